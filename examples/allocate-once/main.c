@@ -150,13 +150,13 @@ int main(int argc, char **argv) {
     cfgpack_entry_t *entries = malloc(entry_count * sizeof(cfgpack_entry_t));
     cfgpack_value_t *values = malloc(entry_count * sizeof(cfgpack_value_t));
     char *str_pool = NULL;
-    uint16_t *str_offsets = NULL;
+    cfgpack_str_off_t *str_offsets = NULL;
 
     if (m.str_pool_size > 0) {
         str_pool = malloc(m.str_pool_size);
     }
     if (str_offset_count > 0) {
-        str_offsets = malloc(str_offset_count * sizeof(uint16_t));
+        str_offsets = malloc(str_offset_count * sizeof(cfgpack_str_off_t));
     }
 
     if (!entries || !values || (m.str_pool_size > 0 && !str_pool) ||
@@ -174,8 +174,8 @@ int main(int argc, char **argv) {
            sizeof(cfgpack_value_t));
     printf("  str_pool:    %zu bytes\n", m.str_pool_size);
     printf("  str_offsets: %zu bytes (%zu x %zu)\n",
-           str_offset_count * sizeof(uint16_t), str_offset_count,
-           sizeof(uint16_t));
+           str_offset_count * sizeof(cfgpack_str_off_t), str_offset_count,
+           sizeof(cfgpack_str_off_t));
     printf("\n");
 
     /* ── 4. Final parse into malloc'd buffers ──────────────────────────
@@ -31,7 +31,7 @@ static cfgpack_value_t values[MAX_ENTRIES];
 
 /* String pool for runtime string values */
 static char str_pool[256];
-static uint16_t str_offsets[MAX_ENTRIES];
+static cfgpack_str_off_t str_offsets[MAX_ENTRIES];
 
 /* Simulated flash storage */
 static uint8_t storage[512];
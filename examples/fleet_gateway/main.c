@@ -68,19 +68,27 @@ static const cfgpack_remap_entry_t v1_to_v2_remap[] = {
 static const cfgpack_remap_entry_t *v2_to_v3_remap = NULL;
 #define V2_V3_REMAP_COUNT 0
 
+/** Composed v1 -> v3 table, built by cfgpack_remap_compile() in Phase 7. */
+static cfgpack_remap_entry_t v1_to_v3_remap[V1_V2_REMAP_COUNT +
+                                            V2_V3_REMAP_COUNT];
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Simulated flash storage for serialized config
  * ═══════════════════════════════════════════════════════════════════════════ */
 static uint8_t flash[2048];
 static size_t flash_len;
 
+/* Copy of the v1 blob, for a device that skips v2 entirely (Phase 7) */
+static uint8_t flash_v1[2048];
+static size_t flash_v1_len;
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Currently active heap-allocated buffers
  * ═══════════════════════════════════════════════════════════════════════════ */
 static cfgpack_entry_t *entries;
 static cfgpack_value_t *values;
 static char *str_pool;
-static uint16_t *str_offsets;
+static cfgpack_str_off_t *str_offsets;
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * Helpers
@@ -165,7 +173,7 @@ static void print_memory_report(const char *label,
     size_t values_bytes = m->entry_count * sizeof(cfgpack_value_t);
     size_t pool_bytes = m->str_pool_size;
     size_t str_off_count = m->str_count + m->fstr_count;
-    size_t offsets_bytes = str_off_count * sizeof(uint16_t);
+    size_t offsets_bytes = str_off_count * sizeof(cfgpack_str_off_t);
 
     size_t total = entries_bytes + values_bytes + pool_bytes + offsets_bytes;
 
@@ -178,7 +186,7 @@ static void print_memory_report(const char *label,
            pool_bytes, m->str_count, CFGPACK_STR_MAX + 1, m->fstr_count,
            CFGPACK_FSTR_MAX + 1);
     printf("    str_offsets        %4zu B  (%zu x %zu)\n", offsets_bytes,
-           str_off_count, sizeof(uint16_t));
+           str_off_count, sizeof(cfgpack_str_off_t));
     printf("    ────────────────────────\n");
     printf("    TOTAL              %4zu B\n\n", total);
 }
@@ -246,7 +254,7 @@ static int load_msgpack_schema(const uint8_t *mp_data,
         str_pool = malloc(m.str_pool_size);
     }
     if (str_off_count > 0) {
-        str_offsets = malloc(str_off_count * sizeof(uint16_t));
+        str_offsets = malloc(str_off_count * sizeof(cfgpack_str_off_t));
     }
 
     if (!entries || !values || (m.str_pool_size > 0 && !str_pool) ||
@@ -614,6 +622,8 @@ int main(void) {
     }
     printf("  Serialized %zu entries -> %zu bytes (measured %zu)\n\n",
            cfgpack_get_size(&ctx), flash_len, needed);
+    memcpy(flash_v1, flash, flash_len);
+    flash_v1_len = flash_len;
 
     /* ═════════════════════════════════════════════════════════════════════
      * Phase 3: Firmware upgrade v1 -> v2
@@ -830,6 +840,53 @@ int main(void) {
            "\n");
     dump_entries(&ctx);
 
+    /* ═════════════════════════════════════════════════════════════════════
+     * Phase 7: Device that skipped v2 — one-pass v1 -> v3 migration
+     * ═════════════════════════════════════════════════════════════════════ */
+
+    printf("── Phase 7: Compose v1->v2->v3, migrate v1 blob in one pass ────\n"
+           "\n");
+
+    const cfgpack_remap_entry_t *chain[] = {v1_to_v2_remap, v2_to_v3_remap};
+    const size_t chain_counts[] = {V1_V2_REMAP_COUNT, V2_V3_REMAP_COUNT};
+    size_t v1_v3_count;
+
+    rc = cfgpack_remap_compile(chain, chain_counts, 2, v1_to_v3_remap,
+                               sizeof(v1_to_v3_remap) /
+                                   sizeof(v1_to_v3_remap[0]),
+                               &v1_v3_count);
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "remap_compile failed: %d\n", rc);
+        return (1);
+    }
+    printf("  Compiled v1->v3 remap (%zu entries):\n", v1_v3_count);
+    for (size_t i = 0; i < v1_v3_count; i++) {
+        printf("    old %u -> new %u\n", v1_to_v3_remap[i].old_index,
+               v1_to_v3_remap[i].new_index);
+    }
+    printf("\n");
+
+    if (load_msgpack_schema(v3_mp, v3_len, "v3", &schema, &ctx, &m) != 0) {
+        return (1);
+    }
+    rc = cfgpack_pagein_remap(&ctx, flash_v1, flash_v1_len, v1_to_v3_remap,
+                              v1_v3_count);
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "v1->v3 pagein_remap failed: %d\n", rc);
+        return (1);
+    }
+
+    fail += check_u32(&ctx, 1, 42, "KEEP vid (from v1)");
+    fail += check_str(&ctx, 2, "big-rig-07", "KEEP vname (from v1)");
+    fail += check_str(&ctx, 5, "alice", "KEEP drv (from v1)");
+    fail += check_u32(&ctx, 9, 2000, "WIDEN gpsrt u16->u32");
+    fail += check_u16(&ctx, 60, 130, "MOVE aspd 20->60");
+    fail += check_u16(&ctx, 61, 600, "MOVE aidle 21->61");
+    fail += check_absent(&ctx, 11, "REMOVE gpsmd");
+    fail += check_absent(&ctx, 24, "REMOVE dtcen");
+    fail += check_u8(&ctx, 71, 1, "ADD otaen default");
+    printf("\n");
+
     /* ═════════════════════════════════════════════════════════════════════
      * Summary
      * ═════════════════════════════════════════════════════════════════════ */
@@ -840,7 +897,8 @@ int main(void) {
     size_t alloc_total = m.entry_count * sizeof(cfgpack_entry_t) +
                          m.entry_count * sizeof(cfgpack_value_t) +
                          m.str_pool_size +
-                         (m.str_count + m.fstr_count) * sizeof(uint16_t);
+                         (m.str_count + m.fstr_count) *
+                             sizeof(cfgpack_str_off_t);
 
     printf("  Schema format:          LZ4-compressed msgpack binary\n");
     printf("  Build pipeline:         .map -> .msgpack -> .msgpack.lz4\n");
@@ -77,7 +77,7 @@ static size_t flash_len;
 static cfgpack_entry_t *entries;
 static cfgpack_value_t *values;
 static char *str_pool;
-static uint16_t *str_offsets;
+static cfgpack_str_off_t *str_offsets;
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * Helpers
@@ -162,7 +162,7 @@ static void print_memory_report(const char *label,
     size_t values_bytes = m->entry_count * sizeof(cfgpack_value_t);
     size_t pool_bytes = m->str_pool_size;
     size_t str_off_count = m->str_count + m->fstr_count;
-    size_t offsets_bytes = str_off_count * sizeof(uint16_t);
+    size_t offsets_bytes = str_off_count * sizeof(cfgpack_str_off_t);
     size_t ctx_bytes = sizeof(cfgpack_ctx_t);
     size_t schema_bytes = sizeof(cfgpack_schema_t);
 
@@ -181,7 +181,7 @@ static void print_memory_report(const char *label,
            pool_bytes, m->str_count, CFGPACK_STR_MAX + 1, m->fstr_count,
            CFGPACK_FSTR_MAX + 1);
     printf("  str_offsets        %4zu B  (%zu x %zu)\n", offsets_bytes,
-           str_off_count, sizeof(uint16_t));
+           str_off_count, sizeof(cfgpack_str_off_t));
     printf("  ────────────────────────\n");
     printf("  TOTAL              %4zu B  (all allocated from measure)\n\n",
            total);
@@ -266,7 +266,7 @@ static int load_schema(const char *path,
         str_pool = malloc(m.str_pool_size);
     }
     if (str_off_count > 0) {
-        str_offsets = malloc(str_off_count * sizeof(uint16_t));
+        str_offsets = malloc(str_off_count * sizeof(cfgpack_str_off_t));
     }
 
     if (!entries || !values || (m.str_pool_size > 0 && !str_pool) ||
@@ -581,7 +581,8 @@ int main(void) {
     size_t alloc_total = m.entry_count * sizeof(cfgpack_entry_t) +
                          m.entry_count * sizeof(cfgpack_value_t) +
                          m.str_pool_size +
-                         (m.str_count + m.fstr_count) * sizeof(uint16_t);
+                         (m.str_count + m.fstr_count) *
+                             sizeof(cfgpack_str_off_t);
 
     printf("  CFGPACK_MAX_ENTRIES:               %d\n", CFGPACK_MAX_ENTRIES);
     printf("  v2 entry count (measured):         %zu\n", m.entry_count);
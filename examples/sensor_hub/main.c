@@ -46,7 +46,7 @@ static cfgpack_value_t values[MAX_ENTRIES];
 
 /* String pool for runtime string values — right-sized for 3 str + 3 fstr */
 static char str_pool[STR_POOL_SIZE];
-static uint16_t str_offsets[NUM_STR_SLOTS];
+static cfgpack_str_off_t str_offsets[NUM_STR_SLOTS];
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * Buffers — temporary buffers share memory via union to reduce footprint.
@@ -16,6 +16,7 @@
 
 #include "config.h"
 #include "error.h"
+#include "msgpack.h"
 #include "schema.h"
 #include "value.h"
 
@@ -23,6 +24,10 @@
 #include <stddef.h>
 #include <string.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief Reserved index for schema name.
  *
@@ -32,6 +37,58 @@
  */
 #define CFGPACK_INDEX_RESERVED_NAME 0
 
+/**
+ * @brief Map key of the offset-index footer written by
+ *        cfgpack_pageout_indexed().
+ *
+ * Lies outside the 16-bit index range, so pagein skips it like any other
+ * unknown key.
+ */
+#define CFGPACK_INDEX_FOOTER 0x10000u
+
+/**
+ * @name Patch header keys
+ *
+ * Map keys of the header entries of a cfgpack_blob_diff() patch.  Like the
+ * footer key they lie outside the 16-bit index range.
+ * @{
+ */
+#define CFGPACK_INDEX_PATCH_BASE 0x10001u   /**< CRC-32C of the base blob */
+#define CFGPACK_INDEX_PATCH_RESULT 0x10002u /**< CRC-32C of the result */
+#define CFGPACK_INDEX_PATCH_DEL 0x10003u    /**< Removed indices (bin) */
+/** @} */
+
+/**
+ * @brief Map key of the schema header written right after the name once
+ *        cfgpack_header_enable() is set.
+ *
+ * Its value is a 12-byte bin: cfgpack_schema_fingerprint() as a u64, then
+ * the schema version as a u32, both big-endian.  Pagein skips it like the
+ * footer; see cfgpack_peek_header().
+ */
+#define CFGPACK_INDEX_HEADER 0x10004u
+
+/** @brief Bytes the schema header entry adds to a blob (key and bin). */
+#define CFGPACK_HEADER_SIZE 19
+
+/**
+ * @brief Map key of the section table written by
+ *        cfgpack_pageout_sectioned().
+ *
+ * Like the footer it comes last before the CRC-32C trailer, and pagein
+ * skips it.
+ */
+#define CFGPACK_INDEX_SECTIONS 0x10005u
+
+/**
+ * @brief Map key of the padding written by cfgpack_pageout_aligned().
+ *
+ * Its value is a bin32 of filler bytes that rounds the blob up to whole
+ * program pages.  It comes last before the CRC-32C trailer, and pagein
+ * skips it.
+ */
+#define CFGPACK_INDEX_PAD 0x10006u
+
 /**
  * @brief Remap table entry for migrating config between schema versions.
  *
@@ -43,6 +100,78 @@ typedef struct {
     uint16_t new_index; /**< Corresponding index in the new schema. */
 } cfgpack_remap_entry_t;
 
+#ifdef CFGPACK_STATS
+/**
+ * @brief Instrumentation counters (CFGPACK_STATS).
+ *
+ * Counters are not atomic and wrap at 2^32; reset them by zeroing the
+ * struct.  CRC bytes come from functions that have no context, so
+ * crc_bytes is only counted in cfgpack_stats_global().
+ */
+typedef struct {
+    uint32_t decoded;      /**< Values decoded by pagein or lazy resolve. */
+    uint32_t skipped;      /**< Pagein keys skipped: name, unknown, lazy. */
+    uint32_t coerced;      /**< Values converted from another wire type. */
+    uint32_t crc_bytes;    /**< Bytes checksummed (global only). */
+    uint32_t index_probes; /**< Entries compared by lookups by index. */
+    uint32_t name_probes;  /**< Entries compared by lookups by name. */
+    uint32_t pool_bytes;   /**< String bytes copied into the pool. */
+    uint32_t io_read;      /**< Bytes read by the file/LittleFS layers. */
+    uint32_t io_written;   /**< Bytes written by the file/LittleFS layers. */
+} cfgpack_stats_t;
+
+/** @brief Operations reported to a cfgpack_stats_hook(). */
+typedef enum {
+    CFGPACK_STATS_PARSE,      /**< Schema parse (any format). */
+    CFGPACK_STATS_PAGEIN,     /**< Decode of a verified blob. */
+    CFGPACK_STATS_PAGEOUT,    /**< Encode of a blob, CRC included. */
+    CFGPACK_STATS_DECOMPRESS  /**< LZ4 or heatshrink decompression. */
+} cfgpack_stats_op_t;
+
+/**
+ * @brief Hook called at the start (@p end 0) and end (@p end 1) of an op.
+ *
+ * @p ctx is NULL for parse.  Ops nest: a compressed pagein reports
+ * DECOMPRESS and then PAGEIN, and file or LittleFS wrappers report the
+ * pagein or pageout they run.
+ */
+typedef void (*cfgpack_stats_hook_fn)(cfgpack_stats_op_t op,
+                                      int end,
+                                      const cfgpack_ctx_t *ctx,
+                                      void *user);
+#endif
+
+typedef struct cfgpack_sub cfgpack_sub_t;
+
+/**
+ * @brief Change notification callback of a subscription.
+ *
+ * Called once per batch in which an entry of the subscription's range
+ * changed; cfgpack_notify_changed() tells which ones.
+ *
+ * @param ctx Context that changed.
+ * @param sub The subscription, including its user pointer.
+ */
+typedef void (*cfgpack_notify_fn)(cfgpack_ctx_t *ctx, const cfgpack_sub_t *sub);
+
+/**
+ * @brief Subscription of a callback to an inclusive range of indices.
+ */
+struct cfgpack_sub {
+    uint16_t first;       /**< First schema index of the range. */
+    uint16_t last;        /**< Last schema index of the range. */
+    cfgpack_notify_fn fn; /**< Called after a batch changed the range. */
+    void *user;           /**< Passed through to @p fn. */
+};
+
+/**
+ * @brief Caller storage for cfgpack_notify_init() for @p n entries.
+ *
+ * Holds the bitmap of changes not yet delivered and the bitmap of the
+ * batch being delivered.
+ */
+#define CFGPACK_NOTIFY_BYTES(n) (2u * (((n) + CHAR_BIT - 1) / CHAR_BIT))
+
 /**
  * @brief Runtime context using caller-owned buffers (no heap).
  *
@@ -52,20 +181,89 @@ typedef struct {
  *
  * The presence bitmap is embedded in the context structure and supports
  * up to CFGPACK_MAX_ENTRIES entries (default 128, configurable in config.h).
+ * A dirty bitmap of the same size records entries set since the last
+ * pageout or pagein; see cfgpack_pageout_delta().  In a CFGPACK_LARGE_SCHEMA
+ * build both bitmaps are caller storage attached by cfgpack_ctx_bitmaps().
  */
 struct cfgpack_ctx {
-    cfgpack_schema_t *schema; /**< Pointer to schema describing entries. */
+    const cfgpack_schema_t *schema; /**< Schema describing entries. */
     cfgpack_value_t
         *values; /**< Caller-provided value slots (size = entry_count). */
     size_t values_count; /**< Number of value slots available. */
+#ifdef CFGPACK_LARGE_SCHEMA
+    uint8_t *present;    /**< Caller presence bitmap (entry_count bits). */
+    uint8_t *dirty;      /**< Caller dirty bitmap, then its saved copy. */
+    size_t bitmap_bytes; /**< Bytes in each of present and dirty. */
+#else
     uint8_t present
         [CFGPACK_PRESENCE_BYTES]; /**< Inline presence bitmap (entry_count bits). */
+    uint8_t dirty
+        [CFGPACK_PRESENCE_BYTES]; /**< Entries set since last pageout/pagein. */
+#endif
     char *str_pool;               /**< Caller-provided string pool buffer. */
     size_t str_pool_cap;          /**< Capacity of string pool in bytes. */
-    uint16_t *str_offsets;    /**< Per-string-entry offsets into str_pool. */
-    size_t str_offsets_count; /**< Number of string offset slots. */
+    cfgpack_str_off_t *str_offsets; /**< Per-string-entry pool offsets. */
+    size_t str_offsets_count;       /**< Number of string offset slots. */
+    const uint64_t *name_index; /**< Sorted name keys, or NULL (linear). */
+    const uint8_t *index_table; /**< Index -> entry offset, or NULL. */
+    size_t index_table_len;     /**< Elements in index_table. */
+#ifdef CFGPACK_PACKED_ARENA
+    uint8_t *packed; /**< Packed value arena, or NULL (values[] slots). */
+#endif
+    const uint8_t *cow_base; /**< Copy-on-write default blob, or NULL. */
+    size_t cow_len;          /**< Bytes in cow_base. */
+    size_t str_pool_used;    /**< Pool bytes handed out (copy-on-write). */
+#ifdef CFGPACK_SIZE_CACHE
+    size_t size_bytes; /**< Cached key+value bytes of present entries. */
+    size_t size_count; /**< Present entries counted in size_bytes. */
+    uint8_t size_cached; /**< Set by cfgpack_size_cache_init(). */
+#endif
+    uint8_t header;      /**< Set by cfgpack_header_enable(). */
+    uint32_t set_count;  /**< cfgpack_dirty_set() calls, wrapping. */
+#ifdef CFGPACK_LAZY
+    uint32_t *lazy_off; /**< Pending value offsets, or NULL (eager). */
+    const uint8_t *lazy_blob; /**< Blob the pending offsets point into. */
+    size_t lazy_len;          /**< Bytes of lazy_blob before the trailer. */
+#endif
+#ifdef CFGPACK_DEFAULTS_BLOB
+    uint32_t *def_off;       /**< Default value offsets, or NULL. */
+    const uint8_t *def_blob; /**< Defaults-only pageout def_off points into. */
+    size_t def_len;          /**< Bytes of def_blob before the trailer. */
+#endif
+#ifdef CFGPACK_TXN
+    uint8_t *txn_buf;     /**< Undo journal of the open transaction, or NULL. */
+    size_t txn_cap;       /**< Capacity of txn_buf in bytes. */
+    size_t txn_len;       /**< Journal bytes written so far. */
+    size_t txn_pool_used; /**< str_pool_used when the transaction began. */
+#endif
+#ifdef CFGPACK_NOTIFY
+    const cfgpack_sub_t *subs; /**< Change subscriptions, or NULL. */
+    size_t sub_count;          /**< Elements in subs. */
+    uint8_t *notify_bits;      /**< Pending, then delivering, change bits. */
+    uint8_t notifying;         /**< Set while callbacks run. */
+#endif
+#ifdef CFGPACK_SEQLOCK
+    volatile uint32_t seq; /**< Seqlock counter; odd while a write is on. */
+#endif
+#ifdef CFGPACK_STATS
+    cfgpack_stats_t *stats; /**< Per-context counters, or NULL. */
+#endif
 };
 
+/**
+ * @brief Size in bytes of each of the context's presence/dirty bitmaps.
+ * @param ctx Context with bitmaps.
+ * @return Bitmap size in bytes.
+ */
+static inline size_t cfgpack_bitmap_bytes(const cfgpack_ctx_t *ctx) {
+#ifdef CFGPACK_LARGE_SCHEMA
+    return (ctx->bitmap_bytes);
+#else
+    (void)ctx;
+    return (CFGPACK_PRESENCE_BYTES);
+#endif
+}
+
 /**
  * @brief Mark entry index as present in the context bitmap.
  * @param ctx Context with presence bitmap.
@@ -94,6 +292,219 @@ static inline void cfgpack_presence_clear(cfgpack_ctx_t *ctx, size_t idx) {
     ctx->present[idx / CHAR_BIT] &= (uint8_t)~(1u << (idx % CHAR_BIT));
 }
 
+/**
+ * @brief Mark entry index as modified since the last pageout/pagein.
+ * @param ctx Context with dirty bitmap.
+ * @param idx Entry index to mark dirty.
+ */
+static inline void cfgpack_dirty_set(cfgpack_ctx_t *ctx, size_t idx) {
+    ctx->dirty[idx / CHAR_BIT] |= (uint8_t)(1u << (idx % CHAR_BIT));
+    ctx->set_count++;
+}
+
+/**
+ * @brief Test dirty bit for entry index.
+ * @param ctx Context with dirty bitmap.
+ * @param idx Entry index to query.
+ * @return 1 if dirty, 0 otherwise.
+ */
+static inline int cfgpack_dirty_get(const cfgpack_ctx_t *ctx, size_t idx) {
+    return (ctx->dirty[idx / CHAR_BIT] >> (idx % CHAR_BIT)) & 1u;
+}
+
+/**
+ * @brief Clear dirty bit for entry index.
+ * @param ctx Context with dirty bitmap.
+ * @param idx Entry index to clear.
+ */
+static inline void cfgpack_dirty_clear(cfgpack_ctx_t *ctx, size_t idx) {
+    ctx->dirty[idx / CHAR_BIT] &= (uint8_t)~(1u << (idx % CHAR_BIT));
+}
+
+/**
+ * @brief Clear every dirty bit (mark the context as in sync with storage).
+ * @param ctx Context with dirty bitmap.
+ */
+static inline void cfgpack_dirty_clear_all(cfgpack_ctx_t *ctx) {
+    for (size_t i = 0; i < cfgpack_bitmap_bytes(ctx); ++i) {
+        ctx->dirty[i] = 0;
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Bitmap scans
+ *
+ * The bitmaps keep bit i in byte i / 8, which is also the layout of the
+ * packed wire format and of snapshots.  Read 8 bytes at a time that is a
+ * little-endian 64-bit word, so scans skip absent entries 64 at a time
+ * with count-trailing-zeros and count them with popcount.
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** @brief Load up to 8 bitmap bytes as a little-endian word. */
+static inline uint64_t cfgpack_bits_load(const uint8_t *p, size_t bytes) {
+    uint64_t w = 0;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (bytes >= 8) {
+        memcpy(&w, p, 8);
+        return (w);
+    }
+#endif
+    if (bytes > 8) {
+        bytes = 8;
+    }
+    for (size_t k = 0; k < bytes; ++k) {
+        w |= (uint64_t)p[k] << (8 * k);
+    }
+    return (w);
+}
+
+/** @brief Index of the lowest set bit of @p w (nonzero). */
+static inline unsigned cfgpack_bits_ctz(uint64_t w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return ((unsigned)__builtin_ctzll(w));
+#else
+    unsigned n = 0;
+
+    while (!(w & 1u)) {
+        w >>= 1;
+        n++;
+    }
+    return (n);
+#endif
+}
+
+/** @brief Number of set bits in @p w. */
+static inline unsigned cfgpack_bits_popcount(uint64_t w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return ((unsigned)__builtin_popcountll(w));
+#else
+    unsigned n = 0;
+
+    for (; w; w &= w - 1) {
+        n++;
+    }
+    return (n);
+#endif
+}
+
+/** @brief Bits @p at .. @p at + 63 of @p bits (and @p mask), below @p n. */
+static inline uint64_t cfgpack_bits_word(const uint8_t *bits,
+                                         const uint8_t *mask,
+                                         size_t n,
+                                         size_t at) {
+    size_t bytes = (n - at + CHAR_BIT - 1) / CHAR_BIT;
+    uint64_t w = cfgpack_bits_load(bits + at / CHAR_BIT, bytes);
+
+    if (mask) {
+        w &= cfgpack_bits_load(mask + at / CHAR_BIT, bytes);
+    }
+    if (n - at < 64) {
+        w &= ((uint64_t)1 << (n - at)) - 1;
+    }
+    return (w);
+}
+
+/**
+ * @brief Cursor over the present (optionally present and dirty) entries.
+ *
+ * @code
+ * cfgpack_present_iter_t it;
+ * size_t off;
+ *
+ * cfgpack_present_iter_init(&it, ctx, 0);
+ * while (cfgpack_present_next(&it, &off)) {
+ *     ... ctx->schema->entries[off] is present ...
+ * }
+ * @endcode
+ *
+ * Entries are visited in schema order.  Bits changed behind the cursor
+ * are not seen; bits of the current word are read once, when it loads.
+ */
+typedef struct {
+    const uint8_t *bits; /**< Presence bitmap */
+    const uint8_t *mask; /**< Dirty bitmap ANDed in, or NULL */
+    size_t n;            /**< Entries to scan */
+    size_t next;         /**< Entry offset of the next word to load */
+    size_t base;         /**< Entry offset of bit 0 of @c word */
+    uint64_t word;       /**< Unvisited bits of the current word */
+} cfgpack_present_iter_t;
+
+/**
+ * @brief Start a scan of @p ctx.
+ * @param it         Cursor to initialize.
+ * @param ctx        Initialized context.
+ * @param dirty_only Nonzero to visit only entries that are also dirty.
+ */
+static inline void cfgpack_present_iter_init(cfgpack_present_iter_t *it,
+                                             const cfgpack_ctx_t *ctx,
+                                             int dirty_only) {
+    it->bits = ctx->present;
+    it->mask = dirty_only ? ctx->dirty : NULL;
+    it->n = ctx->schema->entry_count;
+    it->next = 0;
+    it->base = 0;
+    it->word = 0;
+}
+
+/**
+ * @brief Advance to the next visited entry.
+ * @param it  Cursor from cfgpack_present_iter_init().
+ * @param off Receives the entry offset.
+ * @return 1 if @p off was set, 0 once the scan is done.
+ */
+static inline int cfgpack_present_next(cfgpack_present_iter_t *it,
+                                       size_t *off) {
+    while (it->word == 0) {
+        if (it->next >= it->n) {
+            return (0);
+        }
+        it->word = cfgpack_bits_word(it->bits, it->mask, it->n, it->next);
+        it->base = it->next;
+        it->next += 64;
+    }
+    *off = it->base + cfgpack_bits_ctz(it->word);
+    it->word &= it->word - 1;
+    return (1);
+}
+
+/**
+ * @brief Number of set bits among the first @p n of @p bits (and @p mask).
+ * @param bits Bitmap.
+ * @param mask Second bitmap ANDed in, or NULL.
+ * @param n    Bits to count.
+ * @return Set bit count.
+ */
+static inline size_t cfgpack_bits_count(const uint8_t *bits,
+                                        const uint8_t *mask,
+                                        size_t n) {
+    size_t count = 0;
+
+    for (size_t at = 0; at < n; at += 64) {
+        count += cfgpack_bits_popcount(cfgpack_bits_word(bits, mask, n, at));
+    }
+    return (count);
+}
+
+#ifdef CFGPACK_LARGE_SCHEMA
+/**
+ * @brief Attach caller storage for the presence and dirty bitmaps.
+ *
+ * Must be called before cfgpack_init() or cfgpack_init_cow(), which keep
+ * the attachment and clear the bitmaps.  Size @p bits with
+ * CFGPACK_BITMAP_BYTES() of the schema's entry count (from measure or
+ * sizing); it must outlive the context.
+ *
+ * @param ctx      Context to prepare.
+ * @param bits     Caller-owned bitmap storage.
+ * @param bits_cap Capacity of @p bits in bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments.
+ */
+cfgpack_err_t cfgpack_ctx_bitmaps(cfgpack_ctx_t *ctx,
+                                  uint8_t *bits,
+                                  size_t bits_cap);
+#endif
+
 /**
  * @brief Initialize context with caller buffers.
  *
@@ -110,8 +521,12 @@ static inline void cfgpack_presence_clear(cfgpack_ctx_t *ctx, size_t idx) {
  * @param str_pool_cap     Capacity of @p str_pool in bytes.
  * @param str_offsets      Caller-owned array for string offsets (str_count + fstr_count).
  * @param str_offsets_count Number of elements in @p str_offsets.
- * @return CFGPACK_OK on success; CFGPACK_ERR_BOUNDS if buffers are too small
- *         or schema has more than CFGPACK_MAX_ENTRIES entries.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_BOUNDS if buffers are too small,
+ *         the schema has more than CFGPACK_MAX_ENTRIES entries (or more than
+ *         the attached bitmaps hold), more string entries than
+ *         cfgpack_str_slot_t can number, or an entry's str_max above
+ *         CFGPACK_STR_MAX / CFGPACK_FSTR_MAX; CFGPACK_ERR_INVALID_TYPE if a
+ *         non-string entry has a nonzero str_max.
  */
 cfgpack_err_t cfgpack_init(cfgpack_ctx_t *ctx,
                            cfgpack_schema_t *schema,
@@ -119,9 +534,236 @@ cfgpack_err_t cfgpack_init(cfgpack_ctx_t *ctx,
                            size_t values_count,
                            char *str_pool,
                            size_t str_pool_cap,
-                           uint16_t *str_offsets,
+                           cfgpack_str_off_t *str_offsets,
                            size_t str_offsets_count);
 
+/**
+ * @brief Initialize a context whose string defaults stay in the schema blob.
+ *
+ * Use with cfgpack_schema_parse_msgpack_cow(), which leaves each string
+ * default in place in the msgpack schema instead of copying it into the
+ * pool.  Reads of an unchanged string return a pointer into @p defaults.
+ * A string entry gets a pool slot (its max length + 1 bytes, taken in
+ * order of first write) only when cfgpack_set_str(), cfgpack_set_fstr()
+ * or a pagein first writes it, so @p str_pool only has to hold the
+ * strings that change.  Size it from cfgpack_schema_get_sizing() to make
+ * sure every string can be written.  Strings read from @p defaults are not
+ * NUL-terminated; use the returned length.
+ *
+ * Packed value storage (cfgpack_packed_init()) and
+ * cfgpack_schema_write_image() are not available on such a context.
+ *
+ * @param ctx              Context to initialize (output).
+ * @param schema           Schema from cfgpack_schema_parse_msgpack_cow().
+ * @param values           Values from the same parse (>= entry_count).
+ * @param values_count     Number of elements in @p values.
+ * @param str_pool         Caller-owned pool for written strings.
+ * @param str_pool_cap     Capacity of @p str_pool in bytes.
+ * @param str_offsets      Caller-owned array (str_count + fstr_count).
+ * @param str_offsets_count Number of elements in @p str_offsets.
+ * @param defaults         The parsed msgpack schema; must stay unchanged
+ *                         (e.g. in flash) for the lifetime of @p ctx.
+ * @param defaults_len     Length of @p defaults in bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if buffers are too small, the schema has more
+ *         than CFGPACK_MAX_ENTRIES entries, or a string default lies
+ *         outside @p defaults.
+ */
+cfgpack_err_t cfgpack_init_cow(cfgpack_ctx_t *ctx,
+                               cfgpack_schema_t *schema,
+                               cfgpack_value_t *values,
+                               size_t values_count,
+                               char *str_pool,
+                               size_t str_pool_cap,
+                               cfgpack_str_off_t *str_offsets,
+                               size_t str_offsets_count,
+                               const uint8_t *defaults,
+                               size_t defaults_len);
+
+/**
+ * @brief Initialize a context on the schema of an existing prototype.
+ *
+ * Parsing stays schema setup, done once: parse the schema and initialize
+ * one prototype context on the parser's buffers.  Each further context
+ * then takes the prototype's schema by reference and copies its values,
+ * strings and presence into its own buffers, so one parsed
+ * cfgpack_schema_t serves any number of contexts.  The schema is only
+ * read, never written, so it may be const or shared between threads; a
+ * schema whose string slots were never assigned (a hand-built one no
+ * cfgpack_init() has seen) is refused.  The prototype's name index and
+ * index table are shared as well.
+ *
+ * The new context starts from the prototype's current state, so leave
+ * the prototype unchanged to hand out pristine defaults.  A copy-on-write
+ * prototype (cfgpack_init_cow()) shares its default blob.
+ *
+ * @param ctx              Context to initialize (output).
+ * @param proto            Initialized prototype; it and its schema must
+ *                         outlive @p ctx.
+ * @param values           Caller-owned value slots (>= entry_count).
+ * @param values_count     Number of elements in @p values.
+ * @param str_pool         Caller-owned string pool, sized as for
+ *                         cfgpack_init() (or cfgpack_init_cow()).
+ * @param str_pool_cap     Capacity of @p str_pool in bytes.
+ * @param str_offsets      Caller-owned array (str_count + fstr_count).
+ * @param str_offsets_count Number of elements in @p str_offsets.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments, an
+ *         unassigned string slot, or a prototype using packed storage,
+ *         lazy pagein or copy-on-write strings it has already written;
+ *         CFGPACK_ERR_BOUNDS as cfgpack_init().
+ */
+cfgpack_err_t cfgpack_init_shared(cfgpack_ctx_t *ctx,
+                                  const cfgpack_ctx_t *proto,
+                                  cfgpack_value_t *values,
+                                  size_t values_count,
+                                  char *str_pool,
+                                  size_t str_pool_cap,
+                                  cfgpack_str_off_t *str_offsets,
+                                  size_t str_offsets_count);
+
+/**
+ * @brief Prototype contexts looked up by schema name and version.
+ *
+ * Caller-owned slots kept sorted by (name, version), so a backend that
+ * sees many devices running a few schema versions parses each version
+ * once.  Lookups only read the cache; adds must not run concurrently with
+ * other adds or lookups.
+ */
+typedef struct {
+    const cfgpack_ctx_t **protos; /**< Caller array, sorted by key. */
+    size_t cap;                   /**< Elements in protos. */
+    size_t count;                 /**< Prototypes cached. */
+} cfgpack_schema_cache_t;
+
+/**
+ * @brief Start an empty schema cache on caller storage.
+ *
+ * @param cache  Cache to initialize.
+ * @param protos Caller-owned array; must outlive the cache.
+ * @param cap    Elements in @p protos.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments.
+ */
+cfgpack_err_t cfgpack_schema_cache_init(cfgpack_schema_cache_t *cache,
+                                        const cfgpack_ctx_t **protos,
+                                        size_t cap);
+
+/**
+ * @brief Add a prototype under its schema's map_name and version.
+ *
+ * A prototype with the same name and version replaces the cached one.
+ *
+ * @param cache Cache from cfgpack_schema_cache_init().
+ * @param proto Initialized prototype; must outlive its cache entry.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if the cache is full.
+ */
+cfgpack_err_t cfgpack_schema_cache_add(cfgpack_schema_cache_t *cache,
+                                       const cfgpack_ctx_t *proto);
+
+/**
+ * @brief Find the prototype for a schema name and version.
+ *
+ * Binary search over the cached keys.  For a stored config, pass the name
+ * from cfgpack_peek_name() and the version the device reports, then
+ * cfgpack_init_shared() a context from the result.
+ *
+ * @param cache   Cache to search.
+ * @param name    Schema map_name.
+ * @param version Schema version.
+ * @return The cached prototype, or NULL if there is none (or on NULL
+ *         arguments).
+ */
+const cfgpack_ctx_t *cfgpack_schema_cache_find(
+    const cfgpack_schema_cache_t *cache, const char *name, uint32_t version);
+
+/**
+ * @brief Install a sorted name index for the *_by_name accessors.
+ *
+ * Without an index, name lookups scan every entry with strcmp().  The index
+ * holds one 8-byte key per entry (the packed name plus the entry offset),
+ * sorted once here, so lookups become a binary search over integers.
+ * Call after cfgpack_init(), which resets the context to linear lookups,
+ * and again if the schema's entries change.
+ *
+ * @param ctx        Initialized context.
+ * @param index      Caller-owned array; must outlive the context.
+ * @param index_cap  Elements in @p index (>= schema entry_count).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if @p index_cap is too small;
+ *         CFGPACK_ERR_DUPLICATE if two entries share a name (the context
+ *         keeps using linear lookups).
+ */
+cfgpack_err_t cfgpack_name_index_init(cfgpack_ctx_t *ctx,
+                                      uint64_t *index,
+                                      size_t index_cap);
+
+/**
+ * @brief Install a dense index-to-entry table for index-based accessors.
+ *
+ * Without a table, every cfgpack_get()/cfgpack_set() binary-searches the
+ * schema entries.  The table maps each schema index directly to its entry
+ * offset (UINT8_MAX for unused indices), so lookups are a single load.
+ * Size it from cfgpack_schema_measure_t or cfgpack_schema_sizing_t
+ * index_table_size; a size of 0 means the schema is too sparse (highest
+ * index >= CFGPACK_INDEX_TABLE_MAX) and binary search stays in use.
+ * Call after cfgpack_init(), which resets the context to binary search.
+ *
+ * @param ctx        Initialized context.
+ * @param table      Caller-owned array; must outlive the context.
+ * @param table_cap  Elements in @p table (>= highest index + 1).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if @p table_cap is too small or the schema is
+ *         too sparse (lookups keep using binary search).
+ */
+cfgpack_err_t cfgpack_index_table_init(cfgpack_ctx_t *ctx,
+                                       uint8_t *table,
+                                       size_t table_cap);
+
+#ifdef CFGPACK_PACKED_ARENA
+/**
+ * @brief Bytes needed by cfgpack_packed_init() for a schema.
+ *
+ * The arena holds a uint16_t offset per entry followed by each value at
+ * the width of its schema type: 1 byte for u8/i8 and fstr lengths, 2 for
+ * u16/i16 and str lengths, 4 for u32/i32/f32 and 8 for u64/i64/f64.
+ *
+ * @param schema Schema to size for.
+ * @return Arena size in bytes (0 if @p schema is NULL).
+ */
+size_t cfgpack_packed_size(const cfgpack_schema_t *schema);
+
+/**
+ * @brief Move value storage from cfgpack_value_t slots into a packed arena.
+ *
+ * Only in CFGPACK_PACKED_ARENA builds.
+ *
+ * Every cfgpack_value_t slot is 16 bytes whatever its type.  After this
+ * call the context keeps each value at its natural width in @p arena
+ * instead, grouped by size so every value is naturally aligned, and the
+ * values array given to cfgpack_init() is no longer referenced: it may be
+ * a transient buffer that is reused once this returns.  All accessors and
+ * pagein/pageout keep working unchanged.
+ *
+ * Values are stored at their schema width, so a cfgpack_set() value wider
+ * than its entry type is truncated, and a string value always refers to
+ * the entry's own pool slot.  Call after cfgpack_init(), which resets the
+ * context to value slots.
+ *
+ * @param ctx        Initialized context.
+ * @param arena      Caller-owned, 8-byte aligned buffer; must outlive the
+ *                   context.
+ * @param arena_cap  Capacity of @p arena (>= cfgpack_packed_size()).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments, a
+ *         misaligned @p arena, an already packed context or one set up
+ *         with cfgpack_init_cow();
+ *         CFGPACK_ERR_BOUNDS if @p arena_cap is too
+ *         small (the context keeps using its value slots).
+ */
+cfgpack_err_t cfgpack_packed_init(cfgpack_ctx_t *ctx,
+                                  void *arena,
+                                  size_t arena_cap);
+#endif /* CFGPACK_PACKED_ARENA */
+
 /**
  * @brief No-op cleanup (buffers are caller-owned).
  * @param ctx Context to release (no-op).
@@ -137,7 +779,8 @@ void cfgpack_free(cfgpack_ctx_t *ctx);
  * @param value  Value to store (type must match schema entry).
  * @return CFGPACK_OK on success; CFGPACK_ERR_MISSING if index not in schema;
  *         CFGPACK_ERR_TYPE_MISMATCH for wrong type; CFGPACK_ERR_STR_TOO_LONG
- *         if string exceeds limits.
+ *         if string exceeds limits; CFGPACK_ERR_BOUNDS if the undo journal
+ *         of an open transaction is full (see cfgpack_txn_begin()).
  */
 cfgpack_err_t cfgpack_set(cfgpack_ctx_t *ctx,
                           uint16_t index,
@@ -155,6 +798,37 @@ cfgpack_err_t cfgpack_get(const cfgpack_ctx_t *ctx,
                           uint16_t index,
                           cfgpack_value_t *out_value);
 
+/**
+ * @brief Set a value by schema position, without the index lookup.
+ *
+ * @p pos is the entry's zero-based offset in the schema's entries array,
+ * the same position cfgpack_dirty_get() takes and a generated header names
+ * <P>_POS_<NAME>.  Otherwise as cfgpack_set().
+ *
+ * @param ctx   Initialized context.
+ * @param pos   Schema position of the entry.
+ * @param value Value to store (type must match schema entry).
+ * @return As cfgpack_set(); CFGPACK_ERR_MISSING if @p pos is not below the
+ *         entry count.
+ */
+cfgpack_err_t cfgpack_set_at(cfgpack_ctx_t *ctx,
+                             size_t pos,
+                             const cfgpack_value_t *value);
+
+/**
+ * @brief Get a value by schema position, without the index lookup.
+ * @see cfgpack_set_at
+ *
+ * @param ctx       Initialized context.
+ * @param pos       Schema position of the entry.
+ * @param out_value Filled on success.
+ * @return As cfgpack_get(); CFGPACK_ERR_MISSING if @p pos is not below the
+ *         entry count.
+ */
+cfgpack_err_t cfgpack_get_at(const cfgpack_ctx_t *ctx,
+                             size_t pos,
+                             cfgpack_value_t *out_value);
+
 /**
  * @brief Set a value by schema name; validates type and string lengths.
  *
@@ -181,6 +855,56 @@ cfgpack_err_t cfgpack_get_by_name(const cfgpack_ctx_t *ctx,
                                   const char *name,
                                   cfgpack_value_t *out_value);
 
+/**
+ * @brief Get several values in one call.
+ *
+ * @p indices must be strictly ascending.  They are resolved with a single
+ * walk over the schema entries (or through the index table when one is
+ * installed), and the arguments are checked once for the whole batch.
+ *
+ * @param ctx        Initialized context.
+ * @param indices    @p count schema indices, strictly ascending.
+ * @param count      Number of values to get.
+ * @param out_values Receives @p count values, in @p indices order.
+ * @param failed     If non-NULL, receives the position in @p indices of the
+ *                   index that failed (untouched on success).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or
+ *         indices not strictly ascending; CFGPACK_ERR_RESERVED_INDEX for
+ *         index 0; CFGPACK_ERR_MISSING if an index is absent or unknown.
+ *         On error, the values before the failing position are filled.
+ */
+cfgpack_err_t cfgpack_get_many(const cfgpack_ctx_t *ctx,
+                               const uint16_t *indices,
+                               size_t count,
+                               cfgpack_value_t *out_values,
+                               size_t *failed);
+
+/**
+ * @brief Set several values atomically.
+ *
+ * Every index and value is validated as by cfgpack_set() before any is
+ * stored, so on error the context is unchanged.  @p indices must be
+ * strictly ascending; they are resolved as by cfgpack_get_many().
+ *
+ * @param ctx     Initialized context.
+ * @param indices @p count schema indices, strictly ascending.
+ * @param values  @p count values, in @p indices order.
+ * @param count   Number of values to set.
+ * @param failed  If non-NULL, receives the position in @p indices of the
+ *                entry that failed validation (untouched on success).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or
+ *         indices not strictly ascending; CFGPACK_ERR_RESERVED_INDEX,
+ *         CFGPACK_ERR_MISSING, CFGPACK_ERR_TYPE_MISMATCH,
+ *         CFGPACK_ERR_STR_TOO_LONG or CFGPACK_ERR_BOUNDS as cfgpack_set();
+ *         a batch that does not fit an open transaction's journal is
+ *         rejected whole.
+ */
+cfgpack_err_t cfgpack_set_many(cfgpack_ctx_t *ctx,
+                               const uint16_t *indices,
+                               const cfgpack_value_t *values,
+                               size_t count,
+                               size_t *failed);
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Typed Setter Convenience Functions (by index)
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -189,7 +913,8 @@ cfgpack_err_t cfgpack_get_by_name(const cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_u8(cfgpack_ctx_t *ctx,
                                            uint16_t index,
                                            uint8_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_U8, .v.u64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_U8, {0}};
+    v.v.u64 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -197,7 +922,8 @@ static inline cfgpack_err_t cfgpack_set_u8(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_u16(cfgpack_ctx_t *ctx,
                                             uint16_t index,
                                             uint16_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_U16, .v.u64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_U16, {0}};
+    v.v.u64 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -205,7 +931,8 @@ static inline cfgpack_err_t cfgpack_set_u16(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_u32(cfgpack_ctx_t *ctx,
                                             uint16_t index,
                                             uint32_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_U32, .v.u64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_U32, {0}};
+    v.v.u64 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -213,7 +940,8 @@ static inline cfgpack_err_t cfgpack_set_u32(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_u64(cfgpack_ctx_t *ctx,
                                             uint16_t index,
                                             uint64_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_U64, .v.u64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_U64, {0}};
+    v.v.u64 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -221,7 +949,8 @@ static inline cfgpack_err_t cfgpack_set_u64(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_i8(cfgpack_ctx_t *ctx,
                                            uint16_t index,
                                            int8_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_I8, .v.i64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_I8, {0}};
+    v.v.i64 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -229,7 +958,8 @@ static inline cfgpack_err_t cfgpack_set_i8(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_i16(cfgpack_ctx_t *ctx,
                                             uint16_t index,
                                             int16_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_I16, .v.i64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_I16, {0}};
+    v.v.i64 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -237,7 +967,8 @@ static inline cfgpack_err_t cfgpack_set_i16(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_i32(cfgpack_ctx_t *ctx,
                                             uint16_t index,
                                             int32_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_I32, .v.i64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_I32, {0}};
+    v.v.i64 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -245,7 +976,8 @@ static inline cfgpack_err_t cfgpack_set_i32(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_i64(cfgpack_ctx_t *ctx,
                                             uint16_t index,
                                             int64_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_I64, .v.i64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_I64, {0}};
+    v.v.i64 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -253,7 +985,8 @@ static inline cfgpack_err_t cfgpack_set_i64(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_f32(cfgpack_ctx_t *ctx,
                                             uint16_t index,
                                             float val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_F32, .v.f32 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_F32, {0}};
+    v.v.f32 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -261,7 +994,8 @@ static inline cfgpack_err_t cfgpack_set_f32(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_f64(cfgpack_ctx_t *ctx,
                                             uint16_t index,
                                             double val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_F64, .v.f64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_F64, {0}};
+    v.v.f64 = val;
     return cfgpack_set(ctx, index, &v);
 }
 
@@ -283,7 +1017,8 @@ cfgpack_err_t cfgpack_set_fstr(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_u8_by_name(cfgpack_ctx_t *ctx,
                                                    const char *name,
                                                    uint8_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_U8, .v.u64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_U8, {0}};
+    v.v.u64 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -291,7 +1026,8 @@ static inline cfgpack_err_t cfgpack_set_u8_by_name(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_u16_by_name(cfgpack_ctx_t *ctx,
                                                     const char *name,
                                                     uint16_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_U16, .v.u64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_U16, {0}};
+    v.v.u64 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -299,7 +1035,8 @@ static inline cfgpack_err_t cfgpack_set_u16_by_name(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_u32_by_name(cfgpack_ctx_t *ctx,
                                                     const char *name,
                                                     uint32_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_U32, .v.u64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_U32, {0}};
+    v.v.u64 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -307,7 +1044,8 @@ static inline cfgpack_err_t cfgpack_set_u32_by_name(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_u64_by_name(cfgpack_ctx_t *ctx,
                                                     const char *name,
                                                     uint64_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_U64, .v.u64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_U64, {0}};
+    v.v.u64 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -315,7 +1053,8 @@ static inline cfgpack_err_t cfgpack_set_u64_by_name(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_i8_by_name(cfgpack_ctx_t *ctx,
                                                    const char *name,
                                                    int8_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_I8, .v.i64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_I8, {0}};
+    v.v.i64 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -323,7 +1062,8 @@ static inline cfgpack_err_t cfgpack_set_i8_by_name(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_i16_by_name(cfgpack_ctx_t *ctx,
                                                     const char *name,
                                                     int16_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_I16, .v.i64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_I16, {0}};
+    v.v.i64 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -331,7 +1071,8 @@ static inline cfgpack_err_t cfgpack_set_i16_by_name(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_i32_by_name(cfgpack_ctx_t *ctx,
                                                     const char *name,
                                                     int32_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_I32, .v.i64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_I32, {0}};
+    v.v.i64 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -339,7 +1080,8 @@ static inline cfgpack_err_t cfgpack_set_i32_by_name(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_i64_by_name(cfgpack_ctx_t *ctx,
                                                     const char *name,
                                                     int64_t val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_I64, .v.i64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_I64, {0}};
+    v.v.i64 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -347,7 +1089,8 @@ static inline cfgpack_err_t cfgpack_set_i64_by_name(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_f32_by_name(cfgpack_ctx_t *ctx,
                                                     const char *name,
                                                     float val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_F32, .v.f32 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_F32, {0}};
+    v.v.f32 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -355,7 +1098,8 @@ static inline cfgpack_err_t cfgpack_set_f32_by_name(cfgpack_ctx_t *ctx,
 static inline cfgpack_err_t cfgpack_set_f64_by_name(cfgpack_ctx_t *ctx,
                                                     const char *name,
                                                     double val) {
-    cfgpack_value_t v = {.type = CFGPACK_TYPE_F64, .v.f64 = val};
+    cfgpack_value_t v = {CFGPACK_TYPE_F64, {0}};
+    v.v.f64 = val;
     return cfgpack_set_by_name(ctx, name, &v);
 }
 
@@ -369,6 +1113,120 @@ cfgpack_err_t cfgpack_set_fstr_by_name(cfgpack_ctx_t *ctx,
                                        const char *name,
                                        const char *str);
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Transactions
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+#ifdef CFGPACK_TXN
+/**
+ * @brief Undo journal bytes one cfgpack_set*() call takes in a transaction.
+ *
+ * A string or fixed string entry takes its current length in bytes on top.
+ */
+#define CFGPACK_TXN_REC_BYTES 32u
+
+/**
+ * @brief Start journaling writes so they can be rolled back.
+ *
+ * Until cfgpack_txn_commit() or cfgpack_txn_abort(), every successful
+ * cfgpack_set*() first appends the entry's old value, presence and dirty
+ * bits and old string bytes to @p undo.  A set that does not fit in the
+ * journal fails with CFGPACK_ERR_BOUNDS and changes nothing, so rollback
+ * stays possible.  Only sets are journaled: pagein, pageout (which clears
+ * dirty bits) and cfgpack_presence_clear() inside a transaction are not
+ * undone.  cfgpack_init() ends an open transaction without rolling back.
+ * Only in CFGPACK_TXN builds.
+ *
+ * @param ctx      Initialized context without an open transaction.
+ * @param undo     Caller-owned journal buffer; untouched after the
+ *                 transaction ends.
+ * @param undo_cap Capacity of @p undo in bytes (CFGPACK_TXN_REC_BYTES per
+ *                 set, plus string lengths).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or if
+ *         a transaction is already open.
+ */
+cfgpack_err_t cfgpack_txn_begin(cfgpack_ctx_t *ctx,
+                                void *undo,
+                                size_t undo_cap);
+
+/**
+ * @brief Keep the writes of the open transaction and stop journaling.
+ *
+ * @param ctx Context with an open transaction.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if ctx is NULL or no
+ *         transaction is open.
+ */
+cfgpack_err_t cfgpack_txn_commit(cfgpack_ctx_t *ctx);
+
+/**
+ * @brief Roll back every set of the open transaction and stop journaling.
+ *
+ * Replays the journal newest first, restoring values, string bytes,
+ * presence and dirty bits, pending lazy entries and copy-on-write slots
+ * as they were at cfgpack_txn_begin().  The cost is proportional to the
+ * number of journaled sets, not to the size of the config.
+ *
+ * @param ctx Context with an open transaction.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if ctx is NULL or no
+ *         transaction is open.
+ */
+cfgpack_err_t cfgpack_txn_abort(cfgpack_ctx_t *ctx);
+#endif /* CFGPACK_TXN */
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Change Notification
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+#ifdef CFGPACK_NOTIFY
+/**
+ * @brief Attach change subscriptions to a context.
+ *
+ * Every entry a cfgpack_set*() or pagein writes is marked in a pending
+ * bitmap.  When the call completes, one batched pass calls each
+ * subscription whose index range holds a marked entry once, then clears
+ * the marks: cfgpack_set_many() notifies once for the whole batch, and a
+ * pagein once for the whole blob.  A full pagein reloads the config, so
+ * every entry present before or after it counts as changed; a delta
+ * pagein marks only the keys it carries.  An entry counts as changed when
+ * it is written, even with an equal value.  Inside a transaction the
+ * marks are held until cfgpack_txn_commit() or cfgpack_txn_abort().
+ *
+ * A callback may read the context and set entries; those changes are
+ * delivered in a further pass once the callbacks of the current one
+ * return, so callbacks must not keep changing each other's entries.
+ * Lazy-pagein decodes and cfgpack_presence_set() are not changes.
+ * cfgpack_init() detaches the subscriptions.  Only in CFGPACK_NOTIFY
+ * builds.
+ *
+ * @param ctx       Initialized context.
+ * @param subs      Subscription table (may live in flash); referenced, not
+ *                  copied.  Ranges may overlap.
+ * @param count     Elements in @p subs.
+ * @param bits      Caller storage of CFGPACK_NOTIFY_BYTES(entry_count)
+ *                  bytes.
+ * @param bits_len  Size of @p bits in bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         subscription without a callback or with first > last;
+ *         CFGPACK_ERR_BOUNDS if @p bits_len is too small.
+ */
+cfgpack_err_t cfgpack_notify_init(cfgpack_ctx_t *ctx,
+                                  const cfgpack_sub_t *subs,
+                                  size_t count,
+                                  uint8_t *bits,
+                                  size_t bits_len);
+
+/**
+ * @brief Whether an entry changed in the batch being delivered.
+ *
+ * Meant for notification callbacks; returns 0 outside of them.
+ *
+ * @param ctx   Context passed to the callback.
+ * @param index Schema index to query.
+ * @return 1 if the entry changed in this batch, 0 otherwise.
+ */
+int cfgpack_notify_changed(const cfgpack_ctx_t *ctx, uint16_t index);
+#endif /* CFGPACK_NOTIFY */
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Typed Getter Convenience Functions (by index)
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -722,42 +1580,704 @@ cfgpack_err_t cfgpack_get_fstr_by_name(const cfgpack_ctx_t *ctx,
                                        uint8_t *len);
 
 /**
- * @brief Encode present values into a MessagePack map in caller buffer.
+ * @brief Borrow a string value of either string type by index.
  *
- * The schema name is automatically written at CFGPACK_INDEX_RESERVED_NAME (0)
- * to enable version detection when loading config from flash.
+ * Returns a pointer to the value's bytes where they are stored (the string
+ * pool, or the defaults blob of a cfgpack_init_cow() context); nothing is
+ * copied.  Unlike cfgpack_get_str() and cfgpack_get_fstr(), a `str` and an
+ * `fstr` entry are both accepted, so callers need not know which one an
+ * entry is.
  *
- * @param ctx      Initialized context.
- * @param out      Output buffer for MessagePack payload.
- * @param out_cap  Capacity of @p out in bytes.
- * @param out_len  Optional length written (set on success).
- * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if buffer too small.
+ * The view stays valid until the next set, pagein or cfgpack_init() that
+ * touches the entry; copy it out before any of those.  Pool strings are
+ * NUL-terminated, copy-on-write defaults are not, so use @p len.
+ *
+ * @param ctx   Initialized context.
+ * @param index Schema index of a `str` or `fstr` entry.
+ * @param out   Receives a pointer to the string bytes.
+ * @param len   Receives the string length in bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_RESERVED_INDEX for index 0; CFGPACK_ERR_MISSING if
+ *         absent or unknown; CFGPACK_ERR_TYPE_MISMATCH if the entry is not a
+ *         string; CFGPACK_ERR_BOUNDS if the stored offset is corrupt.
  */
-cfgpack_err_t cfgpack_pageout(const cfgpack_ctx_t *ctx,
-                              uint8_t *out,
-                              size_t out_cap,
-                              size_t *out_len);
+cfgpack_err_t cfgpack_get_str_view(const cfgpack_ctx_t *ctx,
+                                   uint16_t index,
+                                   const char **out,
+                                   size_t *len);
 
 /**
- * @brief Measure the exact buffer size needed for cfgpack_pageout().
- *
- * Runs the full encoding logic without writing, tracking total bytes needed.
- * Use this to right-size the output buffer before calling cfgpack_pageout().
- *
- * @param ctx      Initialized context.
- * @param out_len  Receives the exact number of bytes cfgpack_pageout() will
- *                 write (including the CRC-32C trailer).
- * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if ctx or out_len is NULL.
+ * @brief Borrow a string value of either string type by name.
+ * @see cfgpack_get_str_view
+ */
+cfgpack_err_t cfgpack_get_str_view_by_name(const cfgpack_ctx_t *ctx,
+                                           const char *name,
+                                           const char **out,
+                                           size_t *len);
+
+/**
+ * @brief Borrow a string value of either string type by schema position.
+ * @see cfgpack_get_str_view, cfgpack_get_at
+ */
+cfgpack_err_t cfgpack_get_str_view_at(const cfgpack_ctx_t *ctx,
+                                      size_t pos,
+                                      const char **out,
+                                      size_t *len);
+
+/**
+ * @brief Set a string of either string type by schema position.
+ *
+ * Takes @p len bytes of @p str, which need not be NUL-terminated; the
+ * pool copy is.  Otherwise as cfgpack_set_str() and cfgpack_set_fstr().
+ *
+ * @param ctx Initialized context.
+ * @param pos Schema position of a `str` or `fstr` entry.
+ * @param str String bytes.
+ * @param len Length of @p str in bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_MISSING if @p pos is not below the entry count;
+ *         CFGPACK_ERR_TYPE_MISMATCH if the entry is not a string;
+ *         CFGPACK_ERR_STR_TOO_LONG if @p len exceeds the entry's limit;
+ *         CFGPACK_ERR_BOUNDS if the undo journal of an open transaction is
+ *         full.
+ */
+cfgpack_err_t cfgpack_set_str_at(cfgpack_ctx_t *ctx,
+                                 size_t pos,
+                                 const char *str,
+                                 size_t len);
+
+#ifdef CFGPACK_SEQLOCK
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Lock-Free Consistent Readers (CFGPACK_SEQLOCK)
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Get a value without a lock while another task may be writing.
+ *
+ * Reads as cfgpack_get() between two loads of the context's sequence
+ * counter and retries if a cfgpack_set*() or pagein ran in between, so
+ * the value is never torn.  Up to CFGPACK_SEQLOCK_RETRIES attempts are
+ * made.  Lazy pagein decodes on read, so it cannot be combined with
+ * these readers.
+ *
+ * @param ctx       Initialized context, written only through the API.
+ * @param index     Schema index to retrieve.
+ * @param out_value Filled on success.
+ * @return As cfgpack_get(); CFGPACK_ERR_ARGS if cfgpack_lazy_init() is
+ *         attached; CFGPACK_ERR_BUSY if every attempt overlapped a write.
+ */
+cfgpack_err_t cfgpack_get_consistent(const cfgpack_ctx_t *ctx,
+                                     uint16_t index,
+                                     cfgpack_value_t *out_value);
+
+/**
+ * @brief Get several values as one consistent snapshot.
+ *
+ * Like cfgpack_get_many(), retried as cfgpack_get_consistent(), so all
+ * values come from the same state between two writes.
+ *
+ * @return As cfgpack_get_many(); CFGPACK_ERR_ARGS if lazy pagein is
+ *         attached; CFGPACK_ERR_BUSY if every attempt overlapped a write.
+ */
+cfgpack_err_t cfgpack_get_many_consistent(const cfgpack_ctx_t *ctx,
+                                          const uint16_t *indices,
+                                          size_t count,
+                                          cfgpack_value_t *out_values,
+                                          size_t *failed);
+
+/**
+ * @brief Copy a `str` or `fstr` value out without a lock.
+ *
+ * A view into the pool could change under the reader, so the bytes are
+ * copied into @p buf and NUL-terminated inside the retried read.
+ *
+ * @param ctx   Initialized context.
+ * @param index Schema index of a `str` or `fstr` entry.
+ * @param buf   Receives the string and a NUL terminator.
+ * @param cap   Capacity of @p buf in bytes.
+ * @param len   Optional; receives the string length.
+ * @return As cfgpack_get_str_view(); CFGPACK_ERR_STR_TOO_LONG if the
+ *         string and its terminator do not fit in @p cap;
+ *         CFGPACK_ERR_ARGS if lazy pagein is attached; CFGPACK_ERR_BUSY if
+ *         every attempt overlapped a write.
+ */
+cfgpack_err_t cfgpack_get_str_consistent(const cfgpack_ctx_t *ctx,
+                                         uint16_t index,
+                                         char *buf,
+                                         size_t cap,
+                                         size_t *len);
+
+/** @brief Get a uint8_t value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_u8_consistent(const cfgpack_ctx_t *ctx,
+                                                      uint16_t index,
+                                                      uint8_t *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_U8) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = (uint8_t)v.v.u64;
+    return CFGPACK_OK;
+}
+
+/** @brief Get a uint16_t value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_u16_consistent(const cfgpack_ctx_t *ctx,
+                                                       uint16_t index,
+                                                       uint16_t *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_U16) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = (uint16_t)v.v.u64;
+    return CFGPACK_OK;
+}
+
+/** @brief Get a uint32_t value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_u32_consistent(const cfgpack_ctx_t *ctx,
+                                                       uint16_t index,
+                                                       uint32_t *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_U32) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = (uint32_t)v.v.u64;
+    return CFGPACK_OK;
+}
+
+/** @brief Get a uint64_t value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_u64_consistent(const cfgpack_ctx_t *ctx,
+                                                       uint16_t index,
+                                                       uint64_t *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_U64) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = v.v.u64;
+    return CFGPACK_OK;
+}
+
+/** @brief Get an int8_t value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_i8_consistent(const cfgpack_ctx_t *ctx,
+                                                      uint16_t index,
+                                                      int8_t *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_I8) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = (int8_t)v.v.i64;
+    return CFGPACK_OK;
+}
+
+/** @brief Get an int16_t value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_i16_consistent(const cfgpack_ctx_t *ctx,
+                                                       uint16_t index,
+                                                       int16_t *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_I16) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = (int16_t)v.v.i64;
+    return CFGPACK_OK;
+}
+
+/** @brief Get an int32_t value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_i32_consistent(const cfgpack_ctx_t *ctx,
+                                                       uint16_t index,
+                                                       int32_t *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_I32) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = (int32_t)v.v.i64;
+    return CFGPACK_OK;
+}
+
+/** @brief Get an int64_t value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_i64_consistent(const cfgpack_ctx_t *ctx,
+                                                       uint16_t index,
+                                                       int64_t *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_I64) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = v.v.i64;
+    return CFGPACK_OK;
+}
+
+/** @brief Get a float value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_f32_consistent(const cfgpack_ctx_t *ctx,
+                                                       uint16_t index,
+                                                       float *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_F32) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = v.v.f32;
+    return CFGPACK_OK;
+}
+
+/** @brief Get a double value consistently. @see cfgpack_get_consistent */
+static inline cfgpack_err_t cfgpack_get_f64_consistent(const cfgpack_ctx_t *ctx,
+                                                       uint16_t index,
+                                                       double *out) {
+    cfgpack_value_t v;
+    cfgpack_err_t rc = cfgpack_get_consistent(ctx, index, &v);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    if (v.type != CFGPACK_TYPE_F64) {
+        return CFGPACK_ERR_TYPE_MISMATCH;
+    }
+    *out = v.v.f64;
+    return CFGPACK_OK;
+}
+#endif /* CFGPACK_SEQLOCK */
+
+#ifdef CFGPACK_STATS
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Instrumentation (CFGPACK_STATS)
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Attach per-context counters.
+ *
+ * Zeroes @p stats and counts the context's activity into it from now on,
+ * in addition to the global counters.  cfgpack_init() and its variants
+ * detach it again.
+ *
+ * @param ctx   Initialized context.
+ * @param stats Caller-owned counters, or NULL to detach.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if @p ctx is NULL.
+ */
+cfgpack_err_t cfgpack_stats_init(cfgpack_ctx_t *ctx, cfgpack_stats_t *stats);
+
+/**
+ * @brief Counters summed over every context, plus parse and CRC work.
+ *
+ * @return The library's global counters; zero them with memset to reset.
+ */
+cfgpack_stats_t *cfgpack_stats_global(void);
+
+/**
+ * @brief Set the hook called around each parse, pagein, pageout and
+ *        decompression.
+ *
+ * The hook is global, since a parse has no context yet.  It runs on the
+ * caller's thread, inside the operation, and must not call back into the
+ * library on the same context.
+ *
+ * @param fn   Hook, or NULL to remove it.
+ * @param user Passed through to @p fn.
+ */
+void cfgpack_stats_hook(cfgpack_stats_hook_fn fn, void *user);
+#endif /* CFGPACK_STATS */
+
+/**
+ * @brief Encode present values into a MessagePack map in caller buffer.
+ *
+ * The schema name is automatically written at CFGPACK_INDEX_RESERVED_NAME (0)
+ * to enable version detection when loading config from flash.
+ * On success every dirty bit is cleared.  With cfgpack_size_cache_init()
+ * and @p out_cap at least the cached size, the blob is written without
+ * per-append bounds checks.
+ *
+ * @param ctx      Initialized context.
+ * @param out      Output buffer for MessagePack payload.
+ * @param out_cap  Capacity of @p out in bytes.
+ * @param out_len  Optional length written (set on success).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if buffer too small.
+ */
+cfgpack_err_t cfgpack_pageout(cfgpack_ctx_t *ctx,
+                              uint8_t *out,
+                              size_t out_cap,
+                              size_t *out_len);
+
+#ifdef CFGPACK_PACKED_WIRE
+/**
+ * @brief Encode present values in the packed layout (wire format v2).
+ *
+ * Still one msgpack value with a CRC-32C trailer, but an array instead of
+ * a map, so no entry carries a key:
+ *
+ *   - the schema header bin of CFGPACK_INDEX_HEADER, whether or not
+ *     cfgpack_header_enable() is set;
+ *   - the schema name, as a str;
+ *   - the presence bitmap in entry order, as a bin of
+ *     (entry_count + 7) / 8 bytes (bit i % 8 of byte i / 8 for entry i);
+ *   - the value of each present entry, in entry order.
+ *
+ * Dense configs shrink by the 1-3 key bytes of every entry, and pagein
+ * becomes a straight walk with no key lookups.  cfgpack_pagein_buf(),
+ * cfgpack_pagein_remap(), cfgpack_pagein_stream() and cfgpack_peek_name()
+ * detect the layout from the first byte.  The entries are identified by
+ * position only, so a packed blob loads only into a schema with the same
+ * fingerprint, and a remap table is not used; keep cfgpack_pageout() for
+ * storage that must survive a schema change.  Deltas, patches and the
+ * offset-index footer are map features and do not take packed blobs.
+ * cfgpack_blob_enc_max() bounds both layouts.  On success every dirty bit
+ * is cleared.  Only in CFGPACK_PACKED_WIRE builds; elsewhere pagein
+ * rejects packed blobs with CFGPACK_ERR_DECODE.
+ *
+ * @param ctx      Initialized context.
+ * @param out      Output buffer for the blob.
+ * @param out_cap  Capacity of @p out in bytes.
+ * @param out_len  Optional length written (bytes needed on ENCODE error).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if buffer too small.
+ */
+cfgpack_err_t cfgpack_pageout_packed(cfgpack_ctx_t *ctx,
+                                     uint8_t *out,
+                                     size_t out_cap,
+                                     size_t *out_len);
+#endif /* CFGPACK_PACKED_WIRE */
+
+/**
+ * @brief Encode only entries set since the last pageout/pagein.
+ *
+ * Same format as cfgpack_pageout() (name at key 0, CRC-32C trailer), but
+ * the map holds only present entries whose dirty bit is set.  Apply it on
+ * top of a full blob with cfgpack_pagein_delta().  On success every dirty
+ * bit is cleared.
+ *
+ * @param ctx      Initialized context.
+ * @param out      Output buffer for MessagePack payload.
+ * @param out_cap  Capacity of @p out in bytes.
+ * @param out_len  Optional length written (bytes needed on ENCODE error).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if buffer too small.
+ */
+cfgpack_err_t cfgpack_pageout_delta(cfgpack_ctx_t *ctx,
+                                    uint8_t *out,
+                                    size_t out_cap,
+                                    size_t *out_len);
+
+/**
+ * @brief Encode every scalar at its schema width, for in-place patching.
+ *
+ * Same map as cfgpack_pageout(), and still plain msgpack that
+ * cfgpack_pagein_buf() reads unchanged, but each scalar uses the format
+ * of its schema type (u8 as 0xcc, u16 as 0xcd, i32 as 0xd2, f32 as 0xca,
+ * ...) whatever its value.  A later value of the same entry therefore
+ * encodes to the same number of bytes, and cfgpack_patch_fixed() can
+ * persist it by rewriting those bytes and the CRC-32C trailer.  Strings
+ * keep their exact length, so changing one needs a new pageout.
+ *
+ * @param ctx        Initialized context.
+ * @param out        Output buffer for MessagePack payload.
+ * @param out_cap    Capacity of @p out in bytes.
+ * @param out_len    Optional length written (bytes needed on ENCODE error).
+ * @param value_off  Optional array of entry_count elements; receives each
+ *                   entry's value offset in @p out, or 0 if not written.
+ *                   Keep it for cfgpack_patch_fixed().
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if buffer too small;
+ *         CFGPACK_ERR_BOUNDS if a value is wider than its schema type.
+ */
+cfgpack_err_t cfgpack_pageout_fixed(cfgpack_ctx_t *ctx,
+                                    uint8_t *out,
+                                    size_t out_cap,
+                                    size_t *out_len,
+                                    uint32_t *value_off);
+
+/**
+ * @brief Bytes to rewrite to persist one entry of a fixed-width blob.
+ *
+ * Write @c len bytes of @c bytes at blob offset @c off and the four
+ * @c crc bytes at @c crc_off.  On NOR flash an in-place write can only
+ * clear bits, so the target must be erased (or the write program only
+ * 1 -> 0 transitions).
+ */
+typedef struct {
+    size_t off;        /**< Blob offset of the value encoding. */
+    size_t len;        /**< Bytes in @c bytes. */
+    uint8_t bytes[9];  /**< New value encoding (format byte + payload). */
+    size_t crc_off;    /**< Blob offset of the CRC-32C trailer. */
+    uint8_t crc[4];    /**< New trailer, little-endian. */
+} cfgpack_patch_t;
+
+/**
+ * @brief Compute the in-place patch for one scalar of a fixed-width blob.
+ *
+ * Encodes the entry's current value at its schema width and derives the
+ * new CRC-32C trailer from the old one, the bytes being replaced and their
+ * distance from the end of the body, so only the old value bytes and the
+ * trailer are read through @p src, never the whole blob.  The context is
+ * not modified; dirty bits stay set.
+ *
+ * @param ctx        Initialized context.
+ * @param index      Entry index to persist.
+ * @param value_off  Offsets recorded by cfgpack_pageout_fixed().
+ * @param blob_len   Length of the stored blob, including the trailer.
+ * @param src        Reads the stored blob (see cfgpack_source_fn).
+ * @param user       Opaque pointer passed to @p src.
+ * @param patch      Receives the bytes to write.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_RESERVED_INDEX for index 0; CFGPACK_ERR_MISSING if
+ *         the entry is unknown, not present, or not in the blob;
+ *         CFGPACK_ERR_TYPE_MISMATCH for string entries;
+ *         CFGPACK_ERR_BOUNDS if the value is wider than its type or the
+ *         offset lies outside @p blob_len; CFGPACK_ERR_DECODE if the stored
+ *         format byte differs (offsets from another blob); any error
+ *         returned by @p src.
+ */
+cfgpack_err_t cfgpack_patch_fixed(const cfgpack_ctx_t *ctx,
+                                  uint16_t index,
+                                  const uint32_t *value_off,
+                                  size_t blob_len,
+                                  cfgpack_source_fn src,
+                                  void *user,
+                                  cfgpack_patch_t *patch);
+
+/**
+ * @brief Encode like cfgpack_pageout() and append an offset-index footer.
+ *
+ * The footer is one more map entry, key CFGPACK_INDEX_FOOTER, whose bin
+ * value lists every written index with the blob offset of its value,
+ * sorted by index.  It sits last before the CRC-32C trailer, which covers
+ * it.  cfgpack_pagein_buf() skips it; cfgpack_blob_get() uses it to read
+ * one value without decoding the rest.  The footer costs 6 bytes per
+ * entry plus 9 to 13 bytes of framing.
+ *
+ * @param ctx     Initialized context.
+ * @param out     Output buffer for MessagePack payload.
+ * @param out_cap Capacity of @p out in bytes.
+ * @param out_len Optional length written (bytes needed on ENCODE error).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if buffer too small.
+ */
+cfgpack_err_t cfgpack_pageout_indexed(cfgpack_ctx_t *ctx,
+                                      uint8_t *out,
+                                      size_t out_cap,
+                                      size_t *out_len);
+
+/**
+ * @brief Measure the exact buffer size needed for cfgpack_pageout().
+ *
+ * Runs the full encoding logic without writing, tracking total bytes needed.
+ * Use this to right-size the output buffer before calling cfgpack_pageout().
+ * With cfgpack_size_cache_init() the size is returned in constant time.
+ *
+ * @param ctx      Initialized context.
+ * @param out_len  Receives the exact number of bytes cfgpack_pageout() will
+ *                 write (including the CRC-32C trailer).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if ctx or out_len is NULL;
+ *         the decode error of a pending value (see cfgpack_lazy_init()).
  */
 cfgpack_err_t cfgpack_pageout_measure(const cfgpack_ctx_t *ctx,
                                       size_t *out_len);
 
+#ifdef CFGPACK_SIZE_CACHE
+/**
+ * @brief Track the encoded pageout size incrementally.
+ *
+ * Only in CFGPACK_SIZE_CACHE builds.
+ *
+ * Computes the size of the present entries once, then keeps it current on
+ * every cfgpack_set*() and pagein, so cfgpack_pageout_measure() no longer
+ * walks the context.  The cost is one extra size computation per write.
+ * cfgpack_init() turns tracking off; call this after it (and after any
+ * other *_init() attachment).  While tracking, change values only through
+ * the API: cfgpack_presence_set()/cfgpack_presence_clear() and direct
+ * writes to the values array are not seen.  Calling it again recomputes
+ * the size.  cfgpack_pageout() into a buffer the cached size fits then
+ * takes an unchecked encoder.
+ *
+ * @param ctx Initialized context.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if ctx is NULL.
+ */
+cfgpack_err_t cfgpack_size_cache_init(cfgpack_ctx_t *ctx);
+#endif /* CFGPACK_SIZE_CACHE */
+
+#ifdef CFGPACK_LAZY
+/**
+ * @brief Defer value decoding from pagein to first access.
+ *
+ * With lazy mode attached, cfgpack_pagein_buf() and cfgpack_pagein_remap()
+ * still verify the CRC-32C and walk the map, but only record where each
+ * known value starts in @p offsets and mark the entry present.  The value
+ * (and any string copy into the pool) is decoded the first time a
+ * cfgpack_get*() or cfgpack_print*() call reads it; cfgpack_set*() on a
+ * pending entry just replaces it.  A value that the eager pagein would
+ * have rejected (such as a type that does not coerce or a string too long
+ * for its slot) returns that error from the access instead, and the entry
+ * stays pending.
+ *
+ * The blob passed to pagein is referenced, not copied: it must stay valid
+ * and unchanged until every pending entry is decoded.  Pageout, measure,
+ * cfgpack_size_cache_init() and cfgpack_lazy_finish() decode all pending
+ * entries first.  Delta and streaming pagein decode eagerly as before.
+ * The file, LittleFS and decompressing wrappers page in from their scratch
+ * buffer, which then holds the blob.
+ * cfgpack_init() turns lazy mode off.  Only in CFGPACK_LAZY builds.
+ *
+ * @param ctx     Initialized context.
+ * @param offsets Caller-owned array of at least entry_count elements.
+ * @param count   Elements in @p offsets.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if @p count is below the entry count.
+ */
+cfgpack_err_t cfgpack_lazy_init(cfgpack_ctx_t *ctx,
+                                uint32_t *offsets,
+                                size_t count);
+
+/**
+ * @brief Decode every entry still pending from a lazy pagein.
+ *
+ * Afterwards the pagein blob is no longer referenced and may be released.
+ *
+ * @param ctx Initialized context.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if ctx is NULL; the
+ *         first decode error otherwise (later entries stay pending).
+ */
+cfgpack_err_t cfgpack_lazy_finish(cfgpack_ctx_t *ctx);
+#endif /* CFGPACK_LAZY */
+
+#ifdef CFGPACK_DEFAULTS_BLOB
+/**
+ * @brief Attach the schema defaults for default elision.
+ *
+ * @p blob is the cfgpack_pageout() of a context fresh from cfgpack_init(),
+ * taken before any set or pagein, so it holds exactly the entries with
+ * schema defaults.  Its CRC-32C is checked and the offset of each known
+ * value is recorded in @p offsets; the blob is referenced, not copied, and
+ * must stay valid and unchanged while attached.
+ *
+ * With defaults attached, cfgpack_pageout_elide() leaves out entries that
+ * still hold their default, and every full pagein restores an entry with
+ * a schema default that the blob does not carry by decoding it from
+ * @p blob, instead of only marking it present.  cfgpack_init() detaches
+ * the defaults.  Only in CFGPACK_DEFAULTS_BLOB builds.
+ *
+ * @param ctx     Initialized context.
+ * @param blob    Defaults-only pageout, including its CRC-32C trailer.
+ * @param len     Length of @p blob in bytes.
+ * @param offsets Caller-owned array of at least entry_count elements.
+ * @param count   Elements in @p offsets.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if @p count is below the entry count;
+ *         CFGPACK_ERR_CRC or CFGPACK_ERR_DECODE for a bad blob.
+ */
+cfgpack_err_t cfgpack_defaults_init(cfgpack_ctx_t *ctx,
+                                    const uint8_t *blob,
+                                    size_t len,
+                                    uint32_t *offsets,
+                                    size_t count);
+
+/**
+ * @brief Pageout that leaves out entries equal to their schema default.
+ *
+ * Like cfgpack_pageout(), but a present entry with a schema default is
+ * written only if its encoding differs from the one in the blob attached
+ * with cfgpack_defaults_init().  Any full pagein (cfgpack_pagein_buf(),
+ * cfgpack_pagein_remap(), streaming, file and decompressing wrappers)
+ * restores the omitted entries: from the attached defaults if present,
+ * otherwise by marking them present, which is only correct for a context
+ * that still holds its initial values.
+ *
+ * @param ctx      Context with defaults attached.
+ * @param out      Output buffer.
+ * @param out_cap  Capacity of @p out in bytes.
+ * @param out_len  Optional length written (set on success).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or
+ *         without attached defaults; CFGPACK_ERR_ENCODE if buffer too
+ *         small.
+ */
+cfgpack_err_t cfgpack_pageout_elide(cfgpack_ctx_t *ctx,
+                                    uint8_t *out,
+                                    size_t out_cap,
+                                    size_t *out_len);
+#endif /* CFGPACK_DEFAULTS_BLOB */
+
+/**
+ * @brief Minimum chunk size accepted by cfgpack_pageout_stream().
+ *
+ * Large enough for any scalar token plus its key, so small values never
+ * straddle a sink call.
+ */
+#define CFGPACK_STREAM_CHUNK_MIN 16
+
+/**
+ * @brief Encode the context as a stream of fixed-size chunks.
+ *
+ * Produces exactly the bytes cfgpack_pageout() would, but delivers them to
+ * @p sink through @p chunk_buf instead of requiring a buffer as large as
+ * the blob.  The CRC-32C trailer is computed while encoding and emitted
+ * last.  If encoding or the sink fails mid-stream the trailer is never
+ * written, so a reader will reject the truncated output.  Dirty bits are
+ * cleared only once the whole stream has reached the sink.
+ *
+ * @param ctx        Initialized context.
+ * @param sink       Chunk consumer (called one or more times, in order).
+ * @param user       Opaque pointer passed to @p sink.
+ * @param chunk_buf  Chunk scratch buffer.
+ * @param chunk_cap  Capacity of @p chunk_buf (>= CFGPACK_STREAM_CHUNK_MIN).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_ENCODE if @p chunk_cap is below the minimum;
+ *         the sink's error code if it fails.
+ */
+cfgpack_err_t cfgpack_pageout_stream(cfgpack_ctx_t *ctx,
+                                     cfgpack_sink_fn sink,
+                                     void *user,
+                                     uint8_t *chunk_buf,
+                                     size_t chunk_cap);
+
+/**
+ * @brief Write the schema header into every map pageout of @p ctx.
+ *
+ * Every pageout that writes a map (full, delta, fixed-width, indexed,
+ * elided, streaming and the file, LittleFS and slot wrappers) then puts a
+ * CFGPACK_INDEX_HEADER entry right after the schema name, adding
+ * CFGPACK_HEADER_SIZE bytes.  cfgpack_peek_header() reads it back without
+ * walking the blob, and cfgpack_pagein_remap() drops its remap table when
+ * the fingerprint matches the context's own schema.  Packed blobs always
+ * carry the header.  cfgpack_init() turns it off.  cfgpack_blob_diff()
+ * and cfgpack_patch_apply() check CRCs of the blobs without the header, so
+ * a patch applies whatever the setting on either side.
+ *
+ * @param ctx Initialized context.
+ * @param on  Nonzero to write the header, 0 to stop.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if ctx is NULL.
+ */
+cfgpack_err_t cfgpack_header_enable(cfgpack_ctx_t *ctx, int on);
+
 /**
  * @brief Peek at the schema name stored in a MessagePack config blob.
  *
  * Reads the schema name from CFGPACK_INDEX_RESERVED_NAME (0) without fully
  * decoding the blob. Use this to determine which remap table to apply when
- * loading config from a previous firmware version.
+ * loading config from a previous firmware version.  A packed blob
+ * (cfgpack_pageout_packed()) holds the name right after its header.
  *
  * @param data    MessagePack config blob.
  * @param len     Length of @p data in bytes.
@@ -772,6 +2292,451 @@ cfgpack_err_t cfgpack_peek_name(const uint8_t *data,
                                 char *out_name,
                                 size_t out_cap);
 
+/**
+ * @brief Read the schema fingerprint and version from a blob's header.
+ *
+ * Only the map header, key 0 and the name's length are decoded before the
+ * header entry, so the cost does not depend on the blob's size or entry
+ * count.  Compare the fingerprint with cfgpack_schema_fingerprint() of the
+ * candidate schemas to pick one before any pagein.  The CRC is not
+ * checked.
+ *
+ * @param data        Blob including its CRC trailer.
+ * @param len         Length of @p data in bytes.
+ * @param fingerprint Receives the layout fingerprint.
+ * @param version     Optional; receives the schema version.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_MISSING if the blob was written without
+ *         cfgpack_header_enable(); CFGPACK_ERR_DECODE if it is malformed.
+ */
+cfgpack_err_t cfgpack_peek_header(const uint8_t *data,
+                                  size_t len,
+                                  uint64_t *fingerprint,
+                                  uint32_t *version);
+
+/**
+ * @brief Read one scalar from a blob written by cfgpack_pageout_indexed().
+ *
+ * Binary-searches the offset-index footer and decodes only the value of
+ * @p index, in O(log n) without a context or schema.  @c out->type is the
+ * narrowest type of the stored encoding (U8 for 0..255, I8 for -1, F32 or
+ * F64), not the schema type; compare through @c out->v.  The CRC is not
+ * checked; use cfgpack_blob_verify() once per blob if the storage is not
+ * trusted.
+ *
+ * @param blob  Blob including its CRC trailer.
+ * @param len   Length of @p blob in bytes.
+ * @param index Entry index to read.
+ * @param out   Receives the value.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_DECODE if the blob has no valid footer or the value
+ *         is malformed; CFGPACK_ERR_MISSING if @p index is not in the
+ *         blob; CFGPACK_ERR_TYPE_MISMATCH for a string value.
+ */
+cfgpack_err_t cfgpack_blob_get(const uint8_t *blob,
+                               size_t len,
+                               uint16_t index,
+                               cfgpack_value_t *out);
+
+/**
+ * @brief Read one string from a blob written by cfgpack_pageout_indexed().
+ *
+ * Same lookup as cfgpack_blob_get().  The string is not null-terminated
+ * and points into @p blob.
+ *
+ * @param blob    Blob including its CRC trailer.
+ * @param len     Length of @p blob in bytes.
+ * @param index   Entry index to read.
+ * @param out     Receives a pointer to the string bytes.
+ * @param out_len Receives the string length.
+ * @return As cfgpack_blob_get(); CFGPACK_ERR_TYPE_MISMATCH for a scalar.
+ */
+cfgpack_err_t cfgpack_blob_get_str(const uint8_t *blob,
+                                   size_t len,
+                                   uint16_t index,
+                                   const char **out,
+                                   uint16_t *out_len);
+
+/**
+ * @brief Check the CRC-32C trailer of a blob without decoding it.
+ *
+ * @param blob Blob including its CRC trailer.
+ * @param len  Length of @p blob in bytes.
+ * @return CFGPACK_OK if the trailer matches; CFGPACK_ERR_CRC if not;
+ *         CFGPACK_ERR_DECODE if @p blob is NULL or shorter than the
+ *         trailer.
+ */
+cfgpack_err_t cfgpack_blob_verify(const uint8_t *blob, size_t len);
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Sectioned blobs
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Section table of a blob, from cfgpack_sections_open().
+ *
+ * Points into the blob; valid as long as it is.
+ */
+typedef struct {
+    const uint8_t *blob; /**< Blob the table belongs to */
+    const uint8_t *recs; /**< Section records inside the table */
+    size_t count;        /**< Number of sections */
+    size_t end;          /**< Offset of the table entry: last section end */
+    size_t body;         /**< Blob length without the CRC-32C trailer */
+} cfgpack_sections_t;
+
+/**
+ * @brief Encode like cfgpack_pageout() with a CRC-32C per section.
+ *
+ * The entries are grouped in order into sections of at least
+ * @p section_bytes (the last may be shorter); an entry never straddles
+ * two sections.  A section table follows the last entry, key
+ * CFGPACK_INDEX_SECTIONS, holding each section's offset and CRC-32C, and
+ * under its own CRC.  The whole-blob trailer is kept, so the blob still
+ * pages in with cfgpack_pagein_buf(), and cfgpack_pagein_sections() can
+ * keep the sections that verify when the trailer does not.  The table
+ * costs 8 bytes per section plus 13 to 17 bytes of framing.
+ *
+ * @param ctx           Initialized context.
+ * @param out           Output buffer.
+ * @param out_cap       Capacity of @p out in bytes.
+ * @param out_len       Optional length written (bytes needed on ENCODE
+ *                      error).
+ * @param section_bytes Minimum section size in bytes; 1 gives one
+ *                      section per entry.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         zero @p section_bytes; CFGPACK_ERR_ENCODE if the buffer is too
+ *         small.
+ */
+cfgpack_err_t cfgpack_pageout_sectioned(cfgpack_ctx_t *ctx,
+                                        uint8_t *out,
+                                        size_t out_cap,
+                                        size_t *out_len,
+                                        size_t section_bytes);
+
+/**
+ * @brief Locate and check the section table of a blob.
+ *
+ * Only the table is read: its framing, its own CRC-32C and the order of
+ * the section offsets.  The sections themselves are not checked.
+ *
+ * @param blob Blob including its CRC trailer.
+ * @param len  Length of @p blob in bytes.
+ * @param out  Receives the table.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_DECODE if the blob has no section table;
+ *         CFGPACK_ERR_CRC if the table itself is corrupt.
+ */
+cfgpack_err_t cfgpack_sections_open(const uint8_t *blob,
+                                    size_t len,
+                                    cfgpack_sections_t *out);
+
+/**
+ * @brief Blob offset of the first byte of section @p i.
+ *
+ * @param t Table from cfgpack_sections_open().
+ * @param i Section number; @c t->count or more gives @c t->end.
+ * @return Offset in @c t->blob.
+ */
+size_t cfgpack_sections_offset(const cfgpack_sections_t *t, size_t i);
+
+/**
+ * @brief Check sections [@p first, @p first + @p n) of an open table.
+ *
+ * Sets bit i of @p bad (byte i / 8) for each section i in the range whose
+ * CRC-32C does not match, and clears it for the others; other bits of
+ * @p bad are left alone.  Disjoint ranges may be checked concurrently if
+ * each starts at a multiple of 8.
+ *
+ * @param t     Table from cfgpack_sections_open().
+ * @param first First section to check.
+ * @param n     Number of sections; clamped to the table.
+ * @param bad   Bitmap of bad sections, or NULL.
+ * @param crc   Optional output: CRC-32C of the bytes of the range, for
+ *              folding into an overall check.
+ * @return Number of bad sections in the range.
+ */
+size_t cfgpack_sections_check(const cfgpack_sections_t *t,
+                              size_t first,
+                              size_t n,
+                              uint8_t *bad,
+                              uint32_t *crc);
+
+/**
+ * @brief Check every section of a blob and its trailer in one pass.
+ *
+ * The trailer check is folded from the section CRCs, so each byte is read
+ * once.  See cfgpack_bulk_verify_sections() for a parallel version.
+ *
+ * @param blob      Blob including its CRC trailer.
+ * @param len       Length of @p blob in bytes.
+ * @param bad       Optional bitmap: bit i set for each bad section i, the
+ *                  rest of its first (count + 7) / 8 bytes cleared.
+ * @param bad_len   Size of @p bad in bytes.
+ * @param bad_count Optional output: number of bad sections.
+ * @return CFGPACK_OK if every section and the trailer match;
+ *         CFGPACK_ERR_CRC if any does not, or the table is corrupt;
+ *         CFGPACK_ERR_DECODE if the blob has no section table;
+ *         CFGPACK_ERR_BOUNDS if @p bad cannot hold one bit per section.
+ */
+cfgpack_err_t cfgpack_sections_verify(const uint8_t *blob,
+                                      size_t len,
+                                      uint8_t *bad,
+                                      size_t bad_len,
+                                      size_t *bad_count);
+
+/**
+ * @brief Full pagein that keeps the sections that verify.
+ *
+ * A blob with no usable section table, or with a good trailer when
+ * @p bad is NULL, pages in exactly as with cfgpack_pagein_buf().
+ * Otherwise the context is reset,
+ * the entries of every good section are decoded, and the entries of the
+ * bad ones fall back to their defaults (or become absent).  The blob on
+ * storage is still damaged: write the context back with a pageout.
+ *
+ * @param ctx  Initialized context.
+ * @param data Blob including its CRC trailer.
+ * @param len  Length of @p data in bytes.
+ * @param bad  Bad-section bitmap from cfgpack_sections_verify() or
+ *             cfgpack_bulk_verify_sections(), or NULL to check each
+ *             section here.
+ * @param lost Optional output: number of sections dropped.
+ * @return CFGPACK_OK if the context was loaded, even with sections lost;
+ *         otherwise as cfgpack_pagein_buf().
+ */
+cfgpack_err_t cfgpack_pagein_sections(cfgpack_ctx_t *ctx,
+                                      const uint8_t *data,
+                                      size_t len,
+                                      const uint8_t *bad,
+                                      size_t *lost);
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Flash-aligned blobs
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Raw flash geometry for cfgpack_pageout_aligned().
+ */
+typedef struct {
+    size_t prog_size;    /**< Program page size in bytes */
+    size_t erase_size;   /**< Erase block size; a multiple of prog_size */
+    uint8_t erase_value; /**< Value of an erased byte (0xFF on NOR) */
+} cfgpack_flash_geom_t;
+
+/**
+ * @brief Bytes to erase before writing a blob of @p len bytes.
+ * @return @p len rounded up to whole erase blocks.
+ */
+static inline size_t cfgpack_flash_erase_span(const cfgpack_flash_geom_t *geom,
+                                              size_t len) {
+    return ((len + geom->erase_size - 1) / geom->erase_size *
+            geom->erase_size);
+}
+
+/**
+ * @brief Encode like cfgpack_pageout(), padded to whole program pages.
+ *
+ * A padding entry, key CFGPACK_INDEX_PAD, follows the last value and is
+ * sized so the CRC-32C trailer ends on a program page boundary.  The blob
+ * can then be programmed straight from @p out in whole pages, with no
+ * read-modify-write of a partial last page.  The filler bytes hold
+ * @c geom->erase_value, so on NOR they leave the cells as erased.  The
+ * padding costs 10 bytes of framing plus less than one page.
+ *
+ * The blob still pages in with cfgpack_pagein_buf() given its exact
+ * length; cfgpack_pagein_aligned() finds that length itself.
+ *
+ * @param ctx     Initialized context.
+ * @param out     Output buffer.
+ * @param out_cap Capacity of @p out in bytes.
+ * @param out_len Optional length written, a multiple of
+ *                @c geom->prog_size (bytes needed on ENCODE error).
+ * @param geom    Flash geometry.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments, a
+ *         zero page size or an erase size that is not a whole number of
+ *         pages; CFGPACK_ERR_ENCODE if the buffer is too small.
+ */
+cfgpack_err_t cfgpack_pageout_aligned(cfgpack_ctx_t *ctx,
+                                      uint8_t *out,
+                                      size_t out_cap,
+                                      size_t *out_len,
+                                      const cfgpack_flash_geom_t *geom);
+
+/**
+ * @brief Length of the blob at the start of a longer buffer.
+ *
+ * Walks the top-level msgpack value without decoding it and adds the
+ * CRC-32C trailer.  Whatever follows, such as erased flash, is not read.
+ * The CRC is not checked.
+ *
+ * @param data     Buffer starting with a blob.
+ * @param len      Length of @p data in bytes.
+ * @param blob_len Receives the blob length including its trailer.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_DECODE if no whole blob fits in @p len.
+ */
+cfgpack_err_t cfgpack_blob_extent(const uint8_t *data,
+                                  size_t len,
+                                  size_t *blob_len);
+
+/**
+ * @brief cfgpack_pagein_buf() on the blob at the start of @p data.
+ *
+ * For reading back a raw flash region without storing the blob length:
+ * @p len may cover the whole region, and cfgpack_blob_extent() locates
+ * the blob's end.
+ *
+ * @param ctx      Initialized context.
+ * @param data     Buffer starting with a blob.
+ * @param len      Length of @p data in bytes.
+ * @param blob_len Optional output: blob length including its trailer.
+ * @return As cfgpack_pagein_buf(); CFGPACK_ERR_DECODE if no whole blob
+ *         fits in @p len (an erased region, for one).
+ */
+cfgpack_err_t cfgpack_pagein_aligned(cfgpack_ctx_t *ctx,
+                                     const uint8_t *data,
+                                     size_t len,
+                                     size_t *blob_len);
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Resumable pagein and pageout
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief State of a cfgpack_pagein_step() run.
+ *
+ * Set up by cfgpack_pagein_step_begin(); the fields are private.
+ */
+typedef struct {
+    cfgpack_reader_t r;                 /**< Reader over the blob body */
+    const cfgpack_remap_entry_t *remap; /**< Remap table, or NULL */
+    size_t remap_count;                 /**< Entries in @c remap */
+    const uint8_t *select;              /**< Entries to decode, or NULL */
+    size_t rcur;                        /**< Remap cursor */
+    size_t cur;                         /**< Schema entry cursor */
+    size_t checked;                     /**< Body bytes CRC-checked */
+    uint32_t crc;                       /**< CRC-32C register so far */
+    uint32_t keys;                      /**< Map keys left to decode */
+    uint8_t merge;                      /**< Full, delta or layered */
+    uint8_t lazy;                       /**< Record offsets only */
+    uint8_t remap_sorted;               /**< @c remap sorted by old index */
+    uint8_t phase;                      /**< Check, decode or done */
+} cfgpack_pagein_step_t;
+
+/**
+ * @brief State of a cfgpack_pageout_step() run.
+ *
+ * Set up by cfgpack_pageout_step_begin(); the fields are private.
+ */
+typedef struct {
+    cfgpack_buf_t buf;         /**< Output so far, with its running CRC */
+    cfgpack_present_iter_t it; /**< Next entry to encode */
+    uint32_t set_count;        /**< ctx->set_count when begun */
+    uint8_t phase;             /**< Head, entries or done */
+} cfgpack_pageout_step_t;
+
+/**
+ * @brief Start a resumable cfgpack_pagein_remap().
+ *
+ * Only records the arguments; nothing is read until the first step.  The
+ * blob must stay in place until the run is done.
+ *
+ * @param s           State to set up.
+ * @param data        Blob including its CRC trailer.
+ * @param len         Length of @p data in bytes.
+ * @param remap       Remap table as for cfgpack_pagein_remap(), or NULL.
+ * @param remap_count Entries in @p remap.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_DECODE if @p len cannot hold a trailer.
+ */
+cfgpack_err_t cfgpack_pagein_step_begin(cfgpack_pagein_step_t *s,
+                                        const uint8_t *data,
+                                        size_t len,
+                                        const cfgpack_remap_entry_t *remap,
+                                        size_t remap_count);
+
+/**
+ * @brief Run a bounded slice of a pagein begun with
+ *        cfgpack_pagein_step_begin().
+ *
+ * Each call first checks up to @p budget * CFGPACK_STEP_CRC_BYTES bytes
+ * against the CRC-32C trailer; once the whole blob verifies, each call
+ * decodes up to @p budget map entries.  The context is untouched until
+ * the blob verifies.  The result is the same as cfgpack_pagein_remap().
+ *
+ * While entries are being decoded the context holds part of the old
+ * config and part of the new, so it must not be read or written until
+ * the run is done.  Under CFGPACK_SEQLOCK the write section spans the
+ * decoding steps, and consistent readers return CFGPACK_ERR_BUSY meanwhile.
+ *
+ * The first decoding step also clears the bitmaps, and the last restores
+ * schema defaults; both are passes over the schema whatever the budget.
+ * A packed blob (cfgpack_pageout_packed()) decodes in one step.
+ *
+ * @param ctx    Initialized context.
+ * @param s      State from cfgpack_pagein_step_begin().
+ * @param budget Work per call; at least 1.
+ * @return CFGPACK_IN_PROGRESS if more steps are needed; CFGPACK_OK once
+ *         the pagein is done; otherwise as cfgpack_pagein_remap(), which
+ *         also ends the run; CFGPACK_ERR_ARGS on NULL arguments, a zero
+ *         @p budget or a run that is already done.
+ */
+cfgpack_err_t cfgpack_pagein_step(cfgpack_ctx_t *ctx,
+                                  cfgpack_pagein_step_t *s,
+                                  size_t budget);
+
+/**
+ * @brief Give up a pagein run.
+ *
+ * A run still checking the CRC leaves the context as it was.  One that
+ * was decoding leaves it partly loaded, as a failed pagein would: the
+ * write section is ended and subscribers are notified.
+ *
+ * @param ctx Context the run was stepping.
+ * @param s   State from cfgpack_pagein_step_begin().
+ */
+void cfgpack_pagein_step_abort(cfgpack_ctx_t *ctx, cfgpack_pagein_step_t *s);
+
+/**
+ * @brief Start a resumable cfgpack_pageout().
+ *
+ * @param s       State to set up.
+ * @param out     Output buffer, which must stay in place.
+ * @param out_cap Capacity of @p out in bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments.
+ */
+cfgpack_err_t cfgpack_pageout_step_begin(cfgpack_pageout_step_t *s,
+                                         uint8_t *out,
+                                         size_t out_cap);
+
+/**
+ * @brief Run a bounded slice of a pageout begun with
+ *        cfgpack_pageout_step_begin().
+ *
+ * Each call encodes up to @p budget entries, resolving pending lazy
+ * entries as it reaches them; the final call appends the CRC-32C trailer.
+ * The bytes are the same as cfgpack_pageout()'s, and dirty bits are
+ * cleared once the run succeeds.  A cfgpack_set*() between steps ends the
+ * run with CFGPACK_ERR_BUSY, since the blob would mix two states.
+ *
+ * @param ctx     Initialized context.
+ * @param s       State from cfgpack_pageout_step_begin().
+ * @param budget  Entries per call; at least 1.
+ * @param out_len Optional; receives the blob length once done (bytes
+ *                needed on ENCODE error).
+ * @return CFGPACK_IN_PROGRESS if more steps are needed; CFGPACK_OK once
+ *         the blob is complete; CFGPACK_ERR_ENCODE if @p out is too
+ *         small; CFGPACK_ERR_BUSY if the context was written since the
+ *         run began; CFGPACK_ERR_ARGS on NULL arguments, a zero
+ *         @p budget or a run that is already done;
+ *         a lazy decode error.  Every result but IN_PROGRESS ends the run.
+ */
+cfgpack_err_t cfgpack_pageout_step(cfgpack_ctx_t *ctx,
+                                   cfgpack_pageout_step_t *s,
+                                   size_t budget,
+                                   size_t *out_len);
+
 /**
  * @brief Decode from a MessagePack buffer into the context with index remapping.
  *
@@ -785,6 +2750,11 @@ cfgpack_err_t cfgpack_peek_name(const uint8_t *data,
  * - Keys not in schema (after remapping) are silently ignored
  * - Type widening is allowed (e.g., u8 value into u16 field)
  * - Type narrowing or incompatible types return CFGPACK_ERR_TYPE_MISMATCH
+ * - A packed blob (cfgpack_pageout_packed()) is decoded by position with
+ *   the remap table unused; one with another layout fingerprint returns
+ *   CFGPACK_ERR_TYPE_MISMATCH before any entry changes
+ * - A map blob whose schema header (cfgpack_header_enable()) carries the
+ *   context's own fingerprint is loaded with the remap table unused
  *
  * @param ctx         Initialized context.
  * @param data        MessagePack map buffer.
@@ -801,11 +2771,211 @@ cfgpack_err_t cfgpack_pagein_remap(cfgpack_ctx_t *ctx,
                                    const cfgpack_remap_entry_t *remap,
                                    size_t remap_count);
 
+/**
+ * @brief Spare buffers for cfgpack_pagein_staged().
+ *
+ * Sized like the buffers passed to cfgpack_init().  After a successful
+ * staged pagein the context runs on these buffers and the struct holds the
+ * ones the context used before, ready for the next staged pagein.
+ */
+typedef struct {
+    cfgpack_value_t *values; /**< Value slots. */
+    size_t values_count;     /**< Elements in values (>= entry_count). */
+    char *str_pool;          /**< String pool. */
+    size_t str_pool_cap;     /**< Capacity of str_pool (>= the context's). */
+    cfgpack_str_off_t *str_offsets; /**< String offsets. */
+    size_t str_offsets_count;       /**< Elements (>= the context's). */
+#ifdef CFGPACK_LARGE_SCHEMA
+    uint8_t *bitmaps; /**< CFGPACK_BITMAP_BYTES(entry_count) bytes. */
+#endif
+} cfgpack_stage_t;
+
+/**
+ * @brief Pagein into spare buffers, then switch the context to them.
+ *
+ * Like cfgpack_pagein_remap(), but the context is untouched unless the
+ * whole blob decodes.  The current values, string pool and offsets are
+ * copied into @p stage first, so defaults and unset strings carry over as
+ * with an in-place pagein, and the blob is decoded there.  On success the
+ * context's buffer pointers are swapped with those in @p stage: the
+ * values, pool and offsets are not copied back.  The presence and dirty
+ * bitmaps are copied, or swapped too in a CFGPACK_LARGE_SCHEMA build.
+ *
+ * The swap is one seqlock write section, so consistent readers see the
+ * old or the new config, never a mix and never a half-decoded one.  On
+ * failure (type mismatch, bad string, CRC) nothing changes, no
+ * subscriber is notified, and the context still holds the previous
+ * config.  Pending lazy entries are decoded first; the staged pagein
+ * itself is eager.
+ *
+ * @param ctx         Initialized context.
+ * @param data        Blob including its CRC trailer.
+ * @param len         Length of @p data in bytes.
+ * @param remap       Remap table (NULL for no remapping).
+ * @param remap_count Number of entries in @p remap.
+ * @param stage       Spare buffers; receives the previous buffers.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments, a
+ *         packed value arena or an open transaction; CFGPACK_ERR_BOUNDS if
+ *         a stage buffer is smaller than the context's; otherwise as
+ *         cfgpack_pagein_remap().
+ */
+cfgpack_err_t cfgpack_pagein_staged(cfgpack_ctx_t *ctx,
+                                    const uint8_t *data,
+                                    size_t len,
+                                    const cfgpack_remap_entry_t *remap,
+                                    size_t remap_count,
+                                    cfgpack_stage_t *stage);
+
+/**
+ * @brief Compile one or more remap tables into a single sorted table.
+ *
+ * Composes a migration chain (e.g. v1->v2, then v2->v3) into one old->new
+ * mapping, applying each table in order with unmapped indices passing
+ * through unchanged.  The result is sorted by old_index, without identity
+ * entries, so cfgpack_pagein_remap() walks it with a cursor instead of
+ * scanning it per key: a device that skipped several versions migrates in
+ * a single decode pass.  A single table may be passed to just sort it.
+ *
+ * Composition follows indices only.  An index that an intermediate schema
+ * removed and a later schema reused is carried into the new entry, which
+ * step-by-step migration would have dropped; add a remap entry to an
+ * unused index in that step to discard it.
+ *
+ * @param tables      Remap tables in migration order (NULL allowed for a
+ *                    step whose count is 0).
+ * @param counts      Number of entries in each table.
+ * @param table_count Number of tables.
+ * @param out         Output table (must not overlap the inputs).
+ * @param out_cap     Capacity of @p out (the sum of @p counts suffices).
+ * @param out_count   Receives the number of entries written.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_DUPLICATE if a table lists the same old_index twice;
+ *         CFGPACK_ERR_BOUNDS if @p out_cap is too small.
+ */
+cfgpack_err_t cfgpack_remap_compile(const cfgpack_remap_entry_t *const *tables,
+                                    const size_t *counts,
+                                    size_t table_count,
+                                    cfgpack_remap_entry_t *out,
+                                    size_t out_cap,
+                                    size_t *out_count);
+
+/** @name Migration action kinds (cfgpack_migrate_action_t::kind)
+ *  @{ */
+#define CFGPACK_MIGRATE_KEEP  0 /**< Same index and type. */
+#define CFGPACK_MIGRATE_MOVE  1 /**< Same type at a new index. */
+#define CFGPACK_MIGRATE_WIDEN 2 /**< Wider type (the index may move too). */
+#define CFGPACK_MIGRATE_DROP  3 /**< Not in the new schema; skipped. */
+/** @} */
+
+/** @name Migration decoders (cfgpack_migrate_action_t::decode)
+ *  @{ */
+#define CFGPACK_MIGRATE_DEC_UINT     0 /**< Unsigned into unsigned. */
+#define CFGPACK_MIGRATE_DEC_INT      1 /**< Signed into signed. */
+#define CFGPACK_MIGRATE_DEC_UINT_INT 2 /**< Unsigned into wider signed. */
+#define CFGPACK_MIGRATE_DEC_F32      3 /**< f32 into f32. */
+#define CFGPACK_MIGRATE_DEC_F64      4 /**< f64 into f64. */
+#define CFGPACK_MIGRATE_DEC_F32_F64  5 /**< f32 into f64. */
+#define CFGPACK_MIGRATE_DEC_STR      6 /**< str or fstr into a string. */
+/** @} */
+
+/**
+ * @brief One old-schema entry of a migration plan.
+ */
+typedef struct {
+    uint16_t old_index; /**< Index in the old schema. */
+    uint16_t new_pos;   /**< Entry offset in the new schema (not DROP). */
+    uint8_t kind;       /**< CFGPACK_MIGRATE_KEEP, _MOVE, _WIDEN or _DROP. */
+    uint8_t decode;     /**< CFGPACK_MIGRATE_DEC_*, resolved at build time. */
+} cfgpack_migrate_action_t;
+
+/**
+ * @brief Precompiled migration from one schema to another.
+ *
+ * Built by cfgpack_migration_build(), or emitted as a const table by
+ * cfgpack-migrate-gen, and run by cfgpack_pagein_migrate().
+ */
+typedef struct {
+    uint64_t from_fp; /**< cfgpack_schema_fingerprint() of the old schema. */
+    uint64_t to_fp;   /**< cfgpack_schema_fingerprint() of the new schema. */
+    const cfgpack_migrate_action_t *actions; /**< Sorted by old_index. */
+    size_t count;                            /**< Entries in @c actions. */
+} cfgpack_migration_t;
+
+/**
+ * @brief Build a migration plan by diffing two schemas.
+ *
+ * Entries are matched by name.  Each old entry gets one action, in old
+ * index order: KEEP, MOVE (same type, new index), WIDEN (a wider type;
+ * the index may change too) or DROP (name not in @p to).  Entries only
+ * in @p to are added: they start absent and take their defaults.  A
+ * renamed entry counts as dropped and added.
+ *
+ * Only value-preserving type changes are accepted: the same type, a wider
+ * integer of the same signedness, an unsigned integer into a strictly
+ * wider signed one (u8 into i16, not i8), f32 into f64, and fstr into
+ * str.  A string limit may grow but not shrink.
+ *
+ * The decoder of each action is chosen here, so cfgpack_pagein_migrate()
+ * needs no coercion check per key.  Build plans at build time with
+ * cfgpack-migrate-gen, or at startup when both schemas are at hand.
+ *
+ * @param from    Schema the stored blobs were written with.
+ * @param to      Schema of the context they are loaded into.
+ * @param actions Output actions (@p from->entry_count of them).
+ * @param cap     Capacity of @p actions.
+ * @param out     Receives the plan, pointing at @p actions.
+ * @param failed  Receives the entry offset in @p from of an incompatible
+ *                type change (may be NULL).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if @p cap is too small;
+ *         CFGPACK_ERR_TYPE_MISMATCH if an entry changed to a type that is
+ *         not a widening of its old one.
+ */
+cfgpack_err_t cfgpack_migration_build(const cfgpack_schema_t *from,
+                                      const cfgpack_schema_t *to,
+                                      cfgpack_migrate_action_t *actions,
+                                      size_t cap,
+                                      cfgpack_migration_t *out,
+                                      size_t *failed);
+
+/**
+ * @brief Decode a blob written with an older schema through a migration
+ *        plan.
+ *
+ * A full pagein like cfgpack_pagein_buf().  Blob keys are joined against
+ * the sorted actions with a cursor, and each value is decoded with its
+ * action's decoder straight into its new entry: no entry lookup, no remap
+ * search and no coercion check.  Old keys without an action are skipped,
+ * and new entries take their defaults.
+ *
+ * The plan is checked before anything is decoded: its new-schema
+ * fingerprint must be the context's, and each action must fit its entry.
+ * A blob with a schema header of the new layout is loaded by
+ * cfgpack_pagein_buf() with the plan unused; one with any other layout
+ * than the plan's old schema is refused.  Packed blobs of the old schema
+ * cannot be migrated.
+ *
+ * @param ctx  Initialized context with the plan's new schema.
+ * @param data MessagePack map buffer with CRC trailer.
+ * @param len  Length of @p data in bytes.
+ * @param m    Migration plan.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         malformed plan; CFGPACK_ERR_TYPE_MISMATCH if the plan is for
+ *         another schema or the blob's header names another layout;
+ *         CFGPACK_ERR_CRC or CFGPACK_ERR_DECODE as cfgpack_pagein_buf().
+ */
+cfgpack_err_t cfgpack_pagein_migrate(cfgpack_ctx_t *ctx,
+                                     const uint8_t *data,
+                                     size_t len,
+                                     const cfgpack_migration_t *m);
+
 /**
  * @brief Decode from a MessagePack buffer into the context.
  *
  * Equivalent to cfgpack_pagein_remap(ctx, data, len, NULL, 0).
  * Unknown keys are silently ignored for forward compatibility.
+ * With cfgpack_lazy_init() attached, values are decoded on first access
+ * and @p data must outlive them.
  *
  * @param ctx   Initialized context.
  * @param data  MessagePack map buffer.
@@ -817,6 +2987,241 @@ cfgpack_err_t cfgpack_pagein_buf(cfgpack_ctx_t *ctx,
                                  const uint8_t *data,
                                  size_t len);
 
+/**
+ * @brief Apply a blob from cfgpack_pageout_delta() on top of the context.
+ *
+ * Unlike cfgpack_pagein_buf(), presence and values of entries not in the
+ * blob are left untouched, so a full blob followed by its deltas, applied
+ * in order, reproduces the saved state.  The CRC-32C trailer is verified
+ * before any value changes.  Decoded entries have their dirty bit cleared.
+ *
+ * @param ctx   Initialized context.
+ * @param data  Delta blob.
+ * @param len   Length of @p data in bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_CRC on checksum mismatch;
+ *         CFGPACK_ERR_DECODE on malformed input or a packed blob.
+ */
+cfgpack_err_t cfgpack_pagein_delta(cfgpack_ctx_t *ctx,
+                                   const uint8_t *data,
+                                   size_t len);
+
+/**
+ * @brief One blob of a cfgpack_pagein_layers() stack.
+ */
+typedef struct {
+    const uint8_t *data;                /**< Blob from cfgpack_pageout(). */
+    size_t len;                         /**< Length, including the CRC. */
+    const cfgpack_remap_entry_t *remap; /**< As cfgpack_pagein_remap(), or
+                                             NULL. */
+    size_t remap_count;                 /**< Entries in @c remap. */
+} cfgpack_layer_t;
+
+/** Origin of an entry that holds its schema default. */
+#define CFGPACK_LAYER_DEFAULT 0xfeu
+/** Origin of an entry that no layer and no default supplied. */
+#define CFGPACK_LAYER_NONE 0xffu
+
+/**
+ * @brief Load a stack of blobs, the highest layer winning per entry.
+ *
+ * Resolves, for example, schema defaults under a factory calibration
+ * blob under a user blob in one pagein.  Every CRC-32C trailer is
+ * verified before any value changes.  The layers are then decoded from
+ * the top (@p layers[n - 1]) down, and a lower layer's key is skipped
+ * when a higher layer already supplied its entry, so each entry is
+ * decoded and each string copied into the pool once.  Entries no layer
+ * has get their schema default, as after cfgpack_pagein_buf().  All
+ * entries end up clean, and readers see the old state or the new one.
+ *
+ * If @p origin is given, it receives the layer number that supplied each
+ * entry at its schema position, CFGPACK_LAYER_DEFAULT for a default or
+ * CFGPACK_LAYER_NONE for an absent entry.  It is not updated by later
+ * setters.  To reset the entries of a layer, page in the layers below it
+ * again; @p origin tells which entries that changes.
+ *
+ * Values are decoded eagerly; cfgpack_lazy_init() is not used.
+ *
+ * @param ctx    Initialized context.
+ * @param layers Blobs, lowest first; each of map layout.
+ * @param n      Number of layers, at most CFGPACK_LAYERS_MAX.
+ * @param origin Optional; entry_count bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or
+ *         too many layers; CFGPACK_ERR_CRC on a checksum mismatch (the
+ *         context is untouched); CFGPACK_ERR_DECODE on malformed input or
+ *         a packed blob; decode errors as cfgpack_pagein_buf().
+ */
+cfgpack_err_t cfgpack_pagein_layers(cfgpack_ctx_t *ctx,
+                                    const cfgpack_layer_t *layers,
+                                    size_t n,
+                                    uint8_t *origin);
+
+/**
+ * @brief Inclusive range of schema indices, for cfgpack_select_ranges().
+ */
+typedef struct {
+    uint16_t first; /**< First index in the range. */
+    uint16_t last;  /**< Last index in the range (inclusive). */
+} cfgpack_index_range_t;
+
+/**
+ * @brief Build a cfgpack_pagein_filtered() bitmap from index ranges.
+ *
+ * Sets bit i (bit i % 8 of byte i / 8) for every schema entry i whose
+ * index lies in one of @p ranges, and clears the rest.  An empty list
+ * selects nothing.
+ *
+ * @param ctx        Initialized context.
+ * @param ranges     Index ranges, in any order; they may overlap.
+ * @param n          Number of ranges.
+ * @param select     Receives the bitmap.
+ * @param select_len Capacity of @p select; at least
+ *                   (entry_count + 7) / 8 bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if @p select is too small.
+ */
+cfgpack_err_t cfgpack_select_ranges(const cfgpack_ctx_t *ctx,
+                                    const cfgpack_index_range_t *ranges,
+                                    size_t n,
+                                    uint8_t *select,
+                                    size_t select_len);
+
+/**
+ * @brief Pagein for a subset of the entries only.
+ *
+ * Entries whose bit is set in @p select (same layout as the presence
+ * bitmap) are loaded as by cfgpack_pagein_buf(): the value from the blob
+ * if it has one, else the schema default, else absent, and the dirty bit
+ * cleared.  The other keys are skipped with cfgpack_msgpack_skip_value(),
+ * so their strings are not copied into the pool, and those entries keep
+ * their value, presence and dirty bit.  The CRC is verified once, before
+ * any value changes.
+ *
+ * This splits a boot in two: load the few entries needed early
+ * (clock, watchdog) first, and the rest later from a low-priority task
+ * with the complementary bitmap.  Two calls whose bitmaps cover every
+ * entry once leave the context as one cfgpack_pagein_buf() would.
+ * Values are decoded eagerly; cfgpack_lazy_init() is not used.
+ *
+ * @param ctx    Initialized context.
+ * @param data   Blob from cfgpack_pageout() (map layout).
+ * @param len    Length of @p data in bytes.
+ * @param select Entries to load, (entry_count + 7) / 8 bytes; see
+ *               cfgpack_select_ranges().
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_CRC on checksum mismatch; CFGPACK_ERR_DECODE on
+ *         malformed input or a packed blob; decode errors as
+ *         cfgpack_pagein_buf().
+ */
+cfgpack_err_t cfgpack_pagein_filtered(cfgpack_ctx_t *ctx,
+                                      const uint8_t *data,
+                                      size_t len,
+                                      const uint8_t *select);
+
+/**
+ * @brief Build a patch that turns blob @p base into blob @p target.
+ *
+ * Meant for the host side of an over-the-air update: instead of the full
+ * target, send the patch and apply it with cfgpack_patch_apply().  Both
+ * blobs must come from cfgpack_pageout() (or cfgpack_pageout_indexed(),
+ * whose footer is ignored) with the same schema name.  No schema or
+ * context is needed; values are compared as encoded bytes.
+ *
+ * The patch is itself a msgpack map with a CRC-32C trailer:
+ *
+ *   - key 0: the schema name;
+ *   - CFGPACK_INDEX_PATCH_BASE: CRC-32C the base blob pages out with;
+ *   - CFGPACK_INDEX_PATCH_RESULT: CRC-32C the target blob pages out with;
+ *   - CFGPACK_INDEX_PATCH_DEL: the indices in @p base but not in
+ *     @p target, as a bin of big-endian u16 (only if there are any);
+ *   - each index changed or added by @p target, with its target value.
+ *
+ * Unchanged entries are not carried, so a one-value change makes a patch
+ * of a few tens of bytes whatever the config size.
+ *
+ * @param base       Blob the device holds now.
+ * @param base_len   Length of @p base in bytes.
+ * @param target     Blob the device should end up with.
+ * @param target_len Length of @p target in bytes.
+ * @param out        Output buffer for the patch.
+ * @param out_cap    Capacity of @p out in bytes.
+ * @param out_len    Optional; receives the patch length (the required
+ *                   capacity if @p out is too small).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or
+ *         differing schema names; CFGPACK_ERR_CRC if either blob fails
+ *         its checksum; CFGPACK_ERR_DECODE on a malformed blob or one
+ *         whose keys do not ascend; CFGPACK_ERR_ENCODE if @p out is too
+ *         small.
+ */
+cfgpack_err_t cfgpack_blob_diff(const uint8_t *base,
+                                size_t base_len,
+                                const uint8_t *target,
+                                size_t target_len,
+                                uint8_t *out,
+                                size_t out_cap,
+                                size_t *out_len);
+
+/**
+ * @brief Apply a cfgpack_blob_diff() patch to a live context.
+ *
+ * Nothing changes unless every check passes: the patch trailer, the
+ * base CRC against what the context pages out with now, and the result
+ * CRC against what it will page out with once patched.  A context that
+ * does not hold the base (a missed update, a local change) is therefore
+ * left alone and needs the full blob instead.  Removed entries lose
+ * their presence; set entries are decoded with the same type coercion as
+ * a pagein and marked dirty, since storage still holds the base.  Both
+ * are notified once.  The update runs as one seqlock write section.
+ * Inside a transaction the changes are not journaled.
+ *
+ * @param ctx   Initialized context.
+ * @param patch Patch from cfgpack_blob_diff().
+ * @param len   Length of @p patch in bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if ctx is NULL;
+ *         CFGPACK_ERR_CRC if the patch fails its checksum or the base or
+ *         result CRC does not match; CFGPACK_ERR_DECODE on a malformed
+ *         patch.
+ */
+cfgpack_err_t cfgpack_patch_apply(cfgpack_ctx_t *ctx,
+                                  const uint8_t *patch,
+                                  size_t len);
+
+/**
+ * @brief Minimum window size accepted by cfgpack_pagein_stream().
+ *
+ * Every string value must be decoded from a single window, so the window
+ * must hold the longest string (CFGPACK_STR_MAX) plus its header.
+ */
+#define CFGPACK_STREAM_WINDOW_MIN (CFGPACK_STR_MAX + 3)
+
+/**
+ * @brief Decode from a re-readable source through a small refill window.
+ *
+ * Peak RAM is @p window_cap regardless of blob size.  The source is read
+ * twice: pass 1 checksums the stream and verifies the CRC-32C trailer
+ * without touching @p ctx; pass 2 decodes map entries as the window is
+ * refilled.  Values are therefore committed only after the trailer has
+ * verified.  If the source changes between passes, the mismatch is
+ * reported as CFGPACK_ERR_CRC but @p ctx may be partially updated.
+ * Decoding semantics otherwise match cfgpack_pagein_buf().
+ *
+ * @param ctx         Initialized context.
+ * @param src         Source callback (must return the same bytes for the
+ *                    same offset on both passes).
+ * @param user        Opaque pointer passed to @p src.
+ * @param window      Window scratch buffer.
+ * @param window_cap  Capacity of @p window (>= CFGPACK_STREAM_WINDOW_MIN).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if @p window_cap is below the minimum;
+ *         CFGPACK_ERR_CRC on checksum mismatch; CFGPACK_ERR_DECODE on
+ *         malformed input (or a string longer than the window);
+ *         the source's error code if it fails.
+ */
+cfgpack_err_t cfgpack_pagein_stream(cfgpack_ctx_t *ctx,
+                                    cfgpack_source_fn src,
+                                    void *user,
+                                    uint8_t *window,
+                                    size_t window_cap);
+
 /**
  * @brief Print a single present value by index to stdout.
  *
@@ -857,4 +3262,43 @@ uint32_t cfgpack_get_version(const cfgpack_ctx_t *ctx);
  */
 size_t cfgpack_get_size(const cfgpack_ctx_t *ctx);
 
+/**
+ * @brief Return count of entries set since the last pageout/pagein.
+ * @param ctx Initialized context.
+ * @return Number of entries that are both present and dirty.
+ */
+size_t cfgpack_get_dirty_count(const cfgpack_ctx_t *ctx);
+
+/**
+ * @brief Callback for cfgpack_foreach_present().
+ * @param ctx  Context being scanned.
+ * @param off  Entry offset (into ctx->schema->entries).
+ * @param user Argument given to cfgpack_foreach_present().
+ * @return CFGPACK_OK to continue; anything else stops the scan.
+ */
+typedef cfgpack_err_t (*cfgpack_present_fn)(const cfgpack_ctx_t *ctx,
+                                            size_t off,
+                                            void *user);
+
+/**
+ * @brief Call @p fn for every present entry, in schema order.
+ *
+ * Absent entries are skipped 64 at a time (see cfgpack_present_next()
+ * for the inline cursor this wraps).  Entries still pending in a lazy
+ * pagein are visited; typed getters decode them on first access.
+ *
+ * @param ctx  Initialized context.
+ * @param fn   Callback.
+ * @param user Passed to @p fn.
+ * @return CFGPACK_OK after the last entry; the first non-OK result of
+ *         @p fn; CFGPACK_ERR_ARGS on NULL @p ctx or @p fn.
+ */
+cfgpack_err_t cfgpack_foreach_present(const cfgpack_ctx_t *ctx,
+                                      cfgpack_present_fn fn,
+                                      void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* CFGPACK_API_H */
@@ -0,0 +1,170 @@
+#ifndef CFGPACK_AUTOSAVE_H
+#define CFGPACK_AUTOSAVE_H
+
+/**
+ * @file autosave.h
+ * @brief Write-behind autosave driven by the dirty bitmap.
+ *
+ * Instead of paging out after every cfgpack_set*(), the application calls
+ * cfgpack_autosave_tick() from its main loop (or a timer) and lets the
+ * autosave decide when a save is worth it.  Sets are noticed through the
+ * context's write counter and dirty bits, so the set path is unchanged
+ * and a burst of sets costs one save:
+ *
+ * - @c debounce_ms: save once no set has been seen for this long.
+ * - @c max_stale_ms: but never later than this after the first unsaved
+ *   set, so a slider that never stops still gets written.
+ * - @c max_per_hour: and never more often than this, as a flash endurance
+ *   budget.  Saves are spaced at least 3600000 / max_per_hour ms apart;
+ *   the budget wins over @c max_stale_ms.
+ *
+ * The save itself is a callback, typically cfgpack_pageout_lfs() or
+ * cfgpack_slots_pageout() into the application's storage.  Times are
+ * milliseconds from any monotonic clock; they may wrap.
+ *
+ * Hosted builds (CFGPACK_HOSTED) can instead run the tick on a background
+ * thread, see cfgpack_autosave_start().  That part lives in
+ * src/autosave_thread.c and needs -pthread.
+ *
+ * This header is not pulled in by cfgpack.h.
+ */
+
+#include "api.h"
+#include "error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Save callback: write @p ctx to storage.
+ * @return CFGPACK_OK once the context is stored; any error keeps the
+ *         changes pending.
+ */
+typedef cfgpack_err_t (*cfgpack_autosave_fn)(cfgpack_ctx_t *ctx, void *user);
+
+/** Autosave timing, all in milliseconds. */
+typedef struct {
+    uint32_t debounce_ms;   /**< Quiet time after the last set */
+    uint32_t max_stale_ms;  /**< Oldest unsaved set, 0 for no limit */
+    uint32_t max_per_hour;  /**< Save budget, 0 for no limit */
+} cfgpack_autosave_cfg_t;
+
+/** Autosave state, owned by the caller.  Fields are private. */
+typedef struct {
+    cfgpack_ctx_t *ctx;         /**< Context being saved */
+    cfgpack_autosave_fn save;   /**< Save callback */
+    void *user;                 /**< Callback argument */
+    cfgpack_autosave_cfg_t cfg; /**< Timing */
+    uint32_t seen;              /**< ctx->set_count at the last tick */
+    uint32_t first_ms;          /**< First unsaved set seen */
+    uint32_t last_ms;           /**< Latest set seen */
+    uint32_t saved_ms;          /**< Latest save attempt */
+    uint8_t pending;            /**< Unsaved changes being timed */
+    uint8_t saved;              /**< saved_ms is valid */
+    uint32_t saves;             /**< Successful saves (wraps) */
+} cfgpack_autosave_t;
+
+/**
+ * @brief Attach an autosave to a context.
+ *
+ * Entries already dirty are timed from the first tick.
+ *
+ * @param as   Autosave state to initialize.
+ * @param ctx  Initialized context.
+ * @param cfg  Timing, copied.
+ * @param save Save callback.
+ * @param user Passed to @p save.
+ * @return CFGPACK_OK, or CFGPACK_ERR_ARGS on a NULL argument.
+ */
+cfgpack_err_t cfgpack_autosave_init(cfgpack_autosave_t *as,
+                                    cfgpack_ctx_t *ctx,
+                                    const cfgpack_autosave_cfg_t *cfg,
+                                    cfgpack_autosave_fn save,
+                                    void *user);
+
+/**
+ * @brief Save the context if it is due.
+ *
+ * Call this after sets and periodically.  It must not run concurrently
+ * with sets on the same context.  On a successful save every dirty bit
+ * is cleared.  A failed save is retried @c debounce_ms later (and no
+ * sooner than the budget allows).
+ *
+ * @param as      Autosave state.
+ * @param now_ms  Current time.
+ * @param wait_ms Optional: set to the time until the next save is due,
+ *                or UINT32_MAX when nothing is pending.
+ * @return CFGPACK_OK if nothing was due or the save succeeded; otherwise
+ *         the error of the save callback.  CFGPACK_ERR_ARGS on NULL @p as.
+ */
+cfgpack_err_t cfgpack_autosave_tick(cfgpack_autosave_t *as,
+                                    uint32_t now_ms,
+                                    uint32_t *wait_ms);
+
+/**
+ * @brief Save now if anything is dirty, ignoring debounce and budget.
+ *
+ * For shutdown and brown-out paths.  Does not count against the budget.
+ *
+ * @param as Autosave state.
+ * @return CFGPACK_OK if nothing was dirty or the save succeeded; otherwise
+ *         the error of the save callback.  CFGPACK_ERR_ARGS on NULL @p as.
+ */
+cfgpack_err_t cfgpack_autosave_flush(cfgpack_autosave_t *as);
+
+#ifdef CFGPACK_HOSTED
+  #include <pthread.h>
+
+/**
+ * @brief Background autosave thread (hosted only).
+ *
+ * The thread ticks @c as on CLOCK_MONOTONIC and sleeps until the next
+ * save is due.  Where condition variables cannot wait on that clock
+ * (macOS), the sleep deadline is taken from CLOCK_REALTIME, so a wall
+ * clock step can shorten or stretch one wait.  Sets from other threads
+ * must happen between cfgpack_autosave_lock() and
+ * cfgpack_autosave_unlock(); unlocking wakes the thread so it can restart
+ * its debounce.  Saves run with the lock held.
+ */
+typedef struct {
+    cfgpack_autosave_t *as; /**< Autosave being ticked */
+    pthread_t thread;       /**< Worker thread */
+    pthread_mutex_t lock;   /**< Guards the context and @c as */
+    pthread_cond_t wake;    /**< Signalled on unlock and stop */
+    int running;            /**< Cleared by cfgpack_autosave_stop() */
+    cfgpack_err_t err;      /**< Result of the latest failed save */
+} cfgpack_autosave_thread_t;
+
+/**
+ * @brief Start ticking @p as on a background thread.
+ * @param t  Thread state to initialize.
+ * @param as Initialized autosave.
+ * @return CFGPACK_OK, CFGPACK_ERR_ARGS on NULL arguments, or
+ *         CFGPACK_ERR_IO if the thread could not be started.
+ */
+cfgpack_err_t cfgpack_autosave_start(cfgpack_autosave_thread_t *t,
+                                     cfgpack_autosave_t *as);
+
+/** @brief Take the lock that guards the context against the thread. */
+void cfgpack_autosave_lock(cfgpack_autosave_thread_t *t);
+
+/** @brief Release the lock and wake the thread to look at new sets. */
+void cfgpack_autosave_unlock(cfgpack_autosave_thread_t *t);
+
+/**
+ * @brief Stop and join the thread, then flush what is still dirty.
+ * @param t Thread state from cfgpack_autosave_start().
+ * @return Result of the final cfgpack_autosave_flush().
+ */
+cfgpack_err_t cfgpack_autosave_stop(cfgpack_autosave_thread_t *t);
+#endif /* CFGPACK_HOSTED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGPACK_AUTOSAVE_H */
@@ -0,0 +1,142 @@
+#ifndef CFGPACK_BULK_H
+#define CFGPACK_BULK_H
+
+/**
+ * @file bulk.h
+ * @brief Optional parallel pagein/pageout of many contexts (hosted only).
+ *
+ * For backends that validate and re-encode configs for a whole fleet:
+ * cfgpack_bulk_run() takes an array of jobs, each a context with an input
+ * blob to page in and an output buffer to page out into, and spreads them
+ * over a pool of POSIX threads.  Each job gets its own error code.
+ *
+ * The core functions hold no global state, so the pool needs no locks
+ * around them.  Each worker owns a contiguous run of jobs and, once it is
+ * done, steals half of the remaining run of another worker, so a few slow
+ * jobs do not leave the other cores idle.  Compressed inputs decompress
+ * into a per-worker slice of caller-provided scratch; heatshrink uses a
+ * decoder on each worker's stack instead of the static one.
+ *
+ * cfgpack_bulk_verify_sections() splits one large sectioned blob the same
+ * way, for configs big enough that the CRC pass is worth sharing.
+ *
+ * To use these functions, compile src/bulk.c with hosted flags and link
+ * with -pthread.  This header is not pulled in by cfgpack.h.
+ */
+
+#include "api.h"
+#include "error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Upper bound on cfgpack_bulk_opts_t::threads. */
+#ifndef CFGPACK_BULK_MAX_THREADS
+  #define CFGPACK_BULK_MAX_THREADS 64
+#endif
+
+/** Encoding of cfgpack_bulk_job_t::in. */
+typedef enum {
+    CFGPACK_BULK_RAW = 0,   /**< cfgpack_pagein_buf() */
+    CFGPACK_BULK_LZ4,       /**< cfgpack_pagein_lz4(), needs CFGPACK_LZ4 */
+    CFGPACK_BULK_HEATSHRINK /**< cfgpack_pagein_heatshrink_r() */
+} cfgpack_bulk_codec_t;
+
+/**
+ * @brief One unit of work: page @c in into @c ctx, then page it out.
+ *
+ * Either half may be skipped by leaving its buffer NULL.  A failed pagein
+ * skips the pageout.  Each context must appear in at most one job of a
+ * batch.  Contexts may share one schema (see cfgpack_init_shared()).
+ */
+typedef struct {
+    cfgpack_ctx_t *ctx;  /**< Initialized context of this job */
+    const uint8_t *in;   /**< Blob to page in, or NULL */
+    size_t in_len;       /**< Bytes at @c in */
+    size_t raw_len;      /**< LZ4 only: decompressed size of @c in */
+    uint8_t *out;        /**< Pageout buffer, or NULL */
+    size_t out_cap;      /**< Capacity of @c out */
+    size_t out_len;      /**< Output: bytes written to @c out */
+    cfgpack_err_t err;   /**< Output: result of this job */
+} cfgpack_bulk_job_t;
+
+/** Batch settings for cfgpack_bulk_run(). */
+typedef struct {
+    unsigned threads;           /**< Workers, 0 for the online CPU count */
+    cfgpack_bulk_codec_t codec; /**< Encoding of every job's input */
+    uint8_t *scratch;           /**< workers * scratch_cap bytes, or NULL */
+    size_t scratch_cap;         /**< Decompression scratch per worker */
+} cfgpack_bulk_opts_t;
+
+/**
+ * @brief Run a batch of pagein/pageout jobs across a thread pool.
+ *
+ * The calling thread is one of the workers, so @c threads = 1 runs the
+ * batch in order without creating any thread.  The pool never has more
+ * workers than jobs or than CFGPACK_BULK_MAX_THREADS.  Compressed codecs
+ * need @c scratch of at least (workers * @c scratch_cap) bytes, where
+ * workers is cfgpack_bulk_workers(); RAW needs none.  If a thread cannot
+ * be started, the workers already running take over its jobs.
+ *
+ * Every job's @c err is set, and @c out_len is set for every job whose
+ * pageout succeeded.
+ *
+ * @param jobs   Jobs to run.
+ * @param count  Number of jobs.
+ * @param opts   Batch settings.
+ * @param failed Optional output: number of jobs whose @c err is not OK.
+ * @return CFGPACK_OK if every job succeeded;
+ *         CFGPACK_ERR_ARGS if an argument is NULL, the codec is not
+ *         compiled in, or a compressed codec has no scratch;
+ *         otherwise the error of the first failed job.
+ */
+cfgpack_err_t cfgpack_bulk_run(cfgpack_bulk_job_t *jobs,
+                               size_t count,
+                               const cfgpack_bulk_opts_t *opts,
+                               size_t *failed);
+
+/**
+ * @brief Number of workers cfgpack_bulk_run() would use.
+ *
+ * Resolves @p threads = 0 to the online CPU count and applies the
+ * CFGPACK_BULK_MAX_THREADS and @p count limits, for sizing scratch.
+ *
+ * @param threads Requested workers, 0 for the online CPU count.
+ * @param count   Number of jobs.
+ * @return Worker count, at least 1.
+ */
+unsigned cfgpack_bulk_workers(unsigned threads, size_t count);
+
+/**
+ * @brief cfgpack_sections_verify() with the sections spread over threads.
+ *
+ * Each worker checks a contiguous run of sections, starting at a multiple
+ * of 8 so no two write the same byte of @p bad, and returns the CRC-32C
+ * of its run.  The caller folds those with the prelude and the table into
+ * the trailer check, so no byte is read twice.  Results are identical to
+ * cfgpack_sections_verify().
+ *
+ * @param blob      Blob from cfgpack_pageout_sectioned().
+ * @param len       Length of @p blob in bytes.
+ * @param threads   Workers, 0 for the online CPU count.
+ * @param bad       Optional bitmap: bit i set for each bad section i.
+ * @param bad_len   Size of @p bad in bytes.
+ * @param bad_count Optional output: number of bad sections.
+ * @return As cfgpack_sections_verify().
+ */
+cfgpack_err_t cfgpack_bulk_verify_sections(const uint8_t *blob,
+                                           size_t len,
+                                           unsigned threads,
+                                           uint8_t *bad,
+                                           size_t bad_len,
+                                           size_t *bad_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGPACK_BULK_H */
@@ -0,0 +1,158 @@
+#ifndef CFGPACK_BUNDLE_H
+#define CFGPACK_BUNDLE_H
+
+/**
+ * @file bundle.h
+ * @brief Several contexts (namespaces) in one container blob.
+ *
+ * A bundle stores one ordinary cfgpack blob per context, each tagged with
+ * its schema name and layout fingerprint, so a device with separate radio,
+ * sensor and application contexts keeps one file instead of three:
+ *
+ *   offset 0   magic     "CPNS" (u32 LE)
+ *   offset 4   count     number of sections (u16 LE)
+ *   offset 6   dir_len   directory bytes after this header (u16 LE)
+ *   offset 8   dir_crc   CRC-32C of bytes 0..7 and the directory (u32 LE)
+ *   offset 12  directory, one record per section:
+ *                fingerprint  u64 LE (cfgpack_schema_fingerprint())
+ *                offset       u32 LE, from the start of the bundle
+ *                len          u32 LE, blob length including its CRC
+ *                name_len     u8, then the schema name (no NUL)
+ *   then the section blobs, in directory order.
+ *
+ * Each blob keeps its own CRC-32C trailer, so a section is verified when
+ * it is paged in and an untouched section can be carried over into the
+ * next bundle byte for byte.  cfgpack_bundle_pageout() does this in place:
+ * a context with no dirty bits whose section is in the previous bundle is
+ * moved, not re-encoded.
+ *
+ * The LittleFS variants (cfgpack_pageout_lfs_bundle() and
+ * cfgpack_pagein_lfs_bundle()) live in io_littlefs.h.
+ */
+
+#include "api.h"
+#include "error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Size of the bundle header in bytes. */
+#define CFGPACK_BUNDLE_HDR_SIZE 12
+
+/** @brief Bundle magic, "CPNS" read as a little-endian u32. */
+#define CFGPACK_BUNDLE_MAGIC 0x534e5043u
+
+/** @brief Directory record bytes for a schema name of @p name_len bytes. */
+#define CFGPACK_BUNDLE_REC_SIZE(name_len) (17u + (name_len))
+
+/**
+ * @brief One section of a bundle, as found by cfgpack_bundle_find().
+ */
+typedef struct {
+    uint64_t fingerprint; /**< Layout fingerprint of the writer's schema. */
+    const uint8_t *blob;  /**< Section blob inside the bundle. */
+    size_t len;           /**< Blob length, including its CRC. */
+} cfgpack_bundle_sec_t;
+
+/**
+ * @brief Find the section named @p name.
+ *
+ * Checks the header and the directory CRC; section blobs are not read.
+ *
+ * @param buf  Bundle.
+ * @param len  Length of @p buf.
+ * @param name Schema name to look for.
+ * @param out  Receives the section.
+ * @return CFGPACK_OK if found; CFGPACK_ERR_MISSING if the bundle has no
+ *         such section; CFGPACK_ERR_DECODE if @p buf is not a valid
+ *         bundle; CFGPACK_ERR_ARGS on NULL arguments.
+ */
+cfgpack_err_t cfgpack_bundle_find(const uint8_t *buf,
+                                  size_t len,
+                                  const char *name,
+                                  cfgpack_bundle_sec_t *out);
+
+/**
+ * @brief Write @p n contexts as one bundle, reusing unchanged sections.
+ *
+ * On entry @p buf holds the previous bundle, @p *len bytes of it (0 when
+ * there is none).  Sections of contexts without dirty bits are kept from
+ * it when their name and fingerprint match, and moved to their new
+ * offset if an earlier section changed size.  The other contexts are
+ * encoded with cfgpack_pageout(), which clears their dirty bits.  Section
+ * order follows @p ctxs.  An invalid previous bundle is ignored.
+ *
+ * "No dirty bits" stands for "same as its section", which holds for a
+ * context paged in from this bundle or saved into it and not set since.
+ * A context that was only initialized has no dirty bits either; load it
+ * with cfgpack_bundle_pagein_all() first, or mark it with
+ * cfgpack_dirty_set(), so its old section is not kept.
+ *
+ * Every size is computed before anything is written, so a bundle that
+ * does not fit leaves @p buf untouched.
+ *
+ * @param ctxs Contexts, at most CFGPACK_BUNDLE_MAX, with distinct names.
+ * @param n    Number of contexts.
+ * @param buf  Previous bundle in, new bundle out.
+ * @param cap  Capacity of @p buf.
+ * @param len  Previous length in; new length out (also on
+ *             CFGPACK_ERR_ENCODE, where it is the size needed).
+ * @param kept Optional; receives the number of sections carried over.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments, more
+ *         than CFGPACK_BUNDLE_MAX contexts or a duplicate name;
+ *         CFGPACK_ERR_ENCODE if the bundle does not fit @p cap; errors
+ *         from cfgpack_pageout() and cfgpack_pageout_measure().
+ */
+cfgpack_err_t cfgpack_bundle_pageout(cfgpack_ctx_t *const *ctxs,
+                                     size_t n,
+                                     uint8_t *buf,
+                                     size_t cap,
+                                     size_t *len,
+                                     size_t *kept);
+
+/**
+ * @brief Load the section of @p ctx (matched by schema name).
+ *
+ * The section goes through cfgpack_pagein_buf(), so schema name and CRC
+ * checks apply and @p ctx is untouched on failure.  A fingerprint that
+ * differs from the context's schema is not an error; see
+ * cfgpack_bundle_find() to tell.
+ *
+ * @param ctx Initialized context.
+ * @param buf Bundle.
+ * @param len Length of @p buf.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_MISSING if the bundle has no
+ *         section for @p ctx; errors from cfgpack_bundle_find() and
+ *         cfgpack_pagein_buf().
+ */
+cfgpack_err_t cfgpack_bundle_pagein(cfgpack_ctx_t *ctx,
+                                    const uint8_t *buf,
+                                    size_t len);
+
+/**
+ * @brief Load every context of @p ctxs that has a section.
+ *
+ * Contexts without a section are left as they are.
+ *
+ * @param ctxs Contexts.
+ * @param n    Number of contexts.
+ * @param buf  Bundle.
+ * @param len  Length of @p buf.
+ * @return CFGPACK_OK if every context was loaded; CFGPACK_ERR_MISSING if
+ *         some had no section (the others are loaded); otherwise the first
+ *         other error, which stops the walk.
+ */
+cfgpack_err_t cfgpack_bundle_pagein_all(cfgpack_ctx_t *const *ctxs,
+                                        size_t n,
+                                        const uint8_t *buf,
+                                        size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGPACK_BUNDLE_H */
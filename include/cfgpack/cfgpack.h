@@ -11,16 +11,25 @@
  * - Value types and containers (value.h)
  * - Schema parsing and serialization (schema.h)
  * - Runtime context and value access (api.h)
+ * - A/B slot pageout for raw flash (slots.h)
+ * - Raw context snapshots for warm boots (snapshot.h)
+ * - Several contexts in one bundle blob (bundle.h)
+ * - Single-arena memory planning (plan.h)
  *
  * For file-based convenience wrappers, also include io_file.h.
  * For LittleFS storage wrappers, also include io_littlefs.h.
  * For decompression support (LZ4/heatshrink), also include decompress.h.
+ * For write-behind autosave, also include autosave.h.
  */
 #include "api.h"
+#include "bundle.h"
 #include "config.h"
 #include "decompress.h"
 #include "error.h"
+#include "plan.h"
 #include "schema.h"
+#include "slots.h"
+#include "snapshot.h"
 #include "value.h"
 
 #endif /* CFGPACK_CFGPACK_H */
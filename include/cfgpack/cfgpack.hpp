@@ -0,0 +1,430 @@
+#ifndef CFGPACK_CFGPACK_HPP
+#define CFGPACK_CFGPACK_HPP
+
+/**
+ * @file cfgpack.hpp
+ * @brief Optional C++17 layer: compile-time indices and typed accessors.
+ *
+ * Header-only and built on the C API, which it does not change.  A schema
+ * is described once as a constexpr field list in ascending index order:
+ *
+ * @code
+ *   struct demo {
+ *       static constexpr cfgpack::Field fields[] = {
+ *           {1, CFGPACK_TYPE_U16},
+ *           {2, CFGPACK_TYPE_STR, 32},
+ *           {3, CFGPACK_TYPE_F32},
+ *       };
+ *   };
+ *
+ *   static cfgpack::Storage<demo> st;       // sized from the description
+ *   cfgpack_parse_error_t err;
+ *   cfgpack_parse_opts_t opts = st.parse_opts(&err);
+ *   cfgpack_parse_schema(map, len, &opts);
+ *
+ *   cfgpack::Config<demo> cfg;
+ *   cfg.init(st);                           // checks the parsed layout
+ *   cfg.set<1>(uint16_t{250});
+ *   if (auto host = cfg.get<2>()) {         // std::string_view
+ *       use(host.value);
+ *   }
+ * @endcode
+ *
+ * get<Idx>() and set<Idx>() turn the index into a schema position at
+ * compile time and call cfgpack_get_at(), cfgpack_set_at(),
+ * cfgpack_get_str_view_at() or cfgpack_set_str_at(), so there is no entry
+ * lookup and no runtime type switch.  An index that is not in the
+ * description, or a value of the wrong type, fails the build.  The
+ * description is checked against the context's schema once, when a
+ * Config is initialized or attached.
+ *
+ * A schema written as a schema_def.h list can fill the field list with
+ * the same macro: `fields[] = {DEMO_SCHEMA(CFGPACK_FIELD_V, CFGPACK_FIELD_N,
+ * CFGPACK_FIELD_S)}`.
+ *
+ * Nothing throws and nothing allocates; errors are cfgpack_err_t codes as
+ * in the C API.
+ */
+
+#include "cfgpack.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+/** @name schema_def.h rows as cfgpack::Field initializers
+ * @{
+ */
+#define CFGPACK_FIELD_V(i, n, T, v)    {(i), CFGPACK_TYPE_##T, 0},
+#define CFGPACK_FIELD_N(i, n, T, m)    {(i), CFGPACK_TYPE_##T, (m)},
+#define CFGPACK_FIELD_S(i, n, T, m, s) {(i), CFGPACK_TYPE_##T, (m)},
+/** @} */
+
+namespace cfgpack {
+
+/**
+ * @brief One entry of a compile-time schema description.
+ */
+struct Field {
+    uint16_t index;      /**< Wire index. */
+    cfgpack_type_t type; /**< Entry type. */
+    uint8_t str_max = 0; /**< As cfgpack_entry_t::str_max. */
+};
+
+/**
+ * @brief Value of a get<Idx>(), with the status of the read.
+ *
+ * @c value is value-initialized unless @c err is CFGPACK_OK.
+ */
+template <typename T> struct Result {
+    cfgpack_err_t err;
+    T value;
+
+    constexpr bool ok() const noexcept {
+        return (err == CFGPACK_OK);
+    }
+    constexpr explicit operator bool() const noexcept {
+        return (ok());
+    }
+};
+
+namespace detail {
+
+using str_t = std::string_view;
+
+/* clang-format off */
+template <cfgpack_type_t T> struct value_of;
+template <> struct value_of<CFGPACK_TYPE_U8>   { using type = uint8_t; };
+template <> struct value_of<CFGPACK_TYPE_U16>  { using type = uint16_t; };
+template <> struct value_of<CFGPACK_TYPE_U32>  { using type = uint32_t; };
+template <> struct value_of<CFGPACK_TYPE_U64>  { using type = uint64_t; };
+template <> struct value_of<CFGPACK_TYPE_I8>   { using type = int8_t; };
+template <> struct value_of<CFGPACK_TYPE_I16>  { using type = int16_t; };
+template <> struct value_of<CFGPACK_TYPE_I32>  { using type = int32_t; };
+template <> struct value_of<CFGPACK_TYPE_I64>  { using type = int64_t; };
+template <> struct value_of<CFGPACK_TYPE_F32>  { using type = float; };
+template <> struct value_of<CFGPACK_TYPE_F64>  { using type = double; };
+template <> struct value_of<CFGPACK_TYPE_STR>  { using type = str_t; };
+template <> struct value_of<CFGPACK_TYPE_FSTR> { using type = str_t; };
+/* clang-format on */
+
+constexpr size_t npos = static_cast<size_t>(-1);
+
+constexpr bool is_string(cfgpack_type_t t) {
+    return (t == CFGPACK_TYPE_STR || t == CFGPACK_TYPE_FSTR);
+}
+
+/** As cfgpack_entry_str_max(). */
+constexpr size_t str_max(const Field &f) {
+    if (f.type == CFGPACK_TYPE_STR) {
+        return (f.str_max ? f.str_max : CFGPACK_STR_MAX);
+    }
+    if (f.type == CFGPACK_TYPE_FSTR) {
+        return (f.str_max ? f.str_max : CFGPACK_FSTR_MAX);
+    }
+    return (0);
+}
+
+template <typename Schema> constexpr size_t count() {
+    return (sizeof(Schema::fields) / sizeof(Schema::fields[0]));
+}
+
+template <typename Schema> constexpr size_t pos_of(uint16_t index) {
+    for (size_t i = 0; i < count<Schema>(); ++i) {
+        if (Schema::fields[i].index == index) {
+            return (i);
+        }
+    }
+    return (npos);
+}
+
+/** Type of @p index; U8 for an unknown one, which a static_assert rejects. */
+template <typename Schema> constexpr cfgpack_type_t type_of(uint16_t index) {
+    size_t pos = pos_of<Schema>(index);
+
+    return (pos == npos ? CFGPACK_TYPE_U8 : Schema::fields[pos].type);
+}
+
+/** Indices non-zero and strictly ascending, as the C schema requires. */
+template <typename Schema> constexpr bool well_formed() {
+    for (size_t i = 0; i < count<Schema>(); ++i) {
+        const Field &f = Schema::fields[i];
+
+        if (f.index == 0 ||
+            (i > 0 && Schema::fields[i - 1].index >= f.index)) {
+            return (false);
+        }
+        if (!is_string(f.type) && f.str_max != 0) {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+template <typename Schema> constexpr size_t str_count() {
+    size_t n = 0;
+
+    for (size_t i = 0; i < count<Schema>(); ++i) {
+        n += is_string(Schema::fields[i].type) ? 1 : 0;
+    }
+    return (n);
+}
+
+/** Pool bytes cfgpack_init() lays out: str_max + 1 per string entry. */
+template <typename Schema> constexpr size_t pool_size() {
+    size_t n = 0;
+
+    for (size_t i = 0; i < count<Schema>(); ++i) {
+        if (is_string(Schema::fields[i].type)) {
+            n += str_max(Schema::fields[i]) + 1;
+        }
+    }
+    return (n);
+}
+
+constexpr size_t at_least_one(size_t n) {
+    return (n ? n : 1);
+}
+
+} // namespace detail
+
+/**
+ * @brief Caller buffers for one context of @p Schema, sized at compile time.
+ *
+ * Not copyable: a context points into its own buffers.  Declare it
+ * static (or otherwise give it the lifetime of the context) and hand it
+ * to Config::init().
+ */
+template <typename Schema> struct Storage {
+    static constexpr size_t entry_count = detail::count<Schema>();
+    static constexpr size_t str_count = detail::str_count<Schema>();
+    static constexpr size_t str_pool_size = detail::pool_size<Schema>();
+
+    cfgpack_ctx_t ctx{};
+    cfgpack_schema_t schema{};
+    cfgpack_entry_t entries[entry_count]{};
+    cfgpack_value_t values[entry_count]{};
+    char str_pool[detail::at_least_one(str_pool_size)]{};
+    cfgpack_str_off_t str_offsets[detail::at_least_one(str_count)]{};
+
+    Storage() = default;
+    Storage(const Storage &) = delete;
+    Storage &operator=(const Storage &) = delete;
+
+    /** Parse options that write the schema into these buffers. */
+    cfgpack_parse_opts_t parse_opts(cfgpack_parse_error_t *err) noexcept {
+        return {&schema,          entries,     entry_count, values,
+                str_pool,         sizeof(str_pool), str_offsets,
+                str_count,        err};
+    }
+};
+
+/**
+ * @brief Move-only handle on a context laid out as @p Schema.
+ *
+ * The handle owns the context it was given: it cannot be copied, moving it
+ * leaves the source empty, and destroying it calls cfgpack_free().  The
+ * buffers themselves stay the caller's.  Every accessor of an empty handle
+ * returns CFGPACK_ERR_ARGS.
+ */
+template <typename Schema> class Config {
+    static_assert(detail::well_formed<Schema>(),
+                  "cfgpack: fields must have non-zero, ascending indices");
+
+  public:
+    /** Schema position of index @p Idx. */
+    template <uint16_t Idx>
+    static constexpr size_t pos = detail::pos_of<Schema>(Idx);
+
+    /** Value type of index @p Idx; std::string_view for strings. */
+    template <uint16_t Idx>
+    using value_type =
+        typename detail::value_of<detail::type_of<Schema>(Idx)>::type;
+
+    Config() noexcept = default;
+    Config(const Config &) = delete;
+    Config &operator=(const Config &) = delete;
+
+    Config(Config &&other) noexcept : ctx_(other.ctx_) {
+        other.ctx_ = nullptr;
+    }
+
+    Config &operator=(Config &&other) noexcept {
+        if (this != &other) {
+            reset();
+            ctx_ = other.ctx_;
+            other.ctx_ = nullptr;
+        }
+        return (*this);
+    }
+
+    ~Config() {
+        reset();
+    }
+
+    /**
+     * @brief cfgpack_init() over @p st, whose schema and values were
+     *        filled by a parse (see Storage::parse_opts()), then attach().
+     */
+    cfgpack_err_t init(Storage<Schema> &st) noexcept {
+        cfgpack_err_t rc = cfgpack_init(
+            &st.ctx, &st.schema, st.values, st.entry_count, st.str_pool,
+            sizeof(st.str_pool), st.str_offsets, st.str_count);
+
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        return (attach(&st.ctx));
+    }
+
+    /**
+     * @brief Take over an initialized context.
+     *
+     * For contexts set up any other way (cfgpack_init_cow(), a generated
+     * <p>_init(), ...).  On failure the handle is left empty.
+     *
+     * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS if @p ctx is NULL;
+     *         CFGPACK_ERR_TYPE_MISMATCH if its schema does not have exactly
+     *         the described entries, indices, types and string limits.
+     */
+    cfgpack_err_t attach(cfgpack_ctx_t *ctx) noexcept {
+        reset();
+        if (!ctx || !ctx->schema) {
+            return (CFGPACK_ERR_ARGS);
+        }
+        if (ctx->schema->entry_count != detail::count<Schema>()) {
+            return (CFGPACK_ERR_TYPE_MISMATCH);
+        }
+        for (size_t i = 0; i < detail::count<Schema>(); ++i) {
+            const cfgpack_entry_t *e = &ctx->schema->entries[i];
+            const Field &f = Schema::fields[i];
+
+            if (e->index != f.index || e->type != f.type ||
+                cfgpack_entry_str_max(e) != detail::str_max(f)) {
+                return (CFGPACK_ERR_TYPE_MISMATCH);
+            }
+        }
+        ctx_ = ctx;
+        return (CFGPACK_OK);
+    }
+
+    /** Release the context; the handle becomes empty. */
+    void reset() noexcept {
+        if (ctx_) {
+            cfgpack_free(ctx_);
+            ctx_ = nullptr;
+        }
+    }
+
+    /** The context, for the rest of the C API; NULL if empty. */
+    cfgpack_ctx_t *ctx() const noexcept {
+        return (ctx_);
+    }
+
+    explicit operator bool() const noexcept {
+        return (ctx_ != nullptr);
+    }
+
+    /** @return 1 if index @p Idx holds a value. */
+    template <uint16_t Idx> int has() const noexcept {
+        static_assert(pos<Idx> != detail::npos,
+                      "cfgpack: index not in schema");
+        return (ctx_ ? cfgpack_presence_get(ctx_, pos<Idx>) : 0);
+    }
+
+    /**
+     * @brief Read index @p Idx.
+     * @return err as cfgpack_get_at() or cfgpack_get_str_view_at(); a string
+     *         view stays valid until the entry is next written.
+     */
+    template <uint16_t Idx> Result<value_type<Idx>> get() const noexcept {
+        static_assert(pos<Idx> != detail::npos,
+                      "cfgpack: index not in schema");
+        constexpr cfgpack_type_t type = detail::type_of<Schema>(Idx);
+
+        if (!ctx_) {
+            return {CFGPACK_ERR_ARGS, {}};
+        }
+        if constexpr (detail::is_string(type)) {
+            const char *s;
+            size_t len;
+            cfgpack_err_t rc = cfgpack_get_str_view_at(ctx_, pos<Idx>, &s,
+                                                       &len);
+
+            if (rc != CFGPACK_OK) {
+                return {rc, {}};
+            }
+            return {CFGPACK_OK, std::string_view(s, len)};
+        } else {
+            cfgpack_value_t v;
+            cfgpack_err_t rc = cfgpack_get_at(ctx_, pos<Idx>, &v);
+
+            if (rc != CFGPACK_OK) {
+                return {rc, {}};
+            }
+            return {CFGPACK_OK, load<value_type<Idx>>(v)};
+        }
+    }
+
+    /**
+     * @brief Write index @p Idx.
+     *
+     * The parameter is exactly the entry's type, so a string for a number
+     * or a number for a string does not compile.
+     *
+     * @return As cfgpack_set_at() or cfgpack_set_str_at().
+     */
+    template <uint16_t Idx>
+    cfgpack_err_t set(value_type<Idx> val) noexcept {
+        static_assert(pos<Idx> != detail::npos,
+                      "cfgpack: index not in schema");
+        constexpr cfgpack_type_t type = detail::type_of<Schema>(Idx);
+
+        if (!ctx_) {
+            return (CFGPACK_ERR_ARGS);
+        }
+        if constexpr (detail::is_string(type)) {
+            return (cfgpack_set_str_at(ctx_, pos<Idx>,
+                                       val.data() ? val.data() : "",
+                                       val.size()));
+        } else {
+            cfgpack_value_t v = {type, {0}};
+
+            store(v, val);
+            return (cfgpack_set_at(ctx_, pos<Idx>, &v));
+        }
+    }
+
+  private:
+    template <typename T> static T load(const cfgpack_value_t &v) noexcept {
+        if constexpr (std::is_same_v<T, float>) {
+            return (v.v.f32);
+        } else if constexpr (std::is_same_v<T, double>) {
+            return (v.v.f64);
+        } else if constexpr (std::is_signed_v<T>) {
+            return (static_cast<T>(v.v.i64));
+        } else {
+            return (static_cast<T>(v.v.u64));
+        }
+    }
+
+    template <typename T>
+    static void store(cfgpack_value_t &v, T val) noexcept {
+        if constexpr (std::is_same_v<T, float>) {
+            v.v.f32 = val;
+        } else if constexpr (std::is_same_v<T, double>) {
+            v.v.f64 = val;
+        } else if constexpr (std::is_signed_v<T>) {
+            v.v.i64 = val;
+        } else {
+            v.v.u64 = val;
+        }
+    }
+
+    cfgpack_ctx_t *ctx_ = nullptr;
+};
+
+} // namespace cfgpack
+
+#endif /* CFGPACK_CFGPACK_HPP */
@@ -0,0 +1,146 @@
+#ifndef CFGPACK_COMPRESS_H
+#define CFGPACK_COMPRESS_H
+
+/**
+ * @file compress.h
+ * @brief Optional on-device compression for cfgpack.
+ *
+ * Provides LZ4 and heatshrink pageout wrappers that serialize the context
+ * into a caller-provided scratch buffer with cfgpack_pageout(), then
+ * compress it into the output buffer.  The output uses the same framing as
+ * `cfgpack-compress`, so it loads with cfgpack_pagein_lz4() or
+ * cfgpack_pagein_heatshrink().
+ *
+ * Enable with compile flags:
+ * - CFGPACK_LZ4: Enable LZ4 compression
+ * - CFGPACK_HEATSHRINK: Enable heatshrink compression
+ *
+ * Encoder state is caller-owned, so both paths are reentrant as long as
+ * each concurrent caller passes its own state.  This header includes the
+ * third-party encoder headers and is not pulled in by cfgpack.h.
+ *
+ * The LZ4 wrappers are in the core library.  cfgpack_pageout_heatshrink()
+ * is not: link src/compress_heatshrink.c and
+ * third_party/heatshrink/heatshrink_encoder.c to use it.
+ */
+
+#include "api.h"
+#include "error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CFGPACK_LZ4
+  #include "lz4.h"
+
+/** Bytes of the original-size header written by cfgpack_pageout_lz4(). */
+#define CFGPACK_LZ4_HDR_SIZE 4
+
+/** Output capacity that always fits an LZ4 pageout of @p n blob bytes. */
+#define CFGPACK_LZ4_PAGEOUT_BOUND(n) \
+    (CFGPACK_LZ4_HDR_SIZE + LZ4_COMPRESSBOUND(n))
+
+/**
+ * @brief Serialize the context and compress it with LZ4.
+ *
+ * Writes a 4-byte little-endian decompressed size followed by one raw LZ4
+ * block, the `cfgpack-compress lz4` format.  Load it with
+ * cfgpack_pagein_lz4() after reading the size from the header.
+ *
+ * @param ctx         Initialized cfgpack context.
+ * @param out         Output buffer for the framed LZ4 data.
+ * @param out_cap     Capacity of @p out in bytes.
+ * @param out_len     Receives the number of bytes written to @p out.
+ * @param state       Caller-provided LZ4 compression state (about 16 KB,
+ *                    need not be initialized).
+ * @param scratch     Caller-provided buffer for the uncompressed blob;
+ *                    must not overlap @p out.
+ * @param scratch_cap Capacity of @p scratch in bytes.
+ * @return CFGPACK_OK on success;
+ *         CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_ENCODE if the compressed data does not fit @p out;
+ *         Other errors from cfgpack_pageout() (ERR_ENCODE if the blob does
+ *         not fit @p scratch).
+ */
+cfgpack_err_t cfgpack_pageout_lz4(cfgpack_ctx_t *ctx,
+                                  uint8_t *out,
+                                  size_t out_cap,
+                                  size_t *out_len,
+                                  LZ4_stream_t *state,
+                                  uint8_t *scratch,
+                                  size_t scratch_cap);
+
+/**
+ * @brief cfgpack_pageout_lz4() primed with a dictionary.
+ *
+ * Compresses against @p dict, usually the schema dictionary from
+ * cfgpack_lz4_dict(), so keys, the map name and unchanged defaults encode
+ * as back-references even in a tiny blob.  The framing is unchanged; load
+ * the result with cfgpack_pagein_lz4_dict() and the same dictionary.
+ *
+ * @param ctx         Initialized cfgpack context.
+ * @param out         Output buffer for the framed LZ4 data.
+ * @param out_cap     Capacity of @p out in bytes.
+ * @param out_len     Receives the number of bytes written to @p out.
+ * @param state       Caller-provided LZ4 compression state.
+ * @param dict        Dictionary; must not overlap @p scratch.
+ * @param dict_len    Length of @p dict (LZ4 uses the last 64 KB).
+ * @param scratch     Caller-provided buffer for the uncompressed blob.
+ * @param scratch_cap Capacity of @p scratch in bytes.
+ * @return As cfgpack_pageout_lz4(); CFGPACK_ERR_ARGS also for a NULL
+ *         @p dict with a non-zero @p dict_len.
+ */
+cfgpack_err_t cfgpack_pageout_lz4_dict(cfgpack_ctx_t *ctx,
+                                       uint8_t *out,
+                                       size_t out_cap,
+                                       size_t *out_len,
+                                       LZ4_stream_t *state,
+                                       const uint8_t *dict,
+                                       size_t dict_len,
+                                       uint8_t *scratch,
+                                       size_t scratch_cap);
+#endif /* CFGPACK_LZ4 */
+
+#ifdef CFGPACK_HEATSHRINK
+  #include "heatshrink_encoder.h"
+
+/**
+ * @brief Serialize the context and compress it with heatshrink.
+ *
+ * Writes raw heatshrink data with no header, the `cfgpack-compress
+ * heatshrink` format, using the static window (8 bits) and lookahead
+ * (4 bits) that cfgpack_pagein_heatshrink() expects.
+ *
+ * @param ctx         Initialized cfgpack context.
+ * @param out         Output buffer for the compressed data.
+ * @param out_cap     Capacity of @p out in bytes.
+ * @param out_len     Receives the number of bytes written to @p out.
+ * @param hse         Caller-provided encoder (reset by this call).
+ * @param scratch     Caller-provided buffer for the uncompressed blob;
+ *                    must not overlap @p out.
+ * @param scratch_cap Capacity of @p scratch in bytes.
+ * @return CFGPACK_OK on success;
+ *         CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_ENCODE if the compressed data does not fit @p out
+ *         or on an encoder failure;
+ *         Other errors from cfgpack_pageout() (ERR_ENCODE if the blob does
+ *         not fit @p scratch).
+ */
+cfgpack_err_t cfgpack_pageout_heatshrink(cfgpack_ctx_t *ctx,
+                                         uint8_t *out,
+                                         size_t out_cap,
+                                         size_t *out_len,
+                                         heatshrink_encoder *hse,
+                                         uint8_t *scratch,
+                                         size_t scratch_cap);
+#endif /* CFGPACK_HEATSHRINK */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGPACK_COMPRESS_H */
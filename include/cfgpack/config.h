@@ -17,6 +17,7 @@
 #define CFGPACK_CONFIG_H
 
 #include <limits.h> /* CHAR_BIT */
+#include <stdint.h>
 
 #ifndef CFGPACK_HOSTED
   #define CFGPACK_EMBEDDED 1
@@ -29,14 +30,153 @@
   #define CFGPACK_PRINTF(...) ((void)0)
 #endif
 
+/**
+ * @brief Large-schema build (define CFGPACK_LARGE_SCHEMA to enable).
+ *
+ * The default build keeps the presence and dirty bitmaps inline in
+ * cfgpack_ctx_t, numbers string slots with a uint8_t and addresses the
+ * string pool with uint16_t offsets.  With CFGPACK_LARGE_SCHEMA:
+ *   - the bitmaps live in caller storage attached with cfgpack_ctx_bitmaps()
+ *     (CFGPACK_BITMAP_BYTES(entry_count) bytes),
+ *   - string slots are uint16_t and pool offsets uint32_t,
+ *   - CFGPACK_MAX_ENTRIES defaults to 65535.
+ *
+ * The library and everything including cfgpack headers must be built with
+ * the same setting.  Schema images are only valid for the setting they
+ * were written with.
+ */
+
+/**
+ * @brief Seqlock for lock-free readers (define CFGPACK_SEQLOCK to enable).
+ *
+ * Adds a sequence counter to cfgpack_ctx_t.  cfgpack_set*(), transaction
+ * rollback and every pagein make it odd while they write and even again
+ * afterwards, and the cfgpack_get_*_consistent() readers retry a read
+ * that overlapped a write.  Writers must still be serialized among
+ * themselves.  Like CFGPACK_LARGE_SCHEMA it changes the context layout,
+ * so everything including cfgpack headers must use the same setting.
+ */
+#ifdef CFGPACK_SEQLOCK
+  /**
+   * @brief Full memory barrier ordering the counter against the data.
+   *
+   * Defaults to the GCC/Clang builtin; define it before including cfgpack
+   * headers for other compilers, or as a compiler-only barrier on a
+   * single-core target.
+   */
+  #ifndef CFGPACK_SEQLOCK_BARRIER
+    #if defined(__GNUC__) || defined(__clang__)
+      #define CFGPACK_SEQLOCK_BARRIER() __sync_synchronize()
+    #else
+      #error "CFGPACK_SEQLOCK requires CFGPACK_SEQLOCK_BARRIER()"
+    #endif
+  #endif
+
+  /**
+   * @brief Attempts a consistent read makes before returning
+   *        CFGPACK_ERR_BUSY.
+   *
+   * Bounded so that a reader in an ISR that interrupted a writer on the
+   * same core gives up instead of spinning forever.
+   */
+  #ifndef CFGPACK_SEQLOCK_RETRIES
+    #define CFGPACK_SEQLOCK_RETRIES 16
+  #endif
+#endif
+
+/**
+ * @brief Instrumentation counters and hooks (define CFGPACK_STATS to enable).
+ *
+ * Counts lookup probes, pagein decodes, coercions, CRC and string pool
+ * bytes, and file/LittleFS I/O into a global cfgpack_stats_t and into
+ * per-context counters attached with cfgpack_stats_init().  It also calls
+ * a hook set with cfgpack_stats_hook() around each parse, pagein, pageout
+ * and decompression, so the caller can time them.  Without it the
+ * counting sites compile to nothing.  The option adds a pointer to
+ * cfgpack_ctx_t, so like CFGPACK_SEQLOCK everything including cfgpack
+ * headers must use the same setting.
+ */
+
+/**
+ * @brief Packed value arena (define CFGPACK_PACKED_ARENA to enable).
+ *
+ * Adds cfgpack_packed_size() and cfgpack_packed_init(), which move a
+ * context's values out of cfgpack_value_t slots into a caller arena at
+ * their schema width.  Without it every value access is a plain slot
+ * load or store.  The option adds a pointer to cfgpack_ctx_t, so like
+ * CFGPACK_SEQLOCK everything including cfgpack headers must use the
+ * same setting.
+ */
+
+/**
+ * @brief Pageout size cache (define CFGPACK_SIZE_CACHE to enable).
+ *
+ * Adds cfgpack_size_cache_init(), after which every write keeps a running
+ * total of the pageout size, cfgpack_pageout_measure() answers in
+ * constant time and a full pageout known to fit skips its bounds checks.
+ * Without it no write touches the total.  The option changes the layout
+ * of cfgpack_ctx_t like CFGPACK_SEQLOCK.
+ */
+
+/**
+ * @brief Lazy pagein (define CFGPACK_LAZY to enable).
+ *
+ * Adds cfgpack_lazy_init() and cfgpack_lazy_finish(), with which a full
+ * pagein only records where each value starts and decodes it on first
+ * access.  Without it every read skips the pending check.  The option
+ * changes the layout of cfgpack_ctx_t like CFGPACK_SEQLOCK.
+ */
+
+/**
+ * @brief Attached defaults blob (define CFGPACK_DEFAULTS_BLOB to enable).
+ *
+ * Adds cfgpack_defaults_init() and cfgpack_pageout_elide(): pageout leaves
+ * out entries that still hold their default, and full pagein decodes the
+ * omitted defaults from the blob.  Without it pagein only marks them
+ * present.  The option changes the layout of cfgpack_ctx_t like
+ * CFGPACK_SEQLOCK.
+ */
+
+/**
+ * @brief Transactions (define CFGPACK_TXN to enable).
+ *
+ * Adds cfgpack_txn_begin(), cfgpack_txn_commit() and cfgpack_txn_abort(),
+ * which journal every set so it can be rolled back.  Without it no set
+ * checks for an open journal.  The option changes the layout of
+ * cfgpack_ctx_t like CFGPACK_SEQLOCK.
+ */
+
+/**
+ * @brief Change notification (define CFGPACK_NOTIFY to enable).
+ *
+ * Adds cfgpack_notify_init() and cfgpack_notify_changed(), which call
+ * subscriptions once per batch of writes to their index range.  Without
+ * it no write marks a change.  The option changes the layout of
+ * cfgpack_ctx_t like CFGPACK_SEQLOCK.
+ */
+
+/**
+ * @brief Packed wire format (define CFGPACK_PACKED_WIRE to enable).
+ *
+ * Adds cfgpack_pageout_packed() and lets pagein recognize its array
+ * layout.  Without it pagein returns CFGPACK_ERR_DECODE for a packed
+ * blob, though cfgpack_peek_name() still reads its name.  The option
+ * does not change cfgpack_ctx_t.
+ */
+
 /**
  * @brief Maximum number of schema entries supported.
  *
- * This determines the size of the inline presence bitmap in cfgpack_ctx_t.
- * Override by defining CFGPACK_MAX_ENTRIES before including cfgpack headers.
+ * In the default build this determines the size of the inline presence
+ * bitmap in cfgpack_ctx_t.  Override by defining CFGPACK_MAX_ENTRIES before
+ * including cfgpack headers.
  */
 #ifndef CFGPACK_MAX_ENTRIES
-  #define CFGPACK_MAX_ENTRIES 128
+  #ifdef CFGPACK_LARGE_SCHEMA
+    #define CFGPACK_MAX_ENTRIES 65535
+  #else
+    #define CFGPACK_MAX_ENTRIES 128
+  #endif
 #endif
 
 /**
@@ -44,6 +184,87 @@
  */
 #define CFGPACK_PRESENCE_BYTES ((CFGPACK_MAX_ENTRIES + CHAR_BIT - 1) / CHAR_BIT)
 
+/**
+ * @brief Caller bitmap storage for @p n entries (CFGPACK_LARGE_SCHEMA).
+ *
+ * Holds the presence bitmap, the dirty bitmap and a saved copy of the
+ * dirty bitmap used to roll back failed saves.
+ */
+#define CFGPACK_BITMAP_BYTES(n) (3u * (((n) + CHAR_BIT - 1) / CHAR_BIT))
+
+#ifdef CFGPACK_LARGE_SCHEMA
+typedef uint16_t cfgpack_str_slot_t; /**< String pool slot number. */
+typedef uint32_t cfgpack_str_off_t;  /**< Offset into the string pool. */
+  #define CFGPACK_STR_SLOT_NONE UINT16_MAX
+  #define CFGPACK_STR_OFF_MAX UINT32_MAX
+#else
+typedef uint8_t cfgpack_str_slot_t;  /**< String pool slot number. */
+typedef uint16_t cfgpack_str_off_t;  /**< Offset into the string pool. */
+  /** Sentinel: entry is not a string type (no pool slot). */
+  #define CFGPACK_STR_SLOT_NONE UINT8_MAX
+  /** Largest string pool offset (pool size limit). */
+  #define CFGPACK_STR_OFF_MAX UINT16_MAX
+#endif
+
+/**
+ * @brief Largest dense index table accepted by cfgpack_index_table_init().
+ *
+ * Schemas whose highest index is at or above this bound are considered
+ * sparse: the measure/sizing functions report an index_table_size of 0 and
+ * lookups keep using binary search.  Override by defining
+ * CFGPACK_INDEX_TABLE_MAX before including cfgpack headers.
+ */
+#ifndef CFGPACK_INDEX_TABLE_MAX
+  #define CFGPACK_INDEX_TABLE_MAX 256
+#endif
+
+/**
+ * @brief Default region alignment of cfgpack_plan() arenas, in bytes.
+ *
+ * Every region of a planned arena starts on a multiple of this value, so
+ * entries, values and the string pool never share a cache line with their
+ * neighbours.  32 matches the line size of common Cortex-M7/A-class
+ * caches; override by defining CFGPACK_PLAN_ALIGN (a power of two, at
+ * least 8) before including cfgpack headers.
+ */
+#ifndef CFGPACK_PLAN_ALIGN
+  #define CFGPACK_PLAN_ALIGN 32
+#endif
+
+/**
+ * @brief Most contexts cfgpack_bundle_pageout() writes into one bundle.
+ *
+ * Sizes the per-section bookkeeping it keeps on the stack (about 25
+ * bytes per section).  Override by defining CFGPACK_BUNDLE_MAX before
+ * including cfgpack headers.
+ */
+#ifndef CFGPACK_BUNDLE_MAX
+  #define CFGPACK_BUNDLE_MAX 8
+#endif
+
+/**
+ * @brief Most blobs cfgpack_pagein_layers() resolves in one call.
+ *
+ * Sizes the per-layer lengths it keeps on the stack.  At most 254, since
+ * the origin record stores layer numbers in a byte.  Override by defining
+ * CFGPACK_LAYERS_MAX before including cfgpack headers.
+ */
+#ifndef CFGPACK_LAYERS_MAX
+  #define CFGPACK_LAYERS_MAX 4
+#endif
+
+/**
+ * @brief Bytes of CRC-32C check that cost one unit of step budget.
+ *
+ * cfgpack_pagein_step() checks the blob trailer first, @p budget times
+ * this many bytes per call, then decodes @p budget entries per call.  The
+ * default makes one unit of either take roughly as long.  Override by
+ * defining CFGPACK_STEP_CRC_BYTES before including cfgpack headers.
+ */
+#ifndef CFGPACK_STEP_CRC_BYTES
+  #define CFGPACK_STEP_CRC_BYTES 32
+#endif
+
 /**
  * @brief Maximum nesting depth for cfgpack_msgpack_skip_value().
  *
@@ -55,4 +276,70 @@
   #define CFGPACK_SKIP_MAX_DEPTH 32
 #endif
 
+/**
+ * @brief CRC-32C backend identifiers for CFGPACK_CRC_BACKEND.
+ *
+ *   CFGPACK_CRC_NIBBLE - 16-entry nibble table, 64 bytes ROM (default)
+ *   CFGPACK_CRC_SLICE8 - slicing-by-8, 8 KB ROM, ~8x faster in software
+ *   CFGPACK_CRC_HW     - crc32 instruction (x86-64 SSE4.2 or ARMv8 CRC);
+ *                        requires the compiler to target that extension
+ *                        (e.g. -msse4.2, -march=armv8-a+crc)
+ *
+ * All backends produce bit-identical output.
+ */
+#define CFGPACK_CRC_NIBBLE 0
+#define CFGPACK_CRC_SLICE8 1
+#define CFGPACK_CRC_HW     2
+
+/**
+ * @brief Compile-time CRC-32C backend selection.
+ *
+ * Override by defining CFGPACK_CRC_BACKEND before including cfgpack headers.
+ */
+#ifndef CFGPACK_CRC_BACKEND
+  #define CFGPACK_CRC_BACKEND CFGPACK_CRC_NIBBLE
+#endif
+
+/**
+ * @brief Runtime CRC-32C dispatch (hosted targets).
+ *
+ * When CFGPACK_CRC_DISPATCH is defined, the CPU is probed on first use and
+ * the crc32 instruction is used if present, falling back to slicing-by-8.
+ * CFGPACK_CRC_BACKEND is ignored in this mode.  The probe is available on
+ * x86-64 (GCC/Clang) and AArch64 Linux; elsewhere slicing-by-8 is used.
+ * Independent of CFGPACK_HOSTED, since the probe needs no stdio.
+ */
+
+/**
+ * @brief Text scanner backend identifiers for CFGPACK_SCAN_BACKEND.
+ *
+ * The .map and JSON parsers search for line ends, quotes, backslashes and
+ * runs of blanks through a small scanning layer:
+ *
+ *   CFGPACK_SCAN_BYTE - one byte per step, no word loads (embedded default)
+ *   CFGPACK_SCAN_SWAR - eight bytes per step in portable C
+ *   CFGPACK_SCAN_SIMD - sixteen bytes per step with SSE2 or NEON, falling
+ *                       back to SWAR when neither is available (hosted
+ *                       default)
+ *
+ * All backends return identical positions.
+ */
+#define CFGPACK_SCAN_BYTE 0
+#define CFGPACK_SCAN_SWAR 1
+#define CFGPACK_SCAN_SIMD 2
+
+/**
+ * @brief Compile-time text scanner backend selection.
+ *
+ * Override by defining CFGPACK_SCAN_BACKEND before including cfgpack
+ * headers.
+ */
+#ifndef CFGPACK_SCAN_BACKEND
+  #ifdef CFGPACK_HOSTED
+    #define CFGPACK_SCAN_BACKEND CFGPACK_SCAN_SIMD
+  #else
+    #define CFGPACK_SCAN_BACKEND CFGPACK_SCAN_BYTE
+  #endif
+#endif
+
 #endif /* CFGPACK_CONFIG_H */
@@ -7,14 +7,18 @@
  *
  * Provides LZ4 and heatshrink decompression wrappers that decompress data
  * into a caller-provided scratch buffer, then call cfgpack_pagein_buf().
+ * cfgpack_pagein_lz4_stream() instead decompresses a block-framed LZ4
+ * stream through a small ring into cfgpack_pagein_stream(), and
+ * cfgpack_schema_parse_msgpack_lz4() does the same for a msgpack schema.
  *
  * Enable with compile flags:
  * - CFGPACK_LZ4: Enable LZ4 decompression
  * - CFGPACK_HEATSHRINK: Enable heatshrink decompression
  *
- * Note: The heatshrink path uses a static decoder instance and is NOT
- * thread-safe. The LZ4 path is fully reentrant.
- * Compression must be done externally; only decompression is supported.
+ * Note: cfgpack_pagein_heatshrink() uses a static decoder instance and is
+ * NOT thread-safe; cfgpack_pagein_heatshrink_r() takes a caller-owned
+ * decoder instead. The LZ4 paths are fully reentrant.
+ * On-device compression lives in compress.h.
  */
 
 #include "api.h"
@@ -23,6 +27,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifdef CFGPACK_LZ4
 /**
  * @brief Decompress LZ4 data and load into context.
@@ -47,9 +55,167 @@ cfgpack_err_t cfgpack_pagein_lz4(cfgpack_ctx_t *ctx,
                                  size_t decompressed_size,
                                  uint8_t *scratch,
                                  size_t scratch_cap);
+
+/**
+ * @brief Build the schema's LZ4 dictionary: its defaults-only pageout.
+ *
+ * Writes the cfgpack_pageout() blob of @p ctx without its CRC trailer.
+ * Call it right after cfgpack_init() (or a schema parse and init), before
+ * any set or pagein, so the dictionary depends only on the schema: its
+ * map_name, keys and default values.  `cfgpack-compress --dict <schema>`
+ * derives the same bytes on the host.  Keep the dictionary for the
+ * lifetime of the context; blobs compressed with it load only with it.
+ *
+ * @param ctx       Freshly initialized context holding only defaults.
+ * @param dict      Output buffer for the dictionary.
+ * @param dict_cap  Capacity of @p dict; at least the full pageout size.
+ * @param dict_len  Receives the dictionary length.
+ * @return CFGPACK_OK on success;
+ *         CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_ENCODE if @p dict is too small.
+ */
+cfgpack_err_t cfgpack_lz4_dict(cfgpack_ctx_t *ctx,
+                               uint8_t *dict,
+                               size_t dict_cap,
+                               size_t *dict_len);
+
+/**
+ * @brief Decompress LZ4 data primed with a dictionary and load it.
+ *
+ * Like cfgpack_pagein_lz4() for data compressed against @p dict, usually
+ * the schema dictionary from cfgpack_lz4_dict().  The framing is that of
+ * cfgpack_pagein_lz4(), but matches may reach back into the dictionary,
+ * which shrinks small blobs the most.  A wrong dictionary fails the
+ * decompression or the CRC-32C check.
+ *
+ * @param ctx               Initialized cfgpack context.
+ * @param data              LZ4-compressed data (past the size header).
+ * @param len               Length of compressed data in bytes.
+ * @param decompressed_size Expected size of decompressed data.
+ * @param dict              Dictionary the data was compressed with.
+ * @param dict_len          Length of @p dict (LZ4 uses the last 64 KB).
+ * @param scratch           Buffer for decompressed output; must not
+ *                          overlap @p dict.
+ * @param scratch_cap       Capacity of scratch buffer in bytes.
+ * @return CFGPACK_OK on success;
+ *         CFGPACK_ERR_BOUNDS if decompressed_size > scratch_cap;
+ *         CFGPACK_ERR_DECODE on decompression failure or NULL arguments;
+ *         Other errors from cfgpack_pagein_buf().
+ */
+cfgpack_err_t cfgpack_pagein_lz4_dict(cfgpack_ctx_t *ctx,
+                                      const uint8_t *data,
+                                      size_t len,
+                                      size_t decompressed_size,
+                                      const uint8_t *dict,
+                                      size_t dict_len,
+                                      uint8_t *scratch,
+                                      size_t scratch_cap);
+
+/** Bytes of the block-framed LZ4 stream header. */
+#define CFGPACK_LZ4S_HDR_SIZE 10
+/** Smallest block size of a block-framed LZ4 stream. */
+#define CFGPACK_LZ4S_BLOCK_MIN 16
+/** Largest ring size of a block-framed LZ4 stream. */
+#define CFGPACK_LZ4S_RING_MAX 65536
+
+/**
+ * @brief Decompress a block-framed LZ4 stream while it is decoded.
+ *
+ * The stream, written by `cfgpack-compress lz4-stream`, is a 10-byte
+ * header (decompressed size u32, block size u16 and ring size u32, all
+ * little-endian) followed by blocks, each a u16 LE compressed length and
+ * an LZ4 block.  Every block but the last decompresses to the block size
+ * and may reference earlier blocks still in the encoder's ring.
+ *
+ * Blocks are decompressed into @p ring and fed to cfgpack_pagein_stream()
+ * as its window refills, so peak RAM is the ring plus the window whatever
+ * the config size; no buffer holds the whole decompressed blob.  Like any
+ * streaming pagein the data is read twice, so it is decompressed twice:
+ * once to verify the CRC-32C trailer and once to decode.
+ *
+ * @param ctx         Initialized cfgpack context.
+ * @param data        Block-framed LZ4 stream.
+ * @param len         Length of @p data in bytes.
+ * @param ring        Caller-provided ring buffer.
+ * @param ring_cap    Capacity of @p ring; at least the stream's ring size.
+ * @param window      Pagein window (see cfgpack_pagein_stream()).
+ * @param window_cap  Capacity of @p window (>= CFGPACK_STREAM_WINDOW_MIN).
+ * @return CFGPACK_OK on success;
+ *         CFGPACK_ERR_BOUNDS if the ring or window is too small;
+ *         CFGPACK_ERR_DECODE on a malformed stream or NULL arguments;
+ *         Other errors from cfgpack_pagein_stream().
+ */
+cfgpack_err_t cfgpack_pagein_lz4_stream(cfgpack_ctx_t *ctx,
+                                        const uint8_t *data,
+                                        size_t len,
+                                        uint8_t *ring,
+                                        size_t ring_cap,
+                                        uint8_t *window,
+                                        size_t window_cap);
+
+/**
+ * @brief Measure a MessagePack schema held as a block-framed LZ4 stream.
+ *
+ * Decompresses through @p ring into cfgpack_schema_measure_msgpack_stream(),
+ * once; no buffer holds the whole decompressed schema.
+ *
+ * @param data        Block-framed LZ4 stream of a msgpack schema.
+ * @param len         Length of @p data in bytes.
+ * @param ring        Caller-provided ring buffer.
+ * @param ring_cap    Capacity of @p ring; at least the stream's ring size.
+ * @param window      Parser window.
+ * @param window_cap  Capacity of @p window (>= CFGPACK_STREAM_WINDOW_MIN).
+ * @param out         Filled with measurement results.
+ * @param err         Optional parse error info on failure.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if the ring or window is too small;
+ *         CFGPACK_ERR_DECODE on a malformed stream; other errors from
+ *         cfgpack_schema_measure_msgpack_stream().
+ */
+cfgpack_err_t cfgpack_schema_measure_msgpack_lz4(
+    const uint8_t *data,
+    size_t len,
+    uint8_t *ring,
+    size_t ring_cap,
+    uint8_t *window,
+    size_t window_cap,
+    cfgpack_schema_measure_t *out,
+    cfgpack_parse_error_t *err);
+
+/**
+ * @brief Parse a MessagePack schema held as a block-framed LZ4 stream.
+ *
+ * Decompresses through @p ring into cfgpack_schema_parse_msgpack_stream(),
+ * which parses in one pass, so every block is decompressed once and peak
+ * scratch RAM is the ring plus the window.  The schema's entries must be
+ * in ascending index order (see cfgpack_schema_parse_msgpack_stream()).
+ *
+ * @param data        Block-framed LZ4 stream of a msgpack schema.
+ * @param len         Length of @p data in bytes.
+ * @param ring        Caller-provided ring buffer.
+ * @param ring_cap    Capacity of @p ring; at least the stream's ring size.
+ * @param window      Parser window.
+ * @param window_cap  Capacity of @p window (>= CFGPACK_STREAM_WINDOW_MIN).
+ * @param opts        Parse options containing output buffers and error
+ *                    pointer.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if the ring or window is too small;
+ *         CFGPACK_ERR_DECODE on a malformed stream; other errors from
+ *         cfgpack_schema_parse_msgpack_stream().
+ */
+cfgpack_err_t cfgpack_schema_parse_msgpack_lz4(
+    const uint8_t *data,
+    size_t len,
+    uint8_t *ring,
+    size_t ring_cap,
+    uint8_t *window,
+    size_t window_cap,
+    const cfgpack_parse_opts_t *opts);
 #endif /* CFGPACK_LZ4 */
 
 #ifdef CFGPACK_HEATSHRINK
+  #include "heatshrink_decoder.h"
+
 /**
  * @brief Decompress heatshrink data and load into context.
  *
@@ -62,6 +228,8 @@ cfgpack_err_t cfgpack_pagein_lz4(cfgpack_ctx_t *ctx,
  * - Lookahead: 4 bits (16 bytes)
  *
  * @note Uses a static decoder instance; not thread-safe or reentrant.
+ *       Use cfgpack_pagein_heatshrink_r() where contexts are paged in
+ *       concurrently.
  *
  * @param ctx         Initialized cfgpack context.
  * @param data        Heatshrink-compressed data.
@@ -78,6 +246,36 @@ cfgpack_err_t cfgpack_pagein_heatshrink(cfgpack_ctx_t *ctx,
                                         size_t len,
                                         uint8_t *scratch,
                                         size_t scratch_cap);
+
+/**
+ * @brief Reentrant cfgpack_pagein_heatshrink() with caller-owned state.
+ *
+ * Identical to cfgpack_pagein_heatshrink() but decodes through @p hsd, so
+ * pageins on different tasks need no shared lock as long as each passes
+ * its own decoder (about 330 bytes with the static configuration).  The
+ * decoder is reset on entry and needs no initialization.
+ *
+ * @param ctx         Initialized cfgpack context.
+ * @param data        Heatshrink-compressed data.
+ * @param len         Length of compressed data in bytes.
+ * @param hsd         Caller-provided decoder state.
+ * @param scratch     Caller-provided buffer for decompressed output.
+ * @param scratch_cap Capacity of scratch buffer in bytes.
+ * @return CFGPACK_OK on success;
+ *         CFGPACK_ERR_BOUNDS if decompressed data exceeds scratch_cap;
+ *         CFGPACK_ERR_DECODE on decompression failure or NULL arguments;
+ *         Other errors from cfgpack_pagein_buf().
+ */
+cfgpack_err_t cfgpack_pagein_heatshrink_r(cfgpack_ctx_t *ctx,
+                                          const uint8_t *data,
+                                          size_t len,
+                                          heatshrink_decoder *hsd,
+                                          uint8_t *scratch,
+                                          size_t scratch_cap);
 #endif /* CFGPACK_HEATSHRINK */
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* CFGPACK_DECOMPRESS_H */
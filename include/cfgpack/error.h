@@ -10,6 +10,8 @@
  * @brief Error codes returned by cfgpack APIs.
  */
 typedef enum {
+    CFGPACK_PARTIAL = 2,           /**< Loaded records before a bad one. */
+    CFGPACK_IN_PROGRESS = 1,       /**< Step machine not done; call again. */
     CFGPACK_OK = 0,                /**< Success. */
     CFGPACK_ERR_PARSE = -1,        /**< Parse failure. */
     CFGPACK_ERR_INVALID_TYPE = -2, /**< Unknown or unsupported type. */
@@ -26,7 +28,8 @@ typedef enum {
     CFGPACK_ERR_DECODE = -10, /**< Decoding failure or malformed input. */
     CFGPACK_ERR_RESERVED_INDEX = -11, /**< Attempt to use reserved index 0. */
     CFGPACK_ERR_ARGS = -12,           /**< Missing or bad arguments. */
-    CFGPACK_ERR_CRC = -13             /**< CRC-32C integrity check failed. */
+    CFGPACK_ERR_CRC = -13,            /**< CRC-32C integrity check failed. */
+    CFGPACK_ERR_BUSY = -14 /**< Consistent read kept overlapping a write. */
 } cfgpack_err_t;
 
 #endif /* CFGPACK_ERROR_H */
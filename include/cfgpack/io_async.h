@@ -0,0 +1,182 @@
+#ifndef CFGPACK_IO_ASYNC_H
+#define CFGPACK_IO_ASYNC_H
+
+/**
+ * @file io_async.h
+ * @brief Queued file pageouts with coalescing and batched fsync
+ *        (hosted only).
+ *
+ * cfgpack_pageout_file() writes on the caller's thread and leaves
+ * durability to the OS.  A saver with thousands of files instead queues
+ * them here: cfgpack_async_pageout() encodes the context into a slot on
+ * the caller's thread and returns, and a pool of POSIX threads writes the
+ * slots out in batches.
+ *
+ * - A pageout to a path that is still queued replaces the queued blob, so
+ *   only the latest state of each file is written.
+ * - Each file is written to "<path>.tmp", fsync()ed and renamed over
+ *   @c path, so a crash leaves the old file or the new one.
+ * - A worker takes up to @c batch queued files at once.  It writes them
+ *   all before it syncs any, and syncs each directory once per batch
+ *   rather than once per file.  @c linger_ms holds a worker back to
+ *   collect a fuller batch.
+ *
+ * Slots and their blob buffers come from the caller; nothing is
+ * allocated.  To use these functions, compile src/io_async.c with hosted
+ * flags and link with -pthread.  This header is not pulled in by
+ * cfgpack.h.
+ */
+
+#include "api.h"
+#include "error.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Upper bound on cfgpack_async_opts_t::threads. */
+#ifndef CFGPACK_ASYNC_MAX_THREADS
+  #define CFGPACK_ASYNC_MAX_THREADS 16
+#endif
+
+/** Upper bound on cfgpack_async_opts_t::batch. */
+#ifndef CFGPACK_ASYNC_MAX_BATCH
+  #define CFGPACK_ASYNC_MAX_BATCH 64
+#endif
+
+/** Path capacity of a slot, including the ".tmp" suffix and NUL. */
+#ifndef CFGPACK_ASYNC_PATH_MAX
+  #define CFGPACK_ASYNC_PATH_MAX 256
+#endif
+
+/**
+ * @brief Completion callback, run on a worker once a file is durable or
+ *        has failed.
+ *
+ * Runs once per file written, not once per cfgpack_async_pageout(): the
+ * submissions a write replaced complete with it.  It must not call
+ * cfgpack_async_flush() or cfgpack_async_stop().
+ *
+ * @param path Destination path.
+ * @param rc   CFGPACK_OK, or CFGPACK_ERR_IO.
+ * @param user cfgpack_async_opts_t::user.
+ */
+typedef void (*cfgpack_async_done_fn)(const char *path,
+                                      cfgpack_err_t rc,
+                                      void *user);
+
+/** @brief One queued file.  The fields are private. */
+typedef struct {
+    char path[CFGPACK_ASYNC_PATH_MAX]; /**< Destination path */
+    uint8_t *buf;                      /**< Blob buffer in the arena */
+    size_t len;                        /**< Blob length */
+    uint64_t seq;                      /**< Queue order */
+    uint8_t state;                     /**< Free, reserved, queued, ... */
+} cfgpack_async_slot_t;
+
+/** @brief Settings for cfgpack_async_start(). */
+typedef struct {
+    cfgpack_async_slot_t *slots; /**< Queue slots */
+    size_t slot_count;           /**< Entries in @c slots */
+    uint8_t *arena;              /**< slot_count * blob_cap bytes */
+    size_t blob_cap;             /**< Largest blob a slot holds */
+    unsigned threads;            /**< Workers, at least 1 */
+    unsigned batch;              /**< Files per batch, 0 for the maximum */
+    uint32_t linger_ms;          /**< Wait for a fuller batch, or 0 */
+    cfgpack_async_done_fn done;  /**< Completion callback, or NULL */
+    void *user;                  /**< Passed through to @c done */
+} cfgpack_async_opts_t;
+
+/** @brief Queue counters, stable once cfgpack_async_flush() returns. */
+typedef struct {
+    uint64_t submitted; /**< cfgpack_async_pageout() calls that queued */
+    uint64_t coalesced; /**< Submissions that replaced a queued blob */
+    uint64_t written;   /**< Files renamed into place */
+    uint64_t failed;    /**< Files that failed */
+    uint64_t batches;   /**< Batches taken by workers */
+    uint64_t dir_syncs; /**< Directory fsync() calls */
+} cfgpack_async_stats_t;
+
+/** @brief Queue state.  The fields are private. */
+typedef struct {
+    cfgpack_async_opts_t opts;                   /**< Settings */
+    pthread_t threads[CFGPACK_ASYNC_MAX_THREADS]; /**< Workers */
+    unsigned started;                            /**< Workers running */
+    pthread_mutex_t lock;                        /**< Guards all below */
+    pthread_cond_t work;                         /**< A slot was queued */
+    pthread_cond_t idle;                         /**< A slot was freed */
+    uint64_t seq;                                /**< Next queue order */
+    size_t queued;                               /**< Slots queued */
+    size_t busy;                                 /**< Slots not free */
+    int stop;                                    /**< Set by stop */
+    cfgpack_err_t err;                           /**< First failure */
+    cfgpack_async_stats_t stats;                 /**< Counters */
+} cfgpack_async_t;
+
+/**
+ * @brief Start the worker pool.
+ *
+ * @param a    Queue state to set up; must not move while running.
+ * @param opts Settings, copied.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments, no
+ *         slots, a zero @c blob_cap, or @c threads or @c batch outside
+ *         1..CFGPACK_ASYNC_MAX_THREADS and 0..CFGPACK_ASYNC_MAX_BATCH;
+ *         CFGPACK_ERR_IO if no thread could be started.
+ */
+cfgpack_err_t cfgpack_async_start(cfgpack_async_t *a,
+                                  const cfgpack_async_opts_t *opts);
+
+/**
+ * @brief Queue a pageout of @p ctx to @p path.
+ *
+ * The blob is encoded with cfgpack_pageout() on the calling thread, so
+ * @p ctx may change again as soon as this returns, and its dirty bits are
+ * cleared as by a synchronous pageout.  If @p path is already queued and
+ * not yet taken by a worker, the new blob replaces the old one.  Blocks
+ * while every slot is in use.
+ *
+ * @param a    Running queue.
+ * @param ctx  Initialized context.
+ * @param path Destination path.
+ * @return CFGPACK_OK once queued; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         stopped queue; CFGPACK_ERR_BOUNDS if @p path does not fit
+ *         CFGPACK_ASYNC_PATH_MAX with its suffix; CFGPACK_ERR_ENCODE if
+ *         the blob exceeds @c blob_cap; a lazy decode error.
+ */
+cfgpack_err_t cfgpack_async_pageout(cfgpack_async_t *a,
+                                    cfgpack_ctx_t *ctx,
+                                    const char *path);
+
+/**
+ * @brief Wait until every queued file is written.
+ *
+ * @param a Running queue.
+ * @return CFGPACK_OK if every file since the last flush was written;
+ *         otherwise the first failure, which is then cleared.
+ *         CFGPACK_ERR_ARGS on NULL @p a.
+ */
+cfgpack_err_t cfgpack_async_flush(cfgpack_async_t *a);
+
+/**
+ * @brief Copy the queue counters.
+ * @param a   Queue.
+ * @param out Receives the counters.
+ */
+void cfgpack_async_get_stats(cfgpack_async_t *a, cfgpack_async_stats_t *out);
+
+/**
+ * @brief Flush, then stop and join the workers.
+ * @param a Running queue.
+ * @return Result of the final cfgpack_async_flush().
+ */
+cfgpack_err_t cfgpack_async_stop(cfgpack_async_t *a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGPACK_IO_ASYNC_H */
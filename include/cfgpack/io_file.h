@@ -15,6 +15,10 @@
 #include "api.h"
 #include "schema.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief Parse a .map schema from a file.
  *
@@ -106,14 +110,19 @@ cfgpack_err_t cfgpack_schema_write_json_file(const cfgpack_ctx_t *ctx,
 /**
  * @brief Encode to a file using caller scratch buffer (no heap).
  *
+ * Streams through @p scratch with cfgpack_pageout_stream(), so the blob may
+ * be larger than the scratch buffer.  Encode errors are detected before the
+ * file is opened.
+ *
  * @param ctx          Initialized context.
  * @param path         Destination file path.
- * @param scratch      Scratch buffer used for encode.
- * @param scratch_cap  Capacity of @p scratch in bytes.
- * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if scratch too small;
+ * @param scratch      Chunk buffer used for encode.
+ * @param scratch_cap  Capacity of @p scratch (>= CFGPACK_STREAM_CHUNK_MIN).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if scratch is smaller
+ *         than CFGPACK_STREAM_CHUNK_MIN;
  *         CFGPACK_ERR_IO on write failures.
  */
-cfgpack_err_t cfgpack_pageout_file(const cfgpack_ctx_t *ctx,
+cfgpack_err_t cfgpack_pageout_file(cfgpack_ctx_t *ctx,
                                    const char *path,
                                    uint8_t *scratch,
                                    size_t scratch_cap);
@@ -121,9 +130,13 @@ cfgpack_err_t cfgpack_pageout_file(const cfgpack_ctx_t *ctx,
 /**
  * @brief Decode from a file using caller scratch buffer (no heap).
  *
+ * Files that fit in @p scratch are read whole; larger files are decoded
+ * through cfgpack_pagein_stream() with @p scratch as the refill window.
+ *
  * @param ctx          Initialized context.
  * @param path         Source file path.
- * @param scratch      Scratch buffer to hold file contents.
+ * @param scratch      Scratch buffer (file size, or at least
+ *                     CFGPACK_STREAM_WINDOW_MIN to stream).
  * @param scratch_cap  Capacity of @p scratch.
  * @return CFGPACK_OK on success; CFGPACK_ERR_IO on read/size errors;
  *         CFGPACK_ERR_DECODE if payload is invalid.
@@ -133,4 +146,77 @@ cfgpack_err_t cfgpack_pagein_file(cfgpack_ctx_t *ctx,
                                   uint8_t *scratch,
                                   size_t scratch_cap);
 
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Memory-mapped variants
+ *
+ * On POSIX hosts these map the file read-only and parse straight from the
+ * mapping: no copy, and no scratch buffer.  The mapping is released before
+ * returning; parsed names and defaults are copied into the caller's
+ * buffers as usual.  Define CFGPACK_NO_MMAP when building io_file.c, or
+ * build for a platform without mmap, and they fall back to the fread-based
+ * functions above using @p scratch.
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Report whether the *_mmap functions use a memory mapping.
+ * @return 1 if files are mapped; 0 if the scratch-buffer fallback is used.
+ */
+int cfgpack_io_file_has_mmap(void);
+
+/**
+ * @brief Parse a .map schema from a memory-mapped file.
+ *
+ * @param path        File path to map.
+ * @param opts        Parse options containing output buffers and error pointer.
+ * @param scratch     Fallback buffer, used only without mmap (may be NULL
+ *                    when cfgpack_io_file_has_mmap() returns 1).
+ * @param scratch_cap Capacity of @p scratch.
+ * @return As cfgpack_parse_schema_file(); CFGPACK_ERR_ARGS on NULL arguments.
+ */
+cfgpack_err_t cfgpack_parse_schema_file_mmap(const char *path,
+                                             const cfgpack_parse_opts_t *opts,
+                                             char *scratch,
+                                             size_t scratch_cap);
+
+/**
+ * @brief Parse a JSON schema from a memory-mapped file.
+ *
+ * @param path        File path to map.
+ * @param opts        Parse options containing output buffers and error pointer.
+ * @param scratch     Fallback buffer, used only without mmap (may be NULL
+ *                    when cfgpack_io_file_has_mmap() returns 1).
+ * @param scratch_cap Capacity of @p scratch.
+ * @return As cfgpack_schema_parse_json_file(); CFGPACK_ERR_ARGS on NULL
+ *         arguments.
+ */
+cfgpack_err_t
+cfgpack_schema_parse_json_file_mmap(const char *path,
+                                    const cfgpack_parse_opts_t *opts,
+                                    char *scratch,
+                                    size_t scratch_cap);
+
+/**
+ * @brief Decode a blob from a memory-mapped file.
+ *
+ * Decodes with cfgpack_pagein_buf() directly from the mapping, so files of
+ * any size are loaded in a single pass.
+ * In lazy mode (cfgpack_lazy_init()) every value is decoded before the
+ * mapping is released.
+ *
+ * @param ctx          Initialized context.
+ * @param path         Source file path.
+ * @param scratch      Fallback buffer, used only without mmap (may be NULL
+ *                     when cfgpack_io_file_has_mmap() returns 1).
+ * @param scratch_cap  Capacity of @p scratch.
+ * @return As cfgpack_pagein_file(); CFGPACK_ERR_ARGS on NULL arguments.
+ */
+cfgpack_err_t cfgpack_pagein_file_mmap(cfgpack_ctx_t *ctx,
+                                       const char *path,
+                                       uint8_t *scratch,
+                                       size_t scratch_cap);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* CFGPACK_IO_FILE_H */
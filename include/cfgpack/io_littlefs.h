@@ -11,7 +11,8 @@
  *
  * The scratch buffer serves double duty: the first cfg->cache_size bytes
  * are used as the LittleFS file cache (via lfs_file_opencfg), and the
- * remainder holds the serialized data. This avoids lfs_malloc, making
+ * remainder holds the serialized data (pagein) or a streaming chunk
+ * (pageout). This avoids lfs_malloc, making
  * the wrapper compatible with LFS_NO_MALLOC builds.
  *
  * To use these functions, compile with -DCFGPACK_LITTLEFS and link
@@ -23,23 +24,112 @@
   #include "api.h"
   #include "lfs.h"
 
+  #ifdef __cplusplus
+extern "C" {
+  #endif
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Flash cost accounting
+ *
+ * Mount through a meter to see what each save and load costs the flash:
+ *
+ *     static cfgpack_lfs_meter_t meter;
+ *     cfgpack_lfs_meter_init(&meter, &board_lfs_cfg, cycle_count, NULL);
+ *     lfs_mount(&lfs, &meter.cfg);
+ *     cfgpack_pageout_lfs(&ctx, &lfs, "cfg", scratch, sizeof(scratch));
+ *     log_cost(meter.last.prog_bytes, meter.last.erases, meter.last.ticks);
+ *
+ * The meter's cfg forwards every block device call to the original
+ * callbacks and counts it.  Every cfgpack_*lfs*() call on a metered mount
+ * stores its own cost in last; total accumulates from init or reset and
+ * also includes LittleFS calls the application makes directly.
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Tick source for flash cost accounting.
+ *
+ * Any monotonic unit (cycles, microseconds); differences are taken
+ * modulo 2^32.
+ */
+typedef uint32_t (*cfgpack_lfs_clock_fn)(void *user);
+
+/**
+ * @brief Block device cost of one operation or of a period.
+ */
+typedef struct {
+    uint32_t reads;       /**< Block device read calls. */
+    uint32_t read_bytes;  /**< Bytes read from flash. */
+    uint32_t progs;       /**< Block device program calls. */
+    uint32_t prog_bytes;  /**< Bytes programmed. */
+    uint32_t erases;      /**< Blocks erased. */
+    uint32_t syncs;       /**< Block device sync calls. */
+    uint32_t flash_ticks; /**< Ticks spent inside the block device calls. */
+    uint32_t ticks;       /**< Ticks spent in cfgpack_*lfs*() calls. */
+} cfgpack_lfs_cost_t;
+
+/**
+ * @brief Counting wrapper around a caller's lfs_config.
+ *
+ * Caller-owned; must outlive the mount.  Read last and total directly.
+ */
+typedef struct {
+    struct lfs_config cfg;         /**< Mount with this copy (first). */
+    const struct lfs_config *base; /**< Original config and callbacks. */
+    cfgpack_lfs_clock_fn clock;    /**< Tick source, or NULL (no timing). */
+    void *clock_user;              /**< Passed to @ref clock. */
+    cfgpack_lfs_cost_t last;       /**< Cost of the latest wrapper call. */
+    cfgpack_lfs_cost_t total;      /**< Cost since init or reset. */
+    cfgpack_lfs_cost_t mark;       /**< Internal: total at call start. */
+    uint32_t start;                /**< Internal: tick at call start. */
+} cfgpack_lfs_meter_t;
+
+/**
+ * @brief Set up @p meter to count the block device calls of @p base.
+ *
+ * Copies @p base into meter->cfg and replaces its read, prog, erase and
+ * sync callbacks with counting ones that call the originals with
+ * &meter->cfg (context and geometry are unchanged).  Mount with
+ * &meter->cfg.
+ *
+ * @param meter       Meter to initialize; zeroes its counters.
+ * @param base        Caller's config; must outlive the meter.
+ * @param clock       Optional tick source for flash_ticks and ticks.
+ * @param clock_user  Passed to @p clock.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments,
+ *         missing callbacks, or a @p base that is itself a meter's cfg.
+ */
+cfgpack_err_t cfgpack_lfs_meter_init(cfgpack_lfs_meter_t *meter,
+                                     const struct lfs_config *base,
+                                     cfgpack_lfs_clock_fn clock,
+                                     void *clock_user);
+
+/**
+ * @brief Zero the last and total counters of @p meter.
+ * @param meter Meter to reset (NULL is ignored).
+ */
+void cfgpack_lfs_meter_reset(cfgpack_lfs_meter_t *meter);
+
 /**
  * @brief Encode to a LittleFS file using caller scratch buffer (no heap).
  *
- * Serializes the context into a MessagePack blob via cfgpack_pageout(),
- * then writes it to a LittleFS file. The caller owns the lfs_t instance
- * and must have it mounted before calling.
+ * Streams the context into a LittleFS file via cfgpack_pageout_stream(),
+ * writing one chunk at a time, so the blob may be larger than @p scratch.
+ * Encode errors are detected with cfgpack_pageout_measure() before the
+ * file is opened.  The caller owns the lfs_t instance and must have it
+ * mounted before calling.
  *
  * @param ctx          Initialized context.
  * @param lfs          Mounted LittleFS instance (caller-owned).
  * @param path         Destination file path within LittleFS.
- * @param scratch      Scratch buffer (must be >= cfg->cache_size + encoded size).
+ * @param scratch      Scratch buffer (must be >= cfg->cache_size +
+ *                     CFGPACK_STREAM_CHUNK_MIN).
  * @param scratch_cap  Capacity of @p scratch in bytes.
- * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if data portion too small;
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if data portion is
+ *         smaller than CFGPACK_STREAM_CHUNK_MIN;
  *         CFGPACK_ERR_BOUNDS if scratch < cache_size;
  *         CFGPACK_ERR_IO on LittleFS write failures.
  */
-cfgpack_err_t cfgpack_pageout_lfs(const cfgpack_ctx_t *ctx,
+cfgpack_err_t cfgpack_pageout_lfs(cfgpack_ctx_t *ctx,
                                   lfs_t *lfs,
                                   const char *path,
                                   uint8_t *scratch,
@@ -48,14 +138,17 @@ cfgpack_err_t cfgpack_pageout_lfs(const cfgpack_ctx_t *ctx,
 /**
  * @brief Decode from a LittleFS file using caller scratch buffer (no heap).
  *
- * Reads the file contents into the scratch buffer, then calls
- * cfgpack_pagein_buf() to deserialize the MessagePack payload.
+ * If the file fits in the data region it is read whole and passed to
+ * cfgpack_pagein_buf().  Otherwise, if the data region is at least
+ * CFGPACK_STREAM_WINDOW_MIN, it is decoded through cfgpack_pagein_stream()
+ * using the data region as the refill window.
  * The caller owns the lfs_t instance and must have it mounted.
  *
  * @param ctx          Initialized context.
  * @param lfs          Mounted LittleFS instance (caller-owned).
  * @param path         Source file path within LittleFS.
- * @param scratch      Scratch buffer (must be >= cfg->cache_size + file size).
+ * @param scratch      Scratch buffer (>= cfg->cache_size + file size, or
+ *                     cfg->cache_size + CFGPACK_STREAM_WINDOW_MIN).
  * @param scratch_cap  Capacity of @p scratch.
  * @return CFGPACK_OK on success; CFGPACK_ERR_BOUNDS if scratch < cache_size;
  *         CFGPACK_ERR_IO on read/size errors;
@@ -67,5 +160,201 @@ cfgpack_err_t cfgpack_pagein_lfs(cfgpack_ctx_t *ctx,
                                  uint8_t *scratch,
                                  size_t scratch_cap);
 
+/**
+ * @brief Save to an append-only journal file on LittleFS.
+ *
+ * The journal holds a full base record followed by delta records
+ * (cfgpack_pageout_delta()), each framed by a 1-byte tag and a 4-byte
+ * length and protected by its own CRC-32C trailer.  A save appends one
+ * delta record holding only the dirty entries, so its flash cost scales
+ * with what changed rather than with the config size.  Nothing is written
+ * when no entry is dirty.
+ *
+ * The journal is compacted (rewritten as a single base record) instead of
+ * appended to when the file does not exist yet, when the delta does not
+ * fit the scratch data region, or when appending would grow the file past
+ * @p compact_at bytes.  Call cfgpack_lfs_journal_compact() directly to
+ * compact at a convenient time (e.g. when idle) instead.
+ *
+ * On failure the dirty bits are restored, so the next save retries.
+ * @p path must only be written by the journal functions.
+ *
+ * @param ctx          Initialized context.
+ * @param lfs          Mounted LittleFS instance (caller-owned).
+ * @param path         Journal file path within LittleFS.
+ * @param scratch      Scratch buffer (>= cfg->cache_size + the largest
+ *                     delta + 5 for appends, + CFGPACK_STREAM_CHUNK_MIN for
+ *                     compaction).
+ * @param scratch_cap  Capacity of @p scratch.
+ * @param compact_at   File size that triggers compaction (0 = never).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if scratch < cache_size;
+ *         CFGPACK_ERR_ENCODE if the data region is too small;
+ *         CFGPACK_ERR_IO on LittleFS failures.
+ */
+cfgpack_err_t cfgpack_pageout_lfs_journal(cfgpack_ctx_t *ctx,
+                                          lfs_t *lfs,
+                                          const char *path,
+                                          uint8_t *scratch,
+                                          size_t scratch_cap,
+                                          size_t compact_at);
+
+/**
+ * @brief Rewrite a journal file as a single base record.
+ *
+ * Streams the whole context like cfgpack_pageout_lfs().  LittleFS commits
+ * the new file atomically on close, so the old journal survives a failed
+ * or interrupted compaction.
+ *
+ * @param ctx          Initialized context.
+ * @param lfs          Mounted LittleFS instance (caller-owned).
+ * @param path         Journal file path within LittleFS.
+ * @param scratch      Scratch buffer (>= cfg->cache_size +
+ *                     CFGPACK_STREAM_CHUNK_MIN).
+ * @param scratch_cap  Capacity of @p scratch.
+ * @return As cfgpack_pageout_lfs().
+ */
+cfgpack_err_t cfgpack_lfs_journal_compact(cfgpack_ctx_t *ctx,
+                                          lfs_t *lfs,
+                                          const char *path,
+                                          uint8_t *scratch,
+                                          size_t scratch_cap);
+
+/**
+ * @brief Load a journal file: the base record, then every delta in order.
+ *
+ * Each record's CRC is verified before it is applied.  A base record
+ * larger than the data region is streamed via cfgpack_pagein_stream();
+ * delta records must fit in it.
+ *
+ * Replay stops at the first delta that is truncated, fails its CRC or
+ * does not apply.  The base and the deltas before it are then replayed
+ * again, so the context holds exactly their state, and CFGPACK_PARTIAL
+ * is returned.  Compact the journal afterwards: deltas appended behind
+ * the bad record would never be reached.  If the base itself is bad,
+ * the context may hold part of it.
+ *
+ * @param ctx          Initialized context.
+ * @param lfs          Mounted LittleFS instance (caller-owned).
+ * @param path         Journal file path within LittleFS.
+ * @param scratch      Scratch buffer (>= cfg->cache_size + largest record,
+ *                     or + CFGPACK_STREAM_WINDOW_MIN for the base).
+ * @param scratch_cap  Capacity of @p scratch.
+ * @return CFGPACK_OK on success; CFGPACK_PARTIAL if a delta was bad;
+ *         CFGPACK_ERR_BOUNDS if scratch < cache_size; CFGPACK_ERR_IO on
+ *         read failures or a base too large for scratch;
+ *         CFGPACK_ERR_DECODE on bad framing (including a plain
+ *         cfgpack_pageout_lfs() file); CFGPACK_ERR_CRC if the base fails
+ *         its checksum.
+ */
+cfgpack_err_t cfgpack_pagein_lfs_journal(cfgpack_ctx_t *ctx,
+                                         lfs_t *lfs,
+                                         const char *path,
+                                         uint8_t *scratch,
+                                         size_t scratch_cap);
+
+/**
+ * @brief Save to the older of two A/B files with the next sequence number.
+ *
+ * Each file holds a slot header (see slots.h) followed by a full blob.
+ * The file that does not hold the newest valid copy is rewritten, so the
+ * previous copy survives a failed or interrupted save.  If the newest
+ * file's blob fails its CRC, that file is rewritten instead.
+ *
+ * @param ctx          Initialized context.
+ * @param lfs          Mounted LittleFS instance (caller-owned).
+ * @param path_a       First slot file path.
+ * @param path_b       Second slot file path.
+ * @param scratch      Scratch buffer (>= cfg->cache_size +
+ *                     CFGPACK_STREAM_CHUNK_MIN).
+ * @param scratch_cap  Capacity of @p scratch.
+ * @return As cfgpack_pageout_lfs(); CFGPACK_ERR_ARGS on NULL arguments.
+ */
+cfgpack_err_t cfgpack_pageout_lfs_ab(cfgpack_ctx_t *ctx,
+                                     lfs_t *lfs,
+                                     const char *path_a,
+                                     const char *path_b,
+                                     uint8_t *scratch,
+                                     size_t scratch_cap);
+
+/**
+ * @brief Load the newest valid A/B file, falling back to the other.
+ *
+ * Only the two slot headers are read to choose a file.  If its blob fails
+ * the CRC check, the other file is tried.
+ *
+ * @param ctx          Initialized context.
+ * @param lfs          Mounted LittleFS instance (caller-owned).
+ * @param path_a       First slot file path.
+ * @param path_b       Second slot file path.
+ * @param scratch      Scratch buffer (>= cfg->cache_size + blob size, or
+ *                     cfg->cache_size + CFGPACK_STREAM_WINDOW_MIN).
+ * @param scratch_cap  Capacity of @p scratch.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_MISSING if neither file has
+ *         a valid header; CFGPACK_ERR_CRC / CFGPACK_ERR_DECODE if neither
+ *         blob verifies; CFGPACK_ERR_IO on read failures.
+ */
+cfgpack_err_t cfgpack_pagein_lfs_ab(cfgpack_ctx_t *ctx,
+                                    lfs_t *lfs,
+                                    const char *path_a,
+                                    const char *path_b,
+                                    uint8_t *scratch,
+                                    size_t scratch_cap);
+
+/**
+ * @brief Save several contexts as one bundle file (see bundle.h).
+ *
+ * The previous file is read into the data region first, so sections of
+ * contexts without dirty bits are carried over instead of re-encoded.
+ * The new bundle is then written with one open and one write.  LittleFS
+ * commits it on close, so a failure leaves the old file; dirty bits are
+ * restored in that case.
+ *
+ * @param ctxs         Contexts, at most CFGPACK_BUNDLE_MAX.
+ * @param n            Number of contexts.
+ * @param lfs          Mounted LittleFS instance (caller-owned).
+ * @param path         Bundle file path within LittleFS.
+ * @param scratch      Scratch buffer (>= cfg->cache_size + the larger of
+ *                     the old and new bundle).
+ * @param scratch_cap  Capacity of @p scratch.
+ * @param kept         Optional; receives the sections carried over.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if scratch < cache_size;
+ *         CFGPACK_ERR_ENCODE if the bundle does not fit the data region;
+ *         CFGPACK_ERR_IO on LittleFS failures; errors from
+ *         cfgpack_bundle_pageout().
+ */
+cfgpack_err_t cfgpack_pageout_lfs_bundle(cfgpack_ctx_t *const *ctxs,
+                                         size_t n,
+                                         lfs_t *lfs,
+                                         const char *path,
+                                         uint8_t *scratch,
+                                         size_t scratch_cap,
+                                         size_t *kept);
+
+/**
+ * @brief Load several contexts from one bundle file with a single read.
+ *
+ * @param ctxs         Contexts; each loads the section with its schema
+ *                     name.
+ * @param n            Number of contexts.
+ * @param lfs          Mounted LittleFS instance (caller-owned).
+ * @param path         Bundle file path within LittleFS.
+ * @param scratch      Scratch buffer (>= cfg->cache_size + file size).
+ * @param scratch_cap  Capacity of @p scratch.
+ * @return As cfgpack_bundle_pagein_all(); CFGPACK_ERR_BOUNDS if the file
+ *         does not fit the data region; CFGPACK_ERR_IO on read failures.
+ */
+cfgpack_err_t cfgpack_pagein_lfs_bundle(cfgpack_ctx_t *const *ctxs,
+                                        size_t n,
+                                        lfs_t *lfs,
+                                        const char *path,
+                                        uint8_t *scratch,
+                                        size_t scratch_cap);
+
+  #ifdef __cplusplus
+}
+  #endif
+
 #endif /* CFGPACK_LITTLEFS */
 #endif /* CFGPACK_IO_LITTLEFS_H */
@@ -14,13 +14,47 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Output callback for chunked (streaming) encoding.
+ *
+ * Receives each filled chunk in order.  Must consume all @p len bytes.
+ *
+ * @param user  Opaque pointer passed through from the caller.
+ * @param data  Bytes to write.
+ * @param len   Number of bytes in @p data.
+ * @return CFGPACK_OK on success; any other code aborts the stream and is
+ *         returned to the caller.
+ */
+typedef cfgpack_err_t (*cfgpack_sink_fn)(void *user,
+                                         const uint8_t *data,
+                                         size_t len);
+
 /**
  * @brief Fixed-capacity buffer used for MessagePack encoding.
+ *
+ * When @c crc_on is set (see cfgpack_buf_crc_begin()), every byte passed to
+ * cfgpack_buf_append() is folded into a running CRC-32C so the checksum is
+ * ready as soon as encoding finishes.
+ *
+ * When @c sink is set (see cfgpack_buf_init_sink()), @c data is a chunk
+ * buffer: a full chunk is handed to the sink and reused, so output of any
+ * size passes through @c cap bytes of RAM.  @c len then counts bytes in the
+ * current chunk and @c flushed counts bytes already delivered.
  */
 typedef struct {
     uint8_t *data;
     size_t cap;
     size_t len;
+    uint32_t crc;            /**< Running CRC-32C (valid when crc_on). */
+    uint8_t crc_on;          /**< Nonzero to checksum appended bytes. */
+    cfgpack_sink_fn sink;    /**< Chunk consumer, or NULL for a flat buffer. */
+    void *sink_user;         /**< Opaque pointer passed to @c sink. */
+    size_t flushed;          /**< Bytes already delivered to @c sink. */
+    cfgpack_err_t sink_err;  /**< First sink failure (sticky). */
 } cfgpack_buf_t;
 
 /**
@@ -32,6 +66,37 @@ typedef struct {
  */
 void cfgpack_buf_init(cfgpack_buf_t *buf, uint8_t *storage, size_t cap);
 
+/**
+ * @brief Initialize a chunked buffer that drains into a sink callback.
+ *
+ * Appends accumulate in @p chunk; when the next append would not fit, the
+ * chunk is passed to @p sink and reset.  Appends larger than @p cap are
+ * forwarded to the sink directly.  Call cfgpack_buf_flush() after the last
+ * append to deliver the final partial chunk.
+ *
+ * @param buf   Buffer to initialize.
+ * @param chunk Caller-provided chunk storage.
+ * @param cap   Capacity of @p chunk in bytes (must be > 0).
+ * @param sink  Chunk consumer.
+ * @param user  Opaque pointer passed to @p sink.
+ */
+void cfgpack_buf_init_sink(cfgpack_buf_t *buf,
+                           uint8_t *chunk,
+                           size_t cap,
+                           cfgpack_sink_fn sink,
+                           void *user);
+
+/**
+ * @brief Deliver any buffered bytes to the sink.
+ *
+ * No-op for flat buffers.
+ *
+ * @param buf Buffer to flush.
+ * @return CFGPACK_OK on success; the sink's error code otherwise (also
+ *         recorded in @c sink_err).
+ */
+cfgpack_err_t cfgpack_buf_flush(cfgpack_buf_t *buf);
+
 /**
  * @brief Append bytes to a MessagePack buffer.
  *
@@ -44,6 +109,26 @@ cfgpack_err_t cfgpack_buf_append(cfgpack_buf_t *buf,
                                  const void *src,
                                  size_t len);
 
+/**
+ * @brief Start checksumming bytes appended to @p buf.
+ *
+ * Bytes already in the buffer are not included.
+ *
+ * @param buf Buffer to track.
+ */
+void cfgpack_buf_crc_begin(cfgpack_buf_t *buf);
+
+/**
+ * @brief Return the CRC-32C of all bytes appended since
+ *        cfgpack_buf_crc_begin().
+ *
+ * Tracking stays enabled; later appends continue the same checksum.
+ *
+ * @param buf Tracked buffer.
+ * @return Finalized CRC-32C value.
+ */
+uint32_t cfgpack_buf_crc(const cfgpack_buf_t *buf);
+
 /** Encoding helpers (MessagePack subset). */
 
 /**
@@ -98,6 +183,26 @@ cfgpack_err_t cfgpack_msgpack_encode_str(cfgpack_buf_t *buf,
 cfgpack_err_t cfgpack_msgpack_encode_map_header(cfgpack_buf_t *buf,
                                                 uint32_t count);
 
+/**
+ * @brief Encode a MessagePack array header with the given element count.
+ * @param buf   Buffer to append encoded data to.
+ * @param count Number of elements in the array.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if buffer capacity exceeded.
+ */
+cfgpack_err_t cfgpack_msgpack_encode_array_header(cfgpack_buf_t *buf,
+                                                  uint32_t count);
+
+/**
+ * @brief Encode a byte string as MessagePack bin.
+ * @param buf  Buffer to append encoded data to.
+ * @param data Bytes to encode.
+ * @param len  Number of bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ENCODE if buffer capacity exceeded.
+ */
+cfgpack_err_t cfgpack_msgpack_encode_bin(cfgpack_buf_t *buf,
+                                         const void *data,
+                                         size_t len);
+
 /**
  * @brief Encode an unsigned integer as a MessagePack map key.
  * @param buf Buffer to append encoded data to.
@@ -117,13 +222,52 @@ cfgpack_err_t cfgpack_msgpack_encode_str_key(cfgpack_buf_t *buf,
                                              const char *s,
                                              size_t len);
 
+/**
+ * @brief Input callback for windowed (streaming) decoding.
+ *
+ * Copies up to @p cap bytes starting at absolute stream @p offset into
+ * @p dst.  The stream must be re-readable: the same offset may be requested
+ * more than once.
+ *
+ * @param user     Opaque pointer passed through from the caller.
+ * @param offset   Absolute byte offset to read from.
+ * @param dst      Destination buffer.
+ * @param cap      Maximum bytes to copy.
+ * @param out_len  Receives bytes copied; 0 signals end of stream.
+ * @return CFGPACK_OK on success; any other code aborts decoding.
+ */
+typedef cfgpack_err_t (*cfgpack_source_fn)(void *user,
+                                           size_t offset,
+                                           uint8_t *dst,
+                                           size_t cap,
+                                           size_t *out_len);
+
 /**
  * @brief Reader over a MessagePack buffer.
+ *
+ * When @c crc_on is set (see cfgpack_reader_crc_begin()), consumed bytes are
+ * checksummed lazily: decoders only advance @c pos, and the bytes between
+ * @c crc_pos and @c pos are folded in when cfgpack_reader_crc() is called.
+ *
+ * When @c src is set (see cfgpack_reader_init_source()), @c data is a
+ * refill window over a longer stream: @c base is the stream offset of
+ * data[0], and decoders pull more bytes from @c src whenever a token runs
+ * past @c len.  Any single string must fit in the window.
  */
 typedef struct {
     const uint8_t *data;
     size_t len;
     size_t pos;
+    uint32_t crc;           /**< Running CRC-32C of data[0..crc_pos). */
+    size_t crc_pos;         /**< First consumed byte not yet in @c crc. */
+    uint8_t crc_on;         /**< Nonzero to checksum consumed bytes. */
+    cfgpack_source_fn src;  /**< Refill callback, or NULL for a flat buffer. */
+    void *src_user;         /**< Opaque pointer passed to @c src. */
+    uint8_t *win;           /**< Writable alias of @c data (windowed mode). */
+    size_t win_cap;         /**< Capacity of @c win. */
+    size_t base;            /**< Stream offset of data[0]. */
+    size_t limit;           /**< Stream offset the reader may not read past. */
+    cfgpack_err_t src_err;  /**< First source failure (sticky). */
 } cfgpack_reader_t;
 
 /**
@@ -135,6 +279,52 @@ typedef struct {
  */
 void cfgpack_reader_init(cfgpack_reader_t *r, const uint8_t *data, size_t len);
 
+/**
+ * @brief Initialize a reader that pulls from a source through a window.
+ *
+ * @param r        Reader to initialize.
+ * @param window   Caller-provided window storage.
+ * @param cap      Capacity of @p window in bytes.
+ * @param src      Source callback.
+ * @param user     Opaque pointer passed to @p src.
+ * @param limit    Number of stream bytes the reader may consume.
+ */
+void cfgpack_reader_init_source(cfgpack_reader_t *r,
+                                uint8_t *window,
+                                size_t cap,
+                                cfgpack_source_fn src,
+                                void *user,
+                                size_t limit);
+
+/**
+ * @brief Return the next byte without consuming it.
+ *
+ * @param r    Reader state.
+ * @param out  Receives the byte.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_DECODE at end of input.
+ */
+cfgpack_err_t cfgpack_reader_peek(cfgpack_reader_t *r, uint8_t *out);
+
+/**
+ * @brief Start checksumming bytes consumed from @p r.
+ *
+ * Bytes before the current position are not included.
+ *
+ * @param r Reader to track.
+ */
+void cfgpack_reader_crc_begin(cfgpack_reader_t *r);
+
+/**
+ * @brief Return the CRC-32C of all bytes consumed since
+ *        cfgpack_reader_crc_begin().
+ *
+ * Folds any pending consumed bytes into the running register first.
+ *
+ * @param r Tracked reader.
+ * @return Finalized CRC-32C value.
+ */
+uint32_t cfgpack_reader_crc(cfgpack_reader_t *r);
+
 /** Decoding helpers (MessagePack subset). */
 
 /**
@@ -189,6 +379,26 @@ cfgpack_err_t cfgpack_msgpack_decode_str(cfgpack_reader_t *r,
 cfgpack_err_t cfgpack_msgpack_decode_map_header(cfgpack_reader_t *r,
                                                 uint32_t *count);
 
+/**
+ * @brief Decode a MessagePack array header.
+ * @param r     Reader positioned at the array header.
+ * @param count Output parameter for number of elements.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_DECODE on format error or EOF.
+ */
+cfgpack_err_t cfgpack_msgpack_decode_array_header(cfgpack_reader_t *r,
+                                                  uint32_t *count);
+
+/**
+ * @brief Decode a MessagePack bin.
+ * @param r   Reader positioned at the encoded value.
+ * @param ptr Output parameter for pointer into reader's buffer.
+ * @param len Output parameter for the byte count.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_DECODE on format error or EOF.
+ */
+cfgpack_err_t cfgpack_msgpack_decode_bin(cfgpack_reader_t *r,
+                                         const uint8_t **ptr,
+                                         uint32_t *len);
+
 /**
  * @brief Skip over a MessagePack value without decoding it.
  *
@@ -201,4 +411,8 @@ cfgpack_err_t cfgpack_msgpack_decode_map_header(cfgpack_reader_t *r,
  */
 cfgpack_err_t cfgpack_msgpack_skip_value(cfgpack_reader_t *r);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* CFGPACK_MSGPACK_H */
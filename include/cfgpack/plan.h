@@ -0,0 +1,192 @@
+#ifndef CFGPACK_PLAN_H
+#define CFGPACK_PLAN_H
+
+/**
+ * @file plan.h
+ * @brief One-arena memory planning for a schema and its feature set.
+ *
+ * A schema's scratch requirements are spread over several calls: the
+ * parse buffers from cfgpack_schema_measure_t, the index table and name
+ * index, the large-schema bitmaps, and the I/O, decompression and JSON
+ * buffers of the pagein/pageout wrappers.  cfgpack_plan() sums them into
+ * a single arena size and a layout in which every region starts on a
+ * cache-line boundary; cfgpack_plan_carve() then splits one caller
+ * buffer along that layout.
+ *
+ * Example (all storage from one static buffer):
+ * @code
+ *   cfgpack_schema_measure_t m;
+ *   cfgpack_schema_measure(map, len, &m, &err);
+ *
+ *   cfgpack_plan_opts_t po = {CFGPACK_PLAN_INDEX_TABLE | CFGPACK_PLAN_IO,
+ *                             0, 0};
+ *   cfgpack_plan_t plan;
+ *   cfgpack_plan(&m, &po, &plan);       // plan.arena_size <= sizeof(arena)
+ *
+ *   static uint8_t arena[4096];
+ *   cfgpack_arena_t a;
+ *   cfgpack_plan_carve(&plan, arena, sizeof(arena), &a);
+ *
+ *   cfgpack_parse_opts_t opts = {&schema, a.entries, a.max_entries,
+ *       a.values, a.str_pool, a.str_pool_cap, a.str_offsets,
+ *       a.str_offsets_count, &err};
+ *   cfgpack_parse_schema(map, len, &opts);
+ *   cfgpack_init(&ctx, &schema, a.values, m.entry_count, a.str_pool,
+ *                a.str_pool_cap, a.str_offsets, a.str_offsets_count);
+ *   cfgpack_index_table_init(&ctx, a.index_table, a.index_table_cap);
+ *   cfgpack_pageout(&ctx, a.io, a.io_cap, &blob_len);
+ * @endcode
+ */
+
+#include "api.h"
+#include "config.h"
+#include "error.h"
+#include "schema.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name Plan features
+ * Optional regions requested through cfgpack_plan_opts_t::features.  The
+ * entries, values, string pool and string offsets are always planned, as
+ * are the bitmaps in a CFGPACK_LARGE_SCHEMA build.
+ * @{
+ */
+/** @brief Dense index table for cfgpack_index_table_init(). */
+#define CFGPACK_PLAN_INDEX_TABLE 0x01u
+/** @brief Sorted name index for cfgpack_name_index_init(). */
+#define CFGPACK_PLAN_NAME_INDEX 0x02u
+/**
+ * @brief Blob I/O buffer: a whole cfgpack_pageout() blob, preceded by
+ *        lfs_cache_size bytes of LittleFS file cache when that is set.
+ *        With CFGPACK_PLAN_DECOMPRESS it is sized for the compressed
+ *        blob instead.
+ */
+#define CFGPACK_PLAN_IO 0x04u
+/** @brief Decompression output for cfgpack_pagein_lz4()/heatshrink(). */
+#define CFGPACK_PLAN_DECOMPRESS 0x08u
+/** @brief Output buffer for cfgpack_schema_write_json(). */
+#define CFGPACK_PLAN_JSON 0x10u
+/** @} */
+
+/**
+ * @brief Planning options.
+ */
+typedef struct {
+    unsigned features;     /**< OR of CFGPACK_PLAN_* flags */
+    size_t lfs_cache_size; /**< LittleFS cfg->cache_size, or 0 */
+    size_t align; /**< Region alignment; 0 selects CFGPACK_PLAN_ALIGN */
+} cfgpack_plan_opts_t;
+
+/**
+ * @brief One region of a planned arena.
+ *
+ * An empty region (size 0) is carved as a NULL pointer.
+ */
+typedef struct {
+    size_t off;  /**< Offset from the aligned arena base */
+    size_t size; /**< Size in bytes */
+} cfgpack_plan_region_t;
+
+/**
+ * @brief Arena size and layout returned by cfgpack_plan().
+ */
+typedef struct {
+    size_t arena_size; /**< Buffer size that fits at any base alignment */
+    size_t align;      /**< Alignment of every region */
+    size_t blob_max;   /**< Upper bound of a cfgpack_pageout() blob */
+    size_t json_max;   /**< Upper bound of cfgpack_schema_write_json() */
+    cfgpack_plan_region_t entries;     /**< cfgpack_entry_t[entry_count] */
+    cfgpack_plan_region_t values;      /**< cfgpack_value_t[entry_count] */
+    cfgpack_plan_region_t name_index;  /**< uint64_t[entry_count] */
+    cfgpack_plan_region_t str_offsets; /**< cfgpack_str_off_t[str+fstr] */
+    cfgpack_plan_region_t str_pool;    /**< String pool bytes */
+    cfgpack_plan_region_t index_table; /**< Index table bytes */
+    cfgpack_plan_region_t bitmaps;     /**< cfgpack_ctx_bitmaps() storage */
+    cfgpack_plan_region_t io;          /**< Blob/LittleFS scratch */
+    cfgpack_plan_region_t decompress;  /**< Decompressed blob */
+    cfgpack_plan_region_t json;        /**< JSON text */
+} cfgpack_plan_t;
+
+/**
+ * @brief Typed views of a carved arena.
+ *
+ * Field names follow cfgpack_parse_opts_t and the cfgpack_init() and
+ * *_init() parameters they are passed to.
+ */
+typedef struct {
+    cfgpack_entry_t *entries;
+    size_t max_entries;
+    cfgpack_value_t *values;
+    char *str_pool;
+    size_t str_pool_cap;
+    cfgpack_str_off_t *str_offsets;
+    size_t str_offsets_count;
+    uint64_t *name_index;
+    size_t name_index_cap;
+    uint8_t *index_table;
+    size_t index_table_cap;
+    uint8_t *bitmaps;
+    size_t bitmaps_len;
+    uint8_t *io;
+    size_t io_cap;
+    uint8_t *decompress;
+    size_t decompress_cap;
+    char *json;
+    size_t json_cap;
+} cfgpack_arena_t;
+
+/**
+ * @brief Plan one arena for a measured schema.
+ *
+ * Regions are laid out in order of decreasing element alignment, each
+ * starting on a multiple of the plan alignment.  arena_size includes
+ * align - 1 bytes of slack so any buffer of that size can be carved,
+ * whatever its own alignment.
+ *
+ * The JSON bound assumes the worst case of every entry: the longest
+ * index, name, type and numeric value, and every string byte escaped
+ * as \\u00XX.
+ *
+ * @param m    Measure of the schema (cfgpack_schema_measure() and
+ *             friends).
+ * @param opts Feature set and alignment; NULL plans the always-present
+ *             regions at CFGPACK_PLAN_ALIGN.
+ * @param out  Plan (output).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL @p m or @p out,
+ *         or an alignment that is not a power of two of at least 8.
+ */
+cfgpack_err_t cfgpack_plan(const cfgpack_schema_measure_t *m,
+                           const cfgpack_plan_opts_t *opts,
+                           cfgpack_plan_t *out);
+
+/**
+ * @brief Carve a caller buffer along a plan.
+ *
+ * Rounds @p arena up to the plan alignment and points each field of
+ * @p out at its region.  The arena is not cleared.
+ *
+ * @param plan      Plan from cfgpack_plan().
+ * @param arena     Caller-owned buffer; must outlive every user of @p out.
+ * @param arena_len Size of @p arena in bytes (plan->arena_size always
+ *                  suffices).
+ * @param out       Carved views (output).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         plan without a valid alignment; CFGPACK_ERR_BOUNDS if the regions
+ *         do not fit in @p arena_len at the buffer's alignment.
+ */
+cfgpack_err_t cfgpack_plan_carve(const cfgpack_plan_t *plan,
+                                 void *arena,
+                                 size_t arena_len,
+                                 cfgpack_arena_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGPACK_PLAN_H */
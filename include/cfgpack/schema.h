@@ -11,13 +11,32 @@
  */
 
 #include "error.h"
+#include "msgpack.h"
 #include "value.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
-/** Sentinel: entry is not a string type (no pool slot). */
-#define CFGPACK_STR_SLOT_NONE UINT8_MAX
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** First word of a precompiled schema image ("CPSI" little-endian). */
+#define CFGPACK_SCHEMA_IMAGE_MAGIC 0x49535043u
+
+/** Required alignment of a schema image in memory or flash. */
+#define CFGPACK_SCHEMA_IMAGE_ALIGN 8u
+
+/** First word of a schema family image ("CPSF" little-endian). */
+#define CFGPACK_SCHEMA_FAMILY_MAGIC 0x46535043u
+
+/** Upper bound on the variants of a schema family image. */
+#ifndef CFGPACK_SCHEMA_FAMILY_MAX
+  #define CFGPACK_SCHEMA_FAMILY_MAX 64
+#endif
+
+/** Bytes for a variant name in a family image, including the NUL. */
+#define CFGPACK_SCHEMA_FAMILY_NAME 32
 
 /**
  * @brief Single entry within a schema.
@@ -25,15 +44,42 @@
  * @note Entry names are limited to 5 characters (stored as char[6] with NUL
  *       terminator). This keeps the struct compact for embedded use. Schemas
  *       with longer names will fail to parse with CFGPACK_ERR_PARSE.
+ *
+ * @note str_max is the declared maximum length of a str/fstr entry (e.g.
+ *       "str:16" in a schema).  0 means the type maximum (CFGPACK_STR_MAX
+ *       or CFGPACK_FSTR_MAX); non-string entries must leave it 0.  The
+ *       field was added after the first release: code that builds entries
+ *       by hand must zero it (or the whole entry), since cfgpack_init()
+ *       rejects a value above the type maximum with CFGPACK_ERR_BOUNDS
+ *       and a nonzero value on a non-string entry with
+ *       CFGPACK_ERR_INVALID_TYPE.  The parsers always set it.
  */
 typedef struct {
     uint16_t index;
     char name[6]; /* 5 chars + null */
     cfgpack_type_t type;
     uint8_t has_default; /* 1 if default value exists, 0 otherwise */
-    uint8_t str_slot;    /* string pool slot index, or CFGPACK_STR_SLOT_NONE */
+    cfgpack_str_slot_t str_slot; /* pool slot, or CFGPACK_STR_SLOT_NONE */
+    uint8_t str_max;     /* declared max string length, 0 = type maximum */
 } cfgpack_entry_t;
 
+/**
+ * @brief Maximum string length an entry can hold.
+ *
+ * @param e Schema entry.
+ * @return The declared str_max, the type maximum if none was declared, or
+ *         0 for non-string entries.  The entry's pool slot is this plus 1.
+ */
+static inline size_t cfgpack_entry_str_max(const cfgpack_entry_t *e) {
+    if (e->type == CFGPACK_TYPE_STR) {
+        return (e->str_max ? e->str_max : CFGPACK_STR_MAX);
+    }
+    if (e->type == CFGPACK_TYPE_FSTR) {
+        return (e->str_max ? e->str_max : CFGPACK_FSTR_MAX);
+    }
+    return (0);
+}
+
 /**
  * @brief Parsed schema containing metadata and entries.
  */
@@ -62,6 +108,9 @@ typedef struct {
     size_t str_pool_size; /**< Total bytes needed for string pool */
     size_t str_count;     /**< Number of str-type entries */
     size_t fstr_count;    /**< Number of fstr-type entries */
+    size_t index_table_size; /**< Bytes for cfgpack_index_table_init(),
+                                  or 0 if the schema is too sparse */
+    size_t blob_max;         /**< Upper bound of a cfgpack_pageout() blob */
 } cfgpack_schema_sizing_t;
 
 /**
@@ -79,7 +128,7 @@ typedef struct {
  *   cfgpack_entry_t *entries = malloc(m.entry_count * sizeof(*entries));
  *   cfgpack_value_t *values  = malloc(m.entry_count * sizeof(*values));
  *   char     *str_pool    = m.str_pool_size > 0 ? malloc(m.str_pool_size) : NULL;
- *   uint16_t *str_offsets = (m.str_count + m.fstr_count) > 0
+ *   cfgpack_str_off_t *str_offsets = (m.str_count + m.fstr_count) > 0
  *       ? malloc((m.str_count + m.fstr_count) * sizeof(*str_offsets)) : NULL;
  *
  *   cfgpack_parse_opts_t opts = {&schema, entries, m.entry_count, values,
@@ -93,6 +142,9 @@ typedef struct {
     size_t str_pool_size; /**< Total bytes needed for string pool */
     size_t str_count;     /**< Number of str-type entries */
     size_t fstr_count;    /**< Number of fstr-type entries */
+    size_t index_table_size; /**< Bytes for cfgpack_index_table_init(),
+                                  or 0 if the schema is too sparse */
+    size_t blob_max;         /**< Upper bound of a cfgpack_pageout() blob */
 } cfgpack_schema_measure_t;
 
 /**
@@ -109,7 +161,7 @@ typedef struct {
     cfgpack_value_t *values;
     char *str_pool;
     size_t str_pool_cap;
-    uint16_t *str_offsets;
+    cfgpack_str_off_t *str_offsets;
     size_t str_offsets_count;
     cfgpack_parse_error_t *err;
 } cfgpack_parse_opts_t;
@@ -127,6 +179,33 @@ typedef struct {
 cfgpack_err_t cfgpack_schema_get_sizing(const cfgpack_schema_t *schema,
                                         cfgpack_schema_sizing_t *out);
 
+/**
+ * @brief Hash of a schema's layout, for detecting drift between builds.
+ *
+ * CRC-32C over the map name, version, and each entry's index, type, name
+ * and (when declared) str_max in entry order.  Defaults are not included,
+ * since changing one does not move any entry.  cfgpack-schema-gen emits
+ * the same value into generated headers as <PREFIX>_SCHEMA_HASH.
+ *
+ * @param schema Parsed or attached schema.
+ * @return The hash.
+ */
+uint32_t cfgpack_schema_hash(const cfgpack_schema_t *schema);
+
+/**
+ * @brief Fingerprint of the value layout a blob depends on.
+ *
+ * 64-bit FNV-1a over the entry count and each entry's index and type in
+ * entry order.  Unlike cfgpack_schema_hash(), names, the version and
+ * string limits are left out: two schemas with equal fingerprints decode
+ * each other's packed blobs (see cfgpack_pageout_packed()) entry for
+ * entry.
+ *
+ * @param schema Parsed or attached schema.
+ * @return The fingerprint.
+ */
+uint64_t cfgpack_schema_fingerprint(const cfgpack_schema_t *schema);
+
 /**
  * @brief Measure buffer requirements for a .map schema without allocating.
  *
@@ -249,6 +328,58 @@ cfgpack_err_t cfgpack_schema_parse_json(const char *data,
                                         size_t data_len,
                                         const cfgpack_parse_opts_t *opts);
 
+/**
+ * @brief Encode a context's present values as a JSON object keyed by name.
+ *
+ * Writes one compact object straight from the context, without the schema
+ * fields of cfgpack_schema_write_json() and without a msgpack pass:
+ *
+ *   {"port":8080,"host":"example.org","gain":1.5}
+ *
+ * Members follow schema entry order; absent entries are left out.  Strings
+ * are escaped and numbers formatted as by cfgpack_schema_write_json().
+ * Pass @p out NULL and @p out_cap 0 to measure.
+ *
+ * @param ctx      Initialized context.
+ * @param out      Output buffer for JSON (may be NULL if @p out_cap is 0).
+ * @param out_cap  Capacity of @p out in bytes.
+ * @param out_len  Output: bytes needed (set even if > out_cap).
+ * @param err      Optional error info on failure.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL @p ctx;
+ *         CFGPACK_ERR_BOUNDS if @p out is too small.
+ */
+cfgpack_err_t cfgpack_values_write_json(const cfgpack_ctx_t *ctx,
+                                        char *out,
+                                        size_t out_cap,
+                                        size_t *out_len,
+                                        cfgpack_parse_error_t *err);
+
+/**
+ * @brief Set values from a JSON object keyed by entry name.
+ *
+ * Accepts the format of cfgpack_values_write_json(), with any subset of
+ * the entries in any order.  Each member goes through cfgpack_set() (or
+ * cfgpack_set_str()/cfgpack_set_fstr()), so dirty tracking, notification
+ * and an open transaction see ordinary sets.  The whole document is
+ * validated first: an unknown name, a value of the wrong kind, an integer
+ * outside its type's range or a string over its limit changes nothing.
+ * Only a set refused by the context itself (a full transaction journal)
+ * can stop the second pass part way.
+ *
+ * @param ctx      Initialized context.
+ * @param data     JSON text.
+ * @param data_len Length of @p data in bytes.
+ * @param err      Optional error info on failure.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_PARSE on malformed JSON; CFGPACK_ERR_MISSING for an
+ *         unknown name; CFGPACK_ERR_TYPE_MISMATCH, CFGPACK_ERR_BOUNDS or
+ *         CFGPACK_ERR_STR_TOO_LONG for a value the entry cannot hold.
+ */
+cfgpack_err_t cfgpack_values_parse_json(cfgpack_ctx_t *ctx,
+                                        const char *data,
+                                        size_t data_len,
+                                        cfgpack_parse_error_t *err);
+
 /**
  * @brief Measure buffer requirements for a MessagePack binary schema.
  *
@@ -287,6 +418,85 @@ cfgpack_err_t cfgpack_schema_parse_msgpack(const uint8_t *data,
                                            size_t data_len,
                                            const cfgpack_parse_opts_t *opts);
 
+/**
+ * @brief Parse a MessagePack schema, leaving string defaults in @p data.
+ *
+ * Like cfgpack_schema_parse_msgpack(), but each string default's value
+ * holds its offset into @p data instead of a copy in opts->str_pool, which
+ * is left untouched and may be NULL.  Pass the result to
+ * cfgpack_init_cow() with the same @p data, which must stay unchanged for
+ * the lifetime of the context (e.g. a schema blob in flash).
+ *
+ * @param data     Input buffer containing msgpack data.
+ * @param data_len Length of data in bytes.
+ * @param opts     Parse options containing output buffers and error pointer.
+ * @return As cfgpack_schema_parse_msgpack(); CFGPACK_ERR_BOUNDS if a
+ *         string default lies beyond the range of cfgpack_str_off_t.
+ */
+cfgpack_err_t cfgpack_schema_parse_msgpack_cow(
+    const uint8_t *data,
+    size_t data_len,
+    const cfgpack_parse_opts_t *opts);
+
+/**
+ * @brief Measure a MessagePack schema read from a source through a window.
+ *
+ * Same result as cfgpack_schema_measure_msgpack(), for schemas that are
+ * never held in RAM whole (compressed, or in external flash).  The source
+ * is read once, front to back.
+ *
+ * @param src         Source callback.
+ * @param user        Opaque pointer passed to @p src.
+ * @param len         Stream length, or SIZE_MAX to read until @p src
+ *                    reports the end.
+ * @param window      Window scratch buffer.
+ * @param window_cap  Capacity of @p window (>= CFGPACK_STREAM_WINDOW_MIN).
+ * @param out         Filled with measurement results.
+ * @param err         Optional parse error info on failure.
+ * @return As cfgpack_schema_measure_msgpack(); CFGPACK_ERR_ARGS on NULL
+ *         arguments; CFGPACK_ERR_BOUNDS if @p window_cap is below the
+ *         minimum; the source's error code if it fails.
+ */
+cfgpack_err_t cfgpack_schema_measure_msgpack_stream(
+    cfgpack_source_fn src,
+    void *user,
+    size_t len,
+    uint8_t *window,
+    size_t window_cap,
+    cfgpack_schema_measure_t *out,
+    cfgpack_parse_error_t *err);
+
+/**
+ * @brief Parse a MessagePack schema read from a source through a window.
+ *
+ * Like cfgpack_schema_parse_msgpack(), but in one front-to-back pass:
+ * each default is stored as soon as its entry has been read, so peak RAM
+ * beyond the outputs in @p opts is @p window_cap.  That needs every
+ * string slot known in advance, so entries must appear in strictly
+ * ascending index order with the type before the value, which is how
+ * cfgpack_schema_write_msgpack() and cfgpack-schema-pack emit them.
+ *
+ * @param src         Source callback.
+ * @param user        Opaque pointer passed to @p src.
+ * @param len         Stream length, or SIZE_MAX to read until @p src
+ *                    reports the end.
+ * @param window      Window scratch buffer.
+ * @param window_cap  Capacity of @p window (>= CFGPACK_STREAM_WINDOW_MIN).
+ * @param opts        Parse options containing output buffers and error
+ *                    pointer.
+ * @return As cfgpack_schema_parse_msgpack(); CFGPACK_ERR_DECODE also for
+ *         out-of-order entries; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if @p window_cap is below the minimum; the
+ *         source's error code if it fails.
+ */
+cfgpack_err_t cfgpack_schema_parse_msgpack_stream(
+    cfgpack_source_fn src,
+    void *user,
+    size_t len,
+    uint8_t *window,
+    size_t window_cap,
+    const cfgpack_parse_opts_t *opts);
+
 /**
  * @brief Encode a schema and its current values to MessagePack binary.
  *
@@ -306,4 +516,159 @@ cfgpack_err_t cfgpack_schema_write_msgpack(const cfgpack_ctx_t *ctx,
                                            size_t *out_len,
                                            cfgpack_parse_error_t *err);
 
+/**
+ * @brief Write a precompiled schema image for zero-parse loading.
+ *
+ * The image holds the sorted entry array, the default values, the string
+ * offsets and the default string pool in the in-memory layout of this
+ * build, behind a small header and a CRC-32C trailer.  It is attached with
+ * cfgpack_schema_attach_image(), typically straight from flash.  Because
+ * the layout is native, the image must be written by a build with the same
+ * struct layout as the target (cfgpack-schema-pack --image for targets
+ * whose ABI matches the host, or this function on the target itself);
+ * attaching checks the struct sizes and byte order and rejects a mismatch.
+ *
+ * Values are taken from @p ctx as they are now, so call it right after
+ * parsing and cfgpack_init(), before any cfgpack_set().
+ *
+ * @param ctx      Initialized context containing schema and values.
+ * @param out      Output buffer for the image.
+ * @param out_cap  Capacity of @p out in bytes.
+ * @param out_len  Output: image size (set even when @p out is too small).
+ * @param err      Optional error info on failure.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         cfgpack_init_cow() context;
+ *         CFGPACK_ERR_ENCODE if @p out is too small.
+ */
+cfgpack_err_t cfgpack_schema_write_image(const cfgpack_ctx_t *ctx,
+                                         uint8_t *out,
+                                         size_t out_cap,
+                                         size_t *out_len,
+                                         cfgpack_parse_error_t *err);
+
+/**
+ * @brief Measure buffer requirements for a precompiled schema image.
+ *
+ * Validates the image like cfgpack_schema_attach_image() and reports the
+ * sizes recorded in its header.
+ *
+ * @param image     Image (aligned to CFGPACK_SCHEMA_IMAGE_ALIGN).
+ * @param image_len Length of @p image in bytes.
+ * @param out       Filled with measurement results.
+ * @param err       Optional error info on failure.
+ * @return As cfgpack_schema_attach_image().
+ */
+cfgpack_err_t cfgpack_schema_measure_image(const uint8_t *image,
+                                           size_t image_len,
+                                           cfgpack_schema_measure_t *out,
+                                           cfgpack_parse_error_t *err);
+
+/**
+ * @brief Attach a precompiled schema image without parsing it.
+ *
+ * Points opts->out_schema->entries directly into @p image, so the entry
+ * array is neither parsed, sorted nor copied and may live in XIP flash.
+ * The defaults are copied into opts->values, opts->str_pool and
+ * opts->str_offsets with one memcpy each, since those buffers must be
+ * writable.  opts->entries is unused; opts->max_entries is the capacity of
+ * opts->values.  The image must stay valid for the lifetime of the schema.
+ *
+ * The header, region bounds and CRC are checked, plus a cheap pass over the
+ * entries, so a damaged image is rejected instead of trusted.
+ *
+ * @param image     Image written by cfgpack_schema_write_image() (aligned
+ *                  to CFGPACK_SCHEMA_IMAGE_ALIGN).
+ * @param image_len Length of @p image in bytes.
+ * @param opts      Parse options containing output buffers and error pointer.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         misaligned image; CFGPACK_ERR_DECODE if the image is not a
+ *         schema image, was built for a different ABI or is malformed;
+ *         CFGPACK_ERR_CRC on checksum mismatch; CFGPACK_ERR_BOUNDS if a
+ *         buffer in @p opts is too small.
+ */
+cfgpack_err_t cfgpack_schema_attach_image(const uint8_t *image,
+                                          size_t image_len,
+                                          const cfgpack_parse_opts_t *opts);
+
+/**
+ * @brief Write one image for a family of related schemas.
+ *
+ * An entry (index, name, type, limits and default) that most variants
+ * define identically goes once into a shared table; each variant then
+ * stores a bitmap of the shared entries it lacks or redefines, and its own
+ * entries.  String defaults are stored once per distinct entry.  Like
+ * cfgpack_schema_write_image() the layout is native, and values are taken
+ * from each context as they are now, so call it right after parsing and
+ * cfgpack_init().
+ *
+ * @param ctxs    Initialized context of each variant.
+ * @param names   Name of each variant, unique and shorter than
+ *                CFGPACK_SCHEMA_FAMILY_NAME.
+ * @param count   Number of variants, 1..CFGPACK_SCHEMA_FAMILY_MAX.
+ * @param out     Output buffer for the image.
+ * @param out_cap Capacity of @p out in bytes.
+ * @param out_len Output: image size (set even when @p out is too small).
+ * @param err     Optional error info on failure.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments, a bad
+ *         @p count, a cfgpack_init_cow() context, or an empty, long or
+ *         repeated name; CFGPACK_ERR_ENCODE if @p out is too small or the
+ *         string defaults exceed CFGPACK_STR_OFF_MAX bytes.
+ */
+cfgpack_err_t cfgpack_schema_write_family(const cfgpack_ctx_t *const *ctxs,
+                                          const char *const *names,
+                                          size_t count,
+                                          uint8_t *out,
+                                          size_t out_cap,
+                                          size_t *out_len,
+                                          cfgpack_parse_error_t *err);
+
+/**
+ * @brief Measure buffer requirements for one variant of a family image.
+ *
+ * @param image     Image from cfgpack_schema_write_family() (aligned to
+ *                  CFGPACK_SCHEMA_IMAGE_ALIGN).
+ * @param image_len Length of @p image in bytes.
+ * @param variant   Variant name.
+ * @param out       Filled with measurement results.
+ * @param err       Optional error info on failure.
+ * @return As cfgpack_schema_attach_family().
+ */
+cfgpack_err_t cfgpack_schema_measure_family(const uint8_t *image,
+                                            size_t image_len,
+                                            const char *variant,
+                                            cfgpack_schema_measure_t *out,
+                                            cfgpack_parse_error_t *err);
+
+/**
+ * @brief Load one variant of a family image without parsing.
+ *
+ * Merges the shared entries the variant keeps with its own, both already
+ * sorted, into opts->entries and opts->values, lays out the string pool
+ * and copies the string defaults into it.  Nothing is parsed or sorted.
+ * Unlike cfgpack_schema_attach_image() the entries are copied, since each
+ * variant's array differs, so opts->entries must hold
+ * cfgpack_schema_measure_family()'s entry_count.  The image may be freed
+ * afterwards.
+ *
+ * @param image     Image from cfgpack_schema_write_family() (aligned to
+ *                  CFGPACK_SCHEMA_IMAGE_ALIGN).
+ * @param image_len Length of @p image in bytes.
+ * @param variant   Variant name.
+ * @param opts      Parse options containing output buffers and error pointer.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         misaligned image; CFGPACK_ERR_MISSING if @p variant is not in
+ *         the image; CFGPACK_ERR_DECODE if the image is not a family
+ *         image, was built for a different ABI or is malformed;
+ *         CFGPACK_ERR_CRC on checksum mismatch; CFGPACK_ERR_BOUNDS if a
+ *         buffer in @p opts is too small.
+ */
+cfgpack_err_t cfgpack_schema_attach_family(const uint8_t *image,
+                                           size_t image_len,
+                                           const char *variant,
+                                           const cfgpack_parse_opts_t *opts);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* CFGPACK_SCHEMA_H */
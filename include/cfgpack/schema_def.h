@@ -0,0 +1,293 @@
+/**
+ * @file schema_def.h
+ * @brief Compile-time schema definition with X-macros.
+ *
+ * A schema that is fixed in firmware can be written as a list macro and
+ * turned into tables at compile time, without a schema file, a parse at
+ * boot or cfgpack-schema-gen in the build.  Each row is one entry:
+ *
+ *   V(index, name, TYPE, value)        numeric entry with a default
+ *   N(index, name, TYPE, str_max)      entry without a default (NIL)
+ *   S(index, name, TYPE, str_max, "")  str/fstr entry with a default
+ *
+ * TYPE is the suffix of a cfgpack_type_t (U8 ... F64, STR, FSTR) and
+ * str_max is the declared maximum string length, 0 for the type maximum
+ * (and always 0 for numeric entries).  Rows go in ascending index order.
+ * The list is instantiated by defining its parameters and including this
+ * header, once per schema:
+ *
+ * @code
+ *   #define DEMO_SCHEMA(V, N, S)        \
+ *       V(1, rate, U16, 100)            \
+ *       S(2, host, STR, 32, "gateway")  \
+ *       N(3, gain, F32, 0)
+ *
+ *   #define CFGPACK_SCHEMA_LIST    DEMO_SCHEMA
+ *   #define CFGPACK_SCHEMA_PREFIX  demo
+ *   #define CFGPACK_SCHEMA_UPPER   DEMO
+ *   #define CFGPACK_SCHEMA_NAME    "demo"
+ *   #define CFGPACK_SCHEMA_VERSION 1
+ *   #include "cfgpack/schema_def.h"
+ *
+ *   cfgpack_value_t values[DEMO_ENTRY_COUNT];
+ *   char str_pool[DEMO_STR_POOL_SIZE];
+ *   cfgpack_str_off_t str_offsets[DEMO_STR_COUNT];
+ *
+ *   demo_init(&ctx, &schema, values, str_pool, str_offsets);
+ *   cfgpack_set_u16(&ctx, DEMO_IDX_rate, 250);
+ * @endcode
+ *
+ * This produces the same names as a cfgpack-schema-gen header, except that
+ * entry names keep their case: DEMO_IDX_<name>, DEMO_POS_<name> and (for
+ * strings) DEMO_POOL_<name> enumerators, DEMO_ENTRY_COUNT, DEMO_STR_COUNT
+ * and DEMO_STR_POOL_SIZE, the demo_entries[] and demo_defaults[] tables,
+ * and demo_init().  String slots and pool offsets are assigned in entry
+ * order, exactly as cfgpack_init() assigns them, so the const entry table
+ * is never written and stays in flash.
+ *
+ * Mistakes in the list fail the build: indices that are zero, above
+ * 0xFFFF, repeated or out of order; more than CFGPACK_MAX_ENTRIES or
+ * CFGPACK_STR_SLOT_NONE strings; names over 5 characters; a string type
+ * in a V row or a numeric type in an S row; and a str_max or string
+ * default above the type maximum.  A repeated name is a redeclared
+ * enumerator.
+ */
+
+#ifndef CFGPACK_SCHEMA_DEF_H
+#define CFGPACK_SCHEMA_DEF_H
+
+#include "api.h"
+#include "schema.h"
+#include "value.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers (everything below is internal to this header)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define CFGPACK_SD_CAT_(a, b) a##b
+#define CFGPACK_SD_CAT(a, b)  CFGPACK_SD_CAT_(a, b)
+#define CFGPACK_SD_LO(s)      CFGPACK_SD_CAT(CFGPACK_SCHEMA_PREFIX, s)
+#define CFGPACK_SD_UP(s)      CFGPACK_SD_CAT(CFGPACK_SCHEMA_UPPER, s)
+
+#if defined(__cplusplus) && __cplusplus >= 201103L
+  #define CFGPACK_SD_ASSERT(cond, tag, msg) static_assert(cond, msg)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+  #define CFGPACK_SD_ASSERT(cond, tag, msg) _Static_assert(cond, msg)
+#else
+  #define CFGPACK_SD_ASSERT(cond, tag, msg) \
+      typedef char tag[(cond) ? 1 : -1]
+#endif
+
+/* Rows reduce to one form, ROW(kind, index, name, TYPE, str_max, value,
+ * text): kind 0 is V, 1 is N and 2 is S.  Each pass below redefines
+ * CFGPACK_SD_ROW and expands the list once. */
+#define CFGPACK_SD_V(i, n, T, v)    CFGPACK_SD_ROW(0, i, n, T, 0, v, "")
+#define CFGPACK_SD_N(i, n, T, m)    CFGPACK_SD_ROW(1, i, n, T, m, 0, "")
+#define CFGPACK_SD_S(i, n, T, m, s) CFGPACK_SD_ROW(2, i, n, T, m, 0, s)
+#define CFGPACK_SD_EACH \
+    CFGPACK_SCHEMA_LIST(CFGPACK_SD_V, CFGPACK_SD_N, CFGPACK_SD_S)
+
+#define CFGPACK_SD_DEF_0 1
+#define CFGPACK_SD_DEF_1 0
+#define CFGPACK_SD_DEF_2 1
+#define CFGPACK_SD_DEF(k) CFGPACK_SD_DEF_##k
+
+#define CFGPACK_SD_IS_STR_U8   0
+#define CFGPACK_SD_IS_STR_U16  0
+#define CFGPACK_SD_IS_STR_U32  0
+#define CFGPACK_SD_IS_STR_U64  0
+#define CFGPACK_SD_IS_STR_I8   0
+#define CFGPACK_SD_IS_STR_I16  0
+#define CFGPACK_SD_IS_STR_I32  0
+#define CFGPACK_SD_IS_STR_I64  0
+#define CFGPACK_SD_IS_STR_F32  0
+#define CFGPACK_SD_IS_STR_F64  0
+#define CFGPACK_SD_IS_STR_STR  1
+#define CFGPACK_SD_IS_STR_FSTR 1
+#define CFGPACK_SD_IS_STR(T)   CFGPACK_SD_IS_STR_##T
+
+/* Type maximum string length, 0 for numeric types */
+#define CFGPACK_SD_TMAX_U8   0
+#define CFGPACK_SD_TMAX_U16  0
+#define CFGPACK_SD_TMAX_U32  0
+#define CFGPACK_SD_TMAX_U64  0
+#define CFGPACK_SD_TMAX_I8   0
+#define CFGPACK_SD_TMAX_I16  0
+#define CFGPACK_SD_TMAX_I32  0
+#define CFGPACK_SD_TMAX_I64  0
+#define CFGPACK_SD_TMAX_F32  0
+#define CFGPACK_SD_TMAX_F64  0
+#define CFGPACK_SD_TMAX_STR  CFGPACK_STR_MAX
+#define CFGPACK_SD_TMAX_FSTR CFGPACK_FSTR_MAX
+#define CFGPACK_SD_TMAX(T)   CFGPACK_SD_TMAX_##T
+
+/* As cfgpack_entry_str_max(), and the pool bytes the entry takes */
+#define CFGPACK_SD_STR_MAX(T, m) ((m) ? (m) : CFGPACK_SD_TMAX(T))
+#define CFGPACK_SD_POOL_BYTES(T, m) \
+    (CFGPACK_SD_IS_STR(T) * (CFGPACK_SD_STR_MAX(T, m) + 1))
+
+/* Value union member for a default: INIT_<T>(value, pool offset, len) */
+#define CFGPACK_SD_INIT_U8(x, o, l)   .v.u64 = (x)
+#define CFGPACK_SD_INIT_U16(x, o, l)  .v.u64 = (x)
+#define CFGPACK_SD_INIT_U32(x, o, l)  .v.u64 = (x)
+#define CFGPACK_SD_INIT_U64(x, o, l)  .v.u64 = (x)
+#define CFGPACK_SD_INIT_I8(x, o, l)   .v.i64 = (x)
+#define CFGPACK_SD_INIT_I16(x, o, l)  .v.i64 = (x)
+#define CFGPACK_SD_INIT_I32(x, o, l)  .v.i64 = (x)
+#define CFGPACK_SD_INIT_I64(x, o, l)  .v.i64 = (x)
+#define CFGPACK_SD_INIT_F32(x, o, l)  .v.f32 = (x)
+#define CFGPACK_SD_INIT_F64(x, o, l)  .v.f64 = (x)
+#define CFGPACK_SD_INIT_STR(x, o, l)  .v.str = {(o), (l)}
+#define CFGPACK_SD_INIT_FSTR(x, o, l) .v.fstr = {(o), (l), 0}
+#define CFGPACK_SD_INIT(T, x, o, l)   CFGPACK_SD_INIT_##T(x, o, l)
+
+/* String defaults are copied into the pool by <prefix>_init() */
+#define CFGPACK_SD_FILL_0(o, s)
+#define CFGPACK_SD_FILL_1(o, s)
+#define CFGPACK_SD_FILL_2(o, s) memcpy(str_pool + (o), s, sizeof(s));
+#define CFGPACK_SD_FILL(k, o, s) CFGPACK_SD_FILL_##k(o, s)
+
+#endif /* CFGPACK_SCHEMA_DEF_H */
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Instantiation (runs on every inclusion)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#if !defined(CFGPACK_SCHEMA_LIST) || !defined(CFGPACK_SCHEMA_PREFIX) || \
+    !defined(CFGPACK_SCHEMA_UPPER) || !defined(CFGPACK_SCHEMA_NAME) ||  \
+    !defined(CFGPACK_SCHEMA_VERSION)
+  #error "define CFGPACK_SCHEMA_LIST, _PREFIX, _UPPER, _NAME and _VERSION"
+#endif
+
+/* Wire indices */
+#define CFGPACK_SD_ROW(k, i, n, T, m, v, s) CFGPACK_SD_UP(_IDX_##n) = (i),
+enum { CFGPACK_SD_EACH };
+#undef CFGPACK_SD_ROW
+
+/* Offsets into the entry and value arrays */
+#define CFGPACK_SD_ROW(k, i, n, T, m, v, s) CFGPACK_SD_UP(_POS_##n),
+enum { CFGPACK_SD_EACH CFGPACK_SD_UP(_ENTRY_COUNT) };
+#undef CFGPACK_SD_ROW
+
+/* Each NEXT_<name> is one past the previous entry's index */
+#define CFGPACK_SD_ROW(k, i, n, T, m, v, s) \
+    CFGPACK_SD_UP(_SD_NEXT_##n), CFGPACK_SD_UP(_SD_ORD_##n) = (i),
+enum {
+    CFGPACK_SD_UP(_SD_ORD0) = 0,
+    CFGPACK_SD_EACH
+};
+#undef CFGPACK_SD_ROW
+
+/* Running string count: SA_<name> - 1 strings come before the entry */
+#define CFGPACK_SD_ROW(k, i, n, T, m, v, s) \
+    CFGPACK_SD_UP(_SD_SA_##n),              \
+        CFGPACK_SD_UP(_SD_SB_##n) =         \
+            CFGPACK_SD_UP(_SD_SA_##n) - 1 + CFGPACK_SD_IS_STR(T),
+enum {
+    CFGPACK_SD_UP(_SD_SLOT0) = 0,
+    CFGPACK_SD_EACH CFGPACK_SD_UP(_SD_SLOT_END)
+};
+#undef CFGPACK_SD_ROW
+
+/* String pool offsets (as computed by cfgpack_init()) */
+#define CFGPACK_SD_ROW(k, i, n, T, m, v, s)                       \
+    CFGPACK_SD_UP(_SD_PA_##n),                                    \
+        CFGPACK_SD_UP(_POOL_##n) = CFGPACK_SD_UP(_SD_PA_##n) - 1, \
+        CFGPACK_SD_UP(_SD_PB_##n) =                               \
+            CFGPACK_SD_UP(_POOL_##n) + CFGPACK_SD_POOL_BYTES(T, m),
+enum {
+    CFGPACK_SD_UP(_SD_POOL0) = 0,
+    CFGPACK_SD_EACH CFGPACK_SD_UP(_SD_POOL_END)
+};
+#undef CFGPACK_SD_ROW
+
+enum {
+    CFGPACK_SD_UP(_STR_COUNT) = CFGPACK_SD_UP(_SD_SLOT_END) - 1,
+    CFGPACK_SD_UP(_STR_POOL_SIZE) = CFGPACK_SD_UP(_SD_POOL_END) - 1
+};
+
+#define CFGPACK_SD_ROW(k, i, n, T, m, v, s)                                \
+    CFGPACK_SD_ASSERT((i) >= CFGPACK_SD_UP(_SD_NEXT_##n) && (i) <= 0xFFFF, \
+                      CFGPACK_SD_LO(_sd_order_##n),                        \
+                      "cfgpack schema: index out of order or range");      \
+    CFGPACK_SD_ASSERT(sizeof(#n) <= sizeof(((cfgpack_entry_t *)0)->name),  \
+                      CFGPACK_SD_LO(_sd_name_##n),                         \
+                      "cfgpack schema: name over 5 characters");           \
+    CFGPACK_SD_ASSERT((k) == 1 || ((k) == 2) == CFGPACK_SD_IS_STR(T),      \
+                      CFGPACK_SD_LO(_sd_kind_##n),                         \
+                      "cfgpack schema: S rows are for str and fstr");      \
+    CFGPACK_SD_ASSERT(CFGPACK_SD_IS_STR(T) ? (m) <= CFGPACK_SD_TMAX(T)     \
+                                           : (m) == 0,                     \
+                      CFGPACK_SD_LO(_sd_max_##n),                          \
+                      "cfgpack schema: str_max out of range");             \
+    CFGPACK_SD_ASSERT(sizeof(s) - 1 <= CFGPACK_SD_STR_MAX(T, m),           \
+                      CFGPACK_SD_LO(_sd_len_##n),                          \
+                      "cfgpack schema: string default too long");
+CFGPACK_SD_EACH
+#undef CFGPACK_SD_ROW
+
+CFGPACK_SD_ASSERT(CFGPACK_SD_UP(_ENTRY_COUNT) <= CFGPACK_MAX_ENTRIES,
+                  CFGPACK_SD_LO(_sd_entry_cap),
+                  "cfgpack schema: more than CFGPACK_MAX_ENTRIES entries");
+CFGPACK_SD_ASSERT(CFGPACK_SD_UP(_STR_COUNT) < CFGPACK_STR_SLOT_NONE,
+                  CFGPACK_SD_LO(_sd_str_cap),
+                  "cfgpack schema: too many string entries");
+CFGPACK_SD_ASSERT(sizeof(CFGPACK_SCHEMA_NAME) <=
+                      sizeof(((cfgpack_schema_t *)0)->map_name),
+                  CFGPACK_SD_LO(_sd_map_name),
+                  "cfgpack schema: map name too long");
+
+#define CFGPACK_SD_ROW(k, i, n, T, m, v, s)             \
+    {(i),                                               \
+     #n,                                                \
+     CFGPACK_TYPE_##T,                                  \
+     CFGPACK_SD_DEF(k),                                 \
+     CFGPACK_SD_IS_STR(T)                               \
+         ? (cfgpack_str_slot_t)(CFGPACK_SD_UP(_SD_SA_##n) - 1) \
+         : CFGPACK_STR_SLOT_NONE,                       \
+     (m)},
+static const cfgpack_entry_t CFGPACK_SD_LO(_entries)[] = {
+    CFGPACK_SD_EACH};
+#undef CFGPACK_SD_ROW
+
+/* NIL strings leave their offset 0, as the schema parser does */
+#define CFGPACK_SD_ROW(k, i, n, T, m, v, s)                              \
+    {.type = CFGPACK_TYPE_##T,                                           \
+     CFGPACK_SD_INIT(T, v, CFGPACK_SD_DEF(k) ? CFGPACK_SD_UP(_POOL_##n) : 0, \
+                     sizeof(s) - 1)},
+static const cfgpack_value_t CFGPACK_SD_LO(_defaults)[] = {
+    CFGPACK_SD_EACH};
+#undef CFGPACK_SD_ROW
+
+/**
+ * @brief Set up @p ctx for the compiled-in schema (no parsing).
+ *
+ * @p schema must outlive @p ctx.  Buffers must hold <UPPER>_ENTRY_COUNT
+ * values, <UPPER>_STR_POOL_SIZE pool bytes and <UPPER>_STR_COUNT offsets.
+ */
+#define CFGPACK_SD_ROW(k, i, n, T, m, v, s) \
+    CFGPACK_SD_FILL(k, CFGPACK_SD_UP(_POOL_##n), s)
+static inline cfgpack_err_t CFGPACK_SD_LO(_init)(
+    cfgpack_ctx_t *ctx, cfgpack_schema_t *schema, cfgpack_value_t *values,
+    char *str_pool, cfgpack_str_off_t *str_offsets) {
+    memcpy(schema->map_name, CFGPACK_SCHEMA_NAME, sizeof(CFGPACK_SCHEMA_NAME));
+    schema->version = CFGPACK_SCHEMA_VERSION;
+    /* Entries are never written, so they stay in flash */
+    schema->entries = (cfgpack_entry_t *)(uintptr_t)CFGPACK_SD_LO(_entries);
+    schema->entry_count = CFGPACK_SD_UP(_ENTRY_COUNT);
+    memcpy(values, CFGPACK_SD_LO(_defaults), sizeof(CFGPACK_SD_LO(_defaults)));
+    CFGPACK_SD_EACH
+    return (cfgpack_init(ctx, schema, values, CFGPACK_SD_UP(_ENTRY_COUNT),
+                         str_pool, CFGPACK_SD_UP(_STR_POOL_SIZE), str_offsets,
+                         CFGPACK_SD_UP(_STR_COUNT)));
+}
+#undef CFGPACK_SD_ROW
+
+#undef CFGPACK_SCHEMA_LIST
+#undef CFGPACK_SCHEMA_PREFIX
+#undef CFGPACK_SCHEMA_UPPER
+#undef CFGPACK_SCHEMA_NAME
+#undef CFGPACK_SCHEMA_VERSION
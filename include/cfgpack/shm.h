@@ -0,0 +1,244 @@
+#ifndef CFGPACK_SHM_H
+#define CFGPACK_SHM_H
+
+/**
+ * @file shm.h
+ * @brief Published context in shared memory for multi-process readers
+ *        (hosted only).
+ *
+ * One process, the publisher, keeps an ordinary context and copies it into
+ * a shared segment with cfgpack_shm_publish() after each change.  Any
+ * number of other processes attach the segment read-only and read values
+ * in place: no file read, no decode and no schema parse per process, and
+ * one copy of the config in memory.
+ *
+ * The segment holds a cfgpack_shm_hdr_t followed by the schema entries,
+ * the values array, the presence bitmap, the string offsets and the string
+ * pool, in the native layout of the publishing build.  Regions are located
+ * by byte offsets from the segment start and values refer to strings by
+ * pool offset, so each process may map the segment at its own address.
+ *
+ * The header's @c seq counter follows the CFGPACK_SEQLOCK protocol: it is
+ * odd while a publish is on, and readers retry a read that overlapped one.
+ * Publishes must be serialized among themselves.  The counter lives in the
+ * segment, so this works whether or not the build defines CFGPACK_SEQLOCK.
+ *
+ * To use these functions, compile src/shm.c with hosted flags (and link
+ * with -lrt on glibc before 2.34).  This header is not pulled in by
+ * cfgpack.h.
+ */
+
+#include "api.h"
+#include "error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Segment magic, "CPSH" read as a little-endian u32. */
+#define CFGPACK_SHM_MAGIC 0x48535043u
+
+/** Attempts a reader makes before returning CFGPACK_ERR_BUSY. */
+#ifndef CFGPACK_SHM_RETRIES
+  #define CFGPACK_SHM_RETRIES 1024
+#endif
+
+/**
+ * @brief Segment header, at offset 0 of the segment.
+ *
+ * All fields but @c seq change only inside a publish.
+ */
+typedef struct {
+    uint32_t magic;         /**< CFGPACK_SHM_MAGIC once laid out */
+    uint32_t layout;        /**< Struct sizes of the publishing build */
+    volatile uint32_t seq;  /**< Publish counter; odd while one is on */
+    uint32_t version;       /**< Schema version */
+    uint64_t fingerprint;   /**< cfgpack_schema_fingerprint() */
+    uint32_t hash;          /**< cfgpack_schema_hash() */
+    uint32_t entry_count;   /**< Schema entries and value slots */
+    uint32_t str_count;     /**< String offset slots */
+    uint32_t pool_bytes;    /**< String pool bytes */
+    uint32_t entries_off;   /**< Offset of the cfgpack_entry_t array */
+    uint32_t values_off;    /**< Offset of the cfgpack_value_t array */
+    uint32_t present_off;   /**< Offset of the presence bitmap */
+    uint32_t offsets_off;   /**< Offset of the string offsets */
+    uint32_t pool_off;      /**< Offset of the string pool */
+    uint32_t size;          /**< Bytes used from the segment start */
+    char map_name[64];      /**< Schema name */
+} cfgpack_shm_hdr_t;
+
+/**
+ * @brief A reader's view of a segment, set up by cfgpack_shm_attach().
+ *
+ * @c ctx points into the segment and at @c schema, so the reader must not
+ * be copied or moved after attaching.  @c ctx is only valid inside a
+ * cfgpack_shm_read() callback.
+ */
+typedef struct {
+    const cfgpack_shm_hdr_t *hdr; /**< Attached segment */
+    size_t len;                   /**< Mapped bytes of the segment */
+    uint64_t fingerprint;         /**< Header fingerprint at attach */
+    uint32_t hash;                /**< Header schema hash at attach */
+    cfgpack_schema_t schema;      /**< Schema with entries in the segment */
+    cfgpack_ctx_t ctx;            /**< Read-only view of the values */
+} cfgpack_shm_reader_t;
+
+/**
+ * @brief One read attempt for cfgpack_shm_read().
+ *
+ * May run while a publish rewrites the segment; its result counts only if
+ * none overlapped it, so it should only copy values out.
+ */
+typedef cfgpack_err_t (*cfgpack_shm_read_fn)(const cfgpack_ctx_t *ctx,
+                                             void *user);
+
+/**
+ * @brief Segment size cfgpack_shm_publish() needs for @p ctx.
+ * @param ctx Initialized context.
+ * @return Size in bytes, or 0 if @p ctx is NULL or uses packed storage.
+ */
+size_t cfgpack_shm_size(const cfgpack_ctx_t *ctx);
+
+/**
+ * @brief Copy the context into a shared segment.
+ *
+ * The first publish, or one after the schema changed, lays out the header
+ * and the schema; later ones copy only the values, presence and strings.
+ * Either way the copy is one write section of the segment counter, so
+ * readers see the old state or the new one, never a mix.  Pending lazy
+ * entries are resolved first.  Dirty bits are left as they are.
+ *
+ * @param ctx Initialized context.
+ * @param seg Writable segment, aligned to 8 bytes.
+ * @param cap Size of @p seg in bytes.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments, a
+ *         misaligned segment or a packed context; CFGPACK_ERR_ENCODE if
+ *         @p cap is below cfgpack_shm_size(); a lazy decode error.
+ */
+cfgpack_err_t cfgpack_shm_publish(cfgpack_ctx_t *ctx, void *seg, size_t cap);
+
+/**
+ * @brief Attach a reader to a published segment.
+ *
+ * Checks the header against this build's struct sizes and the region
+ * bounds against @p len, and the schema in the segment against its
+ * fingerprint and hash.  Nothing in the segment is written, so it may be
+ * mapped read-only.
+ *
+ * @param r   Reader to set up.
+ * @param seg Segment, aligned to 8 bytes.
+ * @param len Mapped bytes of @p seg.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         misaligned segment; CFGPACK_ERR_MISSING if nothing was published
+ *         yet; CFGPACK_ERR_DECODE if the segment was written by a build
+ *         with another layout or is malformed; CFGPACK_ERR_BUSY if every
+ *         attempt overlapped a publish.
+ */
+cfgpack_err_t cfgpack_shm_attach(cfgpack_shm_reader_t *r,
+                                 const void *seg,
+                                 size_t len);
+
+/**
+ * @brief Run @p fn on the segment's current state without a lock.
+ *
+ * @p fn gets the reader's view context and may call any cfgpack_get*()
+ * function on it.  It is run again while a publish overlapped it, up to
+ * CFGPACK_SHM_RETRIES times.
+ *
+ * @param r    Attached reader.
+ * @param fn   Read attempt.
+ * @param user Passed through to @p fn.
+ * @return The result of the last clean run of @p fn; CFGPACK_ERR_ARGS on
+ *         NULL arguments; CFGPACK_ERR_TYPE_MISMATCH if the publisher's
+ *         schema changed since attaching (attach again);
+ *         CFGPACK_ERR_BUSY if every attempt overlapped a publish.
+ */
+cfgpack_err_t cfgpack_shm_read(cfgpack_shm_reader_t *r,
+                               cfgpack_shm_read_fn fn,
+                               void *user);
+
+/**
+ * @brief Get one value consistently.  @see cfgpack_shm_read
+ *
+ * Strings come back as pool offsets that a later publish may reuse; read
+ * them with cfgpack_shm_get_str().
+ */
+cfgpack_err_t cfgpack_shm_get(cfgpack_shm_reader_t *r,
+                              uint16_t index,
+                              cfgpack_value_t *out);
+
+/**
+ * @brief Copy a `str` or `fstr` value out consistently.
+ *
+ * @param r     Attached reader.
+ * @param index Schema index of a string entry.
+ * @param buf   Receives the string and a NUL terminator.
+ * @param cap   Capacity of @p buf in bytes.
+ * @param len   Optional; receives the string length.
+ * @return As cfgpack_get_str_view(); CFGPACK_ERR_STR_TOO_LONG if the
+ *         string and its terminator do not fit in @p cap; the errors of
+ *         cfgpack_shm_read().
+ */
+cfgpack_err_t cfgpack_shm_get_str(cfgpack_shm_reader_t *r,
+                                  uint16_t index,
+                                  char *buf,
+                                  size_t cap,
+                                  size_t *len);
+
+/**
+ * @brief Publish counter of the reader's segment.
+ *
+ * Grows by 2 per publish, so a reader can poll it to learn that values
+ * changed without reading them.
+ *
+ * @param r Attached reader.
+ * @return Counter value; odd while a publish is on.
+ */
+uint32_t cfgpack_shm_seq(const cfgpack_shm_reader_t *r);
+
+/**
+ * @brief Create (or open) a POSIX shared memory object for publishing.
+ *
+ * Opens @p name read-write with shm_open(), creating it if needed, sizes
+ * it to @p size bytes and maps it shared.
+ *
+ * @param name Object name, starting with '/'.
+ * @param size Segment size, normally cfgpack_shm_size().
+ * @param seg  Receives the mapping.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         zero @p size; CFGPACK_ERR_IO if the object cannot be created,
+ *         sized or mapped.
+ */
+cfgpack_err_t cfgpack_shm_create(const char *name, size_t size, void **seg);
+
+/**
+ * @brief Map an existing POSIX shared memory object read-only.
+ *
+ * @param name Object name passed to cfgpack_shm_create().
+ * @param seg  Receives the mapping.
+ * @param len  Receives its size.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_IO if the object cannot be opened or mapped.
+ */
+cfgpack_err_t cfgpack_shm_map(const char *name,
+                              const void **seg,
+                              size_t *len);
+
+/**
+ * @brief Unmap a segment from cfgpack_shm_create() or cfgpack_shm_map().
+ *
+ * The object itself stays until shm_unlink().
+ *
+ * @param seg Mapping.
+ * @param len Its size.
+ */
+void cfgpack_shm_unmap(const void *seg, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGPACK_SHM_H */
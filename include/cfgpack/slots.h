@@ -0,0 +1,164 @@
+#ifndef CFGPACK_SLOTS_H
+#define CFGPACK_SLOTS_H
+
+/**
+ * @file slots.h
+ * @brief A/B double-buffered pageout with sequence numbers.
+ *
+ * Two storage slots alternate: each save goes to the slot not holding the
+ * newest copy, so the previous good copy survives a power cut at any point
+ * of the write.  Every slot starts with a small header:
+ *
+ *   offset 0   magic     "CPAB" (u32 LE)
+ *   offset 4   seq       monotonic sequence number (u32 LE)
+ *   offset 8   len       blob length in bytes, including its CRC (u32 LE)
+ *   offset 12  hdr_crc   CRC-32C of bytes 0..11 (u32 LE)
+ *
+ * followed by an ordinary cfgpack blob.  On raw flash the blob is written
+ * first and the header last, so a slot only becomes valid once its data is
+ * complete; the erased (0xFF) header of a torn slot fails the magic check.
+ * Boot reads the two headers, never the blobs, to pick the newest slot,
+ * and falls back to the other slot if the chosen blob fails its CRC.
+ *
+ * The raw-flash API below works with any device exposed through
+ * cfgpack_slot_dev_t.  The LittleFS variant lives in io_littlefs.h.
+ */
+
+#include "api.h"
+#include "error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Size of the slot header in bytes. */
+#define CFGPACK_SLOT_HDR_SIZE 16
+
+/** @brief Slot header magic, "CPAB" read as a little-endian u32. */
+#define CFGPACK_SLOT_MAGIC 0x42415043u
+
+/**
+ * @brief Decoded slot header.
+ */
+typedef struct {
+    uint32_t seq; /**< Sequence number; higher (mod 2^32) is newer. */
+    uint32_t len; /**< Blob length following the header. */
+} cfgpack_slot_hdr_t;
+
+/**
+ * @brief Raw flash device holding two equally sized slots.
+ *
+ * Offsets are relative to the start of @p slot (0 or 1).  @p prog is only
+ * called on erased ranges, in increasing offset order except for the final
+ * header write at offset 0.
+ */
+typedef struct {
+    cfgpack_err_t (*read)(void *user,
+                          uint8_t slot,
+                          size_t off,
+                          uint8_t *dst,
+                          size_t len); /**< Read bytes from a slot. */
+    cfgpack_err_t (*prog)(void *user,
+                          uint8_t slot,
+                          size_t off,
+                          const uint8_t *src,
+                          size_t len); /**< Program erased bytes. */
+    cfgpack_err_t (*erase)(void *user, uint8_t slot); /**< Erase a slot. */
+    void *user;       /**< Opaque pointer passed to the callbacks. */
+    size_t slot_size; /**< Capacity of each slot in bytes. */
+} cfgpack_slot_dev_t;
+
+/**
+ * @brief Serialize a slot header (including its CRC).
+ * @param out Destination, CFGPACK_SLOT_HDR_SIZE bytes.
+ * @param hdr Header to encode.
+ */
+void cfgpack_slot_hdr_encode(uint8_t *out, const cfgpack_slot_hdr_t *hdr);
+
+/**
+ * @brief Parse and validate a slot header.
+ * @param in  Source, CFGPACK_SLOT_HDR_SIZE bytes.
+ * @param hdr Receives the decoded header.
+ * @return CFGPACK_OK if magic and header CRC match; CFGPACK_ERR_DECODE
+ *         otherwise (erased, torn or foreign data).
+ */
+cfgpack_err_t cfgpack_slot_hdr_decode(const uint8_t *in,
+                                      cfgpack_slot_hdr_t *hdr);
+
+/**
+ * @brief Compare sequence numbers with wraparound.
+ * @return Non-zero if @p a is newer than @p b.
+ */
+static inline int cfgpack_slot_seq_newer(uint32_t a, uint32_t b) {
+    return ((int32_t)(a - b) > 0);
+}
+
+/**
+ * @brief Pick the slot holding the newest valid header.
+ *
+ * Reads only the two headers.
+ *
+ * @param dev       Slot device.
+ * @param out_slot  Receives the newest slot (0 or 1).
+ * @param out_hdr   Optional; receives its header.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_MISSING if neither header is
+ *         valid; the device's error code on read failure.
+ */
+cfgpack_err_t cfgpack_slots_select(const cfgpack_slot_dev_t *dev,
+                                   uint8_t *out_slot,
+                                   cfgpack_slot_hdr_t *out_hdr);
+
+/**
+ * @brief Save the context to the older slot with the next sequence number.
+ *
+ * Erases the target slot, streams the blob after the header area through
+ * @p chunk_buf, then programs the header.  The save is published only by
+ * that final header write.  Dirty bits are cleared only once it succeeds.
+ *
+ * The newest slot's blob is CRC-checked first (through @p chunk_buf); if
+ * it is damaged, that slot is the one overwritten, so the older good copy
+ * is never the target.
+ *
+ * @param ctx        Initialized context.
+ * @param dev        Slot device.
+ * @param chunk_buf  Chunk scratch buffer for cfgpack_pageout_stream().
+ * @param chunk_cap  Capacity of @p chunk_buf (>= CFGPACK_STREAM_CHUNK_MIN).
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments;
+ *         CFGPACK_ERR_BOUNDS if the blob does not fit a slot;
+ *         CFGPACK_ERR_ENCODE if @p chunk_cap is below the minimum;
+ *         the device's error code on erase/program failure.
+ */
+cfgpack_err_t cfgpack_pageout_slots(cfgpack_ctx_t *ctx,
+                                    const cfgpack_slot_dev_t *dev,
+                                    uint8_t *chunk_buf,
+                                    size_t chunk_cap);
+
+/**
+ * @brief Load the newest slot, falling back to the other on CRC failure.
+ *
+ * Decodes through cfgpack_pagein_stream(), so @p ctx is untouched unless
+ * a slot verifies.
+ *
+ * @param ctx         Initialized context.
+ * @param dev         Slot device.
+ * @param window      Refill window for cfgpack_pagein_stream().
+ * @param window_cap  Capacity of @p window (>= CFGPACK_STREAM_WINDOW_MIN).
+ * @param out_slot    Optional; receives the slot that was loaded.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_MISSING if no slot has a
+ *         valid header; CFGPACK_ERR_CRC / CFGPACK_ERR_DECODE if no slot
+ *         verifies; other errors from cfgpack_pagein_stream().
+ */
+cfgpack_err_t cfgpack_pagein_slots(cfgpack_ctx_t *ctx,
+                                   const cfgpack_slot_dev_t *dev,
+                                   uint8_t *window,
+                                   size_t window_cap,
+                                   uint8_t *out_slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGPACK_SLOTS_H */
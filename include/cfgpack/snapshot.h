@@ -0,0 +1,111 @@
+#ifndef CFGPACK_SNAPSHOT_H
+#define CFGPACK_SNAPSHOT_H
+
+/**
+ * @file snapshot.h
+ * @brief Raw context snapshots for same-firmware warm boots.
+ *
+ * A snapshot is a copy of the context's values array, presence bitmap,
+ * string offsets and string pool, taken byte for byte.  Loading one is a
+ * header compare, a CRC-32C over the image and a memcpy per buffer: no
+ * msgpack decoding and no type coercion.  The layout is:
+ *
+ *   offset 0   magic        "CPSN" (u32, native byte order)
+ *   offset 4   layout       sizeof(cfgpack_value_t) |
+ *                           sizeof(cfgpack_str_off_t) << 8 (u32, native)
+ *   offset 8   fingerprint  cfgpack_schema_fingerprint() (u64, native)
+ *   offset 16  hash         cfgpack_schema_hash() (u32, native)
+ *   offset 20  entries      value count (u32, native)
+ *   offset 24  strings      string offset count (u32, native)
+ *   offset 28  pool         string pool bytes (u32, native)
+ *
+ * followed by the four buffers in that order and the CRC-32C of all of
+ * the above as a little-endian u32, like a blob trailer.
+ *
+ * A snapshot is only valid for the build and the schema that wrote it:
+ * native byte order, the value layout of the build, and the schema's
+ * entries, names, declared string lengths and version.  Any difference
+ * makes cfgpack_snapshot_load() fall back to the msgpack blob, which
+ * stays the portable copy to keep in storage next to the snapshot.
+ */
+
+#include "api.h"
+#include "error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Size of the snapshot header in bytes. */
+#define CFGPACK_SNAPSHOT_HDR_SIZE 32
+
+/** @brief Snapshot magic, "CPSN" read as a little-endian u32. */
+#define CFGPACK_SNAPSHOT_MAGIC 0x4e535043u
+
+/**
+ * @brief Exact size of the snapshot cfgpack_snapshot_save() writes.
+ * @param ctx Initialized context.
+ * @return Snapshot size in bytes, or 0 if @p ctx is NULL or uses packed
+ *         storage.
+ */
+size_t cfgpack_snapshot_size(const cfgpack_ctx_t *ctx);
+
+/**
+ * @brief Write a raw snapshot of the context.
+ *
+ * Pending lazy entries are resolved first (cfgpack_lazy_finish()).
+ * Presence and dirty bits are left as they are.
+ *
+ * @param ctx     Initialized context.
+ * @param out     Destination buffer.
+ * @param cap     Capacity of @p out.
+ * @param out_len Receives the snapshot size.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_ARGS on NULL arguments or a
+ *         packed context; CFGPACK_ERR_ENCODE if @p cap is below
+ *         cfgpack_snapshot_size(); a lazy decode error.
+ */
+cfgpack_err_t cfgpack_snapshot_save(cfgpack_ctx_t *ctx,
+                                    uint8_t *out,
+                                    size_t cap,
+                                    size_t *out_len);
+
+/**
+ * @brief Restore the context from a snapshot, or fall back to a blob.
+ *
+ * The snapshot header is checked against the running build and schema,
+ * then its CRC.  On a match the buffers are copied in as one seqlock
+ * write section; presence is restored, dirty bits are cleared and
+ * subscribers are notified as after a full pagein.  A copy-on-write
+ * context must be attached to the same defaults blob it was saved with.
+ *
+ * If the snapshot does not apply and @p blob is non-NULL, @p blob is
+ * loaded with cfgpack_pagein_buf() instead.  The context is untouched
+ * until one of the two verifies.
+ *
+ * @param ctx      Initialized context.
+ * @param snap     Snapshot from cfgpack_snapshot_save().
+ * @param snap_len Length of @p snap.
+ * @param blob     Optional msgpack blob to fall back to, or NULL.
+ * @param blob_len Length of @p blob.
+ * @return CFGPACK_OK if the snapshot was loaded.  If it was not, the
+ *         result of cfgpack_pagein_buf() when @p blob is given, or else
+ *         CFGPACK_ERR_MISSING if it is absent or was written by another
+ *         build or schema, CFGPACK_ERR_DECODE if it is truncated,
+ *         CFGPACK_ERR_BOUNDS if its strings do not fit the context and
+ *         CFGPACK_ERR_CRC if it is corrupt.  CFGPACK_ERR_ARGS on a NULL
+ *         @p ctx, a packed context or an open transaction.
+ */
+cfgpack_err_t cfgpack_snapshot_load(cfgpack_ctx_t *ctx,
+                                    const uint8_t *snap,
+                                    size_t snap_len,
+                                    const uint8_t *blob,
+                                    size_t blob_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGPACK_SNAPSHOT_H */
@@ -12,6 +12,8 @@
  * String data is stored in an external pool; only offsets are kept inline.
  */
 
+#include "config.h"
+
 #include <stdint.h>
 
 /**
@@ -51,8 +53,8 @@ typedef struct {
         int64_t  i64;
         float    f32;
         double   f64;
-        struct { uint16_t offset; uint16_t len; } str;
-        struct { uint16_t offset; uint8_t len; uint8_t _pad; } fstr;
+        struct { cfgpack_str_off_t offset; uint16_t len; } str;
+        struct { cfgpack_str_off_t offset; uint8_t len; uint8_t _pad; } fstr;
     } v;
     /* clang-format on */
 } cfgpack_value_t;
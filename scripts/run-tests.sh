@@ -12,7 +12,7 @@ BUILD_OUT="$ROOT_DIR/build/out"
 LOG_FILE="$ROOT_DIR/build/test.log"
 
 # Test binaries to run (order matters for readability)
-TESTS=(basic core_edge coverage decompress io_edge io_littlefs json_edge json_remap measure msgpack msgpack_decode msgpack_schema null_args parser_bounds parser runtime)
+TESTS=(aligned autosave basic blob_diff blob_index bulk bundle compress core_edge coverage crc32 decompress delta filtered io_async io_edge io_littlefs json_edge json_remap large_schema layers measure migrate msgpack msgpack_decode msgpack_schema notify null_args packed parser_bounds parser patch plan runtime schema_def schema_family schema_image sections seqlock shared_schema shm slots snapshot staged stats steps stream txn)
 
 # Colors
 RED='\033[31m'
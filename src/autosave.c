@@ -0,0 +1,136 @@
+/**
+ * @file autosave.c
+ * @brief Write-behind autosave (cfgpack_autosave_tick / _flush).
+ *
+ * See autosave.h for the policy.  All time comparisons go through
+ * time_after() so a wrapping millisecond clock is fine as long as the
+ * intervals involved stay below 2^31 ms.
+ */
+
+#include "cfgpack/autosave.h"
+
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Nonzero if @p a is later than @p b on a wrapping clock. */
+static int time_after(uint32_t a, uint32_t b) {
+    return ((int32_t)(a - b) > 0);
+}
+
+/** Dirty bits include removed entries, which get_dirty_count() skips. */
+static int any_dirty(const cfgpack_ctx_t *ctx) {
+    for (size_t i = 0; i < cfgpack_bitmap_bytes(ctx); ++i) {
+        if (ctx->dirty[i]) {
+            return (1);
+        }
+    }
+    return (0);
+}
+
+static cfgpack_err_t autosave_run(cfgpack_autosave_t *as) {
+    cfgpack_err_t rc = as->save(as->ctx, as->user);
+
+    if (rc == CFGPACK_OK) {
+        cfgpack_dirty_clear_all(as->ctx);
+        as->seen = as->ctx->set_count;
+        as->pending = 0;
+        as->saves++;
+    }
+    return (rc);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * API
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+cfgpack_err_t cfgpack_autosave_init(cfgpack_autosave_t *as,
+                                    cfgpack_ctx_t *ctx,
+                                    const cfgpack_autosave_cfg_t *cfg,
+                                    cfgpack_autosave_fn save,
+                                    void *user) {
+    if (!as || !ctx || !cfg || !save) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    memset(as, 0, sizeof(*as));
+    as->ctx = ctx;
+    as->save = save;
+    as->user = user;
+    as->cfg = *cfg;
+    as->seen = ctx->set_count;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_autosave_tick(cfgpack_autosave_t *as,
+                                    uint32_t now_ms,
+                                    uint32_t *wait_ms) {
+    uint32_t spacing = 0;
+    uint32_t due;
+    cfgpack_err_t rc;
+
+    if (!as) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (wait_ms) {
+        *wait_ms = UINT32_MAX;
+    }
+    if (!any_dirty(as->ctx)) {
+        as->seen = as->ctx->set_count;
+        as->pending = 0;
+        return (CFGPACK_OK);
+    }
+    if (!as->pending) {
+        as->pending = 1;
+        as->first_ms = now_ms;
+        as->last_ms = now_ms;
+    } else if (as->ctx->set_count != as->seen) {
+        as->last_ms = now_ms;
+    }
+    as->seen = as->ctx->set_count;
+
+    due = as->last_ms + as->cfg.debounce_ms;
+    if (as->cfg.max_stale_ms &&
+        time_after(due, as->first_ms + as->cfg.max_stale_ms)) {
+        due = as->first_ms + as->cfg.max_stale_ms;
+    }
+    if (as->cfg.max_per_hour) {
+        spacing = 3600000u / as->cfg.max_per_hour;
+    }
+    if (spacing && as->saved && now_ms - as->saved_ms < spacing &&
+        time_after(as->saved_ms + spacing, due)) {
+        due = as->saved_ms + spacing;
+    }
+    if (time_after(due, now_ms)) {
+        if (wait_ms) {
+            *wait_ms = due - now_ms;
+        }
+        return (CFGPACK_OK);
+    }
+
+    as->saved = 1;
+    as->saved_ms = now_ms;
+    rc = autosave_run(as);
+    if (rc != CFGPACK_OK) {
+        /* Retry one debounce from now rather than on every tick */
+        as->first_ms = now_ms;
+        as->last_ms = now_ms;
+        if (wait_ms) {
+            *wait_ms = as->cfg.debounce_ms > spacing ? as->cfg.debounce_ms
+                                                     : spacing;
+        }
+    }
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_autosave_flush(cfgpack_autosave_t *as) {
+    if (!as) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (!any_dirty(as->ctx)) {
+        as->pending = 0;
+        return (CFGPACK_OK);
+    }
+    return (autosave_run(as));
+}
@@ -0,0 +1,134 @@
+/**
+ * @file autosave_thread.c
+ * @brief Background thread for the write-behind autosave (hosted only).
+ *
+ * The thread holds the lock except while it sleeps on the condition
+ * variable, so a tick never overlaps a set made under
+ * cfgpack_autosave_lock().  The sleep is bounded by the wait reported by
+ * cfgpack_autosave_tick(), and cut short by every unlock.
+ */
+
+#ifndef _POSIX_C_SOURCE
+  #define _POSIX_C_SOURCE 200809L /* clock_gettime/pthreads under -std=c99 */
+#endif
+
+#include "cfgpack/autosave.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Timed waits use CLOCK_MONOTONIC where the condition variable can be
+ * bound to it.  Without clock selection (macOS), they fall back to
+ * CLOCK_REALTIME deadlines, the default clock of a condition variable.
+ */
+#if defined(_POSIX_CLOCK_SELECTION) && _POSIX_CLOCK_SELECTION > 0
+  #define WAIT_MONOTONIC 1
+  #define WAIT_CLOCK     CLOCK_MONOTONIC
+#else
+  #define WAIT_MONOTONIC 0
+  #define WAIT_CLOCK     CLOCK_REALTIME
+#endif
+
+static uint32_t now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint32_t)((uint64_t)ts.tv_sec * 1000u +
+                       (uint64_t)ts.tv_nsec / 1000000u));
+}
+
+/** Absolute WAIT_CLOCK deadline @p ms from now. */
+static struct timespec deadline(uint32_t ms) {
+    struct timespec ts;
+
+    clock_gettime(WAIT_CLOCK, &ts);
+    ts.tv_sec += (time_t)(ms / 1000u);
+    ts.tv_nsec += (long)(ms % 1000u) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return (ts);
+}
+
+static void *autosave_main(void *arg) {
+    cfgpack_autosave_thread_t *t = arg;
+
+    pthread_mutex_lock(&t->lock);
+    while (t->running) {
+        uint32_t wait = UINT32_MAX;
+        cfgpack_err_t rc = cfgpack_autosave_tick(t->as, now_ms(), &wait);
+
+        if (rc != CFGPACK_OK) {
+            t->err = rc;
+        }
+        if (!t->running) {
+            break;
+        }
+        if (wait == UINT32_MAX) {
+            pthread_cond_wait(&t->wake, &t->lock);
+        } else if (wait > 0) {
+            struct timespec ts = deadline(wait);
+
+            pthread_cond_timedwait(&t->wake, &t->lock, &ts);
+        }
+    }
+    pthread_mutex_unlock(&t->lock);
+    return (NULL);
+}
+
+cfgpack_err_t cfgpack_autosave_start(cfgpack_autosave_thread_t *t,
+                                     cfgpack_autosave_t *as) {
+    pthread_condattr_t attr;
+
+    if (!t || !as) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    t->as = as;
+    t->running = 1;
+    t->err = CFGPACK_OK;
+    if (pthread_mutex_init(&t->lock, NULL) != 0) {
+        return (CFGPACK_ERR_IO);
+    }
+    pthread_condattr_init(&attr);
+#if WAIT_MONOTONIC
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+#endif
+    if (pthread_cond_init(&t->wake, &attr) != 0) {
+        pthread_condattr_destroy(&attr);
+        pthread_mutex_destroy(&t->lock);
+        return (CFGPACK_ERR_IO);
+    }
+    pthread_condattr_destroy(&attr);
+    if (pthread_create(&t->thread, NULL, autosave_main, t) != 0) {
+        pthread_cond_destroy(&t->wake);
+        pthread_mutex_destroy(&t->lock);
+        return (CFGPACK_ERR_IO);
+    }
+    return (CFGPACK_OK);
+}
+
+void cfgpack_autosave_lock(cfgpack_autosave_thread_t *t) {
+    pthread_mutex_lock(&t->lock);
+}
+
+void cfgpack_autosave_unlock(cfgpack_autosave_thread_t *t) {
+    pthread_cond_signal(&t->wake);
+    pthread_mutex_unlock(&t->lock);
+}
+
+cfgpack_err_t cfgpack_autosave_stop(cfgpack_autosave_thread_t *t) {
+    cfgpack_err_t rc;
+
+    pthread_mutex_lock(&t->lock);
+    t->running = 0;
+    pthread_cond_signal(&t->wake);
+    pthread_mutex_unlock(&t->lock);
+    pthread_join(t->thread, NULL);
+    rc = cfgpack_autosave_flush(t->as);
+    pthread_cond_destroy(&t->wake);
+    pthread_mutex_destroy(&t->lock);
+    return (rc);
+}
@@ -0,0 +1,360 @@
+/**
+ * @file bulk.c
+ * @brief Optional parallel pagein/pageout of many contexts (hosted only).
+ *
+ * Jobs are split into one contiguous run per worker.  A worker claims
+ * jobs from the front of its own run; when that is empty it steals the
+ * back half of another worker's run and carries on from there.  Runs only
+ * ever shrink, so a worker that finds every run empty is done.
+ */
+
+#ifndef _POSIX_C_SOURCE
+  #define _POSIX_C_SOURCE 200809L /* sysconf/pthreads under -std=c99 */
+#endif
+
+#include "cfgpack/bulk.h"
+
+#include "cfgpack/decompress.h"
+
+#include "crc32.h"
+
+#include <limits.h>
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Scheduler
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Unclaimed jobs [head, tail) of one worker. */
+typedef struct {
+    pthread_mutex_t lock;
+    size_t head;
+    size_t tail;
+} bulk_run_t;
+
+typedef struct {
+    cfgpack_bulk_job_t *jobs;
+    const cfgpack_bulk_opts_t *opts;
+    unsigned workers;
+    bulk_run_t runs[CFGPACK_BULK_MAX_THREADS];
+} bulk_pool_t;
+
+typedef struct {
+    bulk_pool_t *pool;
+    unsigned id;
+} bulk_worker_t;
+
+/** Claim the next job of @p run; returns 0 once it is empty. */
+static int run_take(bulk_run_t *run, size_t *job) {
+    int ok = 0;
+
+    pthread_mutex_lock(&run->lock);
+    if (run->head < run->tail) {
+        *job = run->head++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&run->lock);
+    return (ok);
+}
+
+/**
+ * @brief Move the back half of another worker's run into worker @p self's.
+ *
+ * Victims are tried in order after @p self, so thieves spread out instead
+ * of all queueing on worker 0.
+ *
+ * @return 1 if jobs were stolen, 0 if every other run is empty.
+ */
+static int run_steal(bulk_pool_t *pool, unsigned self) {
+    for (unsigned k = 1; k < pool->workers; ++k) {
+        bulk_run_t *victim = &pool->runs[(self + k) % pool->workers];
+        size_t lo;
+        size_t hi;
+
+        pthread_mutex_lock(&victim->lock);
+        hi = victim->tail;
+        lo = hi - (hi - victim->head + 1) / 2;
+        victim->tail = lo;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (lo < hi) {
+            bulk_run_t *own = &pool->runs[self];
+
+            pthread_mutex_lock(&own->lock);
+            own->head = lo;
+            own->tail = hi;
+            pthread_mutex_unlock(&own->lock);
+            return (1);
+        }
+    }
+    return (0);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Jobs
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static cfgpack_err_t job_pagein(cfgpack_bulk_job_t *job,
+                                const cfgpack_bulk_opts_t *opts,
+                                uint8_t *scratch,
+                                void *hsd) {
+    (void)scratch;
+    (void)hsd;
+    switch (opts->codec) {
+#ifdef CFGPACK_LZ4
+    case CFGPACK_BULK_LZ4:
+        return (cfgpack_pagein_lz4(job->ctx, job->in, job->in_len,
+                                   job->raw_len, scratch, opts->scratch_cap));
+#endif
+#ifdef CFGPACK_HEATSHRINK
+    case CFGPACK_BULK_HEATSHRINK:
+        return (cfgpack_pagein_heatshrink_r(job->ctx, job->in, job->in_len,
+                                            (heatshrink_decoder *)hsd,
+                                            scratch, opts->scratch_cap));
+#endif
+    default:
+        return (cfgpack_pagein_buf(job->ctx, job->in, job->in_len));
+    }
+}
+
+static void job_run(cfgpack_bulk_job_t *job,
+                    const cfgpack_bulk_opts_t *opts,
+                    uint8_t *scratch,
+                    void *hsd) {
+    cfgpack_err_t rc = CFGPACK_OK;
+
+    if (!job->ctx) {
+        job->err = CFGPACK_ERR_ARGS;
+        return;
+    }
+    if (job->in) {
+        rc = job_pagein(job, opts, scratch, hsd);
+    }
+    if (rc == CFGPACK_OK && job->out) {
+        rc = cfgpack_pageout(job->ctx, job->out, job->out_cap,
+                             &job->out_len);
+    }
+    job->err = rc;
+}
+
+static void *worker_main(void *arg) {
+    const bulk_worker_t *w = (const bulk_worker_t *)arg;
+    bulk_pool_t *pool = w->pool;
+    const cfgpack_bulk_opts_t *opts = pool->opts;
+    uint8_t *scratch = NULL;
+    void *hsd = NULL;
+    size_t job;
+#ifdef CFGPACK_HEATSHRINK
+    heatshrink_decoder decoder;
+
+    hsd = &decoder;
+#endif
+
+    if (opts->scratch) {
+        scratch = opts->scratch + (size_t)w->id * opts->scratch_cap;
+    }
+    do {
+        while (run_take(&pool->runs[w->id], &job)) {
+            job_run(&pool->jobs[job], opts, scratch, hsd);
+        }
+    } while (run_steal(pool, w->id));
+    return (NULL);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Section verification
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** One worker's run of sections and its results. */
+typedef struct {
+    const cfgpack_sections_t *t;
+    uint8_t *bad;
+    size_t first;
+    size_t n;
+    size_t nbad; /* output */
+    uint32_t crc; /* output: CRC-32C of the run */
+} bulk_check_t;
+
+static void *check_main(void *arg) {
+    bulk_check_t *c = (bulk_check_t *)arg;
+
+    c->nbad = cfgpack_sections_check(c->t, c->first, c->n, c->bad, &c->crc);
+    return (NULL);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Public API
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+unsigned cfgpack_bulk_workers(unsigned threads, size_t count) {
+    if (threads == 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = n > 0 ? (unsigned)n : 1u;
+#else
+        threads = 1;
+#endif
+    }
+    if (threads > CFGPACK_BULK_MAX_THREADS) {
+        threads = CFGPACK_BULK_MAX_THREADS;
+    }
+    if (threads > count) {
+        threads = count ? (unsigned)count : 1u;
+    }
+    return (threads);
+}
+
+cfgpack_err_t cfgpack_bulk_run(cfgpack_bulk_job_t *jobs,
+                               size_t count,
+                               const cfgpack_bulk_opts_t *opts,
+                               size_t *failed) {
+    bulk_pool_t pool;
+    bulk_worker_t workers[CFGPACK_BULK_MAX_THREADS];
+    pthread_t tids[CFGPACK_BULK_MAX_THREADS];
+    unsigned started = 1;
+    cfgpack_err_t first = CFGPACK_OK;
+    size_t nfail = 0;
+
+    if (failed) {
+        *failed = 0;
+    }
+    if ((!jobs && count) || !opts) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    switch (opts->codec) {
+    case CFGPACK_BULK_RAW:
+        break;
+#ifdef CFGPACK_LZ4
+    case CFGPACK_BULK_LZ4:
+#endif
+#ifdef CFGPACK_HEATSHRINK
+    case CFGPACK_BULK_HEATSHRINK:
+#endif
+        if (!opts->scratch || opts->scratch_cap == 0) {
+            return (CFGPACK_ERR_ARGS);
+        }
+        break;
+    default:
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (count == 0) {
+        return (CFGPACK_OK);
+    }
+
+    memset(&pool, 0, sizeof(pool));
+    pool.jobs = jobs;
+    pool.opts = opts;
+    pool.workers = cfgpack_bulk_workers(opts->threads, count);
+    for (unsigned i = 0; i < pool.workers; ++i) {
+        pthread_mutex_init(&pool.runs[i].lock, NULL);
+        pool.runs[i].head = count * i / pool.workers;
+        pool.runs[i].tail = count * (i + 1) / pool.workers;
+        workers[i].pool = &pool;
+        workers[i].id = i;
+    }
+
+    /* Worker 0 is the caller; runs of threads that fail to start are stolen */
+    for (unsigned i = 1; i < pool.workers; ++i) {
+        if (pthread_create(&tids[started], NULL, worker_main, &workers[i]) ==
+            0) {
+            started++;
+        }
+    }
+    worker_main(&workers[0]);
+    for (unsigned i = 1; i < started; ++i) {
+        pthread_join(tids[i], NULL);
+    }
+    for (unsigned i = 0; i < pool.workers; ++i) {
+        pthread_mutex_destroy(&pool.runs[i].lock);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (jobs[i].err != CFGPACK_OK) {
+            if (nfail++ == 0) {
+                first = jobs[i].err;
+            }
+        }
+    }
+    if (failed) {
+        *failed = nfail;
+    }
+    return (first);
+}
+
+cfgpack_err_t cfgpack_bulk_verify_sections(const uint8_t *blob,
+                                           size_t len,
+                                           unsigned threads,
+                                           uint8_t *bad,
+                                           size_t bad_len,
+                                           size_t *bad_count) {
+    bulk_check_t runs[CFGPACK_BULK_MAX_THREADS];
+    pthread_t tids[CFGPACK_BULK_MAX_THREADS];
+    int started[CFGPACK_BULK_MAX_THREADS];
+    cfgpack_sections_t t;
+    cfgpack_err_t rc;
+    unsigned workers;
+    size_t groups;
+    size_t nbad = 0;
+    uint32_t stored;
+    uint32_t crc;
+
+    if (bad_count) {
+        *bad_count = 0;
+    }
+    rc = cfgpack_sections_open(blob, len, &t);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    groups = (t.count + CHAR_BIT - 1) / CHAR_BIT;
+    if (bad && bad_len < groups) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    if (bad) {
+        memset(bad, 0, groups);
+    }
+
+    /* Runs of whole bitmap bytes; worker 0 is the caller */
+    workers = cfgpack_bulk_workers(threads, groups);
+    for (unsigned i = 0; i < workers; ++i) {
+        size_t lo = groups * i / workers * CHAR_BIT;
+        size_t hi = groups * (i + 1) / workers * CHAR_BIT;
+
+        runs[i].t = &t;
+        runs[i].bad = bad;
+        runs[i].first = lo;
+        runs[i].n = (hi < t.count ? hi : t.count) - lo;
+        started[i] = i > 0 && pthread_create(&tids[i], NULL, check_main,
+                                             &runs[i]) == 0;
+    }
+    check_main(&runs[0]);
+    for (unsigned i = 1; i < workers; ++i) {
+        if (started[i]) {
+            pthread_join(tids[i], NULL);
+        } else {
+            check_main(&runs[i]);
+        }
+    }
+
+    /* Prelude, each run in order, then the table */
+    crc = cfgpack_crc32c(blob, cfgpack_sections_offset(&t, 0));
+    for (unsigned i = 0; i < workers; ++i) {
+        size_t lo = cfgpack_sections_offset(&t, runs[i].first);
+        size_t hi = cfgpack_sections_offset(&t, runs[i].first + runs[i].n);
+
+        nbad += runs[i].nbad;
+        crc = cfgpack_crc32c_combine(crc, runs[i].crc, hi - lo);
+    }
+    crc = cfgpack_crc32c_combine(
+        crc, cfgpack_crc32c(blob + t.end, t.body - t.end), t.body - t.end);
+    stored = (uint32_t)blob[len - 4] | ((uint32_t)blob[len - 3] << 8) |
+             ((uint32_t)blob[len - 2] << 16) |
+             ((uint32_t)blob[len - 1] << 24);
+
+    if (bad_count) {
+        *bad_count = nbad;
+    }
+    return (nbad || crc != stored ? CFGPACK_ERR_CRC : CFGPACK_OK);
+}
@@ -0,0 +1,320 @@
+/**
+ * @file bundle.c
+ * @brief Several contexts in one container blob (cfgpack_bundle_*).
+ *
+ * See bundle.h for the layout.  Pageout rewrites the bundle in place:
+ * sizes first, then the kept sections are moved to their new offsets,
+ * then the changed sections are encoded into the gaps, and the header
+ * and directory are written last.
+ */
+
+#include "cfgpack/bundle.h"
+
+#include "crc32.h"
+
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Directory encoding
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+    return ((uint16_t)(p[0] | (p[1] << 8)));
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+            ((uint32_t)p[3] << 24));
+}
+
+/** Decoded directory record. */
+typedef struct {
+    uint64_t fp;
+    uint32_t off;
+    uint32_t len;
+    const uint8_t *name;
+    uint8_t name_len;
+} rec_t;
+
+/** CRC-32C of the header's first 8 bytes and @p dir_len directory bytes. */
+static uint32_t dir_crc(const uint8_t *buf, size_t dir_len) {
+    uint32_t crc = cfgpack_crc32c_init();
+
+    crc = cfgpack_crc32c_update(crc, buf, 8);
+    crc = cfgpack_crc32c_update(crc, buf + CFGPACK_BUNDLE_HDR_SIZE, dir_len);
+    return (cfgpack_crc32c_final(crc));
+}
+
+/**
+ * @brief Validate the header and directory CRC.
+ * @param count Receives the section count.
+ */
+static cfgpack_err_t dir_check(const uint8_t *buf, size_t len, size_t *count) {
+    size_t dir_len;
+
+    if (len < CFGPACK_BUNDLE_HDR_SIZE ||
+        get_le32(buf) != CFGPACK_BUNDLE_MAGIC) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    dir_len = get_le16(buf + 6);
+    if (dir_len > len - CFGPACK_BUNDLE_HDR_SIZE ||
+        get_le32(buf + 8) != dir_crc(buf, dir_len)) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    *count = get_le16(buf + 4);
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Decode the record at @p *pos and advance past it.
+ * @return 0 if the record runs past the directory or its blob past @p len.
+ */
+static int rec_next(const uint8_t *buf, size_t len, size_t *pos, rec_t *r) {
+    size_t dir_end = CFGPACK_BUNDLE_HDR_SIZE + get_le16(buf + 6);
+    const uint8_t *p = buf + *pos;
+
+    if (dir_end - *pos < CFGPACK_BUNDLE_REC_SIZE(0)) {
+        return (0);
+    }
+    r->fp = 0;
+    for (int i = 7; i >= 0; --i) {
+        r->fp = (r->fp << 8) | p[i];
+    }
+    r->off = get_le32(p + 8);
+    r->len = get_le32(p + 12);
+    r->name_len = p[16];
+    r->name = p + 17;
+    if (dir_end - *pos - CFGPACK_BUNDLE_REC_SIZE(0) < r->name_len ||
+        r->off > len || r->len > len - r->off) {
+        return (0);
+    }
+    *pos += CFGPACK_BUNDLE_REC_SIZE(r->name_len);
+    return (1);
+}
+
+/**
+ * @brief Find the record named @p name in a checked directory.
+ */
+static cfgpack_err_t rec_find(const uint8_t *buf,
+                              size_t len,
+                              size_t count,
+                              const char *name,
+                              rec_t *r) {
+    size_t name_len = strlen(name);
+    size_t pos = CFGPACK_BUNDLE_HDR_SIZE;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!rec_next(buf, len, &pos, r)) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (r->name_len == name_len && memcmp(r->name, name, name_len) == 0) {
+            return (CFGPACK_OK);
+        }
+    }
+    return (CFGPACK_ERR_MISSING);
+}
+
+static int ctx_dirty(const cfgpack_ctx_t *ctx) {
+    return (cfgpack_bits_count(ctx->dirty, NULL, ctx->schema->entry_count) !=
+            0);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * API
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+cfgpack_err_t cfgpack_bundle_find(const uint8_t *buf,
+                                  size_t len,
+                                  const char *name,
+                                  cfgpack_bundle_sec_t *out) {
+    size_t count;
+    cfgpack_err_t rc;
+    rec_t r;
+
+    if (!buf || !name || !out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = dir_check(buf, len, &count);
+    if (rc == CFGPACK_OK) {
+        rc = rec_find(buf, len, count, name, &r);
+    }
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    out->fingerprint = r.fp;
+    out->blob = buf + r.off;
+    out->len = r.len;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_bundle_pageout(cfgpack_ctx_t *const *ctxs,
+                                     size_t n,
+                                     uint8_t *buf,
+                                     size_t cap,
+                                     size_t *len,
+                                     size_t *kept) {
+    size_t old_off[CFGPACK_BUNDLE_MAX];
+    size_t new_off[CFGPACK_BUNDLE_MAX];
+    size_t size[CFGPACK_BUNDLE_MAX];
+    uint8_t keep[CFGPACK_BUNDLE_MAX];
+    size_t dir_len = 0;
+    size_t old_count = 0;
+    size_t old_end = 0;
+    size_t n_kept = 0;
+    size_t total;
+    int old_ok;
+    uint8_t *p;
+
+    if (!ctxs || !buf || !len || n > CFGPACK_BUNDLE_MAX) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!ctxs[i]) {
+            return (CFGPACK_ERR_ARGS);
+        }
+        for (size_t j = 0; j < i; ++j) {
+            if (strcmp(ctxs[i]->schema->map_name,
+                       ctxs[j]->schema->map_name) == 0) {
+                return (CFGPACK_ERR_ARGS);
+            }
+        }
+    }
+    old_ok = *len <= cap && dir_check(buf, *len, &old_count) == CFGPACK_OK;
+
+    /* Sizes: kept sections must stay in their old relative order so the
+     * moves below never overwrite one that has not moved yet. */
+    for (size_t i = 0; i < n; ++i) {
+        const cfgpack_schema_t *schema = ctxs[i]->schema;
+        rec_t r;
+
+        dir_len += CFGPACK_BUNDLE_REC_SIZE(strlen(schema->map_name));
+        keep[i] = 0;
+        if (old_ok && !ctx_dirty(ctxs[i]) &&
+            rec_find(buf, *len, old_count, schema->map_name, &r) ==
+                CFGPACK_OK &&
+            r.fp == cfgpack_schema_fingerprint(schema) && r.off >= old_end) {
+            keep[i] = 1;
+            old_off[i] = r.off;
+            size[i] = r.len;
+            old_end = (size_t)r.off + r.len;
+            n_kept++;
+        } else {
+            cfgpack_err_t rc = cfgpack_pageout_measure(ctxs[i], &size[i]);
+
+            if (rc != CFGPACK_OK) {
+                return (rc);
+            }
+        }
+    }
+    total = CFGPACK_BUNDLE_HDR_SIZE + dir_len;
+    for (size_t i = 0; i < n; ++i) {
+        new_off[i] = total;
+        total += size[i];
+    }
+    if (total > cap || total > UINT32_MAX) {
+        *len = total;
+        return (CFGPACK_ERR_ENCODE);
+    }
+
+    /* Kept sections moving down in order, then those moving up in
+     * reverse order */
+    for (size_t i = 0; i < n; ++i) {
+        if (keep[i] && new_off[i] < old_off[i]) {
+            memmove(buf + new_off[i], buf + old_off[i], size[i]);
+        }
+    }
+    for (size_t i = n; i-- > 0;) {
+        if (keep[i] && new_off[i] > old_off[i]) {
+            memmove(buf + new_off[i], buf + old_off[i], size[i]);
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        cfgpack_err_t rc;
+
+        if (keep[i]) {
+            continue;
+        }
+        /* Writes exactly size[i] bytes; the spare capacity only satisfies
+         * cfgpack_pageout()'s minimum buffer check. */
+        rc = cfgpack_pageout(ctxs[i], buf + new_off[i], cap - new_off[i],
+                             NULL);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+
+    put_le32(buf, CFGPACK_BUNDLE_MAGIC);
+    put_le16(buf + 4, (uint16_t)n);
+    put_le16(buf + 6, (uint16_t)dir_len);
+    p = buf + CFGPACK_BUNDLE_HDR_SIZE;
+    for (size_t i = 0; i < n; ++i) {
+        const cfgpack_schema_t *schema = ctxs[i]->schema;
+        uint64_t fp = cfgpack_schema_fingerprint(schema);
+        size_t name_len = strlen(schema->map_name);
+
+        for (int b = 0; b < 8; ++b) {
+            p[b] = (uint8_t)(fp >> (8 * b));
+        }
+        put_le32(p + 8, (uint32_t)new_off[i]);
+        put_le32(p + 12, (uint32_t)size[i]);
+        p[16] = (uint8_t)name_len;
+        memcpy(p + 17, schema->map_name, name_len);
+        p += CFGPACK_BUNDLE_REC_SIZE(name_len);
+    }
+    put_le32(buf + 8, dir_crc(buf, dir_len));
+
+    *len = total;
+    if (kept) {
+        *kept = n_kept;
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_bundle_pagein(cfgpack_ctx_t *ctx,
+                                    const uint8_t *buf,
+                                    size_t len) {
+    cfgpack_bundle_sec_t sec;
+    cfgpack_err_t rc;
+
+    if (!ctx) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = cfgpack_bundle_find(buf, len, ctx->schema->map_name, &sec);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (cfgpack_pagein_buf(ctx, sec.blob, sec.len));
+}
+
+cfgpack_err_t cfgpack_bundle_pagein_all(cfgpack_ctx_t *const *ctxs,
+                                        size_t n,
+                                        const uint8_t *buf,
+                                        size_t len) {
+    cfgpack_err_t result = CFGPACK_OK;
+
+    if (!ctxs) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        cfgpack_err_t rc = cfgpack_bundle_pagein(ctxs[i], buf, len);
+
+        if (rc == CFGPACK_ERR_MISSING) {
+            result = rc;
+        } else if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+    return (result);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file compress.c
+ * @brief Optional on-device compression for cfgpack.
+ *
+ * Implements the LZ4 pageout wrappers, enabled via the CFGPACK_LZ4
+ * compile flag.  The heatshrink wrapper is in compress_heatshrink.c.
+ */
+
+#include "cfgpack/compress.h"
+
+#ifdef CFGPACK_LZ4
+
+/* Shared by the plain and dictionary variants; dict_len 0 means none. */
+static cfgpack_err_t pageout_lz4(cfgpack_ctx_t *ctx,
+                                 uint8_t *out,
+                                 size_t out_cap,
+                                 size_t *out_len,
+                                 LZ4_stream_t *state,
+                                 const uint8_t *dict,
+                                 size_t dict_len,
+                                 uint8_t *scratch,
+                                 size_t scratch_cap) {
+    char *dst = (char *)out + CFGPACK_LZ4_HDR_SIZE;
+    int dst_cap;
+    size_t blob_len;
+    cfgpack_err_t rc;
+    int result;
+
+    if (!ctx || !out || !state || !scratch || (!dict && dict_len)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (out_cap <= CFGPACK_LZ4_HDR_SIZE) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+
+    rc = cfgpack_pageout(ctx, scratch, scratch_cap, &blob_len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    /* A zero return means the compressed block did not fit */
+    dst_cap = (int)(out_cap - CFGPACK_LZ4_HDR_SIZE);
+    if (dict_len) {
+        LZ4_initStream(state, sizeof(*state));
+        LZ4_loadDict(state, (const char *)dict, (int)dict_len);
+        result = LZ4_compress_fast_continue(state, (const char *)scratch, dst,
+                                            (int)blob_len, dst_cap, 1);
+    } else {
+        result = LZ4_compress_fast_extState(state, (const char *)scratch, dst,
+                                            (int)blob_len, dst_cap, 1);
+    }
+    if (result <= 0) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+
+    /* Original-size header, as written by cfgpack-compress */
+    out[0] = (uint8_t)(blob_len);
+    out[1] = (uint8_t)(blob_len >> 8);
+    out[2] = (uint8_t)(blob_len >> 16);
+    out[3] = (uint8_t)(blob_len >> 24);
+
+    if (out_len) {
+        *out_len = CFGPACK_LZ4_HDR_SIZE + (size_t)result;
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_pageout_lz4(cfgpack_ctx_t *ctx,
+                                  uint8_t *out,
+                                  size_t out_cap,
+                                  size_t *out_len,
+                                  LZ4_stream_t *state,
+                                  uint8_t *scratch,
+                                  size_t scratch_cap) {
+    return (pageout_lz4(ctx, out, out_cap, out_len, state, NULL, 0, scratch,
+                        scratch_cap));
+}
+
+cfgpack_err_t cfgpack_pageout_lz4_dict(cfgpack_ctx_t *ctx,
+                                       uint8_t *out,
+                                       size_t out_cap,
+                                       size_t *out_len,
+                                       LZ4_stream_t *state,
+                                       const uint8_t *dict,
+                                       size_t dict_len,
+                                       uint8_t *scratch,
+                                       size_t scratch_cap) {
+    return (pageout_lz4(ctx, out, out_cap, out_len, state, dict, dict_len,
+                        scratch, scratch_cap));
+}
+
+#endif /* CFGPACK_LZ4 */
@@ -0,0 +1,93 @@
+/**
+ * @file compress_heatshrink.c
+ * @brief Optional heatshrink compressed pageout (not in the core library).
+ *
+ * Kept apart from compress.c so that only programs calling
+ * cfgpack_pageout_heatshrink() link the vendored heatshrink encoder.
+ * Build this file and third_party/heatshrink/heatshrink_encoder.c
+ * alongside the core library, with CFGPACK_HEATSHRINK defined.
+ */
+
+#include "cfgpack/compress.h"
+
+#ifdef CFGPACK_HEATSHRINK
+
+cfgpack_err_t cfgpack_pageout_heatshrink(cfgpack_ctx_t *ctx,
+                                         uint8_t *out,
+                                         size_t out_cap,
+                                         size_t *out_len,
+                                         heatshrink_encoder *hse,
+                                         uint8_t *scratch,
+                                         size_t scratch_cap) {
+    size_t input_consumed = 0;
+    size_t total_output = 0;
+    HSE_finish_res finish_res;
+    size_t sink_count;
+    size_t poll_count;
+    HSE_sink_res sink_res;
+    HSE_poll_res poll_res;
+    size_t blob_len;
+    cfgpack_err_t rc;
+
+    if (!ctx || !out || !hse || !scratch) {
+        return (CFGPACK_ERR_ARGS);
+    }
+
+    rc = cfgpack_pageout(ctx, scratch, scratch_cap, &blob_len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    heatshrink_encoder_reset(hse);
+
+    /* Feed the blob and poll for compressed output; more output pending
+     * with the buffer already full means it does not fit */
+    while (input_consumed < blob_len) {
+        sink_res = heatshrink_encoder_sink(hse, scratch + input_consumed,
+                                           blob_len - input_consumed,
+                                           &sink_count);
+        if (sink_res < 0) {
+            return (CFGPACK_ERR_ENCODE);
+        }
+        input_consumed += sink_count;
+
+        do {
+            poll_res = heatshrink_encoder_poll(hse, out + total_output,
+                                               out_cap - total_output,
+                                               &poll_count);
+            if (poll_res < 0) {
+                return (CFGPACK_ERR_ENCODE);
+            }
+            total_output += poll_count;
+            if (poll_res == HSER_POLL_MORE && total_output == out_cap) {
+                return (CFGPACK_ERR_ENCODE);
+            }
+        } while (poll_res == HSER_POLL_MORE);
+    }
+
+    /* Flush the remaining bits */
+    finish_res = heatshrink_encoder_finish(hse);
+    while (finish_res == HSER_FINISH_MORE) {
+        poll_res = heatshrink_encoder_poll(hse, out + total_output,
+                                           out_cap - total_output,
+                                           &poll_count);
+        if (poll_res < 0) {
+            return (CFGPACK_ERR_ENCODE);
+        }
+        total_output += poll_count;
+        if (poll_res == HSER_POLL_MORE && total_output == out_cap) {
+            return (CFGPACK_ERR_ENCODE);
+        }
+        finish_res = heatshrink_encoder_finish(hse);
+    }
+    if (finish_res < 0) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+
+    if (out_len) {
+        *out_len = total_output;
+    }
+    return (CFGPACK_OK);
+}
+
+#endif /* CFGPACK_HEATSHRINK */
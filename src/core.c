@@ -1,23 +1,31 @@
 #include "cfgpack/api.h"
 #include "cfgpack/config.h"
 
+#include "lookup.h"
+#include "stats.h"
+
 #include <string.h>
 
-/**
- * @brief Find a schema entry by index using binary search.
- *
- * @param schema Schema containing sorted entries.
- * @param index  Entry index to locate.
- * @return Pointer to entry or NULL if not found.
- */
-static const cfgpack_entry_t *find_entry(const cfgpack_schema_t *schema,
-                                         uint16_t index) {
+const cfgpack_entry_t *cfgpack_find_entry(const cfgpack_ctx_t *ctx,
+                                          uint16_t index) {
+    const cfgpack_schema_t *schema = ctx->schema;
     size_t hi = schema->entry_count;
     size_t lo = 0;
 
+    if (ctx->index_table) {
+        uint8_t off;
+        if (index >= ctx->index_table_len) {
+            return (NULL);
+        }
+        off = ctx->index_table[index];
+        CFGPACK_STAT_ADD(ctx, index_probes, 1);
+        return (off == UINT8_MAX ? NULL : &schema->entries[off]);
+    }
+
     while (lo < hi) {
         size_t mid = lo + (hi - lo) / 2;
         uint16_t mid_idx = schema->entries[mid].index;
+        CFGPACK_STAT_ADD(ctx, index_probes, 1);
         if (mid_idx == index) {
             return (&schema->entries[mid]);
         }
@@ -31,15 +39,57 @@ static const cfgpack_entry_t *find_entry(const cfgpack_schema_t *schema,
 }
 
 /**
- * @brief Find a schema entry by name using linear search.
+ * @brief Pack a name of up to 5 characters into the high 40 bits of a
+ *        name-index key.
  *
- * @param schema Schema containing entries.
- * @param name   Entry name to locate (NUL-terminated).
- * @return Pointer to entry or NULL if not found.
+ * @param name Entry name (NUL-terminated).
+ * @param out  Receives the packed name (already shifted into place).
+ * @return 1 on success; 0 if @p name is longer than an entry name can be.
  */
-static const cfgpack_entry_t *find_entry_by_name(const cfgpack_schema_t *schema,
-                                                 const char *name) {
+static int pack_name(const char *name, uint64_t *out) {
+    uint64_t key = 0;
+    size_t i;
+
+    for (i = 0; i < 5 && name[i] != '\0'; ++i) {
+        key |= (uint64_t)(uint8_t)name[i] << (56 - 8 * i);
+    }
+    if (name[i] != '\0') {
+        return (0);
+    }
+    *out = key;
+    return (1);
+}
+
+const cfgpack_entry_t *cfgpack_find_entry_by_name(const cfgpack_ctx_t *ctx,
+                                                  const char *name) {
+    const cfgpack_schema_t *schema = ctx->schema;
+
+    if (ctx->name_index) {
+        size_t hi = schema->entry_count;
+        size_t lo = 0;
+        uint64_t key;
+
+        if (!pack_name(name, &key)) {
+            return (NULL);
+        }
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            uint64_t mid_key = ctx->name_index[mid] & ~(uint64_t)0xFFFF;
+            CFGPACK_STAT_ADD(ctx, name_probes, 1);
+            if (mid_key == key) {
+                return (&schema->entries[ctx->name_index[mid] & 0xFFFF]);
+            }
+            if (mid_key < key) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return (NULL);
+    }
+
     for (size_t i = 0; i < schema->entry_count; ++i) {
+        CFGPACK_STAT_ADD(ctx, name_probes, 1);
         if (strcmp(schema->entries[i].name, name) == 0) {
             return (&schema->entries[i]);
         }
@@ -59,14 +109,46 @@ static size_t entry_offset(const cfgpack_schema_t *schema,
     return (size_t)(entry - schema->entries);
 }
 
-cfgpack_err_t cfgpack_init(cfgpack_ctx_t *ctx,
-                           cfgpack_schema_t *schema,
-                           cfgpack_value_t *values,
-                           size_t values_count,
-                           char *str_pool,
-                           size_t str_pool_cap,
-                           uint16_t *str_offsets,
-                           size_t str_offsets_count) {
+/**
+ * @brief Check that a copy-on-write string default lies inside its blob.
+ *
+ * @param v            Default value from cfgpack_schema_parse_msgpack_cow().
+ * @param defaults_len Length of the blob in bytes.
+ * @return Non-zero if the value's bytes are inside the blob.
+ */
+static int cow_default_in_bounds(const cfgpack_value_t *v,
+                                 size_t defaults_len) {
+    if (v->type == CFGPACK_TYPE_STR) {
+        return ((size_t)v->v.str.offset + v->v.str.len <= defaults_len);
+    }
+    if (v->type == CFGPACK_TYPE_FSTR) {
+        return ((size_t)v->v.fstr.offset + v->v.fstr.len <= defaults_len);
+    }
+    return (0);
+}
+
+/**
+ * @brief Shared body of cfgpack_init(), cfgpack_init_cow() and
+ *        cfgpack_init_shared().
+ *
+ * @param slots        The schema's entries, to assign string slots in, or
+ *                     NULL to leave the schema untouched and refuse one
+ *                     whose slots are not assigned yet.
+ * @param defaults     Copy-on-write default blob, or NULL for a context
+ *                     whose pool holds every string slot.
+ * @param defaults_len Length of @p defaults in bytes.
+ */
+static cfgpack_err_t init_impl(cfgpack_ctx_t *ctx,
+                               const cfgpack_schema_t *schema,
+                               cfgpack_entry_t *slots,
+                               cfgpack_value_t *values,
+                               size_t values_count,
+                               char *str_pool,
+                               size_t str_pool_cap,
+                               cfgpack_str_off_t *str_offsets,
+                               size_t str_offsets_count,
+                               const uint8_t *defaults,
+                               size_t defaults_len) {
     size_t pool_offset = 0;
     size_t str_slot = 0;
 
@@ -74,7 +156,8 @@ cfgpack_err_t cfgpack_init(cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_ARGS);
     }
 
-    if (schema->entry_count > CFGPACK_MAX_ENTRIES) {
+    if (schema->entry_count > CFGPACK_MAX_ENTRIES ||
+        schema->entry_count > cfgpack_bitmap_bytes(ctx) * CHAR_BIT) {
         return (CFGPACK_ERR_BOUNDS);
     }
 
@@ -82,42 +165,57 @@ cfgpack_err_t cfgpack_init(cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_BOUNDS);
     }
 
-    /* Compute string slot offsets and verify pool capacity */
+    /* Compute string slot offsets and verify pool capacity.  Entries are
+     * only written when their slot changes, so a schema attached from a
+     * precompiled image can stay in read-only flash. */
     for (size_t i = 0; i < schema->entry_count; ++i) {
         cfgpack_type_t t = schema->entries[i].type;
-        if (t == CFGPACK_TYPE_STR) {
-            if (str_slot >= str_offsets_count) {
+        cfgpack_str_slot_t slot = CFGPACK_STR_SLOT_NONE;
+        uint8_t str_max = schema->entries[i].str_max;
+
+        /* A hand-built schema may leave str_max unset; the parsers reject
+         * these limits, so check them here too. */
+        if ((t == CFGPACK_TYPE_STR && str_max > CFGPACK_STR_MAX) ||
+            (t == CFGPACK_TYPE_FSTR && str_max > CFGPACK_FSTR_MAX)) {
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        if (str_max && t != CFGPACK_TYPE_STR && t != CFGPACK_TYPE_FSTR) {
+            return (CFGPACK_ERR_INVALID_TYPE);
+        }
+        if (t == CFGPACK_TYPE_STR || t == CFGPACK_TYPE_FSTR) {
+            if (str_slot >= str_offsets_count ||
+                str_slot >= CFGPACK_STR_SLOT_NONE) {
                 return (CFGPACK_ERR_BOUNDS);
             }
-            if (pool_offset > UINT16_MAX) {
+            if (!defaults && pool_offset > CFGPACK_STR_OFF_MAX) {
                 return (CFGPACK_ERR_BOUNDS);
             }
-            schema->entries[i].str_slot = (uint8_t)str_slot;
-            str_offsets[str_slot] = (uint16_t)pool_offset;
+            slot = (cfgpack_str_slot_t)str_slot;
+            str_offsets[str_slot] = defaults ? CFGPACK_STR_OFFSET_UNSET
+                                             : (cfgpack_str_off_t)pool_offset;
             str_slot++;
-            pool_offset += CFGPACK_STR_MAX + 1;
-        } else if (t == CFGPACK_TYPE_FSTR) {
-            if (str_slot >= str_offsets_count) {
+            pool_offset += cfgpack_entry_str_max(&schema->entries[i]) + 1;
+            if (defaults && schema->entries[i].has_default &&
+                !cow_default_in_bounds(&values[i], defaults_len)) {
                 return (CFGPACK_ERR_BOUNDS);
             }
-            if (pool_offset > UINT16_MAX) {
-                return (CFGPACK_ERR_BOUNDS);
+        }
+        if (schema->entries[i].str_slot != slot) {
+            if (!slots) {
+                return (CFGPACK_ERR_ARGS);
             }
-            schema->entries[i].str_slot = (uint8_t)str_slot;
-            str_offsets[str_slot] = (uint16_t)pool_offset;
-            str_slot++;
-            pool_offset += CFGPACK_FSTR_MAX + 1;
-        } else {
-            schema->entries[i].str_slot = CFGPACK_STR_SLOT_NONE;
+            slots[i].str_slot = slot;
         }
     }
-    if (pool_offset > str_pool_cap) {
+    /* Copy-on-write slots are handed out on first write instead. */
+    if (!defaults && pool_offset > str_pool_cap) {
         return (CFGPACK_ERR_BOUNDS);
     }
 
     /* Set up context fields — values and str_pool already contain defaults
      * from schema parsing, so we must NOT zero them. */
-    memset(ctx->present, 0, sizeof(ctx->present));
+    memset(ctx->present, 0, cfgpack_bitmap_bytes(ctx));
+    memset(ctx->dirty, 0, cfgpack_bitmap_bytes(ctx));
     ctx->schema = schema;
     ctx->values = values;
     ctx->values_count = values_count;
@@ -125,6 +223,47 @@ cfgpack_err_t cfgpack_init(cfgpack_ctx_t *ctx,
     ctx->str_pool_cap = str_pool_cap;
     ctx->str_offsets = str_offsets;
     ctx->str_offsets_count = str_offsets_count;
+    ctx->name_index = NULL;
+    ctx->index_table = NULL;
+    ctx->index_table_len = 0;
+#ifdef CFGPACK_PACKED_ARENA
+    ctx->packed = NULL;
+#endif
+    ctx->cow_base = defaults;
+    ctx->cow_len = defaults_len;
+    ctx->str_pool_used = 0;
+#ifdef CFGPACK_SIZE_CACHE
+    ctx->size_cached = 0;
+#endif
+    ctx->header = 0;
+    ctx->set_count = 0;
+#ifdef CFGPACK_LAZY
+    ctx->lazy_off = NULL;
+    ctx->lazy_blob = NULL;
+    ctx->lazy_len = 0;
+#endif
+#ifdef CFGPACK_DEFAULTS_BLOB
+    ctx->def_off = NULL;
+    ctx->def_blob = NULL;
+    ctx->def_len = 0;
+#endif
+#ifdef CFGPACK_TXN
+    ctx->txn_buf = NULL;
+    ctx->txn_cap = 0;
+    ctx->txn_len = 0;
+#endif
+#ifdef CFGPACK_NOTIFY
+    ctx->subs = NULL;
+    ctx->sub_count = 0;
+    ctx->notify_bits = NULL;
+    ctx->notifying = 0;
+#endif
+#ifdef CFGPACK_SEQLOCK
+    ctx->seq = 0;
+#endif
+#ifdef CFGPACK_STATS
+    ctx->stats = NULL;
+#endif
 
     /* Mark entries with defaults as present */
     for (size_t i = 0; i < schema->entry_count; ++i) {
@@ -132,73 +271,811 @@ cfgpack_err_t cfgpack_init(cfgpack_ctx_t *ctx,
             cfgpack_presence_set(ctx, i);
         }
     }
-
-    return (CFGPACK_OK);
+
+    return (CFGPACK_OK);
+}
+
+#ifdef CFGPACK_LARGE_SCHEMA
+cfgpack_err_t cfgpack_ctx_bitmaps(cfgpack_ctx_t *ctx,
+                                  uint8_t *bits,
+                                  size_t bits_cap) {
+    size_t n;
+
+    if (!ctx || !bits) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    /* present | dirty | saved dirty (see CFGPACK_BITMAP_BYTES()) */
+    n = bits_cap / 3;
+    ctx->present = bits;
+    ctx->dirty = bits + n;
+    ctx->bitmap_bytes = n;
+    return (CFGPACK_OK);
+}
+#endif
+
+cfgpack_err_t cfgpack_init(cfgpack_ctx_t *ctx,
+                           cfgpack_schema_t *schema,
+                           cfgpack_value_t *values,
+                           size_t values_count,
+                           char *str_pool,
+                           size_t str_pool_cap,
+                           cfgpack_str_off_t *str_offsets,
+                           size_t str_offsets_count) {
+    return (init_impl(ctx, schema, schema ? schema->entries : NULL, values,
+                      values_count, str_pool, str_pool_cap, str_offsets,
+                      str_offsets_count, NULL, 0));
+}
+
+cfgpack_err_t cfgpack_init_cow(cfgpack_ctx_t *ctx,
+                               cfgpack_schema_t *schema,
+                               cfgpack_value_t *values,
+                               size_t values_count,
+                               char *str_pool,
+                               size_t str_pool_cap,
+                               cfgpack_str_off_t *str_offsets,
+                               size_t str_offsets_count,
+                               const uint8_t *defaults,
+                               size_t defaults_len) {
+    if (!defaults) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    return (init_impl(ctx, schema, schema ? schema->entries : NULL, values,
+                      values_count, str_pool, str_pool_cap, str_offsets,
+                      str_offsets_count, defaults, defaults_len));
+}
+
+cfgpack_err_t cfgpack_init_shared(cfgpack_ctx_t *ctx,
+                                  const cfgpack_ctx_t *proto,
+                                  cfgpack_value_t *values,
+                                  size_t values_count,
+                                  char *str_pool,
+                                  size_t str_pool_cap,
+                                  cfgpack_str_off_t *str_offsets,
+                                  size_t str_offsets_count) {
+    const cfgpack_schema_t *schema;
+    cfgpack_err_t err;
+
+    if (!ctx || !proto || ctx == proto || !proto->schema || !values) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    /* The prototype's values must all be in values[] (or the cow blob) */
+    if (cfgpack_is_packed(proto) || cfgpack_is_lazy(proto) ||
+        (proto->cow_base && proto->str_pool_used)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    schema = proto->schema;
+    if (values_count < schema->entry_count) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    memcpy(values, proto->values, schema->entry_count * sizeof(*values));
+    err = init_impl(ctx, schema, NULL, values, values_count, str_pool,
+                    str_pool_cap, str_offsets, str_offsets_count,
+                    proto->cow_base, proto->cow_len);
+    if (err != CFGPACK_OK) {
+        return (err);
+    }
+
+    /* Copy-on-write strings stay in the blob; pooled ones are copied */
+    for (size_t i = 0; i < schema->entry_count && !proto->cow_base; ++i) {
+        const cfgpack_entry_t *e = &schema->entries[i];
+
+        if (e->str_slot != CFGPACK_STR_SLOT_NONE) {
+            memcpy(ctx->str_pool + ctx->str_offsets[e->str_slot],
+                   proto->str_pool + proto->str_offsets[e->str_slot],
+                   cfgpack_entry_str_max(e) + 1);
+            CFGPACK_STAT_ADD(ctx, pool_bytes, cfgpack_entry_str_max(e) + 1);
+        }
+    }
+    memcpy(ctx->present, proto->present,
+           (schema->entry_count + CHAR_BIT - 1) / CHAR_BIT);
+    ctx->name_index = proto->name_index;
+    ctx->index_table = proto->index_table;
+    ctx->index_table_len = proto->index_table_len;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_str_slot(cfgpack_ctx_t *ctx,
+                               const cfgpack_entry_t *e,
+                               cfgpack_str_off_t *pool_off) {
+    size_t need;
+
+    if (e->str_slot == CFGPACK_STR_SLOT_NONE ||
+        (size_t)e->str_slot >= ctx->str_offsets_count) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    need = cfgpack_entry_str_max(e) + 1;
+    if (ctx->str_offsets[e->str_slot] == CFGPACK_STR_OFFSET_UNSET &&
+        ctx->cow_base) {
+        if (ctx->str_pool_used + need > ctx->str_pool_cap ||
+            ctx->str_pool_used >= CFGPACK_STR_OFFSET_UNSET) {
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        ctx->str_offsets[e->str_slot] =
+            (cfgpack_str_off_t)ctx->str_pool_used;
+        ctx->str_pool_used += need;
+    }
+    *pool_off = ctx->str_offsets[e->str_slot];
+    if ((size_t)*pool_off + need > ctx->str_pool_cap) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_name_index_init(cfgpack_ctx_t *ctx,
+                                      uint64_t *index,
+                                      size_t index_cap) {
+    const cfgpack_schema_t *schema;
+    size_t n;
+
+    if (!ctx || !ctx->schema || !index) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    schema = ctx->schema;
+    n = schema->entry_count;
+    if (index_cap < n || n > 0xFFFF + 1u) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    /* Key = packed name (bits 63..24) | entry offset (bits 15..0) */
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t key;
+        if (!pack_name(schema->entries[i].name, &key)) {
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        key |= (uint64_t)i;
+
+        /* Insertion sort: schemas are small and this runs once */
+        size_t j = i;
+        while (j > 0 && index[j - 1] > key) {
+            index[j] = index[j - 1];
+            --j;
+        }
+        index[j] = key;
+    }
+    for (size_t i = 1; i < n; ++i) {
+        if ((index[i] >> 16) == (index[i - 1] >> 16)) {
+            return (CFGPACK_ERR_DUPLICATE);
+        }
+    }
+
+    ctx->name_index = index;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_index_table_init(cfgpack_ctx_t *ctx,
+                                       uint8_t *table,
+                                       size_t table_cap) {
+    const cfgpack_schema_t *schema;
+    size_t len = 0;
+
+    if (!ctx || !ctx->schema || !table) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    schema = ctx->schema;
+    if (schema->entry_count >= UINT8_MAX) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        if ((size_t)schema->entries[i].index + 1 > len) {
+            len = (size_t)schema->entries[i].index + 1;
+        }
+    }
+    if (len > table_cap || len > CFGPACK_INDEX_TABLE_MAX) {
+        return (CFGPACK_ERR_BOUNDS); /* sparse: keep binary search */
+    }
+
+    memset(table, UINT8_MAX, len);
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        table[schema->entries[i].index] = (uint8_t)i;
+    }
+    ctx->index_table = table;
+    ctx->index_table_len = len;
+    return (CFGPACK_OK);
+}
+
+#ifdef CFGPACK_PACKED_ARENA
+/**
+ * @brief Packed arena width of a value of type @p t.
+ */
+static size_t packed_width(cfgpack_type_t t) {
+    switch (t) {
+    case CFGPACK_TYPE_U8:
+    case CFGPACK_TYPE_I8:
+    case CFGPACK_TYPE_FSTR: return (1);
+    case CFGPACK_TYPE_U16:
+    case CFGPACK_TYPE_I16:
+    case CFGPACK_TYPE_STR: return (2);
+    case CFGPACK_TYPE_U32:
+    case CFGPACK_TYPE_I32:
+    case CFGPACK_TYPE_F32: return (4);
+    case CFGPACK_TYPE_U64:
+    case CFGPACK_TYPE_I64:
+    case CFGPACK_TYPE_F64: return (8);
+    }
+    return (8);
+}
+
+/**
+ * @brief Size of the per-entry offset header, rounded up for 8-byte values.
+ */
+static size_t packed_header_size(size_t entry_count) {
+    return ((entry_count * sizeof(uint16_t) + 7u) & ~(size_t)7u);
+}
+
+size_t cfgpack_packed_size(const cfgpack_schema_t *schema) {
+    size_t size;
+
+    if (!schema) {
+        return (0);
+    }
+    size = packed_header_size(schema->entry_count);
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        size += packed_width(schema->entries[i].type);
+    }
+    return (size);
+}
+
+cfgpack_err_t cfgpack_packed_init(cfgpack_ctx_t *ctx,
+                                  void *arena,
+                                  size_t arena_cap) {
+    const cfgpack_schema_t *schema;
+    uint8_t *base = (uint8_t *)arena;
+    size_t pos;
+
+    if (!ctx || !ctx->schema || !ctx->values || ctx->cow_base || !arena ||
+        ((uintptr_t)arena & 7u) != 0) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    schema = ctx->schema;
+    if (arena_cap < cfgpack_packed_size(schema) ||
+        cfgpack_packed_size(schema) > UINT16_MAX) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    /* Widest values first: each group keeps the next naturally aligned */
+    pos = packed_header_size(schema->entry_count);
+    for (size_t width = 8; width > 0; width /= 2) {
+        for (size_t i = 0; i < schema->entry_count; ++i) {
+            uint16_t p16 = (uint16_t)pos;
+            if (packed_width(schema->entries[i].type) != width) {
+                continue;
+            }
+            memcpy(base + i * sizeof(uint16_t), &p16, sizeof(p16));
+            pos += width;
+        }
+    }
+
+    /* Switch storage last so the copy reads the old slots */
+    ctx->packed = base;
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        cfgpack_value_t v = ctx->values[i];
+        v.type = schema->entries[i].type;
+        cfgpack_value_store(ctx, i, &v);
+    }
+    ctx->values = NULL;
+    ctx->values_count = 0;
+#ifdef CFGPACK_SIZE_CACHE
+    if (ctx->size_cached) {
+        /* Stored values may have been truncated to their schema width */
+        return (cfgpack_size_cache_init(ctx));
+    }
+#endif
+    return (CFGPACK_OK);
+}
+#endif /* CFGPACK_PACKED_ARENA */
+
+void cfgpack_free(cfgpack_ctx_t *ctx) {
+    (void)ctx; /* no-op: caller owns buffers */
+}
+
+static int type_matches(cfgpack_type_t expect, const cfgpack_value_t *v) {
+    return (expect == v->type);
+}
+
+/**
+ * @brief Check a value against its entry's type and string length limit.
+ *
+ * @param entry Schema entry the value is for.
+ * @param value Value to be stored.
+ * @return CFGPACK_OK, CFGPACK_ERR_TYPE_MISMATCH or CFGPACK_ERR_STR_TOO_LONG.
+ */
+static cfgpack_err_t check_value(const cfgpack_entry_t *entry,
+                                 const cfgpack_value_t *value) {
+    if (!type_matches(entry->type, value)) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    if (value->type == CFGPACK_TYPE_STR &&
+        value->v.str.len > cfgpack_entry_str_max(entry)) {
+        return (CFGPACK_ERR_STR_TOO_LONG);
+    }
+    if (value->type == CFGPACK_TYPE_FSTR &&
+        value->v.fstr.len > cfgpack_entry_str_max(entry)) {
+        return (CFGPACK_ERR_STR_TOO_LONG);
+    }
+    return (CFGPACK_OK);
+}
+
+/* ─── Transaction journal ─────────────────────────────────────────────────── */
+
+#ifdef CFGPACK_TXN
+  #define TXN_PRESENT 1u
+  #define TXN_DIRTY   2u
+  #define TXN_STR     4u
+
+/**
+ * @brief Journal record of one set, stored after the string bytes it
+ *        restores so the journal can be replayed from its end.
+ */
+typedef struct {
+    cfgpack_value_t old; /**< Stored value before the set. */
+    uint32_t off;        /**< Zero-based entry offset. */
+    uint32_t lazy;       /**< lazy_off[off] before the set, or 0. */
+    uint32_t slot_off;   /**< str_offsets[] of a string entry's slot. */
+    uint16_t str_len;    /**< String bytes journaled before the record. */
+    uint8_t flags;       /**< TXN_PRESENT, TXN_DIRTY, TXN_STR. */
+} txn_rec_t;
+
+typedef char
+    txn_rec_fits[sizeof(txn_rec_t) <= CFGPACK_TXN_REC_BYTES ? 1 : -1];
+
+/**
+ * @brief Pool bytes of entry @p off's current string to journal, or NULL.
+ *
+ * Copy-on-write defaults still live in the immutable blob and need no copy.
+ */
+static const char *txn_str(const cfgpack_ctx_t *ctx,
+                           size_t off,
+                           const cfgpack_value_t *v,
+                           uint16_t *len) {
+    const cfgpack_entry_t *e = &ctx->schema->entries[off];
+    size_t n;
+
+    *len = 0;
+    if (e->str_slot == CFGPACK_STR_SLOT_NONE ||
+        (size_t)e->str_slot >= ctx->str_offsets_count ||
+        ctx->str_offsets[e->str_slot] == CFGPACK_STR_OFFSET_UNSET) {
+        return (NULL);
+    }
+    n = (e->type == CFGPACK_TYPE_STR) ? v->v.str.len : v->v.fstr.len;
+    if (n > cfgpack_entry_str_max(e) ||
+        (size_t)ctx->str_offsets[e->str_slot] + n > ctx->str_pool_cap) {
+        return (NULL);
+    }
+    *len = (uint16_t)n;
+    return (ctx->str_pool + ctx->str_offsets[e->str_slot]);
+}
+
+/**
+ * @brief Journal bytes a set of entry @p off takes (0 outside a transaction).
+ */
+static size_t txn_need(const cfgpack_ctx_t *ctx, size_t off) {
+    cfgpack_value_t v;
+    uint16_t len;
+
+    if (!ctx->txn_buf) {
+        return (0);
+    }
+    cfgpack_value_load(ctx, off, &v);
+    (void)txn_str(ctx, off, &v, &len);
+    return (CFGPACK_TXN_REC_BYTES + len);
+}
+
+/**
+ * @brief Whether @p need journal bytes fit (always outside a transaction).
+ */
+static int txn_room(const cfgpack_ctx_t *ctx, size_t need) {
+    return (!ctx->txn_buf || need <= ctx->txn_cap - ctx->txn_len);
+}
+
+/**
+ * @brief Journal entry @p off's state before a set changes it.
+ *
+ * @return CFGPACK_OK (also outside a transaction); CFGPACK_ERR_BOUNDS if
+ *         the journal is full.
+ */
+static cfgpack_err_t txn_record(cfgpack_ctx_t *ctx, size_t off) {
+    const cfgpack_entry_t *e = &ctx->schema->entries[off];
+    const char *str;
+    txn_rec_t rec;
+
+    if (!ctx->txn_buf) {
+        return (CFGPACK_OK);
+    }
+    memset(&rec, 0, sizeof(rec));
+    cfgpack_value_load(ctx, off, &rec.old);
+    str = txn_str(ctx, off, &rec.old, &rec.str_len);
+    if (ctx->txn_cap - ctx->txn_len < CFGPACK_TXN_REC_BYTES + rec.str_len) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    rec.off = (uint32_t)off;
+    rec.lazy = cfgpack_lazy_pending(ctx, off);
+    if (e->str_slot != CFGPACK_STR_SLOT_NONE &&
+        (size_t)e->str_slot < ctx->str_offsets_count) {
+        rec.slot_off = ctx->str_offsets[e->str_slot];
+    }
+    rec.flags = (uint8_t)((cfgpack_presence_get(ctx, off) ? TXN_PRESENT : 0) |
+                          (cfgpack_dirty_get(ctx, off) ? TXN_DIRTY : 0) |
+                          (str ? TXN_STR : 0));
+    if (str) {
+        memcpy(ctx->txn_buf + ctx->txn_len, str, rec.str_len);
+        ctx->txn_len += rec.str_len;
+    }
+    memcpy(ctx->txn_buf + ctx->txn_len, &rec, sizeof(rec));
+    ctx->txn_len += CFGPACK_TXN_REC_BYTES;
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Put one journaled entry back, keeping the size cache in step.
+ */
+static void txn_undo(cfgpack_ctx_t *ctx,
+                     const txn_rec_t *rec,
+                     const uint8_t *str) {
+    const cfgpack_entry_t *e = &ctx->schema->entries[rec->off];
+    size_t off = rec->off;
+    int present = (rec->flags & TXN_PRESENT) != 0;
+
+    if (cfgpack_presence_get(ctx, off) && !cfgpack_lazy_pending(ctx, off)) {
+        cfgpack_size_sub(ctx, off);
+    }
+    if (e->str_slot != CFGPACK_STR_SLOT_NONE &&
+        (size_t)e->str_slot < ctx->str_offsets_count) {
+        ctx->str_offsets[e->str_slot] = (cfgpack_str_off_t)rec->slot_off;
+        if (str) {
+            char *dst = ctx->str_pool + rec->slot_off;
+            memcpy(dst, str, rec->str_len);
+            dst[rec->str_len] = '\0';
+            CFGPACK_STAT_ADD(ctx, pool_bytes, rec->str_len);
+        }
+    }
+    cfgpack_value_store(ctx, off, &rec->old);
+    cfgpack_lazy_mark(ctx, off, rec->lazy);
+    if (present) {
+        cfgpack_presence_set(ctx, off);
+    } else {
+        cfgpack_presence_clear(ctx, off);
+    }
+    if (rec->flags & TXN_DIRTY) {
+        cfgpack_dirty_set(ctx, off);
+    } else {
+        cfgpack_dirty_clear(ctx, off);
+    }
+    if (present && !rec->lazy) {
+        cfgpack_size_add(ctx, off);
+    }
+}
+
+cfgpack_err_t cfgpack_txn_begin(cfgpack_ctx_t *ctx,
+                                void *undo,
+                                size_t undo_cap) {
+    if (!ctx || !undo || ctx->txn_buf) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    ctx->txn_buf = (uint8_t *)undo;
+    ctx->txn_cap = undo_cap;
+    ctx->txn_len = 0;
+    ctx->txn_pool_used = ctx->str_pool_used;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_txn_commit(cfgpack_ctx_t *ctx) {
+    if (!ctx || !ctx->txn_buf) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    ctx->txn_buf = NULL;
+    ctx->txn_cap = 0;
+    ctx->txn_len = 0;
+    cfgpack_notify_dispatch(ctx);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_txn_abort(cfgpack_ctx_t *ctx) {
+    size_t pos;
+
+    if (!ctx || !ctx->txn_buf) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    /* Newest first, so an entry set twice ends at its oldest state */
+    pos = ctx->txn_len;
+    cfgpack_seq_write_begin(ctx);
+    while (pos >= CFGPACK_TXN_REC_BYTES) {
+        txn_rec_t rec;
+
+        pos -= CFGPACK_TXN_REC_BYTES;
+        memcpy(&rec, ctx->txn_buf + pos, sizeof(rec));
+        pos -= rec.str_len;
+        txn_undo(ctx, &rec,
+                 (rec.flags & TXN_STR) ? ctx->txn_buf + pos : NULL);
+    }
+    ctx->str_pool_used = ctx->txn_pool_used;
+    cfgpack_seq_write_end(ctx);
+    return (cfgpack_txn_commit(ctx));
+}
+#else /* !CFGPACK_TXN */
+static size_t txn_need(const cfgpack_ctx_t *ctx, size_t off) {
+    (void)ctx;
+    (void)off;
+    return (0);
+}
+
+static int txn_room(const cfgpack_ctx_t *ctx, size_t need) {
+    (void)ctx;
+    (void)need;
+    return (1);
+}
+
+static cfgpack_err_t txn_record(cfgpack_ctx_t *ctx, size_t off) {
+    (void)ctx;
+    (void)off;
+    return (CFGPACK_OK);
+}
+#endif /* CFGPACK_TXN */
+
+/**
+ * @brief Store a value into a known entry; the body of cfgpack_set().
+ */
+static cfgpack_err_t set_entry(cfgpack_ctx_t *ctx,
+                               const cfgpack_entry_t *entry,
+                               const cfgpack_value_t *value) {
+    cfgpack_err_t rc;
+    size_t off;
+
+    rc = check_value(entry, value);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    off = entry_offset(ctx->schema, entry);
+    rc = txn_record(ctx, off);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    cfgpack_seq_write_begin(ctx);
+    cfgpack_value_commit(ctx, off, value);
+    cfgpack_dirty_set(ctx, off);
+    cfgpack_notify_mark(ctx, off);
+    cfgpack_seq_write_end(ctx);
+    cfgpack_notify_dispatch(ctx);
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Read the value of a known entry; the body of cfgpack_get().
+ */
+static cfgpack_err_t get_entry(const cfgpack_ctx_t *ctx,
+                               const cfgpack_entry_t *entry,
+                               cfgpack_value_t *out_value) {
+    cfgpack_err_t rc;
+    size_t off;
+
+    off = entry_offset(ctx->schema, entry);
+    if (!cfgpack_presence_get(ctx, off)) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    rc = cfgpack_lazy_load(ctx, off);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    cfgpack_value_load(ctx, off, out_value);
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Entry at schema position @p pos, or NULL past the last one.
+ */
+static const cfgpack_entry_t *entry_at(const cfgpack_ctx_t *ctx,
+                                       size_t pos) {
+    if (pos >= ctx->schema->entry_count) {
+        return (NULL);
+    }
+    return (&ctx->schema->entries[pos]);
+}
+
+cfgpack_err_t cfgpack_set(cfgpack_ctx_t *ctx,
+                          uint16_t index,
+                          const cfgpack_value_t *value) {
+    const cfgpack_entry_t *entry;
+
+    if (!ctx || !value) {
+        return (CFGPACK_ERR_ARGS);
+    }
+
+    if (index == 0) {
+        return (CFGPACK_ERR_RESERVED_INDEX);
+    }
+    entry = cfgpack_find_entry(ctx, index);
+    if (!entry) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    return (set_entry(ctx, entry, value));
+}
+
+cfgpack_err_t cfgpack_get(const cfgpack_ctx_t *ctx,
+                          uint16_t index,
+                          cfgpack_value_t *out_value) {
+    const cfgpack_entry_t *entry;
+
+    if (!ctx || !out_value) {
+        return (CFGPACK_ERR_ARGS);
+    }
+
+    if (index == 0) {
+        return (CFGPACK_ERR_RESERVED_INDEX);
+    }
+    entry = cfgpack_find_entry(ctx, index);
+    if (!entry) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    return (get_entry(ctx, entry, out_value));
 }
 
-void cfgpack_free(cfgpack_ctx_t *ctx) {
-    (void)ctx; /* no-op: caller owns buffers */
-}
+cfgpack_err_t cfgpack_set_at(cfgpack_ctx_t *ctx,
+                             size_t pos,
+                             const cfgpack_value_t *value) {
+    const cfgpack_entry_t *entry;
 
-static int type_matches(cfgpack_type_t expect, const cfgpack_value_t *v) {
-    return (expect == v->type);
+    if (!ctx || !value) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    entry = entry_at(ctx, pos);
+    if (!entry) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    return (set_entry(ctx, entry, value));
 }
 
-cfgpack_err_t cfgpack_set(cfgpack_ctx_t *ctx,
-                          uint16_t index,
-                          const cfgpack_value_t *value) {
+cfgpack_err_t cfgpack_get_at(const cfgpack_ctx_t *ctx,
+                             size_t pos,
+                             cfgpack_value_t *out_value) {
     const cfgpack_entry_t *entry;
-    size_t off;
 
-    if (!ctx || !value) {
+    if (!ctx || !out_value) {
         return (CFGPACK_ERR_ARGS);
     }
+    entry = entry_at(ctx, pos);
+    if (!entry) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    return (get_entry(ctx, entry, out_value));
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Batch access
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Resolve the next index of an ascending batch.
+ *
+ * Without an index table, advances @p pos through the sorted entries
+ * instead of searching from scratch, so a whole batch costs one walk.
+ *
+ * @param ctx   Initialized context.
+ * @param pos   Walk position; 0 before the first call of a batch.
+ * @param prev  Previous index of the batch (0 before the first).
+ * @param index Index to resolve.
+ * @param entry Receives the entry.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_RESERVED_INDEX for index 0;
+ *         CFGPACK_ERR_ARGS if @p index is not above @p prev;
+ *         CFGPACK_ERR_MISSING if it is not in the schema.
+ */
+static cfgpack_err_t walk_entry(const cfgpack_ctx_t *ctx,
+                                size_t *pos,
+                                uint16_t prev,
+                                uint16_t index,
+                                const cfgpack_entry_t **entry) {
+    const cfgpack_schema_t *schema = ctx->schema;
 
     if (index == 0) {
         return (CFGPACK_ERR_RESERVED_INDEX);
     }
-    entry = find_entry(ctx->schema, index);
-    if (!entry) {
-        return (CFGPACK_ERR_MISSING);
+    if (index <= prev) {
+        return (CFGPACK_ERR_ARGS);
     }
-    if (!type_matches(entry->type, value)) {
-        return (CFGPACK_ERR_TYPE_MISMATCH);
+    if (ctx->index_table) {
+        *entry = cfgpack_find_entry(ctx, index);
+        return (*entry ? CFGPACK_OK : CFGPACK_ERR_MISSING);
     }
-    if (value->type == CFGPACK_TYPE_STR && value->v.str.len > CFGPACK_STR_MAX) {
-        return (CFGPACK_ERR_STR_TOO_LONG);
+    while (*pos < schema->entry_count &&
+           schema->entries[*pos].index < index) {
+        ++*pos;
     }
-    if (value->type == CFGPACK_TYPE_FSTR &&
-        value->v.fstr.len > CFGPACK_FSTR_MAX) {
-        return (CFGPACK_ERR_STR_TOO_LONG);
+    if (*pos == schema->entry_count || schema->entries[*pos].index != index) {
+        return (CFGPACK_ERR_MISSING);
     }
-    off = entry_offset(ctx->schema, entry);
-    ctx->values[off] = *value;
-    cfgpack_presence_set(ctx, off);
+    *entry = &schema->entries[*pos];
     return (CFGPACK_OK);
 }
 
-cfgpack_err_t cfgpack_get(const cfgpack_ctx_t *ctx,
-                          uint16_t index,
-                          cfgpack_value_t *out_value) {
+cfgpack_err_t cfgpack_get_many(const cfgpack_ctx_t *ctx,
+                               const uint16_t *indices,
+                               size_t count,
+                               cfgpack_value_t *out_values,
+                               size_t *failed) {
     const cfgpack_entry_t *entry;
-    size_t off;
+    uint16_t prev = 0;
+    size_t pos = 0;
 
-    if (!ctx || !out_value) {
+    if (!ctx || (count && (!indices || !out_values))) {
         return (CFGPACK_ERR_ARGS);
     }
 
-    if (index == 0) {
-        return (CFGPACK_ERR_RESERVED_INDEX);
+    for (size_t i = 0; i < count; ++i) {
+        cfgpack_err_t rc = walk_entry(ctx, &pos, prev, indices[i], &entry);
+        size_t off;
+
+        if (rc == CFGPACK_OK) {
+            off = entry_offset(ctx->schema, entry);
+            if (!cfgpack_presence_get(ctx, off)) {
+                rc = CFGPACK_ERR_MISSING;
+            } else {
+                rc = cfgpack_lazy_load(ctx, off);
+            }
+        }
+        if (rc != CFGPACK_OK) {
+            if (failed) {
+                *failed = i;
+            }
+            return (rc);
+        }
+        cfgpack_value_load(ctx, off, &out_values[i]);
+        prev = indices[i];
     }
-    entry = find_entry(ctx->schema, index);
-    if (!entry) {
-        return (CFGPACK_ERR_MISSING);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_set_many(cfgpack_ctx_t *ctx,
+                               const uint16_t *indices,
+                               const cfgpack_value_t *values,
+                               size_t count,
+                               size_t *failed) {
+    const cfgpack_entry_t *entry;
+    uint16_t prev = 0;
+    size_t pos = 0;
+    size_t journal = 0;
+
+    if (!ctx || (count && (!indices || !values))) {
+        return (CFGPACK_ERR_ARGS);
     }
-    off = entry_offset(ctx->schema, entry);
-    if (!cfgpack_presence_get(ctx, off)) {
-        return (CFGPACK_ERR_MISSING);
+
+    /* Validate the whole batch, and its room in an open transaction's
+     * journal, before storing anything */
+    for (size_t i = 0; i < count; ++i) {
+        cfgpack_err_t rc = walk_entry(ctx, &pos, prev, indices[i], &entry);
+
+        if (rc == CFGPACK_OK) {
+            rc = check_value(entry, &values[i]);
+        }
+        if (rc == CFGPACK_OK) {
+            journal += txn_need(ctx, entry_offset(ctx->schema, entry));
+            if (!txn_room(ctx, journal)) {
+                rc = CFGPACK_ERR_BOUNDS;
+            }
+        }
+        if (rc != CFGPACK_OK) {
+            if (failed) {
+                *failed = i;
+            }
+            return (rc);
+        }
+        prev = indices[i];
     }
-    *out_value = ctx->values[off];
+
+    prev = 0;
+    pos = 0;
+    cfgpack_seq_write_begin(ctx);
+    for (size_t i = 0; i < count; ++i) {
+        size_t off;
+
+        (void)walk_entry(ctx, &pos, prev, indices[i], &entry);
+        off = entry_offset(ctx->schema, entry);
+        (void)txn_record(ctx, off);
+        cfgpack_value_commit(ctx, off, &values[i]);
+        cfgpack_dirty_set(ctx, off);
+        cfgpack_notify_mark(ctx, off);
+        prev = indices[i];
+    }
+    cfgpack_seq_write_end(ctx);
+    cfgpack_notify_dispatch(ctx);
     return (CFGPACK_OK);
 }
 
@@ -206,66 +1083,97 @@ cfgpack_err_t cfgpack_set_by_name(cfgpack_ctx_t *ctx,
                                   const char *name,
                                   const cfgpack_value_t *value) {
     const cfgpack_entry_t *entry;
-    size_t off;
 
     if (!ctx || !name || !value) {
         return (CFGPACK_ERR_ARGS);
     }
 
-    entry = find_entry_by_name(ctx->schema, name);
+    entry = cfgpack_find_entry_by_name(ctx, name);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
-    if (!type_matches(entry->type, value)) {
-        return (CFGPACK_ERR_TYPE_MISMATCH);
-    }
-    if (value->type == CFGPACK_TYPE_STR && value->v.str.len > CFGPACK_STR_MAX) {
-        return (CFGPACK_ERR_STR_TOO_LONG);
-    }
-    if (value->type == CFGPACK_TYPE_FSTR &&
-        value->v.fstr.len > CFGPACK_FSTR_MAX) {
-        return (CFGPACK_ERR_STR_TOO_LONG);
-    }
-    off = entry_offset(ctx->schema, entry);
-    ctx->values[off] = *value;
-    cfgpack_presence_set(ctx, off);
-    return (CFGPACK_OK);
+    return (set_entry(ctx, entry, value));
 }
 
 cfgpack_err_t cfgpack_get_by_name(const cfgpack_ctx_t *ctx,
                                   const char *name,
                                   cfgpack_value_t *out_value) {
     const cfgpack_entry_t *entry;
-    size_t off;
 
     if (!ctx || !name || !out_value) {
         return (CFGPACK_ERR_ARGS);
     }
 
-    entry = find_entry_by_name(ctx->schema, name);
+    entry = cfgpack_find_entry_by_name(ctx, name);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
-    off = entry_offset(ctx->schema, entry);
-    if (!cfgpack_presence_get(ctx, off)) {
-        return (CFGPACK_ERR_MISSING);
-    }
-    *out_value = ctx->values[off];
-    return (CFGPACK_OK);
+    return (get_entry(ctx, entry, out_value));
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * String Setter/Getter Implementations (use string pool)
  * ═══════════════════════════════════════════════════════════════════════════ */
 
+/**
+ * @brief Store @p len bytes of @p str into a known `str` or `fstr` entry.
+ *
+ * Shared body of cfgpack_set_str(), cfgpack_set_fstr() and
+ * cfgpack_set_str_at(); the caller has checked the entry's type.
+ */
+static cfgpack_err_t set_string(cfgpack_ctx_t *ctx,
+                                const cfgpack_entry_t *entry,
+                                const char *str,
+                                size_t len) {
+    cfgpack_str_off_t pool_off;
+    size_t off;
+    cfgpack_value_t val;
+    char *dst;
+    cfgpack_err_t err;
+
+    if (len > cfgpack_entry_str_max(entry)) {
+        return (CFGPACK_ERR_STR_TOO_LONG);
+    }
+
+    off = entry_offset(ctx->schema, entry);
+    err = txn_record(ctx, off);
+    if (err != CFGPACK_OK) {
+        return (err);
+    }
+    /* A copy-on-write slot moves to the pool before the value does */
+    cfgpack_seq_write_begin(ctx);
+    err = cfgpack_str_slot(ctx, entry, &pool_off);
+    if (err != CFGPACK_OK) {
+        cfgpack_seq_write_end(ctx);
+        return (err);
+    }
+    dst = ctx->str_pool + pool_off;
+    memcpy(dst, str, len);
+    dst[len] = '\0';
+    CFGPACK_STAT_ADD(ctx, pool_bytes, len);
+
+    val.type = entry->type;
+    if (entry->type == CFGPACK_TYPE_STR) {
+        val.v.str.offset = pool_off;
+        val.v.str.len = (uint16_t)len;
+    } else {
+        val.v.fstr.offset = pool_off;
+        val.v.fstr.len = (uint8_t)len;
+        val.v.fstr._pad = 0;
+    }
+    cfgpack_value_commit(ctx, off, &val);
+    cfgpack_dirty_set(ctx, off);
+    cfgpack_notify_mark(ctx, off);
+    cfgpack_seq_write_end(ctx);
+    cfgpack_notify_dispatch(ctx);
+
+    return (CFGPACK_OK);
+}
+
 cfgpack_err_t cfgpack_set_str(cfgpack_ctx_t *ctx,
                               uint16_t index,
                               const char *str) {
     const cfgpack_entry_t *entry;
-    uint16_t pool_off;
-    size_t off;
-    size_t len;
-    char *dst;
 
     if (!ctx || !str) {
         return (CFGPACK_ERR_ARGS);
@@ -275,49 +1183,20 @@ cfgpack_err_t cfgpack_set_str(cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_RESERVED_INDEX);
     }
 
-    entry = find_entry(ctx->schema, index);
+    entry = cfgpack_find_entry(ctx, index);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
     if (entry->type != CFGPACK_TYPE_STR) {
         return (CFGPACK_ERR_TYPE_MISMATCH);
     }
-
-    len = strlen(str);
-    if (len > CFGPACK_STR_MAX) {
-        return (CFGPACK_ERR_STR_TOO_LONG);
-    }
-
-    off = entry_offset(ctx->schema, entry);
-    if (entry->str_slot == CFGPACK_STR_SLOT_NONE ||
-        (size_t)entry->str_slot >= ctx->str_offsets_count) {
-        return (CFGPACK_ERR_BOUNDS);
-    }
-
-    pool_off = ctx->str_offsets[entry->str_slot];
-    if ((size_t)pool_off + len + 1 > ctx->str_pool_cap) {
-        return (CFGPACK_ERR_BOUNDS);
-    }
-    dst = ctx->str_pool + pool_off;
-    memcpy(dst, str, len);
-    dst[len] = '\0';
-
-    ctx->values[off].type = CFGPACK_TYPE_STR;
-    ctx->values[off].v.str.offset = pool_off;
-    ctx->values[off].v.str.len = (uint16_t)len;
-    cfgpack_presence_set(ctx, off);
-
-    return (CFGPACK_OK);
+    return (set_string(ctx, entry, str, strlen(str)));
 }
 
 cfgpack_err_t cfgpack_set_fstr(cfgpack_ctx_t *ctx,
                                uint16_t index,
                                const char *str) {
     const cfgpack_entry_t *entry;
-    uint16_t pool_off;
-    size_t off;
-    size_t len;
-    char *dst;
 
     if (!ctx || !str) {
         return (CFGPACK_ERR_ARGS);
@@ -327,39 +1206,33 @@ cfgpack_err_t cfgpack_set_fstr(cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_RESERVED_INDEX);
     }
 
-    entry = find_entry(ctx->schema, index);
+    entry = cfgpack_find_entry(ctx, index);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
     if (entry->type != CFGPACK_TYPE_FSTR) {
         return (CFGPACK_ERR_TYPE_MISMATCH);
     }
+    return (set_string(ctx, entry, str, strlen(str)));
+}
 
-    len = strlen(str);
-    if (len > CFGPACK_FSTR_MAX) {
-        return (CFGPACK_ERR_STR_TOO_LONG);
-    }
+cfgpack_err_t cfgpack_set_str_at(cfgpack_ctx_t *ctx,
+                                 size_t pos,
+                                 const char *str,
+                                 size_t len) {
+    const cfgpack_entry_t *entry;
 
-    off = entry_offset(ctx->schema, entry);
-    if (entry->str_slot == CFGPACK_STR_SLOT_NONE ||
-        (size_t)entry->str_slot >= ctx->str_offsets_count) {
-        return (CFGPACK_ERR_BOUNDS);
+    if (!ctx || !str) {
+        return (CFGPACK_ERR_ARGS);
     }
-
-    pool_off = ctx->str_offsets[entry->str_slot];
-    if ((size_t)pool_off + len + 1 > ctx->str_pool_cap) {
-        return (CFGPACK_ERR_BOUNDS);
+    entry = entry_at(ctx, pos);
+    if (!entry) {
+        return (CFGPACK_ERR_MISSING);
     }
-    dst = ctx->str_pool + pool_off;
-    memcpy(dst, str, len);
-    dst[len] = '\0';
-
-    ctx->values[off].type = CFGPACK_TYPE_FSTR;
-    ctx->values[off].v.fstr.offset = pool_off;
-    ctx->values[off].v.fstr.len = (uint8_t)len;
-    cfgpack_presence_set(ctx, off);
-
-    return (CFGPACK_OK);
+    if (entry->type != CFGPACK_TYPE_STR && entry->type != CFGPACK_TYPE_FSTR) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    return (set_string(ctx, entry, str, len));
 }
 
 cfgpack_err_t cfgpack_set_str_by_name(cfgpack_ctx_t *ctx,
@@ -371,7 +1244,7 @@ cfgpack_err_t cfgpack_set_str_by_name(cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_ARGS);
     }
 
-    entry = find_entry_by_name(ctx->schema, name);
+    entry = cfgpack_find_entry_by_name(ctx, name);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
@@ -387,7 +1260,7 @@ cfgpack_err_t cfgpack_set_fstr_by_name(cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_ARGS);
     }
 
-    entry = find_entry_by_name(ctx->schema, name);
+    entry = cfgpack_find_entry_by_name(ctx, name);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
@@ -399,6 +1272,8 @@ cfgpack_err_t cfgpack_get_str(const cfgpack_ctx_t *ctx,
                               const char **out,
                               uint16_t *len) {
     const cfgpack_entry_t *entry;
+    cfgpack_value_t val;
+    cfgpack_err_t rc;
     size_t off;
 
     if (!ctx || !out || !len) {
@@ -409,7 +1284,7 @@ cfgpack_err_t cfgpack_get_str(const cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_RESERVED_INDEX);
     }
 
-    entry = find_entry(ctx->schema, index);
+    entry = cfgpack_find_entry(ctx, index);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
@@ -421,9 +1296,17 @@ cfgpack_err_t cfgpack_get_str(const cfgpack_ctx_t *ctx,
     if (!cfgpack_presence_get(ctx, off)) {
         return (CFGPACK_ERR_MISSING);
     }
+    rc = cfgpack_lazy_load(ctx, off);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
 
-    *out = ctx->str_pool + ctx->values[off].v.str.offset;
-    *len = ctx->values[off].v.str.len;
+    cfgpack_value_load(ctx, off, &val);
+    *out = cfgpack_str_data(ctx, entry, &val);
+    if (!*out) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    *len = val.v.str.len;
     return (CFGPACK_OK);
 }
 
@@ -432,6 +1315,8 @@ cfgpack_err_t cfgpack_get_fstr(const cfgpack_ctx_t *ctx,
                                const char **out,
                                uint8_t *len) {
     const cfgpack_entry_t *entry;
+    cfgpack_value_t val;
+    cfgpack_err_t rc;
     size_t off;
 
     if (!ctx || !out || !len) {
@@ -442,7 +1327,7 @@ cfgpack_err_t cfgpack_get_fstr(const cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_RESERVED_INDEX);
     }
 
-    entry = find_entry(ctx->schema, index);
+    entry = cfgpack_find_entry(ctx, index);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
@@ -454,9 +1339,17 @@ cfgpack_err_t cfgpack_get_fstr(const cfgpack_ctx_t *ctx,
     if (!cfgpack_presence_get(ctx, off)) {
         return (CFGPACK_ERR_MISSING);
     }
+    rc = cfgpack_lazy_load(ctx, off);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
 
-    *out = ctx->str_pool + ctx->values[off].v.fstr.offset;
-    *len = ctx->values[off].v.fstr.len;
+    cfgpack_value_load(ctx, off, &val);
+    *out = cfgpack_str_data(ctx, entry, &val);
+    if (!*out) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    *len = val.v.fstr.len;
     return (CFGPACK_OK);
 }
 
@@ -470,7 +1363,7 @@ cfgpack_err_t cfgpack_get_str_by_name(const cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_ARGS);
     }
 
-    entry = find_entry_by_name(ctx->schema, name);
+    entry = cfgpack_find_entry_by_name(ctx, name);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
@@ -487,13 +1380,222 @@ cfgpack_err_t cfgpack_get_fstr_by_name(const cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_ARGS);
     }
 
-    entry = find_entry_by_name(ctx->schema, name);
+    entry = cfgpack_find_entry_by_name(ctx, name);
     if (!entry) {
         return (CFGPACK_ERR_MISSING);
     }
     return (cfgpack_get_fstr(ctx, entry->index, out, len));
 }
 
+/**
+ * @brief Borrow the bytes of a present `str` or `fstr` entry.
+ *
+ * @param ctx   Initialized context.
+ * @param entry Entry of @p ctx's schema, or NULL if the lookup failed.
+ * @param out   Receives a pointer to the string bytes.
+ * @param len   Receives the string length.
+ * @return As cfgpack_get_str_view().
+ */
+static cfgpack_err_t str_view(const cfgpack_ctx_t *ctx,
+                              const cfgpack_entry_t *entry,
+                              const char **out,
+                              size_t *len) {
+    cfgpack_value_t val;
+    cfgpack_err_t rc;
+    size_t off;
+
+    if (!entry) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    if (entry->type != CFGPACK_TYPE_STR && entry->type != CFGPACK_TYPE_FSTR) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+
+    off = entry_offset(ctx->schema, entry);
+    if (!cfgpack_presence_get(ctx, off)) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    rc = cfgpack_lazy_load(ctx, off);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    cfgpack_value_load(ctx, off, &val);
+    *out = cfgpack_str_data(ctx, entry, &val);
+    if (!*out) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    *len = entry->type == CFGPACK_TYPE_STR ? val.v.str.len : val.v.fstr.len;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_get_str_view(const cfgpack_ctx_t *ctx,
+                                   uint16_t index,
+                                   const char **out,
+                                   size_t *len) {
+    if (!ctx || !out || !len) {
+        return (CFGPACK_ERR_ARGS);
+    }
+
+    if (index == 0) {
+        return (CFGPACK_ERR_RESERVED_INDEX);
+    }
+    return (str_view(ctx, cfgpack_find_entry(ctx, index), out, len));
+}
+
+cfgpack_err_t cfgpack_get_str_view_by_name(const cfgpack_ctx_t *ctx,
+                                           const char *name,
+                                           const char **out,
+                                           size_t *len) {
+    if (!ctx || !name || !out || !len) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    return (str_view(ctx, cfgpack_find_entry_by_name(ctx, name), out, len));
+}
+
+cfgpack_err_t cfgpack_get_str_view_at(const cfgpack_ctx_t *ctx,
+                                      size_t pos,
+                                      const char **out,
+                                      size_t *len) {
+    if (!ctx || !out || !len) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    return (str_view(ctx, entry_at(ctx, pos), out, len));
+}
+
+#ifdef CFGPACK_SEQLOCK
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Lock-Free Consistent Readers
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/** One read attempt of a consistent reader; ctx is checked by the caller. */
+typedef cfgpack_err_t (*seq_read_fn)(const cfgpack_ctx_t *ctx, void *arg);
+
+/**
+ * @brief Run @p fn between two counter loads until no write overlapped it.
+ *
+ * @return The result of the last clean attempt; CFGPACK_ERR_BUSY after
+ *         CFGPACK_SEQLOCK_RETRIES attempts that overlapped a write.
+ */
+static cfgpack_err_t seq_read(const cfgpack_ctx_t *ctx,
+                              seq_read_fn fn,
+                              void *arg) {
+    for (unsigned n = 0; n < CFGPACK_SEQLOCK_RETRIES; ++n) {
+        uint32_t seq = ctx->seq;
+        cfgpack_err_t rc;
+
+        CFGPACK_SEQLOCK_BARRIER();
+        if (seq & 1u) {
+            continue;
+        }
+        rc = fn(ctx, arg);
+        CFGPACK_SEQLOCK_BARRIER();
+        if (ctx->seq == seq) {
+            return (rc);
+        }
+    }
+    return (CFGPACK_ERR_BUSY);
+}
+
+typedef struct {
+    uint16_t index;
+    const uint16_t *indices;
+    size_t count;
+    cfgpack_value_t *out;
+    size_t failed;
+    char *buf;
+    size_t cap;
+    size_t *len;
+} seq_args_t;
+
+static cfgpack_err_t seq_get(const cfgpack_ctx_t *ctx, void *arg) {
+    seq_args_t *a = (seq_args_t *)arg;
+
+    return (cfgpack_get(ctx, a->index, a->out));
+}
+
+static cfgpack_err_t seq_get_many(const cfgpack_ctx_t *ctx, void *arg) {
+    seq_args_t *a = (seq_args_t *)arg;
+
+    a->failed = a->count;
+    return (cfgpack_get_many(ctx, a->indices, a->count, a->out, &a->failed));
+}
+
+static cfgpack_err_t seq_get_str(const cfgpack_ctx_t *ctx, void *arg) {
+    seq_args_t *a = (seq_args_t *)arg;
+    const char *s;
+    size_t n;
+    cfgpack_err_t rc = cfgpack_get_str_view(ctx, a->index, &s, &n);
+
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    /* n may be torn; the view is bounds-checked, the copy must be too */
+    if (n >= a->cap) {
+        return (CFGPACK_ERR_STR_TOO_LONG);
+    }
+    memcpy(a->buf, s, n);
+    a->buf[n] = '\0';
+    if (a->len) {
+        *a->len = n;
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_get_consistent(const cfgpack_ctx_t *ctx,
+                                     uint16_t index,
+                                     cfgpack_value_t *out_value) {
+    seq_args_t a = {0};
+
+    if (!ctx || !out_value || cfgpack_is_lazy(ctx)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    a.index = index;
+    a.out = out_value;
+    return (seq_read(ctx, seq_get, &a));
+}
+
+cfgpack_err_t cfgpack_get_many_consistent(const cfgpack_ctx_t *ctx,
+                                          const uint16_t *indices,
+                                          size_t count,
+                                          cfgpack_value_t *out_values,
+                                          size_t *failed) {
+    seq_args_t a = {0};
+    cfgpack_err_t rc;
+
+    if (!ctx || cfgpack_is_lazy(ctx)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    a.indices = indices;
+    a.count = count;
+    a.out = out_values;
+    /* Only the clean attempt may report a failed position */
+    rc = seq_read(ctx, seq_get_many, &a);
+    if (rc != CFGPACK_OK && rc != CFGPACK_ERR_BUSY && a.failed < count &&
+        failed) {
+        *failed = a.failed;
+    }
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_get_str_consistent(const cfgpack_ctx_t *ctx,
+                                         uint16_t index,
+                                         char *buf,
+                                         size_t cap,
+                                         size_t *len) {
+    seq_args_t a = {0};
+
+    if (!ctx || !buf || cfgpack_is_lazy(ctx)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    a.index = index;
+    a.buf = buf;
+    a.cap = cap;
+    a.len = len;
+    return (seq_read(ctx, seq_get_str, &a));
+}
+#endif /* CFGPACK_SEQLOCK */
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Utility Functions
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -503,20 +1605,43 @@ uint32_t cfgpack_get_version(const cfgpack_ctx_t *ctx) {
 }
 
 size_t cfgpack_get_size(const cfgpack_ctx_t *ctx) {
-    size_t count = 0;
-    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
-        if (cfgpack_presence_get(ctx, i)) {
-            count++;
+    return (cfgpack_bits_count(ctx->present, NULL, ctx->schema->entry_count));
+}
+
+size_t cfgpack_get_dirty_count(const cfgpack_ctx_t *ctx) {
+    return (cfgpack_bits_count(ctx->present, ctx->dirty,
+                               ctx->schema->entry_count));
+}
+
+cfgpack_err_t cfgpack_foreach_present(const cfgpack_ctx_t *ctx,
+                                      cfgpack_present_fn fn,
+                                      void *user) {
+    cfgpack_present_iter_t it;
+    size_t off;
+
+    if (!ctx || !fn) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    cfgpack_present_iter_init(&it, ctx, 0);
+    while (cfgpack_present_next(&it, &off)) {
+        cfgpack_err_t rc = fn(ctx, off, user);
+
+        if (rc != CFGPACK_OK) {
+            return (rc);
         }
     }
-    return (count);
+    return (CFGPACK_OK);
 }
 
 #ifdef CFGPACK_HOSTED
   #include <stdio.h>
 
 static void print_value(const cfgpack_ctx_t *ctx, size_t entry_off) {
-    const cfgpack_value_t *v = &ctx->values[entry_off];
+    cfgpack_value_t val;
+    const cfgpack_value_t *v = &val;
+    const char *s;
+
+    cfgpack_value_load(ctx, entry_off, &val);
     switch (v->type) {
     case CFGPACK_TYPE_U8: printf("%u", (unsigned)v->v.u64); break;
     case CFGPACK_TYPE_U16: printf("%u", (unsigned)v->v.u64); break;
@@ -529,16 +1654,19 @@ static void print_value(const cfgpack_ctx_t *ctx, size_t entry_off) {
     case CFGPACK_TYPE_F32: printf("%f", v->v.f32); break;
     case CFGPACK_TYPE_F64: printf("%lf", v->v.f64); break;
     case CFGPACK_TYPE_STR:
-        printf("%.*s", v->v.str.len, ctx->str_pool + v->v.str.offset);
+        s = cfgpack_str_data(ctx, &ctx->schema->entries[entry_off], v);
+        printf("%.*s", s ? v->v.str.len : 0, s ? s : "");
         break;
     case CFGPACK_TYPE_FSTR:
-        printf("%.*s", v->v.fstr.len, ctx->str_pool + v->v.fstr.offset);
+        s = cfgpack_str_data(ctx, &ctx->schema->entries[entry_off], v);
+        printf("%.*s", s ? v->v.fstr.len : 0, s ? s : "");
         break;
     }
 }
 
 cfgpack_err_t cfgpack_print(const cfgpack_ctx_t *ctx, uint16_t index) {
-    const cfgpack_entry_t *entry = find_entry(ctx->schema, index);
+    const cfgpack_entry_t *entry = cfgpack_find_entry(ctx, index);
+    cfgpack_err_t rc;
     size_t off;
 
     if (!entry) {
@@ -548,6 +1676,10 @@ cfgpack_err_t cfgpack_print(const cfgpack_ctx_t *ctx, uint16_t index) {
     if (!cfgpack_presence_get(ctx, off)) {
         return (CFGPACK_ERR_MISSING);
     }
+    rc = cfgpack_lazy_load(ctx, off);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
     printf("[%u] %s = ", entry->index, entry->name);
     print_value(ctx, off);
     printf("\n");
@@ -555,10 +1687,17 @@ cfgpack_err_t cfgpack_print(const cfgpack_ctx_t *ctx, uint16_t index) {
 }
 
 cfgpack_err_t cfgpack_print_all(const cfgpack_ctx_t *ctx) {
-    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
+    cfgpack_present_iter_t it;
+    size_t i;
+
+    cfgpack_present_iter_init(&it, ctx, 0);
+    while (cfgpack_present_next(&it, &i)) {
         const cfgpack_entry_t *e = &ctx->schema->entries[i];
-        if (!cfgpack_presence_get(ctx, i)) {
-            continue;
+        cfgpack_err_t rc;
+
+        rc = cfgpack_lazy_load(ctx, i);
+        if (rc != CFGPACK_OK) {
+            return (rc);
         }
         printf("[%u] %s = ", e->index, e->name);
         print_value(ctx, i);
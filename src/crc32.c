@@ -2,13 +2,78 @@
  * @file crc32.c
  * @brief CRC-32C (Castagnoli) implementation for cfgpack blob integrity.
  *
- * Nibble-at-a-time algorithm using reflected polynomial 0x82F63B78.
- * Lookup table is 16 entries (64 bytes) — good speed/size tradeoff
- * for embedded targets.
+ * Reflected polynomial 0x82F63B78.  The backend is chosen at compile time
+ * by CFGPACK_CRC_BACKEND (see config.h):
+ *
+ *   CFGPACK_CRC_NIBBLE - 16-entry table (64 bytes), the default; good
+ *                        speed/size tradeoff for small embedded targets
+ *   CFGPACK_CRC_SLICE8 - 8 x 256-entry tables (8 KB), eight bytes per step
+ *   CFGPACK_CRC_HW     - SSE4.2 _mm_crc32_* or ARMv8 __crc32c* intrinsics
+ *
+ * Hosted builds may define CFGPACK_CRC_DISPATCH to probe the CPU once and
+ * pick the instruction path at runtime, with slicing-by-8 as the fallback.
+ *
+ * Every backend implements the same raw update step (no pre/post
+ * inversion), so results are bit-identical.
  */
 
+#include "cfgpack/config.h"
+
 #include "crc32.h"
+#include "stats.h"
+
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Backend selection
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#if defined(CFGPACK_CRC_DISPATCH)
+  #define CRC_USE_SLICE8 1
+  #if defined(__x86_64__) && defined(__GNUC__)
+    #define CRC_USE_X86      1
+    #define CRC_HW_ATTR      __attribute__((target("sse4.2")))
+    #include <nmmintrin.h>
+  #elif defined(__aarch64__) && defined(__linux__) && defined(__GNUC__) &&    \
+      !defined(__AARCH64EB__)
+    #define CRC_USE_ARM      1
+    #if defined(__clang__)
+      #define CRC_HW_ATTR __attribute__((target("crc")))
+    #else
+      #define CRC_HW_ATTR __attribute__((target("+crc")))
+    #endif
+    #include <arm_acle.h>
+    #include <sys/auxv.h>
+    #ifndef HWCAP_CRC32
+      #define HWCAP_CRC32 (1 << 7)
+    #endif
+  #endif
+#elif CFGPACK_CRC_BACKEND == CFGPACK_CRC_HW
+  #define CRC_HW_ATTR
+  #if defined(__SSE4_2__)
+    #define CRC_USE_X86 1
+    #include <nmmintrin.h>
+  #elif defined(__ARM_FEATURE_CRC32) && !defined(__ARM_BIG_ENDIAN)
+    #define CRC_USE_ARM 1
+    #include <arm_acle.h>
+  #else
+    #error "CFGPACK_CRC_HW needs SSE4.2 or little-endian ARMv8 CRC32"
+  #endif
+#elif CFGPACK_CRC_BACKEND == CFGPACK_CRC_SLICE8
+  #define CRC_USE_SLICE8 1
+#elif CFGPACK_CRC_BACKEND != CFGPACK_CRC_NIBBLE
+  #error "Unknown CFGPACK_CRC_BACKEND"
+#endif
 
+#ifdef CRC_USE_SLICE8
+  #include "crc32_slice8.h"
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Raw update steps: crc is the running register (already inverted)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#if !defined(CRC_USE_SLICE8) && !defined(CRC_USE_X86) && !defined(CRC_USE_ARM)
 /* CRC-32C (Castagnoli) nibble table — reflected polynomial 0x82F63B78 */
 static const uint32_t crc_table[16] = {0x00000000, 0x105EC76F, 0x20BD8EDE,
                                        0x30E349B1, 0x417B1DBC, 0x5125DAD3,
@@ -17,11 +82,167 @@ static const uint32_t crc_table[16] = {0x00000000, 0x105EC76F, 0x20BD8EDE,
                                        0xC38D26C4, 0xD3D3E1AB, 0xE330A81A,
                                        0xF36E6F75};
 
-uint32_t cfgpack_crc32c(const uint8_t *data, size_t len) {
-    uint32_t crc = 0xFFFFFFFF;
+static uint32_t crc_update_nibble(uint32_t crc, const uint8_t *data,
+                                  size_t len) {
     for (size_t i = 0; i < len; ++i) {
         crc = crc_table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
         crc = crc_table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
     }
+    return (crc);
+}
+#endif
+
+#ifdef CRC_USE_SLICE8
+static uint32_t crc_update_slice8(uint32_t crc, const uint8_t *p, size_t len) {
+    while (len >= 8) {
+        uint32_t lo = crc ^ ((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                             ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+        uint32_t hi = (uint32_t)p[4] | ((uint32_t)p[5] << 8) |
+                      ((uint32_t)p[6] << 16) | ((uint32_t)p[7] << 24);
+        crc = crc_slice8[7][lo & 0xFF] ^ crc_slice8[6][(lo >> 8) & 0xFF] ^
+              crc_slice8[5][(lo >> 16) & 0xFF] ^ crc_slice8[4][lo >> 24] ^
+              crc_slice8[3][hi & 0xFF] ^ crc_slice8[2][(hi >> 8) & 0xFF] ^
+              crc_slice8[1][(hi >> 16) & 0xFF] ^ crc_slice8[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+    while (len--) {
+        crc = crc_slice8[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return (crc);
+}
+#endif
+
+#if defined(CRC_USE_X86) || defined(CRC_USE_ARM)
+  #if defined(CRC_USE_X86)
+    #define CRC_HW_U8(c, b) _mm_crc32_u8((c), (b))
+    #if defined(__x86_64__) || defined(_M_X64)
+      #define CRC_HW_WORD_T uint64_t
+      #define CRC_HW_WORD(c, w) ((uint32_t)_mm_crc32_u64((c), (w)))
+    #else
+      #define CRC_HW_WORD_T uint32_t
+      #define CRC_HW_WORD(c, w) _mm_crc32_u32((c), (w))
+    #endif
+  #else
+    #define CRC_HW_U8(c, b)   __crc32cb((c), (b))
+    #define CRC_HW_WORD_T     uint64_t
+    #define CRC_HW_WORD(c, w) __crc32cd((c), (w))
+  #endif
+
+/* Both instruction sets consume words least-significant byte first, which
+ * matches the reflected CRC on little-endian loads. */
+CRC_HW_ATTR static uint32_t crc_update_hw(uint32_t crc, const uint8_t *p,
+                                          size_t len) {
+    while (len >= sizeof(CRC_HW_WORD_T)) {
+        CRC_HW_WORD_T w;
+        memcpy(&w, p, sizeof(w));
+        crc = CRC_HW_WORD(crc, w);
+        p += sizeof(w);
+        len -= sizeof(w);
+    }
+    while (len--) {
+        crc = CRC_HW_U8(crc, *p++);
+    }
+    return (crc);
+}
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Dispatch
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#if defined(CFGPACK_CRC_DISPATCH)
+typedef uint32_t (*crc_update_fn)(uint32_t, const uint8_t *, size_t);
+
+static uint32_t crc_update_probe(uint32_t crc, const uint8_t *p, size_t len);
+
+/* Resolved once; concurrent first calls store the same pointer. */
+static crc_update_fn crc_update_impl = crc_update_probe;
+
+static uint32_t crc_update_probe(uint32_t crc, const uint8_t *p, size_t len) {
+    crc_update_fn fn = crc_update_slice8;
+  #if defined(CRC_USE_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        fn = crc_update_hw;
+    }
+  #elif defined(CRC_USE_ARM)
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+        fn = crc_update_hw;
+    }
+  #endif
+    crc_update_impl = fn;
+    return (fn(crc, p, len));
+}
+
+  #define crc_update(c, p, n) crc_update_impl((c), (p), (n))
+#elif defined(CRC_USE_X86) || defined(CRC_USE_ARM)
+  #define crc_update(c, p, n) crc_update_hw((c), (p), (n))
+#elif defined(CRC_USE_SLICE8)
+  #define crc_update(c, p, n) crc_update_slice8((c), (p), (n))
+#else
+  #define crc_update(c, p, n) crc_update_nibble((c), (p), (n))
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Public API
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+uint32_t cfgpack_crc32c_init(void) {
+    return (0xFFFFFFFFu);
+}
+
+uint32_t cfgpack_crc32c_update(uint32_t crc, const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return (crc);
+    }
+    CFGPACK_STAT_ADD(NULL, crc_bytes, len);
+    return (crc_update(crc, data, len));
+}
+
+uint32_t cfgpack_crc32c_final(uint32_t crc) {
     return (~crc);
 }
+
+/**
+ * @brief Multiply two reflected polynomials modulo the CRC-32C polynomial.
+ */
+static uint32_t crc_multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = (uint32_t)1 << 31;
+    uint32_t p = 0;
+
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) {
+                break;
+            }
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ 0x82F63B78u : b >> 1;
+    }
+    return (p);
+}
+
+uint32_t cfgpack_crc32c_shift(uint32_t crc, size_t len) {
+    uint32_t xn = (uint32_t)1 << 31; /* x^0 */
+    uint32_t sq = (uint32_t)1 << 23; /* x^8: one zero byte */
+
+    while (len) {
+        if (len & 1) {
+            xn = crc_multmodp(sq, xn);
+        }
+        sq = crc_multmodp(sq, sq);
+        len >>= 1;
+    }
+    return (crc_multmodp(xn, crc));
+}
+
+uint32_t cfgpack_crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2) {
+    return (cfgpack_crc32c_shift(crc1, len2) ^ crc2);
+}
+
+uint32_t cfgpack_crc32c(const uint8_t *data, size_t len) {
+    return (cfgpack_crc32c_final(
+        cfgpack_crc32c_update(cfgpack_crc32c_init(), data, len)));
+}
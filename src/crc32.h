@@ -13,8 +13,10 @@
 /**
  * @brief Compute CRC-32C (Castagnoli) over a byte buffer.
  *
- * Uses the reflected polynomial 0x82F63B78 with a nibble-at-a-time table
- * (16 entries, 64 bytes).  Achieves HD=6 for data words up to ~8 KB.
+ * Uses the reflected polynomial 0x82F63B78.  Achieves HD=6 for data words
+ * up to ~8 KB.  The implementation (nibble table, slicing-by-8, or the
+ * crc32 instruction) is selected by CFGPACK_CRC_BACKEND in config.h; all
+ * backends return identical values.
  *
  * @param data  Input bytes (may be NULL when @p len is 0).
  * @param len   Number of bytes to checksum.
@@ -22,4 +24,61 @@
  */
 uint32_t cfgpack_crc32c(const uint8_t *data, size_t len);
 
+/**
+ * @brief Start an incremental CRC-32C computation.
+ *
+ * The returned register is fed through cfgpack_crc32c_update() and
+ * finished with cfgpack_crc32c_final().  Splitting the input at any
+ * boundary yields the same result as a single cfgpack_crc32c() call.
+ *
+ * @return Initial CRC register.
+ */
+uint32_t cfgpack_crc32c_init(void);
+
+/**
+ * @brief Fold @p len bytes into a running CRC-32C register.
+ *
+ * @param crc   Register from cfgpack_crc32c_init() or a previous update.
+ * @param data  Input bytes (may be NULL when @p len is 0).
+ * @param len   Number of bytes.
+ * @return Updated register.
+ */
+uint32_t cfgpack_crc32c_update(uint32_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief Finish an incremental CRC-32C computation.
+ *
+ * @param crc  Running register.
+ * @return Final CRC-32C value.
+ */
+uint32_t cfgpack_crc32c_final(uint32_t crc);
+
+/**
+ * @brief Advance a CRC-32C register over @p len zero bytes.
+ *
+ * Equivalent to cfgpack_crc32c_update() on @p len zero bytes, but runs in
+ * O(log len) by multiplying with x^(8 * len) modulo the polynomial.  With
+ * a register started at 0 this gives the CRC change caused by XOR-ing a
+ * few bytes somewhere before the last @p len bytes of a message.
+ *
+ * @param crc  Running register.
+ * @param len  Number of zero bytes.
+ * @return Updated register.
+ */
+uint32_t cfgpack_crc32c_shift(uint32_t crc, size_t len);
+
+/**
+ * @brief CRC-32C of two concatenated byte runs from their separate CRCs.
+ *
+ * Lets independently computed pieces (for example blob sections checked
+ * on different threads) be folded into the CRC of the whole without
+ * reading the bytes again.
+ *
+ * @param crc1  cfgpack_crc32c() of the first run.
+ * @param crc2  cfgpack_crc32c() of the second run.
+ * @param len2  Length of the second run in bytes.
+ * @return cfgpack_crc32c() of the first run followed by the second.
+ */
+uint32_t cfgpack_crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
 #endif
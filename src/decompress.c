@@ -8,6 +8,11 @@
 
 #include "cfgpack/decompress.h"
 
+#include "crc32.h"
+#include "stats.h"
+
+#include <string.h>
+
 #ifdef CFGPACK_LZ4
   #include "lz4.h"
 
@@ -27,8 +32,10 @@ cfgpack_err_t cfgpack_pagein_lz4(cfgpack_ctx_t *ctx,
     }
 
     /* LZ4_decompress_safe requires knowing the exact decompressed size */
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_DECOMPRESS, ctx);
     result = LZ4_decompress_safe((const char *)data, (char *)scratch, (int)len,
                                  (int)decompressed_size);
+    CFGPACK_STAT_END(CFGPACK_STATS_DECOMPRESS, ctx);
 
     if (result < 0) {
         return (CFGPACK_ERR_DECODE);
@@ -40,36 +47,336 @@ cfgpack_err_t cfgpack_pagein_lz4(cfgpack_ctx_t *ctx,
     return (cfgpack_pagein_buf(ctx, scratch, (size_t)result));
 }
 
+cfgpack_err_t cfgpack_lz4_dict(cfgpack_ctx_t *ctx,
+                               uint8_t *dict,
+                               size_t dict_cap,
+                               size_t *dict_len) {
+    size_t len = 0;
+    cfgpack_err_t rc;
+
+    if (!ctx || !dict || !dict_len) {
+        return (CFGPACK_ERR_ARGS);
+    }
+
+    rc = cfgpack_pageout(ctx, dict, dict_cap, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    /* The CRC trailer differs per blob, so it is useless as history */
+    *dict_len = len - CFGPACK_CRC_SIZE;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_pagein_lz4_dict(cfgpack_ctx_t *ctx,
+                                      const uint8_t *data,
+                                      size_t len,
+                                      size_t decompressed_size,
+                                      const uint8_t *dict,
+                                      size_t dict_len,
+                                      uint8_t *scratch,
+                                      size_t scratch_cap) {
+    int result;
+
+    if (!ctx || !data || !scratch || (!dict && dict_len)) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (decompressed_size > scratch_cap) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_DECOMPRESS, ctx);
+    result = LZ4_decompress_safe_usingDict(
+        (const char *)data, (char *)scratch, (int)len, (int)decompressed_size,
+        (const char *)dict, (int)dict_len);
+    CFGPACK_STAT_END(CFGPACK_STATS_DECOMPRESS, ctx);
+    if (result < 0 || (size_t)result != decompressed_size) {
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    return (cfgpack_pagein_buf(ctx, scratch, (size_t)result));
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Block-framed LZ4 stream (cfgpack_pagein_lz4_stream, schema parsing)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Source state: decodes one block at a time into the ring.
+ *
+ * Blocks are placed in the ring exactly as the encoder placed them (next
+ * to each other, back to offset 0 when fewer than @c block bytes remain),
+ * which is LZ4's synchronized ring mode and lets the ring be far smaller
+ * than 64 KiB.
+ */
+typedef struct {
+    LZ4_streamDecode_t lz;
+    const uint8_t *data; /**< Compressed stream, header included. */
+    size_t len;          /**< Bytes in @c data. */
+    size_t in;           /**< Next block length prefix in @c data. */
+    uint8_t *ring;       /**< Caller-provided ring. */
+    size_t ring_size;    /**< Ring size used by the encoder. */
+    size_t block;        /**< Decompressed size of every block but the last. */
+    size_t total;        /**< Decompressed size of the stream. */
+    size_t at;           /**< Ring offset of the current block. */
+    size_t blk_off;      /**< Stream offset of the current block. */
+    size_t blk_len;      /**< Decompressed bytes of the current block. */
+    const cfgpack_ctx_t *ctx; /**< Context being paged in, or NULL (stats). */
+} lz4s_source_t;
+
+static uint32_t get_le(const uint8_t *p, size_t n) {
+    uint32_t v = 0;
+
+    while (n--) {
+        v = (v << 8) | p[n];
+    }
+    return (v);
+}
+
+static void lz4s_restart(lz4s_source_t *s) {
+    LZ4_setStreamDecode(&s->lz, NULL, 0);
+    s->in = CFGPACK_LZ4S_HDR_SIZE;
+    s->at = 0;
+    s->blk_off = 0;
+    s->blk_len = 0;
+}
+
+static cfgpack_err_t lz4s_next(lz4s_source_t *s) {
+    size_t off = s->blk_off + s->blk_len;
+    size_t want = s->total - off;
+    size_t clen;
+    int n;
+
+    if (want > s->block) {
+        want = s->block;
+    }
+    if (s->len - s->in < 2) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    clen = get_le(s->data + s->in, 2);
+    if (clen == 0 || clen > s->len - s->in - 2) {
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    s->at += s->blk_len;
+    if (s->at + s->block > s->ring_size) {
+        s->at = 0;
+    }
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_DECOMPRESS, s->ctx);
+    n = LZ4_decompress_safe_continue(&s->lz, (const char *)s->data + s->in + 2,
+                                     (char *)s->ring + s->at, (int)clen,
+                                     (int)want);
+    CFGPACK_STAT_END(CFGPACK_STATS_DECOMPRESS, s->ctx);
+    if (n < 0 || (size_t)n != want) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    s->in += 2 + clen;
+    s->blk_off = off;
+    s->blk_len = want;
+
+    /* The last block must end the compressed data */
+    if (off + want == s->total && s->in != s->len) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief cfgpack_source_fn over the decompressed stream.
+ *
+ * The readers ask for consecutive offsets, so each call is served
+ * from the current block or the next ones.  An offset before the current
+ * block (the second pagein pass) restarts decompression.
+ */
+static cfgpack_err_t lz4s_source(void *user,
+                                 size_t offset,
+                                 uint8_t *dst,
+                                 size_t cap,
+                                 size_t *out_len) {
+    lz4s_source_t *s = (lz4s_source_t *)user;
+    size_t n;
+
+    if (offset >= s->total) {
+        *out_len = 0;
+        return (CFGPACK_OK);
+    }
+    if (offset < s->blk_off) {
+        lz4s_restart(s);
+    }
+    while (offset >= s->blk_off + s->blk_len) {
+        cfgpack_err_t rc = lz4s_next(s);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+
+    n = s->blk_off + s->blk_len - offset;
+    if (n > cap) {
+        n = cap;
+    }
+    memcpy(dst, s->ring + s->at + (offset - s->blk_off), n);
+    *out_len = n;
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Check the stream header and set up @p s to decompress into
+ *        @p ring.
+ */
+static cfgpack_err_t lz4s_open(lz4s_source_t *s,
+                               const uint8_t *data,
+                               size_t len,
+                               uint8_t *ring,
+                               size_t ring_cap,
+                               const cfgpack_ctx_t *ctx) {
+    if (len < CFGPACK_LZ4S_HDR_SIZE) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    s->data = data;
+    s->len = len;
+    s->ring = ring;
+    s->ctx = ctx;
+    s->total = get_le(data, 4);
+    s->block = get_le(data + 4, 2);
+    s->ring_size = get_le(data + 6, 4);
+    if (s->block < CFGPACK_LZ4S_BLOCK_MIN || s->ring_size < s->block ||
+        s->ring_size > CFGPACK_LZ4S_RING_MAX) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (s->ring_size > ring_cap) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    lz4s_restart(s);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_pagein_lz4_stream(cfgpack_ctx_t *ctx,
+                                        const uint8_t *data,
+                                        size_t len,
+                                        uint8_t *ring,
+                                        size_t ring_cap,
+                                        uint8_t *window,
+                                        size_t window_cap) {
+    lz4s_source_t s;
+    cfgpack_err_t rc;
+
+    if (!ctx || !data || !ring || !window) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    rc = lz4s_open(&s, data, len, ring, ring_cap, ctx);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (cfgpack_pagein_stream(ctx, lz4s_source, &s, window, window_cap));
+}
+
+cfgpack_err_t cfgpack_schema_measure_msgpack_lz4(
+    const uint8_t *data,
+    size_t len,
+    uint8_t *ring,
+    size_t ring_cap,
+    uint8_t *window,
+    size_t window_cap,
+    cfgpack_schema_measure_t *out,
+    cfgpack_parse_error_t *err) {
+    lz4s_source_t s;
+    cfgpack_err_t rc;
+
+    if (!data || !ring || !window || !out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = lz4s_open(&s, data, len, ring, ring_cap, NULL);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (cfgpack_schema_measure_msgpack_stream(
+        lz4s_source, &s, s.total, window, window_cap, out, err));
+}
+
+cfgpack_err_t cfgpack_schema_parse_msgpack_lz4(
+    const uint8_t *data,
+    size_t len,
+    uint8_t *ring,
+    size_t ring_cap,
+    uint8_t *window,
+    size_t window_cap,
+    const cfgpack_parse_opts_t *opts) {
+    lz4s_source_t s;
+    cfgpack_err_t rc;
+
+    if (!data || !ring || !window || !opts) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = lz4s_open(&s, data, len, ring, ring_cap, NULL);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (cfgpack_schema_parse_msgpack_stream(lz4s_source, &s, s.total,
+                                                window, window_cap, opts));
+}
+
 #endif /* CFGPACK_LZ4 */
 
 #ifdef CFGPACK_HEATSHRINK
   #include "heatshrink_decoder.h"
 
-/* Static decoder instance (no dynamic allocation) */
+/* Static decoder instance for cfgpack_pagein_heatshrink() */
 static heatshrink_decoder hs_decoder;
 
-cfgpack_err_t cfgpack_pagein_heatshrink(cfgpack_ctx_t *ctx,
-                                        const uint8_t *data,
-                                        size_t len,
-                                        uint8_t *scratch,
-                                        size_t scratch_cap) {
+/**
+ * @brief Poll decoded bytes into the rest of @p scratch.
+ *
+ * The decoder reports HSDR_POLL_MORE whenever the output is full, even
+ * when nothing is left, so once @p scratch is full a one-byte probe tells
+ * an exact fit from an overflow.
+ *
+ * @return Poll result; @p overflow is set if the probe received a byte.
+ */
+static HSD_poll_res hs_poll(heatshrink_decoder *hsd,
+                            uint8_t *scratch,
+                            size_t scratch_cap,
+                            size_t *total_output,
+                            int *overflow) {
+    uint8_t probe;
+    size_t produced = 0;
+    HSD_poll_res res;
+
+    if (*total_output < scratch_cap) {
+        res = heatshrink_decoder_poll(hsd, scratch + *total_output,
+                                      scratch_cap - *total_output, &produced);
+        *total_output += produced;
+        return (res);
+    }
+    res = heatshrink_decoder_poll(hsd, &probe, 1, &produced);
+    *overflow = produced != 0;
+    return (res);
+}
+
+/**
+ * @brief Decompress all of @p data into @p scratch.
+ *
+ * @param total_output Receives the decompressed length.
+ */
+static cfgpack_err_t hs_decode(const uint8_t *data,
+                               size_t len,
+                               heatshrink_decoder *hsd,
+                               uint8_t *scratch,
+                               size_t scratch_cap,
+                               size_t *total_output) {
     size_t output_produced = 0;
     size_t input_consumed = 0;
     HSD_finish_res finish_res;
-    size_t total_output = 0;
     HSD_sink_res sink_res;
     HSD_poll_res poll_res;
+    int overflow = 0;
 
-    if (!ctx || !data || !scratch) {
-        return (CFGPACK_ERR_DECODE);
-    }
-
-    heatshrink_decoder_reset(&hs_decoder);
+    *total_output = 0;
+    heatshrink_decoder_reset(hsd);
 
     /* Feed compressed data and poll for output */
     while (input_consumed < len) {
         /* Sink input data */
-        sink_res = heatshrink_decoder_sink(&hs_decoder,
+        sink_res = heatshrink_decoder_sink(hsd,
                                            (uint8_t *)(data + input_consumed),
                                            len - input_consumed,
                                            &output_produced);
@@ -80,48 +387,71 @@ cfgpack_err_t cfgpack_pagein_heatshrink(cfgpack_ctx_t *ctx,
 
         /* Poll for decompressed output */
         do {
-            poll_res = heatshrink_decoder_poll(&hs_decoder,
-                                               scratch + total_output,
-                                               scratch_cap - total_output,
-                                               &output_produced);
+            poll_res = hs_poll(hsd, scratch, scratch_cap, total_output,
+                               &overflow);
             if (poll_res < 0) {
                 return (CFGPACK_ERR_DECODE);
             }
-            total_output += output_produced;
-
-            if (total_output > scratch_cap) {
+            if (overflow) {
                 return (CFGPACK_ERR_BOUNDS);
             }
         } while (poll_res == HSDR_POLL_MORE);
     }
 
     /* Notify decoder that input is finished */
-    finish_res = heatshrink_decoder_finish(&hs_decoder);
+    finish_res = heatshrink_decoder_finish(hsd);
     if (finish_res < 0) {
         return (CFGPACK_ERR_DECODE);
     }
 
     /* Continue polling until done */
     while (finish_res == HSDR_FINISH_MORE) {
-        poll_res = heatshrink_decoder_poll(&hs_decoder, scratch + total_output,
-                                           scratch_cap - total_output,
-                                           &output_produced);
+        poll_res = hs_poll(hsd, scratch, scratch_cap, total_output,
+                           &overflow);
         if (poll_res < 0) {
             return (CFGPACK_ERR_DECODE);
         }
-        total_output += output_produced;
-
-        if (total_output > scratch_cap) {
+        if (overflow) {
             return (CFGPACK_ERR_BOUNDS);
         }
 
-        finish_res = heatshrink_decoder_finish(&hs_decoder);
+        finish_res = heatshrink_decoder_finish(hsd);
         if (finish_res < 0) {
             return (CFGPACK_ERR_DECODE);
         }
     }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_pagein_heatshrink_r(cfgpack_ctx_t *ctx,
+                                          const uint8_t *data,
+                                          size_t len,
+                                          heatshrink_decoder *hsd,
+                                          uint8_t *scratch,
+                                          size_t scratch_cap) {
+    size_t total_output;
+    cfgpack_err_t rc;
+
+    if (!ctx || !data || !hsd || !scratch) {
+        return (CFGPACK_ERR_DECODE);
+    }
 
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_DECOMPRESS, ctx);
+    rc = hs_decode(data, len, hsd, scratch, scratch_cap, &total_output);
+    CFGPACK_STAT_END(CFGPACK_STATS_DECOMPRESS, ctx);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
     return (cfgpack_pagein_buf(ctx, scratch, total_output));
 }
 
+cfgpack_err_t cfgpack_pagein_heatshrink(cfgpack_ctx_t *ctx,
+                                        const uint8_t *data,
+                                        size_t len,
+                                        uint8_t *scratch,
+                                        size_t scratch_cap) {
+    return (cfgpack_pagein_heatshrink_r(ctx, data, len, &hs_decoder, scratch,
+                                        scratch_cap));
+}
+
 #endif /* CFGPACK_HEATSHRINK */
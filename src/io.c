@@ -5,6 +5,10 @@
 #include "cfgpack/value.h"
 
 #include "crc32.h"
+#include "lookup.h"
+#include "msgpack_fmt.h"
+#include "msgpack_raw.h"
+#include "stats.h"
 
 #include <string.h>
 
@@ -12,12 +16,14 @@
  * @brief Encode a cfgpack value into msgpack format.
  * @param buf  Output buffer.
  * @param ctx  Context (for string pool access).
+ * @param e    Schema entry the value belongs to.
  * @param v    Value to encode.
  * @return CFGPACK_OK on success, CFGPACK_ERR_ENCODE on buffer overflow,
  *         CFGPACK_ERR_BOUNDS on pool corruption, CFGPACK_ERR_INVALID_TYPE on failure.
  */
 static cfgpack_err_t encode_value(cfgpack_buf_t *buf,
                                   const cfgpack_ctx_t *ctx,
+                                  const cfgpack_entry_t *e,
                                   const cfgpack_value_t *v) {
     /* All unsigned integer types are stored in v.u64 regardless of width (see
      * cfgpack_value_t in value.h).  encode_uint64 / encode_int64 already emit
@@ -35,67 +41,689 @@ static cfgpack_err_t encode_value(cfgpack_buf_t *buf,
     case CFGPACK_TYPE_F32: return cfgpack_msgpack_encode_f32(buf, v->v.f32);
     case CFGPACK_TYPE_F64: return cfgpack_msgpack_encode_f64(buf, v->v.f64);
     case CFGPACK_TYPE_STR: {
-        const char *str;
-        if ((size_t)v->v.str.offset + v->v.str.len > ctx->str_pool_cap) {
+        const char *str = cfgpack_str_data(ctx, e, v);
+        if (!str) {
             return (CFGPACK_ERR_BOUNDS);
         }
-        str = ctx->str_pool + v->v.str.offset;
         return (cfgpack_msgpack_encode_str(buf, str, v->v.str.len));
     }
     case CFGPACK_TYPE_FSTR: {
-        const char *str;
-        if ((size_t)v->v.fstr.offset + v->v.fstr.len > ctx->str_pool_cap) {
+        const char *str = cfgpack_str_data(ctx, e, v);
+        if (!str) {
             return (CFGPACK_ERR_BOUNDS);
         }
-        str = ctx->str_pool + v->v.fstr.offset;
         return (cfgpack_msgpack_encode_str(buf, str, v->v.fstr.len));
     }
     }
     return (CFGPACK_ERR_INVALID_TYPE);
 }
 
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Encoded sizes (mirror the msgpack encoders)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static size_t uint_enc_size(uint64_t v) {
+    if (v <= 0x7fu) {
+        return (1);
+    }
+    if (v <= 0xffu) {
+        return (2);
+    }
+    if (v <= 0xffffu) {
+        return (3);
+    }
+    return (v <= 0xffffffffu ? 5 : 9);
+}
+
+static size_t int_enc_size(int64_t v) {
+    if (v >= 0) {
+        return (uint_enc_size((uint64_t)v));
+    }
+    if (v >= -32) {
+        return (1);
+    }
+    if (v >= -128) {
+        return (2);
+    }
+    if (v >= -32768) {
+        return (3);
+    }
+    return (v >= INT32_MIN ? 5 : 9);
+}
+
+static size_t str_enc_size(size_t len) {
+    return ((len <= 31 ? 1 : len <= 255 ? 2 : 3) + len);
+}
+
+size_t cfgpack_entry_enc_size(const cfgpack_ctx_t *ctx, size_t off) {
+    const cfgpack_entry_t *e = &ctx->schema->entries[off];
+    size_t key = uint_enc_size(e->index);
+    cfgpack_value_t v;
+
+    cfgpack_value_load(ctx, off, &v);
+    switch (e->type) {
+    case CFGPACK_TYPE_U8:
+    case CFGPACK_TYPE_U16:
+    case CFGPACK_TYPE_U32:
+    case CFGPACK_TYPE_U64: return (key + uint_enc_size(v.v.u64));
+    case CFGPACK_TYPE_I8:
+    case CFGPACK_TYPE_I16:
+    case CFGPACK_TYPE_I32:
+    case CFGPACK_TYPE_I64: return (key + int_enc_size(v.v.i64));
+    case CFGPACK_TYPE_F32: return (key + 5);
+    case CFGPACK_TYPE_F64: return (key + 9);
+    case CFGPACK_TYPE_STR: return (key + str_enc_size(v.v.str.len));
+    case CFGPACK_TYPE_FSTR: return (key + str_enc_size(v.v.fstr.len));
+    }
+    return (key);
+}
+
+size_t cfgpack_value_enc_max(cfgpack_type_t type, size_t str_max) {
+    switch (type) {
+    case CFGPACK_TYPE_U8:
+    case CFGPACK_TYPE_I8: return (2);
+    case CFGPACK_TYPE_U16:
+    case CFGPACK_TYPE_I16: return (3);
+    case CFGPACK_TYPE_U32:
+    case CFGPACK_TYPE_I32:
+    case CFGPACK_TYPE_F32: return (5);
+    case CFGPACK_TYPE_U64:
+    case CFGPACK_TYPE_I64:
+    case CFGPACK_TYPE_F64: return (9);
+    case CFGPACK_TYPE_STR:
+    case CFGPACK_TYPE_FSTR: return (str_enc_size(str_max));
+    }
+    return (0);
+}
+
+size_t cfgpack_blob_enc_max(size_t entry_count,
+                            uint16_t max_index,
+                            size_t values) {
+    size_t name = sizeof(((cfgpack_schema_t *)0)->map_name) - 1;
+    size_t keys = entry_count + 2;
+    size_t map_hdr = keys <= 15 ? 1 : keys <= 0xffffu ? 3 : 5;
+    size_t elems = entry_count + 3;
+    size_t arr_hdr = elems <= 15 ? 1 : elems <= 0xffffu ? 3 : 5;
+
+    size_t bits = (entry_count + CHAR_BIT - 1) / CHAR_BIT;
+    size_t map;
+    size_t packed;
+
+    /* Key 0 with the longest map name, the schema header, every key at
+     * the widest index, then the values and the CRC */
+    map = map_hdr + 1 + str_enc_size(name) + CFGPACK_HEADER_SIZE +
+          entry_count * uint_enc_size(max_index) + values + CFGPACK_CRC_SIZE;
+
+    /* Packed: array header, header bin (no 5-byte key), name and bitmap
+     * instead of keys; larger only for schemas of a few entries */
+    packed = arr_hdr + CFGPACK_HEADER_SIZE - 5 + str_enc_size(name) +
+             (bits <= 255 ? 2 : 3) + bits + values + CFGPACK_CRC_SIZE;
+    return (packed > map ? packed : map);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Fixed-width encoding (cfgpack_pageout_fixed / cfgpack_patch_fixed)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Largest fixed-width scalar encoding: format byte + 8 payload bytes. */
+#define FIXED_MAX 9
+
 /**
- * @brief Core pageout logic shared by cfgpack_pageout and cfgpack_pageout_measure.
+ * @brief Encode a scalar at its schema width (u16 as 0xcd, i32 as 0xd2, ...).
  *
- * Encodes present values into the buffer.  Overflow errors from the msgpack
- * encoders are ignored — buf->len tracks the total needed size regardless.
- * Real errors (pool corruption, invalid type) are propagated.
+ * @param e    Schema entry the value belongs to.
+ * @param v    Value to encode.
+ * @param out  Receives the encoding (FIXED_MAX bytes).
+ * @param n    Receives the encoding length.
+ * @return CFGPACK_OK; CFGPACK_ERR_TYPE_MISMATCH for string entries;
+ *         CFGPACK_ERR_BOUNDS if the value does not fit the schema width.
  */
-static cfgpack_err_t pageout_impl(const cfgpack_ctx_t *ctx,
-                                  cfgpack_buf_t *buf) {
-    size_t present_count = 0;
+static cfgpack_err_t fixed_bytes(const cfgpack_entry_t *e,
+                                 const cfgpack_value_t *v,
+                                 uint8_t *out,
+                                 size_t *n) {
+    /* Indexed by cfgpack_type_t, U8 through F64 */
+    static const uint8_t tag[] = {0xcc, 0xcd, 0xce, 0xcf, 0xd0,
+                                  0xd1, 0xd2, 0xd3, 0xca, 0xcb};
+    static const uint8_t width[] = {1, 2, 4, 8, 1, 2, 4, 8, 4, 8};
+    uint64_t bits = v->v.u64;
+    int fits = 1;
+    size_t w;
 
-    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
-        if (cfgpack_presence_get(ctx, i)) {
-            present_count++;
+    if ((unsigned)e->type > CFGPACK_TYPE_F64) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    switch (e->type) {
+    case CFGPACK_TYPE_U8: fits = v->v.u64 <= UINT8_MAX; break;
+    case CFGPACK_TYPE_U16: fits = v->v.u64 <= UINT16_MAX; break;
+    case CFGPACK_TYPE_U32: fits = v->v.u64 <= UINT32_MAX; break;
+    case CFGPACK_TYPE_I8:
+        fits = v->v.i64 >= INT8_MIN && v->v.i64 <= INT8_MAX;
+        break;
+    case CFGPACK_TYPE_I16:
+        fits = v->v.i64 >= INT16_MIN && v->v.i64 <= INT16_MAX;
+        break;
+    case CFGPACK_TYPE_I32:
+        fits = v->v.i64 >= INT32_MIN && v->v.i64 <= INT32_MAX;
+        break;
+    case CFGPACK_TYPE_F32: {
+        uint32_t u;
+
+        memcpy(&u, &v->v.f32, sizeof(u));
+        bits = u;
+        break;
+    }
+    case CFGPACK_TYPE_F64: memcpy(&bits, &v->v.f64, sizeof(bits)); break;
+    default: break;
+    }
+    if (!fits) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    w = width[e->type];
+    out[0] = tag[e->type];
+    for (size_t i = 0; i < w; ++i) {
+        out[1 + i] = (uint8_t)(bits >> (8 * (w - 1 - i)));
+    }
+    *n = 1 + w;
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Decode every pending entry of a lazy pagein.
+ */
+static cfgpack_err_t lazy_flush(const cfgpack_ctx_t *ctx) {
+    if (!cfgpack_is_lazy(ctx)) {
+        return (CFGPACK_OK);
+    }
+    cfgpack_present_iter_t it;
+    size_t i;
+
+    cfgpack_present_iter_init(&it, ctx, 0);
+    while (cfgpack_present_next(&it, &i)) {
+        cfgpack_err_t rc = cfgpack_lazy_load(ctx, i);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+    return (CFGPACK_OK);
+}
+
+/** pageout_impl() flags */
+#define PAGEOUT_DELTA 1u /* only dirty entries */
+#define PAGEOUT_FIXED 2u /* scalars at schema width */
+#define PAGEOUT_INDEX 4u /* append the offset-index footer */
+#define PAGEOUT_ELIDE 8u /* skip entries equal to the attached defaults */
+#define PAGEOUT_PACKED 16u /* packed layout: presence bitmap, no keys */
+#define PAGEOUT_BARE 32u   /* no schema header, as blob diffs are checked */
+#define PAGEOUT_SECTIONS 64u /* one more key: the section table */
+#define PAGEOUT_PAD 128u     /* one more key: padding to a program page */
+
+#ifdef CFGPACK_DEFAULTS_BLOB
+/**
+ * @brief Whether entry @p off still holds its attached schema default.
+ *
+ * Both sides are compared as encoded by cfgpack_pageout(), which always
+ * picks the narrowest encoding, so equal bytes mean equal values.
+ */
+static int holds_default(const cfgpack_ctx_t *ctx, size_t off) {
+    const cfgpack_entry_t *e = &ctx->schema->entries[off];
+    uint8_t tmp[CFGPACK_STR_MAX + 3];
+    cfgpack_reader_t r;
+    cfgpack_value_t v;
+    cfgpack_buf_t buf;
+
+    if (!e->has_default || !ctx->def_off[off]) {
+        return (0);
+    }
+    cfgpack_value_load(ctx, off, &v);
+    cfgpack_buf_init(&buf, tmp, sizeof(tmp));
+    if (encode_value(&buf, ctx, e, &v) != CFGPACK_OK) {
+        return (0);
+    }
+    cfgpack_reader_init(&r, ctx->def_blob, ctx->def_len);
+    r.pos = ctx->def_off[off];
+    if (cfgpack_msgpack_skip_value(&r) != CFGPACK_OK) {
+        return (0);
+    }
+    return (r.pos - ctx->def_off[off] == buf.len &&
+            memcmp(ctx->def_blob + ctx->def_off[off], tmp, buf.len) == 0);
+}
+#endif /* CFGPACK_DEFAULTS_BLOB */
+
+/**
+ * @brief Next entry pageout_impl() writes under @p flags.
+ *
+ * @p it scans the presence bitmap (ANDed with the dirty bitmap for
+ * PAGEOUT_DELTA); only PAGEOUT_ELIDE needs a per-entry look.
+ */
+static int pageout_next(const cfgpack_ctx_t *ctx,
+                        cfgpack_present_iter_t *it,
+                        unsigned flags,
+                        size_t *off) {
+#ifdef CFGPACK_DEFAULTS_BLOB
+    while (cfgpack_present_next(it, off)) {
+        if (!(flags & PAGEOUT_ELIDE) || !holds_default(ctx, *off)) {
+            return (1);
         }
     }
+    return (0);
+#else
+    (void)ctx;
+    (void)flags;
+    return (cfgpack_present_next(it, off));
+#endif
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Schema header (cfgpack_header_enable / cfgpack_peek_header)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Header payload: u64 layout fingerprint and u32 version, big-endian. */
+#define HEADER_PAYLOAD 12
+/** Encoded CFGPACK_INDEX_HEADER key (uint32 0x10004). */
+static const uint8_t header_key[] = {0xce, 0x00, 0x01, 0x00, 0x04};
+
+/** Fold one byte into a 64-bit FNV-1a hash. */
+static uint64_t fnv1a_byte(uint64_t h, uint8_t b) {
+    return ((h ^ b) * 0x100000001b3u);
+}
+
+/* Lives here rather than in schema_parser.c so that firmware with a
+ * compiled-in schema (schema_def.h) does not link the parser. */
+uint64_t cfgpack_schema_fingerprint(const cfgpack_schema_t *schema) {
+    uint64_t h = 0xcbf29ce484222325u;
+    size_t n = schema->entry_count;
+
+    for (unsigned shift = 0; shift < 32; shift += 8) {
+        h = fnv1a_byte(h, (uint8_t)(n >> shift));
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const cfgpack_entry_t *e = &schema->entries[i];
+        h = fnv1a_byte(h, (uint8_t)e->index);
+        h = fnv1a_byte(h, (uint8_t)(e->index >> 8));
+        h = fnv1a_byte(h, (uint8_t)e->type);
+    }
+    return (h);
+}
+
+/**
+ * @brief Append the header bin of @p schema (without its map key).
+ */
+static void encode_header_bin(const cfgpack_schema_t *schema,
+                              cfgpack_buf_t *buf) {
+    uint64_t fp = cfgpack_schema_fingerprint(schema);
+    uint8_t tmp[2 + HEADER_PAYLOAD];
+
+    tmp[0] = 0xc4;
+    tmp[1] = HEADER_PAYLOAD;
+    for (size_t i = 0; i < 8; ++i) {
+        tmp[2 + i] = (uint8_t)(fp >> (56 - 8 * i));
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        tmp[10 + i] = (uint8_t)(schema->version >> (24 - 8 * i));
+    }
+    cfgpack_buf_append(buf, tmp, sizeof(tmp));
+}
+
+/**
+ * @brief Fingerprint stored in a header payload of HEADER_PAYLOAD bytes.
+ */
+static uint64_t header_fingerprint(const uint8_t *p) {
+    uint64_t fp = 0;
+
+    for (size_t i = 0; i < 8; ++i) {
+        fp = (fp << 8) | p[i];
+    }
+    return (fp);
+}
 
-    cfgpack_msgpack_encode_map_header(buf, (uint32_t)(present_count + 1));
+/**
+ * @brief Encode the map header, the schema name and, with @p header set,
+ *        the schema header.
+ *
+ * @param count Value entries that follow.
+ * @param extra Map entries after the values (the offset-index footer).
+ */
+static void encode_head(const cfgpack_ctx_t *ctx,
+                        cfgpack_buf_t *buf,
+                        size_t count,
+                        size_t extra,
+                        int header) {
+    cfgpack_msgpack_encode_map_header(
+        buf, (uint32_t)(count + 1 + (header != 0) + extra));
     cfgpack_msgpack_encode_uint_key(buf, CFGPACK_INDEX_RESERVED_NAME);
     cfgpack_msgpack_encode_str(buf, ctx->schema->map_name,
                                strlen(ctx->schema->map_name));
+    if (header) {
+        cfgpack_buf_append(buf, header_key, sizeof(header_key));
+        encode_header_bin(ctx->schema, buf);
+    }
+}
 
-    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
-        const cfgpack_entry_t *e = &ctx->schema->entries[i];
+cfgpack_err_t cfgpack_header_enable(cfgpack_ctx_t *ctx, int on) {
+    if (!ctx) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    ctx->header = on ? 1 : 0;
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Offset-index footer (cfgpack_pageout_indexed / cfgpack_blob_get)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Footer record: u16 index and u32 value offset, both big-endian. */
+#define FOOTER_REC 6
+/** Footer tail: u16 record count and u16 magic, both big-endian. */
+#define FOOTER_TAIL 4
+#define FOOTER_MAGIC 0xcf1du
+/** Encoded CFGPACK_INDEX_FOOTER key (uint32 0x10000). */
+static const uint8_t footer_key[] = {0xce, 0x00, 0x01, 0x00, 0x00};
+
+/**
+ * @brief Bin header for a footer payload of @p n bytes.
+ * @return Header length (2, 3 or 5).
+ */
+static size_t footer_bin_hdr(size_t n, uint8_t *hdr) {
+    if (n <= 0xffu) {
+        hdr[0] = 0xc4;
+        hdr[1] = (uint8_t)n;
+        return (2);
+    }
+    if (n <= 0xffffu) {
+        hdr[0] = 0xc5;
+        hdr[1] = (uint8_t)(n >> 8);
+        hdr[2] = (uint8_t)n;
+        return (3);
+    }
+    hdr[0] = 0xc6;
+    hdr[1] = (uint8_t)(n >> 24);
+    hdr[2] = (uint8_t)(n >> 16);
+    hdr[3] = (uint8_t)(n >> 8);
+    hdr[4] = (uint8_t)n;
+    return (5);
+}
+
+/**
+ * @brief Append the footer entry after the last value.
+ *
+ * The value offsets are not kept while encoding; they are recomputed from
+ * the encoded sizes, walking the entries in the same order from @p body,
+ * the offset just past the schema name.
+ */
+static void encode_footer(const cfgpack_ctx_t *ctx,
+                          cfgpack_buf_t *buf,
+                          size_t count,
+                          size_t body) {
+    size_t n = count * FOOTER_REC + FOOTER_TAIL;
+    uint8_t tmp[FOOTER_REC];
+    size_t off = body;
+
+    cfgpack_buf_append(buf, footer_key, sizeof(footer_key));
+    cfgpack_buf_append(buf, tmp, footer_bin_hdr(n, tmp));
+    cfgpack_present_iter_t it;
+    size_t i;
+
+    cfgpack_present_iter_init(&it, ctx, 0);
+    while (cfgpack_present_next(&it, &i)) {
+        uint16_t index = ctx->schema->entries[i].index;
+        uint32_t at;
+
+        at = (uint32_t)(off + uint_enc_size(index));
+        off += cfgpack_entry_enc_size(ctx, i);
+        tmp[0] = (uint8_t)(index >> 8);
+        tmp[1] = (uint8_t)index;
+        tmp[2] = (uint8_t)(at >> 24);
+        tmp[3] = (uint8_t)(at >> 16);
+        tmp[4] = (uint8_t)(at >> 8);
+        tmp[5] = (uint8_t)at;
+        cfgpack_buf_append(buf, tmp, FOOTER_REC);
+    }
+    tmp[0] = (uint8_t)(count >> 8);
+    tmp[1] = (uint8_t)count;
+    tmp[2] = (uint8_t)(FOOTER_MAGIC >> 8);
+    tmp[3] = (uint8_t)FOOTER_MAGIC;
+    cfgpack_buf_append(buf, tmp, FOOTER_TAIL);
+}
+
+#ifdef CFGPACK_PACKED_WIRE
+/**
+ * @brief Encode the packed layout of cfgpack_pageout_packed().
+ *
+ * One array: the schema header bin, the schema name, the presence
+ * bitmap as bin (bit i of byte i / 8 for entry i), then the @p count
+ * present values in entry order with no keys.
+ */
+static cfgpack_err_t encode_packed(const cfgpack_ctx_t *ctx,
+                                   cfgpack_buf_t *buf,
+                                   size_t count) {
+    size_t n = ctx->schema->entry_count;
+    cfgpack_present_iter_t it;
+    size_t i;
+
+    cfgpack_msgpack_encode_array_header(buf, (uint32_t)(count + 3));
+    encode_header_bin(ctx->schema, buf);
+    cfgpack_msgpack_encode_str(buf, ctx->schema->map_name,
+                               strlen(ctx->schema->map_name));
+    cfgpack_msgpack_encode_bin(buf, ctx->present,
+                               (n + CHAR_BIT - 1) / CHAR_BIT);
+
+    cfgpack_present_iter_init(&it, ctx, 0);
+    while (cfgpack_present_next(&it, &i)) {
+        cfgpack_value_t v;
         cfgpack_err_t err;
-        if (!cfgpack_presence_get(ctx, i)) {
-            continue;
-        }
-        cfgpack_msgpack_encode_uint_key(buf, e->index);
-        err = encode_value(buf, ctx, &ctx->values[i]);
+
+        cfgpack_value_load(ctx, i, &v);
+        err = encode_value(buf, ctx, &ctx->schema->entries[i], &v);
         if (err != CFGPACK_OK && err != CFGPACK_ERR_ENCODE) {
             return (err);
         }
     }
+    return (CFGPACK_OK);
+}
+#endif /* CFGPACK_PACKED_WIRE */
+
+/**
+ * @brief Encode entry @p i, key and value, for pageout_impl().
+ *
+ * Overflow is not an error here; see pageout_impl().
+ */
+static cfgpack_err_t pageout_entry(const cfgpack_ctx_t *ctx,
+                                   cfgpack_buf_t *buf,
+                                   unsigned flags,
+                                   size_t i,
+                                   uint32_t *value_off) {
+    const cfgpack_entry_t *e = &ctx->schema->entries[i];
+    cfgpack_value_t v;
+    cfgpack_err_t err;
+
+    cfgpack_msgpack_encode_uint_key(buf, e->index);
+    cfgpack_value_load(ctx, i, &v);
+    if (value_off) {
+        value_off[i] = (uint32_t)buf->len;
+    }
+    if ((flags & PAGEOUT_FIXED) && e->type != CFGPACK_TYPE_STR &&
+        e->type != CFGPACK_TYPE_FSTR) {
+        uint8_t tmp[FIXED_MAX];
+        size_t n;
+
+        err = fixed_bytes(e, &v, tmp, &n);
+        if (err == CFGPACK_OK) {
+            err = cfgpack_buf_append(buf, tmp, n);
+        }
+    } else {
+        err = encode_value(buf, ctx, e, &v);
+    }
+    return (err == CFGPACK_ERR_ENCODE ? CFGPACK_OK : err);
+}
+
+/**
+ * @brief Core pageout logic shared by cfgpack_pageout and cfgpack_pageout_measure.
+ *
+ * Encodes present values into the buffer (only dirty ones with
+ * PAGEOUT_DELTA, scalars at schema width with PAGEOUT_FIXED, followed by
+ * the offset-index footer with PAGEOUT_INDEX, without those equal to the
+ * attached defaults with PAGEOUT_ELIDE).  Overflow
+ * errors from the msgpack encoders are ignored — buf->len tracks the total
+ * needed size regardless.  Real errors (pool corruption, invalid type, a
+ * value wider than its fixed width) are propagated.
+ *
+ * @param value_off Optional; receives each entry's value offset in the
+ *                  output, or 0 for entries not written.
+ */
+static cfgpack_err_t pageout_impl(const cfgpack_ctx_t *ctx,
+                                  cfgpack_buf_t *buf,
+                                  unsigned flags,
+                                  uint32_t *value_off) {
+    int index = (flags & PAGEOUT_INDEX) != 0;
+    int table = (flags & PAGEOUT_SECTIONS) != 0;
+    int pad = (flags & PAGEOUT_PAD) != 0;
+    int delta = (flags & PAGEOUT_DELTA) != 0;
+    size_t present_count = 0;
+    cfgpack_present_iter_t it;
+    size_t body;
+    size_t i;
+
+#ifdef CFGPACK_DEFAULTS_BLOB
+    if (flags & PAGEOUT_ELIDE) {
+        cfgpack_present_iter_init(&it, ctx, delta);
+        while (pageout_next(ctx, &it, flags, &i)) {
+            present_count++;
+        }
+    } else {
+        present_count = cfgpack_bits_count(ctx->present,
+                                           delta ? ctx->dirty : NULL,
+                                           ctx->schema->entry_count);
+    }
+#else
+    present_count = cfgpack_bits_count(ctx->present, delta ? ctx->dirty : NULL,
+                                       ctx->schema->entry_count);
+#endif
+#ifdef CFGPACK_PACKED_WIRE
+    if (flags & PAGEOUT_PACKED) {
+        return (encode_packed(ctx, buf, present_count));
+    }
+#endif
+
+    encode_head(ctx, buf, present_count, (size_t)(index + table + pad),
+                ctx->header && !(flags & PAGEOUT_BARE));
+    body = buf->len;
+
+    if (value_off) {
+        memset(value_off, 0, ctx->schema->entry_count * sizeof(*value_off));
+    }
+    cfgpack_present_iter_init(&it, ctx, delta);
+    while (pageout_next(ctx, &it, flags, &i)) {
+        cfgpack_err_t err = pageout_entry(ctx, buf, flags, i, value_off);
+
+        if (err != CFGPACK_OK) {
+            return (err);
+        }
+    }
 
+    if (index) {
+        encode_footer(ctx, buf, present_count, body);
+    }
     return (CFGPACK_OK);
 }
 
-cfgpack_err_t cfgpack_pageout(const cfgpack_ctx_t *ctx,
-                              uint8_t *out,
-                              size_t out_cap,
-                              size_t *out_len) {
+#ifdef CFGPACK_SIZE_CACHE
+/**
+ * @brief Size of a full pageout from the size cache (ctx->size_cached).
+ */
+static size_t cached_measure(const cfgpack_ctx_t *ctx) {
+    /* Map header (entries + name key), name key and value, schema header,
+     * entries */
+    size_t keys = ctx->size_count + 1 + ctx->header;
+
+    return ((keys <= 15 ? 1 : keys <= 0xffffu ? 3 : 5) + 1 +
+            str_enc_size(strlen(ctx->schema->map_name)) +
+            (ctx->header ? CFGPACK_HEADER_SIZE : 0) + ctx->size_bytes +
+            CFGPACK_CRC_SIZE);
+}
+
+/**
+ * @brief Full pageout through a raw cursor, for output known to fit.
+ *
+ * Writes the same bytes as pageout_impl() with no flags, using the
+ * unchecked writers of msgpack_raw.h, then checksums the output in one
+ * pass.  The caller must have checked cached_measure() against the
+ * output capacity.
+ */
+static cfgpack_err_t pageout_fast(const cfgpack_ctx_t *ctx,
+                                  uint8_t *out,
+                                  size_t *out_len) {
+    const char *name = ctx->schema->map_name;
+    cfgpack_present_iter_t it;
+    uint8_t *p = out;
+    uint32_t crc;
+    size_t i;
+
+    p = mp_raw_map_header(p, (uint32_t)(ctx->size_count + 1 + ctx->header));
+    p = mp_raw_uint(p, CFGPACK_INDEX_RESERVED_NAME);
+    p = mp_raw_str(p, name, strlen(name));
+    if (ctx->header) {
+        memcpy(p, header_key, sizeof(header_key));
+        p += sizeof(header_key);
+        p[0] = 0xc4;
+        p[1] = HEADER_PAYLOAD;
+        p = mp_raw_be64(p + 2, cfgpack_schema_fingerprint(ctx->schema));
+        p = mp_raw_be32(p, ctx->schema->version);
+    }
+
+    cfgpack_present_iter_init(&it, ctx, 0);
+    while (cfgpack_present_next(&it, &i)) {
+        const cfgpack_entry_t *e = &ctx->schema->entries[i];
+        const char *str;
+        cfgpack_value_t v;
+
+        p = mp_raw_uint(p, e->index);
+        cfgpack_value_load(ctx, i, &v);
+        switch (v.type) {
+        case CFGPACK_TYPE_U8:
+        case CFGPACK_TYPE_U16:
+        case CFGPACK_TYPE_U32:
+        case CFGPACK_TYPE_U64: p = mp_raw_uint(p, v.v.u64); break;
+        case CFGPACK_TYPE_I8:
+        case CFGPACK_TYPE_I16:
+        case CFGPACK_TYPE_I32:
+        case CFGPACK_TYPE_I64: p = mp_raw_int(p, v.v.i64); break;
+        case CFGPACK_TYPE_F32: p = mp_raw_f32(p, v.v.f32); break;
+        case CFGPACK_TYPE_F64: p = mp_raw_f64(p, v.v.f64); break;
+        case CFGPACK_TYPE_STR:
+        case CFGPACK_TYPE_FSTR:
+            str = cfgpack_str_data(ctx, e, &v);
+            if (!str) {
+                return (CFGPACK_ERR_BOUNDS);
+            }
+            p = mp_raw_str(p, str,
+                           v.type == CFGPACK_TYPE_STR ? v.v.str.len
+                                                      : v.v.fstr.len);
+            break;
+        default: return (CFGPACK_ERR_INVALID_TYPE);
+        }
+    }
+
+    crc = cfgpack_crc32c(out, (size_t)(p - out));
+    p[0] = (uint8_t)(crc);
+    p[1] = (uint8_t)(crc >> 8);
+    p[2] = (uint8_t)(crc >> 16);
+    p[3] = (uint8_t)(crc >> 24);
+    *out_len = (size_t)(p - out) + CFGPACK_CRC_SIZE;
+    return (CFGPACK_OK);
+}
+#endif /* CFGPACK_SIZE_CACHE */
+
+/**
+ * @brief Encode into a flat buffer and append the CRC-32C trailer.
+ */
+static cfgpack_err_t pageout_flat(cfgpack_ctx_t *ctx,
+                                  uint8_t *out,
+                                  size_t out_cap,
+                                  size_t *out_len,
+                                  unsigned flags,
+                                  uint32_t *value_off) {
     uint8_t crc_bytes[CFGPACK_CRC_SIZE];
     cfgpack_buf_t buf;
     cfgpack_err_t rc;
@@ -108,50 +736,548 @@ cfgpack_err_t cfgpack_pageout(const cfgpack_ctx_t *ctx,
         return (CFGPACK_ERR_ENCODE);
     }
 
+    rc = lazy_flush(ctx);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEOUT, ctx);
+#ifdef CFGPACK_SIZE_CACHE
+    if (flags == 0 && ctx->size_cached && cached_measure(ctx) <= out_cap) {
+        size_t len = 0;
+
+        rc = pageout_fast(ctx, out, &len);
+        CFGPACK_STAT_END(CFGPACK_STATS_PAGEOUT, ctx);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        if (out_len) {
+            *out_len = len;
+        }
+        cfgpack_dirty_clear_all(ctx);
+        return (CFGPACK_OK);
+    }
+#endif
     cfgpack_buf_init(&buf, out, out_cap);
-    rc = pageout_impl(ctx, &buf);
+    cfgpack_buf_crc_begin(&buf);
+    rc = pageout_impl(ctx, &buf, flags, value_off);
     if (rc != CFGPACK_OK) {
+        CFGPACK_STAT_END(CFGPACK_STATS_PAGEOUT, ctx);
         return (rc);
     }
 
-    crc = cfgpack_crc32c(out, buf.len);
+    /* CRC accumulated during encoding; no second pass over out */
+    crc = cfgpack_buf_crc(&buf);
     crc_bytes[0] = (uint8_t)(crc);
     crc_bytes[1] = (uint8_t)(crc >> 8);
     crc_bytes[2] = (uint8_t)(crc >> 16);
     crc_bytes[3] = (uint8_t)(crc >> 24);
     cfgpack_buf_append(&buf, crc_bytes, CFGPACK_CRC_SIZE);
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEOUT, ctx);
 
     if (out_len) {
         *out_len = buf.len;
     }
-    return (buf.len <= out_cap) ? CFGPACK_OK : CFGPACK_ERR_ENCODE;
+    if (buf.len > out_cap) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    cfgpack_dirty_clear_all(ctx);
+    return (CFGPACK_OK);
 }
 
-cfgpack_err_t cfgpack_pageout_measure(const cfgpack_ctx_t *ctx,
-                                      size_t *out_len) {
-    cfgpack_buf_t buf;
-    cfgpack_err_t rc;
+cfgpack_err_t cfgpack_pageout(cfgpack_ctx_t *ctx,
+                              uint8_t *out,
+                              size_t out_cap,
+                              size_t *out_len) {
+    return (pageout_flat(ctx, out, out_cap, out_len, 0, NULL));
+}
 
-    if (!ctx || !out_len) {
-        return (CFGPACK_ERR_ARGS);
-    }
+cfgpack_err_t cfgpack_pageout_delta(cfgpack_ctx_t *ctx,
+                                    uint8_t *out,
+                                    size_t out_cap,
+                                    size_t *out_len) {
+    return (pageout_flat(ctx, out, out_cap, out_len, PAGEOUT_DELTA, NULL));
+}
 
-    cfgpack_buf_init(&buf, NULL, 0);
-    rc = pageout_impl(ctx, &buf);
-    if (rc != CFGPACK_OK) {
-        return (rc);
+#ifdef CFGPACK_DEFAULTS_BLOB
+cfgpack_err_t cfgpack_pageout_elide(cfgpack_ctx_t *ctx,
+                                    uint8_t *out,
+                                    size_t out_cap,
+                                    size_t *out_len) {
+    if (ctx && !ctx->def_off) {
+        return (CFGPACK_ERR_ARGS);
     }
+    return (pageout_flat(ctx, out, out_cap, out_len, PAGEOUT_ELIDE, NULL));
+}
+#endif
 
-    *out_len = buf.len + CFGPACK_CRC_SIZE;
-    return (CFGPACK_OK);
+#ifdef CFGPACK_PACKED_WIRE
+cfgpack_err_t cfgpack_pageout_packed(cfgpack_ctx_t *ctx,
+                                     uint8_t *out,
+                                     size_t out_cap,
+                                     size_t *out_len) {
+    return (pageout_flat(ctx, out, out_cap, out_len, PAGEOUT_PACKED, NULL));
 }
+#endif
 
-cfgpack_err_t cfgpack_peek_name(const uint8_t *data,
-                                size_t len,
-                                char *out_name,
-                                size_t out_cap) {
-    uint32_t map_count;
-    cfgpack_reader_t r;
+cfgpack_err_t cfgpack_pageout_fixed(cfgpack_ctx_t *ctx,
+                                    uint8_t *out,
+                                    size_t out_cap,
+                                    size_t *out_len,
+                                    uint32_t *value_off) {
+    return (pageout_flat(ctx, out, out_cap, out_len, PAGEOUT_FIXED,
+                         value_off));
+}
+
+cfgpack_err_t cfgpack_pageout_indexed(cfgpack_ctx_t *ctx,
+                                      uint8_t *out,
+                                      size_t out_cap,
+                                      size_t *out_len) {
+    return (pageout_flat(ctx, out, out_cap, out_len, PAGEOUT_INDEX, NULL));
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Section table (cfgpack_pageout_sectioned / cfgpack_pagein_sections)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Section record: u32 offset of its first key and u32 CRC-32C, both
+ *  big-endian. */
+#define SECTION_REC 8
+/** Table tail: u32 CRC-32C of the records and the count, u16 section
+ *  count, u16 magic, all big-endian. */
+#define SECTION_TAIL 8
+#define SECTION_MAGIC 0xcf5eu
+/** Encoded CFGPACK_INDEX_SECTIONS key (uint32 0x10005). */
+static const uint8_t sections_key[] = {0xce, 0x00, 0x01, 0x00, 0x05};
+
+/** Walk over the present entries, grouped into sections. */
+typedef struct {
+    cfgpack_present_iter_t it;
+    size_t off;
+} section_walk_t;
+
+/**
+ * @brief Next section [*start, *end) of the entries from w->off.
+ *
+ * Like encode_footer(), offsets come from the encoded sizes.  A section
+ * takes whole entries until it holds at least @p section_bytes.
+ *
+ * @return 0 once every entry is in a section.
+ */
+static int section_next(const cfgpack_ctx_t *ctx,
+                        section_walk_t *w,
+                        size_t section_bytes,
+                        size_t *start,
+                        size_t *end) {
+    size_t i;
+
+    *start = w->off;
+    while (w->off - *start < section_bytes &&
+           cfgpack_present_next(&w->it, &i)) {
+        w->off += cfgpack_entry_enc_size(ctx, i);
+    }
+    *end = w->off;
+    return (*end > *start);
+}
+
+/**
+ * @brief Append the section table for the entries written from @p body.
+ *
+ * The section CRCs are read back from the output, so they are only right
+ * when the entries fit; otherwise the pageout fails with ENCODE anyway.
+ */
+static void encode_sections(const cfgpack_ctx_t *ctx,
+                            cfgpack_buf_t *buf,
+                            size_t body,
+                            size_t section_bytes) {
+    uint8_t tmp[SECTION_REC];
+    section_walk_t w;
+    uint32_t crc = cfgpack_crc32c_init();
+    size_t count = 0;
+    size_t start;
+    size_t end;
+
+    cfgpack_present_iter_init(&w.it, ctx, 0);
+    w.off = body;
+    while (section_next(ctx, &w, section_bytes, &start, &end)) {
+        count++;
+    }
+    cfgpack_buf_append(buf, sections_key, sizeof(sections_key));
+    cfgpack_buf_append(
+        buf, tmp, footer_bin_hdr(count * SECTION_REC + SECTION_TAIL, tmp));
+
+    cfgpack_present_iter_init(&w.it, ctx, 0);
+    w.off = body;
+    while (section_next(ctx, &w, section_bytes, &start, &end)) {
+        uint32_t c = 0;
+
+        if (end <= buf->cap) {
+            c = cfgpack_crc32c(buf->data + start, end - start);
+        }
+        mp_raw_be32(mp_raw_be32(tmp, (uint32_t)start), c);
+        crc = cfgpack_crc32c_update(crc, tmp, SECTION_REC);
+        cfgpack_buf_append(buf, tmp, SECTION_REC);
+    }
+    mp_raw_be16(tmp + 4, (uint16_t)count);
+    mp_raw_be16(tmp + 6, SECTION_MAGIC);
+    crc = cfgpack_crc32c_final(cfgpack_crc32c_update(crc, tmp + 4, 2));
+    mp_raw_be32(tmp, crc);
+    cfgpack_buf_append(buf, tmp, SECTION_TAIL);
+}
+
+cfgpack_err_t cfgpack_pageout_sectioned(cfgpack_ctx_t *ctx,
+                                        uint8_t *out,
+                                        size_t out_cap,
+                                        size_t *out_len,
+                                        size_t section_bytes) {
+    uint8_t crc_bytes[CFGPACK_CRC_SIZE];
+    cfgpack_present_iter_t it;
+    cfgpack_buf_t buf;
+    cfgpack_err_t rc;
+    size_t body;
+    uint32_t crc;
+    size_t i;
+
+    if (!ctx || !out || section_bytes == 0) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (out_cap < 12) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    rc = lazy_flush(ctx);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEOUT, ctx);
+    cfgpack_buf_init(&buf, out, out_cap);
+    cfgpack_buf_crc_begin(&buf);
+    rc = pageout_impl(ctx, &buf, PAGEOUT_SECTIONS, NULL);
+    if (rc != CFGPACK_OK) {
+        CFGPACK_STAT_END(CFGPACK_STATS_PAGEOUT, ctx);
+        return (rc);
+    }
+
+    /* The entries end the output so far; step back over them */
+    body = buf.len;
+    cfgpack_present_iter_init(&it, ctx, 0);
+    while (cfgpack_present_next(&it, &i)) {
+        body -= cfgpack_entry_enc_size(ctx, i);
+    }
+    encode_sections(ctx, &buf, body, section_bytes);
+
+    crc = cfgpack_buf_crc(&buf);
+    crc_bytes[0] = (uint8_t)(crc);
+    crc_bytes[1] = (uint8_t)(crc >> 8);
+    crc_bytes[2] = (uint8_t)(crc >> 16);
+    crc_bytes[3] = (uint8_t)(crc >> 24);
+    cfgpack_buf_append(&buf, crc_bytes, CFGPACK_CRC_SIZE);
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEOUT, ctx);
+
+    if (out_len) {
+        *out_len = buf.len;
+    }
+    if (buf.len > out_cap) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    cfgpack_dirty_clear_all(ctx);
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Flash-aligned pageout (cfgpack_pageout_aligned / cfgpack_pagein_aligned)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Encoded CFGPACK_INDEX_PAD key (uint32 0x10006). */
+static const uint8_t pad_key[] = {0xce, 0x00, 0x01, 0x00, 0x06};
+/** Pad bin header: always bin32, so its size does not depend on the fill. */
+#define PAD_BIN_HDR 5
+
+cfgpack_err_t cfgpack_pageout_aligned(cfgpack_ctx_t *ctx,
+                                      uint8_t *out,
+                                      size_t out_cap,
+                                      size_t *out_len,
+                                      const cfgpack_flash_geom_t *geom) {
+    uint8_t crc_bytes[CFGPACK_CRC_SIZE];
+    uint8_t tmp[16];
+    cfgpack_buf_t buf;
+    cfgpack_err_t rc;
+    size_t used;
+    size_t fill;
+    uint32_t crc;
+
+    if (!ctx || !out || !geom || geom->prog_size == 0 ||
+        geom->erase_size == 0 || geom->erase_size % geom->prog_size != 0) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (out_cap < 12) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    rc = lazy_flush(ctx);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEOUT, ctx);
+    cfgpack_buf_init(&buf, out, out_cap);
+    cfgpack_buf_crc_begin(&buf);
+    rc = pageout_impl(ctx, &buf, PAGEOUT_PAD, NULL);
+    if (rc != CFGPACK_OK) {
+        CFGPACK_STAT_END(CFGPACK_STATS_PAGEOUT, ctx);
+        return (rc);
+    }
+
+    /* Fill so the trailer ends on a page boundary */
+    used = buf.len + sizeof(pad_key) + PAD_BIN_HDR + CFGPACK_CRC_SIZE;
+    fill = (geom->prog_size - used % geom->prog_size) % geom->prog_size;
+    tmp[0] = 0xc6;
+    mp_raw_be32(tmp + 1, (uint32_t)fill);
+    cfgpack_buf_append(&buf, pad_key, sizeof(pad_key));
+    cfgpack_buf_append(&buf, tmp, PAD_BIN_HDR);
+    memset(tmp, geom->erase_value, sizeof(tmp));
+    while (fill > 0) {
+        size_t n = fill < sizeof(tmp) ? fill : sizeof(tmp);
+
+        cfgpack_buf_append(&buf, tmp, n);
+        fill -= n;
+    }
+
+    crc = cfgpack_buf_crc(&buf);
+    crc_bytes[0] = (uint8_t)(crc);
+    crc_bytes[1] = (uint8_t)(crc >> 8);
+    crc_bytes[2] = (uint8_t)(crc >> 16);
+    crc_bytes[3] = (uint8_t)(crc >> 24);
+    cfgpack_buf_append(&buf, crc_bytes, CFGPACK_CRC_SIZE);
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEOUT, ctx);
+
+    if (out_len) {
+        *out_len = buf.len;
+    }
+    if (buf.len > out_cap) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    cfgpack_dirty_clear_all(ctx);
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Read exactly @p n bytes at @p off from a source callback.
+ */
+static cfgpack_err_t source_read(cfgpack_source_fn src,
+                                 void *user,
+                                 size_t off,
+                                 uint8_t *dst,
+                                 size_t n) {
+    while (n > 0) {
+        size_t got = 0;
+        cfgpack_err_t rc = src(user, off, dst, n, &got);
+
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        if (got == 0 || got > n) {
+            return (CFGPACK_ERR_IO);
+        }
+        off += got;
+        dst += got;
+        n -= got;
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_patch_fixed(const cfgpack_ctx_t *ctx,
+                                  uint16_t index,
+                                  const uint32_t *value_off,
+                                  size_t blob_len,
+                                  cfgpack_source_fn src,
+                                  void *user,
+                                  cfgpack_patch_t *patch) {
+    uint8_t old[FIXED_MAX];
+    uint8_t trailer[CFGPACK_CRC_SIZE];
+    const cfgpack_entry_t *e;
+    cfgpack_value_t v;
+    cfgpack_err_t rc;
+    uint32_t crc;
+    size_t off;
+    size_t n;
+
+    if (!ctx || !value_off || !src || !patch) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (index == CFGPACK_INDEX_RESERVED_NAME) {
+        return (CFGPACK_ERR_RESERVED_INDEX);
+    }
+    e = cfgpack_find_entry(ctx, index);
+    if (!e) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    off = (size_t)(e - ctx->schema->entries);
+    if (!cfgpack_presence_get(ctx, off) || value_off[off] == 0) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    cfgpack_value_load(ctx, off, &v);
+    rc = fixed_bytes(e, &v, patch->bytes, &n);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    patch->off = value_off[off];
+    patch->len = n;
+    patch->crc_off = blob_len - CFGPACK_CRC_SIZE;
+    if (blob_len < CFGPACK_CRC_SIZE || patch->off + n > patch->crc_off) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    rc = source_read(src, user, patch->off, old, n);
+    if (rc == CFGPACK_OK) {
+        rc = source_read(src, user, patch->crc_off, trailer, sizeof(trailer));
+    }
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    /* The offsets must come from a fixed-width pageout of this schema */
+    if (old[0] != patch->bytes[0]) {
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    /* CRC is linear: fold in the XOR of old and new bytes, then shift it
+     * past the rest of the body instead of re-reading it. */
+    for (size_t i = 0; i < n; ++i) {
+        old[i] ^= patch->bytes[i];
+    }
+    crc = cfgpack_crc32c_update(0, old, n);
+    crc = cfgpack_crc32c_shift(crc, patch->crc_off - (patch->off + n));
+    crc ^= (uint32_t)trailer[0] | ((uint32_t)trailer[1] << 8) |
+           ((uint32_t)trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+    patch->crc[0] = (uint8_t)(crc);
+    patch->crc[1] = (uint8_t)(crc >> 8);
+    patch->crc[2] = (uint8_t)(crc >> 16);
+    patch->crc[3] = (uint8_t)(crc >> 24);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_pageout_measure(const cfgpack_ctx_t *ctx,
+                                      size_t *out_len) {
+    cfgpack_buf_t buf;
+    cfgpack_err_t rc;
+
+    if (!ctx || !out_len) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = lazy_flush(ctx);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+#ifdef CFGPACK_SIZE_CACHE
+    if (ctx->size_cached) {
+        *out_len = cached_measure(ctx);
+        return (CFGPACK_OK);
+    }
+#endif
+
+    cfgpack_buf_init(&buf, NULL, 0);
+    rc = pageout_impl(ctx, &buf, 0, NULL);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    *out_len = buf.len + CFGPACK_CRC_SIZE;
+    return (CFGPACK_OK);
+}
+
+#ifdef CFGPACK_SIZE_CACHE
+cfgpack_err_t cfgpack_size_cache_init(cfgpack_ctx_t *ctx) {
+    cfgpack_present_iter_t it;
+    cfgpack_err_t rc;
+    size_t i;
+
+    if (!ctx) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = lazy_flush(ctx);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    ctx->size_bytes = 0;
+    ctx->size_count = 0;
+    cfgpack_present_iter_init(&it, ctx, 0);
+    while (cfgpack_present_next(&it, &i)) {
+        ctx->size_bytes += cfgpack_entry_enc_size(ctx, i);
+        ctx->size_count++;
+    }
+    ctx->size_cached = 1;
+    return (CFGPACK_OK);
+}
+#endif /* CFGPACK_SIZE_CACHE */
+
+static cfgpack_err_t pageout_stream_impl(cfgpack_ctx_t *ctx,
+                                         cfgpack_sink_fn sink,
+                                         void *user,
+                                         uint8_t *chunk_buf,
+                                         size_t chunk_cap) {
+    uint8_t crc_bytes[CFGPACK_CRC_SIZE];
+    cfgpack_buf_t buf;
+    cfgpack_err_t rc;
+    uint32_t crc;
+
+    if (!ctx || !sink || !chunk_buf) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (chunk_cap < CFGPACK_STREAM_CHUNK_MIN) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+
+    rc = lazy_flush(ctx);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    cfgpack_buf_init_sink(&buf, chunk_buf, chunk_cap, sink, user);
+    cfgpack_buf_crc_begin(&buf);
+    rc = pageout_impl(ctx, &buf, 0, NULL);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (buf.sink_err != CFGPACK_OK) {
+        return (buf.sink_err);
+    }
+
+    crc = cfgpack_buf_crc(&buf);
+    crc_bytes[0] = (uint8_t)(crc);
+    crc_bytes[1] = (uint8_t)(crc >> 8);
+    crc_bytes[2] = (uint8_t)(crc >> 16);
+    crc_bytes[3] = (uint8_t)(crc >> 24);
+    cfgpack_buf_append(&buf, crc_bytes, CFGPACK_CRC_SIZE);
+
+    rc = cfgpack_buf_flush(&buf);
+    if (rc == CFGPACK_OK) {
+        cfgpack_dirty_clear_all(ctx);
+    }
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pageout_stream(cfgpack_ctx_t *ctx,
+                                     cfgpack_sink_fn sink,
+                                     void *user,
+                                     uint8_t *chunk_buf,
+                                     size_t chunk_cap) {
+    cfgpack_err_t rc;
+
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEOUT, ctx);
+    rc = pageout_stream_impl(ctx, sink, user, chunk_buf, chunk_cap);
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEOUT, ctx);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_peek_name(const uint8_t *data,
+                                size_t len,
+                                char *out_name,
+                                size_t out_cap) {
+    const uint8_t *str_ptr;
+    uint32_t map_count;
+    uint32_t str_len;
+    cfgpack_reader_t r;
 
     if (!data || len == 0 || !out_name || out_cap == 0) {
         return (CFGPACK_ERR_DECODE);
@@ -162,6 +1288,24 @@ cfgpack_err_t cfgpack_peek_name(const uint8_t *data,
     len -= CFGPACK_CRC_SIZE;
 
     cfgpack_reader_init(&r, data, len);
+
+    /* Packed blob: the name follows the array header and schema header */
+    if (cfgpack_mp_fmt[data[0]].kind == MP_KIND_ARRAY) {
+        if (cfgpack_msgpack_decode_array_header(&r, &map_count) !=
+                CFGPACK_OK ||
+            cfgpack_msgpack_skip_value(&r) != CFGPACK_OK ||
+            cfgpack_msgpack_decode_str(&r, &str_ptr, &str_len) !=
+                CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (str_len + 1 > out_cap) {
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        memcpy(out_name, str_ptr, str_len);
+        out_name[str_len] = '\0';
+        return (CFGPACK_OK);
+    }
+
     if (cfgpack_msgpack_decode_map_header(&r, &map_count) != CFGPACK_OK) {
         return (CFGPACK_ERR_DECODE);
     }
@@ -175,8 +1319,6 @@ cfgpack_err_t cfgpack_peek_name(const uint8_t *data,
 
         if (key == CFGPACK_INDEX_RESERVED_NAME) {
             /* Found key 0, expect string value */
-            const uint8_t *str_ptr;
-            uint32_t str_len;
             if (cfgpack_msgpack_decode_str(&r, &str_ptr, &str_len) !=
                 CFGPACK_OK) {
                 return (CFGPACK_ERR_DECODE);
@@ -202,60 +1344,250 @@ cfgpack_err_t cfgpack_peek_name(const uint8_t *data,
     return (CFGPACK_ERR_MISSING);
 }
 
-/**
- * @brief Decode a msgpack value into a cfgpack value, writing strings to pool.
- * @param r          Reader state.
- * @param ctx        Context (for string pool access).
- * @param entry_off  Entry offset in schema (for string slot lookup).
- * @param type       Expected type to decode.
- * @param out        Output value structure.
- * @return CFGPACK_OK on success, error code on failure.
- */
-static cfgpack_err_t decode_value(cfgpack_reader_t *r,
-                                  cfgpack_ctx_t *ctx,
-                                  size_t entry_off,
-                                  cfgpack_type_t type,
-                                  cfgpack_value_t *out) {
-    out->type = type;
-    switch (type) {
-    case CFGPACK_TYPE_U8:
-    case CFGPACK_TYPE_U16:
-    case CFGPACK_TYPE_U32:
-    case CFGPACK_TYPE_U64: return cfgpack_msgpack_decode_uint64(r, &out->v.u64);
-    case CFGPACK_TYPE_I8:
-    case CFGPACK_TYPE_I16:
-    case CFGPACK_TYPE_I32:
-    case CFGPACK_TYPE_I64: return cfgpack_msgpack_decode_int64(r, &out->v.i64);
-    case CFGPACK_TYPE_F32: return cfgpack_msgpack_decode_f32(r, &out->v.f32);
-    case CFGPACK_TYPE_F64: return cfgpack_msgpack_decode_f64(r, &out->v.f64);
-    case CFGPACK_TYPE_STR: {
-        const uint8_t *ptr;
-        uint16_t pool_off;
-        uint32_t len;
-        char *dst;
-        uint8_t str_slot;
+cfgpack_err_t cfgpack_peek_header(const uint8_t *data,
+                                  size_t len,
+                                  uint64_t *fingerprint,
+                                  uint32_t *version) {
+    const uint8_t *ptr;
+    cfgpack_reader_t r;
+    uint32_t count;
+    uint32_t n;
+    uint64_t key;
 
-        if (cfgpack_msgpack_decode_str(r, &ptr, &len) != CFGPACK_OK) {
+    if (!data || !fingerprint) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (len <= CFGPACK_CRC_SIZE) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    cfgpack_reader_init(&r, data, len - CFGPACK_CRC_SIZE);
+
+    /* Only headers are read, never values: map header, key 0 and the
+     * name's str header, then the schema header entry */
+    if (cfgpack_mp_fmt[data[0]].kind == MP_KIND_ARRAY) {
+        if (cfgpack_msgpack_decode_array_header(&r, &count) != CFGPACK_OK ||
+            count < 3) {
             return (CFGPACK_ERR_DECODE);
         }
-        if (len > CFGPACK_STR_MAX) {
-            return (CFGPACK_ERR_STR_TOO_LONG);
+    } else {
+        if (cfgpack_msgpack_decode_map_header(&r, &count) != CFGPACK_OK ||
+            count == 0 ||
+            cfgpack_msgpack_decode_uint64(&r, &key) != CFGPACK_OK ||
+            key != CFGPACK_INDEX_RESERVED_NAME ||
+            cfgpack_msgpack_decode_str(&r, &ptr, &n) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
         }
-
-        /* Get string slot and write to pool */
-        str_slot = ctx->schema->entries[entry_off].str_slot;
-        if (str_slot == CFGPACK_STR_SLOT_NONE ||
-            (size_t)str_slot >= ctx->str_offsets_count) {
-            return (CFGPACK_ERR_BOUNDS);
+        if (count < 2 ||
+            cfgpack_msgpack_decode_uint64(&r, &key) != CFGPACK_OK ||
+            key != CFGPACK_INDEX_HEADER) {
+            return (CFGPACK_ERR_MISSING);
         }
+    }
+    if (cfgpack_msgpack_decode_bin(&r, &ptr, &n) != CFGPACK_OK ||
+        n != HEADER_PAYLOAD) {
+        return (CFGPACK_ERR_DECODE);
+    }
 
-        pool_off = ctx->str_offsets[str_slot];
-        if ((size_t)pool_off + len + 1 > ctx->str_pool_cap) {
-            return (CFGPACK_ERR_BOUNDS);
+    *fingerprint = header_fingerprint(ptr);
+    if (version) {
+        *version = ((uint32_t)ptr[8] << 24) | ((uint32_t)ptr[9] << 16) |
+                   ((uint32_t)ptr[10] << 8) | ptr[11];
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Binary-search the offset-index footer of a blob.
+ *
+ * Validates the footer tail, its bin header and key, then positions @p r
+ * on the value of @p index.  The reader is bounded by the footer start so
+ * a corrupt offset cannot run into the footer or the trailer.
+ *
+ * @return CFGPACK_OK; CFGPACK_ERR_DECODE if the blob has no valid footer;
+ *         CFGPACK_ERR_MISSING if @p index is not listed.
+ */
+static cfgpack_err_t blob_find(const uint8_t *blob,
+                               size_t len,
+                               uint16_t index,
+                               cfgpack_reader_t *r) {
+    const uint8_t *tab;
+    uint8_t hdr[5];
+    size_t count;
+    size_t start;
+    size_t lo = 0;
+    size_t hi;
+    size_t h;
+    size_t n;
+
+    if (len < CFGPACK_CRC_SIZE + FOOTER_TAIL) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    len -= CFGPACK_CRC_SIZE;
+    if ((((unsigned)blob[len - 2] << 8) | blob[len - 1]) != FOOTER_MAGIC) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    count = ((size_t)blob[len - 4] << 8) | blob[len - 3];
+    n = count * FOOTER_REC + FOOTER_TAIL;
+    h = footer_bin_hdr(n, hdr);
+    if (len < n + h + sizeof(footer_key)) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    tab = blob + len - n;
+    start = len - n - h - sizeof(footer_key);
+    if (memcmp(tab - h, hdr, h) != 0 ||
+        memcmp(blob + start, footer_key, sizeof(footer_key)) != 0) {
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const uint8_t *rec = tab + mid * FOOTER_REC;
+        uint16_t key = (uint16_t)((rec[0] << 8) | rec[1]);
+
+        if (key < index) {
+            lo = mid + 1;
+        } else if (key > index) {
+            hi = mid;
+        } else {
+            size_t at = ((size_t)rec[2] << 24) | ((size_t)rec[3] << 16) |
+                        ((size_t)rec[4] << 8) | rec[5];
+
+            if (at >= start) {
+                return (CFGPACK_ERR_DECODE);
+            }
+            cfgpack_reader_init(r, blob, start);
+            r->pos = at;
+            return (CFGPACK_OK);
+        }
+    }
+    return (CFGPACK_ERR_MISSING);
+}
+
+cfgpack_err_t cfgpack_blob_get(const uint8_t *blob,
+                               size_t len,
+                               uint16_t index,
+                               cfgpack_value_t *out) {
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+    uint8_t b;
+
+    if (!blob || !out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = blob_find(blob, len, index, &r);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (cfgpack_reader_peek(&r, &b) != CFGPACK_OK) {
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    switch (cfgpack_mp_fmt[b].kind) {
+    case MP_KIND_UINT:
+        rc = cfgpack_msgpack_decode_uint64(&r, &out->v.u64);
+        break;
+    case MP_KIND_INT:
+        rc = cfgpack_msgpack_decode_int64(&r, &out->v.i64);
+        break;
+    case MP_KIND_FLOAT:
+        rc = (b == 0xca) ? cfgpack_msgpack_decode_f32(&r, &out->v.f32)
+                         : cfgpack_msgpack_decode_f64(&r, &out->v.f64);
+        break;
+    case MP_KIND_STR: return (CFGPACK_ERR_TYPE_MISMATCH);
+    default: return (CFGPACK_ERR_DECODE);
+    }
+    if (rc != CFGPACK_OK) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    out->type = (cfgpack_type_t)cfgpack_mp_fmt[b].type;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_blob_get_str(const uint8_t *blob,
+                                   size_t len,
+                                   uint16_t index,
+                                   const char **out,
+                                   uint16_t *out_len) {
+    const uint8_t *ptr;
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+    uint32_t n;
+    uint8_t b;
+
+    if (!blob || !out || !out_len) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = blob_find(blob, len, index, &r);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (cfgpack_reader_peek(&r, &b) != CFGPACK_OK) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (cfgpack_mp_fmt[b].kind != MP_KIND_STR) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    if (cfgpack_msgpack_decode_str(&r, &ptr, &n) != CFGPACK_OK ||
+        n > UINT16_MAX) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    *out = (const char *)ptr;
+    *out_len = (uint16_t)n;
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Decode a msgpack value into a cfgpack value, writing strings to pool.
+ * @param r          Reader state.
+ * @param ctx        Context (for string pool access).
+ * @param entry_off  Entry offset in schema (string slot and max length).
+ * @param type       Expected type to decode.
+ * @param out        Output value structure.
+ * @return CFGPACK_OK on success, error code on failure.
+ */
+static cfgpack_err_t decode_value(cfgpack_reader_t *r,
+                                  cfgpack_ctx_t *ctx,
+                                  size_t entry_off,
+                                  cfgpack_type_t type,
+                                  cfgpack_value_t *out) {
+    const cfgpack_entry_t *entry = &ctx->schema->entries[entry_off];
+
+    out->type = type;
+    switch (type) {
+    case CFGPACK_TYPE_U8:
+    case CFGPACK_TYPE_U16:
+    case CFGPACK_TYPE_U32:
+    case CFGPACK_TYPE_U64: return cfgpack_msgpack_decode_uint64(r, &out->v.u64);
+    case CFGPACK_TYPE_I8:
+    case CFGPACK_TYPE_I16:
+    case CFGPACK_TYPE_I32:
+    case CFGPACK_TYPE_I64: return cfgpack_msgpack_decode_int64(r, &out->v.i64);
+    case CFGPACK_TYPE_F32: return cfgpack_msgpack_decode_f32(r, &out->v.f32);
+    case CFGPACK_TYPE_F64: return cfgpack_msgpack_decode_f64(r, &out->v.f64);
+    case CFGPACK_TYPE_STR: {
+        const uint8_t *ptr;
+        cfgpack_str_off_t pool_off;
+        uint32_t len;
+        char *dst;
+        cfgpack_err_t err;
+
+        if (cfgpack_msgpack_decode_str(r, &ptr, &len) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (len > cfgpack_entry_str_max(entry)) {
+            return (CFGPACK_ERR_STR_TOO_LONG);
+        }
+
+        /* Get string slot and write to pool */
+        err = cfgpack_str_slot(ctx, entry, &pool_off);
+        if (err != CFGPACK_OK) {
+            return (err);
         }
         dst = ctx->str_pool + pool_off;
         memcpy(dst, ptr, len);
         dst[len] = '\0';
+        CFGPACK_STAT_ADD(ctx, pool_bytes, len);
 
         out->v.str.offset = pool_off;
         out->v.str.len = (uint16_t)len;
@@ -263,32 +1595,27 @@ static cfgpack_err_t decode_value(cfgpack_reader_t *r,
     }
     case CFGPACK_TYPE_FSTR: {
         const uint8_t *ptr;
-        uint16_t pool_off;
+        cfgpack_str_off_t pool_off;
         uint32_t len;
         char *dst;
-        uint8_t str_slot;
+        cfgpack_err_t err;
 
         if (cfgpack_msgpack_decode_str(r, &ptr, &len) != CFGPACK_OK) {
             return (CFGPACK_ERR_DECODE);
         }
-        if (len > CFGPACK_FSTR_MAX) {
+        if (len > cfgpack_entry_str_max(entry)) {
             return (CFGPACK_ERR_STR_TOO_LONG);
         }
 
         /* Get string slot and write to pool */
-        str_slot = ctx->schema->entries[entry_off].str_slot;
-        if (str_slot == CFGPACK_STR_SLOT_NONE ||
-            (size_t)str_slot >= ctx->str_offsets_count) {
-            return (CFGPACK_ERR_BOUNDS);
-        }
-
-        pool_off = ctx->str_offsets[str_slot];
-        if ((size_t)pool_off + len + 1 > ctx->str_pool_cap) {
-            return (CFGPACK_ERR_BOUNDS);
+        err = cfgpack_str_slot(ctx, entry, &pool_off);
+        if (err != CFGPACK_OK) {
+            return (err);
         }
         dst = ctx->str_pool + pool_off;
         memcpy(dst, ptr, len);
         dst[len] = '\0';
+        CFGPACK_STAT_ADD(ctx, pool_bytes, len);
 
         out->v.fstr.offset = pool_off;
         out->v.fstr.len = (uint8_t)len;
@@ -352,264 +1679,2516 @@ static const uint8_t coerce_table[_N][_N] = {
 /* clang-format on */
 
 /**
- * @brief Check whether a wire type can be coerced to a schema type.
+ * @brief Check whether a wire type can be coerced to a schema type.
+ *
+ * @param wire_type   Type detected from msgpack wire format.
+ * @param schema_type Type declared in schema.
+ * @return 1 if coercion is allowed (or exact match), 0 otherwise.
+ */
+static int can_coerce_type(cfgpack_type_t wire_type,
+                           cfgpack_type_t schema_type) {
+    if ((unsigned)wire_type >= 12 || (unsigned)schema_type >= 12) {
+        return (0);
+    }
+    return (coerce_table[wire_type][schema_type]);
+}
+
+/**
+ * @brief Detect the type of the next msgpack value and decode it.
+ *
+ * Peeks at the format byte and looks up its wire type in the shared
+ * msgpack format table, then decodes the value accordingly. Supports type
+ * coercion during decode.
+ *
+ * @param r           Reader state.
+ * @param ctx         Context (for string pool access).
+ * @param entry_off   Entry offset in schema.
+ * @param schema_type Expected schema type (for coercion check).
+ * @param out         Output value structure.
+ * @return CFGPACK_OK on success, CFGPACK_ERR_TYPE_MISMATCH if incompatible,
+ *         CFGPACK_ERR_DECODE on parse error.
+ */
+static cfgpack_err_t decode_value_with_coercion(cfgpack_reader_t *r,
+                                                cfgpack_ctx_t *ctx,
+                                                size_t entry_off,
+                                                cfgpack_type_t schema_type,
+                                                cfgpack_value_t *out) {
+    cfgpack_type_t wire_type;
+    int wire_is_unsigned;
+    int schema_is_signed;
+    uint8_t b;
+
+    if (cfgpack_reader_peek(r, &b) != CFGPACK_OK) {
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    /* Detect wire type from format byte (don't consume yet) */
+    wire_type = (cfgpack_type_t)cfgpack_mp_fmt[b].type;
+    if (cfgpack_mp_fmt[b].type == MP_TYPE_NONE) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    if (wire_type == CFGPACK_TYPE_STR) {
+        /* Wire strings carry no str/fstr distinction: match the schema */
+        if (schema_type != CFGPACK_TYPE_FSTR &&
+            schema_type != CFGPACK_TYPE_STR) {
+            return (CFGPACK_ERR_TYPE_MISMATCH);
+        }
+        wire_type = schema_type;
+    }
+
+    /* Check if coercion is allowed */
+    if (!can_coerce_type(wire_type, schema_type)) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+
+    /* If wire type matches schema type (or same decode family), decode directly */
+    if (wire_type == schema_type) {
+        return (decode_value(r, ctx, entry_off, schema_type, out));
+    }
+    CFGPACK_STAT_ADD(ctx, coerced, 1);
+
+    /*
+     * Cross-type coercion: decode using the wire type first, then convert.
+     *
+     * Unsigned widening (u8->u16, etc.) and signed widening (i8->i16, etc.)
+     * work via decode_value directly because decode_uint64 handles all
+     * unsigned formats and decode_int64 handles all signed formats.
+     *
+     * The cases that need explicit conversion:
+     *   - unsigned wire -> signed schema (decode_int64 can't parse 0xcc-0xcf)
+     *   - f32 wire -> f64 schema (decode_f64 can't parse 0xca)
+     */
+    wire_is_unsigned = (wire_type == CFGPACK_TYPE_U8 ||
+                        wire_type == CFGPACK_TYPE_U16 ||
+                        wire_type == CFGPACK_TYPE_U32 ||
+                        wire_type == CFGPACK_TYPE_U64);
+    schema_is_signed = (schema_type == CFGPACK_TYPE_I8 ||
+                        schema_type == CFGPACK_TYPE_I16 ||
+                        schema_type == CFGPACK_TYPE_I32 ||
+                        schema_type == CFGPACK_TYPE_I64);
+
+    if (wire_is_unsigned && schema_is_signed) {
+        /* Decode as uint64, then convert to int64 */
+        cfgpack_value_t tmp;
+        cfgpack_err_t err = decode_value(r, ctx, entry_off, wire_type, &tmp);
+        if (err != CFGPACK_OK) {
+            return (err);
+        }
+        /* Check that the unsigned value fits in int64_t */
+        if (tmp.v.u64 > (uint64_t)INT64_MAX) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        out->type = schema_type;
+        out->v.i64 = (int64_t)tmp.v.u64;
+        return (CFGPACK_OK);
+    }
+
+    if (wire_type == CFGPACK_TYPE_F32 && schema_type == CFGPACK_TYPE_F64) {
+        /* Decode as f32, then widen to f64 */
+        cfgpack_value_t tmp;
+        cfgpack_err_t err = decode_value(r, ctx, entry_off, CFGPACK_TYPE_F32,
+                                         &tmp);
+        if (err != CFGPACK_OK) {
+            return (err);
+        }
+        out->type = CFGPACK_TYPE_F64;
+        out->v.f64 = (double)tmp.v.f32;
+        return (CFGPACK_OK);
+    }
+
+    /* All other allowed coercions (signed widening, unsigned widening,
+     * fstr->str) work via decode_value with the schema type directly */
+    return (decode_value(r, ctx, entry_off, schema_type, out));
+}
+
+/**
+ * @brief Drop presence, dirty bits, the size cache and pending lazy
+ *        entries before a full pagein.
+ *
+ * Every entry present before counts as changed for notification.
+ */
+static void pagein_reset(cfgpack_ctx_t *ctx) {
+    cfgpack_notify_mark_present(ctx);
+    memset(ctx->present, 0, cfgpack_bitmap_bytes(ctx));
+    memset(ctx->dirty, 0, cfgpack_bitmap_bytes(ctx));
+#ifdef CFGPACK_SIZE_CACHE
+    ctx->size_bytes = 0;
+    ctx->size_count = 0;
+#endif
+    cfgpack_lazy_clear(ctx);
+}
+
+static int select_get(const uint8_t *select, size_t off) {
+    return ((select[off / CHAR_BIT] >> (off % CHAR_BIT)) & 1u);
+}
+
+/**
+ * @brief pagein_reset() for the entries of @p select only.
+ *
+ * Each selected entry becomes absent and clean, with its bytes taken out
+ * of the size cache; the other entries are untouched.
+ */
+static void pagein_reset_selected(cfgpack_ctx_t *ctx, const uint8_t *select) {
+    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
+        if (!select_get(select, i)) {
+            continue;
+        }
+        if (cfgpack_presence_get(ctx, i)) {
+            cfgpack_notify_mark(ctx, i);
+            if (cfgpack_lazy_pending(ctx, i)) {
+                cfgpack_lazy_mark(ctx, i, 0); /* pending: not counted yet */
+            } else {
+                cfgpack_size_sub(ctx, i);
+            }
+            cfgpack_presence_clear(ctx, i);
+        }
+        cfgpack_dirty_clear(ctx, i);
+    }
+}
+
+/**
+ * @brief Restore presence of schema defaults after a full pagein.
+ * @param select Entries the pagein covered, or NULL for all of them.
+ */
+static cfgpack_err_t pagein_restore_defaults(cfgpack_ctx_t *ctx,
+                                             const uint8_t *select) {
+    /* Restore defaults for entries not covered by old data.
+     * After decoding, any entry with has_default that wasn't set by the
+     * incoming data should still be marked present so its schema default
+     * is accessible via cfgpack_get().  With cfgpack_defaults_init()
+     * attached the default is decoded again, since the slot may have been
+     * overwritten since init. */
+    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
+        if (select && !select_get(select, i)) {
+            continue;
+        }
+        if (!cfgpack_presence_get(ctx, i) &&
+            ctx->schema->entries[i].has_default) {
+#ifdef CFGPACK_DEFAULTS_BLOB
+            if (ctx->def_off && ctx->def_off[i]) {
+                cfgpack_reader_t d;
+                cfgpack_value_t val;
+                cfgpack_err_t err;
+
+                cfgpack_reader_init(&d, ctx->def_blob, ctx->def_len);
+                d.pos = ctx->def_off[i];
+                err = decode_value_with_coercion(
+                    &d, ctx, i, ctx->schema->entries[i].type, &val);
+                if (err != CFGPACK_OK) {
+                    return (err);
+                }
+                cfgpack_value_commit(ctx, i, &val);
+                continue;
+            }
+#endif
+            cfgpack_presence_set(ctx, i);
+            cfgpack_size_add(ctx, i);
+        }
+    }
+    if (!select) {
+        cfgpack_notify_mark_present(ctx);
+        return (CFGPACK_OK);
+    }
+    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
+        if (select_get(select, i) && cfgpack_presence_get(ctx, i)) {
+            cfgpack_notify_mark(ctx, i);
+        }
+    }
+
+    return (CFGPACK_OK);
+}
+
+#ifdef CFGPACK_PACKED_WIRE
+/**
+ * @brief Decode a CRC-verified packed blob from @p r into the context.
+ *
+ * The packed counterpart of pagein_apply() for a full pagein.  The blob
+ * must have the layout fingerprint of the context's schema, so no remap
+ * is needed: the bitmap becomes the presence bitmap and each present
+ * entry's value is decoded in turn, with no key lookup.
+ */
+static cfgpack_err_t pagein_apply_packed(cfgpack_ctx_t *ctx,
+                                         cfgpack_reader_t *r) {
+    size_t n = ctx->schema->entry_count;
+    size_t bits_want = (n + CHAR_BIT - 1) / CHAR_BIT;
+    int lazy = cfgpack_is_lazy(ctx) && !r->src;
+    const uint8_t *bits;
+    const uint8_t *name;
+    uint32_t bits_len;
+    uint32_t name_len;
+    uint32_t count;
+    uint32_t set = 0;
+    uint64_t fp;
+
+    if (cfgpack_msgpack_decode_array_header(r, &count) != CFGPACK_OK ||
+        count < 3 ||
+        cfgpack_msgpack_decode_bin(r, &bits, &bits_len) != CFGPACK_OK ||
+        bits_len != HEADER_PAYLOAD) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    fp = header_fingerprint(bits);
+    if (cfgpack_msgpack_decode_str(r, &name, &name_len) != CFGPACK_OK ||
+        cfgpack_msgpack_decode_bin(r, &bits, &bits_len) != CFGPACK_OK) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (fp != cfgpack_schema_fingerprint(ctx->schema) ||
+        bits_len != bits_want) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    count -= 3;
+
+    /* One value per set bit, checked before anything changes: a blob can
+     * pass its CRC and still disagree with itself */
+    for (size_t i = 0; i < n; ++i) {
+        set += (bits[i / CHAR_BIT] >> (i % CHAR_BIT)) & 1u;
+    }
+    if (set != count) {
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    /* The bitmap may sit in a stream window, so copy it before the first
+     * value is read; bits past the last entry are dropped */
+    pagein_reset(ctx);
+    memcpy(ctx->present, bits, bits_len);
+    if (n % CHAR_BIT) {
+        ctx->present[bits_len - 1] &= (uint8_t)((1u << (n % CHAR_BIT)) - 1);
+    }
+    if (lazy) {
+        cfgpack_lazy_source(ctx, r->data, r->len);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        cfgpack_value_t val;
+        cfgpack_err_t err;
+
+        if (!cfgpack_presence_get(ctx, i)) {
+            continue;
+        }
+        if (lazy) {
+            cfgpack_lazy_mark(ctx, i, (uint32_t)r->pos);
+            if (cfgpack_msgpack_skip_value(r) != CFGPACK_OK) {
+                for (size_t j = i; j < n; ++j) {
+                    cfgpack_presence_clear(ctx, j);
+                }
+                return (CFGPACK_ERR_DECODE);
+            }
+            CFGPACK_STAT_ADD(ctx, skipped, 1);
+            continue;
+        }
+        /* Entries from here on are absent until their value is in, as
+         * after a failed pagein_apply() */
+        cfgpack_presence_clear(ctx, i);
+        err = decode_value_with_coercion(r, ctx, i,
+                                         ctx->schema->entries[i].type, &val);
+        if (err != CFGPACK_OK) {
+            for (size_t j = i; j < n; ++j) {
+                cfgpack_presence_clear(ctx, j);
+            }
+            return (err);
+        }
+        CFGPACK_STAT_ADD(ctx, decoded, 1);
+        cfgpack_value_commit(ctx, i, &val);
+    }
+    return (pagein_restore_defaults(ctx, NULL));
+}
+#endif /* CFGPACK_PACKED_WIRE */
+
+/* pagein_apply() modes */
+#define PAGEIN_FULL  0 /**< Replace the context's state. */
+#define PAGEIN_MERGE 1 /**< Keep it; decoded keys overwrite (delta). */
+#define PAGEIN_FILL  2 /**< Keep it; only absent entries are decoded. */
+
+/**
+ * @brief pagein_apply() up to the first key: read the map header, reset
+ *        the context and set up the cursors in @p s.
+ *
+ * @p s must hold the remap table, @c merge and @c select.
+ */
+static cfgpack_err_t pagein_open(cfgpack_ctx_t *ctx,
+                                 cfgpack_pagein_step_t *s,
+                                 cfgpack_reader_t *r) {
+    if (cfgpack_msgpack_decode_map_header(r, &s->keys) != CFGPACK_OK) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    s->lazy = !s->merge && !s->select && cfgpack_is_lazy(ctx) && !r->src;
+    s->remap_sorted = 1;
+    s->rcur = 0;
+    s->cur = 0;
+
+    if (s->select) {
+        pagein_reset_selected(ctx, s->select);
+    } else if (!s->merge) {
+        pagein_reset(ctx);
+    }
+    if (s->lazy) {
+        cfgpack_lazy_source(ctx, r->data, r->len);
+    }
+
+    if (s->remap != NULL) {
+        for (size_t ri = 1; ri < s->remap_count; ++ri) {
+            if (s->remap[ri].old_index <= s->remap[ri - 1].old_index) {
+                s->remap_sorted = 0;
+                break;
+            }
+        }
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Decode the next key of the map opened by pagein_open().
+ */
+static cfgpack_err_t pagein_key(cfgpack_ctx_t *ctx,
+                                cfgpack_pagein_step_t *s,
+                                cfgpack_reader_t *r) {
+    const cfgpack_schema_t *schema = ctx->schema;
+    const cfgpack_remap_entry_t *remap = s->remap;
+    const cfgpack_entry_t *entry;
+    uint16_t target_index;
+    cfgpack_value_t val;
+    cfgpack_err_t err;
+    uint64_t key;
+    size_t idx;
+
+    s->keys--;
+    if (cfgpack_msgpack_decode_uint64(r, &key) != CFGPACK_OK) {
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    /* A schema header of this schema's layout: keys are already this
+     * schema's indices, so the remap table is not needed */
+    if (key == CFGPACK_INDEX_HEADER) {
+        const uint8_t *hdr;
+        uint32_t hdr_len;
+
+        if (cfgpack_msgpack_decode_bin(r, &hdr, &hdr_len) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (remap != NULL && hdr_len == HEADER_PAYLOAD &&
+            header_fingerprint(hdr) == cfgpack_schema_fingerprint(schema)) {
+            s->remap = NULL;
+        }
+        return (CFGPACK_OK);
+    }
+
+    /* Skip reserved index 0 (schema name) and keys outside the index
+     * range */
+    if (key == CFGPACK_INDEX_RESERVED_NAME || key > UINT16_MAX) {
+        if (cfgpack_msgpack_skip_value(r) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (key != CFGPACK_INDEX_RESERVED_NAME) {
+            CFGPACK_STAT_ADD(ctx, skipped, 1);
+        }
+        return (CFGPACK_OK);
+    }
+
+    /* Apply remap if provided */
+    target_index = (uint16_t)key;
+    if (remap != NULL && s->remap_sorted) {
+        size_t rcur = s->rcur;
+
+        if (rcur > 0 && remap[rcur - 1].old_index >= key) {
+            rcur = 0; /* keys went backwards: rescan from the start */
+        }
+        while (rcur < s->remap_count && remap[rcur].old_index < key) {
+            rcur++;
+        }
+        if (rcur < s->remap_count && remap[rcur].old_index == key) {
+            target_index = remap[rcur].new_index;
+            rcur++;
+        }
+        s->rcur = rcur;
+    } else if (remap != NULL) {
+        for (size_t ri = 0; ri < s->remap_count; ++ri) {
+            if (remap[ri].old_index == (uint16_t)key) {
+                target_index = remap[ri].new_index;
+                break;
+            }
+        }
+    }
+
+    /* Find matching entry: cursor first, then indexed lookup */
+    if (s->cur < schema->entry_count &&
+        schema->entries[s->cur].index == target_index) {
+        entry = &schema->entries[s->cur];
+    } else {
+        entry = cfgpack_find_entry(ctx, target_index);
+    }
+    idx = 0;
+    if (entry) {
+        idx = (size_t)(entry - schema->entries);
+        s->cur = idx + 1;
+    }
+
+    /* Unknown, filtered-out or already filled key: silently skip */
+    if (!entry || (s->select && !select_get(s->select, idx)) ||
+        (s->merge == PAGEIN_FILL && cfgpack_presence_get(ctx, idx))) {
+        if (cfgpack_msgpack_skip_value(r) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        CFGPACK_STAT_ADD(ctx, skipped, 1);
+        return (CFGPACK_OK);
+    }
+
+    /* Lazy: remember the value's offset (never 0: the map header comes
+     * first); it is counted in the size cache once decoded */
+    if (s->lazy) {
+        cfgpack_lazy_mark(ctx, idx, (uint32_t)r->pos);
+        if (cfgpack_msgpack_skip_value(r) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        cfgpack_presence_set(ctx, idx);
+        cfgpack_dirty_clear(ctx, idx);
+        CFGPACK_STAT_ADD(ctx, skipped, 1);
+        return (CFGPACK_OK);
+    }
+
+    /* Decode value with type coercion support */
+    err = decode_value_with_coercion(r, ctx, idx, entry->type, &val);
+    if (err != CFGPACK_OK) {
+        return (err);
+    }
+    CFGPACK_STAT_ADD(ctx, decoded, 1);
+    cfgpack_value_commit(ctx, idx, &val);
+    cfgpack_dirty_clear(ctx, idx);
+    if (s->merge) {
+        cfgpack_notify_mark(ctx, idx);
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Finish the map once every key is decoded.
+ */
+static cfgpack_err_t pagein_close(cfgpack_ctx_t *ctx,
+                                  const cfgpack_pagein_step_t *s) {
+    if (s->merge) {
+        return (CFGPACK_OK);
+    }
+    return (pagein_restore_defaults(ctx, s->select));
+}
+
+/**
+ * @brief Decode a CRC-verified map from @p r into the context.
+ *
+ * Shared by the flat-buffer and streaming pagein paths.  Clears presence,
+ * decodes each known key (with remap and coercion), then restores presence
+ * for entries with schema defaults.  With @p merge set to PAGEIN_MERGE
+ * (delta pagein), existing values and presence are kept and only decoded
+ * keys change.  PAGEIN_FILL (layered pagein) also skips the keys of
+ * entries that are already present, so the layer applied first wins.
+ * The context is in sync with storage afterwards, so dirty bits of decoded
+ * entries (all entries, unless merging) are cleared.
+ *
+ * With cfgpack_lazy_init() attached, a full pagein from a flat buffer only
+ * records where each known value starts, marks it present and skips it;
+ * cfgpack_lazy_resolve() decodes it on first access.
+ *
+ * Keys are matched with a merge-join: cfgpack_pageout() writes keys in
+ * entry order, so a cursor into the schema entries (and into the remap
+ * table, if it is sorted by old_index) normally hits on the first compare.
+ * A key that does not match the cursor falls back to cfgpack_find_entry()
+ * and re-syncs the cursor, so unsorted blobs decode correctly too.
+ *
+ * With @p select (filtered pagein), only the selected entries are reset
+ * and decoded, as in a full pagein; keys of the others are skipped and
+ * their values, presence and dirty bits are kept.
+ *
+ * A packed blob from cfgpack_pageout_packed() goes to
+ * pagein_apply_packed(); it cannot be merged or filtered.
+ */
+static cfgpack_err_t pagein_apply(cfgpack_ctx_t *ctx,
+                                  cfgpack_reader_t *r,
+                                  const cfgpack_remap_entry_t *remap,
+                                  size_t remap_count,
+                                  int merge,
+                                  const uint8_t *select) {
+    cfgpack_pagein_step_t s;
+    cfgpack_err_t rc;
+#ifdef CFGPACK_PACKED_WIRE
+    uint8_t b;
+#endif
+
+#ifdef CFGPACK_PACKED_WIRE
+    /* A packed blob is an array; a delta is always a map */
+    if (cfgpack_reader_peek(r, &b) == CFGPACK_OK &&
+        cfgpack_mp_fmt[b].kind == MP_KIND_ARRAY) {
+        return (merge || select ? CFGPACK_ERR_DECODE
+                                : pagein_apply_packed(ctx, r));
+    }
+#endif
+    s.remap = remap;
+    s.remap_count = remap_count;
+    s.merge = (uint8_t)merge;
+    s.select = select;
+    rc = pagein_open(ctx, &s, r);
+    while (rc == CFGPACK_OK && s.keys > 0) {
+        rc = pagein_key(ctx, &s, r);
+    }
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (pagein_close(ctx, &s));
+}
+
+/**
+ * @brief pagein_apply() as one seqlock write section, then one
+ *        notification pass.
+ *
+ * Consistent readers retry while a pagein runs, so they never see a mix
+ * of the old and the new config.  Subscribers are notified even if the
+ * pagein failed part-way, since the context may have changed.
+ */
+static cfgpack_err_t pagein_decode(cfgpack_ctx_t *ctx,
+                                   cfgpack_reader_t *r,
+                                   const cfgpack_remap_entry_t *remap,
+                                   size_t remap_count,
+                                   int merge,
+                                   const uint8_t *select) {
+    cfgpack_err_t rc;
+
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_seq_write_begin(ctx);
+    rc = pagein_apply(ctx, r, remap, remap_count, merge, select);
+    cfgpack_seq_write_end(ctx);
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_notify_dispatch(ctx);
+    return (rc);
+}
+
+#ifdef CFGPACK_LAZY
+cfgpack_err_t cfgpack_lazy_resolve(cfgpack_ctx_t *ctx, size_t off) {
+    cfgpack_reader_t r;
+    cfgpack_value_t val;
+    cfgpack_err_t err;
+
+    cfgpack_reader_init(&r, ctx->lazy_blob, ctx->lazy_len);
+    r.pos = ctx->lazy_off[off];
+    err = decode_value_with_coercion(&r, ctx, off,
+                                     ctx->schema->entries[off].type, &val);
+    if (err != CFGPACK_OK) {
+        return (err);
+    }
+    CFGPACK_STAT_ADD(ctx, decoded, 1);
+    cfgpack_value_commit(ctx, off, &val);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_lazy_init(cfgpack_ctx_t *ctx,
+                                uint32_t *offsets,
+                                size_t count) {
+    if (!ctx || !offsets) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (count < ctx->schema->entry_count) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    memset(offsets, 0, ctx->schema->entry_count * sizeof(offsets[0]));
+    ctx->lazy_off = offsets;
+    ctx->lazy_blob = NULL;
+    ctx->lazy_len = 0;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_lazy_finish(cfgpack_ctx_t *ctx) {
+    if (!ctx) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    return (lazy_flush(ctx));
+}
+#endif /* CFGPACK_LAZY */
+
+/**
+ * @brief Check the CRC-32C trailer of a flat blob.
+ * @param body_len  Receives @p len minus the trailer.
+ */
+static cfgpack_err_t verify_blob(const uint8_t *data,
+                                 size_t len,
+                                 size_t *body_len) {
+    uint32_t stored_crc;
+    uint32_t actual_crc;
+
+    if (!data || len < CFGPACK_CRC_SIZE) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    stored_crc = (uint32_t)data[len - 4] | ((uint32_t)data[len - 3] << 8) |
+                 ((uint32_t)data[len - 2] << 16) |
+                 ((uint32_t)data[len - 1] << 24);
+    /* Verify before decoding: values are written into ctx as they are
+     * decoded, so a corrupt blob must be rejected before any are touched. */
+    actual_crc = cfgpack_crc32c(data, len - CFGPACK_CRC_SIZE);
+    if (stored_crc != actual_crc) {
+        return (CFGPACK_ERR_CRC);
+    }
+    *body_len = len - CFGPACK_CRC_SIZE;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_blob_verify(const uint8_t *blob, size_t len) {
+    size_t body_len;
+
+    return (verify_blob(blob, len, &body_len));
+}
+
+static uint32_t be32_get(const uint8_t *p) {
+    return (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+            ((uint32_t)p[2] << 8) | p[3]);
+}
+
+size_t cfgpack_sections_offset(const cfgpack_sections_t *t, size_t i) {
+    return (i < t->count ? be32_get(t->recs + i * SECTION_REC) : t->end);
+}
+
+cfgpack_err_t cfgpack_sections_open(const uint8_t *blob,
+                                    size_t len,
+                                    cfgpack_sections_t *out) {
+    const uint8_t *tab;
+    uint8_t hdr[5];
+    uint32_t crc;
+    size_t count;
+    size_t prev = 0;
+    size_t h;
+    size_t n;
+
+    if (!blob || !out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (len < CFGPACK_CRC_SIZE + SECTION_TAIL) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    len -= CFGPACK_CRC_SIZE;
+    if ((((unsigned)blob[len - 2] << 8) | blob[len - 1]) != SECTION_MAGIC) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    count = ((size_t)blob[len - 4] << 8) | blob[len - 3];
+    n = count * SECTION_REC + SECTION_TAIL;
+    h = footer_bin_hdr(n, hdr);
+    if (len < n + h + sizeof(sections_key)) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    tab = blob + len - n;
+    if (memcmp(tab - h, hdr, h) != 0 ||
+        memcmp(tab - h - sizeof(sections_key), sections_key,
+               sizeof(sections_key)) != 0) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    crc = cfgpack_crc32c_update(cfgpack_crc32c_init(), tab, n - SECTION_TAIL);
+    crc = cfgpack_crc32c_update(crc, blob + len - 4, 2);
+    if (cfgpack_crc32c_final(crc) != be32_get(blob + len - SECTION_TAIL)) {
+        return (CFGPACK_ERR_CRC);
+    }
+
+    out->blob = blob;
+    out->recs = tab;
+    out->count = count;
+    out->end = len - n - h - sizeof(sections_key);
+    out->body = len;
+    for (size_t i = 0; i < count; ++i) {
+        size_t at = be32_get(tab + i * SECTION_REC);
+
+        if (at <= prev || at >= out->end) {
+            return (CFGPACK_ERR_CRC);
+        }
+        prev = at;
+    }
+    return (CFGPACK_OK);
+}
+
+size_t cfgpack_sections_check(const cfgpack_sections_t *t,
+                              size_t first,
+                              size_t n,
+                              uint8_t *bad,
+                              uint32_t *crc) {
+    uint32_t all = 0;
+    size_t nbad = 0;
+
+    if (first > t->count) {
+        first = t->count;
+    }
+    if (n > t->count - first) {
+        n = t->count - first;
+    }
+    for (size_t i = first; i < first + n; ++i) {
+        uint8_t bit = (uint8_t)(1u << (i % CHAR_BIT));
+        size_t start;
+        size_t end;
+        uint32_t c;
+
+        start = cfgpack_sections_offset(t, i);
+        end = cfgpack_sections_offset(t, i + 1);
+        c = cfgpack_crc32c(t->blob + start, end - start);
+        all = i == first ? c : cfgpack_crc32c_combine(all, c, end - start);
+        if (c != be32_get(t->recs + i * SECTION_REC + 4)) {
+            nbad++;
+            if (bad) {
+                bad[i / CHAR_BIT] |= bit;
+            }
+        } else if (bad) {
+            bad[i / CHAR_BIT] &= (uint8_t)~bit;
+        }
+    }
+    if (crc) {
+        *crc = all;
+    }
+    return (nbad);
+}
+
+cfgpack_err_t cfgpack_sections_verify(const uint8_t *blob,
+                                      size_t len,
+                                      uint8_t *bad,
+                                      size_t bad_len,
+                                      size_t *bad_count) {
+    cfgpack_sections_t t;
+    cfgpack_err_t rc;
+    size_t first;
+    size_t nbad;
+    uint32_t crc;
+    uint32_t c;
+
+    if (bad_count) {
+        *bad_count = 0;
+    }
+    rc = cfgpack_sections_open(blob, len, &t);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (bad && bad_len < (t.count + CHAR_BIT - 1) / CHAR_BIT) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    if (bad) {
+        memset(bad, 0, (t.count + CHAR_BIT - 1) / CHAR_BIT);
+    }
+
+    /* Prelude, sections, then the table, folded into the trailer CRC */
+    first = cfgpack_sections_offset(&t, 0);
+    crc = cfgpack_crc32c(blob, first);
+    nbad = cfgpack_sections_check(&t, 0, t.count, bad, &c);
+    crc = cfgpack_crc32c_combine(crc, c, t.end - first);
+    c = cfgpack_crc32c(blob + t.end, t.body - t.end);
+    crc = cfgpack_crc32c_combine(crc, c, t.body - t.end);
+
+    if (bad_count) {
+        *bad_count = nbad;
+    }
+    if (nbad || crc != ((uint32_t)blob[len - 4] |
+                        ((uint32_t)blob[len - 3] << 8) |
+                        ((uint32_t)blob[len - 2] << 16) |
+                        ((uint32_t)blob[len - 1] << 24))) {
+        return (CFGPACK_ERR_CRC);
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Decode the key/value pairs of one verified section.
+ *
+ * The reader stops at the section end, so a section can only set the
+ * entries it holds.  Unknown and reserved keys are skipped.
+ */
+static cfgpack_err_t pagein_section(cfgpack_ctx_t *ctx,
+                                    const uint8_t *blob,
+                                    size_t start,
+                                    size_t end) {
+    cfgpack_reader_t r;
+
+    cfgpack_reader_init(&r, blob, end);
+    r.pos = start;
+    while (r.pos < end) {
+        const cfgpack_entry_t *entry = NULL;
+        cfgpack_value_t val;
+        cfgpack_err_t err;
+        uint64_t key;
+        size_t idx;
+
+        if (cfgpack_msgpack_decode_uint64(&r, &key) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (key != CFGPACK_INDEX_RESERVED_NAME && key <= UINT16_MAX) {
+            entry = cfgpack_find_entry(ctx, (uint16_t)key);
+        }
+        if (!entry) {
+            if (cfgpack_msgpack_skip_value(&r) != CFGPACK_OK) {
+                return (CFGPACK_ERR_DECODE);
+            }
+            CFGPACK_STAT_ADD(ctx, skipped, 1);
+            continue;
+        }
+        idx = (size_t)(entry - ctx->schema->entries);
+        err = decode_value_with_coercion(&r, ctx, idx, entry->type, &val);
+        if (err != CFGPACK_OK) {
+            return (err);
+        }
+        CFGPACK_STAT_ADD(ctx, decoded, 1);
+        cfgpack_value_commit(ctx, idx, &val);
+        cfgpack_dirty_clear(ctx, idx);
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Reset the context, decode the good sections, restore defaults.
+ */
+static cfgpack_err_t pagein_apply_sections(cfgpack_ctx_t *ctx,
+                                           const cfgpack_sections_t *t,
+                                           const uint8_t *bad,
+                                           size_t *lost) {
+    pagein_reset(ctx);
+    for (size_t i = 0; i < t->count; ++i) {
+        cfgpack_err_t err;
+        size_t start;
+        size_t end;
+        int ok;
+
+        if (bad) {
+            ok = !select_get(bad, i);
+        } else {
+            ok = cfgpack_sections_check(t, i, 1, NULL, NULL) == 0;
+        }
+        if (!ok) {
+            (*lost)++;
+            continue;
+        }
+        start = cfgpack_sections_offset(t, i);
+        end = cfgpack_sections_offset(t, i + 1);
+        err = pagein_section(ctx, t->blob, start, end);
+        if (err != CFGPACK_OK) {
+            return (err);
+        }
+    }
+    return (pagein_restore_defaults(ctx, NULL));
+}
+
+cfgpack_err_t cfgpack_pagein_sections(cfgpack_ctx_t *ctx,
+                                      const uint8_t *data,
+                                      size_t len,
+                                      const uint8_t *bad,
+                                      size_t *lost) {
+    cfgpack_sections_t t;
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+    size_t body;
+    size_t n = 0;
+
+    if (lost) {
+        *lost = 0;
+    }
+    if (!ctx) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (!data || cfgpack_sections_open(data, len, &t) != CFGPACK_OK) {
+        return (cfgpack_pagein_buf(ctx, data, len));
+    }
+    if (!bad && verify_blob(data, len, &body) == CFGPACK_OK) {
+        cfgpack_reader_init(&r, data, body);
+        return (pagein_decode(ctx, &r, NULL, 0, PAGEIN_FULL, NULL));
+    }
+
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_seq_write_begin(ctx);
+    rc = pagein_apply_sections(ctx, &t, bad, &n);
+    cfgpack_seq_write_end(ctx);
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_notify_dispatch(ctx);
+    if (lost) {
+        *lost = n;
+    }
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_blob_extent(const uint8_t *data,
+                                  size_t len,
+                                  size_t *blob_len) {
+    cfgpack_reader_t r;
+    uint8_t b;
+
+    if (!data || !blob_len) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (len == 0) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    /* A map, or the array of a packed blob; erased flash is neither */
+    b = data[0];
+    if (!((b >= 0x80 && b <= 0x9f) || (b >= 0xdc && b <= 0xdf))) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    cfgpack_reader_init(&r, data, len);
+    if (cfgpack_msgpack_skip_value(&r) != CFGPACK_OK ||
+        len - r.pos < CFGPACK_CRC_SIZE) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    *blob_len = r.pos + CFGPACK_CRC_SIZE;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_pagein_aligned(cfgpack_ctx_t *ctx,
+                                     const uint8_t *data,
+                                     size_t len,
+                                     size_t *blob_len) {
+    cfgpack_err_t rc;
+    size_t n;
+
+    if (!ctx || !data) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = cfgpack_blob_extent(data, len, &n);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (blob_len) {
+        *blob_len = n;
+    }
+    return (cfgpack_pagein_buf(ctx, data, n));
+}
+
+#ifdef CFGPACK_DEFAULTS_BLOB
+cfgpack_err_t cfgpack_defaults_init(cfgpack_ctx_t *ctx,
+                                    const uint8_t *blob,
+                                    size_t len,
+                                    uint32_t *offsets,
+                                    size_t count) {
+    uint32_t map_count = 0;
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+
+    if (!ctx || !blob || !offsets) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (count < ctx->schema->entry_count) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    rc = verify_blob(blob, len, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    ctx->def_off = NULL;
+    memset(offsets, 0, ctx->schema->entry_count * sizeof(offsets[0]));
+    cfgpack_reader_init(&r, blob, len);
+    if (cfgpack_msgpack_decode_map_header(&r, &map_count) != CFGPACK_OK) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    for (uint32_t i = 0; i < map_count; ++i) {
+        const cfgpack_entry_t *entry = NULL;
+        uint64_t key;
+
+        if (cfgpack_msgpack_decode_uint64(&r, &key) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (key != CFGPACK_INDEX_RESERVED_NAME && key <= UINT16_MAX) {
+            entry = cfgpack_find_entry(ctx, (uint16_t)key);
+        }
+        /* Offsets are never 0: the map header comes first */
+        if (entry) {
+            offsets[entry - ctx->schema->entries] = (uint32_t)r.pos;
+        }
+        if (cfgpack_msgpack_skip_value(&r) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+    }
+
+    ctx->def_off = offsets;
+    ctx->def_blob = blob;
+    ctx->def_len = len;
+    return (CFGPACK_OK);
+}
+#endif /* CFGPACK_DEFAULTS_BLOB */
+
+cfgpack_err_t cfgpack_pagein_remap(cfgpack_ctx_t *ctx,
+                                   const uint8_t *data,
+                                   size_t len,
+                                   const cfgpack_remap_entry_t *remap,
+                                   size_t remap_count) {
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+
+    if (!ctx) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = verify_blob(data, len, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    cfgpack_reader_init(&r, data, len);
+    return (pagein_decode(ctx, &r, remap, remap_count, PAGEIN_FULL, NULL));
+}
+
+/**
+ * @brief Point @p tmp at the stage buffers, filled from @p ctx.
+ */
+static void stage_fill(const cfgpack_ctx_t *ctx,
+                       cfgpack_ctx_t *tmp,
+                       const cfgpack_stage_t *stage) {
+    *tmp = *ctx;
+    memcpy(stage->values, ctx->values,
+           ctx->schema->entry_count * sizeof(ctx->values[0]));
+    if (ctx->str_pool_cap) {
+        memcpy(stage->str_pool, ctx->str_pool, ctx->str_pool_cap);
+    }
+    if (ctx->str_offsets_count) {
+        memcpy(stage->str_offsets, ctx->str_offsets,
+               ctx->str_offsets_count * sizeof(ctx->str_offsets[0]));
+    }
+    tmp->values = stage->values;
+    tmp->values_count = stage->values_count;
+    tmp->str_pool = stage->str_pool;
+    tmp->str_pool_cap = stage->str_pool_cap;
+    tmp->str_offsets = stage->str_offsets;
+    tmp->str_offsets_count = stage->str_offsets_count;
+#ifdef CFGPACK_LARGE_SCHEMA
+    memcpy(stage->bitmaps, ctx->present, 3 * ctx->bitmap_bytes);
+    tmp->present = stage->bitmaps;
+    tmp->dirty = stage->bitmaps + ctx->bitmap_bytes;
+#endif
+    /* Nothing is pending after lazy_flush(); notify after the swap only */
+#ifdef CFGPACK_LAZY
+    tmp->lazy_off = NULL;
+#endif
+#ifdef CFGPACK_NOTIFY
+    tmp->notify_bits = NULL;
+#endif
+}
+
+/**
+ * @brief Publish the decoded @p tmp in @p ctx, handing the old buffers
+ *        to @p stage.
+ */
+static void stage_swap(cfgpack_ctx_t *ctx,
+                       const cfgpack_ctx_t *tmp,
+                       cfgpack_stage_t *stage) {
+    stage->values = ctx->values;
+    stage->values_count = ctx->values_count;
+    stage->str_pool = ctx->str_pool;
+    stage->str_pool_cap = ctx->str_pool_cap;
+    stage->str_offsets = ctx->str_offsets;
+    stage->str_offsets_count = ctx->str_offsets_count;
+    ctx->values = tmp->values;
+    ctx->values_count = tmp->values_count;
+    ctx->str_pool = tmp->str_pool;
+    ctx->str_pool_cap = tmp->str_pool_cap;
+    ctx->str_offsets = tmp->str_offsets;
+    ctx->str_offsets_count = tmp->str_offsets_count;
+#ifdef CFGPACK_LARGE_SCHEMA
+    stage->bitmaps = ctx->present;
+    ctx->present = tmp->present;
+    ctx->dirty = tmp->dirty;
+#else
+    memcpy(ctx->present, tmp->present, sizeof(ctx->present));
+    memcpy(ctx->dirty, tmp->dirty, sizeof(ctx->dirty));
+#endif
+    ctx->str_pool_used = tmp->str_pool_used;
+#ifdef CFGPACK_SIZE_CACHE
+    ctx->size_bytes = tmp->size_bytes;
+    ctx->size_count = tmp->size_count;
+#endif
+}
+
+cfgpack_err_t cfgpack_pagein_staged(cfgpack_ctx_t *ctx,
+                                    const uint8_t *data,
+                                    size_t len,
+                                    const cfgpack_remap_entry_t *remap,
+                                    size_t remap_count,
+                                    cfgpack_stage_t *stage) {
+    cfgpack_reader_t r;
+    cfgpack_ctx_t tmp;
+    cfgpack_err_t rc;
+
+    if (!ctx || !stage || !stage->values ||
+        (ctx->str_pool_cap && !stage->str_pool) ||
+        (ctx->str_offsets_count && !stage->str_offsets)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+#ifdef CFGPACK_LARGE_SCHEMA
+    if (!stage->bitmaps) {
+        return (CFGPACK_ERR_ARGS);
+    }
+#endif
+    if (cfgpack_is_packed(ctx) || cfgpack_in_txn(ctx)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (stage->values_count < ctx->schema->entry_count ||
+        stage->str_pool_cap < ctx->str_pool_cap ||
+        stage->str_offsets_count < ctx->str_offsets_count) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    rc = verify_blob(data, len, &len);
+    if (rc == CFGPACK_OK) {
+        rc = lazy_flush(ctx);
+    }
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEIN, ctx);
+    stage_fill(ctx, &tmp, stage);
+    cfgpack_reader_init(&r, data, len);
+    rc = pagein_apply(&tmp, &r, remap, remap_count, PAGEIN_FULL, NULL);
+    if (rc == CFGPACK_OK) {
+        cfgpack_notify_mark_present(ctx);
+        cfgpack_seq_write_begin(ctx);
+        stage_swap(ctx, &tmp, stage);
+        cfgpack_seq_write_end(ctx);
+        cfgpack_notify_mark_present(ctx);
+    }
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_notify_dispatch(ctx);
+    return (rc);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Remap compilation
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Position of the first entry in sorted @p t with old_index >= @p key.
+ */
+static size_t remap_lower_bound(const cfgpack_remap_entry_t *t,
+                                size_t n,
+                                uint16_t key) {
+    size_t lo = 0;
+    size_t hi = n;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (t[mid].old_index < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo);
+}
+
+/**
+ * @brief Apply one (unsorted) remap step to @p index; identity if absent.
+ */
+static uint16_t remap_apply(const cfgpack_remap_entry_t *t,
+                            size_t n,
+                            uint16_t index) {
+    for (size_t i = 0; i < n; ++i) {
+        if (t[i].old_index == index) {
+            return (t[i].new_index);
+        }
+    }
+    return (index);
+}
+
+cfgpack_err_t cfgpack_remap_compile(const cfgpack_remap_entry_t *const *tables,
+                                    const size_t *counts,
+                                    size_t table_count,
+                                    cfgpack_remap_entry_t *out,
+                                    size_t out_cap,
+                                    size_t *out_count) {
+    size_t n = 0;
+    size_t kept = 0;
+
+    if (!tables || !counts || !out_count || (!out && out_cap > 0)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+
+    for (size_t t = 0; t < table_count; ++t) {
+        const cfgpack_remap_entry_t *step = tables[t];
+        size_t step_n = counts[t];
+
+        if (step_n > 0 && !step) {
+            return (CFGPACK_ERR_ARGS);
+        }
+        for (size_t i = 1; i < step_n; ++i) {
+            if (remap_apply(step, i, step[i].old_index) !=
+                step[i].old_index) {
+                return (CFGPACK_ERR_DUPLICATE); /* old_index listed twice */
+            }
+        }
+
+        /* Keys already remapped by earlier steps continue through this one */
+        for (size_t i = 0; i < n; ++i) {
+            out[i].new_index = remap_apply(step, step_n, out[i].new_index);
+        }
+
+        /* Keys that reached this step unchanged pick up its own entries */
+        for (size_t i = 0; i < step_n; ++i) {
+            size_t pos = remap_lower_bound(out, n, step[i].old_index);
+            if (pos < n && out[pos].old_index == step[i].old_index) {
+                continue;
+            }
+            if (n >= out_cap) {
+                return (CFGPACK_ERR_BOUNDS);
+            }
+            memmove(&out[pos + 1], &out[pos], (n - pos) * sizeof(*out));
+            out[pos] = step[i];
+            n++;
+        }
+    }
+
+    /* Identity mappings are implicit; drop them */
+    for (size_t i = 0; i < n; ++i) {
+        if (out[i].old_index != out[i].new_index) {
+            out[kept++] = out[i];
+        }
+    }
+    *out_count = kept;
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Migration plans
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define TYPE_BIT(t) (1u << CFGPACK_TYPE_##t)
+
+/** Schema types each CFGPACK_MIGRATE_DEC_* decoder can produce. */
+static const uint16_t migrate_dec_types[] = {
+    TYPE_BIT(U8) | TYPE_BIT(U16) | TYPE_BIT(U32) | TYPE_BIT(U64),
+    TYPE_BIT(I8) | TYPE_BIT(I16) | TYPE_BIT(I32) | TYPE_BIT(I64),
+    TYPE_BIT(I8) | TYPE_BIT(I16) | TYPE_BIT(I32) | TYPE_BIT(I64),
+    TYPE_BIT(F32),
+    TYPE_BIT(F64),
+    TYPE_BIT(F64),
+    TYPE_BIT(STR) | TYPE_BIT(FSTR),
+};
+
+#undef TYPE_BIT
+
+#define MIGRATE_DEC_COUNT                                                      \
+    (sizeof(migrate_dec_types) / sizeof(migrate_dec_types[0]))
+
+/**
+ * @brief Pick the decoder that carries @p from values into @p to.
+ *
+ * Only value-preserving changes qualify: the same type, a wider integer of
+ * the same signedness, an unsigned integer into a strictly wider signed
+ * one, f32 into f64, and fstr into str, with a string limit that does not
+ * shrink.
+ *
+ * @return 1 with @p dec set, or 0 if the type change is not a widening.
+ */
+static int migrate_decoder(const cfgpack_entry_t *from,
+                           const cfgpack_entry_t *to,
+                           uint8_t *dec) {
+    cfgpack_type_t a = from->type;
+    cfgpack_type_t b = to->type;
+    int a_uint = (a <= CFGPACK_TYPE_U64);
+    int b_uint = (b <= CFGPACK_TYPE_U64);
+    int a_int = (a >= CFGPACK_TYPE_I8 && a <= CFGPACK_TYPE_I64);
+    int b_int = (b >= CFGPACK_TYPE_I8 && b <= CFGPACK_TYPE_I64);
+
+    if (a_uint && b_uint) {
+        *dec = CFGPACK_MIGRATE_DEC_UINT;
+        return (b >= a);
+    }
+    if (a_uint && b_int) {
+        *dec = CFGPACK_MIGRATE_DEC_UINT_INT;
+        return (b - CFGPACK_TYPE_I8 > a - CFGPACK_TYPE_U8);
+    }
+    if (a_int && b_int) {
+        *dec = CFGPACK_MIGRATE_DEC_INT;
+        return (b >= a);
+    }
+    if (a == CFGPACK_TYPE_F32 && b == CFGPACK_TYPE_F32) {
+        *dec = CFGPACK_MIGRATE_DEC_F32;
+        return (1);
+    }
+    if (a == CFGPACK_TYPE_F32 && b == CFGPACK_TYPE_F64) {
+        *dec = CFGPACK_MIGRATE_DEC_F32_F64;
+        return (1);
+    }
+    if (a == CFGPACK_TYPE_F64 && b == CFGPACK_TYPE_F64) {
+        *dec = CFGPACK_MIGRATE_DEC_F64;
+        return (1);
+    }
+    if ((a == b || a == CFGPACK_TYPE_FSTR) && b >= CFGPACK_TYPE_STR) {
+        *dec = CFGPACK_MIGRATE_DEC_STR;
+        return (cfgpack_entry_str_max(to) >= cfgpack_entry_str_max(from));
+    }
+    return (0);
+}
+
+cfgpack_err_t cfgpack_migration_build(const cfgpack_schema_t *from,
+                                      const cfgpack_schema_t *to,
+                                      cfgpack_migrate_action_t *actions,
+                                      size_t cap,
+                                      cfgpack_migration_t *out,
+                                      size_t *failed) {
+    if (!from || !to || !out || (!actions && from->entry_count > 0)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (cap < from->entry_count) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    /* Old entries are sorted by index, so the actions are too */
+    for (size_t i = 0; i < from->entry_count; ++i) {
+        const cfgpack_entry_t *e = &from->entries[i];
+        cfgpack_migrate_action_t *a = &actions[i];
+        size_t j = 0;
+
+        while (j < to->entry_count &&
+               strncmp(to->entries[j].name, e->name, sizeof(e->name)) != 0) {
+            j++;
+        }
+        a->old_index = e->index;
+        a->new_pos = 0;
+        a->kind = CFGPACK_MIGRATE_DROP;
+        a->decode = 0;
+        if (j == to->entry_count) {
+            continue;
+        }
+        if (!migrate_decoder(e, &to->entries[j], &a->decode)) {
+            if (failed) {
+                *failed = i;
+            }
+            return (CFGPACK_ERR_TYPE_MISMATCH);
+        }
+        a->new_pos = (uint16_t)j;
+        if (to->entries[j].type != e->type) {
+            a->kind = CFGPACK_MIGRATE_WIDEN;
+        } else if (to->entries[j].index != e->index) {
+            a->kind = CFGPACK_MIGRATE_MOVE;
+        } else {
+            a->kind = CFGPACK_MIGRATE_KEEP;
+        }
+    }
+
+    out->from_fp = cfgpack_schema_fingerprint(from);
+    out->to_fp = cfgpack_schema_fingerprint(to);
+    out->actions = actions;
+    out->count = from->entry_count;
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Check that @p m was built for the context's schema and that every
+ *        action is well-formed, so the decode loop can trust them.
+ *
+ * @return CFGPACK_OK; CFGPACK_ERR_TYPE_MISMATCH if the plan targets another
+ *         schema; CFGPACK_ERR_ARGS if an action is malformed or the actions
+ *         are not strictly sorted by old_index.
+ */
+static cfgpack_err_t migration_check(const cfgpack_ctx_t *ctx,
+                                     const cfgpack_migration_t *m) {
+    const cfgpack_schema_t *schema = ctx->schema;
+
+    if (m->to_fp != cfgpack_schema_fingerprint(schema)) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    for (size_t i = 0; i < m->count; ++i) {
+        const cfgpack_migrate_action_t *a = &m->actions[i];
+
+        if (i > 0 && a->old_index <= m->actions[i - 1].old_index) {
+            return (CFGPACK_ERR_ARGS);
+        }
+        if (a->kind == CFGPACK_MIGRATE_DROP) {
+            continue;
+        }
+        if (a->kind > CFGPACK_MIGRATE_DROP || a->decode >= MIGRATE_DEC_COUNT ||
+            a->new_pos >= schema->entry_count ||
+            !(migrate_dec_types[a->decode] &
+              (1u << schema->entries[a->new_pos].type))) {
+            return (CFGPACK_ERR_ARGS);
+        }
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Decode one value with the decoder a migration action resolved.
+ *
+ * Only the two conversions decode_value() cannot do by itself are handled
+ * here: unsigned formats into a signed entry, and f32 into f64.
+ */
+static cfgpack_err_t migrate_decode(cfgpack_reader_t *r,
+                                    cfgpack_ctx_t *ctx,
+                                    size_t pos,
+                                    uint8_t dec,
+                                    cfgpack_value_t *out) {
+    cfgpack_type_t type = ctx->schema->entries[pos].type;
+    uint64_t u;
+    uint8_t b;
+    float f;
+
+    switch (dec) {
+    case CFGPACK_MIGRATE_DEC_INT:
+    case CFGPACK_MIGRATE_DEC_UINT_INT:
+        /* Non-negative signed values are written in uint formats */
+        if (dec == CFGPACK_MIGRATE_DEC_INT &&
+            (cfgpack_reader_peek(r, &b) != CFGPACK_OK ||
+             cfgpack_mp_fmt[b].kind != MP_KIND_UINT)) {
+            break;
+        }
+        if (cfgpack_msgpack_decode_uint64(r, &u) != CFGPACK_OK ||
+            u > (uint64_t)INT64_MAX) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        out->type = type;
+        out->v.i64 = (int64_t)u;
+        return (CFGPACK_OK);
+    case CFGPACK_MIGRATE_DEC_F32_F64:
+        if (cfgpack_msgpack_decode_f32(r, &f) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        out->type = type;
+        out->v.f64 = (double)f;
+        return (CFGPACK_OK);
+    default: break;
+    }
+    return (decode_value(r, ctx, pos, type, out));
+}
+
+/**
+ * @brief Decode a CRC-verified map written with the plan's old schema.
+ *
+ * The pagein_apply() of a migration: keys are joined against the sorted
+ * actions with a cursor, so a blob in entry order is decoded in one pass
+ * with no entry lookup, remap search or coercion check.  Keys that went
+ * backwards restart the cursor.  Keys without an action (the schema name,
+ * the header, dropped and unknown entries) are skipped.
+ */
+static cfgpack_err_t pagein_apply_migration(cfgpack_ctx_t *ctx,
+                                            cfgpack_reader_t *r,
+                                            const cfgpack_migration_t *m) {
+    const cfgpack_migrate_action_t *actions = m->actions;
+    uint32_t map_count = 0;
+    uint64_t prev = 0;
+    size_t cur = 0;
+
+    if (cfgpack_msgpack_decode_map_header(r, &map_count) != CFGPACK_OK) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    pagein_reset(ctx);
+
+    for (uint32_t i = 0; i < map_count; ++i) {
+        const cfgpack_migrate_action_t *a;
+        cfgpack_value_t val;
+        cfgpack_err_t err;
+        uint64_t key;
+
+        if (cfgpack_msgpack_decode_uint64(r, &key) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (key < prev) {
+            cur = 0; /* keys went backwards: rescan from the start */
+        }
+        prev = key;
+        while (cur < m->count && actions[cur].old_index < key) {
+            cur++;
+        }
+        if (cur == m->count || actions[cur].old_index != key ||
+            actions[cur].kind == CFGPACK_MIGRATE_DROP) {
+            if (cfgpack_msgpack_skip_value(r) != CFGPACK_OK) {
+                return (CFGPACK_ERR_DECODE);
+            }
+            if (key != CFGPACK_INDEX_RESERVED_NAME &&
+                key != CFGPACK_INDEX_HEADER) {
+                CFGPACK_STAT_ADD(ctx, skipped, 1);
+            }
+            continue;
+        }
+
+        a = &actions[cur];
+        err = migrate_decode(r, ctx, a->new_pos, a->decode, &val);
+        if (err != CFGPACK_OK) {
+            return (err);
+        }
+        if (a->kind == CFGPACK_MIGRATE_WIDEN) {
+            CFGPACK_STAT_ADD(ctx, coerced, 1);
+        }
+        CFGPACK_STAT_ADD(ctx, decoded, 1);
+        cfgpack_value_commit(ctx, a->new_pos, &val);
+        cfgpack_dirty_clear(ctx, a->new_pos);
+    }
+    return (pagein_restore_defaults(ctx, NULL));
+}
+
+cfgpack_err_t cfgpack_pagein_migrate(cfgpack_ctx_t *ctx,
+                                     const uint8_t *data,
+                                     size_t len,
+                                     const cfgpack_migration_t *m) {
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+    uint64_t fp;
+
+    if (!ctx || !m || (m->count > 0 && !m->actions)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = migration_check(ctx, m);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    /* A blob that names its layout must be the plan's old schema; one
+     * already in the new layout (packed blobs included) needs no plan */
+    rc = cfgpack_peek_header(data, len, &fp, NULL);
+    if (rc == CFGPACK_OK && fp == m->to_fp) {
+        return (cfgpack_pagein_buf(ctx, data, len));
+    }
+    if (rc == CFGPACK_OK && fp != m->from_fp) {
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    rc = verify_blob(data, len, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    cfgpack_reader_init(&r, data, len);
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_seq_write_begin(ctx);
+    rc = pagein_apply_migration(ctx, &r, m);
+    cfgpack_seq_write_end(ctx);
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_notify_dispatch(ctx);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pagein_buf(cfgpack_ctx_t *ctx,
+                                 const uint8_t *data,
+                                 size_t len) {
+    return (cfgpack_pagein_remap(ctx, data, len, NULL, 0));
+}
+
+cfgpack_err_t cfgpack_pagein_delta(cfgpack_ctx_t *ctx,
+                                   const uint8_t *data,
+                                   size_t len) {
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+
+    if (!ctx) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = verify_blob(data, len, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    cfgpack_reader_init(&r, data, len);
+    return (pagein_decode(ctx, &r, NULL, 0, PAGEIN_MERGE, NULL));
+}
+
+cfgpack_err_t cfgpack_select_ranges(const cfgpack_ctx_t *ctx,
+                                    const cfgpack_index_range_t *ranges,
+                                    size_t n,
+                                    uint8_t *select,
+                                    size_t select_len) {
+    const cfgpack_schema_t *schema;
+
+    if (!ctx || !select || (n && !ranges)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    schema = ctx->schema;
+    if (select_len < (schema->entry_count + CHAR_BIT - 1) / CHAR_BIT) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    memset(select, 0, select_len);
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        uint16_t index = schema->entries[i].index;
+
+        for (size_t k = 0; k < n; ++k) {
+            if (index >= ranges[k].first && index <= ranges[k].last) {
+                select[i / CHAR_BIT] |= (uint8_t)(1u << (i % CHAR_BIT));
+                break;
+            }
+        }
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_pagein_filtered(cfgpack_ctx_t *ctx,
+                                      const uint8_t *data,
+                                      size_t len,
+                                      const uint8_t *select) {
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+
+    if (!ctx || !select) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = verify_blob(data, len, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    cfgpack_reader_init(&r, data, len);
+    return (pagein_decode(ctx, &r, NULL, 0, PAGEIN_FULL, select));
+}
+
+/**
+ * @brief Record @p layer as the origin of entries that became present.
+ */
+static void layers_mark(const cfgpack_ctx_t *ctx,
+                        uint8_t *origin,
+                        uint8_t layer) {
+    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
+        if (origin[i] == CFGPACK_LAYER_NONE && cfgpack_presence_get(ctx, i)) {
+            origin[i] = layer;
+        }
+    }
+}
+
+/**
+ * @brief Apply the verified layers top-down, then the schema defaults.
+ * @param body_len Length of each layer without its CRC trailer.
+ */
+static cfgpack_err_t layers_apply(cfgpack_ctx_t *ctx,
+                                  const cfgpack_layer_t *layers,
+                                  const size_t *body_len,
+                                  size_t n,
+                                  uint8_t *origin) {
+    cfgpack_err_t rc;
+
+    pagein_reset(ctx);
+    for (size_t k = n; k-- > 0;) {
+        cfgpack_reader_t r;
+
+        cfgpack_reader_init(&r, layers[k].data, body_len[k]);
+        rc = pagein_apply(ctx, &r, layers[k].remap, layers[k].remap_count,
+                          PAGEIN_FILL, NULL);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        if (origin) {
+            layers_mark(ctx, origin, (uint8_t)k);
+        }
+    }
+    rc = pagein_restore_defaults(ctx, NULL);
+    if (rc == CFGPACK_OK && origin) {
+        layers_mark(ctx, origin, CFGPACK_LAYER_DEFAULT);
+    }
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pagein_layers(cfgpack_ctx_t *ctx,
+                                    const cfgpack_layer_t *layers,
+                                    size_t n,
+                                    uint8_t *origin) {
+    size_t body_len[CFGPACK_LAYERS_MAX];
+    cfgpack_err_t rc;
+
+    if (!ctx || (n && !layers) || n > CFGPACK_LAYERS_MAX) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    /* Every trailer first, so a bad layer leaves the context alone */
+    for (size_t k = 0; k < n; ++k) {
+        rc = verify_blob(layers[k].data, layers[k].len, &body_len[k]);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+    if (origin) {
+        memset(origin, CFGPACK_LAYER_NONE, ctx->schema->entry_count);
+    }
+
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_seq_write_begin(ctx);
+    rc = layers_apply(ctx, layers, body_len, n, origin);
+    cfgpack_seq_write_end(ctx);
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_notify_dispatch(ctx);
+    return (rc);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Resumable pagein/pageout (cfgpack_pagein_step / cfgpack_pageout_step)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define STEP_CHECK  0 /**< Checking the trailer */
+#define STEP_DECODE 1 /**< Decoding keys; the write section is open */
+#define STEP_DONE   2 /**< Finished, failed or aborted */
+
+#define STEP_HEAD    0 /**< Nothing encoded yet */
+#define STEP_ENTRIES 1 /**< Encoding entries */
+
+cfgpack_err_t cfgpack_pagein_step_begin(cfgpack_pagein_step_t *s,
+                                        const uint8_t *data,
+                                        size_t len,
+                                        const cfgpack_remap_entry_t *remap,
+                                        size_t remap_count) {
+    if (!s || !data) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    memset(s, 0, sizeof(*s));
+    s->phase = STEP_DONE;
+    if (len < CFGPACK_CRC_SIZE) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    cfgpack_reader_init(&s->r, data, len - CFGPACK_CRC_SIZE);
+    s->remap = remap;
+    s->remap_count = remap_count;
+    s->merge = PAGEIN_FULL;
+    s->crc = cfgpack_crc32c_init();
+    s->phase = STEP_CHECK;
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief End a decoding run as pagein_decode() does.
+ */
+static cfgpack_err_t pagein_step_end(cfgpack_ctx_t *ctx,
+                                     cfgpack_pagein_step_t *s,
+                                     cfgpack_err_t rc) {
+    s->phase = STEP_DONE;
+    cfgpack_seq_write_end(ctx);
+    cfgpack_notify_dispatch(ctx);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pagein_step(cfgpack_ctx_t *ctx,
+                                  cfgpack_pagein_step_t *s,
+                                  size_t budget) {
+    cfgpack_reader_t *r;
+    cfgpack_err_t rc;
+#ifdef CFGPACK_PACKED_WIRE
+    uint8_t b;
+#endif
+
+    if (!ctx || !s || budget == 0 || s->phase == STEP_DONE) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    r = &s->r;
+
+    if (s->phase == STEP_CHECK) {
+        size_t n = r->len - s->checked;
+        const uint8_t *t = r->data + r->len;
+        uint32_t stored;
+
+        if (n / CFGPACK_STEP_CRC_BYTES > budget) {
+            n = budget * CFGPACK_STEP_CRC_BYTES;
+        }
+        s->crc = cfgpack_crc32c_update(s->crc, r->data + s->checked, n);
+        s->checked += n;
+        if (s->checked < r->len) {
+            return (CFGPACK_IN_PROGRESS);
+        }
+        stored = (uint32_t)t[0] | ((uint32_t)t[1] << 8) |
+                 ((uint32_t)t[2] << 16) | ((uint32_t)t[3] << 24);
+        if (cfgpack_crc32c_final(s->crc) != stored) {
+            s->phase = STEP_DONE;
+            return (CFGPACK_ERR_CRC);
+        }
+
+        /* Verified: open the map in the next step */
+        s->phase = STEP_DECODE;
+        cfgpack_seq_write_begin(ctx);
+#ifdef CFGPACK_PACKED_WIRE
+        if (cfgpack_reader_peek(r, &b) == CFGPACK_OK &&
+            cfgpack_mp_fmt[b].kind == MP_KIND_ARRAY) {
+            return (pagein_step_end(ctx, s, pagein_apply_packed(ctx, r)));
+        }
+#endif
+        rc = pagein_open(ctx, s, r);
+        if (rc != CFGPACK_OK) {
+            return (pagein_step_end(ctx, s, rc));
+        }
+        return (CFGPACK_IN_PROGRESS);
+    }
+
+    while (budget-- > 0 && s->keys > 0) {
+        rc = pagein_key(ctx, s, r);
+        if (rc != CFGPACK_OK) {
+            return (pagein_step_end(ctx, s, rc));
+        }
+    }
+    if (s->keys > 0) {
+        return (CFGPACK_IN_PROGRESS);
+    }
+    return (pagein_step_end(ctx, s, pagein_close(ctx, s)));
+}
+
+void cfgpack_pagein_step_abort(cfgpack_ctx_t *ctx, cfgpack_pagein_step_t *s) {
+    if (!ctx || !s) {
+        return;
+    }
+    if (s->phase == STEP_DECODE) {
+        pagein_step_end(ctx, s, CFGPACK_OK);
+    }
+    s->phase = STEP_DONE;
+}
+
+cfgpack_err_t cfgpack_pageout_step_begin(cfgpack_pageout_step_t *s,
+                                         uint8_t *out,
+                                         size_t out_cap) {
+    if (!s || !out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    memset(s, 0, sizeof(*s));
+    cfgpack_buf_init(&s->buf, out, out_cap);
+    s->phase = STEP_HEAD;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_pageout_step(cfgpack_ctx_t *ctx,
+                                   cfgpack_pageout_step_t *s,
+                                   size_t budget,
+                                   size_t *out_len) {
+    uint8_t crc_bytes[CFGPACK_CRC_SIZE];
+    cfgpack_buf_t *buf;
+    uint32_t crc;
+    size_t i;
+
+    if (!ctx || !s || budget == 0 || s->phase == STEP_DONE) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    buf = &s->buf;
+
+    if (s->phase == STEP_HEAD) {
+        size_t count = cfgpack_bits_count(ctx->present, NULL,
+                                          ctx->schema->entry_count);
+
+        cfgpack_buf_crc_begin(buf);
+        encode_head(ctx, buf, count, 0, ctx->header);
+        cfgpack_present_iter_init(&s->it, ctx, 0);
+        s->set_count = ctx->set_count;
+        s->phase = STEP_ENTRIES;
+        return (CFGPACK_IN_PROGRESS);
+    }
+
+    if (ctx->set_count != s->set_count) {
+        s->phase = STEP_DONE;
+        return (CFGPACK_ERR_BUSY);
+    }
+    while (budget-- > 0) {
+        cfgpack_err_t rc;
+
+        if (!cfgpack_present_next(&s->it, &i)) {
+            break;
+        }
+        rc = cfgpack_lazy_load(ctx, i);
+        if (rc == CFGPACK_OK) {
+            rc = pageout_entry(ctx, buf, 0, i, NULL);
+        }
+        if (rc != CFGPACK_OK) {
+            s->phase = STEP_DONE;
+            return (rc);
+        }
+        if (budget == 0) {
+            return (CFGPACK_IN_PROGRESS);
+        }
+    }
+
+    s->phase = STEP_DONE;
+    crc = cfgpack_buf_crc(buf);
+    crc_bytes[0] = (uint8_t)(crc);
+    crc_bytes[1] = (uint8_t)(crc >> 8);
+    crc_bytes[2] = (uint8_t)(crc >> 16);
+    crc_bytes[3] = (uint8_t)(crc >> 24);
+    cfgpack_buf_append(buf, crc_bytes, CFGPACK_CRC_SIZE);
+    if (out_len) {
+        *out_len = buf->len;
+    }
+    if (buf->len > buf->cap) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    cfgpack_dirty_clear_all(ctx);
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Blob diff and patch
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Key of a walk past its last entry (above every index key). */
+#define WALK_END 0xffffffffu
+
+/** Cursor over the value entries of a CRC-verified blob or patch. */
+typedef struct {
+    cfgpack_reader_t r;
+    uint32_t left;   /**< Map entries not read yet. */
+    uint32_t key;    /**< Current index key, or WALK_END. */
+    size_t val;      /**< Offset of the current value. */
+    size_t val_len;  /**< Encoded length of the current value. */
+    size_t name;     /**< Offset of the encoded schema name. */
+    size_t name_len; /**< Encoded length of the schema name. */
+} blob_walk_t;
+
+/**
+ * @brief Advance to the next value entry.
+ *
+ * Keys outside the 16-bit index range (the offset-index footer) are
+ * skipped.  Index keys must ascend, as cfgpack_pageout() writes them.
+ */
+static cfgpack_err_t walk_next(blob_walk_t *w) {
+    uint32_t prev = w->key;
+
+    for (;;) {
+        uint64_t key;
+
+        if (w->left == 0) {
+            w->key = WALK_END;
+            return (CFGPACK_OK);
+        }
+        w->left--;
+        if (cfgpack_msgpack_decode_uint64(&w->r, &key) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        w->val = w->r.pos;
+        if (cfgpack_msgpack_skip_value(&w->r) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        w->val_len = w->r.pos - w->val;
+        if (key > UINT16_MAX) {
+            continue;
+        }
+        if (key == CFGPACK_INDEX_RESERVED_NAME || key <= prev) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        w->key = (uint32_t)key;
+        return (CFGPACK_OK);
+    }
+}
+
+/**
+ * @brief Verify a blob and position a walk on its first value entry.
+ *
+ * The schema name must be the first key, as cfgpack_pageout() writes it.
+ */
+static cfgpack_err_t walk_open(blob_walk_t *w,
+                               const uint8_t *data,
+                               size_t len) {
+    uint64_t key;
+    cfgpack_err_t rc;
+
+    rc = verify_blob(data, len, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    cfgpack_reader_init(&w->r, data, len);
+    if (cfgpack_msgpack_decode_map_header(&w->r, &w->left) != CFGPACK_OK ||
+        w->left == 0 ||
+        cfgpack_msgpack_decode_uint64(&w->r, &key) != CFGPACK_OK ||
+        key != CFGPACK_INDEX_RESERVED_NAME) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    w->left--;
+    w->name = w->r.pos;
+    if (cfgpack_msgpack_skip_value(&w->r) != CFGPACK_OK ||
+        cfgpack_mp_fmt[data[w->name]].type != CFGPACK_TYPE_STR) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    w->name_len = w->r.pos - w->name;
+    w->key = 0;
+    return (walk_next(w));
+}
+
+/**
+ * @brief CRC-32C that cfgpack_pageout() writes for the @p count entries
+ *        of @p w (a blob with a footer has the footer left out).
+ */
+static uint32_t walk_crc(blob_walk_t w, size_t count) {
+    cfgpack_buf_t buf;
+
+    cfgpack_buf_init(&buf, NULL, 0);
+    cfgpack_buf_crc_begin(&buf);
+    cfgpack_msgpack_encode_map_header(&buf, (uint32_t)(count + 1));
+    cfgpack_msgpack_encode_uint_key(&buf, CFGPACK_INDEX_RESERVED_NAME);
+    cfgpack_buf_append(&buf, w.r.data + w.name, w.name_len);
+    while (w.key != WALK_END) {
+        cfgpack_msgpack_encode_uint_key(&buf, w.key);
+        cfgpack_buf_append(&buf, w.r.data + w.val, w.val_len);
+        if (walk_next(&w) != CFGPACK_OK) {
+            break; /* not reached: diff_pass() walked it already */
+        }
+    }
+    return (cfgpack_buf_crc(&buf));
+}
+
+/** Entry counts of one diff_pass(). */
+typedef struct {
+    size_t base_n;   /**< Value entries in the base. */
+    size_t target_n; /**< Value entries in the target. */
+    size_t set_n;    /**< Indices changed or added by the target. */
+    size_t del_n;    /**< Indices removed by the target. */
+} diff_count_t;
+
+/**
+ * @brief Merge-walk base and target once, counting into @p c.
+ *
+ * With @p dels set, appends each removed index as a big-endian u16; with
+ * @p sets set, appends each changed or added entry: its key and the raw
+ * target value bytes.
+ */
+static cfgpack_err_t diff_pass(blob_walk_t b,
+                               blob_walk_t t,
+                               diff_count_t *c,
+                               cfgpack_buf_t *dels,
+                               cfgpack_buf_t *sets) {
+    memset(c, 0, sizeof(*c));
+    while (b.key != WALK_END || t.key != WALK_END) {
+        cfgpack_err_t rc;
+
+        if (b.key < t.key) {
+            uint8_t be[2];
+
+            be[0] = (uint8_t)(b.key >> 8);
+            be[1] = (uint8_t)b.key;
+            if (dels) {
+                cfgpack_buf_append(dels, be, sizeof(be));
+            }
+            c->base_n++;
+            c->del_n++;
+            rc = walk_next(&b);
+        } else {
+            int same = b.key == t.key && b.val_len == t.val_len &&
+                       memcmp(b.r.data + b.val, t.r.data + t.val,
+                              t.val_len) == 0;
+
+            if (!same) {
+                if (sets) {
+                    cfgpack_msgpack_encode_uint_key(sets, t.key);
+                    cfgpack_buf_append(sets, t.r.data + t.val, t.val_len);
+                }
+                c->set_n++;
+            }
+            if (b.key == t.key) {
+                c->base_n++;
+                rc = walk_next(&b);
+                if (rc != CFGPACK_OK) {
+                    return (rc);
+                }
+            }
+            c->target_n++;
+            rc = walk_next(&t);
+        }
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_blob_diff(const uint8_t *base,
+                                size_t base_len,
+                                const uint8_t *target,
+                                size_t target_len,
+                                uint8_t *out,
+                                size_t out_cap,
+                                size_t *out_len) {
+    uint8_t crc_bytes[CFGPACK_CRC_SIZE];
+    uint8_t hdr[5];
+    cfgpack_buf_t buf;
+    diff_count_t c;
+    blob_walk_t b;
+    blob_walk_t t;
+    cfgpack_err_t rc;
+    uint32_t crc;
+
+    if (!base || !target || !out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = walk_open(&b, base, base_len);
+    if (rc == CFGPACK_OK) {
+        rc = walk_open(&t, target, target_len);
+    }
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (b.name_len != t.name_len ||
+        memcmp(base + b.name, target + t.name, t.name_len) != 0) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = diff_pass(b, t, &c, NULL, NULL);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    cfgpack_buf_init(&buf, out, out_cap);
+    cfgpack_buf_crc_begin(&buf);
+    cfgpack_msgpack_encode_map_header(
+        &buf, (uint32_t)(3 + (c.del_n > 0) + c.set_n));
+    cfgpack_msgpack_encode_uint_key(&buf, CFGPACK_INDEX_RESERVED_NAME);
+    cfgpack_buf_append(&buf, target + t.name, t.name_len);
+    cfgpack_msgpack_encode_uint_key(&buf, CFGPACK_INDEX_PATCH_BASE);
+    cfgpack_msgpack_encode_uint64(&buf, walk_crc(b, c.base_n));
+    cfgpack_msgpack_encode_uint_key(&buf, CFGPACK_INDEX_PATCH_RESULT);
+    cfgpack_msgpack_encode_uint64(&buf, walk_crc(t, c.target_n));
+    if (c.del_n > 0) {
+        cfgpack_msgpack_encode_uint_key(&buf, CFGPACK_INDEX_PATCH_DEL);
+        cfgpack_buf_append(&buf, hdr, footer_bin_hdr(c.del_n * 2, hdr));
+        diff_pass(b, t, &c, &buf, NULL);
+    }
+    diff_pass(b, t, &c, NULL, &buf);
+
+    crc = cfgpack_buf_crc(&buf);
+    crc_bytes[0] = (uint8_t)(crc);
+    crc_bytes[1] = (uint8_t)(crc >> 8);
+    crc_bytes[2] = (uint8_t)(crc >> 16);
+    crc_bytes[3] = (uint8_t)(crc >> 24);
+    cfgpack_buf_append(&buf, crc_bytes, CFGPACK_CRC_SIZE);
+
+    if (out_len) {
+        *out_len = buf.len;
+    }
+    return (buf.len > out_cap ? CFGPACK_ERR_ENCODE : CFGPACK_OK);
+}
+
+/** A CRC-verified patch from cfgpack_blob_diff(). */
+typedef struct {
+    uint32_t base_crc;   /**< CRC-32C of the blob the patch applies to. */
+    uint32_t result_crc; /**< CRC-32C of the blob it produces. */
+    const uint8_t *dels; /**< Removed indices, big-endian u16 each. */
+    size_t del_n;        /**< Removed index count. */
+    blob_walk_t sets;    /**< Walk positioned on the first set entry. */
+} patch_t;
+
+static uint16_t patch_del(const patch_t *p, size_t i) {
+    return ((uint16_t)((p->dels[2 * i] << 8) | p->dels[2 * i + 1]));
+}
+
+/**
+ * @brief Verify a patch and read its header entries.
  *
- * @param wire_type   Type detected from msgpack wire format.
- * @param schema_type Type declared in schema.
- * @return 1 if coercion is allowed (or exact match), 0 otherwise.
+ * The header keys come in a fixed order after the schema name: base CRC,
+ * result CRC and, if anything was removed, the removed-index list.
  */
-static int can_coerce_type(cfgpack_type_t wire_type,
-                           cfgpack_type_t schema_type) {
-    if ((unsigned)wire_type >= 12 || (unsigned)schema_type >= 12) {
-        return (0);
+static cfgpack_err_t patch_open(patch_t *p, const uint8_t *data, size_t len) {
+    blob_walk_t *w = &p->sets;
+    uint64_t key;
+    uint64_t crc;
+    cfgpack_err_t rc;
+
+    rc = verify_blob(data, len, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
     }
-    return (coerce_table[wire_type][schema_type]);
+    memset(p, 0, sizeof(*p));
+    cfgpack_reader_init(&w->r, data, len);
+    if (cfgpack_msgpack_decode_map_header(&w->r, &w->left) != CFGPACK_OK ||
+        w->left < 3 ||
+        cfgpack_msgpack_decode_uint64(&w->r, &key) != CFGPACK_OK ||
+        key != CFGPACK_INDEX_RESERVED_NAME ||
+        cfgpack_msgpack_skip_value(&w->r) != CFGPACK_OK ||
+        cfgpack_msgpack_decode_uint64(&w->r, &key) != CFGPACK_OK ||
+        key != CFGPACK_INDEX_PATCH_BASE ||
+        cfgpack_msgpack_decode_uint64(&w->r, &crc) != CFGPACK_OK ||
+        crc > UINT32_MAX) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    p->base_crc = (uint32_t)crc;
+    if (cfgpack_msgpack_decode_uint64(&w->r, &key) != CFGPACK_OK ||
+        key != CFGPACK_INDEX_PATCH_RESULT ||
+        cfgpack_msgpack_decode_uint64(&w->r, &crc) != CFGPACK_OK ||
+        crc > UINT32_MAX) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    p->result_crc = (uint32_t)crc;
+    w->left -= 3;
+
+    /* The removed-index list is a bin, so its header byte is 0xc4..0xc6
+     * and 1, 2 or 4 length bytes follow it */
+    if (w->left > 0) {
+        size_t at = w->r.pos;
+
+        if (cfgpack_msgpack_decode_uint64(&w->r, &key) != CFGPACK_OK) {
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (key == CFGPACK_INDEX_PATCH_DEL) {
+            size_t hdr;
+
+            at = w->r.pos;
+            if (cfgpack_msgpack_skip_value(&w->r) != CFGPACK_OK ||
+                data[at] < 0xc4 || data[at] > 0xc6) {
+                return (CFGPACK_ERR_DECODE);
+            }
+            hdr = data[at] == 0xc4 ? 2 : data[at] == 0xc5 ? 3 : 5;
+            if ((w->r.pos - at - hdr) % 2 != 0) {
+                return (CFGPACK_ERR_DECODE);
+            }
+            p->dels = data + at + hdr;
+            p->del_n = (w->r.pos - at - hdr) / 2;
+            w->left--;
+        } else {
+            w->r.pos = at;
+        }
+    }
+    for (size_t i = 1; i < p->del_n; ++i) {
+        if (patch_del(p, i) <= patch_del(p, i - 1)) {
+            return (CFGPACK_ERR_DECODE);
+        }
+    }
+    w->key = 0;
+    return (walk_next(w));
 }
 
 /**
- * @brief Detect the type of the next msgpack value and decode it.
+ * @brief Encode the entries the context holds once @p p is applied.
  *
- * Peeks at the format byte to determine the wire type, then decodes
- * the value accordingly. Supports type coercion during decode.
+ * Merges the present entries with the set and removed indices of the
+ * patch, all in ascending index order, and appends each resulting entry
+ * as cfgpack_pageout() would; a set entry is appended as its patch bytes.
+ * Set indices the schema does not have are left out.
  *
- * @param r           Reader state.
- * @param ctx         Context (for string pool access).
- * @param entry_off   Entry offset in schema.
- * @param schema_type Expected schema type (for coercion check).
- * @param out         Output value structure.
- * @return CFGPACK_OK on success, CFGPACK_ERR_TYPE_MISMATCH if incompatible,
- *         CFGPACK_ERR_DECODE on parse error.
+ * @param count Receives the number of resulting entries.
  */
-static cfgpack_err_t decode_value_with_coercion(cfgpack_reader_t *r,
-                                                cfgpack_ctx_t *ctx,
-                                                size_t entry_off,
-                                                cfgpack_type_t schema_type,
-                                                cfgpack_value_t *out) {
-    cfgpack_type_t wire_type;
-    int wire_is_unsigned;
-    int schema_is_signed;
-    uint8_t b;
+static cfgpack_err_t patch_merge(const cfgpack_ctx_t *ctx,
+                                 const patch_t *p,
+                                 cfgpack_buf_t *buf,
+                                 size_t *count) {
+    blob_walk_t s = p->sets;
+    size_t d = 0;
 
-    if (r->pos >= r->len) {
-        return (CFGPACK_ERR_DECODE);
-    }
+    *count = 0;
+    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
+        const cfgpack_entry_t *e = &ctx->schema->entries[i];
+        cfgpack_err_t rc;
 
-    b = r->data[r->pos];
+        while (s.key < e->index) {
+            rc = walk_next(&s);
+            if (rc != CFGPACK_OK) {
+                return (rc);
+            }
+        }
+        while (d < p->del_n && patch_del(p, d) < e->index) {
+            d++;
+        }
 
-    /* Detect wire type from format byte (don't consume yet) */
-    if (b <= 0x7f) {
-        /* Positive fixint: treat as smallest unsigned that fits */
-        wire_type = CFGPACK_TYPE_U8;
-    } else if (b >= 0xe0) {
-        /* Negative fixint: treat as smallest signed that fits */
-        wire_type = CFGPACK_TYPE_I8;
-    } else if (b == 0xcc) {
-        wire_type = CFGPACK_TYPE_U8;
-    } else if (b == 0xcd) {
-        wire_type = CFGPACK_TYPE_U16;
-    } else if (b == 0xce) {
-        wire_type = CFGPACK_TYPE_U32;
-    } else if (b == 0xcf) {
-        wire_type = CFGPACK_TYPE_U64;
-    } else if (b == 0xd0) {
-        wire_type = CFGPACK_TYPE_I8;
-    } else if (b == 0xd1) {
-        wire_type = CFGPACK_TYPE_I16;
-    } else if (b == 0xd2) {
-        wire_type = CFGPACK_TYPE_I32;
-    } else if (b == 0xd3) {
-        wire_type = CFGPACK_TYPE_I64;
-    } else if (b == 0xca) {
-        wire_type = CFGPACK_TYPE_F32;
-    } else if (b == 0xcb) {
-        wire_type = CFGPACK_TYPE_F64;
-    } else if ((b & 0xe0) == 0xa0 || b == 0xd9 || b == 0xda) {
-        /* String: peek at length to decide fstr vs str */
-        /* For simplicity, we'll detect based on what we're coercing to */
-        if (schema_type == CFGPACK_TYPE_FSTR ||
-            schema_type == CFGPACK_TYPE_STR) {
-            wire_type = schema_type; /* Match schema expectation for strings */
+        if (s.key == e->index) {
+            cfgpack_msgpack_encode_uint_key(buf, e->index);
+            cfgpack_buf_append(buf, s.r.data + s.val, s.val_len);
+            rc = walk_next(&s);
+            if (rc != CFGPACK_OK) {
+                return (rc);
+            }
+        } else if (d < p->del_n && patch_del(p, d) == e->index) {
+            continue;
+        } else if (cfgpack_presence_get(ctx, i)) {
+            cfgpack_value_t v;
+
+            cfgpack_msgpack_encode_uint_key(buf, e->index);
+            cfgpack_value_load(ctx, i, &v);
+            rc = encode_value(buf, ctx, e, &v);
+            if (rc != CFGPACK_OK && rc != CFGPACK_ERR_ENCODE) {
+                return (rc);
+            }
         } else {
-            return (CFGPACK_ERR_TYPE_MISMATCH);
+            continue;
         }
-    } else {
-        return (CFGPACK_ERR_TYPE_MISMATCH);
+        (*count)++;
     }
-
-    /* Check if coercion is allowed */
-    if (!can_coerce_type(wire_type, schema_type)) {
-        return (CFGPACK_ERR_TYPE_MISMATCH);
+    while (s.key != WALK_END) {
+        cfgpack_err_t rc = walk_next(&s);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
     }
+    return (CFGPACK_OK);
+}
 
-    /* If wire type matches schema type (or same decode family), decode directly */
-    if (wire_type == schema_type) {
-        return (decode_value(r, ctx, entry_off, schema_type, out));
-    }
+/**
+ * @brief CRC-32C of the blob cfgpack_pageout() would write without the
+ *        schema header once @p p is applied, or of the current state if
+ *        @p p is NULL.
+ */
+static cfgpack_err_t state_crc(const cfgpack_ctx_t *ctx,
+                               const patch_t *p,
+                               uint32_t *crc) {
+    cfgpack_buf_t buf;
+    cfgpack_err_t rc;
+    size_t count;
 
-    /*
-     * Cross-type coercion: decode using the wire type first, then convert.
-     *
-     * Unsigned widening (u8->u16, etc.) and signed widening (i8->i16, etc.)
-     * work via decode_value directly because decode_uint64 handles all
-     * unsigned formats and decode_int64 handles all signed formats.
-     *
-     * The cases that need explicit conversion:
-     *   - unsigned wire -> signed schema (decode_int64 can't parse 0xcc-0xcf)
-     *   - f32 wire -> f64 schema (decode_f64 can't parse 0xca)
-     */
-    wire_is_unsigned = (wire_type == CFGPACK_TYPE_U8 ||
-                        wire_type == CFGPACK_TYPE_U16 ||
-                        wire_type == CFGPACK_TYPE_U32 ||
-                        wire_type == CFGPACK_TYPE_U64);
-    schema_is_signed = (schema_type == CFGPACK_TYPE_I8 ||
-                        schema_type == CFGPACK_TYPE_I16 ||
-                        schema_type == CFGPACK_TYPE_I32 ||
-                        schema_type == CFGPACK_TYPE_I64);
+    cfgpack_buf_init(&buf, NULL, 0);
+    cfgpack_buf_crc_begin(&buf);
+    if (!p) {
+        rc = pageout_impl(ctx, &buf, PAGEOUT_BARE, NULL);
+    } else {
+        cfgpack_buf_t head;
 
-    if (wire_is_unsigned && schema_is_signed) {
-        /* Decode as uint64, then convert to int64 */
-        cfgpack_value_t tmp;
-        cfgpack_err_t err = decode_value(r, ctx, entry_off, wire_type, &tmp);
-        if (err != CFGPACK_OK) {
-            return (err);
+        /* One pass for the map header count, one for the CRC */
+        cfgpack_buf_init(&head, NULL, 0);
+        rc = patch_merge(ctx, p, &head, &count);
+        if (rc != CFGPACK_OK) {
+            return (rc);
         }
-        /* Check that the unsigned value fits in int64_t */
-        if (tmp.v.u64 > (uint64_t)INT64_MAX) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        out->type = schema_type;
-        out->v.i64 = (int64_t)tmp.v.u64;
-        return (CFGPACK_OK);
+        encode_head(ctx, &buf, count, 0, 0);
+        rc = patch_merge(ctx, p, &buf, &count);
     }
+    *crc = cfgpack_buf_crc(&buf);
+    return (rc);
+}
 
-    if (wire_type == CFGPACK_TYPE_F32 && schema_type == CFGPACK_TYPE_F64) {
-        /* Decode as f32, then widen to f64 */
-        cfgpack_value_t tmp;
-        cfgpack_err_t err = decode_value(r, ctx, entry_off, CFGPACK_TYPE_F32,
-                                         &tmp);
-        if (err != CFGPACK_OK) {
-            return (err);
+/**
+ * @brief Remove, then set, the entries of a checked patch.
+ *
+ * Set entries are marked dirty; both kinds are marked for notification.
+ */
+static cfgpack_err_t patch_write(cfgpack_ctx_t *ctx, const patch_t *p) {
+    const cfgpack_entry_t *entries = ctx->schema->entries;
+    blob_walk_t s = p->sets;
+
+    for (size_t d = 0; d < p->del_n; ++d) {
+        const cfgpack_entry_t *e = cfgpack_find_entry(ctx, patch_del(p, d));
+        size_t off;
+
+        if (!e || !cfgpack_presence_get(ctx, (size_t)(e - entries))) {
+            continue;
         }
-        out->type = CFGPACK_TYPE_F64;
-        out->v.f64 = (double)tmp.v.f32;
-        return (CFGPACK_OK);
+        off = (size_t)(e - entries);
+        cfgpack_size_sub(ctx, off);
+        cfgpack_presence_clear(ctx, off);
+        cfgpack_notify_mark(ctx, off);
     }
 
-    /* All other allowed coercions (signed widening, unsigned widening,
-     * fstr->str) work via decode_value with the schema type directly */
-    return (decode_value(r, ctx, entry_off, schema_type, out));
+    while (s.key != WALK_END) {
+        const cfgpack_entry_t *e = cfgpack_find_entry(ctx, (uint16_t)s.key);
+        cfgpack_err_t rc;
+
+        if (e) {
+            size_t off = (size_t)(e - entries);
+            cfgpack_reader_t r;
+            cfgpack_value_t val;
+
+            cfgpack_reader_init(&r, s.r.data, s.r.len);
+            r.pos = s.val;
+            rc = decode_value_with_coercion(&r, ctx, off, e->type, &val);
+            if (rc != CFGPACK_OK) {
+                return (rc);
+            }
+            CFGPACK_STAT_ADD(ctx, decoded, 1);
+            cfgpack_value_commit(ctx, off, &val);
+            cfgpack_dirty_set(ctx, off);
+            cfgpack_notify_mark(ctx, off);
+        }
+        rc = walk_next(&s);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+    return (CFGPACK_OK);
 }
 
-cfgpack_err_t cfgpack_pagein_remap(cfgpack_ctx_t *ctx,
-                                   const uint8_t *data,
-                                   size_t len,
-                                   const cfgpack_remap_entry_t *remap,
-                                   size_t remap_count) {
-    uint32_t map_count = 0;
-    uint32_t stored_crc;
-    uint32_t actual_crc;
-    cfgpack_reader_t r;
+cfgpack_err_t cfgpack_patch_apply(cfgpack_ctx_t *ctx,
+                                  const uint8_t *patch,
+                                  size_t len) {
+    cfgpack_err_t rc;
+    uint32_t crc;
+    patch_t p;
 
     if (!ctx) {
         return (CFGPACK_ERR_ARGS);
     }
-    if (!data || len == 0) {
-        return (CFGPACK_ERR_DECODE);
+    rc = patch_open(&p, patch, len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    rc = lazy_flush(ctx);
+    if (rc != CFGPACK_OK) {
+        return (rc);
     }
 
-    if (len < CFGPACK_CRC_SIZE) {
-        return (CFGPACK_ERR_DECODE);
+    /* Both checks run before any entry changes: the context must hold the
+     * base, and the patched context must page out as the target */
+    rc = state_crc(ctx, NULL, &crc);
+    if (rc == CFGPACK_OK && crc != p.base_crc) {
+        rc = CFGPACK_ERR_CRC;
     }
-    stored_crc = (uint32_t)data[len - 4] | ((uint32_t)data[len - 3] << 8) |
-                 ((uint32_t)data[len - 2] << 16) |
-                 ((uint32_t)data[len - 1] << 24);
-    actual_crc = cfgpack_crc32c(data, len - CFGPACK_CRC_SIZE);
-    if (stored_crc != actual_crc) {
-        return (CFGPACK_ERR_CRC);
+    if (rc == CFGPACK_OK) {
+        rc = state_crc(ctx, &p, &crc);
     }
-    len -= CFGPACK_CRC_SIZE;
-
-    cfgpack_reader_init(&r, data, len);
-    if (cfgpack_msgpack_decode_map_header(&r, &map_count) != CFGPACK_OK) {
-        return (CFGPACK_ERR_DECODE);
+    if (rc == CFGPACK_OK && crc != p.result_crc) {
+        rc = CFGPACK_ERR_CRC;
+    }
+    if (rc != CFGPACK_OK) {
+        return (rc);
     }
 
-    memset(ctx->present, 0, sizeof(ctx->present));
-
-    for (uint32_t i = 0; i < map_count; ++i) {
-        const cfgpack_entry_t *entry;
-        uint16_t target_index;
-        cfgpack_err_t err;
-        uint64_t key;
-        size_t idx;
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_seq_write_begin(ctx);
+    rc = patch_write(ctx, &p);
+    cfgpack_seq_write_end(ctx);
+    CFGPACK_STAT_END(CFGPACK_STATS_PAGEIN, ctx);
+    cfgpack_notify_dispatch(ctx);
+    return (rc);
+}
 
-        if (cfgpack_msgpack_decode_uint64(&r, &key) != CFGPACK_OK) {
-            return (CFGPACK_ERR_DECODE);
-        }
+/**
+ * @brief Pass 1 of streaming pagein: checksum the whole stream.
+ *
+ * Reads the source front to back through @p win, holding back the last
+ * CRC_SIZE bytes seen so the trailer is excluded from the checksum.
+ *
+ * @param body_len    Receives the stream length minus the trailer.
+ * @param stored_crc  Receives the trailer value.
+ */
+static cfgpack_err_t stream_verify(cfgpack_source_fn src,
+                                   void *user,
+                                   uint8_t *win,
+                                   size_t win_cap,
+                                   size_t *body_len,
+                                   uint32_t *stored_crc) {
+    uint32_t crc = cfgpack_crc32c_init();
+    size_t total = 0;
+    size_t held = 0;
 
-        /* Skip reserved index 0 (schema name) */
-        if (key == CFGPACK_INDEX_RESERVED_NAME) {
-            if (cfgpack_msgpack_skip_value(&r) != CFGPACK_OK) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            continue;
-        }
+    for (;;) {
+        size_t got = 0;
+        cfgpack_err_t rc;
 
-        /* Apply remap if provided */
-        target_index = (uint16_t)key;
-        if (remap != NULL) {
-            for (size_t ri = 0; ri < remap_count; ++ri) {
-                if (remap[ri].old_index == (uint16_t)key) {
-                    target_index = remap[ri].new_index;
-                    break;
-                }
-            }
+        rc = src(user, total, win + held, win_cap - held, &got);
+        if (rc != CFGPACK_OK) {
+            return (rc);
         }
-
-        /* Find matching entry in schema */
-        entry = NULL;
-        idx = 0;
-        for (size_t j = 0; j < ctx->schema->entry_count; ++j) {
-            if (ctx->schema->entries[j].index == target_index) {
-                entry = &ctx->schema->entries[j];
-                idx = j;
-                break;
-            }
+        if (got == 0) {
+            break;
         }
-
-        /* Unknown key: silently skip */
-        if (!entry) {
-            if (cfgpack_msgpack_skip_value(&r) != CFGPACK_OK) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            continue;
+        if (got > win_cap - held) {
+            return (CFGPACK_ERR_IO);
         }
-
-        /* Decode value with type coercion support */
-        err = decode_value_with_coercion(&r, ctx, idx, entry->type,
-                                         &ctx->values[idx]);
-        if (err != CFGPACK_OK) {
-            return (err);
+        total += got;
+        held += got;
+        if (held > CFGPACK_CRC_SIZE) {
+            crc = cfgpack_crc32c_update(crc, win, held - CFGPACK_CRC_SIZE);
+            memmove(win, win + held - CFGPACK_CRC_SIZE, CFGPACK_CRC_SIZE);
+            held = CFGPACK_CRC_SIZE;
         }
-        cfgpack_presence_set(ctx, idx);
     }
 
-    /* Restore defaults for entries not covered by old data.
-     * After decoding, any entry with has_default that wasn't set by the
-     * incoming data should still be marked present so its schema default
-     * is accessible via cfgpack_get(). */
-    for (size_t i = 0; i < ctx->schema->entry_count; ++i) {
-        if (!cfgpack_presence_get(ctx, i) &&
-            ctx->schema->entries[i].has_default) {
-            cfgpack_presence_set(ctx, i);
-        }
+    if (total <= CFGPACK_CRC_SIZE) {
+        return (CFGPACK_ERR_DECODE);
     }
-
+    *stored_crc = (uint32_t)win[0] | ((uint32_t)win[1] << 8) |
+                  ((uint32_t)win[2] << 16) | ((uint32_t)win[3] << 24);
+    if (cfgpack_crc32c_final(crc) != *stored_crc) {
+        return (CFGPACK_ERR_CRC);
+    }
+    *body_len = total - CFGPACK_CRC_SIZE;
     return (CFGPACK_OK);
 }
 
-cfgpack_err_t cfgpack_pagein_buf(cfgpack_ctx_t *ctx,
-                                 const uint8_t *data,
-                                 size_t len) {
-    return (cfgpack_pagein_remap(ctx, data, len, NULL, 0));
+cfgpack_err_t cfgpack_pagein_stream(cfgpack_ctx_t *ctx,
+                                    cfgpack_source_fn src,
+                                    void *user,
+                                    uint8_t *window,
+                                    size_t window_cap) {
+    uint32_t stored_crc = 0;
+    size_t body_len = 0;
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+
+    if (!ctx || !src || !window) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (window_cap < CFGPACK_STREAM_WINDOW_MIN) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    /* Pass 1: nothing in ctx is touched until the trailer verifies */
+    rc = stream_verify(src, user, window, window_cap, &body_len, &stored_crc);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    /* Pass 2: decode through the refill window */
+    cfgpack_reader_init_source(&r, window, window_cap, src, user, body_len);
+    cfgpack_reader_crc_begin(&r);
+    rc = pagein_decode(ctx, &r, NULL, 0, PAGEIN_FULL, NULL);
+    if (r.src_err != CFGPACK_OK) {
+        return (r.src_err);
+    }
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    /* Re-check what pass 2 actually consumed, in case the source changed */
+    if (r.base + r.pos == body_len && cfgpack_reader_crc(&r) != stored_crc) {
+        return (CFGPACK_ERR_CRC);
+    }
+    return (CFGPACK_OK);
 }
@@ -0,0 +1,461 @@
+/**
+ * @file io_async.c
+ * @brief Worker pool behind cfgpack_async_pageout() (hosted only).
+ *
+ * Slots move FREE -> RESERVED (encoding on the caller) -> QUEUED ->
+ * WRITING (owned by a worker) -> FREE.  The lock covers slot states and
+ * counters only; encoding and file I/O run without it.  A path that is
+ * being written is not taken again until that write is done, so two
+ * renames of one file never race.
+ */
+
+#ifndef _POSIX_C_SOURCE
+  #define _POSIX_C_SOURCE 200809L /* fsync/clock_gettime under -std=c99 */
+#endif
+
+#include "cfgpack/io_async.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h> /* rename */
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Linger waits on CLOCK_MONOTONIC where the condition variable can be bound
+ * to it, and on CLOCK_REALTIME deadlines without clock selection (macOS). */
+#if defined(_POSIX_CLOCK_SELECTION) && _POSIX_CLOCK_SELECTION > 0
+  #define WAIT_MONOTONIC 1
+  #define WAIT_CLOCK     CLOCK_MONOTONIC
+#else
+  #define WAIT_MONOTONIC 0
+  #define WAIT_CLOCK     CLOCK_REALTIME
+#endif
+
+#define SLOT_FREE     0u
+#define SLOT_RESERVED 1u
+#define SLOT_QUEUED   2u
+#define SLOT_WRITING  3u
+
+#define TMP_SUFFIX ".tmp"
+
+/** Absolute WAIT_CLOCK deadline @p ms from now. */
+static struct timespec deadline(uint32_t ms) {
+    struct timespec ts;
+
+    clock_gettime(WAIT_CLOCK, &ts);
+    ts.tv_sec += (time_t)(ms / 1000u);
+    ts.tv_nsec += (long)(ms % 1000u) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return (ts);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * File writes
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static int write_all(int fd, const uint8_t *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (-1);
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return (0);
+}
+
+/** "<path>.tmp"; cfgpack_async_pageout() checked that it fits. */
+static void tmp_of(const char *path, char *tmp) {
+    size_t n = strlen(path);
+
+    memcpy(tmp, path, n);
+    memcpy(tmp + n, TMP_SUFFIX, sizeof(TMP_SUFFIX));
+}
+
+/** Directory part of @p path, "." if there is none. */
+static void dir_of(const char *path, char *dir) {
+    const char *slash = strrchr(path, '/');
+    size_t n;
+
+    if (!slash) {
+        strcpy(dir, ".");
+        return;
+    }
+    n = (slash == path) ? 1 : (size_t)(slash - path);
+    memcpy(dir, path, n);
+    dir[n] = '\0';
+}
+
+/**
+ * Write one batch: every temp file first, then every fsync, then the
+ * renames, then one fsync per distinct directory.
+ */
+static void write_batch(cfgpack_async_t *a,
+                        cfgpack_async_slot_t *const *batch,
+                        size_t n,
+                        cfgpack_err_t *rc) {
+    char tmp[CFGPACK_ASYNC_PATH_MAX];
+    char dirs[CFGPACK_ASYNC_MAX_BATCH][CFGPACK_ASYNC_PATH_MAX];
+    int fds[CFGPACK_ASYNC_MAX_BATCH];
+    size_t ndirs = 0;
+    uint64_t synced = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        tmp_of(batch[i]->path, tmp);
+        rc[i] = CFGPACK_OK;
+        fds[i] = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fds[i] < 0) {
+            rc[i] = CFGPACK_ERR_IO;
+        } else if (write_all(fds[i], batch[i]->buf, batch[i]->len) != 0) {
+            rc[i] = CFGPACK_ERR_IO;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        if (rc[i] == CFGPACK_OK && fsync(fds[i]) != 0) {
+            rc[i] = CFGPACK_ERR_IO;
+        }
+        if (close(fds[i]) != 0) {
+            rc[i] = CFGPACK_ERR_IO;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        tmp_of(batch[i]->path, tmp);
+        if (rc[i] == CFGPACK_OK && rename(tmp, batch[i]->path) != 0) {
+            rc[i] = CFGPACK_ERR_IO;
+        }
+        if (rc[i] != CFGPACK_OK) {
+            unlink(tmp);
+        }
+    }
+
+    /* Make the renames durable: each directory once for the whole batch */
+    for (size_t i = 0; i < n; ++i) {
+        char dir[CFGPACK_ASYNC_PATH_MAX];
+        size_t d;
+        int fd;
+
+        if (rc[i] != CFGPACK_OK) {
+            continue;
+        }
+        dir_of(batch[i]->path, dir);
+        for (d = 0; d < ndirs && strcmp(dirs[d], dir) != 0; ++d) {
+        }
+        if (d < ndirs) {
+            continue;
+        }
+        strcpy(dirs[ndirs++], dir);
+        fd = open(dir, O_RDONLY);
+        if (fd < 0 || fsync(fd) != 0) {
+            for (size_t j = i; j < n; ++j) {
+                char other[CFGPACK_ASYNC_PATH_MAX];
+
+                dir_of(batch[j]->path, other);
+                if (strcmp(other, dir) == 0) {
+                    rc[j] = CFGPACK_ERR_IO;
+                }
+            }
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        ++synced;
+    }
+
+    pthread_mutex_lock(&a->lock);
+    a->stats.dir_syncs += synced;
+    pthread_mutex_unlock(&a->lock);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Workers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Whether a worker holds a slot for @p path. */
+static int path_writing(const cfgpack_async_t *a, const char *path) {
+    for (size_t i = 0; i < a->opts.slot_count; ++i) {
+        const cfgpack_async_slot_t *s = &a->opts.slots[i];
+
+        if (s->state == SLOT_WRITING && strcmp(s->path, path) == 0) {
+            return (1);
+        }
+    }
+    return (0);
+}
+
+/**
+ * Take up to @c batch queued slots, oldest first, skipping paths that
+ * are being written.  Called with the lock held.
+ */
+static size_t take_batch(cfgpack_async_t *a, cfgpack_async_slot_t **batch) {
+    size_t n = 0;
+
+    for (size_t i = 0; i < a->opts.slot_count; ++i) {
+        cfgpack_async_slot_t *s = &a->opts.slots[i];
+        size_t at;
+
+        if (s->state != SLOT_QUEUED) {
+            continue;
+        }
+        if (n == a->opts.batch && s->seq > batch[n - 1]->seq) {
+            continue;
+        }
+        if (path_writing(a, s->path)) {
+            continue;
+        }
+        /* Insert by queue order, dropping the newest if full */
+        at = (n < a->opts.batch) ? n++ : n - 1;
+        while (at > 0 && batch[at - 1]->seq > s->seq) {
+            batch[at] = batch[at - 1];
+            --at;
+        }
+        batch[at] = s;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        batch[i]->state = SLOT_WRITING;
+    }
+    a->queued -= n;
+    return (n);
+}
+
+static void *async_main(void *arg) {
+    cfgpack_async_t *a = arg;
+    cfgpack_async_slot_t *batch[CFGPACK_ASYNC_MAX_BATCH];
+    cfgpack_err_t rc[CFGPACK_ASYNC_MAX_BATCH];
+
+    pthread_mutex_lock(&a->lock);
+    for (;;) {
+        size_t n;
+
+        if (a->stop && a->queued == 0) {
+            break;
+        }
+        if (a->queued == 0) {
+            pthread_cond_wait(&a->work, &a->lock);
+            continue;
+        }
+        if (a->opts.linger_ms > 0 && !a->stop &&
+            a->queued < a->opts.batch) {
+            struct timespec ts = deadline(a->opts.linger_ms);
+
+            while (!a->stop && a->queued > 0 &&
+                   a->queued < a->opts.batch &&
+                   pthread_cond_timedwait(&a->work, &a->lock, &ts) == 0) {
+            }
+        }
+        n = take_batch(a, batch);
+        if (n == 0) {
+            /* Only paths being written are queued; wait for those */
+            pthread_cond_wait(&a->work, &a->lock);
+            continue;
+        }
+        a->stats.batches++;
+        pthread_mutex_unlock(&a->lock);
+
+        write_batch(a, batch, n, rc);
+        if (a->opts.done) {
+            for (size_t i = 0; i < n; ++i) {
+                a->opts.done(batch[i]->path, rc[i], a->opts.user);
+            }
+        }
+
+        pthread_mutex_lock(&a->lock);
+        for (size_t i = 0; i < n; ++i) {
+            if (rc[i] == CFGPACK_OK) {
+                a->stats.written++;
+            } else {
+                a->stats.failed++;
+                if (a->err == CFGPACK_OK) {
+                    a->err = rc[i];
+                }
+            }
+            batch[i]->state = SLOT_FREE;
+        }
+        a->busy -= n;
+        pthread_cond_broadcast(&a->idle);
+        pthread_cond_broadcast(&a->work);
+    }
+    pthread_mutex_unlock(&a->lock);
+    return (NULL);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Public API
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+cfgpack_err_t cfgpack_async_start(cfgpack_async_t *a,
+                                  const cfgpack_async_opts_t *opts) {
+    pthread_condattr_t attr;
+
+    if (!a || !opts || !opts->slots || !opts->arena || opts->slot_count == 0 ||
+        opts->blob_cap == 0 || opts->threads == 0 ||
+        opts->threads > CFGPACK_ASYNC_MAX_THREADS ||
+        opts->batch > CFGPACK_ASYNC_MAX_BATCH) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    memset(a, 0, sizeof(*a));
+    a->opts = *opts;
+    if (a->opts.batch == 0) {
+        a->opts.batch = CFGPACK_ASYNC_MAX_BATCH;
+    }
+    for (size_t i = 0; i < opts->slot_count; ++i) {
+        memset(&opts->slots[i], 0, sizeof(opts->slots[i]));
+        opts->slots[i].buf = opts->arena + i * opts->blob_cap;
+    }
+    a->err = CFGPACK_OK;
+    if (pthread_mutex_init(&a->lock, NULL) != 0) {
+        return (CFGPACK_ERR_IO);
+    }
+    pthread_condattr_init(&attr);
+#if WAIT_MONOTONIC
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+#endif
+    if (pthread_cond_init(&a->work, &attr) != 0) {
+        pthread_condattr_destroy(&attr);
+        pthread_mutex_destroy(&a->lock);
+        return (CFGPACK_ERR_IO);
+    }
+    pthread_condattr_destroy(&attr);
+    if (pthread_cond_init(&a->idle, NULL) != 0) {
+        pthread_cond_destroy(&a->work);
+        pthread_mutex_destroy(&a->lock);
+        return (CFGPACK_ERR_IO);
+    }
+    for (unsigned i = 0; i < opts->threads; ++i) {
+        if (pthread_create(&a->threads[a->started], NULL, async_main, a) ==
+            0) {
+            a->started++;
+        }
+    }
+    if (a->started == 0) {
+        pthread_cond_destroy(&a->idle);
+        pthread_cond_destroy(&a->work);
+        pthread_mutex_destroy(&a->lock);
+        return (CFGPACK_ERR_IO);
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_async_pageout(cfgpack_async_t *a,
+                                    cfgpack_ctx_t *ctx,
+                                    const char *path) {
+    cfgpack_async_slot_t *slot = NULL;
+    cfgpack_err_t rc;
+    size_t len = 0;
+
+    if (!a || !ctx || !path) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (strlen(path) + sizeof(TMP_SUFFIX) > CFGPACK_ASYNC_PATH_MAX) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    pthread_mutex_lock(&a->lock);
+    while (!a->stop) {
+        for (size_t i = 0; i < a->opts.slot_count && !slot; ++i) {
+            if (a->opts.slots[i].state == SLOT_FREE) {
+                slot = &a->opts.slots[i];
+            }
+        }
+        if (slot) {
+            break;
+        }
+        pthread_cond_wait(&a->idle, &a->lock);
+    }
+    if (!slot) {
+        pthread_mutex_unlock(&a->lock);
+        return (CFGPACK_ERR_ARGS);
+    }
+    slot->state = SLOT_RESERVED;
+    a->busy++;
+    pthread_mutex_unlock(&a->lock);
+
+    /* The slot is ours while reserved, so encode without the lock */
+    rc = cfgpack_pageout(ctx, slot->buf, a->opts.blob_cap, &len);
+
+    pthread_mutex_lock(&a->lock);
+    if (rc != CFGPACK_OK) {
+        slot->state = SLOT_FREE;
+        a->busy--;
+        pthread_cond_broadcast(&a->idle);
+        pthread_mutex_unlock(&a->lock);
+        return (rc);
+    }
+    strcpy(slot->path, path);
+    slot->len = len;
+    slot->seq = a->seq++;
+    for (size_t i = 0; i < a->opts.slot_count; ++i) {
+        cfgpack_async_slot_t *old = &a->opts.slots[i];
+
+        if (old->state == SLOT_QUEUED && strcmp(old->path, path) == 0) {
+            /* Take over the queued blob's place in the queue */
+            slot->seq = old->seq;
+            old->state = SLOT_FREE;
+            a->busy--;
+            a->queued--;
+            a->stats.coalesced++;
+            pthread_cond_broadcast(&a->idle);
+            break;
+        }
+    }
+    slot->state = SLOT_QUEUED;
+    a->queued++;
+    a->stats.submitted++;
+    pthread_cond_signal(&a->work);
+    pthread_mutex_unlock(&a->lock);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_async_flush(cfgpack_async_t *a) {
+    cfgpack_err_t rc;
+
+    if (!a) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    pthread_mutex_lock(&a->lock);
+    while (a->busy > 0) {
+        pthread_cond_wait(&a->idle, &a->lock);
+    }
+    rc = a->err;
+    a->err = CFGPACK_OK;
+    pthread_mutex_unlock(&a->lock);
+    return (rc);
+}
+
+void cfgpack_async_get_stats(cfgpack_async_t *a, cfgpack_async_stats_t *out) {
+    pthread_mutex_lock(&a->lock);
+    *out = a->stats;
+    pthread_mutex_unlock(&a->lock);
+}
+
+cfgpack_err_t cfgpack_async_stop(cfgpack_async_t *a) {
+    cfgpack_err_t rc;
+
+    if (!a) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = cfgpack_async_flush(a);
+    pthread_mutex_lock(&a->lock);
+    a->stop = 1;
+    pthread_cond_broadcast(&a->work);
+    pthread_cond_broadcast(&a->idle);
+    pthread_mutex_unlock(&a->lock);
+    for (unsigned i = 0; i < a->started; ++i) {
+        pthread_join(a->threads[i], NULL);
+    }
+    pthread_cond_destroy(&a->idle);
+    pthread_cond_destroy(&a->work);
+    pthread_mutex_destroy(&a->lock);
+    return (rc);
+}
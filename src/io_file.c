@@ -7,11 +7,28 @@
  * use the buffer-based functions in api.h and schema.h instead.
  */
 
+#if !defined(CFGPACK_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+  #ifndef _POSIX_C_SOURCE
+    #define _POSIX_C_SOURCE 200809L /* mmap/fstat under -std=c99 */
+  #endif
+  #define CFGPACK_IO_MMAP 1
+#endif
+
 #include "cfgpack/io_file.h"
 
+#include "stats.h"
+
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+#ifdef CFGPACK_IO_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
 /**
  * @brief Read entire file into scratch buffer.
  * @param path        File path to read.
@@ -30,6 +47,7 @@ static cfgpack_err_t read_file(const char *path,
     }
 
     size_t n = fread(scratch, 1, scratch_cap - 1, f);
+    CFGPACK_STAT_ADD(NULL, io_read, n);
     if (!feof(f)) {
         fclose(f);
         return CFGPACK_ERR_IO; /* file too big for scratch */
@@ -44,31 +62,31 @@ static cfgpack_err_t read_file(const char *path,
 }
 
 /**
- * @brief Read entire file into scratch buffer (binary mode).
- * @param path        File path to read.
- * @param scratch     Scratch buffer to hold file contents.
- * @param scratch_cap Capacity of scratch buffer.
- * @param out_len     Output: bytes read.
- * @return CFGPACK_OK on success, CFGPACK_ERR_IO on failure.
+ * @brief Open file and the context it is read into or written from.
  */
-static cfgpack_err_t read_file_binary(const char *path,
-                                      uint8_t *scratch,
-                                      size_t scratch_cap,
-                                      size_t *out_len) {
-    FILE *f = fopen(path, "rb");
-    if (!f) {
-        return (CFGPACK_ERR_IO);
-    }
+typedef struct {
+    FILE *f;
+    const cfgpack_ctx_t *ctx;
+} file_io_t;
 
-    size_t n = fread(scratch, 1, scratch_cap, f);
-    if (n == scratch_cap && !feof(f)) {
-        fclose(f);
-        return CFGPACK_ERR_IO; /* file too big for scratch */
-    }
-    fclose(f);
+/**
+ * @brief cfgpack_source_fn that reads a file_io_t at @p offset.
+ */
+static cfgpack_err_t file_source(void *user,
+                                 size_t offset,
+                                 uint8_t *dst,
+                                 size_t cap,
+                                 size_t *out_len) {
+    const file_io_t *io = (const file_io_t *)user;
+    FILE *f = io->f;
 
-    if (out_len) {
-        *out_len = n;
+    if (fseek(f, (long)offset, SEEK_SET) != 0) {
+        return (CFGPACK_ERR_IO);
+    }
+    *out_len = fread(dst, 1, cap, f);
+    CFGPACK_STAT_ADD(io->ctx, io_read, *out_len);
+    if (*out_len < cap && ferror(f)) {
+        return (CFGPACK_ERR_IO);
     }
     return (CFGPACK_OK);
 }
@@ -92,29 +110,7 @@ static cfgpack_err_t write_file(const char *path,
         fclose(f);
         return (CFGPACK_ERR_IO);
     }
-    fclose(f);
-    return (CFGPACK_OK);
-}
-
-/**
- * @brief Write buffer to file (binary mode).
- * @param path File path to write.
- * @param data Data to write.
- * @param len  Length of data.
- * @return CFGPACK_OK on success, CFGPACK_ERR_IO on failure.
- */
-static cfgpack_err_t write_file_binary(const char *path,
-                                       const uint8_t *data,
-                                       size_t len) {
-    FILE *f = fopen(path, "wb");
-    if (!f) {
-        return (CFGPACK_ERR_IO);
-    }
-
-    if (fwrite(data, 1, len, f) != len) {
-        fclose(f);
-        return (CFGPACK_ERR_IO);
-    }
+    CFGPACK_STAT_ADD(NULL, io_written, len);
     fclose(f);
     return (CFGPACK_OK);
 }
@@ -220,19 +216,49 @@ cfgpack_err_t cfgpack_schema_write_json_file(const cfgpack_ctx_t *ctx,
     return (write_file(path, scratch, out_len));
 }
 
-cfgpack_err_t cfgpack_pageout_file(const cfgpack_ctx_t *ctx,
+/**
+ * @brief cfgpack_sink_fn that appends each chunk to a file_io_t.
+ */
+static cfgpack_err_t file_sink(void *user, const uint8_t *data, size_t len) {
+    const file_io_t *io = (const file_io_t *)user;
+
+    if (fwrite(data, 1, len, io->f) != len) {
+        return (CFGPACK_ERR_IO);
+    }
+    CFGPACK_STAT_ADD(io->ctx, io_written, len);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_pageout_file(cfgpack_ctx_t *ctx,
                                    const char *path,
                                    uint8_t *scratch,
                                    size_t scratch_cap) {
     cfgpack_err_t rc;
     size_t len = 0;
+    file_io_t io;
 
-    rc = cfgpack_pageout(ctx, scratch, scratch_cap, &len);
+    if (!ctx || !scratch) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (scratch_cap < CFGPACK_STREAM_CHUNK_MIN) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    /* Surface encode errors before the existing file is truncated */
+    rc = cfgpack_pageout_measure(ctx, &len);
     if (rc != CFGPACK_OK) {
         return (rc);
     }
 
-    return (write_file_binary(path, scratch, len));
+    io.f = fopen(path, "wb");
+    io.ctx = ctx;
+    if (!io.f) {
+        return (CFGPACK_ERR_IO);
+    }
+    rc = cfgpack_pageout_stream(ctx, file_sink, &io, scratch, scratch_cap);
+    if (fclose(io.f) != 0 && rc == CFGPACK_OK) {
+        rc = CFGPACK_ERR_IO;
+    }
+    return (rc);
 }
 
 cfgpack_err_t cfgpack_pagein_file(cfgpack_ctx_t *ctx,
@@ -240,12 +266,193 @@ cfgpack_err_t cfgpack_pagein_file(cfgpack_ctx_t *ctx,
                                   uint8_t *scratch,
                                   size_t scratch_cap) {
     cfgpack_err_t rc;
-    size_t len = 0;
+    file_io_t io;
+    size_t n;
+    FILE *f;
 
-    rc = read_file_binary(path, scratch, scratch_cap, &len);
-    if (rc != CFGPACK_OK) {
-        return (rc);
+    f = fopen(path, "rb");
+    if (!f) {
+        return (CFGPACK_ERR_IO);
     }
 
-    return (cfgpack_pagein_buf(ctx, scratch, len));
+    n = fread(scratch, 1, scratch_cap, f);
+    CFGPACK_STAT_ADD(ctx, io_read, n);
+    if (ferror(f)) {
+        rc = CFGPACK_ERR_IO;
+    } else if (n < scratch_cap || fgetc(f) == EOF) {
+        /* Whole file fits: single-pass decode */
+        fclose(f);
+        return (cfgpack_pagein_buf(ctx, scratch, n));
+    } else if (scratch_cap >= CFGPACK_STREAM_WINDOW_MIN) {
+        /* Larger than scratch: decode through a refill window */
+        io.f = f;
+        io.ctx = ctx;
+        rc = cfgpack_pagein_stream(ctx, file_source, &io, scratch,
+                                   scratch_cap);
+    } else {
+        rc = CFGPACK_ERR_IO; /* file too big for scratch */
+    }
+
+    fclose(f);
+    return (rc);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Memory-mapped variants
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#ifdef CFGPACK_IO_MMAP
+/**
+ * @brief Read-only mapping of a whole file.
+ */
+typedef struct {
+    const char *data; /**< Mapped bytes (or "" for an empty file). */
+    size_t len;       /**< File size. */
+    void *map;        /**< mmap() result, NULL for an empty file. */
+} mapped_file_t;
+
+/**
+ * @brief Map @p path read-only.
+ * @return CFGPACK_OK on success, CFGPACK_ERR_IO on failure.
+ */
+static cfgpack_err_t map_file(const char *path, mapped_file_t *m) {
+    struct stat st;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return (CFGPACK_ERR_IO);
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        (uintmax_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        return (CFGPACK_ERR_IO);
+    }
+    m->len = (size_t)st.st_size;
+    m->map = NULL;
+    m->data = "";
+    if (m->len > 0) {
+        m->map = mmap(NULL, m->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m->map == MAP_FAILED) {
+            close(fd);
+            return (CFGPACK_ERR_IO);
+        }
+        m->data = (const char *)m->map;
+    }
+    close(fd); /* the mapping stays valid */
+    return (CFGPACK_OK);
+}
+
+static void unmap_file(mapped_file_t *m) {
+    if (m->map) {
+        munmap(m->map, m->len);
+    }
+}
+
+/**
+ * @brief Report a file that could not be opened in a parse error.
+ */
+static void set_open_error(cfgpack_parse_error_t *err) {
+    if (err) {
+        err->line = 0;
+        snprintf(err->message, sizeof(err->message), "unable to open file");
+    }
+}
+#endif /* CFGPACK_IO_MMAP */
+
+cfgpack_err_t cfgpack_parse_schema_file_mmap(const char *path,
+                                             const cfgpack_parse_opts_t *opts,
+                                             char *scratch,
+                                             size_t scratch_cap) {
+#ifdef CFGPACK_IO_MMAP
+    mapped_file_t m;
+    cfgpack_err_t rc;
+
+    (void)scratch;
+    (void)scratch_cap;
+    if (!path || !opts) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (map_file(path, &m) != CFGPACK_OK) {
+        set_open_error(opts->err);
+        return (CFGPACK_ERR_IO);
+    }
+    rc = cfgpack_parse_schema(m.data, m.len, opts);
+    unmap_file(&m);
+    return (rc);
+#else
+    if (!path || !opts || !scratch || scratch_cap == 0) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    return (cfgpack_parse_schema_file(path, opts, scratch, scratch_cap));
+#endif
+}
+
+cfgpack_err_t
+cfgpack_schema_parse_json_file_mmap(const char *path,
+                                    const cfgpack_parse_opts_t *opts,
+                                    char *scratch,
+                                    size_t scratch_cap) {
+#ifdef CFGPACK_IO_MMAP
+    mapped_file_t m;
+    cfgpack_err_t rc;
+
+    (void)scratch;
+    (void)scratch_cap;
+    if (!path || !opts) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (map_file(path, &m) != CFGPACK_OK) {
+        set_open_error(opts->err);
+        return (CFGPACK_ERR_IO);
+    }
+    rc = cfgpack_schema_parse_json(m.data, m.len, opts);
+    unmap_file(&m);
+    return (rc);
+#else
+    if (!path || !opts || !scratch || scratch_cap == 0) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    return (cfgpack_schema_parse_json_file(path, opts, scratch, scratch_cap));
+#endif
+}
+
+cfgpack_err_t cfgpack_pagein_file_mmap(cfgpack_ctx_t *ctx,
+                                       const char *path,
+                                       uint8_t *scratch,
+                                       size_t scratch_cap) {
+#ifdef CFGPACK_IO_MMAP
+    mapped_file_t m;
+    cfgpack_err_t rc;
+
+    (void)scratch;
+    (void)scratch_cap;
+    if (!ctx || !path) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (map_file(path, &m) != CFGPACK_OK) {
+        return (CFGPACK_ERR_IO);
+    }
+    rc = cfgpack_pagein_buf(ctx, (const uint8_t *)m.data, m.len);
+  #ifdef CFGPACK_LAZY
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_lazy_finish(ctx); /* the mapping goes away below */
+    }
+  #endif
+    unmap_file(&m);
+    return (rc);
+#else
+    if (!ctx || !path || !scratch || scratch_cap == 0) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    return (cfgpack_pagein_file(ctx, path, scratch, scratch_cap));
+#endif
+}
+
+int cfgpack_io_file_has_mmap(void) {
+#ifdef CFGPACK_IO_MMAP
+    return (1);
+#else
+    return (0);
+#endif
 }
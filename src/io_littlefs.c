@@ -12,7 +12,13 @@
 
 #ifdef CFGPACK_LITTLEFS
 
+  #include "cfgpack/bundle.h"
   #include "cfgpack/io_littlefs.h"
+  #include "cfgpack/slots.h"
+
+  #include "crc32.h"
+  #include "lookup.h"
+  #include "stats.h"
 
   #include <string.h>
 
@@ -49,128 +55,1094 @@ static cfgpack_err_t split_scratch(const lfs_t *lfs,
  * ───────────────────────────────────────────────────────────────────────────── */
 
 /**
- * @brief Read entire LittleFS file into buffer.
+ * @brief Source state for streaming pagein from an open LittleFS file.
  */
-static cfgpack_err_t read_lfs_file(lfs_t *lfs,
-                                   const char *path,
-                                   uint8_t *file_cache,
-                                   uint8_t *buf,
-                                   size_t buf_cap,
-                                   size_t *out_len) {
-    struct lfs_file_config file_cfg;
-    lfs_ssize_t size;
-    lfs_ssize_t n;
-    lfs_file_t file;
-    int err;
+typedef struct {
+    lfs_t *lfs;
+    lfs_file_t *file;
+    size_t base;              /**< File offset of source byte 0. */
+    size_t limit;             /**< Source length in bytes. */
+    const cfgpack_ctx_t *ctx; /**< Context charged for the reads. */
+} lfs_source_t;
 
-    memset(&file_cfg, 0, sizeof(file_cfg));
-    file_cfg.buffer = file_cache;
+/**
+ * @brief cfgpack_source_fn that reads [base, base + limit) of a LittleFS
+ *        file at @p offset.
+ */
+static cfgpack_err_t lfs_source(void *user,
+                                size_t offset,
+                                uint8_t *dst,
+                                size_t cap,
+                                size_t *out_len) {
+    lfs_source_t *s = (lfs_source_t *)user;
+    lfs_ssize_t n;
 
-    err = lfs_file_opencfg(lfs, &file, path, LFS_O_RDONLY, &file_cfg);
-    if (err < 0) {
+    if (offset >= s->limit) {
+        *out_len = 0;
+        return (CFGPACK_OK);
+    }
+    if (cap > s->limit - offset) {
+        cap = s->limit - offset;
+    }
+    if (lfs_file_seek(s->lfs, s->file, (lfs_soff_t)(s->base + offset),
+                      LFS_SEEK_SET) < 0) {
         return (CFGPACK_ERR_IO);
     }
-
-    size = lfs_file_size(lfs, &file);
-    if (size < 0 || (size_t)size > buf_cap) {
-        lfs_file_close(lfs, &file);
+    n = lfs_file_read(s->lfs, s->file, dst, (lfs_size_t)cap);
+    if (n < 0) {
         return (CFGPACK_ERR_IO);
     }
+    CFGPACK_STAT_ADD(s->ctx, io_read, n);
+    *out_len = (size_t)n;
+    return (CFGPACK_OK);
+}
 
-    n = lfs_file_read(lfs, &file, buf, (lfs_size_t)size);
-    lfs_file_close(lfs, &file);
+/**
+ * @brief Sink state for streaming pageout into an open LittleFS file.
+ */
+typedef struct {
+    lfs_t *lfs;
+    lfs_file_t *file;
+    const cfgpack_ctx_t *ctx; /**< Context charged for the writes. */
+} lfs_sink_t;
+
+/**
+ * @brief cfgpack_sink_fn that appends each chunk to a LittleFS file.
+ */
+static cfgpack_err_t lfs_sink(void *user, const uint8_t *data, size_t len) {
+    lfs_sink_t *s = (lfs_sink_t *)user;
+    lfs_ssize_t n = lfs_file_write(s->lfs, s->file, data, (lfs_size_t)len);
 
-    if (n != size) {
+    if (n < 0 || (size_t)n != len) {
         return (CFGPACK_ERR_IO);
     }
-
-    *out_len = (size_t)n;
+    CFGPACK_STAT_ADD(s->ctx, io_written, n);
     return (CFGPACK_OK);
 }
 
 /**
- * @brief Write buffer to a LittleFS file.
+ * @brief Stream a full blob into a LittleFS file, replacing its contents.
+ *
+ * @p hdr (may be empty) is written ahead of the blob.  LittleFS commits the
+ * new contents atomically on close, so a failure leaves the old file in
+ * place; dirty bits are restored in that case.
  */
-static cfgpack_err_t write_lfs_file(lfs_t *lfs,
+static cfgpack_err_t write_lfs_blob(cfgpack_ctx_t *ctx,
+                                    lfs_t *lfs,
                                     const char *path,
                                     uint8_t *file_cache,
-                                    const uint8_t *data,
-                                    size_t len) {
+                                    uint8_t *chunk_buf,
+                                    size_t chunk_cap,
+                                    const uint8_t *hdr,
+                                    size_t hdr_len) {
+    uint8_t saved_dirty[CFGPACK_DIRTY_SAVE_BYTES];
     struct lfs_file_config file_cfg;
-    lfs_ssize_t n;
     lfs_file_t file;
-    int err;
+    lfs_sink_t sink;
+    cfgpack_err_t rc;
 
     memset(&file_cfg, 0, sizeof(file_cfg));
     file_cfg.buffer = file_cache;
-
-    err = lfs_file_opencfg(lfs, &file, path,
-                           LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC, &file_cfg);
-    if (err < 0) {
+    if (lfs_file_opencfg(lfs, &file, path,
+                         LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC,
+                         &file_cfg) < 0) {
         return (CFGPACK_ERR_IO);
     }
 
-    n = lfs_file_write(lfs, &file, data, (lfs_size_t)len);
+    cfgpack_dirty_save(ctx, saved_dirty);
+    sink.lfs = lfs;
+    sink.file = &file;
+    sink.ctx = ctx;
+    rc = CFGPACK_OK;
+    if (hdr_len > 0) {
+        rc = lfs_sink(&sink, hdr, hdr_len);
+    }
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_pageout_stream(ctx, lfs_sink, &sink, chunk_buf,
+                                    chunk_cap);
+    }
+    if (lfs_file_close(lfs, &file) < 0 && rc == CFGPACK_OK) {
+        rc = CFGPACK_ERR_IO;
+    }
+    if (rc != CFGPACK_OK) {
+        cfgpack_dirty_restore(ctx, saved_dirty);
+    }
+    return (rc);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Journal record framing
+ *
+ * A journal file is a sequence of records, each a 1-byte tag and a 4-byte
+ * little-endian length followed by a complete cfgpack blob (with its own
+ * CRC-32C trailer).  The first record is a full base blob; every later
+ * record is a cfgpack_pageout_delta() blob.
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+  #define JOURNAL_TAG_BASE  0x42u /* 'B' */
+  #define JOURNAL_TAG_DELTA 0x44u /* 'D' */
+  #define JOURNAL_HDR_SIZE  5u
+
+static void journal_hdr(uint8_t *hdr, uint8_t tag, size_t len) {
+    hdr[0] = tag;
+    hdr[1] = (uint8_t)(len);
+    hdr[2] = (uint8_t)(len >> 8);
+    hdr[3] = (uint8_t)(len >> 16);
+    hdr[4] = (uint8_t)(len >> 24);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * A/B slot helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Read and validate the slot header of an A/B file.
+ * @param valid  Set to 1 if the file exists, has a valid header, and holds
+ *               at least the advertised blob length.
+ */
+static void read_slot_hdr(lfs_t *lfs,
+                          const char *path,
+                          uint8_t *file_cache,
+                          cfgpack_slot_hdr_t *hdr,
+                          int *valid) {
+    uint8_t raw[CFGPACK_SLOT_HDR_SIZE];
+    struct lfs_file_config file_cfg;
+    lfs_ssize_t size;
+    lfs_file_t file;
+
+    *valid = 0;
+    memset(&file_cfg, 0, sizeof(file_cfg));
+    file_cfg.buffer = file_cache;
+    if (lfs_file_opencfg(lfs, &file, path, LFS_O_RDONLY, &file_cfg) < 0) {
+        return;
+    }
+    size = lfs_file_size(lfs, &file);
+    CFGPACK_STAT_ADD(NULL, io_read, sizeof(raw));
+    if (lfs_file_read(lfs, &file, raw, sizeof(raw)) ==
+            (lfs_ssize_t)sizeof(raw) &&
+        cfgpack_slot_hdr_decode(raw, hdr) == CFGPACK_OK &&
+        size >= 0 && (size_t)size - sizeof(raw) >= hdr->len) {
+        *valid = 1;
+    }
+    lfs_file_close(lfs, &file);
+}
+
+/**
+ * @brief Check the blob of an A/B file against its CRC trailer.
+ *
+ * Reads through @p buf in chunks.  Returns 1 if the trailer matches, 0 on
+ * mismatch or any read failure.
+ */
+static int slot_file_ok(lfs_t *lfs,
+                        const char *path,
+                        uint8_t *file_cache,
+                        uint8_t *buf,
+                        size_t cap,
+                        size_t len) {
+    uint8_t trailer[CFGPACK_CRC_SIZE];
+    struct lfs_file_config file_cfg;
+    uint32_t crc = cfgpack_crc32c_init();
+    lfs_file_t file;
+    size_t off = 0;
+    int ok = 0;
+
+    if (len < CFGPACK_CRC_SIZE) {
+        return (0);
+    }
+    memset(&file_cfg, 0, sizeof(file_cfg));
+    file_cfg.buffer = file_cache;
+    if (lfs_file_opencfg(lfs, &file, path, LFS_O_RDONLY, &file_cfg) < 0) {
+        return (0);
+    }
+    if (lfs_file_seek(lfs, &file, CFGPACK_SLOT_HDR_SIZE, LFS_SEEK_SET) < 0) {
+        goto done;
+    }
+    while (off < len - CFGPACK_CRC_SIZE) {
+        size_t want = len - CFGPACK_CRC_SIZE - off;
+        lfs_ssize_t n;
+        if (want > cap) {
+            want = cap;
+        }
+        n = lfs_file_read(lfs, &file, buf, (lfs_size_t)want);
+        if (n < 0 || (size_t)n != want) {
+            goto done;
+        }
+        CFGPACK_STAT_ADD(NULL, io_read, n);
+        crc = cfgpack_crc32c_update(crc, buf, want);
+        off += want;
+    }
+    if (lfs_file_read(lfs, &file, trailer, sizeof(trailer)) ==
+        (lfs_ssize_t)sizeof(trailer)) {
+        ok = cfgpack_crc32c_final(crc) ==
+             ((uint32_t)trailer[0] | ((uint32_t)trailer[1] << 8) |
+              ((uint32_t)trailer[2] << 16) | ((uint32_t)trailer[3] << 24));
+    }
+
+done:
     lfs_file_close(lfs, &file);
+    return (ok);
+}
 
-    if (n < 0 || (size_t)n != len) {
+/**
+ * @brief Load the blob that follows the slot header of an A/B file.
+ */
+static cfgpack_err_t pagein_slot_file(cfgpack_ctx_t *ctx,
+                                      lfs_t *lfs,
+                                      const char *path,
+                                      uint8_t *file_cache,
+                                      uint8_t *data_buf,
+                                      size_t data_cap,
+                                      size_t len) {
+    struct lfs_file_config file_cfg;
+    lfs_source_t source;
+    lfs_file_t file;
+    cfgpack_err_t rc;
+    lfs_ssize_t n;
+
+    memset(&file_cfg, 0, sizeof(file_cfg));
+    file_cfg.buffer = file_cache;
+    if (lfs_file_opencfg(lfs, &file, path, LFS_O_RDONLY, &file_cfg) < 0) {
         return (CFGPACK_ERR_IO);
     }
-    return (CFGPACK_OK);
+
+    if (len <= data_cap) {
+        rc = CFGPACK_ERR_IO;
+        if (lfs_file_seek(lfs, &file, CFGPACK_SLOT_HDR_SIZE, LFS_SEEK_SET) >=
+            0) {
+            n = lfs_file_read(lfs, &file, data_buf, (lfs_size_t)len);
+            if (n >= 0 && (size_t)n == len) {
+                CFGPACK_STAT_ADD(ctx, io_read, n);
+                rc = cfgpack_pagein_buf(ctx, data_buf, len);
+            }
+        }
+    } else if (data_cap >= CFGPACK_STREAM_WINDOW_MIN) {
+        source.lfs = lfs;
+        source.file = &file;
+        source.base = CFGPACK_SLOT_HDR_SIZE;
+        source.limit = len;
+        source.ctx = ctx;
+        rc = cfgpack_pagein_stream(ctx, lfs_source, &source, data_buf,
+                                   data_cap);
+    } else {
+        rc = CFGPACK_ERR_IO;
+    }
+
+    lfs_file_close(lfs, &file);
+    return (rc);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Flash cost accounting
+ *
+ * A meter's cfg is a copy of the caller's lfs_config whose block device
+ * callbacks count and time each call before forwarding it.  cfg is the
+ * first member, so the callbacks and meter_of() recover the meter from
+ * the lfs_config pointer LittleFS hands back.
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static int meter_read(const struct lfs_config *c,
+                      lfs_block_t block,
+                      lfs_off_t off,
+                      void *buffer,
+                      lfs_size_t size);
+
+/** Meter behind a mount, or NULL if it was not mounted through one. */
+static cfgpack_lfs_meter_t *meter_of(const lfs_t *lfs) {
+    if (!lfs || !lfs->cfg || lfs->cfg->read != meter_read) {
+        return (NULL);
+    }
+    return ((cfgpack_lfs_meter_t *)(uintptr_t)lfs->cfg);
+}
+
+/** Meter owning @p c; only called from the meter callbacks. */
+static cfgpack_lfs_meter_t *meter_from_cfg(const struct lfs_config *c) {
+    return ((cfgpack_lfs_meter_t *)(uintptr_t)c);
+}
+
+static uint32_t meter_now(const cfgpack_lfs_meter_t *m) {
+    return (m->clock ? m->clock(m->clock_user) : 0);
+}
+
+static int meter_read(const struct lfs_config *c,
+                      lfs_block_t block,
+                      lfs_off_t off,
+                      void *buffer,
+                      lfs_size_t size) {
+    cfgpack_lfs_meter_t *m = meter_from_cfg(c);
+    uint32_t t0 = meter_now(m);
+    int err = m->base->read(c, block, off, buffer, size);
+
+    m->total.flash_ticks += meter_now(m) - t0;
+    m->total.reads++;
+    m->total.read_bytes += size;
+    return (err);
+}
+
+static int meter_prog(const struct lfs_config *c,
+                      lfs_block_t block,
+                      lfs_off_t off,
+                      const void *buffer,
+                      lfs_size_t size) {
+    cfgpack_lfs_meter_t *m = meter_from_cfg(c);
+    uint32_t t0 = meter_now(m);
+    int err = m->base->prog(c, block, off, buffer, size);
+
+    m->total.flash_ticks += meter_now(m) - t0;
+    m->total.progs++;
+    m->total.prog_bytes += size;
+    return (err);
+}
+
+static int meter_erase(const struct lfs_config *c, lfs_block_t block) {
+    cfgpack_lfs_meter_t *m = meter_from_cfg(c);
+    uint32_t t0 = meter_now(m);
+    int err = m->base->erase(c, block);
+
+    m->total.flash_ticks += meter_now(m) - t0;
+    m->total.erases++;
+    return (err);
+}
+
+static int meter_sync(const struct lfs_config *c) {
+    cfgpack_lfs_meter_t *m = meter_from_cfg(c);
+    uint32_t t0 = meter_now(m);
+    int err = m->base->sync(c);
+
+    m->total.flash_ticks += meter_now(m) - t0;
+    m->total.syncs++;
+    return (err);
+}
+
+/** Start charging a wrapper call to the meter behind @p lfs, if any. */
+static void meter_begin(const lfs_t *lfs) {
+    cfgpack_lfs_meter_t *m = meter_of(lfs);
+
+    if (m) {
+        m->mark = m->total;
+        m->start = meter_now(m);
+    }
+}
+
+/** Record the cost since meter_begin() as the meter's last operation. */
+static void meter_end(const lfs_t *lfs) {
+    cfgpack_lfs_meter_t *m = meter_of(lfs);
+
+    if (m) {
+        m->last.reads = m->total.reads - m->mark.reads;
+        m->last.read_bytes = m->total.read_bytes - m->mark.read_bytes;
+        m->last.progs = m->total.progs - m->mark.progs;
+        m->last.prog_bytes = m->total.prog_bytes - m->mark.prog_bytes;
+        m->last.erases = m->total.erases - m->mark.erases;
+        m->last.syncs = m->total.syncs - m->mark.syncs;
+        m->last.flash_ticks = m->total.flash_ticks - m->mark.flash_ticks;
+        m->last.ticks = meter_now(m) - m->start;
+        m->total.ticks += m->last.ticks;
+    }
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════
- * Public API
+ * Operations
  * ═══════════════════════════════════════════════════════════════════════════ */
 
-cfgpack_err_t cfgpack_pageout_lfs(const cfgpack_ctx_t *ctx,
-                                  lfs_t *lfs,
-                                  const char *path,
-                                  uint8_t *scratch,
-                                  size_t scratch_cap) {
+static cfgpack_err_t pageout_lfs(cfgpack_ctx_t *ctx,
+                                 lfs_t *lfs,
+                                 const char *path,
+                                 uint8_t *scratch,
+                                 size_t scratch_cap) {
+    uint8_t *file_cache;
+    uint8_t *chunk_buf;
+    cfgpack_err_t rc;
+    size_t chunk_cap;
+    size_t len = 0;
+
+    rc = split_scratch(lfs, scratch, scratch_cap, &file_cache, &chunk_buf,
+                       &chunk_cap);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (chunk_cap < CFGPACK_STREAM_CHUNK_MIN) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    /* Surface encode errors before the existing file is truncated */
+    rc = cfgpack_pageout_measure(ctx, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    return (write_lfs_blob(ctx, lfs, path, file_cache, chunk_buf, chunk_cap,
+                           NULL, 0));
+}
+
+static cfgpack_err_t pagein_lfs(cfgpack_ctx_t *ctx,
+                                lfs_t *lfs,
+                                const char *path,
+                                uint8_t *scratch,
+                                size_t scratch_cap) {
+    struct lfs_file_config file_cfg;
     uint8_t *file_cache;
     uint8_t *data_buf;
+    lfs_source_t source;
+    lfs_ssize_t size;
+    lfs_ssize_t n;
+    lfs_file_t file;
     cfgpack_err_t rc;
     size_t data_cap;
+
+    rc = split_scratch(lfs, scratch, scratch_cap, &file_cache, &data_buf,
+                       &data_cap);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    memset(&file_cfg, 0, sizeof(file_cfg));
+    file_cfg.buffer = file_cache;
+    if (lfs_file_opencfg(lfs, &file, path, LFS_O_RDONLY, &file_cfg) < 0) {
+        return (CFGPACK_ERR_IO);
+    }
+
+    size = lfs_file_size(lfs, &file);
+    if (size < 0) {
+        rc = CFGPACK_ERR_IO;
+    } else if ((size_t)size <= data_cap) {
+        /* Whole file fits: one read, single-pass decode */
+        n = lfs_file_read(lfs, &file, data_buf, (lfs_size_t)size);
+        rc = (n == size) ? CFGPACK_OK : CFGPACK_ERR_IO;
+        if (rc == CFGPACK_OK) {
+            CFGPACK_STAT_ADD(ctx, io_read, n);
+            lfs_file_close(lfs, &file);
+            return (cfgpack_pagein_buf(ctx, data_buf, (size_t)n));
+        }
+    } else if (data_cap >= CFGPACK_STREAM_WINDOW_MIN) {
+        /* Larger than scratch: decode through a refill window */
+        source.lfs = lfs;
+        source.file = &file;
+        source.base = 0;
+        source.limit = (size_t)size;
+        source.ctx = ctx;
+        rc = cfgpack_pagein_stream(ctx, lfs_source, &source, data_buf,
+                                   data_cap);
+    } else {
+        rc = CFGPACK_ERR_IO;
+    }
+
+    lfs_file_close(lfs, &file);
+    return (rc);
+}
+
+static cfgpack_err_t journal_compact(cfgpack_ctx_t *ctx,
+                                     lfs_t *lfs,
+                                     const char *path,
+                                     uint8_t *scratch,
+                                     size_t scratch_cap) {
+    uint8_t hdr[JOURNAL_HDR_SIZE];
+    uint8_t *file_cache;
+    uint8_t *chunk_buf;
+    cfgpack_err_t rc;
+    size_t chunk_cap;
     size_t len = 0;
 
+    rc = split_scratch(lfs, scratch, scratch_cap, &file_cache, &chunk_buf,
+                       &chunk_cap);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (chunk_cap < CFGPACK_STREAM_CHUNK_MIN) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    /* The base length goes in the record header, ahead of the stream */
+    rc = cfgpack_pageout_measure(ctx, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    journal_hdr(hdr, JOURNAL_TAG_BASE, len);
+    return (write_lfs_blob(ctx, lfs, path, file_cache, chunk_buf, chunk_cap,
+                           hdr, sizeof(hdr)));
+}
+
+static cfgpack_err_t pageout_lfs_journal(cfgpack_ctx_t *ctx,
+                                         lfs_t *lfs,
+                                         const char *path,
+                                         uint8_t *scratch,
+                                         size_t scratch_cap,
+                                         size_t compact_at) {
+    uint8_t saved_dirty[CFGPACK_DIRTY_SAVE_BYTES];
+    struct lfs_file_config file_cfg;
+    struct lfs_info info;
+    uint8_t *file_cache;
+    uint8_t *data_buf;
+    lfs_file_t file;
+    lfs_ssize_t n;
+    cfgpack_err_t rc;
+    size_t data_cap;
+    size_t len = 0;
+    int err;
+
+    if (!ctx || !lfs || !path || !scratch) {
+        return (CFGPACK_ERR_ARGS);
+    }
     rc = split_scratch(lfs, scratch, scratch_cap, &file_cache, &data_buf,
                        &data_cap);
     if (rc != CFGPACK_OK) {
         return (rc);
     }
 
-    rc = cfgpack_pageout(ctx, data_buf, data_cap, &len);
+    /* No journal yet: start one with a base record */
+    err = lfs_stat(lfs, path, &info);
+    if (err == LFS_ERR_NOENT) {
+        return (journal_compact(ctx, lfs, path, scratch, scratch_cap));
+    }
+    if (err < 0) {
+        return (CFGPACK_ERR_IO);
+    }
+    if (cfgpack_get_dirty_count(ctx) == 0) {
+        return (CFGPACK_OK);
+    }
+
+    /* Encode the delta after the header slot; a delta that does not fit
+     * the data region falls back to compaction */
+    cfgpack_dirty_save(ctx, saved_dirty);
+    if (data_cap <= JOURNAL_HDR_SIZE) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    rc = cfgpack_pageout_delta(ctx, data_buf + JOURNAL_HDR_SIZE,
+                               data_cap - JOURNAL_HDR_SIZE, &len);
+    if (rc == CFGPACK_ERR_ENCODE ||
+        (rc == CFGPACK_OK && compact_at > 0 &&
+         (size_t)info.size + JOURNAL_HDR_SIZE + len > compact_at)) {
+        cfgpack_dirty_restore(ctx, saved_dirty);
+        return (journal_compact(ctx, lfs, path, scratch, scratch_cap));
+    }
     if (rc != CFGPACK_OK) {
         return (rc);
     }
 
-    return (write_lfs_file(lfs, path, file_cache, data_buf, len));
+    journal_hdr(data_buf, JOURNAL_TAG_DELTA, len);
+    memset(&file_cfg, 0, sizeof(file_cfg));
+    file_cfg.buffer = file_cache;
+    rc = CFGPACK_ERR_IO;
+    if (lfs_file_opencfg(lfs, &file, path, LFS_O_WRONLY | LFS_O_APPEND,
+                         &file_cfg) >= 0) {
+        n = lfs_file_write(lfs, &file, data_buf,
+                           (lfs_size_t)(JOURNAL_HDR_SIZE + len));
+        rc = (n >= 0 && (size_t)n == JOURNAL_HDR_SIZE + len) ? CFGPACK_OK
+                                                              : CFGPACK_ERR_IO;
+        if (rc == CFGPACK_OK) {
+            CFGPACK_STAT_ADD(ctx, io_written, n);
+        }
+        if (lfs_file_close(lfs, &file) < 0) {
+            rc = CFGPACK_ERR_IO;
+        }
+    }
+    if (rc != CFGPACK_OK) {
+        cfgpack_dirty_restore(ctx, saved_dirty);
+    }
+    return (rc);
 }
 
-cfgpack_err_t cfgpack_pagein_lfs(cfgpack_ctx_t *ctx,
-                                 lfs_t *lfs,
-                                 const char *path,
-                                 uint8_t *scratch,
-                                 size_t scratch_cap) {
+/**
+ * @brief Apply the first @p max records of an open journal file.
+ *
+ * @p applied receives the number of records that went in without error,
+ * so on failure the records before the bad one are known to be good.
+ */
+static cfgpack_err_t journal_replay(cfgpack_ctx_t *ctx,
+                                    lfs_source_t *source,
+                                    size_t size,
+                                    uint8_t *data_buf,
+                                    size_t data_cap,
+                                    size_t max,
+                                    size_t *applied) {
+    cfgpack_err_t rc = CFGPACK_OK;
+    size_t off = 0;
+
+    *applied = 0;
+    while (rc == CFGPACK_OK && off < size && *applied < max) {
+        uint8_t want = (off == 0) ? JOURNAL_TAG_BASE : JOURNAL_TAG_DELTA;
+        size_t len;
+        lfs_ssize_t n;
+
+        if (lfs_file_seek(source->lfs, source->file, (lfs_soff_t)off,
+                          LFS_SEEK_SET) < 0 ||
+            lfs_file_read(source->lfs, source->file, data_buf,
+                          JOURNAL_HDR_SIZE) != (lfs_ssize_t)JOURNAL_HDR_SIZE) {
+            rc = CFGPACK_ERR_DECODE; /* truncated header */
+            break;
+        }
+        CFGPACK_STAT_ADD(ctx, io_read, JOURNAL_HDR_SIZE);
+        len = (size_t)data_buf[1] | ((size_t)data_buf[2] << 8) |
+              ((size_t)data_buf[3] << 16) | ((size_t)data_buf[4] << 24);
+        if (data_buf[0] != want || len > size - off - JOURNAL_HDR_SIZE) {
+            rc = CFGPACK_ERR_DECODE;
+            break;
+        }
+        off += JOURNAL_HDR_SIZE;
+
+        if (len <= data_cap) {
+            n = lfs_file_read(source->lfs, source->file, data_buf,
+                              (lfs_size_t)len);
+            if (n < 0 || (size_t)n != len) {
+                rc = CFGPACK_ERR_IO;
+                break;
+            }
+            CFGPACK_STAT_ADD(ctx, io_read, n);
+            if (want == JOURNAL_TAG_BASE) {
+                rc = cfgpack_pagein_buf(ctx, data_buf, len);
+            } else {
+                rc = cfgpack_pagein_delta(ctx, data_buf, len);
+            }
+        } else if (want == JOURNAL_TAG_BASE &&
+                   data_cap >= CFGPACK_STREAM_WINDOW_MIN) {
+            /* Base larger than scratch: stream it like cfgpack_pagein_lfs */
+            source->base = off;
+            source->limit = len;
+            rc = cfgpack_pagein_stream(ctx, lfs_source, source, data_buf,
+                                       data_cap);
+        } else {
+            rc = CFGPACK_ERR_IO;
+        }
+        if (rc == CFGPACK_OK) {
+            (*applied)++;
+        }
+        off += len;
+    }
+    return (rc);
+}
+
+static cfgpack_err_t pagein_lfs_journal(cfgpack_ctx_t *ctx,
+                                        lfs_t *lfs,
+                                        const char *path,
+                                        uint8_t *scratch,
+                                        size_t scratch_cap) {
+    struct lfs_file_config file_cfg;
     uint8_t *file_cache;
     uint8_t *data_buf;
+    lfs_source_t source;
+    lfs_file_t file;
+    lfs_ssize_t size;
     cfgpack_err_t rc;
     size_t data_cap;
+    size_t applied;
+
+    if (!ctx || !lfs || !path || !scratch) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = split_scratch(lfs, scratch, scratch_cap, &file_cache, &data_buf,
+                       &data_cap);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (data_cap < JOURNAL_HDR_SIZE) {
+        return (CFGPACK_ERR_IO);
+    }
+
+    memset(&file_cfg, 0, sizeof(file_cfg));
+    file_cfg.buffer = file_cache;
+    if (lfs_file_opencfg(lfs, &file, path, LFS_O_RDONLY, &file_cfg) < 0) {
+        return (CFGPACK_ERR_IO);
+    }
+    size = lfs_file_size(lfs, &file);
+    if (size <= 0) {
+        lfs_file_close(lfs, &file);
+        return (size < 0 ? CFGPACK_ERR_IO : CFGPACK_ERR_DECODE);
+    }
+
+    source.lfs = lfs;
+    source.file = &file;
+    source.ctx = ctx;
+    rc = journal_replay(ctx, &source, (size_t)size, data_buf, data_cap,
+                        SIZE_MAX, &applied);
+    if (rc != CFGPACK_OK && applied > 0) {
+        /* A delta failed, perhaps halfway through: replay the good
+         * records again so the context holds exactly their state */
+        rc = journal_replay(ctx, &source, (size_t)size, data_buf, data_cap,
+                            applied, &applied);
+        if (rc == CFGPACK_OK) {
+            rc = CFGPACK_PARTIAL;
+        }
+    }
+
+    lfs_file_close(lfs, &file);
+    return (rc);
+}
+
+static cfgpack_err_t pageout_lfs_ab(cfgpack_ctx_t *ctx,
+                                    lfs_t *lfs,
+                                    const char *path_a,
+                                    const char *path_b,
+                                    uint8_t *scratch,
+                                    size_t scratch_cap) {
+    uint8_t raw[CFGPACK_SLOT_HDR_SIZE];
+    cfgpack_slot_hdr_t hdrs[2];
+    cfgpack_slot_hdr_t hdr;
+    uint8_t *file_cache;
+    uint8_t *chunk_buf;
+    cfgpack_err_t rc;
+    size_t chunk_cap;
     size_t len = 0;
+    int valid[2];
+    int target;
+
+    if (!ctx || !lfs || !path_a || !path_b || !scratch) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = split_scratch(lfs, scratch, scratch_cap, &file_cache, &chunk_buf,
+                       &chunk_cap);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (chunk_cap < CFGPACK_STREAM_CHUNK_MIN) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    rc = cfgpack_pageout_measure(ctx, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    /* Overwrite the older (or invalid) slot */
+    read_slot_hdr(lfs, path_a, file_cache, &hdrs[0], &valid[0]);
+    read_slot_hdr(lfs, path_b, file_cache, &hdrs[1], &valid[1]);
+    if (valid[0] && valid[1]) {
+        /* A newer header over a damaged blob is the slot to replace */
+        int newer = cfgpack_slot_seq_newer(hdrs[1].seq, hdrs[0].seq) ? 1 : 0;
+        if (!slot_file_ok(lfs, newer ? path_b : path_a, file_cache, chunk_buf,
+                          chunk_cap, hdrs[newer].len)) {
+            valid[newer] = 0;
+        }
+    }
+    if (valid[0] && valid[1]) {
+        target = cfgpack_slot_seq_newer(hdrs[0].seq, hdrs[1].seq) ? 1 : 0;
+        hdr.seq = hdrs[target ? 0 : 1].seq + 1u;
+    } else if (valid[0] || valid[1]) {
+        target = valid[0] ? 1 : 0;
+        hdr.seq = hdrs[valid[0] ? 0 : 1].seq + 1u;
+    } else {
+        target = 0;
+        hdr.seq = 1u;
+    }
+    hdr.len = (uint32_t)len;
+    cfgpack_slot_hdr_encode(raw, &hdr);
+
+    return (write_lfs_blob(ctx, lfs, target ? path_b : path_a, file_cache,
+                           chunk_buf, chunk_cap, raw, sizeof(raw)));
+}
+
+static cfgpack_err_t pagein_lfs_ab(cfgpack_ctx_t *ctx,
+                                   lfs_t *lfs,
+                                   const char *path_a,
+                                   const char *path_b,
+                                   uint8_t *scratch,
+                                   size_t scratch_cap) {
+    const char *paths[2];
+    cfgpack_slot_hdr_t hdrs[2];
+    uint8_t *file_cache;
+    uint8_t *data_buf;
+    cfgpack_err_t rc;
+    size_t data_cap;
+    int valid[2];
+    int s;
 
+    if (!ctx || !lfs || !path_a || !path_b || !scratch) {
+        return (CFGPACK_ERR_ARGS);
+    }
     rc = split_scratch(lfs, scratch, scratch_cap, &file_cache, &data_buf,
                        &data_cap);
     if (rc != CFGPACK_OK) {
         return (rc);
     }
 
-    rc = read_lfs_file(lfs, path, file_cache, data_buf, data_cap, &len);
+    paths[0] = path_a;
+    paths[1] = path_b;
+    read_slot_hdr(lfs, path_a, file_cache, &hdrs[0], &valid[0]);
+    read_slot_hdr(lfs, path_b, file_cache, &hdrs[1], &valid[1]);
+
+    rc = CFGPACK_ERR_MISSING;
+    while (valid[0] || valid[1]) {
+        if (valid[0] && valid[1]) {
+            s = cfgpack_slot_seq_newer(hdrs[1].seq, hdrs[0].seq) ? 1 : 0;
+        } else {
+            s = valid[0] ? 0 : 1;
+        }
+        rc = pagein_slot_file(ctx, lfs, paths[s], file_cache, data_buf,
+                              data_cap, hdrs[s].len);
+        if (rc != CFGPACK_ERR_CRC && rc != CFGPACK_ERR_DECODE) {
+            break;
+        }
+        /* Newest copy is damaged: fall back to the other one */
+        valid[s] = 0;
+    }
+    return (rc);
+}
+
+static cfgpack_err_t pageout_lfs_bundle(cfgpack_ctx_t *const *ctxs,
+                                        size_t n,
+                                        lfs_t *lfs,
+                                        const char *path,
+                                        uint8_t *scratch,
+                                        size_t scratch_cap,
+                                        size_t *kept) {
+    uint8_t saved[CFGPACK_BUNDLE_MAX][CFGPACK_DIRTY_SAVE_BYTES];
+    struct lfs_file_config file_cfg;
+    uint8_t *file_cache;
+    uint8_t *data_buf;
+    lfs_file_t file;
+    cfgpack_err_t rc;
+    size_t data_cap;
+    size_t len = 0;
+    lfs_ssize_t size;
+
+    if (!ctxs || !lfs || !path || !scratch || n > CFGPACK_BUNDLE_MAX) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!ctxs[i]) {
+            return (CFGPACK_ERR_ARGS);
+        }
+    }
+    rc = split_scratch(lfs, scratch, scratch_cap, &file_cache, &data_buf,
+                       &data_cap);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    /* The previous bundle supplies the sections that can be kept; a
+     * missing or oversized file just means every section is encoded */
+    memset(&file_cfg, 0, sizeof(file_cfg));
+    file_cfg.buffer = file_cache;
+    if (lfs_file_opencfg(lfs, &file, path, LFS_O_RDONLY, &file_cfg) >= 0) {
+        size = lfs_file_size(lfs, &file);
+        if (size > 0 && (size_t)size <= data_cap &&
+            lfs_file_read(lfs, &file, data_buf, (lfs_size_t)size) == size) {
+            len = (size_t)size;
+        }
+        lfs_file_close(lfs, &file);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        cfgpack_dirty_save(ctxs[i], saved[i]);
+    }
+    rc = cfgpack_bundle_pageout(ctxs, n, data_buf, data_cap, &len, kept);
+    if (rc == CFGPACK_OK) {
+        if (lfs_file_opencfg(lfs, &file, path,
+                             LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC,
+                             &file_cfg) < 0) {
+            rc = CFGPACK_ERR_IO;
+        } else {
+            if (lfs_file_write(lfs, &file, data_buf, (lfs_size_t)len) !=
+                (lfs_ssize_t)len) {
+                rc = CFGPACK_ERR_IO;
+            }
+            if (lfs_file_close(lfs, &file) < 0) {
+                rc = CFGPACK_ERR_IO;
+            }
+        }
+    }
+    if (rc != CFGPACK_OK) {
+        for (size_t i = 0; i < n; ++i) {
+            cfgpack_dirty_restore(ctxs[i], saved[i]);
+        }
+    }
+    return (rc);
+}
+
+static cfgpack_err_t pagein_lfs_bundle(cfgpack_ctx_t *const *ctxs,
+                                       size_t n,
+                                       lfs_t *lfs,
+                                       const char *path,
+                                       uint8_t *scratch,
+                                       size_t scratch_cap) {
+    struct lfs_file_config file_cfg;
+    uint8_t *file_cache;
+    uint8_t *data_buf;
+    lfs_file_t file;
+    cfgpack_err_t rc;
+    size_t data_cap;
+    lfs_ssize_t size;
+    lfs_ssize_t got = -1;
+
+    if (!ctxs || !lfs || !path || !scratch) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = split_scratch(lfs, scratch, scratch_cap, &file_cache, &data_buf,
+                       &data_cap);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    memset(&file_cfg, 0, sizeof(file_cfg));
+    file_cfg.buffer = file_cache;
+    if (lfs_file_opencfg(lfs, &file, path, LFS_O_RDONLY, &file_cfg) < 0) {
+        return (CFGPACK_ERR_IO);
+    }
+    size = lfs_file_size(lfs, &file);
+    if (size >= 0 && (size_t)size > data_cap) {
+        rc = CFGPACK_ERR_BOUNDS;
+    } else if (size >= 0) {
+        got = lfs_file_read(lfs, &file, data_buf, (lfs_size_t)size);
+    }
+    lfs_file_close(lfs, &file);
     if (rc != CFGPACK_OK) {
         return (rc);
     }
+    if (size < 0 || got != size) {
+        return (CFGPACK_ERR_IO);
+    }
+    return (cfgpack_bundle_pagein_all(ctxs, n, data_buf, (size_t)size));
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Public API
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+cfgpack_err_t cfgpack_lfs_meter_init(cfgpack_lfs_meter_t *meter,
+                                     const struct lfs_config *base,
+                                     cfgpack_lfs_clock_fn clock,
+                                     void *clock_user) {
+    if (!meter || !base || !base->read || !base->prog || !base->erase ||
+        !base->sync || base->read == meter_read) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    memset(meter, 0, sizeof(*meter));
+    meter->cfg = *base;
+    meter->cfg.read = meter_read;
+    meter->cfg.prog = meter_prog;
+    meter->cfg.erase = meter_erase;
+    meter->cfg.sync = meter_sync;
+    meter->base = base;
+    meter->clock = clock;
+    meter->clock_user = clock_user;
+    return (CFGPACK_OK);
+}
+
+void cfgpack_lfs_meter_reset(cfgpack_lfs_meter_t *meter) {
+    if (meter) {
+        memset(&meter->total, 0, sizeof(meter->total));
+        memset(&meter->last, 0, sizeof(meter->last));
+    }
+}
+
+cfgpack_err_t cfgpack_pageout_lfs(cfgpack_ctx_t *ctx,
+                                  lfs_t *lfs,
+                                  const char *path,
+                                  uint8_t *scratch,
+                                  size_t scratch_cap) {
+    cfgpack_err_t rc;
+
+    meter_begin(lfs);
+    rc = pageout_lfs(ctx, lfs, path, scratch, scratch_cap);
+    meter_end(lfs);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pagein_lfs(cfgpack_ctx_t *ctx,
+                                 lfs_t *lfs,
+                                 const char *path,
+                                 uint8_t *scratch,
+                                 size_t scratch_cap) {
+    cfgpack_err_t rc;
+
+    meter_begin(lfs);
+    rc = pagein_lfs(ctx, lfs, path, scratch, scratch_cap);
+    meter_end(lfs);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_lfs_journal_compact(cfgpack_ctx_t *ctx,
+                                          lfs_t *lfs,
+                                          const char *path,
+                                          uint8_t *scratch,
+                                          size_t scratch_cap) {
+    cfgpack_err_t rc;
+
+    meter_begin(lfs);
+    rc = journal_compact(ctx, lfs, path, scratch, scratch_cap);
+    meter_end(lfs);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pageout_lfs_journal(cfgpack_ctx_t *ctx,
+                                          lfs_t *lfs,
+                                          const char *path,
+                                          uint8_t *scratch,
+                                          size_t scratch_cap,
+                                          size_t compact_at) {
+    cfgpack_err_t rc;
+
+    meter_begin(lfs);
+    rc = pageout_lfs_journal(ctx, lfs, path, scratch, scratch_cap,
+                             compact_at);
+    meter_end(lfs);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pagein_lfs_journal(cfgpack_ctx_t *ctx,
+                                         lfs_t *lfs,
+                                         const char *path,
+                                         uint8_t *scratch,
+                                         size_t scratch_cap) {
+    cfgpack_err_t rc;
+
+    meter_begin(lfs);
+    rc = pagein_lfs_journal(ctx, lfs, path, scratch, scratch_cap);
+    meter_end(lfs);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pageout_lfs_ab(cfgpack_ctx_t *ctx,
+                                     lfs_t *lfs,
+                                     const char *path_a,
+                                     const char *path_b,
+                                     uint8_t *scratch,
+                                     size_t scratch_cap) {
+    cfgpack_err_t rc;
+
+    meter_begin(lfs);
+    rc = pageout_lfs_ab(ctx, lfs, path_a, path_b, scratch, scratch_cap);
+    meter_end(lfs);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pagein_lfs_ab(cfgpack_ctx_t *ctx,
+                                    lfs_t *lfs,
+                                    const char *path_a,
+                                    const char *path_b,
+                                    uint8_t *scratch,
+                                    size_t scratch_cap) {
+    cfgpack_err_t rc;
+
+    meter_begin(lfs);
+    rc = pagein_lfs_ab(ctx, lfs, path_a, path_b, scratch, scratch_cap);
+    meter_end(lfs);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pageout_lfs_bundle(cfgpack_ctx_t *const *ctxs,
+                                         size_t n,
+                                         lfs_t *lfs,
+                                         const char *path,
+                                         uint8_t *scratch,
+                                         size_t scratch_cap,
+                                         size_t *kept) {
+    cfgpack_err_t rc;
+
+    meter_begin(lfs);
+    rc = pageout_lfs_bundle(ctxs, n, lfs, path, scratch, scratch_cap, kept);
+    meter_end(lfs);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pagein_lfs_bundle(cfgpack_ctx_t *const *ctxs,
+                                        size_t n,
+                                        lfs_t *lfs,
+                                        const char *path,
+                                        uint8_t *scratch,
+                                        size_t scratch_cap) {
+    cfgpack_err_t rc;
 
-    return (cfgpack_pagein_buf(ctx, data_buf, len));
+    meter_begin(lfs);
+    rc = pagein_lfs_bundle(ctxs, n, lfs, path, scratch, scratch_cap);
+    meter_end(lfs);
+    return (rc);
 }
 
 #endif /* CFGPACK_LITTLEFS */
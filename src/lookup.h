@@ -0,0 +1,632 @@
+/**
+ * @file lookup.h
+ * @brief Schema entry lookup and value slot access shared by the runtime,
+ *        pagein decoder and schema writers.
+ */
+#ifndef CFGPACK_LOOKUP_H
+#define CFGPACK_LOOKUP_H
+
+#include "cfgpack/api.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Find a schema entry by index.
+ *
+ * Uses the dense index table when one was installed with
+ * cfgpack_index_table_init(); otherwise binary-searches the sorted entries.
+ *
+ * @param ctx   Initialized context.
+ * @param index Entry index to locate.
+ * @return Pointer to entry or NULL if not found.
+ */
+const cfgpack_entry_t *cfgpack_find_entry(const cfgpack_ctx_t *ctx,
+                                          uint16_t index);
+
+/**
+ * @brief Find a schema entry by name.
+ *
+ * Binary-searches the context's name index when one was installed with
+ * cfgpack_name_index_init(); otherwise scans the entries linearly.
+ *
+ * @param ctx  Initialized context.
+ * @param name Entry name to locate (NUL-terminated).
+ * @return Pointer to entry or NULL if not found.
+ */
+const cfgpack_entry_t *cfgpack_find_entry_by_name(const cfgpack_ctx_t *ctx,
+                                                  const char *name);
+
+/** str_offsets[] value of a copy-on-write slot not yet given pool space. */
+#define CFGPACK_STR_OFFSET_UNSET CFGPACK_STR_OFF_MAX
+
+/**
+ * @brief Bytes a caller reserves for cfgpack_dirty_save().
+ *
+ * A CFGPACK_LARGE_SCHEMA context keeps the saved copy in its own bitmap
+ * storage, so the caller's buffer is not used.
+ */
+#ifdef CFGPACK_LARGE_SCHEMA
+  #define CFGPACK_DIRTY_SAVE_BYTES 1
+#else
+  #define CFGPACK_DIRTY_SAVE_BYTES CFGPACK_PRESENCE_BYTES
+#endif
+
+/**
+ * @brief Save the dirty bitmap so a failed save can restore it.
+ *
+ * @param ctx   Initialized context.
+ * @param saved CFGPACK_DIRTY_SAVE_BYTES bytes of caller storage.
+ */
+static inline void cfgpack_dirty_save(cfgpack_ctx_t *ctx, uint8_t *saved) {
+#ifdef CFGPACK_LARGE_SCHEMA
+    (void)saved;
+    memcpy(ctx->dirty + ctx->bitmap_bytes, ctx->dirty, ctx->bitmap_bytes);
+#else
+    memcpy(saved, ctx->dirty, sizeof(ctx->dirty));
+#endif
+}
+
+/**
+ * @brief Restore the dirty bitmap saved by cfgpack_dirty_save().
+ *
+ * @param ctx   Initialized context.
+ * @param saved Buffer passed to cfgpack_dirty_save().
+ */
+static inline void cfgpack_dirty_restore(cfgpack_ctx_t *ctx,
+                                         const uint8_t *saved) {
+#ifdef CFGPACK_LARGE_SCHEMA
+    (void)saved;
+    memcpy(ctx->dirty, ctx->dirty + ctx->bitmap_bytes, ctx->bitmap_bytes);
+#else
+    memcpy(ctx->dirty, saved, sizeof(ctx->dirty));
+#endif
+}
+
+/**
+ * @brief Open a write section for cfgpack_get_*_consistent() readers.
+ *
+ * Makes the seqlock counter odd before any value, string or bitmap of the
+ * context changes.  A no-op unless built with CFGPACK_SEQLOCK.
+ *
+ * @param ctx Initialized context.
+ */
+static inline void cfgpack_seq_write_begin(cfgpack_ctx_t *ctx) {
+#ifdef CFGPACK_SEQLOCK
+    ctx->seq = ctx->seq + 1u;
+    CFGPACK_SEQLOCK_BARRIER();
+#else
+    (void)ctx;
+#endif
+}
+
+/**
+ * @brief Close the write section opened by cfgpack_seq_write_begin().
+ *
+ * @param ctx Initialized context.
+ */
+static inline void cfgpack_seq_write_end(cfgpack_ctx_t *ctx) {
+#ifdef CFGPACK_SEQLOCK
+    CFGPACK_SEQLOCK_BARRIER();
+    ctx->seq = ctx->seq + 1u;
+#else
+    (void)ctx;
+#endif
+}
+
+/**
+ * @brief Mark entry @p off as changed for the next notification pass.
+ *
+ * A no-op unless cfgpack_notify_init() is attached.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset.
+ */
+static inline void cfgpack_notify_mark(cfgpack_ctx_t *ctx, size_t off) {
+#ifdef CFGPACK_NOTIFY
+    if (ctx->notify_bits) {
+        ctx->notify_bits[off / CHAR_BIT] |= (uint8_t)(1u << (off % CHAR_BIT));
+    }
+#else
+    (void)ctx;
+    (void)off;
+#endif
+}
+
+/**
+ * @brief Mark every present entry as changed (full pagein).
+ *
+ * @param ctx Initialized context.
+ */
+static inline void cfgpack_notify_mark_present(cfgpack_ctx_t *ctx) {
+#ifdef CFGPACK_NOTIFY
+    size_t n = (ctx->schema->entry_count + CHAR_BIT - 1) / CHAR_BIT;
+
+    if (ctx->notify_bits) {
+        for (size_t i = 0; i < n; ++i) {
+            ctx->notify_bits[i] |= ctx->present[i];
+        }
+    }
+#else
+    (void)ctx;
+#endif
+}
+
+/**
+ * @brief Deliver the pending changes to the subscriptions.
+ *
+ * Called by every API write once it completes.  A no-op without
+ * subscriptions, inside a transaction or from a callback (the running
+ * pass delivers those changes), and always unless built with
+ * CFGPACK_NOTIFY.
+ *
+ * @param ctx Initialized context.
+ */
+#ifdef CFGPACK_NOTIFY
+void cfgpack_notify_dispatch(cfgpack_ctx_t *ctx);
+#else
+static inline void cfgpack_notify_dispatch(cfgpack_ctx_t *ctx) {
+    (void)ctx;
+}
+#endif
+
+/**
+ * @brief Pool offset a string entry's next write goes to.
+ *
+ * On a cfgpack_init_cow() context the first write takes the entry's slot
+ * from the unused part of the pool.
+ *
+ * @param ctx      Initialized context.
+ * @param e        String entry of @p ctx's schema.
+ * @param pool_off Receives the slot's offset into ctx->str_pool.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_BOUNDS if the entry has no
+ *         valid slot or the pool is full.
+ */
+cfgpack_err_t cfgpack_str_slot(cfgpack_ctx_t *ctx,
+                               const cfgpack_entry_t *e,
+                               cfgpack_str_off_t *pool_off);
+
+/**
+ * @brief Bytes of a string value, in the pool or the copy-on-write blob.
+ *
+ * @param ctx Initialized context.
+ * @param e   String entry the value belongs to.
+ * @param v   The entry's value.
+ * @return Pointer to the string bytes, or NULL if the value's offset and
+ *         length do not lie inside the buffer it refers to.
+ */
+static inline const char *cfgpack_str_data(const cfgpack_ctx_t *ctx,
+                                           const cfgpack_entry_t *e,
+                                           const cfgpack_value_t *v) {
+    const char *base = ctx->str_pool;
+    size_t cap = ctx->str_pool_cap;
+    size_t off;
+    size_t len;
+
+    if (e->type == CFGPACK_TYPE_STR) {
+        off = v->v.str.offset;
+        len = v->v.str.len;
+    } else {
+        off = v->v.fstr.offset;
+        len = v->v.fstr.len;
+    }
+    if (ctx->cow_base && e->str_slot < ctx->str_offsets_count &&
+        ctx->str_offsets[e->str_slot] == CFGPACK_STR_OFFSET_UNSET) {
+        base = (const char *)ctx->cow_base;
+        cap = ctx->cow_len;
+    }
+    if (off + len > cap) {
+        return (NULL);
+    }
+    return (base + off);
+}
+
+/**
+ * @brief Whether cfgpack_packed_init() moved the values into an arena.
+ *
+ * Always 0 unless built with CFGPACK_PACKED_ARENA.
+ *
+ * @param ctx Initialized context.
+ */
+static inline int cfgpack_is_packed(const cfgpack_ctx_t *ctx) {
+#ifdef CFGPACK_PACKED_ARENA
+    return (ctx->packed != NULL);
+#else
+    (void)ctx;
+    return (0);
+#endif
+}
+
+#ifdef CFGPACK_PACKED_ARENA
+/**
+ * @brief Byte offset of entry @p off's value in a packed arena.
+ */
+static inline size_t cfgpack_packed_offset(const cfgpack_ctx_t *ctx,
+                                           size_t off) {
+    uint16_t pos;
+    memcpy(&pos, ctx->packed + off * sizeof(uint16_t), sizeof(pos));
+    return (pos);
+}
+#endif
+
+/**
+ * @brief Read the value of entry @p off, from its slot or packed arena.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset.
+ * @param out Receives the value (tagged with the schema type when packed).
+ */
+static inline void cfgpack_value_load(const cfgpack_ctx_t *ctx,
+                                      size_t off,
+                                      cfgpack_value_t *out) {
+#ifdef CFGPACK_PACKED_ARENA
+    const cfgpack_entry_t *e;
+    const uint8_t *p;
+
+    if (!ctx->packed) {
+        *out = ctx->values[off];
+        return;
+    }
+    e = &ctx->schema->entries[off];
+    p = ctx->packed + cfgpack_packed_offset(ctx, off);
+    out->type = e->type;
+    switch (e->type) {
+    case CFGPACK_TYPE_U8: out->v.u64 = *p; break;
+    case CFGPACK_TYPE_I8: out->v.i64 = (int8_t)*p; break;
+    case CFGPACK_TYPE_U16: {
+        uint16_t x;
+        memcpy(&x, p, sizeof(x));
+        out->v.u64 = x;
+        break;
+    }
+    case CFGPACK_TYPE_I16: {
+        int16_t x;
+        memcpy(&x, p, sizeof(x));
+        out->v.i64 = x;
+        break;
+    }
+    case CFGPACK_TYPE_U32: {
+        uint32_t x;
+        memcpy(&x, p, sizeof(x));
+        out->v.u64 = x;
+        break;
+    }
+    case CFGPACK_TYPE_I32: {
+        int32_t x;
+        memcpy(&x, p, sizeof(x));
+        out->v.i64 = x;
+        break;
+    }
+    case CFGPACK_TYPE_F32: memcpy(&out->v.f32, p, sizeof(float)); break;
+    case CFGPACK_TYPE_U64:
+    case CFGPACK_TYPE_I64:
+    case CFGPACK_TYPE_F64: memcpy(&out->v.u64, p, sizeof(uint64_t)); break;
+    case CFGPACK_TYPE_STR:
+        memcpy(&out->v.str.len, p, sizeof(uint16_t));
+        out->v.str.offset = ctx->str_offsets[e->str_slot];
+        break;
+    case CFGPACK_TYPE_FSTR:
+        out->v.fstr.len = *p;
+        out->v.fstr.offset = ctx->str_offsets[e->str_slot];
+        out->v.fstr._pad = 0;
+        break;
+    }
+#else
+    *out = ctx->values[off];
+#endif
+}
+
+/**
+ * @brief Write the value of entry @p off, to its slot or packed arena.
+ *
+ * In packed mode the value is truncated to the schema type's width and a
+ * string's pool offset is implied by the entry's str_slot.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset.
+ * @param v   Value to store (type already checked against the schema).
+ */
+static inline void cfgpack_value_store(cfgpack_ctx_t *ctx,
+                                       size_t off,
+                                       const cfgpack_value_t *v) {
+#ifdef CFGPACK_PACKED_ARENA
+    uint8_t *p;
+
+    if (!ctx->packed) {
+        ctx->values[off] = *v;
+        return;
+    }
+    p = ctx->packed + cfgpack_packed_offset(ctx, off);
+    switch (ctx->schema->entries[off].type) {
+    case CFGPACK_TYPE_U8:
+    case CFGPACK_TYPE_I8: *p = (uint8_t)v->v.u64; break;
+    case CFGPACK_TYPE_U16:
+    case CFGPACK_TYPE_I16: {
+        uint16_t x = (uint16_t)v->v.u64;
+        memcpy(p, &x, sizeof(x));
+        break;
+    }
+    case CFGPACK_TYPE_U32:
+    case CFGPACK_TYPE_I32: {
+        uint32_t x = (uint32_t)v->v.u64;
+        memcpy(p, &x, sizeof(x));
+        break;
+    }
+    case CFGPACK_TYPE_F32: memcpy(p, &v->v.f32, sizeof(float)); break;
+    case CFGPACK_TYPE_U64:
+    case CFGPACK_TYPE_I64:
+    case CFGPACK_TYPE_F64: memcpy(p, &v->v.u64, sizeof(uint64_t)); break;
+    case CFGPACK_TYPE_STR: memcpy(p, &v->v.str.len, sizeof(uint16_t)); break;
+    case CFGPACK_TYPE_FSTR: *p = v->v.fstr.len; break;
+    }
+#else
+    ctx->values[off] = *v;
+#endif
+}
+
+/**
+ * @brief Encoded pageout bytes (key + value) of entry @p off's stored value.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset.
+ * @return Bytes cfgpack_pageout() spends on the entry when it is present.
+ */
+size_t cfgpack_entry_enc_size(const cfgpack_ctx_t *ctx, size_t off);
+
+/**
+ * @brief Largest pageout encoding of a value of @p type.
+ *
+ * @param type    Schema type.
+ * @param str_max Effective string limit for str/fstr, else ignored.
+ * @return Upper bound of the value bytes for any stored value.
+ */
+size_t cfgpack_value_enc_max(cfgpack_type_t type, size_t str_max);
+
+/**
+ * @brief Upper bound of a cfgpack_pageout() blob for a schema.
+ *
+ * @param entry_count Schema entries.
+ * @param max_index   Highest schema index (sizes every key).
+ * @param values      Sum of cfgpack_value_enc_max() over the entries.
+ * @return Bound including the map header, the name at key 0 (at its
+ *         longest) and the CRC trailer.
+ */
+size_t cfgpack_blob_enc_max(size_t entry_count,
+                            uint16_t max_index,
+                            size_t values);
+
+/**
+ * @brief Whether cfgpack_size_cache_init() is tracking the pageout size.
+ *
+ * Always 0 unless built with CFGPACK_SIZE_CACHE.
+ *
+ * @param ctx Initialized context.
+ */
+static inline int cfgpack_size_cached(const cfgpack_ctx_t *ctx) {
+#ifdef CFGPACK_SIZE_CACHE
+    return (ctx->size_cached);
+#else
+    (void)ctx;
+    return (0);
+#endif
+}
+
+/**
+ * @brief Count present entry @p off's stored value in the size cache.
+ *
+ * A no-op unless cfgpack_size_cache_init() is tracking.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset.
+ */
+static inline void cfgpack_size_add(cfgpack_ctx_t *ctx, size_t off) {
+#ifdef CFGPACK_SIZE_CACHE
+    if (ctx->size_cached) {
+        ctx->size_bytes += cfgpack_entry_enc_size(ctx, off);
+        ctx->size_count++;
+    }
+#else
+    (void)ctx;
+    (void)off;
+#endif
+}
+
+/**
+ * @brief Take entry @p off's stored value back out of the size cache.
+ *
+ * Call while the value counted by cfgpack_size_add() is still stored.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset.
+ */
+static inline void cfgpack_size_sub(cfgpack_ctx_t *ctx, size_t off) {
+#ifdef CFGPACK_SIZE_CACHE
+    if (ctx->size_cached) {
+        ctx->size_bytes -= cfgpack_entry_enc_size(ctx, off);
+        ctx->size_count--;
+    }
+#else
+    (void)ctx;
+    (void)off;
+#endif
+}
+
+/**
+ * @brief Whether a cfgpack_txn_begin() transaction is open.
+ *
+ * Always 0 unless built with CFGPACK_TXN.
+ *
+ * @param ctx Initialized context.
+ */
+static inline int cfgpack_in_txn(const cfgpack_ctx_t *ctx) {
+#ifdef CFGPACK_TXN
+    return (ctx->txn_buf != NULL);
+#else
+    (void)ctx;
+    return (0);
+#endif
+}
+
+/**
+ * @brief Whether cfgpack_lazy_init() is attached.
+ *
+ * Always 0 unless built with CFGPACK_LAZY.
+ *
+ * @param ctx Initialized context.
+ */
+static inline int cfgpack_is_lazy(const cfgpack_ctx_t *ctx) {
+#ifdef CFGPACK_LAZY
+    return (ctx->lazy_off != NULL);
+#else
+    (void)ctx;
+    return (0);
+#endif
+}
+
+/**
+ * @brief Blob offset of entry @p off's pending value.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset.
+ * @return The offset, or 0 if the entry is not pending from a lazy pagein.
+ */
+static inline uint32_t cfgpack_lazy_pending(const cfgpack_ctx_t *ctx,
+                                            size_t off) {
+#ifdef CFGPACK_LAZY
+    return (ctx->lazy_off ? ctx->lazy_off[off] : 0);
+#else
+    (void)ctx;
+    (void)off;
+    return (0);
+#endif
+}
+
+/**
+ * @brief Record @p pos as entry @p off's pending value offset.
+ *
+ * A no-op unless cfgpack_lazy_init() is attached; 0 marks the entry as
+ * decoded.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset.
+ * @param pos Offset of the value in the lazy blob, or 0.
+ */
+static inline void cfgpack_lazy_mark(cfgpack_ctx_t *ctx,
+                                     size_t off,
+                                     uint32_t pos) {
+#ifdef CFGPACK_LAZY
+    if (ctx->lazy_off) {
+        ctx->lazy_off[off] = pos;
+    }
+#else
+    (void)ctx;
+    (void)off;
+    (void)pos;
+#endif
+}
+
+/**
+ * @brief Drop every pending entry.
+ *
+ * A no-op unless cfgpack_lazy_init() is attached.
+ *
+ * @param ctx Initialized context.
+ */
+static inline void cfgpack_lazy_clear(cfgpack_ctx_t *ctx) {
+#ifdef CFGPACK_LAZY
+    if (ctx->lazy_off) {
+        memset(ctx->lazy_off, 0,
+               ctx->schema->entry_count * sizeof(ctx->lazy_off[0]));
+    }
+#else
+    (void)ctx;
+#endif
+}
+
+/**
+ * @brief Point later pending offsets into @p blob.
+ *
+ * Call only with cfgpack_lazy_init() attached.
+ *
+ * @param ctx  Initialized context.
+ * @param blob Blob being paged in lazily.
+ * @param len  Bytes of @p blob before the trailer.
+ */
+static inline void cfgpack_lazy_source(cfgpack_ctx_t *ctx,
+                                       const uint8_t *blob,
+                                       size_t len) {
+#ifdef CFGPACK_LAZY
+    ctx->lazy_blob = blob;
+    ctx->lazy_len = len;
+#else
+    (void)ctx;
+    (void)blob;
+    (void)len;
+#endif
+}
+
+/**
+ * @brief Store @p v for entry @p off and mark it present.
+ *
+ * Keeps the cached pageout size of cfgpack_size_cache_init() in step.  The
+ * size is taken from the value as stored, since packed storage truncates.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset.
+ * @param v   Value to store (type already checked against the schema).
+ */
+static inline void cfgpack_value_commit(cfgpack_ctx_t *ctx,
+                                        size_t off,
+                                        const cfgpack_value_t *v) {
+    /* A pending lazy entry is present but not yet counted in the size */
+    int counted = cfgpack_presence_get(ctx, off) &&
+                  !cfgpack_lazy_pending(ctx, off);
+
+    cfgpack_lazy_mark(ctx, off, 0);
+    if (counted) {
+        cfgpack_size_sub(ctx, off);
+    }
+    cfgpack_value_store(ctx, off, v);
+    cfgpack_presence_set(ctx, off);
+    cfgpack_size_add(ctx, off);
+}
+
+#ifdef CFGPACK_LAZY
+/**
+ * @brief Decode the pending value of entry @p off from the lazy blob.
+ *
+ * @param ctx Context with a pending entry at @p off.
+ * @param off Zero-based entry offset.
+ * @return CFGPACK_OK, or the error the eager pagein would have returned
+ *         for the value; the entry then stays pending.
+ */
+cfgpack_err_t cfgpack_lazy_resolve(cfgpack_ctx_t *ctx, size_t off);
+#endif
+
+/**
+ * @brief Make entry @p off's stored value current before it is read.
+ *
+ * A no-op unless cfgpack_lazy_init() is attached and the entry is still
+ * pending from a lazy pagein; without CFGPACK_LAZY it always is.  The
+ * pending value is logically part of the context already, so readers
+ * taking a const context may decode it.
+ *
+ * @param ctx Initialized context.
+ * @param off Zero-based entry offset of a present entry.
+ * @return As cfgpack_lazy_resolve().
+ */
+static inline cfgpack_err_t cfgpack_lazy_load(const cfgpack_ctx_t *ctx,
+                                              size_t off) {
+#ifdef CFGPACK_LAZY
+    if (!ctx->lazy_off || !ctx->lazy_off[off]) {
+        return (CFGPACK_OK);
+    }
+    return (cfgpack_lazy_resolve((cfgpack_ctx_t *)ctx, off));
+#else
+    (void)ctx;
+    (void)off;
+    return (CFGPACK_OK);
+#endif
+}
+
+#endif /* CFGPACK_LOOKUP_H */
@@ -1,21 +1,114 @@
 #include "cfgpack/msgpack.h"
 
 #include "cfgpack/config.h"
+#include "cfgpack/value.h"
 
+#include "crc32.h"
+#include "msgpack_fmt.h"
 #include "wbuf.h"
 
 #include <string.h>
 
 void cfgpack_buf_init(cfgpack_buf_t *buf, uint8_t *storage, size_t cap) {
     wbuf_init((wbuf_t *)buf, (char *)storage, cap);
+    buf->crc = 0;
+    buf->crc_on = 0;
+    buf->sink = NULL;
+    buf->sink_user = NULL;
+    buf->flushed = 0;
+    buf->sink_err = CFGPACK_OK;
+}
+
+void cfgpack_buf_init_sink(cfgpack_buf_t *buf,
+                           uint8_t *chunk,
+                           size_t cap,
+                           cfgpack_sink_fn sink,
+                           void *user) {
+    cfgpack_buf_init(buf, chunk, cap);
+    buf->sink = sink;
+    buf->sink_user = user;
+}
+
+/**
+ * @brief Hand @p len bytes to the sink, latching the first failure.
+ */
+static cfgpack_err_t buf_emit(cfgpack_buf_t *buf,
+                              const uint8_t *src,
+                              size_t len) {
+    cfgpack_err_t rc;
+
+    if (len == 0) {
+        return (CFGPACK_OK);
+    }
+    rc = buf->sink(buf->sink_user, src, len);
+    if (rc != CFGPACK_OK) {
+        buf->sink_err = rc;
+        return (rc);
+    }
+    buf->flushed += len;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_buf_flush(cfgpack_buf_t *buf) {
+    cfgpack_err_t rc;
+
+    if (!buf->sink) {
+        return (CFGPACK_OK);
+    }
+    if (buf->sink_err != CFGPACK_OK) {
+        return (buf->sink_err);
+    }
+    rc = buf_emit(buf, buf->data, buf->len);
+    buf->len = 0;
+    return (rc);
+}
+
+/**
+ * @brief Chunked append: copy into the chunk, draining it when full.
+ */
+static cfgpack_err_t buf_append_sink(cfgpack_buf_t *buf,
+                                     const void *src,
+                                     size_t len) {
+    cfgpack_err_t rc;
+
+    if (buf->sink_err != CFGPACK_OK) {
+        return (buf->sink_err);
+    }
+    if (buf->len + len > buf->cap) {
+        rc = cfgpack_buf_flush(buf);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        if (len > buf->cap) {
+            return (buf_emit(buf, (const uint8_t *)src, len));
+        }
+    }
+    memcpy(buf->data + buf->len, src, len);
+    buf->len += len;
+    return (CFGPACK_OK);
 }
 
 cfgpack_err_t cfgpack_buf_append(cfgpack_buf_t *buf,
                                  const void *src,
                                  size_t len) {
+    if (buf->crc_on) {
+        buf->crc = cfgpack_crc32c_update(buf->crc, (const uint8_t *)src, len);
+    }
+    if (buf->sink) {
+        return (buf_append_sink(buf, src, len));
+    }
     return (wbuf_try_append((wbuf_t *)buf, src, len));
 }
 
+void cfgpack_buf_crc_begin(cfgpack_buf_t *buf) {
+    buf->crc = cfgpack_crc32c_init();
+    buf->crc_on = 1;
+}
+
+uint32_t cfgpack_buf_crc(const cfgpack_buf_t *buf) {
+    return (cfgpack_crc32c_final(buf->crc));
+}
+
 cfgpack_err_t cfgpack_msgpack_encode_uint64(cfgpack_buf_t *buf, uint64_t v) {
     uint8_t tmp[9];
     size_t n = 0;
@@ -124,18 +217,65 @@ cfgpack_err_t cfgpack_msgpack_encode_str(cfgpack_buf_t *buf,
 
 cfgpack_err_t cfgpack_msgpack_encode_map_header(cfgpack_buf_t *buf,
                                                 uint32_t count) {
-    uint8_t tmp[3];
+    uint8_t tmp[5];
     size_t n = 0;
     if (count <= 15) {
         tmp[n++] = (uint8_t)(0x80 | count);
-    } else {
+    } else if (count <= 0xffffu) {
         tmp[n++] = 0xde;
         tmp[n++] = (uint8_t)(count >> 8);
         tmp[n++] = (uint8_t)count;
+    } else {
+        tmp[n++] = 0xdf;
+        tmp[n++] = (uint8_t)(count >> 24);
+        tmp[n++] = (uint8_t)(count >> 16);
+        tmp[n++] = (uint8_t)(count >> 8);
+        tmp[n++] = (uint8_t)count;
     }
     return (cfgpack_buf_append(buf, tmp, n));
 }
 
+cfgpack_err_t cfgpack_msgpack_encode_array_header(cfgpack_buf_t *buf,
+                                                  uint32_t count) {
+    uint8_t tmp[5];
+    size_t n = 0;
+    if (count <= 15) {
+        tmp[n++] = (uint8_t)(0x90 | count);
+    } else if (count <= 0xffffu) {
+        tmp[n++] = 0xdc;
+        tmp[n++] = (uint8_t)(count >> 8);
+        tmp[n++] = (uint8_t)count;
+    } else {
+        tmp[n++] = 0xdd;
+        tmp[n++] = (uint8_t)(count >> 24);
+        tmp[n++] = (uint8_t)(count >> 16);
+        tmp[n++] = (uint8_t)(count >> 8);
+        tmp[n++] = (uint8_t)count;
+    }
+    return (cfgpack_buf_append(buf, tmp, n));
+}
+
+cfgpack_err_t cfgpack_msgpack_encode_bin(cfgpack_buf_t *buf,
+                                         const void *data,
+                                         size_t len) {
+    size_t hlen = 0;
+    cfgpack_err_t rc;
+    uint8_t hdr[3];
+    if (len <= 255) {
+        hdr[hlen++] = 0xc4;
+        hdr[hlen++] = (uint8_t)len;
+    } else {
+        hdr[hlen++] = 0xc5;
+        hdr[hlen++] = (uint8_t)(len >> 8);
+        hdr[hlen++] = (uint8_t)len;
+    }
+    rc = cfgpack_buf_append(buf, hdr, hlen);
+    if (cfgpack_buf_append(buf, data, len) != CFGPACK_OK) {
+        rc = CFGPACK_ERR_ENCODE;
+    }
+    return (rc);
+}
+
 cfgpack_err_t cfgpack_msgpack_encode_uint_key(cfgpack_buf_t *buf, uint64_t v) {
     return (cfgpack_msgpack_encode_uint64(buf, v));
 }
@@ -150,192 +290,359 @@ void cfgpack_reader_init(cfgpack_reader_t *r, const uint8_t *data, size_t len) {
     r->data = data;
     r->len = len;
     r->pos = 0;
+    r->crc = 0;
+    r->crc_pos = 0;
+    r->crc_on = 0;
+    r->src = NULL;
+    r->src_user = NULL;
+    r->win = NULL;
+    r->win_cap = 0;
+    r->base = 0;
+    r->limit = len;
+    r->src_err = CFGPACK_OK;
+}
+
+void cfgpack_reader_init_source(cfgpack_reader_t *r,
+                                uint8_t *window,
+                                size_t cap,
+                                cfgpack_source_fn src,
+                                void *user,
+                                size_t limit) {
+    cfgpack_reader_init(r, window, 0);
+    r->src = src;
+    r->src_user = user;
+    r->win = window;
+    r->win_cap = cap;
+    r->limit = limit;
+}
+
+void cfgpack_reader_crc_begin(cfgpack_reader_t *r) {
+    r->crc = cfgpack_crc32c_init();
+    r->crc_pos = r->pos;
+    r->crc_on = 1;
 }
 
 /**
- * @brief Read bytes from a msgpack reader.
- * @param r    Reader state.
- * @param dst  Destination buffer.
- * @param n    Number of bytes to read.
- * @return 0 on success, -1 if insufficient data.
+ * @brief Fold consumed-but-unchecksummed bytes into the reader CRC.
  */
-static int read_bytes(cfgpack_reader_t *r, void *dst, size_t n) {
-    if (r->pos + n > r->len) {
+static void reader_crc_sync(cfgpack_reader_t *r) {
+    if (r->crc_on && r->pos > r->crc_pos) {
+        r->crc = cfgpack_crc32c_update(r->crc, r->data + r->crc_pos,
+                                       r->pos - r->crc_pos);
+        r->crc_pos = r->pos;
+    }
+}
+
+uint32_t cfgpack_reader_crc(cfgpack_reader_t *r) {
+    reader_crc_sync(r);
+    return (cfgpack_crc32c_final(r->crc));
+}
+
+/**
+ * @brief Slide the window and pull from the source until @p n bytes are
+ *        available at @c pos.
+ * @return 0 on success, -1 if the source is exhausted, fails, or @p n
+ *         exceeds the window.
+ */
+static int reader_refill(cfgpack_reader_t *r, size_t n) {
+    size_t keep;
+
+    if (!r->src || n > r->win_cap || r->src_err != CFGPACK_OK) {
         return (-1);
     }
-    memcpy(dst, r->data + r->pos, n);
-    r->pos += n;
+
+    /* Consumed bytes are about to be discarded */
+    reader_crc_sync(r);
+    keep = r->len - r->pos;
+    memmove(r->win, r->win + r->pos, keep);
+    r->base += r->pos;
+    r->pos = 0;
+    r->crc_pos = 0;
+    r->len = keep;
+
+    while (r->len < n) {
+        size_t avail = r->limit - (r->base + r->len);
+        size_t want = r->win_cap - r->len;
+        size_t got = 0;
+        cfgpack_err_t rc;
+
+        if (avail == 0) {
+            return (-1);
+        }
+        if (want > avail) {
+            want = avail;
+        }
+        rc = r->src(r->src_user, r->base + r->len, r->win + r->len, want,
+                    &got);
+        if (rc != CFGPACK_OK) {
+            r->src_err = rc;
+            return (-1);
+        }
+        if (got == 0 || got > want) {
+            return (-1);
+        }
+        r->len += got;
+    }
     return (0);
 }
 
-cfgpack_err_t cfgpack_msgpack_decode_map_header(cfgpack_reader_t *r,
-                                                uint32_t *count) {
-    uint8_t b;
-    if (read_bytes(r, &b, 1)) {
-        return (CFGPACK_ERR_DECODE);
-    }
-    if ((b & 0xf0u) == 0x80u) {
-        *count = (uint32_t)(b & 0x0f);
-        return (CFGPACK_OK);
+/**
+ * @brief Ensure @p n bytes are available at data[pos].
+ * @return 0 on success, -1 if insufficient data.
+ */
+static int reader_need(cfgpack_reader_t *r, size_t n) {
+    if (r->pos + n <= r->len) {
+        return (0);
     }
-    if (b == 0xde) {
-        uint8_t bytes[2];
-        if (read_bytes(r, bytes, 2)) {
-            return (CFGPACK_ERR_DECODE);
+    return (reader_refill(r, n));
+}
+
+/**
+ * @brief Advance past @p n bytes, which may span several windows.
+ * @return 0 on success, -1 if insufficient data.
+ */
+static int reader_skip(cfgpack_reader_t *r, size_t n) {
+    while (r->pos + n > r->len) {
+        if (!r->src) {
+            return (-1);
+        }
+        n -= r->len - r->pos;
+        r->pos = r->len;
+        if (reader_refill(r, 1)) {
+            return (-1);
         }
-        *count = ((uint32_t)bytes[0] << 8) | bytes[1];
-        return (CFGPACK_OK);
     }
-    return (CFGPACK_ERR_DECODE);
+    r->pos += n;
+    return (0);
 }
 
-cfgpack_err_t cfgpack_msgpack_decode_uint64(cfgpack_reader_t *r,
-                                            uint64_t *out) {
-    uint8_t b;
-    if (read_bytes(r, &b, 1)) {
+cfgpack_err_t cfgpack_reader_peek(cfgpack_reader_t *r, uint8_t *out) {
+    if (reader_need(r, 1)) {
         return (CFGPACK_ERR_DECODE);
     }
-    if (b <= 0x7f) {
+    *out = r->data[r->pos];
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Format table
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/* clang-format off */
+#define F1(...)  {__VA_ARGS__}
+#define F4(...)  F1(__VA_ARGS__), F1(__VA_ARGS__), F1(__VA_ARGS__), \
+                 F1(__VA_ARGS__)
+#define F16(...) F4(__VA_ARGS__), F4(__VA_ARGS__), F4(__VA_ARGS__), \
+                 F4(__VA_ARGS__)
+#define F32(...) F16(__VA_ARGS__), F16(__VA_ARGS__)
+
+#define K(k)  MP_KIND_##k
+#define T(t)  CFGPACK_TYPE_##t
+#define L(l)  MP_LEN_##l
+#define NO_T  MP_TYPE_NONE
+
+const cfgpack_mp_fmt_t cfgpack_mp_fmt[256] = {
+    /* 0x00-0x7f positive fixint */
+    F32(K(UINT), T(U8), 0, L(NONE)), F32(K(UINT), T(U8), 0, L(NONE)),
+    F32(K(UINT), T(U8), 0, L(NONE)), F32(K(UINT), T(U8), 0, L(NONE)),
+    /* 0x80-0x8f fixmap, 0x90-0x9f fixarray, 0xa0-0xbf fixstr */
+    F16(K(MAP),   NO_T,   0, L(FIX4)),
+    F16(K(ARRAY), NO_T,   0, L(FIX4)),
+    F32(K(STR),   T(STR), 0, L(FIX5)),
+    /* 0xc0 nil, 0xc1 never used, 0xc2 false, 0xc3 true */
+    F1(K(NIL),     NO_T, 0, L(NONE)),
+    F1(K(INVALID), NO_T, 0, L(NONE)),
+    F1(K(BOOL),    NO_T, 0, L(NONE)),
+    F1(K(BOOL),    NO_T, 0, L(NONE)),
+    /* 0xc4-0xc6 bin 8/16/32 */
+    F1(K(BIN), NO_T, 1, L(HDR)),
+    F1(K(BIN), NO_T, 2, L(HDR)),
+    F1(K(BIN), NO_T, 4, L(HDR)),
+    /* 0xc7-0xc9 ext 8/16/32 (unsupported) */
+    F1(K(INVALID), NO_T, 0, L(NONE)),
+    F1(K(INVALID), NO_T, 0, L(NONE)),
+    F1(K(INVALID), NO_T, 0, L(NONE)),
+    /* 0xca float 32, 0xcb float 64 */
+    F1(K(FLOAT), T(F32), 4, L(NONE)),
+    F1(K(FLOAT), T(F64), 8, L(NONE)),
+    /* 0xcc-0xcf uint 8/16/32/64 */
+    F1(K(UINT), T(U8),  1, L(NONE)),
+    F1(K(UINT), T(U16), 2, L(NONE)),
+    F1(K(UINT), T(U32), 4, L(NONE)),
+    F1(K(UINT), T(U64), 8, L(NONE)),
+    /* 0xd0-0xd3 int 8/16/32/64 */
+    F1(K(INT), T(I8),  1, L(NONE)),
+    F1(K(INT), T(I16), 2, L(NONE)),
+    F1(K(INT), T(I32), 4, L(NONE)),
+    F1(K(INT), T(I64), 8, L(NONE)),
+    /* 0xd4-0xd8 fixext 1/2/4/8/16 (unsupported) */
+    F4(K(INVALID), NO_T, 0, L(NONE)),
+    F1(K(INVALID), NO_T, 0, L(NONE)),
+    /* 0xd9-0xdb str 8/16/32 */
+    F1(K(STR), T(STR), 1, L(HDR)),
+    F1(K(STR), T(STR), 2, L(HDR)),
+    F1(K(STR), T(STR), 4, L(HDR)),
+    /* 0xdc-0xdd array 16/32, 0xde-0xdf map 16/32 */
+    F1(K(ARRAY), NO_T, 2, L(HDR)),
+    F1(K(ARRAY), NO_T, 4, L(HDR)),
+    F1(K(MAP),   NO_T, 2, L(HDR)),
+    F1(K(MAP),   NO_T, 4, L(HDR)),
+    /* 0xe0-0xff negative fixint */
+    F32(K(INT), T(I8), 0, L(NONE)),
+};
+
+#undef NO_T
+#undef L
+#undef T
+#undef K
+#undef F32
+#undef F16
+#undef F4
+#undef F1
+/* clang-format on */
+
+/**
+ * @brief Consume a format byte and look up its table entry.
+ * @return 0 on success, -1 if no data or the format is unsupported.
+ */
+static int read_fmt(cfgpack_reader_t *r,
+                    uint8_t *b,
+                    const cfgpack_mp_fmt_t **fmt) {
+    if (reader_need(r, 1)) {
+        return (-1);
+    }
+    *b = r->data[r->pos++];
+    *fmt = &cfgpack_mp_fmt[*b];
+    return ((*fmt)->kind == MP_KIND_INVALID ? -1 : 0);
+}
+
+/**
+ * @brief Consume the header bytes of format @p b as a big-endian value.
+ *
+ * Fix formats yield the length or count packed into @p b; header-less
+ * scalars (fixints, nil, bool) yield @p b itself.
+ *
+ * @return 0 on success, -1 if the header is truncated.
+ */
+static int read_arg(cfgpack_reader_t *r,
+                    uint8_t b,
+                    const cfgpack_mp_fmt_t *fmt,
+                    uint64_t *out) {
+    uint64_t v = 0;
+
+    if (fmt->len == MP_LEN_FIX4) {
+        *out = b & 0x0fu;
+        return (0);
+    }
+    if (fmt->len == MP_LEN_FIX5) {
+        *out = b & 0x1fu;
+        return (0);
+    }
+    if (fmt->hdr == 0) {
         *out = b;
-        return (CFGPACK_OK);
+        return (0);
     }
-    if (b == 0xcc) {
-        uint8_t v;
-        if (read_bytes(r, &v, 1)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        *out = v;
-        return (CFGPACK_OK);
+    if (reader_need(r, fmt->hdr)) {
+        return (-1);
     }
-    if (b == 0xcd) {
-        uint8_t v[2];
-        if (read_bytes(r, v, 2)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        *out = ((uint16_t)v[0] << 8) | v[1];
-        return (CFGPACK_OK);
+    for (uint8_t i = 0; i < fmt->hdr; ++i) {
+        v = (v << 8) | r->data[r->pos + i];
     }
-    if (b == 0xce) {
-        uint8_t v[4];
-        if (read_bytes(r, v, 4)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        *out = ((uint32_t)v[0] << 24) | ((uint32_t)v[1] << 16) |
-               ((uint32_t)v[2] << 8) | v[3];
-        return (CFGPACK_OK);
+    r->pos += fmt->hdr;
+    *out = v;
+    return (0);
+}
+
+cfgpack_err_t cfgpack_msgpack_decode_map_header(cfgpack_reader_t *r,
+                                                uint32_t *count) {
+    const cfgpack_mp_fmt_t *fmt;
+    uint64_t v;
+    uint8_t b;
+
+    if (read_fmt(r, &b, &fmt) || fmt->kind != MP_KIND_MAP ||
+        read_arg(r, b, fmt, &v)) {
+        return (CFGPACK_ERR_DECODE);
     }
-    if (b == 0xcf) {
-        uint64_t res = 0;
-        uint8_t v[8];
+    *count = (uint32_t)v;
+    return (CFGPACK_OK);
+}
 
-        if (read_bytes(r, v, 8)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        for (int i = 0; i < 8; ++i) {
-            res = (res << 8) | v[i];
-        }
-        *out = res;
-        return (CFGPACK_OK);
+cfgpack_err_t cfgpack_msgpack_decode_array_header(cfgpack_reader_t *r,
+                                                  uint32_t *count) {
+    const cfgpack_mp_fmt_t *fmt;
+    uint64_t v;
+    uint8_t b;
+
+    if (read_fmt(r, &b, &fmt) || fmt->kind != MP_KIND_ARRAY ||
+        read_arg(r, b, fmt, &v)) {
+        return (CFGPACK_ERR_DECODE);
     }
-    return (CFGPACK_ERR_DECODE);
+    *count = (uint32_t)v;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_msgpack_decode_uint64(cfgpack_reader_t *r,
+                                            uint64_t *out) {
+    const cfgpack_mp_fmt_t *fmt;
+    uint8_t b;
+
+    if (read_fmt(r, &b, &fmt) || fmt->kind != MP_KIND_UINT ||
+        read_arg(r, b, fmt, out)) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    return (CFGPACK_OK);
 }
 
 cfgpack_err_t cfgpack_msgpack_decode_int64(cfgpack_reader_t *r, int64_t *out) {
+    const cfgpack_mp_fmt_t *fmt;
+    uint64_t v;
     uint8_t b;
-    if (read_bytes(r, &b, 1)) {
+
+    if (read_fmt(r, &b, &fmt)) {
         return (CFGPACK_ERR_DECODE);
     }
-    if (b <= 0x7f) {
+    /* Positive fixint is the only unsigned format accepted */
+    if (fmt->kind == MP_KIND_UINT && fmt->hdr == 0) {
         *out = (int64_t)b;
         return (CFGPACK_OK);
     }
-    if (b >= 0xe0) {
-        *out = (int8_t)b;
-        return (CFGPACK_OK);
-    }
-    if (b == 0xd0) {
-        int8_t v;
-        if (read_bytes(r, &v, 1)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        *out = v;
-        return (CFGPACK_OK);
-    }
-    if (b == 0xd1) {
-        int16_t v;
-        if (read_bytes(r, &v, 2)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        v = (int16_t)((uint16_t)(uint8_t)(v >> 8) |
-                      ((uint16_t)(uint8_t)v << 8));
-        *out = v;
-        return (CFGPACK_OK);
-    }
-    if (b == 0xd2) {
-        uint8_t v[4];
-        int32_t res;
-
-        if (read_bytes(r, v, 4)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        res = (int32_t)((uint32_t)v[0] << 24 | (uint32_t)v[1] << 16 |
-                        (uint32_t)v[2] << 8 | v[3]);
-        *out = res;
-        return (CFGPACK_OK);
+    if (fmt->kind != MP_KIND_INT || read_arg(r, b, fmt, &v)) {
+        return (CFGPACK_ERR_DECODE);
     }
-    if (b == 0xd3) {
-        int64_t res = 0;
-        uint8_t v[8];
-
-        if (read_bytes(r, v, 8)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        for (int i = 0; i < 8; ++i) {
-            res = (res << 8) | v[i];
-        }
-        *out = res;
-        return (CFGPACK_OK);
+    switch (fmt->hdr) {
+    case 0:
+    case 1: *out = (int8_t)v; break;
+    case 2: *out = (int16_t)v; break;
+    case 4: *out = (int32_t)v; break;
+    default: *out = (int64_t)v; break;
     }
-    return (CFGPACK_ERR_DECODE);
+    return (CFGPACK_OK);
 }
 
 cfgpack_err_t cfgpack_msgpack_decode_f32(cfgpack_reader_t *r, float *out) {
-    uint8_t v[4];
+    const cfgpack_mp_fmt_t *fmt;
+    uint64_t v;
     uint32_t u;
     uint8_t b;
 
-    if (read_bytes(r, &b, 1)) {
-        return (CFGPACK_ERR_DECODE);
-    }
-    if (b != 0xca) {
+    if (read_fmt(r, &b, &fmt) || fmt->type != CFGPACK_TYPE_F32 ||
+        read_arg(r, b, fmt, &v)) {
         return (CFGPACK_ERR_DECODE);
     }
-    if (read_bytes(r, v, 4)) {
-        return (CFGPACK_ERR_DECODE);
-    }
-    u = ((uint32_t)v[0] << 24) | ((uint32_t)v[1] << 16) |
-        ((uint32_t)v[2] << 8) | v[3];
+    u = (uint32_t)v;
     memcpy(out, &u, sizeof(u));
     return (CFGPACK_OK);
 }
 
 cfgpack_err_t cfgpack_msgpack_decode_f64(cfgpack_reader_t *r, double *out) {
-    uint64_t u = 0;
-    uint8_t v[8];
+    const cfgpack_mp_fmt_t *fmt;
+    uint64_t u;
     uint8_t b;
 
-    if (read_bytes(r, &b, 1)) {
-        return (CFGPACK_ERR_DECODE);
-    }
-    if (b != 0xcb) {
+    if (read_fmt(r, &b, &fmt) || fmt->type != CFGPACK_TYPE_F64 ||
+        read_arg(r, b, fmt, &u)) {
         return (CFGPACK_ERR_DECODE);
     }
-    if (read_bytes(r, v, 8)) {
-        return (CFGPACK_ERR_DECODE);
-    }
-    for (int i = 0; i < 8; ++i) {
-        u = (u << 8) | v[i];
-    }
     memcpy(out, &u, sizeof(u));
     return (CFGPACK_OK);
 }
@@ -343,28 +650,36 @@ cfgpack_err_t cfgpack_msgpack_decode_f64(cfgpack_reader_t *r, double *out) {
 cfgpack_err_t cfgpack_msgpack_decode_str(cfgpack_reader_t *r,
                                          const uint8_t **ptr,
                                          uint32_t *len) {
+    const cfgpack_mp_fmt_t *fmt;
+    uint64_t v;
     uint8_t b;
-    if (read_bytes(r, &b, 1)) {
+
+    if (read_fmt(r, &b, &fmt) || fmt->kind != MP_KIND_STR ||
+        read_arg(r, b, fmt, &v)) {
         return (CFGPACK_ERR_DECODE);
     }
-    if ((b & 0xe0u) == 0xa0u) {
-        *len = (uint32_t)(b & 0x1f);
-    } else if (b == 0xd9) {
-        uint8_t l;
-        if (read_bytes(r, &l, 1)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        *len = l;
-    } else if (b == 0xda) {
-        uint8_t v[2];
-        if (read_bytes(r, v, 2)) {
-            return (CFGPACK_ERR_DECODE);
-        }
-        *len = ((uint32_t)v[0] << 8) | v[1];
-    } else {
+    *len = (uint32_t)v;
+    if (reader_need(r, *len)) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    *ptr = r->data + r->pos;
+    r->pos += *len;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_msgpack_decode_bin(cfgpack_reader_t *r,
+                                         const uint8_t **ptr,
+                                         uint32_t *len) {
+    const cfgpack_mp_fmt_t *fmt;
+    uint64_t v;
+    uint8_t b;
+
+    if (read_fmt(r, &b, &fmt) || fmt->kind != MP_KIND_BIN ||
+        read_arg(r, b, fmt, &v)) {
         return (CFGPACK_ERR_DECODE);
     }
-    if (r->pos + *len > r->len) {
+    *len = (uint32_t)v;
+    if (reader_need(r, *len)) {
         return (CFGPACK_ERR_DECODE);
     }
     *ptr = r->data + r->pos;
@@ -382,6 +697,10 @@ cfgpack_err_t cfgpack_msgpack_skip_value(cfgpack_reader_t *r) {
      * scalar is consumed, the top counter is decremented until the container
      * is fully skipped.
      *
+     * The format table gives every value's header size, so scalars are
+     * consumed by read_arg() alone; only strings, binaries and containers
+     * need the decoded length or count.
+     *
      * Stack budget: CFGPACK_SKIP_MAX_DEPTH * sizeof(uint32_t) bytes.
      * Default 32 levels = 128 bytes, which is safe for embedded targets.
      */
@@ -390,244 +709,36 @@ cfgpack_err_t cfgpack_msgpack_skip_value(cfgpack_reader_t *r) {
     remaining[0] = 1; /* skip exactly one top-level value */
 
     do {
+        const cfgpack_mp_fmt_t *fmt;
+        uint64_t arg;
         uint8_t b;
 
-        if (r->pos >= r->len) {
+        if (read_fmt(r, &b, &fmt) || read_arg(r, b, fmt, &arg)) {
             return (CFGPACK_ERR_DECODE);
         }
-        b = r->data[r->pos++];
-
-        /* Positive fixint (0x00-0x7f) and negative fixint (0xe0-0xff) */
-        if (b <= 0x7f || b >= 0xe0) {
-            goto value_done;
-        }
-
-        /* Fixstr (0xa0-0xbf): length in low 5 bits */
-        if ((b & 0xe0) == 0xa0) {
-            uint32_t len = b & 0x1f;
-            if (r->pos + len > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            r->pos += len;
-            goto value_done;
-        }
-
-        /* Fixmap (0x80-0x8f): count in low 4 bits, each entry = 2 values */
-        if ((b & 0xf0) == 0x80) {
-            uint32_t count = (uint32_t)(b & 0x0f) * 2;
-            if (count == 0) {
-                goto value_done;
-            }
-            if (depth + 1 >= CFGPACK_SKIP_MAX_DEPTH) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            remaining[depth + 1] = count;
-            depth++;
-            continue;
-        }
-
-        /* Fixarray (0x90-0x9f): count in low 4 bits */
-        if ((b & 0xf0) == 0x90) {
-            uint32_t count = b & 0x0f;
-            if (count == 0) {
-                goto value_done;
-            }
-            if (depth + 1 >= CFGPACK_SKIP_MAX_DEPTH) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            remaining[depth + 1] = count;
-            depth++;
-            continue;
-        }
-
-        /* Handle other types by format byte */
-        switch (b) {
-        /* nil, false, true */
-        case 0xc0:
-        case 0xc2:
-        case 0xc3: goto value_done;
-
-        /* bin 8, str 8 */
-        case 0xc4:
-        case 0xd9: {
-            uint8_t len;
-
-            if (r->pos >= r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            len = r->data[r->pos++];
-            if (r->pos + len > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            r->pos += len;
-            goto value_done;
-        }
-
-        /* bin 16, str 16 */
-        case 0xc5:
-        case 0xda: {
-            uint32_t len;
-
-            if (r->pos + 2 > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            len = ((uint32_t)r->data[r->pos] << 8) | r->data[r->pos + 1];
-            r->pos += 2;
-            if (r->pos + len > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            r->pos += len;
-            goto value_done;
-        }
-
-        /* bin 32, str 32 */
-        case 0xc6:
-        case 0xdb: {
-            uint32_t len;
-
-            if (r->pos + 4 > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            len = ((uint32_t)r->data[r->pos] << 24) |
-                  ((uint32_t)r->data[r->pos + 1] << 16) |
-                  ((uint32_t)r->data[r->pos + 2] << 8) | r->data[r->pos + 3];
-            r->pos += 4;
-            if (r->pos + len > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            r->pos += len;
-            goto value_done;
-        }
-
-        /* float 32, uint 32, int 32 */
-        case 0xca:
-        case 0xce:
-        case 0xd2:
-            if (r->pos + 4 > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            r->pos += 4;
-            goto value_done;
-
-        /* float 64, uint 64, int 64 */
-        case 0xcb:
-        case 0xcf:
-        case 0xd3:
-            if (r->pos + 8 > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            r->pos += 8;
-            goto value_done;
-
-        /* uint 8, int 8 */
-        case 0xcc:
-        case 0xd0:
-            if (r->pos + 1 > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            r->pos += 1;
-            goto value_done;
-
-        /* uint 16, int 16 */
-        case 0xcd:
-        case 0xd1:
-            if (r->pos + 2 > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            r->pos += 2;
-            goto value_done;
-
-        /* array 16 */
-        case 0xdc: {
-            uint32_t count;
-
-            if (r->pos + 2 > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            count = ((uint32_t)r->data[r->pos] << 8) | r->data[r->pos + 1];
-            r->pos += 2;
-            if (count == 0) {
-                goto value_done;
-            }
-            if (depth + 1 >= CFGPACK_SKIP_MAX_DEPTH) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            remaining[depth + 1] = count;
-            depth++;
-            continue;
-        }
 
-        /* array 32 */
-        case 0xdd: {
-            uint32_t count;
-
-            if (r->pos + 4 > r->len) {
+        if (fmt->kind == MP_KIND_STR || fmt->kind == MP_KIND_BIN) {
+            if (reader_skip(r, (size_t)arg)) {
                 return (CFGPACK_ERR_DECODE);
             }
-            count = ((uint32_t)r->data[r->pos] << 24) |
-                    ((uint32_t)r->data[r->pos + 1] << 16) |
-                    ((uint32_t)r->data[r->pos + 2] << 8) | r->data[r->pos + 3];
-            r->pos += 4;
-            if (count == 0) {
-                goto value_done;
+        } else if (fmt->kind == MP_KIND_ARRAY || fmt->kind == MP_KIND_MAP) {
+            /* Each map entry is a key and a value */
+            if (fmt->kind == MP_KIND_MAP) {
+                if (arg > UINT32_MAX / 2) {
+                    return (CFGPACK_ERR_DECODE);
+                }
+                arg *= 2;
             }
-            if (depth + 1 >= CFGPACK_SKIP_MAX_DEPTH) {
-                return (CFGPACK_ERR_DECODE);
+            if (arg > 0) {
+                if (depth + 1 >= CFGPACK_SKIP_MAX_DEPTH) {
+                    return (CFGPACK_ERR_DECODE);
+                }
+                remaining[depth + 1] = (uint32_t)arg;
+                depth++;
+                continue;
             }
-            remaining[depth + 1] = count;
-            depth++;
-            continue;
-        }
-
-        /* map 16 */
-        case 0xde: {
-            uint32_t count;
-
-            if (r->pos + 2 > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            count = ((uint32_t)r->data[r->pos] << 8) | r->data[r->pos + 1];
-            r->pos += 2;
-            if (count == 0) {
-                goto value_done;
-            }
-            if (depth + 1 >= CFGPACK_SKIP_MAX_DEPTH) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            remaining[depth + 1] = count * 2;
-            depth++;
-            continue;
-        }
-
-        /* map 32 */
-        case 0xdf: {
-            uint32_t count;
-
-            if (r->pos + 4 > r->len) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            count = ((uint32_t)r->data[r->pos] << 24) |
-                    ((uint32_t)r->data[r->pos + 1] << 16) |
-                    ((uint32_t)r->data[r->pos + 2] << 8) | r->data[r->pos + 3];
-            r->pos += 4;
-            if (count == 0) {
-                goto value_done;
-            }
-            if (count > UINT32_MAX / 2) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            if (depth + 1 >= CFGPACK_SKIP_MAX_DEPTH) {
-                return (CFGPACK_ERR_DECODE);
-            }
-            remaining[depth + 1] = count * 2;
-            depth++;
-            continue;
-        }
-
-        default: return CFGPACK_ERR_DECODE;
         }
 
-    value_done:
         /* Decrement the current container's remaining count and unwind. */
         while (remaining[depth] > 0) {
             remaining[depth]--;
@@ -0,0 +1,56 @@
+/**
+ * @file msgpack_fmt.h
+ * @brief MessagePack format-byte classification shared by the decoders,
+ *        the value skipper and the pagein type coercion.
+ */
+#ifndef CFGPACK_MSGPACK_FMT_H
+#define CFGPACK_MSGPACK_FMT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Value family of a msgpack format byte.
+ */
+enum {
+    MP_KIND_INVALID = 0, /**< Reserved (0xc1) or unsupported (ext) */
+    MP_KIND_NIL,
+    MP_KIND_BOOL,
+    MP_KIND_UINT, /**< Positive fixint, uint 8-64 */
+    MP_KIND_INT,  /**< Negative fixint, int 8-64 */
+    MP_KIND_FLOAT,
+    MP_KIND_STR,
+    MP_KIND_BIN,
+    MP_KIND_ARRAY,
+    MP_KIND_MAP,
+};
+
+/**
+ * @brief Where the payload length (or element count) of a format comes from.
+ */
+enum {
+    MP_LEN_NONE = 0, /**< No payload past the header bytes */
+    MP_LEN_FIX4,     /**< Low 4 bits of the format byte (fixmap, fixarray) */
+    MP_LEN_FIX5,     /**< Low 5 bits of the format byte (fixstr) */
+    MP_LEN_HDR,      /**< Big-endian value of the header bytes */
+};
+
+/** Wire type of formats that do not carry a cfgpack scalar. */
+#define MP_TYPE_NONE 0xffu
+
+/**
+ * @brief Static description of one msgpack format byte.
+ */
+typedef struct {
+    uint8_t kind; /**< MP_KIND_* */
+    uint8_t type; /**< Smallest cfgpack_type_t holding the value, or
+                       MP_TYPE_NONE */
+    uint8_t hdr;  /**< Bytes following the format byte before any payload */
+    uint8_t len;  /**< MP_LEN_* */
+} cfgpack_mp_fmt_t;
+
+/**
+ * @brief Format table indexed by the format byte (defined in msgpack.c).
+ */
+extern const cfgpack_mp_fmt_t cfgpack_mp_fmt[256];
+
+#endif /* CFGPACK_MSGPACK_FMT_H */
@@ -0,0 +1,148 @@
+/**
+ * @file msgpack_raw.h
+ * @brief Unchecked MessagePack writers over a raw output cursor.
+ *
+ * Same encodings as the cfgpack_msgpack_encode_*() functions, but each
+ * writer stores at @p p and returns the advanced cursor without any
+ * capacity check.  Only for callers that have already proven the output
+ * fits (pageout with a valid size cache, see io.c).  Multi-byte fields
+ * are byte-swapped and written with one store.
+ */
+#ifndef CFGPACK_MSGPACK_RAW_H
+#define CFGPACK_MSGPACK_RAW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && \
+    (defined(__GNUC__) || defined(__clang__))
+  #define MP_RAW_BSWAP 1
+#endif
+
+static inline uint8_t *mp_raw_be16(uint8_t *p, uint16_t v) {
+#ifdef MP_RAW_BSWAP
+    v = __builtin_bswap16(v);
+    memcpy(p, &v, 2);
+#else
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+#endif
+    return (p + 2);
+}
+
+static inline uint8_t *mp_raw_be32(uint8_t *p, uint32_t v) {
+#ifdef MP_RAW_BSWAP
+    v = __builtin_bswap32(v);
+    memcpy(p, &v, 4);
+#else
+    for (int i = 0; i < 4; ++i) {
+        p[i] = (uint8_t)(v >> (24 - 8 * i));
+    }
+#endif
+    return (p + 4);
+}
+
+static inline uint8_t *mp_raw_be64(uint8_t *p, uint64_t v) {
+#ifdef MP_RAW_BSWAP
+    v = __builtin_bswap64(v);
+    memcpy(p, &v, 8);
+#else
+    for (int i = 0; i < 8; ++i) {
+        p[i] = (uint8_t)(v >> (56 - 8 * i));
+    }
+#endif
+    return (p + 8);
+}
+
+static inline uint8_t *mp_raw_uint(uint8_t *p, uint64_t v) {
+    if (v <= 0x7fu) {
+        *p = (uint8_t)v;
+        return (p + 1);
+    }
+    if (v <= 0xffu) {
+        p[0] = 0xcc;
+        p[1] = (uint8_t)v;
+        return (p + 2);
+    }
+    if (v <= 0xffffu) {
+        *p = 0xcd;
+        return (mp_raw_be16(p + 1, (uint16_t)v));
+    }
+    if (v <= 0xffffffffu) {
+        *p = 0xce;
+        return (mp_raw_be32(p + 1, (uint32_t)v));
+    }
+    *p = 0xcf;
+    return (mp_raw_be64(p + 1, v));
+}
+
+static inline uint8_t *mp_raw_int(uint8_t *p, int64_t v) {
+    if (v >= 0) {
+        return (mp_raw_uint(p, (uint64_t)v));
+    }
+    if (v >= -32) {
+        *p = (uint8_t)v; /* negative fixint */
+        return (p + 1);
+    }
+    if (v >= -128) {
+        p[0] = 0xd0;
+        p[1] = (uint8_t)v;
+        return (p + 2);
+    }
+    if (v >= -32768) {
+        *p = 0xd1;
+        return (mp_raw_be16(p + 1, (uint16_t)v));
+    }
+    if (v >= INT32_MIN) {
+        *p = 0xd2;
+        return (mp_raw_be32(p + 1, (uint32_t)v));
+    }
+    *p = 0xd3;
+    return (mp_raw_be64(p + 1, (uint64_t)v));
+}
+
+static inline uint8_t *mp_raw_f32(uint8_t *p, float v) {
+    uint32_t u;
+
+    memcpy(&u, &v, sizeof(u));
+    *p = 0xca;
+    return (mp_raw_be32(p + 1, u));
+}
+
+static inline uint8_t *mp_raw_f64(uint8_t *p, double v) {
+    uint64_t u;
+
+    memcpy(&u, &v, sizeof(u));
+    *p = 0xcb;
+    return (mp_raw_be64(p + 1, u));
+}
+
+static inline uint8_t *mp_raw_str(uint8_t *p, const char *s, size_t len) {
+    if (len <= 31) {
+        *p++ = (uint8_t)(0xa0 | (uint8_t)len);
+    } else if (len <= 255) {
+        *p++ = 0xd9;
+        *p++ = (uint8_t)len;
+    } else {
+        *p = 0xda;
+        p = mp_raw_be16(p + 1, (uint16_t)len);
+    }
+    memcpy(p, s, len);
+    return (p + len);
+}
+
+static inline uint8_t *mp_raw_map_header(uint8_t *p, uint32_t count) {
+    if (count <= 15) {
+        *p = (uint8_t)(0x80 | count);
+        return (p + 1);
+    }
+    if (count <= 0xffffu) {
+        *p = 0xde;
+        return (mp_raw_be16(p + 1, (uint16_t)count));
+    }
+    *p = 0xdf;
+    return (mp_raw_be32(p + 1, count));
+}
+
+#endif /* CFGPACK_MSGPACK_RAW_H */
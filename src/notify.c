@@ -0,0 +1,138 @@
+/**
+ * @file notify.c
+ * @brief Batched change notification for index-range subscriptions.
+ *
+ * API writes mark the entries they change in a pending bitmap (see
+ * cfgpack_notify_mark()); cfgpack_notify_dispatch() then moves the marks
+ * to the delivering bitmap and calls each subscription whose range holds
+ * one, so a batch of writes costs one pass over the subscriptions.
+ *
+ * Compiles to nothing unless CFGPACK_NOTIFY is defined; the marking sites
+ * are the inline helpers in lookup.h.
+ */
+
+#include "cfgpack/api.h"
+
+#ifdef CFGPACK_NOTIFY
+
+  #include "lookup.h"
+
+  #include <string.h>
+
+/** Bytes in each of the pending and delivering bitmaps. */
+static size_t notify_half(const cfgpack_ctx_t *ctx) {
+    return ((ctx->schema->entry_count + CHAR_BIT - 1) / CHAR_BIT);
+}
+
+static int bit_get(const uint8_t *bits, size_t off) {
+    return ((bits[off / CHAR_BIT] >> (off % CHAR_BIT)) & 1u);
+}
+
+/**
+ * @brief Whether any entry of @p sub's range is set in @p bits.
+ *
+ * Entries are sorted by index, so the range is found by binary search and
+ * walked in order.
+ */
+static int range_marked(const cfgpack_schema_t *schema,
+                        const cfgpack_sub_t *sub,
+                        const uint8_t *bits) {
+    size_t lo = 0;
+    size_t hi = schema->entry_count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (schema->entries[mid].index < sub->first) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (size_t i = lo;
+         i < schema->entry_count && schema->entries[i].index <= sub->last;
+         ++i) {
+        if (bit_get(bits, i)) {
+            return (1);
+        }
+    }
+    return (0);
+}
+
+cfgpack_err_t cfgpack_notify_init(cfgpack_ctx_t *ctx,
+                                  const cfgpack_sub_t *subs,
+                                  size_t count,
+                                  uint8_t *bits,
+                                  size_t bits_len) {
+    if (!ctx || !ctx->schema || !subs || !bits) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!subs[i].fn || subs[i].first > subs[i].last) {
+            return (CFGPACK_ERR_ARGS);
+        }
+    }
+    if (bits_len < CFGPACK_NOTIFY_BYTES(ctx->schema->entry_count)) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    memset(bits, 0, CFGPACK_NOTIFY_BYTES(ctx->schema->entry_count));
+    ctx->subs = subs;
+    ctx->sub_count = count;
+    ctx->notify_bits = bits;
+    ctx->notifying = 0;
+    return (CFGPACK_OK);
+}
+
+int cfgpack_notify_changed(const cfgpack_ctx_t *ctx, uint16_t index) {
+    const cfgpack_entry_t *e;
+
+    if (!ctx || !ctx->notify_bits || !ctx->notifying) {
+        return (0);
+    }
+    e = cfgpack_find_entry(ctx, index);
+    if (!e) {
+        return (0);
+    }
+    return (bit_get(ctx->notify_bits + notify_half(ctx),
+                    (size_t)(e - ctx->schema->entries)));
+}
+
+void cfgpack_notify_dispatch(cfgpack_ctx_t *ctx) {
+    const cfgpack_sub_t *subs = ctx->subs;
+    uint8_t *pending = ctx->notify_bits;
+    uint8_t *delivering;
+    size_t half;
+
+    if (!pending || ctx->notifying || cfgpack_in_txn(ctx)) {
+        return;
+    }
+    half = notify_half(ctx);
+    delivering = pending + half;
+
+    /* Changes made by callbacks go to pending and get their own pass */
+    ctx->notifying = 1;
+    for (;;) {
+        uint8_t any = 0;
+
+        for (size_t i = 0; i < half; ++i) {
+            delivering[i] = pending[i];
+            any |= pending[i];
+            pending[i] = 0;
+        }
+        if (!any) {
+            break;
+        }
+        for (size_t s = 0; s < ctx->sub_count; ++s) {
+            if (range_marked(ctx->schema, &subs[s], delivering)) {
+                subs[s].fn(ctx, &subs[s]);
+                if (ctx->notify_bits != pending) {
+                    return; /* a callback re-initialized the context */
+                }
+            }
+        }
+    }
+    memset(delivering, 0, half);
+    ctx->notifying = 0;
+}
+
+#endif /* CFGPACK_NOTIFY */
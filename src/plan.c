@@ -0,0 +1,189 @@
+/**
+ * @file plan.c
+ * @brief Single-arena planning and carving.
+ *
+ * See plan.h for the region list and the bounds behind each size.
+ */
+
+#include "cfgpack/plan.h"
+
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Bounds
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** @brief Fixed JSON text around the entries: braces, name and version. */
+#define PLAN_JSON_HEAD                                                        \
+    (sizeof("{\n  \"name\": \"\",\n  \"version\": ,\n  \"entries\": [\n") -   \
+     1 + 63 + 10 + sizeof("  ]\n}\n") - 1)
+
+/**
+ * @brief Worst-case JSON text of one entry, excluding string bytes:
+ *        `    {"index": 65535, "name": "abcde", "type": "fstr:255",
+ *        "value": ` and `},\n` (70 bytes, rounded up) plus a
+ *        31-character number.
+ */
+#define PLAN_JSON_ENTRY (72 + 31)
+
+/** @brief Escaped JSON size of one string byte (\\u00XX). */
+#define PLAN_JSON_CHAR 6
+
+/**
+ * @brief Compressed size bound for an @p n byte blob.
+ *
+ * Covers the LZ4 worst case (n + n/255 + 16 plus a 4-byte size header)
+ * and heatshrink's (9 bits per literal byte plus a flush).
+ */
+static size_t compressed_max(size_t n) {
+    return (n + n / 8 + 20);
+}
+
+static size_t align_up(size_t n, size_t align) {
+    return ((n + align - 1) & ~(align - 1));
+}
+
+static int align_ok(size_t align) {
+    return (align >= 8 && (align & (align - 1)) == 0);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Planning
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static void place(cfgpack_plan_region_t *r,
+                  size_t size,
+                  size_t *cursor,
+                  size_t align) {
+    r->size = size;
+    r->off = 0;
+    if (size) {
+        r->off = align_up(*cursor, align);
+        *cursor = r->off + size;
+    }
+}
+
+cfgpack_err_t cfgpack_plan(const cfgpack_schema_measure_t *m,
+                           const cfgpack_plan_opts_t *opts,
+                           cfgpack_plan_t *out) {
+    unsigned features = opts ? opts->features : 0;
+    size_t align = (opts && opts->align) ? opts->align : CFGPACK_PLAN_ALIGN;
+    size_t n_str;
+    size_t bitmaps = 0;
+    size_t io = 0;
+    size_t cursor = 0;
+
+    if (!m || !out || !align_ok(align)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->align = align;
+    out->blob_max = m->blob_max;
+    out->json_max = PLAN_JSON_HEAD + m->entry_count * PLAN_JSON_ENTRY +
+                    m->str_pool_size * PLAN_JSON_CHAR;
+    n_str = m->str_count + m->fstr_count;
+#ifdef CFGPACK_LARGE_SCHEMA
+    bitmaps = CFGPACK_BITMAP_BYTES(m->entry_count);
+#endif
+    if (features & CFGPACK_PLAN_IO) {
+        io = (features & CFGPACK_PLAN_DECOMPRESS) ? compressed_max(m->blob_max)
+                                                  : m->blob_max;
+        io += opts->lfs_cache_size;
+    }
+
+    place(&out->entries, m->entry_count * sizeof(cfgpack_entry_t), &cursor,
+          align);
+    place(&out->values, m->entry_count * sizeof(cfgpack_value_t), &cursor,
+          align);
+    place(&out->name_index,
+          (features & CFGPACK_PLAN_NAME_INDEX) ? m->entry_count *
+                                                     sizeof(uint64_t)
+                                               : 0,
+          &cursor, align);
+    place(&out->str_offsets, n_str * sizeof(cfgpack_str_off_t), &cursor,
+          align);
+    place(&out->str_pool, m->str_pool_size, &cursor, align);
+    place(&out->index_table,
+          (features & CFGPACK_PLAN_INDEX_TABLE) ? m->index_table_size : 0,
+          &cursor, align);
+    place(&out->bitmaps, bitmaps, &cursor, align);
+    place(&out->io, io, &cursor, align);
+    place(&out->decompress,
+          (features & CFGPACK_PLAN_DECOMPRESS) ? m->blob_max : 0, &cursor,
+          align);
+    place(&out->json, (features & CFGPACK_PLAN_JSON) ? out->json_max : 0,
+          &cursor, align);
+
+    out->arena_size = cursor + align - 1;
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Carving
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static void *region_ptr(uint8_t *base, const cfgpack_plan_region_t *r) {
+    return (r->size ? base + r->off : NULL);
+}
+
+static size_t region_end(const cfgpack_plan_region_t *r) {
+    return (r->size ? r->off + r->size : 0);
+}
+
+cfgpack_err_t cfgpack_plan_carve(const cfgpack_plan_t *plan,
+                                 void *arena,
+                                 size_t arena_len,
+                                 cfgpack_arena_t *out) {
+    const cfgpack_plan_region_t *regions[10];
+    uint8_t *base;
+    size_t skew;
+    size_t end = 0;
+
+    if (!plan || !arena || !out || !align_ok(plan->align)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+
+    skew = align_up((uintptr_t)arena, plan->align) - (uintptr_t)arena;
+    regions[0] = &plan->entries;
+    regions[1] = &plan->values;
+    regions[2] = &plan->name_index;
+    regions[3] = &plan->str_offsets;
+    regions[4] = &plan->str_pool;
+    regions[5] = &plan->index_table;
+    regions[6] = &plan->bitmaps;
+    regions[7] = &plan->io;
+    regions[8] = &plan->decompress;
+    regions[9] = &plan->json;
+    for (size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); ++i) {
+        if (region_end(regions[i]) > end) {
+            end = region_end(regions[i]);
+        }
+    }
+    if (skew > arena_len || end > arena_len - skew) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    base = (uint8_t *)arena + skew;
+    out->entries = region_ptr(base, &plan->entries);
+    out->max_entries = plan->entries.size / sizeof(cfgpack_entry_t);
+    out->values = region_ptr(base, &plan->values);
+    out->str_pool = region_ptr(base, &plan->str_pool);
+    out->str_pool_cap = plan->str_pool.size;
+    out->str_offsets = region_ptr(base, &plan->str_offsets);
+    out->str_offsets_count = plan->str_offsets.size /
+                             sizeof(cfgpack_str_off_t);
+    out->name_index = region_ptr(base, &plan->name_index);
+    out->name_index_cap = plan->name_index.size / sizeof(uint64_t);
+    out->index_table = region_ptr(base, &plan->index_table);
+    out->index_table_cap = plan->index_table.size;
+    out->bitmaps = region_ptr(base, &plan->bitmaps);
+    out->bitmaps_len = plan->bitmaps.size;
+    out->io = region_ptr(base, &plan->io);
+    out->io_cap = plan->io.size;
+    out->decompress = region_ptr(base, &plan->decompress);
+    out->decompress_cap = plan->decompress.size;
+    out->json = region_ptr(base, &plan->json);
+    out->json_cap = plan->json.size;
+    return (CFGPACK_OK);
+}
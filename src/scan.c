@@ -0,0 +1,207 @@
+/**
+ * @file scan.c
+ * @brief Byte search helpers for the .map and JSON parsers.
+ *
+ * The backend is chosen at compile time by CFGPACK_SCAN_BACKEND (see
+ * config.h):
+ *
+ *   CFGPACK_SCAN_BYTE - plain byte loop; no word loads, smallest code
+ *   CFGPACK_SCAN_SWAR - eight bytes per step: each 64-bit word is tested
+ *                       for a matching byte with the (x - 0x01..) & ~x &
+ *                       0x80.. zero-byte trick, and the word that hits is
+ *                       finished with the byte loop
+ *   CFGPACK_SCAN_SIMD - sixteen bytes per step with SSE2 compares or NEON
+ *                       compares, then the SWAR loop for the tail
+ *
+ * Words are loaded with memcpy, so the input needs no alignment and the
+ * SWAR path is endian-neutral.  No backend reads past p[n - 1].
+ */
+
+#include "cfgpack/config.h"
+
+#include "scan.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Backend selection
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#if CFGPACK_SCAN_BACKEND == CFGPACK_SCAN_SIMD
+  #define SCAN_USE_SWAR 1
+  #if defined(__GNUC__) && defined(__SSE2__)
+    #define SCAN_USE_SSE2 1
+    #include <emmintrin.h>
+  #elif defined(__GNUC__) && defined(__ARM_NEON) && defined(__aarch64__) &&  \
+      !defined(__ARM_BIG_ENDIAN)
+    #define SCAN_USE_NEON 1
+    #include <arm_neon.h>
+  #endif
+#elif CFGPACK_SCAN_BACKEND == CFGPACK_SCAN_SWAR
+  #define SCAN_USE_SWAR 1
+#elif CFGPACK_SCAN_BACKEND != CFGPACK_SCAN_BYTE
+  #error "Unknown CFGPACK_SCAN_BACKEND"
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Byte loop (every backend finishes with it)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static size_t any2_bytes(const char *p, size_t n, char a, char b) {
+    size_t i = 0;
+
+    while (i < n && p[i] != a && p[i] != b) {
+        i++;
+    }
+    return (i);
+}
+
+static size_t run_bytes(const char *p, size_t n, char c) {
+    size_t i = 0;
+
+    while (i < n && p[i] == c) {
+        i++;
+    }
+    return (i);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * SWAR: eight bytes per step
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#ifdef SCAN_USE_SWAR
+  #define SWAR_ONES  0x0101010101010101u
+  #define SWAR_HIGHS 0x8080808080808080u
+
+/* Non-zero iff some byte of w equals the byte repeated in pat. */
+static uint64_t swar_has(uint64_t w, uint64_t pat) {
+    uint64_t x = w ^ pat;
+    return ((x - SWAR_ONES) & ~x & SWAR_HIGHS);
+}
+
+static size_t any2_swar(const char *p, size_t n, char a, char b) {
+    uint64_t pa = SWAR_ONES * (unsigned char)a;
+    uint64_t pb = SWAR_ONES * (unsigned char)b;
+    size_t i = 0;
+
+    for (; n - i >= 8; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        if (swar_has(w, pa) | swar_has(w, pb)) {
+            break;
+        }
+    }
+    return (i + any2_bytes(p + i, n - i, a, b));
+}
+
+static size_t run_swar(const char *p, size_t n, char c) {
+    uint64_t pc = SWAR_ONES * (unsigned char)c;
+    size_t i = 0;
+
+    for (; n - i >= 8; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        if (w != pc) {
+            break;
+        }
+    }
+    return (i + run_bytes(p + i, n - i, c));
+}
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * SIMD: sixteen bytes per step
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#if defined(SCAN_USE_SSE2)
+static size_t any2_simd(const char *p, size_t n, char a, char b) {
+    __m128i va = _mm_set1_epi8(a);
+    __m128i vb = _mm_set1_epi8(b);
+    size_t i = 0;
+
+    for (; n - i >= 16; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(p + i));
+        int m = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+        if (m) {
+            return (i + (size_t)__builtin_ctz((unsigned)m));
+        }
+    }
+    return (i + any2_swar(p + i, n - i, a, b));
+}
+
+static size_t run_simd(const char *p, size_t n, char c) {
+    __m128i vc = _mm_set1_epi8(c);
+    size_t i = 0;
+
+    for (; n - i >= 16; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(p + i));
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vc)) ^
+                     0xFFFFu;
+        if (m) {
+            return (i + (size_t)__builtin_ctz(m));
+        }
+    }
+    return (i + run_swar(p + i, n - i, c));
+}
+#elif defined(SCAN_USE_NEON)
+/* Narrow a 0x00/0xFF byte mask to 4 bits per byte in a 64-bit word. */
+static uint64_t neon_mask(uint8x16_t eq) {
+    uint8x8_t nib = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return (vget_lane_u64(vreinterpret_u64_u8(nib), 0));
+}
+
+static size_t any2_simd(const char *p, size_t n, char a, char b) {
+    uint8x16_t va = vdupq_n_u8((uint8_t)a);
+    uint8x16_t vb = vdupq_n_u8((uint8_t)b);
+    size_t i = 0;
+
+    for (; n - i >= 16; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)p + i);
+        uint64_t m = neon_mask(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb)));
+        if (m) {
+            return (i + ((size_t)__builtin_ctzll(m) >> 2));
+        }
+    }
+    return (i + any2_swar(p + i, n - i, a, b));
+}
+
+static size_t run_simd(const char *p, size_t n, char c) {
+    uint8x16_t vc = vdupq_n_u8((uint8_t)c);
+    size_t i = 0;
+
+    for (; n - i >= 16; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)p + i);
+        uint64_t m = neon_mask(vmvnq_u8(vceqq_u8(v, vc)));
+        if (m) {
+            return (i + ((size_t)__builtin_ctzll(m) >> 2));
+        }
+    }
+    return (i + run_swar(p + i, n - i, c));
+}
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Public API
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+size_t cfgpack_scan_any2(const char *p, size_t n, char a, char b) {
+#if defined(SCAN_USE_SSE2) || defined(SCAN_USE_NEON)
+    return (any2_simd(p, n, a, b));
+#elif defined(SCAN_USE_SWAR)
+    return (any2_swar(p, n, a, b));
+#else
+    return (any2_bytes(p, n, a, b));
+#endif
+}
+
+size_t cfgpack_scan_run(const char *p, size_t n, char c) {
+#if defined(SCAN_USE_SSE2) || defined(SCAN_USE_NEON)
+    return (run_simd(p, n, c));
+#elif defined(SCAN_USE_SWAR)
+    return (run_swar(p, n, c));
+#else
+    return (run_bytes(p, n, c));
+#endif
+}
@@ -0,0 +1,36 @@
+/**
+ * @file scan.h
+ * @brief Byte search helpers for the .map and JSON parsers.
+ *
+ * The implementation (byte loop, SWAR or SSE2/NEON) is selected by
+ * CFGPACK_SCAN_BACKEND in config.h; all backends return identical
+ * positions.
+ */
+#ifndef CFGPACK_SCAN_H
+#define CFGPACK_SCAN_H
+
+#include <stddef.h>
+
+/**
+ * @brief Find the first occurrence of either of two bytes.
+ *
+ * @param p  Input bytes (may be NULL when @p n is 0).
+ * @param n  Number of bytes to search.
+ * @param a  First byte to look for.
+ * @param b  Second byte to look for (pass @p a twice for a single byte).
+ * @return Offset of the first @p a or @p b, or @p n if neither occurs.
+ */
+size_t cfgpack_scan_any2(const char *p, size_t n, char a, char b);
+
+/**
+ * @brief Measure a run of one repeated byte.
+ *
+ * @param p  Input bytes (may be NULL when @p n is 0).
+ * @param n  Number of bytes to search.
+ * @param c  Byte the run consists of.
+ * @return Offset of the first byte other than @p c, or @p n if every byte
+ *         is @p c.
+ */
+size_t cfgpack_scan_run(const char *p, size_t n, char c);
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file schema_cache.c
+ * @brief Prototype contexts looked up by schema name and version.
+ *
+ * The cache is a caller-owned array of prototype pointers kept sorted by
+ * (map_name, version): lookups are a binary search, adds an insertion.
+ * Pair with cfgpack_init_shared() to parse each schema version once.
+ */
+
+#include "cfgpack/api.h"
+
+#include <string.h>
+
+/** Order of a cached prototype relative to (@p name, @p version). */
+static int key_cmp(const cfgpack_ctx_t *proto,
+                   const char *name,
+                   uint32_t version) {
+    int c = strcmp(proto->schema->map_name, name);
+
+    if (c != 0) {
+        return (c);
+    }
+    if (proto->schema->version != version) {
+        return (proto->schema->version < version ? -1 : 1);
+    }
+    return (0);
+}
+
+/** First position whose key is not below (@p name, @p version). */
+static size_t lower_bound(const cfgpack_schema_cache_t *cache,
+                          const char *name,
+                          uint32_t version) {
+    size_t lo = 0;
+    size_t hi = cache->count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (key_cmp(cache->protos[mid], name, version) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo);
+}
+
+cfgpack_err_t cfgpack_schema_cache_init(cfgpack_schema_cache_t *cache,
+                                        const cfgpack_ctx_t **protos,
+                                        size_t cap) {
+    if (!cache || (!protos && cap)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    cache->protos = protos;
+    cache->cap = cap;
+    cache->count = 0;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_schema_cache_add(cfgpack_schema_cache_t *cache,
+                                       const cfgpack_ctx_t *proto) {
+    const cfgpack_schema_t *schema;
+    size_t pos;
+
+    if (!cache || !proto || !proto->schema) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    schema = proto->schema;
+    pos = lower_bound(cache, schema->map_name, schema->version);
+    if (pos < cache->count &&
+        key_cmp(cache->protos[pos], schema->map_name, schema->version) == 0) {
+        cache->protos[pos] = proto;
+        return (CFGPACK_OK);
+    }
+    if (cache->count >= cache->cap) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    memmove(&cache->protos[pos + 1], &cache->protos[pos],
+            (cache->count - pos) * sizeof(*cache->protos));
+    cache->protos[pos] = proto;
+    cache->count++;
+    return (CFGPACK_OK);
+}
+
+const cfgpack_ctx_t *cfgpack_schema_cache_find(
+    const cfgpack_schema_cache_t *cache, const char *name, uint32_t version) {
+    size_t pos;
+
+    if (!cache || !name) {
+        return (NULL);
+    }
+    pos = lower_bound(cache, name, version);
+    if (pos < cache->count &&
+        key_cmp(cache->protos[pos], name, version) == 0) {
+        return (cache->protos[pos]);
+    }
+    return (NULL);
+}
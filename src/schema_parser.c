@@ -5,6 +5,10 @@
 #include "cfgpack/schema.h"
 #include "cfgpack/value.h"
 
+#include "crc32.h"
+#include "lookup.h"
+#include "scan.h"
+#include "stats.h"
 #include "tokens.h"
 #include "wbuf.h"
 
@@ -63,7 +67,7 @@ static void line_iter_init(line_iter_t *it, const char *data, size_t len) {
 static const char *line_iter_next(line_iter_t *it, size_t *line_len) {
     const char *start;
     size_t remaining;
-    size_t i = 0;
+    size_t i;
 
     if (it->pos >= it->len) {
         return (NULL);
@@ -73,9 +77,7 @@ static const char *line_iter_next(line_iter_t *it, size_t *line_len) {
     remaining = it->len - it->pos;
 
     /* Find end of line (newline or end of buffer) */
-    while (i < remaining && start[i] != '\n' && start[i] != '\r') {
-        i++;
-    }
+    i = cfgpack_scan_any2(start, remaining, '\n', '\r');
 
     *line_len = i;
 
@@ -187,6 +189,64 @@ static cfgpack_err_t parse_type(const char *tok, cfgpack_type_t *out) {
     return (CFGPACK_ERR_INVALID_TYPE);
 }
 
+/**
+ * @brief Maximum string length for a type and declared max (0 = type max).
+ */
+static size_t str_limit(cfgpack_type_t type, uint8_t str_max) {
+    cfgpack_entry_t e;
+    e.type = type;
+    e.str_max = str_max;
+    return (cfgpack_entry_str_max(&e));
+}
+
+/**
+ * @brief Parse a type token with an optional ":N" max length ("str:16").
+ *
+ * Only str and fstr take a length, which must be 1 to the type maximum.
+ *
+ * @param tok     Type token.
+ * @param out     Receives the type.
+ * @param str_max Receives N, or 0 when no length was given.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_INVALID_TYPE for an unknown
+ *         type or malformed length; CFGPACK_ERR_BOUNDS if N is out of range.
+ */
+static cfgpack_err_t parse_type_len(const char *tok,
+                                    cfgpack_type_t *out,
+                                    uint8_t *str_max) {
+    const char *colon = strchr(tok, ':');
+    unsigned long n;
+    cfgpack_err_t rc;
+    char *endp;
+    char base[8];
+
+    *str_max = 0;
+    if (!colon) {
+        return (parse_type(tok, out));
+    }
+    if ((size_t)(colon - tok) >= sizeof(base)) {
+        return (CFGPACK_ERR_INVALID_TYPE);
+    }
+    memcpy(base, tok, (size_t)(colon - tok));
+    base[colon - tok] = '\0';
+    rc = parse_type(base, out);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if ((*out != CFGPACK_TYPE_STR && *out != CFGPACK_TYPE_FSTR) ||
+        colon[1] < '0' || colon[1] > '9') {
+        return (CFGPACK_ERR_INVALID_TYPE);
+    }
+    n = strtoul(colon + 1, &endp, 10);
+    if (*endp != '\0') {
+        return (CFGPACK_ERR_INVALID_TYPE);
+    }
+    if (n == 0 || n > str_limit(*out, 0)) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    *str_max = (uint8_t)n;
+    return (CFGPACK_OK);
+}
+
 /**
  * @brief Check if an entry name exceeds the allowed length.
  */
@@ -194,41 +254,96 @@ static int name_too_long(const char *name) {
     return (strlen(name) > 5 || strlen(name) == 0);
 }
 
+/** Ordering of two entries for sort_entries(): <0, 0 or >0. */
+typedef int (*entry_cmp_fn)(const cfgpack_entry_t *a,
+                            const cfgpack_entry_t *b);
+
+static int entry_cmp_index(const cfgpack_entry_t *a,
+                           const cfgpack_entry_t *b) {
+    return ((a->index > b->index) - (a->index < b->index));
+}
+
+static int entry_cmp_name(const cfgpack_entry_t *a, const cfgpack_entry_t *b) {
+    return (strcmp(a->name, b->name));
+}
+
 /**
- * @brief Check for duplicate index or name in existing entries.
+ * @brief Position of the first entry equal to its predecessor under @p cmp.
+ *
+ * @return The position, or 0 if no two neighbours compare equal.
  */
-static int has_duplicate(const cfgpack_entry_t *entries,
-                         size_t count,
-                         uint16_t idx,
-                         const char *name) {
-    for (size_t i = 0; i < count; ++i) {
-        if (entries[i].index == idx) {
-            return (1);
-        }
-        if (strcmp(entries[i].name, name) == 0) {
-            return (1);
+static size_t first_adjacent_equal(const cfgpack_entry_t *entries,
+                                   size_t n,
+                                   entry_cmp_fn cmp) {
+    for (size_t i = 1; i < n; ++i) {
+        if (cmp(&entries[i - 1], &entries[i]) == 0) {
+            return (i);
         }
     }
     return (0);
 }
 
+static void swap_entries(cfgpack_entry_t *entries,
+                         cfgpack_value_t *values,
+                         size_t a,
+                         size_t b) {
+    cfgpack_entry_t e = entries[a];
+    cfgpack_value_t v = values[a];
+    entries[a] = entries[b];
+    values[a] = values[b];
+    entries[b] = e;
+    values[b] = v;
+}
+
+/**
+ * @brief Restore the max-heap property below @p root in entries[0, end).
+ */
+static void sift_down(cfgpack_entry_t *entries,
+                      cfgpack_value_t *values,
+                      size_t root,
+                      size_t end,
+                      entry_cmp_fn cmp) {
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= end) {
+            return;
+        }
+        if (child + 1 < end && cmp(&entries[child], &entries[child + 1]) < 0) {
+            child++;
+        }
+        if (cmp(&entries[root], &entries[child]) >= 0) {
+            return;
+        }
+        swap_entries(entries, values, root, child);
+        root = child;
+    }
+}
+
 /**
- * @brief Sort entries and values by index using insertion sort.
+ * @brief Sort entries and values together with an in-place heapsort.
+ *
+ * O(n log n) with constant stack.  Input that is already in order is
+ * detected in one pass and left alone.
  */
 static void sort_entries(cfgpack_entry_t *entries,
                          cfgpack_value_t *values,
-                         size_t n) {
-    for (size_t i = 1; i < n; ++i) {
-        cfgpack_entry_t key_entry = entries[i];
-        cfgpack_value_t key_value = values[i];
-        size_t j = i;
-        while (j > 0 && entries[j - 1].index > key_entry.index) {
-            entries[j] = entries[j - 1];
-            values[j] = values[j - 1];
-            --j;
-        }
-        entries[j] = key_entry;
-        values[j] = key_value;
+                         size_t n,
+                         entry_cmp_fn cmp) {
+    size_t i = 1;
+
+    while (i < n && cmp(&entries[i - 1], &entries[i]) <= 0) {
+        i++;
+    }
+    if (i >= n) {
+        return;
+    }
+
+    for (i = n / 2; i-- > 0;) {
+        sift_down(entries, values, i, n, cmp);
+    }
+    for (i = n - 1; i > 0; --i) {
+        swap_entries(entries, values, 0, i);
+        sift_down(entries, values, 0, i, cmp);
     }
 }
 
@@ -236,59 +351,42 @@ static void sort_entries(cfgpack_entry_t *entries,
  * @brief Compute string pool offsets for sorted entries.
  *
  * After sorting, recomputes str_offsets[] in sorted entry order.
- * Returns total pool bytes needed.
+ * Returns total pool bytes needed and stores the number of string slots
+ * in @p slots_out.
  */
 static size_t compute_str_offsets(cfgpack_entry_t *entries,
                                   size_t count,
-                                  uint16_t *str_offsets,
-                                  size_t str_offsets_count) {
+                                  cfgpack_str_off_t *str_offsets,
+                                  size_t str_offsets_count,
+                                  size_t *slots_out) {
     size_t pool_offset = 0;
     size_t slot = 0;
     for (size_t i = 0; i < count; ++i) {
         cfgpack_type_t t = entries[i].type;
         if (t == CFGPACK_TYPE_STR) {
-            entries[i].str_slot = (uint8_t)slot;
-            if (slot < str_offsets_count && pool_offset <= UINT16_MAX) {
-                str_offsets[slot] = (uint16_t)pool_offset;
+            entries[i].str_slot = (cfgpack_str_slot_t)slot;
+            if (slot < str_offsets_count &&
+                pool_offset <= CFGPACK_STR_OFF_MAX) {
+                str_offsets[slot] = (cfgpack_str_off_t)pool_offset;
             }
             slot++;
-            pool_offset += CFGPACK_STR_MAX + 1;
+            pool_offset += cfgpack_entry_str_max(&entries[i]) + 1;
         } else if (t == CFGPACK_TYPE_FSTR) {
-            entries[i].str_slot = (uint8_t)slot;
-            if (slot < str_offsets_count && pool_offset <= UINT16_MAX) {
-                str_offsets[slot] = (uint16_t)pool_offset;
+            entries[i].str_slot = (cfgpack_str_slot_t)slot;
+            if (slot < str_offsets_count &&
+                pool_offset <= CFGPACK_STR_OFF_MAX) {
+                str_offsets[slot] = (cfgpack_str_off_t)pool_offset;
             }
             slot++;
-            pool_offset += CFGPACK_FSTR_MAX + 1;
+            pool_offset += cfgpack_entry_str_max(&entries[i]) + 1;
         } else {
             entries[i].str_slot = CFGPACK_STR_SLOT_NONE;
         }
     }
+    *slots_out = slot;
     return (pool_offset);
 }
 
-/**
- * @brief Find entry position by index using binary search (sorted entries).
- */
-static int find_entry_pos(const cfgpack_entry_t *entries,
-                          size_t count,
-                          uint16_t index) {
-    size_t hi = count;
-    size_t lo = 0;
-    while (lo < hi) {
-        size_t mid = lo + (hi - lo) / 2;
-        if (entries[mid].index == index) {
-            return (int)mid;
-        }
-        if (entries[mid].index < index) {
-            lo = mid + 1;
-        } else {
-            hi = mid;
-        }
-    }
-    return (-1);
-}
-
 /**
  * @brief Skip whitespace and return pointer to next non-space character.
  */
@@ -558,9 +656,9 @@ static void fat_str_to_pool(const cfgpack_fat_value_t *fat,
                             cfgpack_value_t *values,
                             const cfgpack_entry_t *entries,
                             char *str_pool,
-                            uint16_t *str_offsets) {
-    uint8_t slot = entries[entry_pos].str_slot;
-    uint16_t offset;
+                            cfgpack_str_off_t *str_offsets) {
+    cfgpack_str_slot_t slot = entries[entry_pos].str_slot;
+    cfgpack_str_off_t offset;
     char *dst;
 
     if (slot == CFGPACK_STR_SLOT_NONE) {
@@ -585,33 +683,79 @@ static void fat_str_to_pool(const cfgpack_fat_value_t *fat,
     }
 }
 
+/**
+ * @brief Remember where a default value starts in the source (Phase 1).
+ *
+ * String defaults can only be written once sorting has fixed the pool
+ * slots, so Phase 1 parks the source offset in the entry's value slot,
+ * which sort_entries() moves along with the entry.
+ */
+static void defer_default(cfgpack_value_t *v, size_t src_off) {
+    v->v.u64 = (uint64_t)src_off;
+}
+
+/**
+ * @brief Take back the source offset parked by defer_default() (Phase 2).
+ */
+static size_t take_deferred(cfgpack_value_t *v) {
+    size_t src_off = (size_t)v->v.u64;
+    v->v.u64 = 0;
+    return (src_off);
+}
+
 /* ─────────────────────────────────────────────────────────────────────────────
  * Schema Finalize — shared post-parse setup used by all three parsers
  * ───────────────────────────────────────────────────────────────────────────── */
 
 /**
- * @brief Finalize a parsed schema: sort entries, assign schema fields, set up
- *        string pool offsets, and zero the string pool.
+ * @brief Finalize a parsed schema: sort entries, reject duplicate names and
+ *        indices, assign schema fields, set up string pool offsets, and zero
+ *        the string pool.
  *
  * Called by all three format-specific parsers between Phase 1 (entry parsing)
  * and Phase 2 (string default extraction).
  *
  * @param opts      Parse options (provides schema, entries, values, pool, etc.)
  * @param count     Number of entries parsed in Phase 1.
- * @return CFGPACK_OK on success, or CFGPACK_ERR_BOUNDS if the string pool is
- *         too small for the parsed entries.
+ * @param cow       Non-zero when string defaults stay in the source blob;
+ *                  the pool is then neither checked nor touched.
+ * @param filled    Non-zero when the defaults are already in the pool (a
+ *                  streaming parse); the pool is checked but not zeroed.
+ * @return CFGPACK_OK on success; CFGPACK_ERR_DUPLICATE if two entries share
+ *         a name or index; CFGPACK_ERR_BOUNDS if the string pool is too
+ *         small for the parsed entries.
  */
 static cfgpack_err_t schema_finalize(const cfgpack_parse_opts_t *opts,
-                                     size_t count) {
+                                     size_t count,
+                                     int cow,
+                                     int filled) {
     size_t pool_needed;
+    size_t slots;
 
-    sort_entries(opts->entries, opts->values, count);
+    /* Sort by name to find duplicate names, then into index order */
+    sort_entries(opts->entries, opts->values, count, entry_cmp_name);
+    if (first_adjacent_equal(opts->entries, count, entry_cmp_name)) {
+        set_err(opts->err, 0, "duplicate name");
+        return (CFGPACK_ERR_DUPLICATE);
+    }
+    sort_entries(opts->entries, opts->values, count, entry_cmp_index);
+    if (first_adjacent_equal(opts->entries, count, entry_cmp_index)) {
+        set_err(opts->err, 0, "duplicate index");
+        return (CFGPACK_ERR_DUPLICATE);
+    }
     opts->out_schema->entries = opts->entries;
     opts->out_schema->entry_count = count;
 
     pool_needed = compute_str_offsets(opts->entries, count, opts->str_offsets,
-                                      opts->str_offsets_count);
-    if (pool_needed > UINT16_MAX) {
+                                      opts->str_offsets_count, &slots);
+    if (slots > CFGPACK_STR_SLOT_NONE) {
+        set_err(opts->err, 0, "too many string entries");
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    if (cow) {
+        return (CFGPACK_OK);
+    }
+    if (pool_needed > CFGPACK_STR_OFF_MAX) {
         set_err(opts->err, 0, "string pool exceeds offset range");
         return (CFGPACK_ERR_BOUNDS);
     }
@@ -619,7 +763,7 @@ static cfgpack_err_t schema_finalize(const cfgpack_parse_opts_t *opts,
         set_err(opts->err, 0, "string pool too small");
         return (CFGPACK_ERR_BOUNDS);
     }
-    if (opts->str_pool_cap > 0) {
+    if (opts->str_pool_cap > 0 && !filled) {
         memset(opts->str_pool, 0, opts->str_pool_cap);
     }
 
@@ -638,15 +782,24 @@ static cfgpack_err_t schema_finalize(const cfgpack_parse_opts_t *opts,
  */
 typedef struct {
     int measuring;
+    int cow; /**< String defaults stay in the msgpack source blob. */
+    int stream; /**< One pass over a windowed source; see mp_stream_store(). */
     cfgpack_schema_t *out_schema;
     cfgpack_entry_t *entries;
     size_t max_entries;
     cfgpack_value_t *values;
     char *str_pool;
-    uint16_t *str_offsets;
+    cfgpack_str_off_t *str_offsets;
+    size_t str_pool_cap;
+    size_t str_offsets_count;
+    size_t pool_used; /**< Stream mode: pool bytes handed out so far. */
+    size_t slots;     /**< Stream mode: string slots handed out so far. */
     size_t count;
     size_t str_count;
     size_t fstr_count;
+    size_t str_pool_size;
+    size_t blob_values; /**< Sum of cfgpack_value_enc_max() so far. */
+    uint16_t max_index;
     cfgpack_parse_error_t *err;
 } parse_ctx_t;
 
@@ -674,11 +827,26 @@ static cfgpack_err_t parse_ctx_init(parse_ctx_t *ctx,
         ctx->values = opts->values;
         ctx->str_pool = opts->str_pool;
         ctx->str_offsets = opts->str_offsets;
+        ctx->str_pool_cap = opts->str_pool_cap;
+        ctx->str_offsets_count = opts->str_offsets_count;
         memset(ctx->values, 0, ctx->max_entries * sizeof(cfgpack_value_t));
     }
     return (CFGPACK_OK);
 }
 
+/**
+ * @brief Dense index table size for a schema, or 0 if it is too sparse.
+ *
+ * Table slots hold uint8_t entry offsets with UINT8_MAX as "absent", so
+ * schemas with UINT8_MAX or more entries cannot use one either.
+ */
+static size_t index_table_size(uint16_t max_index, size_t count) {
+    if ((size_t)max_index >= CFGPACK_INDEX_TABLE_MAX || count >= UINT8_MAX) {
+        return (0);
+    }
+    return ((size_t)max_index + 1);
+}
+
 /**
  * @brief Fill a cfgpack_schema_measure_t from the accumulated context counts.
  */
@@ -687,8 +855,10 @@ static void fill_measure(const parse_ctx_t *ctx,
     measure->entry_count = ctx->count;
     measure->str_count = ctx->str_count;
     measure->fstr_count = ctx->fstr_count;
-    measure->str_pool_size = ctx->str_count * (CFGPACK_STR_MAX + 1) +
-                             ctx->fstr_count * (CFGPACK_FSTR_MAX + 1);
+    measure->str_pool_size = ctx->str_pool_size;
+    measure->index_table_size = index_table_size(ctx->max_index, ctx->count);
+    measure->blob_max =
+        cfgpack_blob_enc_max(ctx->count, ctx->max_index, ctx->blob_values);
 }
 
 /* ─────────────────────────────────────────────────────────────────────────────
@@ -749,6 +919,7 @@ static cfgpack_err_t map_parse_header(parse_ctx_t *ctx,
 static cfgpack_err_t map_parse_entry(parse_ctx_t *ctx,
                                      tokens_t *tok,
                                      char *line_buf,
+                                     size_t line_off,
                                      size_t stop_offset,
                                      size_t line_no) {
     cfgpack_fat_value_t fat_default;
@@ -759,6 +930,7 @@ static cfgpack_err_t map_parse_entry(parse_ctx_t *ctx,
     cfgpack_type_t type;
     cfgpack_err_t drc;
     cfgpack_err_t trc;
+    uint8_t str_max;
     uint8_t has_def;
     size_t name_len;
 
@@ -776,7 +948,7 @@ static cfgpack_err_t map_parse_entry(parse_ctx_t *ctx,
         set_err(ctx->err, line_no, "index 0 is reserved for schema name");
         return (CFGPACK_ERR_RESERVED_INDEX);
     }
-    trc = parse_type(tok->index[2], &type);
+    trc = parse_type_len(tok->index[2], &type, &str_max);
     if (trc != CFGPACK_OK) {
         set_err(ctx->err, line_no, "invalid type");
         return (trc);
@@ -785,11 +957,6 @@ static cfgpack_err_t map_parse_entry(parse_ctx_t *ctx,
         set_err(ctx->err, line_no, "name too long");
         return (CFGPACK_ERR_BOUNDS);
     }
-    if (!ctx->measuring && has_duplicate(ctx->entries, ctx->count,
-                                         (uint16_t)idx_ul, tok->index[1])) {
-        set_err(ctx->err, line_no, "duplicate");
-        return (CFGPACK_ERR_DUPLICATE);
-    }
 
     /* Extract default value from remainder of line */
     remainder = line_buf + stop_offset;
@@ -807,12 +974,25 @@ static cfgpack_err_t map_parse_entry(parse_ctx_t *ctx,
         set_err(ctx->err, line_no, "invalid default value");
         return (drc);
     }
+    if (has_def && str_max != 0 &&
+        (type == CFGPACK_TYPE_STR ? fat_default.v.str.len
+                                  : fat_default.v.fstr.len) > str_max) {
+        set_err(ctx->err, line_no, "default longer than declared max");
+        return (CFGPACK_ERR_STR_TOO_LONG);
+    }
 
+    if ((uint16_t)idx_ul > ctx->max_index) {
+        ctx->max_index = (uint16_t)idx_ul;
+    }
     if (ctx->measuring) {
+        ctx->blob_values +=
+            cfgpack_value_enc_max(type, str_limit(type, str_max));
         if (type == CFGPACK_TYPE_STR) {
             ctx->str_count++;
+            ctx->str_pool_size += str_limit(type, str_max) + 1;
         } else if (type == CFGPACK_TYPE_FSTR) {
             ctx->fstr_count++;
+            ctx->str_pool_size += str_limit(type, str_max) + 1;
         }
     } else {
         ctx->entries[ctx->count].index = (uint16_t)idx_ul;
@@ -820,12 +1000,17 @@ static cfgpack_err_t map_parse_entry(parse_ctx_t *ctx,
         memcpy(ctx->entries[ctx->count].name, tok->index[1], name_len + 1);
         ctx->entries[ctx->count].type = type;
         ctx->entries[ctx->count].has_default = has_def;
+        ctx->entries[ctx->count].str_max = str_max;
 
-        /* Store scalar defaults directly into compact values */
+        /* Store scalar defaults directly; defer strings to Phase 2 */
         if (has_def && type != CFGPACK_TYPE_STR && type != CFGPACK_TYPE_FSTR) {
             fat_to_compact_scalar(&fat_default, &ctx->values[ctx->count]);
         } else {
             ctx->values[ctx->count].type = type;
+            if (has_def) {
+                defer_default(&ctx->values[ctx->count],
+                              line_off + stop_offset);
+            }
         }
     }
 
@@ -834,87 +1019,45 @@ static cfgpack_err_t map_parse_entry(parse_ctx_t *ctx,
 }
 
 /**
- * @brief Phase 2 of .map parsing: re-iterate lines and extract string defaults
- *        into the string pool at sorted positions.
+ * @brief Phase 2 of .map parsing: write string defaults into the string
+ *        pool at sorted positions.
+ *
+ * Only the default tokens recorded in Phase 1 are re-read; the rest of the
+ * input is not scanned again.
  */
 static void map_phase2(parse_ctx_t *ctx, const char *data, size_t data_len) {
-    char line_buf[MAX_LINE_LEN];
-    int header_read = 0;
-    const char *line;
-    line_iter_t iter;
-    size_t line_len;
-
-    line_iter_init(&iter, data, data_len);
-
-    while ((line = line_iter_next(&iter, &line_len)) != NULL) {
+    for (size_t i = 0; i < ctx->count; ++i) {
+        cfgpack_type_t type = ctx->entries[i].type;
         cfgpack_fat_value_t fat_default;
         char default_tok[MAX_LINE_LEN];
-        unsigned long idx_ul;
-        const char *remainder;
-        size_t stop_offset = 0;
+        char line_buf[MAX_LINE_LEN];
         const char *def_str;
-        cfgpack_type_t type;
-        uint8_t has_def;
-        char *slots[4];
-        tokens_t tok;
-        int pos;
-        if (is_blank_or_comment_n(line, line_len)) {
-            continue;
-        }
-
-        if (line_len >= sizeof(line_buf)) {
-            continue; /* already validated */
-        }
-        memcpy(line_buf, line, line_len);
-        line_buf[line_len] = '\0';
-
-        if (tokens_create(&tok, 4, slots) != 0) {
-            continue;
-        }
-
-        if (!header_read) {
-            tokens_destroy(&tok);
-            header_read = 1;
-            continue;
-        }
+        uint8_t has_def = 0;
+        size_t src_off;
+        size_t len = 0;
 
-        tokens_find(&tok, line_buf, " \t\r\n", 3, &stop_offset);
-        if (tok.used < 3) {
-            tokens_destroy(&tok);
+        if (!ctx->entries[i].has_default ||
+            (type != CFGPACK_TYPE_STR && type != CFGPACK_TYPE_FSTR)) {
             continue;
         }
 
-        idx_ul = strtoul(tok.index[0], NULL, 10);
-        parse_type(tok.index[2], &type);
-
-        /* Only process string entries with defaults */
-        if (type != CFGPACK_TYPE_STR && type != CFGPACK_TYPE_FSTR) {
-            tokens_destroy(&tok);
-            continue;
+        /* Copy the rest of the line; Phase 1 bounded its length */
+        src_off = take_deferred(&ctx->values[i]);
+        while (src_off + len < data_len && len < sizeof(line_buf) - 1 &&
+               data[src_off + len] != '\n' && data[src_off + len] != '\r') {
+            len++;
         }
+        memcpy(line_buf, data + src_off, len);
+        line_buf[len] = '\0';
 
-        remainder = line_buf + stop_offset;
-        def_str = extract_default_token(remainder, default_tok,
+        def_str = extract_default_token(line_buf, default_tok,
                                         sizeof(default_tok));
-        if (!def_str || strcmp(def_str, "NIL") == 0) {
-            tokens_destroy(&tok);
-            continue;
-        }
-
-        /* Parse string default into stack-local fat value */
-        has_def = 0;
-        parse_default(def_str, type, &fat_default, &has_def);
-
-        if (has_def) {
-            /* Find this entry's position in the sorted array */
-            pos = find_entry_pos(ctx->entries, ctx->count, (uint16_t)idx_ul);
-            if (pos >= 0) {
-                fat_str_to_pool(&fat_default, (size_t)pos, ctx->values,
-                                ctx->entries, ctx->str_pool, ctx->str_offsets);
-            }
+        if (def_str && parse_default(def_str, type, &fat_default, &has_def) ==
+                           CFGPACK_OK &&
+            has_def) {
+            fat_str_to_pool(&fat_default, i, ctx->values, ctx->entries,
+                            ctx->str_pool, ctx->str_offsets);
         }
-
-        tokens_destroy(&tok);
     }
 }
 
@@ -993,7 +1136,8 @@ static cfgpack_err_t parse_schema_map_impl(const char *data,
             return (CFGPACK_ERR_PARSE);
         }
 
-        rc = map_parse_entry(&ctx, &tok, line_buf, stop_offset, line_no);
+        rc = map_parse_entry(&ctx, &tok, line_buf, (size_t)(line - data),
+                             stop_offset, line_no);
         tokens_destroy(&tok);
         if (rc != CFGPACK_OK) {
             return (rc);
@@ -1012,12 +1156,12 @@ static cfgpack_err_t parse_schema_map_impl(const char *data,
     }
 
     /* ── Parse mode: finalize and extract string defaults ──────────────── */
-    rc = schema_finalize(opts, ctx.count);
+    rc = schema_finalize(opts, ctx.count, 0, 0);
     if (rc != CFGPACK_OK) {
         return (rc);
     }
 
-    /* ── Phase 2: Re-parse input to extract string defaults ───────────── */
+    /* ── Phase 2: Write the string defaults recorded in Phase 1 ─────────── */
     map_phase2(&ctx, data, data_len);
 
     return (CFGPACK_OK);
@@ -1030,10 +1174,15 @@ static cfgpack_err_t parse_schema_map_impl(const char *data,
 cfgpack_err_t cfgpack_parse_schema(const char *data,
                                    size_t data_len,
                                    const cfgpack_parse_opts_t *opts) {
+    cfgpack_err_t rc;
+
     if (!opts || !data) {
         return (CFGPACK_ERR_ARGS);
     }
-    return (parse_schema_map_impl(data, data_len, opts, NULL, opts->err));
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PARSE, NULL);
+    rc = parse_schema_map_impl(data, data_len, opts, NULL, opts->err);
+    CFGPACK_STAT_END(CFGPACK_STATS_PARSE, NULL);
+    return (rc);
 }
 
 void cfgpack_schema_free(cfgpack_schema_t *schema) {
@@ -1097,14 +1246,11 @@ static void write_json_string_to_wbuf(wbuf_t *w, const char *str, size_t len) {
     wbuf_putc(w, '"');
 }
 
-static void write_json_value_to_wbuf(wbuf_t *w,
-                                     const cfgpack_entry_t *entry,
-                                     const cfgpack_value_t *val,
-                                     const char *str_pool) {
-    if (!entry->has_default) {
-        wbuf_puts(w, "null");
-        return;
-    }
+static void write_json_scalar_to_wbuf(wbuf_t *w,
+                                      const cfgpack_ctx_t *ctx,
+                                      const cfgpack_entry_t *entry,
+                                      const cfgpack_value_t *val) {
+    const char *s;
 
     switch (entry->type) {
     case CFGPACK_TYPE_U8:
@@ -1118,16 +1264,27 @@ static void write_json_value_to_wbuf(wbuf_t *w,
     case CFGPACK_TYPE_F32: wbuf_put_float(w, val->v.f32); break;
     case CFGPACK_TYPE_F64: wbuf_put_double(w, val->v.f64); break;
     case CFGPACK_TYPE_STR:
-        write_json_string_to_wbuf(w, str_pool + val->v.str.offset,
-                                  val->v.str.len);
+        s = cfgpack_str_data(ctx, entry, val);
+        write_json_string_to_wbuf(w, s ? s : "", s ? val->v.str.len : 0);
         break;
     case CFGPACK_TYPE_FSTR:
-        write_json_string_to_wbuf(w, str_pool + val->v.fstr.offset,
-                                  val->v.fstr.len);
+        s = cfgpack_str_data(ctx, entry, val);
+        write_json_string_to_wbuf(w, s ? s : "", s ? val->v.fstr.len : 0);
         break;
     }
 }
 
+static void write_json_value_to_wbuf(wbuf_t *w,
+                                     const cfgpack_ctx_t *ctx,
+                                     const cfgpack_entry_t *entry,
+                                     const cfgpack_value_t *val) {
+    if (!entry->has_default) {
+        wbuf_puts(w, "null");
+        return;
+    }
+    write_json_scalar_to_wbuf(w, ctx, entry, val);
+}
+
 cfgpack_err_t cfgpack_schema_write_json(const cfgpack_ctx_t *ctx,
                                         char *out,
                                         size_t out_cap,
@@ -1148,14 +1305,25 @@ cfgpack_err_t cfgpack_schema_write_json(const cfgpack_ctx_t *ctx,
 
     for (size_t i = 0; i < schema->entry_count; ++i) {
         const cfgpack_entry_t *e = &schema->entries[i];
+        cfgpack_value_t v;
+        cfgpack_err_t rc;
         wbuf_puts(&w, "    {\"index\": ");
         wbuf_put_uint(&w, e->index);
         wbuf_puts(&w, ", \"name\": \"");
         wbuf_puts(&w, e->name);
         wbuf_puts(&w, "\", \"type\": \"");
         wbuf_puts(&w, type_to_str(e->type));
+        if (e->str_max) {
+            wbuf_puts(&w, ":");
+            wbuf_put_uint(&w, e->str_max);
+        }
         wbuf_puts(&w, "\", \"value\": ");
-        write_json_value_to_wbuf(&w, e, &ctx->values[i], ctx->str_pool);
+        rc = cfgpack_lazy_load(ctx, i);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        cfgpack_value_load(ctx, i, &v);
+        write_json_value_to_wbuf(&w, ctx, e, &v);
         if (i + 1 < schema->entry_count) {
             wbuf_puts(&w, "},\n");
         } else {
@@ -1195,7 +1363,9 @@ static void json_skip_ws(json_parser_t *p) {
         if (c == '\n') {
             p->line++;
             p->pos++;
-        } else if (c == ' ' || c == '\t' || c == '\r') {
+        } else if (c == ' ') {
+            p->pos += cfgpack_scan_run(p->data + p->pos, p->len - p->pos, ' ');
+        } else if (c == '\t' || c == '\r') {
             p->pos++;
         } else {
             break;
@@ -1231,11 +1401,25 @@ static int json_parse_string(json_parser_t *p,
 
     size_t len = 0;
     while (p->pos < p->len && p->data[p->pos] != '"') {
+        if (p->data[p->pos] != '\\') {
+            /* Copy the run of plain characters up to the next quote or
+             * backslash in one step. */
+            size_t run = cfgpack_scan_any2(p->data + p->pos,
+                                           p->len - p->pos, '"', '\\');
+            if (run > out_cap - 1 - len) {
+                return 0; /* overflow */
+            }
+            memcpy(out + len, p->data + p->pos, run);
+            len += run;
+            p->pos += run;
+            continue;
+        }
+
         if (len >= out_cap - 1) {
             return 0; /* overflow */
         }
 
-        if (p->data[p->pos] == '\\' && p->pos + 1 < p->len) {
+        if (p->pos + 1 < p->len) {
             p->pos++;
             switch (p->data[p->pos]) {
             case 'n': out[len++] = '\n'; break;
@@ -1372,18 +1556,26 @@ static int json_match_literal(json_parser_t *p, const char *lit) {
 cfgpack_err_t cfgpack_schema_get_sizing(const cfgpack_schema_t *schema,
                                         cfgpack_schema_sizing_t *out) {
     size_t str_pool_size = 0;
+    uint16_t max_index = 0;
     size_t fstr_count = 0;
     size_t str_count = 0;
+    size_t values = 0;
 
     for (size_t i = 0; i < schema->entry_count; ++i) {
+        if (schema->entries[i].index > max_index) {
+            max_index = schema->entries[i].index;
+        }
+        values += cfgpack_value_enc_max(
+            schema->entries[i].type,
+            cfgpack_entry_str_max(&schema->entries[i]));
         switch (schema->entries[i].type) {
         case CFGPACK_TYPE_STR:
             str_count++;
-            str_pool_size += CFGPACK_STR_MAX + 1; /* Fixed slot per entry */
+            str_pool_size += cfgpack_entry_str_max(&schema->entries[i]) + 1;
             break;
         case CFGPACK_TYPE_FSTR:
             fstr_count++;
-            str_pool_size += CFGPACK_FSTR_MAX + 1; /* Fixed slot per entry */
+            str_pool_size += cfgpack_entry_str_max(&schema->entries[i]) + 1;
             break;
         default: break;
         }
@@ -1392,10 +1584,46 @@ cfgpack_err_t cfgpack_schema_get_sizing(const cfgpack_schema_t *schema,
     out->str_count = str_count;
     out->fstr_count = fstr_count;
     out->str_pool_size = str_pool_size;
+    out->index_table_size = index_table_size(max_index, schema->entry_count);
+    out->blob_max = cfgpack_blob_enc_max(schema->entry_count, max_index,
+                                         values);
 
     return (CFGPACK_OK);
 }
 
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Schema Hash
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+uint32_t cfgpack_schema_hash(const cfgpack_schema_t *schema) {
+    uint32_t crc = cfgpack_crc32c_init();
+    uint8_t buf[4];
+
+    crc = cfgpack_crc32c_update(crc, (const uint8_t *)schema->map_name,
+                                strlen(schema->map_name) + 1);
+    buf[0] = (uint8_t)(schema->version);
+    buf[1] = (uint8_t)(schema->version >> 8);
+    buf[2] = (uint8_t)(schema->version >> 16);
+    buf[3] = (uint8_t)(schema->version >> 24);
+    crc = cfgpack_crc32c_update(crc, buf, 4);
+
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        const cfgpack_entry_t *e = &schema->entries[i];
+        buf[0] = (uint8_t)(e->index);
+        buf[1] = (uint8_t)(e->index >> 8);
+        buf[2] = (uint8_t)e->type;
+        crc = cfgpack_crc32c_update(crc, buf, 3);
+        crc = cfgpack_crc32c_update(crc, (const uint8_t *)e->name,
+                                    strlen(e->name) + 1);
+        /* Declared max lengths change the pool layout; hashed only when
+         * set so schemas without them keep their hash. */
+        if (e->str_max) {
+            crc = cfgpack_crc32c_update(crc, &e->str_max, 1);
+        }
+    }
+    return (cfgpack_crc32c_final(crc));
+}
+
 /* ─────────────────────────────────────────────────────────────────────────────
  * Schema Measure (.map format) — public wrapper
  * ───────────────────────────────────────────────────────────────────────────── */
@@ -1461,11 +1689,13 @@ typedef struct {
     int64_t default_ival;
     double default_fval;
     size_t default_str_len;
+    size_t default_pos; /**< Offset of a string default's opening quote. */
     int got_index;
     int got_ename;
     int got_type;
     int got_default;
     cfgpack_type_t entry_type;
+    uint8_t str_max;
     int default_is_null;
     int default_is_string;
     int default_is_number;
@@ -1512,6 +1742,9 @@ static cfgpack_err_t json_parse_entry_fields(parse_ctx_t *ctx,
             if (!ctx->measuring) {
                 e->index = (uint16_t)idx;
             }
+            if ((uint16_t)idx > ctx->max_index) {
+                ctx->max_index = (uint16_t)idx;
+            }
             f->got_index = 1;
         } else if (strcmp(ekey, "name") == 0) {
             char name_buf[32];
@@ -1536,10 +1769,11 @@ static cfgpack_err_t json_parse_entry_fields(parse_ctx_t *ctx,
                 return (CFGPACK_ERR_PARSE);
             }
             if (ctx->measuring) {
-                trc = parse_type(type_buf, &f->entry_type);
+                trc = parse_type_len(type_buf, &f->entry_type, &f->str_max);
             } else {
-                trc = parse_type(type_buf, &e->type);
+                trc = parse_type_len(type_buf, &e->type, &f->str_max);
                 f->entry_type = e->type;
+                e->str_max = f->str_max;
             }
             if (trc != CFGPACK_OK) {
                 set_err(ctx->err, p->line, "invalid type");
@@ -1551,6 +1785,7 @@ static cfgpack_err_t json_parse_entry_fields(parse_ctx_t *ctx,
             if (json_match_literal(p, "null")) {
                 f->default_is_null = 1;
             } else if (c == '"') {
+                f->default_pos = p->pos;
                 if (!json_parse_string(p, f->default_str,
                                        sizeof(f->default_str),
                                        &f->default_str_len)) {
@@ -1560,7 +1795,8 @@ static cfgpack_err_t json_parse_entry_fields(parse_ctx_t *ctx,
                 /* Validate string length against type if known */
                 if (ctx->measuring && f->got_type &&
                     f->entry_type == CFGPACK_TYPE_FSTR &&
-                    f->default_str_len > CFGPACK_FSTR_MAX) {
+                    f->default_str_len > str_limit(f->entry_type,
+                                                   f->str_max)) {
                     set_err(ctx->err, p->line, "fstr too long");
                     return (CFGPACK_ERR_STR_TOO_LONG);
                 }
@@ -1585,27 +1821,44 @@ static cfgpack_err_t json_parse_entry_fields(parse_ctx_t *ctx,
 }
 
 /**
- * @brief Store numeric defaults and check duplicates after parsing one entry.
+ * @brief Store numeric defaults after parsing one entry.
  *
- * String defaults are deferred to Phase 2.
+ * String defaults are deferred to Phase 2, which re-reads them at the
+ * recorded position.  A default whose kind (string or number) does not
+ * match the entry type is rejected.
  */
 static cfgpack_err_t json_store_entry_defaults(parse_ctx_t *ctx,
                                                json_parser_t *p,
                                                cfgpack_entry_t *e,
                                                const json_entry_fields_t *f) {
+    int type_is_str = (e->type == CFGPACK_TYPE_STR ||
+                       e->type == CFGPACK_TYPE_FSTR);
+
+    if (type_is_str && f->default_is_number) {
+        set_err(ctx->err, p->line,
+                "default value is numeric but type is string");
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    if (!type_is_str && f->default_is_string) {
+        set_err(ctx->err, p->line,
+                "default value is string but type is numeric");
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+
     if (f->default_is_null) {
         e->has_default = 0;
         ctx->values[ctx->count].type = e->type;
     } else if (f->default_is_string) {
         e->has_default = 1;
         ctx->values[ctx->count].type = e->type;
+        defer_default(&ctx->values[ctx->count], f->default_pos);
         if (e->type == CFGPACK_TYPE_FSTR) {
-            if (f->default_str_len > CFGPACK_FSTR_MAX) {
+            if (f->default_str_len > cfgpack_entry_str_max(e)) {
                 set_err(ctx->err, p->line, "fstr too long");
                 return (CFGPACK_ERR_STR_TOO_LONG);
             }
         } else {
-            if (f->default_str_len > CFGPACK_STR_MAX) {
+            if (f->default_str_len > cfgpack_entry_str_max(e)) {
                 set_err(ctx->err, p->line, "str too long");
                 return (CFGPACK_ERR_STR_TOO_LONG);
             }
@@ -1639,12 +1892,6 @@ static cfgpack_err_t json_store_entry_defaults(parse_ctx_t *ctx,
         default: break;
         }
     }
-
-    /* Check for duplicates */
-    if (has_duplicate(ctx->entries, ctx->count, e->index, e->name)) {
-        set_err(ctx->err, p->line, "duplicate");
-        return (CFGPACK_ERR_DUPLICATE);
-    }
     return (CFGPACK_OK);
 }
 
@@ -1694,10 +1941,14 @@ static cfgpack_err_t json_parse_one_entry(parse_ctx_t *ctx, json_parser_t *p) {
     }
 
     if (ctx->measuring) {
+        ctx->blob_values += cfgpack_value_enc_max(
+            f.entry_type, str_limit(f.entry_type, f.str_max));
         if (f.entry_type == CFGPACK_TYPE_STR) {
             ctx->str_count++;
+            ctx->str_pool_size += str_limit(f.entry_type, f.str_max) + 1;
         } else if (f.entry_type == CFGPACK_TYPE_FSTR) {
             ctx->fstr_count++;
+            ctx->str_pool_size += str_limit(f.entry_type, f.str_max) + 1;
         }
     } else {
         if (e->index == 0) {
@@ -1715,131 +1966,42 @@ static cfgpack_err_t json_parse_one_entry(parse_ctx_t *ctx, json_parser_t *p) {
 }
 
 /**
- * @brief Phase 2 of JSON parsing: re-parse to extract string/fstr defaults
- *        into the string pool at sorted positions.
+ * @brief Phase 2 of JSON parsing: write string/fstr defaults into the
+ *        string pool at sorted positions.
+ *
+ * Each default is decoded again at the position recorded in Phase 1;
+ * the rest of the input is not scanned again.
  */
 static void json_phase2(parse_ctx_t *ctx, const char *data, size_t data_len) {
-    json_parser_t p2 = {data, data_len, 0, 1};
-    json_parser_t *jp = &p2;
-
-    if (!json_expect(jp, '{')) {
-        return; /* should not happen */
-    }
-
-    while (json_peek(jp) != '}' && json_peek(jp) != '\0') {
-        size_t key_len;
-        char key[32];
-        if (!json_parse_string(jp, key, sizeof(key), &key_len)) {
-            break;
-        }
-        if (!json_expect(jp, ':')) {
-            break;
+    for (size_t i = 0; i < ctx->count; ++i) {
+        cfgpack_type_t type = ctx->entries[i].type;
+        json_parser_t p2 = {data, data_len, 0, 0};
+        cfgpack_fat_value_t fat;
+        size_t str_len = 0;
+
+        if (!ctx->entries[i].has_default ||
+            (type != CFGPACK_TYPE_STR && type != CFGPACK_TYPE_FSTR)) {
+            continue;
         }
 
-        if (strcmp(key, "entries") == 0) {
-            if (!json_expect(jp, '[')) {
-                break;
+        p2.pos = take_deferred(&ctx->values[i]);
+        memset(&fat, 0, sizeof(fat));
+        fat.type = type;
+        if (type == CFGPACK_TYPE_FSTR) {
+            if (!json_parse_string(&p2, fat.v.fstr.data,
+                                   sizeof(fat.v.fstr.data), &str_len)) {
+                continue;
             }
-
-            while (json_peek(jp) != ']' && json_peek(jp) != '\0') {
-                char str_data[CFGPACK_STR_MAX + 1];
-                int has_string_default;
-                cfgpack_type_t entry_type;
-                int entry_has_default;
-                uint16_t entry_index;
-                size_t str_len;
-
-                if (!json_expect(jp, '{')) {
-                    break;
-                }
-
-                entry_index = 0;
-                entry_type = CFGPACK_TYPE_U8;
-                has_string_default = 0;
-                str_len = 0;
-                entry_has_default = 0;
-
-                while (json_peek(jp) != '}' && json_peek(jp) != '\0') {
-                    size_t ekey_len;
-                    char ekey[32];
-                    if (!json_parse_string(jp, ekey, sizeof(ekey), &ekey_len)) {
-                        break;
-                    }
-                    if (!json_expect(jp, ':')) {
-                        break;
-                    }
-
-                    if (strcmp(ekey, "index") == 0) {
-                        double idx_f;
-                        int is_float;
-                        int64_t idx;
-                        json_parse_number(jp, &idx, &idx_f, &is_float);
-                        entry_index = (uint16_t)idx;
-                    } else if (strcmp(ekey, "name") == 0) {
-                        char tmp[32];
-                        json_parse_string(jp, tmp, sizeof(tmp), NULL);
-                    } else if (strcmp(ekey, "type") == 0) {
-                        char type_buf[16];
-                        json_parse_string(jp, type_buf, sizeof(type_buf), NULL);
-                        parse_type(type_buf, &entry_type);
-                    } else if (strcmp(ekey, "value") == 0) {
-                        char c = json_peek(jp);
-                        if (json_match_literal(jp, "null")) {
-                            /* no default */
-                        } else if (c == '"') {
-                            if (json_parse_string(jp, str_data,
-                                                  sizeof(str_data), &str_len)) {
-                                has_string_default = 1;
-                                entry_has_default = 1;
-                            }
-                        } else {
-                            int64_t iv;
-                            double fv;
-                            int isf;
-                            json_parse_number(jp, &iv, &fv, &isf);
-                            entry_has_default = 1;
-                        }
-                    }
-                    json_expect(jp, ',');
-                }
-                json_expect(jp, '}');
-
-                /* Write string default to pool if applicable */
-                if (has_string_default && entry_has_default &&
-                    (entry_type == CFGPACK_TYPE_STR ||
-                     entry_type == CFGPACK_TYPE_FSTR)) {
-                    int pos = find_entry_pos(ctx->entries, ctx->count,
-                                             entry_index);
-                    if (pos >= 0) {
-                        cfgpack_fat_value_t fat;
-                        memset(&fat, 0, sizeof(fat));
-                        fat.type = entry_type;
-                        if (entry_type == CFGPACK_TYPE_FSTR) {
-                            fat.v.fstr.len = (uint8_t)str_len;
-                            memcpy(fat.v.fstr.data, str_data, str_len + 1);
-                        } else {
-                            fat.v.str.len = (uint16_t)str_len;
-                            memcpy(fat.v.str.data, str_data, str_len + 1);
-                        }
-                        fat_str_to_pool(&fat, (size_t)pos, ctx->values,
-                                        ctx->entries, ctx->str_pool,
-                                        ctx->str_offsets);
-                    }
-                }
-
-                json_expect(jp, ',');
+            fat.v.fstr.len = (uint8_t)str_len;
+        } else {
+            if (!json_parse_string(&p2, fat.v.str.data, sizeof(fat.v.str.data),
+                                   &str_len)) {
+                continue;
             }
-            json_expect(jp, ']');
-        } else if (strcmp(key, "name") == 0) {
-            char tmp[64];
-            json_parse_string(jp, tmp, sizeof(tmp), NULL);
-        } else if (strcmp(key, "version") == 0) {
-            int64_t v;
-            double vf;
-            int isf;
-            json_parse_number(jp, &v, &vf, &isf);
+            fat.v.str.len = (uint16_t)str_len;
         }
-        json_expect(jp, ',');
+        fat_str_to_pool(&fat, i, ctx->values, ctx->entries, ctx->str_pool,
+                        ctx->str_offsets);
     }
 }
 
@@ -1948,12 +2110,12 @@ static cfgpack_err_t parse_schema_json_impl(const char *data,
     }
 
     /* ── Parse mode: finalize and extract string defaults ──────────────── */
-    rc = schema_finalize(opts, ctx.count);
+    rc = schema_finalize(opts, ctx.count, 0, 0);
     if (rc != CFGPACK_OK) {
         return (rc);
     }
 
-    /* ── Phase 2: Re-parse JSON to extract string defaults ────────────── */
+    /* ── Phase 2: Write the string defaults recorded in Phase 1 ─────────── */
     json_phase2(&ctx, data, data_len);
 
     return (CFGPACK_OK);
@@ -1980,91 +2142,330 @@ cfgpack_err_t cfgpack_schema_measure_json(const char *data,
 cfgpack_err_t cfgpack_schema_parse_json(const char *data,
                                         size_t data_len,
                                         const cfgpack_parse_opts_t *opts) {
+    cfgpack_err_t rc;
+
     if (!opts || !data) {
         return (CFGPACK_ERR_ARGS);
     }
-    return (parse_schema_json_impl(data, data_len, opts, NULL, opts->err));
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PARSE, NULL);
+    rc = parse_schema_json_impl(data, data_len, opts, NULL, opts->err);
+    CFGPACK_STAT_END(CFGPACK_STATS_PARSE, NULL);
+    return (rc);
 }
 
 /* ─────────────────────────────────────────────────────────────────────────────
- * MessagePack Schema - Helpers
+ * Config Values JSON — writer
  * ───────────────────────────────────────────────────────────────────────────── */
 
-/* Top-level schema msgpack keys */
-#define MP_SCHEMA_KEY_NAME 0
-#define MP_SCHEMA_KEY_VERSION 1
-#define MP_SCHEMA_KEY_ENTRIES 2
+cfgpack_err_t cfgpack_values_write_json(const cfgpack_ctx_t *ctx,
+                                        char *out,
+                                        size_t out_cap,
+                                        size_t *out_len,
+                                        cfgpack_parse_error_t *err) {
+    const cfgpack_schema_t *schema;
+    int first = 1;
+    wbuf_t w;
 
-/* Per-entry schema msgpack keys */
-#define MP_ENTRY_KEY_INDEX 0
-#define MP_ENTRY_KEY_NAME 1
-#define MP_ENTRY_KEY_TYPE 2
-#define MP_ENTRY_KEY_VALUE 3
+    if (!ctx || (!out && out_cap)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    schema = ctx->schema;
+    wbuf_init(&w, out, out_cap);
 
-/* Number of valid cfgpack_type_t enum values */
-#define MP_TYPE_COUNT 12
+    wbuf_putc(&w, '{');
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        const cfgpack_entry_t *e = &schema->entries[i];
+        cfgpack_value_t v;
+        cfgpack_err_t rc;
 
-/**
- * @brief Encode a msgpack array header into a buffer.
- *
- * fixarray (0x90 | count) for count 0-15, array16 (0xdc + 2 bytes) for
- * count 16-65535.
- */
-static cfgpack_err_t mp_encode_array_header(cfgpack_buf_t *buf,
-                                            uint32_t count) {
-    if (count <= 15) {
-        uint8_t b = (uint8_t)(0x90 | count);
-        return (cfgpack_buf_append(buf, &b, 1));
+        rc = cfgpack_lazy_load(ctx, i);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        if (!cfgpack_presence_get(ctx, i)) {
+            continue;
+        }
+        if (!first) {
+            wbuf_putc(&w, ',');
+        }
+        first = 0;
+        write_json_string_to_wbuf(&w, e->name, strlen(e->name));
+        wbuf_putc(&w, ':');
+        cfgpack_value_load(ctx, i, &v);
+        write_json_scalar_to_wbuf(&w, ctx, e, &v);
     }
-    if (count <= 0xFFFF) {
-        uint8_t hdr[3];
-        hdr[0] = 0xdc;
-        hdr[1] = (uint8_t)(count >> 8);
-        hdr[2] = (uint8_t)(count & 0xFF);
-        return (cfgpack_buf_append(buf, hdr, 3));
+    wbuf_puts(&w, "}\n");
+
+    if (out_len) {
+        *out_len = w.len;
     }
-    return (CFGPACK_ERR_ENCODE);
+
+    if (w.len > out_cap) {
+        set_err(err, 0, "buffer too small");
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    return (CFGPACK_OK);
 }
 
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Config Values JSON — parser
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** @brief One decoded "name": value member of a values object. */
+typedef struct {
+    const cfgpack_entry_t *entry;
+    cfgpack_value_t val;           /**< Numeric value, typed as the entry */
+    char str[CFGPACK_STR_MAX + 2]; /**< String value; one spare byte so a
+                                        too-long string still parses */
+} json_member_t;
+
 /**
- * @brief Decode a msgpack array header from the reader.
+ * @brief Parse a JSON number as a value of schema type @p type.
+ *
+ * Integers are range-checked against the type; floats are refused for
+ * integer types.  Float types accept any JSON number.
  */
-static cfgpack_err_t mp_decode_array_header(cfgpack_reader_t *r,
-                                            uint32_t *count) {
-    uint8_t b;
+static cfgpack_err_t json_parse_typed_number(json_parser_t *p,
+                                             cfgpack_type_t type,
+                                             cfgpack_value_t *out) {
+    char buf[64];
+    size_t start;
+    size_t n;
+    int64_t ival;
+    double fval;
+    int is_float;
 
-    if (r->pos >= r->len) {
-        return (CFGPACK_ERR_DECODE);
+    json_skip_ws(p);
+    start = p->pos;
+    if (!json_parse_number(p, &ival, &fval, &is_float)) {
+        return (CFGPACK_ERR_PARSE);
     }
-    b = r->data[r->pos];
-    if ((b & 0xF0) == 0x90) {
-        *count = b & 0x0F;
-        r->pos++;
-        return (CFGPACK_OK);
+    n = p->pos - start;
+    memcpy(buf, p->data + start, n);
+    buf[n] = '\0';
+    if (buf[buf[0] == '-'] < '0' || buf[buf[0] == '-'] > '9') {
+        return (CFGPACK_ERR_PARSE);
     }
-    if (b == 0xdc) {
-        if (r->pos + 3 > r->len) {
-            return (CFGPACK_ERR_DECODE);
+
+    out->type = type;
+    errno = 0;
+    switch (type) {
+    case CFGPACK_TYPE_F32: out->v.f32 = (float)strtod(buf, NULL); break;
+    case CFGPACK_TYPE_F64: out->v.f64 = strtod(buf, NULL); break;
+    case CFGPACK_TYPE_U8:
+    case CFGPACK_TYPE_U16:
+    case CFGPACK_TYPE_U32:
+    case CFGPACK_TYPE_U64: {
+        static const uint64_t umax[] = {UINT8_MAX, UINT16_MAX, UINT32_MAX,
+                                        UINT64_MAX};
+        unsigned long long u;
+
+        if (is_float) {
+            return (CFGPACK_ERR_TYPE_MISMATCH);
         }
-        r->pos++;
-        *count = ((uint32_t)r->data[r->pos] << 8) |
-                 (uint32_t)r->data[r->pos + 1];
-        r->pos += 2;
-        return (CFGPACK_OK);
+        if (buf[0] == '-') {
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        u = strtoull(buf, NULL, 10);
+        if (errno == ERANGE || u > umax[type - CFGPACK_TYPE_U8]) {
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        out->v.u64 = u;
+        break;
     }
-    if (b == 0xdd) {
-        if (r->pos + 5 > r->len) {
-            return (CFGPACK_ERR_DECODE);
+    case CFGPACK_TYPE_I8:
+    case CFGPACK_TYPE_I16:
+    case CFGPACK_TYPE_I32:
+    case CFGPACK_TYPE_I64: {
+        static const int64_t imax[] = {INT8_MAX, INT16_MAX, INT32_MAX,
+                                       INT64_MAX};
+        int64_t hi = imax[type - CFGPACK_TYPE_I8];
+        long long i;
+
+        if (is_float) {
+            return (CFGPACK_ERR_TYPE_MISMATCH);
         }
-        r->pos++;
-        *count = ((uint32_t)r->data[r->pos] << 24) |
-                 ((uint32_t)r->data[r->pos + 1] << 16) |
-                 ((uint32_t)r->data[r->pos + 2] << 8) |
-                 (uint32_t)r->data[r->pos + 3];
-        r->pos += 4;
-        return (CFGPACK_OK);
+        i = strtoll(buf, NULL, 10);
+        if (errno == ERANGE || i > hi || i < -hi - 1) {
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        out->v.i64 = i;
+        break;
+    }
+    default: return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Parse and validate one member without touching the context.
+ */
+static cfgpack_err_t json_parse_member(const cfgpack_ctx_t *ctx,
+                                       json_parser_t *p,
+                                       json_member_t *m,
+                                       cfgpack_parse_error_t *err) {
+    char name[32];
+    size_t len;
+    cfgpack_err_t rc;
+
+    if (!json_parse_string(p, name, sizeof(name), NULL)) {
+        set_err(err, p->line, "expected value name");
+        return (CFGPACK_ERR_PARSE);
+    }
+    if (!json_expect(p, ':')) {
+        set_err(err, p->line, "expected ':'");
+        return (CFGPACK_ERR_PARSE);
+    }
+    m->entry = cfgpack_find_entry_by_name(ctx, name);
+    if (!m->entry) {
+        set_err(err, p->line, "unknown value name");
+        return (CFGPACK_ERR_MISSING);
+    }
+
+    if (m->entry->type != CFGPACK_TYPE_STR &&
+        m->entry->type != CFGPACK_TYPE_FSTR) {
+        rc = json_parse_typed_number(p, m->entry->type, &m->val);
+        if (rc == CFGPACK_ERR_BOUNDS) {
+            set_err(err, p->line, "value out of range");
+        } else if (rc == CFGPACK_ERR_TYPE_MISMATCH) {
+            set_err(err, p->line, "expected integer");
+        } else if (rc != CFGPACK_OK) {
+            set_err(err, p->line, "expected number");
+        }
+        return (rc);
+    }
+
+    if (json_peek(p) != '"') {
+        set_err(err, p->line, "expected string");
+        return (CFGPACK_ERR_TYPE_MISMATCH);
+    }
+    if (!json_parse_string(p, m->str, sizeof(m->str), &len)) {
+        set_err(err, p->line, "invalid string value");
+        return (CFGPACK_ERR_PARSE);
+    }
+    if (len > cfgpack_entry_str_max(m->entry)) {
+        set_err(err, p->line, "string too long");
+        return (CFGPACK_ERR_STR_TOO_LONG);
+    }
+    if (memchr(m->str, '\0', len)) {
+        set_err(err, p->line, "NUL in string value");
+        return (CFGPACK_ERR_PARSE);
+    }
+    return (CFGPACK_OK);
+}
+
+static cfgpack_err_t json_store_member(cfgpack_ctx_t *ctx,
+                                       const json_member_t *m) {
+    switch (m->entry->type) {
+    case CFGPACK_TYPE_STR:
+        return (cfgpack_set_str(ctx, m->entry->index, m->str));
+    case CFGPACK_TYPE_FSTR:
+        return (cfgpack_set_fstr(ctx, m->entry->index, m->str));
+    default: return (cfgpack_set(ctx, m->entry->index, &m->val));
+    }
+}
+
+/**
+ * @brief Walk a values object; store each member only when @p apply is set.
+ */
+static cfgpack_err_t values_json_walk(cfgpack_ctx_t *ctx,
+                                      const char *data,
+                                      size_t data_len,
+                                      int apply,
+                                      cfgpack_parse_error_t *err) {
+    json_parser_t parser = {data, data_len, 0, 1};
+    json_parser_t *p = &parser;
+    json_member_t m;
+    cfgpack_err_t rc;
+
+    if (!json_expect(p, '{')) {
+        set_err(err, p->line, "expected '{'");
+        return (CFGPACK_ERR_PARSE);
+    }
+    while (json_peek(p) != '}') {
+        rc = json_parse_member(ctx, p, &m, err);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        if (apply) {
+            rc = json_store_member(ctx, &m);
+            if (rc != CFGPACK_OK) {
+                set_err(err, p->line, "set failed");
+                return (rc);
+            }
+        }
+        if (!json_expect(p, ',')) {
+            break;
+        }
+    }
+    if (!json_expect(p, '}')) {
+        set_err(err, p->line, "expected '}'");
+        return (CFGPACK_ERR_PARSE);
+    }
+    if (json_peek(p) != '\0') {
+        set_err(err, p->line, "trailing data");
+        return (CFGPACK_ERR_PARSE);
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_values_parse_json(cfgpack_ctx_t *ctx,
+                                        const char *data,
+                                        size_t data_len,
+                                        cfgpack_parse_error_t *err) {
+    cfgpack_err_t rc;
+
+    if (!ctx || !data) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    /* Validate everything first so a bad document changes nothing */
+    rc = values_json_walk(ctx, data, data_len, 0, err);
+    if (rc == CFGPACK_OK) {
+        rc = values_json_walk(ctx, data, data_len, 1, err);
+    }
+    return (rc);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * MessagePack Schema - Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/* Top-level schema msgpack keys */
+#define MP_SCHEMA_KEY_NAME 0
+#define MP_SCHEMA_KEY_VERSION 1
+#define MP_SCHEMA_KEY_ENTRIES 2
+
+/* Per-entry schema msgpack keys */
+#define MP_ENTRY_KEY_INDEX 0
+#define MP_ENTRY_KEY_NAME 1
+#define MP_ENTRY_KEY_TYPE 2
+#define MP_ENTRY_KEY_VALUE 3
+#define MP_ENTRY_KEY_STR_MAX 4 /* optional; omitted means the type maximum */
+
+/* Number of valid cfgpack_type_t enum values */
+#define MP_TYPE_COUNT 12
+
+/**
+ * @brief Encode a msgpack array header into a buffer.
+ *
+ * fixarray (0x90 | count) for count 0-15, array16 (0xdc + 2 bytes) for
+ * count 16-65535.
+ */
+static cfgpack_err_t mp_encode_array_header(cfgpack_buf_t *buf,
+                                            uint32_t count) {
+    if (count <= 15) {
+        uint8_t b = (uint8_t)(0x90 | count);
+        return (cfgpack_buf_append(buf, &b, 1));
+    }
+    if (count <= 0xFFFF) {
+        uint8_t hdr[3];
+        hdr[0] = 0xdc;
+        hdr[1] = (uint8_t)(count >> 8);
+        hdr[2] = (uint8_t)(count & 0xFF);
+        return (cfgpack_buf_append(buf, hdr, 3));
     }
-    return (CFGPACK_ERR_DECODE);
+    return (CFGPACK_ERR_ENCODE);
 }
 
 /* ─────────────────────────────────────────────────────────────────────────────
@@ -2136,234 +2537,72 @@ static cfgpack_err_t mp_parse_header_version(parse_ctx_t *ctx,
 }
 
 /**
- * @brief Parse one entry from the entries array during Phase 1.
+ * @brief Temporary state for one entry during Phase 2 default decoding.
+ */
+typedef struct {
+    cfgpack_type_t entry_type;
+    int entry_has_default;
+    int has_string_default;
+    size_t str_off; /**< Offset of the string default's bytes in the blob. */
+    cfgpack_fat_value_t fat;
+    uint64_t def_u64;
+    int64_t def_i64;
+    float def_f32;
+    double def_f64;
+    int def_is_uint;
+    int def_is_int;
+    int def_is_f32;
+    int def_is_f64;
+} mp_p2_entry_t;
+
+/**
+ * @brief Initialise Phase 2 per-entry temporaries to zero/defaults.
+ */
+static void mp_p2_entry_init(mp_p2_entry_t *p2) {
+    p2->entry_type = CFGPACK_TYPE_U8;
+    p2->entry_has_default = 0;
+    p2->has_string_default = 0;
+    p2->str_off = 0;
+    memset(&p2->fat, 0, sizeof(p2->fat));
+    p2->def_u64 = 0;
+    p2->def_i64 = 0;
+    p2->def_f32 = 0;
+    p2->def_f64 = 0;
+    p2->def_is_uint = 0;
+    p2->def_is_int = 0;
+    p2->def_is_f32 = 0;
+    p2->def_is_f64 = 0;
+}
+
+/**
+ * @brief Decode the default value for one entry during Phase 2.
  *
- * Decodes entry fields (index, name, type, value) and validates them.
- * In measure mode only the type is tracked (for str/fstr counting).
- * In parse mode the entry is populated and checked for duplicates.
- * The default value is skipped — Phase 2 will re-decode it.
+ * Reads the wire-format byte and dispatches to the appropriate msgpack
+ * decoder (f32, f64, int64, str, or uint64).  Updates p2->def_is_*
+ * and p2->has_string_default flags accordingly.
  *
- * Increments ctx->count on success.
+ * Returns CFGPACK_OK on success (including nil / no-default).
  */
-static cfgpack_err_t mp_parse_one_entry(parse_ctx_t *ctx, cfgpack_reader_t *r) {
-    cfgpack_type_t entry_type = CFGPACK_TYPE_U8;
-    cfgpack_entry_t *e = NULL;
-    int default_is_nil = 0;
-    int got_default = 0;
-    int got_ename = 0;
-    int got_type = 0;
+static cfgpack_err_t mp_phase2_decode_value(cfgpack_reader_t *rp,
+                                            mp_p2_entry_t *p2,
+                                            cfgpack_parse_error_t *err) {
     cfgpack_err_t rc;
-    int got_idx = 0;
-    uint32_t ecount;
-
-    if (!ctx->measuring && ctx->count >= ctx->max_entries) {
-        set_err(ctx->err, 0, "too many entries");
-        return (CFGPACK_ERR_BOUNDS);
-    }
+    uint8_t vb;
 
-    rc = cfgpack_msgpack_decode_map_header(r, &ecount);
-    if (rc != CFGPACK_OK) {
-        set_err(ctx->err, 0, "expected entry map");
+    if (cfgpack_reader_peek(rp, &vb) != CFGPACK_OK) {
+        set_err(err, 0, "truncated default value");
         return (CFGPACK_ERR_DECODE);
     }
-
-    if (!ctx->measuring) {
-        e = &ctx->entries[ctx->count];
-        memset(e, 0, sizeof(*e));
+    if (vb == 0xC0) {
+        return (cfgpack_msgpack_skip_value(rp)); /* nil — no default */
     }
 
-    for (uint32_t ek = 0; ek < ecount; ++ek) {
-        uint64_t ekey;
+    p2->entry_has_default = 1;
 
-        rc = cfgpack_msgpack_decode_uint64(r, &ekey);
+    if (vb == 0xCA) {
+        rc = cfgpack_msgpack_decode_f32(rp, &p2->def_f32);
         if (rc != CFGPACK_OK) {
-            set_err(ctx->err, 0, "expected entry key");
-            return (CFGPACK_ERR_DECODE);
-        }
-
-        if (ekey == MP_ENTRY_KEY_INDEX) {
-            uint64_t idx;
-
-            rc = cfgpack_msgpack_decode_uint64(r, &idx);
-            if (rc != CFGPACK_OK) {
-                set_err(ctx->err, 0, "invalid index");
-                return (CFGPACK_ERR_DECODE);
-            }
-            if (idx == 0) {
-                set_err(ctx->err, 0, "index 0 is reserved for schema name");
-                return (CFGPACK_ERR_RESERVED_INDEX);
-            }
-            if (idx > 65535) {
-                set_err(ctx->err, 0, "index out of range");
-                return (CFGPACK_ERR_BOUNDS);
-            }
-            if (!ctx->measuring) {
-                e->index = (uint16_t)idx;
-            }
-            got_idx = 1;
-        } else if (ekey == MP_ENTRY_KEY_NAME) {
-            const uint8_t *nptr;
-            uint32_t nlen;
-
-            rc = cfgpack_msgpack_decode_str(r, &nptr, &nlen);
-            if (rc != CFGPACK_OK) {
-                set_err(ctx->err, 0, "invalid entry name");
-                return (CFGPACK_ERR_DECODE);
-            }
-            if (nlen > 5 || nlen == 0) {
-                set_err(ctx->err, 0, "name too long");
-                return (CFGPACK_ERR_BOUNDS);
-            }
-            if (!ctx->measuring) {
-                memcpy(e->name, nptr, nlen);
-                e->name[nlen] = '\0';
-            }
-            got_ename = 1;
-        } else if (ekey == MP_ENTRY_KEY_TYPE) {
-            uint64_t type_val;
-
-            rc = cfgpack_msgpack_decode_uint64(r, &type_val);
-            if (rc != CFGPACK_OK) {
-                set_err(ctx->err, 0, "invalid type");
-                return (CFGPACK_ERR_DECODE);
-            }
-            if (type_val >= MP_TYPE_COUNT) {
-                set_err(ctx->err, 0, "invalid type");
-                return (CFGPACK_ERR_INVALID_TYPE);
-            }
-            entry_type = (cfgpack_type_t)type_val;
-            if (!ctx->measuring) {
-                e->type = entry_type;
-            }
-            got_type = 1;
-        } else if (ekey == MP_ENTRY_KEY_VALUE) {
-            if (!ctx->measuring) {
-                if (r->pos < r->len && r->data[r->pos] == 0xC0) {
-                    r->pos++;
-                    default_is_nil = 1;
-                } else {
-                    rc = cfgpack_msgpack_skip_value(r);
-                    if (rc != CFGPACK_OK) {
-                        set_err(ctx->err, 0, "invalid default value");
-                        return (CFGPACK_ERR_DECODE);
-                    }
-                }
-            } else {
-                rc = cfgpack_msgpack_skip_value(r);
-                if (rc != CFGPACK_OK) {
-                    set_err(ctx->err, 0, "invalid default value");
-                    return (CFGPACK_ERR_DECODE);
-                }
-            }
-            got_default = 1;
-        } else {
-            rc = cfgpack_msgpack_skip_value(r);
-            if (rc != CFGPACK_OK) {
-                set_err(ctx->err, 0, "invalid value");
-                return (CFGPACK_ERR_DECODE);
-            }
-        }
-    }
-
-    if (ctx->measuring) {
-        if (got_type) {
-            if (entry_type == CFGPACK_TYPE_STR) {
-                ctx->str_count++;
-            } else if (entry_type == CFGPACK_TYPE_FSTR) {
-                ctx->fstr_count++;
-            }
-        }
-    } else {
-        if (!got_idx || !got_ename || !got_type || !got_default) {
-            set_err(ctx->err, 0, "missing entry field");
-            return (CFGPACK_ERR_DECODE);
-        }
-        if (default_is_nil) {
-            e->has_default = 0;
-        } else {
-            e->has_default = 1;
-        }
-        ctx->values[ctx->count].type = e->type;
-
-        if (has_duplicate(ctx->entries, ctx->count, e->index, e->name)) {
-            set_err(ctx->err, 0, "duplicate");
-            return (CFGPACK_ERR_DUPLICATE);
-        }
-    }
-
-    ctx->count++;
-    return (CFGPACK_OK);
-}
-
-/**
- * @brief Temporary state for one entry during Phase 2 default decoding.
- */
-typedef struct {
-    uint16_t entry_index;
-    cfgpack_type_t entry_type;
-    int entry_has_default;
-    int has_string_default;
-    cfgpack_fat_value_t fat;
-    uint64_t def_u64;
-    int64_t def_i64;
-    float def_f32;
-    double def_f64;
-    int def_is_uint;
-    int def_is_int;
-    int def_is_f32;
-    int def_is_f64;
-} mp_p2_entry_t;
-
-/**
- * @brief Initialise Phase 2 per-entry temporaries to zero/defaults.
- */
-static void mp_p2_entry_init(mp_p2_entry_t *p2) {
-    p2->entry_index = 0;
-    p2->entry_type = CFGPACK_TYPE_U8;
-    p2->entry_has_default = 0;
-    p2->has_string_default = 0;
-    memset(&p2->fat, 0, sizeof(p2->fat));
-    p2->def_u64 = 0;
-    p2->def_i64 = 0;
-    p2->def_f32 = 0;
-    p2->def_f64 = 0;
-    p2->def_is_uint = 0;
-    p2->def_is_int = 0;
-    p2->def_is_f32 = 0;
-    p2->def_is_f64 = 0;
-}
-
-/**
- * @brief Decode the default value for one entry during Phase 2.
- *
- * Reads the wire-format byte and dispatches to the appropriate msgpack
- * decoder (f32, f64, int64, str, or uint64).  Updates p2->def_is_*
- * and p2->has_string_default flags accordingly.
- *
- * Returns CFGPACK_OK on success (including nil / no-default).
- */
-static cfgpack_err_t mp_phase2_decode_value(cfgpack_reader_t *rp,
-                                            mp_p2_entry_t *p2,
-                                            cfgpack_parse_error_t *err) {
-    cfgpack_err_t rc;
-    uint8_t vb;
-
-    if (rp->pos < rp->len && rp->data[rp->pos] == 0xC0) {
-        rp->pos++;
-        return CFGPACK_OK; /* nil — no default */
-    }
-    if (rp->pos >= rp->len) {
-        set_err(err, 0, "truncated default value");
-        return (CFGPACK_ERR_DECODE);
-    }
-
-    p2->entry_has_default = 1;
-    vb = rp->data[rp->pos];
-
-    if (vb == 0xCA) {
-        rc = cfgpack_msgpack_decode_f32(rp, &p2->def_f32);
-        if (rc != CFGPACK_OK) {
-            set_err(err, 0, "phase2 decode error");
+            set_err(err, 0, "phase2 decode error");
             return (CFGPACK_ERR_DECODE);
         }
         p2->def_is_f32 = 1;
@@ -2392,6 +2631,7 @@ static cfgpack_err_t mp_phase2_decode_value(cfgpack_reader_t *rp,
             return (CFGPACK_ERR_DECODE);
         }
         p2->has_string_default = 1;
+        p2->str_off = rp->base + (size_t)(sptr - rp->data);
         p2->fat.type = p2->entry_type;
         if (p2->entry_type == CFGPACK_TYPE_FSTR) {
             if (slen > CFGPACK_FSTR_MAX) {
@@ -2426,7 +2666,8 @@ static cfgpack_err_t mp_phase2_decode_value(cfgpack_reader_t *rp,
  *
  * Checks that string-typed entries get string defaults and numeric-typed
  * entries get numeric defaults.  Stores the value into ctx->values at
- * the sorted position, using fat_str_to_pool for string types.
+ * the sorted position, using fat_str_to_pool for string types (or an
+ * offset into the source blob in copy-on-write mode).
  */
 static cfgpack_err_t mp_phase2_validate_and_store(parse_ctx_t *ctx,
                                                   const mp_p2_entry_t *p2,
@@ -2451,9 +2692,31 @@ static cfgpack_err_t mp_phase2_validate_and_store(parse_ctx_t *ctx,
         return (CFGPACK_OK);
     }
 
+    if (val_is_str &&
+        (p2->entry_type == CFGPACK_TYPE_STR ? p2->fat.v.str.len
+                                            : p2->fat.v.fstr.len) >
+            cfgpack_entry_str_max(&ctx->entries[pos])) {
+        set_err(ctx->err, 0, "default longer than declared max");
+        return (CFGPACK_ERR_STR_TOO_LONG);
+    }
+
     ctx->entries[pos].has_default = 1;
 
-    if (p2->has_string_default && type_is_str) {
+    if (p2->has_string_default && type_is_str && ctx->cow) {
+        /* Copy-on-write: point at the bytes in the source blob */
+        if (p2->str_off >= CFGPACK_STR_OFF_MAX) {
+            set_err(ctx->err, 0, "string default beyond offset range");
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        ctx->values[pos].type = p2->entry_type;
+        if (p2->entry_type == CFGPACK_TYPE_STR) {
+            ctx->values[pos].v.str.offset = (cfgpack_str_off_t)p2->str_off;
+            ctx->values[pos].v.str.len = p2->fat.v.str.len;
+        } else {
+            ctx->values[pos].v.fstr.offset = (cfgpack_str_off_t)p2->str_off;
+            ctx->values[pos].v.fstr.len = p2->fat.v.fstr.len;
+        }
+    } else if (p2->has_string_default && type_is_str) {
         fat_str_to_pool(&p2->fat, (size_t)pos, ctx->values, ctx->entries,
                         ctx->str_pool, ctx->str_offsets);
     } else if (p2->def_is_uint) {
@@ -2474,147 +2737,286 @@ static cfgpack_err_t mp_phase2_validate_and_store(parse_ctx_t *ctx,
 }
 
 /**
- * @brief Decode one entry's key-value fields during Phase 2.
+ * @brief Store one entry's default during a streaming parse.
+ *
+ * There is no second pass to go back to, so the default is stored as soon
+ * as its entry is complete.  That needs the entry's final string slot,
+ * which only index order fixes in advance: the caller rejects entries that
+ * are not strictly ascending, and slots and pool offsets are handed out
+ * here exactly as compute_str_offsets() will recompute them.
+ */
+static cfgpack_err_t mp_stream_store(parse_ctx_t *ctx, mp_p2_entry_t *p2) {
+    cfgpack_entry_t *e = &ctx->entries[ctx->count];
+
+    e->str_slot = CFGPACK_STR_SLOT_NONE;
+    if (e->type == CFGPACK_TYPE_STR || e->type == CFGPACK_TYPE_FSTR) {
+        size_t need = ctx->pool_used + cfgpack_entry_str_max(e) + 1;
+
+        if (ctx->slots >= ctx->str_offsets_count ||
+            ctx->slots >= CFGPACK_STR_SLOT_NONE) {
+            set_err(ctx->err, 0, "too many string entries");
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        if (need > CFGPACK_STR_OFF_MAX) {
+            set_err(ctx->err, 0, "string pool exceeds offset range");
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        if (need > ctx->str_pool_cap) {
+            set_err(ctx->err, 0, "string pool too small");
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        e->str_slot = (cfgpack_str_slot_t)ctx->slots;
+        ctx->str_offsets[ctx->slots++] = (cfgpack_str_off_t)ctx->pool_used;
+        ctx->pool_used = need;
+    }
+    p2->entry_type = e->type;
+    ctx->values[ctx->count].type = e->type;
+    return (mp_phase2_validate_and_store(ctx, p2, (int)ctx->count));
+}
+
+/**
+ * @brief Parse one entry from the entries array during Phase 1.
+ *
+ * Decodes entry fields (index, name, type, value) and validates them.
+ * In measure mode only the type is tracked (for str/fstr counting).
+ * In parse mode the entry is populated; duplicates are found by
+ * schema_finalize().
+ * The default value is skipped and its position recorded — Phase 2 will
+ * decode it there.  In stream mode it is decoded on the spot instead and
+ * stored by mp_stream_store(), so the index must be ascending and the
+ * type must come before the value.
  *
- * Iterates over the entry map keys, extracting index, type, and default
- * value into p2.  Name and unknown keys are skipped.
+ * Increments ctx->count on success.
  */
-static cfgpack_err_t mp_phase2_decode_entry_fields(cfgpack_reader_t *rp,
-                                                   mp_p2_entry_t *p2,
-                                                   uint32_t ecount,
-                                                   cfgpack_parse_error_t *err) {
+static cfgpack_err_t mp_parse_one_entry(parse_ctx_t *ctx, cfgpack_reader_t *r) {
+    cfgpack_type_t entry_type = CFGPACK_TYPE_U8;
+    cfgpack_entry_t *e = NULL;
+    int default_is_nil = 0;
+    size_t default_pos = 0;
+    int got_default = 0;
+    int got_ename = 0;
+    uint64_t str_max = 0;
+    int got_type = 0;
     cfgpack_err_t rc;
+    int got_idx = 0;
+    uint32_t ecount;
+    mp_p2_entry_t p2;
+
+    mp_p2_entry_init(&p2);
+    if (!ctx->measuring && ctx->count >= ctx->max_entries) {
+        set_err(ctx->err, 0, "too many entries");
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    rc = cfgpack_msgpack_decode_map_header(r, &ecount);
+    if (rc != CFGPACK_OK) {
+        set_err(ctx->err, 0, "expected entry map");
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    if (!ctx->measuring) {
+        e = &ctx->entries[ctx->count];
+        memset(e, 0, sizeof(*e));
+    }
 
     for (uint32_t ek = 0; ek < ecount; ++ek) {
         uint64_t ekey;
 
-        rc = cfgpack_msgpack_decode_uint64(rp, &ekey);
+        rc = cfgpack_msgpack_decode_uint64(r, &ekey);
         if (rc != CFGPACK_OK) {
-            set_err(err, 0, "phase2 decode error");
+            set_err(ctx->err, 0, "expected entry key");
             return (CFGPACK_ERR_DECODE);
         }
 
         if (ekey == MP_ENTRY_KEY_INDEX) {
             uint64_t idx;
 
-            rc = cfgpack_msgpack_decode_uint64(rp, &idx);
+            rc = cfgpack_msgpack_decode_uint64(r, &idx);
             if (rc != CFGPACK_OK) {
-                set_err(err, 0, "phase2 decode error");
+                set_err(ctx->err, 0, "invalid index");
+                return (CFGPACK_ERR_DECODE);
+            }
+            if (idx == 0) {
+                set_err(ctx->err, 0, "index 0 is reserved for schema name");
+                return (CFGPACK_ERR_RESERVED_INDEX);
+            }
+            if (idx > 65535) {
+                set_err(ctx->err, 0, "index out of range");
+                return (CFGPACK_ERR_BOUNDS);
+            }
+            if (ctx->stream && ctx->count > 0 && idx <= ctx->max_index) {
+                set_err(ctx->err, 0, "streamed entries not in index order");
                 return (CFGPACK_ERR_DECODE);
             }
-            p2->entry_index = (uint16_t)idx;
+            if (!ctx->measuring) {
+                e->index = (uint16_t)idx;
+            }
+            if ((uint16_t)idx > ctx->max_index) {
+                ctx->max_index = (uint16_t)idx;
+            }
+            got_idx = 1;
         } else if (ekey == MP_ENTRY_KEY_NAME) {
-            const uint8_t *np;
-            uint32_t nl;
+            const uint8_t *nptr;
+            uint32_t nlen;
 
-            rc = cfgpack_msgpack_decode_str(rp, &np, &nl);
+            rc = cfgpack_msgpack_decode_str(r, &nptr, &nlen);
             if (rc != CFGPACK_OK) {
-                set_err(err, 0, "phase2 decode error");
+                set_err(ctx->err, 0, "invalid entry name");
                 return (CFGPACK_ERR_DECODE);
             }
+            if (nlen > 5 || nlen == 0) {
+                set_err(ctx->err, 0, "name too long");
+                return (CFGPACK_ERR_BOUNDS);
+            }
+            if (!ctx->measuring) {
+                memcpy(e->name, nptr, nlen);
+                e->name[nlen] = '\0';
+            }
+            got_ename = 1;
         } else if (ekey == MP_ENTRY_KEY_TYPE) {
             uint64_t type_val;
 
-            rc = cfgpack_msgpack_decode_uint64(rp, &type_val);
+            rc = cfgpack_msgpack_decode_uint64(r, &type_val);
             if (rc != CFGPACK_OK) {
-                set_err(err, 0, "phase2 decode error");
+                set_err(ctx->err, 0, "invalid type");
                 return (CFGPACK_ERR_DECODE);
             }
-            if (type_val < MP_TYPE_COUNT) {
-                p2->entry_type = (cfgpack_type_t)type_val;
-            }
-        } else if (ekey == MP_ENTRY_KEY_VALUE) {
-            rc = mp_phase2_decode_value(rp, p2, err);
-            if (rc != CFGPACK_OK) {
-                return (rc);
+            if (type_val >= MP_TYPE_COUNT) {
+                set_err(ctx->err, 0, "invalid type");
+                return (CFGPACK_ERR_INVALID_TYPE);
             }
-        } else {
-            rc = cfgpack_msgpack_skip_value(rp);
-            if (rc != CFGPACK_OK) {
-                set_err(err, 0, "phase2 decode error");
-                return (CFGPACK_ERR_DECODE);
+            entry_type = (cfgpack_type_t)type_val;
+            if (!ctx->measuring) {
+                e->type = entry_type;
+            }
+            got_type = 1;
+        } else if (ekey == MP_ENTRY_KEY_VALUE) {
+            uint8_t vb = 0;
+
+            default_pos = r->pos;
+            if (ctx->stream) {
+                if (!got_type) {
+                    set_err(ctx->err, 0, "streamed value before its type");
+                    return (CFGPACK_ERR_DECODE);
+                }
+                p2.entry_type = entry_type;
+                rc = mp_phase2_decode_value(r, &p2, ctx->err);
+                if (rc != CFGPACK_OK) {
+                    return (rc);
+                }
+                default_is_nil = !p2.entry_has_default;
+            } else if (!ctx->measuring) {
+                if (cfgpack_reader_peek(r, &vb) == CFGPACK_OK && vb == 0xC0) {
+                    r->pos++;
+                    default_is_nil = 1;
+                } else {
+                    rc = cfgpack_msgpack_skip_value(r);
+                    if (rc != CFGPACK_OK) {
+                        set_err(ctx->err, 0, "invalid default value");
+                        return (CFGPACK_ERR_DECODE);
+                    }
+                }
+            } else {
+                rc = cfgpack_msgpack_skip_value(r);
+                if (rc != CFGPACK_OK) {
+                    set_err(ctx->err, 0, "invalid default value");
+                    return (CFGPACK_ERR_DECODE);
+                }
+            }
+            got_default = 1;
+        } else if (ekey == MP_ENTRY_KEY_STR_MAX) {
+            rc = cfgpack_msgpack_decode_uint64(r, &str_max);
+            if (rc != CFGPACK_OK) {
+                set_err(ctx->err, 0, "invalid string max length");
+                return (CFGPACK_ERR_DECODE);
+            }
+        } else {
+            rc = cfgpack_msgpack_skip_value(r);
+            if (rc != CFGPACK_OK) {
+                set_err(ctx->err, 0, "invalid value");
+                return (CFGPACK_ERR_DECODE);
             }
         }
     }
+
+    if (str_max != 0 && (str_limit(entry_type, 0) == 0 ||
+                         str_max > str_limit(entry_type, 0))) {
+        set_err(ctx->err, 0, "invalid string max length");
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    if (ctx->measuring) {
+        if (got_type) {
+            ctx->blob_values += cfgpack_value_enc_max(
+                entry_type, str_limit(entry_type, (uint8_t)str_max));
+            if (entry_type == CFGPACK_TYPE_STR) {
+                ctx->str_count++;
+                ctx->str_pool_size +=
+                    str_limit(entry_type, (uint8_t)str_max) + 1;
+            } else if (entry_type == CFGPACK_TYPE_FSTR) {
+                ctx->fstr_count++;
+                ctx->str_pool_size +=
+                    str_limit(entry_type, (uint8_t)str_max) + 1;
+            }
+        }
+    } else {
+        if (!got_idx || !got_ename || !got_type || !got_default) {
+            set_err(ctx->err, 0, "missing entry field");
+            return (CFGPACK_ERR_DECODE);
+        }
+        if (default_is_nil) {
+            e->has_default = 0;
+        } else {
+            e->has_default = 1;
+        }
+        e->str_max = (uint8_t)str_max;
+        ctx->values[ctx->count].type = e->type;
+        if (ctx->stream) {
+            rc = mp_stream_store(ctx, &p2);
+            if (rc != CFGPACK_OK) {
+                return (rc);
+            }
+        } else if (e->has_default) {
+            defer_default(&ctx->values[ctx->count], default_pos);
+        }
+    }
+
+    ctx->count++;
     return (CFGPACK_OK);
 }
 
 /**
- * @brief Phase 2: re-decode msgpack to extract default values.
+ * @brief Phase 2: decode default values at their recorded positions.
  *
- * After schema_finalize has sorted entries, this re-reads the original
- * data to decode all default values and store them at their sorted
- * positions.  Handles numeric, string, and fstr defaults.
+ * After schema_finalize has sorted entries, each default is decoded at
+ * the source position Phase 1 recorded for it and stored at its sorted
+ * position; the rest of the input is not decoded again.  Handles numeric,
+ * string, and fstr defaults.
  */
 static cfgpack_err_t mp_phase2(parse_ctx_t *ctx,
                                const uint8_t *data,
                                size_t data_len) {
-    cfgpack_reader_t *rp;
-    cfgpack_reader_t r2;
-    cfgpack_err_t rc;
-    uint32_t top2;
+    for (size_t i = 0; i < ctx->count; ++i) {
+        cfgpack_reader_t r2;
+        mp_p2_entry_t p2;
+        cfgpack_err_t rc;
 
-    cfgpack_reader_init(&r2, data, data_len);
-    rp = &r2;
-
-    rc = cfgpack_msgpack_decode_map_header(rp, &top2);
-    if (rc != CFGPACK_OK) {
-        set_err(ctx->err, 0, "phase2 decode error");
-        return (CFGPACK_ERR_DECODE);
-    }
+        if (!ctx->entries[i].has_default) {
+            continue;
+        }
 
-    for (uint32_t ti = 0; ti < top2; ++ti) {
-        uint64_t tkey;
+        cfgpack_reader_init(&r2, data, data_len);
+        r2.pos = take_deferred(&ctx->values[i]);
+        mp_p2_entry_init(&p2);
+        p2.entry_type = ctx->entries[i].type;
 
-        rc = cfgpack_msgpack_decode_uint64(rp, &tkey);
+        rc = mp_phase2_decode_value(&r2, &p2, ctx->err);
         if (rc != CFGPACK_OK) {
-            set_err(ctx->err, 0, "phase2 decode error");
-            return (CFGPACK_ERR_DECODE);
+            return (rc);
         }
-
-        if (tkey == MP_SCHEMA_KEY_ENTRIES) {
-            uint32_t arr_count;
-
-            rc = mp_decode_array_header(rp, &arr_count);
-            if (rc != CFGPACK_OK) {
-                set_err(ctx->err, 0, "phase2 decode error");
-                return (CFGPACK_ERR_DECODE);
-            }
-
-            for (uint32_t ei = 0; ei < arr_count; ++ei) {
-                mp_p2_entry_t p2;
-                uint32_t ecount;
-                int pos;
-
-                rc = cfgpack_msgpack_decode_map_header(rp, &ecount);
-                if (rc != CFGPACK_OK) {
-                    set_err(ctx->err, 0, "phase2 decode error");
-                    return (CFGPACK_ERR_DECODE);
-                }
-
-                mp_p2_entry_init(&p2);
-
-                rc = mp_phase2_decode_entry_fields(rp, &p2, ecount, ctx->err);
-                if (rc != CFGPACK_OK) {
-                    return (rc);
-                }
-
-                pos = find_entry_pos(ctx->entries, ctx->count, p2.entry_index);
-                if (pos < 0 || !p2.entry_has_default) {
-                    continue;
-                }
-
-                rc = mp_phase2_validate_and_store(ctx, &p2, pos);
-                if (rc != CFGPACK_OK) {
-                    return (rc);
-                }
-            }
-        } else {
-            rc = cfgpack_msgpack_skip_value(rp);
-            if (rc != CFGPACK_OK) {
-                set_err(ctx->err, 0, "phase2 decode error");
-                return (CFGPACK_ERR_DECODE);
-            }
+        rc = mp_phase2_validate_and_store(ctx, &p2, (int)i);
+        if (rc != CFGPACK_OK) {
+            return (rc);
         }
     }
 
@@ -2631,16 +3033,18 @@ static cfgpack_err_t mp_phase2(parse_ctx_t *ctx,
  *
  * When opts is non-NULL (parse mode): full two-phase parse with output.
  * When measure is non-NULL (measure mode): single-pass tally, no output.
- * Exactly one of opts/measure must be non-NULL.
+ * Exactly one of opts/measure must be non-NULL.  @p cow leaves string
+ * defaults in the input (see cfgpack_schema_parse_msgpack_cow()).
+ *
+ * A flat reader is parsed in two phases; a windowed one (@c src set) in
+ * one, with defaults stored as Phase 1 goes (see mp_stream_store()).
  */
 static cfgpack_err_t parse_schema_msgpack_impl(
-    const uint8_t *data,
-    size_t data_len,
+    cfgpack_reader_t *r,
     const cfgpack_parse_opts_t *opts,
     cfgpack_schema_measure_t *measure,
-    cfgpack_parse_error_t *err) {
-    cfgpack_reader_t reader;
-    cfgpack_reader_t *r;
+    cfgpack_parse_error_t *err,
+    int cow) {
     int got_version = 0;
     int got_entries = 0;
     uint32_t top_count;
@@ -2652,9 +3056,11 @@ static cfgpack_err_t parse_schema_msgpack_impl(
     if (rc != CFGPACK_OK) {
         return (rc);
     }
-
-    cfgpack_reader_init(&reader, data, data_len);
-    r = &reader;
+    ctx.cow = cow;
+    ctx.stream = (r->src != NULL && !ctx.measuring);
+    if (ctx.stream && opts->str_pool_cap > 0) {
+        memset(opts->str_pool, 0, opts->str_pool_cap);
+    }
 
     /* Top-level map */
     rc = cfgpack_msgpack_decode_map_header(r, &top_count);
@@ -2690,7 +3096,7 @@ static cfgpack_err_t parse_schema_msgpack_impl(
         } else if (tkey == MP_SCHEMA_KEY_ENTRIES) {
             uint32_t arr_count;
 
-            rc = mp_decode_array_header(r, &arr_count);
+            rc = cfgpack_msgpack_decode_array_header(r, &arr_count);
             if (rc != CFGPACK_OK) {
                 set_err(err, 0, "expected array for entries");
                 return (CFGPACK_ERR_DECODE);
@@ -2730,12 +3136,12 @@ static cfgpack_err_t parse_schema_msgpack_impl(
         return (CFGPACK_ERR_DECODE);
     }
 
-    rc = schema_finalize(opts, ctx.count);
-    if (rc != CFGPACK_OK) {
+    rc = schema_finalize(opts, ctx.count, ctx.cow, ctx.stream);
+    if (rc != CFGPACK_OK || ctx.stream) {
         return (rc);
     }
 
-    return (mp_phase2(&ctx, data, data_len));
+    return (mp_phase2(&ctx, r->data, r->len));
 }
 
 /* ─────────────────────────────────────────────────────────────────────────────
@@ -2746,10 +3152,35 @@ cfgpack_err_t cfgpack_schema_measure_msgpack(const uint8_t *data,
                                              size_t data_len,
                                              cfgpack_schema_measure_t *out,
                                              cfgpack_parse_error_t *err) {
+    cfgpack_reader_t r;
+
     if (!data || !out) {
         return (CFGPACK_ERR_ARGS);
     }
-    return (parse_schema_msgpack_impl(data, data_len, NULL, out, err));
+    cfgpack_reader_init(&r, data, data_len);
+    return (parse_schema_msgpack_impl(&r, NULL, out, err, 0));
+}
+
+cfgpack_err_t cfgpack_schema_measure_msgpack_stream(
+    cfgpack_source_fn src,
+    void *user,
+    size_t len,
+    uint8_t *window,
+    size_t window_cap,
+    cfgpack_schema_measure_t *out,
+    cfgpack_parse_error_t *err) {
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+
+    if (!src || !window || !out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (window_cap < CFGPACK_STREAM_WINDOW_MIN) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    cfgpack_reader_init_source(&r, window, window_cap, src, user, len);
+    rc = parse_schema_msgpack_impl(&r, NULL, out, err, 0);
+    return (r.src_err != CFGPACK_OK ? r.src_err : rc);
 }
 
 /* ─────────────────────────────────────────────────────────────────────────────
@@ -2759,10 +3190,57 @@ cfgpack_err_t cfgpack_schema_measure_msgpack(const uint8_t *data,
 cfgpack_err_t cfgpack_schema_parse_msgpack(const uint8_t *data,
                                            size_t data_len,
                                            const cfgpack_parse_opts_t *opts) {
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+
+    if (!opts || !data) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PARSE, NULL);
+    cfgpack_reader_init(&r, data, data_len);
+    rc = parse_schema_msgpack_impl(&r, opts, NULL, opts->err, 0);
+    CFGPACK_STAT_END(CFGPACK_STATS_PARSE, NULL);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_schema_parse_msgpack_cow(
+    const uint8_t *data,
+    size_t data_len,
+    const cfgpack_parse_opts_t *opts) {
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+
     if (!opts || !data) {
         return (CFGPACK_ERR_ARGS);
     }
-    return (parse_schema_msgpack_impl(data, data_len, opts, NULL, opts->err));
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PARSE, NULL);
+    cfgpack_reader_init(&r, data, data_len);
+    rc = parse_schema_msgpack_impl(&r, opts, NULL, opts->err, 1);
+    CFGPACK_STAT_END(CFGPACK_STATS_PARSE, NULL);
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_schema_parse_msgpack_stream(
+    cfgpack_source_fn src,
+    void *user,
+    size_t len,
+    uint8_t *window,
+    size_t window_cap,
+    const cfgpack_parse_opts_t *opts) {
+    cfgpack_reader_t r;
+    cfgpack_err_t rc;
+
+    if (!opts || !src || !window) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (window_cap < CFGPACK_STREAM_WINDOW_MIN) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    CFGPACK_STAT_BEGIN(CFGPACK_STATS_PARSE, NULL);
+    cfgpack_reader_init_source(&r, window, window_cap, src, user, len);
+    rc = parse_schema_msgpack_impl(&r, opts, NULL, opts->err, 0);
+    CFGPACK_STAT_END(CFGPACK_STATS_PARSE, NULL);
+    return (r.src_err != CFGPACK_OK ? r.src_err : rc);
 }
 
 /* ─────────────────────────────────────────────────────────────────────────────
@@ -2819,10 +3297,14 @@ cfgpack_err_t cfgpack_schema_write_msgpack(const cfgpack_ctx_t *ctx,
 
     for (size_t i = 0; i < schema->entry_count; ++i) {
         const cfgpack_entry_t *e = &schema->entries[i];
-        const cfgpack_value_t *val = &ctx->values[i];
+        cfgpack_value_t v;
+        const cfgpack_value_t *val = &v;
+        const char *sp;
 
-        /* map(4): index, name, type, value */
-        rc = cfgpack_msgpack_encode_map_header(&buf, 4);
+        cfgpack_value_load(ctx, i, &v);
+
+        /* map(4): index, name, type, value; map(5) adds str_max */
+        rc = cfgpack_msgpack_encode_map_header(&buf, e->str_max ? 5 : 4);
         if (rc != CFGPACK_OK) {
             goto fail;
         }
@@ -2890,14 +3372,32 @@ cfgpack_err_t cfgpack_schema_write_msgpack(const cfgpack_ctx_t *ctx,
                 rc = cfgpack_msgpack_encode_f64(&buf, val->v.f64);
                 break;
             case CFGPACK_TYPE_STR:
-                rc = cfgpack_msgpack_encode_str(
-                    &buf, ctx->str_pool + val->v.str.offset, val->v.str.len);
+                sp = cfgpack_str_data(ctx, e, val);
+                rc = sp ? cfgpack_msgpack_encode_str(&buf, sp, val->v.str.len)
+                        : CFGPACK_ERR_BOUNDS;
                 break;
             case CFGPACK_TYPE_FSTR:
-                rc = cfgpack_msgpack_encode_str(
-                    &buf, ctx->str_pool + val->v.fstr.offset, val->v.fstr.len);
+                sp = cfgpack_str_data(ctx, e, val);
+                rc = sp ? cfgpack_msgpack_encode_str(&buf, sp, val->v.fstr.len)
+                        : CFGPACK_ERR_BOUNDS;
                 break;
             }
+            if (rc == CFGPACK_ERR_BOUNDS) {
+                set_err(err, 0, "string value out of bounds");
+                return (rc);
+            }
+            if (rc != CFGPACK_OK) {
+                goto fail;
+            }
+        }
+
+        /* 4 -> declared string max length, only when set */
+        if (e->str_max) {
+            rc = cfgpack_msgpack_encode_uint64(&buf, MP_ENTRY_KEY_STR_MAX);
+            if (rc != CFGPACK_OK) {
+                goto fail;
+            }
+            rc = cfgpack_msgpack_encode_uint64(&buf, e->str_max);
             if (rc != CFGPACK_OK) {
                 goto fail;
             }
@@ -2914,3 +3414,925 @@ fail:
     set_err(err, 0, "buffer too small");
     return (CFGPACK_ERR_ENCODE);
 }
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Precompiled Schema Image (zero-parse attach)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Image header, stored in native layout at offset 0.
+ *
+ * Followed by the entries, the default values, the string offsets and the
+ * default string pool, each starting at the recorded offset, then a 4-byte
+ * LE CRC-32C trailer over everything before it.
+ */
+typedef struct {
+    uint32_t magic;  /**< CFGPACK_SCHEMA_IMAGE_MAGIC (catches endianness) */
+    uint16_t format; /**< CFGPACK_SCHEMA_IMAGE_FORMAT */
+    uint8_t entry_size;
+    uint8_t value_size;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t str_count;
+    uint32_t fstr_count;
+    uint32_t str_pool_size;
+    uint32_t entries_off;
+    uint32_t values_off;
+    uint32_t offsets_off;
+    uint32_t pool_off;
+    uint32_t total_len; /**< Including the CRC trailer */
+    uint32_t max_index;
+    char map_name[64];
+} image_hdr_t;
+
+#define IMAGE_FORMAT 2u /* 2: cfgpack_entry_t.str_max */
+
+static size_t image_align(size_t off) {
+    return ((off + CFGPACK_SCHEMA_IMAGE_ALIGN - 1) &
+            ~(size_t)(CFGPACK_SCHEMA_IMAGE_ALIGN - 1));
+}
+
+static uint32_t image_get_le32(const uint8_t *p) {
+    return ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+            ((uint32_t)p[3] << 24));
+}
+
+/**
+ * @brief Validate an image header, layout and CRC; copy out the header.
+ */
+static cfgpack_err_t image_check(const uint8_t *image,
+                                 size_t len,
+                                 image_hdr_t *hdr,
+                                 cfgpack_parse_error_t *err) {
+    size_t n_str;
+
+    if (((uintptr_t)image & (CFGPACK_SCHEMA_IMAGE_ALIGN - 1)) != 0) {
+        set_err(err, 0, "image not aligned");
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (len < sizeof(*hdr) + CFGPACK_CRC_SIZE) {
+        set_err(err, 0, "image truncated");
+        return (CFGPACK_ERR_DECODE);
+    }
+    memcpy(hdr, image, sizeof(*hdr));
+    if (hdr->magic != CFGPACK_SCHEMA_IMAGE_MAGIC ||
+        hdr->format != IMAGE_FORMAT) {
+        set_err(err, 0, "not a schema image");
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (hdr->entry_size != sizeof(cfgpack_entry_t) ||
+        hdr->value_size != sizeof(cfgpack_value_t)) {
+        set_err(err, 0, "image built for a different ABI");
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (hdr->total_len > len ||
+        hdr->total_len < sizeof(*hdr) + CFGPACK_CRC_SIZE) {
+        set_err(err, 0, "image truncated");
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (hdr->entry_count > CFGPACK_MAX_ENTRIES ||
+        hdr->map_name[sizeof(hdr->map_name) - 1] != '\0') {
+        set_err(err, 0, "bad image header");
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    /* Each region must fit before the next one and the trailer */
+    n_str = (size_t)hdr->str_count + hdr->fstr_count;
+    if (hdr->entries_off < sizeof(*hdr) ||
+        hdr->values_off < hdr->entries_off ||
+        hdr->values_off - hdr->entries_off <
+            hdr->entry_count * sizeof(cfgpack_entry_t) ||
+        hdr->offsets_off < hdr->values_off ||
+        hdr->offsets_off - hdr->values_off <
+            hdr->entry_count * sizeof(cfgpack_value_t) ||
+        hdr->pool_off < hdr->offsets_off ||
+        hdr->pool_off - hdr->offsets_off < n_str * sizeof(cfgpack_str_off_t) ||
+        hdr->pool_off > hdr->total_len - CFGPACK_CRC_SIZE ||
+        hdr->total_len - CFGPACK_CRC_SIZE - hdr->pool_off <
+            hdr->str_pool_size ||
+        (hdr->entries_off & (CFGPACK_SCHEMA_IMAGE_ALIGN - 1)) != 0 ||
+        (hdr->values_off & (CFGPACK_SCHEMA_IMAGE_ALIGN - 1)) != 0 ||
+        (hdr->offsets_off & 1u) != 0) {
+        set_err(err, 0, "bad image layout");
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    if (cfgpack_crc32c(image, hdr->total_len - CFGPACK_CRC_SIZE) !=
+        image_get_le32(image + hdr->total_len - CFGPACK_CRC_SIZE)) {
+        set_err(err, 0, "image CRC mismatch");
+        return (CFGPACK_ERR_CRC);
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_schema_write_image(const cfgpack_ctx_t *ctx,
+                                         uint8_t *out,
+                                         size_t out_cap,
+                                         size_t *out_len,
+                                         cfgpack_parse_error_t *err) {
+    const cfgpack_schema_t *schema;
+    cfgpack_schema_sizing_t sz;
+    image_hdr_t hdr;
+    uint16_t max_index = 0;
+    size_t n_str;
+    uint32_t crc;
+    size_t off;
+
+    /* An image carries the whole pool; copy-on-write contexts have none */
+    if (!ctx || !ctx->schema || !out || ctx->cow_base) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    schema = ctx->schema;
+    cfgpack_schema_get_sizing(schema, &sz);
+    n_str = sz.str_count + sz.fstr_count;
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        if (schema->entries[i].index > max_index) {
+            max_index = schema->entries[i].index;
+        }
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = CFGPACK_SCHEMA_IMAGE_MAGIC;
+    hdr.format = IMAGE_FORMAT;
+    hdr.entry_size = (uint8_t)sizeof(cfgpack_entry_t);
+    hdr.value_size = (uint8_t)sizeof(cfgpack_value_t);
+    hdr.version = schema->version;
+    hdr.entry_count = (uint32_t)schema->entry_count;
+    hdr.str_count = (uint32_t)sz.str_count;
+    hdr.fstr_count = (uint32_t)sz.fstr_count;
+    hdr.str_pool_size = (uint32_t)sz.str_pool_size;
+    hdr.max_index = max_index;
+    memcpy(hdr.map_name, schema->map_name, sizeof(hdr.map_name));
+    hdr.map_name[sizeof(hdr.map_name) - 1] = '\0';
+
+    off = image_align(sizeof(hdr));
+    hdr.entries_off = (uint32_t)off;
+    off = image_align(off + schema->entry_count * sizeof(cfgpack_entry_t));
+    hdr.values_off = (uint32_t)off;
+    off += schema->entry_count * sizeof(cfgpack_value_t);
+    hdr.offsets_off = (uint32_t)off;
+    off += n_str * sizeof(cfgpack_str_off_t);
+    hdr.pool_off = (uint32_t)off;
+    off += sz.str_pool_size;
+    hdr.total_len = (uint32_t)(off + CFGPACK_CRC_SIZE);
+
+    if (out_len) {
+        *out_len = hdr.total_len;
+    }
+    if (hdr.total_len > out_cap) {
+        set_err(err, 0, "buffer too small");
+        return (CFGPACK_ERR_ENCODE);
+    }
+
+    memset(out, 0, hdr.total_len);
+    memcpy(out, &hdr, sizeof(hdr));
+    memcpy(out + hdr.entries_off, schema->entries,
+           schema->entry_count * sizeof(cfgpack_entry_t));
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        cfgpack_value_t v;
+
+        /* Entries without a default have no meaningful value; store zeros */
+        if (schema->entries[i].has_default) {
+            cfgpack_value_load(ctx, i, &v);
+        } else {
+            memset(&v, 0, sizeof(v));
+            v.type = schema->entries[i].type;
+        }
+        memcpy(out + hdr.values_off + i * sizeof(v), &v, sizeof(v));
+    }
+    memcpy(out + hdr.offsets_off, ctx->str_offsets,
+           n_str * sizeof(cfgpack_str_off_t));
+    memcpy(out + hdr.pool_off, ctx->str_pool, sz.str_pool_size);
+
+    crc = cfgpack_crc32c(out, off);
+    out[off] = (uint8_t)(crc);
+    out[off + 1] = (uint8_t)(crc >> 8);
+    out[off + 2] = (uint8_t)(crc >> 16);
+    out[off + 3] = (uint8_t)(crc >> 24);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_schema_measure_image(const uint8_t *image,
+                                           size_t image_len,
+                                           cfgpack_schema_measure_t *out,
+                                           cfgpack_parse_error_t *err) {
+    const cfgpack_entry_t *entries;
+    size_t values = 0;
+    image_hdr_t hdr;
+    cfgpack_err_t rc;
+
+    if (!image || !out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = image_check(image, image_len, &hdr, err);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    out->entry_count = hdr.entry_count;
+    out->str_pool_size = hdr.str_pool_size;
+    out->str_count = hdr.str_count;
+    out->fstr_count = hdr.fstr_count;
+    out->index_table_size =
+        index_table_size((uint16_t)hdr.max_index, hdr.entry_count);
+    entries = (const cfgpack_entry_t *)(const void *)(image + hdr.entries_off);
+    for (size_t i = 0; i < hdr.entry_count; ++i) {
+        values += cfgpack_value_enc_max(entries[i].type,
+                                        cfgpack_entry_str_max(&entries[i]));
+    }
+    out->blob_max = cfgpack_blob_enc_max(hdr.entry_count,
+                                         (uint16_t)hdr.max_index, values);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_schema_attach_image(const uint8_t *image,
+                                          size_t image_len,
+                                          const cfgpack_parse_opts_t *opts) {
+    const cfgpack_entry_t *entries;
+    const cfgpack_value_t *defaults;
+    image_hdr_t hdr;
+    cfgpack_err_t rc;
+    size_t n_str;
+
+    if (!image || !opts || !opts->out_schema || !opts->values) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = image_check(image, image_len, &hdr, opts->err);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (opts->max_entries < hdr.entry_count) {
+        set_err(opts->err, 0, "too many entries");
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    n_str = (size_t)hdr.str_count + hdr.fstr_count;
+    if (opts->str_pool_cap < hdr.str_pool_size ||
+        opts->str_offsets_count < n_str || (n_str > 0 && !opts->str_offsets) ||
+        (hdr.str_pool_size > 0 && !opts->str_pool)) {
+        set_err(opts->err, 0, "string buffers too small");
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    /* Cheap per-entry sanity checks so a damaged-but-CRC-valid image
+     * cannot send later string accesses outside the caller's buffers. */
+    entries = (const cfgpack_entry_t *)(const void *)(image + hdr.entries_off);
+    defaults = (const cfgpack_value_t *)(const void *)(image + hdr.values_off);
+    for (size_t i = 0; i < hdr.entry_count; ++i) {
+        cfgpack_type_t t = entries[i].type;
+        int is_str = (t == CFGPACK_TYPE_STR || t == CFGPACK_TYPE_FSTR);
+
+        if ((unsigned)t > CFGPACK_TYPE_FSTR ||
+            (i > 0 && entries[i].index <= entries[i - 1].index) ||
+            (is_str && entries[i].str_slot >= n_str) ||
+            (!is_str && entries[i].str_slot != CFGPACK_STR_SLOT_NONE) ||
+            entries[i].str_max > str_limit(t, 0) ||
+            (entries[i].has_default && t == CFGPACK_TYPE_STR &&
+             (size_t)defaults[i].v.str.offset + defaults[i].v.str.len >
+                 hdr.str_pool_size) ||
+            (entries[i].has_default && t == CFGPACK_TYPE_FSTR &&
+             (size_t)defaults[i].v.fstr.offset + defaults[i].v.fstr.len >
+                 hdr.str_pool_size)) {
+            set_err(opts->err, 0, "bad image entry");
+            return (CFGPACK_ERR_DECODE);
+        }
+    }
+
+    memcpy(opts->values, defaults, hdr.entry_count * sizeof(cfgpack_value_t));
+    if (n_str > 0) {
+        memcpy(opts->str_offsets, image + hdr.offsets_off,
+               n_str * sizeof(cfgpack_str_off_t));
+    }
+    if (hdr.str_pool_size > 0) {
+        memcpy(opts->str_pool, image + hdr.pool_off, hdr.str_pool_size);
+    }
+
+    memcpy(opts->out_schema->map_name, hdr.map_name, sizeof(hdr.map_name));
+    opts->out_schema->version = hdr.version;
+    /* The entries are never written after init, so they can stay in flash */
+    opts->out_schema->entries = (cfgpack_entry_t *)(uintptr_t)entries;
+    opts->out_schema->entry_count = hdr.entry_count;
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Schema Family Image (shared entries plus per-variant overlays)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Family image header, stored in native layout at offset 0.
+ *
+ * Followed by the variant records, the shared entries and their default
+ * values, each variant's own entries, values and drop bitmap, then the
+ * string default text, and a 4-byte LE CRC-32C trailer.  String defaults
+ * in the stored values are offsets into the text region.
+ */
+typedef struct {
+    uint32_t magic;  /**< CFGPACK_SCHEMA_FAMILY_MAGIC (catches endianness) */
+    uint16_t format; /**< FAMILY_FORMAT */
+    uint8_t entry_size;
+    uint8_t value_size;
+    uint32_t variant_count;
+    uint32_t shared_count;
+    uint32_t variants_off;
+    uint32_t entries_off;
+    uint32_t values_off;
+    uint32_t text_off;
+    uint32_t text_size;
+    uint32_t total_len; /**< Including the CRC trailer */
+} family_hdr_t;
+
+/** @brief One variant: its own entries and the shared ones it drops. */
+typedef struct {
+    char name[CFGPACK_SCHEMA_FAMILY_NAME];
+    char map_name[64];
+    uint32_t version;
+    uint32_t add_count;   /**< Entries of this variant only */
+    uint32_t entries_off; /**< Its entries, sorted by index */
+    uint32_t values_off;  /**< Their default values */
+    uint32_t drop_off;    /**< Bit i set: shared entry i is not used */
+    uint32_t reserved;
+} family_variant_t;
+
+#define FAMILY_FORMAT 1u
+
+/** Distinct indices bound every entry count in a family image. */
+#define FAMILY_MAX_COUNT 65536u
+
+/** @brief One entry with its default, from a context or an image. */
+typedef struct {
+    const cfgpack_entry_t *e;
+    cfgpack_value_t v;
+    const char *text; /**< String default bytes, or NULL */
+} family_ent_t;
+
+/** @brief Running totals of the family sweep. */
+typedef struct {
+    size_t shared;
+    size_t text;
+    size_t adds[CFGPACK_SCHEMA_FAMILY_MAX];
+} family_sums_t;
+
+static size_t family_str_len(const cfgpack_value_t *v) {
+    return (v->type == CFGPACK_TYPE_STR ? v->v.str.len : v->v.fstr.len);
+}
+
+static family_ent_t family_view(const cfgpack_ctx_t *ctx, size_t i) {
+    family_ent_t f;
+
+    f.e = &ctx->schema->entries[i];
+    f.text = NULL;
+    memset(&f.v, 0, sizeof(f.v));
+    f.v.type = f.e->type;
+    if (f.e->has_default) {
+        cfgpack_value_load(ctx, i, &f.v);
+        if (f.e->type == CFGPACK_TYPE_STR) {
+            f.text = ctx->str_pool + f.v.v.str.offset;
+        } else if (f.e->type == CFGPACK_TYPE_FSTR) {
+            f.text = ctx->str_pool + f.v.v.fstr.offset;
+        }
+    }
+    return (f);
+}
+
+/** Whether two entries agree on everything but their pool slot. */
+static int family_same(const family_ent_t *a, const family_ent_t *b) {
+    const cfgpack_entry_t *x = a->e;
+    const cfgpack_entry_t *y = b->e;
+    uint32_t fa;
+    uint32_t fb;
+
+    if (x->index != y->index || x->type != y->type ||
+        x->has_default != y->has_default || x->str_max != y->str_max ||
+        strncmp(x->name, y->name, sizeof(x->name)) != 0) {
+        return (0);
+    }
+    if (!x->has_default) {
+        return (1);
+    }
+    switch (x->type) {
+    case CFGPACK_TYPE_STR:
+    case CFGPACK_TYPE_FSTR:
+        return (family_str_len(&a->v) == family_str_len(&b->v) &&
+                memcmp(a->text, b->text, family_str_len(&a->v)) == 0);
+    case CFGPACK_TYPE_F32:
+        memcpy(&fa, &a->v.v.f32, sizeof(fa));
+        memcpy(&fb, &b->v.v.f32, sizeof(fb));
+        return (fa == fb);
+    default: return (a->v.v.u64 == b->v.v.u64);
+    }
+}
+
+/**
+ * @brief Store one entry at slot @p k of a region, its text at the cursor.
+ *
+ * Counts the text even when @p out is NULL, so the sizing pass and the
+ * writing pass advance the same way.
+ */
+static void family_emit(uint8_t *out,
+                        const family_hdr_t *hdr,
+                        uint32_t entries_off,
+                        uint32_t values_off,
+                        size_t k,
+                        const family_ent_t *f,
+                        size_t *text) {
+    size_t len = 0;
+    cfgpack_entry_t e;
+    cfgpack_value_t v;
+
+    if (f->text) {
+        len = family_str_len(&f->v);
+    }
+    if (out) {
+        e = *f->e;
+        e.str_slot = CFGPACK_STR_SLOT_NONE;
+        v = f->v;
+        if (f->text && f->e->type == CFGPACK_TYPE_STR) {
+            v.v.str.offset = (cfgpack_str_off_t)*text;
+        } else if (f->text) {
+            v.v.fstr.offset = (cfgpack_str_off_t)*text;
+        }
+        if (len > 0) {
+            memcpy(out + hdr->text_off + *text, f->text, len);
+        }
+        memcpy(out + entries_off + k * sizeof(e), &e, sizeof(e));
+        memcpy(out + values_off + k * sizeof(v), &v, sizeof(v));
+    }
+    *text += len;
+}
+
+/**
+ * @brief Walk every variant in index order, deciding what is shared.
+ *
+ * At each index the definition that more than half of the variants share
+ * goes into the shared table; every variant with another definition adds
+ * its own and drops the shared one, as does every variant without the
+ * index.  With @p out NULL only @p sums is filled.
+ */
+static void family_sweep(const cfgpack_ctx_t *const *ctxs,
+                         size_t count,
+                         family_sums_t *sums,
+                         uint8_t *out,
+                         const family_hdr_t *hdr,
+                         const family_variant_t *recs) {
+    size_t pos[CFGPACK_SCHEMA_FAMILY_MAX];
+    family_ent_t ents[CFGPACK_SCHEMA_FAMILY_MAX];
+    uint8_t at[CFGPACK_SCHEMA_FAMILY_MAX];
+
+    memset(sums, 0, sizeof(*sums));
+    memset(pos, 0, sizeof(pos));
+    for (;;) {
+        uint32_t m = UINT32_MAX;
+        size_t rep = count;
+
+        for (size_t v = 0; v < count; ++v) {
+            const cfgpack_schema_t *s = ctxs[v]->schema;
+
+            if (pos[v] < s->entry_count && s->entries[pos[v]].index < m) {
+                m = s->entries[pos[v]].index;
+            }
+        }
+        if (m == UINT32_MAX) {
+            break;
+        }
+        for (size_t v = 0; v < count; ++v) {
+            const cfgpack_schema_t *s = ctxs[v]->schema;
+
+            at[v] = pos[v] < s->entry_count && s->entries[pos[v]].index == m;
+            if (at[v]) {
+                ents[v] = family_view(ctxs[v], pos[v]);
+            }
+        }
+        for (size_t v = 0; v < count && rep == count; ++v) {
+            size_t same = 0;
+
+            for (size_t w = 0; w < count && at[v]; ++w) {
+                same += at[w] && family_same(&ents[v], &ents[w]);
+            }
+            if (same * 2 > count) {
+                rep = v;
+            }
+        }
+        if (rep < count) {
+            family_emit(out, hdr, hdr ? hdr->entries_off : 0,
+                        hdr ? hdr->values_off : 0, sums->shared, &ents[rep],
+                        &sums->text);
+            sums->shared++;
+        }
+        for (size_t v = 0; v < count; ++v) {
+            if (at[v] && rep < count && family_same(&ents[v], &ents[rep])) {
+                pos[v]++;
+                continue;
+            }
+            if (rep < count && out) {
+                size_t bit = sums->shared - 1;
+
+                out[recs[v].drop_off + bit / 8] |= (uint8_t)(1u << (bit % 8));
+            }
+            if (at[v]) {
+                family_emit(out, hdr, recs ? recs[v].entries_off : 0,
+                            recs ? recs[v].values_off : 0, sums->adds[v],
+                            &ents[v], &sums->text);
+                sums->adds[v]++;
+                pos[v]++;
+            }
+        }
+    }
+}
+
+cfgpack_err_t cfgpack_schema_write_family(const cfgpack_ctx_t *const *ctxs,
+                                          const char *const *names,
+                                          size_t count,
+                                          uint8_t *out,
+                                          size_t out_cap,
+                                          size_t *out_len,
+                                          cfgpack_parse_error_t *err) {
+    family_variant_t recs[CFGPACK_SCHEMA_FAMILY_MAX];
+    family_sums_t sums;
+    family_hdr_t hdr;
+    size_t drop_bytes;
+    uint32_t crc;
+    size_t off;
+
+    if (!ctxs || !names || !out || count == 0 ||
+        count > CFGPACK_SCHEMA_FAMILY_MAX) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    for (size_t v = 0; v < count; ++v) {
+        size_t len;
+
+        if (!ctxs[v] || !ctxs[v]->schema || ctxs[v]->cow_base || !names[v]) {
+            return (CFGPACK_ERR_ARGS);
+        }
+        len = strlen(names[v]);
+        if (len == 0 || len >= CFGPACK_SCHEMA_FAMILY_NAME) {
+            set_err(err, 0, "bad variant name");
+            return (CFGPACK_ERR_ARGS);
+        }
+        for (size_t w = 0; w < v; ++w) {
+            if (strcmp(names[v], names[w]) == 0) {
+                set_err(err, 0, "duplicate variant name");
+                return (CFGPACK_ERR_ARGS);
+            }
+        }
+    }
+
+    /* Sizing pass: shared and per-variant counts, then the layout */
+    family_sweep(ctxs, count, &sums, NULL, NULL, NULL);
+    if (sums.text > CFGPACK_STR_OFF_MAX) {
+        set_err(err, 0, "string defaults too large");
+        return (CFGPACK_ERR_ENCODE);
+    }
+    drop_bytes = (sums.shared + 7) / 8;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memset(recs, 0, sizeof(recs));
+    hdr.magic = CFGPACK_SCHEMA_FAMILY_MAGIC;
+    hdr.format = FAMILY_FORMAT;
+    hdr.entry_size = (uint8_t)sizeof(cfgpack_entry_t);
+    hdr.value_size = (uint8_t)sizeof(cfgpack_value_t);
+    hdr.variant_count = (uint32_t)count;
+    hdr.shared_count = (uint32_t)sums.shared;
+
+    off = image_align(sizeof(hdr));
+    hdr.variants_off = (uint32_t)off;
+    off = image_align(off + count * sizeof(family_variant_t));
+    hdr.entries_off = (uint32_t)off;
+    off = image_align(off + sums.shared * sizeof(cfgpack_entry_t));
+    hdr.values_off = (uint32_t)off;
+    off += sums.shared * sizeof(cfgpack_value_t);
+    for (size_t v = 0; v < count; ++v) {
+        const cfgpack_schema_t *s = ctxs[v]->schema;
+
+        memcpy(recs[v].name, names[v], strlen(names[v]));
+        memcpy(recs[v].map_name, s->map_name, sizeof(recs[v].map_name));
+        recs[v].map_name[sizeof(recs[v].map_name) - 1] = '\0';
+        recs[v].version = s->version;
+        recs[v].add_count = (uint32_t)sums.adds[v];
+        off = image_align(off);
+        recs[v].entries_off = (uint32_t)off;
+        off = image_align(off + sums.adds[v] * sizeof(cfgpack_entry_t));
+        recs[v].values_off = (uint32_t)off;
+        off += sums.adds[v] * sizeof(cfgpack_value_t);
+        recs[v].drop_off = (uint32_t)off;
+        off += drop_bytes;
+    }
+    hdr.text_off = (uint32_t)off;
+    hdr.text_size = (uint32_t)sums.text;
+    off += sums.text;
+    hdr.total_len = (uint32_t)(off + CFGPACK_CRC_SIZE);
+
+    if (out_len) {
+        *out_len = hdr.total_len;
+    }
+    if (hdr.total_len > out_cap) {
+        set_err(err, 0, "buffer too small");
+        return (CFGPACK_ERR_ENCODE);
+    }
+
+    memset(out, 0, hdr.total_len);
+    memcpy(out, &hdr, sizeof(hdr));
+    memcpy(out + hdr.variants_off, recs, count * sizeof(family_variant_t));
+    family_sweep(ctxs, count, &sums, out, &hdr, recs);
+
+    crc = cfgpack_crc32c(out, off);
+    out[off] = (uint8_t)(crc);
+    out[off + 1] = (uint8_t)(crc >> 8);
+    out[off + 2] = (uint8_t)(crc >> 16);
+    out[off + 3] = (uint8_t)(crc >> 24);
+    return (CFGPACK_OK);
+}
+
+/** Whether [@p off, @p off + @p n) lies inside the first @p end bytes. */
+static int family_fits(size_t off, size_t n, size_t end) {
+    return (off <= end && n <= end - off);
+}
+
+/**
+ * @brief Validate a family image and find a variant; copy out both.
+ */
+static cfgpack_err_t family_open(const uint8_t *image,
+                                 size_t len,
+                                 const char *variant,
+                                 family_hdr_t *hdr,
+                                 family_variant_t *rec,
+                                 cfgpack_parse_error_t *err) {
+    size_t body;
+    size_t v;
+
+    if (((uintptr_t)image & (CFGPACK_SCHEMA_IMAGE_ALIGN - 1)) != 0) {
+        set_err(err, 0, "image not aligned");
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (len < sizeof(*hdr) + CFGPACK_CRC_SIZE) {
+        set_err(err, 0, "image truncated");
+        return (CFGPACK_ERR_DECODE);
+    }
+    memcpy(hdr, image, sizeof(*hdr));
+    if (hdr->magic != CFGPACK_SCHEMA_FAMILY_MAGIC ||
+        hdr->format != FAMILY_FORMAT) {
+        set_err(err, 0, "not a schema family image");
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (hdr->entry_size != sizeof(cfgpack_entry_t) ||
+        hdr->value_size != sizeof(cfgpack_value_t)) {
+        set_err(err, 0, "image built for a different ABI");
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (hdr->total_len > len ||
+        hdr->total_len < sizeof(*hdr) + CFGPACK_CRC_SIZE) {
+        set_err(err, 0, "image truncated");
+        return (CFGPACK_ERR_DECODE);
+    }
+    body = hdr->total_len - CFGPACK_CRC_SIZE;
+    if (hdr->variant_count == 0 ||
+        hdr->variant_count > CFGPACK_SCHEMA_FAMILY_MAX ||
+        hdr->shared_count > FAMILY_MAX_COUNT ||
+        !family_fits(hdr->variants_off,
+                     hdr->variant_count * sizeof(family_variant_t), body) ||
+        !family_fits(hdr->entries_off,
+                     hdr->shared_count * sizeof(cfgpack_entry_t), body) ||
+        !family_fits(hdr->values_off,
+                     hdr->shared_count * sizeof(cfgpack_value_t), body) ||
+        !family_fits(hdr->text_off, hdr->text_size, body) ||
+        (hdr->variants_off & (CFGPACK_SCHEMA_IMAGE_ALIGN - 1)) != 0 ||
+        (hdr->entries_off & (CFGPACK_SCHEMA_IMAGE_ALIGN - 1)) != 0 ||
+        (hdr->values_off & (CFGPACK_SCHEMA_IMAGE_ALIGN - 1)) != 0) {
+        set_err(err, 0, "bad image layout");
+        return (CFGPACK_ERR_DECODE);
+    }
+    if (cfgpack_crc32c(image, body) != image_get_le32(image + body)) {
+        set_err(err, 0, "image CRC mismatch");
+        return (CFGPACK_ERR_CRC);
+    }
+
+    for (v = 0; v < hdr->variant_count; ++v) {
+        memcpy(rec, image + hdr->variants_off + v * sizeof(*rec),
+               sizeof(*rec));
+        if (strncmp(rec->name, variant, sizeof(rec->name)) == 0 &&
+            strlen(variant) < sizeof(rec->name)) {
+            break;
+        }
+    }
+    if (v == hdr->variant_count) {
+        set_err(err, 0, "no such variant");
+        return (CFGPACK_ERR_MISSING);
+    }
+    if (rec->add_count > FAMILY_MAX_COUNT ||
+        rec->map_name[sizeof(rec->map_name) - 1] != '\0' ||
+        !family_fits(rec->entries_off,
+                     rec->add_count * sizeof(cfgpack_entry_t), body) ||
+        !family_fits(rec->values_off,
+                     rec->add_count * sizeof(cfgpack_value_t), body) ||
+        !family_fits(rec->drop_off, (hdr->shared_count + 7) / 8, body) ||
+        (rec->entries_off & (CFGPACK_SCHEMA_IMAGE_ALIGN - 1)) != 0 ||
+        (rec->values_off & (CFGPACK_SCHEMA_IMAGE_ALIGN - 1)) != 0) {
+        set_err(err, 0, "bad image layout");
+        return (CFGPACK_ERR_DECODE);
+    }
+    return (CFGPACK_OK);
+}
+
+/** @brief Merge cursor over a variant's kept shared and own entries. */
+typedef struct {
+    const cfgpack_entry_t *se; /**< Shared entries */
+    const cfgpack_value_t *sv; /**< Shared defaults */
+    const cfgpack_entry_t *ae; /**< Variant entries */
+    const cfgpack_value_t *av; /**< Variant defaults */
+    const uint8_t *drop;       /**< Dropped shared entries */
+    size_t shared;
+    size_t adds;
+    size_t i;
+    size_t j;
+    int prev; /**< Previous index, or -1 */
+    const family_hdr_t *hdr;
+} family_iter_t;
+
+static void family_iter_init(family_iter_t *it,
+                             const uint8_t *image,
+                             const family_hdr_t *hdr,
+                             const family_variant_t *rec) {
+    it->se = (const cfgpack_entry_t *)(const void *)(image + hdr->entries_off);
+    it->sv = (const cfgpack_value_t *)(const void *)(image + hdr->values_off);
+    it->ae = (const cfgpack_entry_t *)(const void *)(image + rec->entries_off);
+    it->av = (const cfgpack_value_t *)(const void *)(image + rec->values_off);
+    it->drop = image + rec->drop_off;
+    it->shared = hdr->shared_count;
+    it->adds = rec->add_count;
+    it->i = 0;
+    it->j = 0;
+    it->prev = -1;
+    it->hdr = hdr;
+}
+
+/**
+ * @brief Next entry of the variant in index order.
+ * @return 1 with @p e and @p v set, 0 at the end, -1 if the image is bad.
+ */
+static int family_next(family_iter_t *it,
+                       const cfgpack_entry_t **e,
+                       const cfgpack_value_t **v) {
+    cfgpack_type_t t;
+
+    while (it->i < it->shared &&
+           (it->drop[it->i / 8] & (1u << (it->i % 8))) != 0) {
+        it->i++;
+    }
+    if (it->i < it->shared &&
+        (it->j == it->adds || it->se[it->i].index < it->ae[it->j].index)) {
+        *e = &it->se[it->i];
+        *v = &it->sv[it->i++];
+    } else if (it->j < it->adds) {
+        *e = &it->ae[it->j];
+        *v = &it->av[it->j++];
+    } else {
+        return (0);
+    }
+
+    /* Same per-entry checks as an image, with text in the text region */
+    t = (*e)->type;
+    if ((unsigned)t > CFGPACK_TYPE_FSTR || (int)(*e)->index <= it->prev ||
+        (*e)->str_max > str_limit(t, 0)) {
+        return (-1);
+    }
+    if ((*e)->has_default &&
+        (t == CFGPACK_TYPE_STR || t == CFGPACK_TYPE_FSTR)) {
+        size_t off = (t == CFGPACK_TYPE_STR) ? (*v)->v.str.offset
+                                              : (*v)->v.fstr.offset;
+        size_t len = family_str_len(*v);
+
+        if (len > cfgpack_entry_str_max(*e) ||
+            !family_fits(off, len, it->hdr->text_size)) {
+            return (-1);
+        }
+    }
+    it->prev = (*e)->index;
+    return (1);
+}
+
+cfgpack_err_t cfgpack_schema_measure_family(const uint8_t *image,
+                                            size_t image_len,
+                                            const char *variant,
+                                            cfgpack_schema_measure_t *out,
+                                            cfgpack_parse_error_t *err) {
+    const cfgpack_entry_t *e;
+    const cfgpack_value_t *v;
+    family_variant_t rec;
+    family_hdr_t hdr;
+    family_iter_t it;
+    size_t values = 0;
+    uint16_t max_index = 0;
+    cfgpack_err_t rc;
+    int more;
+
+    if (!image || !variant || !out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = family_open(image, image_len, variant, &hdr, &rec, err);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    memset(out, 0, sizeof(*out));
+    family_iter_init(&it, image, &hdr, &rec);
+    while ((more = family_next(&it, &e, &v)) > 0) {
+        out->entry_count++;
+        if (e->type == CFGPACK_TYPE_STR) {
+            out->str_count++;
+            out->str_pool_size += cfgpack_entry_str_max(e) + 1;
+        } else if (e->type == CFGPACK_TYPE_FSTR) {
+            out->fstr_count++;
+            out->str_pool_size += cfgpack_entry_str_max(e) + 1;
+        }
+        max_index = e->index;
+        values += cfgpack_value_enc_max(e->type, cfgpack_entry_str_max(e));
+    }
+    if (more < 0) {
+        set_err(err, 0, "bad image entry");
+        return (CFGPACK_ERR_DECODE);
+    }
+    out->index_table_size = index_table_size(max_index, out->entry_count);
+    out->blob_max = cfgpack_blob_enc_max(out->entry_count, max_index, values);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_schema_attach_family(const uint8_t *image,
+                                           size_t image_len,
+                                           const char *variant,
+                                           const cfgpack_parse_opts_t *opts) {
+    const cfgpack_entry_t *e;
+    const cfgpack_value_t *v;
+    const char *text;
+    family_variant_t rec;
+    family_hdr_t hdr;
+    family_iter_t it;
+    size_t n = 0;
+    size_t slots;
+    size_t pool;
+    cfgpack_err_t rc;
+    int more;
+
+    if (!image || !variant || !opts || !opts->out_schema || !opts->entries ||
+        !opts->values) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = family_open(image, image_len, variant, &hdr, &rec, opts->err);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    /* Merge the kept shared entries with the variant's own */
+    family_iter_init(&it, image, &hdr, &rec);
+    while ((more = family_next(&it, &e, &v)) > 0) {
+        if (n >= opts->max_entries) {
+            set_err(opts->err, 0, "too many entries");
+            return (CFGPACK_ERR_BOUNDS);
+        }
+        opts->entries[n] = *e;
+        opts->values[n] = *v;
+        n++;
+    }
+    if (more < 0) {
+        set_err(opts->err, 0, "bad image entry");
+        return (CFGPACK_ERR_DECODE);
+    }
+
+    /* Lay out the pool as a parse would, then copy the string defaults */
+    pool = compute_str_offsets(opts->entries, n, opts->str_offsets,
+                               opts->str_offsets_count, &slots);
+    if (slots > opts->str_offsets_count || pool > opts->str_pool_cap ||
+        pool > (size_t)CFGPACK_STR_OFF_MAX + 1 ||
+        (slots > 0 && !opts->str_offsets) || (pool > 0 && !opts->str_pool)) {
+        set_err(opts->err, 0, "string buffers too small");
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    text = (const char *)image + hdr.text_off;
+    for (size_t k = 0; k < n; ++k) {
+        cfgpack_value_t *dst = &opts->values[k];
+        cfgpack_str_off_t off;
+        size_t from;
+        size_t len;
+
+        if (opts->entries[k].str_slot == CFGPACK_STR_SLOT_NONE) {
+            continue;
+        }
+        off = opts->str_offsets[opts->entries[k].str_slot];
+        len = opts->entries[k].has_default ? family_str_len(dst) : 0;
+        from = (dst->type == CFGPACK_TYPE_STR) ? dst->v.str.offset
+                                               : dst->v.fstr.offset;
+        if (len > 0) {
+            memcpy(opts->str_pool + off, text + from, len);
+        }
+        opts->str_pool[off + len] = '\0';
+        if (dst->type == CFGPACK_TYPE_STR) {
+            dst->v.str.offset = off;
+            dst->v.str.len = (uint16_t)len;
+        } else {
+            dst->v.fstr.offset = off;
+            dst->v.fstr.len = (uint8_t)len;
+        }
+    }
+
+    memcpy(opts->out_schema->map_name, rec.map_name, sizeof(rec.map_name));
+    opts->out_schema->version = rec.version;
+    opts->out_schema->entries = opts->entries;
+    opts->out_schema->entry_count = n;
+    return (CFGPACK_OK);
+}
@@ -0,0 +1,465 @@
+/**
+ * @file shm.c
+ * @brief Published context in shared memory (hosted only).
+ *
+ * See shm.h for the segment layout.  The publisher is the only writer of
+ * a segment; readers only load from it, so it may be mapped read-only in
+ * their processes.
+ */
+
+#ifndef _POSIX_C_SOURCE
+  #define _POSIX_C_SOURCE 200809L /* shm_open/mmap under -std=c99 */
+#endif
+
+#include "cfgpack/shm.h"
+
+#include "lookup.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef CFGPACK_SEQLOCK_BARRIER
+  #define SHM_BARRIER() CFGPACK_SEQLOCK_BARRIER()
+#else
+  #define SHM_BARRIER() __sync_synchronize()
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Layout
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define SHM_LAYOUT                                         \
+    ((uint32_t)sizeof(cfgpack_value_t) |                   \
+     ((uint32_t)sizeof(cfgpack_str_off_t) << 8) |          \
+     ((uint32_t)sizeof(cfgpack_entry_t) << 16) |           \
+     ((uint32_t)sizeof(cfgpack_shm_hdr_t) << 24))
+
+/** Regions start on 8-byte boundaries, for the values' 64-bit members. */
+#define SHM_ALIGN(n) (((n) + 7u) & ~(size_t)7u)
+
+static int seg_aligned(const void *seg) {
+    return (((uintptr_t)seg & 7u) == 0);
+}
+
+/**
+ * @brief Header cfgpack_shm_publish() writes for @p ctx, @c seq aside.
+ *
+ * Like a snapshot, the pool is the slot extent cfgpack_init() computed, or
+ * the bytes handed out so far on a copy-on-write context.
+ */
+static void shm_expect(const cfgpack_ctx_t *ctx, cfgpack_shm_hdr_t *h) {
+    const cfgpack_schema_t *schema = ctx->schema;
+    size_t n = schema->entry_count;
+    size_t strings = 0;
+    size_t pool = 0;
+    size_t off;
+
+    for (size_t i = 0; i < n; ++i) {
+        const cfgpack_entry_t *e = &schema->entries[i];
+
+        if (e->type == CFGPACK_TYPE_STR || e->type == CFGPACK_TYPE_FSTR) {
+            strings++;
+            pool += cfgpack_entry_str_max(e) + 1;
+        }
+    }
+    memset(h, 0, sizeof(*h));
+    h->magic = CFGPACK_SHM_MAGIC;
+    h->layout = SHM_LAYOUT;
+    h->version = schema->version;
+    h->fingerprint = cfgpack_schema_fingerprint(schema);
+    h->hash = cfgpack_schema_hash(schema);
+    h->entry_count = (uint32_t)n;
+    h->str_count = (uint32_t)strings;
+    h->pool_bytes = (uint32_t)(ctx->cow_base ? ctx->str_pool_used : pool);
+
+    off = SHM_ALIGN(sizeof(*h));
+    h->entries_off = (uint32_t)off;
+    off = SHM_ALIGN(off + n * sizeof(cfgpack_entry_t));
+    h->values_off = (uint32_t)off;
+    off = SHM_ALIGN(off + n * sizeof(cfgpack_value_t));
+    h->present_off = (uint32_t)off;
+    off = SHM_ALIGN(off + (n + CHAR_BIT - 1) / CHAR_BIT);
+    h->offsets_off = (uint32_t)off;
+    off = SHM_ALIGN(off + strings * sizeof(cfgpack_str_off_t));
+    h->pool_off = (uint32_t)off;
+    h->size = (uint32_t)(off + h->pool_bytes);
+    memcpy(h->map_name, schema->map_name, sizeof(h->map_name));
+}
+
+/** Whether @p a and @p b describe the same layout and schema. */
+static int shm_same(const cfgpack_shm_hdr_t *a, const cfgpack_shm_hdr_t *b) {
+    return (a->magic == b->magic && a->layout == b->layout &&
+            a->version == b->version && a->fingerprint == b->fingerprint &&
+            a->hash == b->hash && a->entry_count == b->entry_count &&
+            a->str_count == b->str_count && a->pool_bytes == b->pool_bytes &&
+            a->size == b->size);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Publish
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+size_t cfgpack_shm_size(const cfgpack_ctx_t *ctx) {
+    cfgpack_shm_hdr_t h;
+
+    if (!ctx || cfgpack_is_packed(ctx)) {
+        return (0);
+    }
+    shm_expect(ctx, &h);
+    return (h.size);
+}
+
+cfgpack_err_t cfgpack_shm_publish(cfgpack_ctx_t *ctx, void *seg, size_t cap) {
+    cfgpack_shm_hdr_t *h = (cfgpack_shm_hdr_t *)seg;
+    uint8_t *base = (uint8_t *)seg;
+    cfgpack_shm_hdr_t want;
+    uint32_t seq = 0;
+    size_t n;
+
+    if (!ctx || !seg || !seg_aligned(seg) || cfgpack_is_packed(ctx)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+#ifdef CFGPACK_LAZY
+    if (ctx->lazy_off) {
+        cfgpack_err_t rc = cfgpack_lazy_finish(ctx);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+#endif
+    shm_expect(ctx, &want);
+    if (cap < want.size) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    n = want.entry_count;
+
+    /* Odd from here on; a publisher that died mid-write left it odd */
+    if (h->magic == CFGPACK_SHM_MAGIC) {
+        seq = h->seq | 1u;
+    } else {
+        seq = 1;
+    }
+    h->seq = seq;
+    SHM_BARRIER();
+
+    if (!shm_same(h, &want) ||
+        memcmp(h->map_name, want.map_name, sizeof(want.map_name)) != 0) {
+        want.seq = seq;
+        memcpy(h, &want, sizeof(want));
+        memcpy(base + want.entries_off, ctx->schema->entries,
+               n * sizeof(cfgpack_entry_t));
+    }
+    memcpy(base + want.values_off, ctx->values, n * sizeof(cfgpack_value_t));
+    memcpy(base + want.present_off, ctx->present,
+           (n + CHAR_BIT - 1) / CHAR_BIT);
+    if (want.str_count) {
+        memcpy(base + want.offsets_off, ctx->str_offsets,
+               want.str_count * sizeof(cfgpack_str_off_t));
+    }
+    if (want.pool_bytes) {
+        memcpy(base + want.pool_off, ctx->str_pool, want.pool_bytes);
+    }
+
+    SHM_BARRIER();
+    h->seq = seq + 1u;
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Read
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Check a header copy against this build and the mapping size.
+ */
+static cfgpack_err_t shm_check(const cfgpack_shm_hdr_t *h, size_t len) {
+    size_t n = h->entry_count;
+
+    if (h->magic != CFGPACK_SHM_MAGIC) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    if (h->layout != SHM_LAYOUT || h->size > len ||
+        h->entries_off < sizeof(*h) || (h->entries_off & 7u) ||
+        (h->values_off & 7u) || h->values_off > h->size ||
+        h->present_off > h->size || h->offsets_off > h->size ||
+        h->pool_off > h->size) {
+        return (CFGPACK_ERR_DECODE);
+    }
+#ifndef CFGPACK_LARGE_SCHEMA
+    if (n > CFGPACK_MAX_ENTRIES) {
+        return (CFGPACK_ERR_DECODE);
+    }
+#endif
+    if (h->entries_off + n * sizeof(cfgpack_entry_t) > h->values_off ||
+        h->values_off + n * sizeof(cfgpack_value_t) > h->present_off ||
+        h->present_off + (n + CHAR_BIT - 1) / CHAR_BIT > h->offsets_off ||
+        h->offsets_off + h->str_count * sizeof(cfgpack_str_off_t) >
+            h->pool_off ||
+        h->pool_off + h->pool_bytes > h->size) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Point the reader's schema and view context at the segment.
+ */
+static void shm_view(cfgpack_shm_reader_t *r, const cfgpack_shm_hdr_t *h) {
+    uint8_t *base = (uint8_t *)(uintptr_t)r->hdr;
+    cfgpack_ctx_t *ctx = &r->ctx;
+
+    memset(&r->schema, 0, sizeof(r->schema));
+    memcpy(r->schema.map_name, h->map_name, sizeof(r->schema.map_name));
+    r->schema.map_name[sizeof(r->schema.map_name) - 1] = '\0';
+    r->schema.version = h->version;
+    r->schema.entries = (cfgpack_entry_t *)(base + h->entries_off);
+    r->schema.entry_count = h->entry_count;
+
+    /* Only the fields cfgpack_get*() reads; never written through */
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->schema = &r->schema;
+    ctx->values = (cfgpack_value_t *)(base + h->values_off);
+    ctx->values_count = h->entry_count;
+#ifdef CFGPACK_LARGE_SCHEMA
+    ctx->present = base + h->present_off;
+    ctx->bitmap_bytes = (h->entry_count + CHAR_BIT - 1) / CHAR_BIT;
+#endif
+    ctx->str_pool = (char *)(base + h->pool_off);
+    ctx->str_pool_cap = h->pool_bytes;
+    ctx->str_offsets = (cfgpack_str_off_t *)(base + h->offsets_off);
+    ctx->str_offsets_count = h->str_count;
+}
+
+/**
+ * @brief Refresh the parts of the view a publish may have replaced.
+ *
+ * Presence is inline in a context, so it is copied in; in a
+ * CFGPACK_LARGE_SCHEMA build it is read in place.
+ */
+static void shm_refresh(cfgpack_shm_reader_t *r) {
+#ifndef CFGPACK_LARGE_SCHEMA
+    const uint8_t *base = (const uint8_t *)r->hdr;
+
+    memcpy(r->ctx.present, base + r->hdr->present_off,
+           (r->schema.entry_count + CHAR_BIT - 1) / CHAR_BIT);
+#else
+    (void)r;
+#endif
+}
+
+cfgpack_err_t cfgpack_shm_attach(cfgpack_shm_reader_t *r,
+                                 const void *seg,
+                                 size_t len) {
+    const cfgpack_shm_hdr_t *h = (const cfgpack_shm_hdr_t *)seg;
+
+    if (!r || !seg || !seg_aligned(seg) || len < sizeof(*h)) {
+        return (!r || !seg || !seg_aligned(seg) ? CFGPACK_ERR_ARGS
+                                                : CFGPACK_ERR_MISSING);
+    }
+    for (unsigned n = 0; n < CFGPACK_SHM_RETRIES; ++n) {
+        cfgpack_shm_hdr_t copy;
+        uint32_t seq = h->seq;
+        cfgpack_err_t rc;
+
+        SHM_BARRIER();
+        if (seq & 1u) {
+            sched_yield();
+            continue;
+        }
+        memcpy(&copy, (const void *)h, sizeof(copy));
+        rc = shm_check(&copy, len);
+        if (rc == CFGPACK_OK) {
+            r->hdr = h;
+            r->len = len;
+            r->fingerprint = copy.fingerprint;
+            r->hash = copy.hash;
+            shm_view(r, &copy);
+            if (cfgpack_schema_fingerprint(&r->schema) != copy.fingerprint ||
+                cfgpack_schema_hash(&r->schema) != copy.hash) {
+                rc = CFGPACK_ERR_DECODE;
+            }
+        }
+        SHM_BARRIER();
+        if (h->seq == seq) {
+            if (rc != CFGPACK_OK) {
+                memset(r, 0, sizeof(*r));
+            }
+            return (rc);
+        }
+    }
+    memset(r, 0, sizeof(*r));
+    return (CFGPACK_ERR_BUSY);
+}
+
+cfgpack_err_t cfgpack_shm_read(cfgpack_shm_reader_t *r,
+                               cfgpack_shm_read_fn fn,
+                               void *user) {
+    const cfgpack_shm_hdr_t *h;
+
+    if (!r || !r->hdr || !fn) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    h = r->hdr;
+    for (unsigned n = 0; n < CFGPACK_SHM_RETRIES; ++n) {
+        uint32_t seq = h->seq;
+        cfgpack_err_t rc;
+        int same;
+
+        SHM_BARRIER();
+        if (seq & 1u) {
+            sched_yield();
+            continue;
+        }
+        same = h->magic == CFGPACK_SHM_MAGIC &&
+               h->fingerprint == r->fingerprint && h->hash == r->hash &&
+               h->size <= r->len;
+        rc = CFGPACK_ERR_TYPE_MISMATCH;
+        if (same) {
+            shm_refresh(r);
+            rc = fn(&r->ctx, user);
+        }
+        SHM_BARRIER();
+        if (h->seq == seq) {
+            return (rc);
+        }
+    }
+    return (CFGPACK_ERR_BUSY);
+}
+
+typedef struct {
+    uint16_t index;
+    cfgpack_value_t *out;
+    char *buf;
+    size_t cap;
+    size_t *len;
+} shm_args_t;
+
+static cfgpack_err_t shm_get(const cfgpack_ctx_t *ctx, void *arg) {
+    shm_args_t *a = (shm_args_t *)arg;
+
+    return (cfgpack_get(ctx, a->index, a->out));
+}
+
+static cfgpack_err_t shm_get_str(const cfgpack_ctx_t *ctx, void *arg) {
+    shm_args_t *a = (shm_args_t *)arg;
+    const char *s;
+    size_t n;
+    cfgpack_err_t rc = cfgpack_get_str_view(ctx, a->index, &s, &n);
+
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    /* n may be torn; the view is bounds-checked, the copy must be too */
+    if (n >= a->cap) {
+        return (CFGPACK_ERR_STR_TOO_LONG);
+    }
+    memcpy(a->buf, s, n);
+    a->buf[n] = '\0';
+    if (a->len) {
+        *a->len = n;
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_shm_get(cfgpack_shm_reader_t *r,
+                              uint16_t index,
+                              cfgpack_value_t *out) {
+    shm_args_t a = {0};
+
+    if (!out) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    a.index = index;
+    a.out = out;
+    return (cfgpack_shm_read(r, shm_get, &a));
+}
+
+cfgpack_err_t cfgpack_shm_get_str(cfgpack_shm_reader_t *r,
+                                  uint16_t index,
+                                  char *buf,
+                                  size_t cap,
+                                  size_t *len) {
+    shm_args_t a = {0};
+
+    if (!buf) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    a.index = index;
+    a.buf = buf;
+    a.cap = cap;
+    a.len = len;
+    return (cfgpack_shm_read(r, shm_get_str, &a));
+}
+
+uint32_t cfgpack_shm_seq(const cfgpack_shm_reader_t *r) {
+    if (!r || !r->hdr) {
+        return (0);
+    }
+    return (r->hdr->seq);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * POSIX shared memory objects
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+cfgpack_err_t cfgpack_shm_create(const char *name, size_t size, void **seg) {
+    void *p;
+    int fd;
+
+    if (!name || !seg || size == 0) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    fd = shm_open(name, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return (CFGPACK_ERR_IO);
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return (CFGPACK_ERR_IO);
+    }
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return (CFGPACK_ERR_IO);
+    }
+    *seg = p;
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_shm_map(const char *name,
+                              const void **seg,
+                              size_t *len) {
+    struct stat st;
+    void *p;
+    int fd;
+
+    if (!name || !seg || !len) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return (CFGPACK_ERR_IO);
+    }
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return (CFGPACK_ERR_IO);
+    }
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return (CFGPACK_ERR_IO);
+    }
+    *seg = p;
+    *len = (size_t)st.st_size;
+    return (CFGPACK_OK);
+}
+
+void cfgpack_shm_unmap(const void *seg, size_t len) {
+    if (seg) {
+        munmap((void *)(uintptr_t)seg, len);
+    }
+}
@@ -0,0 +1,322 @@
+/**
+ * @file slots.c
+ * @brief A/B double-buffered pageout/pagein over a raw slot device.
+ *
+ * See slots.h for the slot layout and publication order.
+ */
+
+#include "cfgpack/slots.h"
+
+#include "crc32.h"
+#include "lookup.h"
+
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Header encoding
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+            ((uint32_t)p[3] << 24));
+}
+
+void cfgpack_slot_hdr_encode(uint8_t *out, const cfgpack_slot_hdr_t *hdr) {
+    put_le32(out, CFGPACK_SLOT_MAGIC);
+    put_le32(out + 4, hdr->seq);
+    put_le32(out + 8, hdr->len);
+    put_le32(out + 12, cfgpack_crc32c(out, 12));
+}
+
+cfgpack_err_t cfgpack_slot_hdr_decode(const uint8_t *in,
+                                      cfgpack_slot_hdr_t *hdr) {
+    if (get_le32(in) != CFGPACK_SLOT_MAGIC ||
+        get_le32(in + 12) != cfgpack_crc32c(in, 12)) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    hdr->seq = get_le32(in + 4);
+    hdr->len = get_le32(in + 8);
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Slot scanning
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Read both headers.
+ * @param valid  valid[i] is set to 1 if slot i has a valid header that
+ *               fits the slot.
+ */
+static cfgpack_err_t scan_slots(const cfgpack_slot_dev_t *dev,
+                                cfgpack_slot_hdr_t hdrs[2],
+                                int valid[2]) {
+    uint8_t raw[CFGPACK_SLOT_HDR_SIZE];
+
+    for (uint8_t s = 0; s < 2; ++s) {
+        cfgpack_err_t rc = dev->read(dev->user, s, 0, raw, sizeof(raw));
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        valid[s] = cfgpack_slot_hdr_decode(raw, &hdrs[s]) == CFGPACK_OK &&
+                   hdrs[s].len <= dev->slot_size - CFGPACK_SLOT_HDR_SIZE;
+    }
+    return (CFGPACK_OK);
+}
+
+/**
+ * @brief Index of the newest valid slot, or -1 if none.
+ */
+static int newest_slot(const cfgpack_slot_hdr_t hdrs[2], const int valid[2]) {
+    if (valid[0] && valid[1]) {
+        return (cfgpack_slot_seq_newer(hdrs[1].seq, hdrs[0].seq) ? 1 : 0);
+    }
+    if (valid[0]) {
+        return (0);
+    }
+    return (valid[1] ? 1 : -1);
+}
+
+/**
+ * @brief Check a slot's blob against its CRC trailer.
+ *
+ * Reads the blob through @p buf in chunks.  Sets @p *ok to 1 if the trailer
+ * matches.
+ */
+static cfgpack_err_t slot_blob_ok(const cfgpack_slot_dev_t *dev,
+                                  uint8_t slot,
+                                  uint32_t len,
+                                  uint8_t *buf,
+                                  size_t cap,
+                                  int *ok) {
+    uint8_t trailer[CFGPACK_CRC_SIZE];
+    uint32_t crc = cfgpack_crc32c_init();
+    size_t body;
+    size_t off = 0;
+    cfgpack_err_t rc;
+
+    *ok = 0;
+    if (len < CFGPACK_CRC_SIZE) {
+        return (CFGPACK_OK);
+    }
+    body = len - CFGPACK_CRC_SIZE;
+    while (off < body) {
+        size_t n = (body - off < cap) ? body - off : cap;
+        rc = dev->read(dev->user, slot, CFGPACK_SLOT_HDR_SIZE + off, buf, n);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        crc = cfgpack_crc32c_update(crc, buf, n);
+        off += n;
+    }
+    rc = dev->read(dev->user, slot, CFGPACK_SLOT_HDR_SIZE + body, trailer,
+                   sizeof(trailer));
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    *ok = cfgpack_crc32c_final(crc) == get_le32(trailer);
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_slots_select(const cfgpack_slot_dev_t *dev,
+                                   uint8_t *out_slot,
+                                   cfgpack_slot_hdr_t *out_hdr) {
+    cfgpack_slot_hdr_t hdrs[2];
+    int valid[2];
+    cfgpack_err_t rc;
+    int s;
+
+    if (!dev || !out_slot || dev->slot_size < CFGPACK_SLOT_HDR_SIZE) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = scan_slots(dev, hdrs, valid);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    s = newest_slot(hdrs, valid);
+    if (s < 0) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    *out_slot = (uint8_t)s;
+    if (out_hdr) {
+        *out_hdr = hdrs[s];
+    }
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Sink / source adapters
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+typedef struct {
+    const cfgpack_slot_dev_t *dev;
+    uint8_t slot;
+    size_t off; /**< Next program offset within the slot. */
+} slot_io_t;
+
+static cfgpack_err_t slot_sink(void *user, const uint8_t *data, size_t len) {
+    slot_io_t *s = (slot_io_t *)user;
+    cfgpack_err_t rc;
+
+    if (len > s->dev->slot_size - s->off) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    rc = s->dev->prog(s->dev->user, s->slot, s->off, data, len);
+    s->off += len;
+    return (rc);
+}
+
+typedef struct {
+    const cfgpack_slot_dev_t *dev;
+    uint8_t slot;
+    size_t len; /**< Blob length from the header. */
+} slot_src_t;
+
+static cfgpack_err_t slot_source(void *user,
+                                 size_t offset,
+                                 uint8_t *dst,
+                                 size_t cap,
+                                 size_t *out_len) {
+    slot_src_t *s = (slot_src_t *)user;
+    cfgpack_err_t rc;
+
+    if (offset >= s->len) {
+        *out_len = 0;
+        return (CFGPACK_OK);
+    }
+    if (cap > s->len - offset) {
+        cap = s->len - offset;
+    }
+    rc = s->dev->read(s->dev->user, s->slot, CFGPACK_SLOT_HDR_SIZE + offset,
+                      dst, cap);
+    *out_len = (rc == CFGPACK_OK) ? cap : 0;
+    return (rc);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Public API
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+cfgpack_err_t cfgpack_pageout_slots(cfgpack_ctx_t *ctx,
+                                    const cfgpack_slot_dev_t *dev,
+                                    uint8_t *chunk_buf,
+                                    size_t chunk_cap) {
+    uint8_t saved_dirty[CFGPACK_DIRTY_SAVE_BYTES];
+    uint8_t raw[CFGPACK_SLOT_HDR_SIZE];
+    cfgpack_slot_hdr_t hdrs[2];
+    cfgpack_slot_hdr_t hdr;
+    slot_io_t io;
+    cfgpack_err_t rc;
+    size_t len = 0;
+    int valid[2];
+    int newest;
+
+    if (!ctx || !dev || !chunk_buf || !dev->read || !dev->prog ||
+        !dev->erase || dev->slot_size < CFGPACK_SLOT_HDR_SIZE) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (chunk_cap < CFGPACK_STREAM_CHUNK_MIN) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+    rc = cfgpack_pageout_measure(ctx, &len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    if (len > dev->slot_size - CFGPACK_SLOT_HDR_SIZE) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+
+    rc = scan_slots(dev, hdrs, valid);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    newest = newest_slot(hdrs, valid);
+    if (newest >= 0) {
+        /* Never overwrite the only good copy because the newer header
+         * points at a damaged blob: retarget the damaged slot instead. */
+        int ok;
+        rc = slot_blob_ok(dev, (uint8_t)newest, hdrs[newest].len, chunk_buf,
+                          chunk_cap, &ok);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        if (!ok) {
+            valid[newest] = 0;
+            newest = newest_slot(hdrs, valid);
+        }
+    }
+    io.dev = dev;
+    io.slot = (newest == 0) ? 1 : 0;
+    io.off = CFGPACK_SLOT_HDR_SIZE;
+    hdr.seq = (newest < 0) ? 1u : hdrs[newest].seq + 1u;
+    hdr.len = (uint32_t)len;
+
+    rc = dev->erase(dev->user, io.slot);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    /* Blob first, header last: the slot is published by the header write */
+    cfgpack_dirty_save(ctx, saved_dirty);
+    rc = cfgpack_pageout_stream(ctx, slot_sink, &io, chunk_buf, chunk_cap);
+    if (rc == CFGPACK_OK) {
+        cfgpack_slot_hdr_encode(raw, &hdr);
+        rc = dev->prog(dev->user, io.slot, 0, raw, sizeof(raw));
+    }
+    if (rc != CFGPACK_OK) {
+        cfgpack_dirty_restore(ctx, saved_dirty);
+    }
+    return (rc);
+}
+
+cfgpack_err_t cfgpack_pagein_slots(cfgpack_ctx_t *ctx,
+                                   const cfgpack_slot_dev_t *dev,
+                                   uint8_t *window,
+                                   size_t window_cap,
+                                   uint8_t *out_slot) {
+    cfgpack_slot_hdr_t hdrs[2];
+    slot_src_t src;
+    cfgpack_err_t rc;
+    int valid[2];
+    int s;
+
+    if (!ctx || !dev || !window || !dev->read ||
+        dev->slot_size < CFGPACK_SLOT_HDR_SIZE) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = scan_slots(dev, hdrs, valid);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    s = newest_slot(hdrs, valid);
+    if (s < 0) {
+        return (CFGPACK_ERR_MISSING);
+    }
+
+    src.dev = dev;
+    for (int attempt = 0; attempt < 2 && s >= 0; ++attempt) {
+        src.slot = (uint8_t)s;
+        src.len = hdrs[s].len;
+        rc = cfgpack_pagein_stream(ctx, slot_source, &src, window, window_cap);
+        if (rc == CFGPACK_OK) {
+            if (out_slot) {
+                *out_slot = (uint8_t)s;
+            }
+            return (CFGPACK_OK);
+        }
+        if (rc != CFGPACK_ERR_CRC && rc != CFGPACK_ERR_DECODE) {
+            return (rc);
+        }
+        /* Newest copy is damaged: fall back to the other one */
+        valid[s] = 0;
+        s = newest_slot(hdrs, valid);
+    }
+    return (rc);
+}
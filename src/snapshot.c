@@ -0,0 +1,244 @@
+/**
+ * @file snapshot.c
+ * @brief Raw context snapshots (cfgpack_snapshot_save / _load).
+ *
+ * See snapshot.h for the layout.
+ */
+
+#include "cfgpack/snapshot.h"
+
+#include "crc32.h"
+#include "lookup.h"
+
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Layout
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Decoded snapshot header. */
+typedef struct {
+    uint32_t magic;
+    uint32_t layout;
+    uint64_t fingerprint;
+    uint32_t hash;
+    uint32_t entries;
+    uint32_t strings;
+    uint32_t pool;
+} snap_hdr_t;
+
+#define SNAP_LAYOUT \
+    ((uint32_t)sizeof(cfgpack_value_t) | \
+     ((uint32_t)sizeof(cfgpack_str_off_t) << 8))
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    memcpy(p, &v, 4);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v;
+
+    memcpy(&v, p, 4);
+    return (v);
+}
+
+/**
+ * @brief Header the running build and schema would write for @p ctx.
+ *
+ * The pool is the slot extent cfgpack_init() computed, or the bytes
+ * handed out so far on a copy-on-write context.
+ */
+static void snap_expect(const cfgpack_ctx_t *ctx, snap_hdr_t *h) {
+    const cfgpack_schema_t *schema = ctx->schema;
+    size_t strings = 0;
+    size_t pool = 0;
+
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        const cfgpack_entry_t *e = &schema->entries[i];
+
+        if (e->type == CFGPACK_TYPE_STR || e->type == CFGPACK_TYPE_FSTR) {
+            strings++;
+            pool += cfgpack_entry_str_max(e) + 1;
+        }
+    }
+    h->magic = CFGPACK_SNAPSHOT_MAGIC;
+    h->layout = SNAP_LAYOUT;
+    h->fingerprint = cfgpack_schema_fingerprint(schema);
+    h->hash = cfgpack_schema_hash(schema);
+    h->entries = (uint32_t)schema->entry_count;
+    h->strings = (uint32_t)strings;
+    h->pool = (uint32_t)(ctx->cow_base ? ctx->str_pool_used : pool);
+}
+
+static size_t snap_bitmap_bytes(const snap_hdr_t *h) {
+    return ((h->entries + CHAR_BIT - 1) / CHAR_BIT);
+}
+
+static size_t snap_size(const snap_hdr_t *h) {
+    return (CFGPACK_SNAPSHOT_HDR_SIZE + h->entries * sizeof(cfgpack_value_t) +
+            snap_bitmap_bytes(h) + h->strings * sizeof(cfgpack_str_off_t) +
+            h->pool + CFGPACK_CRC_SIZE);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Save
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+size_t cfgpack_snapshot_size(const cfgpack_ctx_t *ctx) {
+    snap_hdr_t h;
+
+    if (!ctx || cfgpack_is_packed(ctx)) {
+        return (0);
+    }
+    snap_expect(ctx, &h);
+    return (snap_size(&h));
+}
+
+cfgpack_err_t cfgpack_snapshot_save(cfgpack_ctx_t *ctx,
+                                    uint8_t *out,
+                                    size_t cap,
+                                    size_t *out_len) {
+    snap_hdr_t h;
+    uint8_t *p;
+    uint32_t crc;
+
+    if (!ctx || !out || !out_len || cfgpack_is_packed(ctx)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+#ifdef CFGPACK_LAZY
+    if (ctx->lazy_off) {
+        cfgpack_err_t rc = cfgpack_lazy_finish(ctx);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+#endif
+    snap_expect(ctx, &h);
+    if (cap < snap_size(&h)) {
+        return (CFGPACK_ERR_ENCODE);
+    }
+
+    put_u32(out, h.magic);
+    put_u32(out + 4, h.layout);
+    memcpy(out + 8, &h.fingerprint, 8);
+    put_u32(out + 16, h.hash);
+    put_u32(out + 20, h.entries);
+    put_u32(out + 24, h.strings);
+    put_u32(out + 28, h.pool);
+    p = out + CFGPACK_SNAPSHOT_HDR_SIZE;
+    memcpy(p, ctx->values, h.entries * sizeof(cfgpack_value_t));
+    p += h.entries * sizeof(cfgpack_value_t);
+    memcpy(p, ctx->present, snap_bitmap_bytes(&h));
+    p += snap_bitmap_bytes(&h);
+    if (h.strings) {
+        memcpy(p, ctx->str_offsets, h.strings * sizeof(cfgpack_str_off_t));
+        p += h.strings * sizeof(cfgpack_str_off_t);
+    }
+    if (h.pool) {
+        memcpy(p, ctx->str_pool, h.pool);
+        p += h.pool;
+    }
+    crc = cfgpack_crc32c(out, (size_t)(p - out));
+    p[0] = (uint8_t)(crc);
+    p[1] = (uint8_t)(crc >> 8);
+    p[2] = (uint8_t)(crc >> 16);
+    p[3] = (uint8_t)(crc >> 24);
+    *out_len = snap_size(&h);
+    return (CFGPACK_OK);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Load
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Check @p snap against the running build and schema.
+ *
+ * Everything but the pool size must match; a copy-on-write pool may have
+ * grown since, so it only has to fit.
+ */
+static cfgpack_err_t snap_check(const cfgpack_ctx_t *ctx,
+                                const uint8_t *snap,
+                                size_t len,
+                                snap_hdr_t *h) {
+    snap_hdr_t want;
+    uint32_t stored;
+
+    if (!snap || len < CFGPACK_SNAPSHOT_HDR_SIZE ||
+        get_u32(snap) != CFGPACK_SNAPSHOT_MAGIC) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    snap_expect(ctx, &want);
+    h->layout = get_u32(snap + 4);
+    memcpy(&h->fingerprint, snap + 8, 8);
+    h->hash = get_u32(snap + 16);
+    h->entries = get_u32(snap + 20);
+    h->strings = get_u32(snap + 24);
+    h->pool = get_u32(snap + 28);
+    if (h->layout != want.layout || h->fingerprint != want.fingerprint ||
+        h->hash != want.hash || h->entries != want.entries ||
+        h->strings != want.strings) {
+        return (CFGPACK_ERR_MISSING);
+    }
+    if (h->pool > ctx->str_pool_cap || h->strings > ctx->str_offsets_count) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    if (len != snap_size(h)) {
+        return (CFGPACK_ERR_DECODE);
+    }
+    stored = (uint32_t)snap[len - 4] | ((uint32_t)snap[len - 3] << 8) |
+             ((uint32_t)snap[len - 2] << 16) | ((uint32_t)snap[len - 1] << 24);
+    if (stored != cfgpack_crc32c(snap, len - CFGPACK_CRC_SIZE)) {
+        return (CFGPACK_ERR_CRC);
+    }
+    return (CFGPACK_OK);
+}
+
+cfgpack_err_t cfgpack_snapshot_load(cfgpack_ctx_t *ctx,
+                                    const uint8_t *snap,
+                                    size_t snap_len,
+                                    const uint8_t *blob,
+                                    size_t blob_len) {
+    const uint8_t *p;
+    snap_hdr_t h;
+    cfgpack_err_t rc;
+
+    if (!ctx || cfgpack_is_packed(ctx) || cfgpack_in_txn(ctx)) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    rc = snap_check(ctx, snap, snap_len, &h);
+    if (rc != CFGPACK_OK) {
+        return (blob ? cfgpack_pagein_buf(ctx, blob, blob_len) : rc);
+    }
+
+    /* Entries present before and after both count as changed */
+    cfgpack_notify_mark_present(ctx);
+    cfgpack_seq_write_begin(ctx);
+    p = snap + CFGPACK_SNAPSHOT_HDR_SIZE;
+    memcpy(ctx->values, p, h.entries * sizeof(cfgpack_value_t));
+    p += h.entries * sizeof(cfgpack_value_t);
+    memset(ctx->present, 0, cfgpack_bitmap_bytes(ctx));
+    memcpy(ctx->present, p, snap_bitmap_bytes(&h));
+    p += snap_bitmap_bytes(&h);
+    memset(ctx->dirty, 0, cfgpack_bitmap_bytes(ctx));
+    if (h.strings) {
+        memcpy(ctx->str_offsets, p, h.strings * sizeof(cfgpack_str_off_t));
+        p += h.strings * sizeof(cfgpack_str_off_t);
+    }
+    if (h.pool) {
+        memcpy(ctx->str_pool, p, h.pool);
+    }
+    if (ctx->cow_base) {
+        ctx->str_pool_used = h.pool;
+    }
+    cfgpack_lazy_clear(ctx);
+#ifdef CFGPACK_SIZE_CACHE
+    if (ctx->size_cached) {
+        (void)cfgpack_size_cache_init(ctx);
+    }
+#endif
+    cfgpack_seq_write_end(ctx);
+    cfgpack_notify_mark_present(ctx);
+    cfgpack_notify_dispatch(ctx);
+    return (CFGPACK_OK);
+}
@@ -0,0 +1,40 @@
+/**
+ * @file stats.c
+ * @brief Global counters and hook for CFGPACK_STATS builds.
+ *
+ * Compiles to nothing unless CFGPACK_STATS is defined; the counting
+ * sites themselves are the macros in stats.h.
+ */
+
+#ifdef CFGPACK_STATS
+
+  #include "stats.h"
+
+  #include <string.h>
+
+cfgpack_stats_t cfgpack_stats_all;
+cfgpack_stats_hook_fn cfgpack_stats_hook_cb;
+void *cfgpack_stats_hook_user;
+
+cfgpack_err_t cfgpack_stats_init(cfgpack_ctx_t *ctx, cfgpack_stats_t *stats) {
+    if (!ctx) {
+        return (CFGPACK_ERR_ARGS);
+    }
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+    ctx->stats = stats;
+    return (CFGPACK_OK);
+}
+
+cfgpack_stats_t *cfgpack_stats_global(void) {
+    return (&cfgpack_stats_all);
+}
+
+void cfgpack_stats_hook(cfgpack_stats_hook_fn fn, void *user) {
+    cfgpack_stats_hook_cb = NULL;
+    cfgpack_stats_hook_user = user;
+    cfgpack_stats_hook_cb = fn;
+}
+
+#endif /* CFGPACK_STATS */
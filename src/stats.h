@@ -0,0 +1,59 @@
+/**
+ * @file stats.h
+ * @brief Counting and hook sites for CFGPACK_STATS builds.
+ *
+ * Without CFGPACK_STATS every macro expands to ((void)0) and its
+ * arguments are not evaluated.
+ */
+#ifndef CFGPACK_STATS_H
+#define CFGPACK_STATS_H
+
+#include "cfgpack/api.h"
+
+#ifdef CFGPACK_STATS
+
+extern cfgpack_stats_t cfgpack_stats_all;
+extern cfgpack_stats_hook_fn cfgpack_stats_hook_cb;
+extern void *cfgpack_stats_hook_user;
+
+/**
+ * @brief Add @p n to counter @p field globally and, if attached, in the
+ *        counters of @p ctx (may be NULL).
+ */
+  #define CFGPACK_STAT_ADD(ctx, field, n)                                   \
+      do {                                                                  \
+          const cfgpack_ctx_t *stat_ctx_ = (ctx);                           \
+          uint32_t stat_n_ = (uint32_t)(n);                                 \
+          cfgpack_stats_all.field += stat_n_;                               \
+          if (stat_ctx_ && stat_ctx_->stats) {                              \
+              stat_ctx_->stats->field += stat_n_;                           \
+          }                                                                 \
+      } while (0)
+
+/** @brief Report the start of @p op on @p ctx to the hook. */
+  #define CFGPACK_STAT_BEGIN(op, ctx)                                       \
+      do {                                                                  \
+          if (cfgpack_stats_hook_cb) {                                      \
+              cfgpack_stats_hook_cb((op), 0, (ctx),                         \
+                                    cfgpack_stats_hook_user);               \
+          }                                                                 \
+      } while (0)
+
+/** @brief Report the end of @p op on @p ctx to the hook. */
+  #define CFGPACK_STAT_END(op, ctx)                                         \
+      do {                                                                  \
+          if (cfgpack_stats_hook_cb) {                                      \
+              cfgpack_stats_hook_cb((op), 1, (ctx),                         \
+                                    cfgpack_stats_hook_user);               \
+          }                                                                 \
+      } while (0)
+
+#else
+
+  #define CFGPACK_STAT_ADD(ctx, field, n) ((void)0)
+  #define CFGPACK_STAT_BEGIN(op, ctx)     ((void)0)
+  #define CFGPACK_STAT_END(op, ctx)       ((void)0)
+
+#endif /* CFGPACK_STATS */
+
+#endif /* CFGPACK_STATS_H */
@@ -27,28 +27,32 @@ int tokens_create(tokens_t *tokens, uint16_t n, char **provided) {
 }
 
 /**
- * @brief Test whether a character is in the delimiter set.
+ * @brief Build a 256-bit membership table for a delimiter set.
  *
- * @param s Character to test.
- * @param d NUL-terminated delimiter string.
- * @return 1 if delimiter, 0 otherwise.
+ * Lets tokens_find() test each input byte with one load and mask instead
+ * of a walk over the delimiter string.
+ *
+ * @param set Table to fill (bit c set if c is a delimiter).
+ * @param d   NUL-terminated delimiter string.
  */
-static int _is_delimiter(char s, const char *d) {
-    size_t len;
-
-    if (!d) {
-        return (0);
-    }
-
-    len = strlen(d);
-
-    for (size_t i = 0; i < len; i++) {
-        if (d[i] == s) {
-            return (1);
-        }
+static void _delimiter_set(uint32_t set[8], const char *d) {
+    memset(set, 0, 8 * sizeof(set[0]));
+    for (; *d; d++) {
+        unsigned char c = (unsigned char)*d;
+        set[c >> 5] |= 1u << (c & 31);
     }
+}
 
-    return (0);
+/**
+ * @brief Test whether a character is in the delimiter set.
+ *
+ * @param set Table from _delimiter_set().
+ * @param s   Character to test.
+ * @return 1 if delimiter, 0 otherwise.
+ */
+static int _is_delimiter(const uint32_t set[8], char s) {
+    unsigned char c = (unsigned char)s;
+    return ((set[c >> 5] >> (c & 31)) & 1u);
 }
 
 /** @copydoc tokens_find */
@@ -57,6 +61,7 @@ int tokens_find(tokens_t *tokens,
                 const char *delimiters,
                 uint16_t n_tokens,
                 size_t *stop_offset) {
+    uint32_t set[8];
     bool new_token;
     size_t len;
 
@@ -70,12 +75,13 @@ int tokens_find(tokens_t *tokens,
 
     tokens->used = 0;
     new_token = true;
+    _delimiter_set(set, delimiters);
 
     /* Use the length of the string before mutilation. */
     len = strlen(input);
 
     for (size_t i = 0; i < len; i++) {
-        if (_is_delimiter(input[i], delimiters)) {
+        if (_is_delimiter(set, input[i])) {
             input[i] = 0;
             new_token = true;
             continue;
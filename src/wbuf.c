@@ -3,10 +3,6 @@
 #include <stdint.h>
 #include <string.h>
 
-#ifdef CFGPACK_HOSTED
-  #include <stdio.h>
-#endif
-
 #include "wbuf.h"
 
 /** @copydoc wbuf_init */
@@ -58,68 +54,358 @@ void wbuf_put_uint(wbuf_t *w, unsigned long long val) {
 /** @copydoc wbuf_put_int */
 void wbuf_put_int(wbuf_t *w, long long val) {
     if (val < 0) {
+        /* Negate as unsigned: -val overflows for LLONG_MIN */
         wbuf_putc(w, '-');
-        val = -val;
+        wbuf_put_uint(w, 0ULL - (unsigned long long)val);
+        return;
     }
     wbuf_put_uint(w, (unsigned long long)val);
 }
 
-/** @copydoc wbuf_put_double */
-void wbuf_put_double(wbuf_t *w, double val) {
-#ifdef CFGPACK_HOSTED
-    char tmp[32];
-    int len = snprintf(tmp, sizeof(tmp), "%.17g", val);
-    if (len > 0 && (size_t)len < sizeof(tmp)) {
-        wbuf_append(w, tmp, (size_t)len);
-    }
-#else
-    /* Minimal formatter: sign, integer part, decimal point, up to 9 fractional digits */
-    uint64_t ipart;
-    double frac;
-    uint64_t frac_int;
-    char digits[9];
-    int ndigits;
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Shortest round-trip float formatting (Grisu2)
+ *
+ * Florian Loitsch's Grisu2 with Milo Yip's digit generation: the value and
+ * the midpoints to its neighbours are scaled by a cached power of ten into
+ * 64-bit fixed point, and digits are generated until the result falls
+ * between the midpoints.  Parsing the output back (strtod, or strtod and
+ * a cast for f32) gives the original value.  Integer arithmetic only,
+ * apart from one multiply choosing the cached power.
+ * ───────────────────────────────────────────────────────────────────────────── */
 
-    if (val < 0) {
-        wbuf_putc(w, '-');
-        val = -val;
+/** @brief Unpacked binary float: f * 2^e. */
+typedef struct {
+    uint64_t f;
+    int e;
+} diy_fp_t;
+
+/** @brief Normalized 10^k for k = -348, -340, ..., 340 (f * 2^e). */
+static const struct {
+    uint64_t f;
+    int16_t e;
+} cached_pow10[] = {
+    {0xfa8fd5a0081c0288ull, -1220}, {0xbaaee17fa23ebf76ull, -1193},
+    {0x8b16fb203055ac76ull, -1166}, {0xcf42894a5dce35eaull, -1140},
+    {0x9a6bb0aa55653b2dull, -1113}, {0xe61acf033d1a45dfull, -1087},
+    {0xab70fe17c79ac6caull, -1060}, {0xff77b1fcbebcdc4full, -1034},
+    {0xbe5691ef416bd60cull, -1007}, {0x8dd01fad907ffc3cull, -980},
+    {0xd3515c2831559a83ull, -954}, {0x9d71ac8fada6c9b5ull, -927},
+    {0xea9c227723ee8bcbull, -901}, {0xaecc49914078536dull, -874},
+    {0x823c12795db6ce57ull, -847}, {0xc21094364dfb5637ull, -821},
+    {0x9096ea6f3848984full, -794}, {0xd77485cb25823ac7ull, -768},
+    {0xa086cfcd97bf97f4ull, -741}, {0xef340a98172aace5ull, -715},
+    {0xb23867fb2a35b28eull, -688}, {0x84c8d4dfd2c63f3bull, -661},
+    {0xc5dd44271ad3cdbaull, -635}, {0x936b9fcebb25c996ull, -608},
+    {0xdbac6c247d62a584ull, -582}, {0xa3ab66580d5fdaf6ull, -555},
+    {0xf3e2f893dec3f126ull, -529}, {0xb5b5ada8aaff80b8ull, -502},
+    {0x87625f056c7c4a8bull, -475}, {0xc9bcff6034c13053ull, -449},
+    {0x964e858c91ba2655ull, -422}, {0xdff9772470297ebdull, -396},
+    {0xa6dfbd9fb8e5b88full, -369}, {0xf8a95fcf88747d94ull, -343},
+    {0xb94470938fa89bcfull, -316}, {0x8a08f0f8bf0f156bull, -289},
+    {0xcdb02555653131b6ull, -263}, {0x993fe2c6d07b7facull, -236},
+    {0xe45c10c42a2b3b06ull, -210}, {0xaa242499697392d3ull, -183},
+    {0xfd87b5f28300ca0eull, -157}, {0xbce5086492111aebull, -130},
+    {0x8cbccc096f5088ccull, -103}, {0xd1b71758e219652cull, -77},
+    {0x9c40000000000000ull, -50}, {0xe8d4a51000000000ull, -24},
+    {0xad78ebc5ac620000ull, 3}, {0x813f3978f8940984ull, 30},
+    {0xc097ce7bc90715b3ull, 56}, {0x8f7e32ce7bea5c70ull, 83},
+    {0xd5d238a4abe98068ull, 109}, {0x9f4f2726179a2245ull, 136},
+    {0xed63a231d4c4fb27ull, 162}, {0xb0de65388cc8ada8ull, 189},
+    {0x83c7088e1aab65dbull, 216}, {0xc45d1df942711d9aull, 242},
+    {0x924d692ca61be758ull, 269}, {0xda01ee641a708deaull, 295},
+    {0xa26da3999aef774aull, 322}, {0xf209787bb47d6b85ull, 348},
+    {0xb454e4a179dd1877ull, 375}, {0x865b86925b9bc5c2ull, 402},
+    {0xc83553c5c8965d3dull, 428}, {0x952ab45cfa97a0b3ull, 455},
+    {0xde469fbd99a05fe3ull, 481}, {0xa59bc234db398c25ull, 508},
+    {0xf6c69a72a3989f5cull, 534}, {0xb7dcbf5354e9beceull, 561},
+    {0x88fcf317f22241e2ull, 588}, {0xcc20ce9bd35c78a5ull, 614},
+    {0x98165af37b2153dfull, 641}, {0xe2a0b5dc971f303aull, 667},
+    {0xa8d9d1535ce3b396ull, 694}, {0xfb9b7cd9a4a7443cull, 720},
+    {0xbb764c4ca7a44410ull, 747}, {0x8bab8eefb6409c1aull, 774},
+    {0xd01fef10a657842cull, 800}, {0x9b10a4e5e9913129ull, 827},
+    {0xe7109bfba19c0c9dull, 853}, {0xac2820d9623bf429ull, 880},
+    {0x80444b5e7aa7cf85ull, 907}, {0xbf21e44003acdd2dull, 933},
+    {0x8e679c2f5e44ff8full, 960}, {0xd433179d9c8cb841ull, 986},
+    {0x9e19db92b4e31ba9ull, 1013}, {0xeb96bf6ebadf77d9ull, 1039},
+    {0xaf87023b9bf0ee6bull, 1066},
+};
+
+static const uint64_t pow10_u64[] = {1ull,
+                                     10ull,
+                                     100ull,
+                                     1000ull,
+                                     10000ull,
+                                     100000ull,
+                                     1000000ull,
+                                     10000000ull,
+                                     100000000ull,
+                                     1000000000ull,
+                                     10000000000ull,
+                                     100000000000ull,
+                                     1000000000000ull,
+                                     10000000000000ull,
+                                     100000000000000ull,
+                                     1000000000000000ull,
+                                     10000000000000000ull,
+                                     100000000000000000ull,
+                                     1000000000000000000ull,
+                                     10000000000000000000ull};
+
+static diy_fp_t fp_normalize(diy_fp_t x) {
+    while (!(x.f & ((uint64_t)1 << 63))) {
+        x.f <<= 1;
+        x.e--;
     }
-    ipart = (uint64_t)val;
-    wbuf_put_uint(w, ipart);
+    return (x);
+}
 
-    frac = val - (double)ipart;
-    if (frac > 1e-10) { /* Skip if essentially zero */
-        wbuf_putc(w, '.');
-        /* Multiply by 10^9 and round to get all digits at once - avoids accumulated error */
-        frac_int = (uint64_t)(frac * 1000000000.0 + 0.5);
-        /* Extract up to 9 digits */
-        ndigits = 9;
-        for (int i = 8; i >= 0; i--) {
-            digits[i] = '0' + (frac_int % 10);
-            frac_int /= 10;
+/** @brief Upper 64 bits of the 128-bit product, rounded. */
+static diy_fp_t fp_mul(diy_fp_t x, diy_fp_t y) {
+    const uint64_t m32 = 0xFFFFFFFFu;
+    uint64_t a = x.f >> 32;
+    uint64_t b = x.f & m32;
+    uint64_t c = y.f >> 32;
+    uint64_t d = y.f & m32;
+    uint64_t ac = a * c;
+    uint64_t bc = b * c;
+    uint64_t ad = a * d;
+    uint64_t bd = b * d;
+    uint64_t mid = (bd >> 32) + (ad & m32) + (bc & m32) + (1u << 31);
+    diy_fp_t r;
+
+    r.f = ac + (ad >> 32) + (bc >> 32) + (mid >> 32);
+    r.e = x.e + y.e + 64;
+    return (r);
+}
+
+/**
+ * @brief Cached power c = 10^-k with c.e placing a product with an
+ *        exponent-@p e operand in [-60, -32].
+ */
+static diy_fp_t cached_power(int e, int *k) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ik = (int)dk;
+    unsigned idx;
+    diy_fp_t c;
+
+    if (dk - ik > 0.0) {
+        ik++;
+    }
+    idx = (unsigned)((ik >> 3) + 1);
+    *k = -(-348 + (int)(idx << 3));
+    c.f = cached_pow10[idx].f;
+    c.e = cached_pow10[idx].e;
+    return (c);
+}
+
+static void grisu_round(char *buf,
+                        int len,
+                        uint64_t delta,
+                        uint64_t rest,
+                        uint64_t ten_kappa,
+                        uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w ||
+            wp_w - rest > rest + ten_kappa - wp_w)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static void digit_gen(diy_fp_t w,
+                      diy_fp_t mp,
+                      uint64_t delta,
+                      char *buf,
+                      int *len,
+                      int *k) {
+    int shift = -mp.e;
+    uint64_t one = (uint64_t)1 << shift;
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> shift);
+    uint64_t p2 = mp.f & (one - 1);
+    int kappa = 1;
+
+    while (kappa < 10 && p1 >= pow10_u64[kappa]) {
+        kappa++;
+    }
+    *len = 0;
+
+    /* Integer part */
+    while (kappa > 0) {
+        uint32_t div = (uint32_t)pow10_u64[kappa - 1];
+        uint32_t d = p1 / div;
+        uint64_t rest;
+
+        p1 %= div;
+        if (d || *len) {
+            buf[(*len)++] = (char)('0' + d);
+        }
+        kappa--;
+        rest = ((uint64_t)p1 << shift) + p2;
+        if (rest <= delta) {
+            *k += kappa;
+            grisu_round(buf, *len, delta, rest, pow10_u64[kappa] << shift,
+                        wp_w);
+            return;
+        }
+    }
+
+    /* Fractional part */
+    for (;;) {
+        char d;
+
+        p2 *= 10;
+        delta *= 10;
+        d = (char)(p2 >> shift);
+        if (d || *len) {
+            buf[(*len)++] = (char)('0' + d);
+        }
+        p2 &= one - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            grisu_round(buf, *len, delta, p2, one,
+                        -kappa < 20 ? wp_w * pow10_u64[-kappa] : 0);
+            return;
         }
-        /* Trim trailing zeros */
-        while (ndigits > 0 && digits[ndigits - 1] == '0') {
-            ndigits--;
+    }
+}
+
+/**
+ * @brief Shortest digits of @p v (positive, finite, non-zero) given its
+ *        significand width: v = buf[0..len) * 10^k.
+ *
+ * @param f     Significand including the hidden bit for normal values.
+ * @param e     Binary exponent (v = f * 2^e).
+ * @param lower_closer Non-zero if v is a power of two above the smallest
+ *                     normal, so the gap below it is half the gap above.
+ */
+static void grisu2(uint64_t f,
+                   int e,
+                   int lower_closer,
+                   char *buf,
+                   int *len,
+                   int *k) {
+    diy_fp_t v = {f, e};
+    diy_fp_t mp = {(f << 1) + 1, e - 1};
+    diy_fp_t mm;
+    diy_fp_t c;
+
+    mp = fp_normalize(mp);
+    if (lower_closer) {
+        mm.f = (f << 2) - 1;
+        mm.e = e - 2;
+    } else {
+        mm.f = (f << 1) - 1;
+        mm.e = e - 1;
+    }
+    mm.f <<= mm.e - mp.e;
+    mm.e = mp.e;
+    v = fp_normalize(v);
+
+    c = cached_power(mp.e, k);
+    v = fp_mul(v, c);
+    mp = fp_mul(mp, c);
+    mm = fp_mul(mm, c);
+    mm.f++;
+    mp.f--;
+    digit_gen(v, mp, mp.f - mm.f, buf, len, k);
+}
+
+/**
+ * @brief Append digits @p d[0..n) * 10^k like printf's %g: positional for
+ *        decimal exponents -4..16, otherwise d.ddde±XX.
+ */
+static void put_decimal(wbuf_t *w, const char *d, int n, int k) {
+    int point = n + k; /* digits before the decimal point */
+
+    if (point > 17 || point < -3) {
+        int x = point - 1;
+
+        wbuf_putc(w, d[0]);
+        if (n > 1) {
+            wbuf_putc(w, '.');
+            wbuf_append(w, d + 1, (size_t)(n - 1));
+        }
+        wbuf_putc(w, 'e');
+        wbuf_putc(w, x < 0 ? '-' : '+');
+        if (x < 0) {
+            x = -x;
+        }
+        if (x < 10) {
+            wbuf_putc(w, '0');
         }
-        for (int i = 0; i < ndigits; i++) {
-            wbuf_putc(w, digits[i]);
+        wbuf_put_uint(w, (unsigned long long)x);
+    } else if (k >= 0) {
+        wbuf_append(w, d, (size_t)n);
+        for (int i = 0; i < k; ++i) {
+            wbuf_putc(w, '0');
         }
+    } else if (point > 0) {
+        wbuf_append(w, d, (size_t)point);
+        wbuf_putc(w, '.');
+        wbuf_append(w, d + point, (size_t)(n - point));
+    } else {
+        wbuf_puts(w, "0.");
+        for (int i = point; i < 0; ++i) {
+            wbuf_putc(w, '0');
+        }
+        wbuf_append(w, d, (size_t)n);
     }
-#endif
+}
+
+/**
+ * @brief Format a float given as sign, biased exponent and stored
+ *        significand of a format with @p mant_bits and @p bias.
+ */
+static void put_float_bits(wbuf_t *w,
+                           int neg,
+                           unsigned bexp,
+                           uint64_t mant,
+                           int mant_bits,
+                           unsigned exp_max,
+                           int bias) {
+    uint64_t hidden = (uint64_t)1 << mant_bits;
+    char digits[24];
+    int len;
+    int k;
+
+    if (bexp == exp_max) {
+        wbuf_puts(w, mant ? "nan" : (neg ? "-inf" : "inf"));
+        return;
+    }
+    if (neg) {
+        wbuf_putc(w, '-');
+    }
+    if (bexp == 0 && mant == 0) {
+        wbuf_putc(w, '0');
+        return;
+    }
+    if (bexp == 0) {
+        grisu2(mant, 1 - bias - mant_bits, 0, digits, &len, &k);
+    } else {
+        grisu2(mant | hidden, (int)bexp - bias - mant_bits,
+               mant == 0 && bexp > 1, digits, &len, &k);
+    }
+    put_decimal(w, digits, len, k);
+}
+
+/** @copydoc wbuf_put_double */
+void wbuf_put_double(wbuf_t *w, double val) {
+    uint64_t bits;
+
+    memcpy(&bits, &val, sizeof(bits));
+    put_float_bits(w, (int)(bits >> 63), (unsigned)(bits >> 52) & 0x7FFu,
+                   bits & (((uint64_t)1 << 52) - 1), 52, 0x7FFu, 1023);
 }
 
 /** @copydoc wbuf_put_float */
 void wbuf_put_float(wbuf_t *w, float val) {
-#ifdef CFGPACK_HOSTED
-    char tmp[32];
-    int len = snprintf(tmp, sizeof(tmp), "%.9g", (double)val);
-    if (len > 0 && (size_t)len < sizeof(tmp)) {
-        wbuf_append(w, tmp, (size_t)len);
-    }
-#else
-    wbuf_put_double(w, (double)val);
-#endif
+    uint32_t bits;
+
+    memcpy(&bits, &val, sizeof(bits));
+    put_float_bits(w, (int)(bits >> 31), (bits >> 23) & 0xFFu,
+                   bits & ((1u << 23) - 1), 23, 0xFFu, 127);
 }
 
 /** @copydoc wbuf_try_append */
@@ -88,10 +88,11 @@ void wbuf_put_int(wbuf_t *w, long long val);
 /**
  * @brief Format a double-precision float as text and append it.
  *
- * On hosted builds (@c CFGPACK_HOSTED) this uses @c snprintf with
- * <tt>"%.17g"</tt> formatting.  On embedded builds a minimal integer +
- * fractional digit formatter is used (up to 9 fractional digits, trailing
- * zeros trimmed).
+ * Writes the shortest decimal that reads back as @p val (Grisu2), without
+ * @c snprintf, heap or more than a few dozen bytes of stack.  Output is
+ * positional for decimal exponents -4 to 16 and d.ddde±XX otherwise, like
+ * <tt>"%g"</tt>; integral values carry no fraction ("8080", "-0").
+ * Infinities and NaN are written as @c inf, @c -inf and @c nan.
  *
  * @param w   Write buffer.
  * @param val Value to format.
@@ -101,9 +102,8 @@ void wbuf_put_double(wbuf_t *w, double val);
 /**
  * @brief Format a single-precision float as text and append it.
  *
- * On hosted builds (@c CFGPACK_HOSTED) this uses @c snprintf with
- * <tt>"%.9g"</tt> formatting.  On embedded builds this delegates to
- * @ref wbuf_put_double.
+ * As @ref wbuf_put_double, but the digits are the shortest that read back
+ * as @p val once rounded to float, so 0.1f is written as "0.1".
  *
  * @param w   Write buffer.
  * @param val Value to format.
@@ -0,0 +1,225 @@
+/* Flash-aligned pageout: blobs padded to whole program pages, read back
+ * from a raw region without a stored length. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES  24
+#define REGION_CAP 8192
+#define CRC_SIZE   4
+
+static cfgpack_type_t flash_type(size_t i) {
+    return (i % 8 == 7 ? CFGPACK_TYPE_STR : CFGPACK_TYPE_U32);
+}
+
+/* u32 at index 1..24 except a str at every 8th; fixture_fill(f, 0, 1000)
+ * sets the u32 entries to 1000 * index. */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    return (fixture_make(f, "flash", N_ENTRIES, flash_type));
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Whole pages for any page size, read back from the whole region
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_aligned_roundtrip) {
+    static const size_t pages[] = {1, 16, 100, 256, 300, 4096};
+    static fixture_t f;
+    static fixture_t g;
+    static uint8_t plain[REGION_CAP];
+    static uint8_t region[REGION_CAP];
+    size_t plain_len = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    fixture_fill(&f, 0, 1000);
+    CHECK(cfgpack_pageout(&f.ctx, plain, sizeof(plain), &plain_len) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Program pages from 1 to 4096 bytes");
+    for (size_t p = 0; p < sizeof(pages) / sizeof(pages[0]); ++p) {
+        cfgpack_flash_geom_t geom = {pages[p], pages[p] * 2, 0xff};
+        size_t len = 0;
+        size_t found = 0;
+        size_t erase;
+
+        memset(region, geom.erase_value, sizeof(region));
+        fixture_fill(&f, 0, 1000);
+        CHECK(cfgpack_pageout_aligned(&f.ctx, region, sizeof(region), &len,
+                                      &geom) == CFGPACK_OK);
+        CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+        CHECK(len % geom.prog_size == 0);
+        CHECK(len >= plain_len + 10 && len < plain_len + 10 + pages[p]);
+        erase = cfgpack_flash_erase_span(&geom, len);
+        CHECK(erase % geom.erase_size == 0 && erase >= len);
+        CHECK(erase - len < geom.erase_size);
+        LOG("%zu-byte pages: %zu-byte blob (plain %zu), %zu to erase",
+            pages[p], len, plain_len, erase);
+
+        /* Same entries as the plain blob after the map16 count, then the
+         * pad key */
+        CHECK(region[0] == 0xde && region[2] == plain[2] + 1);
+        CHECK(memcmp(region + 3, plain + 3,
+                     plain_len - CRC_SIZE - 3) == 0);
+        CHECK(region[plain_len - CRC_SIZE] == 0xce);
+        CHECK(region[len - CRC_SIZE - 1] == 0xff ||
+              len == plain_len + 10);
+
+        CHECK(cfgpack_blob_extent(region, sizeof(region), &found) ==
+              CFGPACK_OK);
+        CHECK(found == len);
+        CHECK(make_fixture(&g) == CFGPACK_OK);
+        CHECK(cfgpack_pagein_aligned(&g.ctx, region, sizeof(region),
+                                     &found) == CFGPACK_OK);
+        CHECK(found == len && fixture_filled(&g, 0, 1000));
+        CHECK(make_fixture(&g) == CFGPACK_OK);
+        CHECK(cfgpack_pagein_buf(&g.ctx, region, len) == CFGPACK_OK);
+        CHECK(fixture_filled(&g, 0, 1000));
+    }
+
+    LOG_SECTION("Any other erase value fills the padding");
+    {
+        cfgpack_flash_geom_t geom = {64, 4096, 0x00};
+        size_t len = 0;
+
+        memset(region, 0xa5, sizeof(region));
+        CHECK(cfgpack_pageout_aligned(&f.ctx, region, sizeof(region), &len,
+                                      &geom) == CFGPACK_OK);
+        CHECK(len % 64 == 0);
+        CHECK(len == plain_len + 10 ||
+              region[len - CRC_SIZE - 1] == 0x00);
+        CHECK(make_fixture(&g) == CFGPACK_OK);
+        CHECK(cfgpack_pagein_aligned(&g.ctx, region, sizeof(region), NULL) ==
+              CFGPACK_OK);
+        CHECK(fixture_filled(&g, 0, 1000));
+    }
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Locating the end of other blobs, and of none
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_aligned_extent) {
+    static fixture_t f;
+    static fixture_t g;
+    static uint8_t region[REGION_CAP];
+    size_t len = 0;
+    size_t found = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    fixture_fill(&f, 0, 1000);
+
+    LOG_SECTION("A plain blob followed by erased flash");
+    memset(region, 0xff, sizeof(region));
+    CHECK(cfgpack_pageout(&f.ctx, region, sizeof(region), &len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_blob_extent(region, sizeof(region), &found) == CFGPACK_OK);
+    CHECK(found == len);
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_aligned(&g.ctx, region, sizeof(region), NULL) ==
+          CFGPACK_OK);
+    CHECK(fixture_filled(&g, 0, 1000));
+
+    LOG_SECTION("An erased or truncated region");
+    CHECK(cfgpack_blob_extent(region, len - 1, &found) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_blob_extent(region, len - CRC_SIZE - 1, &found) ==
+          CFGPACK_ERR_DECODE);
+    memset(region, 0xff, sizeof(region));
+    CHECK(cfgpack_blob_extent(region, sizeof(region), &found) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_pagein_aligned(&g.ctx, region, sizeof(region), NULL) ==
+          CFGPACK_ERR_DECODE);
+    memset(region, 0x00, sizeof(region));
+    CHECK(cfgpack_blob_extent(region, sizeof(region), &found) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(fixture_filled(&g, 0, 1000));
+
+    LOG_SECTION("A corrupt blob still fails its CRC");
+    CHECK(cfgpack_pageout(&f.ctx, region, sizeof(region), &len) ==
+          CFGPACK_OK);
+    region[len - CRC_SIZE - 1] ^= 0x01;
+    CHECK(cfgpack_pagein_aligned(&g.ctx, region, sizeof(region), NULL) ==
+          CFGPACK_ERR_CRC);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Argument and capacity errors
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_aligned_errors) {
+    static fixture_t f;
+    static uint8_t region[REGION_CAP];
+    cfgpack_flash_geom_t geom = {256, 4096, 0xff};
+    cfgpack_flash_geom_t bad = geom;
+    size_t len = 0;
+    size_t need = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    fixture_fill(&f, 0, 1000);
+
+    LOG_SECTION("Arguments");
+    CHECK(cfgpack_pageout_aligned(NULL, region, sizeof(region), &len,
+                                  &geom) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_aligned(&f.ctx, NULL, sizeof(region), &len,
+                                  &geom) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_aligned(&f.ctx, region, sizeof(region), &len,
+                                  NULL) == CFGPACK_ERR_ARGS);
+    bad.prog_size = 0;
+    CHECK(cfgpack_pageout_aligned(&f.ctx, region, sizeof(region), &len,
+                                  &bad) == CFGPACK_ERR_ARGS);
+    bad.prog_size = 256;
+    bad.erase_size = 1000;
+    CHECK(cfgpack_pageout_aligned(&f.ctx, region, sizeof(region), &len,
+                                  &bad) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_blob_extent(NULL, 4, &len) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_blob_extent(region, 0, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_blob_extent(region, 0, &len) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_pagein_aligned(NULL, region, sizeof(region), NULL) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_aligned(&f.ctx, NULL, 0, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == N_ENTRIES);
+
+    LOG_SECTION("Too small a buffer reports the size needed");
+    CHECK(cfgpack_pageout_aligned(&f.ctx, region, sizeof(region), &len,
+                                  &geom) == CFGPACK_OK);
+    fixture_fill(&f, 0, 1000);
+    CHECK(cfgpack_pageout_aligned(&f.ctx, region, len - 1, &need, &geom) ==
+          CFGPACK_ERR_ENCODE);
+    CHECK(need == len);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == N_ENTRIES);
+    CHECK(cfgpack_pageout_aligned(&f.ctx, region, len, &need, &geom) ==
+          CFGPACK_OK);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    overall |= (test_case_result("aligned_roundtrip",
+                                 test_aligned_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("aligned_extent", test_aligned_extent()) !=
+                TEST_OK);
+    overall |= (test_case_result("aligned_errors", test_aligned_errors()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
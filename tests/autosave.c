@@ -0,0 +1,224 @@
+/* Write-behind autosave: debounce, staleness cap and save budget on a fake
+ * clock, plus the hosted background thread. */
+
+#define _POSIX_C_SOURCE 200809L /* nanosleep under -std=c99 */
+
+#include "cfgpack/autosave.h"
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/* Save target handed to the autosave callback */
+typedef struct {
+    uint8_t data[128];
+    size_t len;
+    unsigned writes;
+    cfgpack_err_t fail;
+} flash_t;
+
+static const char map[] = "ui 1\n"
+                          "1 level u8 0\n"
+                          "2 name str:16 \"x\"\n"
+                          "3 gain f32 NIL\n";
+
+static cfgpack_err_t save_to_flash(cfgpack_ctx_t *ctx, void *user) {
+    flash_t *fl = user;
+
+    if (fl->fail != CFGPACK_OK) {
+        return (fl->fail);
+    }
+    fl->writes++;
+    return (cfgpack_pageout(ctx, fl->data, sizeof(fl->data), &fl->len));
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. A burst of sets becomes one save after the debounce
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_autosave_debounce) {
+    static fixture_t f;
+    static flash_t flash;
+    cfgpack_autosave_cfg_t cfg = {100, 300, 0};
+    cfgpack_autosave_t as;
+    uint32_t wait = 0;
+    uint32_t t;
+    uint8_t u8 = 0;
+
+    CHECK(fixture_parse(&f, map) == CFGPACK_OK);
+    cfgpack_dirty_clear_all(&f.ctx);
+    CHECK(cfgpack_autosave_init(&as, &f.ctx, &cfg, save_to_flash, &flash) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Nothing dirty, nothing to do");
+    CHECK(cfgpack_autosave_tick(&as, 0, &wait) == CFGPACK_OK);
+    CHECK(wait == UINT32_MAX && flash.writes == 0);
+
+    LOG_SECTION("Slider burst: one save, 100 ms after the last set");
+    for (t = 1000; t < 1100; t += 10) {
+        CHECK(cfgpack_set_u8(&f.ctx, 1, (uint8_t)t) == CFGPACK_OK);
+        CHECK(cfgpack_autosave_tick(&as, t, &wait) == CFGPACK_OK);
+        CHECK(wait == 100);
+    }
+    CHECK(cfgpack_autosave_tick(&as, 1150, &wait) == CFGPACK_OK);
+    CHECK(wait == 40 && flash.writes == 0);
+    CHECK(cfgpack_autosave_tick(&as, 1190, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 1 && wait == UINT32_MAX);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+    CHECK(cfgpack_pagein_buf(&f.ctx, flash.data, flash.len) == CFGPACK_OK);
+    CHECK(cfgpack_get_u8(&f.ctx, 1, &u8) == CFGPACK_OK);
+    CHECK(u8 == (uint8_t)1090);
+    CHECK(cfgpack_autosave_tick(&as, 2000, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 1);
+
+    LOG_SECTION("Sets that never pause are saved at max_stale_ms");
+    for (t = 5000; t <= 5400; t += 50) {
+        CHECK(cfgpack_set_u8(&f.ctx, 1, (uint8_t)t) == CFGPACK_OK);
+        CHECK(cfgpack_autosave_tick(&as, t, &wait) == CFGPACK_OK);
+        if (t < 5300) {
+            CHECK(flash.writes == 1);
+        }
+    }
+    CHECK(flash.writes == 2);
+
+    LOG_SECTION("Wrapping clock");
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 7) == CFGPACK_OK);
+    CHECK(cfgpack_autosave_tick(&as, UINT32_MAX - 49, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 2);
+    CHECK(cfgpack_autosave_tick(&as, 49, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 2 && wait == 1);
+    CHECK(cfgpack_autosave_tick(&as, 50, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 3);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Save budget, flush and failed saves
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_autosave_budget) {
+    static fixture_t f;
+    static flash_t flash;
+    cfgpack_autosave_cfg_t cfg = {100, 200, 60};
+    cfgpack_autosave_t as;
+    uint32_t wait = 0;
+
+    CHECK(fixture_parse(&f, map) == CFGPACK_OK);
+    cfgpack_dirty_clear_all(&f.ctx);
+    CHECK(cfgpack_autosave_init(&as, &f.ctx, &cfg, save_to_flash, &flash) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("60 per hour: saves at least a minute apart");
+    CHECK(cfgpack_set_str(&f.ctx, 2, "a") == CFGPACK_OK);
+    CHECK(cfgpack_autosave_tick(&as, 0, &wait) == CFGPACK_OK);
+    CHECK(cfgpack_autosave_tick(&as, 100, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 1);
+    CHECK(cfgpack_set_str(&f.ctx, 2, "b") == CFGPACK_OK);
+    CHECK(cfgpack_autosave_tick(&as, 200, &wait) == CFGPACK_OK);
+    CHECK(wait == 59900);
+    CHECK(cfgpack_autosave_tick(&as, 1000, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 1 && wait == 59100);
+    CHECK(cfgpack_autosave_tick(&as, 60100, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 2);
+
+    LOG_SECTION("Flush ignores debounce and budget");
+    CHECK(cfgpack_autosave_flush(&as) == CFGPACK_OK);
+    CHECK(flash.writes == 2);
+    CHECK(cfgpack_set_str(&f.ctx, 2, "c") == CFGPACK_OK);
+    CHECK(cfgpack_autosave_flush(&as) == CFGPACK_OK);
+    CHECK(flash.writes == 3 && cfgpack_get_dirty_count(&f.ctx) == 0);
+    CHECK(as.saves == 3);
+
+    LOG_SECTION("A failed save stays pending and is retried later");
+    cfg.max_per_hour = 0;
+    CHECK(cfgpack_autosave_init(&as, &f.ctx, &cfg, save_to_flash, &flash) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 9) == CFGPACK_OK);
+    flash.fail = CFGPACK_ERR_IO;
+    CHECK(cfgpack_autosave_tick(&as, 0, &wait) == CFGPACK_OK);
+    CHECK(cfgpack_autosave_tick(&as, 100, &wait) == CFGPACK_ERR_IO);
+    CHECK(wait == 100 && cfgpack_get_dirty_count(&f.ctx) == 1);
+    flash.fail = CFGPACK_OK;
+    CHECK(cfgpack_autosave_tick(&as, 150, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 3);
+    CHECK(cfgpack_autosave_tick(&as, 200, &wait) == CFGPACK_OK);
+    CHECK(flash.writes == 4 && cfgpack_get_dirty_count(&f.ctx) == 0);
+
+    LOG_SECTION("Bad arguments");
+    CHECK(cfgpack_autosave_init(NULL, &f.ctx, &cfg, save_to_flash, &flash) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_autosave_init(&as, &f.ctx, &cfg, NULL, &flash) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_autosave_tick(NULL, 0, &wait) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_autosave_flush(NULL) == CFGPACK_ERR_ARGS);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. The background thread saves sets made under its lock
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_autosave_thread) {
+    static fixture_t f;
+    static flash_t flash;
+    static cfgpack_autosave_thread_t th;
+    cfgpack_autosave_cfg_t cfg = {5, 0, 0};
+    struct timespec ms = {0, 1000000L};
+    cfgpack_autosave_t as;
+    unsigned writes = 0;
+    uint8_t u8 = 0;
+
+    CHECK(fixture_parse(&f, map) == CFGPACK_OK);
+    cfgpack_dirty_clear_all(&f.ctx);
+    CHECK(cfgpack_autosave_init(&as, &f.ctx, &cfg, save_to_flash, &flash) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_autosave_start(&th, &as) == CFGPACK_OK);
+
+    LOG_SECTION("Set, then wait for the thread to save it");
+    cfgpack_autosave_lock(&th);
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 42) == CFGPACK_OK);
+    cfgpack_autosave_unlock(&th);
+    for (int i = 0; i < 2000 && writes == 0; ++i) {
+        nanosleep(&ms, NULL);
+        cfgpack_autosave_lock(&th);
+        writes = flash.writes;
+        cfgpack_autosave_unlock(&th);
+    }
+    CHECK(writes == 1);
+
+    LOG_SECTION("Stop saves what the thread has not saved yet");
+    cfgpack_autosave_lock(&th);
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 43) == CFGPACK_OK);
+    cfgpack_autosave_unlock(&th);
+    CHECK(cfgpack_autosave_stop(&th) == CFGPACK_OK);
+    CHECK(flash.writes == 2 && th.err == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, flash.data, flash.len) == CFGPACK_OK);
+    CHECK(cfgpack_get_u8(&f.ctx, 1, &u8) == CFGPACK_OK && u8 == 43);
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("autosave_debounce",
+                                 test_autosave_debounce()) != TEST_OK);
+    overall |= (test_case_result("autosave_budget",
+                                 test_autosave_budget()) != TEST_OK);
+    overall |= (test_case_result("autosave_thread",
+                                 test_autosave_thread()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
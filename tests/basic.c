@@ -20,6 +20,7 @@ TEST_CASE(test_basic_case) {
     char str_pool[128];
     uint16_t str_offsets[1]; /* 1 string entry (index 2 is str) */
 
+    memset(entries, 0, sizeof(entries));
     LOG("Creating schema with 2 entries: 'a' (u8) and 'b' (str)");
     schema.map_name[0] = '\0';
     schema.version = 1;
@@ -245,6 +246,7 @@ TEST_CASE(test_typed_convenience_functions) {
     char str_pool[128];
     uint16_t str_offsets[2];
 
+    memset(entries, 0, sizeof(entries));
     LOG("Creating schema with 6 entries of various types:");
     LOG("  Index 1: u8v (u8)");
     LOG("  Index 2: i32v (i32)");
@@ -0,0 +1,466 @@
+/**
+ * @file bench.c
+ * @brief Throughput and latency benchmarks for parse, pagein and pageout.
+ *
+ * Standalone hosted program.  For each schema size it generates a .map
+ * schema of mixed types, derives the JSON and msgpack forms from it (as
+ * cfgpack-schema-pack would), pages out a blob, and then times:
+ *
+ *   parse_{map,json,msgpack}     schema parse into caller buffers
+ *   measure_{map,json,msgpack}   schema measure
+ *   write_json                   cfgpack_schema_write_json(), dominated
+ *                                by float formatting for float schemas
+ *   pageout                      cfgpack_pageout()
+ *   pagein                       cfgpack_pagein_buf()
+ *   pagein_remap                 cfgpack_pagein_remap() of a blob saved by
+ *                                a schema whose indices all moved
+ *   crc32c                       CRC-32C over the blob
+ *   pagein_{lz4,heatshrink}      decompress + pagein of the same blob
+ *
+ * Each op runs in batches long enough to span at least the round time;
+ * the fastest of BENCH_ROUNDS batches is reported, which filters out
+ * scheduler noise.  Results go to stdout as JSON, one result per line so
+ * two runs can be compared with diff or jq.  `bytes` is the size of the
+ * data one op reads (parse, measure, pagein, crc32c; for compressed
+ * pagein the compressed input) or writes (write_json, pageout).
+ *
+ * Sizes above CFGPACK_MAX_ENTRIES are skipped; `make bench-large-schema`
+ * rebuilds with CFGPACK_LARGE_SCHEMA to cover them.
+ *
+ * Build: make bench           (writes build/bench.json)
+ * Run:   build/out/bench [--ms <round-ms>] > results.json
+ */
+
+#ifndef _POSIX_C_SOURCE
+  #define _POSIX_C_SOURCE 200809L /* clock_gettime under -std=c99 */
+#endif
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/compress.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* CRC-32C: linked from libcfgpack.a */
+uint32_t cfgpack_crc32c(const uint8_t *data, size_t len);
+
+#define BENCH_MAX_ENTRIES 512
+#define BENCH_ROUNDS 5
+#define BENCH_ROUND_MS 20
+#define BENCH_TEXT_CAP (64 * 1024)
+#define BENCH_BLOB_CAP (32 * 1024)
+#define BENCH_POOL_CAP (BENCH_MAX_ENTRIES * (CFGPACK_STR_MAX + 1))
+#define BENCH_REMAP_SHIFT 1000 /* old index = new index + shift */
+#define BENCH_EARLY_ENTRIES 8  /* entries of the pagein_filtered subset */
+
+static const size_t bench_sizes[] = {8, 32, 128, 512};
+
+/* ── fixture ────────────────────────────────────────────────────────────── */
+
+/** Schema buffers and the context initialized on them. */
+typedef struct {
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[BENCH_MAX_ENTRIES];
+    cfgpack_value_t values[BENCH_MAX_ENTRIES];
+    char str_pool[BENCH_POOL_CAP];
+    cfgpack_str_off_t str_offsets[BENCH_MAX_ENTRIES];
+    cfgpack_parse_error_t err;
+    cfgpack_parse_opts_t opts;
+    cfgpack_ctx_t ctx;
+#ifdef CFGPACK_LARGE_SCHEMA
+    uint8_t bits[CFGPACK_BITMAP_BYTES(BENCH_MAX_ENTRIES)];
+#endif
+} bench_schema_t;
+
+/** Inputs for one schema size. */
+typedef struct {
+    size_t n;
+    char map[BENCH_TEXT_CAP];
+    size_t map_len;
+    char json[BENCH_TEXT_CAP];
+    size_t json_len;
+    uint8_t mp[BENCH_TEXT_CAP];
+    size_t mp_len;
+    uint8_t blob[BENCH_BLOB_CAP];
+    size_t blob_len;
+    uint8_t old_blob[BENCH_BLOB_CAP];
+    size_t old_blob_len;
+    cfgpack_remap_entry_t remap[BENCH_MAX_ENTRIES];
+    uint8_t early[(BENCH_MAX_ENTRIES + CHAR_BIT - 1) / CHAR_BIT];
+    uint8_t lz4[BENCH_BLOB_CAP];
+    size_t lz4_len;
+    uint8_t hs[BENCH_BLOB_CAP];
+    size_t hs_len;
+} bench_input_t;
+
+static bench_schema_t sch;     /* parse target and runtime context */
+static bench_schema_t old_sch; /* schema before the index migration */
+static bench_input_t in;
+static uint8_t out_buf[BENCH_BLOB_CAP];
+static char json_out[BENCH_TEXT_CAP];
+static uint8_t scratch[BENCH_BLOB_CAP];
+static LZ4_stream_t lz4_state;
+static heatshrink_encoder hse;
+static volatile uint32_t sink; /* keeps CRC results observable */
+
+static const char *const type_names[] = {"u8",  "u16", "u32", "u64",
+                                         "i8",  "i16", "i32", "i64",
+                                         "f32", "f64", "str", "fstr"};
+
+static void die(const char *what, cfgpack_err_t rc) {
+    fprintf(stderr, "bench: %s failed (%d)\n", what, (int)rc);
+    exit(1);
+}
+
+static void schema_opts(bench_schema_t *s) {
+    cfgpack_parse_opts_t opts = {&s->schema,     s->entries, BENCH_MAX_ENTRIES,
+                                 s->values,      s->str_pool,
+                                 sizeof(s->str_pool),
+                                 s->str_offsets, BENCH_MAX_ENTRIES,
+                                 &s->err};
+    s->opts = opts;
+}
+
+static cfgpack_err_t schema_init(bench_schema_t *s) {
+    size_t n_str = 0;
+
+    for (size_t i = 0; i < s->schema.entry_count; ++i) {
+        if (s->entries[i].type == CFGPACK_TYPE_STR ||
+            s->entries[i].type == CFGPACK_TYPE_FSTR) {
+            n_str++;
+        }
+    }
+#ifdef CFGPACK_LARGE_SCHEMA
+    if (cfgpack_ctx_bitmaps(&s->ctx, s->bits, sizeof(s->bits)) !=
+        CFGPACK_OK) {
+        return (CFGPACK_ERR_ARGS);
+    }
+#endif
+    return (cfgpack_init(&s->ctx, &s->schema, s->values,
+                         s->schema.entry_count, s->str_pool,
+                         sizeof(s->str_pool), s->str_offsets, n_str));
+}
+
+/**
+ * @brief Write an @p n entry .map schema; entry i has index i + 1 + shift.
+ *
+ * Types cycle through all twelve, so every size has a proportional mix of
+ * integers, floats and both string kinds.  Every entry has a default.
+ */
+static size_t gen_map(char *out, size_t cap, size_t n, unsigned shift) {
+    size_t len = (size_t)snprintf(out, cap, "bench 1\n");
+
+    for (size_t i = 0; i < n && len < cap; ++i) {
+        unsigned idx = (unsigned)i + 1u + shift;
+        const char *type = type_names[i % 12];
+        char def[32];
+
+        switch (i % 12) {
+        case 4: case 5: case 6: case 7:
+            snprintf(def, sizeof(def), "-%u", (unsigned)(i * 7 % 100));
+            break;
+        case 8: case 9:
+            snprintf(def, sizeof(def), "%u.25", (unsigned)i);
+            break;
+        case 10:
+            snprintf(def, sizeof(def), "\"value %u\"", (unsigned)i);
+            break;
+        case 11:
+            snprintf(def, sizeof(def), "\"f%u\"", (unsigned)i);
+            break;
+        default:
+            snprintf(def, sizeof(def), "%u", (unsigned)(i * 37 % 100));
+            break;
+        }
+        len += (size_t)snprintf(out + len, cap - len, "%u e%u %s %s\n", idx,
+                                (unsigned)i, type, def);
+    }
+    if (len >= cap) {
+        die("gen_map", CFGPACK_ERR_BOUNDS);
+    }
+    return (len);
+}
+
+static void build_input(size_t n) {
+    static char old_map[BENCH_TEXT_CAP];
+    cfgpack_index_range_t early = {1, BENCH_EARLY_ENTRIES};
+    size_t old_len;
+    cfgpack_err_t rc;
+
+    in.n = n;
+    in.map_len = gen_map(in.map, sizeof(in.map), n, 0);
+
+    schema_opts(&sch);
+    rc = cfgpack_parse_schema(in.map, in.map_len, &sch.opts);
+    if (rc != CFGPACK_OK || (rc = schema_init(&sch)) != CFGPACK_OK) {
+        die("parse_map", rc);
+    }
+    rc = cfgpack_schema_write_json(&sch.ctx, in.json, sizeof(in.json),
+                                   &in.json_len, NULL);
+    if (rc != CFGPACK_OK) {
+        die("write_json", rc);
+    }
+    rc = cfgpack_schema_write_msgpack(&sch.ctx, in.mp, sizeof(in.mp),
+                                      &in.mp_len, NULL);
+    if (rc != CFGPACK_OK) {
+        die("write_msgpack", rc);
+    }
+    rc = cfgpack_pageout(&sch.ctx, in.blob, sizeof(in.blob), &in.blob_len);
+    if (rc != CFGPACK_OK) {
+        die("pageout", rc);
+    }
+    rc = cfgpack_pageout_lz4(&sch.ctx, in.lz4, sizeof(in.lz4), &in.lz4_len,
+                             &lz4_state, scratch, sizeof(scratch));
+    if (rc != CFGPACK_OK) {
+        die("pageout_lz4", rc);
+    }
+    rc = cfgpack_pageout_heatshrink(&sch.ctx, in.hs, sizeof(in.hs),
+                                    &in.hs_len, &hse, scratch,
+                                    sizeof(scratch));
+    if (rc != CFGPACK_OK) {
+        die("pageout_heatshrink", rc);
+    }
+
+    /* Same entries saved by a schema that numbered them differently */
+    old_len = gen_map(old_map, sizeof(old_map), n, BENCH_REMAP_SHIFT);
+    schema_opts(&old_sch);
+    rc = cfgpack_parse_schema(old_map, old_len, &old_sch.opts);
+    if (rc != CFGPACK_OK || (rc = schema_init(&old_sch)) != CFGPACK_OK) {
+        die("parse_map (old)", rc);
+    }
+    rc = cfgpack_pageout(&old_sch.ctx, in.old_blob, sizeof(in.old_blob),
+                         &in.old_blob_len);
+    if (rc != CFGPACK_OK) {
+        die("pageout (old)", rc);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        in.remap[i].old_index = (uint16_t)(i + 1 + BENCH_REMAP_SHIFT);
+        in.remap[i].new_index = (uint16_t)(i + 1);
+    }
+
+    /* Early-boot subset for pagein_filtered */
+    rc = cfgpack_select_ranges(&sch.ctx, &early, 1, in.early,
+                               sizeof(in.early));
+    if (rc != CFGPACK_OK) {
+        die("select_ranges", rc);
+    }
+}
+
+/* ── ops ────────────────────────────────────────────────────────────────── */
+
+static cfgpack_err_t op_parse_map(void) {
+    return (cfgpack_parse_schema(in.map, in.map_len, &sch.opts));
+}
+
+static cfgpack_err_t op_parse_json(void) {
+    return (cfgpack_schema_parse_json(in.json, in.json_len, &sch.opts));
+}
+
+static cfgpack_err_t op_parse_msgpack(void) {
+    return (cfgpack_schema_parse_msgpack(in.mp, in.mp_len, &sch.opts));
+}
+
+static cfgpack_err_t op_measure_map(void) {
+    cfgpack_schema_measure_t m;
+    return (cfgpack_schema_measure(in.map, in.map_len, &m, NULL));
+}
+
+static cfgpack_err_t op_measure_json(void) {
+    cfgpack_schema_measure_t m;
+    return (cfgpack_schema_measure_json(in.json, in.json_len, &m, NULL));
+}
+
+static cfgpack_err_t op_measure_msgpack(void) {
+    cfgpack_schema_measure_t m;
+    return (cfgpack_schema_measure_msgpack(in.mp, in.mp_len, &m, NULL));
+}
+
+static cfgpack_err_t op_write_json(void) {
+    size_t len;
+    return (cfgpack_schema_write_json(&sch.ctx, json_out, sizeof(json_out),
+                                      &len, NULL));
+}
+
+static cfgpack_err_t op_pageout(void) {
+    size_t len;
+    return (cfgpack_pageout(&sch.ctx, out_buf, sizeof(out_buf), &len));
+}
+
+#ifdef CFGPACK_SIZE_CACHE
+/* Same pageout once the size cache proves the blob fits: unchecked
+ * encoder.  The cache stays valid across the later pagein ops. */
+static cfgpack_err_t op_pageout_cached(void) {
+    size_t len;
+
+    if (!sch.ctx.size_cached) {
+        cfgpack_err_t rc = cfgpack_size_cache_init(&sch.ctx);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+    }
+    return (cfgpack_pageout(&sch.ctx, out_buf, sizeof(out_buf), &len));
+}
+#endif
+
+static cfgpack_err_t op_pagein(void) {
+    return (cfgpack_pagein_buf(&sch.ctx, in.blob, in.blob_len));
+}
+
+static cfgpack_err_t op_pagein_remap(void) {
+    return (cfgpack_pagein_remap(&sch.ctx, in.old_blob, in.old_blob_len,
+                                 in.remap, in.n));
+}
+
+static cfgpack_err_t op_pagein_filtered(void) {
+    return (cfgpack_pagein_filtered(&sch.ctx, in.blob, in.blob_len,
+                                    in.early));
+}
+
+static cfgpack_err_t op_crc32c(void) {
+    sink ^= cfgpack_crc32c(in.blob, in.blob_len);
+    return (CFGPACK_OK);
+}
+
+static cfgpack_err_t op_pagein_lz4(void) {
+    return (cfgpack_pagein_lz4(&sch.ctx, in.lz4 + CFGPACK_LZ4_HDR_SIZE,
+                               in.lz4_len - CFGPACK_LZ4_HDR_SIZE, in.blob_len,
+                               scratch, sizeof(scratch)));
+}
+
+static cfgpack_err_t op_pagein_heatshrink(void) {
+    return (cfgpack_pagein_heatshrink(&sch.ctx, in.hs, in.hs_len, scratch,
+                                      sizeof(scratch)));
+}
+
+typedef struct {
+    const char *name;
+    cfgpack_err_t (*fn)(void);
+    const size_t *bytes; /* per-op size, from the current input */
+} bench_op_t;
+
+static const bench_op_t ops[] = {
+    {"parse_map", op_parse_map, &in.map_len},
+    {"parse_json", op_parse_json, &in.json_len},
+    {"parse_msgpack", op_parse_msgpack, &in.mp_len},
+    {"measure_map", op_measure_map, &in.map_len},
+    {"measure_json", op_measure_json, &in.json_len},
+    {"measure_msgpack", op_measure_msgpack, &in.mp_len},
+    {"write_json", op_write_json, &in.json_len},
+    {"pageout", op_pageout, &in.blob_len},
+#ifdef CFGPACK_SIZE_CACHE
+    {"pageout_cached", op_pageout_cached, &in.blob_len},
+#endif
+    {"pagein", op_pagein, &in.blob_len},
+    {"pagein_remap", op_pagein_remap, &in.old_blob_len},
+    {"pagein_filtered", op_pagein_filtered, &in.blob_len},
+    {"crc32c", op_crc32c, &in.blob_len},
+    {"pagein_lz4", op_pagein_lz4, &in.lz4_len},
+    {"pagein_heatshrink", op_pagein_heatshrink, &in.hs_len},
+};
+
+/* ── timing ─────────────────────────────────────────────────────────────── */
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1e9 + (double)ts.tv_nsec);
+}
+
+static double run_batch(const bench_op_t *op, size_t iters) {
+    double t0 = now_ns();
+
+    for (size_t i = 0; i < iters; ++i) {
+        cfgpack_err_t rc = op->fn();
+        if (rc != CFGPACK_OK) {
+            die(op->name, rc);
+        }
+    }
+    return (now_ns() - t0);
+}
+
+/** Best ns/op over BENCH_ROUNDS batches of at least @p round_ns each. */
+static double time_op(const bench_op_t *op, double round_ns, size_t *iters) {
+    size_t n = 1;
+    double best;
+
+    while (run_batch(op, n) < round_ns && n < ((size_t)1 << 30)) {
+        n *= 2;
+    }
+    best = run_batch(op, n) / (double)n;
+    for (int r = 1; r < BENCH_ROUNDS; ++r) {
+        double t = run_batch(op, n) / (double)n;
+        if (t < best) {
+            best = t;
+        }
+    }
+    *iters = n;
+    return (best);
+}
+
+static const char *crc_backend(void) {
+#if defined(CFGPACK_CRC_DISPATCH)
+    return ("dispatch");
+#elif CFGPACK_CRC_BACKEND == CFGPACK_CRC_HW
+    return ("hw");
+#elif CFGPACK_CRC_BACKEND == CFGPACK_CRC_SLICE8
+    return ("slice8");
+#else
+    return ("nibble");
+#endif
+}
+
+/* ── main ───────────────────────────────────────────────────────────────── */
+
+int main(int argc, char **argv) {
+    unsigned round_ms = BENCH_ROUND_MS;
+    const char *sep = "";
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--ms") == 0 && i + 1 < argc) {
+            round_ms = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--ms <round-ms>]\n", argv[0]);
+            return (1);
+        }
+    }
+
+    printf("{\n");
+    printf("  \"format\": 1,\n");
+#ifdef __VERSION__
+    printf("  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    printf("  \"max_entries\": %u,\n", (unsigned)CFGPACK_MAX_ENTRIES);
+    printf("  \"crc_backend\": \"%s\",\n", crc_backend());
+    printf("  \"rounds\": %d,\n", BENCH_ROUNDS);
+    printf("  \"round_ms\": %u,\n", round_ms);
+    printf("  \"results\": [");
+
+    for (size_t s = 0; s < sizeof(bench_sizes) / sizeof(bench_sizes[0]);
+         ++s) {
+        size_t n = bench_sizes[s];
+
+        if (n > CFGPACK_MAX_ENTRIES) {
+            fprintf(stderr, "bench: skipping %zu entries (max %u)\n", n,
+                    (unsigned)CFGPACK_MAX_ENTRIES);
+            continue;
+        }
+        build_input(n);
+        for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); ++o) {
+            size_t iters;
+            double ns = time_op(&ops[o], round_ms * 1e6, &iters);
+            size_t bytes = *ops[o].bytes;
+
+            printf("%s\n    {\"op\": \"%s\", \"entries\": %zu, "
+                   "\"bytes\": %zu, \"iters\": %zu, \"ns_per_op\": %.1f, "
+                   "\"bytes_per_s\": %.0f}",
+                   sep, ops[o].name, n, bytes, iters, ns,
+                   ns > 0 ? (double)bytes * 1e9 / ns : 0.0);
+            sep = ",";
+            fflush(stdout);
+        }
+    }
+    printf("\n  ]\n}\n");
+    return (0);
+}
@@ -0,0 +1,780 @@
+/**
+ * @file wcet.c
+ * @brief Worst-case execution time measurement on adversarial inputs.
+ *
+ * Standalone hosted program, the timing counterpart of stack-usage-Os.
+ * It builds inputs that drive each API down its slowest path and counts
+ * cycles for:
+ *
+ *   pagein_remap    cfgpack_pagein_remap() with keys that force a remap
+ *                   rescan, an unsorted remap table, and unknown keys
+ *                   whose values nest to CFGPACK_SKIP_MAX_DEPTH
+ *   skip_value      cfgpack_msgpack_skip_value() over one-byte tokens and
+ *                   chains at the nesting limit, accepted and rejected
+ *   parse_{map,json,msgpack}
+ *                   schema parse of CFGPACK_MAX_ENTRIES entries, in
+ *                   reverse order or with maximal string defaults
+ *   crc32c          CRC-32C over 1 KB and 64 KB
+ *
+ * Each input first runs WCET_WARMUP times untimed, so first-touch page
+ * faults and cold caches of the generated buffers are not charged to it,
+ * then WCET_REPS timed times.  `cycles` is the fastest run and
+ * `max_cycles` the slowest; `cycles_per_kb` and `max_cycles_per_kb`
+ * scale them to 1024 input bytes.
+ *
+ * The budget file bounds `max_cycles_per_kb`, the worst observed run.
+ * Each line holds a reference figure, and the limit is that figure plus
+ * the file's `headroom` percentage (WCET_HEADROOM_PCT if the file has
+ * none).  An input over its limit is measured again, up to WCET_ATTEMPTS
+ * in all, and fails only if every attempt is over: one preemption or
+ * interrupt lands in a single attempt, a slower path in all of them.
+ * The attempt with the lowest maximum is reported.  Runs during which
+ * getrusage() sees a context switch are repeated rather than counted
+ * (`preempted` in the results), so the maximum holds the input's own
+ * path plus only the interrupts the kernel handled in place.
+ *
+ * Files in fuzz corpus directories can be added with --corpus, their
+ * results are reported per corpus (worst file) and not budgeted.
+ *
+ * The counter is the TSC on x86, CNTVCT on AArch64 and nanoseconds
+ * elsewhere; budgets are in TSC cycles and only checked on x86.
+ *
+ * Build: make wcet           (writes build/wcet.json, checks the budget)
+ * Run:   build/out/wcet [--budget <file>] [--corpus <op>=<dir>]...
+ */
+
+#ifndef _POSIX_C_SOURCE
+  #define _POSIX_C_SOURCE 200809L /* clock_gettime, opendir under -std=c99 */
+#endif
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/msgpack.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+/* CRC-32C: linked from libcfgpack.a */
+uint32_t cfgpack_crc32c(const uint8_t *data, size_t len);
+
+#define WCET_WARMUP       10
+#define WCET_REPS         200
+#define WCET_ATTEMPTS     3
+#define WCET_HEADROOM_PCT 100 /* limit = reference * (100 + pct) / 100 */
+#define WCET_BUF_CAP      (64 * 1024)
+#define WCET_POOL_CAP     (CFGPACK_MAX_ENTRIES * (CFGPACK_STR_MAX + 1))
+#define WCET_REMAP_SHIFT  1000 /* old index = new index + shift */
+#define WCET_UNKNOWN_KEYS 64
+#define WCET_MAX_BUDGETS  64
+#define WCET_MAX_CORPORA  8
+#define WCET_CRC_SIZE     4 /* blob trailer: CRC-32C, little-endian */
+
+/* ── counter ────────────────────────────────────────────────────────────── */
+
+#if defined(__x86_64__) || defined(__i386__)
+static uint64_t ticks(void) {
+    return (__builtin_ia32_rdtsc());
+}
+  #define WCET_UNIT "tsc"
+#elif defined(__aarch64__)
+static uint64_t ticks(void) {
+    uint64_t v;
+    __asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(v));
+    return (v);
+}
+  #define WCET_UNIT "cntvct"
+#else
+static uint64_t ticks(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+  #define WCET_UNIT "ns"
+#endif
+
+/** Context switches of this process so far, voluntary or not. */
+static long switches(void) {
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_nvcsw + ru.ru_nivcsw);
+}
+
+/* ── fixture ────────────────────────────────────────────────────────────── */
+
+/** Schema buffers and the context initialized on them. */
+typedef struct {
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[CFGPACK_MAX_ENTRIES];
+    cfgpack_value_t values[CFGPACK_MAX_ENTRIES];
+    char str_pool[WCET_POOL_CAP];
+    cfgpack_str_off_t str_offsets[CFGPACK_MAX_ENTRIES];
+    cfgpack_parse_error_t err;
+    cfgpack_parse_opts_t opts;
+    cfgpack_ctx_t ctx;
+} wcet_schema_t;
+
+/** One generated input. */
+typedef struct {
+    uint8_t data[WCET_BUF_CAP];
+    size_t len;
+} wcet_buf_t;
+
+static wcet_schema_t sch;
+static wcet_buf_t text;
+static wcet_buf_t aux;
+static cfgpack_remap_entry_t remap[CFGPACK_MAX_ENTRIES];
+static size_t remap_count;
+static const char *cur_op;
+static const char *cur_input;
+static int budget_failed;
+static int cur_preempted;
+
+static const char *const type_names[] = {"u8",  "u16", "u32", "u64",
+                                         "i8",  "i16", "i32", "i64",
+                                         "f32", "f64", "str", "fstr"};
+
+static void die(const char *what, cfgpack_err_t rc) {
+    fprintf(stderr, "wcet: %s failed (%d)\n", what, (int)rc);
+    exit(1);
+}
+
+static void schema_opts(wcet_schema_t *s) {
+    cfgpack_parse_opts_t opts = {&s->schema,     s->entries,
+                                 CFGPACK_MAX_ENTRIES,
+                                 s->values,      s->str_pool,
+                                 sizeof(s->str_pool),
+                                 s->str_offsets, CFGPACK_MAX_ENTRIES,
+                                 &s->err};
+    s->opts = opts;
+}
+
+static void schema_load(const char *map, size_t len) {
+    size_t n_str = 0;
+    cfgpack_err_t rc;
+
+    schema_opts(&sch);
+    rc = cfgpack_parse_schema(map, len, &sch.opts);
+    if (rc != CFGPACK_OK) {
+        die("parse_map (setup)", rc);
+    }
+    for (size_t i = 0; i < sch.schema.entry_count; ++i) {
+        if (sch.entries[i].type == CFGPACK_TYPE_STR ||
+            sch.entries[i].type == CFGPACK_TYPE_FSTR) {
+            n_str++;
+        }
+    }
+    rc = cfgpack_init(&sch.ctx, &sch.schema, sch.values,
+                      sch.schema.entry_count, sch.str_pool,
+                      sizeof(sch.str_pool), sch.str_offsets, n_str);
+    if (rc != CFGPACK_OK) {
+        die("init (setup)", rc);
+    }
+}
+
+/* ── inputs ─────────────────────────────────────────────────────────────── */
+
+/** Schema text shapes for gen_map(). */
+typedef enum {
+    MAP_MIXED,    /**< Types cycle through all twelve, ascending indices */
+    MAP_REVERSED, /**< As MAP_MIXED, lines in descending index order */
+    MAP_LONG_STR  /**< Every entry a str with a CFGPACK_STR_MAX default */
+} map_shape_t;
+
+/** Write a CFGPACK_MAX_ENTRIES entry .map schema. */
+static size_t gen_map(char *out, size_t cap, map_shape_t shape) {
+    size_t n = CFGPACK_MAX_ENTRIES;
+    size_t len = (size_t)snprintf(out, cap, "wcet 1\n");
+
+    for (size_t k = 0; k < n && len < cap; ++k) {
+        size_t i = shape == MAP_REVERSED ? n - 1 - k : k;
+        const char *type = type_names[i % 12];
+        char def[CFGPACK_STR_MAX + 3];
+
+        if (shape == MAP_LONG_STR) {
+            def[0] = '"';
+            memset(def + 1, 'a' + (int)(i % 26), CFGPACK_STR_MAX);
+            def[CFGPACK_STR_MAX + 1] = '"';
+            def[CFGPACK_STR_MAX + 2] = '\0';
+            type = "str";
+        } else if (i % 12 >= 4 && i % 12 <= 7) {
+            snprintf(def, sizeof(def), "-%u", (unsigned)(i * 7 % 100));
+        } else if (i % 12 == 8 || i % 12 == 9) {
+            snprintf(def, sizeof(def), "%u.125", (unsigned)i);
+        } else if (i % 12 == 10) {
+            snprintf(def, sizeof(def), "\"value %u\"", (unsigned)i);
+        } else if (i % 12 == 11) {
+            snprintf(def, sizeof(def), "\"f%u\"", (unsigned)i);
+        } else {
+            snprintf(def, sizeof(def), "%u", (unsigned)(i * 37 % 100));
+        }
+        len += (size_t)snprintf(out + len, cap - len, "%u e%u %s %s\n",
+                                (unsigned)(i + 1), (unsigned)i, type, def);
+    }
+    if (len >= cap) {
+        die("gen_map", CFGPACK_ERR_BOUNDS);
+    }
+    return (len);
+}
+
+/** Append a chain of @p depth nested one-element arrays around a 0. */
+static void put_chain(cfgpack_buf_t *b, unsigned depth) {
+    for (unsigned d = 0; d < depth; ++d) {
+        (void)cfgpack_msgpack_encode_array_header(b, 1);
+    }
+    (void)cfgpack_msgpack_encode_uint64(b, 0);
+}
+
+/** Skip-value shapes for gen_skip(). */
+typedef enum {
+    SKIP_FIXINT_ARRAY, /**< One array of one-byte ints */
+    SKIP_FIXINT_MAP,   /**< One map of one-byte int pairs */
+    SKIP_MAX_DEPTH,    /**< Array of chains nested to the limit */
+    SKIP_DEPTH_LIMIT   /**< As SKIP_MAX_DEPTH, last chain one too deep */
+} skip_shape_t;
+
+static size_t gen_skip(uint8_t *out, size_t cap, skip_shape_t shape) {
+    /* The outer array is depth 1; a chain may add up to MAX - 2 more */
+    unsigned chain = CFGPACK_SKIP_MAX_DEPTH - 2;
+    uint32_t count = (uint32_t)(cap / 2);
+    cfgpack_buf_t b;
+
+    cfgpack_buf_init(&b, out, cap);
+    switch (shape) {
+    case SKIP_FIXINT_ARRAY:
+        (void)cfgpack_msgpack_encode_array_header(&b, count);
+        for (uint32_t i = 0; i < count; ++i) {
+            (void)cfgpack_msgpack_encode_uint64(&b, i & 0x7f);
+        }
+        break;
+    case SKIP_FIXINT_MAP:
+        (void)cfgpack_msgpack_encode_map_header(&b, count / 2);
+        for (uint32_t i = 0; i < count; ++i) {
+            (void)cfgpack_msgpack_encode_uint64(&b, i & 0x7f);
+        }
+        break;
+    case SKIP_MAX_DEPTH:
+    case SKIP_DEPTH_LIMIT:
+        count /= chain + 1;
+        (void)cfgpack_msgpack_encode_array_header(&b, count);
+        for (uint32_t i = 0; i < count; ++i) {
+            int last = shape == SKIP_DEPTH_LIMIT && i + 1 == count;
+            put_chain(&b, chain + (last ? 1u : 0u));
+        }
+        break;
+    }
+    if (b.len > cap / 2 + 8) {
+        die("gen_skip", CFGPACK_ERR_BOUNDS);
+    }
+    return (b.len);
+}
+
+/** Pagein shapes for gen_blob(). */
+typedef enum {
+    BLOB_ASCENDING,  /**< Saved order with a sorted remap (baseline) */
+    BLOB_DESCENDING, /**< Keys backwards: each one rescans the table */
+    BLOB_UNSORTED,   /**< Unsorted remap table: linear search per key */
+    BLOB_UNKNOWN     /**< Extra unknown keys with values at max depth */
+} blob_shape_t;
+
+/**
+ * @brief Blob saved by the old numbering (index + WCET_REMAP_SHIFT), and
+ *        the remap table back to the schema's indices.
+ */
+static size_t gen_blob(uint8_t *out, size_t cap, blob_shape_t shape) {
+    size_t n = sch.schema.entry_count;
+    uint32_t extra = shape == BLOB_UNKNOWN ? WCET_UNKNOWN_KEYS : 0;
+    cfgpack_buf_t b;
+    uint32_t crc;
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t r = shape == BLOB_UNSORTED ? n - 1 - i : i;
+
+        remap[r].old_index =
+            (uint16_t)(sch.entries[i].index + WCET_REMAP_SHIFT);
+        remap[r].new_index = sch.entries[i].index;
+    }
+    remap_count = n;
+
+    cfgpack_buf_init(&b, out, cap - WCET_CRC_SIZE);
+    (void)cfgpack_msgpack_encode_map_header(&b, (uint32_t)n + extra);
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = shape == BLOB_DESCENDING ? n - 1 - k : k;
+        const cfgpack_entry_t *e = &sch.entries[i];
+
+        (void)cfgpack_msgpack_encode_uint_key(&b,
+                                              e->index + WCET_REMAP_SHIFT);
+        switch (e->type) {
+        case CFGPACK_TYPE_STR:
+        case CFGPACK_TYPE_FSTR:
+            (void)cfgpack_msgpack_encode_str(&b, "x", 1);
+            break;
+        case CFGPACK_TYPE_F32:
+            (void)cfgpack_msgpack_encode_f32(&b, 0.5f);
+            break;
+        case CFGPACK_TYPE_F64:
+            (void)cfgpack_msgpack_encode_f64(&b, 0.5);
+            break;
+        case CFGPACK_TYPE_I8:
+        case CFGPACK_TYPE_I16:
+        case CFGPACK_TYPE_I32:
+        case CFGPACK_TYPE_I64:
+            (void)cfgpack_msgpack_encode_int64(&b, -1);
+            break;
+        default:
+            (void)cfgpack_msgpack_encode_uint64(&b, 1);
+            break;
+        }
+    }
+    for (uint32_t u = 0; u < extra; ++u) {
+        (void)cfgpack_msgpack_encode_uint_key(&b, 60000u + u);
+        (void)cfgpack_msgpack_encode_array_header(&b, 8);
+        for (int c = 0; c < 8; ++c) {
+            put_chain(&b, CFGPACK_SKIP_MAX_DEPTH - 2);
+        }
+    }
+    if (b.len + WCET_CRC_SIZE >= cap) {
+        die("gen_blob", CFGPACK_ERR_BOUNDS);
+    }
+    crc = cfgpack_crc32c(out, b.len);
+    for (int i = 0; i < 4; ++i) {
+        out[b.len + (size_t)i] = (uint8_t)(crc >> (8 * i));
+    }
+    return (b.len + WCET_CRC_SIZE);
+}
+
+/* ── ops ────────────────────────────────────────────────────────────────── */
+
+typedef cfgpack_err_t (*wcet_fn)(const uint8_t *data, size_t len);
+
+static cfgpack_err_t op_pagein_remap(const uint8_t *data, size_t len) {
+    return (cfgpack_pagein_remap(&sch.ctx, data, len, remap, remap_count));
+}
+
+static cfgpack_err_t op_pagein(const uint8_t *data, size_t len) {
+    return (cfgpack_pagein_remap(&sch.ctx, data, len, NULL, 0));
+}
+
+static cfgpack_err_t op_skip_value(const uint8_t *data, size_t len) {
+    cfgpack_reader_t r;
+
+    cfgpack_reader_init(&r, data, len);
+    return (cfgpack_msgpack_skip_value(&r));
+}
+
+static cfgpack_err_t op_parse_map(const uint8_t *data, size_t len) {
+    static wcet_schema_t s;
+
+    schema_opts(&s);
+    return (cfgpack_parse_schema((const char *)data, len, &s.opts));
+}
+
+static cfgpack_err_t op_parse_json(const uint8_t *data, size_t len) {
+    static wcet_schema_t s;
+
+    schema_opts(&s);
+    return (cfgpack_schema_parse_json((const char *)data, len, &s.opts));
+}
+
+static cfgpack_err_t op_parse_msgpack(const uint8_t *data, size_t len) {
+    static wcet_schema_t s;
+
+    schema_opts(&s);
+    return (cfgpack_schema_parse_msgpack(data, len, &s.opts));
+}
+
+static volatile uint32_t sink; /* keeps CRC results observable */
+
+static cfgpack_err_t op_crc32c(const uint8_t *data, size_t len) {
+    sink ^= cfgpack_crc32c(data, len);
+    return (CFGPACK_OK);
+}
+
+/* ── budget ─────────────────────────────────────────────────────────────── */
+
+typedef struct {
+    char op[32];
+    char input[32];
+    unsigned long per_kb;
+} wcet_budget_t;
+
+static wcet_budget_t budgets[WCET_MAX_BUDGETS];
+static size_t budget_count;
+static unsigned long headroom_pct = WCET_HEADROOM_PCT;
+
+/**
+ * @brief Read "<op> <input> <reference max cycles per KB>" lines and an
+ *        optional "headroom <percent>" line; '#' starts a comment.
+ */
+static void load_budget(const char *path) {
+    char line[128];
+    FILE *f = fopen(path, "r");
+
+    if (!f) {
+        fprintf(stderr, "wcet: cannot open %s\n", path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), f) && budget_count < WCET_MAX_BUDGETS) {
+        wcet_budget_t *b = &budgets[budget_count];
+
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (sscanf(line, "headroom %lu", &headroom_pct) == 1) {
+            continue;
+        }
+        if (sscanf(line, "%31s %31s %lu", b->op, b->input, &b->per_kb) == 3) {
+            budget_count++;
+        }
+    }
+    fclose(f);
+}
+
+static const wcet_budget_t *find_budget(const char *op, const char *input) {
+    for (size_t i = 0; i < budget_count; ++i) {
+        if (strcmp(budgets[i].op, op) == 0 &&
+            strcmp(budgets[i].input, input) == 0) {
+            return (&budgets[i]);
+        }
+    }
+    return (NULL);
+}
+
+/** Limit on max_cycles_per_kb: the reference plus the headroom. */
+static uint64_t budget_limit(const wcet_budget_t *b) {
+    return ((uint64_t)b->per_kb * (100u + headroom_pct) / 100u);
+}
+
+/** Nonzero if @p worst cycles over @p bytes break budget @p b. */
+static int over_budget(const wcet_budget_t *b, size_t bytes, uint64_t worst) {
+    if (!b || bytes == 0 || strcmp(WCET_UNIT, "tsc") != 0) {
+        return (0);
+    }
+    return (worst * 1024u / bytes > budget_limit(b));
+}
+
+/* ── measurement ────────────────────────────────────────────────────────── */
+
+static const char *sep = "";
+
+static void report(const char *op,
+                   const char *input,
+                   size_t bytes,
+                   uint64_t best,
+                   uint64_t worst,
+                   int attempts) {
+    const wcet_budget_t *b = budget_count ? find_budget(op, input) : NULL;
+    uint64_t per_kb = bytes ? best * 1024u / bytes : 0;
+    uint64_t max_per_kb = bytes ? worst * 1024u / bytes : 0;
+
+    printf("%s\n    {\"op\": \"%s\", \"input\": \"%s\", \"bytes\": %zu, "
+           "\"cycles\": %llu, \"max_cycles\": %llu, \"cycles_per_kb\": %llu, "
+           "\"max_cycles_per_kb\": %llu, \"attempts\": %d, "
+           "\"preempted\": %d",
+           sep, op, input, bytes, (unsigned long long)best,
+           (unsigned long long)worst, (unsigned long long)per_kb,
+           (unsigned long long)max_per_kb, attempts, cur_preempted);
+    if (b) {
+        printf(", \"budget_per_kb\": %lu, \"limit_per_kb\": %llu",
+               b->per_kb, (unsigned long long)budget_limit(b));
+        if (over_budget(b, bytes, worst)) {
+            fprintf(stderr,
+                    "wcet: %s/%s: max %llu cycles/KB over limit %llu "
+                    "(budget %lu + %lu%%) in %d attempts\n",
+                    op, input, (unsigned long long)max_per_kb,
+                    (unsigned long long)budget_limit(b), b->per_kb,
+                    headroom_pct, attempts);
+            budget_failed = 1;
+        }
+    }
+    printf("}");
+    sep = ",";
+    fflush(stdout);
+}
+
+/**
+ * @brief Fastest and slowest of WCET_REPS runs of @p fn on one input,
+ *        after WCET_WARMUP untimed runs.
+ *
+ * A run during which the process was switched out is repeated instead
+ * of counted, at most WCET_REPS times per call, and added to
+ * cur_preempted.
+ */
+static void time_input(wcet_fn fn,
+                       const uint8_t *data,
+                       size_t len,
+                       cfgpack_err_t expect,
+                       int check,
+                       uint64_t *best,
+                       uint64_t *worst) {
+    int retried = 0;
+
+    *best = UINT64_MAX;
+    *worst = 0;
+    for (int i = 0; i < WCET_WARMUP; ++i) {
+        (void)fn(data, len);
+    }
+    for (int i = 0; i < WCET_REPS;) {
+        long sw = switches();
+        uint64_t t0 = ticks();
+        cfgpack_err_t rc = fn(data, len);
+        uint64_t t = ticks() - t0;
+
+        if (check && rc != expect) {
+            fprintf(stderr, "wcet: %s/%s returned %d, expected %d\n", cur_op,
+                    cur_input, (int)rc, (int)expect);
+            exit(1);
+        }
+        if (switches() != sw && retried < WCET_REPS) {
+            retried++; /* descheduled: the run timed another task too */
+            cur_preempted++;
+            continue;
+        }
+        i++;
+        if (t < *best) {
+            *best = t;
+        }
+        if (t > *worst) {
+            *worst = t;
+        }
+    }
+}
+
+static void measure(const char *op,
+                    const char *input,
+                    wcet_fn fn,
+                    const uint8_t *data,
+                    size_t len,
+                    cfgpack_err_t expect) {
+    const wcet_budget_t *b = budget_count ? find_budget(op, input) : NULL;
+    uint64_t best;
+    uint64_t worst;
+    int attempts = 1;
+
+    cur_op = op;
+    cur_input = input;
+    cur_preempted = 0;
+    time_input(fn, data, len, expect, 1, &best, &worst);
+    while (attempts < WCET_ATTEMPTS && over_budget(b, len, worst)) {
+        uint64_t again_best;
+        uint64_t again_worst;
+
+        time_input(fn, data, len, expect, 1, &again_best, &again_worst);
+        attempts++;
+        if (again_worst < worst) {
+            best = again_best;
+            worst = again_worst;
+        }
+    }
+    report(op, input, len, best, worst, attempts);
+}
+
+/* ── corpora ────────────────────────────────────────────────────────────── */
+
+typedef struct {
+    const char *name;
+    wcet_fn fn;
+} wcet_corpus_op_t;
+
+static const wcet_corpus_op_t corpus_ops[] = {
+    {"parse_map", op_parse_map},     {"parse_json", op_parse_json},
+    {"parse_msgpack", op_parse_msgpack}, {"pagein", op_pagein},
+    {"skip_value", op_skip_value},
+};
+
+/**
+ * @brief Run every file of @p dir through @p op; report the file with
+ *        the highest cycles per KB (files under 64 bytes are timed but
+ *        dominated by call overhead, so they only count in max_cycles).
+ */
+static void measure_corpus(const wcet_corpus_op_t *op, const char *dir) {
+    static uint8_t file[WCET_BUF_CAP];
+    char path[512];
+    uint64_t worst_per_kb = 0;
+    uint64_t worst_best = 0;
+    uint64_t worst_max = 0;
+    size_t worst_len = 0;
+    struct dirent *de;
+    DIR *d = opendir(dir);
+
+    if (!d) {
+        fprintf(stderr, "wcet: skipping missing corpus %s\n", dir);
+        return;
+    }
+    cur_op = op->name;
+    cur_input = dir;
+    cur_preempted = 0;
+    while ((de = readdir(d)) != NULL) {
+        uint64_t best;
+        uint64_t worst;
+        size_t len;
+        FILE *f;
+
+        if (de->d_name[0] == '.') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+        f = fopen(path, "rb");
+        if (!f) {
+            continue;
+        }
+        len = fread(file, 1, sizeof(file), f);
+        fclose(f);
+        time_input(op->fn, file, len, CFGPACK_OK, 0, &best, &worst);
+        if (worst > worst_max) {
+            worst_max = worst;
+        }
+        if (len >= 64 && best * 1024u / len > worst_per_kb) {
+            worst_per_kb = best * 1024u / len;
+            worst_best = best;
+            worst_len = len;
+        }
+    }
+    closedir(d);
+    report(op->name, dir, worst_len, worst_best, worst_max, 1);
+}
+
+/* ── main ───────────────────────────────────────────────────────────────── */
+
+int main(int argc, char **argv) {
+    static char map_text[WCET_BUF_CAP];
+    const char *corpora[WCET_MAX_CORPORA];
+    size_t corpus_count = 0;
+    size_t map_len;
+    cfgpack_err_t rc;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            load_budget(argv[++i]);
+        } else if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc &&
+                   corpus_count < WCET_MAX_CORPORA) {
+            corpora[corpus_count++] = argv[++i];
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--budget <file>] [--corpus <op>=<dir>]...\n",
+                    argv[0]);
+            return (1);
+        }
+    }
+
+    printf("{\n");
+    printf("  \"format\": 2,\n");
+#ifdef __VERSION__
+    printf("  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    printf("  \"unit\": \"%s\",\n", WCET_UNIT);
+    printf("  \"max_entries\": %u,\n", (unsigned)CFGPACK_MAX_ENTRIES);
+    printf("  \"skip_max_depth\": %u,\n", (unsigned)CFGPACK_SKIP_MAX_DEPTH);
+    printf("  \"warmup\": %d,\n", WCET_WARMUP);
+    printf("  \"reps\": %d,\n", WCET_REPS);
+    printf("  \"attempts\": %d,\n", WCET_ATTEMPTS);
+    printf("  \"headroom_pct\": %lu,\n", headroom_pct);
+    printf("  \"results\": [");
+
+    /* pagein_remap against the mixed schema */
+    map_len = gen_map(map_text, sizeof(map_text), MAP_MIXED);
+    schema_load(map_text, map_len);
+    {
+        static const struct {
+            const char *name;
+            blob_shape_t shape;
+        } blobs[] = {{"ascending", BLOB_ASCENDING},
+                     {"descending", BLOB_DESCENDING},
+                     {"unsorted_remap", BLOB_UNSORTED},
+                     {"unknown_nested", BLOB_UNKNOWN}};
+
+        for (size_t i = 0; i < sizeof(blobs) / sizeof(blobs[0]); ++i) {
+            aux.len = gen_blob(aux.data, sizeof(aux.data), blobs[i].shape);
+            measure("pagein_remap", blobs[i].name, op_pagein_remap,
+                    aux.data, aux.len, CFGPACK_OK);
+        }
+    }
+
+    /* skip_value */
+    {
+        static const struct {
+            const char *name;
+            skip_shape_t shape;
+            cfgpack_err_t expect;
+        } skips[] = {{"fixint_array", SKIP_FIXINT_ARRAY, CFGPACK_OK},
+                     {"fixint_map", SKIP_FIXINT_MAP, CFGPACK_OK},
+                     {"max_depth", SKIP_MAX_DEPTH, CFGPACK_OK},
+                     {"depth_limit", SKIP_DEPTH_LIMIT, CFGPACK_ERR_DECODE}};
+
+        for (size_t i = 0; i < sizeof(skips) / sizeof(skips[0]); ++i) {
+            aux.len = gen_skip(aux.data, 16 * 1024, skips[i].shape);
+            measure("skip_value", skips[i].name, op_skip_value, aux.data,
+                    aux.len, skips[i].expect);
+        }
+    }
+
+    /* Schema parsers: .map text, and the JSON/msgpack derived from it */
+    {
+        static const struct {
+            const char *name;
+            map_shape_t shape;
+        } maps[] = {{"mixed", MAP_MIXED},
+                    {"reversed", MAP_REVERSED},
+                    {"long_str", MAP_LONG_STR}};
+
+        for (size_t i = 0; i < sizeof(maps) / sizeof(maps[0]); ++i) {
+            map_len = gen_map(map_text, sizeof(map_text), maps[i].shape);
+            measure("parse_map", maps[i].name, op_parse_map,
+                    (const uint8_t *)map_text, map_len, CFGPACK_OK);
+            if (maps[i].shape == MAP_REVERSED) {
+                continue; /* the writers emit index order */
+            }
+            schema_load(map_text, map_len);
+            rc = cfgpack_schema_write_json(&sch.ctx, (char *)text.data,
+                                           sizeof(text.data), &text.len,
+                                           NULL);
+            if (rc != CFGPACK_OK) {
+                die("write_json", rc);
+            }
+            measure("parse_json", maps[i].name, op_parse_json, text.data,
+                    text.len, CFGPACK_OK);
+            rc = cfgpack_schema_write_msgpack(&sch.ctx, text.data,
+                                              sizeof(text.data), &text.len,
+                                              NULL);
+            if (rc != CFGPACK_OK) {
+                die("write_msgpack", rc);
+            }
+            measure("parse_msgpack", maps[i].name, op_parse_msgpack,
+                    text.data, text.len, CFGPACK_OK);
+        }
+    }
+
+    /* CRC-32C: linear, so two sizes are enough to see the fixed cost */
+    memset(aux.data, 0xA5, sizeof(aux.data));
+    measure("crc32c", "1k", op_crc32c, aux.data, 1024, CFGPACK_OK);
+    measure("crc32c", "64k", op_crc32c, aux.data, sizeof(aux.data),
+            CFGPACK_OK);
+
+    /* Fuzz corpora, "<op>=<dir>": pagein uses the mixed schema */
+    map_len = gen_map(map_text, sizeof(map_text), MAP_MIXED);
+    schema_load(map_text, map_len);
+    for (size_t c = 0; c < corpus_count; ++c) {
+        const char *eq = strchr(corpora[c], '=');
+        size_t k;
+
+        for (k = 0; eq && k < sizeof(corpus_ops) / sizeof(corpus_ops[0]);
+             ++k) {
+            if (strlen(corpus_ops[k].name) == (size_t)(eq - corpora[c]) &&
+                strncmp(corpus_ops[k].name, corpora[c],
+                        (size_t)(eq - corpora[c])) == 0) {
+                measure_corpus(&corpus_ops[k], eq + 1);
+                break;
+            }
+        }
+        if (!eq || k == sizeof(corpus_ops) / sizeof(corpus_ops[0])) {
+            fprintf(stderr, "wcet: bad --corpus %s\n", corpora[c]);
+            return (1);
+        }
+    }
+
+    printf("\n  ]\n}\n");
+    return (budget_failed);
+}
@@ -0,0 +1,236 @@
+/* Blob diff and patch tests: a patch carries only changed, added and
+ * removed indices, and applying it to a context holding the base leaves
+ * the context paging out as the target, byte for byte. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 24
+
+/* u32 x 23 (index 1..23) + str (index 24), all present. */
+static cfgpack_err_t make_fixture(fixture_t *f, const char *name) {
+    cfgpack_err_t rc;
+
+    fixture_schema(f, name, N_ENTRIES, NULL);
+    f->entries[N_ENTRIES - 1].type = CFGPACK_TYPE_STR;
+    rc = fixture_init(f);
+    if (rc == CFGPACK_OK) {
+        fixture_fill(f, 0, 100000);
+        rc = cfgpack_set_str(&f->ctx, N_ENTRIES, "fleet-a");
+    }
+    return (rc);
+}
+
+static uint32_t get_u32(const cfgpack_ctx_t *ctx, uint16_t index) {
+    uint32_t v = 0;
+    cfgpack_get_u32(ctx, index, &v);
+    return (v);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Patch with a change, an addition and a removal reproduces the target
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_diff_roundtrip) {
+    static fixture_t host;
+    static fixture_t dev;
+    uint8_t base[256];
+    uint8_t target[256];
+    uint8_t patch[64];
+    uint8_t out[256];
+    size_t base_len = 0;
+    size_t target_len = 0;
+    size_t patch_len = 0;
+    size_t out_len = 0;
+    const char *s = NULL;
+    uint16_t s_len = 0;
+
+    /* Base: entry 5 absent */
+    CHECK(make_fixture(&host, "ota") == CFGPACK_OK);
+    cfgpack_presence_clear(&host.ctx, 4);
+    CHECK(cfgpack_pageout(&host.ctx, base, sizeof(base), &base_len) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Target changes 3 and 24, adds 5, removes 9");
+    CHECK(cfgpack_set_u32(&host.ctx, 3, 7) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&host.ctx, 5, 5555) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&host.ctx, 24, "fleet-b") == CFGPACK_OK);
+    cfgpack_presence_clear(&host.ctx, 8);
+    CHECK(cfgpack_pageout(&host.ctx, target, sizeof(target), &target_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_blob_diff(base, base_len, target, target_len, patch,
+                            sizeof(patch), &patch_len) == CFGPACK_OK);
+    LOG("Base %zu bytes, target %zu bytes, patch %zu bytes", base_len,
+        target_len, patch_len);
+    CHECK(patch_len * 2 < target_len);
+    CHECK(cfgpack_blob_verify(patch, patch_len) == CFGPACK_OK);
+
+    LOG_SECTION("Device holding the base applies it");
+    CHECK(make_fixture(&dev, "ota") == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&dev.ctx, base, base_len) == CFGPACK_OK);
+#ifdef CFGPACK_SIZE_CACHE
+    CHECK(cfgpack_size_cache_init(&dev.ctx) == CFGPACK_OK);
+#endif
+    CHECK(cfgpack_patch_apply(&dev.ctx, patch, patch_len) == CFGPACK_OK);
+    CHECK(get_u32(&dev.ctx, 3) == 7);
+    CHECK(get_u32(&dev.ctx, 5) == 5555);
+    CHECK(get_u32(&dev.ctx, 4) == 400000u);
+    CHECK(!cfgpack_presence_get(&dev.ctx, 8));
+    CHECK(cfgpack_get_str(&dev.ctx, 24, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 7 && memcmp(s, "fleet-b", 7) == 0);
+
+    LOG_SECTION("Set entries are dirty until saved");
+    CHECK(cfgpack_get_dirty_count(&dev.ctx) == 3);
+    CHECK(cfgpack_dirty_get(&dev.ctx, 2));
+    CHECK(!cfgpack_dirty_get(&dev.ctx, 3));
+
+    LOG_SECTION("Patched context pages out as the target");
+    CHECK(cfgpack_pageout_measure(&dev.ctx, &out_len) == CFGPACK_OK);
+    CHECK(out_len == target_len);
+    CHECK(cfgpack_pageout(&dev.ctx, out, sizeof(out), &out_len) ==
+          CFGPACK_OK);
+    CHECK(out_len == target_len && memcmp(out, target, target_len) == 0);
+
+    LOG_SECTION("Applying it twice fails: the base is gone");
+    CHECK(cfgpack_patch_apply(&dev.ctx, patch, patch_len) ==
+          CFGPACK_ERR_CRC);
+    CHECK(get_u32(&dev.ctx, 3) == 7);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. A device that does not hold the base is left alone
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_apply_rejects) {
+    static fixture_t host;
+    static fixture_t dev;
+    uint8_t base[256];
+    uint8_t target[256];
+    uint8_t patch[64];
+    size_t base_len = 0;
+    size_t target_len = 0;
+    size_t patch_len = 0;
+
+    CHECK(make_fixture(&host, "ota") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&host.ctx, base, sizeof(base), &base_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&host.ctx, 10, 1) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&host.ctx, target, sizeof(target), &target_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_blob_diff(base, base_len, target, target_len, patch,
+                            sizeof(patch), &patch_len) == CFGPACK_OK);
+
+    LOG_SECTION("Local change since the base: base CRC mismatch");
+    CHECK(make_fixture(&dev, "ota") == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&dev.ctx, 2, 2) == CFGPACK_OK);
+    CHECK(cfgpack_patch_apply(&dev.ctx, patch, patch_len) ==
+          CFGPACK_ERR_CRC);
+    CHECK(get_u32(&dev.ctx, 10) == 1000000u);
+
+    LOG_SECTION("Other schema name: base CRC mismatch");
+    CHECK(make_fixture(&dev, "ota2") == CFGPACK_OK);
+    CHECK(cfgpack_patch_apply(&dev.ctx, patch, patch_len) ==
+          CFGPACK_ERR_CRC);
+    CHECK(get_u32(&dev.ctx, 10) == 1000000u);
+
+    LOG_SECTION("Corrupt patch fails its own trailer");
+    CHECK(make_fixture(&dev, "ota") == CFGPACK_OK);
+    patch[patch_len - 6] ^= 0x01;
+    CHECK(cfgpack_patch_apply(&dev.ctx, patch, patch_len) ==
+          CFGPACK_ERR_CRC);
+    patch[patch_len - 6] ^= 0x01;
+
+    LOG_SECTION("A plain blob is not a patch");
+    CHECK(cfgpack_patch_apply(&dev.ctx, target, target_len) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(get_u32(&dev.ctx, 10) == 1000000u);
+
+    LOG_SECTION("Intact patch still applies");
+    CHECK(cfgpack_patch_apply(&dev.ctx, patch, patch_len) == CFGPACK_OK);
+    CHECK(get_u32(&dev.ctx, 10) == 1);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Diff argument checks and edge cases
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_diff_edges) {
+    static fixture_t host;
+    static fixture_t other;
+    uint8_t base[256];
+    uint8_t indexed[512];
+    uint8_t named[256];
+    uint8_t patch[64];
+    size_t base_len = 0;
+    size_t indexed_len = 0;
+    size_t named_len = 0;
+    size_t patch_len = 0;
+    size_t need = 0;
+
+    CHECK(make_fixture(&host, "ota") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&host.ctx, base, sizeof(base), &base_len) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Identical blobs: header only, applies as a no-op");
+    CHECK(cfgpack_blob_diff(base, base_len, base, base_len, patch,
+                            sizeof(patch), &patch_len) == CFGPACK_OK);
+    LOG("Empty patch %zu bytes", patch_len);
+    CHECK(cfgpack_patch_apply(&host.ctx, patch, patch_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_dirty_count(&host.ctx) == 0);
+
+    LOG_SECTION("Footer of an indexed blob is ignored");
+    CHECK(cfgpack_pageout_indexed(&host.ctx, indexed, sizeof(indexed),
+                                  &indexed_len) == CFGPACK_OK);
+    CHECK(cfgpack_blob_diff(base, base_len, indexed, indexed_len, patch,
+                            sizeof(patch), &need) == CFGPACK_OK);
+    CHECK(need == patch_len);
+
+    LOG_SECTION("Too small output reports the needed size");
+    CHECK(cfgpack_blob_diff(base, base_len, base, base_len, patch, 4,
+                            &need) == CFGPACK_ERR_ENCODE);
+    CHECK(need == patch_len);
+
+    LOG_SECTION("Bad arguments and blobs");
+    CHECK(make_fixture(&other, "other") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&other.ctx, named, sizeof(named), &named_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_blob_diff(base, base_len, named, named_len, patch,
+                            sizeof(patch), &need) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_blob_diff(NULL, 0, base, base_len, patch, sizeof(patch),
+                            &need) == CFGPACK_ERR_ARGS);
+    base[base_len - 1] ^= 0x80;
+    CHECK(cfgpack_blob_diff(base, base_len, named, named_len, patch,
+                            sizeof(patch), &need) == CFGPACK_ERR_CRC);
+    CHECK(cfgpack_patch_apply(NULL, patch, patch_len) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_patch_apply(&host.ctx, patch, 2) == CFGPACK_ERR_DECODE);
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("diff_roundtrip", test_diff_roundtrip()) !=
+                TEST_OK);
+    overall |= (test_case_result("apply_rejects", test_apply_rejects()) !=
+                TEST_OK);
+    overall |= (test_case_result("diff_edges", test_diff_edges()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -0,0 +1,232 @@
+/* Offset-index footer: the indexed blob still pages in like a plain one,
+ * and cfgpack_blob_get() reads single values straight from the footer
+ * without a context. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 40
+
+static cfgpack_type_t diag_type(size_t i) {
+    if (i % 10 == 0) {
+        return (CFGPACK_TYPE_STR);
+    }
+    if (i == 1) {
+        return (CFGPACK_TYPE_I32);
+    }
+    return (i == 2 ? CFGPACK_TYPE_F64 : CFGPACK_TYPE_U32);
+}
+
+/* Indices 3, 6, 9, ... so lookups between them miss.  Every 10th entry is
+ * a string, entry 1 an i32 and entry 2 an f64; the rest are u32. */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    fixture_schema(f, "diag", N_ENTRIES, diag_type);
+    for (size_t i = 0; i < N_ENTRIES; ++i) {
+        f->entries[i].index = (uint16_t)(3 * (i + 1));
+    }
+    return (fixture_init(f));
+}
+
+/* Set every entry except index 15 (entry 4); u32 entries hold
+ * 1000 * index. */
+static void fill(fixture_t *f) {
+    fixture_fill(f, 0, 3000);
+    cfgpack_set_i32(&f->ctx, 6, -40000);
+    cfgpack_set_f64(&f->ctx, 9, 2.5);
+    cfgpack_presence_clear(&f->ctx, 4);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. The indexed blob pages in like a plain one
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_indexed_pagein) {
+    LOG_SECTION("Footer is skipped by pagein and covered by the CRC");
+
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t plain[512];
+    uint8_t blob[1024];
+    size_t plain_len = 0;
+    size_t len = 0;
+    uint32_t u;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    fill(&f);
+    CHECK(cfgpack_pageout(&f.ctx, plain, sizeof(plain), &plain_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout_indexed(&f.ctx, blob, sizeof(blob), &len) ==
+          CFGPACK_OK);
+    /* 39 records of 6, tail 4, key 5, bin8 header 2 */
+    CHECK(len == plain_len + 39 * 6 + 4 + 5 + 2);
+    LOG("Plain %zu bytes, indexed %zu bytes", plain_len, len);
+
+    /* Too small: the needed length is still reported */
+    CHECK(cfgpack_pageout_indexed(&f.ctx, blob, plain_len, &len) ==
+          CFGPACK_ERR_ENCODE);
+    CHECK(len == plain_len + 39 * 6 + 4 + 5 + 2);
+    CHECK(cfgpack_pageout_indexed(&f.ctx, blob, sizeof(blob), &len) ==
+          CFGPACK_OK);
+
+    CHECK(cfgpack_blob_verify(blob, len) == CFGPACK_OK);
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&g.ctx, blob, len) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&g.ctx, 120, &u) == CFGPACK_OK);
+    CHECK(u == 120000u);
+    CHECK(cfgpack_get_size(&g.ctx) == N_ENTRIES - 1);
+    LOG("Pagein restored %zu entries", cfgpack_get_size(&g.ctx));
+
+    /* A flipped footer byte fails the CRC */
+    blob[len - 8] ^= 0x01;
+    CHECK(cfgpack_blob_verify(blob, len) == CFGPACK_ERR_CRC);
+    CHECK(cfgpack_pagein_buf(&g.ctx, blob, len) == CFGPACK_ERR_CRC);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Single values read from the footer match the context
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_blob_get) {
+    LOG_SECTION("cfgpack_blob_get for every entry, hits and misses");
+
+    static fixture_t f;
+    uint8_t blob[1024];
+    size_t len = 0;
+    cfgpack_value_t v;
+    const char *s;
+    uint16_t slen;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    fill(&f);
+    CHECK(cfgpack_pageout_indexed(&f.ctx, blob, sizeof(blob), &len) ==
+          CFGPACK_OK);
+
+    for (size_t i = 0; i < N_ENTRIES; ++i) {
+        uint16_t index = f.entries[i].index;
+        cfgpack_value_t want;
+
+        if (i == 4) {
+            CHECK(cfgpack_blob_get(blob, len, index, &v) ==
+                  CFGPACK_ERR_MISSING);
+            continue;
+        }
+        CHECK(cfgpack_get(&f.ctx, index, &want) == CFGPACK_OK);
+        if (f.entries[i].type == CFGPACK_TYPE_STR) {
+            const char *ws;
+            uint16_t wlen;
+
+            CHECK(cfgpack_blob_get(blob, len, index, &v) ==
+                  CFGPACK_ERR_TYPE_MISMATCH);
+            CHECK(cfgpack_blob_get_str(blob, len, index, &s, &slen) ==
+                  CFGPACK_OK);
+            CHECK(cfgpack_get_str(&f.ctx, index, &ws, &wlen) == CFGPACK_OK);
+            CHECK(slen == wlen && memcmp(s, ws, slen) == 0);
+            continue;
+        }
+        CHECK(cfgpack_blob_get(blob, len, index, &v) == CFGPACK_OK);
+        CHECK(cfgpack_blob_get_str(blob, len, index, &s, &slen) ==
+              CFGPACK_ERR_TYPE_MISMATCH);
+        if (i == 1) {
+            CHECK(v.type == CFGPACK_TYPE_I32 && v.v.i64 == -40000);
+        } else if (i == 2) {
+            CHECK(v.type == CFGPACK_TYPE_F64 && v.v.f64 == 2.5);
+        } else {
+            CHECK(v.v.u64 == want.v.u64);
+        }
+    }
+    LOG("All %d indices match the context", N_ENTRIES);
+
+    /* Narrowest wire type, not schema type: 6000 is a uint16 */
+    CHECK(cfgpack_blob_get(blob, len, 12, &v) == CFGPACK_OK);
+    CHECK(v.type == CFGPACK_TYPE_U16 && v.v.u64 == 12000u);
+
+    /* Between, below and above the stored indices */
+    CHECK(cfgpack_blob_get(blob, len, 4, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_blob_get(blob, len, 0, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_blob_get(blob, len, 200, &v) == CFGPACK_ERR_MISSING);
+
+    CHECK(cfgpack_blob_get_str(blob, len, 3, &s, &slen) == CFGPACK_OK);
+    LOG("Index 3: \"%.*s\"", (int)slen, s);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Blobs without a valid footer are rejected
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_blob_get_errors) {
+    LOG_SECTION("Plain, truncated and corrupted blobs");
+
+    static fixture_t f;
+    uint8_t blob[1024];
+    uint8_t bad[1024];
+    size_t len = 0;
+    cfgpack_value_t v;
+    const char *s;
+    uint16_t slen;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    fill(&f);
+
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_blob_get(blob, len, 6, &v) == CFGPACK_ERR_DECODE);
+    LOG("Plain pageout: ERR_DECODE");
+
+    CHECK(cfgpack_pageout_indexed(&f.ctx, blob, sizeof(blob), &len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_blob_get(NULL, len, 6, &v) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_blob_get(blob, len, 6, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_blob_get_str(blob, len, 3, NULL, &slen) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_blob_get(blob, 7, 6, &v) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_blob_get(blob, len - 1, 6, &v) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_blob_verify(NULL, 0) == CFGPACK_ERR_DECODE);
+
+    /* Record count too large for the blob */
+    memcpy(bad, blob, len);
+    bad[len - 8] = 0xff;
+    CHECK(cfgpack_blob_get(bad, len, 6, &v) == CFGPACK_ERR_DECODE);
+
+    /* Footer key damaged */
+    memcpy(bad, blob, len);
+    bad[len - 4 - (39 * 6 + 4) - 2 - 5] = 0xcf;
+    CHECK(cfgpack_blob_get(bad, len, 6, &v) == CFGPACK_ERR_DECODE);
+
+    /* Offset pointing into the footer */
+    memcpy(bad, blob, len);
+    bad[len - 4 - (39 * 6 + 4) + 2] = 0x7f;
+    CHECK(cfgpack_blob_get(bad, len, 3, &v) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_blob_get_str(bad, len, 3, &s, &slen) ==
+          CFGPACK_ERR_DECODE);
+    LOG("Corrupt footers: ERR_DECODE");
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("indexed_pagein", test_indexed_pagein()) !=
+                TEST_OK);
+    overall |= (test_case_result("blob_get", test_blob_get()) != TEST_OK);
+    overall |= (test_case_result("blob_get_errors", test_blob_get_errors()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -0,0 +1,364 @@
+/* Parallel bulk pagein/pageout: a batch of (ctx, blob) jobs runs across a
+ * work-stealing pool with per-job error codes, and gives the same bytes as
+ * running the jobs one at a time. */
+
+#define _POSIX_C_SOURCE 200809L /* clock_gettime under -std=c99 */
+
+#include "cfgpack/bulk.h"
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/compress.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_JOBS    4096
+#define BLOB_CAP  160
+
+static const char fleet_map[] = "fleet 1\n"
+                                "1 id u32 0\n"
+                                "2 port u16 1883\n"
+                                "3 rate u8 10\n"
+                                "4 off i16 0\n"
+                                "5 gain f32 1.0\n"
+                                "6 volt f64 3.3\n"
+                                "7 host str \"broker\"\n"
+                                "8 tag fstr \"dev\"\n";
+
+static fixture_t fx[N_JOBS];
+static cfgpack_bulk_job_t jobs[N_JOBS];
+static uint8_t blobs[N_JOBS][BLOB_CAP];
+static size_t blob_len[N_JOBS];
+static uint8_t outs[N_JOBS][BLOB_CAP];
+
+/* Device n's config, paged out into blobs[n] */
+static cfgpack_err_t make_blob(fixture_t *f, size_t n) {
+    char host[48];
+
+    snprintf(host, sizeof(host), "gw-%zu.fleet.example.com", n);
+    cfgpack_set_u32(&f->ctx, 1, (uint32_t)n);
+    cfgpack_set_u8(&f->ctx, 3, (uint8_t)(n % 50));
+    cfgpack_set_i16(&f->ctx, 4, (int16_t)(0 - (int)(n % 300)));
+    cfgpack_set_str(&f->ctx, 7, host);
+    return (cfgpack_pageout(&f->ctx, blobs[n], BLOB_CAP, &blob_len[n]));
+}
+
+/* Fresh contexts, one blob per device, jobs that re-encode each blob */
+static cfgpack_err_t make_batch(size_t count) {
+    cfgpack_err_t rc;
+
+    for (size_t n = 0; n < count; ++n) {
+        rc = fixture_parse(&fx[n], fleet_map);
+        if (rc == CFGPACK_OK) {
+            rc = make_blob(&fx[n], n);
+        }
+        if (rc == CFGPACK_OK) {
+            rc = fixture_parse(&fx[n], fleet_map);
+        }
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        memset(&jobs[n], 0, sizeof(jobs[n]));
+        jobs[n].ctx = &fx[n].ctx;
+        jobs[n].in = blobs[n];
+        jobs[n].in_len = blob_len[n];
+        jobs[n].out = outs[n];
+        jobs[n].out_cap = BLOB_CAP;
+        jobs[n].err = CFGPACK_ERR_IO; /* must be overwritten */
+    }
+    return (CFGPACK_OK);
+}
+
+/* Every job succeeded and paged out exactly the blob it paged in */
+static int batch_matches(size_t count) {
+    for (size_t n = 0; n < count; ++n) {
+        uint32_t id = 0;
+
+        if (jobs[n].err != CFGPACK_OK || jobs[n].out_len != blob_len[n] ||
+            memcmp(outs[n], blobs[n], blob_len[n]) != 0) {
+            return (0);
+        }
+        if (cfgpack_get_u32(&fx[n].ctx, 1, &id) != CFGPACK_OK || id != n) {
+            return (0);
+        }
+    }
+    return (1);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + (double)ts.tv_nsec * 1e-9);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. A parallel batch gives the same bytes as one job at a time
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_bulk_roundtrip) {
+    cfgpack_bulk_opts_t opts = {4, CFGPACK_BULK_RAW, NULL, 0};
+    size_t failed = 99;
+
+    LOG_SECTION("Four workers, 1000 jobs");
+    CHECK(make_batch(1000) == CFGPACK_OK);
+    CHECK(cfgpack_bulk_run(jobs, 1000, &opts, &failed) == CFGPACK_OK);
+    CHECK(failed == 0);
+    CHECK(batch_matches(1000));
+    LOG("1000 blobs validated and re-encoded byte for byte");
+
+    LOG_SECTION("One worker runs in the calling thread");
+    opts.threads = 1;
+    CHECK(make_batch(100) == CFGPACK_OK);
+    CHECK(cfgpack_bulk_run(jobs, 100, &opts, NULL) == CFGPACK_OK);
+    CHECK(batch_matches(100));
+
+    LOG_SECTION("More workers than jobs");
+    opts.threads = CFGPACK_BULK_MAX_THREADS + 10;
+    CHECK(cfgpack_bulk_workers(opts.threads, 3) == 3);
+    CHECK(cfgpack_bulk_workers(opts.threads, N_JOBS) ==
+          CFGPACK_BULK_MAX_THREADS);
+    CHECK(cfgpack_bulk_workers(0, N_JOBS) >= 1);
+    CHECK(make_batch(3) == CFGPACK_OK);
+    CHECK(cfgpack_bulk_run(jobs, 3, &opts, NULL) == CFGPACK_OK);
+    CHECK(batch_matches(3));
+
+    LOG_SECTION("Pagein-only and pageout-only jobs");
+    opts.threads = 2;
+    CHECK(make_batch(8) == CFGPACK_OK);
+    for (size_t n = 0; n < 8; ++n) {
+        if (n % 2) {
+            jobs[n].out = NULL;
+        } else {
+            jobs[n].in = NULL;
+        }
+    }
+    CHECK(cfgpack_bulk_run(jobs, 8, &opts, NULL) == CFGPACK_OK);
+    CHECK(jobs[0].out_len > 0 && jobs[1].out_len == 0);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Each job reports its own error; the rest of the batch still runs
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_bulk_errors) {
+    cfgpack_bulk_opts_t opts = {3, CFGPACK_BULK_RAW, NULL, 0};
+    size_t failed = 0;
+
+    CHECK(make_batch(300) == CFGPACK_OK);
+    jobs[10].in_len = 3;                   /* truncated blob */
+    blobs[20][blob_len[20] - 1] ^= 0x5a;   /* corrupted CRC */
+    jobs[30].out_cap = 4;                  /* pageout does not fit */
+    jobs[40].ctx = NULL;
+
+    LOG_SECTION("Four bad jobs among 300");
+    CHECK(cfgpack_bulk_run(jobs, 300, &opts, &failed) == jobs[10].err);
+    CHECK(failed == 4);
+    CHECK(jobs[10].err != CFGPACK_OK && jobs[20].err != CFGPACK_OK);
+    CHECK(jobs[30].err == CFGPACK_ERR_ENCODE);
+    CHECK(jobs[40].err == CFGPACK_ERR_ARGS);
+    CHECK(jobs[10].out_len == 0);
+    CHECK(jobs[11].err == CFGPACK_OK && jobs[299].err == CFGPACK_OK);
+    LOG("Failed pageins skip their pageout; other jobs unaffected");
+
+    LOG_SECTION("Argument checks");
+    opts.codec = CFGPACK_BULK_LZ4;
+    CHECK(cfgpack_bulk_run(jobs, 1, &opts, NULL) == CFGPACK_ERR_ARGS);
+    opts.codec = (cfgpack_bulk_codec_t)42;
+    CHECK(cfgpack_bulk_run(jobs, 1, &opts, NULL) == CFGPACK_ERR_ARGS);
+    opts.codec = CFGPACK_BULK_RAW;
+    CHECK(cfgpack_bulk_run(NULL, 1, &opts, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_bulk_run(jobs, 1, NULL, &failed) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_bulk_run(NULL, 0, &opts, &failed) == CFGPACK_OK);
+    CHECK(failed == 0);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Compressed input decompresses into per-worker scratch
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_bulk_compressed) {
+    static LZ4_stream_t lz4;
+    static heatshrink_encoder hse;
+    static uint8_t packed[256][BLOB_CAP * 2];
+    static uint8_t scratch[4 * 256];
+    cfgpack_bulk_opts_t opts = {4, CFGPACK_BULK_LZ4, scratch, 256};
+    uint8_t tmp[BLOB_CAP];
+
+    CHECK(make_batch(256) == CFGPACK_OK);
+
+    LOG_SECTION("LZ4");
+    for (size_t n = 0; n < 256; ++n) {
+        size_t len = 0;
+
+        CHECK(cfgpack_pagein_buf(&fx[n].ctx, blobs[n], blob_len[n]) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_pageout_lz4(&fx[n].ctx, packed[n], sizeof(packed[n]),
+                                  &len, &lz4, tmp, sizeof(tmp)) ==
+              CFGPACK_OK);
+        CHECK(fixture_parse(&fx[n], fleet_map) == CFGPACK_OK);
+        jobs[n].in = packed[n] + CFGPACK_LZ4_HDR_SIZE;
+        jobs[n].in_len = len - CFGPACK_LZ4_HDR_SIZE;
+        jobs[n].raw_len = blob_len[n];
+    }
+    CHECK(cfgpack_bulk_run(jobs, 256, &opts, NULL) == CFGPACK_OK);
+    CHECK(batch_matches(256));
+
+    LOG_SECTION("Heatshrink, one decoder per worker");
+    for (size_t n = 0; n < 256; ++n) {
+        size_t len = 0;
+
+        CHECK(cfgpack_pageout_heatshrink(&fx[n].ctx, packed[n],
+                                         sizeof(packed[n]), &len, &hse, tmp,
+                                         sizeof(tmp)) == CFGPACK_OK);
+        CHECK(fixture_parse(&fx[n], fleet_map) == CFGPACK_OK);
+        jobs[n].ctx = &fx[n].ctx;
+        jobs[n].in = packed[n];
+        jobs[n].in_len = len;
+    }
+    opts.codec = CFGPACK_BULK_HEATSHRINK;
+    CHECK(cfgpack_bulk_run(jobs, 256, &opts, NULL) == CFGPACK_OK);
+    CHECK(batch_matches(256));
+
+    LOG_SECTION("Scratch smaller than a blob fails per job");
+    opts.scratch_cap = 8;
+    CHECK(cfgpack_bulk_run(jobs, 256, &opts, NULL) == CFGPACK_ERR_BOUNDS);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. Throughput by worker count
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_bulk_scaling) {
+    static const unsigned counts[] = {1, 2, 4, 8, 0};
+    cfgpack_bulk_opts_t opts = {1, CFGPACK_BULK_RAW, NULL, 0};
+    double base = 0;
+
+    LOG_SECTION("Pagein + pageout of 4096 contexts, 10 rounds");
+    CHECK(make_batch(N_JOBS) == CFGPACK_OK);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        double t0;
+        double rate;
+
+        opts.threads = counts[c];
+        t0 = now_s();
+        for (int round = 0; round < 10; ++round) {
+            CHECK(cfgpack_bulk_run(jobs, N_JOBS, &opts, NULL) == CFGPACK_OK);
+        }
+        rate = 10.0 * N_JOBS / (now_s() - t0);
+        if (c == 0) {
+            base = rate;
+        }
+        LOG("%2u workers: %9.0f jobs/s  (x%.2f)",
+            cfgpack_bulk_workers(counts[c], N_JOBS), rate, rate / base);
+    }
+    CHECK(batch_matches(N_JOBS));
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 5. Parallel section checks agree with the serial ones
+ * ═══════════════════════════════════════════════════════════════════════════ */
+#define BIG_ENTRIES CFGPACK_MAX_ENTRIES
+#define BIG_CAP     (BIG_ENTRIES * 16)
+
+TEST_CASE(test_bulk_sections) {
+    static const unsigned counts[] = {1, 3, 8, 0};
+    static cfgpack_schema_t schema;
+    static cfgpack_entry_t entries[BIG_ENTRIES];
+    static cfgpack_value_t values[BIG_ENTRIES];
+    static cfgpack_ctx_t ctx;
+    static uint8_t blob[BIG_CAP];
+    static uint8_t want[BIG_ENTRIES / 8];
+    static uint8_t bad[BIG_ENTRIES / 8];
+    cfgpack_sections_t t;
+    size_t len = 0;
+    size_t nbad = 0;
+    size_t lost = 0;
+    uint32_t v = 0;
+
+    snprintf(schema.map_name, sizeof(schema.map_name), "big");
+    schema.entry_count = BIG_ENTRIES;
+    schema.entries = entries;
+    for (size_t i = 0; i < BIG_ENTRIES; ++i) {
+        entries[i].index = (uint16_t)(1 + i);
+        snprintf(entries[i].name, sizeof(entries[i].name), "e%zu", i);
+        entries[i].type = CFGPACK_TYPE_U32;
+    }
+    CHECK(cfgpack_init(&ctx, &schema, values, BIG_ENTRIES, NULL, 0, NULL,
+                       0) == CFGPACK_OK);
+    for (size_t i = 0; i < BIG_ENTRIES; ++i) {
+        CHECK(cfgpack_set_u32(&ctx, (uint16_t)(1 + i), 70000u + i) ==
+              CFGPACK_OK);
+    }
+    CHECK(cfgpack_pageout_sectioned(&ctx, blob, sizeof(blob), &len, 1) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_sections_open(blob, len, &t) == CFGPACK_OK);
+    LOG("%zu sections in %zu bytes", t.count, len);
+
+    LOG_SECTION("Intact blob");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        CHECK(cfgpack_bulk_verify_sections(blob, len, counts[c], bad,
+                                           sizeof(bad), &nbad) == CFGPACK_OK);
+        CHECK(nbad == 0);
+    }
+
+    LOG_SECTION("Two bad sections, and a bad trailer alone");
+    blob[cfgpack_sections_offset(&t, 5) + 1] ^= 0x40;
+    blob[cfgpack_sections_offset(&t, t.count - 1) + 2] ^= 0x01;
+    CHECK(cfgpack_sections_verify(blob, len, want, sizeof(want), &nbad) ==
+          CFGPACK_ERR_CRC);
+    CHECK(nbad == 2);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        CHECK(cfgpack_bulk_verify_sections(blob, len, counts[c], bad,
+                                           sizeof(bad), &nbad) ==
+              CFGPACK_ERR_CRC);
+        CHECK(nbad == 2 && memcmp(bad, want, sizeof(bad)) == 0);
+    }
+    CHECK(cfgpack_pagein_sections(&ctx, blob, len, bad, &lost) == CFGPACK_OK);
+    CHECK(lost == 2);
+    CHECK(cfgpack_get_u32(&ctx, 1, &v) == CFGPACK_OK && v == 70000u);
+    CHECK(cfgpack_get_size(&ctx) < BIG_ENTRIES);
+    blob[cfgpack_sections_offset(&t, 5) + 1] ^= 0x40;
+    blob[cfgpack_sections_offset(&t, t.count - 1) + 2] ^= 0x01;
+    blob[len - 1] ^= 0x80;
+    CHECK(cfgpack_bulk_verify_sections(blob, len, 4, bad, sizeof(bad),
+                                       &nbad) == CFGPACK_ERR_CRC);
+    CHECK(nbad == 0);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("bulk_roundtrip", test_bulk_roundtrip()) !=
+                TEST_OK);
+    overall |= (test_case_result("bulk_errors", test_bulk_errors()) !=
+                TEST_OK);
+    overall |= (test_case_result("bulk_compressed", test_bulk_compressed()) !=
+                TEST_OK);
+    overall |= (test_case_result("bulk_scaling", test_bulk_scaling()) !=
+                TEST_OK);
+    overall |= (test_case_result("bulk_sections", test_bulk_sections()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
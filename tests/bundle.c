@@ -0,0 +1,276 @@
+/* Bundles: several contexts in one container, sections found by schema
+ * name, unchanged sections carried over and moved in place. */
+
+#include "cfgpack/bundle.h"
+#include "cfgpack/cfgpack.h"
+
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_CTX 3
+#define N_ENT 8
+
+typedef struct {
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[N_ENT];
+    cfgpack_value_t values[N_ENT];
+    cfgpack_ctx_t ctx;
+} ns_t;
+
+static ns_t ns[N_CTX];
+static cfgpack_ctx_t *ctxs[N_CTX];
+static uint8_t bundle[1024];
+
+static void make_ns(ns_t *n, const char *name, cfgpack_type_t type) {
+    snprintf(n->schema.map_name, sizeof(n->schema.map_name), "%s", name);
+    n->schema.version = 1;
+    n->schema.entry_count = N_ENT;
+    n->schema.entries = n->entries;
+    for (size_t i = 0; i < N_ENT; ++i) {
+        n->entries[i].index = (uint16_t)(i + 1);
+        snprintf(n->entries[i].name, sizeof(n->entries[i].name), "e%zu", i);
+        n->entries[i].type = type;
+        n->entries[i].has_default = 0;
+        n->entries[i].str_max = 0;
+    }
+    cfgpack_init(&n->ctx, &n->schema, n->values, N_ENT, NULL, 0, NULL, 0);
+}
+
+static void make_all(void) {
+    make_ns(&ns[0], "radio", CFGPACK_TYPE_U8);
+    make_ns(&ns[1], "sensors", CFGPACK_TYPE_U32);
+    make_ns(&ns[2], "app", CFGPACK_TYPE_U16);
+    for (size_t i = 0; i < N_CTX; ++i) {
+        ctxs[i] = &ns[i].ctx;
+    }
+}
+
+static uint64_t get_u64(cfgpack_ctx_t *ctx, uint16_t index) {
+    cfgpack_value_t v;
+
+    if (cfgpack_get(ctx, index, &v) != CFGPACK_OK) {
+        return (UINT64_MAX);
+    }
+    return (v.v.u64);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Three namespaces in one bundle, loaded one at a time or together
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_bundle_roundtrip) {
+    cfgpack_bundle_sec_t sec;
+    size_t len = 0;
+    size_t kept = 99;
+
+    make_all();
+    CHECK(cfgpack_set_u8(&ns[0].ctx, 1, 11) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&ns[1].ctx, 2, 70000) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&ns[2].ctx, 8, 300) == CFGPACK_OK);
+
+    LOG_SECTION("First save encodes every section");
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, sizeof(bundle), &len,
+                                 &kept) == CFGPACK_OK);
+    CHECK(kept == 0);
+    CHECK(cfgpack_get_dirty_count(&ns[1].ctx) == 0);
+    LOG("Bundle of %zu bytes", len);
+
+    CHECK(cfgpack_bundle_find(bundle, len, "sensors", &sec) == CFGPACK_OK);
+    CHECK(sec.fingerprint == cfgpack_schema_fingerprint(&ns[1].schema));
+    CHECK(sec.blob > bundle && sec.blob + sec.len <= bundle + len);
+    CHECK(cfgpack_bundle_find(bundle, len, "gps", &sec) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_bundle_find(bundle, len, "radi", &sec) ==
+          CFGPACK_ERR_MISSING);
+
+    LOG_SECTION("Load one namespace");
+    make_all();
+    CHECK(cfgpack_bundle_pagein(&ns[1].ctx, bundle, len) == CFGPACK_OK);
+    CHECK(get_u64(&ns[1].ctx, 2) == 70000);
+    CHECK(get_u64(&ns[0].ctx, 1) == UINT64_MAX);
+
+    LOG_SECTION("Load all of them");
+    make_all();
+    CHECK(cfgpack_bundle_pagein_all(ctxs, N_CTX, bundle, len) == CFGPACK_OK);
+    CHECK(get_u64(&ns[0].ctx, 1) == 11);
+    CHECK(get_u64(&ns[2].ctx, 8) == 300);
+
+    LOG_SECTION("A context without a section is left alone");
+    {
+        static ns_t gps;
+        cfgpack_ctx_t *more[2] = {&ns[0].ctx, NULL};
+
+        make_ns(&gps, "gps", CFGPACK_TYPE_U8);
+        more[1] = &gps.ctx;
+        CHECK(cfgpack_bundle_pagein_all(more, 2, bundle, len) ==
+              CFGPACK_ERR_MISSING);
+        CHECK(get_u64(&ns[0].ctx, 1) == 11);
+        CHECK(cfgpack_bundle_pagein(&gps.ctx, bundle, len) ==
+              CFGPACK_ERR_MISSING);
+    }
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Unchanged sections are kept, and moved when an earlier one grows
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_bundle_keep) {
+    static uint8_t ref[1024];
+    cfgpack_bundle_sec_t before;
+    cfgpack_bundle_sec_t after;
+    size_t ref_len = 0;
+    size_t len = 0;
+    size_t kept = 0;
+
+    make_all();
+    for (uint16_t i = 1; i <= N_ENT; ++i) {
+        CHECK(cfgpack_set_u32(&ns[1].ctx, i, 100000u * i) == CFGPACK_OK);
+        CHECK(cfgpack_set_u16(&ns[2].ctx, i, (uint16_t)(1000 + i)) ==
+              CFGPACK_OK);
+    }
+    CHECK(cfgpack_set_u8(&ns[0].ctx, 1, 1) == CFGPACK_OK);
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, sizeof(bundle), &len,
+                                 &kept) == CFGPACK_OK);
+
+    LOG_SECTION("Nothing dirty: every section kept, bundle unchanged");
+    memcpy(ref, bundle, len);
+    ref_len = len;
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, sizeof(bundle), &len,
+                                 &kept) == CFGPACK_OK);
+    CHECK(kept == N_CTX && len == ref_len && memcmp(ref, bundle, len) == 0);
+
+    LOG_SECTION("First section grows: the others move up intact");
+    CHECK(cfgpack_bundle_find(bundle, len, "app", &before) == CFGPACK_OK);
+    memcpy(ref, before.blob, before.len);
+    for (uint16_t i = 2; i <= N_ENT; ++i) {
+        CHECK(cfgpack_set_u8(&ns[0].ctx, i, (uint8_t)(200 + i)) ==
+              CFGPACK_OK);
+    }
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, sizeof(bundle), &len,
+                                 &kept) == CFGPACK_OK);
+    CHECK(kept == 2 && len > ref_len);
+    CHECK(cfgpack_bundle_find(bundle, len, "app", &after) == CFGPACK_OK);
+    CHECK(after.blob > before.blob && after.len == before.len);
+    CHECK(memcmp(after.blob, ref, after.len) == 0);
+
+    LOG_SECTION("First section shrinks: the others move down intact");
+    make_ns(&ns[0], "radio", CFGPACK_TYPE_U8);
+    CHECK(cfgpack_set_u8(&ns[0].ctx, 1, 5) == CFGPACK_OK);
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, sizeof(bundle), &len,
+                                 &kept) == CFGPACK_OK);
+    CHECK(kept == 2);
+    CHECK(cfgpack_bundle_find(bundle, len, "app", &after) == CFGPACK_OK);
+    CHECK(after.blob == before.blob);
+    CHECK(memcmp(after.blob, ref, after.len) == 0);
+
+    LOG_SECTION("Reordered contexts: out-of-order sections are re-encoded");
+    {
+        cfgpack_ctx_t *rev[N_CTX] = {&ns[2].ctx, &ns[1].ctx, &ns[0].ctx};
+
+        CHECK(cfgpack_bundle_pageout(rev, N_CTX, bundle, sizeof(bundle),
+                                     &len, &kept) == CFGPACK_OK);
+        CHECK(kept == 1);
+    }
+    make_all();
+    CHECK(cfgpack_bundle_pagein_all(ctxs, N_CTX, bundle, len) == CFGPACK_OK);
+    CHECK(get_u64(&ns[0].ctx, 1) == 5);
+    CHECK(get_u64(&ns[1].ctx, 8) == 800000);
+    CHECK(get_u64(&ns[2].ctx, 3) == 1003);
+
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, sizeof(bundle), &len,
+                                 &kept) == CFGPACK_OK);
+    CHECK(kept == 1);
+
+    LOG_SECTION("A changed layout is re-encoded even when clean");
+    ns[2].entries[7].type = CFGPACK_TYPE_U32;
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, sizeof(bundle), &len,
+                                 &kept) == CFGPACK_OK);
+    CHECK(kept == 2);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Errors and damaged bundles
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_bundle_errors) {
+    cfgpack_ctx_t *dup[2];
+    cfgpack_bundle_sec_t sec;
+    size_t len = 0;
+    size_t need = 0;
+
+    make_all();
+    CHECK(cfgpack_set_u8(&ns[0].ctx, 1, 9) == CFGPACK_OK);
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, sizeof(bundle), &len,
+                                 NULL) == CFGPACK_OK);
+
+    LOG_SECTION("Too small: size reported, buffer untouched");
+    CHECK(cfgpack_set_u8(&ns[0].ctx, 2, 9) == CFGPACK_OK);
+    need = len;
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, len, &need, NULL) ==
+          CFGPACK_ERR_ENCODE);
+    CHECK(need == len + 2);
+    CHECK(cfgpack_get_dirty_count(&ns[0].ctx) == 1);
+    CHECK(cfgpack_bundle_find(bundle, len, "radio", &sec) == CFGPACK_OK);
+
+    LOG_SECTION("Arguments");
+    dup[0] = &ns[0].ctx;
+    dup[1] = &ns[0].ctx;
+    CHECK(cfgpack_bundle_pageout(dup, 2, bundle, sizeof(bundle), &len,
+                                 NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_bundle_pageout(ctxs, CFGPACK_BUNDLE_MAX + 1, bundle,
+                                 sizeof(bundle), &len,
+                                 NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_bundle_pageout(NULL, 1, bundle, sizeof(bundle), &len,
+                                 NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_bundle_find(NULL, len, "radio", &sec) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_bundle_pagein(NULL, bundle, len) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_bundle_pagein_all(NULL, 1, bundle, len) ==
+          CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("Damaged directory or section");
+    CHECK(cfgpack_bundle_find(bundle, 8, "radio", &sec) ==
+          CFGPACK_ERR_DECODE);
+    bundle[CFGPACK_BUNDLE_HDR_SIZE + 20] ^= 1;
+    CHECK(cfgpack_bundle_find(bundle, len, "radio", &sec) ==
+          CFGPACK_ERR_DECODE);
+    bundle[CFGPACK_BUNDLE_HDR_SIZE + 20] ^= 1;
+    bundle[len - 6] ^= 1;
+    CHECK(cfgpack_bundle_pagein(&ns[2].ctx, bundle, len) == CFGPACK_ERR_CRC);
+
+    LOG_SECTION("An invalid previous bundle is rewritten from scratch");
+    memset(bundle, 0xff, sizeof(bundle));
+    len = 64;
+    CHECK(cfgpack_bundle_pageout(ctxs, N_CTX, bundle, sizeof(bundle), &len,
+                                 &need) == CFGPACK_OK);
+    CHECK(need == 0);
+    make_all();
+    CHECK(cfgpack_bundle_pagein_all(ctxs, N_CTX, bundle, len) == CFGPACK_OK);
+    CHECK(get_u64(&ns[0].ctx, 2) == 9);
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("bundle_roundtrip",
+                                 test_bundle_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("bundle_keep", test_bundle_keep()) !=
+                TEST_OK);
+    overall |= (test_case_result("bundle_errors", test_bundle_errors()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
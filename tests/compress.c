@@ -0,0 +1,271 @@
+/* On-device compressed pageout: LZ4 and heatshrink output carries the
+ * cfgpack-compress framing and loads back with the matching pagein. */
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/compress.h"
+#include "cfgpack/decompress.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 6
+
+static uint8_t scratch[1024];
+static uint8_t out[1024];
+static uint8_t back[1024];
+
+static cfgpack_type_t zip_type(size_t i) {
+    return (i < 2 ? CFGPACK_TYPE_U16 : CFGPACK_TYPE_STR);
+}
+
+/* u16 (index 1, 2) + str (index 3..6); strings are left unset. */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    return (fixture_make(f, "zip", N_ENTRIES, zip_type));
+}
+
+/* String-heavy values with plenty of repetition. */
+static void fill_fixture(fixture_t *f) {
+    cfgpack_set_u16(&f->ctx, 1, 1234);
+    cfgpack_set_u16(&f->ctx, 2, 5678);
+    cfgpack_set_str(&f->ctx, 3, "mqtt://broker.example.com:1883/devices");
+    cfgpack_set_str(&f->ctx, 4, "mqtt://broker.example.com:1883/telemetry");
+    cfgpack_set_str(&f->ctx, 5, "mqtt://broker.example.com:1883/commands");
+    cfgpack_set_str(&f->ctx, 6, "mqtt://broker.example.com:1883/status");
+}
+
+/* Same layout as the fixture, with the string defaults in the schema. */
+static const char zip_map[] =
+    "zip 1\n"
+    "1 e0 u16 0\n"
+    "2 e1 u16 0\n"
+    "3 e2 str \"mqtt://broker.example.com:1883/devices\"\n"
+    "4 e3 str \"mqtt://broker.example.com:1883/telemetry\"\n"
+    "5 e4 str \"mqtt://broker.example.com:1883/commands\"\n"
+    "6 e5 str \"mqtt://broker.example.com:1883/status\"\n";
+
+static int same_values(const cfgpack_ctx_t *a, const cfgpack_ctx_t *b) {
+    for (uint16_t i = 1; i <= N_ENTRIES; ++i) {
+        const char *sa, *sb;
+        uint16_t la, lb;
+        cfgpack_value_t va, vb;
+
+        if (i <= 2) {
+            if (cfgpack_get(a, i, &va) != CFGPACK_OK ||
+                cfgpack_get(b, i, &vb) != CFGPACK_OK || va.v.u64 != vb.v.u64) {
+                return (0);
+            }
+            continue;
+        }
+        if (cfgpack_get_str(a, i, &sa, &la) != CFGPACK_OK ||
+            cfgpack_get_str(b, i, &sb, &lb) != CFGPACK_OK || la != lb ||
+            memcmp(sa, sb, la) != 0) {
+            return (0);
+        }
+    }
+    return (1);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. LZ4 pageout round-trips through cfgpack_pagein_lz4()
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lz4_pageout) {
+    static LZ4_stream_t state;
+    static fixture_t src, dst;
+    size_t raw_len = 0;
+    size_t len = 0;
+    uint32_t orig;
+
+    LOG_SECTION("LZ4 pageout with the original-size header");
+
+    CHECK(make_fixture(&src) == CFGPACK_OK);
+    fill_fixture(&src);
+    CHECK(cfgpack_pageout(&src.ctx, back, sizeof(back), &raw_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout_lz4(&src.ctx, out, sizeof(out), &len, &state,
+                              scratch, sizeof(scratch)) == CFGPACK_OK);
+    LOG("Blob %zu bytes, LZ4 %zu bytes", raw_len, len);
+    CHECK(len < raw_len);
+
+    orig = (uint32_t)out[0] | ((uint32_t)out[1] << 8) |
+           ((uint32_t)out[2] << 16) | ((uint32_t)out[3] << 24);
+    CHECK(orig == raw_len);
+    CHECK(memcmp(scratch, back, raw_len) == 0);
+
+    CHECK(make_fixture(&dst) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_lz4(&dst.ctx, out + CFGPACK_LZ4_HDR_SIZE,
+                             len - CFGPACK_LZ4_HDR_SIZE, orig, back,
+                             sizeof(back)) == CFGPACK_OK);
+    CHECK(same_values(&src.ctx, &dst.ctx));
+    LOG("Values restored from the compressed blob");
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Heatshrink pageout round-trips through cfgpack_pagein_heatshrink()
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_heatshrink_pageout) {
+    static heatshrink_encoder hse;
+    static fixture_t src, dst;
+    size_t raw_len = 0;
+    size_t len = 0;
+
+    LOG_SECTION("Heatshrink pageout with no header");
+
+    CHECK(make_fixture(&src) == CFGPACK_OK);
+    fill_fixture(&src);
+    CHECK(cfgpack_pageout(&src.ctx, back, sizeof(back), &raw_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout_heatshrink(&src.ctx, out, sizeof(out), &len, &hse,
+                                     scratch, sizeof(scratch)) == CFGPACK_OK);
+    LOG("Blob %zu bytes, heatshrink %zu bytes", raw_len, len);
+    CHECK(len < raw_len);
+
+    CHECK(make_fixture(&dst) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_heatshrink(&dst.ctx, out, len, back, sizeof(back)) ==
+          CFGPACK_OK);
+    CHECK(same_values(&src.ctx, &dst.ctx));
+
+    /* The encoder is reset per call, so a second pageout is identical */
+    memcpy(back, out, len);
+    CHECK(cfgpack_pageout_heatshrink(&src.ctx, out, sizeof(out), &len, &hse,
+                                     scratch, sizeof(scratch)) == CFGPACK_OK);
+    CHECK(memcmp(back, out, len) == 0);
+    LOG("Values restored; repeated pageout is byte-identical");
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Schema dictionary: defaults-only pageout primes LZ4
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lz4_dict_pageout) {
+    static LZ4_stream_t state;
+    static fixture_t src, dst;
+    static uint8_t dict[256];
+    size_t dict_len = 0;
+    size_t plain_len = 0;
+    size_t len = 0;
+    uint32_t orig;
+
+    LOG_SECTION("LZ4 pageout and pagein with the schema dictionary");
+
+    /* Defaults-only pageout of a freshly parsed schema, before any set */
+    CHECK(fixture_parse(&src, zip_map) == CFGPACK_OK);
+    CHECK(cfgpack_lz4_dict(NULL, dict, sizeof(dict), &dict_len) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_lz4_dict(&src.ctx, dict, 8, &dict_len) ==
+          CFGPACK_ERR_ENCODE);
+    CHECK(cfgpack_lz4_dict(&src.ctx, dict, sizeof(dict), &dict_len) ==
+          CFGPACK_OK);
+    CHECK(dict_len > 0 && memcmp(dict + 3, "zip", 3) == 0);
+    LOG("Dictionary %zu bytes", dict_len);
+
+    /* A few changes from the defaults */
+    CHECK(cfgpack_set_u16(&src.ctx, 1, 1234) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&src.ctx, 4, "mqtt://broker.example.com:8883/tls") ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout_lz4(&src.ctx, out, sizeof(out), &plain_len, &state,
+                              scratch, sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_lz4_dict(&src.ctx, out, sizeof(out), &len, &state,
+                                   NULL, 4, scratch,
+                                   sizeof(scratch)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_lz4_dict(&src.ctx, out, sizeof(out), &len, &state,
+                                   dict, dict_len, scratch,
+                                   sizeof(scratch)) == CFGPACK_OK);
+    LOG("Plain LZ4 %zu bytes, with dictionary %zu bytes", plain_len, len);
+    CHECK(len < plain_len);
+
+    orig = (uint32_t)out[0] | ((uint32_t)out[1] << 8) |
+           ((uint32_t)out[2] << 16) | ((uint32_t)out[3] << 24);
+    CHECK(fixture_parse(&dst, zip_map) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_lz4_dict(&dst.ctx, out + CFGPACK_LZ4_HDR_SIZE,
+                                  len - CFGPACK_LZ4_HDR_SIZE, orig, NULL, 4,
+                                  back, sizeof(back)) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_pagein_lz4(&dst.ctx, out + CFGPACK_LZ4_HDR_SIZE,
+                             len - CFGPACK_LZ4_HDR_SIZE, orig, back,
+                             sizeof(back)) != CFGPACK_OK);
+    CHECK(cfgpack_pagein_lz4_dict(&dst.ctx, out + CFGPACK_LZ4_HDR_SIZE,
+                                  len - CFGPACK_LZ4_HDR_SIZE, orig, dict,
+                                  dict_len, back, sizeof(back)) == CFGPACK_OK);
+    CHECK(same_values(&src.ctx, &dst.ctx));
+    LOG("Loads only with the dictionary; values restored");
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. NULL arguments and undersized buffers
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pageout_errors) {
+    static heatshrink_encoder hse;
+    static LZ4_stream_t state;
+    static fixture_t f;
+    size_t len;
+
+    LOG_SECTION("Argument and capacity errors");
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    fill_fixture(&f);
+
+    CHECK(cfgpack_pageout_lz4(NULL, out, sizeof(out), &len, &state, scratch,
+                              sizeof(scratch)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_lz4(&f.ctx, out, sizeof(out), &len, NULL, scratch,
+                              sizeof(scratch)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_lz4(&f.ctx, out, sizeof(out), &len, &state, NULL,
+                              sizeof(scratch)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_heatshrink(&f.ctx, NULL, sizeof(out), &len, &hse,
+                                     scratch,
+                                     sizeof(scratch)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_heatshrink(&f.ctx, out, sizeof(out), &len, NULL,
+                                     scratch,
+                                     sizeof(scratch)) == CFGPACK_ERR_ARGS);
+    LOG("NULL arguments rejected with ERR_ARGS");
+
+    /* Scratch too small for the uncompressed blob */
+    CHECK(cfgpack_pageout_lz4(&f.ctx, out, sizeof(out), &len, &state, scratch,
+                              32) == CFGPACK_ERR_ENCODE);
+    CHECK(cfgpack_pageout_heatshrink(&f.ctx, out, sizeof(out), &len, &hse,
+                                     scratch, 32) == CFGPACK_ERR_ENCODE);
+
+    /* Output too small for the compressed data */
+    CHECK(cfgpack_pageout_lz4(&f.ctx, out, CFGPACK_LZ4_HDR_SIZE, &len, &state,
+                              scratch,
+                              sizeof(scratch)) == CFGPACK_ERR_ENCODE);
+    CHECK(cfgpack_pageout_lz4(&f.ctx, out, 24, &len, &state, scratch,
+                              sizeof(scratch)) == CFGPACK_ERR_ENCODE);
+    CHECK(cfgpack_pageout_heatshrink(&f.ctx, out, 24, &len, &hse, scratch,
+                                     sizeof(scratch)) == CFGPACK_ERR_ENCODE);
+    LOG("Undersized scratch and output rejected with ERR_ENCODE");
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("lz4_pageout", test_lz4_pageout()) !=
+                TEST_OK);
+    overall |= (test_case_result("heatshrink_pageout",
+                                 test_heatshrink_pageout()) != TEST_OK);
+    overall |= (test_case_result("lz4_dict_pageout",
+                                 test_lz4_dict_pageout()) != TEST_OK);
+    overall |= (test_case_result("pageout_errors", test_pageout_errors()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
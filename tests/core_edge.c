@@ -19,6 +19,7 @@ static void make_schema(cfgpack_schema_t *schema,
         snprintf(entries[i].name, sizeof(entries[i].name), "e%zu", i);
         entries[i].type = CFGPACK_TYPE_U8;
         entries[i].has_default = 0;
+        entries[i].str_max = 0;
     }
 }
 
@@ -396,6 +397,560 @@ TEST_CASE(test_get_size) {
     return TEST_OK;
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 12. Name index: same answers as the linear scan
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_name_index) {
+    LOG_SECTION("Install index over 40 entries");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[40];
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t values[40];
+    cfgpack_value_t v;
+    uint64_t index[40];
+    char name[8];
+
+    make_schema(&schema, entries, 40); /* e0..e39: e1 is a prefix of e10 */
+    snprintf(entries[39].name, sizeof(entries[39].name), "zzzzz");
+    CHECK(cfgpack_init(&ctx, &schema, values, 40, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(ctx.name_index == NULL);
+    CHECK(cfgpack_name_index_init(&ctx, index, 39) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_name_index_init(&ctx, NULL, 40) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_name_index_init(&ctx, index, 40) == CFGPACK_OK);
+
+    for (uint16_t i = 0; i < 40; ++i) {
+        v.type = CFGPACK_TYPE_U8;
+        v.v.u64 = (uint64_t)(i + 1);
+        CHECK(cfgpack_set_by_name(&ctx, entries[i].name, &v) == CFGPACK_OK);
+    }
+    for (uint16_t i = 0; i < 40; ++i) {
+        CHECK(cfgpack_get(&ctx, (uint16_t)(i + 1), &v) == CFGPACK_OK);
+        CHECK(v.v.u64 == (uint64_t)(i + 1));
+    }
+    LOG("All 40 names resolved through the index");
+
+    LOG_SECTION("Misses: unknown, prefix, over-long and empty names");
+    CHECK(cfgpack_get_by_name(&ctx, "e40", &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_by_name(&ctx, "e", &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_by_name(&ctx, "zzzzzz", &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_by_name(&ctx, "", &v) == CFGPACK_ERR_MISSING);
+    snprintf(name, sizeof(name), "e10");
+    CHECK(cfgpack_get_by_name(&ctx, name, &v) == CFGPACK_OK);
+    CHECK(v.v.u64 == 11);
+
+    LOG_SECTION("Duplicate names keep linear lookups");
+    snprintf(entries[5].name, sizeof(entries[5].name), "e4");
+    CHECK(cfgpack_init(&ctx, &schema, values, 40, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_name_index_init(&ctx, index, 40) == CFGPACK_ERR_DUPLICATE);
+    CHECK(ctx.name_index == NULL);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 13. Dense index table: direct lookups, holes, and sparse fallback
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_index_table) {
+    LOG_SECTION("Install table over indices 2, 4, ..., 40");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[20];
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t values[20];
+    cfgpack_value_t v;
+    cfgpack_schema_sizing_t sizing;
+    uint8_t table[41];
+
+    make_schema(&schema, entries, 20);
+    for (size_t i = 0; i < 20; ++i) {
+        entries[i].index = (uint16_t)(2 * (i + 1));
+    }
+    cfgpack_schema_get_sizing(&schema, &sizing);
+    CHECK(sizing.index_table_size == 41);
+    CHECK(cfgpack_init(&ctx, &schema, values, 20, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(ctx.index_table == NULL);
+    CHECK(cfgpack_index_table_init(&ctx, table, 40) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_index_table_init(&ctx, NULL, 41) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_index_table_init(&ctx, table, sizing.index_table_size) ==
+          CFGPACK_OK);
+
+    for (uint16_t i = 2; i <= 40; i = (uint16_t)(i + 2)) {
+        CHECK(cfgpack_set_u8(&ctx, i, (uint8_t)i) == CFGPACK_OK);
+    }
+    for (uint16_t i = 2; i <= 40; i = (uint16_t)(i + 2)) {
+        CHECK(cfgpack_get(&ctx, i, &v) == CFGPACK_OK);
+        CHECK(v.v.u64 == i);
+    }
+    LOG("20 entries resolved through the table");
+
+    LOG_SECTION("Holes and indices past the table miss");
+    CHECK(cfgpack_get(&ctx, 3, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_set_u8(&ctx, 41, 1) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get(&ctx, 60000, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get(&ctx, 0, &v) == CFGPACK_ERR_RESERVED_INDEX);
+
+    LOG_SECTION("Sparse schema keeps binary search");
+    entries[19].index = 5000;
+    cfgpack_schema_get_sizing(&schema, &sizing);
+    CHECK(sizing.index_table_size == 0);
+    CHECK(cfgpack_init(&ctx, &schema, values, 20, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_index_table_init(&ctx, table, sizeof(table)) ==
+          CFGPACK_ERR_BOUNDS);
+    CHECK(ctx.index_table == NULL);
+    CHECK(cfgpack_set_u8(&ctx, 5000, 7) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 5000, &v) == CFGPACK_OK);
+    CHECK(v.v.u64 == 7);
+
+    return TEST_OK;
+}
+
+#ifdef CFGPACK_PACKED_ARENA
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 14. Packed value arena: natural widths, accessors, and pagein/pageout
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_packed_values) {
+    LOG_SECTION("Pack defaults from transient value slots");
+
+    static const cfgpack_type_t types[8] = {
+        CFGPACK_TYPE_U8,  CFGPACK_TYPE_I16, CFGPACK_TYPE_U32,
+        CFGPACK_TYPE_F64, CFGPACK_TYPE_STR, CFGPACK_TYPE_FSTR,
+        CFGPACK_TYPE_I8,  CFGPACK_TYPE_U64,
+    };
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[8];
+    cfgpack_ctx_t ctx;
+    cfgpack_ctx_t ctx2;
+    cfgpack_value_t values[8];
+    cfgpack_value_t values2[8];
+    cfgpack_value_t v;
+    uint64_t arena[8];
+    char pool[82];
+    char pool2[82];
+    uint16_t offsets[2];
+    uint16_t offsets2[2];
+    uint8_t blob[128];
+    size_t blob_len = 0;
+    const char *str;
+    uint16_t slen;
+    uint8_t flen;
+
+    make_schema(&schema, entries, 8);
+    for (size_t i = 0; i < 8; ++i) {
+        entries[i].type = types[i];
+    }
+    memset(values, 0, sizeof(values));
+    entries[0].has_default = 1;
+    values[0].type = CFGPACK_TYPE_U8;
+    values[0].v.u64 = 200;
+    entries[1].has_default = 1;
+    values[1].type = CFGPACK_TYPE_I16;
+    values[1].v.i64 = -1234;
+
+    CHECK(cfgpack_packed_size(&schema) == 16 + 27);
+    CHECK(cfgpack_packed_size(NULL) == 0);
+    CHECK(cfgpack_init(&ctx, &schema, values, 8, pool, sizeof(pool), offsets,
+                       2) == CFGPACK_OK);
+    CHECK(cfgpack_packed_init(&ctx, arena, 42) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_packed_init(&ctx, (uint8_t *)arena + 1, 42) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_packed_init(&ctx, arena, sizeof(arena)) == CFGPACK_OK);
+    CHECK(cfgpack_packed_init(&ctx, arena, sizeof(arena)) == CFGPACK_ERR_ARGS);
+    memset(values, 0xA5, sizeof(values));
+    LOG("%zu arena bytes instead of %zu slot bytes",
+        cfgpack_packed_size(&schema), sizeof(values));
+
+    CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_OK);
+    CHECK(v.type == CFGPACK_TYPE_U8 && v.v.u64 == 200);
+    CHECK(cfgpack_get(&ctx, 2, &v) == CFGPACK_OK);
+    CHECK(v.type == CFGPACK_TYPE_I16 && v.v.i64 == -1234);
+    CHECK(cfgpack_get(&ctx, 3, &v) == CFGPACK_ERR_MISSING);
+
+    LOG_SECTION("Set every type and read it back");
+    CHECK(cfgpack_set_u8(&ctx, 1, 7) == CFGPACK_OK);
+    CHECK(cfgpack_set_i16(&ctx, 2, -32768) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&ctx, 3, 0xDEADBEEFu) == CFGPACK_OK);
+    CHECK(cfgpack_set_f64(&ctx, 4, 2.5) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&ctx, 5, "hello") == CFGPACK_OK);
+    CHECK(cfgpack_set_fstr(&ctx, 6, "abc") == CFGPACK_OK);
+    CHECK(cfgpack_set_i8(&ctx, 7, -5) == CFGPACK_OK);
+    CHECK(cfgpack_set_u64(&ctx, 8, 0x0123456789ABCDEFull) == CFGPACK_OK);
+
+    CHECK(cfgpack_get(&ctx, 2, &v) == CFGPACK_OK && v.v.i64 == -32768);
+    CHECK(cfgpack_get(&ctx, 3, &v) == CFGPACK_OK && v.v.u64 == 0xDEADBEEFu);
+    CHECK(cfgpack_get(&ctx, 4, &v) == CFGPACK_OK && v.v.f64 == 2.5);
+    CHECK(cfgpack_get(&ctx, 7, &v) == CFGPACK_OK && v.v.i64 == -5);
+    CHECK(cfgpack_get(&ctx, 8, &v) == CFGPACK_OK &&
+          v.v.u64 == 0x0123456789ABCDEFull);
+    CHECK(cfgpack_get_str(&ctx, 5, &str, &slen) == CFGPACK_OK);
+    CHECK(slen == 5 && memcmp(str, "hello", 5) == 0);
+    CHECK(cfgpack_get_fstr(&ctx, 6, &str, &flen) == CFGPACK_OK);
+    CHECK(flen == 3 && memcmp(str, "abc", 3) == 0);
+
+    LOG_SECTION("Packed pageout decodes into value slots and back");
+    CHECK(cfgpack_pageout(&ctx, blob, sizeof(blob), &blob_len) == CFGPACK_OK);
+    memset(values2, 0, sizeof(values2));
+    CHECK(cfgpack_init(&ctx2, &schema, values2, 8, pool2, sizeof(pool2),
+                       offsets2, 2) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx2, blob, blob_len) == CFGPACK_OK);
+    CHECK(values2[1].v.i64 == -32768);
+    CHECK(values2[7].v.u64 == 0x0123456789ABCDEFull);
+    CHECK(cfgpack_get_str(&ctx2, 5, &str, &slen) == CFGPACK_OK);
+    CHECK(slen == 5 && memcmp(str, "hello", 5) == 0);
+
+    CHECK(cfgpack_set_u32(&ctx2, 3, 42) == CFGPACK_OK);
+    CHECK(cfgpack_set_fstr(&ctx2, 6, "xyz") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx2, blob, sizeof(blob), &blob_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, blob_len) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 3, &v) == CFGPACK_OK && v.v.u64 == 42);
+    CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_OK && v.v.u64 == 7);
+    CHECK(cfgpack_get_fstr(&ctx, 6, &str, &flen) == CFGPACK_OK);
+    CHECK(flen == 3 && memcmp(str, "xyz", 3) == 0);
+
+    return TEST_OK;
+}
+#endif /* CFGPACK_PACKED_ARENA */
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 15. Batch get/set: merge walk, ordering rules, and atomic set
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_get_set_many) {
+    LOG_SECTION("Set and get a block of sparse indices in one call");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[10];
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t values[10];
+    cfgpack_value_t in[3];
+    cfgpack_value_t out[3];
+    uint8_t table[31];
+    size_t failed = 99;
+
+    make_schema(&schema, entries, 10);
+    for (size_t i = 0; i < 10; ++i) {
+        entries[i].index = (uint16_t)(3 * (i + 1));
+    }
+    CHECK(cfgpack_init(&ctx, &schema, values, 10, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+
+    static const uint16_t idx[3] = {6, 15, 30};
+    for (size_t i = 0; i < 3; ++i) {
+        in[i].type = CFGPACK_TYPE_U8;
+        in[i].v.u64 = 10 + i;
+    }
+    CHECK(cfgpack_set_many(&ctx, idx, in, 3, &failed) == CFGPACK_OK);
+    CHECK(failed == 99);
+    CHECK(cfgpack_get_dirty_count(&ctx) == 3);
+    CHECK(cfgpack_get_many(&ctx, idx, 3, out, NULL) == CFGPACK_OK);
+    for (size_t i = 0; i < 3; ++i) {
+        CHECK(out[i].v.u64 == 10 + i);
+    }
+    CHECK(cfgpack_get_many(&ctx, NULL, 0, NULL, NULL) == CFGPACK_OK);
+    LOG("Indices 6, 15, 30 written and read back");
+
+    LOG_SECTION("Unsorted, duplicate, reserved and unknown indices fail");
+    static const uint16_t unsorted[2] = {15, 6};
+    static const uint16_t dup[2] = {6, 6};
+    static const uint16_t zero[2] = {0, 6};
+    static const uint16_t unknown[3] = {6, 7, 30};
+    static const uint16_t absent[2] = {6, 9};
+    CHECK(cfgpack_get_many(&ctx, unsorted, 2, out, &failed) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(failed == 1);
+    CHECK(cfgpack_get_many(&ctx, dup, 2, out, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_get_many(&ctx, zero, 2, out, NULL) ==
+          CFGPACK_ERR_RESERVED_INDEX);
+    CHECK(cfgpack_get_many(&ctx, unknown, 3, out, &failed) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(failed == 1);
+    CHECK(cfgpack_get_many(&ctx, absent, 2, out, &failed) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(failed == 1 && out[0].v.u64 == 10);
+    CHECK(cfgpack_get_many(NULL, idx, 3, out, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_set_many(&ctx, idx, NULL, 3, NULL) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("A bad value leaves the whole batch unapplied");
+    cfgpack_dirty_clear_all(&ctx);
+    in[0].v.u64 = 50;
+    in[2].type = CFGPACK_TYPE_U16;
+    CHECK(cfgpack_set_many(&ctx, idx, in, 3, &failed) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(failed == 2);
+    CHECK(cfgpack_get_dirty_count(&ctx) == 0);
+    CHECK(cfgpack_get_many(&ctx, idx, 1, out, NULL) == CFGPACK_OK);
+    CHECK(out[0].v.u64 == 10);
+    LOG("Entry 6 still holds 10 after the failed batch");
+
+    LOG_SECTION("Batch resolves through the index table");
+    CHECK(cfgpack_index_table_init(&ctx, table, sizeof(table)) == CFGPACK_OK);
+    in[2].type = CFGPACK_TYPE_U8;
+    CHECK(cfgpack_set_many(&ctx, idx, in, 3, NULL) == CFGPACK_OK);
+    CHECK(cfgpack_get_many(&ctx, idx, 3, out, NULL) == CFGPACK_OK);
+    CHECK(out[0].v.u64 == 50 && out[2].v.u64 == 12);
+    CHECK(cfgpack_get_many(&ctx, unknown, 3, out, &failed) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(failed == 1);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 16. String views: str and fstr by index and name, error paths
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_str_view) {
+    LOG_SECTION("View str and fstr entries in place");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[3];
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t values[3];
+    char str_pool[128];
+    uint16_t str_offsets[2];
+    const char *s;
+    size_t len = 0;
+
+    make_schema(&schema, entries, 3);
+    entries[0].type = CFGPACK_TYPE_STR;
+    entries[1].type = CFGPACK_TYPE_FSTR;
+    CHECK(cfgpack_init(&ctx, &schema, values, 3, str_pool, sizeof(str_pool),
+                       str_offsets, 2) == CFGPACK_OK);
+
+    CHECK(cfgpack_get_str_view(&ctx, 1, &s, &len) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_set_str(&ctx, 1, "devices/abc") == CFGPACK_OK);
+    CHECK(cfgpack_set_fstr(&ctx, 2, "node7") == CFGPACK_OK);
+
+    CHECK(cfgpack_get_str_view(&ctx, 1, &s, &len) == CFGPACK_OK);
+    CHECK(len == 11 && memcmp(s, "devices/abc", 11) == 0);
+    CHECK(s >= str_pool && s < str_pool + sizeof(str_pool));
+    CHECK(cfgpack_get_str_view(&ctx, 2, &s, &len) == CFGPACK_OK);
+    CHECK(len == 5 && strcmp(s, "node7") == 0);
+    CHECK(cfgpack_get_str_view_by_name(&ctx, "e0", &s, &len) == CFGPACK_OK);
+    CHECK(len == 11 && s[len] == '\0');
+    LOG("Views point into the pool: '%s' (%zu bytes)", s, len);
+
+    LOG_SECTION("A set through another path is visible through the view");
+    CHECK(cfgpack_set_str(&ctx, 1, "x") == CFGPACK_OK);
+    CHECK(cfgpack_get_str_view(&ctx, 1, &s, &len) == CFGPACK_OK);
+    CHECK(len == 1 && s[0] == 'x');
+
+    LOG_SECTION("Error paths");
+    CHECK(cfgpack_set_u8(&ctx, 3, 1) == CFGPACK_OK);
+    CHECK(cfgpack_get_str_view(&ctx, 3, &s, &len) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(cfgpack_get_str_view(&ctx, 0, &s, &len) ==
+          CFGPACK_ERR_RESERVED_INDEX);
+    CHECK(cfgpack_get_str_view(&ctx, 9, &s, &len) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_str_view(&ctx, 1, NULL, &len) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_get_str_view_by_name(&ctx, "nope", &s, &len) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_str_view_by_name(&ctx, NULL, &s, &len) ==
+          CFGPACK_ERR_ARGS);
+
+    return TEST_OK;
+}
+
+#ifdef CFGPACK_SIZE_CACHE
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 17. Cached pageout size follows sets, pagein, and packed storage
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/* The cached measure must equal what a real pageout writes. */
+typedef struct {
+    uint8_t data[256];
+    size_t len;
+} ref_sink_t;
+
+static cfgpack_err_t ref_sink(void *user, const uint8_t *data, size_t len) {
+    ref_sink_t *ref = user;
+
+    if (ref->len + len > sizeof(ref->data)) {
+        return (CFGPACK_ERR_IO);
+    }
+    memcpy(ref->data + ref->len, data, len);
+    ref->len += len;
+    return (CFGPACK_OK);
+}
+
+/* With a valid cache, a pageout that fits takes the unchecked encoder;
+ * the streamed pageout still goes through cfgpack_buf_append(). */
+static int cached_size_ok(cfgpack_ctx_t *ctx, uint8_t *blob, size_t cap,
+                          size_t *blob_len) {
+    static ref_sink_t ref;
+    uint8_t chunk[CFGPACK_STREAM_CHUNK_MIN];
+    size_t measured = 0;
+
+    ref.len = 0;
+    if (cfgpack_pageout_stream(ctx, ref_sink, &ref, chunk, sizeof(chunk)) !=
+            CFGPACK_OK ||
+        cfgpack_pageout_measure(ctx, &measured) != CFGPACK_OK ||
+        cfgpack_pageout(ctx, blob, cap, blob_len) != CFGPACK_OK) {
+        return (0);
+    }
+    return (measured == *blob_len && ref.len == *blob_len &&
+            memcmp(ref.data, blob, *blob_len) == 0);
+}
+
+TEST_CASE(test_size_cache) {
+    LOG_SECTION("Measure from the cache after each kind of write");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[20];
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t values[20];
+    char str_pool[128];
+    uint16_t str_offsets[2];
+    uint8_t blob[256];
+    uint8_t delta[64];
+    size_t blob_len = 0;
+    size_t delta_len = 0;
+
+    make_schema(&schema, entries, 20);
+    entries[0].type = CFGPACK_TYPE_STR;
+    entries[1].type = CFGPACK_TYPE_FSTR;
+    entries[2].type = CFGPACK_TYPE_I64;
+    entries[3].type = CFGPACK_TYPE_F32;
+    entries[4].type = CFGPACK_TYPE_U64;
+    entries[5].has_default = 1;
+    values[5].type = CFGPACK_TYPE_U8;
+    values[5].v.u64 = 200;
+    CHECK(cfgpack_init(&ctx, &schema, values, 20, str_pool, sizeof(str_pool),
+                       str_offsets, 2) == CFGPACK_OK);
+    CHECK(cfgpack_size_cache_init(NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_size_cache_init(&ctx) == CFGPACK_OK);
+    CHECK(cached_size_ok(&ctx, blob, sizeof(blob), &blob_len));
+    LOG("Defaults only: %zu bytes", blob_len);
+
+    CHECK(cfgpack_set_str(&ctx, 1, "short") == CFGPACK_OK);
+    CHECK(cfgpack_set_fstr(&ctx, 2, "node7") == CFGPACK_OK);
+    CHECK(cfgpack_set_i64(&ctx, 3, -5) == CFGPACK_OK);
+    CHECK(cfgpack_set_f32(&ctx, 4, 1.5f) == CFGPACK_OK);
+    CHECK(cached_size_ok(&ctx, blob, sizeof(blob), &blob_len));
+
+    /* Wider encodings, and more than 15 entries (map16 header) */
+    CHECK(cfgpack_set_str(&ctx, 1, "a string longer than thirty-one bytes") ==
+          CFGPACK_OK);
+    CHECK(cfgpack_set_i64(&ctx, 3, INT64_MIN) == CFGPACK_OK);
+    CHECK(cfgpack_set_u64(&ctx, 5, UINT64_MAX) == CFGPACK_OK);
+    for (uint16_t i = 6; i <= 20; ++i) {
+        CHECK(cfgpack_set_u8(&ctx, i, (uint8_t)(i * 12)) == CFGPACK_OK);
+    }
+    CHECK(cached_size_ok(&ctx, blob, sizeof(blob), &blob_len));
+    LOG("Overwrites and a map16 header: %zu bytes", blob_len);
+    size_t short_len = 0;
+    CHECK(cfgpack_pageout(&ctx, blob, blob_len - 1, &short_len) ==
+          CFGPACK_ERR_ENCODE);
+    CHECK(short_len == blob_len);
+    CHECK(cfgpack_header_enable(&ctx, 1) == CFGPACK_OK);
+    CHECK(cached_size_ok(&ctx, blob, sizeof(blob), &blob_len));
+    CHECK(cfgpack_header_enable(&ctx, 0) == CFGPACK_OK);
+
+    uint16_t idx[2] = {3, 7};
+    cfgpack_value_t vals[2] = {{.type = CFGPACK_TYPE_I64, .v.i64 = 100},
+                               {.type = CFGPACK_TYPE_U8, .v.u64 = 1}};
+    CHECK(cfgpack_set_many(&ctx, idx, vals, 2, NULL) == CFGPACK_OK);
+    CHECK(cfgpack_set_by_name(&ctx, "e19", &vals[1]) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_delta(&ctx, delta, sizeof(delta), &delta_len) ==
+          CFGPACK_OK);
+    CHECK(cached_size_ok(&ctx, blob, sizeof(blob), &blob_len));
+
+    LOG_SECTION("Pagein replaces and merges the tracked size");
+    CHECK(cfgpack_init(&ctx, &schema, values, 20, str_pool, sizeof(str_pool),
+                       str_offsets, 2) == CFGPACK_OK);
+    CHECK(cfgpack_size_cache_init(&ctx) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&ctx, 1, "before") == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, blob_len) == CFGPACK_OK);
+    size_t full_len = blob_len;
+    CHECK(cached_size_ok(&ctx, blob, sizeof(blob), &blob_len));
+    CHECK(blob_len == full_len);
+    CHECK(cfgpack_set_i64(&ctx, 3, -1) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_delta(&ctx, delta, delta_len) == CFGPACK_OK);
+    CHECK(cached_size_ok(&ctx, blob, sizeof(blob), &blob_len));
+    LOG("After pagein and delta merge: %zu bytes", blob_len);
+
+  #ifdef CFGPACK_PACKED_ARENA
+    LOG_SECTION("Packed storage truncation is re-measured");
+    static uint8_t arena[256];
+    cfgpack_value_t wide = {.type = CFGPACK_TYPE_U8, .v.u64 = 300};
+    CHECK(cfgpack_set(&ctx, 8, &wide) == CFGPACK_OK);
+    CHECK(cfgpack_packed_size(&schema) <= sizeof(arena));
+    CHECK(cfgpack_packed_init(&ctx, arena, sizeof(arena)) == CFGPACK_OK);
+    CHECK(cached_size_ok(&ctx, blob, sizeof(blob), &blob_len));
+    CHECK(cfgpack_set_u8(&ctx, 8, 255) == CFGPACK_OK);
+    CHECK(cached_size_ok(&ctx, blob, sizeof(blob), &blob_len));
+  #endif
+
+    return TEST_OK;
+}
+#endif /* CFGPACK_SIZE_CACHE */
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 18. Access by schema position: same results as by index, no lookup
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_access_at) {
+    LOG_SECTION("Get and set by position");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[3];
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t values[3];
+    cfgpack_value_t v = {CFGPACK_TYPE_U8, {0}};
+    char str_pool[128];
+    uint16_t str_offsets[2];
+    const char *s;
+    size_t len = 0;
+    uint8_t b = 0;
+
+    make_schema(&schema, entries, 3);
+    entries[0].index = 10;
+    entries[1].index = 20;
+    entries[1].type = CFGPACK_TYPE_STR;
+    entries[2].index = 30;
+    entries[2].type = CFGPACK_TYPE_FSTR;
+    entries[2].str_max = 4;
+    CHECK(cfgpack_init(&ctx, &schema, values, 3, str_pool, sizeof(str_pool),
+                       str_offsets, 2) == CFGPACK_OK);
+
+    v.v.u64 = 42;
+    CHECK(cfgpack_get_at(&ctx, 0, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_set_at(&ctx, 0, &v) == CFGPACK_OK);
+    CHECK(cfgpack_get_u8(&ctx, 10, &b) == CFGPACK_OK && b == 42);
+    CHECK(cfgpack_dirty_get(&ctx, 0));
+    CHECK(cfgpack_set_u8(&ctx, 10, 43) == CFGPACK_OK);
+    CHECK(cfgpack_get_at(&ctx, 0, &v) == CFGPACK_OK && v.v.u64 == 43);
+
+    LOG_SECTION("Strings of either type, with an explicit length");
+    CHECK(cfgpack_set_str_at(&ctx, 1, "gateway-2", 7) == CFGPACK_OK);
+    CHECK(cfgpack_get_str_view(&ctx, 20, &s, &len) == CFGPACK_OK);
+    CHECK(len == 7 && strcmp(s, "gateway") == 0);
+    CHECK(cfgpack_set_str_at(&ctx, 2, "eu-w", 4) == CFGPACK_OK);
+    CHECK(cfgpack_get_str_view_at(&ctx, 2, &s, &len) == CFGPACK_OK);
+    CHECK(len == 4 && memcmp(s, "eu-w", 4) == 0);
+    LOG("Position 1 holds '%s'", str_pool + str_offsets[0]);
+
+    LOG_SECTION("Error paths");
+    CHECK(cfgpack_set_str_at(&ctx, 2, "eu-west", 7) ==
+          CFGPACK_ERR_STR_TOO_LONG);
+    CHECK(cfgpack_set_str_at(&ctx, 0, "x", 1) == CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(cfgpack_set_at(&ctx, 1, &v) == CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(cfgpack_get_str_view_at(&ctx, 0, &s, &len) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(cfgpack_get_at(&ctx, 3, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_set_at(&ctx, 3, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_set_str_at(&ctx, 3, "x", 1) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_str_view_at(&ctx, 3, &s, &len) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_at(NULL, 0, &v) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_set_at(&ctx, 0, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_set_str_at(&ctx, 1, NULL, 0) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_get_str_view_at(&ctx, 1, NULL, &len) == CFGPACK_ERR_ARGS);
+
+    return TEST_OK;
+}
+
 int main(void) {
     test_result_t overall = TEST_OK;
 
@@ -419,6 +974,19 @@ int main(void) {
                 TEST_OK);
     overall |= (test_case_result("get_version", test_get_version()) != TEST_OK);
     overall |= (test_case_result("get_size", test_get_size()) != TEST_OK);
+    overall |= (test_case_result("name_index", test_name_index()) != TEST_OK);
+    overall |= (test_case_result("index_table", test_index_table()) != TEST_OK);
+#ifdef CFGPACK_PACKED_ARENA
+    overall |= (test_case_result("packed_values", test_packed_values()) !=
+                TEST_OK);
+#endif
+    overall |= (test_case_result("get_set_many", test_get_set_many()) !=
+                TEST_OK);
+    overall |= (test_case_result("str_view", test_str_view()) != TEST_OK);
+#ifdef CFGPACK_SIZE_CACHE
+    overall |= (test_case_result("size_cache", test_size_cache()) != TEST_OK);
+#endif
+    overall |= (test_case_result("access_at", test_access_at()) != TEST_OK);
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
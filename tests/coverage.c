@@ -26,6 +26,7 @@ static void make_schema(cfgpack_schema_t *schema,
         snprintf(entries[i].name, sizeof(entries[i].name), "e%zu", i);
         entries[i].type = CFGPACK_TYPE_U8;
         entries[i].has_default = 0;
+        entries[i].str_max = 0;
     }
 }
 
@@ -55,6 +56,7 @@ static cfgpack_err_t make_all_types_ctx(cfgpack_ctx_t *ctx,
         snprintf(entries[i].name, sizeof(entries[i].name), "t%zu", i);
         entries[i].type = types[i];
         entries[i].has_default = 0;
+        entries[i].str_max = 0;
     }
     return (cfgpack_init(ctx, schema, values, n, str_pool, str_pool_cap,
                          str_offsets, str_offsets_count));
@@ -0,0 +1,244 @@
+/* CRC-32C tests: known vectors, agreement with a bitwise reference across
+ * lengths and alignments, and the incremental/buffer/reader tracking APIs.
+ * Run under every backend via `make test-crc-backends`. */
+
+#include "cfgpack/msgpack.h"
+
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Helper: bit-at-a-time reference CRC-32C
+ * ═══════════════════════════════════════════════════════════════════════════ */
+static uint32_t ref_crc32c(const uint8_t *data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; ++b) {
+            crc = (crc >> 1) ^ ((crc & 1u) ? 0x82F63B78u : 0u);
+        }
+    }
+    return (~crc);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. RFC 3720 (iSCSI) B.4 test vectors
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_rfc3720_vectors) {
+    uint8_t buf[32];
+
+    LOG_SECTION("32 bytes of zeros");
+    memset(buf, 0x00, sizeof(buf));
+    CHECK(cfgpack_crc32c(buf, sizeof(buf)) == 0x8A9136AAu);
+
+    LOG_SECTION("32 bytes of 0xFF");
+    memset(buf, 0xFF, sizeof(buf));
+    CHECK(cfgpack_crc32c(buf, sizeof(buf)) == 0x62A8AB43u);
+
+    LOG_SECTION("32 incrementing bytes");
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+        buf[i] = (uint8_t)i;
+    }
+    CHECK(cfgpack_crc32c(buf, sizeof(buf)) == 0x46DD794Eu);
+
+    LOG_SECTION("32 decrementing bytes");
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+        buf[i] = (uint8_t)(31 - i);
+    }
+    CHECK(cfgpack_crc32c(buf, sizeof(buf)) == 0x113FDB5Cu);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Every length 0..300 at every start offset 0..7 matches the reference
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lengths_and_alignment) {
+    static uint8_t buf[320];
+    uint32_t seed = 0x12345678u;
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+        seed = seed * 1103515245u + 12345u;
+        buf[i] = (uint8_t)(seed >> 16);
+    }
+
+    for (size_t off = 0; off < 8; ++off) {
+        for (size_t len = 0; len <= 300; ++len) {
+            uint32_t want = ref_crc32c(buf + off, len);
+            uint32_t got = cfgpack_crc32c(buf + off, len);
+            if (got != want) {
+                LOG("off=%zu len=%zu got=0x%08X want=0x%08X", off, len, got,
+                    want);
+            }
+            CHECK(got == want);
+        }
+    }
+    LOG("2408 (offset, length) pairs match bitwise reference");
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. init/update/final over any split equals the one-shot CRC
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_incremental_split) {
+    static uint8_t buf[200];
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+        buf[i] = (uint8_t)(i * 7 + 3);
+    }
+    uint32_t want = cfgpack_crc32c(buf, sizeof(buf));
+
+    LOG_SECTION("Two-way split at every position");
+    for (size_t cut = 0; cut <= sizeof(buf); ++cut) {
+        uint32_t c = cfgpack_crc32c_init();
+        c = cfgpack_crc32c_update(c, buf, cut);
+        c = cfgpack_crc32c_update(c, buf + cut, sizeof(buf) - cut);
+        CHECK(cfgpack_crc32c_final(c) == want);
+    }
+
+    LOG_SECTION("Byte-at-a-time");
+    uint32_t c = cfgpack_crc32c_init();
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+        c = cfgpack_crc32c_update(c, &buf[i], 1);
+    }
+    CHECK(cfgpack_crc32c_final(c) == want);
+
+    LOG_SECTION("Empty update is a no-op");
+    c = cfgpack_crc32c_init();
+    CHECK(cfgpack_crc32c_update(c, NULL, 0) == c);
+    CHECK(cfgpack_crc32c_final(c) == cfgpack_crc32c(NULL, 0));
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. cfgpack_buf_t accumulates CRC while encoding
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_buf_crc_tracking) {
+    uint8_t storage[64];
+    cfgpack_buf_t buf;
+
+    cfgpack_buf_init(&buf, storage, sizeof(storage));
+    cfgpack_msgpack_encode_map_header(&buf, 2); /* before begin: excluded */
+    size_t start = buf.len;
+    cfgpack_buf_crc_begin(&buf);
+    CHECK(cfgpack_msgpack_encode_uint_key(&buf, 1) == CFGPACK_OK);
+    CHECK(cfgpack_msgpack_encode_str(&buf, "hello", 5) == CFGPACK_OK);
+    CHECK(cfgpack_msgpack_encode_f64(&buf, 3.5) == CFGPACK_OK);
+
+    LOG("Tracked %zu bytes", buf.len - start);
+    CHECK(cfgpack_buf_crc(&buf) ==
+          cfgpack_crc32c(storage + start, buf.len - start));
+
+    LOG_SECTION("Measure mode still tracks CRC");
+    cfgpack_buf_t m;
+    cfgpack_buf_init(&m, NULL, 0);
+    cfgpack_buf_crc_begin(&m);
+    cfgpack_msgpack_encode_uint_key(&m, 1);
+    cfgpack_msgpack_encode_str(&m, "hello", 5);
+    cfgpack_msgpack_encode_f64(&m, 3.5);
+    CHECK(m.len == buf.len - start);
+    CHECK(cfgpack_buf_crc(&m) == cfgpack_buf_crc(&buf));
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 5. cfgpack_reader_t checksums consumed bytes lazily
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_reader_crc_tracking) {
+    uint8_t storage[64];
+    cfgpack_buf_t buf;
+    cfgpack_reader_t r;
+    uint32_t count;
+    uint64_t key;
+    const uint8_t *s;
+    uint32_t slen;
+
+    cfgpack_buf_init(&buf, storage, sizeof(storage));
+    cfgpack_msgpack_encode_map_header(&buf, 1);
+    cfgpack_msgpack_encode_uint_key(&buf, 7);
+    cfgpack_msgpack_encode_str(&buf, "abc", 3);
+
+    cfgpack_reader_init(&r, storage, buf.len);
+    CHECK(cfgpack_msgpack_decode_map_header(&r, &count) == CFGPACK_OK);
+    cfgpack_reader_crc_begin(&r);
+    CHECK(cfgpack_msgpack_decode_uint64(&r, &key) == CFGPACK_OK);
+
+    LOG_SECTION("Partial sync after first value");
+    CHECK(cfgpack_reader_crc(&r) == cfgpack_crc32c(storage + 1, r.pos - 1));
+
+    CHECK(cfgpack_msgpack_decode_str(&r, &s, &slen) == CFGPACK_OK);
+    CHECK(r.pos == buf.len);
+
+    LOG_SECTION("Full sync after last value");
+    CHECK(cfgpack_reader_crc(&r) == cfgpack_crc32c(storage + 1, buf.len - 1));
+    CHECK(cfgpack_reader_crc(&r) == cfgpack_crc32c(storage + 1, buf.len - 1));
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 6. Zero-byte shift matches feeding zeros, patches and combines CRCs
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_crc_shift) {
+    static uint8_t zeros[1000];
+    static uint8_t msg[600];
+
+    LOG_SECTION("shift(crc, n) == update(crc, zeros, n)");
+    for (size_t n = 0; n <= sizeof(zeros); n += (n < 70 ? 1 : 131)) {
+        uint32_t c = 0x12345678u;
+        CHECK(cfgpack_crc32c_shift(c, n) ==
+              cfgpack_crc32c_update(c, zeros, n));
+        CHECK(cfgpack_crc32c_shift(0, n) == 0);
+    }
+
+    LOG_SECTION("Changing bytes mid-message via the XOR delta");
+    for (size_t i = 0; i < sizeof(msg); ++i) {
+        msg[i] = (uint8_t)(i * 13 + 1);
+    }
+    uint32_t before = cfgpack_crc32c(msg, sizeof(msg));
+    uint8_t delta[3] = {0x5a, 0x00, 0xff};
+    size_t at = 217;
+    for (size_t i = 0; i < sizeof(delta); ++i) {
+        msg[at + i] ^= delta[i];
+    }
+    uint32_t d = cfgpack_crc32c_update(0, delta, sizeof(delta));
+    d = cfgpack_crc32c_shift(d, sizeof(msg) - at - sizeof(delta));
+    CHECK((before ^ d) == cfgpack_crc32c(msg, sizeof(msg)));
+    LOG("Patched CRC 0x%08x matches a full recompute", (unsigned)(before ^ d));
+
+    LOG_SECTION("combine(crc(a), crc(b), len(b)) == crc(a || b)");
+    for (size_t at = 0; at <= sizeof(msg); at += 37) {
+        uint32_t a = cfgpack_crc32c(msg, at);
+        uint32_t b = cfgpack_crc32c(msg + at, sizeof(msg) - at);
+        CHECK(cfgpack_crc32c_combine(a, b, sizeof(msg) - at) ==
+              cfgpack_crc32c(msg, sizeof(msg)));
+    }
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("rfc3720_vectors", test_rfc3720_vectors()) !=
+                TEST_OK);
+    overall |= (test_case_result("lengths_and_alignment",
+                                 test_lengths_and_alignment()) != TEST_OK);
+    overall |= (test_case_result("incremental_split",
+                                 test_incremental_split()) != TEST_OK);
+    overall |= (test_case_result("buf_crc_tracking",
+                                 test_buf_crc_tracking()) != TEST_OK);
+    overall |= (test_case_result("reader_crc_tracking",
+                                 test_reader_crc_tracking()) != TEST_OK);
+    overall |= (test_case_result("crc_shift", test_crc_shift()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
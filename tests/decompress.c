@@ -7,6 +7,7 @@
  */
 
 #include "cfgpack/cfgpack.h"
+#include "cfgpack/decompress.h"
 #include "cfgpack/msgpack.h"
 
 #include "test.h"
@@ -125,6 +126,55 @@ static int compress_with_lz4(const uint8_t *input,
     return 0;
 }
 
+/**
+ * @brief Compress data as a block-framed LZ4 stream (as cfgpack-compress
+ *        lz4-stream does, with a chosen block and ring size).
+ */
+static int compress_with_lz4_stream(const uint8_t *input,
+                                    size_t input_len,
+                                    size_t block,
+                                    size_t ring_size,
+                                    uint8_t *output,
+                                    size_t output_cap,
+                                    size_t *output_len) {
+    static uint8_t ring[CFGPACK_LZ4S_RING_MAX];
+    LZ4_stream_t lz;
+    size_t out = CFGPACK_LZ4S_HDR_SIZE;
+    size_t in = 0;
+    size_t at = 0;
+
+    LZ4_initStream(&lz, sizeof(lz));
+    for (size_t i = 0; i < 4; ++i) {
+        output[i] = (uint8_t)(input_len >> (8 * i));
+        output[6 + i] = (uint8_t)(ring_size >> (8 * i));
+    }
+    output[4] = (uint8_t)block;
+    output[5] = (uint8_t)(block >> 8);
+
+    while (in < input_len) {
+        size_t n = input_len - in < block ? input_len - in : block;
+        int c;
+
+        memcpy(ring + at, input + in, n);
+        c = LZ4_compress_fast_continue(&lz, (const char *)ring + at,
+                                       (char *)output + out + 2, (int)n,
+                                       (int)(output_cap - out - 2), 1);
+        if (c <= 0) {
+            return -1;
+        }
+        output[out] = (uint8_t)c;
+        output[out + 1] = (uint8_t)(c >> 8);
+        out += 2 + (size_t)c;
+        in += n;
+        at += n;
+        if (at + block > ring_size) {
+            at = 0;
+        }
+    }
+    *output_len = out;
+    return 0;
+}
+
 /**
  * @brief Compress data with heatshrink.
  */
@@ -197,6 +247,7 @@ static void setup_large_test_context(cfgpack_schema_t *schema,
                                      size_t str_pool_cap,
                                      uint16_t *str_offsets,
                                      size_t str_offsets_count) {
+    memset(entries, 0, 15 * sizeof(*entries));
     snprintf(schema->map_name, sizeof(schema->map_name), "demo");
     schema->version = 1;
     schema->entry_count = 15;
@@ -296,6 +347,7 @@ static void setup_minimal_test_context(cfgpack_schema_t *schema,
                                        size_t str_pool_cap,
                                        uint16_t *str_offsets,
                                        size_t str_offsets_count) {
+    memset(entries, 0, 2 * sizeof(*entries));
     snprintf(schema->map_name, sizeof(schema->map_name), "test");
     schema->version = 1;
     schema->entry_count = 2;
@@ -493,6 +545,206 @@ TEST_CASE(test_lz4_corrupted_data) {
     return TEST_OK;
 }
 
+TEST_CASE(test_lz4_stream_basic) {
+    LOG_SECTION("Block-framed LZ4 stream through a small ring");
+
+    static const size_t shapes[][2] = {{64, 128}, {16, 40}, {1024, 4096}};
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[15];
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t values[15];
+    char str_pool[512];
+    uint16_t str_offsets[5];
+    uint8_t ring[4096];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    size_t msgpack_len, compressed_len;
+    cfgpack_value_t v;
+    const char *str_out;
+    uint16_t str_len;
+
+    msgpack_len = create_large_test_msgpack(msgpack_buf, BUF_SIZE);
+    test_append_crc(msgpack_buf, &msgpack_len);
+    LOG("Original size: %zu bytes (incl. CRC)", msgpack_len);
+
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i) {
+        size_t block = shapes[i][0];
+        size_t ring_size = shapes[i][1];
+
+        CHECK(compress_with_lz4_stream(msgpack_buf, msgpack_len, block,
+                                       ring_size, compressed_buf, BUF_SIZE,
+                                       &compressed_len) == 0);
+        LOG("block %zu, ring %zu: %zu -> %zu bytes", block, ring_size,
+            msgpack_len, compressed_len);
+
+        memset(values, 0, sizeof(values));
+        memset(str_pool, 0, sizeof(str_pool));
+        setup_large_test_context(&schema, entries, &ctx, values, str_pool,
+                                 sizeof(str_pool), str_offsets, 5);
+        CHECK(cfgpack_pagein_lz4_stream(&ctx, compressed_buf, compressed_len,
+                                        ring, ring_size, window,
+                                        sizeof(window)) == CFGPACK_OK);
+        CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_OK && v.v.u64 == 255);
+        CHECK(cfgpack_get(&ctx, 8, &v) == CFGPACK_OK &&
+              v.v.i64 == -9999999);
+        CHECK(cfgpack_get_str(&ctx, 12, &str_out, &str_len) == CFGPACK_OK &&
+              str_len == 43);
+        CHECK(cfgpack_get_str(&ctx, 15, &str_out, &str_len) == CFGPACK_OK &&
+              str_len == 59);
+    }
+    LOG("Peak buffers: ring + %zu byte window", sizeof(window));
+
+    LOG("Test completed successfully");
+    return TEST_OK;
+}
+
+TEST_CASE(test_lz4_stream_errors) {
+    LOG_SECTION("Block-framed LZ4 stream error handling");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[15];
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t values[15];
+    char str_pool[512];
+    uint16_t str_offsets[5];
+    uint8_t ring[256];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    uint8_t bad[BUF_SIZE];
+    size_t msgpack_len, len;
+
+    msgpack_len = create_large_test_msgpack(msgpack_buf, BUF_SIZE);
+    test_append_crc(msgpack_buf, &msgpack_len);
+    CHECK(compress_with_lz4_stream(msgpack_buf, msgpack_len, 64, 128,
+                                   compressed_buf, BUF_SIZE, &len) == 0);
+    setup_large_test_context(&schema, entries, &ctx, values, str_pool,
+                             sizeof(str_pool), str_offsets, 5);
+
+    CHECK(cfgpack_pagein_lz4_stream(NULL, compressed_buf, len, ring,
+                                    sizeof(ring), window, sizeof(window)) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_pagein_lz4_stream(&ctx, compressed_buf, len, NULL,
+                                    sizeof(ring), window, sizeof(window)) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_pagein_lz4_stream(&ctx, compressed_buf, 9, ring,
+                                    sizeof(ring), window, sizeof(window)) ==
+          CFGPACK_ERR_DECODE);
+    LOG("NULL arguments and short header: ERR_DECODE");
+
+    CHECK(cfgpack_pagein_lz4_stream(&ctx, compressed_buf, len, ring, 127,
+                                    window, sizeof(window)) ==
+          CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_pagein_lz4_stream(&ctx, compressed_buf, len, ring,
+                                    sizeof(ring), window,
+                                    sizeof(window) - 1) == CFGPACK_ERR_BOUNDS);
+    LOG("Ring below the stream's ring size or small window: ERR_BOUNDS");
+
+    /* Block size below the minimum, ring smaller than a block */
+    memcpy(bad, compressed_buf, len);
+    bad[4] = 8;
+    CHECK(cfgpack_pagein_lz4_stream(&ctx, bad, len, ring, sizeof(ring),
+                                    window, sizeof(window)) ==
+          CFGPACK_ERR_DECODE);
+    memcpy(bad, compressed_buf, len);
+    bad[6] = 32;
+    CHECK(cfgpack_pagein_lz4_stream(&ctx, bad, len, ring, sizeof(ring),
+                                    window, sizeof(window)) ==
+          CFGPACK_ERR_DECODE);
+
+    /* Truncated stream and trailing bytes */
+    CHECK(cfgpack_pagein_lz4_stream(&ctx, compressed_buf, len - 1, ring,
+                                    sizeof(ring), window, sizeof(window)) ==
+          CFGPACK_ERR_DECODE);
+    memcpy(bad, compressed_buf, len);
+    bad[len] = 0;
+    CHECK(cfgpack_pagein_lz4_stream(&ctx, bad, len + 1, ring, sizeof(ring),
+                                    window, sizeof(window)) ==
+          CFGPACK_ERR_DECODE);
+
+    /* Decompressed size larger than the blocks hold */
+    memcpy(bad, compressed_buf, len);
+    bad[0] = (uint8_t)(bad[0] + 1);
+    CHECK(cfgpack_pagein_lz4_stream(&ctx, bad, len, ring, sizeof(ring),
+                                    window, sizeof(window)) ==
+          CFGPACK_ERR_DECODE);
+    LOG("Malformed streams: ERR_DECODE");
+
+    LOG("Test completed successfully");
+    return TEST_OK;
+}
+
+TEST_CASE(test_lz4_stream_schema) {
+    LOG_SECTION("Msgpack schema parsed straight from an LZ4 stream");
+
+    cfgpack_schema_t schema, schema2;
+    cfgpack_entry_t entries[15], entries2[15];
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t values[15], values2[15];
+    char str_pool[512], str_pool2[512];
+    uint16_t str_offsets[5], str_offsets2[5];
+    uint8_t ring[40];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    cfgpack_schema_measure_t m, m2;
+    cfgpack_parse_error_t perr;
+    size_t msgpack_len, schema_len, len;
+
+    /* Current values become the schema's defaults */
+    msgpack_len = create_large_test_msgpack(msgpack_buf, BUF_SIZE);
+    test_append_crc(msgpack_buf, &msgpack_len);
+    setup_large_test_context(&schema, entries, &ctx, values, str_pool,
+                             sizeof(str_pool), str_offsets, 5);
+    CHECK(cfgpack_pagein_buf(&ctx, msgpack_buf, msgpack_len) == CFGPACK_OK);
+    for (size_t i = 0; i < 15; ++i) {
+        entries[i].has_default = 1;
+    }
+    CHECK(cfgpack_schema_write_msgpack(&ctx, scratch_buf, BUF_SIZE,
+                                       &schema_len, &perr) == CFGPACK_OK);
+    CHECK(compress_with_lz4_stream(scratch_buf, schema_len, 16, 40,
+                                   compressed_buf, BUF_SIZE, &len) == 0);
+    LOG("Schema %zu -> %zu bytes, ring %zu + window %zu", schema_len, len,
+        sizeof(ring), sizeof(window));
+
+    CHECK(cfgpack_schema_measure_msgpack(scratch_buf, schema_len, &m, &perr) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_schema_measure_msgpack_lz4(compressed_buf, len, ring,
+                                             sizeof(ring), window,
+                                             sizeof(window), &m2,
+                                             &perr) == CFGPACK_OK);
+    CHECK(memcmp(&m, &m2, sizeof(m)) == 0);
+
+    cfgpack_parse_opts_t flat = {&schema,     entries,  15,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 5,        &perr};
+    cfgpack_parse_opts_t opts = {&schema2,     entries2,  15,
+                                 values2,      str_pool2, sizeof(str_pool2),
+                                 str_offsets2, 5,         &perr};
+    CHECK(cfgpack_schema_parse_msgpack(scratch_buf, schema_len, &flat) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_schema_parse_msgpack_lz4(compressed_buf, len, ring,
+                                           sizeof(ring), window,
+                                           sizeof(window),
+                                           &opts) == CFGPACK_OK);
+    CHECK(schema2.entry_count == 15);
+    CHECK(memcmp(entries, entries2, sizeof(entries)) == 0);
+    CHECK(memcmp(values, values2, sizeof(values)) == 0);
+    CHECK(memcmp(str_pool, str_pool2, sizeof(str_pool)) == 0);
+    LOG("Same schema and defaults as parsing the decompressed copy");
+
+    CHECK(cfgpack_schema_parse_msgpack_lz4(NULL, len, ring, sizeof(ring),
+                                           window, sizeof(window), &opts) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_schema_parse_msgpack_lz4(compressed_buf, len, ring,
+                                           sizeof(ring) - 1, window,
+                                           sizeof(window),
+                                           &opts) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_schema_parse_msgpack_lz4(compressed_buf, len - 1, ring,
+                                           sizeof(ring), window,
+                                           sizeof(window),
+                                           &opts) == CFGPACK_ERR_DECODE);
+    LOG("NULL: ERR_ARGS, small ring: ERR_BOUNDS, truncated: ERR_DECODE");
+
+    LOG("Test completed successfully");
+    return TEST_OK;
+}
+
 TEST_CASE(test_heatshrink_basic) {
     LOG_SECTION(
         "Heatshrink compression/decompression roundtrip (large dataset)");
@@ -647,6 +899,70 @@ TEST_CASE(test_heatshrink_empty_input) {
     return TEST_OK;
 }
 
+TEST_CASE(test_heatshrink_caller_state) {
+    LOG_SECTION("Heatshrink pagein with caller-owned decoders");
+
+    static heatshrink_decoder dec_a, dec_b;
+    cfgpack_schema_t schema_a, schema_b;
+    cfgpack_entry_t entries_a[15], entries_b[15];
+    cfgpack_ctx_t ctx_a, ctx_b;
+    cfgpack_value_t values_a[15], values_b[15];
+    char str_pool_a[512], str_pool_b[512];
+    uint16_t str_offsets_a[5], str_offsets_b[5];
+    size_t msgpack_len, compressed_len;
+    const char *str_out;
+    uint16_t str_len;
+    cfgpack_value_t v;
+
+    msgpack_len = create_large_test_msgpack(msgpack_buf, BUF_SIZE);
+    test_append_crc(msgpack_buf, &msgpack_len);
+    CHECK(compress_with_heatshrink(msgpack_buf, msgpack_len, compressed_buf,
+                                   BUF_SIZE, &compressed_len) == 0);
+    setup_large_test_context(&schema_a, entries_a, &ctx_a, values_a,
+                             str_pool_a, sizeof(str_pool_a), str_offsets_a, 5);
+    setup_large_test_context(&schema_b, entries_b, &ctx_b, values_b,
+                             str_pool_b, sizeof(str_pool_b), str_offsets_b, 5);
+
+    LOG("NULL decoder rejected");
+    CHECK(cfgpack_pagein_heatshrink_r(&ctx_a, compressed_buf, compressed_len,
+                                      NULL, scratch_buf,
+                                      BUF_SIZE) == CFGPACK_ERR_DECODE);
+
+    /* A truncated stream leaves dec_a mid-decode; the next call resets it */
+    LOG("Truncated input fails, then the same decoder is reused");
+    CHECK(cfgpack_pagein_heatshrink_r(&ctx_a, compressed_buf,
+                                      compressed_len / 2, &dec_a, scratch_buf,
+                                      BUF_SIZE) != CFGPACK_OK);
+    CHECK(cfgpack_pagein_heatshrink_r(&ctx_a, compressed_buf, compressed_len,
+                                      &dec_a, scratch_buf,
+                                      BUF_SIZE) == CFGPACK_OK);
+
+    LOG("Second context decoded through its own decoder");
+    CHECK(cfgpack_pagein_heatshrink_r(&ctx_b, compressed_buf, compressed_len,
+                                      &dec_b, decompress_scratch,
+                                      BUF_SIZE) == CFGPACK_OK);
+
+    LOG("Scratch of exactly the decoded size fits; one byte less does not");
+    CHECK(cfgpack_pagein_heatshrink_r(&ctx_b, compressed_buf, compressed_len,
+                                      &dec_b, decompress_scratch,
+                                      msgpack_len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_heatshrink_r(&ctx_b, compressed_buf, compressed_len,
+                                      &dec_b, decompress_scratch,
+                                      msgpack_len - 1) == CFGPACK_ERR_BOUNDS);
+
+    CHECK(cfgpack_get(&ctx_a, 1, &v) == CFGPACK_OK && v.v.u64 == 255);
+    CHECK(cfgpack_get(&ctx_b, 4, &v) == CFGPACK_OK && v.v.u64 == 9999999);
+    CHECK(cfgpack_get_str(&ctx_a, 15, &str_out, &str_len) == CFGPACK_OK &&
+          str_len == 59);
+    CHECK(cfgpack_get_str(&ctx_b, 11, &str_out, &str_len) == CFGPACK_OK &&
+          str_len == 41);
+    LOG("Both contexts loaded (decoder %zu bytes each)",
+        sizeof(heatshrink_decoder));
+
+    LOG("Test completed successfully");
+    return TEST_OK;
+}
+
 TEST_CASE(test_roundtrip_both_algorithms) {
     LOG_SECTION("Roundtrip comparison: LZ4 vs Heatshrink (large dataset)");
 
@@ -732,12 +1048,20 @@ int main(void) {
                                  test_lz4_size_too_large()) != TEST_OK);
     overall |= (test_case_result("lz4_corrupted_data",
                                  test_lz4_corrupted_data()) != TEST_OK);
+    overall |= (test_case_result("lz4_stream_basic", test_lz4_stream_basic()) !=
+                TEST_OK);
+    overall |= (test_case_result("lz4_stream_errors",
+                                 test_lz4_stream_errors()) != TEST_OK);
+    overall |= (test_case_result("lz4_stream_schema",
+                                 test_lz4_stream_schema()) != TEST_OK);
     overall |= (test_case_result("heatshrink_basic", test_heatshrink_basic()) !=
                 TEST_OK);
     overall |= (test_case_result("heatshrink_null_args",
                                  test_heatshrink_null_args()) != TEST_OK);
     overall |= (test_case_result("heatshrink_empty_input",
                                  test_heatshrink_empty_input()) != TEST_OK);
+    overall |= (test_case_result("heatshrink_caller_state",
+                                 test_heatshrink_caller_state()) != TEST_OK);
     overall |= (test_case_result("roundtrip_both_algorithms",
                                  test_roundtrip_both_algorithms()) != TEST_OK);
 
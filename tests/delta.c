@@ -0,0 +1,184 @@
+/* Dirty tracking and delta pageout/pagein tests: setters mark entries dirty,
+ * successful pageouts clear them, and full + delta blobs replay the state. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 8
+
+static cfgpack_type_t delta_type(size_t i) {
+    return (i == N_ENTRIES - 1 ? CFGPACK_TYPE_STR : CFGPACK_TYPE_U16);
+}
+
+/* u16 x 7 (index 1..7) + str (index 8); entry 1 has a default. */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    fixture_schema(f, "delta", N_ENTRIES, delta_type);
+    f->entries[0].has_default = 1;
+    f->values[0].type = CFGPACK_TYPE_U16;
+    f->values[0].v.u64 = 5;
+    return (fixture_init(f));
+}
+
+static uint16_t get_u16(const cfgpack_ctx_t *ctx, uint16_t index) {
+    uint16_t v = 0;
+    cfgpack_get_u16(ctx, index, &v);
+    return (v);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Setters mark dirty, pageout clears
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_dirty_tracking) {
+    static fixture_t f;
+    uint8_t out[128];
+    size_t len = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    LOG_SECTION("Fresh context is clean (defaults are not dirty)");
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+
+    LOG_SECTION("Each setter marks its entry");
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 100) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 8, "hi") == CFGPACK_OK);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 2);
+    CHECK(cfgpack_dirty_get(&f.ctx, 1));
+    CHECK(cfgpack_dirty_get(&f.ctx, 7));
+    CHECK(!cfgpack_dirty_get(&f.ctx, 0));
+
+    LOG_SECTION("Failed pageout keeps dirty bits");
+    CHECK(cfgpack_pageout(&f.ctx, out, 12, &len) == CFGPACK_ERR_ENCODE);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 2);
+    CHECK(cfgpack_pageout_delta(&f.ctx, out, 12, &len) == CFGPACK_ERR_ENCODE);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 2);
+
+    LOG_SECTION("Successful pageout clears them");
+    CHECK(cfgpack_pageout(&f.ctx, out, sizeof(out), &len) == CFGPACK_OK);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+    LOG("Full blob %zu bytes, dirty count now 0", len);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Delta holds only changed entries and replays onto the full blob
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_delta_replay) {
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t full[128];
+    uint8_t delta[128];
+    size_t full_len = 0;
+    size_t delta_len = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    for (uint16_t i = 2; i <= 7; ++i) {
+        CHECK(cfgpack_set_u16(&f.ctx, i, (uint16_t)(1000 + i)) == CFGPACK_OK);
+    }
+    CHECK(cfgpack_set_str(&f.ctx, 8, "threshold table") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, full, sizeof(full), &full_len) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("One threshold changes");
+    CHECK(cfgpack_set_u16(&f.ctx, 4, 4444) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_delta(&f.ctx, delta, sizeof(delta), &delta_len) ==
+          CFGPACK_OK);
+    LOG("Full %zu bytes, delta %zu bytes", full_len, delta_len);
+    CHECK(delta_len < full_len);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+
+    LOG_SECTION("Delta alone is a valid blob with only key 4");
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&g.ctx, delta, delta_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&g.ctx) == 2); /* key 4 + default of key 1 */
+    CHECK(get_u16(&g.ctx, 4) == 4444);
+
+    LOG_SECTION("Full then delta reproduces the live state");
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&g.ctx, full, full_len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_delta(&g.ctx, delta, delta_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&g.ctx) == cfgpack_get_size(&f.ctx));
+    for (uint16_t i = 1; i <= 7; ++i) {
+        CHECK(get_u16(&g.ctx, i) == get_u16(&f.ctx, i));
+    }
+    CHECK(cfgpack_get_dirty_count(&g.ctx) == 0);
+
+    LOG_SECTION("Nothing dirty: delta is just the name");
+    CHECK(cfgpack_pageout_delta(&f.ctx, delta, sizeof(delta), &delta_len) ==
+          CFGPACK_OK);
+    LOG("Empty delta %zu bytes", delta_len);
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_delta(&g.ctx, delta, delta_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&g.ctx) == 1);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Pagein resets dirty state; corrupt delta changes nothing
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_delta_pagein_dirty_and_crc) {
+    static fixture_t f;
+    uint8_t full[128];
+    uint8_t delta[128];
+    size_t full_len = 0;
+    size_t delta_len = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 22) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, full, sizeof(full), &full_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 3, 33) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_delta(&f.ctx, delta, sizeof(delta), &delta_len) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Full pagein clears every dirty bit");
+    CHECK(cfgpack_set_u16(&f.ctx, 5, 55) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, full, full_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+
+    LOG_SECTION("Delta pagein clears only decoded entries");
+    CHECK(cfgpack_set_u16(&f.ctx, 3, 1) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 6, 66) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_delta(&f.ctx, delta, delta_len) == CFGPACK_OK);
+    CHECK(get_u16(&f.ctx, 3) == 33);
+    CHECK(!cfgpack_dirty_get(&f.ctx, 2));
+    CHECK(cfgpack_dirty_get(&f.ctx, 5));
+    CHECK(get_u16(&f.ctx, 6) == 66);
+
+    LOG_SECTION("Corrupt delta is rejected before any change");
+    delta[delta_len - 6] ^= 0x10;
+    CHECK(cfgpack_set_u16(&f.ctx, 3, 7) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_delta(&f.ctx, delta, delta_len) == CFGPACK_ERR_CRC);
+    CHECK(get_u16(&f.ctx, 3) == 7);
+    CHECK(cfgpack_pagein_delta(NULL, delta, delta_len) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_delta(&f.ctx, delta, 2) == CFGPACK_ERR_DECODE);
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("dirty_tracking", test_dirty_tracking()) !=
+                TEST_OK);
+    overall |= (test_case_result("delta_replay", test_delta_replay()) !=
+                TEST_OK);
+    overall |= (test_case_result("delta_pagein_dirty_and_crc",
+                                 test_delta_pagein_dirty_and_crc()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
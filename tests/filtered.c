@@ -0,0 +1,228 @@
+/* Filtered pagein tests: only selected entries are loaded, the others are
+ * skipped and keep their state, and two complementary passes equal one
+ * full pagein. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 8
+
+/* u16 at index 10..16 + str at index 20; index 10 has a default of 5. */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    fixture_schema(f, "boot", N_ENTRIES, NULL);
+    for (size_t i = 0; i < N_ENTRIES; ++i) {
+        f->entries[i].index = (uint16_t)(10 + i);
+        f->entries[i].type = CFGPACK_TYPE_U16;
+    }
+    f->entries[N_ENTRIES - 1].index = 20;
+    f->entries[N_ENTRIES - 1].type = CFGPACK_TYPE_STR;
+    f->entries[0].has_default = 1;
+    f->values[0].type = CFGPACK_TYPE_U16;
+    f->values[0].v.u64 = 5;
+    return (fixture_init(f));
+}
+
+static uint16_t get_u16(const cfgpack_ctx_t *ctx, uint16_t index) {
+    uint16_t v = 0;
+    cfgpack_get_u16(ctx, index, &v);
+    return (v);
+}
+
+/* Blob with index 11..16 = 1011..1016 and a string; index 10 is absent,
+ * so its default applies on pagein. */
+static size_t make_blob(uint8_t *out, size_t cap) {
+    static fixture_t f;
+    size_t len = 0;
+
+    make_fixture(&f);
+    cfgpack_presence_clear(&f.ctx, 0);
+    for (uint16_t i = 11; i <= 16; ++i) {
+        cfgpack_set_u16(&f.ctx, i, (uint16_t)(1000 + i));
+    }
+    cfgpack_set_str(&f.ctx, 20, "a long calibration string");
+    cfgpack_pageout(&f.ctx, out, cap, &len);
+    return (len);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Only selected entries are loaded
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_filtered_subset) {
+    static fixture_t f;
+    cfgpack_index_range_t early[] = {{12, 13}, {16, 16}};
+    uint8_t select[CFGPACK_PRESENCE_BYTES];
+    uint8_t blob[128];
+    size_t len = make_blob(blob, sizeof(blob));
+    const char *s;
+    uint16_t slen;
+
+    CHECK(len > 0);
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 11, 77) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 12, 78) == CFGPACK_OK);
+
+    LOG_SECTION("Ranges become a bitmap over schema positions");
+    CHECK(cfgpack_select_ranges(&f.ctx, early, 2, select, sizeof(select)) ==
+          CFGPACK_OK);
+    CHECK(select[0] == 0x4c); /* positions 2, 3 and 6 */
+    CHECK(select[1] == 0);
+
+    LOG_SECTION("Selected entries come from the blob");
+    CHECK(cfgpack_pagein_filtered(&f.ctx, blob, len, select) == CFGPACK_OK);
+    CHECK(get_u16(&f.ctx, 12) == 1012);
+    CHECK(get_u16(&f.ctx, 13) == 1013);
+    CHECK(get_u16(&f.ctx, 16) == 1016);
+    CHECK(!cfgpack_dirty_get(&f.ctx, 2));
+
+    LOG_SECTION("The others keep their value, presence and dirty bit");
+    CHECK(get_u16(&f.ctx, 11) == 77);
+    CHECK(cfgpack_dirty_get(&f.ctx, 0) == 0);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 1); /* index 11 */
+    CHECK(get_u16(&f.ctx, 10) == 5);
+    CHECK(get_u16(&f.ctx, 14) == 0);
+    CHECK(cfgpack_get_str(&f.ctx, 20, &s, &slen) != CFGPACK_OK);
+    CHECK(f.str_pool[0] == '\0');
+    CHECK(cfgpack_get_size(&f.ctx) == 5);
+    LOG("Loaded 3 of %d entries", N_ENTRIES);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Two complementary passes equal one full pagein
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_filtered_staged) {
+    static fixture_t f;
+    static fixture_t g;
+    cfgpack_index_range_t early[] = {{10, 11}};
+    uint8_t select[CFGPACK_PRESENCE_BYTES];
+    uint8_t blob[128];
+    uint8_t a[128];
+    uint8_t b[128];
+    size_t len = make_blob(blob, sizeof(blob));
+    size_t a_len = 0;
+    size_t b_len = 0;
+    size_t need = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+#ifdef CFGPACK_SIZE_CACHE
+    CHECK(cfgpack_size_cache_init(&f.ctx) == CFGPACK_OK);
+#endif
+    CHECK(cfgpack_set_u16(&f.ctx, 14, 1) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 20, "stale") == CFGPACK_OK);
+
+    LOG_SECTION("Early pass: the default of index 10 and index 11");
+    CHECK(cfgpack_select_ranges(&f.ctx, early, 1, select, sizeof(select)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pagein_filtered(&f.ctx, blob, len, select) == CFGPACK_OK);
+    CHECK(get_u16(&f.ctx, 10) == 5);
+    CHECK(get_u16(&f.ctx, 11) == 1011);
+    CHECK(get_u16(&f.ctx, 14) == 1);
+
+    LOG_SECTION("Late pass with the complement");
+    for (size_t i = 0; i < sizeof(select); ++i) {
+        select[i] = (uint8_t)~select[i];
+    }
+    CHECK(cfgpack_pagein_filtered(&f.ctx, blob, len, select) == CFGPACK_OK);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+
+    LOG_SECTION("Same state, and the size cache still agrees");
+    CHECK(cfgpack_pagein_buf(&g.ctx, blob, len) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&f.ctx) == cfgpack_get_size(&g.ctx));
+    CHECK(cfgpack_pageout(&f.ctx, a, sizeof(a), &a_len) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&g.ctx, b, sizeof(b), &b_len) == CFGPACK_OK);
+    CHECK(a_len == b_len && memcmp(a, b, a_len) == 0);
+    CHECK(cfgpack_pageout_measure(&f.ctx, &need) == CFGPACK_OK);
+    CHECK(need == a_len);
+    LOG("Both blobs %zu bytes", a_len);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Errors leave the context alone
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_filtered_errors) {
+    static fixture_t f;
+    cfgpack_index_range_t all[] = {{0, UINT16_MAX}};
+    uint8_t select[CFGPACK_PRESENCE_BYTES];
+    uint8_t blob[128];
+    size_t len = make_blob(blob, sizeof(blob));
+#ifdef CFGPACK_PACKED_WIRE
+    uint8_t packed[128];
+    size_t packed_len = 0;
+#endif
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 12, 42) == CFGPACK_OK);
+
+    LOG_SECTION("Arguments");
+    CHECK(cfgpack_select_ranges(NULL, all, 1, select, sizeof(select)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_select_ranges(&f.ctx, NULL, 1, select, sizeof(select)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_select_ranges(&f.ctx, all, 1, select, 0) ==
+          CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_pagein_filtered(NULL, blob, len, select) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_filtered(&f.ctx, blob, len, NULL) ==
+          CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("An empty list selects nothing");
+    CHECK(cfgpack_select_ranges(&f.ctx, NULL, 0, select, sizeof(select)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pagein_filtered(&f.ctx, blob, len, select) == CFGPACK_OK);
+    CHECK(get_u16(&f.ctx, 12) == 42);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 1);
+
+    LOG_SECTION("Bad CRC and packed blobs are refused");
+    CHECK(cfgpack_select_ranges(&f.ctx, all, 1, select, sizeof(select)) ==
+          CFGPACK_OK);
+    blob[3] ^= 0x01;
+    CHECK(cfgpack_pagein_filtered(&f.ctx, blob, len, select) ==
+          CFGPACK_ERR_CRC);
+    blob[3] ^= 0x01;
+#ifdef CFGPACK_PACKED_WIRE
+    CHECK(cfgpack_pageout_packed(&f.ctx, packed, sizeof(packed),
+                                 &packed_len) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 12, 43) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_filtered(&f.ctx, packed, packed_len, select) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(get_u16(&f.ctx, 12) == 43);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 1);
+#endif
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    overall |= (test_case_result("filtered_subset", test_filtered_subset()) !=
+                TEST_OK);
+    overall |= (test_case_result("filtered_staged", test_filtered_staged()) !=
+                TEST_OK);
+    overall |= (test_case_result("filtered_errors", test_filtered_errors()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
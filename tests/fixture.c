@@ -0,0 +1,128 @@
+#include "fixture.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void fixture_schema(fixture_t *f,
+                    const char *name,
+                    size_t n,
+                    fixture_type_fn type_of) {
+    memset(f, 0, sizeof(*f));
+    snprintf(f->schema.map_name, sizeof(f->schema.map_name), "%s", name);
+    f->schema.version = 1;
+    f->schema.entry_count = n;
+    f->schema.entries = f->entries;
+    for (size_t i = 0; i < n; ++i) {
+        f->entries[i].index = (uint16_t)(i + 1);
+        snprintf(f->entries[i].name, sizeof(f->entries[i].name), "e%zu", i);
+        f->entries[i].type = type_of ? type_of(i) : CFGPACK_TYPE_U32;
+    }
+}
+
+cfgpack_err_t fixture_init(fixture_t *f) {
+    return (cfgpack_init(&f->ctx, &f->schema, f->values, FIXTURE_ENTRIES,
+                         f->str_pool, sizeof(f->str_pool), f->str_offsets,
+                         FIXTURE_STRS));
+}
+
+cfgpack_err_t fixture_make(fixture_t *f,
+                           const char *name,
+                           size_t n,
+                           fixture_type_fn type_of) {
+    fixture_schema(f, name, n, type_of);
+    return (fixture_init(f));
+}
+
+cfgpack_err_t fixture_parse(fixture_t *f, const char *map) {
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts = {&f->schema,     f->entries,
+                                 FIXTURE_ENTRIES, f->values,
+                                 f->str_pool,    sizeof(f->str_pool),
+                                 f->str_offsets, FIXTURE_STRS,
+                                 &perr};
+    cfgpack_err_t rc;
+
+    memset(f, 0, sizeof(*f));
+    rc = cfgpack_parse_schema(map, strlen(map), &opts);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (fixture_init(f));
+}
+
+/* The value fixture_fill() gives entry @p i, as @p e's type */
+static void fill_value(const cfgpack_entry_t *e,
+                       size_t i,
+                       uint32_t base,
+                       uint32_t step,
+                       cfgpack_value_t *v) {
+    uint64_t n = (uint64_t)base + (uint64_t)step * (i + 1);
+
+    v->type = e->type;
+    switch (e->type) {
+    case CFGPACK_TYPE_I8:
+    case CFGPACK_TYPE_I16:
+    case CFGPACK_TYPE_I32:
+    case CFGPACK_TYPE_I64: v->v.i64 = -(int64_t)n; break;
+    case CFGPACK_TYPE_F32: v->v.f32 = (float)n; break;
+    case CFGPACK_TYPE_F64: v->v.f64 = (double)n; break;
+    default: v->v.u64 = n; break;
+    }
+}
+
+void fixture_fill(fixture_t *f, uint32_t base, uint32_t step) {
+    for (size_t i = 0; i < f->schema.entry_count; ++i) {
+        const cfgpack_entry_t *e = &f->entries[i];
+        cfgpack_value_t v;
+        char s[8];
+
+        snprintf(s, sizeof(s), "s%zu", i + 1);
+        if (e->type == CFGPACK_TYPE_STR) {
+            cfgpack_set_str(&f->ctx, e->index, s);
+        } else if (e->type == CFGPACK_TYPE_FSTR) {
+            cfgpack_set_fstr(&f->ctx, e->index, s);
+        } else {
+            fill_value(e, i, base, step, &v);
+            cfgpack_set(&f->ctx, e->index, &v);
+        }
+    }
+}
+
+int fixture_holds(const fixture_t *f, size_t i, uint32_t base, uint32_t step) {
+    const cfgpack_entry_t *e = &f->entries[i];
+    cfgpack_value_t want;
+    cfgpack_value_t got;
+    const char *str;
+    uint16_t len;
+    uint8_t flen;
+    char s[8];
+
+    snprintf(s, sizeof(s), "s%zu", i + 1);
+    if (e->type == CFGPACK_TYPE_STR) {
+        return (cfgpack_get_str(&f->ctx, e->index, &str, &len) == CFGPACK_OK &&
+                len == strlen(s) && memcmp(str, s, len) == 0);
+    }
+    if (e->type == CFGPACK_TYPE_FSTR) {
+        return (cfgpack_get_fstr(&f->ctx, e->index, &str, &flen) ==
+                    CFGPACK_OK &&
+                flen == strlen(s) && memcmp(str, s, flen) == 0);
+    }
+    fill_value(e, i, base, step, &want);
+    if (cfgpack_get(&f->ctx, e->index, &got) != CFGPACK_OK) {
+        return (0);
+    }
+    switch (e->type) {
+    case CFGPACK_TYPE_F32: return (got.v.f32 == want.v.f32);
+    case CFGPACK_TYPE_F64: return (got.v.f64 == want.v.f64);
+    default: return (got.v.u64 == want.v.u64);
+    }
+}
+
+int fixture_filled(const fixture_t *f, uint32_t base, uint32_t step) {
+    for (size_t i = 0; i < f->schema.entry_count; ++i) {
+        if (!fixture_holds(f, i, base, step)) {
+            return (0);
+        }
+    }
+    return (1);
+}
@@ -0,0 +1,58 @@
+#ifndef CFGPACK_TEST_FIXTURE_H
+#define CFGPACK_TEST_FIXTURE_H
+
+#include "cfgpack/cfgpack.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Room for the largest schema a test builds */
+#define FIXTURE_ENTRIES 40
+#define FIXTURE_STRS    5
+
+/* One context with its schema and buffers, all in one static-friendly
+ * block.  bits is there for tests that call cfgpack_notify_init(). */
+typedef struct {
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[FIXTURE_ENTRIES];
+    cfgpack_value_t values[FIXTURE_ENTRIES];
+    char str_pool[FIXTURE_STRS * (CFGPACK_STR_MAX + 1)];
+    cfgpack_str_off_t str_offsets[FIXTURE_STRS];
+    uint8_t bits[CFGPACK_NOTIFY_BYTES(FIXTURE_ENTRIES)];
+    cfgpack_ctx_t ctx;
+} fixture_t;
+
+/* Type of entry @p i (0-based) of a built schema */
+typedef cfgpack_type_t (*fixture_type_fn)(size_t i);
+
+/* Zero @p f and describe @p n entries: index i + 1, name "e<i>", the type
+ * from @p type_of (u32 when NULL), no defaults.  Adjust the entries or the
+ * defaults in f->values, then call fixture_init(). */
+void fixture_schema(fixture_t *f,
+                    const char *name,
+                    size_t n,
+                    fixture_type_fn type_of);
+
+/* cfgpack_init() on the fixture's own buffers */
+cfgpack_err_t fixture_init(fixture_t *f);
+
+/* fixture_schema() then fixture_init() */
+cfgpack_err_t fixture_make(fixture_t *f,
+                           const char *name,
+                           size_t n,
+                           fixture_type_fn type_of);
+
+/* Zero @p f, parse the NUL-terminated @p map and initialize */
+cfgpack_err_t fixture_parse(fixture_t *f, const char *map);
+
+/* Set every entry from its position n = i + 1: strings to "s<n>", unsigned
+ * entries to base + step * n, signed ones to its negative, floats to it */
+void fixture_fill(fixture_t *f, uint32_t base, uint32_t step);
+
+/* Whether entry @p i holds what fixture_fill() set */
+int fixture_holds(const fixture_t *f, size_t i, uint32_t base, uint32_t step);
+
+/* fixture_holds() for every entry */
+int fixture_filled(const fixture_t *f, uint32_t base, uint32_t step);
+
+#endif /* CFGPACK_TEST_FIXTURE_H */
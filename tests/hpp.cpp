@@ -0,0 +1,192 @@
+/* C++ layer tests: compile-time indices, typed get/set through the C
+ * positional API, and the move-only context handle. */
+
+#include "cfgpack/cfgpack.hpp"
+
+extern "C" {
+#include "test.h"
+}
+
+#include <cstring>
+#include <utility>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static const char demo_map[] = "demo 1\n"
+                               "1 rate u16 100\n"
+                               "2 host str:16 \"gateway\"\n"
+                               "3 gain f32 NIL\n"
+                               "5 tag fstr NIL\n"
+                               "9 off i32 -7\n";
+
+#define DEMO_SCHEMA(V, N, S)      \
+    V(1, rate, U16, 100)          \
+    S(2, host, STR, 16, "gateway") \
+    N(3, gain, F32, 0)            \
+    N(5, tag, FSTR, 0)            \
+    V(9, off, I32, -7)
+
+struct demo {
+    static constexpr cfgpack::Field fields[] = {
+        DEMO_SCHEMA(CFGPACK_FIELD_V, CFGPACK_FIELD_N, CFGPACK_FIELD_S)};
+};
+
+/* Same entries, but index 3 described as a u32 */
+struct wrong {
+    static constexpr cfgpack::Field fields[] = {
+        {1, CFGPACK_TYPE_U16},
+        {2, CFGPACK_TYPE_STR, 16},
+        {3, CFGPACK_TYPE_U32},
+        {5, CFGPACK_TYPE_FSTR},
+        {9, CFGPACK_TYPE_I32},
+    };
+};
+
+using demo_config = cfgpack::Config<demo>;
+
+static_assert(demo_config::pos<9> == 4, "positions are compile-time");
+static_assert(std::is_same_v<demo_config::value_type<2>, std::string_view>,
+              "strings are string views");
+static_assert(std::is_same_v<demo_config::value_type<3>, float>,
+              "f32 is float");
+static_assert(cfgpack::Storage<demo>::str_pool_size == 17 + 17,
+              "pool sized from the string limits");
+static_assert(!std::is_copy_constructible_v<demo_config> &&
+                  std::is_nothrow_move_constructible_v<demo_config>,
+              "handles are move-only");
+
+static cfgpack_err_t parse(cfgpack::Storage<demo> &st) {
+    cfgpack_parse_error_t err;
+    cfgpack_parse_opts_t opts = st.parse_opts(&err);
+
+    return (cfgpack_parse_schema(demo_map, sizeof(demo_map) - 1, &opts));
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Typed get and set
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_hpp_typed) {
+    static cfgpack::Storage<demo> st;
+    demo_config cfg;
+    uint16_t rate = 0;
+
+    CHECK(parse(st) == CFGPACK_OK);
+    CHECK(cfg.init(st) == CFGPACK_OK);
+    CHECK(cfg.ctx() == &st.ctx);
+
+    LOG_SECTION("Defaults");
+    CHECK(cfg.get<1>().ok() && cfg.get<1>().value == 100);
+    CHECK(cfg.get<2>().value == "gateway");
+    CHECK(cfg.get<9>().value == -7);
+    CHECK(!cfg.has<3>());
+    CHECK(cfg.get<3>().err == CFGPACK_ERR_MISSING);
+
+    LOG_SECTION("Set, and read back through the C API");
+    CHECK(cfg.set<1>(uint16_t{250}) == CFGPACK_OK);
+    CHECK(cfg.set<3>(1.5f) == CFGPACK_OK);
+    CHECK(cfg.set<9>(int32_t{-70000}) == CFGPACK_OK);
+    CHECK(cfgpack_get_u16(cfg.ctx(), 1, &rate) == CFGPACK_OK && rate == 250);
+    CHECK(cfg.get<3>().value == 1.5f);
+    CHECK(cfg.get<9>().value == -70000);
+    CHECK(cfgpack_get_dirty_count(cfg.ctx()) == 3);
+
+    LOG_SECTION("Strings from views that are not NUL-terminated");
+    std::string_view names("kitchen-sink");
+    CHECK(cfg.set<2>(names.substr(0, 7)) == CFGPACK_OK);
+    CHECK(cfg.get<2>().value == "kitchen");
+    CHECK(cfg.set<5>(names.substr(8)) == CFGPACK_OK);
+    CHECK(cfg.get<5>().value == "sink");
+    CHECK(cfg.set<2>(std::string_view()) == CFGPACK_OK);
+    CHECK(cfg.get<2>().ok() && cfg.get<2>().value.empty());
+    CHECK(cfg.set<2>("seventeen-chars-x") == CFGPACK_ERR_STR_TOO_LONG);
+    CHECK(cfg.get<2>().value.empty());
+    LOG("rate=%u gain=%f", cfg.get<1>().value, (double)cfg.get<3>().value);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Same blob as the C API writes
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_hpp_blob) {
+    static cfgpack::Storage<demo> a;
+    static cfgpack::Storage<demo> b;
+    demo_config cfg;
+    uint8_t blob_a[128];
+    uint8_t blob_b[128];
+    size_t len_a = 0;
+    size_t len_b = 0;
+
+    CHECK(parse(a) == CFGPACK_OK);
+    CHECK(parse(b) == CFGPACK_OK);
+    CHECK(cfg.init(a) == CFGPACK_OK);
+    CHECK(cfgpack_init(&b.ctx, &b.schema, b.values, b.entry_count,
+                       b.str_pool, sizeof(b.str_pool), b.str_offsets,
+                       b.str_count) == CFGPACK_OK);
+
+    CHECK(cfg.set<3>(0.25f) == CFGPACK_OK);
+    CHECK(cfg.set<5>("eu") == CFGPACK_OK);
+    CHECK(cfgpack_set_f32(&b.ctx, 3, 0.25f) == CFGPACK_OK);
+    CHECK(cfgpack_set_fstr(&b.ctx, 5, "eu") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(cfg.ctx(), blob_a, sizeof(blob_a), &len_a) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout(&b.ctx, blob_b, sizeof(blob_b), &len_b) ==
+          CFGPACK_OK);
+    CHECK(len_a == len_b && memcmp(blob_a, blob_b, len_a) == 0);
+    LOG("Both blobs %zu bytes", len_a);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Handles: layout check and moves
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_hpp_handle) {
+    static cfgpack::Storage<demo> st;
+    demo_config cfg;
+    cfgpack::Config<wrong> bad;
+
+    CHECK(parse(st) == CFGPACK_OK);
+    CHECK(cfg.init(st) == CFGPACK_OK);
+
+    LOG_SECTION("A description that differs from the schema is refused");
+    CHECK(bad.attach(&st.ctx) == CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(!bad);
+    CHECK(bad.attach(nullptr) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("Moving leaves the source empty");
+    demo_config moved(std::move(cfg));
+    CHECK(!cfg && moved);
+    CHECK(cfg.get<1>().err == CFGPACK_ERR_ARGS);
+    CHECK(cfg.set<1>(uint16_t{1}) == CFGPACK_ERR_ARGS);
+    CHECK(moved.get<1>().value == 100);
+
+    demo_config other;
+    other = std::move(moved);
+    CHECK(!moved && other.ctx() == &st.ctx);
+    other.reset();
+    CHECK(!other && other.has<1>() == 0);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    overall |= (test_case_result("hpp_typed", test_hpp_typed()) != TEST_OK);
+    overall |= (test_case_result("hpp_blob", test_hpp_blob()) != TEST_OK);
+    overall |= (test_case_result("hpp_handle", test_hpp_handle()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
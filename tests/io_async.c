@@ -0,0 +1,293 @@
+/* Queued file pageouts: encode on the caller, write on a worker pool with
+ * temp-file-and-rename, coalescing per path and batched directory syncs. */
+
+#define _POSIX_C_SOURCE 200809L /* mkdir/getpid under -std=c99 */
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/io_async.h"
+#include "cfgpack/io_file.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 8
+#define N_SLOTS   16
+#define BLOB_CAP  256
+#define N_FILES   40
+
+/* u32 entries at index 1..8; device dev's are filled with
+ * fixture_fill(f, 100 * dev, 1). */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    return (fixture_make(f, "async", N_ENTRIES, NULL));
+}
+
+/* Whether @p path holds the blob device @p dev would page out. */
+static int file_holds(const char *path, uint32_t dev) {
+    static fixture_t g;
+    uint8_t scratch[BLOB_CAP];
+
+    return (make_fixture(&g) == CFGPACK_OK &&
+            cfgpack_pagein_file(&g.ctx, path, scratch, sizeof(scratch)) ==
+                CFGPACK_OK &&
+            fixture_filled(&g, 100 * dev, 1));
+}
+
+static int file_exists(const char *path) {
+    struct stat st;
+
+    return (stat(path, &st) == 0);
+}
+
+typedef struct {
+    pthread_mutex_t lock;
+    unsigned ok;
+    unsigned failed;
+} done_log_t;
+
+static void on_done(const char *path, cfgpack_err_t rc, void *user) {
+    done_log_t *log = user;
+
+    (void)path;
+    pthread_mutex_lock(&log->lock);
+    if (rc == CFGPACK_OK) {
+        log->ok++;
+    } else {
+        log->failed++;
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+static cfgpack_async_slot_t slots[N_SLOTS];
+static uint8_t arena[N_SLOTS * BLOB_CAP];
+static char dir[64];
+
+static cfgpack_async_opts_t make_opts(done_log_t *log,
+                                      unsigned threads,
+                                      uint32_t linger_ms) {
+    cfgpack_async_opts_t o;
+
+    memset(&o, 0, sizeof(o));
+    o.slots = slots;
+    o.slot_count = N_SLOTS;
+    o.arena = arena;
+    o.blob_cap = BLOB_CAP;
+    o.threads = threads;
+    o.linger_ms = linger_ms;
+    o.done = on_done;
+    o.user = log;
+    return (o);
+}
+
+static void file_path(char *out, size_t cap, unsigned k) {
+    snprintf(out, cap, "%s/dev%u.bin", dir, k);
+}
+
+static void remove_files(void) {
+    char path[128];
+
+    for (unsigned k = 0; k < N_FILES; ++k) {
+        file_path(path, sizeof(path), k);
+        remove(path);
+    }
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Many files through a small queue, read back whole
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_async_many_files) {
+    static fixture_t f;
+    static cfgpack_async_t a;
+    done_log_t log = {PTHREAD_MUTEX_INITIALIZER, 0, 0};
+    cfgpack_async_opts_t o = make_opts(&log, 4, 0);
+    cfgpack_async_stats_t st;
+    char path[128];
+    char tmp[160];
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_async_start(&a, &o) == CFGPACK_OK);
+
+    LOG_SECTION("40 files through 16 slots and 4 workers");
+    for (unsigned k = 0; k < N_FILES; ++k) {
+        fixture_fill(&f, 100 * k, 1);
+        file_path(path, sizeof(path), k);
+        CHECK(cfgpack_async_pageout(&a, &f.ctx, path) == CFGPACK_OK);
+        CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+    }
+    CHECK(cfgpack_async_flush(&a) == CFGPACK_OK);
+    cfgpack_async_get_stats(&a, &st);
+    LOG("batches %llu, dir syncs %llu", (unsigned long long)st.batches,
+        (unsigned long long)st.dir_syncs);
+    CHECK(st.submitted == N_FILES);
+    CHECK(st.written == N_FILES);
+    CHECK(st.failed == 0);
+    CHECK(st.dir_syncs == st.batches);
+    CHECK(log.ok == N_FILES && log.failed == 0);
+
+    LOG_SECTION("Every file holds its blob and no temp file is left");
+    for (unsigned k = 0; k < N_FILES; ++k) {
+        file_path(path, sizeof(path), k);
+        snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+        CHECK(file_holds(path, k));
+        CHECK(!file_exists(tmp));
+    }
+
+    LOG_SECTION("A rewrite replaces the file in place");
+    fixture_fill(&f, 100 * 77, 1);
+    file_path(path, sizeof(path), 3);
+    CHECK(cfgpack_async_pageout(&a, &f.ctx, path) == CFGPACK_OK);
+    CHECK(cfgpack_async_stop(&a) == CFGPACK_OK);
+    CHECK(file_holds(path, 77));
+
+    remove_files();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Coalescing per path and one directory sync per batch
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_async_coalesce) {
+    static fixture_t f;
+    static cfgpack_async_t a;
+    done_log_t log = {PTHREAD_MUTEX_INITIALIZER, 0, 0};
+    cfgpack_async_opts_t o = make_opts(&log, 1, 300);
+    cfgpack_async_stats_t st;
+    char path[128];
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_async_start(&a, &o) == CFGPACK_OK);
+
+    LOG_SECTION("Ten pageouts of one path inside the linger: one write");
+    file_path(path, sizeof(path), 0);
+    for (unsigned k = 1; k <= 10; ++k) {
+        fixture_fill(&f, 100 * k, 1);
+        CHECK(cfgpack_async_pageout(&a, &f.ctx, path) == CFGPACK_OK);
+    }
+    CHECK(cfgpack_async_flush(&a) == CFGPACK_OK);
+    cfgpack_async_get_stats(&a, &st);
+    CHECK(st.submitted == 10);
+    CHECK(st.coalesced == 9);
+    CHECK(st.written == 1);
+    CHECK(log.ok == 1);
+    CHECK(file_holds(path, 10));
+
+    LOG_SECTION("Sixteen files in one directory: one batch, one dir sync");
+    for (unsigned k = 1; k <= N_SLOTS; ++k) {
+        fixture_fill(&f, 100 * k, 1);
+        file_path(path, sizeof(path), k);
+        CHECK(cfgpack_async_pageout(&a, &f.ctx, path) == CFGPACK_OK);
+    }
+    CHECK(cfgpack_async_flush(&a) == CFGPACK_OK);
+    cfgpack_async_get_stats(&a, &st);
+    CHECK(cfgpack_async_stop(&a) == CFGPACK_OK);
+    CHECK(st.written == 1 + N_SLOTS);
+    CHECK(st.batches == 2);
+    CHECK(st.dir_syncs == 2);
+    for (unsigned k = 1; k <= N_SLOTS; ++k) {
+        file_path(path, sizeof(path), k);
+        CHECK(file_holds(path, k));
+    }
+
+    remove_files();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Argument, encode and write errors
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_async_errors) {
+    static fixture_t f;
+    static cfgpack_async_t a;
+    static char long_path[CFGPACK_ASYNC_PATH_MAX];
+    done_log_t log = {PTHREAD_MUTEX_INITIALIZER, 0, 0};
+    cfgpack_async_opts_t o = make_opts(&log, 2, 0);
+    cfgpack_async_opts_t bad;
+    cfgpack_async_stats_t st;
+    char path[128];
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    fixture_fill(&f, 100 * 5, 1);
+
+    LOG_SECTION("Bad settings");
+    CHECK(cfgpack_async_start(NULL, &o) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_async_start(&a, NULL) == CFGPACK_ERR_ARGS);
+    bad = o;
+    bad.threads = 0;
+    CHECK(cfgpack_async_start(&a, &bad) == CFGPACK_ERR_ARGS);
+    bad = o;
+    bad.batch = CFGPACK_ASYNC_MAX_BATCH + 1;
+    CHECK(cfgpack_async_start(&a, &bad) == CFGPACK_ERR_ARGS);
+    bad = o;
+    bad.slot_count = 0;
+    CHECK(cfgpack_async_start(&a, &bad) == CFGPACK_ERR_ARGS);
+
+    CHECK(cfgpack_async_start(&a, &o) == CFGPACK_OK);
+
+    LOG_SECTION("Bad submissions are refused on the caller");
+    file_path(path, sizeof(path), 1);
+    CHECK(cfgpack_async_pageout(NULL, &f.ctx, path) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_async_pageout(&a, NULL, path) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_async_pageout(&a, &f.ctx, NULL) == CFGPACK_ERR_ARGS);
+    memset(long_path, 'x', sizeof(long_path) - 4);
+    CHECK(cfgpack_async_pageout(&a, &f.ctx, long_path) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_async_flush(NULL) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("A failed write is reported once, then cleared");
+    CHECK(cfgpack_async_pageout(&a, &f.ctx, "/nonexistent-dir/x.bin") ==
+          CFGPACK_OK);
+    CHECK(cfgpack_async_pageout(&a, &f.ctx, path) == CFGPACK_OK);
+    CHECK(cfgpack_async_flush(&a) == CFGPACK_ERR_IO);
+    CHECK(cfgpack_async_flush(&a) == CFGPACK_OK);
+    CHECK(log.ok == 1 && log.failed == 1);
+    CHECK(file_holds(path, 5));
+    CHECK(cfgpack_async_stop(&a) == CFGPACK_OK);
+
+    LOG_SECTION("A blob larger than a slot is an encode error");
+    o.blob_cap = 8;
+    CHECK(cfgpack_async_start(&a, &o) == CFGPACK_OK);
+    CHECK(cfgpack_async_pageout(&a, &f.ctx, path) == CFGPACK_ERR_ENCODE);
+    cfgpack_async_get_stats(&a, &st);
+    CHECK(st.submitted == 0);
+    CHECK(cfgpack_async_stop(&a) == CFGPACK_OK);
+
+    remove_files();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    snprintf(dir, sizeof(dir), "/tmp/cfgpack_async_%ld", (long)getpid());
+    if (mkdir(dir, 0755) != 0) {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+        return (1);
+    }
+
+    overall |= (test_case_result("async_many_files",
+                                 test_async_many_files()) != TEST_OK);
+    overall |= (test_case_result("async_coalesce", test_async_coalesce()) !=
+                TEST_OK);
+    overall |= (test_case_result("async_errors", test_async_errors()) !=
+                TEST_OK);
+    rmdir(dir);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
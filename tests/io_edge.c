@@ -22,6 +22,7 @@ static void make_schema(cfgpack_schema_t *schema,
         snprintf(entries[i].name, sizeof(entries[i].name), "e%zu", i);
         entries[i].type = CFGPACK_TYPE_U8;
         entries[i].has_default = 0;
+        entries[i].str_max = 0;
     }
 }
 
@@ -152,6 +153,8 @@ TEST_CASE(test_remap_string_types) {
     char old_str_pool[256], new_str_pool[256];
     uint16_t old_str_offsets[2], new_str_offsets[2];
 
+    memset(old_entries, 0, sizeof(old_entries));
+    memset(new_entries, 0, sizeof(new_entries));
     LOG("Setting up old schema: str@10, fstr@11");
     snprintf(old_schema.map_name, sizeof(old_schema.map_name), "old");
     old_schema.version = 1;
@@ -948,6 +951,481 @@ TEST_CASE(test_remap_decoded_overrides_default) {
     return TEST_OK;
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 17. pagein_file streams a file larger than scratch
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pagein_file_streams_large) {
+    LOG_SECTION("pagein_file with file larger than scratch");
+
+    const char *path = "/tmp/cfgpack_io_edge_stream.bin";
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[40];
+    cfgpack_value_t values[40];
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    uint8_t big[512];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    size_t needed = 0;
+
+    make_schema(&schema, entries, 40);
+    CHECK(cfgpack_init(&ctx, &schema, values, 40, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    for (uint16_t i = 1; i <= 40; ++i) {
+        cfgpack_set_u8(&ctx, i, (uint8_t)(100 + i));
+    }
+    CHECK(cfgpack_pageout_measure(&ctx, &needed) == CFGPACK_OK);
+    CHECK(needed > sizeof(window));
+    CHECK(cfgpack_pageout_file(&ctx, path, big, sizeof(big)) == CFGPACK_OK);
+    LOG("Wrote %zu-byte blob", needed);
+
+    memset(values, 0, sizeof(values));
+    memset(ctx.present, 0, sizeof(ctx.present));
+    CHECK(cfgpack_pagein_file(&ctx, path, window, sizeof(window)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 40, &v) == CFGPACK_OK);
+    CHECK(v.v.u64 == 140);
+    LOG("Streamed through %zu-byte window", sizeof(window));
+
+    LOG_SECTION("Below the window minimum: IO");
+    CHECK(cfgpack_pagein_file(&ctx, path, window, sizeof(window) - 1) ==
+          CFGPACK_ERR_IO);
+
+    remove(path);
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 18. Memory-mapped schema parse matches the scratch-buffer parse
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_parse_schema_file_mmap) {
+    LOG_SECTION("mmap parse of .map and JSON schemas");
+
+    static cfgpack_schema_t a;
+    static cfgpack_schema_t b;
+    static cfgpack_entry_t ea[128];
+    static cfgpack_entry_t eb[128];
+    static cfgpack_value_t va[128];
+    static cfgpack_value_t vb[128];
+    static char pa[1024];
+    static char pb[1024];
+    static uint16_t oa[128];
+    static uint16_t ob[128];
+    static char scratch[4096];
+    cfgpack_parse_error_t err;
+    cfgpack_parse_opts_t opts_a = {&a, ea, 128, va, pa, sizeof(pa),
+                                   oa, 128, &err};
+    cfgpack_parse_opts_t opts_b = {&b, eb, 128, vb, pb, sizeof(pb),
+                                   ob, 128, &err};
+
+    LOG("mmap available: %d", cfgpack_io_file_has_mmap());
+    CHECK(cfgpack_parse_schema_file("tests/data/sample.map", &opts_a, scratch,
+                                    sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_parse_schema_file_mmap("tests/data/sample.map", &opts_b,
+                                         NULL, 0) == CFGPACK_OK);
+    CHECK(a.entry_count == b.entry_count);
+    CHECK(strcmp(a.map_name, b.map_name) == 0);
+    for (size_t i = 0; i < a.entry_count; ++i) {
+        CHECK(ea[i].index == eb[i].index);
+        CHECK(strcmp(ea[i].name, eb[i].name) == 0);
+        CHECK(ea[i].type == eb[i].type);
+    }
+    CHECK(memcmp(pa, pb, sizeof(pa)) == 0);
+    LOG(".map: %zu entries identical", b.entry_count);
+
+    CHECK(cfgpack_schema_parse_json_file("tests/data/test_schema.json",
+                                         &opts_a, scratch,
+                                         sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_schema_parse_json_file_mmap("tests/data/test_schema.json",
+                                              &opts_b, NULL,
+                                              0) == CFGPACK_OK);
+    CHECK(a.entry_count == b.entry_count);
+    CHECK(strcmp(a.map_name, b.map_name) == 0);
+    LOG("JSON: %zu entries identical", b.entry_count);
+
+    LOG_SECTION("Missing file and NULL arguments");
+    CHECK(cfgpack_parse_schema_file_mmap("/tmp/cfgpack_nope.map", &opts_b,
+                                         NULL, 0) == CFGPACK_ERR_IO);
+    CHECK(strcmp(err.message, "unable to open file") == 0);
+    CHECK(cfgpack_schema_parse_json_file_mmap("/tmp/cfgpack_nope.json",
+                                              &opts_b, NULL,
+                                              0) == CFGPACK_ERR_IO);
+    CHECK(cfgpack_parse_schema_file_mmap(NULL, &opts_b, NULL, 0) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_schema_parse_json_file_mmap("x", NULL, NULL, 0) ==
+          CFGPACK_ERR_ARGS);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 19. Memory-mapped pagein needs no scratch, whatever the file size
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pagein_file_mmap) {
+    LOG_SECTION("mmap pagein of a pageout_file blob");
+
+    const char *path = "/tmp/cfgpack_io_edge_mmap.bin";
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[40];
+    cfgpack_value_t values[40];
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    uint8_t chunk[64];
+    FILE *f;
+
+    make_schema(&schema, entries, 40);
+    CHECK(cfgpack_init(&ctx, &schema, values, 40, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    for (uint16_t i = 1; i <= 40; ++i) {
+        cfgpack_set_u8(&ctx, i, (uint8_t)(200 + i % 50));
+    }
+    CHECK(cfgpack_pageout_file(&ctx, path, chunk, sizeof(chunk)) ==
+          CFGPACK_OK);
+
+    memset(values, 0, sizeof(values));
+    memset(ctx.present, 0, sizeof(ctx.present));
+    if (cfgpack_io_file_has_mmap()) {
+        CHECK(cfgpack_pagein_file_mmap(&ctx, path, NULL, 0) == CFGPACK_OK);
+    } else {
+        CHECK(cfgpack_pagein_file_mmap(&ctx, path, chunk, sizeof(chunk)) ==
+              CFGPACK_OK);
+    }
+    CHECK(cfgpack_get(&ctx, 40, &v) == CFGPACK_OK);
+    CHECK(v.v.u64 == 240);
+    CHECK(cfgpack_get_size(&ctx) == 40);
+
+    LOG_SECTION("Corrupt, empty and missing files");
+    f = fopen(path, "r+b");
+    CHECK(f != NULL);
+    fseek(f, 10, SEEK_SET);
+    fputc(0x00, f);
+    fclose(f);
+    CHECK(cfgpack_pagein_file_mmap(&ctx, path, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_CRC);
+    f = fopen(path, "wb");
+    CHECK(f != NULL);
+    fclose(f);
+    CHECK(cfgpack_pagein_file_mmap(&ctx, path, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_DECODE);
+    remove(path);
+    CHECK(cfgpack_pagein_file_mmap(&ctx, path, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_IO);
+    CHECK(cfgpack_pagein_file_mmap(NULL, path, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_ARGS);
+
+    return TEST_OK;
+}
+
+#ifdef CFGPACK_LAZY
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 20. Lazy pagein decodes each value on first access
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lazy_pagein) {
+    LOG_SECTION("Lazy pagein: record offsets, decode on first get");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[8];
+    cfgpack_value_t values[8];
+    char str_pool[CFGPACK_STR_MAX + 1];
+    uint16_t str_offsets[1];
+    uint32_t lazy_off[8];
+    uint8_t blob[128];
+    uint8_t again[128];
+    size_t blob_len = 0;
+    size_t again_len = 0;
+    size_t measured = 0;
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    const char *s;
+    uint16_t slen;
+
+    make_schema(&schema, entries, 8);
+    entries[7].type = CFGPACK_TYPE_STR;
+    CHECK(cfgpack_init(&ctx, &schema, values, 8, str_pool, sizeof(str_pool),
+                       str_offsets, 1) == CFGPACK_OK);
+    for (uint16_t i = 1; i <= 7; ++i) {
+        cfgpack_set_u8(&ctx, i, (uint8_t)(10 * i));
+    }
+    CHECK(cfgpack_set_str(&ctx, 8, "lazy") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, blob, sizeof(blob), &blob_len) == CFGPACK_OK);
+
+    /* Fresh context: nothing is decoded by pagein */
+    memset(values, 0, sizeof(values));
+    memset(str_pool, 0, sizeof(str_pool));
+    CHECK(cfgpack_init(&ctx, &schema, values, 8, str_pool, sizeof(str_pool),
+                       str_offsets, 1) == CFGPACK_OK);
+    CHECK(cfgpack_lazy_init(&ctx, lazy_off, 8) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, blob_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&ctx) == 8);
+    for (size_t i = 0; i < 8; ++i) {
+        CHECK(lazy_off[i] != 0);
+        CHECK(values[i].v.u64 == 0);
+    }
+    CHECK(str_pool[0] == '\0');
+    LOG("8 entries present, none decoded");
+
+    CHECK(cfgpack_get(&ctx, 3, &v) == CFGPACK_OK && v.v.u64 == 30);
+    CHECK(lazy_off[2] == 0 && lazy_off[3] != 0);
+    CHECK(cfgpack_get_str(&ctx, 8, &s, &slen) == CFGPACK_OK);
+    CHECK(slen == 4 && memcmp(s, "lazy", 4) == 0);
+    CHECK(lazy_off[7] == 0);
+    LOG("Entries 3 and 8 decoded on first access");
+
+    /* A set replaces the pending value without decoding it */
+    CHECK(cfgpack_set_u8(&ctx, 5, 99) == CFGPACK_OK);
+    CHECK(lazy_off[4] == 0);
+    CHECK(cfgpack_get(&ctx, 5, &v) == CFGPACK_OK && v.v.u64 == 99);
+    CHECK(cfgpack_set_u8(&ctx, 5, 50) == CFGPACK_OK);
+
+    /* Measure and pageout decode the rest and match the original blob */
+    CHECK(cfgpack_pageout_measure(&ctx, &measured) == CFGPACK_OK);
+    CHECK(measured == blob_len);
+    for (size_t i = 0; i < 8; ++i) {
+        CHECK(lazy_off[i] == 0);
+    }
+    CHECK(cfgpack_pageout(&ctx, again, sizeof(again), &again_len) ==
+          CFGPACK_OK);
+    CHECK(again_len == blob_len && memcmp(again, blob, blob_len) == 0);
+    LOG("Pageout after lazy pagein is byte-identical (%zu bytes)", blob_len);
+
+  #ifdef CFGPACK_SIZE_CACHE
+    /* Size cache stays exact across a lazy pagein */
+    CHECK(cfgpack_size_cache_init(&ctx) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, blob_len) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_OK && v.v.u64 == 10);
+    CHECK(cfgpack_set_u8(&ctx, 2, 200) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_measure(&ctx, &measured) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, again, sizeof(again), &again_len) ==
+          CFGPACK_OK);
+    CHECK(measured == again_len && again_len == blob_len + 1);
+    LOG("Size cache: measure %zu == pageout %zu", measured, again_len);
+  #endif
+
+    /* Eager again after cfgpack_init() */
+    CHECK(cfgpack_init(&ctx, &schema, values, 8, str_pool, sizeof(str_pool),
+                       str_offsets, 1) == CFGPACK_OK);
+    memset(lazy_off, 0, sizeof(lazy_off));
+    CHECK(cfgpack_pagein_buf(&ctx, blob, blob_len) == CFGPACK_OK);
+    CHECK(lazy_off[0] == 0 && values[0].v.u64 == 10);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 21. Lazy pagein reports decode faults on first access
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lazy_faults) {
+    LOG_SECTION("Lazy pagein: bad values fail the access, not the pagein");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[3];
+    cfgpack_value_t values[3];
+    char str_pool[1];
+    uint16_t str_offsets[1];
+    uint32_t lazy_off[3];
+    uint8_t out[64];
+    size_t out_len;
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    cfgpack_err_t eager;
+
+    /* map(3) {1: 7, 2: "x", 3: 9}; entry 2 is a u8 */
+    uint8_t buf[16];
+    size_t buf_len = 0;
+    buf[buf_len++] = 0x83;
+    buf[buf_len++] = 0x01;
+    buf[buf_len++] = 0x07;
+    buf[buf_len++] = 0x02;
+    buf[buf_len++] = 0xa1;
+    buf[buf_len++] = 'x';
+    buf[buf_len++] = 0x03;
+    buf[buf_len++] = 0x09;
+    test_append_crc(buf, &buf_len);
+
+    make_schema(&schema, entries, 3);
+    CHECK(cfgpack_init(&ctx, &schema, values, 3, str_pool, sizeof(str_pool),
+                       str_offsets, 0) == CFGPACK_OK);
+    eager = cfgpack_pagein_buf(&ctx, buf, buf_len);
+    CHECK(eager != CFGPACK_OK);
+    LOG("Eager pagein fails with %d", eager);
+
+    CHECK(cfgpack_init(&ctx, &schema, values, 3, str_pool, sizeof(str_pool),
+                       str_offsets, 0) == CFGPACK_OK);
+    CHECK(cfgpack_lazy_init(NULL, lazy_off, 3) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_lazy_init(&ctx, NULL, 3) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_lazy_init(&ctx, lazy_off, 2) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_lazy_init(&ctx, lazy_off, 3) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, buf, buf_len) == CFGPACK_OK);
+
+    CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_OK && v.v.u64 == 7);
+    CHECK(cfgpack_get(&ctx, 2, &v) == eager);
+    CHECK(cfgpack_get(&ctx, 2, &v) == eager);
+    CHECK(cfgpack_get(&ctx, 3, &v) == CFGPACK_OK && v.v.u64 == 9);
+    CHECK(cfgpack_pageout(&ctx, out, sizeof(out), &out_len) == eager);
+    CHECK(cfgpack_lazy_finish(&ctx) == eager);
+    LOG("Entry 2 keeps failing while pending");
+
+    CHECK(cfgpack_set_u8(&ctx, 2, 2) == CFGPACK_OK);
+    CHECK(cfgpack_lazy_finish(&ctx) == CFGPACK_OK);
+    CHECK(cfgpack_lazy_finish(NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout(&ctx, out, sizeof(out), &out_len) == CFGPACK_OK);
+    LOG("Setting the entry clears the fault");
+
+    /* A corrupt trailer is still caught up front */
+    buf[buf_len - 1] ^= 0xff;
+    CHECK(cfgpack_pagein_buf(&ctx, buf, buf_len) == CFGPACK_ERR_CRC);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 22. Lazy mmap pagein decodes before the mapping goes away
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lazy_pagein_mmap) {
+    LOG_SECTION("Lazy mode with pagein_file_mmap");
+
+    const char *path = "/tmp/cfgpack_io_edge_lazy.bin";
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[4];
+    cfgpack_value_t values[4];
+    uint32_t lazy_off[4];
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    uint8_t chunk[64];
+
+    make_schema(&schema, entries, 4);
+    CHECK(cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    for (uint16_t i = 1; i <= 4; ++i) {
+        cfgpack_set_u8(&ctx, i, (uint8_t)(i + 100));
+    }
+    CHECK(cfgpack_pageout_file(&ctx, path, chunk, sizeof(chunk)) ==
+          CFGPACK_OK);
+
+    CHECK(cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_lazy_init(&ctx, lazy_off, 4) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_file_mmap(&ctx, path, chunk, sizeof(chunk)) ==
+          CFGPACK_OK);
+    remove(path);
+    if (cfgpack_io_file_has_mmap()) {
+        for (size_t i = 0; i < 4; ++i) {
+            CHECK(lazy_off[i] == 0);
+        }
+    }
+    CHECK(cfgpack_get(&ctx, 4, &v) == CFGPACK_OK && v.v.u64 == 104);
+    LOG("No value refers to the released mapping");
+
+    return TEST_OK;
+}
+#endif /* CFGPACK_LAZY */
+
+#ifdef CFGPACK_DEFAULTS_BLOB
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 23. Default elision: pageout skips defaults, pagein restores them
+ * ═══════════════════════════════════════════════════════════════════════════ */
+static const char elide_map[] = "elide 1\n"
+                                "1 a u8 1\n"
+                                "2 b u16 300\n"
+                                "3 c i32 -7\n"
+                                "4 d f32 1.5\n"
+                                "5 e str \"default host\"\n"
+                                "6 f u8 NIL\n";
+
+static cfgpack_err_t init_elide(cfgpack_ctx_t *ctx,
+                                cfgpack_schema_t *schema,
+                                cfgpack_entry_t *entries,
+                                cfgpack_value_t *values,
+                                char *str_pool,
+                                size_t str_pool_cap,
+                                uint16_t *str_offsets) {
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts = {schema,      entries, 6, values,
+                                 str_pool,    str_pool_cap,
+                                 str_offsets, 1,       &perr};
+    cfgpack_err_t rc;
+
+    rc = cfgpack_parse_schema(elide_map, sizeof(elide_map) - 1, &opts);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (cfgpack_init(ctx, schema, values, 6, str_pool, str_pool_cap,
+                         str_offsets, 1));
+}
+
+TEST_CASE(test_pageout_elide) {
+    LOG_SECTION("Default-elision pageout and default-restoring pagein");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[6];
+    cfgpack_value_t values[6];
+    char str_pool[CFGPACK_STR_MAX + 1];
+    uint16_t str_offsets[1];
+    uint32_t def_off[6];
+    uint8_t defs[96];
+    uint8_t blob[96];
+    uint8_t full[96];
+    size_t defs_len = 0;
+    size_t blob_len = 0;
+    size_t full_len = 0;
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    const char *s;
+    uint16_t slen;
+
+    CHECK(init_elide(&ctx, &schema, entries, values, str_pool,
+                     sizeof(str_pool), str_offsets) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, defs, sizeof(defs), &defs_len) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_elide(&ctx, blob, sizeof(blob), &blob_len) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_defaults_init(&ctx, defs, defs_len, def_off, 5) ==
+          CFGPACK_ERR_BOUNDS);
+    defs[2] ^= 1;
+    CHECK(cfgpack_defaults_init(&ctx, defs, defs_len, def_off, 6) ==
+          CFGPACK_ERR_CRC);
+    defs[2] ^= 1;
+    CHECK(cfgpack_defaults_init(&ctx, defs, defs_len, def_off, 6) ==
+          CFGPACK_OK);
+    CHECK(def_off[0] != 0 && def_off[4] != 0 && def_off[5] == 0);
+    LOG("Defaults blob: %zu bytes", defs_len);
+
+    /* Only entries 2, 5 and 6 differ from the defaults; 3 is set back */
+    CHECK(cfgpack_set_u16(&ctx, 2, 301) == CFGPACK_OK);
+    CHECK(cfgpack_set_i32(&ctx, 3, 9) == CFGPACK_OK);
+    CHECK(cfgpack_set_i32(&ctx, 3, -7) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&ctx, 5, "other host") == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&ctx, 6, 1) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, full, sizeof(full), &full_len) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_elide(&ctx, blob, sizeof(blob), &blob_len) ==
+          CFGPACK_OK);
+    CHECK(blob[0] == 0x84); /* name + entries 2, 5 and 6 */
+    CHECK(blob_len < full_len);
+    LOG("Full pageout %zu bytes, elided %zu bytes", full_len, blob_len);
+
+    /* Values changed since init are put back to their defaults */
+    CHECK(cfgpack_set_u8(&ctx, 1, 200) == CFGPACK_OK);
+    CHECK(cfgpack_set_f32(&ctx, 4, 2.5f) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, blob_len) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_OK && v.v.u64 == 1);
+    CHECK(cfgpack_get(&ctx, 2, &v) == CFGPACK_OK && v.v.u64 == 301);
+    CHECK(cfgpack_get(&ctx, 3, &v) == CFGPACK_OK && v.v.i64 == -7);
+    CHECK(cfgpack_get(&ctx, 4, &v) == CFGPACK_OK && v.v.f32 == 1.5f);
+    CHECK(cfgpack_get_str(&ctx, 5, &s, &slen) == CFGPACK_OK);
+    CHECK(slen == 10 && memcmp(s, "other host", 10) == 0);
+    CHECK(cfgpack_get(&ctx, 6, &v) == CFGPACK_OK && v.v.u64 == 1);
+    LOG("Elided entries restored from the attached defaults");
+
+    /* A fresh context needs no defaults attached to load the blob */
+    CHECK(init_elide(&ctx, &schema, entries, values, str_pool,
+                     sizeof(str_pool), str_offsets) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, blob_len) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, blob, sizeof(blob), &blob_len) == CFGPACK_OK);
+    CHECK(blob_len == full_len && memcmp(blob, full, full_len) == 0);
+    LOG("Fresh context reproduces the full pageout byte for byte");
+
+    return TEST_OK;
+}
+#endif /* CFGPACK_DEFAULTS_BLOB */
+
 int main(void) {
     test_result_t overall = TEST_OK;
 
@@ -989,6 +1467,24 @@ int main(void) {
     overall |= (test_case_result("remap_decoded_overrides_default",
                                  test_remap_decoded_overrides_default()) !=
                 TEST_OK);
+    overall |= (test_case_result("pagein_file_streams_large",
+                                 test_pagein_file_streams_large()) != TEST_OK);
+    overall |= (test_case_result("parse_schema_file_mmap",
+                                 test_parse_schema_file_mmap()) != TEST_OK);
+    overall |= (test_case_result("pagein_file_mmap",
+                                 test_pagein_file_mmap()) != TEST_OK);
+#ifdef CFGPACK_LAZY
+    overall |= (test_case_result("lazy_pagein", test_lazy_pagein()) !=
+                TEST_OK);
+    overall |= (test_case_result("lazy_faults", test_lazy_faults()) !=
+                TEST_OK);
+    overall |= (test_case_result("lazy_pagein_mmap",
+                                 test_lazy_pagein_mmap()) != TEST_OK);
+#endif
+#ifdef CFGPACK_DEFAULTS_BLOB
+    overall |= (test_case_result("pageout_elide", test_pageout_elide()) !=
+                TEST_OK);
+#endif
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
@@ -91,9 +91,13 @@ static void make_schema(cfgpack_schema_t *schema,
         snprintf(entries[i].name, sizeof(entries[i].name), "e%zu", i);
         entries[i].type = CFGPACK_TYPE_U8;
         entries[i].has_default = 0;
+        entries[i].str_max = 0;
     }
 }
 
+/* Journal record header: tag byte and little-endian length */
+#define JOURNAL_HDR 5
+
 static lfs_t lfs;
 
 /* scratch must be >= cache_size + data */
@@ -108,6 +112,14 @@ static void unmount(void) {
     lfs_unmount(&lfs);
 }
 
+static lfs_soff_t file_size(const char *path) {
+    struct lfs_info info;
+    if (lfs_stat(&lfs, path, &info) < 0) {
+        return (-1);
+    }
+    return ((lfs_soff_t)info.size);
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * 1. Basic pageout/pagein roundtrip
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -387,6 +399,537 @@ TEST_CASE(test_lfs_scratch_below_cache_size) {
     return (TEST_OK);
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 9. Streaming pageout: blob larger than the scratch data region
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lfs_pageout_small_chunk) {
+    LOG_SECTION("Pageout with a minimum-size chunk");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[20];
+    cfgpack_value_t values[20];
+    cfgpack_value_t out;
+    cfgpack_ctx_t ctx;
+    size_t needed = 0;
+
+    uint8_t small[BLOCK_SIZE + CFGPACK_STREAM_CHUNK_MIN];
+
+    make_schema(&schema, entries, 20);
+    cfgpack_init(&ctx, &schema, values, 20, NULL, 0, NULL, 0);
+    for (uint16_t i = 1; i <= 20; ++i) {
+        cfgpack_set_u8(&ctx, i, (uint8_t)(200 + i));
+    }
+    CHECK(cfgpack_pageout_measure(&ctx, &needed) == CFGPACK_OK);
+    LOG("Blob is %zu bytes, chunk is %d bytes", needed,
+        CFGPACK_STREAM_CHUNK_MIN);
+    CHECK(needed > CFGPACK_STREAM_CHUNK_MIN);
+
+    CHECK(mount_fresh() == 0);
+    CHECK(cfgpack_pageout_lfs(&ctx, &lfs, "/big.bin", small, sizeof(small)) ==
+          CFGPACK_OK);
+
+    memset(values, 0, sizeof(values));
+    memset(ctx.present, 0, sizeof(ctx.present));
+    CHECK(cfgpack_pagein_lfs(&ctx, &lfs, "/big.bin", scratch,
+                             sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 20, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 220);
+    LOG("Round-trip through %zu-byte scratch OK", sizeof(small));
+
+    unmount();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 10. Pagein of a file larger than scratch streams through a window
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lfs_pagein_stream_window) {
+    LOG_SECTION("Pagein with a window smaller than the file");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[40];
+    cfgpack_value_t values[40];
+    cfgpack_value_t out;
+    cfgpack_ctx_t ctx;
+    size_t needed = 0;
+
+    uint8_t small[BLOCK_SIZE + CFGPACK_STREAM_WINDOW_MIN];
+
+    make_schema(&schema, entries, 40);
+    cfgpack_init(&ctx, &schema, values, 40, NULL, 0, NULL, 0);
+    for (uint16_t i = 1; i <= 40; ++i) {
+        cfgpack_set_u8(&ctx, i, (uint8_t)(200 + i));
+    }
+    CHECK(cfgpack_pageout_measure(&ctx, &needed) == CFGPACK_OK);
+    LOG("Blob is %zu bytes, window is %d bytes", needed,
+        CFGPACK_STREAM_WINDOW_MIN);
+    CHECK(needed > CFGPACK_STREAM_WINDOW_MIN);
+
+    CHECK(mount_fresh() == 0);
+    CHECK(cfgpack_pageout_lfs(&ctx, &lfs, "/big.bin", scratch,
+                              sizeof(scratch)) == CFGPACK_OK);
+
+    memset(values, 0, sizeof(values));
+    memset(ctx.present, 0, sizeof(ctx.present));
+    CHECK(cfgpack_pagein_lfs(&ctx, &lfs, "/big.bin", small, sizeof(small)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 1, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 201);
+    CHECK(cfgpack_get(&ctx, 40, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 240);
+    LOG("Streamed pagein through %d-byte window OK",
+        CFGPACK_STREAM_WINDOW_MIN);
+
+    unmount();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 11. Journal: saves append small deltas, pagein replays them
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lfs_journal_roundtrip) {
+    LOG_SECTION("Base record, then one delta per save");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[20];
+    cfgpack_value_t values[20];
+    cfgpack_value_t out;
+    cfgpack_ctx_t ctx;
+    lfs_soff_t base_size;
+    lfs_soff_t prev;
+
+    make_schema(&schema, entries, 20);
+    cfgpack_init(&ctx, &schema, values, 20, NULL, 0, NULL, 0);
+    for (uint16_t i = 1; i <= 20; ++i) {
+        cfgpack_set_u8(&ctx, i, (uint8_t)i);
+    }
+
+    CHECK(mount_fresh() == 0);
+    CHECK(cfgpack_pageout_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                      sizeof(scratch), 0) == CFGPACK_OK);
+    base_size = file_size("/cfg.jnl");
+    LOG("Base record: %ld bytes", (long)base_size);
+    CHECK(cfgpack_get_dirty_count(&ctx) == 0);
+
+    prev = base_size;
+    for (uint8_t round = 0; round < 5; ++round) {
+        CHECK(cfgpack_set_u8(&ctx, (uint16_t)(3 + round),
+                             (uint8_t)(100 + round)) == CFGPACK_OK);
+        CHECK(cfgpack_pageout_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                          sizeof(scratch), 0) == CFGPACK_OK);
+        CHECK(file_size("/cfg.jnl") - prev < base_size / 2);
+        prev = file_size("/cfg.jnl");
+    }
+    LOG("After 5 single-entry saves: %ld bytes", (long)prev);
+
+    LOG_SECTION("Clean context writes nothing");
+    CHECK(cfgpack_pageout_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                      sizeof(scratch), 0) == CFGPACK_OK);
+    CHECK(file_size("/cfg.jnl") == prev);
+
+    LOG_SECTION("Replay into a fresh context");
+    memset(values, 0, sizeof(values));
+    cfgpack_init(&ctx, &schema, values, 20, NULL, 0, NULL, 0);
+    CHECK(cfgpack_pagein_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                     sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&ctx) == 20);
+    CHECK(cfgpack_get(&ctx, 2, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 2);
+    CHECK(cfgpack_get(&ctx, 7, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 104);
+    CHECK(cfgpack_get_dirty_count(&ctx) == 0);
+
+    unmount();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 12. Journal compaction at the size threshold and on demand
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lfs_journal_compaction) {
+    LOG_SECTION("Threshold triggers a base rewrite");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[20];
+    cfgpack_value_t values[20];
+    cfgpack_value_t out;
+    cfgpack_ctx_t ctx;
+    lfs_soff_t base_size;
+    lfs_soff_t max_seen = 0;
+    int compactions = 0;
+
+    make_schema(&schema, entries, 20);
+    cfgpack_init(&ctx, &schema, values, 20, NULL, 0, NULL, 0);
+    for (uint16_t i = 1; i <= 20; ++i) {
+        cfgpack_set_u8(&ctx, i, 0);
+    }
+
+    CHECK(mount_fresh() == 0);
+    CHECK(cfgpack_pageout_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                      sizeof(scratch), 0) == CFGPACK_OK);
+    base_size = file_size("/cfg.jnl");
+
+    for (uint8_t round = 1; round <= 30; ++round) {
+        lfs_soff_t before = file_size("/cfg.jnl");
+        CHECK(cfgpack_set_u8(&ctx, 1, round) == CFGPACK_OK);
+        CHECK(cfgpack_pageout_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                          sizeof(scratch),
+                                          (size_t)base_size * 2) ==
+              CFGPACK_OK);
+        if (file_size("/cfg.jnl") < before) {
+            compactions++;
+        }
+        if (file_size("/cfg.jnl") > max_seen) {
+            max_seen = file_size("/cfg.jnl");
+        }
+    }
+    LOG("%d compactions, file never above %ld bytes (limit %ld)",
+        compactions, (long)max_seen, (long)base_size * 2);
+    CHECK(compactions > 0);
+    CHECK(max_seen <= base_size * 2);
+
+    LOG_SECTION("Explicit compaction leaves just the base");
+    CHECK(cfgpack_set_u8(&ctx, 2, 77) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                      sizeof(scratch), 0) == CFGPACK_OK);
+    CHECK(cfgpack_lfs_journal_compact(&ctx, &lfs, "/cfg.jnl", scratch,
+                                      sizeof(scratch)) == CFGPACK_OK);
+    CHECK(file_size("/cfg.jnl") == base_size);
+
+    memset(values, 0, sizeof(values));
+    cfgpack_init(&ctx, &schema, values, 20, NULL, 0, NULL, 0);
+    CHECK(cfgpack_pagein_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                     sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 1, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 30);
+    CHECK(cfgpack_get(&ctx, 2, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 77);
+
+    unmount();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 13. Journal pagein stops at a bad record and keeps the ones before it
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lfs_journal_errors) {
+    LOG_SECTION("Plain pageout file is not a journal");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[4];
+    cfgpack_value_t values[4];
+    cfgpack_value_t out;
+    cfgpack_ctx_t ctx;
+    static const uint8_t bad_delta[] = {0x82, 0x01, 0x63, 0x02, 0xcd, 0x01,
+                                        0x2c};
+    uint8_t rec[JOURNAL_HDR + sizeof(bad_delta) + TEST_CRC_SIZE];
+    size_t rec_len;
+    lfs_file_t file;
+    lfs_soff_t size;
+    uint8_t byte;
+
+    make_schema(&schema, entries, 4);
+    cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0);
+    cfgpack_set_u8(&ctx, 1, 11);
+
+    CHECK(mount_fresh() == 0);
+    CHECK(cfgpack_pageout_lfs(&ctx, &lfs, "/plain.bin", scratch,
+                              sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_lfs_journal(&ctx, &lfs, "/plain.bin", scratch,
+                                     sizeof(scratch)) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_pagein_lfs_journal(&ctx, &lfs, "/missing.jnl", scratch,
+                                     sizeof(scratch)) == CFGPACK_ERR_IO);
+
+    LOG_SECTION("Corrupt last delta: earlier records kept");
+    CHECK(cfgpack_pageout_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                      sizeof(scratch), 0) == CFGPACK_OK);
+    cfgpack_set_u8(&ctx, 2, 22);
+    CHECK(cfgpack_pageout_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                      sizeof(scratch), 0) == CFGPACK_OK);
+    cfgpack_set_u8(&ctx, 3, 33);
+    CHECK(cfgpack_pageout_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                      sizeof(scratch), 0) == CFGPACK_OK);
+    size = file_size("/cfg.jnl");
+    CHECK(lfs_file_open(&lfs, &file, "/cfg.jnl", LFS_O_RDWR) == 0);
+    lfs_file_seek(&lfs, &file, size - 6, LFS_SEEK_SET);
+    lfs_file_read(&lfs, &file, &byte, 1);
+    byte ^= 0x01;
+    lfs_file_seek(&lfs, &file, size - 6, LFS_SEEK_SET);
+    lfs_file_write(&lfs, &file, &byte, 1);
+    lfs_file_close(&lfs, &file);
+    cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0);
+    CHECK(cfgpack_pagein_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                     sizeof(scratch)) == CFGPACK_PARTIAL);
+    CHECK(cfgpack_get(&ctx, 1, &out) == CFGPACK_OK && out.v.u64 == 11);
+    CHECK(cfgpack_get(&ctx, 2, &out) == CFGPACK_OK && out.v.u64 == 22);
+    CHECK(cfgpack_get(&ctx, 3, &out) == CFGPACK_ERR_MISSING);
+
+    LOG_SECTION("Truncated last record: earlier records kept");
+    CHECK(lfs_file_open(&lfs, &file, "/cfg.jnl", LFS_O_RDWR) == 0);
+    CHECK(lfs_file_truncate(&lfs, &file, (lfs_off_t)(size - 2)) == 0);
+    lfs_file_close(&lfs, &file);
+    cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0);
+    CHECK(cfgpack_pagein_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                     sizeof(scratch)) == CFGPACK_PARTIAL);
+    CHECK(cfgpack_get(&ctx, 2, &out) == CFGPACK_OK && out.v.u64 == 22);
+    CHECK(cfgpack_get(&ctx, 3, &out) == CFGPACK_ERR_MISSING);
+
+    LOG_SECTION("Compaction drops the bad tail");
+    CHECK(cfgpack_lfs_journal_compact(&ctx, &lfs, "/cfg.jnl", scratch,
+                                      sizeof(scratch)) == CFGPACK_OK);
+    cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0);
+    CHECK(cfgpack_pagein_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                     sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 2, &out) == CFGPACK_OK && out.v.u64 == 22);
+
+    LOG_SECTION("Delta that fails halfway: its first key is undone");
+    /* {1: 99, 2: 300} passes its CRC, but 300 does not fit entry 2's u8 */
+    memcpy(rec + JOURNAL_HDR, bad_delta, sizeof(bad_delta));
+    rec_len = sizeof(bad_delta);
+    test_append_crc(rec + JOURNAL_HDR, &rec_len);
+    rec[0] = 'D';
+    rec[1] = (uint8_t)rec_len;
+    rec[2] = rec[3] = rec[4] = 0;
+    CHECK(lfs_file_open(&lfs, &file, "/cfg.jnl",
+                        LFS_O_WRONLY | LFS_O_APPEND) == 0);
+    CHECK(lfs_file_write(&lfs, &file, rec, (lfs_size_t)(JOURNAL_HDR +
+                                                        rec_len)) ==
+          (lfs_ssize_t)(JOURNAL_HDR + rec_len));
+    lfs_file_close(&lfs, &file);
+    cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0);
+    CHECK(cfgpack_pagein_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                     sizeof(scratch)) == CFGPACK_PARTIAL);
+    CHECK(cfgpack_get(&ctx, 1, &out) == CFGPACK_OK && out.v.u64 == 11);
+    CHECK(cfgpack_get(&ctx, 2, &out) == CFGPACK_OK && out.v.u64 == 22);
+
+    LOG_SECTION("Truncated base: DECODE error");
+    CHECK(lfs_file_open(&lfs, &file, "/cfg.jnl", LFS_O_RDWR) == 0);
+    CHECK(lfs_file_truncate(&lfs, &file, 3) == 0);
+    lfs_file_close(&lfs, &file);
+    CHECK(cfgpack_pagein_lfs_journal(&ctx, &lfs, "/cfg.jnl", scratch,
+                                     sizeof(scratch)) == CFGPACK_ERR_DECODE);
+
+    unmount();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 14. A/B files: saves alternate, corrupt newest falls back
+ * ═══════════════════════════════════════════════════════════════════════════ */
+static void flip_byte(const char *path, lfs_soff_t pos) {
+    lfs_file_t file;
+    uint8_t byte;
+
+    lfs_file_open(&lfs, &file, path, LFS_O_RDWR);
+    lfs_file_seek(&lfs, &file, pos, LFS_SEEK_SET);
+    lfs_file_read(&lfs, &file, &byte, 1);
+    byte ^= 0x01;
+    lfs_file_seek(&lfs, &file, pos, LFS_SEEK_SET);
+    lfs_file_write(&lfs, &file, &byte, 1);
+    lfs_file_close(&lfs, &file);
+}
+
+TEST_CASE(test_lfs_ab) {
+    LOG_SECTION("Three saves alternate between the files");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[4];
+    cfgpack_value_t values[4];
+    cfgpack_value_t out;
+    cfgpack_ctx_t ctx;
+
+    make_schema(&schema, entries, 4);
+    cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0);
+
+    CHECK(mount_fresh() == 0);
+    CHECK(cfgpack_pagein_lfs_ab(&ctx, &lfs, "/a.bin", "/b.bin", scratch,
+                                sizeof(scratch)) == CFGPACK_ERR_MISSING);
+    for (uint8_t round = 1; round <= 3; ++round) {
+        cfgpack_set_u8(&ctx, 1, round);
+        CHECK(cfgpack_pageout_lfs_ab(&ctx, &lfs, "/a.bin", "/b.bin", scratch,
+                                     sizeof(scratch)) == CFGPACK_OK);
+    }
+    CHECK(file_size("/a.bin") > CFGPACK_SLOT_HDR_SIZE);
+    CHECK(file_size("/b.bin") > CFGPACK_SLOT_HDR_SIZE);
+
+    cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0);
+    CHECK(cfgpack_pagein_lfs_ab(&ctx, &lfs, "/a.bin", "/b.bin", scratch,
+                                sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 1, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 3);
+
+    LOG_SECTION("Newest (a, seq 3) corrupted: b (seq 2) is loaded");
+    flip_byte("/a.bin", file_size("/a.bin") - 6);
+    CHECK(cfgpack_pagein_lfs_ab(&ctx, &lfs, "/a.bin", "/b.bin", scratch,
+                                sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 1, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 2);
+
+    LOG_SECTION("Next save replaces the damaged file, not the good one");
+    cfgpack_set_u8(&ctx, 1, 4);
+    CHECK(cfgpack_pageout_lfs_ab(&ctx, &lfs, "/a.bin", "/b.bin", scratch,
+                                 sizeof(scratch)) == CFGPACK_OK);
+    flip_byte("/a.bin", file_size("/a.bin") - 6);
+    CHECK(cfgpack_pagein_lfs_ab(&ctx, &lfs, "/a.bin", "/b.bin", scratch,
+                                sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 1, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 2);
+
+    LOG_SECTION("Both damaged: CRC error");
+    flip_byte("/b.bin", file_size("/b.bin") - 6);
+    CHECK(cfgpack_pagein_lfs_ab(&ctx, &lfs, "/a.bin", "/b.bin", scratch,
+                                sizeof(scratch)) == CFGPACK_ERR_CRC);
+
+    unmount();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 15. Flash cost accounting through a metered mount
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static uint32_t fake_ticks;
+
+static uint32_t fake_clock(void *user) {
+    (void)user;
+    return (fake_ticks += 10);
+}
+
+TEST_CASE(test_lfs_meter) {
+    static cfgpack_lfs_meter_t meter;
+    static cfgpack_lfs_meter_t twice;
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[4];
+    cfgpack_value_t values[4];
+    cfgpack_lfs_cost_t saved;
+    cfgpack_ctx_t ctx;
+
+    LOG_SECTION("Argument checks");
+    CHECK(cfgpack_lfs_meter_init(NULL, &lfs_cfg, NULL, NULL) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_lfs_meter_init(&meter, NULL, NULL, NULL) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_lfs_meter_init(&meter, &lfs_cfg, fake_clock, NULL) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_lfs_meter_init(&twice, &meter.cfg, NULL, NULL) ==
+          CFGPACK_ERR_ARGS);
+
+    make_schema(&schema, entries, 4);
+    cfgpack_init(&ctx, &schema, values, 4, NULL, 0, NULL, 0);
+    cfgpack_set_u8(&ctx, 1, 7);
+
+    LOG_SECTION("Format and mount are counted in total only");
+    CHECK(lfs_format(&lfs, &meter.cfg) == 0);
+    CHECK(lfs_mount(&lfs, &meter.cfg) == 0);
+    CHECK(meter.total.erases > 0 && meter.total.progs > 0);
+    CHECK(meter.last.progs == 0);
+
+    LOG_SECTION("Pageout: programs whole prog_size units, erases blocks");
+    saved = meter.total;
+    CHECK(cfgpack_pageout_lfs(&ctx, &lfs, "/m.bin", scratch,
+                              sizeof(scratch)) == CFGPACK_OK);
+    LOG("pageout: %u progs / %u B, %u erases, %u syncs, %u ticks",
+        (unsigned)meter.last.progs, (unsigned)meter.last.prog_bytes,
+        (unsigned)meter.last.erases, (unsigned)meter.last.syncs,
+        (unsigned)meter.last.ticks);
+    CHECK(meter.last.progs > 0);
+    CHECK(meter.last.prog_bytes % BLOCK_SIZE == 0);
+    CHECK(meter.last.prog_bytes >= (uint32_t)file_size("/m.bin"));
+    CHECK(meter.last.erases > 0);
+    CHECK(meter.last.syncs > 0);
+    CHECK(meter.total.progs - saved.progs == meter.last.progs);
+    CHECK(meter.last.flash_ticks > 0);
+    CHECK(meter.last.ticks >= meter.last.flash_ticks);
+
+    LOG_SECTION("Pagein: reads only");
+    CHECK(cfgpack_pagein_lfs(&ctx, &lfs, "/m.bin", scratch,
+                             sizeof(scratch)) == CFGPACK_OK);
+    CHECK(meter.last.read_bytes > 0);
+    CHECK(meter.last.progs == 0 && meter.last.erases == 0);
+
+    LOG_SECTION("A/B save is charged as one operation");
+    CHECK(cfgpack_pageout_lfs_ab(&ctx, &lfs, "/a.bin", "/b.bin", scratch,
+                                 sizeof(scratch)) == CFGPACK_OK);
+    CHECK(meter.last.reads > 0 && meter.last.progs > 0);
+
+    LOG_SECTION("Reset zeroes the counters");
+    cfgpack_lfs_meter_reset(&meter);
+    CHECK(meter.total.progs == 0 && meter.last.progs == 0);
+    lfs_unmount(&lfs);
+
+    LOG_SECTION("Unmetered mount leaves the meter alone");
+    CHECK(mount_fresh() == 0);
+    CHECK(cfgpack_pageout_lfs(&ctx, &lfs, "/m.bin", scratch,
+                              sizeof(scratch)) == CFGPACK_OK);
+    CHECK(meter.total.progs == 0 && meter.last.progs == 0);
+
+    unmount();
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 16. Several contexts in one bundle file
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_lfs_bundle) {
+    cfgpack_schema_t schema[3];
+    cfgpack_entry_t entries[3][4];
+    cfgpack_value_t values[3][4];
+    cfgpack_ctx_t ctx[3];
+    cfgpack_ctx_t *ctxs[3] = {&ctx[0], &ctx[1], &ctx[2]};
+    cfgpack_value_t out;
+    size_t kept = 99;
+
+    for (int i = 0; i < 3; ++i) {
+        make_schema(&schema[i], entries[i], 4);
+        snprintf(schema[i].map_name, sizeof(schema[i].map_name), "ns%d", i);
+        cfgpack_init(&ctx[i], &schema[i], values[i], 4, NULL, 0, NULL, 0);
+        cfgpack_set_u8(&ctx[i], 1, (uint8_t)(10 + i));
+    }
+    CHECK(mount_fresh() == 0);
+
+    LOG_SECTION("First save encodes every section");
+    CHECK(cfgpack_pageout_lfs_bundle(ctxs, 3, &lfs, "/ns.bin", scratch,
+                                     sizeof(scratch), &kept) == CFGPACK_OK);
+    CHECK(kept == 0);
+    LOG("Bundle file: %d bytes", (int)file_size("/ns.bin"));
+
+    LOG_SECTION("One read loads all of them");
+    for (int i = 0; i < 3; ++i) {
+        cfgpack_init(&ctx[i], &schema[i], values[i], 4, NULL, 0, NULL, 0);
+    }
+    CHECK(cfgpack_pagein_lfs_bundle(ctxs, 3, &lfs, "/ns.bin", scratch,
+                                    sizeof(scratch)) == CFGPACK_OK);
+    for (int i = 0; i < 3; ++i) {
+        CHECK(cfgpack_get(&ctx[i], 1, &out) == CFGPACK_OK);
+        CHECK(out.v.u64 == (uint64_t)(10 + i));
+    }
+
+    LOG_SECTION("Second save re-encodes only the changed section");
+    cfgpack_set_u8(&ctx[1], 2, 77);
+    CHECK(cfgpack_pageout_lfs_bundle(ctxs, 3, &lfs, "/ns.bin", scratch,
+                                     sizeof(scratch), &kept) == CFGPACK_OK);
+    CHECK(kept == 2);
+    cfgpack_init(&ctx[1], &schema[1], values[1], 4, NULL, 0, NULL, 0);
+    CHECK(cfgpack_pagein_lfs_bundle(&ctxs[1], 1, &lfs, "/ns.bin", scratch,
+                                    sizeof(scratch)) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx[1], 2, &out) == CFGPACK_OK);
+    CHECK(out.v.u64 == 77);
+
+    LOG_SECTION("Missing file and short scratch");
+    CHECK(cfgpack_pagein_lfs_bundle(ctxs, 3, &lfs, "/none.bin", scratch,
+                                    sizeof(scratch)) == CFGPACK_ERR_IO);
+    CHECK(cfgpack_pagein_lfs_bundle(ctxs, 3, &lfs, "/ns.bin", scratch,
+                                    BLOCK_SIZE + 8) == CFGPACK_ERR_BOUNDS);
+    cfgpack_set_u8(&ctx[0], 3, 1);
+    CHECK(cfgpack_pageout_lfs_bundle(ctxs, 3, &lfs, "/ns.bin", scratch,
+                                     BLOCK_SIZE + 8, NULL) ==
+          CFGPACK_ERR_ENCODE);
+    CHECK(cfgpack_get_dirty_count(&ctx[0]) > 0);
+
+    unmount();
+    return (TEST_OK);
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Test runner
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -413,6 +956,19 @@ int main(void) {
     overall |= (test_case_result("lfs_scratch_below_cache_size",
                                  test_lfs_scratch_below_cache_size()) !=
                 TEST_OK);
+    overall |= (test_case_result("lfs_pageout_small_chunk",
+                                 test_lfs_pageout_small_chunk()) != TEST_OK);
+    overall |= (test_case_result("lfs_pagein_stream_window",
+                                 test_lfs_pagein_stream_window()) != TEST_OK);
+    overall |= (test_case_result("lfs_journal_roundtrip",
+                                 test_lfs_journal_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("lfs_journal_compaction",
+                                 test_lfs_journal_compaction()) != TEST_OK);
+    overall |= (test_case_result("lfs_journal_errors",
+                                 test_lfs_journal_errors()) != TEST_OK);
+    overall |= (test_case_result("lfs_ab", test_lfs_ab()) != TEST_OK);
+    overall |= (test_case_result("lfs_meter", test_lfs_meter()) != TEST_OK);
+    overall |= (test_case_result("lfs_bundle", test_lfs_bundle()) != TEST_OK);
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
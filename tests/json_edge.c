@@ -2,6 +2,7 @@
 
 #include "cfgpack/cfgpack.h"
 
+#include "fixture.h"
 #include "test.h"
 
 #include <stdio.h>
@@ -263,6 +264,7 @@ TEST_CASE(test_json_writer_small_buffer) {
     snprintf(entries[0].name, sizeof(entries[0].name), "foo");
     entries[0].type = CFGPACK_TYPE_U8;
     entries[0].has_default = 1;
+    entries[0].str_max = 0;
 
     CHECK(cfgpack_init(&ctx, &schema, values, 1, str_pool, sizeof(str_pool),
                        str_offsets, 0) == CFGPACK_OK);
@@ -288,6 +290,373 @@ TEST_CASE(test_json_writer_small_buffer) {
     return TEST_OK;
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 9. String defaults of unsorted entries land in their sorted slots
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_json_parse_unsorted_str_defaults) {
+    LOG_SECTION("Unsorted entries, escapes, value before type");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[4];
+    cfgpack_value_t values[4];
+    char str_pool[256];
+    uint16_t str_offsets[3];
+    cfgpack_parse_error_t err;
+    cfgpack_parse_opts_t opts = {&schema,     entries,  4,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 3,        &err};
+    cfgpack_ctx_t ctx;
+    const char *s;
+    uint16_t slen;
+    uint8_t flen;
+    uint32_t u;
+
+    const char *json =
+        "{\"name\": \"t\", \"version\": 1, \"entries\": ["
+        "{\"index\": 9, \"name\": \"c\", \"value\": \"q\\\"x\", "
+        "\"type\": \"str\"},"
+        "{\"index\": 2, \"name\": \"a\", \"type\": \"fstr\", "
+        "\"value\": \"a\\tb\"},"
+        "{\"index\": 5, \"name\": \"b\", \"type\": \"u32\", \"value\": 7},"
+        "{\"index\": 3, \"name\": \"d\", \"type\": \"str\", \"value\": null}"
+        "]}";
+
+    CHECK(parse_json(json, &opts) == CFGPACK_OK);
+    CHECK(cfgpack_init(&ctx, &schema, values, 4, str_pool, sizeof(str_pool),
+                       str_offsets, 3) == CFGPACK_OK);
+    CHECK(cfgpack_get_fstr(&ctx, 2, &s, &flen) == CFGPACK_OK);
+    CHECK(flen == 3 && strcmp(s, "a\tb") == 0);
+    CHECK(cfgpack_get_str(&ctx, 9, &s, &slen) == CFGPACK_OK);
+    CHECK(slen == 3 && strcmp(s, "q\"x") == 0);
+    CHECK(cfgpack_get_str(&ctx, 3, &s, &slen) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_u32(&ctx, 5, &u) == CFGPACK_OK && u == 7);
+    LOG("Defaults stored at sorted slots 0 and 2");
+
+    LOG_SECTION("Default kind must match the entry type");
+    const char *num_for_str =
+        "{\"name\": \"t\", \"version\": 1, \"entries\": ["
+        "{\"index\": 1, \"name\": \"a\", \"type\": \"str\", \"value\": 5}]}";
+    const char *str_for_num =
+        "{\"name\": \"t\", \"version\": 1, \"entries\": ["
+        "{\"index\": 1, \"name\": \"a\", \"type\": \"u8\", \"value\": \"5\"}]}";
+    CHECK(parse_json(num_for_str, &opts) == CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(parse_json(str_for_num, &opts) == CFGPACK_ERR_TYPE_MISMATCH);
+    LOG("Correctly returned: CFGPACK_ERR_TYPE_MISMATCH (%s)", err.message);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 10. Config values: JSON export and import round trip
+ * ═══════════════════════════════════════════════════════════════════════════ */
+static const char values_map[] = "vals 1\n"
+                                 "1 port u16 8080\n"
+                                 "2 big u64 0\n"
+                                 "3 ofs i8 -3\n"
+                                 "4 gain f32 1.5\n"
+                                 "5 host str \"example.org\"\n"
+                                 "6 mode fstr \"fast\"\n"
+                                 "7 key str NIL\n";
+
+TEST_CASE(test_values_json_roundtrip) {
+    LOG_SECTION("values_write_json measures, writes; values_parse_json loads");
+
+    static fixture_t a;
+    static fixture_t b;
+    cfgpack_parse_error_t err;
+    char out[512];
+    char again[512];
+    size_t need = 0;
+    size_t len = 0;
+    const char *s;
+    uint16_t slen;
+    uint64_t big;
+    int8_t ofs;
+
+    CHECK(fixture_parse(&a, values_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&b, values_map) == CFGPACK_OK);
+
+    CHECK(cfgpack_values_write_json(&a.ctx, NULL, 0, &need, &err) ==
+          CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_values_write_json(&a.ctx, out, need, &len, &err) ==
+          CFGPACK_OK);
+    CHECK(len == need);
+    LOG("defaults: %.*s", (int)len - 1, out);
+    CHECK(memcmp(out,
+                 "{\"port\":8080,\"big\":0,\"ofs\":-3,\"gain\":1.5,"
+                 "\"host\":\"example.org\",\"mode\":\"fast\"}\n",
+                 len) == 0);
+
+    LOG("Extremes and escapes survive the round trip");
+    CHECK(cfgpack_set_u64(&a.ctx, 2, UINT64_MAX) == CFGPACK_OK);
+    CHECK(cfgpack_set_i8(&a.ctx, 3, INT8_MIN) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&a.ctx, 5, "a\"b\\c\n\x01") == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&a.ctx, 7, "k") == CFGPACK_OK);
+    CHECK(cfgpack_values_write_json(&a.ctx, out, sizeof(out), &len, &err) ==
+          CFGPACK_OK);
+    LOG("set: %.*s", (int)len - 1, out);
+    CHECK(cfgpack_values_parse_json(&b.ctx, out, len, &err) == CFGPACK_OK);
+    CHECK(cfgpack_get_u64(&b.ctx, 2, &big) == CFGPACK_OK);
+    CHECK(big == UINT64_MAX);
+    CHECK(cfgpack_get_i8(&b.ctx, 3, &ofs) == CFGPACK_OK && ofs == INT8_MIN);
+    CHECK(cfgpack_get_str(&b.ctx, 5, &s, &slen) == CFGPACK_OK);
+    CHECK(slen == 7 && strcmp(s, "a\"b\\c\n\x01") == 0);
+    CHECK(cfgpack_get_str(&b.ctx, 7, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "k") == 0);
+    CHECK(cfgpack_values_write_json(&b.ctx, again, sizeof(again), &need,
+                                    &err) == CFGPACK_OK);
+    CHECK(need == len && memcmp(again, out, len) == 0);
+
+    LOG("Subsets in any order, whitespace allowed");
+    const char *part = " { \"gain\" : 2 , \"port\": 1 }\n";
+    uint16_t port;
+    float gain;
+    CHECK(cfgpack_values_parse_json(&b.ctx, part, strlen(part), &err) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_get_u16(&b.ctx, 1, &port) == CFGPACK_OK && port == 1);
+    CHECK(cfgpack_get_f32(&b.ctx, 4, &gain) == CFGPACK_OK && gain == 2.0f);
+    CHECK(cfgpack_values_parse_json(&b.ctx, "{}", 2, &err) == CFGPACK_OK);
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 11. Config values: a rejected document changes nothing
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_values_json_reject) {
+    LOG_SECTION("Invalid values documents are refused whole");
+
+    static fixture_t f;
+    cfgpack_parse_error_t err;
+    static const struct {
+        const char *json;
+        cfgpack_err_t rc;
+    } bad[] = {
+        {"{\"port\":1,\"nope\":2}", CFGPACK_ERR_MISSING},
+        {"{\"port\":1,\"port\":65536}", CFGPACK_ERR_BOUNDS},
+        {"{\"port\":1,\"big\":-1}", CFGPACK_ERR_BOUNDS},
+        {"{\"port\":1,\"big\":18446744073709551616}", CFGPACK_ERR_BOUNDS},
+        {"{\"port\":1,\"ofs\":-129}", CFGPACK_ERR_BOUNDS},
+        {"{\"port\":1,\"ofs\":1.5}", CFGPACK_ERR_TYPE_MISMATCH},
+        {"{\"port\":1,\"host\":7}", CFGPACK_ERR_TYPE_MISMATCH},
+        {"{\"port\":1,\"port\":\"7\"}", CFGPACK_ERR_PARSE},
+        {"{\"port\":1,\"mode\":\"seventeen-chars!!\"}",
+         CFGPACK_ERR_STR_TOO_LONG},
+        {"{\"port\":1,\"host\":\"a\\u0000b\"}", CFGPACK_ERR_PARSE},
+        {"{\"port\":1,", CFGPACK_ERR_PARSE},
+        {"{\"port\":1} x", CFGPACK_ERR_PARSE},
+        {"[]", CFGPACK_ERR_PARSE},
+    };
+    uint16_t port;
+
+    CHECK(fixture_parse(&f, values_map) == CFGPACK_OK);
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        cfgpack_err_t rc = cfgpack_values_parse_json(&f.ctx, bad[i].json,
+                                                     strlen(bad[i].json),
+                                                     &err);
+        LOG("%-40s -> %d (%s)", bad[i].json, rc, err.message);
+        CHECK(rc == bad[i].rc);
+        CHECK(cfgpack_get_u16(&f.ctx, 1, &port) == CFGPACK_OK);
+        CHECK(port == 8080);
+    }
+
+    CHECK(cfgpack_values_parse_json(NULL, "{}", 2, &err) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_values_parse_json(&f.ctx, NULL, 0, &err) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_values_write_json(NULL, NULL, 0, NULL, &err) ==
+          CFGPACK_ERR_ARGS);
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 12. Floats are written as their shortest round-trip decimal
+ * ═══════════════════════════════════════════════════════════════════════════ */
+static const char float_map[] = "flts 1\n"
+                                "1 f f32 0\n"
+                                "2 d f64 0\n";
+
+TEST_CASE(test_values_json_floats) {
+    LOG_SECTION("Shortest round-trip f32/f64 formatting");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[2];
+    cfgpack_value_t values[2];
+    cfgpack_parse_error_t err;
+    cfgpack_parse_opts_t opts = {&schema, entries, 2,    values, NULL,
+                                 0,       NULL,    0,    &err};
+    cfgpack_ctx_t ctx;
+    char out[128];
+    size_t len;
+    static const struct {
+        float f;
+        double d;
+        const char *json;
+    } cases[] = {
+        {0.1f, 0.1, "{\"f\":0.1,\"d\":0.1}\n"},
+        {1.5f, 8080.0, "{\"f\":1.5,\"d\":8080}\n"},
+        {-0.0f, 1e21, "{\"f\":-0,\"d\":1e+21}\n"},
+        {3.4028235e38f, 1e-7, "{\"f\":3.4028235e+38,\"d\":1e-07}\n"},
+        {1e-45f, 5e-324, "{\"f\":1e-45,\"d\":5e-324}\n"},
+        {16777216.0f, 1.7976931348623157e308,
+         "{\"f\":16777216,\"d\":1.7976931348623157e+308}\n"},
+        {0.001f, 123456.789, "{\"f\":0.001,\"d\":123456.789}\n"},
+    };
+
+    CHECK(cfgpack_parse_schema(float_map, sizeof(float_map) - 1, &opts) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_init(&ctx, &schema, values, 2, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        CHECK(cfgpack_set_f32(&ctx, 1, cases[i].f) == CFGPACK_OK);
+        CHECK(cfgpack_set_f64(&ctx, 2, cases[i].d) == CFGPACK_OK);
+        CHECK(cfgpack_values_write_json(&ctx, out, sizeof(out), &len, &err) ==
+              CFGPACK_OK);
+        LOG("%.*s", (int)len - 1, out);
+        CHECK(len == strlen(cases[i].json));
+        CHECK(memcmp(out, cases[i].json, len) == 0);
+    }
+
+    LOG("Random bit patterns read back bit-exact");
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 20000; ++i) {
+        uint64_t dbits;
+        uint32_t fbits;
+        float f;
+        double d;
+        float f2;
+        double d2;
+
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        dbits = x;
+        fbits = (uint32_t)(x >> 17);
+        memcpy(&d, &dbits, sizeof(d));
+        memcpy(&f, &fbits, sizeof(f));
+        if (d != d || d - d != 0 || f != f || f - f != 0) {
+            continue; /* NaN and infinities are not JSON numbers */
+        }
+        CHECK(cfgpack_set_f32(&ctx, 1, f) == CFGPACK_OK);
+        CHECK(cfgpack_set_f64(&ctx, 2, d) == CFGPACK_OK);
+        CHECK(cfgpack_values_write_json(&ctx, out, sizeof(out), &len, &err) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_set_f32(&ctx, 1, 0) == CFGPACK_OK);
+        CHECK(cfgpack_set_f64(&ctx, 2, 0) == CFGPACK_OK);
+        CHECK(cfgpack_values_parse_json(&ctx, out, len, &err) == CFGPACK_OK);
+        CHECK(cfgpack_get_f32(&ctx, 1, &f2) == CFGPACK_OK);
+        CHECK(cfgpack_get_f64(&ctx, 2, &d2) == CFGPACK_OK);
+        CHECK(memcmp(&f, &f2, sizeof(f)) == 0);
+        CHECK(memcmp(&d, &d2, sizeof(d)) == 0);
+    }
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 13. Strings and whitespace across scan word boundaries
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_json_scan_boundaries) {
+    LOG_SECTION("Escapes and blank runs at every offset parse identically");
+
+    static fixture_t f;
+    static char doc[256];
+    char want[CFGPACK_STR_MAX + 2];
+    cfgpack_parse_error_t err;
+    const char *s;
+    uint16_t slen;
+    size_t len;
+
+    CHECK(fixture_parse(&f, values_map) == CFGPACK_OK);
+
+    /* Each string length up to one past CFGPACK_STR_MAX, with no escape
+     * or one escaped quote/backslash at each position, behind a blank run
+     * whose length also varies. */
+    for (size_t n = 0; n <= CFGPACK_STR_MAX + 1; ++n) {
+        for (size_t esc = 0; esc <= n; ++esc) {
+            size_t blanks = (n * 7 + esc) % 41;
+            char *d = doc;
+
+            *d++ = '\n';
+            memset(d, ' ', blanks);
+            d += blanks;
+            d += sprintf(d, "{\"host\":%*s\"", (int)(esc % 19), "");
+            for (size_t i = 0; i < n; ++i) {
+                char c = (char)('a' + i % 26);
+                if (i == esc) {
+                    c = (i & 1) ? '\\' : '"';
+                    *d++ = '\\';
+                }
+                want[i] = c;
+                *d++ = c;
+            }
+            want[n] = '\0';
+            d += sprintf(d, "\"}");
+            len = (size_t)(d - doc);
+
+            cfgpack_err_t rc = cfgpack_values_parse_json(&f.ctx, doc, len,
+                                                         &err);
+            if (n > CFGPACK_STR_MAX) {
+                CHECK(rc != CFGPACK_OK);
+                continue;
+            }
+            CHECK(rc == CFGPACK_OK);
+            CHECK(cfgpack_get_str(&f.ctx, 5, &s, &slen) == CFGPACK_OK);
+            CHECK(slen == n && memcmp(s, want, n) == 0);
+        }
+    }
+
+    LOG("Line numbers count newlines between blank runs");
+    len = (size_t)sprintf(doc, "{\n%40s\"port\": 1,\n%17s\n  \"nope\": 2}",
+                          "", "");
+    CHECK(cfgpack_values_parse_json(&f.ctx, doc, len, &err) ==
+          CFGPACK_ERR_MISSING);
+    LOG("error on line %zu: %s", err.line, err.message);
+    CHECK(err.line == 4);
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 14. 64-bit integer extremes round trip
+ * ═══════════════════════════════════════════════════════════════════════════ */
+static const char int64_map[] = "ints 1\n"
+                                "1 lo i64 0\n"
+                                "2 hi i64 0\n";
+
+TEST_CASE(test_values_json_int64) {
+    LOG_SECTION("INT64_MIN and INT64_MAX are written and read back");
+
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[2];
+    cfgpack_value_t values[2];
+    cfgpack_parse_error_t err;
+    cfgpack_parse_opts_t opts = {&schema, entries, 2,    values, NULL,
+                                 0,       NULL,    0,    &err};
+    cfgpack_ctx_t ctx;
+    char out[128];
+    size_t len;
+    int64_t lo;
+    int64_t hi;
+
+    CHECK(cfgpack_parse_schema(int64_map, sizeof(int64_map) - 1, &opts) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_init(&ctx, &schema, values, 2, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_set_i64(&ctx, 1, INT64_MIN) == CFGPACK_OK);
+    CHECK(cfgpack_set_i64(&ctx, 2, INT64_MAX) == CFGPACK_OK);
+    CHECK(cfgpack_values_write_json(&ctx, out, sizeof(out), &len, &err) ==
+          CFGPACK_OK);
+    LOG("%.*s", (int)len - 1, out);
+    CHECK(memcmp(out,
+                 "{\"lo\":-9223372036854775808,"
+                 "\"hi\":9223372036854775807}\n",
+                 len) == 0);
+
+    CHECK(cfgpack_set_i64(&ctx, 1, 0) == CFGPACK_OK);
+    CHECK(cfgpack_set_i64(&ctx, 2, 0) == CFGPACK_OK);
+    CHECK(cfgpack_values_parse_json(&ctx, out, len, &err) == CFGPACK_OK);
+    CHECK(cfgpack_get_i64(&ctx, 1, &lo) == CFGPACK_OK && lo == INT64_MIN);
+    CHECK(cfgpack_get_i64(&ctx, 2, &hi) == CFGPACK_OK && hi == INT64_MAX);
+    return TEST_OK;
+}
+
 int main(void) {
     test_result_t overall = TEST_OK;
 
@@ -308,6 +677,19 @@ int main(void) {
                                  test_json_parse_reserved_index()) != TEST_OK);
     overall |= (test_case_result("json_writer_small_buffer",
                                  test_json_writer_small_buffer()) != TEST_OK);
+    overall |= (test_case_result("json_parse_unsorted_str_defaults",
+                                 test_json_parse_unsorted_str_defaults()) !=
+                TEST_OK);
+    overall |= (test_case_result("values_json_roundtrip",
+                                 test_values_json_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("values_json_reject",
+                                 test_values_json_reject()) != TEST_OK);
+    overall |= (test_case_result("values_json_floats",
+                                 test_values_json_floats()) != TEST_OK);
+    overall |= (test_case_result("json_scan_boundaries",
+                                 test_json_scan_boundaries()) != TEST_OK);
+    overall |= (test_case_result("values_json_int64",
+                                 test_values_json_int64()) != TEST_OK);
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
@@ -0,0 +1,296 @@
+/* Large-schema limits: a schema with more entries, string slots and pool
+ * bytes than the default build can address.  Under CFGPACK_LARGE_SCHEMA
+ * (make test-large-schema) it parses and round-trips with caller-owned
+ * bitmaps; the default build must reject it and keep its compact layout.
+ */
+
+#include "cfgpack/cfgpack.h"
+
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* 1200 entries: every 8th a u16, the rest 1050 str slots of 65 bytes,
+ * so the pool (68250 bytes) overflows a 16-bit offset. */
+#define N_ENTRIES 1200
+#define N_STR (N_ENTRIES - N_ENTRIES / 8)
+
+static char map[N_ENTRIES * 24 + 16];
+static cfgpack_entry_t entries[N_ENTRIES];
+static cfgpack_value_t values[N_ENTRIES];
+static char str_pool[N_STR * (CFGPACK_STR_MAX + 1)];
+static cfgpack_str_off_t str_offsets[N_STR];
+
+/* Build the .map text; entry i+1 is "e<i>", defaulting to "v<i>" or i. */
+static size_t build_map(void) {
+    size_t len = (size_t)snprintf(map, sizeof(map), "big 1\n");
+
+    for (int i = 0; i < N_ENTRIES; ++i) {
+        if (i % 8 == 0) {
+            len += (size_t)snprintf(map + len, sizeof(map) - len,
+                                    "%d e%d u16 %d\n", i + 1, i, i);
+        } else {
+            len += (size_t)snprintf(map + len, sizeof(map) - len,
+                                    "%d e%d str \"v%d\"\n", i + 1, i, i);
+        }
+    }
+    return (len);
+}
+
+static cfgpack_err_t parse_big(cfgpack_schema_t *schema,
+                               cfgpack_parse_error_t *perr) {
+    size_t len = build_map();
+    cfgpack_parse_opts_t opts = {schema,      entries, N_ENTRIES, values,
+                                 str_pool,    sizeof(str_pool),
+                                 str_offsets, N_STR,   perr};
+
+    return (cfgpack_parse_schema(map, len, &opts));
+}
+
+#ifdef CFGPACK_LARGE_SCHEMA
+
+static uint8_t bits[CFGPACK_BITMAP_BYTES(N_ENTRIES)];
+static uint8_t blob[32768];
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Measure, parse and init past the default limits
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_large_init) {
+    LOG_SECTION("Schema beyond 128 entries, 255 slots and 64 KiB of pool");
+
+    cfgpack_schema_measure_t m;
+    cfgpack_schema_t schema;
+    cfgpack_parse_error_t perr;
+    cfgpack_ctx_t ctx;
+    size_t len = build_map();
+
+    CHECK(cfgpack_schema_measure(map, len, &m, &perr) == CFGPACK_OK);
+    CHECK(m.entry_count == N_ENTRIES && m.str_count == N_STR);
+    CHECK(m.str_pool_size > UINT16_MAX);
+    LOG("%zu entries, %zu strings, %zu pool bytes", m.entry_count,
+        m.str_count, m.str_pool_size);
+    CHECK(parse_big(&schema, &perr) == CFGPACK_OK);
+
+    /* Bitmaps too small for the schema */
+    CHECK(cfgpack_ctx_bitmaps(&ctx, bits, CFGPACK_BITMAP_BYTES(128)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_init(&ctx, &schema, values, N_ENTRIES, str_pool,
+                       sizeof(str_pool), str_offsets,
+                       N_STR) == CFGPACK_ERR_BOUNDS);
+    LOG("128-entry bitmaps rejected with ERR_BOUNDS");
+
+    CHECK(cfgpack_ctx_bitmaps(NULL, bits, sizeof(bits)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_ctx_bitmaps(&ctx, bits, sizeof(bits)) == CFGPACK_OK);
+    CHECK(cfgpack_init(&ctx, &schema, values, N_ENTRIES, str_pool,
+                       sizeof(str_pool), str_offsets, N_STR) == CFGPACK_OK);
+
+    /* Last string: slot 1049, pool offset past 64 KiB */
+    const char *s;
+    uint16_t slen;
+    CHECK(entries[N_ENTRIES - 1].str_slot == N_STR - 1);
+    CHECK(cfgpack_get_str(&ctx, N_ENTRIES, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "v1199") == 0);
+    CHECK(s - str_pool > UINT16_MAX);
+    LOG("Entry %d (slot %u) read at pool offset %ld", N_ENTRIES,
+        (unsigned)entries[N_ENTRIES - 1].str_slot, (long)(s - str_pool));
+
+    cfgpack_value_t v;
+    CHECK(cfgpack_get(&ctx, 1153, &v) == CFGPACK_OK);
+    CHECK(v.v.u64 == 1152);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Pageout, delta pageout and pagein with caller-owned bitmaps
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_large_roundtrip) {
+    LOG_SECTION("Pageout/pagein round-trip of a large schema");
+
+    cfgpack_schema_t schema;
+    cfgpack_parse_error_t perr;
+    cfgpack_ctx_t ctx;
+    size_t blob_len = 0;
+    const char *s;
+    uint16_t slen;
+
+    CHECK(parse_big(&schema, &perr) == CFGPACK_OK);
+    CHECK(cfgpack_ctx_bitmaps(&ctx, bits, sizeof(bits)) == CFGPACK_OK);
+    CHECK(cfgpack_init(&ctx, &schema, values, N_ENTRIES, str_pool,
+                       sizeof(str_pool), str_offsets, N_STR) == CFGPACK_OK);
+
+    CHECK(cfgpack_get_size(&ctx) == N_ENTRIES);
+    cfgpack_dirty_clear_all(&ctx);
+    CHECK(cfgpack_set_str(&ctx, 1198, "changed") == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&ctx, 1001, 4242) == CFGPACK_OK);
+    CHECK(cfgpack_get_dirty_count(&ctx) == 2);
+    CHECK(cfgpack_pageout_delta(&ctx, blob, sizeof(blob), &blob_len) ==
+          CFGPACK_OK);
+    CHECK(blob_len < 32);
+    LOG("Delta of 2 entries: %zu bytes", blob_len);
+
+    CHECK(cfgpack_pageout(&ctx, blob, sizeof(blob), &blob_len) == CFGPACK_OK);
+    LOG("Full blob: %zu bytes", blob_len);
+
+    /* Fresh context from the same schema text, then load the blob */
+    CHECK(parse_big(&schema, &perr) == CFGPACK_OK);
+    CHECK(cfgpack_ctx_bitmaps(&ctx, bits, sizeof(bits)) == CFGPACK_OK);
+    CHECK(cfgpack_init(&ctx, &schema, values, N_ENTRIES, str_pool,
+                       sizeof(str_pool), str_offsets, N_STR) == CFGPACK_OK);
+    CHECK(cfgpack_get_str(&ctx, 1198, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "v1197") == 0);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, blob_len) == CFGPACK_OK);
+
+    uint16_t u;
+    CHECK(cfgpack_get_str(&ctx, 1198, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "changed") == 0);
+    CHECK(cfgpack_get_u16(&ctx, 1001, &u) == CFGPACK_OK);
+    CHECK(u == 4242);
+    CHECK(cfgpack_get_str(&ctx, 2, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "v1") == 0);
+    LOG("Values restored past entry 1000 and pool offset 64 KiB");
+
+    return TEST_OK;
+}
+
+/* 65535 u8 entries: with the name and header keys the map has more than
+ * 0xffff keys, so a full pageout needs a map32 header. */
+#define N_WIDE 65535
+
+static cfgpack_entry_t wide_entries[N_WIDE];
+static cfgpack_value_t wide_values[N_WIDE];
+static uint8_t wide_bits[CFGPACK_BITMAP_BYTES(N_WIDE)];
+static uint8_t wide_slow[N_WIDE * 4 + 128];
+static uint8_t wide_fast[N_WIDE * 4 + 128];
+
+static cfgpack_err_t init_wide(cfgpack_schema_t *schema, cfgpack_ctx_t *ctx) {
+    memset(schema, 0, sizeof(*schema));
+    memset(wide_entries, 0, sizeof(wide_entries));
+    memset(wide_values, 0, sizeof(wide_values));
+    snprintf(schema->map_name, sizeof(schema->map_name), "wide");
+    schema->version = 1;
+    schema->entries = wide_entries;
+    schema->entry_count = N_WIDE;
+    for (unsigned i = 0; i < N_WIDE; ++i) {
+        wide_entries[i].index = (uint16_t)(i + 1);
+        snprintf(wide_entries[i].name, sizeof(wide_entries[i].name), "e%x",
+                 i);
+        wide_entries[i].type = CFGPACK_TYPE_U8;
+        wide_entries[i].has_default = 1;
+        wide_entries[i].str_slot = CFGPACK_STR_SLOT_NONE;
+        wide_values[i].type = CFGPACK_TYPE_U8;
+        wide_values[i].v.u64 = i & 0x7f;
+    }
+    if (cfgpack_ctx_bitmaps(ctx, wide_bits, sizeof(wide_bits)) !=
+        CFGPACK_OK) {
+        return (CFGPACK_ERR_BOUNDS);
+    }
+    return (cfgpack_init(ctx, schema, wide_values, N_WIDE, NULL, 0, NULL, 0));
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. More than 0xffff map keys: map32 on the cached and the checked paths
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_large_map32) {
+    LOG_SECTION("65535 entries plus name and header keys need map32");
+
+    cfgpack_schema_t schema;
+    cfgpack_ctx_t ctx;
+    size_t slow_len = 0;
+    size_t fast_len = 0;
+    size_t measured = 0;
+    cfgpack_value_t v;
+
+    CHECK(init_wide(&schema, &ctx) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, wide_slow, sizeof(wide_slow), &slow_len) ==
+          CFGPACK_OK);
+    CHECK(wide_slow[0] == 0xdf);
+    LOG("Checked pageout: %zu bytes, header 0x%02x", slow_len, wide_slow[0]);
+
+  #ifdef CFGPACK_SIZE_CACHE
+    LOG_SECTION("Size cache measure and unchecked pageout agree");
+    CHECK(cfgpack_size_cache_init(&ctx) == CFGPACK_OK);
+  #endif
+    CHECK(cfgpack_pageout_measure(&ctx, &measured) == CFGPACK_OK);
+    CHECK(measured == slow_len);
+    CHECK(cfgpack_pageout(&ctx, wide_fast, measured, &fast_len) ==
+          CFGPACK_OK);
+    CHECK(fast_len == slow_len);
+    CHECK(memcmp(wide_fast, wide_slow, slow_len) == 0);
+    LOG("Measure %zu bytes, pageout into that size identical", measured);
+
+    LOG_SECTION("The map32 blob pages back in");
+    CHECK(init_wide(&schema, &ctx) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&ctx, N_WIDE, 0) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, wide_fast, fast_len) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, N_WIDE, &v) == CFGPACK_OK);
+    CHECK(v.v.u64 == ((N_WIDE - 1) & 0x7f));
+
+    return TEST_OK;
+}
+
+#else /* !CFGPACK_LARGE_SCHEMA */
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Default build: compact layout and limits are unchanged
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_default_footprint) {
+    LOG_SECTION("Default build keeps inline bitmaps and narrow slots");
+
+    cfgpack_ctx_t ctx;
+
+    CHECK(sizeof(cfgpack_entry_t) == 16);
+    CHECK(sizeof(cfgpack_value_t) == 16);
+    CHECK(sizeof(cfgpack_str_slot_t) == 1);
+    CHECK(sizeof(cfgpack_str_off_t) == 2);
+    CHECK(sizeof(ctx.present) == CFGPACK_PRESENCE_BYTES);
+    CHECK(sizeof(ctx.dirty) == CFGPACK_PRESENCE_BYTES);
+    LOG("entry %zu B, value %zu B, ctx %zu B", sizeof(cfgpack_entry_t),
+        sizeof(cfgpack_value_t), sizeof(cfgpack_ctx_t));
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Default build: a schema with too many string slots is rejected
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_default_rejects_large) {
+    LOG_SECTION("Default build rejects more than 255 string slots");
+
+    cfgpack_schema_t schema;
+    cfgpack_parse_error_t perr;
+
+    CHECK(parse_big(&schema, &perr) == CFGPACK_ERR_BOUNDS);
+    LOG("Correctly returned ERR_BOUNDS: %s", perr.message);
+
+    return TEST_OK;
+}
+
+#endif /* CFGPACK_LARGE_SCHEMA */
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+#ifdef CFGPACK_LARGE_SCHEMA
+    overall |= (test_case_result("large_init", test_large_init()) != TEST_OK);
+    overall |= (test_case_result("large_roundtrip", test_large_roundtrip()) !=
+                TEST_OK);
+    overall |= (test_case_result("large_map32", test_large_map32()) !=
+                TEST_OK);
+#else
+    overall |= (test_case_result("default_footprint",
+                                 test_default_footprint()) != TEST_OK);
+    overall |= (test_case_result("default_rejects_large",
+                                 test_default_rejects_large()) != TEST_OK);
+#endif
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
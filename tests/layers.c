@@ -0,0 +1,210 @@
+/* Layered pagein tests: a user blob over a factory blob over the schema
+ * defaults, resolved in one call, with the origin of every entry. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 5
+
+static cfgpack_type_t dev_type(size_t i) {
+    return (i < 3 ? CFGPACK_TYPE_U16 : CFGPACK_TYPE_STR);
+}
+
+/* u16 at index 1..3 (index 1 defaults to 7), str at 4 and 5. */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    fixture_schema(f, "dev", N_ENTRIES, dev_type);
+    f->entries[0].has_default = 1;
+    f->values[0].type = CFGPACK_TYPE_U16;
+    f->values[0].v.u64 = 7;
+    return (fixture_init(f));
+}
+
+static uint16_t get_u16(const cfgpack_ctx_t *ctx, uint16_t index) {
+    uint16_t v = 0;
+    cfgpack_get_u16(ctx, index, &v);
+    return (v);
+}
+
+/* Factory: index 2 = 200, 3 = 300, calibration string at 4.
+ * User: index 3 = 333 and a name at 5. */
+static void make_layers(uint8_t *factory,
+                        size_t *factory_len,
+                        uint8_t *user,
+                        size_t *user_len,
+                        size_t cap) {
+    static fixture_t f;
+
+    make_fixture(&f);
+    cfgpack_presence_clear(&f.ctx, 0);
+    cfgpack_set_u16(&f.ctx, 2, 200);
+    cfgpack_set_u16(&f.ctx, 3, 300);
+    cfgpack_set_str(&f.ctx, 4, "cal-A1");
+    cfgpack_pageout(&f.ctx, factory, cap, factory_len);
+
+    make_fixture(&f);
+    cfgpack_presence_clear(&f.ctx, 0);
+    cfgpack_set_u16(&f.ctx, 3, 333);
+    cfgpack_set_str(&f.ctx, 5, "kitchen");
+    cfgpack_pageout(&f.ctx, user, cap, user_len);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. The highest layer wins per entry
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_layers_resolve) {
+    static fixture_t f;
+    uint8_t factory[128];
+    uint8_t user[128];
+    size_t factory_len = 0;
+    size_t user_len = 0;
+    uint8_t origin[N_ENTRIES];
+    const char *s;
+    uint16_t slen;
+
+    make_layers(factory, &factory_len, user, &user_len, sizeof(factory));
+    cfgpack_layer_t layers[] = {{factory, factory_len, NULL, 0},
+                                {user, user_len, NULL, 0}};
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 1) == CFGPACK_OK);
+
+    LOG_SECTION("Defaults, then factory, then user");
+    CHECK(cfgpack_pagein_layers(&f.ctx, layers, 2, origin) == CFGPACK_OK);
+    CHECK(get_u16(&f.ctx, 1) == 7);
+    CHECK(get_u16(&f.ctx, 2) == 200);
+    CHECK(get_u16(&f.ctx, 3) == 333);
+    CHECK(cfgpack_get_str(&f.ctx, 4, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "cal-A1") == 0);
+    CHECK(cfgpack_get_str(&f.ctx, 5, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "kitchen") == 0);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+
+    LOG_SECTION("Origin of every entry");
+    CHECK(origin[0] == CFGPACK_LAYER_DEFAULT);
+    CHECK(origin[1] == 0);
+    CHECK(origin[2] == 1);
+    CHECK(origin[3] == 0);
+    CHECK(origin[4] == 1);
+    LOG("origin: %u %u %u %u %u", origin[0], origin[1], origin[2], origin[3],
+        origin[4]);
+
+    LOG_SECTION("Every entry present once");
+    CHECK(cfgpack_get_size(&f.ctx) == N_ENTRIES);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Resetting the user layer: page in the layers below it again
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_layers_reset) {
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t factory[128];
+    uint8_t user[128];
+    uint8_t a[128];
+    uint8_t b[128];
+    size_t factory_len = 0;
+    size_t user_len = 0;
+    size_t a_len = 0;
+    size_t b_len = 0;
+    uint8_t origin[N_ENTRIES];
+    const char *s;
+    uint16_t slen;
+
+    make_layers(factory, &factory_len, user, &user_len, sizeof(factory));
+    cfgpack_layer_t layers[] = {{factory, factory_len, NULL, 0},
+                                {user, user_len, NULL, 0}};
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+#ifdef CFGPACK_SIZE_CACHE
+    CHECK(cfgpack_size_cache_init(&f.ctx) == CFGPACK_OK);
+#endif
+    CHECK(cfgpack_pagein_layers(&f.ctx, layers, 2, origin) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_layers(&f.ctx, layers, 1, origin) == CFGPACK_OK);
+    CHECK(get_u16(&f.ctx, 3) == 300);
+    CHECK(cfgpack_get_str(&f.ctx, 5, &s, &slen) != CFGPACK_OK);
+    CHECK(origin[2] == 0 && origin[4] == CFGPACK_LAYER_NONE);
+
+    LOG_SECTION("Same state as a plain pagein of the factory blob");
+    CHECK(cfgpack_pagein_buf(&g.ctx, factory, factory_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&f.ctx) == cfgpack_get_size(&g.ctx));
+    CHECK(cfgpack_pageout(&f.ctx, a, sizeof(a), &a_len) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&g.ctx, b, sizeof(b), &b_len) == CFGPACK_OK);
+    CHECK(a_len == b_len && memcmp(a, b, a_len) == 0);
+
+    LOG_SECTION("No layers: defaults only");
+    CHECK(cfgpack_pagein_layers(&f.ctx, NULL, 0, origin) == CFGPACK_OK);
+    CHECK(get_u16(&f.ctx, 1) == 7);
+    CHECK(cfgpack_get_size(&f.ctx) == 1);
+    CHECK(origin[0] == CFGPACK_LAYER_DEFAULT &&
+          origin[1] == CFGPACK_LAYER_NONE);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Errors: a bad layer leaves the context alone
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_layers_errors) {
+    static fixture_t f;
+    uint8_t factory[128];
+    uint8_t user[128];
+    size_t factory_len = 0;
+    size_t user_len = 0;
+    cfgpack_layer_t many[CFGPACK_LAYERS_MAX + 1] = {{0}};
+
+    make_layers(factory, &factory_len, user, &user_len, sizeof(factory));
+    cfgpack_layer_t layers[] = {{factory, factory_len, NULL, 0},
+                                {user, user_len, NULL, 0}};
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 42) == CFGPACK_OK);
+
+    LOG_SECTION("Arguments");
+    CHECK(cfgpack_pagein_layers(NULL, layers, 2, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_layers(&f.ctx, NULL, 2, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_layers(&f.ctx, many, CFGPACK_LAYERS_MAX + 1,
+                                NULL) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("A corrupt upper layer is caught before anything changes");
+    user[2] ^= 0x01;
+    CHECK(cfgpack_pagein_layers(&f.ctx, layers, 2, NULL) == CFGPACK_ERR_CRC);
+    user[2] ^= 0x01;
+    CHECK(get_u16(&f.ctx, 2) == 42);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 1);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    overall |= (test_case_result("layers_resolve", test_layers_resolve()) !=
+                TEST_OK);
+    overall |= (test_case_result("layers_reset", test_layers_reset()) !=
+                TEST_OK);
+    overall |= (test_case_result("layers_errors", test_layers_errors()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -80,6 +80,8 @@ TEST_CASE(test_measure_map_sample) {
     CHECK(m.str_count == sizing.str_count);
     CHECK(m.fstr_count == sizing.fstr_count);
     CHECK(m.str_pool_size == sizing.str_pool_size);
+    CHECK(m.index_table_size == 16); /* highest index 15 */
+    CHECK(sizing.index_table_size == m.index_table_size);
 
     LOG("Test completed successfully");
     return (TEST_OK);
@@ -265,6 +267,8 @@ TEST_CASE(test_measure_json_valid) {
     CHECK(m.str_count == sizing.str_count);
     CHECK(m.fstr_count == sizing.fstr_count);
     CHECK(m.str_pool_size == sizing.str_pool_size);
+    CHECK(m.index_table_size == 5);
+    CHECK(sizing.index_table_size == m.index_table_size);
     LOG("Measure matches parse results");
 
     LOG("Test completed successfully");
@@ -496,6 +500,131 @@ TEST_CASE(test_measure_then_parse_json) {
     return (TEST_OK);
 }
 
+/* ─── Declared string max lengths ───────────────────────────────────────── */
+
+TEST_CASE(test_measure_str_max) {
+    LOG_SECTION("str:N / fstr:N size pool slots exactly in every format");
+
+    const char *map = "demo 1\n"
+                      "1 id str:8 \"abc\"\n"
+                      "2 tag fstr:4 NIL\n"
+                      "3 name str \"x\"\n"
+                      "4 n u8 1\n";
+    static const struct {
+        const char *line;
+        cfgpack_err_t rc;
+    } bad[] = {
+        {"demo 1\n1 a u8:4 0\n", CFGPACK_ERR_INVALID_TYPE},
+        {"demo 1\n1 a str:8x \"\"\n", CFGPACK_ERR_INVALID_TYPE},
+        {"demo 1\n1 a str:0 \"\"\n", CFGPACK_ERR_BOUNDS},
+        {"demo 1\n1 a str:65 \"\"\n", CFGPACK_ERR_BOUNDS},
+        {"demo 1\n1 a fstr:17 \"\"\n", CFGPACK_ERR_BOUNDS},
+        {"demo 1\n1 a str:2 \"abc\"\n", CFGPACK_ERR_STR_TOO_LONG},
+    };
+    cfgpack_schema_measure_t m;
+    cfgpack_schema_sizing_t sizing;
+    cfgpack_parse_error_t err;
+    cfgpack_schema_t schema;
+    cfgpack_schema_t schema2;
+    cfgpack_entry_t entries[4];
+    cfgpack_entry_t entries2[4];
+    cfgpack_value_t values[4];
+    cfgpack_value_t values2[4];
+    char str_pool[9 + 5 + 65];
+    char str_pool2[128];
+    uint16_t str_offsets[3];
+    uint16_t str_offsets2[3];
+    char json[1024];
+    uint8_t mp[256];
+    uint8_t blob[128];
+    size_t len = 0;
+    cfgpack_ctx_t ctx;
+    cfgpack_ctx_t ctx2;
+
+    CHECK(cfgpack_schema_measure(map, strlen(map), &m, &err) == CFGPACK_OK);
+    CHECK(m.str_pool_size == 9 + 5 + 65);
+    LOG("pool = %zu bytes (was %d without max lengths)", m.str_pool_size,
+        2 * (CFGPACK_STR_MAX + 1) + CFGPACK_FSTR_MAX + 1);
+
+    cfgpack_parse_opts_t opts = {&schema,     entries,  4,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 3,        &err};
+    CHECK(cfgpack_parse_schema(map, strlen(map), &opts) == CFGPACK_OK);
+    CHECK(entries[0].str_max == 8 && entries[1].str_max == 4);
+    CHECK(entries[2].str_max == 0 && entries[3].str_max == 0);
+    CHECK(str_offsets[0] == 0 && str_offsets[1] == 9 && str_offsets[2] == 14);
+    cfgpack_schema_get_sizing(&schema, &sizing);
+    CHECK(sizing.str_pool_size == m.str_pool_size);
+
+    LOG_SECTION("Setters and pagein enforce the declared max");
+    CHECK(cfgpack_init(&ctx, &schema, values, 4, str_pool, sizeof(str_pool),
+                       str_offsets, 3) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&ctx, 1, "123456789") == CFGPACK_ERR_STR_TOO_LONG);
+    CHECK(cfgpack_set_str(&ctx, 1, "12345678") == CFGPACK_OK);
+    CHECK(cfgpack_set_fstr(&ctx, 2, "abcde") == CFGPACK_ERR_STR_TOO_LONG);
+    CHECK(cfgpack_set_fstr(&ctx, 2, "abcd") == CFGPACK_OK);
+    CHECK(memcmp(str_pool + 9, "abcd", 5) == 0);
+    CHECK(memcmp(str_pool, "12345678", 9) == 0);
+
+    LOG_SECTION("JSON and msgpack writers round-trip the max lengths");
+    CHECK(cfgpack_schema_write_json(&ctx, json, sizeof(json), &len, &err) ==
+          CFGPACK_OK);
+    CHECK(strstr(json, "\"str:8\"") != NULL);
+    CHECK(strstr(json, "\"fstr:4\"") != NULL);
+    CHECK(cfgpack_schema_measure_json(json, len, &m, &err) == CFGPACK_OK);
+    CHECK(m.str_pool_size == 9 + 5 + 65);
+    cfgpack_parse_opts_t opts2 = {&schema2,     entries2,  4,
+                                  values2,      str_pool2, sizeof(str_pool2),
+                                  str_offsets2, 3,         &err};
+    CHECK(cfgpack_schema_parse_json(json, len, &opts2) == CFGPACK_OK);
+    CHECK(entries2[0].str_max == 8 && entries2[1].str_max == 4);
+    CHECK(values2[0].v.str.len == 8);
+
+    CHECK(cfgpack_schema_write_msgpack(&ctx, mp, sizeof(mp), &len, &err) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_schema_measure_msgpack(mp, len, &m, &err) == CFGPACK_OK);
+    CHECK(m.str_pool_size == 9 + 5 + 65);
+    memset(entries2, 0, sizeof(entries2));
+    CHECK(cfgpack_schema_parse_msgpack(mp, len, &opts2) == CFGPACK_OK);
+    CHECK(entries2[0].str_max == 8 && entries2[1].str_max == 4);
+    CHECK(cfgpack_schema_hash(&schema2) == cfgpack_schema_hash(&schema));
+
+    LOG_SECTION("A longer stored string does not fit a shorter slot");
+    CHECK(cfgpack_pageout(&ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    entries2[0].str_max = 4;
+    CHECK(cfgpack_init(&ctx2, &schema2, values2, 4, str_pool2,
+                       sizeof(str_pool2), str_offsets2, 3) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx2, blob, len) == CFGPACK_ERR_STR_TOO_LONG);
+
+    LOG_SECTION("cfgpack_init checks hand-set max lengths");
+    entries2[0].str_max = CFGPACK_STR_MAX + 1;
+    CHECK(cfgpack_init(&ctx2, &schema2, values2, 4, str_pool2,
+                       sizeof(str_pool2), str_offsets2, 3) ==
+          CFGPACK_ERR_BOUNDS);
+    entries2[0].str_max = CFGPACK_STR_MAX;
+    entries2[1].str_max = CFGPACK_FSTR_MAX + 1;
+    CHECK(cfgpack_init(&ctx2, &schema2, values2, 4, str_pool2,
+                       sizeof(str_pool2), str_offsets2, 3) ==
+          CFGPACK_ERR_BOUNDS);
+    entries2[0].str_max = 8;
+    entries2[1].str_max = 4;
+    entries2[3].str_max = 1;
+    CHECK(cfgpack_init(&ctx2, &schema2, values2, 4, str_pool2,
+                       sizeof(str_pool2), str_offsets2, 3) ==
+          CFGPACK_ERR_INVALID_TYPE);
+    entries2[3].str_max = 0;
+    CHECK(cfgpack_init(&ctx2, &schema2, values2, 4, str_pool2,
+                       sizeof(str_pool2), str_offsets2, 3) == CFGPACK_OK);
+
+    LOG_SECTION("Malformed or out-of-range max lengths are rejected");
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        CHECK(cfgpack_schema_measure(bad[i].line, strlen(bad[i].line), &m,
+                                     &err) == bad[i].rc);
+    }
+
+    return (TEST_OK);
+}
+
 int main(void) {
     test_result_t overall = TEST_OK;
 
@@ -536,6 +665,8 @@ int main(void) {
                                  test_measure_then_parse_map()) != TEST_OK);
     overall |= (test_case_result("measure_then_parse_json",
                                  test_measure_then_parse_json()) != TEST_OK);
+    overall |= (test_case_result("measure_str_max", test_measure_str_max()) !=
+                TEST_OK);
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
@@ -0,0 +1,284 @@
+/* Migration plan tests: a plan built by diffing two schemas, and a pagein
+ * through it that matches the equivalent remap pagein. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define MAX_ENTRIES 8
+
+static const char v1_map[] = "dev 1\n"
+                             "1 rate u16 100\n"
+                             "2 name fstr \"dev\"\n"
+                             "3 gain f32 NIL\n"
+                             "4 mode u8 0\n"
+                             "5 off i8 NIL\n"
+                             "6 cnt u8 NIL\n"
+                             "7 host str NIL\n"
+                             "8 port u16 NIL\n";
+
+/* rate, name and gain widened; mode removed; off and cnt widened and moved;
+ * host kept; port moved; new added */
+static const char v2_map[] = "dev 2\n"
+                             "1 rate u32 100\n"
+                             "2 name str \"dev\"\n"
+                             "3 gain f64 NIL\n"
+                             "7 host str NIL\n"
+                             "10 port u16 NIL\n"
+                             "11 cnt i16 NIL\n"
+                             "12 off i32 NIL\n"
+                             "13 new u8 42\n";
+
+/* v1 -> v2 as a remap table, for comparison */
+static const cfgpack_remap_entry_t v1_to_v2[] = {
+    {4, 0}, /* dropped: not a v2 index */
+    {5, 12},
+    {6, 11},
+    {8, 10},
+};
+
+/* A v1 blob with every entry set; @p off is written to index 5. */
+static size_t make_v1_blob(uint8_t *out, size_t cap, int8_t off, int header) {
+    static fixture_t f;
+    size_t len = 0;
+
+    fixture_parse(&f, v1_map);
+    cfgpack_header_enable(&f.ctx, header);
+    cfgpack_set_u16(&f.ctx, 1, 300);
+    cfgpack_set_fstr(&f.ctx, 2, "abc");
+    cfgpack_set_f32(&f.ctx, 3, 0.5f);
+    cfgpack_set_u8(&f.ctx, 4, 3);
+    cfgpack_set_i8(&f.ctx, 5, off);
+    cfgpack_set_u8(&f.ctx, 6, 200);
+    cfgpack_set_str(&f.ctx, 7, "gw");
+    cfgpack_set_u16(&f.ctx, 8, 8080);
+    cfgpack_pageout(&f.ctx, out, cap, &len);
+    return (len);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Building a plan from two schemas
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_migrate_build) {
+    static fixture_t a;
+    static fixture_t b;
+    cfgpack_migrate_action_t act[MAX_ENTRIES];
+    cfgpack_migration_t m;
+    size_t failed = 0;
+
+    CHECK(fixture_parse(&a, v1_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&b, v2_map) == CFGPACK_OK);
+    CHECK(cfgpack_migration_build(&a.schema, &b.schema, act, MAX_ENTRIES, &m,
+                                  &failed) == CFGPACK_OK);
+
+    LOG_SECTION("One action per old entry, in old index order");
+    CHECK(m.count == 8 && m.actions == act);
+    CHECK(m.from_fp == cfgpack_schema_fingerprint(&a.schema));
+    CHECK(m.to_fp == cfgpack_schema_fingerprint(&b.schema));
+    for (size_t i = 0; i < m.count; ++i) {
+        CHECK(act[i].old_index == a.entries[i].index);
+    }
+
+    LOG_SECTION("Kinds and resolved decoders");
+    CHECK(act[0].kind == CFGPACK_MIGRATE_WIDEN && act[0].new_pos == 0 &&
+          act[0].decode == CFGPACK_MIGRATE_DEC_UINT);
+    CHECK(act[1].kind == CFGPACK_MIGRATE_WIDEN &&
+          act[1].decode == CFGPACK_MIGRATE_DEC_STR);
+    CHECK(act[2].kind == CFGPACK_MIGRATE_WIDEN &&
+          act[2].decode == CFGPACK_MIGRATE_DEC_F32_F64);
+    CHECK(act[3].kind == CFGPACK_MIGRATE_DROP);
+    CHECK(act[4].kind == CFGPACK_MIGRATE_WIDEN && act[4].new_pos == 6 &&
+          act[4].decode == CFGPACK_MIGRATE_DEC_INT);
+    CHECK(act[5].kind == CFGPACK_MIGRATE_WIDEN && act[5].new_pos == 5 &&
+          act[5].decode == CFGPACK_MIGRATE_DEC_UINT_INT);
+    CHECK(act[6].kind == CFGPACK_MIGRATE_KEEP && act[6].new_pos == 3);
+    CHECK(act[7].kind == CFGPACK_MIGRATE_MOVE && act[7].new_pos == 4 &&
+          act[7].decode == CFGPACK_MIGRATE_DEC_UINT);
+
+    LOG_SECTION("Narrowing changes are refused");
+    CHECK(cfgpack_migration_build(&b.schema, &a.schema, act, MAX_ENTRIES, &m,
+                                  &failed) == CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(failed == 0); /* rate: u32 -> u16 */
+    b.entries[5].type = CFGPACK_TYPE_I8; /* cnt: u8 -> i8 may overflow */
+    CHECK(cfgpack_migration_build(&a.schema, &b.schema, act, MAX_ENTRIES, &m,
+                                  &failed) == CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(failed == 5);
+    b.entries[5].type = CFGPACK_TYPE_I16;
+    b.entries[3].str_max = 1; /* host: str limit shrinks */
+    CHECK(cfgpack_migration_build(&a.schema, &b.schema, act, MAX_ENTRIES, &m,
+                                  &failed) == CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(failed == 6);
+
+    LOG_SECTION("Arguments");
+    CHECK(cfgpack_migration_build(&a.schema, &b.schema, act, 7, &m, NULL) ==
+          CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_migration_build(NULL, &b.schema, act, MAX_ENTRIES, &m,
+                                  NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_migration_build(&a.schema, &b.schema, act, MAX_ENTRIES,
+                                  NULL, NULL) == CFGPACK_ERR_ARGS);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Pagein through a plan matches the remap pagein
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_migrate_pagein) {
+    static fixture_t a;
+    static fixture_t f;
+    static fixture_t g;
+    cfgpack_migrate_action_t act[MAX_ENTRIES];
+    cfgpack_migration_t m;
+    uint8_t blob[160];
+    uint8_t out_f[160];
+    uint8_t out_g[160];
+    size_t len = make_v1_blob(blob, sizeof(blob), -5, 0);
+    size_t len_f = 0;
+    size_t len_g = 0;
+    uint32_t rate = 0;
+    uint8_t nv = 0;
+    int16_t cnt = 0;
+    int32_t off = 0;
+    double gain = 0;
+    const char *s;
+    uint16_t slen;
+
+    CHECK(len > 0);
+    CHECK(fixture_parse(&a, v1_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&f, v2_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&g, v2_map) == CFGPACK_OK);
+    CHECK(cfgpack_migration_build(&a.schema, &f.schema, act, MAX_ENTRIES, &m,
+                                  NULL) == CFGPACK_OK);
+
+    LOG_SECTION("Values land in their new entries");
+    CHECK(cfgpack_pagein_migrate(&f.ctx, blob, len, &m) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&f.ctx, 1, &rate) == CFGPACK_OK && rate == 300);
+    CHECK(cfgpack_get_str(&f.ctx, 2, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "abc") == 0);
+    CHECK(cfgpack_get_f64(&f.ctx, 3, &gain) == CFGPACK_OK && gain == 0.5);
+    CHECK(cfgpack_get_str(&f.ctx, 7, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "gw") == 0);
+    CHECK(cfgpack_get_i16(&f.ctx, 11, &cnt) == CFGPACK_OK && cnt == 200);
+    CHECK(cfgpack_get_i32(&f.ctx, 12, &off) == CFGPACK_OK && off == -5);
+    LOG("rate=%u cnt=%d off=%d", (unsigned)rate, cnt, (int)off);
+
+    LOG_SECTION("Added entries take their defaults; nothing is dirty");
+    CHECK(cfgpack_get_u8(&f.ctx, 13, &nv) == CFGPACK_OK && nv == 42);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+    CHECK(cfgpack_get_size(&f.ctx) == 8);
+
+    LOG_SECTION("Same state as a remap pagein");
+    CHECK(cfgpack_pagein_remap(&g.ctx, blob, len, v1_to_v2, 4) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, out_f, sizeof(out_f), &len_f) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout(&g.ctx, out_g, sizeof(out_g), &len_g) ==
+          CFGPACK_OK);
+    CHECK(len_f == len_g && memcmp(out_f, out_g, len_f) == 0);
+    LOG("Both blobs %zu bytes", len_f);
+
+    LOG_SECTION("Non-negative signed values are written as uint");
+    len = make_v1_blob(blob, sizeof(blob), 100, 1);
+    CHECK(cfgpack_pagein_migrate(&f.ctx, blob, len, &m) == CFGPACK_OK);
+    CHECK(cfgpack_get_i32(&f.ctx, 12, &off) == CFGPACK_OK && off == 100);
+
+    LOG_SECTION("A blob already in the new layout needs no plan");
+    CHECK(cfgpack_header_enable(&f.ctx, 1) == CFGPACK_OK);
+    CHECK(cfgpack_set_i32(&f.ctx, 12, 77000) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, out_f, sizeof(out_f), &len_f) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pagein_migrate(&g.ctx, out_f, len_f, &m) == CFGPACK_OK);
+    CHECK(cfgpack_get_i32(&g.ctx, 12, &off) == CFGPACK_OK && off == 77000);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Errors leave the context alone
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_migrate_errors) {
+    static fixture_t a;
+    static fixture_t f;
+    cfgpack_migrate_action_t act[MAX_ENTRIES];
+    cfgpack_migration_t m;
+    cfgpack_migration_t bad;
+    uint8_t blob[160];
+    size_t len = make_v1_blob(blob, sizeof(blob), -5, 1);
+    uint32_t rate = 0;
+
+    CHECK(fixture_parse(&a, v1_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&f, v2_map) == CFGPACK_OK);
+    CHECK(cfgpack_migration_build(&a.schema, &f.schema, act, MAX_ENTRIES, &m,
+                                  NULL) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&f.ctx, 1, 9) == CFGPACK_OK);
+
+    LOG_SECTION("Arguments");
+    CHECK(cfgpack_pagein_migrate(NULL, blob, len, &m) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_migrate(&f.ctx, blob, len, NULL) ==
+          CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("A plan for another schema");
+    CHECK(cfgpack_pagein_migrate(&a.ctx, blob, len, &m) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+
+    LOG_SECTION("Malformed actions");
+    bad = m;
+    act[1].new_pos = 100;
+    CHECK(cfgpack_pagein_migrate(&f.ctx, blob, len, &bad) ==
+          CFGPACK_ERR_ARGS);
+    act[1].new_pos = 1;
+    act[1].decode = CFGPACK_MIGRATE_DEC_UINT; /* into a str entry */
+    CHECK(cfgpack_pagein_migrate(&f.ctx, blob, len, &bad) ==
+          CFGPACK_ERR_ARGS);
+    act[1].decode = CFGPACK_MIGRATE_DEC_STR;
+    act[1].old_index = 9; /* out of order */
+    CHECK(cfgpack_pagein_migrate(&f.ctx, blob, len, &bad) ==
+          CFGPACK_ERR_ARGS);
+    act[1].old_index = 2;
+
+    LOG_SECTION("A header of another layout, and a bad CRC");
+    bad.from_fp ^= 1;
+    CHECK(cfgpack_pagein_migrate(&f.ctx, blob, len, &bad) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+    blob[len - 1] ^= 0x01;
+    CHECK(cfgpack_pagein_migrate(&f.ctx, blob, len, &m) == CFGPACK_ERR_CRC);
+    blob[len - 1] ^= 0x01;
+    CHECK(cfgpack_get_u32(&f.ctx, 1, &rate) == CFGPACK_OK && rate == 9);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 1);
+
+    LOG_SECTION("The restored blob migrates");
+    CHECK(cfgpack_pagein_migrate(&f.ctx, blob, len, &m) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&f.ctx, 1, &rate) == CFGPACK_OK && rate == 300);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    overall |= (test_case_result("migrate_build", test_migrate_build()) !=
+                TEST_OK);
+    overall |= (test_case_result("migrate_pagein", test_migrate_pagein()) !=
+                TEST_OK);
+    overall |= (test_case_result("migrate_errors", test_migrate_errors()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -587,6 +587,59 @@ TEST_CASE(test_buf_append_overflow) {
     return TEST_OK;
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 17. Array header and bin roundtrip
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_encode_decode_array_bin) {
+    static const uint32_t counts[] = {0, 15, 16, 65535, 65536};
+    static const size_t lens[] = {1, 1, 3, 3, 5};
+    uint8_t bits[300];
+    uint8_t storage[320];
+    cfgpack_buf_t buf;
+    cfgpack_reader_t r;
+    const uint8_t *ptr = NULL;
+    uint32_t n = 0;
+
+    LOG_SECTION("Array header: fixarray, array16, array32");
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+        cfgpack_buf_init(&buf, storage, sizeof(storage));
+        CHECK(cfgpack_msgpack_encode_array_header(&buf, counts[i]) ==
+              CFGPACK_OK);
+        CHECK(buf.len == lens[i]);
+        cfgpack_reader_init(&r, storage, buf.len);
+        CHECK(cfgpack_msgpack_decode_array_header(&r, &n) == CFGPACK_OK);
+        CHECK(n == counts[i]);
+        LOG("array(%u): %zu byte header", (unsigned)counts[i], buf.len);
+    }
+
+    LOG_SECTION("Bin: bin8 and bin16 point into the reader's buffer");
+    for (size_t i = 0; i < sizeof(bits); ++i) {
+        bits[i] = (uint8_t)(i * 7);
+    }
+    cfgpack_buf_init(&buf, storage, sizeof(storage));
+    CHECK(cfgpack_msgpack_encode_bin(&buf, bits, 3) == CFGPACK_OK);
+    CHECK(buf.len == 5 && storage[0] == 0xc4);
+    cfgpack_reader_init(&r, storage, buf.len);
+    CHECK(cfgpack_msgpack_decode_bin(&r, &ptr, &n) == CFGPACK_OK);
+    CHECK(n == 3 && ptr == storage + 2 && memcmp(ptr, bits, 3) == 0);
+
+    cfgpack_buf_init(&buf, storage, sizeof(storage));
+    CHECK(cfgpack_msgpack_encode_bin(&buf, bits, sizeof(bits)) ==
+          CFGPACK_OK);
+    CHECK(buf.len == sizeof(bits) + 3 && storage[0] == 0xc5);
+    cfgpack_reader_init(&r, storage, buf.len);
+    CHECK(cfgpack_msgpack_decode_bin(&r, &ptr, &n) == CFGPACK_OK);
+    CHECK(n == sizeof(bits) && memcmp(ptr, bits, sizeof(bits)) == 0);
+
+    LOG_SECTION("Wrong kind and truncation are decode errors");
+    cfgpack_reader_init(&r, storage, buf.len);
+    CHECK(cfgpack_msgpack_decode_array_header(&r, &n) == CFGPACK_ERR_DECODE);
+    cfgpack_reader_init(&r, storage, 10);
+    CHECK(cfgpack_msgpack_decode_bin(&r, &ptr, &n) == CFGPACK_ERR_DECODE);
+
+    return TEST_OK;
+}
+
 int main(void) {
     test_result_t overall = TEST_OK;
 
@@ -622,6 +675,8 @@ int main(void) {
                                  test_skip_value_all_types()) != TEST_OK);
     overall |= (test_case_result("buf_append_overflow",
                                  test_buf_append_overflow()) != TEST_OK);
+    overall |= (test_case_result("encode_decode_array_bin",
+                                 test_encode_decode_array_bin()) != TEST_OK);
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
@@ -887,6 +887,108 @@ TEST_CASE(test_encode_wrappers) {
     return (TEST_OK);
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 12. Every format byte — decoders and skip_value agree
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_all_format_bytes) {
+    cfgpack_reader_t r;
+    size_t n_skip = 0, n_uint = 0, n_int = 0, n_f32 = 0, n_f64 = 0;
+    size_t n_str = 0, n_map = 0;
+
+    LOG_SECTION("All 256 format bytes through skip and each decoder");
+
+    for (int b = 0; b < 256; ++b) {
+        /* Zero-filled tail: enough for any header, fixstr/bin body, or
+         * the 30 zero-valued children of the largest fixmap */
+        uint8_t data[33] = {0};
+        const uint8_t *ptr;
+        uint64_t u;
+        int64_t i;
+        uint32_t n;
+        float f;
+        double d;
+        size_t end;
+        int ext = (b == 0xc1 || (b >= 0xc7 && b <= 0xc9) ||
+                   (b >= 0xd4 && b <= 0xd8));
+
+        data[0] = (uint8_t)b;
+        cfgpack_reader_init(&r, data, sizeof(data));
+        if (cfgpack_msgpack_skip_value(&r) != CFGPACK_OK) {
+            CHECK(ext);
+            continue;
+        }
+        CHECK(!ext);
+        end = r.pos;
+        n_skip++;
+
+        /* Scalar and string decoders consume exactly what skip does */
+        cfgpack_reader_init(&r, data, sizeof(data));
+        if (cfgpack_msgpack_decode_uint64(&r, &u) == CFGPACK_OK) {
+            CHECK(r.pos == end);
+            n_uint++;
+        }
+        cfgpack_reader_init(&r, data, sizeof(data));
+        if (cfgpack_msgpack_decode_int64(&r, &i) == CFGPACK_OK) {
+            CHECK(r.pos == end);
+            n_int++;
+        }
+        cfgpack_reader_init(&r, data, sizeof(data));
+        if (cfgpack_msgpack_decode_f32(&r, &f) == CFGPACK_OK) {
+            CHECK(r.pos == end);
+            n_f32++;
+        }
+        cfgpack_reader_init(&r, data, sizeof(data));
+        if (cfgpack_msgpack_decode_f64(&r, &d) == CFGPACK_OK) {
+            CHECK(r.pos == end);
+            n_f64++;
+        }
+        cfgpack_reader_init(&r, data, sizeof(data));
+        if (cfgpack_msgpack_decode_str(&r, &ptr, &n) == CFGPACK_OK) {
+            CHECK(r.pos == end);
+            n_str++;
+        }
+        cfgpack_reader_init(&r, data, sizeof(data));
+        if (cfgpack_msgpack_decode_map_header(&r, &n) == CFGPACK_OK) {
+            CHECK(r.pos <= end);
+            n_map++;
+        }
+    }
+
+    CHECK(n_skip == 247);
+    CHECK(n_uint == 128 + 4);
+    CHECK(n_int == 128 + 32 + 4);
+    CHECK(n_f32 == 1 && n_f64 == 1);
+    CHECK(n_str == 32 + 3);
+    CHECK(n_map == 16 + 2);
+    LOG("skip %zu, uint %zu, int %zu, str %zu, map %zu formats", n_skip,
+        n_uint, n_int, n_str, n_map);
+
+    LOG_SECTION("Sign extension of each int width");
+    {
+        uint8_t d8[] = {0xd0, 0x80};
+        uint8_t d16[] = {0xd1, 0x80, 0x00};
+        uint8_t d32[] = {0xd2, 0x80, 0x00, 0x00, 0x00};
+        uint8_t neg[] = {0xe0};
+        int64_t i;
+
+        cfgpack_reader_init(&r, d8, sizeof(d8));
+        CHECK(cfgpack_msgpack_decode_int64(&r, &i) == CFGPACK_OK);
+        CHECK(i == INT8_MIN);
+        cfgpack_reader_init(&r, d16, sizeof(d16));
+        CHECK(cfgpack_msgpack_decode_int64(&r, &i) == CFGPACK_OK);
+        CHECK(i == INT16_MIN);
+        cfgpack_reader_init(&r, d32, sizeof(d32));
+        CHECK(cfgpack_msgpack_decode_int64(&r, &i) == CFGPACK_OK);
+        CHECK(i == INT32_MIN);
+        cfgpack_reader_init(&r, neg, sizeof(neg));
+        CHECK(cfgpack_msgpack_decode_int64(&r, &i) == CFGPACK_OK);
+        CHECK(i == -32);
+        LOG("int8/16/32 minimums and fixint -32 decoded (ok)");
+    }
+
+    return (TEST_OK);
+}
+
 int main(void) {
     test_result_t overall = TEST_OK;
 
@@ -913,6 +1015,8 @@ int main(void) {
                                  test_skip_depth_and_overflow()) != TEST_OK);
     overall |= (test_case_result("encode_wrappers", test_encode_wrappers()) !=
                 TEST_OK);
+    overall |= (test_case_result("all_format_bytes",
+                                 test_all_format_bytes()) != TEST_OK);
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
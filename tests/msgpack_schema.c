@@ -961,6 +961,271 @@ TEST_CASE(test_err_type_mismatch_int_for_str) {
     return TEST_OK;
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 18. Copy-on-write: string defaults stay in the blob until first write
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_cow_string_defaults) {
+    LOG_SECTION("Copy-on-write string defaults");
+
+    static const char *json = "{"
+                              "  \"name\": \"cow\","
+                              "  \"version\": 1,"
+                              "  \"entries\": ["
+                              "    {\"index\": 1, \"name\": \"a\", \"type\": "
+                              "\"str:8\", \"value\": \"alpha\"},"
+                              "    {\"index\": 2, \"name\": \"b\", \"type\": "
+                              "\"str:8\", \"value\": \"two\"},"
+                              "    {\"index\": 3, \"name\": \"c\", \"type\": "
+                              "\"fstr:8\", \"value\": \"c3\"},"
+                              "    {\"index\": 4, \"name\": \"n\", \"type\": "
+                              "\"u8\", \"value\": 7}"
+                              "  ]"
+                              "}";
+
+    uint8_t mp[512];
+    size_t mp_len = 0;
+    CHECK(json_to_msgpack(json, mp, sizeof(mp), &mp_len) == CFGPACK_OK);
+
+    /* Parse without a pool: defaults are offsets into mp */
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[4];
+    cfgpack_value_t values[4];
+    uint16_t str_offsets[3];
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts = {&schema,     entries, 4, values, NULL, 0,
+                                 str_offsets, 3,       &perr};
+    CHECK(cfgpack_schema_parse_msgpack_cow(mp, mp_len, &opts) == CFGPACK_OK);
+
+    /* Pool for two of the three 9-byte slots */
+    char str_pool[18];
+    cfgpack_ctx_t ctx;
+    CHECK(cfgpack_init_cow(&ctx, &schema, values, 4, str_pool,
+                           sizeof(str_pool), str_offsets, 3, mp,
+                           mp_len) == CFGPACK_OK);
+
+    const char *s;
+    uint16_t slen;
+    uint8_t flen;
+    CHECK(cfgpack_get_str(&ctx, 1, &s, &slen) == CFGPACK_OK);
+    CHECK(slen == 5 && memcmp(s, "alpha", 5) == 0);
+    CHECK((const uint8_t *)s > mp && (const uint8_t *)s < mp + mp_len);
+    LOG("str@1 read from blob offset %u", (unsigned)((const uint8_t *)s - mp));
+
+    /* First write materializes a slot; other defaults stay in the blob */
+    CHECK(cfgpack_set_str(&ctx, 1, "beta") == CFGPACK_OK);
+    CHECK(cfgpack_get_str(&ctx, 1, &s, &slen) == CFGPACK_OK);
+    CHECK(s == str_pool && slen == 4 && strcmp(s, "beta") == 0);
+    CHECK(cfgpack_get_fstr(&ctx, 3, &s, &flen) == CFGPACK_OK);
+    CHECK(flen == 2 && memcmp(s, "c3", 2) == 0);
+    CHECK((const uint8_t *)s > mp && (const uint8_t *)s < mp + mp_len);
+    size_t vlen;
+    CHECK(cfgpack_get_str_view(&ctx, 3, &s, &vlen) == CFGPACK_OK);
+    CHECK(vlen == 2 && (const uint8_t *)s > mp);
+
+    CHECK(cfgpack_set_fstr(&ctx, 3, "x") == CFGPACK_OK);
+    CHECK(ctx.str_pool_used == sizeof(str_pool));
+    LOG("Two slots materialized, %u pool bytes used",
+        (unsigned)ctx.str_pool_used);
+
+    /* Pool exhausted: a third string cannot be written, but a
+     * materialized one can be rewritten in place */
+    CHECK(cfgpack_set_str(&ctx, 2, "zz") == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_get_str(&ctx, 2, &s, &slen) == CFGPACK_OK);
+    CHECK(slen == 3 && memcmp(s, "two", 3) == 0);
+    CHECK(cfgpack_set_str(&ctx, 1, "gamma") == CFGPACK_OK);
+    LOG("Correctly returned ERR_BOUNDS once the pool is full");
+
+    /* Features that need every string in the pool are refused */
+    uint8_t img[512];
+    CHECK(cfgpack_schema_write_image(&ctx, img, sizeof(img), NULL, &perr) ==
+          CFGPACK_ERR_ARGS);
+#ifdef CFGPACK_PACKED_ARENA
+    uint64_t arena[8];
+    CHECK(cfgpack_packed_init(&ctx, arena, sizeof(arena)) == CFGPACK_ERR_ARGS);
+#endif
+
+    /* Pageout mixes pool and blob strings; pagein materializes all */
+    uint8_t blob[256];
+    size_t blob_len = 0;
+    CHECK(cfgpack_pageout(&ctx, blob, sizeof(blob), &blob_len) == CFGPACK_OK);
+
+    cfgpack_schema_t schema2;
+    cfgpack_entry_t entries2[4];
+    cfgpack_value_t values2[4];
+    uint16_t str_offsets2[3];
+    char str_pool2[27];
+    cfgpack_parse_opts_t opts2 = {&schema2,     entries2, 4, values2, NULL, 0,
+                                  str_offsets2, 3,        &perr};
+    cfgpack_ctx_t ctx2;
+    CHECK(cfgpack_schema_parse_msgpack_cow(mp, mp_len, &opts2) == CFGPACK_OK);
+    CHECK(cfgpack_init_cow(&ctx2, &schema2, values2, 4, str_pool2,
+                           sizeof(str_pool2), str_offsets2, 3, mp,
+                           mp_len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx2, blob, blob_len) == CFGPACK_OK);
+    CHECK(ctx2.str_pool_used == sizeof(str_pool2));
+
+    CHECK(cfgpack_get_str(&ctx2, 1, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "gamma") == 0);
+    CHECK(cfgpack_get_str(&ctx2, 2, &s, &slen) == CFGPACK_OK);
+    CHECK(strcmp(s, "two") == 0);
+    CHECK(cfgpack_get_fstr(&ctx2, 3, &s, &flen) == CFGPACK_OK);
+    CHECK(strcmp(s, "x") == 0);
+    LOG("Pagein wrote every string into the pool");
+
+    /* A default outside the declared blob is rejected */
+    CHECK(cfgpack_init_cow(&ctx2, &schema2, values2, 4, str_pool2,
+                           sizeof(str_pool2), str_offsets2, 3, mp,
+                           8) == CFGPACK_ERR_BOUNDS);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 19. Streaming parse through a small window equals the flat parse
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/* Source over a buffer, at most @c chunk bytes per call. */
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t chunk;
+} mem_src_t;
+
+static cfgpack_err_t mem_source(void *user,
+                                size_t offset,
+                                uint8_t *dst,
+                                size_t cap,
+                                size_t *out_len) {
+    const mem_src_t *m = (const mem_src_t *)user;
+    size_t n = offset < m->len ? m->len - offset : 0;
+
+    if (n > cap) {
+        n = cap;
+    }
+    if (n > m->chunk) {
+        n = m->chunk;
+    }
+    memcpy(dst, m->data + offset, n);
+    *out_len = n;
+    return (CFGPACK_OK);
+}
+
+TEST_CASE(test_stream_parse) {
+    LOG_SECTION("Streaming parse through a small window");
+
+    static const char *json = "{"
+                              "  \"name\": \"strm\","
+                              "  \"version\": 4,"
+                              "  \"entries\": ["
+                              "    {\"index\": 1, \"name\": \"id\", \"type\": "
+                              "\"str\", \"value\": \"unit-0042\"},"
+                              "    {\"index\": 2, \"name\": \"gain\", "
+                              "\"type\": \"f32\", \"value\": 0.5},"
+                              "    {\"index\": 7, \"name\": \"tag\", \"type\": "
+                              "\"fstr:8\", \"value\": \"blue\"},"
+                              "    {\"index\": 9, \"name\": \"off\", \"type\": "
+                              "\"i16\", \"value\": -300},"
+                              "    {\"index\": 12, \"name\": \"note\", "
+                              "\"type\": \"str:4\", \"value\": null}"
+                              "  ]"
+                              "}";
+    /* Same shape as the writer's output, but index 2 before index 1 */
+    static const uint8_t unsorted[] = {
+        0x83, 0x00, 0xa1, 'x', 0x01, 0x01, 0x02, 0x92, 0x84, 0x00,
+        0x02, 0x01, 0xa1, 'a', 0x02, 0x00, 0x03, 0xc0, 0x84, 0x00,
+        0x01, 0x01, 0xa1, 'b', 0x02, 0x00, 0x03, 0xc0};
+    /* One entry with its value ahead of its type */
+    static const uint8_t value_first[] = {0x83, 0x00, 0xa1, 'x', 0x01,
+                                          0x01, 0x02, 0x91, 0x84, 0x00,
+                                          0x01, 0x01, 0xa1, 'a', 0x03,
+                                          0x05, 0x02, 0x00};
+
+    uint8_t mp[512];
+    size_t mp_len = 0;
+    CHECK(json_to_msgpack(json, mp, sizeof(mp), &mp_len) == CFGPACK_OK);
+
+    cfgpack_schema_t schema, schema2;
+    cfgpack_entry_t entries[5], entries2[5];
+    cfgpack_value_t values[5], values2[5];
+    char str_pool[128], str_pool2[128];
+    uint16_t str_offsets[3], str_offsets2[3];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    cfgpack_schema_measure_t m, m2;
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t flat = {&schema,     entries,  5,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 3,        &perr};
+    cfgpack_parse_opts_t opts = {&schema2,     entries2,  5,
+                                 values2,      str_pool2, sizeof(str_pool2),
+                                 str_offsets2, 3,         &perr};
+    mem_src_t src = {mp, mp_len, 7};
+
+    CHECK(cfgpack_schema_measure_msgpack(mp, mp_len, &m, &perr) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_schema_measure_msgpack_stream(mem_source, &src, SIZE_MAX,
+                                                window, sizeof(window), &m2,
+                                                &perr) == CFGPACK_OK);
+    CHECK(memcmp(&m, &m2, sizeof(m)) == 0);
+    LOG("Measure: %zu entries, %zu pool bytes", m2.entry_count,
+        m2.str_pool_size);
+
+    LOG("7-byte reads through a %zu-byte window", sizeof(window));
+    CHECK(cfgpack_schema_parse_msgpack(mp, mp_len, &flat) == CFGPACK_OK);
+    memset(str_pool2, 0x5a, sizeof(str_pool2));
+    CHECK(cfgpack_schema_parse_msgpack_stream(mem_source, &src, SIZE_MAX,
+                                              window, sizeof(window),
+                                              &opts) == CFGPACK_OK);
+    CHECK(strcmp(schema2.map_name, "strm") == 0 && schema2.version == 4);
+    CHECK(schema2.entry_count == 5);
+    CHECK(memcmp(entries, entries2, sizeof(entries)) == 0);
+    CHECK(memcmp(values, values2, sizeof(values)) == 0);
+    CHECK(memcmp(str_pool, str_pool2, sizeof(str_pool)) == 0);
+    CHECK(memcmp(str_offsets, str_offsets2, sizeof(str_offsets)) == 0);
+    LOG("Entries, values, pool and offsets match the flat parse");
+
+    LOG_SECTION("Outputs too small for a streamed default");
+    opts.str_pool_cap = m.str_pool_size - 1;
+    CHECK(cfgpack_schema_parse_msgpack_stream(mem_source, &src, SIZE_MAX,
+                                              window, sizeof(window),
+                                              &opts) == CFGPACK_ERR_BOUNDS);
+    opts.str_pool_cap = sizeof(str_pool2);
+    opts.str_offsets_count = 2;
+    CHECK(cfgpack_schema_parse_msgpack_stream(mem_source, &src, SIZE_MAX,
+                                              window, sizeof(window),
+                                              &opts) == CFGPACK_ERR_BOUNDS);
+    opts.str_offsets_count = 3;
+    CHECK(cfgpack_schema_parse_msgpack_stream(mem_source, &src, SIZE_MAX,
+                                              window, sizeof(window) - 1,
+                                              &opts) == CFGPACK_ERR_BOUNDS);
+
+    LOG_SECTION("Input the single pass cannot take");
+    src.len = mp_len - 1;
+    CHECK(cfgpack_schema_parse_msgpack_stream(mem_source, &src, SIZE_MAX,
+                                              window, sizeof(window),
+                                              &opts) == CFGPACK_ERR_DECODE);
+    src.data = unsorted;
+    src.len = sizeof(unsorted);
+    CHECK(cfgpack_schema_parse_msgpack(unsorted, sizeof(unsorted), &flat) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_schema_parse_msgpack_stream(mem_source, &src, SIZE_MAX,
+                                              window, sizeof(window),
+                                              &opts) == CFGPACK_ERR_DECODE);
+    LOG("Unsorted entries: %s", perr.message);
+    src.data = value_first;
+    src.len = sizeof(value_first);
+    CHECK(cfgpack_schema_parse_msgpack(value_first, sizeof(value_first),
+                                       &flat) == CFGPACK_OK);
+    CHECK(cfgpack_schema_parse_msgpack_stream(mem_source, &src, SIZE_MAX,
+                                              window, sizeof(window),
+                                              &opts) == CFGPACK_ERR_DECODE);
+    LOG("Value before type: %s", perr.message);
+    CHECK(cfgpack_schema_parse_msgpack_stream(NULL, &src, SIZE_MAX, window,
+                                              sizeof(window), &opts) ==
+          CFGPACK_ERR_ARGS);
+
+    return TEST_OK;
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════ */
 
 int main(void) {
@@ -1000,6 +1265,10 @@ int main(void) {
     overall |= (test_case_result("err_type_mismatch_int_for_str",
                                  test_err_type_mismatch_int_for_str()) !=
                 TEST_OK);
+    overall |= (test_case_result("cow_string_defaults",
+                                 test_cow_string_defaults()) != TEST_OK);
+    overall |= (test_case_result("stream_parse", test_stream_parse()) !=
+                TEST_OK);
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
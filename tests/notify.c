@@ -0,0 +1,267 @@
+/* Change notification tests: under CFGPACK_NOTIFY (make test-features)
+ * subscriptions over index ranges are called once per batch after sets,
+ * set_many, pagein and transactions, and see which entries of their range
+ * changed.  The default build has no subscriptions. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 6
+
+/* Index 6 is derived: the callback of 5 writes it */
+static const char notify_map[] = "notify 1\n"
+                                 "1 kp u16 10\n"
+                                 "2 ki u16 20\n"
+                                 "3 kd u16 30\n"
+                                 "4 host str \"gw\"\n"
+                                 "5 rate u16 100\n"
+                                 "6 per u16 10\n";
+
+#ifdef CFGPACK_NOTIFY
+
+/* What one subscription saw */
+typedef struct {
+    unsigned calls;
+    uint8_t changed[N_ENTRIES + 1]; /* by index, from the last call */
+} seen_t;
+
+static seen_t seen[4];
+
+static void record(cfgpack_ctx_t *ctx, const cfgpack_sub_t *sub) {
+    seen_t *s = (seen_t *)sub->user;
+
+    s->calls++;
+    for (uint16_t i = 1; i <= N_ENTRIES; ++i) {
+        s->changed[i] = (uint8_t)cfgpack_notify_changed(ctx, i);
+    }
+}
+
+static void derive_period(cfgpack_ctx_t *ctx, const cfgpack_sub_t *sub) {
+    uint16_t rate = 1;
+
+    record(ctx, sub);
+    cfgpack_get_u16(ctx, 5, &rate);
+    cfgpack_set_u16(ctx, 6, (uint16_t)(1000 / rate));
+}
+
+/* pid (1-3), host (4), everything (1-6), rate (5) -> period (6) */
+static const cfgpack_sub_t subs[4] = {
+    {1, 3, record, &seen[0]},
+    {4, 4, record, &seen[1]},
+    {1, 6, record, &seen[2]},
+    {5, 5, derive_period, &seen[3]},
+};
+
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    cfgpack_err_t rc;
+
+    memset(seen, 0, sizeof(seen));
+    rc = fixture_parse(f, notify_map);
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_notify_init(&f->ctx, subs, 4, f->bits, sizeof(f->bits));
+    }
+    return (rc);
+}
+
+static unsigned total_calls(void) {
+    return (seen[0].calls + seen[1].calls + seen[2].calls + seen[3].calls);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Sets notify the subscriptions of their range, once per batch
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_notify_sets) {
+    static fixture_t f;
+    static const uint16_t pid[3] = {1, 2, 3};
+    cfgpack_value_t gains[3] = {
+        {.type = CFGPACK_TYPE_U16, .v.u64 = 11},
+        {.type = CFGPACK_TYPE_U16, .v.u64 = 21},
+        {.type = CFGPACK_TYPE_U16, .v.u64 = 31},
+    };
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(total_calls() == 0);
+
+    LOG_SECTION("One set: the pid and catch-all subscriptions");
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 22) == CFGPACK_OK);
+    CHECK(seen[0].calls == 1 && seen[1].calls == 0 && seen[2].calls == 1);
+    CHECK(seen[0].changed[2] && !seen[0].changed[1] && !seen[0].changed[3]);
+    CHECK(cfgpack_notify_changed(&f.ctx, 2) == 0);
+
+    LOG_SECTION("set_many of three gains: one call per subscription");
+    CHECK(cfgpack_set_many(&f.ctx, pid, gains, 3, NULL) == CFGPACK_OK);
+    CHECK(seen[0].calls == 2 && seen[2].calls == 2 && seen[1].calls == 0);
+    CHECK(seen[0].changed[1] && seen[0].changed[2] && seen[0].changed[3]);
+    LOG("3 changes delivered in 1 call to each of 2 subscriptions");
+
+    LOG_SECTION("Failed sets notify nobody");
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 1) == CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(cfgpack_set_str(&f.ctx, 9, "x") == CFGPACK_ERR_MISSING);
+    CHECK(seen[0].calls == 2 && seen[2].calls == 2);
+
+    LOG_SECTION("String set reaches the host subscription");
+    CHECK(cfgpack_set_str(&f.ctx, 4, "gw2") == CFGPACK_OK);
+    CHECK(seen[1].calls == 1 && seen[1].changed[4]);
+    CHECK(seen[0].calls == 2 && seen[2].calls == 3);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Callbacks that set entries are delivered in a further pass
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_notify_derived) {
+    static fixture_t f;
+    uint16_t period = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+
+    LOG_SECTION("rate -> period, set from the callback");
+    CHECK(cfgpack_set_u16(&f.ctx, 5, 50) == CFGPACK_OK);
+    CHECK(cfgpack_get_u16(&f.ctx, 6, &period) == CFGPACK_OK && period == 20);
+    CHECK(seen[3].calls == 1);
+    /* Catch-all: rate in pass 1, period in pass 2 */
+    CHECK(seen[2].calls == 2);
+    CHECK(seen[2].changed[6] && !seen[2].changed[5]);
+    LOG("Derived entry delivered in a second pass");
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Pagein and transactions notify once, when they complete
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_notify_pagein_txn) {
+    static fixture_t f;
+    uint8_t blob[128];
+    uint8_t delta[64];
+  #ifdef CFGPACK_TXN
+    uint8_t undo[256];
+  #endif
+    size_t len = 0;
+    size_t dlen = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 3, 33) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_delta(&f.ctx, delta, sizeof(delta), &dlen) ==
+          CFGPACK_OK);
+    memset(seen, 0, sizeof(seen));
+
+    LOG_SECTION("Full pagein: every subscription holding present entries");
+    CHECK(cfgpack_pagein_buf(&f.ctx, blob, len) == CFGPACK_OK);
+    CHECK(seen[0].calls == 1 && seen[1].calls == 1 && seen[3].calls == 1);
+    CHECK(seen[0].changed[1] && seen[0].changed[2] && seen[0].changed[3]);
+
+    LOG_SECTION("Delta pagein: only the keys it carries");
+    memset(seen, 0, sizeof(seen));
+    CHECK(cfgpack_pagein_delta(&f.ctx, delta, dlen) == CFGPACK_OK);
+    CHECK(seen[0].calls == 1 && seen[1].calls == 0 && seen[3].calls == 0);
+    CHECK(seen[0].changed[3] && !seen[0].changed[1]);
+
+  #ifdef CFGPACK_TXN
+    LOG_SECTION("Transaction: held until commit");
+    memset(seen, 0, sizeof(seen));
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 1, 1) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 2) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 4, "h") == CFGPACK_OK);
+    CHECK(total_calls() == 0);
+    CHECK(cfgpack_txn_commit(&f.ctx) == CFGPACK_OK);
+    CHECK(seen[0].calls == 1 && seen[1].calls == 1 && seen[2].calls == 1);
+
+    LOG_SECTION("Aborted transaction notifies the entries it touched");
+    memset(seen, 0, sizeof(seen));
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 4, "gone") == CFGPACK_OK);
+    CHECK(cfgpack_txn_abort(&f.ctx) == CFGPACK_OK);
+    CHECK(seen[1].calls == 1 && seen[0].calls == 0);
+  #endif
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. Argument checks and detaching
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_notify_args) {
+    static fixture_t f;
+    cfgpack_sub_t bad[1] = {{3, 2, record, &seen[0]}};
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_notify_init(NULL, subs, 4, f.bits, sizeof(f.bits)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_notify_init(&f.ctx, subs, 4, NULL, sizeof(f.bits)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_notify_init(&f.ctx, bad, 1, f.bits, sizeof(f.bits)) ==
+          CFGPACK_ERR_ARGS);
+    bad[0].first = 1;
+    bad[0].fn = NULL;
+    CHECK(cfgpack_notify_init(&f.ctx, bad, 1, f.bits, sizeof(f.bits)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_notify_init(&f.ctx, subs, 4, f.bits, 1) ==
+          CFGPACK_ERR_BOUNDS);
+
+    LOG_SECTION("cfgpack_init() detaches the subscriptions");
+    CHECK(fixture_init(&f) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 1, 5) == CFGPACK_OK);
+    CHECK(total_calls() == 0);
+
+    return TEST_OK;
+}
+
+#else /* !CFGPACK_NOTIFY */
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Default build: no subscriptions, sets only store
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_notify_off) {
+    LOG_SECTION("Default build keeps the plain set path");
+
+    static fixture_t f;
+    uint16_t per = 0;
+
+    CHECK(fixture_parse(&f, notify_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 5, 50) == CFGPACK_OK);
+    CHECK(cfgpack_get_u16(&f.ctx, 6, &per) == CFGPACK_OK && per == 10);
+    LOG("ctx %zu B without subscriptions", sizeof(cfgpack_ctx_t));
+
+    return TEST_OK;
+}
+
+#endif /* CFGPACK_NOTIFY */
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+#ifdef CFGPACK_NOTIFY
+    overall |= (test_case_result("notify_sets", test_notify_sets()) !=
+                TEST_OK);
+    overall |= (test_case_result("notify_derived", test_notify_derived()) !=
+                TEST_OK);
+    overall |= (test_case_result("notify_pagein_txn",
+                                 test_notify_pagein_txn()) != TEST_OK);
+    overall |= (test_case_result("notify_args", test_notify_args()) !=
+                TEST_OK);
+#else
+    overall |= (test_case_result("notify_off", test_notify_off()) != TEST_OK);
+#endif
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -19,6 +19,7 @@ static void make_schema(cfgpack_schema_t *schema,
         snprintf(entries[i].name, sizeof(entries[i].name), "e%zu", i);
         entries[i].type = CFGPACK_TYPE_U8;
         entries[i].has_default = 0;
+        entries[i].str_max = 0;
     }
 }
 
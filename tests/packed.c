@@ -0,0 +1,405 @@
+/* Packed pageout (wire format v2): a keyless array with a layout
+ * fingerprint and presence bitmap, detected by every full pagein path and
+ * by cfgpack_peek_name(), and rejected by schemas of another layout.
+ * Without CFGPACK_PACKED_WIRE only the map layout is checked. */
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/msgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 20
+
+static const cfgpack_type_t scalar_types[] = {
+    CFGPACK_TYPE_U8,  CFGPACK_TYPE_U16, CFGPACK_TYPE_I16,
+    CFGPACK_TYPE_U32, CFGPACK_TYPE_F32, CFGPACK_TYPE_I8,
+};
+
+static cfgpack_type_t scalar_type(size_t i) {
+    return (scalar_types[i % 6]);
+}
+
+/* Scalars at index 1..18, fstr at 19, str at 20; entry 1 defaults to 7.
+ * Nothing is set. */
+static cfgpack_err_t make_schema(fixture_t *f, const char *name) {
+    fixture_schema(f, name, N_ENTRIES, scalar_type);
+    f->entries[N_ENTRIES - 2].type = CFGPACK_TYPE_FSTR;
+    f->entries[N_ENTRIES - 1].type = CFGPACK_TYPE_STR;
+    f->entries[0].has_default = 1;
+    f->values[0].type = CFGPACK_TYPE_U8;
+    f->values[0].v.u64 = 7;
+    return (fixture_init(f));
+}
+
+/* Every entry but index 10 set, with signed values on both sides of 0. */
+static cfgpack_err_t make_fixture(fixture_t *f, const char *name) {
+    cfgpack_err_t rc = make_schema(f, name);
+
+    for (uint16_t i = 1; rc == CFGPACK_OK && i <= 18; ++i) {
+        if (i == 10) {
+            continue;
+        }
+        switch (scalar_types[(i - 1) % 6]) {
+        case CFGPACK_TYPE_U8:
+            rc = cfgpack_set_u8(&f->ctx, i, (uint8_t)(i * 13));
+            break;
+        case CFGPACK_TYPE_U16:
+            rc = cfgpack_set_u16(&f->ctx, i, (uint16_t)(300 * i));
+            break;
+        case CFGPACK_TYPE_I16:
+            rc = cfgpack_set_i16(&f->ctx, i,
+                                 (int16_t)(i == 3 ? 200 : -200 * i));
+            break;
+        case CFGPACK_TYPE_U32:
+            rc = cfgpack_set_u32(&f->ctx, i, 70000u * i);
+            break;
+        case CFGPACK_TYPE_F32:
+            rc = cfgpack_set_f32(&f->ctx, i, 0.25f * i);
+            break;
+        default: rc = cfgpack_set_i8(&f->ctx, i, (int8_t)-i); break;
+        }
+    }
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_set_fstr(&f->ctx, 19, "eu868");
+    }
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_set_str(&f->ctx, 20, "gateway.example.net");
+    }
+    return (rc);
+}
+
+#ifdef CFGPACK_PACKED_WIRE
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+} mem_source_t;
+
+/* Serves at most 8 bytes per call. */
+static cfgpack_err_t mem_source(void *user,
+                                size_t offset,
+                                uint8_t *dst,
+                                size_t cap,
+                                size_t *out_len) {
+    mem_source_t *m = (mem_source_t *)user;
+    size_t n = offset < m->len ? m->len - offset : 0;
+
+    if (n > cap) {
+        n = cap;
+    }
+    if (n > 8) {
+        n = 8;
+    }
+    memcpy(dst, m->data + offset, n);
+    *out_len = n;
+    return (CFGPACK_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Packed round trip reproduces the state of a map pageout
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_packed_roundtrip) {
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t map[256];
+    uint8_t packed[256];
+    uint8_t again[256];
+    size_t map_len = 0;
+    size_t packed_len = 0;
+    size_t again_len = 0;
+    cfgpack_schema_sizing_t sizing;
+
+    CHECK(make_fixture(&f, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, map, sizeof(map), &map_len) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 9) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_packed(&f.ctx, packed, sizeof(packed),
+                                 &packed_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+    LOG("Map %zu bytes, packed %zu bytes", map_len, packed_len);
+    CHECK(packed_len < map_len);
+    CHECK(cfgpack_schema_get_sizing(&f.schema, &sizing) == CFGPACK_OK);
+    CHECK(packed_len <= sizing.blob_max);
+
+    LOG_SECTION("Pagein detects the layout and restores every entry");
+    CHECK(make_schema(&g, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&g.ctx, packed, packed_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&g.ctx) == N_ENTRIES - 1);
+    CHECK(!cfgpack_presence_get(&g.ctx, 9));
+    CHECK(cfgpack_get_dirty_count(&g.ctx) == 0);
+    CHECK(cfgpack_pageout(&g.ctx, again, sizeof(again), &again_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, map, sizeof(map), &map_len) == CFGPACK_OK);
+    CHECK(again_len == map_len && memcmp(again, map, map_len) == 0);
+
+    LOG_SECTION("Absent entry with a default is restored");
+    cfgpack_presence_clear(&f.ctx, 0);
+    CHECK(cfgpack_pageout_packed(&f.ctx, packed, sizeof(packed),
+                                 &packed_len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&g.ctx, packed, packed_len) == CFGPACK_OK);
+    CHECK(cfgpack_presence_get(&g.ctx, 0));
+    CHECK(cfgpack_get_size(&g.ctx) == N_ENTRIES - 1);
+
+    LOG_SECTION("Too small buffer reports the needed size");
+    CHECK(cfgpack_pageout_packed(&f.ctx, packed, 16, &again_len) ==
+          CFGPACK_ERR_ENCODE);
+    CHECK(again_len == packed_len);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Peek, remap, stream and lazy pagein accept packed blobs
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_packed_detection) {
+    static const cfgpack_remap_entry_t remap[] = {{3, 4}, {4, 3}};
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t packed[256];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+  #ifdef CFGPACK_LAZY
+    uint32_t lazy_off[N_ENTRIES];
+  #endif
+    size_t packed_len = 0;
+    mem_source_t src;
+    char name[16];
+    uint32_t u32 = 0;
+    int16_t i16 = 0;
+    const char *s = NULL;
+    uint16_t s_len = 0;
+
+    CHECK(make_fixture(&f, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_pageout_packed(&f.ctx, packed, sizeof(packed),
+                                 &packed_len) == CFGPACK_OK);
+
+    LOG_SECTION("Peek reads the name");
+    CHECK(cfgpack_peek_name(packed, packed_len, name, sizeof(name)) ==
+          CFGPACK_OK);
+    CHECK(strcmp(name, "pk") == 0);
+    CHECK(cfgpack_peek_name(packed, packed_len, name, 2) ==
+          CFGPACK_ERR_BOUNDS);
+
+    LOG_SECTION("Same layout: remap table is not used");
+    CHECK(make_schema(&g, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_pagein_remap(&g.ctx, packed, packed_len, remap, 2) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_get_i16(&g.ctx, 3, &i16) == CFGPACK_OK && i16 == 200);
+    CHECK(cfgpack_get_u32(&g.ctx, 4, &u32) == CFGPACK_OK && u32 == 280000u);
+
+    LOG_SECTION("Streaming pagein through a small window");
+    CHECK(make_schema(&g, "pk") == CFGPACK_OK);
+    src.data = packed;
+    src.len = packed_len;
+    CHECK(cfgpack_pagein_stream(&g.ctx, mem_source, &src, window,
+                                sizeof(window)) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&g.ctx) == N_ENTRIES - 1);
+    CHECK(cfgpack_get_str(&g.ctx, 20, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 19 && memcmp(s, "gateway.example.net", 19) == 0);
+
+  #ifdef CFGPACK_LAZY
+    LOG_SECTION("Lazy pagein decodes on first access");
+    CHECK(make_schema(&g, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_lazy_init(&g.ctx, lazy_off, N_ENTRIES) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&g.ctx, packed, packed_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_i16(&g.ctx, 9, &i16) == CFGPACK_OK && i16 == -1800);
+    CHECK(cfgpack_lazy_finish(&g.ctx) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&g.ctx) == N_ENTRIES - 1);
+  #endif
+
+    LOG_SECTION("Deltas and diffs are map-only");
+    CHECK(cfgpack_pagein_delta(&g.ctx, packed, packed_len) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_blob_diff(packed, packed_len, packed, packed_len, window,
+                            sizeof(window), NULL) == CFGPACK_ERR_DECODE);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. The layout fingerprint gates packed pagein
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_packed_fingerprint) {
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t packed[256];
+    size_t packed_len = 0;
+    uint32_t u32 = 0;
+
+    CHECK(make_fixture(&f, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_pageout_packed(&f.ctx, packed, sizeof(packed),
+                                 &packed_len) == CFGPACK_OK);
+
+    LOG_SECTION("Renamed schema and entries, same layout: loads");
+    CHECK(make_schema(&g, "pk2") == CFGPACK_OK);
+    snprintf(g.entries[3].name, sizeof(g.entries[3].name), "zz");
+    g.schema.version = 2;
+    CHECK(cfgpack_schema_fingerprint(&g.schema) ==
+          cfgpack_schema_fingerprint(&f.schema));
+    CHECK(cfgpack_pagein_buf(&g.ctx, packed, packed_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&g.ctx, 4, &u32) == CFGPACK_OK && u32 == 280000u);
+
+    LOG_SECTION("Changed type: rejected before any entry changes");
+    CHECK(make_schema(&g, "pk") == CFGPACK_OK);
+    g.entries[3].type = CFGPACK_TYPE_U64;
+    CHECK(cfgpack_set_u64(&g.ctx, 4, 5) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&g.ctx, packed, packed_len) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(cfgpack_get_size(&g.ctx) == 2);
+
+    LOG_SECTION("Moved index: rejected");
+    CHECK(make_schema(&g, "pk") == CFGPACK_OK);
+    g.entries[N_ENTRIES - 1].index = 40;
+    CHECK(cfgpack_schema_fingerprint(&g.schema) !=
+          cfgpack_schema_fingerprint(&f.schema));
+
+    LOG_SECTION("Corrupt blob fails the trailer");
+    packed[packed_len / 2] ^= 0x04;
+    CHECK(make_schema(&g, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&g.ctx, packed, packed_len) == CFGPACK_ERR_CRC);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. A bitmap that disagrees with the value count changes nothing
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_packed_count_mismatch) {
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t packed[256];
+    uint8_t bad[256];
+    size_t packed_len = 0;
+    size_t bad_len;
+    size_t last;
+    size_t end;
+    cfgpack_reader_t r;
+    uint32_t count = 0;
+    uint16_t u16 = 0;
+  #ifdef CFGPACK_LAZY
+    uint32_t lazy_off[N_ENTRIES];
+  #endif
+
+    /* Entries 1, 2 and 3 set, the rest absent */
+    CHECK(make_schema(&f, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 9) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 601) == CFGPACK_OK);
+    CHECK(cfgpack_set_i16(&f.ctx, 3, 200) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_packed(&f.ctx, packed, sizeof(packed),
+                                 &packed_len) == CFGPACK_OK);
+
+    /* Header, name and bitmap, then the three values */
+    cfgpack_reader_init(&r, packed, packed_len - TEST_CRC_SIZE);
+    CHECK(cfgpack_msgpack_decode_array_header(&r, &count) == CFGPACK_OK);
+    CHECK(count == 6 && packed[0] == 0x96);
+    for (int k = 0; k < 5; ++k) {
+        CHECK(cfgpack_msgpack_skip_value(&r) == CFGPACK_OK);
+    }
+    last = r.pos;
+    CHECK(cfgpack_msgpack_skip_value(&r) == CFGPACK_OK);
+    end = r.pos;
+
+    LOG_SECTION("Three bits, two values: rejected, old config kept");
+    CHECK(make_fixture(&g, "pk") == CFGPACK_OK);
+    memcpy(bad, packed, last);
+    bad[0] = 0x95;
+    bad_len = last;
+    test_append_crc(bad, &bad_len);
+    CHECK(cfgpack_pagein_buf(&g.ctx, bad, bad_len) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_get_size(&g.ctx) == N_ENTRIES - 1);
+    CHECK(cfgpack_get_u16(&g.ctx, 2, &u16) == CFGPACK_OK && u16 == 600);
+    CHECK(cfgpack_presence_get(&g.ctx, N_ENTRIES - 1));
+
+    LOG_SECTION("Three bits, four values: rejected, old config kept");
+    memcpy(bad, packed, end);
+    memcpy(bad + end, packed + last, end - last);
+    bad[0] = 0x97;
+    bad_len = end + (end - last);
+    test_append_crc(bad, &bad_len);
+    CHECK(cfgpack_pagein_buf(&g.ctx, bad, bad_len) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_get_size(&g.ctx) == N_ENTRIES - 1);
+    CHECK(cfgpack_get_u16(&g.ctx, 2, &u16) == CFGPACK_OK && u16 == 600);
+
+  #ifdef CFGPACK_LAZY
+    LOG_SECTION("Lazy pagein rejects it the same way");
+    CHECK(cfgpack_lazy_init(&g.ctx, lazy_off, N_ENTRIES) == CFGPACK_OK);
+    memcpy(bad, packed, last);
+    bad[0] = 0x95;
+    bad_len = last;
+    test_append_crc(bad, &bad_len);
+    CHECK(cfgpack_pagein_buf(&g.ctx, bad, bad_len) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_get_size(&g.ctx) == N_ENTRIES - 1);
+    CHECK(cfgpack_get_u16(&g.ctx, 2, &u16) == CFGPACK_OK && u16 == 600);
+  #endif
+
+    LOG_SECTION("The intact blob still loads");
+    CHECK(cfgpack_pagein_buf(&g.ctx, packed, packed_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&g.ctx) == 3);
+    CHECK(cfgpack_get_u16(&g.ctx, 2, &u16) == CFGPACK_OK && u16 == 601);
+
+    return TEST_OK;
+}
+
+#else /* !CFGPACK_PACKED_WIRE */
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Default build: map blobs only
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_packed_off) {
+    LOG_SECTION("Default build keeps the map layout");
+
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t map[256];
+    uint8_t again[256];
+    size_t map_len = 0;
+    size_t again_len = 0;
+    char name[16];
+
+    CHECK(make_fixture(&f, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, map, sizeof(map), &map_len) == CFGPACK_OK);
+    CHECK(cfgpack_peek_name(map, map_len, name, sizeof(name)) == CFGPACK_OK);
+    CHECK(strcmp(name, "pk") == 0);
+    CHECK(make_schema(&g, "pk") == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&g.ctx, map, map_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&g.ctx) == N_ENTRIES - 1);
+    CHECK(cfgpack_pageout(&g.ctx, again, sizeof(again), &again_len) ==
+          CFGPACK_OK);
+    CHECK(again_len == map_len && memcmp(again, map, map_len) == 0);
+
+    return TEST_OK;
+}
+
+#endif /* CFGPACK_PACKED_WIRE */
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+#ifdef CFGPACK_PACKED_WIRE
+    overall |= (test_case_result("packed_roundtrip",
+                                 test_packed_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("packed_detection",
+                                 test_packed_detection()) != TEST_OK);
+    overall |= (test_case_result("packed_fingerprint",
+                                 test_packed_fingerprint()) != TEST_OK);
+    overall |= (test_case_result("packed_count_mismatch",
+                                 test_packed_count_mismatch()) != TEST_OK);
+#else
+    overall |= (test_case_result("packed_off", test_packed_off()) != TEST_OK);
+#endif
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
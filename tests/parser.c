@@ -128,6 +128,114 @@ TEST_CASE(test_parse_duplicate_index) {
     return (TEST_OK);
 }
 
+TEST_CASE(test_parse_unsorted_large) {
+    LOG_SECTION("Sort and duplicate checks on 128 shuffled entries");
+
+    static char map[128 * 32];
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[128];
+    cfgpack_value_t values[128];
+    char str_pool[128 * 17];
+    uint16_t str_offsets[128];
+    cfgpack_parse_error_t err;
+    cfgpack_parse_opts_t opts = {&schema,     entries,  128,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 128,      &err};
+    size_t len = (size_t)snprintf(map, sizeof(map), "big 1\n");
+    int ok = 1;
+
+    /* Indices 1..128 in a stride-37 shuffle; odd ones are fstr */
+    for (int i = 0; i < 128; ++i) {
+        int idx = (i * 37) % 128 + 1;
+        if (idx % 2) {
+            len += (size_t)snprintf(map + len, sizeof(map) - len,
+                                    "%d n%d fstr \"s%d\"\n", idx, idx, idx);
+        } else {
+            len += (size_t)snprintf(map + len, sizeof(map) - len,
+                                    "%d n%d u16 %d\n", idx, idx, idx);
+        }
+    }
+    CHECK(cfgpack_parse_schema(map, len, &opts) == CFGPACK_OK);
+    for (size_t i = 0; i < 128; ++i) {
+        char name[6];
+        char def[6];
+        snprintf(name, sizeof(name), "n%zu", i + 1);
+        snprintf(def, sizeof(def), "s%zu", i + 1);
+        ok &= entries[i].index == i + 1 && strcmp(entries[i].name, name) == 0;
+        if (i % 2 == 0) {
+            ok &= strcmp(str_pool + values[i].v.fstr.offset, def) == 0;
+        } else {
+            ok &= values[i].v.u64 == i + 1;
+        }
+    }
+    CHECK(ok);
+    LOG("Entries sorted with defaults attached");
+
+    LOG_SECTION("Duplicates far apart in the input are found");
+    memcpy(strstr(map, "n75 "), "n11 ", 4);
+    CHECK(cfgpack_parse_schema(map, len, &opts) == CFGPACK_ERR_DUPLICATE);
+    LOG("Correctly rejected: %s", err.message);
+    memcpy(strstr(map, "n11 "), "n75 ", 4);
+    memcpy(strstr(map, "\n75 "), "\n11 ", 4);
+    CHECK(cfgpack_parse_schema(map, len, &opts) == CFGPACK_ERR_DUPLICATE);
+    LOG("Correctly rejected: %s", err.message);
+
+    return (TEST_OK);
+}
+
+TEST_CASE(test_parse_line_endings) {
+    LOG_SECTION("LF, CRLF and CR line ends; long lines; error line numbers");
+
+    static char map[1024];
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[8];
+    cfgpack_value_t values[8];
+    char str_pool[256];
+    uint16_t str_offsets[8];
+    cfgpack_parse_error_t err;
+    cfgpack_parse_opts_t opts = {&schema,     entries,  8,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 8,        &err};
+    const char *ends[] = {"\n", "\r\n", "\r"};
+    cfgpack_ctx_t ctx;
+    const char *s;
+    uint16_t slen;
+    uint16_t u;
+    size_t len;
+
+    for (size_t e = 0; e < sizeof(ends) / sizeof(ends[0]); ++e) {
+        const char *nl = ends[e];
+        LOG("Line end %zu", e);
+        len = (size_t)snprintf(
+            map, sizeof(map),
+            "demo 1%s"
+            "# a comment line long enough to span several scan words%s"
+            "%s"
+            "1\t\tone     u8      7   # trailing comment%s"
+            "2 two str \"a default string of forty characters!!!!\"%s"
+            "    %s"
+            "3 three u16 65535",
+            nl, nl, nl, nl, nl, nl);
+        CHECK(cfgpack_parse_schema(map, len, &opts) == CFGPACK_OK);
+        CHECK(schema.entry_count == 3);
+        CHECK(cfgpack_init(&ctx, &schema, values, 8, str_pool,
+                           sizeof(str_pool), str_offsets, 8) == CFGPACK_OK);
+        CHECK(cfgpack_get_u16(&ctx, 3, &u) == CFGPACK_OK && u == 65535);
+        CHECK(cfgpack_get_str(&ctx, 2, &s, &slen) == CFGPACK_OK);
+        CHECK(slen == 40);
+
+        len = (size_t)snprintf(map, sizeof(map),
+                               "demo 1%s%s# comment%s1 a u8 0%s2 b nope 0%s",
+                               nl, nl, nl, nl, nl);
+        CHECK(cfgpack_parse_schema(map, len, &opts) ==
+              CFGPACK_ERR_INVALID_TYPE);
+        LOG("  error on line %zu", err.line);
+        CHECK(err.line == 5);
+    }
+
+    return (TEST_OK);
+}
+
 int main(void) {
     test_result_t overall = TEST_OK;
 
@@ -135,6 +243,10 @@ int main(void) {
     overall |= (test_case_result("bad_type", test_parse_bad_type()) != TEST_OK);
     overall |= (test_case_result("dup_index", test_parse_duplicate_index()) !=
                 TEST_OK);
+    overall |= (test_case_result("unsorted_large",
+                                 test_parse_unsorted_large()) != TEST_OK);
+    overall |= (test_case_result("line_endings", test_parse_line_endings()) !=
+                TEST_OK);
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
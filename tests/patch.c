@@ -0,0 +1,239 @@
+/* Fixed-width pageout and in-place patching: the blob stays plain msgpack,
+ * every scalar keeps its schema width, and a patched blob (value bytes plus
+ * trailer) matches a fresh fixed-width pageout byte for byte. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 8
+
+static cfgpack_type_t patch_type(size_t i) {
+    static const cfgpack_type_t types[N_ENTRIES] = {
+        CFGPACK_TYPE_U8,  CFGPACK_TYPE_U16, CFGPACK_TYPE_U32,
+        CFGPACK_TYPE_U64, CFGPACK_TYPE_I16, CFGPACK_TYPE_F32,
+        CFGPACK_TYPE_F64, CFGPACK_TYPE_STR};
+
+    return (types[i]);
+}
+
+/* One entry of each scalar width plus a string (index 8). */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    return (fixture_make(f, "patch", N_ENTRIES, patch_type));
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t bytes_read;
+} mem_source_t;
+
+static cfgpack_err_t mem_source(void *user,
+                                size_t offset,
+                                uint8_t *dst,
+                                size_t cap,
+                                size_t *out_len) {
+    mem_source_t *m = (mem_source_t *)user;
+    size_t n;
+
+    if (offset >= m->len) {
+        *out_len = 0;
+        return (CFGPACK_OK);
+    }
+    n = m->len - offset;
+    if (n > cap) {
+        n = cap;
+    }
+    memcpy(dst, m->data + offset, n);
+    m->bytes_read += n;
+    *out_len = n;
+    return (CFGPACK_OK);
+}
+
+static void apply_patch(uint8_t *blob, const cfgpack_patch_t *p) {
+    memcpy(blob + p->off, p->bytes, p->len);
+    memcpy(blob + p->crc_off, p->crc, sizeof(p->crc));
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Scalars use their schema width and the blob pages in unchanged
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_fixed_layout) {
+    static fixture_t f;
+    uint32_t off[N_ENTRIES];
+    uint8_t fixed[128];
+    uint8_t small[128];
+    size_t fixed_len = 0;
+    size_t small_len = 0;
+    uint16_t u16;
+    double f64;
+
+    LOG_SECTION("Fixed-width pageout of small values");
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 1) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 2) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&f.ctx, 3, 3) == CFGPACK_OK);
+    CHECK(cfgpack_set_i16(&f.ctx, 5, -1) == CFGPACK_OK);
+    CHECK(cfgpack_set_f64(&f.ctx, 7, 0.5) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 8, "abc") == CFGPACK_OK);
+
+    CHECK(cfgpack_pageout(&f.ctx, small, sizeof(small), &small_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout_fixed(&f.ctx, fixed, sizeof(fixed), &fixed_len,
+                                off) == CFGPACK_OK);
+    CHECK(fixed_len == small_len + 1 + 2 + 4 + 2);
+    LOG("Smallest encoding %zu bytes, fixed-width %zu bytes", small_len,
+        fixed_len);
+
+    CHECK(fixed[off[0]] == 0xcc && fixed[off[0] + 1] == 1);
+    CHECK(fixed[off[1]] == 0xcd);
+    CHECK(fixed[off[2]] == 0xce);
+    CHECK(fixed[off[4]] == 0xd1 && fixed[off[4] + 1] == 0xff);
+    CHECK(fixed[off[6]] == 0xcb);
+    CHECK(fixed[off[7]] == 0xa3);
+    CHECK(off[3] == 0 && off[5] == 0);
+    LOG("Value offsets recorded; absent entries report 0");
+
+    LOG_SECTION("cfgpack_pagein_buf reads the fixed-width blob");
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, fixed, fixed_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_u16(&f.ctx, 2, &u16) == CFGPACK_OK && u16 == 2);
+    CHECK(cfgpack_get_f64(&f.ctx, 7, &f64) == CFGPACK_OK && f64 == 0.5);
+
+    LOG_SECTION("A value wider than its schema type is rejected");
+    cfgpack_value_t wide = {.type = CFGPACK_TYPE_U8, .v.u64 = 256};
+    CHECK(cfgpack_set(&f.ctx, 1, &wide) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_fixed(&f.ctx, fixed, sizeof(fixed), &fixed_len,
+                                NULL) == CFGPACK_ERR_BOUNDS);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. A patched blob equals a fresh fixed-width pageout
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_patch_matches_pageout) {
+    static fixture_t f;
+    uint32_t off[N_ENTRIES];
+    uint8_t blob[128];
+    uint8_t fresh[128];
+    size_t len = 0;
+    size_t fresh_len = 0;
+    cfgpack_patch_t p;
+    mem_source_t src;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 0) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 10) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&f.ctx, 3, 7) == CFGPACK_OK);
+    CHECK(cfgpack_set_u64(&f.ctx, 4, 1) == CFGPACK_OK);
+    CHECK(cfgpack_set_i16(&f.ctx, 5, 0) == CFGPACK_OK);
+    CHECK(cfgpack_set_f32(&f.ctx, 6, 1.0f) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 8, "name") == CFGPACK_OK);
+    CHECK(cfgpack_pageout_fixed(&f.ctx, blob, sizeof(blob), &len, off) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Patch each scalar in turn");
+    CHECK(cfgpack_set_u8(&f.ctx, 1, 200) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 60000) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&f.ctx, 3, 0xdeadbeefu) == CFGPACK_OK);
+    CHECK(cfgpack_set_u64(&f.ctx, 4, UINT64_MAX) == CFGPACK_OK);
+    CHECK(cfgpack_set_i16(&f.ctx, 5, -32768) == CFGPACK_OK);
+    CHECK(cfgpack_set_f32(&f.ctx, 6, -2.25f) == CFGPACK_OK);
+    for (uint16_t i = 1; i <= 6; ++i) {
+        src.data = blob;
+        src.len = len;
+        src.bytes_read = 0;
+        CHECK(cfgpack_patch_fixed(&f.ctx, i, off, len, mem_source, &src,
+                                  &p) == CFGPACK_OK);
+        CHECK(src.bytes_read == p.len + 4);
+        apply_patch(blob, &p);
+    }
+    CHECK(cfgpack_pageout_fixed(&f.ctx, fresh, sizeof(fresh), &fresh_len,
+                                NULL) == CFGPACK_OK);
+    CHECK(fresh_len == len && memcmp(fresh, blob, len) == 0);
+    LOG("Six patches, each reading only value + trailer, match a rewrite");
+
+    LOG_SECTION("The patched blob passes its CRC and pages in");
+    uint32_t u32;
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, blob, len) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&f.ctx, 3, &u32) == CFGPACK_OK);
+    CHECK(u32 == 0xdeadbeefu);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Patch error paths
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_patch_errors) {
+    static fixture_t f;
+    uint32_t off[N_ENTRIES];
+    uint8_t blob[128];
+    size_t len = 0;
+    cfgpack_patch_t p;
+    mem_source_t src = {blob, 0, 0};
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 2, 5) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 8, "s") == CFGPACK_OK);
+    CHECK(cfgpack_pageout_fixed(&f.ctx, blob, sizeof(blob), &len, off) ==
+          CFGPACK_OK);
+    src.len = len;
+
+    CHECK(cfgpack_patch_fixed(NULL, 2, off, len, mem_source, &src, &p) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_patch_fixed(&f.ctx, 2, off, len, NULL, &src, &p) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_patch_fixed(&f.ctx, 0, off, len, mem_source, &src, &p) ==
+          CFGPACK_ERR_RESERVED_INDEX);
+    CHECK(cfgpack_patch_fixed(&f.ctx, 99, off, len, mem_source, &src, &p) ==
+          CFGPACK_ERR_MISSING);
+    LOG("NULL, reserved and unknown indices rejected");
+
+    /* Set after the pageout: present now, but not in the blob */
+    CHECK(cfgpack_set_u32(&f.ctx, 3, 1) == CFGPACK_OK);
+    CHECK(cfgpack_patch_fixed(&f.ctx, 3, off, len, mem_source, &src, &p) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_patch_fixed(&f.ctx, 8, off, len, mem_source, &src, &p) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+    LOG("Entry missing from the blob and string entry rejected");
+
+    CHECK(cfgpack_patch_fixed(&f.ctx, 2, off, off[1] + 2, mem_source, &src,
+                              &p) == CFGPACK_ERR_BOUNDS);
+    blob[off[1]] = 0xcc;
+    CHECK(cfgpack_patch_fixed(&f.ctx, 2, off, len, mem_source, &src, &p) ==
+          CFGPACK_ERR_DECODE);
+    LOG("Out-of-range blob length and mismatched format byte rejected");
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("fixed_layout", test_fixed_layout()) !=
+                TEST_OK);
+    overall |= (test_case_result("patch_matches_pageout",
+                                 test_patch_matches_pageout()) != TEST_OK);
+    overall |= (test_case_result("patch_errors", test_patch_errors()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
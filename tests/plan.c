@@ -0,0 +1,353 @@
+/* Single-arena planning: cfgpack_plan() layouts, cfgpack_plan_carve() and
+ * the blob_max bound reported by every measure path. */
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/compress.h"
+
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static const char plan_map[] = "plan 3\n"
+                               "1 big u64 0\n"
+                               "2 neg i64 0\n"
+                               "3 dbl f64 0\n"
+                               "4 flt f32 0\n"
+                               "5 host str \"example.org\"\n"
+                               "6 tag fstr NIL\n"
+                               "7 id str:8 \"abc\"\n"
+                               "9 mode u8 1\n";
+
+static union {
+    uint64_t align;
+    uint8_t bytes[16384];
+} arena;
+
+static cfgpack_plan_opts_t all_opts(void) {
+    cfgpack_plan_opts_t po = {CFGPACK_PLAN_INDEX_TABLE |
+                                  CFGPACK_PLAN_NAME_INDEX | CFGPACK_PLAN_IO |
+                                  CFGPACK_PLAN_DECOMPRESS | CFGPACK_PLAN_JSON,
+                              0, 0};
+    return (po);
+}
+
+/* Parse plan_map into a context whose storage is all carved from arena */
+static cfgpack_err_t build(cfgpack_ctx_t *ctx,
+                           cfgpack_schema_t *schema,
+                           const cfgpack_plan_opts_t *po,
+                           size_t skew,
+                           cfgpack_plan_t *plan,
+                           cfgpack_arena_t *a) {
+    cfgpack_schema_measure_t m;
+    cfgpack_parse_error_t perr;
+    cfgpack_err_t rc;
+
+    rc = cfgpack_schema_measure(plan_map, sizeof(plan_map) - 1, &m, &perr);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    rc = cfgpack_plan(&m, po, plan);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    rc = cfgpack_plan_carve(plan, arena.bytes + skew, plan->arena_size, a);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+
+    cfgpack_parse_opts_t opts = {schema,         a->entries,
+                                 a->max_entries, a->values,
+                                 a->str_pool,    a->str_pool_cap,
+                                 a->str_offsets, a->str_offsets_count,
+                                 &perr};
+    rc = cfgpack_parse_schema(plan_map, sizeof(plan_map) - 1, &opts);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+#ifdef CFGPACK_LARGE_SCHEMA
+    rc = cfgpack_ctx_bitmaps(ctx, a->bitmaps, a->bitmaps_len);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+#endif
+    return (cfgpack_init(ctx, schema, a->values, a->max_entries, a->str_pool,
+                         a->str_pool_cap, a->str_offsets,
+                         a->str_offsets_count));
+}
+
+/* Worst-case values: widest numbers and full strings of escaped bytes */
+static cfgpack_err_t fill_worst(cfgpack_ctx_t *ctx) {
+    char s[CFGPACK_STR_MAX + 1];
+    cfgpack_err_t rc = CFGPACK_OK;
+
+    rc |= cfgpack_set_u64(ctx, 1, UINT64_MAX);
+    rc |= cfgpack_set_i64(ctx, 2, INT64_MIN);
+    rc |= cfgpack_set_f64(ctx, 3, -1.2345678901234567e-300);
+    rc |= cfgpack_set_f32(ctx, 4, -1.17549435e-38f);
+    memset(s, 0x01, sizeof(s));
+    s[CFGPACK_STR_MAX] = '\0';
+    rc |= cfgpack_set_str(ctx, 5, s);
+    s[CFGPACK_FSTR_MAX] = '\0';
+    rc |= cfgpack_set_fstr(ctx, 6, s);
+    s[8] = '\0';
+    rc |= cfgpack_set_str(ctx, 7, s);
+    rc |= cfgpack_set_u8(ctx, 9, 255);
+    return (rc);
+}
+
+static int region_aligned(const cfgpack_plan_region_t *r, size_t align) {
+    return (r->size == 0 || r->off % align == 0);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Layout: every region aligned, in order and without overlap
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+TEST_CASE(test_plan_layout) {
+    LOG_SECTION("Region layout of a full-feature plan");
+
+    cfgpack_schema_measure_t m;
+    cfgpack_parse_error_t perr;
+    cfgpack_plan_opts_t po = all_opts();
+    cfgpack_plan_t plan;
+
+    CHECK(cfgpack_schema_measure(plan_map, sizeof(plan_map) - 1, &m, &perr) ==
+          CFGPACK_OK);
+    po.lfs_cache_size = 64;
+    CHECK(cfgpack_plan(&m, &po, &plan) == CFGPACK_OK);
+    LOG("arena_size=%zu blob_max=%zu json_max=%zu", plan.arena_size,
+        plan.blob_max, plan.json_max);
+
+    const cfgpack_plan_region_t *r[] = {
+        &plan.entries,     &plan.values,   &plan.name_index,
+        &plan.str_offsets, &plan.str_pool, &plan.index_table,
+        &plan.bitmaps,     &plan.io,       &plan.decompress,
+        &plan.json};
+    size_t end = 0;
+    for (size_t i = 0; i < sizeof(r) / sizeof(r[0]); ++i) {
+        CHECK(region_aligned(r[i], CFGPACK_PLAN_ALIGN));
+        if (r[i]->size) {
+            CHECK(r[i]->off >= end);
+            end = r[i]->off + r[i]->size;
+        }
+    }
+    CHECK(plan.align == CFGPACK_PLAN_ALIGN);
+    CHECK(plan.arena_size >= end + CFGPACK_PLAN_ALIGN - 1);
+
+    LOG("Region sizes follow the measure");
+    CHECK(plan.entries.size == m.entry_count * sizeof(cfgpack_entry_t));
+    CHECK(plan.values.size == m.entry_count * sizeof(cfgpack_value_t));
+    CHECK(plan.name_index.size == m.entry_count * sizeof(uint64_t));
+    CHECK(plan.str_pool.size == m.str_pool_size);
+    CHECK(plan.str_offsets.size ==
+          (m.str_count + m.fstr_count) * sizeof(cfgpack_str_off_t));
+    CHECK(plan.index_table.size == m.index_table_size);
+    CHECK(plan.decompress.size == m.blob_max);
+    CHECK(plan.io.size > m.blob_max + 64); /* compressed bound + cache */
+    CHECK(plan.json.size == plan.json_max);
+#ifdef CFGPACK_LARGE_SCHEMA
+    CHECK(plan.bitmaps.size == CFGPACK_BITMAP_BYTES(m.entry_count));
+#else
+    CHECK(plan.bitmaps.size == 0);
+#endif
+
+    LOG("Features left out get no storage");
+    CHECK(cfgpack_plan(&m, NULL, &plan) == CFGPACK_OK);
+    CHECK(plan.io.size == 0 && plan.json.size == 0);
+    CHECK(plan.index_table.size == 0 && plan.name_index.size == 0);
+    CHECK(plan.entries.size > 0 && plan.str_pool.size > 0);
+
+    LOG("Wider alignment");
+    po.align = 128;
+    CHECK(cfgpack_plan(&m, &po, &plan) == CFGPACK_OK);
+    for (size_t i = 0; i < sizeof(r) / sizeof(r[0]); ++i) {
+        CHECK(region_aligned(r[i], 128));
+    }
+
+    LOG("Rejects a bad alignment and NULL arguments");
+    po.align = 48;
+    CHECK(cfgpack_plan(&m, &po, &plan) == CFGPACK_ERR_ARGS);
+    po.align = 4;
+    CHECK(cfgpack_plan(&m, &po, &plan) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_plan(NULL, NULL, &plan) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_plan(&m, NULL, NULL) == CFGPACK_ERR_ARGS);
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Carve: base alignment and capacity checks
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+TEST_CASE(test_plan_carve) {
+    LOG_SECTION("Carve a buffer at every base alignment");
+
+    cfgpack_schema_measure_t m;
+    cfgpack_parse_error_t perr;
+    cfgpack_plan_opts_t po = all_opts();
+    cfgpack_plan_t plan;
+    cfgpack_arena_t a;
+
+    CHECK(cfgpack_schema_measure(plan_map, sizeof(plan_map) - 1, &m, &perr) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_plan(&m, &po, &plan) == CFGPACK_OK);
+    CHECK(plan.arena_size + CFGPACK_PLAN_ALIGN <= sizeof(arena.bytes));
+
+    for (size_t skew = 0; skew < CFGPACK_PLAN_ALIGN; ++skew) {
+        uint8_t *buf = arena.bytes + skew;
+        CHECK(cfgpack_plan_carve(&plan, buf, plan.arena_size, &a) ==
+              CFGPACK_OK);
+        CHECK((uintptr_t)a.entries % CFGPACK_PLAN_ALIGN == 0);
+        CHECK((uint8_t *)a.entries >= buf);
+        CHECK(a.json + a.json_cap <= (char *)buf + plan.arena_size);
+        CHECK((uint8_t *)a.values ==
+              (uint8_t *)a.entries + plan.values.off - plan.entries.off);
+    }
+    CHECK(a.max_entries == m.entry_count);
+    CHECK(a.str_pool_cap == m.str_pool_size);
+    CHECK(a.str_offsets_count == m.str_count + m.fstr_count);
+    CHECK(a.name_index_cap == m.entry_count);
+    CHECK(a.index_table_cap == m.index_table_size);
+    CHECK(a.decompress_cap == m.blob_max);
+
+    LOG("An aligned base needs no slack");
+    size_t exact = plan.arena_size - (CFGPACK_PLAN_ALIGN - 1);
+    CHECK(cfgpack_plan_carve(&plan, arena.bytes, exact, &a) == CFGPACK_OK);
+    CHECK(cfgpack_plan_carve(&plan, arena.bytes, exact - 1, &a) ==
+          CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_plan_carve(&plan, arena.bytes + 1, exact, &a) ==
+          CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_plan_carve(&plan, arena.bytes + 1, 4, &a) ==
+          CFGPACK_ERR_BOUNDS);
+
+    LOG("Empty regions carve as NULL");
+    CHECK(cfgpack_plan(&m, NULL, &plan) == CFGPACK_OK);
+    CHECK(cfgpack_plan_carve(&plan, arena.bytes, plan.arena_size, &a) ==
+          CFGPACK_OK);
+    CHECK(a.io == NULL && a.io_cap == 0);
+    CHECK(a.json == NULL && a.name_index == NULL);
+
+    CHECK(cfgpack_plan_carve(NULL, arena.bytes, 1, &a) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_plan_carve(&plan, NULL, 1, &a) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_plan_carve(&plan, arena.bytes, 1, NULL) ==
+          CFGPACK_ERR_ARGS);
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. A whole context on one arena, worst-case values
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+TEST_CASE(test_plan_context) {
+    LOG_SECTION("Parse, init, index, page out and export from one arena");
+
+    cfgpack_plan_opts_t po = all_opts();
+    cfgpack_plan_t plan;
+    cfgpack_arena_t a;
+    cfgpack_schema_t schema;
+    cfgpack_ctx_t ctx;
+    cfgpack_parse_error_t perr;
+    size_t len = 0;
+    size_t json_len = 0;
+
+    CHECK(build(&ctx, &schema, &po, 3, &plan, &a) == CFGPACK_OK);
+    CHECK(cfgpack_index_table_init(&ctx, a.index_table, a.index_table_cap) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_name_index_init(&ctx, a.name_index, a.name_index_cap) ==
+          CFGPACK_OK);
+    CHECK(fill_worst(&ctx) == CFGPACK_OK);
+
+    CHECK(cfgpack_pageout(&ctx, a.decompress, a.decompress_cap, &len) ==
+          CFGPACK_OK);
+    LOG("worst-case blob %zu <= blob_max %zu", len, plan.blob_max);
+    CHECK(len <= plan.blob_max);
+
+    CHECK(cfgpack_schema_write_json(&ctx, a.json, a.json_cap, &json_len,
+                                    &perr) == CFGPACK_OK);
+    LOG("worst-case JSON %zu <= json_max %zu", json_len, plan.json_max);
+    CHECK(json_len <= plan.json_max);
+
+    LOG("Compressed worst case fits the I/O region");
+    LZ4_stream_t lz;
+    size_t clen = 0;
+    CHECK(cfgpack_pageout_lz4(&ctx, a.io, a.io_cap, &clen, &lz, a.decompress,
+                              a.decompress_cap) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&ctx, 9, 0) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_lz4(&ctx, a.io + CFGPACK_LZ4_HDR_SIZE,
+                             clen - CFGPACK_LZ4_HDR_SIZE, len, a.decompress,
+                             a.decompress_cap) == CFGPACK_OK);
+    uint8_t mode = 0;
+    CHECK(cfgpack_get_u8_by_name(&ctx, "mode", &mode) == CFGPACK_OK);
+    CHECK(mode == 255);
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. blob_max agrees across every measure path
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+TEST_CASE(test_plan_blob_max_paths) {
+    LOG_SECTION("blob_max from .map, JSON, msgpack, image and sizing");
+
+    cfgpack_plan_t plan;
+    cfgpack_arena_t a;
+    cfgpack_schema_t schema;
+    cfgpack_ctx_t ctx;
+    cfgpack_parse_error_t perr;
+    cfgpack_schema_measure_t m;
+    cfgpack_schema_sizing_t sz;
+    static union {
+        uint64_t align;
+        uint8_t bytes[4096];
+    } out;
+    size_t len = 0;
+
+    CHECK(build(&ctx, &schema, NULL, 0, &plan, &a) == CFGPACK_OK);
+    LOG(".map blob_max = %zu", plan.blob_max);
+    CHECK(plan.blob_max > 0);
+
+    CHECK(cfgpack_schema_get_sizing(&schema, &sz) == CFGPACK_OK);
+    CHECK(sz.blob_max == plan.blob_max);
+
+    CHECK(cfgpack_schema_write_json(&ctx, (char *)out.bytes, sizeof(out.bytes),
+                                    &len, &perr) == CFGPACK_OK);
+    CHECK(cfgpack_schema_measure_json((const char *)out.bytes, len, &m,
+                                      &perr) == CFGPACK_OK);
+    CHECK(m.blob_max == plan.blob_max);
+
+    CHECK(cfgpack_schema_write_msgpack(&ctx, out.bytes, sizeof(out.bytes),
+                                       &len, &perr) == CFGPACK_OK);
+    CHECK(cfgpack_schema_measure_msgpack(out.bytes, len, &m, &perr) ==
+          CFGPACK_OK);
+    CHECK(m.blob_max == plan.blob_max);
+
+    CHECK(cfgpack_schema_write_image(&ctx, out.bytes, sizeof(out.bytes), &len,
+                                     &perr) == CFGPACK_OK);
+    CHECK(cfgpack_schema_measure_image(out.bytes, len, &m, &perr) ==
+          CFGPACK_OK);
+    CHECK(m.blob_max == plan.blob_max);
+    return (TEST_OK);
+}
+
+int main(void) {
+    int overall = 0;
+
+    overall |= (test_case_result("plan_layout", test_plan_layout()) !=
+                TEST_OK);
+    overall |= (test_case_result("plan_carve", test_plan_carve()) != TEST_OK);
+    overall |= (test_case_result("plan_context", test_plan_context()) !=
+                TEST_OK);
+    overall |= (test_case_result("plan_blob_max_paths",
+                                 test_plan_blob_max_paths()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -23,6 +23,7 @@ static void make_schema(cfgpack_schema_t *schema,
         snprintf(entries[i].name, sizeof(entries[i].name), "e%zu", i);
         entries[i].type = CFGPACK_TYPE_U8;
         entries[i].has_default = 0;
+        entries[i].str_max = 0;
     }
 }
 
@@ -736,6 +737,7 @@ TEST_CASE(test_remap_basic) {
     snprintf(old_entries[0].name, sizeof(old_entries[0].name), "val");
     old_entries[0].type = CFGPACK_TYPE_U8;
     old_entries[0].has_default = 0;
+    old_entries[0].str_max = 0;
 
     LOG("Setting up new schema: 'val' at index 20 (u8)");
     new_schema.map_name[0] = '\0';
@@ -747,6 +749,7 @@ TEST_CASE(test_remap_basic) {
     snprintf(new_entries[0].name, sizeof(new_entries[0].name), "val");
     new_entries[0].type = CFGPACK_TYPE_U8;
     new_entries[0].has_default = 0;
+    new_entries[0].str_max = 0;
 
     LOG("Initializing both contexts");
     CHECK(cfgpack_init(&old_ctx, &old_schema, old_values, 1, old_str_pool,
@@ -805,6 +808,7 @@ TEST_CASE(test_remap_type_widening) {
     snprintf(old_entries[0].name, sizeof(old_entries[0].name), "val");
     old_entries[0].type = CFGPACK_TYPE_U8;
     old_entries[0].has_default = 0;
+    old_entries[0].str_max = 0;
 
     LOG("Setting up new schema: 'val' at index 1 (u16)");
     new_schema.map_name[0] = '\0';
@@ -816,6 +820,7 @@ TEST_CASE(test_remap_type_widening) {
     snprintf(new_entries[0].name, sizeof(new_entries[0].name), "val");
     new_entries[0].type = CFGPACK_TYPE_U16;
     new_entries[0].has_default = 0;
+    new_entries[0].str_max = 0;
 
     LOG("Initializing both contexts");
     CHECK(cfgpack_init(&old_ctx, &old_schema, old_values, 1, old_str_pool,
@@ -871,6 +876,7 @@ TEST_CASE(test_remap_type_narrowing_rejected) {
     snprintf(old_entries[0].name, sizeof(old_entries[0].name), "val");
     old_entries[0].type = CFGPACK_TYPE_U16;
     old_entries[0].has_default = 0;
+    old_entries[0].str_max = 0;
 
     LOG("Setting up new schema: 'val' at index 1 (u8)");
     new_schema.map_name[0] = '\0';
@@ -882,6 +888,7 @@ TEST_CASE(test_remap_type_narrowing_rejected) {
     snprintf(new_entries[0].name, sizeof(new_entries[0].name), "val");
     new_entries[0].type = CFGPACK_TYPE_U8;
     new_entries[0].has_default = 0;
+    new_entries[0].str_max = 0;
 
     LOG("Initializing both contexts");
     CHECK(cfgpack_init(&old_ctx, &old_schema, old_values, 1, old_str_pool,
@@ -1143,6 +1150,369 @@ TEST_CASE(test_init_str_pool_too_small) {
     return (TEST_OK);
 }
 
+/* ─── Merge-join decode order tests ─────────────────────────────────────── */
+
+/* Encode {key: key + 100} for each key in order, plus the CRC trailer. */
+static size_t encode_keys(uint8_t *out,
+                          size_t cap,
+                          const uint32_t *keys,
+                          size_t n) {
+    cfgpack_buf_t buf;
+    size_t len;
+
+    cfgpack_buf_init(&buf, out, cap);
+    cfgpack_msgpack_encode_map_header(&buf, (uint32_t)n);
+    for (size_t i = 0; i < n; ++i) {
+        cfgpack_msgpack_encode_uint_key(&buf, keys[i]);
+        cfgpack_msgpack_encode_uint64(&buf, (keys[i] + 100) & 0x7F);
+    }
+    len = buf.len;
+    test_append_crc(out, &len);
+    return (len);
+}
+
+TEST_CASE(test_pagein_key_order) {
+    LOG_SECTION("Sorted, reversed and shuffled keys decode alike");
+
+    static const uint32_t sorted[] = {1, 2, 3, 5, 8, 13, 21, 34};
+    static const uint32_t reversed[] = {34, 21, 13, 8, 5, 3, 2, 1};
+    static const uint32_t shuffled[] = {8, 1, 34, 3, 77, 2, 21, 13, 5};
+    const uint32_t *orders[] = {sorted, reversed, shuffled};
+    const size_t counts[] = {8, 8, 9};
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[34];
+    cfgpack_value_t values[34];
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    uint8_t blob[128];
+
+    make_schema(&schema, entries, 34);
+    for (size_t o = 0; o < 3; ++o) {
+        size_t len = encode_keys(blob, sizeof(blob), orders[o], counts[o]);
+        CHECK(cfgpack_init(&ctx, &schema, values, 34, NULL, 0, NULL, 0) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_pagein_buf(&ctx, blob, len) == CFGPACK_OK);
+        CHECK(cfgpack_get_size(&ctx) == 8);
+        for (size_t i = 0; i < 8; ++i) {
+            CHECK(cfgpack_get(&ctx, (uint16_t)sorted[i], &v) == CFGPACK_OK);
+            CHECK(v.v.u64 == ((sorted[i] + 100) & 0x7F));
+        }
+        LOG("Order %zu: 8 entries decoded", o);
+    }
+
+    LOG_SECTION("Keys above the index range are skipped, not truncated");
+    {
+        static const uint32_t wide[] = {65536 + 5, 7};
+        size_t len = encode_keys(blob, sizeof(blob), wide, 2);
+        CHECK(cfgpack_init(&ctx, &schema, values, 34, NULL, 0, NULL, 0) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_pagein_buf(&ctx, blob, len) == CFGPACK_OK);
+        CHECK(cfgpack_get(&ctx, 5, &v) == CFGPACK_ERR_MISSING);
+        CHECK(cfgpack_get(&ctx, 7, &v) == CFGPACK_OK);
+    }
+
+    return (TEST_OK);
+}
+
+TEST_CASE(test_remap_table_order) {
+    LOG_SECTION("Sorted and unsorted remap tables give the same result");
+
+    static const uint32_t keys[] = {1, 2, 3, 4, 5, 6};
+    static const uint32_t back[] = {6, 4, 2, 1};
+    const cfgpack_remap_entry_t sorted[] = {{2, 12}, {4, 14}, {6, 16}};
+    const cfgpack_remap_entry_t unsorted[] = {{6, 16}, {2, 12}, {4, 14}};
+    const cfgpack_remap_entry_t *tables[] = {sorted, unsorted};
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[16];
+    cfgpack_value_t values[16];
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    uint8_t blob[64];
+    size_t len;
+
+    make_schema(&schema, entries, 16);
+    len = encode_keys(blob, sizeof(blob), keys, 6);
+    for (size_t t = 0; t < 2; ++t) {
+        CHECK(cfgpack_init(&ctx, &schema, values, 16, NULL, 0, NULL, 0) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_pagein_remap(&ctx, blob, len, tables[t], 3) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_OK && v.v.u64 == 101);
+        CHECK(cfgpack_get(&ctx, 2, &v) == CFGPACK_ERR_MISSING);
+        CHECK(cfgpack_get(&ctx, 12, &v) == CFGPACK_OK && v.v.u64 == 102);
+        CHECK(cfgpack_get(&ctx, 14, &v) == CFGPACK_OK && v.v.u64 == 104);
+        CHECK(cfgpack_get(&ctx, 16, &v) == CFGPACK_OK && v.v.u64 == 106);
+        CHECK(cfgpack_get(&ctx, 5, &v) == CFGPACK_OK && v.v.u64 == 105);
+    }
+
+    LOG_SECTION("Descending keys with a sorted table");
+    len = encode_keys(blob, sizeof(blob), back, 4);
+    CHECK(cfgpack_init(&ctx, &schema, values, 16, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pagein_remap(&ctx, blob, len, sorted, 3) == CFGPACK_OK);
+    CHECK(cfgpack_get_size(&ctx) == 4);
+    CHECK(cfgpack_get(&ctx, 16, &v) == CFGPACK_OK && v.v.u64 == 106);
+    CHECK(cfgpack_get(&ctx, 14, &v) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 12, &v) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_OK);
+
+    return (TEST_OK);
+}
+
+TEST_CASE(test_remap_compile) {
+    LOG_SECTION("Two tables compose into one sorted table");
+
+    static const uint32_t keys[] = {1, 2, 3, 4, 5, 6};
+    const cfgpack_remap_entry_t v1_v2[] = {{3, 13}, {2, 12}};
+    const cfgpack_remap_entry_t v2_v3[] = {{13, 3}, {4, 14}, {12, 7}};
+    const cfgpack_remap_entry_t *chain[] = {v1_v2, NULL, v2_v3};
+    const size_t counts[] = {2, 0, 3};
+    const size_t bad_counts[] = {2, 1, 3};
+    const cfgpack_remap_entry_t dup[] = {{2, 12}, {2, 13}};
+    const cfgpack_remap_entry_t *dup_chain[] = {dup};
+    const size_t dup_count = 2;
+    cfgpack_remap_entry_t out[5];
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[16];
+    cfgpack_value_t values[16];
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    uint8_t blob[64];
+    size_t n = 99;
+    size_t len;
+
+    CHECK(cfgpack_remap_compile(chain, counts, 3, out, 5, &n) == CFGPACK_OK);
+    LOG("Compiled entries: %zu", n);
+    CHECK(n == 4); /* 3->13->3 is identity and dropped */
+    CHECK(out[0].old_index == 2 && out[0].new_index == 7);
+    CHECK(out[1].old_index == 4 && out[1].new_index == 14);
+    CHECK(out[2].old_index == 12 && out[2].new_index == 7);
+    CHECK(out[3].old_index == 13 && out[3].new_index == 3);
+
+    LOG_SECTION("Single pagein with the compiled table");
+    make_schema(&schema, entries, 16);
+    len = encode_keys(blob, sizeof(blob), keys, 6);
+    CHECK(cfgpack_init(&ctx, &schema, values, 16, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pagein_remap(&ctx, blob, len, out, n) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 7, &v) == CFGPACK_OK && v.v.u64 == 102);
+    CHECK(cfgpack_get(&ctx, 3, &v) == CFGPACK_OK && v.v.u64 == 103);
+    CHECK(cfgpack_get(&ctx, 14, &v) == CFGPACK_OK && v.v.u64 == 104);
+    CHECK(cfgpack_get(&ctx, 2, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get(&ctx, 4, &v) == CFGPACK_ERR_MISSING);
+
+    LOG_SECTION("Errors");
+    CHECK(cfgpack_remap_compile(chain, counts, 3, out, 4, &n) ==
+          CFGPACK_ERR_BOUNDS); /* identity is only dropped at the end */
+    CHECK(cfgpack_remap_compile(dup_chain, &dup_count, 1, out, 5, &n) ==
+          CFGPACK_ERR_DUPLICATE);
+    CHECK(cfgpack_remap_compile(chain, NULL, 3, out, 5, &n) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_remap_compile(chain, bad_counts, 3, out, 5, &n) ==
+          CFGPACK_ERR_ARGS); /* NULL table with entries */
+    CHECK(cfgpack_remap_compile(chain, counts, 3, out, 5, NULL) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_remap_compile(chain, counts, 0, NULL, 0, &n) == CFGPACK_OK);
+    CHECK(n == 0);
+
+    return (TEST_OK);
+}
+
+TEST_CASE(test_peek_header) {
+    LOG_SECTION("Schema header: fingerprint and version without a walk");
+
+    const cfgpack_remap_entry_t remap[] = {{1, 2}};
+    cfgpack_schema_t schema;
+    cfgpack_schema_t other;
+    cfgpack_entry_t entries[16];
+    cfgpack_entry_t other_entries[16];
+    cfgpack_value_t values[16];
+    cfgpack_value_t v;
+    cfgpack_ctx_t ctx;
+    uint8_t plain[96];
+    uint8_t blob[96];
+    uint8_t target[96];
+    uint8_t patch[64];
+    size_t plain_len = 0;
+    size_t len = 0;
+    size_t target_len = 0;
+    size_t patch_len = 0;
+    size_t measured = 0;
+    uint64_t fp = 0;
+    uint32_t version = 0;
+    char name[16];
+
+    make_schema(&schema, entries, 16);
+    schema.version = 7;
+    CHECK(cfgpack_init(&ctx, &schema, values, 16, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&ctx, 1, 11) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&ctx, 9, 99) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, plain, sizeof(plain), &plain_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_peek_header(plain, plain_len, &fp, &version) ==
+          CFGPACK_ERR_MISSING);
+
+    CHECK(cfgpack_header_enable(&ctx, 1) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_measure(&ctx, &measured) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    LOG("Blob %zu bytes, %zu without the header", len, plain_len);
+    CHECK(len == plain_len + CFGPACK_HEADER_SIZE && measured == len);
+#ifdef CFGPACK_SIZE_CACHE
+    CHECK(cfgpack_size_cache_init(&ctx) == CFGPACK_OK);
+#endif
+    CHECK(cfgpack_pageout_measure(&ctx, &measured) == CFGPACK_OK);
+    CHECK(measured == len);
+    CHECK(cfgpack_peek_header(blob, len, &fp, &version) == CFGPACK_OK);
+    CHECK(fp == cfgpack_schema_fingerprint(&schema) && version == 7);
+    CHECK(cfgpack_peek_header(blob, len, &fp, NULL) == CFGPACK_OK);
+    CHECK(cfgpack_peek_name(blob, len, name, sizeof(name)) == CFGPACK_OK);
+    CHECK(strcmp(name, "test") == 0);
+#ifdef CFGPACK_PACKED_WIRE
+    CHECK(cfgpack_pageout_packed(&ctx, target, sizeof(target),
+                                 &target_len) == CFGPACK_OK);
+    version = 0;
+    CHECK(cfgpack_peek_header(target, target_len, &fp, &version) ==
+          CFGPACK_OK);
+    CHECK(fp == cfgpack_schema_fingerprint(&schema) && version == 7);
+#endif
+
+    LOG_SECTION("Matching fingerprint drops the remap table");
+    CHECK(cfgpack_init(&ctx, &schema, values, 16, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pagein_remap(&ctx, blob, len, remap, 1) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_OK && v.v.u64 == 11);
+    CHECK(cfgpack_get(&ctx, 2, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_size(&ctx) == 2);
+
+    LOG_SECTION("Another layout still remaps");
+    make_schema(&other, other_entries, 16);
+    other_entries[15].type = CFGPACK_TYPE_U16;
+    CHECK(cfgpack_schema_fingerprint(&other) !=
+          cfgpack_schema_fingerprint(&schema));
+    CHECK(cfgpack_init(&ctx, &other, values, 16, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pagein_remap(&ctx, blob, len, remap, 1) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 2, &v) == CFGPACK_OK && v.v.u64 == 11);
+    CHECK(cfgpack_get(&ctx, 1, &v) == CFGPACK_ERR_MISSING);
+
+    LOG_SECTION("Deltas and patches carry the header");
+    CHECK(cfgpack_init(&ctx, &schema, values, 16, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_header_enable(&ctx, 1) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, len) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&ctx, 4, 44) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_delta(&ctx, target, sizeof(target),
+                                &target_len) == CFGPACK_OK);
+    CHECK(cfgpack_peek_header(target, target_len, &fp, NULL) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&ctx, 4, 44) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, target, sizeof(target), &target_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_blob_diff(blob, len, target, target_len, patch,
+                            sizeof(patch), &patch_len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, len) == CFGPACK_OK);
+    CHECK(cfgpack_patch_apply(&ctx, patch, patch_len) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 4, &v) == CFGPACK_OK && v.v.u64 == 44);
+
+    LOG_SECTION("Errors");
+    CHECK(cfgpack_peek_header(NULL, len, &fp, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_peek_header(blob, len, NULL, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_peek_header(blob, 4, &fp, NULL) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_peek_header(blob, 16, &fp, NULL) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_header_enable(NULL, 1) == CFGPACK_ERR_ARGS);
+
+    return (TEST_OK);
+}
+
+typedef struct {
+    size_t offs[8];
+    size_t n;
+    size_t stop_at;
+} scan_log_t;
+
+static cfgpack_err_t log_present(const cfgpack_ctx_t *ctx,
+                                 size_t off,
+                                 void *user) {
+    scan_log_t *log = user;
+
+    (void)ctx;
+    if (log->n == log->stop_at) {
+        return (CFGPACK_ERR_IO);
+    }
+    if (log->n < 8) {
+        log->offs[log->n] = off;
+    }
+    log->n++;
+    return (CFGPACK_OK);
+}
+
+TEST_CASE(test_present_scan) {
+    LOG_SECTION("Word-wide scans of a sparse presence bitmap");
+
+    static const size_t want[] = {0, 7, 63, 64, 99};
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[100];
+    cfgpack_value_t values[100];
+    cfgpack_present_iter_t it;
+    cfgpack_ctx_t ctx;
+    scan_log_t log = {{0}, 0, SIZE_MAX};
+    size_t off = 0;
+    size_t n = 0;
+
+    make_schema(&schema, entries, 100);
+    CHECK(cfgpack_init(&ctx, &schema, values, 100, NULL, 0, NULL, 0) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_get_size(&ctx) == 0);
+    cfgpack_present_iter_init(&it, &ctx, 0);
+    CHECK(cfgpack_present_next(&it, &off) == 0);
+
+    for (size_t i = 0; i < 5; ++i) {
+        CHECK(cfgpack_set_u8(&ctx, (uint16_t)(want[i] + 1), 1) ==
+              CFGPACK_OK);
+    }
+    /* Bits past entry_count in the inline bitmap must not be counted */
+    cfgpack_presence_set(&ctx, 100);
+    cfgpack_presence_set(&ctx, 127);
+    CHECK(cfgpack_get_size(&ctx) == 5);
+
+    cfgpack_present_iter_init(&it, &ctx, 0);
+    while (cfgpack_present_next(&it, &off)) {
+        CHECK(n < 5 && off == want[n]);
+        n++;
+    }
+    CHECK(n == 5);
+    CHECK(cfgpack_foreach_present(&ctx, log_present, &log) == CFGPACK_OK);
+    CHECK(log.n == 5 && log.offs[2] == 63 && log.offs[4] == 99);
+
+    LOG_SECTION("Dirty-only scan and counts");
+    cfgpack_dirty_clear_all(&ctx);
+    CHECK(cfgpack_set_u8(&ctx, 65, 2) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&ctx, 50, 2) == CFGPACK_OK);
+    cfgpack_dirty_set(&ctx, 33); /* dirty but absent */
+    CHECK(cfgpack_get_size(&ctx) == 6);
+    CHECK(cfgpack_get_dirty_count(&ctx) == 2);
+    n = 0;
+    cfgpack_present_iter_init(&it, &ctx, 1);
+    while (cfgpack_present_next(&it, &off)) {
+        CHECK(off == (n == 0 ? 49u : 64u));
+        n++;
+    }
+    CHECK(n == 2);
+
+    LOG_SECTION("Callback result stops the scan");
+    log.n = 0;
+    log.stop_at = 3;
+    CHECK(cfgpack_foreach_present(&ctx, log_present, &log) ==
+          CFGPACK_ERR_IO);
+    CHECK(log.n == 3);
+    CHECK(cfgpack_foreach_present(NULL, log_present, &log) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_foreach_present(&ctx, NULL, &log) == CFGPACK_ERR_ARGS);
+
+    return (TEST_OK);
+}
+
 int main(void) {
     test_result_t overall = TEST_OK;
 
@@ -1200,6 +1570,16 @@ int main(void) {
                                  test_schema_get_sizing()) != TEST_OK);
     overall |= (test_case_result("init_str_pool_too_small",
                                  test_init_str_pool_too_small()) != TEST_OK);
+    overall |= (test_case_result("pagein_key_order",
+                                 test_pagein_key_order()) != TEST_OK);
+    overall |= (test_case_result("remap_table_order",
+                                 test_remap_table_order()) != TEST_OK);
+    overall |= (test_case_result("remap_compile", test_remap_compile()) !=
+                TEST_OK);
+    overall |= (test_case_result("peek_header", test_peek_header()) !=
+                TEST_OK);
+    overall |= (test_case_result("present_scan", test_present_scan()) !=
+                TEST_OK);
 
     if (overall == TEST_OK) {
         printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
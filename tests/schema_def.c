@@ -0,0 +1,211 @@
+/* Compile-time schema definitions (schema_def.h) against the same schemas
+ * parsed at runtime. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Schemas: each list mirrors the .map text below it
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define NODE_SCHEMA(V, N, S)         \
+    V(1, rate, U16, 100)             \
+    S(2, host, STR, 32, "gateway")   \
+    N(3, gain, F32, 0)               \
+    V(5, trim, I8, -4)               \
+    S(9, tag, FSTR, 8, "n1")         \
+    N(12, note, STR, 0)              \
+    V(40, span, F64, 2.5)            \
+    V(300, uid, U64, UINT64_C(1) << 40)
+
+#define CFGPACK_SCHEMA_LIST    NODE_SCHEMA
+#define CFGPACK_SCHEMA_PREFIX  node
+#define CFGPACK_SCHEMA_UPPER   NODE
+#define CFGPACK_SCHEMA_NAME    "node"
+#define CFGPACK_SCHEMA_VERSION 3
+#include "cfgpack/schema_def.h"
+
+static const char node_map[] = "node 3\n"
+                               "1 rate u16 100\n"
+                               "2 host str:32 \"gateway\"\n"
+                               "3 gain f32 NIL\n"
+                               "5 trim i8 -4\n"
+                               "9 tag fstr:8 \"n1\"\n"
+                               "12 note str NIL\n"
+                               "40 span f64 2.5\n"
+                               "300 uid u64 1099511627776\n";
+
+/* A second schema in the same translation unit */
+#define TINY_SCHEMA(V, N, S) \
+    V(1, on, U8, 1)          \
+    N(2, name, FSTR, 0)
+
+#define CFGPACK_SCHEMA_LIST    TINY_SCHEMA
+#define CFGPACK_SCHEMA_PREFIX  tiny
+#define CFGPACK_SCHEMA_UPPER   TINY
+#define CFGPACK_SCHEMA_NAME    "tiny"
+#define CFGPACK_SCHEMA_VERSION 1
+#include "cfgpack/schema_def.h"
+
+static const char tiny_map[] = "tiny 1\n"
+                               "1 on u8 1\n"
+                               "2 name fstr NIL\n";
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define MAX_ENTRIES 8
+#define MAX_STR     4
+
+typedef struct {
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[MAX_ENTRIES];
+    cfgpack_value_t values[MAX_ENTRIES];
+    char str_pool[MAX_STR * (CFGPACK_STR_MAX + 1)];
+    cfgpack_str_off_t str_offsets[MAX_STR];
+    cfgpack_ctx_t ctx;
+} parsed_t;
+
+static cfgpack_err_t parse_fixture(parsed_t *p, const char *map, size_t len) {
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts = {&p->schema,     p->entries,
+                                 MAX_ENTRIES,    p->values,
+                                 p->str_pool,    sizeof(p->str_pool),
+                                 p->str_offsets, MAX_STR,
+                                 &perr};
+    cfgpack_err_t rc;
+
+    memset(p, 0, sizeof(*p));
+    rc = cfgpack_parse_schema(map, len, &opts);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (cfgpack_init(&p->ctx, &p->schema, p->values,
+                         p->schema.entry_count, p->str_pool,
+                         sizeof(p->str_pool), p->str_offsets, MAX_STR));
+}
+
+static int entries_equal(const cfgpack_entry_t *a,
+                         const cfgpack_entry_t *b,
+                         size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (a[i].index != b[i].index || strcmp(a[i].name, b[i].name) != 0 ||
+            a[i].type != b[i].type || a[i].has_default != b[i].has_default ||
+            a[i].str_slot != b[i].str_slot || a[i].str_max != b[i].str_max) {
+            LOG("entry %zu differs", i);
+            return (0);
+        }
+    }
+    return (1);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Compile-time tables match the parsed schema
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_tables_match_parser) {
+    static parsed_t p;
+    cfgpack_schema_measure_t m;
+    cfgpack_parse_error_t perr;
+
+    CHECK(parse_fixture(&p, node_map, sizeof(node_map) - 1) == CFGPACK_OK);
+    CHECK(cfgpack_schema_measure(node_map, sizeof(node_map) - 1, &m, &perr) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Counts and sizes");
+    CHECK(NODE_ENTRY_COUNT == 8 && m.entry_count == NODE_ENTRY_COUNT);
+    CHECK(NODE_STR_COUNT == m.str_count + m.fstr_count);
+    CHECK(NODE_STR_POOL_SIZE == m.str_pool_size);
+    CHECK(NODE_IDX_uid == 300 && NODE_POS_uid == 7);
+    CHECK(NODE_POOL_host == 0 && NODE_POOL_tag == 33 && NODE_POOL_note == 42);
+
+    LOG_SECTION("Entries, including string slots");
+    CHECK(entries_equal(node_entries, p.entries, NODE_ENTRY_COUNT));
+    CHECK(node_entries[NODE_POS_gain].str_slot == CFGPACK_STR_SLOT_NONE);
+    CHECK(node_entries[NODE_POS_note].str_slot == 2);
+
+    LOG_SECTION("Defaults, including pool offsets");
+    CHECK(memcmp(node_defaults, p.values, sizeof(node_defaults)) == 0);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. <prefix>_init() gives the same context as parse + init
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_init_matches_parser) {
+    static parsed_t p;
+    static parsed_t q;
+    static cfgpack_ctx_t ctx;
+    static cfgpack_ctx_t tctx;
+    static cfgpack_schema_t schema;
+    static cfgpack_schema_t tschema;
+    static cfgpack_value_t values[NODE_ENTRY_COUNT];
+    static char str_pool[NODE_STR_POOL_SIZE];
+    static cfgpack_str_off_t str_offsets[NODE_STR_COUNT];
+    static cfgpack_value_t tvalues[TINY_ENTRY_COUNT];
+    static char tpool[TINY_STR_POOL_SIZE];
+    static cfgpack_str_off_t toffsets[TINY_STR_COUNT];
+    uint8_t a[160];
+    uint8_t b[160];
+    size_t a_len = 0;
+    size_t b_len = 0;
+    const char *s = NULL;
+    uint16_t s_len = 0;
+    uint8_t u8 = 0;
+
+    CHECK(parse_fixture(&p, node_map, sizeof(node_map) - 1) == CFGPACK_OK);
+    CHECK(node_init(&ctx, &schema, values, str_pool, str_offsets) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Entry table is used in place");
+    CHECK(schema.entries == node_entries);
+    CHECK(strcmp(schema.map_name, "node") == 0 && schema.version == 3);
+    CHECK(cfgpack_schema_hash(&schema) == cfgpack_schema_hash(&p.schema));
+
+    LOG_SECTION("Defaults page out identically");
+    CHECK(cfgpack_pageout(&ctx, a, sizeof(a), &a_len) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&p.ctx, b, sizeof(b), &b_len) == CFGPACK_OK);
+    CHECK(a_len == b_len && memcmp(a, b, a_len) == 0);
+    CHECK(cfgpack_get_str(&ctx, NODE_IDX_host, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 7 && memcmp(s, "gateway", 7) == 0);
+
+    LOG_SECTION("Writes and reloads through the generic API");
+    CHECK(cfgpack_set_str(&ctx, NODE_IDX_note, "hello") == CFGPACK_OK);
+    CHECK(cfgpack_set_fstr(&ctx, NODE_IDX_tag, "n2") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, a, sizeof(a), &a_len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&p.ctx, a, a_len) == CFGPACK_OK);
+    CHECK(cfgpack_get_str(&p.ctx, NODE_IDX_note, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 5 && memcmp(s, "hello", 5) == 0);
+
+    LOG_SECTION("Second schema in the same file");
+    CHECK(parse_fixture(&q, tiny_map, sizeof(tiny_map) - 1) == CFGPACK_OK);
+    CHECK(tiny_init(&tctx, &tschema, tvalues, tpool, toffsets) == CFGPACK_OK);
+    CHECK(TINY_STR_COUNT == 1 && TINY_STR_POOL_SIZE == CFGPACK_FSTR_MAX + 1);
+    CHECK(entries_equal(tiny_entries, q.entries, TINY_ENTRY_COUNT));
+    CHECK(cfgpack_get_u8(&tctx, TINY_IDX_on, &u8) == CFGPACK_OK && u8 == 1);
+    CHECK(cfgpack_get_fstr(&tctx, TINY_IDX_name, &s, &u8) ==
+          CFGPACK_ERR_MISSING);
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("tables_match_parser",
+                                 test_tables_match_parser()) != TEST_OK);
+    overall |= (test_case_result("init_matches_parser",
+                                 test_init_matches_parser()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
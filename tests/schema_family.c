@@ -0,0 +1,358 @@
+/* Schema family images: one image for several variant schemas that share
+ * most entries, each variant loaded by name as a parse would load it.
+ * Variants are .map texts built from one base with a few edits each.
+ */
+
+#include "cfgpack/cfgpack.h"
+
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_VARIANTS  5
+#define MAX_ENTRIES 40
+#define MAX_STR     8
+#define MAP_CAP     2048
+#define IMAGE_CAP   16384
+
+typedef struct {
+    char map[MAP_CAP];
+    size_t map_len;
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[MAX_ENTRIES];
+    cfgpack_value_t values[MAX_ENTRIES];
+    char str_pool[MAX_STR * (CFGPACK_STR_MAX + 1)];
+    cfgpack_str_off_t str_offsets[MAX_STR];
+    cfgpack_ctx_t ctx;
+} variant_t;
+
+static const char *const names[N_VARIANTS] = {"base", "fast", "lite", "eu",
+                                              "base2"};
+
+static union {
+    uint64_t align;
+    uint8_t bytes[IMAGE_CAP + 8];
+} image;
+
+/*
+ * Base: 30 entries, u16 at 1..30 with default 10*i, except a str "h<i>"
+ * at every 10th and an fstr "m" at 15.  Variant 1 changes default 5,
+ * variant 2 drops 10 and adds 40, variant 3 changes the str at 20 and
+ * variant 4 is the base again.
+ */
+static void write_map(variant_t *v, unsigned k) {
+    size_t n = 0;
+
+    n += (size_t)snprintf(v->map + n, MAP_CAP - n, "dev%u %u\n", k, 1 + k);
+    for (unsigned i = 1; i <= 30; ++i) {
+        if (k == 2 && i == 10) {
+            continue;
+        }
+        if (i == 15) {
+            n += (size_t)snprintf(v->map + n, MAP_CAP - n,
+                                  "%u e%u fstr \"m\"\n", i, i);
+        } else if (i % 10 == 0) {
+            n += (size_t)snprintf(v->map + n, MAP_CAP - n,
+                                  "%u e%u str \"%s%u\"\n", i, i,
+                                  (k == 3 && i == 20) ? "eu" : "h", i);
+        } else {
+            n += (size_t)snprintf(v->map + n, MAP_CAP - n, "%u e%u u16 %u\n",
+                                  i, i, (k == 1 && i == 5) ? 7u : 10u * i);
+        }
+    }
+    if (k == 2) {
+        n += (size_t)snprintf(v->map + n, MAP_CAP - n, "40 lite u8 1\n");
+    }
+    v->map_len = n;
+}
+
+static cfgpack_err_t parse_variant(variant_t *v, unsigned k) {
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts = {&v->schema,      v->entries,
+                                 MAX_ENTRIES,     v->values,
+                                 v->str_pool,     sizeof(v->str_pool),
+                                 v->str_offsets,  MAX_STR,
+                                 &perr};
+    cfgpack_err_t rc;
+
+    memset(v, 0, sizeof(*v));
+    write_map(v, k);
+    rc = cfgpack_parse_schema(v->map, v->map_len, &opts);
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (cfgpack_init(&v->ctx, &v->schema, v->values, v->schema.entry_count,
+                         v->str_pool, sizeof(v->str_pool), v->str_offsets,
+                         MAX_STR));
+}
+
+static variant_t variants[N_VARIANTS];
+static size_t image_len;
+
+static cfgpack_err_t build_family(void) {
+    const cfgpack_ctx_t *ctxs[N_VARIANTS];
+    cfgpack_err_t rc;
+
+    for (unsigned k = 0; k < N_VARIANTS; ++k) {
+        rc = parse_variant(&variants[k], k);
+        if (rc != CFGPACK_OK) {
+            return (rc);
+        }
+        ctxs[k] = &variants[k].ctx;
+    }
+    return (cfgpack_schema_write_family(ctxs, names, N_VARIANTS, image.bytes,
+                                        IMAGE_CAP, &image_len, NULL));
+}
+
+/* Buffers for loading one variant out of the image. */
+typedef struct {
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[MAX_ENTRIES];
+    cfgpack_value_t values[MAX_ENTRIES];
+    char str_pool[MAX_STR * (CFGPACK_STR_MAX + 1)];
+    cfgpack_str_off_t str_offsets[MAX_STR];
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts;
+    cfgpack_ctx_t ctx;
+} loaded_t;
+
+static void make_loaded(loaded_t *l) {
+    memset(l, 0, sizeof(*l));
+    l->opts.out_schema = &l->schema;
+    l->opts.entries = l->entries;
+    l->opts.max_entries = MAX_ENTRIES;
+    l->opts.values = l->values;
+    l->opts.str_pool = l->str_pool;
+    l->opts.str_pool_cap = sizeof(l->str_pool);
+    l->opts.str_offsets = l->str_offsets;
+    l->opts.str_offsets_count = MAX_STR;
+    l->opts.err = &l->perr;
+}
+
+/* Helper: rewrite the CRC trailer after deliberately editing the image. */
+static void fix_crc(uint8_t *img, size_t len) {
+    size_t n = len - 4;
+
+    test_append_crc(img, &n);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Every variant loads as its own parse does
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_family_roundtrip) {
+    static loaded_t l;
+    static uint8_t img[4096];
+    static uint8_t want[1024];
+    static uint8_t got[1024];
+    size_t images = 0;
+
+    CHECK(build_family() == CFGPACK_OK);
+
+    LOG_SECTION("The family is far smaller than one image per variant");
+    for (unsigned k = 0; k < N_VARIANTS; ++k) {
+        size_t len = 0;
+
+        CHECK(cfgpack_schema_write_image(&variants[k].ctx, img, sizeof(img),
+                                         &len, NULL) == CFGPACK_OK);
+        images += len;
+    }
+    LOG("family %zu bytes, separate images %zu bytes", image_len, images);
+    CHECK(image_len * 2 < images);
+
+    LOG_SECTION("Measure, attach and page out match the parsed variant");
+    for (unsigned k = 0; k < N_VARIANTS; ++k) {
+        const variant_t *v = &variants[k];
+        cfgpack_schema_measure_t want_m;
+        cfgpack_schema_measure_t m;
+        size_t want_len = 0;
+        size_t got_len = 0;
+
+        CHECK(cfgpack_schema_measure(v->map, v->map_len, &want_m, NULL) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_schema_measure_family(image.bytes, image_len, names[k],
+                                            &m, NULL) == CFGPACK_OK);
+        CHECK(m.entry_count == want_m.entry_count);
+        CHECK(m.str_count == want_m.str_count);
+        CHECK(m.fstr_count == want_m.fstr_count);
+        CHECK(m.str_pool_size == want_m.str_pool_size);
+        CHECK(m.index_table_size == want_m.index_table_size);
+        CHECK(m.blob_max == want_m.blob_max);
+
+        make_loaded(&l);
+        CHECK(cfgpack_schema_attach_family(image.bytes, image_len, names[k],
+                                           &l.opts) == CFGPACK_OK);
+        CHECK(strcmp(l.schema.map_name, v->schema.map_name) == 0);
+        CHECK(l.schema.version == v->schema.version);
+        CHECK(l.schema.entry_count == v->schema.entry_count);
+        for (size_t i = 0; i < l.schema.entry_count; ++i) {
+            CHECK(l.entries[i].index == v->entries[i].index);
+            CHECK(l.entries[i].type == v->entries[i].type);
+            CHECK(l.entries[i].str_slot == v->entries[i].str_slot);
+            CHECK(strcmp(l.entries[i].name, v->entries[i].name) == 0);
+        }
+        CHECK(cfgpack_init(&l.ctx, &l.schema, l.values, l.schema.entry_count,
+                           l.str_pool, sizeof(l.str_pool), l.str_offsets,
+                           MAX_STR) == CFGPACK_OK);
+        CHECK(cfgpack_pageout(&variants[k].ctx, want, sizeof(want),
+                              &want_len) == CFGPACK_OK);
+        CHECK(cfgpack_pageout(&l.ctx, got, sizeof(got), &got_len) ==
+              CFGPACK_OK);
+        CHECK(got_len == want_len);
+        CHECK(memcmp(got, want, want_len) == 0);
+        LOG("%s: %zu entries, blob %zu bytes", names[k], l.schema.entry_count,
+            got_len);
+    }
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Unknown variants, damaged images and small buffers
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_family_rejects) {
+    static loaded_t l;
+    cfgpack_schema_measure_t m;
+
+    CHECK(build_family() == CFGPACK_OK);
+    make_loaded(&l);
+
+    LOG_SECTION("Unknown variant and argument errors");
+    CHECK(cfgpack_schema_attach_family(image.bytes, image_len, "nope",
+                                       &l.opts) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_schema_attach_family(NULL, image_len, "eu", &l.opts) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_schema_attach_family(image.bytes, image_len, NULL,
+                                       &l.opts) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_schema_measure_family(image.bytes, image_len, "eu", NULL,
+                                        NULL) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("Misaligned, truncated, corrupt and foreign images");
+    memmove(image.bytes + 1, image.bytes, image_len);
+    CHECK(cfgpack_schema_measure_family(image.bytes + 1, image_len, "eu", &m,
+                                        NULL) == CFGPACK_ERR_ARGS);
+    memmove(image.bytes, image.bytes + 1, image_len);
+    CHECK(cfgpack_schema_measure_family(image.bytes, image_len - 1, "eu", &m,
+                                        NULL) == CFGPACK_ERR_DECODE);
+    image.bytes[image_len / 2] ^= 0x10;
+    CHECK(cfgpack_schema_measure_family(image.bytes, image_len, "eu", &m,
+                                        NULL) == CFGPACK_ERR_CRC);
+    image.bytes[image_len / 2] ^= 0x10;
+    image.bytes[0] ^= 0xff;
+    fix_crc(image.bytes, image_len);
+    CHECK(cfgpack_schema_measure_family(image.bytes, image_len, "eu", &m,
+                                        NULL) == CFGPACK_ERR_DECODE);
+    image.bytes[0] ^= 0xff;
+    fix_crc(image.bytes, image_len);
+    CHECK(cfgpack_schema_measure_family(image.bytes, image_len, "eu", &m,
+                                        NULL) == CFGPACK_OK);
+
+    LOG_SECTION("A plain schema image is not a family image");
+    {
+        static uint8_t img[4096];
+        size_t len = 0;
+
+        CHECK(cfgpack_schema_write_image(&variants[0].ctx, img, sizeof(img),
+                                         &len, NULL) == CFGPACK_OK);
+        memcpy(image.bytes, img, len);
+        CHECK(cfgpack_schema_measure_family(image.bytes, len, "base", &m,
+                                            NULL) == CFGPACK_ERR_DECODE);
+        CHECK(build_family() == CFGPACK_OK);
+    }
+
+    LOG_SECTION("Buffers smaller than the variant");
+    l.opts.max_entries = 20;
+    CHECK(cfgpack_schema_attach_family(image.bytes, image_len, "lite",
+                                       &l.opts) == CFGPACK_ERR_BOUNDS);
+    make_loaded(&l);
+    l.opts.str_pool_cap = 40;
+    CHECK(cfgpack_schema_attach_family(image.bytes, image_len, "lite",
+                                       &l.opts) == CFGPACK_ERR_BOUNDS);
+    make_loaded(&l);
+    l.opts.str_offsets_count = 2;
+    CHECK(cfgpack_schema_attach_family(image.bytes, image_len, "lite",
+                                       &l.opts) == CFGPACK_ERR_BOUNDS);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Writer arguments, sizing and a one-variant family
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_family_write) {
+    static loaded_t l;
+    const cfgpack_ctx_t *ctxs[2];
+    const char *dup[2] = {"same", "same"};
+    const char *one[1] = {"only"};
+    const char *long_name[1] = {"a-variant-name-of-thirty-two-chars"};
+    size_t len = 0;
+
+    CHECK(build_family() == CFGPACK_OK);
+    ctxs[0] = &variants[0].ctx;
+    ctxs[1] = &variants[1].ctx;
+
+    LOG_SECTION("Argument errors");
+    CHECK(cfgpack_schema_write_family(NULL, names, 2, image.bytes, IMAGE_CAP,
+                                      &len, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_schema_write_family(ctxs, names, 0, image.bytes, IMAGE_CAP,
+                                      &len, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_schema_write_family(ctxs, names,
+                                      CFGPACK_SCHEMA_FAMILY_MAX + 1,
+                                      image.bytes, IMAGE_CAP, &len,
+                                      NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_schema_write_family(ctxs, dup, 2, image.bytes, IMAGE_CAP,
+                                      &len, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_schema_write_family(ctxs, long_name, 1, image.bytes,
+                                      IMAGE_CAP, &len,
+                                      NULL) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("A small buffer reports the size needed");
+    CHECK(cfgpack_schema_write_family(ctxs, names, 2, image.bytes, 64, &len,
+                                      NULL) == CFGPACK_ERR_ENCODE);
+    CHECK(len > 64);
+    {
+        size_t need = len;
+
+        CHECK(cfgpack_schema_write_family(ctxs, names, 2, image.bytes, need,
+                                          &len, NULL) == CFGPACK_OK);
+        CHECK(len == need);
+    }
+
+    LOG_SECTION("One variant: everything is shared");
+    CHECK(cfgpack_schema_write_family(ctxs, one, 1, image.bytes, IMAGE_CAP,
+                                      &len, NULL) == CFGPACK_OK);
+    make_loaded(&l);
+    CHECK(cfgpack_schema_attach_family(image.bytes, len, "only", &l.opts) ==
+          CFGPACK_OK);
+    CHECK(l.schema.entry_count == variants[0].schema.entry_count);
+    CHECK(cfgpack_schema_attach_family(image.bytes, len, "base", &l.opts) ==
+          CFGPACK_ERR_MISSING);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    overall |= (test_case_result("family_roundtrip",
+                                 test_family_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("family_rejects", test_family_rejects()) !=
+                TEST_OK);
+    overall |= (test_case_result("family_write", test_family_write()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
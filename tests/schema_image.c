@@ -0,0 +1,381 @@
+/* Precompiled schema images: write, measure, attach, XIP use and rejection of
+ * damaged or foreign images, plus the schema hash used by generated headers.
+ * Images are generated from a JSON schema with cfgpack_schema_write_image(),
+ * as cfgpack-schema-pack --image does.
+ */
+
+#include "cfgpack/cfgpack.h"
+
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *json = "{"
+                          "  \"name\": \"imgtest\","
+                          "  \"version\": 7,"
+                          "  \"entries\": ["
+                          "    {\"index\": 9, \"name\": \"rate\", "
+                          "\"type\": \"u32\", \"value\": 5000},"
+                          "    {\"index\": 2, \"name\": \"host\", "
+                          "\"type\": \"str\", \"value\": \"example.com\"},"
+                          "    {\"index\": 4, \"name\": \"mode\", "
+                          "\"type\": \"fstr\", \"value\": \"fast\"},"
+                          "    {\"index\": 3, \"name\": \"gain\", "
+                          "\"type\": \"f32\", \"value\": 1.5},"
+                          "    {\"index\": 7, \"name\": \"apik\", "
+                          "\"type\": \"str\", \"value\": null},"
+                          "    {\"index\": 5, \"name\": \"ofs\", "
+                          "\"type\": \"i8\", \"value\": -3}"
+                          "  ]"
+                          "}";
+
+/* Image storage, aligned as the image must be in flash */
+static union {
+    uint64_t align;
+    uint8_t bytes[2048];
+} image;
+static size_t image_len;
+
+/* Helper: parse the JSON schema, init a context, write the image. */
+static cfgpack_err_t build_image(void) {
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[16];
+    cfgpack_value_t values[16];
+    char str_pool[256];
+    uint16_t str_offsets[8];
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts = {&schema,     entries,  16,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 8,        &perr};
+    cfgpack_ctx_t ctx;
+    cfgpack_err_t rc;
+
+    rc = cfgpack_schema_parse_json(json, strlen(json), &opts);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    rc = cfgpack_init(&ctx, &schema, values, 16, str_pool, sizeof(str_pool),
+                      str_offsets, 8);
+    if (rc != CFGPACK_OK) {
+        return rc;
+    }
+    return cfgpack_schema_write_image(&ctx, image.bytes, sizeof(image.bytes),
+                                      &image_len, &perr);
+}
+
+/* Helper: rewrite the CRC trailer after deliberately editing the image. */
+static void fix_crc(uint8_t *img, size_t len) {
+    uint8_t body[2048];
+
+    memcpy(body, img, len - 4);
+    size_t n = len - 4;
+    test_append_crc(body, &n);
+    memcpy(img, body, len);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Attach matches a normal parse
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_attach_roundtrip) {
+    LOG_SECTION("Write image, attach it, compare with the JSON parse");
+
+    cfgpack_schema_t schema;
+    cfgpack_value_t values[8];
+    char str_pool[160];
+    uint16_t str_offsets[4];
+    cfgpack_parse_error_t perr;
+    cfgpack_schema_measure_t m;
+    cfgpack_schema_measure_t mj;
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t v;
+    const char *s;
+    uint8_t len8;
+    uint16_t len16;
+
+    CHECK(build_image() == CFGPACK_OK);
+    LOG("Image: %zu bytes", image_len);
+
+    CHECK(cfgpack_schema_measure_image(image.bytes, image_len, &m, &perr) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_schema_measure_json(json, strlen(json), &mj, &perr) ==
+          CFGPACK_OK);
+    CHECK(m.entry_count == mj.entry_count);
+    CHECK(m.str_pool_size == mj.str_pool_size);
+    CHECK(m.str_count == mj.str_count && m.fstr_count == mj.fstr_count);
+    CHECK(m.index_table_size == mj.index_table_size);
+    LOG("Measured: %zu entries, pool %zu", m.entry_count, m.str_pool_size);
+
+    cfgpack_parse_opts_t opts = {&schema,     NULL,     8,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 4,        &perr};
+    CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &opts) ==
+          CFGPACK_OK);
+    CHECK(strcmp(schema.map_name, "imgtest") == 0);
+    CHECK(schema.version == 7);
+    CHECK(schema.entry_count == 6);
+    CHECK((const uint8_t *)schema.entries > image.bytes &&
+          (const uint8_t *)schema.entries < image.bytes + image_len);
+    LOG("Entries point into the image");
+
+    for (size_t i = 1; i < schema.entry_count; ++i) {
+        CHECK(schema.entries[i - 1].index < schema.entries[i].index);
+    }
+
+    CHECK(cfgpack_init(&ctx, &schema, values, 8, str_pool, sizeof(str_pool),
+                       str_offsets, 4) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 9, &v) == CFGPACK_OK && v.v.u64 == 5000);
+    CHECK(cfgpack_get(&ctx, 3, &v) == CFGPACK_OK && v.v.f32 == 1.5f);
+    CHECK(cfgpack_get(&ctx, 5, &v) == CFGPACK_OK && v.v.i64 == -3);
+    CHECK(cfgpack_get_str(&ctx, 2, &s, &len16) == CFGPACK_OK &&
+          len16 == 11 && memcmp(s, "example.com", 11) == 0);
+    CHECK(cfgpack_get_fstr(&ctx, 4, &s, &len8) == CFGPACK_OK && len8 == 4 &&
+          memcmp(s, "fast", 4) == 0);
+    CHECK(cfgpack_get(&ctx, 7, &v) == CFGPACK_ERR_MISSING);
+    LOG("Defaults verified");
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Attached image is never written (XIP)
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_image_read_only) {
+    LOG_SECTION("Init, set, pageout and pagein leave the image untouched");
+
+    static union {
+        uint64_t align;
+        uint8_t bytes[2048];
+    } copy;
+    cfgpack_schema_t schema;
+    cfgpack_value_t values[8];
+    char str_pool[160];
+    uint16_t str_offsets[4];
+    cfgpack_parse_error_t perr;
+    cfgpack_ctx_t ctx;
+    cfgpack_value_t v;
+    uint8_t blob[256];
+    size_t blob_len;
+    const char *s;
+    uint16_t len16;
+
+    CHECK(build_image() == CFGPACK_OK);
+    memcpy(copy.bytes, image.bytes, image_len);
+
+    cfgpack_parse_opts_t opts = {&schema,     NULL,     8,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 4,        &perr};
+    CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &opts) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_init(&ctx, &schema, values, 8, str_pool, sizeof(str_pool),
+                       str_offsets, 4) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&ctx, 9, 1234) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&ctx, 7, "key-1") == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ctx, blob, sizeof(blob), &blob_len) == CFGPACK_OK);
+
+    /* Second boot from the same image restores the saved values */
+    CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &opts) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_init(&ctx, &schema, values, 8, str_pool, sizeof(str_pool),
+                       str_offsets, 4) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 9, &v) == CFGPACK_OK && v.v.u64 == 5000);
+    CHECK(cfgpack_pagein_buf(&ctx, blob, blob_len) == CFGPACK_OK);
+    CHECK(cfgpack_get(&ctx, 9, &v) == CFGPACK_OK && v.v.u64 == 1234);
+    CHECK(cfgpack_get_str(&ctx, 7, &s, &len16) == CFGPACK_OK && len16 == 5);
+
+    CHECK(memcmp(copy.bytes, image.bytes, image_len) == 0);
+    LOG("Image unchanged after %zu-byte pageout/pagein cycle", blob_len);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Damaged and foreign images are rejected
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_image_rejects) {
+    LOG_SECTION("Corrupt, truncated, misaligned and foreign images");
+
+    static union {
+        uint64_t align;
+        uint8_t bytes[2048 + 8];
+    } bad;
+    cfgpack_schema_measure_t m;
+    cfgpack_parse_error_t perr;
+
+    CHECK(build_image() == CFGPACK_OK);
+
+    memcpy(bad.bytes, image.bytes, image_len);
+    bad.bytes[image_len / 2] ^= 0x40;
+    CHECK(cfgpack_schema_measure_image(bad.bytes, image_len, &m, &perr) ==
+          CFGPACK_ERR_CRC);
+    LOG("Flipped bit: %s", perr.message);
+
+    CHECK(cfgpack_schema_measure_image(image.bytes, image_len - 1, &m,
+                                       &perr) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_schema_measure_image(image.bytes, 8, &m, &perr) ==
+          CFGPACK_ERR_DECODE);
+    LOG("Truncated: %s", perr.message);
+
+    memcpy(bad.bytes + 4, image.bytes, image_len);
+    CHECK(cfgpack_schema_measure_image(bad.bytes + 4, image_len, &m, &perr) ==
+          CFGPACK_ERR_ARGS);
+    LOG("Misaligned: %s", perr.message);
+
+    memcpy(bad.bytes, image.bytes, image_len);
+    bad.bytes[0] ^= 0xFF;
+    fix_crc(bad.bytes, image_len);
+    CHECK(cfgpack_schema_measure_image(bad.bytes, image_len, &m, &perr) ==
+          CFGPACK_ERR_DECODE);
+    LOG("Bad magic: %s", perr.message);
+
+    /* Byte 6 is the entry struct size: a build with another layout */
+    memcpy(bad.bytes, image.bytes, image_len);
+    bad.bytes[6]++;
+    fix_crc(bad.bytes, image_len);
+    CHECK(cfgpack_schema_measure_image(bad.bytes, image_len, &m, &perr) ==
+          CFGPACK_ERR_DECODE);
+    LOG("Foreign ABI: %s", perr.message);
+
+    CHECK(cfgpack_schema_measure_image(NULL, image_len, &m, &perr) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_schema_measure_image(image.bytes, image_len, NULL, &perr) ==
+          CFGPACK_ERR_ARGS);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. Attach buffer bounds
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_attach_bounds) {
+    LOG_SECTION("Caller buffers smaller than the image needs");
+
+    cfgpack_schema_t schema;
+    cfgpack_value_t values[8];
+    char str_pool[160];
+    uint16_t str_offsets[4];
+    cfgpack_parse_error_t perr;
+
+    CHECK(build_image() == CFGPACK_OK);
+
+    cfgpack_parse_opts_t opts = {&schema,     NULL,     5,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 4,        &perr};
+    CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &opts) ==
+          CFGPACK_ERR_BOUNDS);
+    opts.max_entries = 8;
+    opts.str_pool_cap = 100;
+    CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &opts) ==
+          CFGPACK_ERR_BOUNDS);
+    opts.str_pool_cap = sizeof(str_pool);
+    opts.str_offsets_count = 2;
+    CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &opts) ==
+          CFGPACK_ERR_BOUNDS);
+    LOG("Small buffers: %s", perr.message);
+    opts.str_offsets_count = 4;
+    opts.values = NULL;
+    CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &opts) ==
+          CFGPACK_ERR_ARGS);
+    opts.values = values;
+    CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &opts) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Writer reports the needed size");
+    {
+        cfgpack_schema_t s2;
+        cfgpack_value_t v2[8];
+        char p2[160];
+        uint16_t o2[4];
+        cfgpack_ctx_t ctx;
+        uint8_t small[64];
+        size_t need = 0;
+
+        opts.out_schema = &s2;
+        opts.values = v2;
+        opts.str_pool = p2;
+        opts.str_offsets = o2;
+        CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &opts) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_init(&ctx, &s2, v2, 8, p2, sizeof(p2), o2, 4) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_schema_write_image(&ctx, small, sizeof(small), &need,
+                                         &perr) == CFGPACK_ERR_ENCODE);
+        CHECK(need == image_len);
+        LOG("Needed %zu bytes", need);
+    }
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 5. Schema hash
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_schema_hash) {
+    LOG_SECTION("Hash matches between parse and image, tracks layout");
+
+    cfgpack_schema_t parsed;
+    cfgpack_schema_t attached;
+    cfgpack_entry_t entries[16];
+    cfgpack_value_t values[16];
+    cfgpack_value_t values2[8];
+    char str_pool[256];
+    char str_pool2[160];
+    uint16_t str_offsets[8];
+    uint16_t str_offsets2[4];
+    cfgpack_parse_error_t perr;
+    uint32_t h;
+
+    CHECK(build_image() == CFGPACK_OK);
+    cfgpack_parse_opts_t opts = {&parsed,     entries,  16,
+                                 values,      str_pool, sizeof(str_pool),
+                                 str_offsets, 8,        &perr};
+    CHECK(cfgpack_schema_parse_json(json, strlen(json), &opts) == CFGPACK_OK);
+    cfgpack_parse_opts_t aopts = {&attached,    NULL,      8,
+                                  values2,      str_pool2, sizeof(str_pool2),
+                                  str_offsets2, 4,         &perr};
+    CHECK(cfgpack_schema_attach_image(image.bytes, image_len, &aopts) ==
+          CFGPACK_OK);
+
+    h = cfgpack_schema_hash(&parsed);
+    LOG("Hash: 0x%08x", (unsigned)h);
+    CHECK(h == cfgpack_schema_hash(&attached));
+
+    /* Defaults do not move entries and are not hashed */
+    values[0].v.u64 ^= 1;
+    CHECK(cfgpack_schema_hash(&parsed) == h);
+
+    entries[0].type = CFGPACK_TYPE_U16;
+    CHECK(cfgpack_schema_hash(&parsed) != h);
+    entries[0].type = attached.entries[0].type;
+    parsed.version++;
+    CHECK(cfgpack_schema_hash(&parsed) != h);
+    parsed.version--;
+    entries[1].name[0] ^= 0x20;
+    CHECK(cfgpack_schema_hash(&parsed) != h);
+    entries[1].name[0] ^= 0x20;
+    CHECK(cfgpack_schema_hash(&parsed) == h);
+
+    return (TEST_OK);
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("attach_roundtrip",
+                                 test_attach_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("image_read_only", test_image_read_only()) !=
+                TEST_OK);
+    overall |= (test_case_result("image_rejects", test_image_rejects()) !=
+                TEST_OK);
+    overall |= (test_case_result("attach_bounds", test_attach_bounds()) !=
+                TEST_OK);
+    overall |= (test_case_result("schema_hash", test_schema_hash()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -0,0 +1,255 @@
+/* Sectioned blobs: a CRC-32C per group of entries, so a flipped bit costs
+ * only the entries of its section, and everything else still pages in. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 40
+#define BLOB_CAP  1024
+
+static cfgpack_type_t sec_type(size_t i) {
+    return (i % 8 == 7 ? CFGPACK_TYPE_STR : CFGPACK_TYPE_U32);
+}
+
+/* u32 at index 1..40 except a str at every 8th; index 1 defaults to 7. */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    fixture_schema(f, "sec", N_ENTRIES, sec_type);
+    f->entries[0].has_default = 1;
+    f->values[0].type = CFGPACK_TYPE_U32;
+    f->values[0].v.u64 = 7;
+    return (fixture_init(f));
+}
+
+/* Whether entry i holds what fixture_fill(f, 100000, 1) set: 100000 +
+ * index for u32 entries, "s<index>" for strings. */
+static int holds_fill(const fixture_t *f, size_t i) {
+    return (fixture_holds(f, i, 100000, 1));
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Same entries as a plain pageout, grouped into sections
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_sections_roundtrip) {
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t plain[BLOB_CAP];
+    uint8_t blob[BLOB_CAP];
+    uint8_t again[BLOB_CAP];
+    size_t plain_len = 0;
+    size_t len = 0;
+    size_t again_len = 0;
+    cfgpack_sections_t t;
+    size_t nbad = 1;
+    uint8_t bad[8];
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    fixture_fill(&f, 100000, 1);
+    CHECK(cfgpack_pageout(&f.ctx, plain, sizeof(plain), &plain_len) ==
+          CFGPACK_OK);
+    fixture_fill(&f, 100000, 1);
+    CHECK(cfgpack_pageout_sectioned(&f.ctx, blob, sizeof(blob), &len, 64) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+
+    LOG_SECTION("Sections of whole entries, at least 64 bytes each");
+    CHECK(cfgpack_sections_open(blob, len, &t) == CFGPACK_OK);
+    CHECK(t.count > 1 && t.count < N_ENTRIES);
+    for (size_t i = 0; i + 1 < t.count; ++i) {
+        CHECK(cfgpack_sections_offset(&t, i + 1) -
+                  cfgpack_sections_offset(&t, i) >=
+              64);
+    }
+    CHECK(len == plain_len + 5 + 2 + t.count * 8 + 8);
+    CHECK(cfgpack_sections_verify(blob, len, bad, sizeof(bad), &nbad) ==
+          CFGPACK_OK);
+    CHECK(nbad == 0 && bad[0] == 0);
+    LOG("%zu sections, %zu bytes over a %zu-byte plain blob", t.count, len,
+        plain_len);
+
+    LOG_SECTION("Plain pagein skips the table");
+    CHECK(cfgpack_pagein_buf(&g.ctx, blob, len) == CFGPACK_OK);
+    for (size_t i = 0; i < N_ENTRIES; ++i) {
+        CHECK(holds_fill(&g, i));
+    }
+    CHECK(cfgpack_pageout(&g.ctx, again, sizeof(again), &again_len) ==
+          CFGPACK_OK);
+    CHECK(again_len == plain_len && memcmp(again, plain, plain_len) == 0);
+
+    LOG_SECTION("One section per entry");
+    CHECK(cfgpack_pageout_sectioned(&f.ctx, blob, sizeof(blob), &len, 1) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_sections_open(blob, len, &t) == CFGPACK_OK);
+    CHECK(t.count == N_ENTRIES);
+
+    LOG_SECTION("Too small a buffer reports the size needed");
+    CHECK(cfgpack_pageout_sectioned(&f.ctx, blob, 100, &again_len, 1) ==
+          CFGPACK_ERR_ENCODE);
+    CHECK(again_len == len);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. A corrupt section costs only its own entries
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_sections_recover) {
+    static fixture_t f;
+    static fixture_t g;
+    uint8_t blob[BLOB_CAP];
+    size_t len = 0;
+    cfgpack_sections_t t;
+    size_t lost = 0;
+    size_t nbad = 0;
+    uint8_t bad[8];
+    size_t lo;
+    size_t hi;
+    uint32_t v;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    fixture_fill(&f, 100000, 1);
+    CHECK(cfgpack_pageout_sectioned(&f.ctx, blob, sizeof(blob), &len, 48) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_sections_open(blob, len, &t) == CFGPACK_OK);
+    lo = cfgpack_sections_offset(&t, 2);
+    hi = cfgpack_sections_offset(&t, 3);
+
+    LOG_SECTION("Flip one bit in section 2");
+    blob[lo + 3] ^= 0x10;
+    CHECK(cfgpack_pagein_buf(&g.ctx, blob, len) == CFGPACK_ERR_CRC);
+    CHECK(cfgpack_sections_verify(blob, len, bad, sizeof(bad), &nbad) ==
+          CFGPACK_ERR_CRC);
+    CHECK(nbad == 1 && bad[0] == 0x04);
+
+    LOG_SECTION("Every other section still pages in");
+    CHECK(cfgpack_set_u32(&g.ctx, 1, 1) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_sections(&g.ctx, blob, len, NULL, &lost) ==
+          CFGPACK_OK);
+    CHECK(lost == 1);
+    for (size_t i = 0; i < N_ENTRIES; ++i) {
+        size_t at = cfgpack_sections_offset(&t, 0);
+        int in_bad = 0;
+
+        /* Walk the written entries to find the ones section 2 held: a
+         * one-byte key, then a uint32 or a fixstr "s<index>" */
+        for (size_t k = 0; k < i; ++k) {
+            at += f.entries[k].type == CFGPACK_TYPE_STR
+                      ? (k + 1 < 10 ? 4 : 5)
+                      : 6;
+        }
+        in_bad = at >= lo && at < hi;
+        CHECK(holds_fill(&g, i) == !in_bad);
+        if (in_bad && i > 0 && f.entries[i].type == CFGPACK_TYPE_U32) {
+            CHECK(cfgpack_get_u32(&g.ctx, f.entries[i].index, &v) ==
+                  CFGPACK_ERR_MISSING);
+        }
+    }
+    CHECK(cfgpack_get_dirty_count(&g.ctx) == 0);
+
+    LOG_SECTION("Same result from a precomputed bitmap");
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_sections(&g.ctx, blob, len, bad, &lost) ==
+          CFGPACK_OK);
+    CHECK(lost == 1 && holds_fill(&g, 0) && holds_fill(&g, N_ENTRIES - 1));
+    blob[lo + 3] ^= 0x10;
+
+    LOG_SECTION("A corrupt schema name loses nothing");
+    blob[3] ^= 0x01;
+    CHECK(cfgpack_sections_verify(blob, len, bad, sizeof(bad), &nbad) ==
+          CFGPACK_ERR_CRC);
+    CHECK(nbad == 0);
+    CHECK(cfgpack_pagein_sections(&g.ctx, blob, len, NULL, &lost) ==
+          CFGPACK_OK);
+    CHECK(lost == 0);
+    for (size_t i = 0; i < N_ENTRIES; ++i) {
+        CHECK(holds_fill(&g, i));
+    }
+    blob[3] ^= 0x01;
+
+    LOG_SECTION("A corrupt table leaves nothing to trust");
+    blob[len - 9] ^= 0x01;
+    CHECK(cfgpack_sections_verify(blob, len, NULL, 0, NULL) ==
+          CFGPACK_ERR_CRC);
+    CHECK(cfgpack_pagein_sections(&g.ctx, blob, len, NULL, &lost) ==
+          CFGPACK_ERR_CRC);
+    CHECK(holds_fill(&g, 5));
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Errors, and blobs without a table
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_sections_errors) {
+    static fixture_t f;
+    uint8_t blob[BLOB_CAP];
+    size_t len = 0;
+    cfgpack_sections_t t;
+    size_t lost = 9;
+    uint8_t bad[1];
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    fixture_fill(&f, 100000, 1);
+
+    LOG_SECTION("Arguments");
+    CHECK(cfgpack_pageout_sectioned(NULL, blob, sizeof(blob), &len, 8) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_sectioned(&f.ctx, blob, sizeof(blob), &len, 0) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_sections_open(NULL, 0, &t) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_sections(NULL, blob, len, NULL, &lost) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(lost == 0);
+
+    LOG_SECTION("A bitmap too small for the sections");
+    CHECK(cfgpack_pageout_sectioned(&f.ctx, blob, sizeof(blob), &len, 1) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_sections_verify(blob, len, bad, sizeof(bad), NULL) ==
+          CFGPACK_ERR_BOUNDS);
+
+    LOG_SECTION("A plain blob has no table and pages in as usual");
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_sections_open(blob, len, &t) == CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_sections_verify(blob, len, NULL, 0, NULL) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_pagein_sections(&f.ctx, blob, len, NULL, &lost) ==
+          CFGPACK_OK);
+    CHECK(lost == 0 && holds_fill(&f, 7));
+    blob[5] ^= 0x01;
+    CHECK(cfgpack_pagein_sections(&f.ctx, blob, len, NULL, &lost) ==
+          CFGPACK_ERR_CRC);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    overall |= (test_case_result("sections_roundtrip",
+                                 test_sections_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("sections_recover",
+                                 test_sections_recover()) != TEST_OK);
+    overall |= (test_case_result("sections_errors", test_sections_errors()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -0,0 +1,257 @@
+/* Seqlock readers: under CFGPACK_SEQLOCK (make test-seqlock) every set,
+ * rollback and pagein is a write section, and cfgpack_get_*_consistent()
+ * readers on other threads never see a torn value or a half-applied
+ * batch.  The default build has no counter and the plain API unchanged.
+ */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef CFGPACK_SEQLOCK
+  #include <pthread.h>
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 4
+
+static const char seq_map[] = "seq 1\n"
+                              "1 lo u32 0\n"
+                              "2 hi u32 0\n"
+                              "3 tag str \"aaaaaaaa\"\n"
+                              "4 gain f64 0.5\n";
+
+#ifdef CFGPACK_SEQLOCK
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Writers bump the counter; readers retry and give up on a stuck write
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_seqlock_counter) {
+    static fixture_t f;
+    static const uint16_t both[2] = {1, 2};
+    cfgpack_value_t pair[2];
+    uint8_t blob[128];
+  #ifdef CFGPACK_TXN
+    uint8_t undo[128];
+  #endif
+  #ifdef CFGPACK_LAZY
+    uint32_t offs[N_ENTRIES];
+  #endif
+    char buf[16];
+    size_t len = 0;
+    uint32_t u = 0;
+    double g = 0;
+
+    CHECK(fixture_parse(&f, seq_map) == CFGPACK_OK);
+    CHECK(f.ctx.seq == 0);
+
+    LOG_SECTION("Each write section advances the counter by 2");
+    CHECK(cfgpack_set_u32(&f.ctx, 1, 7) == CFGPACK_OK);
+    CHECK(f.ctx.seq == 2);
+    CHECK(cfgpack_set_str(&f.ctx, 3, "bbbb") == CFGPACK_OK);
+    CHECK(f.ctx.seq == 4);
+    CHECK(cfgpack_set_u32(&f.ctx, 9, 1) == CFGPACK_ERR_MISSING);
+    CHECK(f.ctx.seq == 4);
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(f.ctx.seq == 4);
+    CHECK(cfgpack_pagein_buf(&f.ctx, blob, len) == CFGPACK_OK);
+    CHECK(f.ctx.seq == 6);
+  #ifdef CFGPACK_TXN
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&f.ctx, 2, 3) == CFGPACK_OK);
+    CHECK(cfgpack_txn_abort(&f.ctx) == CFGPACK_OK);
+    CHECK(f.ctx.seq == 10);
+  #endif
+    LOG("set, pagein and rollback each left the counter even");
+
+    LOG_SECTION("Consistent getters read the current values");
+    CHECK(cfgpack_get_u32_consistent(&f.ctx, 1, &u) == CFGPACK_OK && u == 7);
+    CHECK(cfgpack_get_f64_consistent(&f.ctx, 4, &g) == CFGPACK_OK && g == 0.5);
+    CHECK(cfgpack_get_u32_consistent(&f.ctx, 4, &u) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(cfgpack_get_many_consistent(&f.ctx, both, 2, pair, NULL) ==
+          CFGPACK_OK);
+    CHECK(pair[0].v.u64 == 7 && pair[1].v.u64 == 0);
+    CHECK(cfgpack_get_str_consistent(&f.ctx, 3, buf, sizeof(buf), &len) ==
+          CFGPACK_OK);
+    CHECK(len == 4 && strcmp(buf, "bbbb") == 0);
+    CHECK(cfgpack_get_str_consistent(&f.ctx, 3, buf, 4, &len) ==
+          CFGPACK_ERR_STR_TOO_LONG);
+
+    LOG_SECTION("A write that never finishes makes readers give up");
+    f.ctx.seq++;
+    CHECK(cfgpack_get_u32_consistent(&f.ctx, 1, &u) == CFGPACK_ERR_BUSY);
+    CHECK(cfgpack_get_str_consistent(&f.ctx, 3, buf, sizeof(buf), NULL) ==
+          CFGPACK_ERR_BUSY);
+    f.ctx.seq++;
+    CHECK(cfgpack_get_u32_consistent(&f.ctx, 1, &u) == CFGPACK_OK);
+    LOG("Correctly returned ERR_BUSY after %d attempts",
+        CFGPACK_SEQLOCK_RETRIES);
+
+  #ifdef CFGPACK_LAZY
+    LOG_SECTION("Lazy pagein decodes on read and is refused");
+    CHECK(cfgpack_lazy_init(&f.ctx, offs, N_ENTRIES) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32_consistent(&f.ctx, 1, &u) == CFGPACK_ERR_ARGS);
+  #endif
+    CHECK(cfgpack_get_consistent(NULL, 1, pair) == CFGPACK_ERR_ARGS);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Readers on other threads never see a torn string or a split batch
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+#define WRITES  20000
+#define READERS 3
+
+static fixture_t shared;
+static volatile int writer_done;
+
+static void *writer(void *arg) {
+    static const uint16_t both[2] = {1, 2};
+    char tag[CFGPACK_STR_MAX + 1];
+
+    (void)arg;
+    for (uint32_t n = 1; n <= WRITES; ++n) {
+        cfgpack_value_t pair[2] = {
+            {.type = CFGPACK_TYPE_U32, .v.u64 = n},
+            {.type = CFGPACK_TYPE_U32, .v.u64 = n},
+        };
+        size_t len = 8 + (n % 32);
+
+        /* Runs of one letter whose length follows the generation */
+        memset(tag, 'a' + (int)(n % 26), len);
+        tag[len] = '\0';
+        cfgpack_set_many(&shared.ctx, both, pair, 2, NULL);
+        cfgpack_set_str(&shared.ctx, 3, tag);
+    }
+    writer_done = 1;
+    return (NULL);
+}
+
+typedef struct {
+    unsigned reads;
+    unsigned busy;
+    unsigned torn;
+} reader_stats_t;
+
+static void *reader(void *arg) {
+    static const uint16_t both[2] = {1, 2};
+    reader_stats_t *st = (reader_stats_t *)arg;
+
+    while (!writer_done) {
+        cfgpack_value_t pair[2];
+        char buf[CFGPACK_STR_MAX + 1];
+        size_t len = 0;
+        cfgpack_err_t rc;
+
+        rc = cfgpack_get_many_consistent(&shared.ctx, both, 2, pair, NULL);
+        if (rc == CFGPACK_OK) {
+            st->torn += pair[0].v.u64 != pair[1].v.u64;
+        } else {
+            st->busy++;
+        }
+        rc = cfgpack_get_str_consistent(&shared.ctx, 3, buf, sizeof(buf),
+                                        &len);
+        if (rc == CFGPACK_OK) {
+            for (size_t i = 1; i < len; ++i) {
+                if (buf[i] != buf[0]) {
+                    st->torn++;
+                    break;
+                }
+            }
+            st->torn += len < 8 || strlen(buf) != len;
+        } else {
+            st->busy++;
+        }
+        st->reads += 2;
+    }
+    return (NULL);
+}
+
+TEST_CASE(test_seqlock_threads) {
+    LOG_SECTION("One writer thread, three lock-free readers");
+
+    pthread_t w;
+    pthread_t r[READERS];
+    reader_stats_t st[READERS];
+    unsigned reads = 0;
+    unsigned busy = 0;
+    unsigned torn = 0;
+    uint32_t lo = 0;
+
+    CHECK(fixture_parse(&shared, seq_map) == CFGPACK_OK);
+    memset(st, 0, sizeof(st));
+    writer_done = 0;
+    for (int i = 0; i < READERS; ++i) {
+        CHECK(pthread_create(&r[i], NULL, reader, &st[i]) == 0);
+    }
+    CHECK(pthread_create(&w, NULL, writer, NULL) == 0);
+    CHECK(pthread_join(w, NULL) == 0);
+    for (int i = 0; i < READERS; ++i) {
+        CHECK(pthread_join(r[i], NULL) == 0);
+        reads += st[i].reads;
+        busy += st[i].busy;
+        torn += st[i].torn;
+    }
+    LOG("%u reads, %u busy, %u torn", reads, busy, torn);
+    CHECK(torn == 0);
+    CHECK(shared.ctx.seq == 4u * WRITES);
+    CHECK(cfgpack_get_u32_consistent(&shared.ctx, 1, &lo) == CFGPACK_OK);
+    CHECK(lo == WRITES);
+
+    return TEST_OK;
+}
+
+#else /* !CFGPACK_SEQLOCK */
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Default build: no counter, plain readers and writers unchanged
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_seqlock_off) {
+    LOG_SECTION("Default build keeps the plain API");
+
+    static fixture_t f;
+    uint32_t u = 0;
+
+    CHECK(fixture_parse(&f, seq_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&f.ctx, 1, 42) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&f.ctx, 1, &u) == CFGPACK_OK && u == 42);
+    CHECK(CFGPACK_ERR_BUSY != CFGPACK_ERR_CRC);
+    LOG("ctx %zu B without a sequence counter", sizeof(cfgpack_ctx_t));
+
+    return TEST_OK;
+}
+
+#endif /* CFGPACK_SEQLOCK */
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+#ifdef CFGPACK_SEQLOCK
+    overall |= (test_case_result("seqlock_counter", test_seqlock_counter()) !=
+                TEST_OK);
+    overall |= (test_case_result("seqlock_threads", test_seqlock_threads()) !=
+                TEST_OK);
+#else
+    overall |= (test_case_result("seqlock_off", test_seqlock_off()) !=
+                TEST_OK);
+#endif
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -0,0 +1,335 @@
+/* Shared schemas: one parsed schema serves many contexts through
+ * cfgpack_init_shared(), which never writes it, and a schema cache finds
+ * the prototype for a name and version. */
+
+#define _POSIX_C_SOURCE 200809L /* clock_gettime under -std=c99 */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 5
+#define N_STR     2
+#define N_CTX     1000
+
+/* Per-device state of a context on a shared schema */
+typedef struct {
+    cfgpack_value_t values[N_ENTRIES];
+    char str_pool[2 * (CFGPACK_STR_MAX + 1)];
+    uint16_t str_offsets[N_STR];
+    cfgpack_ctx_t ctx;
+} device_t;
+
+static const char dev_map[] = "dev 1\n"
+                              "1 port u16 8080\n"
+                              "2 host str \"example.org\"\n"
+                              "3 name fstr \"dev\"\n"
+                              "4 gain f32 NIL\n"
+                              "5 mode u8 2\n";
+
+static device_t devs[N_CTX];
+
+static cfgpack_err_t make_device(device_t *d, const cfgpack_ctx_t *proto) {
+    return (cfgpack_init_shared(&d->ctx, proto, d->values, N_ENTRIES,
+                                d->str_pool, sizeof(d->str_pool),
+                                d->str_offsets, N_STR));
+}
+
+/* Copy-on-write defaults are not NUL-terminated in the blob */
+static int str_is(const cfgpack_ctx_t *ctx, uint16_t idx, const char *s) {
+    const char *p = NULL;
+    uint16_t len = 0;
+    uint8_t flen = 0;
+
+    if (cfgpack_get_str(ctx, idx, &p, &len) != CFGPACK_OK) {
+        if (cfgpack_get_fstr(ctx, idx, &p, &flen) != CFGPACK_OK) {
+            return (0);
+        }
+        len = flen;
+    }
+    return (len == strlen(s) && memcmp(p, s, len) == 0);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + (double)ts.tv_nsec * 1e-9);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. One parsed schema, a thousand independent contexts
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_shared_contexts) {
+    static fixture_t proto;
+    static uint64_t names[N_ENTRIES];
+    cfgpack_entry_t before[N_ENTRIES];
+    uint8_t blob[128];
+    size_t len = 0;
+    uint16_t port = 0;
+
+    CHECK(fixture_parse(&proto, dev_map) == CFGPACK_OK);
+    CHECK(cfgpack_name_index_init(&proto.ctx, names, N_ENTRIES) ==
+          CFGPACK_OK);
+    memcpy(before, proto.entries, sizeof(before));
+
+    LOG_SECTION("Contexts start from the prototype's defaults");
+    for (size_t n = 0; n < N_CTX; ++n) {
+        CHECK(make_device(&devs[n], &proto.ctx) == CFGPACK_OK);
+    }
+    CHECK(devs[0].ctx.schema == &proto.schema);
+    CHECK(devs[7].ctx.name_index == names);
+    CHECK(cfgpack_get_u16(&devs[7].ctx, 1, &port) == CFGPACK_OK &&
+          port == 8080);
+    CHECK(str_is(&devs[7].ctx, 2, "example.org"));
+    CHECK(str_is(&devs[7].ctx, 3, "dev"));
+    CHECK(!cfgpack_presence_get(&devs[7].ctx, 3)); /* gain has no default */
+    LOG("%d contexts on one schema", N_CTX);
+
+    LOG_SECTION("Each context keeps its own values");
+    for (size_t n = 0; n < N_CTX; ++n) {
+        char host[32];
+
+        snprintf(host, sizeof(host), "gw-%zu", n);
+        CHECK(cfgpack_set_u16(&devs[n].ctx, 1, (uint16_t)n) == CFGPACK_OK);
+        CHECK(cfgpack_set_str(&devs[n].ctx, 2, host) == CFGPACK_OK);
+    }
+    CHECK(cfgpack_get_u16_by_name(&devs[500].ctx, "port", &port) ==
+          CFGPACK_OK &&
+          port == 500);
+    CHECK(str_is(&devs[999].ctx, 2, "gw-999"));
+    CHECK(str_is(&proto.ctx, 2, "example.org"));
+
+    LOG_SECTION("Pagein into one context leaves the others alone");
+    CHECK(cfgpack_pageout(&devs[1].ctx, blob, sizeof(blob), &len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&devs[2].ctx, blob, len) == CFGPACK_OK);
+    CHECK(str_is(&devs[2].ctx, 2, "gw-1") && str_is(&devs[3].ctx, 2, "gw-3"));
+
+    LOG_SECTION("The schema was never written");
+    CHECK(memcmp(before, proto.entries, sizeof(before)) == 0);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Prototypes that cannot be shared are refused
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_shared_refused) {
+    static fixture_t proto;
+#ifdef CFGPACK_PACKED_ARENA
+    static uint8_t arena[128];
+#endif
+    device_t *d = &devs[0];
+
+    CHECK(fixture_parse(&proto, dev_map) == CFGPACK_OK);
+    CHECK(cfgpack_init_shared(NULL, &proto.ctx, d->values, N_ENTRIES,
+                              d->str_pool, sizeof(d->str_pool),
+                              d->str_offsets, N_STR) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_init_shared(&d->ctx, NULL, d->values, N_ENTRIES,
+                              d->str_pool, sizeof(d->str_pool),
+                              d->str_offsets, N_STR) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_init_shared(&proto.ctx, &proto.ctx, d->values, N_ENTRIES,
+                              d->str_pool, sizeof(d->str_pool),
+                              d->str_offsets, N_STR) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_init_shared(&d->ctx, &proto.ctx, d->values, N_ENTRIES - 1,
+                              d->str_pool, sizeof(d->str_pool),
+                              d->str_offsets, N_STR) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_init_shared(&d->ctx, &proto.ctx, d->values, N_ENTRIES,
+                              d->str_pool, 8, d->str_offsets,
+                              N_STR) == CFGPACK_ERR_BOUNDS);
+
+    LOG_SECTION("Unassigned string slot: refused, schema untouched");
+    proto.entries[2].str_slot = 0;
+    CHECK(make_device(d, &proto.ctx) == CFGPACK_ERR_ARGS);
+    CHECK(proto.entries[2].str_slot == 0);
+    proto.entries[2].str_slot = 1;
+    CHECK(make_device(d, &proto.ctx) == CFGPACK_OK);
+
+#ifdef CFGPACK_PACKED_ARENA
+    LOG_SECTION("Packed prototype");
+    CHECK(cfgpack_packed_init(&proto.ctx, arena, sizeof(arena)) ==
+          CFGPACK_OK);
+    CHECK(make_device(d, &proto.ctx) == CFGPACK_ERR_ARGS);
+#endif
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. A copy-on-write prototype shares its default blob
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_shared_cow) {
+    static fixture_t src;
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[N_ENTRIES];
+    cfgpack_value_t values[N_ENTRIES];
+    uint16_t str_offsets[N_STR];
+    char str_pool[CFGPACK_STR_MAX + 1];
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts = {&schema,     entries, N_ENTRIES, values,
+                                 NULL,        0,       str_offsets, N_STR,
+                                 &perr};
+    cfgpack_ctx_t proto;
+    cfgpack_ctx_t a;
+    cfgpack_ctx_t b;
+    cfgpack_value_t va[N_ENTRIES];
+    cfgpack_value_t vb[N_ENTRIES];
+    char pa[CFGPACK_STR_MAX + 1];
+    char pb[CFGPACK_STR_MAX + 1];
+    uint16_t oa[N_STR];
+    uint16_t ob[N_STR];
+    uint8_t mp[256];
+    size_t mp_len = 0;
+
+    CHECK(fixture_parse(&src, dev_map) == CFGPACK_OK);
+    CHECK(cfgpack_schema_write_msgpack(&src.ctx, mp, sizeof(mp), &mp_len,
+                                       &perr) == CFGPACK_OK);
+    CHECK(cfgpack_schema_parse_msgpack_cow(mp, mp_len, &opts) == CFGPACK_OK);
+    CHECK(cfgpack_init_cow(&proto, &schema, values, N_ENTRIES, str_pool,
+                           sizeof(str_pool), str_offsets, N_STR, mp,
+                           mp_len) == CFGPACK_OK);
+
+    LOG_SECTION("Defaults read from the blob; writes take own slots");
+    CHECK(cfgpack_init_shared(&a, &proto, va, N_ENTRIES, pa, sizeof(pa), oa,
+                              N_STR) == CFGPACK_OK);
+    CHECK(cfgpack_init_shared(&b, &proto, vb, N_ENTRIES, pb, sizeof(pb), ob,
+                              N_STR) == CFGPACK_OK);
+    CHECK(str_is(&a, 2, "example.org") && str_is(&b, 3, "dev"));
+    CHECK(cfgpack_set_str(&a, 2, "a.example.org") == CFGPACK_OK);
+    CHECK(str_is(&a, 2, "a.example.org") && str_is(&b, 2, "example.org"));
+
+    LOG_SECTION("A prototype with written strings is refused");
+    CHECK(cfgpack_set_str(&proto, 2, "x") == CFGPACK_OK);
+    CHECK(cfgpack_init_shared(&b, &proto, vb, N_ENTRIES, pb, sizeof(pb), ob,
+                              N_STR) == CFGPACK_ERR_ARGS);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. Schema cache keyed by name and version
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_schema_cache) {
+    static const char v2_map[] = "dev 2\n"
+                                 "1 port u16 9090\n"
+                                 "2 host str \"v2.example.org\"\n"
+                                 "3 name fstr \"dev\"\n"
+                                 "4 gain f32 0.5\n"
+                                 "5 mode u8 3\n";
+    static const char alt_map[] = "alt 1\n"
+                                  "1 port u16 1\n"
+                                  "2 host str \"\"\n"
+                                  "3 name fstr \"\"\n"
+                                  "4 gain f32 NIL\n"
+                                  "5 mode u8 0\n";
+    static fixture_t v1;
+    static fixture_t v1b;
+    static fixture_t v2;
+    static fixture_t alt;
+    const cfgpack_ctx_t *slots[3];
+    cfgpack_schema_cache_t cache;
+    const cfgpack_ctx_t *hit;
+    char name[64];
+    uint8_t blob[128];
+    size_t len = 0;
+    uint16_t port = 0;
+
+    CHECK(fixture_parse(&v1, dev_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&v1b, dev_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&v2, v2_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&alt, alt_map) == CFGPACK_OK);
+    CHECK(cfgpack_schema_cache_init(&cache, slots, 3) == CFGPACK_OK);
+
+    LOG_SECTION("Adds in any order, lookups by name and version");
+    CHECK(cfgpack_schema_cache_add(&cache, &v2.ctx) == CFGPACK_OK);
+    CHECK(cfgpack_schema_cache_add(&cache, &alt.ctx) == CFGPACK_OK);
+    CHECK(cfgpack_schema_cache_add(&cache, &v1.ctx) == CFGPACK_OK);
+    CHECK(cache.count == 3);
+    CHECK(cfgpack_schema_cache_find(&cache, "dev", 1) == &v1.ctx);
+    CHECK(cfgpack_schema_cache_find(&cache, "dev", 2) == &v2.ctx);
+    CHECK(cfgpack_schema_cache_find(&cache, "alt", 1) == &alt.ctx);
+    CHECK(cfgpack_schema_cache_find(&cache, "dev", 3) == NULL);
+    CHECK(cfgpack_schema_cache_find(&cache, "zzz", 1) == NULL);
+    CHECK(cfgpack_schema_cache_find(NULL, "dev", 1) == NULL);
+
+    LOG_SECTION("Same key replaces; a new key does not fit");
+    CHECK(cfgpack_schema_cache_add(&cache, &v1b.ctx) == CFGPACK_OK);
+    CHECK(cfgpack_schema_cache_find(&cache, "dev", 1) == &v1b.ctx);
+    v1.schema.version = 7;
+    CHECK(cfgpack_schema_cache_add(&cache, &v1.ctx) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_schema_cache_add(&cache, NULL) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("Stored blob -> peek name -> prototype -> context");
+    CHECK(cfgpack_pageout(&v2.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_peek_name(blob, len, name, sizeof(name)) == CFGPACK_OK);
+    hit = cfgpack_schema_cache_find(&cache, name, 2);
+    CHECK(hit == &v2.ctx);
+    CHECK(make_device(&devs[0], hit) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&devs[0].ctx, blob, len) == CFGPACK_OK);
+    CHECK(cfgpack_get_u16(&devs[0].ctx, 1, &port) == CFGPACK_OK &&
+          port == 9090);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 5. Shared setup against a parse per context
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_shared_cost) {
+    static fixture_t parsed;
+    static fixture_t proto;
+    double t0;
+    double t_parse;
+    double t_shared;
+
+    CHECK(fixture_parse(&proto, dev_map) == CFGPACK_OK);
+
+    LOG_SECTION("Set up 1000 contexts each way");
+    t0 = now_s();
+    for (size_t n = 0; n < N_CTX; ++n) {
+        CHECK(fixture_parse(&parsed, dev_map) == CFGPACK_OK);
+    }
+    t_parse = now_s() - t0;
+    t0 = now_s();
+    for (size_t n = 0; n < N_CTX; ++n) {
+        CHECK(make_device(&devs[n], &proto.ctx) == CFGPACK_OK);
+    }
+    t_shared = now_s() - t0;
+    LOG("parse + init: %.0f ns/ctx", t_parse * 1e9 / N_CTX);
+    LOG("init_shared:  %.0f ns/ctx", t_shared * 1e9 / N_CTX);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("shared_contexts", test_shared_contexts()) !=
+                TEST_OK);
+    overall |= (test_case_result("shared_refused", test_shared_refused()) !=
+                TEST_OK);
+    overall |= (test_case_result("shared_cow", test_shared_cow()) != TEST_OK);
+    overall |= (test_case_result("schema_cache", test_schema_cache()) !=
+                TEST_OK);
+    overall |= (test_case_result("shared_cost", test_shared_cost()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
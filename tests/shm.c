@@ -0,0 +1,324 @@
+/* Shared-memory publishing: one process copies its context into a segment,
+ * other processes map it read-only and read values in place under the
+ * segment's publish counter. */
+
+#define _POSIX_C_SOURCE 200809L /* fork/shm_unlink under -std=c99 */
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/shm.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 12
+#define SEG_CAP   4096
+
+static cfgpack_type_t shm_type(size_t i) {
+    return (i % 4 == 3 ? CFGPACK_TYPE_STR : CFGPACK_TYPE_U32);
+}
+
+/* u32 at index 1..12 except a str at every 4th; index 1 defaults to 7. */
+static cfgpack_err_t make_fixture(fixture_t *f, uint32_t version) {
+    fixture_schema(f, "shm", N_ENTRIES, shm_type);
+    f->schema.version = version;
+    f->entries[0].has_default = 1;
+    f->values[0].type = CFGPACK_TYPE_U32;
+    f->values[0].v.u64 = 7;
+    return (fixture_init(f));
+}
+
+/* Entry 2 to @p gen, entry 4 to "g<gen>". */
+static void stamp(fixture_t *f, uint32_t gen) {
+    char s[16];
+
+    snprintf(s, sizeof(s), "g%u", (unsigned)gen);
+    cfgpack_set_u32(&f->ctx, 2, gen);
+    cfgpack_set_str(&f->ctx, 4, s);
+}
+
+/* Whether the reader sees stamp(@p gen) and the default of entry 1. */
+static int sees(cfgpack_shm_reader_t *r, uint32_t gen) {
+    cfgpack_value_t v;
+    char want[16];
+    char s[16];
+    size_t len = 0;
+
+    snprintf(want, sizeof(want), "g%u", (unsigned)gen);
+    if (cfgpack_shm_get(r, 1, &v) != CFGPACK_OK || v.v.u64 != 7) {
+        return (0);
+    }
+    if (cfgpack_shm_get(r, 2, &v) != CFGPACK_OK || v.v.u64 != gen) {
+        return (0);
+    }
+    if (cfgpack_shm_get_str(r, 4, s, sizeof(s), &len) != CFGPACK_OK) {
+        return (0);
+    }
+    return (len == strlen(want) && strcmp(s, want) == 0);
+}
+
+typedef struct {
+    uint32_t a;
+    uint32_t b;
+} pair_t;
+
+/* Entries 2 and 3 in one consistent read. */
+static cfgpack_err_t read_pair(const cfgpack_ctx_t *ctx, void *user) {
+    pair_t *p = (pair_t *)user;
+    cfgpack_err_t rc = cfgpack_get_u32(ctx, 2, &p->a);
+
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    return (cfgpack_get_u32(ctx, 3, &p->b));
+}
+
+/* Segment storage with the 8-byte alignment publish and attach want. */
+typedef union {
+    uint64_t align;
+    uint8_t bytes[SEG_CAP];
+} seg_t;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Publish and read in one process; the segment is position independent
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_shm_roundtrip) {
+    static fixture_t f;
+    static seg_t seg;
+    static seg_t moved;
+    cfgpack_shm_reader_t r;
+    cfgpack_shm_reader_t m;
+    cfgpack_value_t v;
+    uint32_t seq;
+    pair_t p;
+
+    CHECK(make_fixture(&f, 1) == CFGPACK_OK);
+    CHECK(cfgpack_shm_size(&f.ctx) > sizeof(cfgpack_shm_hdr_t));
+    CHECK(cfgpack_shm_size(&f.ctx) <= SEG_CAP);
+
+    LOG_SECTION("First publish lays out the segment");
+    stamp(&f, 1);
+    cfgpack_set_u32(&f.ctx, 3, 1);
+    CHECK(cfgpack_shm_publish(&f.ctx, seg.bytes, sizeof(seg.bytes)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_shm_attach(&r, seg.bytes, sizeof(seg.bytes)) ==
+          CFGPACK_OK);
+    CHECK(strcmp(r.schema.map_name, "shm") == 0);
+    CHECK(r.schema.entry_count == N_ENTRIES);
+    CHECK(cfgpack_shm_seq(&r) == 2);
+    CHECK(sees(&r, 1));
+    LOG("%zu-byte segment, seq %u", cfgpack_shm_size(&f.ctx),
+        (unsigned)cfgpack_shm_seq(&r));
+
+    LOG_SECTION("Later publishes show through the same reader");
+    stamp(&f, 2);
+    cfgpack_set_u32(&f.ctx, 3, 2);
+    seq = cfgpack_shm_seq(&r);
+    CHECK(cfgpack_shm_publish(&f.ctx, seg.bytes, sizeof(seg.bytes)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_shm_seq(&r) == seq + 2);
+    CHECK(sees(&r, 2));
+    CHECK(cfgpack_shm_read(&r, read_pair, &p) == CFGPACK_OK);
+    CHECK(p.a == 2 && p.b == 2);
+
+    LOG_SECTION("Unset and unknown entries are missing");
+    CHECK(cfgpack_shm_get(&r, 5, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_shm_get(&r, 99, &v) == CFGPACK_ERR_MISSING);
+
+    LOG_SECTION("A copy at another address reads the same");
+    memcpy(moved.bytes, seg.bytes, sizeof(seg.bytes));
+    memset(seg.bytes, 0, sizeof(seg.bytes));
+    CHECK(cfgpack_shm_attach(&m, moved.bytes, sizeof(moved.bytes)) ==
+          CFGPACK_OK);
+    CHECK(sees(&m, 2));
+    CHECK(cfgpack_shm_read(&r, read_pair, &p) == CFGPACK_ERR_TYPE_MISMATCH);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Readers in other processes map the object read-only
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_shm_processes) {
+    static fixture_t f;
+    static fixture_t g;
+    cfgpack_shm_reader_t r;
+    size_t size;
+    char name[40];
+    void *seg = NULL;
+    int status = 0;
+    pid_t pid;
+
+    snprintf(name, sizeof(name), "/cfgpack-test-%ld", (long)getpid());
+    CHECK(make_fixture(&f, 1) == CFGPACK_OK);
+    size = cfgpack_shm_size(&f.ctx);
+    CHECK(cfgpack_shm_create(name, size, &seg) == CFGPACK_OK);
+    stamp(&f, 40);
+    CHECK(cfgpack_shm_publish(&f.ctx, seg, size) == CFGPACK_OK);
+
+    LOG_SECTION("Child maps the object and reads the published values");
+    pid = fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        const void *ro = NULL;
+        size_t len = 0;
+        int ok;
+
+        if (cfgpack_shm_map(name, &ro, &len) != CFGPACK_OK) {
+            _exit(2);
+        }
+        ok = len == size && cfgpack_shm_attach(&r, ro, len) == CFGPACK_OK &&
+             sees(&r, 40);
+        cfgpack_shm_unmap(ro, len);
+        _exit(ok ? 0 : 1);
+    }
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    LOG_SECTION("Child attached before a publish sees it");
+    pid = fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        const void *ro = NULL;
+        size_t len = 0;
+        int ok;
+
+        if (cfgpack_shm_map(name, &ro, &len) != CFGPACK_OK ||
+            cfgpack_shm_attach(&r, ro, len) != CFGPACK_OK) {
+            _exit(2);
+        }
+        /* Wait up to 5 s for the parent's next publish */
+        for (unsigned n = 0; n < 5000 && cfgpack_shm_seq(&r) == 2; ++n) {
+            struct timespec ms = {0, 1000000};
+
+            nanosleep(&ms, NULL);
+        }
+        ok = sees(&r, 41);
+        cfgpack_shm_unmap(ro, len);
+        _exit(ok ? 0 : 1);
+    }
+    stamp(&f, 41);
+    CHECK(cfgpack_shm_publish(&f.ctx, seg, size) == CFGPACK_OK);
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    LOG_SECTION("A new schema version needs a new attach");
+    CHECK(cfgpack_shm_attach(&r, seg, size) == CFGPACK_OK);
+    CHECK(make_fixture(&g, 2) == CFGPACK_OK);
+    stamp(&g, 42);
+    CHECK(cfgpack_shm_publish(&g.ctx, seg, size) == CFGPACK_OK);
+    CHECK(!sees(&r, 42));
+    CHECK(cfgpack_shm_attach(&r, seg, size) == CFGPACK_OK);
+    CHECK(r.schema.version == 2);
+    CHECK(sees(&r, 42));
+
+    cfgpack_shm_unmap(seg, size);
+    CHECK(shm_unlink(name) == 0);
+    CHECK(cfgpack_shm_map(name, (const void **)&seg, &size) ==
+          CFGPACK_ERR_IO);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Argument, capacity and segment state errors
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_shm_errors) {
+    static fixture_t f;
+    static seg_t seg;
+    cfgpack_shm_hdr_t *h = (cfgpack_shm_hdr_t *)seg.bytes;
+    cfgpack_shm_reader_t r;
+    cfgpack_value_t v;
+    size_t size;
+    char s[2];
+    pair_t p;
+
+    CHECK(make_fixture(&f, 1) == CFGPACK_OK);
+    size = cfgpack_shm_size(&f.ctx);
+
+    LOG_SECTION("NULL and misaligned arguments");
+    CHECK(cfgpack_shm_size(NULL) == 0);
+    CHECK(cfgpack_shm_publish(NULL, seg.bytes, size) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_shm_publish(&f.ctx, NULL, size) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_shm_publish(&f.ctx, seg.bytes + 1, size) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_shm_attach(NULL, seg.bytes, size) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_shm_attach(&r, seg.bytes + 4, size) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_shm_create(NULL, 64, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_shm_map("/x", NULL, &size) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_shm_seq(NULL) == 0);
+
+    LOG_SECTION("Segment too small to publish into");
+    CHECK(cfgpack_shm_publish(&f.ctx, seg.bytes, size - 1) ==
+          CFGPACK_ERR_ENCODE);
+    CHECK(h->magic == 0);
+
+    LOG_SECTION("Nothing published yet, or a truncated mapping");
+    CHECK(cfgpack_shm_attach(&r, seg.bytes, sizeof(seg.bytes)) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_shm_attach(&r, seg.bytes, 8) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_shm_publish(&f.ctx, seg.bytes, size) == CFGPACK_OK);
+    CHECK(cfgpack_shm_attach(&r, seg.bytes, size - 1) == CFGPACK_ERR_DECODE);
+
+    LOG_SECTION("Another build's layout or a damaged schema");
+    h->layout ^= 1u;
+    CHECK(cfgpack_shm_attach(&r, seg.bytes, size) == CFGPACK_ERR_DECODE);
+    h->layout ^= 1u;
+    h->map_name[0] ^= 1;
+    CHECK(cfgpack_shm_attach(&r, seg.bytes, size) == CFGPACK_ERR_DECODE);
+    h->map_name[0] ^= 1;
+    CHECK(cfgpack_shm_attach(&r, seg.bytes, size) == CFGPACK_OK);
+
+    LOG_SECTION("Reads through a reader");
+    CHECK(cfgpack_shm_read(&r, NULL, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_shm_get(&r, 1, NULL) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_shm_get(&r, 2, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_set_str(&f.ctx, 4, "long") == CFGPACK_OK);
+    CHECK(cfgpack_shm_publish(&f.ctx, seg.bytes, size) == CFGPACK_OK);
+    CHECK(cfgpack_shm_get_str(&r, 4, s, sizeof(s), NULL) ==
+          CFGPACK_ERR_STR_TOO_LONG);
+    CHECK(cfgpack_shm_get_str(&r, 1, s, sizeof(s), NULL) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+
+    LOG_SECTION("A publisher stuck mid-write");
+    h->seq |= 1u;
+    CHECK(cfgpack_shm_read(&r, read_pair, &p) == CFGPACK_ERR_BUSY);
+    CHECK(cfgpack_shm_attach(&r, seg.bytes, size) == CFGPACK_ERR_BUSY);
+    CHECK(cfgpack_shm_publish(&f.ctx, seg.bytes, size) == CFGPACK_OK);
+    CHECK((cfgpack_shm_seq(&r) & 1u) == 0);
+    CHECK(cfgpack_shm_attach(&r, seg.bytes, size) == CFGPACK_OK);
+    CHECK(cfgpack_shm_get(&r, 1, &v) == CFGPACK_OK && v.v.u64 == 7);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    overall |= (test_case_result("shm_roundtrip", test_shm_roundtrip()) !=
+                TEST_OK);
+    overall |= (test_case_result("shm_processes", test_shm_processes()) !=
+                TEST_OK);
+    overall |= (test_case_result("shm_errors", test_shm_errors()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
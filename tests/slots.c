@@ -0,0 +1,316 @@
+/* A/B slot tests: alternating publication, power cuts mid-write, and
+ * fallback to the older slot, on a RAM-backed NOR flash emulation. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * RAM-backed NOR flash (prog can only clear bits; erase sets 0xFF)
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define SLOT_SIZE 256
+
+typedef struct {
+    uint8_t mem[2][SLOT_SIZE];
+    size_t prog_budget; /* bytes left before a simulated power cut */
+    int limited;        /* 1 = prog_budget applies */
+    size_t reads;
+} flash_t;
+
+static cfgpack_err_t flash_read(void *user,
+                                uint8_t slot,
+                                size_t off,
+                                uint8_t *dst,
+                                size_t len) {
+    flash_t *f = (flash_t *)user;
+    f->reads++;
+    if (off + len > SLOT_SIZE) {
+        return (CFGPACK_ERR_IO);
+    }
+    memcpy(dst, &f->mem[slot][off], len);
+    return (CFGPACK_OK);
+}
+
+static cfgpack_err_t flash_prog(void *user,
+                                uint8_t slot,
+                                size_t off,
+                                const uint8_t *src,
+                                size_t len) {
+    flash_t *f = (flash_t *)user;
+    if (off + len > SLOT_SIZE) {
+        return (CFGPACK_ERR_IO);
+    }
+    for (size_t i = 0; i < len; ++i) {
+        if (f->limited && f->prog_budget == 0) {
+            return (CFGPACK_ERR_IO); /* power lost */
+        }
+        f->mem[slot][off + i] &= src[i];
+        if (f->limited) {
+            f->prog_budget--;
+        }
+    }
+    return (CFGPACK_OK);
+}
+
+static cfgpack_err_t flash_erase(void *user, uint8_t slot) {
+    flash_t *f = (flash_t *)user;
+    memset(f->mem[slot], 0xFF, SLOT_SIZE);
+    return (CFGPACK_OK);
+}
+
+static void flash_init(flash_t *f, cfgpack_slot_dev_t *dev) {
+    memset(f, 0xFF, sizeof(f->mem));
+    f->prog_budget = 0;
+    f->limited = 0;
+    f->reads = 0;
+    dev->read = flash_read;
+    dev->prog = flash_prog;
+    dev->erase = flash_erase;
+    dev->user = f;
+    dev->slot_size = SLOT_SIZE;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Context fixture
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 10
+
+static uint32_t get_u32(const fixture_t *f, uint16_t index) {
+    uint32_t v = 0;
+    cfgpack_get_u32(&f->ctx, index, &v);
+    return (v);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Header encode/decode and sequence comparison
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_slot_header) {
+    uint8_t raw[CFGPACK_SLOT_HDR_SIZE];
+    cfgpack_slot_hdr_t in = {0xDEADBEEFu, 1234u};
+    cfgpack_slot_hdr_t out;
+
+    cfgpack_slot_hdr_encode(raw, &in);
+    CHECK(cfgpack_slot_hdr_decode(raw, &out) == CFGPACK_OK);
+    CHECK(out.seq == in.seq && out.len == in.len);
+
+    LOG_SECTION("Erased and corrupted headers are rejected");
+    raw[5] ^= 0x01;
+    CHECK(cfgpack_slot_hdr_decode(raw, &out) == CFGPACK_ERR_DECODE);
+    memset(raw, 0xFF, sizeof(raw));
+    CHECK(cfgpack_slot_hdr_decode(raw, &out) == CFGPACK_ERR_DECODE);
+
+    LOG_SECTION("Sequence numbers wrap");
+    CHECK(cfgpack_slot_seq_newer(2, 1));
+    CHECK(!cfgpack_slot_seq_newer(1, 2));
+    CHECK(cfgpack_slot_seq_newer(0, 0xFFFFFFFFu));
+    CHECK(!cfgpack_slot_seq_newer(7, 7));
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Saves alternate slots; boot loads the newest
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_slots_alternate) {
+    static flash_t flash;
+    static fixture_t f;
+    static fixture_t g;
+    cfgpack_slot_dev_t dev;
+    cfgpack_slot_hdr_t hdr;
+    uint8_t chunk[32];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    uint8_t slot = 0xFF;
+
+    flash_init(&flash, &dev);
+    CHECK(fixture_make(&f, "slots", N_ENTRIES, NULL) == CFGPACK_OK);
+    CHECK(fixture_make(&g, "slots", N_ENTRIES, NULL) == CFGPACK_OK);
+
+    LOG_SECTION("Empty device");
+    CHECK(cfgpack_slots_select(&dev, &slot, NULL) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_pagein_slots(&g.ctx, &dev, window, sizeof(window), NULL) ==
+          CFGPACK_ERR_MISSING);
+
+    for (uint32_t round = 0; round < 4; ++round) {
+        fixture_fill(&f, round * 100, 1);
+        CHECK(cfgpack_pageout_slots(&f.ctx, &dev, chunk, sizeof(chunk)) ==
+              CFGPACK_OK);
+        CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+        CHECK(cfgpack_slots_select(&dev, &slot, &hdr) == CFGPACK_OK);
+        LOG("Save %u -> slot %u seq %u (%u bytes)", round, slot, hdr.seq,
+            hdr.len);
+        CHECK(slot == round % 2);
+        CHECK(hdr.seq == round + 1);
+    }
+
+    LOG_SECTION("Selection reads only the headers");
+    flash.reads = 0;
+    CHECK(cfgpack_slots_select(&dev, &slot, NULL) == CFGPACK_OK);
+    CHECK(flash.reads == 2);
+
+    CHECK(cfgpack_pagein_slots(&g.ctx, &dev, window, sizeof(window), &slot) ==
+          CFGPACK_OK);
+    CHECK(slot == 1);
+    CHECK(get_u32(&g, 1) == 301);
+    CHECK(get_u32(&g, N_ENTRIES) == 300 + N_ENTRIES);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Power cut at every byte of a save keeps the previous copy
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_slots_power_cut) {
+    static flash_t flash;
+    static fixture_t f;
+    static fixture_t g;
+    cfgpack_slot_dev_t dev;
+    cfgpack_slot_hdr_t hdr;
+    uint8_t chunk[32];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    size_t total;
+    uint8_t slot;
+
+    flash_init(&flash, &dev);
+    CHECK(fixture_make(&f, "slots", N_ENTRIES, NULL) == CFGPACK_OK);
+    fixture_fill(&f, 1000, 1);
+    CHECK(cfgpack_pageout_slots(&f.ctx, &dev, chunk, sizeof(chunk)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_slots_select(&dev, &slot, &hdr) == CFGPACK_OK);
+    total = hdr.len + CFGPACK_SLOT_HDR_SIZE;
+
+    for (size_t cut = 0; cut < total; ++cut) {
+        static flash_t snap;
+        snap = flash;
+        dev.user = &snap;
+        fixture_fill(&f, 2000, 1);
+        snap.limited = 1;
+        snap.prog_budget = cut;
+        CHECK(cfgpack_pageout_slots(&f.ctx, &dev, chunk, sizeof(chunk)) ==
+              CFGPACK_ERR_IO);
+        CHECK(cfgpack_get_dirty_count(&f.ctx) == N_ENTRIES);
+        snap.limited = 0;
+
+        CHECK(fixture_make(&g, "slots", N_ENTRIES, NULL) == CFGPACK_OK);
+        CHECK(cfgpack_pagein_slots(&g.ctx, &dev, window, sizeof(window),
+                                   &slot) == CFGPACK_OK);
+        CHECK(slot == 0);
+        CHECK(get_u32(&g, 1) == 1001);
+    }
+    LOG("Cut after each of %zu programmed bytes: old copy loaded", total);
+
+    LOG_SECTION("Completed save publishes the new copy");
+    dev.user = &flash;
+    fixture_fill(&f, 2000, 1);
+    CHECK(cfgpack_pageout_slots(&f.ctx, &dev, chunk, sizeof(chunk)) ==
+          CFGPACK_OK);
+    CHECK(fixture_make(&g, "slots", N_ENTRIES, NULL) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_slots(&g.ctx, &dev, window, sizeof(window), &slot) ==
+          CFGPACK_OK);
+    CHECK(slot == 1);
+    CHECK(get_u32(&g, 1) == 2001);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. Corrupt newest blob falls back to the older slot
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_slots_fallback) {
+    static flash_t flash;
+    static fixture_t f;
+    static fixture_t g;
+    cfgpack_slot_dev_t dev;
+    uint8_t chunk[32];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    uint8_t slot;
+
+    flash_init(&flash, &dev);
+    CHECK(fixture_make(&f, "slots", N_ENTRIES, NULL) == CFGPACK_OK);
+    fixture_fill(&f, 10, 1);
+    CHECK(cfgpack_pageout_slots(&f.ctx, &dev, chunk, sizeof(chunk)) ==
+          CFGPACK_OK);
+    fixture_fill(&f, 20, 1);
+    CHECK(cfgpack_pageout_slots(&f.ctx, &dev, chunk, sizeof(chunk)) ==
+          CFGPACK_OK);
+
+    flash.mem[1][CFGPACK_SLOT_HDR_SIZE + 8] ^= 0x04; /* bit rot in slot 1 */
+    CHECK(fixture_make(&g, "slots", N_ENTRIES, NULL) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_slots(&g.ctx, &dev, window, sizeof(window), &slot) ==
+          CFGPACK_OK);
+    CHECK(slot == 0);
+    CHECK(get_u32(&g, 1) == 11);
+    LOG("Slot 1 failed CRC, slot 0 loaded");
+
+    LOG_SECTION("Next save overwrites the damaged slot");
+    fixture_fill(&f, 30, 1);
+    CHECK(cfgpack_pageout_slots(&f.ctx, &dev, chunk, sizeof(chunk)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_slots_select(&dev, &slot, NULL) == CFGPACK_OK);
+    CHECK(slot == 1);
+
+    LOG_SECTION("Both damaged: CRC error, context untouched");
+    flash.mem[0][CFGPACK_SLOT_HDR_SIZE + 8] ^= 0x04;
+    flash.mem[1][CFGPACK_SLOT_HDR_SIZE + 8] ^= 0x04;
+    CHECK(cfgpack_pagein_slots(&g.ctx, &dev, window, sizeof(window), NULL) ==
+          CFGPACK_ERR_CRC);
+    CHECK(get_u32(&g, 1) == 11);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 5. Argument and capacity checks
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_slots_args) {
+    static flash_t flash;
+    static fixture_t f;
+    cfgpack_slot_dev_t dev;
+    uint8_t chunk[32];
+
+    flash_init(&flash, &dev);
+    CHECK(fixture_make(&f, "slots", N_ENTRIES, NULL) == CFGPACK_OK);
+    fixture_fill(&f, 0, 1);
+
+    CHECK(cfgpack_pageout_slots(NULL, &dev, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_slots(&f.ctx, NULL, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_slots(&f.ctx, &dev, chunk,
+                                CFGPACK_STREAM_CHUNK_MIN - 1) ==
+          CFGPACK_ERR_ENCODE);
+
+    dev.slot_size = 40; /* blob is larger than this */
+    CHECK(cfgpack_pageout_slots(&f.ctx, &dev, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == N_ENTRIES);
+    LOG("NULL -> ARGS, small chunk -> ENCODE, small slot -> BOUNDS");
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("slot_header", test_slot_header()) !=
+                TEST_OK);
+    overall |= (test_case_result("slots_alternate", test_slots_alternate()) !=
+                TEST_OK);
+    overall |= (test_case_result("slots_power_cut", test_slots_power_cut()) !=
+                TEST_OK);
+    overall |= (test_case_result("slots_fallback", test_slots_fallback()) !=
+                TEST_OK);
+    overall |= (test_case_result("slots_args", test_slots_args()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -0,0 +1,227 @@
+/* Raw context snapshots: a warm boot copies the saved buffers back when
+ * build and schema are unchanged, and falls back to the blob otherwise. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 5
+#define N_STR     2 /* string entries in snap_map */
+
+static const char snap_map[] = "snp 1\n"
+                               "1 mode u8 3\n"
+                               "2 host str:24 \"gw\"\n"
+                               "3 gain f32 NIL\n"
+                               "4 tag fstr NIL\n"
+                               "5 offs i16 -7\n";
+
+/* Same entries, next version: the snapshot no longer applies */
+static const char next_map[] = "snp 2\n"
+                               "1 mode u8 3\n"
+                               "2 host str:24 \"gw\"\n"
+                               "3 gain f32 NIL\n"
+                               "4 tag fstr NIL\n"
+                               "5 offs i16 -7\n";
+
+static unsigned notified;
+
+#ifdef CFGPACK_NOTIFY
+static void count_calls(cfgpack_ctx_t *ctx, const cfgpack_sub_t *sub) {
+    (void)ctx;
+    (void)sub;
+    notified++;
+}
+
+static const cfgpack_sub_t all_sub = {1, N_ENTRIES, count_calls, NULL};
+#endif
+
+static cfgpack_err_t make_fixture(fixture_t *f, const char *map) {
+    cfgpack_err_t rc = fixture_parse(f, map);
+
+#ifdef CFGPACK_NOTIFY
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_notify_init(&f->ctx, &all_sub, 1, f->bits,
+                                 sizeof(f->bits));
+    }
+#endif
+    return (rc);
+}
+
+/* Non-default state touching every kind of buffer */
+static cfgpack_err_t populate(fixture_t *f) {
+    cfgpack_err_t rc;
+
+    rc = cfgpack_set_str(&f->ctx, 2, "gateway-7");
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_set_f32(&f->ctx, 3, 0.25f);
+    }
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_set_fstr(&f->ctx, 4, "north");
+    }
+    if (rc == CFGPACK_OK) {
+        cfgpack_presence_clear(&f->ctx, 0);
+    }
+    return (rc);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. A snapshot restores the same state as a pagein of the blob
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_snapshot_roundtrip) {
+    static fixture_t f;
+    static fixture_t g;
+    static uint8_t snap[512];
+    uint8_t a[128];
+    uint8_t b[128];
+    size_t snap_len = 0;
+    size_t a_len = 0;
+    size_t b_len = 0;
+    const char *s = NULL;
+    uint16_t s_len = 0;
+    uint8_t f_len = 0;
+    uint8_t u8 = 0;
+    int16_t i16 = 0;
+
+    CHECK(make_fixture(&f, snap_map) == CFGPACK_OK);
+    CHECK(populate(&f) == CFGPACK_OK);
+
+    LOG_SECTION("Size is exact and small buffers are refused");
+    CHECK(cfgpack_snapshot_size(&f.ctx) ==
+          CFGPACK_SNAPSHOT_HDR_SIZE + N_ENTRIES * sizeof(cfgpack_value_t) +
+              1 + N_STR * sizeof(cfgpack_str_off_t) + 25 + 17 + 4);
+    CHECK(cfgpack_snapshot_save(&f.ctx, snap,
+                                cfgpack_snapshot_size(&f.ctx) - 1,
+                                &snap_len) == CFGPACK_ERR_ENCODE);
+    CHECK(cfgpack_snapshot_save(&f.ctx, snap, sizeof(snap), &snap_len) ==
+          CFGPACK_OK);
+    CHECK(snap_len == cfgpack_snapshot_size(&f.ctx));
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 3);
+
+    LOG_SECTION("Load into a fresh context");
+    CHECK(make_fixture(&g, snap_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_i16(&g.ctx, 5, 99) == CFGPACK_OK);
+    notified = 0;
+    CHECK(cfgpack_snapshot_load(&g.ctx, snap, snap_len, NULL, 0) ==
+          CFGPACK_OK);
+#ifdef CFGPACK_NOTIFY
+    CHECK(notified == 1);
+#endif
+    CHECK(cfgpack_get_dirty_count(&g.ctx) == 0);
+    CHECK(cfgpack_get_u8(&g.ctx, 1, &u8) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_i16(&g.ctx, 5, &i16) == CFGPACK_OK && i16 == -7);
+    CHECK(cfgpack_get_str(&g.ctx, 2, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 9 && memcmp(s, "gateway-7", 9) == 0);
+    CHECK(cfgpack_get_fstr(&g.ctx, 4, &s, &f_len) == CFGPACK_OK);
+    CHECK(f_len == 5 && memcmp(s, "north", 5) == 0);
+
+    LOG_SECTION("Same blob as the saving context");
+    CHECK(cfgpack_pageout(&f.ctx, a, sizeof(a), &a_len) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&g.ctx, b, sizeof(b), &b_len) == CFGPACK_OK);
+    CHECK(a_len == b_len && memcmp(a, b, a_len) == 0);
+
+    LOG_SECTION("The restored context keeps working");
+    CHECK(cfgpack_set_str(&g.ctx, 2, "gw2") == CFGPACK_OK);
+    CHECK(cfgpack_get_str(&g.ctx, 2, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 3 && memcmp(s, "gw2", 3) == 0);
+    CHECK(cfgpack_get_fstr(&g.ctx, 4, &s, &f_len) == CFGPACK_OK);
+    CHECK(f_len == 5 && memcmp(s, "north", 5) == 0);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Snapshots that do not apply are refused or fall back to the blob
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_snapshot_fallback) {
+    static fixture_t f;
+    static fixture_t next;
+    static uint8_t snap[512];
+    static uint8_t erased[64];
+#ifdef CFGPACK_TXN
+    uint8_t undo[256];
+#endif
+    uint8_t blob[128];
+    size_t snap_len = 0;
+    size_t blob_len = 0;
+    const char *s = NULL;
+    uint16_t s_len = 0;
+    int16_t i16 = 0;
+
+    CHECK(make_fixture(&f, snap_map) == CFGPACK_OK);
+    CHECK(populate(&f) == CFGPACK_OK);
+    CHECK(cfgpack_snapshot_save(&f.ctx, snap, sizeof(snap), &snap_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &blob_len) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Another schema version: refused, then the blob is used");
+    CHECK(make_fixture(&next, next_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_i16(&next.ctx, 5, 1) == CFGPACK_OK);
+    CHECK(cfgpack_snapshot_load(&next.ctx, snap, snap_len, NULL, 0) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_i16(&next.ctx, 5, &i16) == CFGPACK_OK && i16 == 1);
+    CHECK(cfgpack_snapshot_load(&next.ctx, snap, snap_len, blob, blob_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_get_i16(&next.ctx, 5, &i16) == CFGPACK_OK && i16 == -7);
+    CHECK(cfgpack_get_str(&next.ctx, 2, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 9 && memcmp(s, "gateway-7", 9) == 0);
+
+    LOG_SECTION("Erased, truncated and corrupt snapshots");
+    CHECK(make_fixture(&f, snap_map) == CFGPACK_OK);
+    memset(erased, 0xFF, sizeof(erased));
+    CHECK(cfgpack_snapshot_load(&f.ctx, erased, sizeof(erased), NULL, 0) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_snapshot_load(&f.ctx, NULL, 0, NULL, 0) ==
+          CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_snapshot_load(&f.ctx, snap, snap_len - 1, NULL, 0) ==
+          CFGPACK_ERR_DECODE);
+    snap[CFGPACK_SNAPSHOT_HDR_SIZE + 1] ^= 0x01;
+    CHECK(cfgpack_snapshot_load(&f.ctx, snap, snap_len, NULL, 0) ==
+          CFGPACK_ERR_CRC);
+    CHECK(cfgpack_get_str(&f.ctx, 2, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 2 && memcmp(s, "gw", 2) == 0);
+    CHECK(cfgpack_snapshot_load(&f.ctx, snap, snap_len, blob, blob_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_get_str(&f.ctx, 2, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 9);
+
+    LOG_SECTION("Bad arguments");
+    CHECK(cfgpack_snapshot_save(NULL, snap, sizeof(snap), &snap_len) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_snapshot_save(&f.ctx, NULL, sizeof(snap), &snap_len) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_snapshot_load(NULL, snap, snap_len, NULL, 0) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_snapshot_size(NULL) == 0);
+#ifdef CFGPACK_TXN
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_snapshot_load(&f.ctx, snap, snap_len, blob, blob_len) ==
+          CFGPACK_ERR_ARGS);
+#endif
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("snapshot_roundtrip",
+                                 test_snapshot_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("snapshot_fallback",
+                                 test_snapshot_fallback()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
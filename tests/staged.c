@@ -0,0 +1,226 @@
+/* Staged pagein: a blob is decoded into spare buffers and published by a
+ * pointer swap, so a failed pagein leaves the context as it was. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 5
+
+/* Spare buffers of the fixture's sizes */
+typedef struct {
+    cfgpack_value_t values[FIXTURE_ENTRIES];
+    char str_pool[FIXTURE_STRS * (CFGPACK_STR_MAX + 1)];
+    cfgpack_str_off_t str_offsets[FIXTURE_STRS];
+} spare_t;
+
+static const char stage_map[] = "stg 1\n"
+                                "1 mode u8 3\n"
+                                "2 rate u8 NIL\n"
+                                "3 host str \"gw\"\n"
+                                "4 gain f32 NIL\n"
+                                "5 port u8 NIL\n";
+
+/* Same indices, but rate is a u16: 300 does not fit the u8 above */
+static const char wide_map[] = "stg 2\n"
+                               "1 mode u8 3\n"
+                               "2 rate u16 NIL\n"
+                               "3 host str \"gw\"\n"
+                               "4 gain f32 NIL\n"
+                               "5 port u8 NIL\n";
+
+static unsigned notified;
+
+#ifdef CFGPACK_NOTIFY
+static void count_calls(cfgpack_ctx_t *ctx, const cfgpack_sub_t *sub) {
+    (void)ctx;
+    (void)sub;
+    notified++;
+}
+
+static const cfgpack_sub_t all_sub = {1, N_ENTRIES, count_calls, NULL};
+#endif
+
+static cfgpack_err_t make_fixture(fixture_t *f, const char *map) {
+    cfgpack_err_t rc = fixture_parse(f, map);
+
+#ifdef CFGPACK_NOTIFY
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_notify_init(&f->ctx, &all_sub, 1, f->bits,
+                                 sizeof(f->bits));
+    }
+#endif
+    return (rc);
+}
+
+static void stage_init(cfgpack_stage_t *st, spare_t *s) {
+    memset(st, 0, sizeof(*st));
+    st->values = s->values;
+    st->values_count = FIXTURE_ENTRIES;
+    st->str_pool = s->str_pool;
+    st->str_pool_cap = sizeof(s->str_pool);
+    st->str_offsets = s->str_offsets;
+    st->str_offsets_count = FIXTURE_STRS;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. A successful staged pagein swaps buffers and matches pagein_buf
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_staged_swap) {
+    static fixture_t f;
+    static fixture_t ref;
+    static spare_t spare;
+    cfgpack_stage_t st;
+    uint8_t blob[96];
+    uint8_t a[96];
+    uint8_t b[96];
+    size_t blob_len = 0;
+    size_t a_len = 0;
+    size_t b_len = 0;
+    const char *s = NULL;
+    uint16_t s_len = 0;
+    uint8_t u8 = 0;
+
+    CHECK(make_fixture(&f, stage_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 2, 40) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 3, "gateway") == CFGPACK_OK);
+    CHECK(cfgpack_set_f32(&f.ctx, 4, 1.5f) == CFGPACK_OK);
+    cfgpack_presence_clear(&f.ctx, 0); /* mode: default restored on load */
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &blob_len) ==
+          CFGPACK_OK);
+
+    CHECK(make_fixture(&f, stage_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 5, 9) == CFGPACK_OK);
+    stage_init(&st, &spare);
+    notified = 0;
+
+    LOG_SECTION("Context runs on the spare buffers afterwards");
+    CHECK(cfgpack_pagein_staged(&f.ctx, blob, blob_len, NULL, 0, &st) ==
+          CFGPACK_OK);
+    CHECK(f.ctx.values == spare.values && f.ctx.str_pool == spare.str_pool);
+    CHECK(st.values == f.values && st.str_pool == f.str_pool);
+    CHECK(st.str_offsets == f.str_offsets);
+#ifdef CFGPACK_NOTIFY
+    CHECK(notified == 1);
+#endif
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+    CHECK(cfgpack_get_u8(&f.ctx, 1, &u8) == CFGPACK_OK && u8 == 3);
+    CHECK(cfgpack_get_u8(&f.ctx, 2, &u8) == CFGPACK_OK && u8 == 40);
+    CHECK(cfgpack_get_u8(&f.ctx, 5, &u8) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_str(&f.ctx, 3, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 7 && memcmp(s, "gateway", 7) == 0);
+
+    LOG_SECTION("Same state as an in-place pagein");
+    CHECK(make_fixture(&ref, stage_map) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&ref.ctx, blob, blob_len) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&ref.ctx, a, sizeof(a), &a_len) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, b, sizeof(b), &b_len) == CFGPACK_OK);
+    CHECK(a_len == b_len && memcmp(a, b, a_len) == 0);
+
+    LOG_SECTION("The returned buffers stage the next pagein");
+    CHECK(cfgpack_set_u8(&f.ctx, 2, 41) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, a, sizeof(a), &a_len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_staged(&f.ctx, blob, blob_len, NULL, 0, &st) ==
+          CFGPACK_OK);
+    CHECK(f.ctx.values == f.values && st.values == spare.values);
+    CHECK(cfgpack_get_u8(&f.ctx, 2, &u8) == CFGPACK_OK && u8 == 40);
+    CHECK(cfgpack_set_str(&f.ctx, 3, "gw2") == CFGPACK_OK);
+    CHECK(cfgpack_get_str(&f.ctx, 3, &s, &s_len) == CFGPACK_OK);
+    CHECK(s_len == 3 && memcmp(s, "gw2", 3) == 0);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. A failed staged pagein leaves the context and its buffers alone
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_staged_failure) {
+    static fixture_t wide;
+    static fixture_t f;
+    static spare_t spare;
+    cfgpack_stage_t st;
+    uint8_t blob[96];
+    uint8_t before[96];
+    uint8_t after[96];
+    size_t blob_len = 0;
+    size_t before_len = 0;
+    size_t after_len = 0;
+    uint8_t u8 = 0;
+
+    LOG_SECTION("Entry 2 does not fit: in-place pagein is half applied");
+    CHECK(make_fixture(&wide, wide_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&wide.ctx, 1, 7) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&wide.ctx, 2, 300) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&wide.ctx, 5, 8) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&wide.ctx, blob, sizeof(blob), &blob_len) ==
+          CFGPACK_OK);
+    CHECK(make_fixture(&f, stage_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 5, 50) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, blob, blob_len) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+    CHECK(cfgpack_get_u8(&f.ctx, 1, &u8) == CFGPACK_OK && u8 == 7);
+    CHECK(cfgpack_get_u8(&f.ctx, 5, &u8) == CFGPACK_ERR_MISSING);
+
+    LOG_SECTION("Staged: nothing changes, nobody is notified");
+    CHECK(make_fixture(&f, stage_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 5, 50) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, before, sizeof(before), &before_len) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 2, 20) == CFGPACK_OK);
+    stage_init(&st, &spare);
+    notified = 0;
+    CHECK(cfgpack_pagein_staged(&f.ctx, blob, blob_len, NULL, 0, &st) ==
+          CFGPACK_ERR_TYPE_MISMATCH);
+#ifdef CFGPACK_NOTIFY
+    CHECK(notified == 0);
+#endif
+    CHECK(f.ctx.values == f.values && st.values == spare.values);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 1);
+    CHECK(cfgpack_set_u8(&f.ctx, 2, 0) == CFGPACK_OK);
+    cfgpack_presence_clear(&f.ctx, 1);
+    CHECK(cfgpack_pageout(&f.ctx, after, sizeof(after), &after_len) ==
+          CFGPACK_OK);
+    CHECK(after_len == before_len && memcmp(after, before, before_len) == 0);
+
+    LOG_SECTION("Corrupt blob and bad stages");
+    blob[3] ^= 0x01;
+    CHECK(cfgpack_pagein_staged(&f.ctx, blob, blob_len, NULL, 0, &st) ==
+          CFGPACK_ERR_CRC);
+    CHECK(cfgpack_pagein_staged(NULL, blob, blob_len, NULL, 0, &st) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_staged(&f.ctx, blob, blob_len, NULL, 0, NULL) ==
+          CFGPACK_ERR_ARGS);
+    st.str_pool_cap = 4;
+    CHECK(cfgpack_pagein_staged(&f.ctx, blob, blob_len, NULL, 0, &st) ==
+          CFGPACK_ERR_BOUNDS);
+    st.str_pool = NULL;
+    CHECK(cfgpack_pagein_staged(&f.ctx, blob, blob_len, NULL, 0, &st) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(f.ctx.values == f.values);
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("staged_swap", test_staged_swap()) !=
+                TEST_OK);
+    overall |= (test_case_result("staged_failure", test_staged_failure()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
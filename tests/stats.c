@@ -0,0 +1,334 @@
+/* Instrumentation: under CFGPACK_STATS (make test-stats) lookups, pagein,
+ * string writes, CRC and file I/O feed cfgpack_stats_t counters, per
+ * context and globally, and the hook sees every parse, pagein, pageout
+ * and decompress start and end.  The default build has neither.
+ */
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/compress.h"
+#include "cfgpack/decompress.h"
+#include "cfgpack/io_file.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 5
+
+static const char st_map[] = "st 1\n"
+                             "1 lvl u8 3\n"
+                             "2 rate u32 70000\n"
+                             "3 tag str \"abc\"\n"
+                             "5 gain f32 1.5\n";
+
+#ifdef CFGPACK_STATS
+
+  #define MAX_EVENTS 16
+
+/* Key 9 is unknown to st_map, and rate goes out as a u16 */
+static const char st_map_wide[] = "st 1\n"
+                                  "1 lvl u8 3\n"
+                                  "2 rate u16 300\n"
+                                  "3 tag str \"abc\"\n"
+                                  "5 gain f32 1.5\n"
+                                  "9 extra u16 9\n";
+
+typedef struct {
+    cfgpack_stats_op_t op[MAX_EVENTS];
+    int end[MAX_EVENTS];
+    const cfgpack_ctx_t *ctx[MAX_EVENTS];
+    size_t count;
+} events_t;
+
+static void record(cfgpack_stats_op_t op,
+                   int end,
+                   const cfgpack_ctx_t *ctx,
+                   void *user) {
+    events_t *ev = (events_t *)user;
+
+    if (ev->count < MAX_EVENTS) {
+        ev->op[ev->count] = op;
+        ev->end[ev->count] = end;
+        ev->ctx[ev->count] = ctx;
+        ev->count++;
+    }
+}
+
+static int event_is(const events_t *ev,
+                    size_t i,
+                    cfgpack_stats_op_t op,
+                    int end) {
+    return (i < ev->count && ev->op[i] == op && ev->end[i] == end);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Lookup probes follow the lookup strategy in use
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_stats_probes) {
+    static fixture_t f;
+    cfgpack_stats_t st;
+    uint64_t names[N_ENTRIES];
+    uint8_t table[6];
+    uint32_t u = 0;
+    float g = 0;
+
+    CHECK(fixture_parse(&f, st_map) == CFGPACK_OK);
+    CHECK(cfgpack_stats_init(NULL, &st) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_stats_init(&f.ctx, &st) == CFGPACK_OK);
+    CHECK(st.index_probes == 0 && st.name_probes == 0);
+
+    LOG_SECTION("Binary search: one probe per halving");
+    CHECK(cfgpack_get_u32(&f.ctx, 2, &u) == CFGPACK_OK && u == 70000);
+    LOG("index 2 of 4 entries: %u probes", (unsigned)st.index_probes);
+    CHECK(st.index_probes >= 1 && st.index_probes <= 3);
+
+    LOG_SECTION("Index table: exactly one probe");
+    CHECK(cfgpack_index_table_init(&f.ctx, table, sizeof(table)) ==
+          CFGPACK_OK);
+    st.index_probes = 0;
+    CHECK(cfgpack_get_u32(&f.ctx, 2, &u) == CFGPACK_OK);
+    CHECK(st.index_probes == 1);
+
+    LOG_SECTION("Linear name scan: one probe per entry compared");
+    CHECK(cfgpack_get_f32_by_name(&f.ctx, "gain", &g) == CFGPACK_OK);
+    CHECK(st.name_probes == 4);
+
+    LOG_SECTION("Name index: binary search over the keys");
+    CHECK(cfgpack_name_index_init(&f.ctx, names, N_ENTRIES) == CFGPACK_OK);
+    st.name_probes = 0;
+    CHECK(cfgpack_get_f32_by_name(&f.ctx, "gain", &g) == CFGPACK_OK);
+    LOG("name index: %u probes", (unsigned)st.name_probes);
+    CHECK(st.name_probes >= 1 && st.name_probes <= 3);
+
+    LOG_SECTION("Detached context stops counting");
+    CHECK(cfgpack_stats_init(&f.ctx, NULL) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&f.ctx, 2, &u) == CFGPACK_OK);
+    CHECK(st.index_probes == 1);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Pagein counts decoded, skipped and coerced values; strings hit the pool
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_stats_pagein) {
+    static fixture_t f;
+    static fixture_t wide;
+    cfgpack_stats_t st;
+    uint8_t blob[128];
+    size_t len = 0;
+
+    CHECK(fixture_parse(&f, st_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&wide, st_map_wide) == CFGPACK_OK);
+    CHECK(cfgpack_stats_init(&f.ctx, &st) == CFGPACK_OK);
+
+    LOG_SECTION("Own blob: every entry decoded, nothing skipped");
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, blob, len) == CFGPACK_OK);
+    LOG("decoded %u skipped %u coerced %u", (unsigned)st.decoded,
+        (unsigned)st.skipped, (unsigned)st.coerced);
+    CHECK(st.decoded == 4);
+    CHECK(st.skipped == 0);
+    CHECK(st.coerced == 0);
+    CHECK(st.pool_bytes == 3);
+
+    LOG_SECTION("Wider schema: unknown key skipped, u16 widened to u32");
+    CHECK(cfgpack_pageout(&wide.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_stats_init(&f.ctx, &st) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, blob, len) == CFGPACK_OK);
+    CHECK(st.decoded == 4);
+    CHECK(st.skipped == 1);
+    CHECK(st.coerced == 1);
+
+    LOG_SECTION("String writes count pool bytes");
+    CHECK(cfgpack_stats_init(&f.ctx, &st) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 3, "hello") == CFGPACK_OK);
+    CHECK(st.pool_bytes == 5);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Global counters: CRC bytes and the sum over contexts
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_stats_global) {
+    static fixture_t a;
+    static fixture_t b;
+    static const uint8_t data[32] = {1, 2, 3};
+    cfgpack_stats_t sa;
+    cfgpack_stats_t sb;
+    cfgpack_stats_t *all = cfgpack_stats_global();
+    uint32_t crc_before;
+    uint32_t probes_before;
+    uint32_t u = 0;
+
+    CHECK(all != NULL);
+
+    LOG_SECTION("CRC-32C bytes land in the global counters only");
+    crc_before = all->crc_bytes;
+    (void)cfgpack_crc32c(data, sizeof(data));
+    CHECK(all->crc_bytes - crc_before == sizeof(data));
+
+    LOG_SECTION("Global probes are the sum over contexts");
+    CHECK(fixture_parse(&a, st_map) == CFGPACK_OK);
+    CHECK(fixture_parse(&b, st_map) == CFGPACK_OK);
+    CHECK(cfgpack_stats_init(&a.ctx, &sa) == CFGPACK_OK);
+    CHECK(cfgpack_stats_init(&b.ctx, &sb) == CFGPACK_OK);
+    probes_before = all->index_probes;
+    CHECK(cfgpack_get_u32(&a.ctx, 2, &u) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&b.ctx, 2, &u) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&b.ctx, 2, &u) == CFGPACK_OK);
+    CHECK(sb.index_probes == 2 * sa.index_probes);
+    CHECK(all->index_probes - probes_before ==
+          sa.index_probes + sb.index_probes);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. File pageout/pagein count the bytes written and read
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_stats_file_io) {
+    static fixture_t f;
+    const char *path = "/tmp/cfgpack_stats.bin";
+    uint8_t scratch[256];
+    cfgpack_stats_t st;
+    uint8_t blob[128];
+    size_t len = 0;
+
+    CHECK(fixture_parse(&f, st_map) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_stats_init(&f.ctx, &st) == CFGPACK_OK);
+
+    LOG_SECTION("Pageout writes one blob");
+    CHECK(cfgpack_pageout_file(&f.ctx, path, scratch, sizeof(scratch)) ==
+          CFGPACK_OK);
+    LOG("blob %zu B, written %u B", len, (unsigned)st.io_written);
+    CHECK(st.io_written == len);
+    CHECK(st.io_read == 0);
+
+    LOG_SECTION("Pagein reads it back");
+    CHECK(cfgpack_pagein_file(&f.ctx, path, scratch, sizeof(scratch)) ==
+          CFGPACK_OK);
+    CHECK(st.io_read == len);
+    CHECK(st.decoded == 4);
+    remove(path);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 5. The hook brackets parse, pageout, pagein and decompress
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_stats_hook) {
+    static fixture_t f;
+    static LZ4_stream_t state;
+    static events_t ev;
+    uint8_t scratch[128];
+    uint8_t blob[128];
+    uint8_t out[160];
+    size_t orig = 0;
+    size_t len = 0;
+
+    memset(&ev, 0, sizeof(ev));
+    cfgpack_stats_hook(record, &ev);
+
+    LOG_SECTION("Parse has no context");
+    CHECK(fixture_parse(&f, st_map) == CFGPACK_OK);
+    CHECK(ev.count == 2);
+    CHECK(event_is(&ev, 0, CFGPACK_STATS_PARSE, 0));
+    CHECK(event_is(&ev, 1, CFGPACK_STATS_PARSE, 1));
+    CHECK(ev.ctx[0] == NULL);
+
+    LOG_SECTION("Pageout then pagein, each with its context");
+    ev.count = 0;
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, blob, len) == CFGPACK_OK);
+    CHECK(ev.count == 4);
+    CHECK(event_is(&ev, 0, CFGPACK_STATS_PAGEOUT, 0));
+    CHECK(event_is(&ev, 1, CFGPACK_STATS_PAGEOUT, 1));
+    CHECK(event_is(&ev, 2, CFGPACK_STATS_PAGEIN, 0));
+    CHECK(event_is(&ev, 3, CFGPACK_STATS_PAGEIN, 1));
+    CHECK(ev.ctx[3] == &f.ctx);
+
+    LOG_SECTION("LZ4 pagein: decompress ends before pagein starts");
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &orig) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_lz4(&f.ctx, out, sizeof(out), &len, &state, blob,
+                              sizeof(blob)) == CFGPACK_OK);
+    ev.count = 0;
+    CHECK(cfgpack_pagein_lz4(&f.ctx, out + CFGPACK_LZ4_HDR_SIZE,
+                             len - CFGPACK_LZ4_HDR_SIZE, orig, scratch,
+                             sizeof(scratch)) == CFGPACK_OK);
+    CHECK(ev.count == 4);
+    CHECK(event_is(&ev, 0, CFGPACK_STATS_DECOMPRESS, 0));
+    CHECK(event_is(&ev, 1, CFGPACK_STATS_DECOMPRESS, 1));
+    CHECK(event_is(&ev, 2, CFGPACK_STATS_PAGEIN, 0));
+    CHECK(event_is(&ev, 3, CFGPACK_STATS_PAGEIN, 1));
+
+    LOG_SECTION("Removing the hook stops the events");
+    cfgpack_stats_hook(NULL, NULL);
+    ev.count = 0;
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, blob, len) == CFGPACK_OK);
+    CHECK(ev.count == 0);
+
+    return TEST_OK;
+}
+
+#else /* !CFGPACK_STATS */
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Default build: no counters, lookups and pagein unchanged
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_stats_off) {
+    LOG_SECTION("Default build keeps the plain API");
+
+    static fixture_t f;
+    uint8_t blob[128];
+    size_t len = 0;
+    uint32_t u = 0;
+
+    CHECK(fixture_parse(&f, st_map) == CFGPACK_OK);
+    CHECK(cfgpack_get_u32(&f.ctx, 2, &u) == CFGPACK_OK && u == 70000);
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_buf(&f.ctx, blob, len) == CFGPACK_OK);
+    LOG("ctx %zu B without a stats pointer", sizeof(cfgpack_ctx_t));
+
+    return TEST_OK;
+}
+
+#endif /* CFGPACK_STATS */
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+#ifdef CFGPACK_STATS
+    overall |= (test_case_result("stats_probes", test_stats_probes()) !=
+                TEST_OK);
+    overall |= (test_case_result("stats_pagein", test_stats_pagein()) !=
+                TEST_OK);
+    overall |= (test_case_result("stats_global", test_stats_global()) !=
+                TEST_OK);
+    overall |= (test_case_result("stats_file_io", test_stats_file_io()) !=
+                TEST_OK);
+    overall |= (test_case_result("stats_hook", test_stats_hook()) !=
+                TEST_OK);
+#else
+    overall |= (test_case_result("stats_off", test_stats_off()) != TEST_OK);
+#endif
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
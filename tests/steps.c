@@ -0,0 +1,252 @@
+/* Resumable pagein and pageout: bounded slices of work per call with the
+ * same result as the one-shot calls. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 24
+#define BLOB_CAP  2048
+
+static cfgpack_type_t step_type(size_t i) {
+    return (i % 8 == 7 ? CFGPACK_TYPE_STR : CFGPACK_TYPE_U32);
+}
+
+/* u32 at index base+1..base+24 except a str at every 8th. */
+static cfgpack_err_t make_fixture(fixture_t *f, uint16_t base) {
+    fixture_schema(f, "steps", N_ENTRIES, step_type);
+    for (size_t i = 0; i < N_ENTRIES; ++i) {
+        f->entries[i].index = (uint16_t)(base + 1 + i);
+    }
+    return (fixture_init(f));
+}
+
+/* Step a pagein to its end; returns the final result, calls in *steps. */
+static cfgpack_err_t run_pagein(cfgpack_ctx_t *ctx,
+                                cfgpack_pagein_step_t *s,
+                                size_t budget,
+                                size_t *steps) {
+    cfgpack_err_t rc;
+
+    *steps = 0;
+    do {
+        rc = cfgpack_pagein_step(ctx, s, budget);
+        ++*steps;
+    } while (rc == CFGPACK_IN_PROGRESS);
+    return (rc);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Pagein in slices matches cfgpack_pagein_remap()
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pagein_steps) {
+    static const size_t budgets[] = {1, 3, 1000};
+    static fixture_t f;
+    static fixture_t g;
+    static uint8_t blob[BLOB_CAP];
+    cfgpack_remap_entry_t remap[N_ENTRIES];
+    cfgpack_pagein_step_t s;
+    size_t steps[3];
+    size_t len = 0;
+    size_t n;
+    uint32_t v;
+
+    CHECK(make_fixture(&f, 0) == CFGPACK_OK);
+    fixture_fill(&f, 0, 1000);
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(len > 32);
+
+    LOG_SECTION("Budgets of 1, 3 and 1000 all load the blob");
+    for (size_t b = 0; b < 3; ++b) {
+        CHECK(make_fixture(&g, 0) == CFGPACK_OK);
+        CHECK(cfgpack_pagein_step_begin(&s, blob, len, NULL, 0) ==
+              CFGPACK_OK);
+        CHECK(run_pagein(&g.ctx, &s, budgets[b], &steps[b]) == CFGPACK_OK);
+        CHECK(fixture_filled(&g, 0, 1000));
+        CHECK(cfgpack_get_dirty_count(&g.ctx) == 0);
+        LOG("budget %zu: %zu steps", budgets[b], steps[b]);
+    }
+    CHECK(steps[0] > steps[1]);
+    CHECK(steps[1] > steps[2]);
+    CHECK(steps[2] == 2);
+
+    LOG_SECTION("The context is untouched while the CRC is checked");
+    CHECK(make_fixture(&g, 0) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&g.ctx, 1, 7) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_step_begin(&s, blob, len, NULL, 0) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_step(&g.ctx, &s, 1) == CFGPACK_IN_PROGRESS);
+    CHECK(cfgpack_get_u32(&g.ctx, 1, &v) == CFGPACK_OK && v == 7);
+    CHECK(run_pagein(&g.ctx, &s, 1, &n) == CFGPACK_OK);
+    CHECK(fixture_filled(&g, 0, 1000));
+
+    LOG_SECTION("A finished run refuses further steps");
+    CHECK(cfgpack_pagein_step(&g.ctx, &s, 1) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("The remap table applies as in cfgpack_pagein_remap()");
+    for (size_t i = 0; i < N_ENTRIES; ++i) {
+        remap[i].old_index = (uint16_t)(1 + i);
+        remap[i].new_index = (uint16_t)(101 + i);
+    }
+    CHECK(make_fixture(&g, 100) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_step_begin(&s, blob, len, remap, N_ENTRIES) ==
+          CFGPACK_OK);
+    CHECK(run_pagein(&g.ctx, &s, 2, &n) == CFGPACK_OK);
+    CHECK(fixture_filled(&g, 0, 1000));
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Bad blobs, bad arguments and abandoned runs
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pagein_step_errors) {
+    static fixture_t f;
+    static fixture_t g;
+    static uint8_t blob[BLOB_CAP];
+    cfgpack_pagein_step_t s;
+    size_t len = 0;
+    size_t n;
+    uint32_t v;
+
+    CHECK(make_fixture(&f, 0) == CFGPACK_OK);
+    fixture_fill(&f, 0, 1000);
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(make_fixture(&g, 0) == CFGPACK_OK);
+    CHECK(cfgpack_set_u32(&g.ctx, 1, 7) == CFGPACK_OK);
+
+    LOG_SECTION("A corrupt blob fails the CRC phase and changes nothing");
+    blob[len / 2] ^= 0x01;
+    CHECK(cfgpack_pagein_step_begin(&s, blob, len, NULL, 0) == CFGPACK_OK);
+    CHECK(run_pagein(&g.ctx, &s, 1, &n) == CFGPACK_ERR_CRC);
+    CHECK(n > 1);
+    CHECK(cfgpack_get_u32(&g.ctx, 1, &v) == CFGPACK_OK && v == 7);
+    CHECK(cfgpack_get_u32(&g.ctx, 2, &v) == CFGPACK_ERR_MISSING);
+    blob[len / 2] ^= 0x01;
+
+    LOG_SECTION("Argument errors");
+    CHECK(cfgpack_pagein_step_begin(NULL, blob, len, NULL, 0) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_step_begin(&s, NULL, len, NULL, 0) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_step_begin(&s, blob, 3, NULL, 0) ==
+          CFGPACK_ERR_DECODE);
+    CHECK(cfgpack_pagein_step_begin(&s, blob, len, NULL, 0) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_step(NULL, &s, 1) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_step(&g.ctx, NULL, 1) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_step(&g.ctx, &s, 0) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("Aborting while checking leaves the context as it was");
+    CHECK(cfgpack_pagein_step(&g.ctx, &s, 1) == CFGPACK_IN_PROGRESS);
+    cfgpack_pagein_step_abort(&g.ctx, &s);
+    CHECK(cfgpack_get_u32(&g.ctx, 1, &v) == CFGPACK_OK && v == 7);
+
+    LOG_SECTION("Aborting while decoding, then a fresh run loads the blob");
+    CHECK(cfgpack_pagein_step_begin(&s, blob, len, NULL, 0) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_step(&g.ctx, &s, 1000) == CFGPACK_IN_PROGRESS);
+    CHECK(cfgpack_pagein_step(&g.ctx, &s, 1) == CFGPACK_IN_PROGRESS);
+    cfgpack_pagein_step_abort(&g.ctx, &s);
+    CHECK(cfgpack_pagein_step(&g.ctx, &s, 1) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_step_begin(&s, blob, len, NULL, 0) == CFGPACK_OK);
+    CHECK(run_pagein(&g.ctx, &s, 5, &n) == CFGPACK_OK);
+    CHECK(fixture_filled(&g, 0, 1000));
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Pageout in slices matches cfgpack_pageout() byte for byte
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pageout_steps) {
+    static const size_t budgets[] = {1, 5, 1000};
+    static fixture_t f;
+    static uint8_t ref[BLOB_CAP];
+    static uint8_t out[BLOB_CAP];
+    cfgpack_pageout_step_t s;
+    cfgpack_err_t rc;
+    size_t ref_len = 0;
+    size_t len;
+    size_t steps;
+
+    CHECK(make_fixture(&f, 0) == CFGPACK_OK);
+    fixture_fill(&f, 0, 1000);
+    CHECK(cfgpack_pageout(&f.ctx, ref, sizeof(ref), &ref_len) == CFGPACK_OK);
+
+    LOG_SECTION("Every budget gives the same bytes and clears dirty bits");
+    for (size_t b = 0; b < 3; ++b) {
+        fixture_fill(&f, 0, 1000);
+        CHECK(cfgpack_get_dirty_count(&f.ctx) == N_ENTRIES);
+        memset(out, 0, sizeof(out));
+        len = 0;
+        steps = 0;
+        CHECK(cfgpack_pageout_step_begin(&s, out, sizeof(out)) ==
+              CFGPACK_OK);
+        do {
+            rc = cfgpack_pageout_step(&f.ctx, &s, budgets[b], &len);
+            ++steps;
+        } while (rc == CFGPACK_IN_PROGRESS);
+        CHECK(rc == CFGPACK_OK);
+        CHECK(len == ref_len);
+        CHECK(memcmp(out, ref, ref_len) == 0);
+        CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+        CHECK(cfgpack_pageout_step(&f.ctx, &s, 1, &len) == CFGPACK_ERR_ARGS);
+        LOG("budget %zu: %zu steps", budgets[b], steps);
+    }
+
+    LOG_SECTION("A write between steps ends the run with BUSY");
+    CHECK(cfgpack_pageout_step_begin(&s, out, sizeof(out)) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_step(&f.ctx, &s, 1, &len) == CFGPACK_IN_PROGRESS);
+    CHECK(cfgpack_pageout_step(&f.ctx, &s, 1, &len) == CFGPACK_IN_PROGRESS);
+    CHECK(cfgpack_set_u32(&f.ctx, 2, 5) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_step(&f.ctx, &s, 1, &len) == CFGPACK_ERR_BUSY);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 1);
+    CHECK(cfgpack_set_u32(&f.ctx, 2, 2000) == CFGPACK_OK);
+
+    LOG_SECTION("A small buffer reports ENCODE and the length needed");
+    CHECK(cfgpack_pageout_step_begin(&s, out, 16) == CFGPACK_OK);
+    do {
+        rc = cfgpack_pageout_step(&f.ctx, &s, 4, &len);
+    } while (rc == CFGPACK_IN_PROGRESS);
+    CHECK(rc == CFGPACK_ERR_ENCODE);
+    CHECK(len == ref_len);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 1);
+
+    LOG_SECTION("Argument errors");
+    CHECK(cfgpack_pageout_step_begin(NULL, out, 16) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_step_begin(&s, NULL, 16) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_step_begin(&s, out, sizeof(out)) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_step(NULL, &s, 1, &len) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_step(&f.ctx, NULL, 1, &len) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_step(&f.ctx, &s, 0, &len) == CFGPACK_ERR_ARGS);
+
+    return (TEST_OK);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Test runner
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    int overall = TEST_OK;
+
+    overall |= (test_case_result("pagein_steps", test_pagein_steps()) !=
+                TEST_OK);
+    overall |= (test_case_result("pagein_step_errors",
+                                 test_pagein_step_errors()) != TEST_OK);
+    overall |= (test_case_result("pageout_steps", test_pageout_steps()) !=
+                TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -0,0 +1,413 @@
+/* Streaming pageout/pagein tests: chunked sink output must match the flat
+ * buffer APIs byte-for-byte at every chunk size. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 6
+
+static cfgpack_type_t stream_type(size_t i) {
+    static const cfgpack_type_t types[N_ENTRIES] = {
+        CFGPACK_TYPE_U8,  CFGPACK_TYPE_U32,  CFGPACK_TYPE_STR,
+        CFGPACK_TYPE_F64, CFGPACK_TYPE_FSTR, CFGPACK_TYPE_I16,
+    };
+
+    return (types[i]);
+}
+
+/* u8, u32, str, f64, fstr, i16 with every entry set. */
+static cfgpack_err_t make_fixture(fixture_t *f) {
+    cfgpack_err_t rc = fixture_make(f, "stream", N_ENTRIES, stream_type);
+
+    if (rc != CFGPACK_OK) {
+        return (rc);
+    }
+    cfgpack_set_u8(&f->ctx, 1, 200);
+    cfgpack_set_u32(&f->ctx, 2, 123456789u);
+    cfgpack_set_str(&f->ctx, 3,
+                    "a string long enough to exceed a small chunk buffer");
+    cfgpack_set_f64(&f->ctx, 4, 2.718281828);
+    cfgpack_set_fstr(&f->ctx, 5, "fixed");
+    cfgpack_set_i16(&f->ctx, 6, -1234);
+    return (CFGPACK_OK);
+}
+
+/* Memory sink: collects chunks, counts calls, optionally fails on call N. */
+typedef struct {
+    uint8_t data[512];
+    size_t len;
+    size_t calls;
+    size_t max_chunk;
+    size_t fail_at; /* 0 = never */
+} mem_sink_t;
+
+static cfgpack_err_t mem_sink(void *user, const uint8_t *data, size_t len) {
+    mem_sink_t *m = (mem_sink_t *)user;
+    m->calls++;
+    if (m->fail_at && m->calls == m->fail_at) {
+        return (CFGPACK_ERR_IO);
+    }
+    if (m->len + len > sizeof(m->data)) {
+        return (CFGPACK_ERR_IO);
+    }
+    memcpy(m->data + m->len, data, len);
+    m->len += len;
+    if (len > m->max_chunk) {
+        m->max_chunk = len;
+    }
+    return (CFGPACK_OK);
+}
+
+/* Memory source: serves at most max_read bytes per call; optionally flips a
+ * byte once `flip_after` calls have been made (models a changing source). */
+typedef struct {
+    uint8_t data[512];
+    size_t len;
+    size_t max_read;
+    size_t calls;
+    size_t flip_after; /* 0 = never */
+    size_t flip_pos;
+} mem_source_t;
+
+static cfgpack_err_t mem_source(void *user,
+                                size_t offset,
+                                uint8_t *dst,
+                                size_t cap,
+                                size_t *out_len) {
+    mem_source_t *m = (mem_source_t *)user;
+    size_t n;
+
+    m->calls++;
+    if (m->flip_after && m->calls == m->flip_after) {
+        m->data[m->flip_pos] ^= 0x01;
+    }
+    if (offset >= m->len) {
+        *out_len = 0;
+        return (CFGPACK_OK);
+    }
+    n = m->len - offset;
+    if (n > cap) {
+        n = cap;
+    }
+    if (m->max_read && n > m->max_read) {
+        n = m->max_read;
+    }
+    memcpy(dst, m->data + offset, n);
+    *out_len = n;
+    return (CFGPACK_OK);
+}
+
+static cfgpack_err_t failing_source(void *user,
+                                    size_t offset,
+                                    uint8_t *dst,
+                                    size_t cap,
+                                    size_t *out_len) {
+    (void)user;
+    (void)offset;
+    (void)dst;
+    (void)cap;
+    *out_len = 0;
+    return (CFGPACK_ERR_IO);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. pageout_stream matches pageout for every chunk size
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pageout_stream_matches_pageout) {
+    static fixture_t f;
+    uint8_t flat[256];
+    uint8_t chunk[256];
+    size_t flat_len = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, flat, sizeof(flat), &flat_len) ==
+          CFGPACK_OK);
+    LOG("Flat pageout: %zu bytes", flat_len);
+
+    for (size_t cap = CFGPACK_STREAM_CHUNK_MIN; cap <= flat_len + 8; ++cap) {
+        static mem_sink_t m;
+        memset(&m, 0, sizeof(m));
+        CHECK(cfgpack_pageout_stream(&f.ctx, mem_sink, &m, chunk, cap) ==
+              CFGPACK_OK);
+        CHECK(m.len == flat_len);
+        CHECK(memcmp(m.data, flat, flat_len) == 0);
+    }
+    LOG("Chunk sizes %d..%zu all byte-identical", CFGPACK_STREAM_CHUNK_MIN,
+        flat_len + 8);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. Chunks are bounded by chunk_cap except oversized single appends
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pageout_stream_chunking) {
+    static fixture_t f;
+    static mem_sink_t m;
+    uint8_t chunk[32];
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    memset(&m, 0, sizeof(m));
+    CHECK(cfgpack_pageout_stream(&f.ctx, mem_sink, &m, chunk, sizeof(chunk)) ==
+          CFGPACK_OK);
+    LOG("%zu sink calls, largest %zu bytes", m.calls, m.max_chunk);
+    CHECK(m.calls > 1);
+    /* The 51-byte string body is forwarded directly; nothing else exceeds
+     * the chunk size. */
+    CHECK(m.max_chunk <= 51);
+
+    LOG_SECTION("Output pages in and round-trips");
+    static fixture_t g;
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    cfgpack_set_u8(&g.ctx, 1, 0);
+    CHECK(cfgpack_pagein_buf(&g.ctx, m.data, m.len) == CFGPACK_OK);
+    uint8_t v8 = 0;
+    CHECK(cfgpack_get_u8(&g.ctx, 1, &v8) == CFGPACK_OK);
+    CHECK(v8 == 200);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Argument validation
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pageout_stream_args) {
+    static fixture_t f;
+    static mem_sink_t m;
+    uint8_t chunk[64];
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    CHECK(cfgpack_pageout_stream(NULL, mem_sink, &m, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_stream(&f.ctx, NULL, &m, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_stream(&f.ctx, mem_sink, &m, NULL, sizeof(chunk)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pageout_stream(&f.ctx, mem_sink, &m, chunk,
+                                 CFGPACK_STREAM_CHUNK_MIN - 1) ==
+          CFGPACK_ERR_ENCODE);
+    LOG("NULL args -> ARGS, undersized chunk -> ENCODE");
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. Sink failure aborts the stream before the CRC trailer
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pageout_stream_sink_error) {
+    static fixture_t f;
+    static mem_sink_t m;
+    uint8_t chunk[CFGPACK_STREAM_CHUNK_MIN];
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    memset(&m, 0, sizeof(m));
+    m.fail_at = 2;
+    CHECK(cfgpack_pageout_stream(&f.ctx, mem_sink, &m, chunk, sizeof(chunk)) ==
+          CFGPACK_ERR_IO);
+    LOG("Sink failed on call 2; stream stopped after %zu calls", m.calls);
+    CHECK(m.calls == 2);
+    CHECK(m.len > 0 && m.len <= sizeof(chunk)); /* only the first chunk */
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 5. pagein_stream round-trips at every window and read size
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pagein_stream_roundtrip) {
+    static fixture_t f;
+    static fixture_t g;
+    static mem_source_t src;
+    uint8_t window[256];
+    const char *str = NULL;
+    uint16_t slen = 0;
+    uint32_t v32 = 0;
+    int16_t v16 = 0;
+    double f64 = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    memset(&src, 0, sizeof(src));
+    CHECK(cfgpack_pageout(&f.ctx, src.data, sizeof(src.data), &src.len) ==
+          CFGPACK_OK);
+    LOG("Blob: %zu bytes", src.len);
+
+    for (size_t cap = CFGPACK_STREAM_WINDOW_MIN; cap <= src.len + 8; ++cap) {
+        for (size_t rd = 0; rd <= 7; rd += 7) {
+            CHECK(make_fixture(&g) == CFGPACK_OK);
+            cfgpack_set_u32(&g.ctx, 2, 0);
+            cfgpack_set_str(&g.ctx, 3, "");
+            src.max_read = rd;
+            CHECK(cfgpack_pagein_stream(&g.ctx, mem_source, &src, window,
+                                        cap) == CFGPACK_OK);
+            CHECK(cfgpack_get_u32(&g.ctx, 2, &v32) == CFGPACK_OK);
+            CHECK(v32 == 123456789u);
+            CHECK(cfgpack_get_str(&g.ctx, 3, &str, &slen) == CFGPACK_OK);
+            CHECK(slen == 51);
+            CHECK(memcmp(str, "a string long enough to exceed a small chunk "
+                              "buffer", 51) == 0);
+            CHECK(cfgpack_get_f64(&g.ctx, 4, &f64) == CFGPACK_OK);
+            CHECK(f64 == 2.718281828);
+            CHECK(cfgpack_get_i16(&g.ctx, 6, &v16) == CFGPACK_OK);
+            CHECK(v16 == -1234);
+        }
+    }
+    LOG("Windows %d..%zu, whole and 7-byte reads all decode",
+        CFGPACK_STREAM_WINDOW_MIN, src.len + 8);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 6. Corrupt stream is rejected before any value is committed
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pagein_stream_crc_untouched) {
+    static fixture_t f;
+    static fixture_t g;
+    static mem_source_t src;
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    uint8_t v8 = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    memset(&src, 0, sizeof(src));
+    CHECK(cfgpack_pageout(&f.ctx, src.data, sizeof(src.data), &src.len) ==
+          CFGPACK_OK);
+
+    LOG_SECTION("Flipped byte near the end");
+    src.data[src.len - 6] ^= 0x40;
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    cfgpack_set_u8(&g.ctx, 1, 42);
+    CHECK(cfgpack_pagein_stream(&g.ctx, mem_source, &src, window,
+                                sizeof(window)) == CFGPACK_ERR_CRC);
+    CHECK(cfgpack_get_u8(&g.ctx, 1, &v8) == CFGPACK_OK);
+    CHECK(v8 == 42);
+    LOG("CRC error, first value still 42");
+
+    LOG_SECTION("Truncated stream");
+    src.data[src.len - 6] ^= 0x40;
+    size_t full = src.len;
+    src.len = 3;
+    CHECK(cfgpack_pagein_stream(&g.ctx, mem_source, &src, window,
+                                sizeof(window)) == CFGPACK_ERR_DECODE);
+    src.len = full;
+
+    LOG_SECTION("Source changes between passes");
+    src.calls = 0;
+    src.max_read = 16;
+    src.flip_after = (src.len + 15) / 16 + 2; /* first read of pass 2 */
+    src.flip_pos = src.len - 6;
+    CHECK(cfgpack_pagein_stream(&g.ctx, mem_source, &src, window,
+                                sizeof(window)) != CFGPACK_OK);
+    LOG("Changed source detected after %zu reads", src.calls);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 7. Argument validation and source errors
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pagein_stream_args) {
+    static fixture_t f;
+    static mem_source_t src;
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    memset(&src, 0, sizeof(src));
+    CHECK(cfgpack_pageout(&f.ctx, src.data, sizeof(src.data), &src.len) ==
+          CFGPACK_OK);
+
+    CHECK(cfgpack_pagein_stream(NULL, mem_source, &src, window,
+                                sizeof(window)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_stream(&f.ctx, NULL, &src, window, sizeof(window)) ==
+          CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_stream(&f.ctx, mem_source, &src, NULL,
+                                sizeof(window)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_pagein_stream(&f.ctx, mem_source, &src, window,
+                                sizeof(window) - 1) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_pagein_stream(&f.ctx, failing_source, NULL, window,
+                                sizeof(window)) == CFGPACK_ERR_IO);
+    LOG("NULL args -> ARGS, small window -> BOUNDS, source error propagated");
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 8. Unknown keys with long strings are skipped across window refills
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_pagein_stream_skip_unknown) {
+    static fixture_t f;
+    static fixture_t g;
+    static mem_source_t src;
+    static char long_str[200];
+    uint8_t window[CFGPACK_STREAM_WINDOW_MIN];
+    cfgpack_buf_t buf;
+    uint8_t v8 = 0;
+
+    CHECK(make_fixture(&f) == CFGPACK_OK);
+    memset(long_str, 'x', sizeof(long_str));
+
+    /* Hand-build {0: "stream", 99: <200-byte str>, 1: 7} + CRC */
+    memset(&src, 0, sizeof(src));
+    cfgpack_buf_init(&buf, src.data, sizeof(src.data));
+    cfgpack_buf_crc_begin(&buf);
+    CHECK(cfgpack_msgpack_encode_map_header(&buf, 3) == CFGPACK_OK);
+    CHECK(cfgpack_msgpack_encode_uint_key(&buf, 0) == CFGPACK_OK);
+    CHECK(cfgpack_msgpack_encode_str(&buf, "stream", 6) == CFGPACK_OK);
+    CHECK(cfgpack_msgpack_encode_uint_key(&buf, 99) == CFGPACK_OK);
+    CHECK(cfgpack_msgpack_encode_str(&buf, long_str, sizeof(long_str)) ==
+          CFGPACK_OK);
+    CHECK(cfgpack_msgpack_encode_uint_key(&buf, 1) == CFGPACK_OK);
+    CHECK(cfgpack_msgpack_encode_uint64(&buf, 7) == CFGPACK_OK);
+    uint32_t crc = cfgpack_buf_crc(&buf);
+    uint8_t trailer[4] = {(uint8_t)crc, (uint8_t)(crc >> 8),
+                          (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)};
+    CHECK(cfgpack_buf_append(&buf, trailer, sizeof(trailer)) == CFGPACK_OK);
+    src.len = buf.len;
+    LOG("Blob %zu bytes through a %zu-byte window", src.len, sizeof(window));
+
+    CHECK(make_fixture(&g) == CFGPACK_OK);
+    CHECK(cfgpack_pagein_stream(&g.ctx, mem_source, &src, window,
+                                sizeof(window)) == CFGPACK_OK);
+    CHECK(cfgpack_get_u8(&g.ctx, 1, &v8) == CFGPACK_OK);
+    CHECK(v8 == 7);
+
+    return TEST_OK;
+}
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+    overall |= (test_case_result("pageout_stream_matches_pageout",
+                                 test_pageout_stream_matches_pageout()) !=
+                TEST_OK);
+    overall |= (test_case_result("pageout_stream_chunking",
+                                 test_pageout_stream_chunking()) != TEST_OK);
+    overall |= (test_case_result("pageout_stream_args",
+                                 test_pageout_stream_args()) != TEST_OK);
+    overall |= (test_case_result("pageout_stream_sink_error",
+                                 test_pageout_stream_sink_error()) != TEST_OK);
+    overall |= (test_case_result("pagein_stream_roundtrip",
+                                 test_pagein_stream_roundtrip()) != TEST_OK);
+    overall |= (test_case_result("pagein_stream_crc_untouched",
+                                 test_pagein_stream_crc_untouched()) !=
+                TEST_OK);
+    overall |= (test_case_result("pagein_stream_args",
+                                 test_pagein_stream_args()) != TEST_OK);
+    overall |= (test_case_result("pagein_stream_skip_unknown",
+                                 test_pagein_stream_skip_unknown()) != TEST_OK);
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
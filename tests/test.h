@@ -114,6 +114,11 @@ test_result_t test_case_result(const char *name, test_result_t r);
 
 /* CRC-32C: linked from libcfgpack.a, used to craft test blobs with trailer */
 uint32_t cfgpack_crc32c(const uint8_t *data, size_t len);
+uint32_t cfgpack_crc32c_init(void);
+uint32_t cfgpack_crc32c_update(uint32_t crc, const uint8_t *data, size_t len);
+uint32_t cfgpack_crc32c_final(uint32_t crc);
+uint32_t cfgpack_crc32c_shift(uint32_t crc, size_t len);
+uint32_t cfgpack_crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2);
 
 #define TEST_CRC_SIZE 4
 
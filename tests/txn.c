@@ -0,0 +1,292 @@
+/* Transaction tests: under CFGPACK_TXN (make test-features) sets inside
+ * cfgpack_txn_begin() are journaled and cfgpack_txn_abort() puts back
+ * values, strings, presence and dirty bits, the size cache and
+ * copy-on-write slots; a full journal refuses the set.  The default build
+ * has no journal and the plain set path unchanged. */
+
+#include "cfgpack/cfgpack.h"
+
+#include "fixture.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define N_ENTRIES 5
+#define N_STR     2
+
+static const char txn_map[] = "txn 1\n"
+                              "1 port u16 8080\n"
+                              "2 host str \"example.org\"\n"
+                              "3 name fstr \"dev\"\n"
+                              "4 gain f32 NIL\n"
+                              "5 mode u8 2\n";
+
+#ifdef CFGPACK_TXN
+
+static uint16_t get_port(const cfgpack_ctx_t *ctx) {
+    uint16_t v = 0;
+    cfgpack_get_u16(ctx, 1, &v);
+    return (v);
+}
+
+/* Copy-on-write defaults are not NUL-terminated in the blob */
+static int str_is(const cfgpack_ctx_t *ctx, uint16_t index, const char *s) {
+    const char *got;
+    uint16_t len;
+    uint8_t flen;
+
+    if (index == 3) {
+        if (cfgpack_get_fstr(ctx, index, &got, &flen) != CFGPACK_OK) {
+            return (0);
+        }
+        return (flen == strlen(s) && memcmp(got, s, flen) == 0);
+    }
+    if (cfgpack_get_str(ctx, index, &got, &len) != CFGPACK_OK) {
+        return (0);
+    }
+    return (len == strlen(s) && memcmp(got, s, len) == 0);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Abort undoes a partly failed batch; commit keeps it
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_txn_abort_commit) {
+    static fixture_t f;
+    uint8_t undo[256];
+    cfgpack_value_t v;
+    uint8_t mode = 0;
+    char too_long[CFGPACK_STR_MAX + 2];
+
+    CHECK(fixture_parse(&f, txn_map) == CFGPACK_OK);
+    memset(too_long, 'x', sizeof(too_long) - 1);
+    too_long[sizeof(too_long) - 1] = '\0';
+
+    LOG_SECTION("Argument and state checks");
+    CHECK(cfgpack_txn_begin(NULL, undo, sizeof(undo)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_txn_begin(&f.ctx, NULL, sizeof(undo)) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_txn_commit(&f.ctx) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_txn_abort(&f.ctx) == CFGPACK_ERR_ARGS);
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("Four sets, then a string that is too long");
+    CHECK(cfgpack_set_u16(&f.ctx, 1, 9090) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 2, "other.example.net") == CFGPACK_OK);
+    CHECK(cfgpack_set_fstr(&f.ctx, 3, "edge") == CFGPACK_OK);
+    CHECK(cfgpack_set_f32(&f.ctx, 4, 2.5f) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 2, too_long) == CFGPACK_ERR_STR_TOO_LONG);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 4);
+    LOG("Journal holds %zu bytes for 4 sets", f.ctx.txn_len);
+
+    LOG_SECTION("Abort restores values, strings, presence and dirty bits");
+    CHECK(cfgpack_txn_abort(&f.ctx) == CFGPACK_OK);
+    CHECK(get_port(&f.ctx) == 8080);
+    CHECK(str_is(&f.ctx, 2, "example.org"));
+    CHECK(str_is(&f.ctx, 3, "dev"));
+    CHECK(cfgpack_get(&f.ctx, 4, &v) == CFGPACK_ERR_MISSING);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+    CHECK(cfgpack_txn_abort(&f.ctx) == CFGPACK_ERR_ARGS);
+
+    LOG_SECTION("Commit keeps the writes");
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 1, 7070) == CFGPACK_OK);
+    CHECK(cfgpack_set_str_by_name(&f.ctx, "host", "kept") == CFGPACK_OK);
+    CHECK(cfgpack_txn_commit(&f.ctx) == CFGPACK_OK);
+    CHECK(get_port(&f.ctx) == 7070);
+    CHECK(str_is(&f.ctx, 2, "kept"));
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 2);
+
+    LOG_SECTION("An entry set twice returns to its state before begin");
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 2, "first") == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 2, "second one") == CFGPACK_OK);
+    CHECK(cfgpack_set_u8_by_name(&f.ctx, "mode", 9) == CFGPACK_OK);
+    CHECK(cfgpack_txn_abort(&f.ctx) == CFGPACK_OK);
+    CHECK(str_is(&f.ctx, 2, "kept"));
+    CHECK(cfgpack_get_u8(&f.ctx, 5, &mode) == CFGPACK_OK && mode == 2);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 2);
+
+    LOG_SECTION("cfgpack_init() ends the transaction");
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(fixture_parse(&f, txn_map) == CFGPACK_OK);
+    CHECK(cfgpack_txn_commit(&f.ctx) == CFGPACK_ERR_ARGS);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 2. A full journal refuses the set and leaves it undoable
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_txn_journal_full) {
+    static fixture_t f;
+    uint8_t undo[CFGPACK_TXN_REC_BYTES + 4];
+    uint16_t idx[2] = {1, 5};
+    cfgpack_value_t vals[2] = {
+        {.type = CFGPACK_TYPE_U16, .v.u64 = 1},
+        {.type = CFGPACK_TYPE_U8, .v.u64 = 1},
+    };
+    size_t failed = 99;
+    uint8_t mode = 0;
+
+    CHECK(fixture_parse(&f, txn_map) == CFGPACK_OK);
+
+    LOG_SECTION("Room for one record");
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 1, 1111) == CFGPACK_OK);
+    CHECK(cfgpack_set_u8(&f.ctx, 5, 3) == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_set_str(&f.ctx, 2, "nope") == CFGPACK_ERR_BOUNDS);
+    CHECK(cfgpack_get_u8(&f.ctx, 5, &mode) == CFGPACK_OK && mode == 2);
+    CHECK(str_is(&f.ctx, 2, "example.org"));
+    CHECK(cfgpack_txn_abort(&f.ctx) == CFGPACK_OK);
+    CHECK(get_port(&f.ctx) == 8080);
+    LOG("Second set returned ERR_BOUNDS; abort undid the first");
+
+    LOG_SECTION("set_many rejects a batch the journal cannot hold");
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_set_many(&f.ctx, idx, vals, 2, &failed) ==
+          CFGPACK_ERR_BOUNDS);
+    CHECK(failed == 1);
+    CHECK(get_port(&f.ctx) == 8080);
+    CHECK(cfgpack_set_many(&f.ctx, idx, vals, 1, &failed) == CFGPACK_OK);
+    CHECK(cfgpack_txn_abort(&f.ctx) == CFGPACK_OK);
+    CHECK(get_port(&f.ctx) == 8080);
+    CHECK(cfgpack_get_dirty_count(&f.ctx) == 0);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 3. Abort keeps the size cache and packed storage consistent
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_txn_size_cache_packed) {
+    static fixture_t f;
+  #ifdef CFGPACK_PACKED_ARENA
+    uint64_t arena[8];
+  #endif
+    uint8_t undo[256];
+    uint8_t blob[256];
+    size_t before = 0;
+    size_t after = 0;
+    size_t len = 0;
+
+    CHECK(fixture_parse(&f, txn_map) == CFGPACK_OK);
+  #ifdef CFGPACK_PACKED_ARENA
+    CHECK(cfgpack_packed_init(&f.ctx, arena, sizeof(arena)) == CFGPACK_OK);
+  #endif
+  #ifdef CFGPACK_SIZE_CACHE
+    CHECK(cfgpack_size_cache_init(&f.ctx) == CFGPACK_OK);
+  #endif
+    CHECK(cfgpack_pageout_measure(&f.ctx, &before) == CFGPACK_OK);
+
+    LOG_SECTION("Sets that grow the pageout, then abort");
+    CHECK(cfgpack_txn_begin(&f.ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 1, 65000) == CFGPACK_OK);
+    CHECK(cfgpack_set_f32(&f.ctx, 4, 1.0f) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&f.ctx, 2, "a.much.longer.host.name") == CFGPACK_OK);
+    CHECK(cfgpack_pageout_measure(&f.ctx, &after) == CFGPACK_OK);
+    CHECK(after > before);
+    CHECK(cfgpack_txn_abort(&f.ctx) == CFGPACK_OK);
+
+    CHECK(cfgpack_pageout_measure(&f.ctx, &after) == CFGPACK_OK);
+    CHECK(cfgpack_pageout(&f.ctx, blob, sizeof(blob), &len) == CFGPACK_OK);
+    CHECK(after == before && len == before);
+    CHECK(get_port(&f.ctx) == 8080);
+    CHECK(str_is(&f.ctx, 2, "example.org"));
+    LOG("Cached size back to %zu bytes, matching the pageout", after);
+
+    return TEST_OK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 4. Abort gives back copy-on-write pool slots
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_txn_cow) {
+    static fixture_t src;
+    cfgpack_schema_t schema;
+    cfgpack_entry_t entries[N_ENTRIES];
+    cfgpack_value_t values[N_ENTRIES];
+    uint16_t str_offsets[N_STR];
+    char str_pool[CFGPACK_STR_MAX + 1];
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts = {&schema,     entries, N_ENTRIES, values,
+                                 NULL,        0,       str_offsets, N_STR,
+                                 &perr};
+    cfgpack_ctx_t ctx;
+    uint8_t mp[256];
+    uint8_t undo[256];
+    size_t mp_len = 0;
+
+    CHECK(fixture_parse(&src, txn_map) == CFGPACK_OK);
+    CHECK(cfgpack_schema_write_msgpack(&src.ctx, mp, sizeof(mp), &mp_len,
+                                       &perr) == CFGPACK_OK);
+    CHECK(cfgpack_schema_parse_msgpack_cow(mp, mp_len, &opts) == CFGPACK_OK);
+    CHECK(cfgpack_init_cow(&ctx, &schema, values, N_ENTRIES, str_pool,
+                           sizeof(str_pool), str_offsets, N_STR, mp,
+                           mp_len) == CFGPACK_OK);
+
+    LOG_SECTION("First write takes a pool slot; abort returns it");
+    CHECK(cfgpack_txn_begin(&ctx, undo, sizeof(undo)) == CFGPACK_OK);
+    CHECK(cfgpack_set_str(&ctx, 2, "pooled") == CFGPACK_OK);
+    CHECK(ctx.str_pool_used == sizeof(str_pool));
+    CHECK(cfgpack_txn_abort(&ctx) == CFGPACK_OK);
+    CHECK(ctx.str_pool_used == 0);
+    CHECK(str_is(&ctx, 2, "example.org"));
+
+    LOG_SECTION("The freed slot serves another entry");
+    CHECK(cfgpack_set_fstr(&ctx, 3, "cow") == CFGPACK_OK);
+    CHECK(str_is(&ctx, 3, "cow"));
+    CHECK(str_is(&ctx, 2, "example.org"));
+
+    return TEST_OK;
+}
+
+#else /* !CFGPACK_TXN */
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * 1. Default build: no journal, sets apply directly
+ * ═══════════════════════════════════════════════════════════════════════════ */
+TEST_CASE(test_txn_off) {
+    LOG_SECTION("Default build keeps the plain set path");
+
+    static fixture_t f;
+    uint16_t port = 0;
+
+    CHECK(fixture_parse(&f, txn_map) == CFGPACK_OK);
+    CHECK(cfgpack_set_u16(&f.ctx, 1, 9090) == CFGPACK_OK);
+    CHECK(cfgpack_get_u16(&f.ctx, 1, &port) == CFGPACK_OK && port == 9090);
+    LOG("ctx %zu B without an undo journal", sizeof(cfgpack_ctx_t));
+
+    return TEST_OK;
+}
+
+#endif /* CFGPACK_TXN */
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+int main(void) {
+    test_result_t overall = TEST_OK;
+
+#ifdef CFGPACK_TXN
+    overall |= (test_case_result("txn_abort_commit", test_txn_abort_commit()) !=
+                TEST_OK);
+    overall |= (test_case_result("txn_journal_full", test_txn_journal_full()) !=
+                TEST_OK);
+    overall |= (test_case_result("txn_size_cache_packed",
+                                 test_txn_size_cache_packed()) != TEST_OK);
+    overall |= (test_case_result("txn_cow", test_txn_cow()) != TEST_OK);
+#else
+    overall |= (test_case_result("txn_off", test_txn_off()) != TEST_OK);
+#endif
+
+    if (overall == TEST_OK) {
+        printf(COLOR_GREEN "ALL PASS" COLOR_RESET "\n");
+    } else {
+        printf(COLOR_RED "SOME FAIL" COLOR_RESET "\n");
+    }
+    return (overall);
+}
@@ -6,10 +6,16 @@
 /* Disable dynamic allocation - use static buffers only */
 #define HEATSHRINK_DYNAMIC_ALLOC 0
 
-/* Static configuration for decoder */
+/* Static configuration for decoder.  The window and lookahead can be
+ * overridden on the command line to match blobs compressed with
+ * cfgpack-compress --window/--lookahead. */
 #define HEATSHRINK_STATIC_INPUT_BUFFER_SIZE 64
+#ifndef HEATSHRINK_STATIC_WINDOW_BITS
 #define HEATSHRINK_STATIC_WINDOW_BITS 8      /* 256-byte history window */
+#endif
+#ifndef HEATSHRINK_STATIC_LOOKAHEAD_BITS
 #define HEATSHRINK_STATIC_LOOKAHEAD_BITS 4   /* 16-byte lookahead */
+#endif
 
 /* Disable debugging logs */
 #define HEATSHRINK_DEBUGGING_LOGS 0
@@ -0,0 +1,513 @@
+/**
+ * @file batch.c
+ * @brief Batch, parallel and incremental processing for the schema tools.
+ *
+ * Workers claim the next unclaimed job from a shared counter; a schema
+ * takes long enough to parse that one lock per file does not matter.
+ * Each job writes its messages into memory streams, which are printed once
+ * every worker has finished.
+ */
+
+#ifndef _POSIX_C_SOURCE
+  #define _POSIX_C_SOURCE 200809L /* open_memstream/sysconf/pthreads */
+#endif
+
+#include "batch.h"
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Job lists
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static char *dup_str(const char *s, size_t len) {
+    char *d = malloc(len + 1);
+
+    if (d) {
+        memcpy(d, s, len);
+        d[len] = '\0';
+    }
+    return (d);
+}
+
+static int add_n(batch_list_t *list,
+                 const char *in,
+                 size_t in_len,
+                 const char *out,
+                 size_t out_len) {
+    batch_job_t *job;
+
+    if (list->count == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 16;
+        batch_job_t *jobs = realloc(list->jobs, cap * sizeof(*jobs));
+        if (!jobs) {
+            return (-1);
+        }
+        list->jobs = jobs;
+        list->cap = cap;
+    }
+    job = &list->jobs[list->count];
+    job->in = dup_str(in, in_len);
+    job->out = out ? dup_str(out, out_len) : NULL;
+    if (!job->in || (out && !job->out)) {
+        free((char *)job->in);
+        free((char *)job->out);
+        return (-1);
+    }
+    list->count++;
+    return (0);
+}
+
+int batch_add(batch_list_t *list, const char *in, const char *out) {
+    return (add_n(list, in, strlen(in), out, out ? strlen(out) : 0));
+}
+
+int batch_read_manifest(batch_list_t *list, const char *path, int pairs) {
+    char line[4096];
+    size_t line_no = 0;
+    FILE *f;
+    int rc = 0;
+
+    f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Cannot open manifest: %s\n", path);
+        return (2);
+    }
+
+    while (rc == 0 && fgets(line, sizeof(line), f)) {
+        char *p = line;
+        char *end;
+        char *split;
+
+        line_no++;
+        if (!strchr(line, '\n') && !feof(f)) {
+            fprintf(stderr, "%s:%zu: line too long\n", path, line_no);
+            rc = 1;
+            break;
+        }
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        end = p + strlen(p);
+        while (end > p && isspace((unsigned char)end[-1])) {
+            end--;
+        }
+        if (p == end || *p == '#') {
+            continue;
+        }
+        if (!pairs) {
+            if (add_n(list, p, (size_t)(end - p), NULL, 0) != 0) {
+                rc = 2;
+            }
+            continue;
+        }
+
+        split = p;
+        while (split < end && !isspace((unsigned char)*split)) {
+            split++;
+        }
+        char *out = split;
+        while (out < end && isspace((unsigned char)*out)) {
+            out++;
+        }
+        if (out == end) {
+            fprintf(stderr, "%s:%zu: expected <input> <output>\n", path,
+                    line_no);
+            rc = 1;
+            break;
+        }
+        if (add_n(list, p, (size_t)(split - p), out, (size_t)(end - out)) !=
+            0) {
+            rc = 2;
+        }
+    }
+    if (rc == 0 && ferror(f)) {
+        fprintf(stderr, "Error reading manifest: %s\n", path);
+        rc = 2;
+    }
+    if (rc == 2 && !ferror(f)) {
+        fprintf(stderr, "Out of memory reading manifest: %s\n", path);
+    }
+    fclose(f);
+    return (rc);
+}
+
+void batch_free(batch_list_t *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free((char *)list->jobs[i].in);
+        free((char *)list->jobs[i].out);
+    }
+    free(list->jobs);
+    memset(list, 0, sizeof(*list));
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Worker pool
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+/** Captured messages and exit code of one job. */
+typedef struct {
+    char *out;
+    size_t out_len;
+    char *err;
+    size_t err_len;
+    int rc;
+} batch_result_t;
+
+typedef struct {
+    const batch_list_t *list;
+    batch_result_t *results;
+    batch_fn fn;
+    void *user;
+    pthread_mutex_t lock;
+    size_t next;
+} batch_pool_t;
+
+typedef struct {
+    batch_pool_t *pool;
+    void *ws;
+} batch_worker_t;
+
+static int pool_take(batch_pool_t *pool, size_t *job) {
+    int ok = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->next < pool->list->count) {
+        *job = pool->next++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return (ok);
+}
+
+static void run_one(batch_pool_t *pool, void *ws, size_t i) {
+    batch_result_t *r = &pool->results[i];
+    FILE *out = open_memstream(&r->out, &r->out_len);
+    FILE *err = open_memstream(&r->err, &r->err_len);
+
+    if (!out || !err) {
+        if (out) {
+            fclose(out);
+        }
+        if (err) {
+            fclose(err);
+        }
+        r->rc = 2;
+        return;
+    }
+    r->rc = pool->fn(ws, &pool->list->jobs[i], pool->user, out, err);
+    fclose(out);
+    fclose(err);
+}
+
+static void *worker_main(void *arg) {
+    batch_worker_t *w = arg;
+    size_t i;
+
+    while (pool_take(w->pool, &i)) {
+        run_one(w->pool, w->ws, i);
+    }
+    return (NULL);
+}
+
+/* Copy captured text to @p f, prefixing each line with "name: " if set. */
+static void print_lines(FILE *f, const char *name, const char *text,
+                        size_t len) {
+    size_t pos = 0;
+
+    while (pos < len) {
+        const char *nl = memchr(text + pos, '\n', len - pos);
+        size_t end = nl ? (size_t)(nl - text) + 1 : len;
+        if (name) {
+            fprintf(f, "%s: ", name);
+        }
+        fwrite(text + pos, 1, end - pos, f);
+        pos = end;
+    }
+}
+
+int batch_run(const batch_list_t *list,
+              unsigned threads,
+              size_t ws_size,
+              batch_fn fn,
+              void *user) {
+    batch_worker_t workers[BATCH_MAX_THREADS];
+    pthread_t tids[BATCH_MAX_THREADS];
+    batch_pool_t pool;
+    unsigned started = 0;
+    int worst = 0;
+
+    if (threads == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = n > 0 ? (unsigned)n : 1;
+    }
+    if (threads > BATCH_MAX_THREADS) {
+        threads = BATCH_MAX_THREADS;
+    }
+    if (threads > list->count) {
+        threads = list->count ? (unsigned)list->count : 1;
+    }
+
+    memset(&pool, 0, sizeof(pool));
+    pool.list = list;
+    pool.fn = fn;
+    pool.user = user;
+    pool.results = calloc(list->count ? list->count : 1,
+                          sizeof(*pool.results));
+    if (!pool.results) {
+        fprintf(stderr, "Out of memory\n");
+        return (2);
+    }
+    pthread_mutex_init(&pool.lock, NULL);
+
+    for (unsigned t = 0; t < threads; t++) {
+        workers[t].pool = &pool;
+        workers[t].ws = calloc(1, ws_size);
+        if (!workers[t].ws) {
+            break;
+        }
+        /* Worker 0 is the calling thread. */
+        if (t > 0 &&
+            pthread_create(&tids[t], NULL, worker_main, &workers[t]) != 0) {
+            free(workers[t].ws);
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        fprintf(stderr, "Out of memory\n");
+        worst = 2;
+    } else {
+        worker_main(&workers[0]);
+    }
+    for (unsigned t = 0; t < started; t++) {
+        if (t > 0) {
+            pthread_join(tids[t], NULL);
+        }
+        free(workers[t].ws);
+    }
+    pthread_mutex_destroy(&pool.lock);
+
+    for (size_t i = 0; i < list->count; i++) {
+        batch_result_t *r = &pool.results[i];
+        const char *name = list->count > 1 ? list->jobs[i].in : NULL;
+        print_lines(stdout, name, r->out, r->out_len);
+        if (r->err_len) {
+            fflush(stdout);
+            print_lines(stderr, name, r->err, r->err_len);
+        }
+        free(r->out);
+        free(r->err);
+        if (r->rc > worst) {
+            worst = r->rc;
+        }
+    }
+    fflush(stdout);
+    free(pool.results);
+    return (worst);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Hashing and the up-to-date cache
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+uint64_t batch_hash(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = data;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3u;
+    }
+    return (h);
+}
+
+typedef struct {
+    char *path;
+    uint64_t key;
+    uint64_t out;
+} cache_entry_t;
+
+static struct {
+    char *file;
+    cache_entry_t *entries;
+    size_t count;
+    size_t cap;
+    pthread_mutex_t lock;
+} cache = {NULL, NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER};
+
+static cache_entry_t *cache_find(const char *path) {
+    for (size_t i = 0; i < cache.count; i++) {
+        if (strcmp(cache.entries[i].path, path) == 0) {
+            return (&cache.entries[i]);
+        }
+    }
+    return (NULL);
+}
+
+static int cache_add(const char *path, size_t len, uint64_t key,
+                     uint64_t out) {
+    if (cache.count == cache.cap) {
+        size_t cap = cache.cap ? cache.cap * 2 : 64;
+        cache_entry_t *e = realloc(cache.entries, cap * sizeof(*e));
+        if (!e) {
+            return (-1);
+        }
+        cache.entries = e;
+        cache.cap = cap;
+    }
+    cache.entries[cache.count].path = dup_str(path, len);
+    if (!cache.entries[cache.count].path) {
+        return (-1);
+    }
+    cache.entries[cache.count].key = key;
+    cache.entries[cache.count].out = out;
+    cache.count++;
+    return (0);
+}
+
+int batch_cache_load(const char *path) {
+    char line[4096];
+    FILE *f;
+
+    cache.file = dup_str(path, strlen(path));
+    if (!cache.file) {
+        return (2);
+    }
+    f = fopen(path, "r");
+    if (!f) {
+        return (0); /* first run */
+    }
+    while (fgets(line, sizeof(line), f)) {
+        uint64_t key;
+        uint64_t out;
+        int n = 0;
+        size_t len;
+
+        /* Malformed lines are dropped; they only cost a rebuild. */
+        if (sscanf(line, "%" SCNx64 " %" SCNx64 " %n", &key, &out, &n) < 2 ||
+            n == 0) {
+            continue;
+        }
+        len = strcspn(line + n, "\r\n");
+        line[n + len] = '\0';
+        if (len && !cache_find(line + n)) {
+            if (cache_add(line + n, len, key, out) != 0) {
+                fclose(f);
+                return (2);
+            }
+        }
+    }
+    fclose(f);
+    return (0);
+}
+
+int batch_cache_get(const char *path, uint64_t *key, uint64_t *out) {
+    cache_entry_t *e;
+    int found = 0;
+
+    pthread_mutex_lock(&cache.lock);
+    e = cache.file ? cache_find(path) : NULL;
+    if (e) {
+        *key = e->key;
+        *out = e->out;
+        found = 1;
+    }
+    pthread_mutex_unlock(&cache.lock);
+    return (found);
+}
+
+void batch_cache_put(const char *path, uint64_t key, uint64_t out) {
+    cache_entry_t *e;
+
+    pthread_mutex_lock(&cache.lock);
+    if (cache.file) {
+        e = cache_find(path);
+        if (e) {
+            e->key = key;
+            e->out = out;
+        } else {
+            /* On allocation failure the file is simply rebuilt next run. */
+            (void)cache_add(path, strlen(path), key, out);
+        }
+    }
+    pthread_mutex_unlock(&cache.lock);
+}
+
+int batch_cache_save(void) {
+    char tmp[4096];
+    FILE *f;
+    int rc = 0;
+
+    if (!cache.file) {
+        return (0);
+    }
+    if ((size_t)snprintf(tmp, sizeof(tmp), "%s.tmp", cache.file) >=
+        sizeof(tmp)) {
+        rc = 2;
+    } else if (!(f = fopen(tmp, "w"))) {
+        rc = 2;
+    } else {
+        for (size_t i = 0; i < cache.count; i++) {
+            fprintf(f, "%016" PRIx64 " %016" PRIx64 " %s\n",
+                    cache.entries[i].key, cache.entries[i].out,
+                    cache.entries[i].path);
+        }
+        if (fclose(f) != 0 || rename(tmp, cache.file) != 0) {
+            rc = 2;
+        }
+    }
+    if (rc) {
+        fprintf(stderr, "Cannot write cache: %s\n", cache.file);
+    }
+
+    for (size_t i = 0; i < cache.count; i++) {
+        free(cache.entries[i].path);
+    }
+    free(cache.entries);
+    free(cache.file);
+    cache.entries = NULL;
+    cache.file = NULL;
+    cache.count = 0;
+    cache.cap = 0;
+    return (rc);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Files
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+int batch_read_file(const char *path,
+                    uint8_t *buf,
+                    size_t cap,
+                    size_t *len,
+                    FILE *err) {
+    size_t n;
+    FILE *f;
+
+    f = fopen(path, "rb");
+    if (!f) {
+        fprintf(err, "Cannot open file: %s\n", path);
+        return (2);
+    }
+
+    n = fread(buf, 1, cap, f);
+    if (n == 0 && ferror(f)) {
+        fprintf(err, "Error reading file: %s\n", path);
+        fclose(f);
+        return (2);
+    }
+    if (!feof(f) && fgetc(f) != EOF) {
+        fprintf(err, "File too large (max %zu bytes): %s\n", cap, path);
+        fclose(f);
+        return (2);
+    }
+
+    fclose(f);
+    *len = n;
+    return (0);
+}
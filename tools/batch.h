@@ -0,0 +1,154 @@
+/**
+ * @file batch.h
+ * @brief Batch, parallel and incremental processing for the schema tools.
+ *
+ * cfgpack-schema-validate and cfgpack-schema-pack accept many inputs (on
+ * the command line or in a manifest) and process them on a pool of
+ * worker threads.  Each worker owns one workspace for its whole run, so
+ * parse buffers are reused from file to file.  A worker's messages for
+ * one file are collected and printed after the run, in input order and
+ * prefixed with the input path when there is more than one job, so the
+ * log reads the same at any thread count.
+ *
+ * An optional cache file records a content hash per file, so files whose
+ * inputs (and outputs) have not changed since the last run are skipped.
+ */
+#ifndef CFGPACK_TOOLS_BATCH_H
+#define CFGPACK_TOOLS_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** @brief Upper bound on the worker threads of one run. */
+#define BATCH_MAX_THREADS 64
+
+/** @brief One unit of work: an input and, for schema-pack, an output. */
+typedef struct {
+    const char *in;  /**< Input path */
+    const char *out; /**< Output path, or NULL */
+} batch_job_t;
+
+/** @brief Growable job list; paths are owned by the list. */
+typedef struct {
+    batch_job_t *jobs;
+    size_t count;
+    size_t cap;
+} batch_list_t;
+
+/**
+ * @brief Process one job.
+ *
+ * @param ws   Worker workspace (zeroed once before the worker's first job).
+ * @param job  Job to run.
+ * @param user Tool state shared by all workers (read-only).
+ * @param out  Stream for the job's stdout messages.
+ * @param err  Stream for the job's stderr messages.
+ * @return Tool exit code for this job (0 on success).
+ */
+typedef int (*batch_fn)(void *ws,
+                        const batch_job_t *job,
+                        void *user,
+                        FILE *out,
+                        FILE *err);
+
+/**
+ * @brief Append a job, copying its paths.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int batch_add(batch_list_t *list, const char *in, const char *out);
+
+/**
+ * @brief Append the jobs of a manifest file.
+ *
+ * One job per line; blank lines and lines starting with '#' are skipped.
+ * With @p pairs set a line holds an input and an output path separated
+ * by whitespace, otherwise the whole line (trimmed) is one input path.
+ *
+ * @return 0 on success, 1 on a malformed line, 2 on an I/O error.  A
+ *         message naming the file and line is printed to stderr.
+ */
+int batch_read_manifest(batch_list_t *list, const char *path, int pairs);
+
+/** @brief Free a job list and its paths. */
+void batch_free(batch_list_t *list);
+
+/**
+ * @brief Run every job of @p list.
+ *
+ * @param list    Jobs.
+ * @param threads Worker count; 0 uses one per online CPU.  Never more
+ *                than the job count or BATCH_MAX_THREADS.
+ * @param ws_size Size of each worker's workspace.
+ * @param fn      Job function.
+ * @param user    Passed to @p fn.
+ * @return The largest exit code of any job, or 2 if workers or
+ *         workspaces could not be allocated.
+ */
+int batch_run(const batch_list_t *list,
+              unsigned threads,
+              size_t ws_size,
+              batch_fn fn,
+              void *user);
+
+/**
+ * @brief Fold @p len bytes into a 64-bit FNV-1a hash.
+ *
+ * Start with BATCH_HASH_INIT.
+ */
+uint64_t batch_hash(uint64_t h, const void *data, size_t len);
+
+/** @brief FNV-1a offset basis. */
+#define BATCH_HASH_INIT 0xcbf29ce484222325u
+
+/**
+ * @name Up-to-date cache
+ *
+ * The cache is a text file with one `<key> <out> <path>` line per file:
+ * @c key hashes everything the result depends on (tool mode and input
+ * bytes), @c out hashes the output file the result produced (0 when there
+ * is none), and @c path names the file the line is for.  It is loaded
+ * before a run and rewritten after it; lookups and updates are safe from
+ * any worker.
+ * @{
+ */
+
+/**
+ * @brief Load the cache from @p path; a missing file is an empty cache.
+ * @return 0 on success, 2 on an I/O or allocation error.
+ */
+int batch_cache_load(const char *path);
+
+/**
+ * @brief Look up @p path.
+ * @return 1 and the recorded hashes if @p path has an entry, else 0.
+ */
+int batch_cache_get(const char *path, uint64_t *key, uint64_t *out);
+
+/** @brief Record the hashes of @p path, replacing any previous entry. */
+void batch_cache_put(const char *path, uint64_t key, uint64_t out);
+
+/**
+ * @brief Write the cache back to the path it was loaded from and free it.
+ *
+ * Does nothing if no cache was loaded.
+ *
+ * @return 0 on success, 2 on an I/O error.
+ */
+int batch_cache_save(void);
+
+/** @} */
+
+/**
+ * @brief Read a whole file into a caller buffer.
+ *
+ * @return 0 on success, 2 on an I/O error or a file larger than @p cap (a
+ *         message is printed to @p err).
+ */
+int batch_read_file(const char *path,
+                    uint8_t *buf,
+                    size_t cap,
+                    size_t *len,
+                    FILE *err);
+
+#endif
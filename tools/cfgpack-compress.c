@@ -3,242 +3,1209 @@
  * @brief CLI tool for compressing files with LZ4 or heatshrink.
  *
  * Usage:
- *   cfgpack-compress <algorithm> <input> <output>
+ *   cfgpack-compress [options] <algorithm> <input> <output>
  *
  * Algorithms:
  *   lz4        - LZ4 block compression
- *   heatshrink - Heatshrink compression (window=8, lookahead=4)
+ *   lz4-stream - Block-framed LZ4 for cfgpack_pagein_lz4_stream()
+ *   heatshrink - Heatshrink compression (window/lookahead from options)
+ *   best       - Try lz4 at several levels and heatshrink, keep the
+ *                smallest output and name the winner on the last line
+ *
+ * Options:
+ *   --dict <schema>      lz4 only: prime the compressor with the schema's
+ *                        defaults-only pageout (cfgpack_lz4_dict()); load
+ *                        the result with cfgpack_pagein_lz4_dict()
+ *   --level <N>          lz4/lz4-stream: 1 (default) is LZ4's fast
+ *                        compressor, 2-12 a hash-chain search with lazy
+ *                        matching whose depth doubles with each level
+ *   --window <bits>      heatshrink window bits, 4-15
+ *   --lookahead <bits>   heatshrink lookahead bits, 3 to window - 1
+ *
+ * The heatshrink defaults are the HEATSHRINK_STATIC_* values the library
+ * was built with; other values need a device decoder built with the same
+ * ones.  Every output is decoded again and compared with the input before
+ * it is written, and one line of ratio and host throughput is printed per
+ * algorithm tried.  The input is read whole into memory and may be of any
+ * size the output format can describe.
  *
  * Output format:
  *   LZ4:        4-byte little-endian original size + raw compressed data
+ *   LZ4 stream: 4-byte LE original size, 2-byte LE block size, 4-byte LE
+ *               ring size, then per block a 2-byte LE compressed length
+ *               and the compressed block
  *   Heatshrink: raw compressed data only
  *
  * Exit codes:
  *   0 - Success
  *   1 - Usage error
  *   2 - File I/O error
- *   3 - Compression error
+ *   3 - Compression error (or invalid --dict schema)
  */
 
-#include "heatshrink_encoder.h"
+#ifndef _POSIX_C_SOURCE
+  #define _POSIX_C_SOURCE 200809L /* clock_gettime */
+#endif
+
+#include "cfgpack/cfgpack.h"
+
+#include "heatshrink_config.h"
 #include "lz4.h"
 
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+/* lz4-stream: the decoder needs a ring of LZ4S_RING bytes */
+#define LZ4S_BLOCK 1024
+#define LZ4S_RING (4 * LZ4S_BLOCK)
+#define LZ4S_HDR_SIZE 10
+
+/* --dict: schema limits and the dictionary buffer */
+#define MAX_ENTRIES CFGPACK_MAX_ENTRIES
+#define MAX_STR_OFFSETS 256
+#define MAX_DICT_SIZE (64 * 1024)
+
+/* --level range; 1 is LZ4_compress_default() */
+#define LEVEL_MIN 1
+#define LEVEL_MAX 12
+
+/* Heatshrink parameter range accepted by heatshrink_decoder */
+#define HS_WINDOW_MIN 4
+#define HS_WINDOW_MAX 15
+#define HS_LOOKAHEAD_MIN 3
+
+/* Throughput figures repeat a step until it has run this long */
+#define MIN_BENCH_SEC 0.02
 
-#define MAX_INPUT_SIZE (64 * 1024)  /* 64 KB max input */
-#define MAX_OUTPUT_SIZE (64 * 1024) /* 64 KB max output */
+static uint8_t dict_buf[MAX_DICT_SIZE];
+static size_t dict_len;
 
-static uint8_t input_buf[MAX_INPUT_SIZE];
-static uint8_t output_buf[MAX_OUTPUT_SIZE];
+static cfgpack_entry_t entries[MAX_ENTRIES];
+static cfgpack_value_t values[MAX_ENTRIES];
+static char str_pool[MAX_STR_OFFSETS * (CFGPACK_STR_MAX + 1)];
+static cfgpack_str_off_t str_offsets[MAX_STR_OFFSETS];
+static LZ4_stream_t lz4_state;
 
-/* Static heatshrink encoder (uses config from heatshrink_config.h) */
-static heatshrink_encoder hs_encoder;
+typedef enum {
+    ALG_LZ4,
+    ALG_LZ4S,
+    ALG_HS,
+} algorithm_t;
+
+/** @brief One way of compressing the input. */
+typedef struct {
+    algorithm_t alg;
+    int level;           /**< lz4/lz4-stream level */
+    unsigned window;     /**< heatshrink window bits */
+    unsigned lookahead;  /**< heatshrink lookahead bits */
+} method_t;
+
+/** @brief Output file bytes of one method, with its timings. */
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    double comp_mbs;
+    double decomp_mbs;
+} result_t;
 
 static void print_usage(const char *prog) {
-    fprintf(stderr, "Usage: %s <algorithm> <input> <output>\n", prog);
+    fprintf(stderr, "Usage: %s [options] <algorithm> <input> <output>\n",
+            prog);
     fprintf(stderr, "\n");
     fprintf(stderr, "Algorithms:\n");
     fprintf(stderr, "  lz4        - LZ4 block compression\n");
     fprintf(stderr,
-            "  heatshrink - Heatshrink compression (window=8, lookahead=4)\n");
+            "  lz4-stream - Block-framed LZ4 (%d B blocks, %d B ring)\n",
+            LZ4S_BLOCK, LZ4S_RING);
+    fprintf(stderr, "  heatshrink - Heatshrink compression\n");
+    fprintf(stderr, "  best       - Smallest of lz4 (several levels) and "
+                    "heatshrink\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --dict <schema>    lz4 only: compress against the "
+                    "schema's defaults (.map, .json, .msgpack)\n");
+    fprintf(stderr,
+            "  --level <N>        lz4/lz4-stream: %d = fast (default), "
+            "%d-%d = high compression\n",
+            LEVEL_MIN, LEVEL_MIN + 1, LEVEL_MAX);
+    fprintf(stderr,
+            "  --window <bits>    heatshrink window, %d-%d (default %d)\n",
+            HS_WINDOW_MIN, HS_WINDOW_MAX, HEATSHRINK_STATIC_WINDOW_BITS);
+    fprintf(stderr,
+            "  --lookahead <bits> heatshrink lookahead, %d to window - 1 "
+            "(default %d)\n",
+            HS_LOOKAHEAD_MIN, HEATSHRINK_STATIC_LOOKAHEAD_BITS);
     fprintf(stderr, "\n");
     fprintf(stderr, "Output format:\n");
     fprintf(stderr,
             "  LZ4:        4-byte LE original size + compressed data\n");
+    fprintf(stderr, "  LZ4 stream: 10-byte header (size, block, ring) + "
+                    "length-prefixed blocks\n");
     fprintf(stderr, "  Heatshrink: raw compressed data only\n");
 }
 
+static void put_le(uint8_t *p, uint32_t v, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + (double)ts.tv_nsec * 1e-9);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * LZ4 high compression
+ *
+ * A hash-chain match finder over the whole history (dictionary, earlier
+ * blocks and the current block) with lazy matching: a match is deferred
+ * by one byte whenever the next position has a longer one.  The output
+ * is a plain LZ4 block, so the device decoders are unchanged.
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define HC_HASH_LOG 16
+#define HC_MINMATCH 4
+#define HC_MFLIMIT 12     /* last match must start this far from the end */
+#define HC_LASTLITERALS 5 /* the block always ends with literals */
+#define HC_MAX_OFFSET 65535
+
+typedef struct {
+    const uint8_t *src; /**< History followed by the data to compress */
+    size_t len;
+    int32_t *head;      /**< Most recent position per hash */
+    int32_t *prev;      /**< Previous position with the same hash */
+    size_t next;        /**< First position not yet in the chains */
+    unsigned attempts;  /**< Chain entries examined per search */
+} hc_t;
+
+static uint32_t hc_hash(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return ((v * 2654435761u) >> (32 - HC_HASH_LOG));
+}
+
+static int hc_init(hc_t *hc, const uint8_t *src, size_t len, int level) {
+    hc->src = src;
+    hc->len = len;
+    hc->next = 0;
+    hc->attempts = 1u << (level - 1);
+    hc->head = malloc(sizeof(int32_t) << HC_HASH_LOG);
+    hc->prev = malloc(sizeof(int32_t) * (len ? len : 1));
+    if (!hc->head || !hc->prev) {
+        free(hc->head);
+        free(hc->prev);
+        return -1;
+    }
+    memset(hc->head, 0xFF, sizeof(int32_t) << HC_HASH_LOG);
+    return 0;
+}
+
+static void hc_free(hc_t *hc) {
+    free(hc->head);
+    free(hc->prev);
+}
+
+static void hc_insert(hc_t *hc, size_t upto) {
+    while (hc->next < upto) {
+        size_t p = hc->next++;
+        if (p + HC_MINMATCH <= hc->len) {
+            uint32_t h = hc_hash(hc->src + p);
+            hc->prev[p] = hc->head[h];
+            hc->head[h] = (int32_t)p;
+        }
+    }
+}
+
+/* Longest match for ip that starts at or after lowest and ends by limit;
+ * returns 0 when there is none of at least HC_MINMATCH bytes. */
+static size_t
+hc_find(hc_t *hc, size_t ip, size_t lowest, size_t limit, size_t *off) {
+    const uint8_t *s = hc->src;
+    unsigned left = hc->attempts;
+    size_t best = 0;
+    int32_t c;
+
+    hc_insert(hc, ip);
+    if (ip + HC_MINMATCH > limit) {
+        return (0);
+    }
+    for (c = hc->head[hc_hash(s + ip)]; c >= 0 && left > 0;
+         c = hc->prev[c], left--) {
+        size_t cand = (size_t)c;
+        size_t n = 0;
+
+        if (cand < lowest || ip - cand > HC_MAX_OFFSET) {
+            break;
+        }
+        if (s[cand + best] != s[ip + best]) {
+            continue;
+        }
+        while (ip + n < limit && s[cand + n] == s[ip + n]) {
+            n++;
+        }
+        if (n > best) {
+            best = n;
+            *off = ip - cand;
+            if (ip + n == limit) {
+                break;
+            }
+        }
+    }
+    return (best >= HC_MINMATCH ? best : 0);
+}
+
+static size_t hc_put_len(uint8_t *out, size_t op, size_t r) {
+    while (r >= 255) {
+        out[op++] = 255;
+        r -= 255;
+    }
+    out[op++] = (uint8_t)r;
+    return (op);
+}
+
+/* Append one sequence; mlen 0 writes the final literals. */
+static int hc_emit(uint8_t *out,
+                   size_t cap,
+                   size_t *op,
+                   const uint8_t *lit,
+                   size_t nlit,
+                   size_t off,
+                   size_t mlen) {
+    size_t o = *op;
+    size_t tok;
+
+    if (cap - o < 1 + nlit / 255 + 1 + nlit + 2 + mlen / 255 + 1) {
+        return (-1);
+    }
+    tok = o++;
+    out[tok] = (uint8_t)((nlit >= 15 ? 15 : nlit) << 4);
+    if (nlit >= 15) {
+        o = hc_put_len(out, o, nlit - 15);
+    }
+    memcpy(out + o, lit, nlit);
+    o += nlit;
+    if (mlen) {
+        size_t m = mlen - HC_MINMATCH;
+        out[o++] = (uint8_t)off;
+        out[o++] = (uint8_t)(off >> 8);
+        out[tok] |= (uint8_t)(m >= 15 ? 15 : m);
+        if (m >= 15) {
+            o = hc_put_len(out, o, m - 15);
+        }
+    }
+    *op = o;
+    return (0);
+}
+
+/* Compress src[start..end) into one LZ4 block; matches may reach back to
+ * src[lowest].  Returns the block size or -1. */
+static int hc_block(hc_t *hc,
+                    size_t start,
+                    size_t end,
+                    size_t lowest,
+                    uint8_t *out,
+                    size_t cap) {
+    const uint8_t *s = hc->src;
+    size_t limit = end > HC_LASTLITERALS ? end - HC_LASTLITERALS : 0;
+    size_t anchor = start;
+    size_t ip = start;
+    size_t op = 0;
+
+    while (ip + HC_MFLIMIT <= end) {
+        size_t off = 0;
+        size_t len = hc_find(hc, ip, lowest, limit, &off);
+
+        if (!len) {
+            ip++;
+            continue;
+        }
+        while (ip + 1 + HC_MFLIMIT <= end) {
+            size_t off1 = 0;
+            size_t len1 = hc_find(hc, ip + 1, lowest, limit, &off1);
+            if (len1 <= len) {
+                break;
+            }
+            ip++;
+            len = len1;
+            off = off1;
+        }
+        if (hc_emit(out, cap, &op, s + anchor, ip - anchor, off, len) != 0) {
+            return (-1);
+        }
+        ip += len;
+        anchor = ip;
+    }
+    if (hc_emit(out, cap, &op, s + anchor, end - anchor, 0, 0) != 0) {
+        return (-1);
+    }
+    return ((int)op);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * LZ4 block and stream formats
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static size_t lz4_bound(size_t n) {
+    return (4 + (size_t)LZ4_compressBound((int)n));
+}
+
+static size_t lz4s_bound(size_t n) {
+    size_t blocks = (n + LZ4S_BLOCK - 1) / LZ4S_BLOCK;
+    return (LZ4S_HDR_SIZE +
+            blocks * (2 + (size_t)LZ4_compressBound(LZ4S_BLOCK)));
+}
+
 static int compress_lz4(const uint8_t *input,
                         size_t input_len,
+                        int level,
                         uint8_t *output,
                         size_t output_cap,
                         size_t *output_len) {
-    int compressed_size = LZ4_compress_default((const char *)input,
-                                               (char *)output, (int)input_len,
-                                               (int)output_cap);
+    int compressed_size;
+
+    put_le(output, (uint32_t)input_len, 4);
+    if (level > LEVEL_MIN) {
+        /* The dictionary is the history in front of the input */
+        uint8_t *buf = malloc(dict_len + input_len + 1);
+        hc_t hc;
+
+        if (!buf || hc_init(&hc, buf, dict_len + input_len, level) != 0) {
+            free(buf);
+            fprintf(stderr, "Out of memory\n");
+            return -1;
+        }
+        memcpy(buf, dict_buf, dict_len);
+        memcpy(buf + dict_len, input, input_len);
+        compressed_size = hc_block(&hc, dict_len, dict_len + input_len, 0,
+                                   output + 4, output_cap - 4);
+        hc_free(&hc);
+        free(buf);
+    } else if (dict_len > 0) {
+        LZ4_initStream(&lz4_state, sizeof(lz4_state));
+        LZ4_loadDict(&lz4_state, (const char *)dict_buf, (int)dict_len);
+        compressed_size = LZ4_compress_fast_continue(
+            &lz4_state, (const char *)input, (char *)output + 4,
+            (int)input_len, (int)(output_cap - 4), 1);
+    } else {
+        compressed_size = LZ4_compress_default((const char *)input,
+                                               (char *)output + 4,
+                                               (int)input_len,
+                                               (int)(output_cap - 4));
+    }
 
     if (compressed_size <= 0) {
         fprintf(stderr, "LZ4 compression failed\n");
         return -1;
     }
 
-    *output_len = (size_t)compressed_size;
+    *output_len = 4 + (size_t)compressed_size;
+    return 0;
+}
+
+/* Blocks are staged in a ring laid out exactly as the decoder will lay
+ * them out, so later blocks can reference earlier ones in a ring smaller
+ * than 64 KB (LZ4's synchronized ring mode).  The high-compression path
+ * searches the input directly instead, and only references bytes that
+ * are still in the decoder's ring when the block is decoded: the ring
+ * holds the last LZ4S_RING bytes up to the end of the current block. */
+static int compress_lz4_stream(const uint8_t *input,
+                               size_t input_len,
+                               int level,
+                               uint8_t *output,
+                               size_t output_cap,
+                               size_t *output_len) {
+    static uint8_t ring[LZ4S_RING];
+    LZ4_stream_t lz;
+    hc_t hc;
+    size_t out = LZ4S_HDR_SIZE;
+    size_t in = 0;
+    size_t at = 0;
+    int ret = 0;
+
+    if (level > LEVEL_MIN && hc_init(&hc, input, input_len, level) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+    LZ4_initStream(&lz, sizeof(lz));
+    put_le(output, (uint32_t)input_len, 4);
+    put_le(output + 4, LZ4S_BLOCK, 2);
+    put_le(output + 6, LZ4S_RING, 4);
+
+    while (in < input_len) {
+        size_t n = input_len - in;
+        int c;
+
+        if (n > LZ4S_BLOCK) {
+            n = LZ4S_BLOCK;
+        }
+        if (output_cap - out < 2) {
+            fprintf(stderr, "LZ4 stream output too large\n");
+            ret = -1;
+            break;
+        }
+        if (level > LEVEL_MIN) {
+            size_t end = in + n;
+            c = hc_block(&hc, in, end, end > LZ4S_RING ? end - LZ4S_RING : 0,
+                         output + out + 2, output_cap - out - 2);
+        } else {
+            memcpy(ring + at, input + in, n);
+            c = LZ4_compress_fast_continue(&lz, (const char *)ring + at,
+                                           (char *)output + out + 2, (int)n,
+                                           (int)(output_cap - out - 2), 1);
+        }
+        if (c <= 0 || c > 0xFFFF) {
+            fprintf(stderr, "LZ4 stream compression failed\n");
+            ret = -1;
+            break;
+        }
+        put_le(output + out, (uint32_t)c, 2);
+        out += 2 + (size_t)c;
+        in += n;
+        at += n;
+        if (at + LZ4S_BLOCK > LZ4S_RING) {
+            at = 0;
+        }
+    }
+
+    if (level > LEVEL_MIN) {
+        hc_free(&hc);
+    }
+    *output_len = out;
+    return ret;
+}
+
+static int verify_lz4(const uint8_t *data,
+                      size_t len,
+                      uint8_t *scratch,
+                      size_t orig_len) {
+    int n;
+
+    if (dict_len > 0) {
+        n = LZ4_decompress_safe_usingDict(
+            (const char *)data + 4, (char *)scratch, (int)(len - 4),
+            (int)orig_len, (const char *)dict_buf, (int)dict_len);
+    } else {
+        n = LZ4_decompress_safe((const char *)data + 4, (char *)scratch,
+                                (int)(len - 4), (int)orig_len);
+    }
+    return (n == (int)orig_len ? 0 : -1);
+}
+
+/* Decodes block by block into a ring, as cfgpack_pagein_lz4_stream()
+ * does, appending each block to scratch. */
+static int verify_lz4_stream(const uint8_t *data,
+                             size_t len,
+                             uint8_t *scratch,
+                             size_t orig_len) {
+    static uint8_t ring[LZ4S_RING];
+    LZ4_streamDecode_t lz;
+    size_t in = LZ4S_HDR_SIZE;
+    size_t off = 0;
+    size_t at = 0;
+
+    LZ4_setStreamDecode(&lz, NULL, 0);
+    while (off < orig_len) {
+        size_t want = orig_len - off;
+        size_t clen;
+        int n;
+
+        if (want > LZ4S_BLOCK) {
+            want = LZ4S_BLOCK;
+        }
+        if (len - in < 2) {
+            return (-1);
+        }
+        clen = (size_t)data[in] | ((size_t)data[in + 1] << 8);
+        if (clen > len - in - 2) {
+            return (-1);
+        }
+        n = LZ4_decompress_safe_continue(&lz, (const char *)data + in + 2,
+                                         (char *)ring + at, (int)clen,
+                                         (int)want);
+        if (n != (int)want) {
+            return (-1);
+        }
+        memcpy(scratch + off, ring + at, want);
+        in += 2 + clen;
+        off += want;
+        at += want;
+        if (at + LZ4S_BLOCK > LZ4S_RING) {
+            at = 0;
+        }
+    }
+    return (in == len ? 0 : -1);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Heatshrink
+ *
+ * The bitstream is a 1 bit and a literal byte, or a 0 bit, the match
+ * distance minus one in window bits and the match length minus one in
+ * lookahead bits, MSB first.  A backreference costs the same however long
+ * it is, so the cheapest encoding follows from the longest match at each
+ * position alone: a backward pass picks, per position, the literal or the
+ * match prefix that minimizes the bits to the end of the input.  This
+ * beats the library's greedy encoder and works for any window and
+ * lookahead, where the library encoder is fixed at build time.
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+#define HS_ATTEMPTS 1024 /* chain entries examined per position */
+#define HS_LITERAL_BITS 9
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    unsigned cur;
+    unsigned used;
+} hs_bits_t;
+
+static void hs_put(hs_bits_t *b, uint32_t v, unsigned n) {
+    while (n--) {
+        b->cur = (b->cur << 1) | ((v >> n) & 1u);
+        if (++b->used == 8) {
+            b->buf[b->len++] = (uint8_t)b->cur;
+            b->cur = 0;
+            b->used = 0;
+        }
+    }
+}
+
+static size_t hs_bound(size_t n) {
+    return (n + n / 8 + 2);
+}
+
+/* Longest match at every position (mlen/moff), found with chains keyed on
+ * two bytes.  A match at i - 1 minus its first byte is a match at i, so
+ * mlen never drops by more than one between neighbours. */
+static int hs_matches(const uint8_t *in,
+                      size_t n,
+                      unsigned window,
+                      unsigned lookahead,
+                      uint16_t *mlen,
+                      uint16_t *moff) {
+    size_t win = (size_t)1 << window;
+    size_t max = (size_t)1 << lookahead;
+    int one_byte = 1 + window + lookahead < HS_LITERAL_BITS;
+    int32_t *head = malloc(sizeof(int32_t) * 65536);
+    int32_t *prev = malloc(sizeof(int32_t) * (n ? n : 1));
+
+    if (!head || !prev) {
+        free(head);
+        free(prev);
+        return -1;
+    }
+    memset(head, 0xFF, sizeof(int32_t) * 65536);
+
+    for (size_t i = 0; i < n; i++) {
+        size_t lim = n - i < max ? n - i : max;
+        size_t best = 0;
+        size_t off = 0;
+
+        if (i > 0 && mlen[i - 1] > 1) {
+            best = mlen[i - 1] - 1u;
+            off = moff[i - 1];
+        }
+        if (i + 1 < n) {
+            unsigned key = ((unsigned)in[i] << 8) | in[i + 1];
+            unsigned left = HS_ATTEMPTS;
+
+            for (int32_t c = head[key]; c >= 0 && left > 0 && best < lim;
+                 c = prev[c], left--) {
+                size_t cand = (size_t)c;
+                size_t k = 2;
+
+                if (i - cand > win) {
+                    break;
+                }
+                if (in[cand + best] != in[i + best]) {
+                    continue;
+                }
+                while (k < lim && in[cand + k] == in[i + k]) {
+                    k++;
+                }
+                if (k > best) {
+                    best = k;
+                    off = i - cand;
+                }
+            }
+            prev[i] = head[key];
+            head[key] = (int32_t)i;
+        }
+        /* Tiny windows make even a one-byte backreference pay */
+        if (best == 0 && one_byte) {
+            for (size_t d = 1; d <= i && d <= win; d++) {
+                if (in[i - d] == in[i]) {
+                    best = 1;
+                    off = d;
+                    break;
+                }
+            }
+        }
+        mlen[i] = (uint16_t)best;
+        moff[i] = (uint16_t)off;
+    }
+
+    free(head);
+    free(prev);
     return 0;
 }
 
 static int compress_heatshrink(const uint8_t *input,
                                size_t input_len,
+                               unsigned window,
+                               unsigned lookahead,
                                uint8_t *output,
                                size_t output_cap,
                                size_t *output_len) {
-    size_t input_consumed = 0;
-    size_t total_output = 0;
-    size_t sink_count, poll_count;
-    HSE_sink_res sink_res;
-    HSE_poll_res poll_res;
-    HSE_finish_res finish_res;
-
-    heatshrink_encoder_reset(&hs_encoder);
-
-    /* Feed input and poll for output */
-    while (input_consumed < input_len) {
-        sink_res = heatshrink_encoder_sink(&hs_encoder,
-                                           (uint8_t *)(input + input_consumed),
-                                           input_len - input_consumed,
-                                           &sink_count);
-        if (sink_res < 0) {
-            fprintf(stderr, "Heatshrink sink error: %d\n", sink_res);
-            return -1;
+    size_t n = input_len;
+    uint64_t br_bits = 1 + window + lookahead;
+    uint16_t *mlen = malloc(sizeof(uint16_t) * (n ? n : 1));
+    uint16_t *moff = malloc(sizeof(uint16_t) * (n ? n : 1));
+    uint16_t *pick = malloc(sizeof(uint16_t) * (n ? n : 1));
+    uint64_t *cost = malloc(sizeof(uint64_t) * (n + 1));
+    size_t *dq = malloc(sizeof(size_t) * (n + 1));
+    hs_bits_t bits = {output, 0, 0, 0};
+    size_t front = n + 1;
+    size_t back = n + 1;
+    int ret = -1;
+
+    if (!mlen || !moff || !pick || !cost || !dq) {
+        fprintf(stderr, "Out of memory\n");
+        goto done;
+    }
+    if (hs_matches(input, n, window, lookahead, mlen, moff) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        goto done;
+    }
+
+    /* cost[i] = fewest bits encoding input[i..n).  The match choices at i
+     * are the lengths 1..mlen[i], i.e. the window cost[i + 1 .. i + mlen[i]];
+     * both ends only move left as i falls, so a deque whose values rise
+     * from back to front yields the window minimum at its back. */
+    cost[n] = 0;
+    for (size_t i = n; i-- > 0;) {
+        uint64_t lit = HS_LITERAL_BITS + cost[i + 1];
+
+        while (front < back && cost[dq[front]] > cost[i + 1]) {
+            front++;
+        }
+        dq[--front] = i + 1;
+        while (front < back && dq[back - 1] > i + mlen[i]) {
+            back--;
         }
-        input_consumed += sink_count;
-
-        /* Poll for compressed output */
-        do {
-            poll_res = heatshrink_encoder_poll(&hs_encoder,
-                                               output + total_output,
-                                               output_cap - total_output,
-                                               &poll_count);
-            if (poll_res < 0) {
-                fprintf(stderr, "Heatshrink poll error: %d\n", poll_res);
-                return -1;
+        pick[i] = 0;
+        cost[i] = lit;
+        if (mlen[i] > 0 && front < back) {
+            size_t j = dq[back - 1];
+            if (br_bits + cost[j] < lit) {
+                cost[i] = br_bits + cost[j];
+                pick[i] = (uint16_t)(j - i);
             }
-            total_output += poll_count;
+        }
+    }
 
-            if (total_output > output_cap) {
-                fprintf(stderr, "Output buffer overflow\n");
-                return -1;
+    if (output_cap < (cost[0] + 7) / 8) {
+        fprintf(stderr, "Heatshrink output too large\n");
+        goto done;
+    }
+    for (size_t i = 0; i < n;) {
+        if (pick[i] == 0) {
+            hs_put(&bits, 1, 1);
+            hs_put(&bits, input[i], 8);
+            i++;
+        } else {
+            hs_put(&bits, 0, 1);
+            hs_put(&bits, moff[i] - 1u, window);
+            hs_put(&bits, pick[i] - 1u, lookahead);
+            i += pick[i];
+        }
+    }
+    if (bits.used) {
+        output[bits.len++] = (uint8_t)(bits.cur << (8 - bits.used));
+    }
+    *output_len = bits.len;
+    ret = 0;
+
+done:
+    free(mlen);
+    free(moff);
+    free(pick);
+    free(cost);
+    free(dq);
+    return ret;
+}
+
+/* Reference decoder for any window/lookahead; stops where too few bits
+ * remain for another item, as heatshrink_decoder does. */
+static int verify_heatshrink(const uint8_t *data,
+                             size_t len,
+                             unsigned window,
+                             unsigned lookahead,
+                             uint8_t *scratch,
+                             size_t orig_len) {
+    size_t total = len * 8;
+    size_t bit = 0;
+    size_t out = 0;
+
+    for (;;) {
+        uint32_t v = 0;
+        unsigned need;
+
+        if (bit >= total) {
+            break;
+        }
+        if ((data[bit / 8] >> (7 - bit % 8)) & 1u) {
+            need = HS_LITERAL_BITS;
+        } else {
+            need = 1 + window + lookahead;
+        }
+        if (total - bit < need) {
+            break;
+        }
+        for (unsigned k = 0; k < need; k++, bit++) {
+            v = (v << 1) | ((data[bit / 8] >> (7 - bit % 8)) & 1u);
+        }
+        if (need == HS_LITERAL_BITS) {
+            if (out == orig_len) {
+                return (-1);
             }
-        } while (poll_res == HSER_POLL_MORE);
+            scratch[out++] = (uint8_t)v;
+        } else {
+            size_t count = (v & ((1u << lookahead) - 1)) + 1;
+            size_t dist = (v >> lookahead) + 1;
+            if (dist > out || count > orig_len - out) {
+                return (-1);
+            }
+            for (size_t k = 0; k < count; k++, out++) {
+                scratch[out] = scratch[out - dist];
+            }
+        }
     }
+    return (out == orig_len ? 0 : -1);
+}
 
-    /* Finish encoding */
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Running a method
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static void method_name(const method_t *m, char *buf, size_t cap) {
+    switch (m->alg) {
+    case ALG_LZ4:
+        snprintf(buf, cap, "lz4 level %d", m->level);
+        break;
+    case ALG_LZ4S:
+        snprintf(buf, cap, "lz4-stream level %d", m->level);
+        break;
+    default:
+        snprintf(buf, cap, "heatshrink window %u lookahead %u", m->window,
+                 m->lookahead);
+        break;
+    }
+}
+
+static int run_compress(const method_t *m,
+                        const uint8_t *input,
+                        size_t input_len,
+                        uint8_t *output,
+                        size_t cap,
+                        size_t *len) {
+    switch (m->alg) {
+    case ALG_LZ4:
+        return compress_lz4(input, input_len, m->level, output, cap, len);
+    case ALG_LZ4S:
+        return compress_lz4_stream(input, input_len, m->level, output, cap,
+                                   len);
+    default:
+        return compress_heatshrink(input, input_len, m->window,
+                                   m->lookahead, output, cap, len);
+    }
+}
+
+static int run_verify(const method_t *m,
+                      const uint8_t *data,
+                      size_t len,
+                      uint8_t *scratch,
+                      size_t orig_len) {
+    switch (m->alg) {
+    case ALG_LZ4:
+        return verify_lz4(data, len, scratch, orig_len);
+    case ALG_LZ4S:
+        return verify_lz4_stream(data, len, scratch, orig_len);
+    default:
+        return verify_heatshrink(data, len, m->window, m->lookahead, scratch,
+                                 orig_len);
+    }
+}
+
+/* Compress, check the round trip and time both directions. */
+static int run_method(const method_t *m,
+                      const uint8_t *input,
+                      size_t input_len,
+                      result_t *r) {
+    size_t cap;
+    uint8_t *scratch;
+    double t0, dt;
+    unsigned reps;
+
+    cap = m->alg == ALG_LZ4    ? lz4_bound(input_len)
+          : m->alg == ALG_LZ4S ? lz4s_bound(input_len)
+                               : hs_bound(input_len);
+    r->data = malloc(cap);
+    scratch = malloc(input_len ? input_len : 1);
+    if (!r->data || !scratch) {
+        fprintf(stderr, "Out of memory\n");
+        free(r->data);
+        free(scratch);
+        r->data = NULL;
+        return 3;
+    }
+
+    t0 = now_sec();
+    reps = 0;
     do {
-        finish_res = heatshrink_encoder_finish(&hs_encoder);
-        if (finish_res < 0) {
-            fprintf(stderr, "Heatshrink finish error: %d\n", finish_res);
-            return -1;
+        if (run_compress(m, input, input_len, r->data, cap, &r->len) != 0) {
+            free(scratch);
+            return 3;
         }
+        reps++;
+        dt = now_sec() - t0;
+    } while (dt < MIN_BENCH_SEC);
+    r->comp_mbs = (double)input_len * reps / dt / 1e6;
 
-        /* Poll remaining output */
-        do {
-            poll_res = heatshrink_encoder_poll(&hs_encoder,
-                                               output + total_output,
-                                               output_cap - total_output,
-                                               &poll_count);
-            if (poll_res < 0) {
-                fprintf(stderr, "Heatshrink poll error: %d\n", poll_res);
-                return -1;
-            }
-            total_output += poll_count;
+    t0 = now_sec();
+    reps = 0;
+    do {
+        if (run_verify(m, r->data, r->len, scratch, input_len) != 0 ||
+            memcmp(scratch, input, input_len) != 0) {
+            char name[64];
+            method_name(m, name, sizeof(name));
+            fprintf(stderr, "%s: round trip check failed\n", name);
+            free(scratch);
+            return 3;
+        }
+        reps++;
+        dt = now_sec() - t0;
+    } while (dt < MIN_BENCH_SEC);
+    r->decomp_mbs = (double)input_len * reps / dt / 1e6;
 
-            if (total_output > output_cap) {
-                fprintf(stderr, "Output buffer overflow\n");
-                return -1;
-            }
-        } while (poll_res == HSER_POLL_MORE);
-    } while (finish_res == HSER_FINISH_MORE);
+    free(scratch);
+    return 0;
+}
+
+static void print_result(const method_t *m,
+                         const result_t *r,
+                         size_t input_len) {
+    char name[64];
+
+    method_name(m, name, sizeof(name));
+    printf("%s: %zu -> %zu bytes (%.1f%%), %.1f MB/s compress, "
+           "%.1f MB/s decompress\n",
+           name, input_len, r->len,
+           input_len > 0 ? (100.0 * r->len / input_len) : 0.0, r->comp_mbs,
+           r->decomp_mbs);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Files
+ * ───────────────────────────────────────────────────────────────────────────── */
 
-    *output_len = total_output;
+/* Read a whole file of any size into a malloc'd buffer. */
+static int read_file(const char *path, uint8_t **buf, size_t *len) {
+    size_t cap = 64 * 1024;
+    size_t n = 0;
+    uint8_t *p = malloc(cap);
+    FILE *f;
+
+    if (!p) {
+        fprintf(stderr, "Out of memory\n");
+        return 2;
+    }
+    f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open input file: %s\n", path);
+        free(p);
+        return 2;
+    }
+    for (;;) {
+        n += fread(p + n, 1, cap - n, f);
+        if (n < cap) {
+            break;
+        }
+        uint8_t *q = cap <= SIZE_MAX / 2 ? realloc(p, cap * 2) : NULL;
+        if (!q) {
+            fprintf(stderr, "Input file too large: %s\n", path);
+            fclose(f);
+            free(p);
+            return 2;
+        }
+        p = q;
+        cap *= 2;
+    }
+    if (ferror(f)) {
+        fprintf(stderr, "Error reading input file: %s\n", path);
+        fclose(f);
+        free(p);
+        return 2;
+    }
+    fclose(f);
+    *buf = p;
+    *len = n;
+    return 0;
+}
+
+static int has_suffix(const char *str, const char *suffix) {
+    size_t str_len = strlen(str);
+    size_t suf_len = strlen(suffix);
+    if (suf_len > str_len) {
+        return 0;
+    }
+    return strcmp(str + str_len - suf_len, suffix) == 0;
+}
+
+/* Parse the schema, init a context holding only its defaults and take its
+ * dictionary, exactly as the device does after boot. */
+static int load_dict(const char *path) {
+    cfgpack_parse_error_t perr;
+    cfgpack_parse_opts_t opts;
+    cfgpack_schema_t schema;
+    cfgpack_ctx_t ctx;
+    cfgpack_err_t rc;
+    uint8_t *schema_text;
+    size_t len;
+    int ret;
+
+    ret = read_file(path, &schema_text, &len);
+    if (ret != 0) {
+        return ret;
+    }
+
+    memset(&perr, 0, sizeof(perr));
+    memset(&opts, 0, sizeof(opts));
+    opts.out_schema = &schema;
+    opts.entries = entries;
+    opts.max_entries = MAX_ENTRIES;
+    opts.values = values;
+    opts.str_pool = str_pool;
+    opts.str_pool_cap = sizeof(str_pool);
+    opts.str_offsets = str_offsets;
+    opts.str_offsets_count = MAX_STR_OFFSETS;
+    opts.err = &perr;
+
+    if (has_suffix(path, ".json")) {
+        rc = cfgpack_schema_parse_json((const char *)schema_text, len, &opts);
+    } else if (has_suffix(path, ".msgpack") || has_suffix(path, ".bin")) {
+        rc = cfgpack_schema_parse_msgpack(schema_text, len, &opts);
+    } else {
+        rc = cfgpack_parse_schema((const char *)schema_text, len, &opts);
+    }
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_init(&ctx, &schema, values, schema.entry_count, str_pool,
+                          sizeof(str_pool), str_offsets, MAX_STR_OFFSETS);
+    }
+    if (rc == CFGPACK_OK) {
+        rc = cfgpack_lz4_dict(&ctx, dict_buf, sizeof(dict_buf), &dict_len);
+    }
+    free(schema_text);
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "Cannot build dictionary from %s: %s (%d)\n", path,
+                perr.message[0] ? perr.message : "schema error", (int)rc);
+        return 3;
+    }
+    return 0;
+}
+
+static int parse_uint(const char *s, int lo, int hi, int *out) {
+    char *end;
+    long v = strtol(s, &end, 10);
+    if (*s == '\0' || *end != '\0' || v < lo || v > hi) {
+        return -1;
+    }
+    *out = (int)v;
     return 0;
 }
 
 int main(int argc, char *argv[]) {
-    FILE *fin = NULL;
-    FILE *fout = NULL;
-    size_t input_len, output_len;
+    static const int best_levels[] = {1, 4, 9, LEVEL_MAX};
+    method_t methods[sizeof(best_levels) / sizeof(best_levels[0]) + 1];
+    size_t method_count = 0;
+    result_t results[sizeof(methods) / sizeof(methods[0])];
+    size_t winner = 0;
+    uint8_t *input = NULL;
+    size_t input_len;
+    FILE *fout;
     int ret = 0;
-    int is_lz4;
+    int level = 0;
+    int window = 0;
+    int lookahead = 0;
+    int i = 1;
 
-    if (argc != 4) {
-        print_usage(argv[0]);
+    const char *prog = argv[0];
+    const char *dict_path = NULL;
+
+    for (; i < argc && strncmp(argv[i], "--", 2) == 0; i += 2) {
+        if (i + 1 >= argc) {
+            print_usage(prog);
+            return 1;
+        }
+        if (strcmp(argv[i], "--dict") == 0) {
+            dict_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--level") == 0) {
+            if (parse_uint(argv[i + 1], LEVEL_MIN, LEVEL_MAX, &level) != 0) {
+                fprintf(stderr, "--level must be %d-%d\n", LEVEL_MIN,
+                        LEVEL_MAX);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--window") == 0) {
+            if (parse_uint(argv[i + 1], HS_WINDOW_MIN, HS_WINDOW_MAX,
+                           &window) != 0) {
+                fprintf(stderr, "--window must be %d-%d\n", HS_WINDOW_MIN,
+                        HS_WINDOW_MAX);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--lookahead") == 0) {
+            if (parse_uint(argv[i + 1], HS_LOOKAHEAD_MIN, HS_WINDOW_MAX - 1,
+                           &lookahead) != 0) {
+                fprintf(stderr, "--lookahead must be %d-%d\n",
+                        HS_LOOKAHEAD_MIN, HS_WINDOW_MAX - 1);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(prog);
+            return 1;
+        }
+    }
+    if (argc - i != 3) {
+        print_usage(prog);
         return 1;
     }
 
-    const char *algorithm = argv[1];
-    const char *input_path = argv[2];
-    const char *output_path = argv[3];
+    const char *algorithm = argv[i];
+    const char *input_path = argv[i + 1];
+    const char *output_path = argv[i + 2];
+    int is_best = strcmp(algorithm, "best") == 0;
+    int is_hs = strcmp(algorithm, "heatshrink") == 0;
+    method_t m;
+
+    memset(&m, 0, sizeof(m));
+    m.level = level ? level : LEVEL_MIN;
+    m.window = window ? (unsigned)window : HEATSHRINK_STATIC_WINDOW_BITS;
+    m.lookahead = lookahead ? (unsigned)lookahead
+                            : HEATSHRINK_STATIC_LOOKAHEAD_BITS;
 
-    /* Validate algorithm */
+    /* Validate algorithm and options */
     if (strcmp(algorithm, "lz4") == 0) {
-        is_lz4 = 1;
-    } else if (strcmp(algorithm, "heatshrink") == 0) {
-        is_lz4 = 0;
+        m.alg = ALG_LZ4;
+    } else if (strcmp(algorithm, "lz4-stream") == 0) {
+        m.alg = ALG_LZ4S;
+    } else if (is_hs || is_best) {
+        m.alg = ALG_HS;
     } else {
         fprintf(stderr, "Unknown algorithm: %s\n", algorithm);
-        print_usage(argv[0]);
+        print_usage(prog);
         return 1;
     }
-
-    /* Read input file */
-    fin = fopen(input_path, "rb");
-    if (!fin) {
-        fprintf(stderr, "Cannot open input file: %s\n", input_path);
-        return 2;
+    if (dict_path && m.alg != ALG_LZ4) {
+        fprintf(stderr, "--dict is only supported with lz4\n");
+        return 1;
     }
-
-    input_len = fread(input_buf, 1, MAX_INPUT_SIZE, fin);
-    if (ferror(fin)) {
-        fprintf(stderr, "Error reading input file\n");
-        fclose(fin);
-        return 2;
+    if (level && (is_hs || is_best)) {
+        fprintf(stderr, "--level is only supported with lz4 and "
+                        "lz4-stream\n");
+        return 1;
     }
-    if (!feof(fin)) {
-        fprintf(stderr, "Input file too large (max %d bytes)\n",
-                MAX_INPUT_SIZE);
-        fclose(fin);
-        return 2;
+    if ((window || lookahead) && !is_hs && !is_best) {
+        fprintf(stderr, "--window and --lookahead are only supported with "
+                        "heatshrink and best\n");
+        return 1;
     }
-    fclose(fin);
-    fin = NULL;
-
-    /* Compress */
-    if (is_lz4) {
-        ret = compress_lz4(input_buf, input_len, output_buf, MAX_OUTPUT_SIZE,
-                           &output_len);
-    } else {
-        ret = compress_heatshrink(input_buf, input_len, output_buf,
-                                  MAX_OUTPUT_SIZE, &output_len);
+    if (m.alg == ALG_HS && m.lookahead >= m.window) {
+        fprintf(stderr, "--lookahead must be less than --window (%u)\n",
+                m.window);
+        return 1;
+    }
+    if (dict_path) {
+        ret = load_dict(dict_path);
+        if (ret != 0) {
+            return ret;
+        }
     }
 
+    /* Read input file */
+    ret = read_file(input_path, &input, &input_len);
     if (ret != 0) {
-        return 3;
+        return ret;
     }
-
-    /* Write output file */
-    fout = fopen(output_path, "wb");
-    if (!fout) {
-        fprintf(stderr, "Cannot open output file: %s\n", output_path);
+    if (input_len > (m.alg == ALG_HS && !is_best ? (size_t)INT32_MAX
+                                                 : LZ4_MAX_INPUT_SIZE)) {
+        fprintf(stderr, "Input file too large: %s\n", input_path);
+        free(input);
         return 2;
     }
 
-    /* LZ4: prepend 4-byte little-endian original size header */
-    if (is_lz4) {
-        uint8_t hdr[4];
-        hdr[0] = (uint8_t)(input_len & 0xFF);
-        hdr[1] = (uint8_t)((input_len >> 8) & 0xFF);
-        hdr[2] = (uint8_t)((input_len >> 16) & 0xFF);
-        hdr[3] = (uint8_t)((input_len >> 24) & 0xFF);
-        if (fwrite(hdr, 1, 4, fout) != 4) {
-            fprintf(stderr, "Error writing LZ4 header\n");
-            fclose(fout);
-            return 2;
+    if (is_best) {
+        for (size_t k = 0; k < sizeof(best_levels) / sizeof(best_levels[0]);
+             k++) {
+            methods[method_count] = m;
+            methods[method_count].alg = ALG_LZ4;
+            methods[method_count].level = best_levels[k];
+            method_count++;
         }
     }
+    methods[method_count++] = m;
 
-    if (fwrite(output_buf, 1, output_len, fout) != output_len) {
-        fprintf(stderr, "Error writing output file\n");
-        fclose(fout);
-        return 2;
+    /* Compress with every method, keeping the smallest */
+    memset(results, 0, sizeof(results));
+    for (size_t k = 0; k < method_count; k++) {
+        ret = run_method(&methods[k], input, input_len, &results[k]);
+        if (ret != 0) {
+            break;
+        }
+        print_result(&methods[k], &results[k], input_len);
+        if (results[k].len < results[winner].len) {
+            winner = k;
+        }
     }
-    fclose(fout);
 
-    /* Print stats */
-    size_t file_size = is_lz4 ? output_len + 4 : output_len;
-    printf("%s: %zu -> %zu bytes (%.1f%%)\n", algorithm, input_len, file_size,
-           input_len > 0 ? (100.0 * file_size / input_len) : 0.0);
+    /* Write output file */
+    if (ret == 0) {
+        fout = fopen(output_path, "wb");
+        if (!fout) {
+            fprintf(stderr, "Cannot open output file: %s\n", output_path);
+            ret = 2;
+        } else {
+            if (fwrite(results[winner].data, 1, results[winner].len, fout) !=
+                results[winner].len) {
+                fprintf(stderr, "Error writing output file\n");
+                ret = 2;
+            }
+            if (fclose(fout) != 0 && ret == 0) {
+                fprintf(stderr, "Error writing output file\n");
+                ret = 2;
+            }
+        }
+    }
+    if (ret == 0 && is_best) {
+        char name[64];
+        method_name(&methods[winner], name, sizeof(name));
+        printf("best: %s\n", name);
+    }
+    if (ret == 0 && methods[winner].alg == ALG_HS &&
+        (m.window != HEATSHRINK_STATIC_WINDOW_BITS ||
+         m.lookahead != HEATSHRINK_STATIC_LOOKAHEAD_BITS)) {
+        printf("note: decode with HEATSHRINK_STATIC_WINDOW_BITS=%u and "
+               "HEATSHRINK_STATIC_LOOKAHEAD_BITS=%u\n",
+               m.window, m.lookahead);
+    }
 
-    return 0;
+    for (size_t k = 0; k < method_count; k++) {
+        free(results[k].data);
+    }
+    free(input);
+    return ret;
 }
@@ -0,0 +1,502 @@
+/**
+ * @file cfgpack-config-pack.c
+ * @brief CLI tool for compiling per-device JSON values into config blobs.
+ *
+ * Usage:
+ *   cfgpack-config-pack --schema FILE [options] <values> <output>
+ *   cfgpack-config-pack --schema FILE [options] --manifest FILE
+ *   cfgpack-config-pack --schema FILE [options] --out-dir DIR <values>...
+ *
+ * The schema (.map, .json, or .msgpack/.bin) is parsed once into a
+ * prototype context.  Each values file is a JSON object keyed by entry
+ * name, in the format of cfgpack_values_write_json(); entries it leaves
+ * out keep their schema defaults.  Every unit gets a fresh context from
+ * the prototype (cfgpack_init_shared()), takes its values through
+ * cfgpack_values_parse_json() and is written with cfgpack_pageout(), so
+ * the output is byte-for-byte the blob the device would save itself.
+ *
+ * With --compress the blob goes through the library's pageout wrappers
+ * instead, in the cfgpack-compress formats:
+ *   lz4        - cfgpack_pageout_lz4(); load with cfgpack_pagein_lz4()
+ *   lz4-dict   - cfgpack_pageout_lz4_dict() against the schema's
+ *                cfgpack_lz4_dict(); load with cfgpack_pagein_lz4_dict()
+ *   heatshrink - cfgpack_pageout_heatshrink(); load with
+ *                cfgpack_pagein_heatshrink()
+ *
+ * Many units can be compiled in one run: a --manifest lists one
+ * "<values> <output>" pair per line, and --out-dir writes each input to
+ * DIR/<input basename><ext> (.bin, .lz4, .lz4d or .hs).  Jobs run on -j
+ * worker threads (one per CPU by default).  With --cache, an output is
+ * left alone when the schema, mode and values match the last run and the
+ * output file still holds what that run wrote.
+ *
+ * Exit codes (the highest over all inputs):
+ *   0 - Success
+ *   1 - Usage error
+ *   2 - File I/O error
+ *   3 - Schema, values or encode error
+ */
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/compress.h"
+
+#include "batch.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_INPUT_SIZE (64 * 1024)  /* 64 KB max schema or values file */
+#define MAX_OUTPUT_SIZE (64 * 1024) /* 64 KB max blob */
+#define MAX_ENTRIES CFGPACK_MAX_ENTRIES
+#define MAX_STR_OFFSETS 256
+#define MAX_STR_POOL (MAX_STR_OFFSETS * (CFGPACK_STR_MAX + 1))
+#define MAX_DICT_SIZE (64 * 1024)
+#define MAX_PATH_LEN 4096
+
+typedef enum {
+    PACK_RAW,
+    PACK_LZ4,
+    PACK_LZ4_DICT,
+    PACK_HEATSHRINK,
+} pack_mode_t;
+
+/* --out-dir extension per mode */
+static const char *const mode_ext[] = {".bin", ".lz4", ".lz4d", ".hs"};
+
+/** Per-worker buffers and encoder state, reused for every unit. */
+typedef struct {
+    char input[MAX_INPUT_SIZE];
+    uint8_t blob[MAX_OUTPUT_SIZE];
+    uint8_t output_buf[CFGPACK_LZ4_PAGEOUT_BOUND(MAX_OUTPUT_SIZE)];
+    uint8_t existing[CFGPACK_LZ4_PAGEOUT_BOUND(MAX_OUTPUT_SIZE)];
+    cfgpack_value_t values[MAX_ENTRIES];
+    char str_pool[MAX_STR_POOL];
+    cfgpack_str_off_t str_offsets[MAX_STR_OFFSETS];
+    LZ4_stream_t lz4;
+    heatshrink_encoder hse;
+} workspace_t;
+
+/** The parsed schema and options shared (read-only) by every unit. */
+typedef struct {
+    cfgpack_ctx_t proto;
+    size_t str_pool_size;
+    size_t str_count;
+    pack_mode_t mode;
+    uint64_t schema_hash;
+    int use_cache;
+} pack_opts_t;
+
+static char schema_text[MAX_INPUT_SIZE];
+static cfgpack_schema_t schema;
+static cfgpack_entry_t entries[MAX_ENTRIES];
+static cfgpack_value_t proto_values[MAX_ENTRIES];
+static char proto_pool[MAX_STR_POOL];
+static cfgpack_str_off_t proto_offsets[MAX_STR_OFFSETS];
+static uint8_t dict_buf[MAX_DICT_SIZE];
+static size_t dict_len;
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s --schema FILE [options] <values> <output>\n"
+            "       %s --schema FILE [options] --manifest FILE\n"
+            "       %s --schema FILE [options] --out-dir DIR <values>...\n",
+            prog, prog, prog);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Compiles JSON value files into cfgpack_pageout() "
+                    "blobs.\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --schema F   Schema (.map, .json, .msgpack/.bin), "
+                    "parsed once\n");
+    fprintf(stderr, "  --compress A Compress with lz4, lz4-dict or "
+                    "heatshrink\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Batch options:\n");
+    fprintf(stderr, "  --manifest F Compile each \"<values> <output>\" "
+                    "line of F\n");
+    fprintf(stderr, "  --out-dir D  Write each input to D/<name>.bin "
+                    "(.lz4, .lz4d, .hs)\n");
+    fprintf(stderr, "  -j N         Worker threads (default: one per "
+                    "CPU)\n");
+    fprintf(stderr, "  --cache F    Skip outputs left up to date by the "
+                    "run recorded in F\n");
+}
+
+static int has_suffix(const char *str, const char *suffix) {
+    size_t str_len = strlen(str);
+    size_t suf_len = strlen(suffix);
+    if (suf_len > str_len) {
+        return 0;
+    }
+    return strcmp(str + str_len - suf_len, suffix) == 0;
+}
+
+/* Parse the schema and initialize the prototype every unit starts from. */
+static int load_schema(const char *path, pack_opts_t *po) {
+    cfgpack_schema_measure_t m;
+    cfgpack_parse_error_t perr;
+    cfgpack_err_t rc;
+    size_t len = 0;
+    int is_json = has_suffix(path, ".json");
+    int is_msgpack = has_suffix(path, ".msgpack") || has_suffix(path, ".bin");
+
+    memset(&perr, 0, sizeof(perr));
+    if (batch_read_file(path, (uint8_t *)schema_text, sizeof(schema_text),
+                        &len, stderr) != 0) {
+        return 2;
+    }
+    po->schema_hash = batch_hash(BATCH_HASH_INIT, schema_text, len);
+
+    if (is_json) {
+        rc = cfgpack_schema_measure_json(schema_text, len, &m, &perr);
+    } else if (is_msgpack) {
+        rc = cfgpack_schema_measure_msgpack((const uint8_t *)schema_text,
+                                            len, &m, &perr);
+    } else {
+        rc = cfgpack_schema_measure(schema_text, len, &m, &perr);
+    }
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "%s: schema measure failed: %s\n", path,
+                perr.message);
+        return 3;
+    }
+    if (m.entry_count > MAX_ENTRIES ||
+        m.str_count + m.fstr_count > MAX_STR_OFFSETS ||
+        m.str_pool_size > MAX_STR_POOL) {
+        fprintf(stderr, "%s: schema too large (%zu entries, max %d)\n", path,
+                m.entry_count, MAX_ENTRIES);
+        return 3;
+    }
+    po->str_pool_size = m.str_pool_size;
+    po->str_count = m.str_count + m.fstr_count;
+
+    cfgpack_parse_opts_t opts = {
+        .out_schema = &schema,
+        .entries = entries,
+        .max_entries = m.entry_count,
+        .values = proto_values,
+        .str_pool = proto_pool,
+        .str_pool_cap = m.str_pool_size,
+        .str_offsets = proto_offsets,
+        .str_offsets_count = po->str_count,
+        .err = &perr,
+    };
+
+    if (is_json) {
+        rc = cfgpack_schema_parse_json(schema_text, len, &opts);
+    } else if (is_msgpack) {
+        rc = cfgpack_schema_parse_msgpack((const uint8_t *)schema_text, len,
+                                          &opts);
+    } else {
+        rc = cfgpack_parse_schema(schema_text, len, &opts);
+    }
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "%s: schema parse failed: %s\n", path, perr.message);
+        return 3;
+    }
+    rc = cfgpack_init(&po->proto, &schema, proto_values, schema.entry_count,
+                      proto_pool, m.str_pool_size, proto_offsets,
+                      po->str_count);
+    if (rc == CFGPACK_OK && po->mode == PACK_LZ4_DICT) {
+        rc = cfgpack_lz4_dict(&po->proto, dict_buf, sizeof(dict_buf),
+                              &dict_len);
+    }
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "%s: schema init failed (error %d)\n", path, rc);
+        return 3;
+    }
+    return 0;
+}
+
+/* Hash of the file at @p path, or 0 if it cannot be read in full. */
+static uint64_t hash_existing(workspace_t *ws, const char *path) {
+    size_t len = 0;
+    FILE *f;
+
+    f = fopen(path, "rb");
+    if (!f) {
+        return (0);
+    }
+    len = fread(ws->existing, 1, sizeof(ws->existing), f);
+    if (ferror(f) || fgetc(f) != EOF) {
+        fclose(f);
+        return (0);
+    }
+    fclose(f);
+    return (batch_hash(BATCH_HASH_INIT, ws->existing, len));
+}
+
+/* batch_fn: set one unit's values on a fresh context and write its blob. */
+static int pack_job(void *arg,
+                    const batch_job_t *job,
+                    void *user,
+                    FILE *out,
+                    FILE *err) {
+    const pack_opts_t *po = user;
+    workspace_t *ws = arg;
+    const char *input_path = job->in;
+    const char *output_path = job->out;
+    FILE *fout = NULL;
+    cfgpack_parse_error_t perr;
+    cfgpack_ctx_t ctx;
+    cfgpack_err_t rc;
+    uint64_t key = po->schema_hash;
+    uint64_t cached_key;
+    uint64_t cached_out;
+    uint8_t mode;
+    size_t in_len = 0;
+    size_t blob_len = 0;
+    size_t out_len = 0;
+    const uint8_t *data;
+
+    memset(&perr, 0, sizeof(perr));
+    if (batch_read_file(input_path, (uint8_t *)ws->input, sizeof(ws->input),
+                        &in_len, err) != 0) {
+        return 2;
+    }
+
+    /* The output depends on the schema, the mode and the values alone. */
+    mode = (uint8_t)po->mode;
+    key = batch_hash(batch_hash(key, &mode, 1), ws->input, in_len);
+    if (po->use_cache && batch_cache_get(output_path, &cached_key,
+                                         &cached_out) &&
+        cached_key == key && hash_existing(ws, output_path) == cached_out) {
+        fprintf(out, "Up to date: %s\n", output_path);
+        return 0;
+    }
+
+    /* Phase 1: fresh context holding the schema defaults */
+    rc = cfgpack_init_shared(&ctx, &po->proto, ws->values, MAX_ENTRIES,
+                             ws->str_pool, po->str_pool_size,
+                             ws->str_offsets, po->str_count);
+    if (rc != CFGPACK_OK) {
+        fprintf(err, "Init failed (error %d)\n", rc);
+        return 3;
+    }
+
+    /* Phase 2: apply the unit's values */
+    rc = cfgpack_values_parse_json(&ctx, ws->input, in_len, &perr);
+    if (rc != CFGPACK_OK) {
+        if (perr.line > 0) {
+            fprintf(err, "Values rejected (line %zu): %s\n", perr.line,
+                    perr.message);
+        } else {
+            fprintf(err, "Values rejected: %s (error %d)\n",
+                    perr.message[0] ? perr.message : "invalid value", rc);
+        }
+        return 3;
+    }
+
+    /* Phase 3: pageout, compressed if asked */
+    switch (po->mode) {
+    case PACK_LZ4:
+        rc = cfgpack_pageout_lz4(&ctx, ws->output_buf, sizeof(ws->output_buf),
+                                 &out_len, &ws->lz4, ws->blob,
+                                 sizeof(ws->blob));
+        data = ws->output_buf;
+        break;
+    case PACK_LZ4_DICT:
+        rc = cfgpack_pageout_lz4_dict(&ctx, ws->output_buf,
+                                      sizeof(ws->output_buf), &out_len,
+                                      &ws->lz4, dict_buf, dict_len, ws->blob,
+                                      sizeof(ws->blob));
+        data = ws->output_buf;
+        break;
+    case PACK_HEATSHRINK:
+        rc = cfgpack_pageout_heatshrink(&ctx, ws->output_buf,
+                                        sizeof(ws->output_buf), &out_len,
+                                        &ws->hse, ws->blob, sizeof(ws->blob));
+        data = ws->output_buf;
+        break;
+    default:
+        rc = cfgpack_pageout(&ctx, ws->blob, sizeof(ws->blob), &out_len);
+        data = ws->blob;
+        break;
+    }
+    if (rc != CFGPACK_OK) {
+        fprintf(err, "Pageout failed (error %d)\n", rc);
+        return 3;
+    }
+    if (po->mode != PACK_RAW) {
+        rc = cfgpack_pageout_measure(&ctx, &blob_len);
+        if (rc != CFGPACK_OK) {
+            blob_len = 0;
+        }
+    }
+
+    /* Phase 4: write output file */
+    fout = fopen(output_path, "wb");
+    if (!fout) {
+        fprintf(err, "Cannot open output file: %s\n", output_path);
+        return 2;
+    }
+
+    if (fwrite(data, 1, out_len, fout) != out_len) {
+        fprintf(err, "Error writing output file\n");
+        fclose(fout);
+        return 2;
+    }
+    if (fclose(fout) != 0) {
+        fprintf(err, "Error writing output file\n");
+        return 2;
+    }
+    if (po->use_cache) {
+        batch_cache_put(output_path, key,
+                        batch_hash(BATCH_HASH_INIT, data, out_len));
+    }
+
+    /* Print stats */
+    if (po->mode == PACK_RAW) {
+        fprintf(out, "Output: %zu bytes -> %s\n", out_len, output_path);
+    } else {
+        fprintf(out, "Output: %zu bytes (%zu uncompressed) -> %s\n", out_len,
+                blob_len, output_path);
+    }
+
+    return 0;
+}
+
+/* DIR/<basename of input without extension><ext> */
+static int out_dir_path(char *buf,
+                        size_t cap,
+                        const char *dir,
+                        const char *input,
+                        const char *ext) {
+    const char *base = strrchr(input, '/');
+    const char *dot;
+    size_t stem;
+    int n;
+
+    base = base ? base + 1 : input;
+    dot = strrchr(base, '.');
+    stem = (dot && dot != base) ? (size_t)(dot - base) : strlen(base);
+    n = snprintf(buf, cap, "%s/%.*s%s", dir, (int)stem, base, ext);
+    return (n > 0 && (size_t)n < cap) ? 0 : -1;
+}
+
+static int parse_mode(const char *name, pack_mode_t *mode) {
+    if (strcmp(name, "lz4") == 0) {
+        *mode = PACK_LZ4;
+    } else if (strcmp(name, "lz4-dict") == 0) {
+        *mode = PACK_LZ4_DICT;
+    } else if (strcmp(name, "heatshrink") == 0) {
+        *mode = PACK_HEATSHRINK;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static pack_opts_t po;
+    batch_list_t list = {NULL, 0, 0};
+    const char *positional[2] = {NULL, NULL};
+    const char *schema_path = NULL;
+    const char *manifest = NULL;
+    const char *out_dir = NULL;
+    const char *cache_path = NULL;
+    char path[MAX_PATH_LEN];
+    unsigned threads = 0;
+    size_t n_pos = 0;
+    int rc = 0;
+    int i;
+
+    po.mode = PACK_RAW;
+    for (i = 1; i < argc && rc == 0; i++) {
+        if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--schema") == 0 ||
+            strcmp(argv[i], "--compress") == 0 ||
+            strcmp(argv[i], "--manifest") == 0 ||
+            strcmp(argv[i], "--out-dir") == 0 ||
+            strcmp(argv[i], "--cache") == 0) {
+            const char *opt = argv[i];
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires an argument\n", opt);
+                rc = 1;
+                break;
+            }
+            i++;
+            if (strcmp(opt, "-j") == 0) {
+                threads = (unsigned)strtoul(argv[i], NULL, 10);
+            } else if (strcmp(opt, "--schema") == 0) {
+                schema_path = argv[i];
+            } else if (strcmp(opt, "--compress") == 0) {
+                if (parse_mode(argv[i], &po.mode) != 0) {
+                    fprintf(stderr, "Unknown compression: %s\n", argv[i]);
+                    rc = 1;
+                }
+            } else if (strcmp(opt, "--manifest") == 0) {
+                manifest = argv[i];
+            } else if (strcmp(opt, "--out-dir") == 0) {
+                out_dir = argv[i];
+            } else {
+                cache_path = argv[i];
+            }
+        } else if (strcmp(argv[i], "--help") == 0 ||
+                   strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            rc = 1;
+        } else if (out_dir || n_pos >= 2) {
+            /* With --out-dir every positional argument is an input. */
+            break;
+        } else {
+            positional[n_pos++] = argv[i];
+        }
+    }
+
+    /* Build the job list */
+    if (rc == 0 && out_dir) {
+        const char *ext = mode_ext[po.mode];
+        for (size_t k = 0; k < n_pos && rc == 0; k++) {
+            if (out_dir_path(path, sizeof(path), out_dir, positional[k], ext) !=
+                    0 ||
+                batch_add(&list, positional[k], path) != 0) {
+                rc = 2;
+            }
+        }
+        for (; i < argc && rc == 0; i++) {
+            if (out_dir_path(path, sizeof(path), out_dir, argv[i], ext) != 0 ||
+                batch_add(&list, argv[i], path) != 0) {
+                rc = 2;
+            }
+        }
+        if (rc == 2) {
+            fprintf(stderr, "Cannot form output path in %s\n", out_dir);
+        }
+    } else if (rc == 0 && (i < argc || (manifest && n_pos) ||
+                           (!manifest && n_pos != 2))) {
+        rc = 1; /* stray inputs, or not exactly one <values> <output> pair */
+    } else if (rc == 0 && n_pos == 2) {
+        rc = batch_add(&list, positional[0], positional[1]) ? 2 : 0;
+    }
+    if (rc == 0 && manifest) {
+        rc = batch_read_manifest(&list, manifest, 1);
+    }
+    if (rc == 0 && (list.count == 0 || !schema_path)) {
+        rc = 1;
+    }
+    if (rc == 1) {
+        print_usage(argv[0]);
+    }
+
+    if (rc == 0) {
+        rc = load_schema(schema_path, &po);
+    }
+    if (rc == 0 && cache_path) {
+        rc = batch_cache_load(cache_path);
+        po.use_cache = (rc == 0);
+    }
+    if (rc == 0) {
+        rc = batch_run(&list, threads, sizeof(workspace_t), pack_job, &po);
+        if (batch_cache_save() != 0 && rc == 0) {
+            rc = 2;
+        }
+    }
+
+    batch_free(&list);
+    return rc;
+}
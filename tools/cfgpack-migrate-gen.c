@@ -0,0 +1,372 @@
+/**
+ * @file cfgpack-migrate-gen.c
+ * @brief CLI tool for generating a migration plan from two schemas.
+ *
+ * Usage:
+ *   cfgpack-migrate-gen [--prefix <name>] <old> <new> <output.h>
+ *
+ * Each input format is auto-detected:
+ *   - Files ending in ".json" are parsed as JSON schemas.
+ *   - Files ending in ".msgpack" or ".bin" are parsed as MessagePack
+ *     schemas (see cfgpack-schema-pack).
+ *   - All other files are parsed as .map schemas.
+ *
+ * The schemas are diffed with cfgpack_migration_build(): entries are
+ * matched by name and each old entry is kept, moved, widened or removed;
+ * entries only in the new schema are added.  The generated header holds
+ * the result as const data, ready for cfgpack_pagein_migrate():
+ *   - <p>_actions[], one action per old entry, sorted by old index, with
+ *     the decoder of each widening already chosen.
+ *   - <p>_migration, the plan, with the fingerprints of both schemas.
+ *
+ * The default prefix is "<old>_to_<new>" from the schema names, or
+ * "<name>_v<old>_to_v<new>" when both schemas have the same name.
+ *
+ * Exit codes:
+ *   0 - Success
+ *   1 - Usage error
+ *   2 - File I/O error
+ *   3 - Parse error, or a type change that is not a widening
+ */
+
+#include "cfgpack/cfgpack.h"
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_INPUT_SIZE (64 * 1024) /* 64 KB max input */
+#define MAX_ENTRIES 256
+#define MAX_STR_OFFSETS 256
+#define MAX_IDENT 64
+
+/* Buffers for one parsed schema */
+typedef struct {
+    uint8_t data[MAX_INPUT_SIZE];
+    cfgpack_entry_t entries[MAX_ENTRIES];
+    cfgpack_value_t values[MAX_ENTRIES];
+    char str_pool[MAX_STR_OFFSETS * (CFGPACK_STR_MAX + 1)];
+    cfgpack_str_off_t str_offsets[MAX_STR_OFFSETS];
+    cfgpack_schema_t schema;
+} loaded_t;
+
+static loaded_t old_schema;
+static loaded_t new_schema;
+static cfgpack_migrate_action_t actions[MAX_ENTRIES];
+
+static char prefix_lo[MAX_IDENT];
+static char prefix_up[MAX_IDENT];
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--prefix <name>] <old> <new> <output.h>\n",
+            prog);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Diffs two schemas and generates a C header with the "
+                    "migration plan\n");
+    fprintf(stderr, "for cfgpack_pagein_migrate().\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Input format:\n");
+    fprintf(stderr, "  .json files          - Parsed as JSON schema\n");
+    fprintf(stderr, "  .msgpack .bin files  - Parsed as MessagePack schema\n");
+    fprintf(stderr, "  Other files          - Parsed as .map schema\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --prefix     Identifier prefix (default: "
+                    "<old>_to_<new>)\n");
+}
+
+static int has_suffix(const char *str, const char *suffix) {
+    size_t str_len = strlen(str);
+    size_t suf_len = strlen(suffix);
+    if (suf_len > str_len) {
+        return 0;
+    }
+    return strcmp(str + str_len - suf_len, suffix) == 0;
+}
+
+/* Copy @p src into @p dst as a C identifier fragment (non-alnum -> '_'). */
+static void make_ident(char *dst, size_t cap, const char *src, int upper) {
+    size_t n = 0;
+
+    for (; *src && n + 1 < cap; ++src) {
+        unsigned char c = (unsigned char)*src;
+        if (!isalnum(c)) {
+            c = '_';
+        }
+        dst[n++] = (char)(upper ? toupper(c) : tolower(c));
+    }
+    dst[n] = '\0';
+}
+
+static const char *type_name(cfgpack_type_t t) {
+    static const char *const names[] = {"u8",  "u16", "u32", "u64",
+                                        "i8",  "i16", "i32", "i64",
+                                        "f32", "f64", "str", "fstr"};
+    return names[t];
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Schema loading
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static int load_schema(const char *path, loaded_t *s) {
+    cfgpack_schema_measure_t m;
+    cfgpack_parse_error_t perr;
+    int is_json = has_suffix(path, ".json");
+    int is_msgpack = has_suffix(path, ".msgpack") || has_suffix(path, ".bin");
+    FILE *f = fopen(path, "rb");
+    cfgpack_err_t rc;
+    size_t len;
+
+    if (!f) {
+        fprintf(stderr, "Cannot open input file: %s\n", path);
+        return 2;
+    }
+    len = fread(s->data, 1, sizeof(s->data), f);
+    if (ferror(f) || (len == sizeof(s->data) && fgetc(f) != EOF)) {
+        fclose(f);
+        fprintf(stderr, "Cannot read %s (max %d bytes)\n", path,
+                MAX_INPUT_SIZE);
+        return 2;
+    }
+    fclose(f);
+
+    memset(&perr, 0, sizeof(perr));
+    if (is_msgpack) {
+        rc = cfgpack_schema_measure_msgpack(s->data, len, &m, &perr);
+    } else if (is_json) {
+        rc = cfgpack_schema_measure_json((const char *)s->data, len, &m,
+                                         &perr);
+    } else {
+        rc = cfgpack_schema_measure((const char *)s->data, len, &m, &perr);
+    }
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "%s: measure failed: %s\n", path, perr.message);
+        return 3;
+    }
+    if (m.entry_count > MAX_ENTRIES ||
+        m.str_count + m.fstr_count > MAX_STR_OFFSETS) {
+        fprintf(stderr, "%s: schema too large: %zu entries, %zu strings\n",
+                path, m.entry_count, m.str_count + m.fstr_count);
+        return 3;
+    }
+
+    cfgpack_parse_opts_t opts = {
+        .out_schema = &s->schema,
+        .entries = s->entries,
+        .max_entries = m.entry_count,
+        .values = s->values,
+        .str_pool = s->str_pool,
+        .str_pool_cap = m.str_pool_size,
+        .str_offsets = s->str_offsets,
+        .str_offsets_count = m.str_count + m.fstr_count,
+        .err = &perr,
+    };
+    if (is_msgpack) {
+        rc = cfgpack_schema_parse_msgpack(s->data, len, &opts);
+    } else if (is_json) {
+        rc = cfgpack_schema_parse_json((const char *)s->data, len, &opts);
+    } else {
+        rc = cfgpack_parse_schema((const char *)s->data, len, &opts);
+    }
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "%s: parse failed: %s\n", path, perr.message);
+        return 3;
+    }
+    return 0;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Header emission
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static const char *kind_name(uint8_t kind) {
+    static const char *const names[] = {"KEEP", "MOVE", "WIDEN", "DROP"};
+    return names[kind];
+}
+
+static const char *decoder_name(uint8_t dec) {
+    static const char *const names[] = {"UINT", "INT", "UINT_INT", "F32",
+                                        "F64",  "F32_F64", "STR"};
+    return names[dec];
+}
+
+/* Number of new entries whose name is not in the old schema */
+static size_t count_added(const cfgpack_schema_t *from,
+                          const cfgpack_schema_t *to) {
+    size_t added = 0;
+
+    for (size_t j = 0; j < to->entry_count; ++j) {
+        size_t i = 0;
+
+        while (i < from->entry_count &&
+               strncmp(from->entries[i].name, to->entries[j].name,
+                       sizeof(to->entries[j].name)) != 0) {
+            i++;
+        }
+        added += (i == from->entry_count);
+    }
+    return added;
+}
+
+static int emit_header(FILE *f,
+                       const char *old_path,
+                       const char *new_path,
+                       const cfgpack_migration_t *m,
+                       const size_t *kinds,
+                       size_t added) {
+    const cfgpack_schema_t *from = &old_schema.schema;
+    const cfgpack_schema_t *to = &new_schema.schema;
+    const char *p = prefix_lo;
+    const char *P = prefix_up;
+
+    fprintf(f,
+            "/* Generated by cfgpack-migrate-gen from %s -> %s.\n"
+            " * Do not edit: regenerate when either schema changes. */\n\n",
+            old_path, new_path);
+    fprintf(f, "#ifndef %s_MIGRATE_H\n#define %s_MIGRATE_H\n\n", P, P);
+    fprintf(f, "#include \"cfgpack/api.h\"\n\n");
+
+    fprintf(f,
+            "/* \"%s\" v%u -> \"%s\" v%u: %zu kept, %zu moved, %zu widened, "
+            "%zu removed;\n"
+            " * %zu added (they take their defaults). */\n\n",
+            from->map_name, from->version, to->map_name, to->version,
+            kinds[CFGPACK_MIGRATE_KEEP], kinds[CFGPACK_MIGRATE_MOVE],
+            kinds[CFGPACK_MIGRATE_WIDEN], kinds[CFGPACK_MIGRATE_DROP], added);
+
+    fprintf(f, "static const cfgpack_migrate_action_t %s_actions[] = {\n", p);
+    for (size_t i = 0; i < m->count; ++i) {
+        const cfgpack_migrate_action_t *a = &m->actions[i];
+        const cfgpack_entry_t *e = &from->entries[i];
+        int n;
+
+        n = fprintf(f,
+                    "    {%u, %u, CFGPACK_MIGRATE_%s, "
+                    "CFGPACK_MIGRATE_DEC_%s},",
+                    a->old_index, a->new_pos, kind_name(a->kind),
+                    decoder_name(a->decode));
+        fprintf(f, "%*s/* %s", n < 60 ? 60 - n : 1, "", e->name);
+        if (a->kind == CFGPACK_MIGRATE_DROP) {
+            fprintf(f, " */\n");
+            continue;
+        }
+        fprintf(f, " %s", type_name(e->type));
+        if (a->kind == CFGPACK_MIGRATE_WIDEN) {
+            fprintf(f, "->%s", type_name(to->entries[a->new_pos].type));
+        }
+        if (to->entries[a->new_pos].index != e->index) {
+            fprintf(f, " @%u", to->entries[a->new_pos].index);
+        }
+        fprintf(f, " */\n");
+    }
+    fprintf(f, "};\n\n");
+
+    fprintf(f,
+            "static const cfgpack_migration_t %s_migration = {\n"
+            "    0x%016" PRIx64 "ull,\n"
+            "    0x%016" PRIx64 "ull,\n"
+            "    %s_actions,\n"
+            "    sizeof(%s_actions) /\n"
+            "        sizeof(%s_actions[0]),\n"
+            "};\n\n",
+            p, m->from_fp, m->to_fp, p, p, p);
+
+    fprintf(f, "#endif /* %s_MIGRATE_H */\n", P);
+    return ferror(f) ? 2 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    const cfgpack_schema_t *from = &old_schema.schema;
+    const cfgpack_schema_t *to = &new_schema.schema;
+    size_t kinds[4] = {0, 0, 0, 0};
+    const char *prefix = NULL;
+    char def_prefix[2 * MAX_IDENT + 32];
+    cfgpack_migration_t m;
+    size_t failed = 0;
+    size_t added;
+    cfgpack_err_t err;
+    FILE *fout;
+    int rc;
+
+    if (argc == 6 && strcmp(argv[1], "--prefix") == 0) {
+        prefix = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc != 4) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    rc = load_schema(argv[1], &old_schema);
+    if (rc == 0) {
+        rc = load_schema(argv[2], &new_schema);
+    }
+    if (rc != 0) {
+        return rc;
+    }
+
+    err = cfgpack_migration_build(from, to, actions, MAX_ENTRIES, &m,
+                                  &failed);
+    if (err == CFGPACK_ERR_TYPE_MISMATCH) {
+        const cfgpack_entry_t *e = &from->entries[failed];
+        const cfgpack_entry_t *n = to->entries;
+
+        while (strncmp(n->name, e->name, sizeof(e->name)) != 0) {
+            n++;
+        }
+        fprintf(stderr,
+                "Entry \"%s\" (index %u): %s to %s is not a widening; "
+                "rename it to drop the old value\n",
+                e->name, e->index, type_name(e->type), type_name(n->type));
+        return 3;
+    }
+    if (err != CFGPACK_OK) {
+        fprintf(stderr, "Cannot build the migration: %d\n", err);
+        return 3;
+    }
+    for (size_t i = 0; i < m.count; ++i) {
+        kinds[actions[i].kind]++;
+    }
+    added = count_added(from, to);
+
+    if (!prefix) {
+        if (strcmp(from->map_name, to->map_name) == 0) {
+            snprintf(def_prefix, sizeof(def_prefix), "%s_v%u_to_v%u",
+                     from->map_name, from->version, to->version);
+        } else {
+            snprintf(def_prefix, sizeof(def_prefix), "%s_to_%s",
+                     from->map_name, to->map_name);
+        }
+        prefix = def_prefix;
+    }
+    make_ident(prefix_lo, sizeof(prefix_lo), prefix, 0);
+    make_ident(prefix_up, sizeof(prefix_up), prefix_lo, 1);
+    if (!isalpha((unsigned char)prefix_lo[0]) && prefix_lo[0] != '_') {
+        fprintf(stderr, "Prefix \"%s\" is not a C identifier; use --prefix\n",
+                prefix_lo);
+        return 1;
+    }
+
+    fout = fopen(argv[3], "w");
+    if (!fout) {
+        fprintf(stderr, "Cannot open output file: %s\n", argv[3]);
+        return 2;
+    }
+    rc = emit_header(fout, argv[1], argv[2], &m, kinds, added);
+    if (fclose(fout) != 0 || rc != 0) {
+        fprintf(stderr, "Error writing output file\n");
+        return 2;
+    }
+
+    printf("Migration: \"%s\" v%u -> \"%s\" v%u\n", from->map_name,
+           from->version, to->map_name, to->version);
+    printf("  %zu kept, %zu moved, %zu widened, %zu removed, %zu added\n",
+           kinds[CFGPACK_MIGRATE_KEEP], kinds[CFGPACK_MIGRATE_MOVE],
+           kinds[CFGPACK_MIGRATE_WIDEN], kinds[CFGPACK_MIGRATE_DROP], added);
+    printf("Header: %s (%s_migration)\n", argv[3], prefix_lo);
+    return 0;
+}
@@ -0,0 +1,624 @@
+/**
+ * @file cfgpack-schema-gen.c
+ * @brief CLI tool for generating a C header from a schema.
+ *
+ * Usage:
+ *   cfgpack-schema-gen [--prefix <name>] <input> <output.h>
+ *   cfgpack-schema-gen --hash <input>
+ *
+ * The input format is auto-detected:
+ *   - Files ending in ".json" are parsed as JSON schemas.
+ *   - Files ending in ".img" are attached as precompiled schema images
+ *     (see cfgpack-schema-pack --image).
+ *   - All other files are parsed as .map schemas.
+ *
+ * The generated header compiles the schema into the firmware:
+ *   - <P>_IDX_<NAME> wire indices and <P>_POS_<NAME> entry offsets.
+ *   - Static cfgpack_entry_t and default-value tables, plus <p>_init(),
+ *     which sets up a context without parsing anything.
+ *   - Inline <p>_get_<name>() / <p>_set_<name>() / <p>_has_<name>()
+ *     accessors that index ctx->values directly, with no entry lookup.
+ *   - <P>_SCHEMA_HASH (cfgpack_schema_hash()).  If the build defines
+ *     <P>_SCHEMA_EXPECTED_HASH (e.g. from --hash on the deployed image),
+ *     a static assertion fails when the header has drifted from it.
+ *
+ * --hash prints the schema hash of <input> as a C hex literal.
+ *
+ * Exit codes:
+ *   0 - Success
+ *   1 - Usage error
+ *   2 - File I/O error
+ *   3 - Parse/encode error
+ */
+
+#include "cfgpack/cfgpack.h"
+#include "cfgpack/io_file.h"
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_INPUT_SIZE (64 * 1024) /* 64 KB max input */
+#define MAX_ENTRIES 256
+#define MAX_STR_OFFSETS 256
+#define MAX_IDENT 64
+
+static char scratch[MAX_INPUT_SIZE];
+
+/* Image input must be aligned like it would be in flash */
+static union {
+    uint64_t align;
+    uint8_t bytes[MAX_INPUT_SIZE];
+} image;
+
+static cfgpack_entry_t entries[MAX_ENTRIES];
+static cfgpack_value_t values[MAX_ENTRIES];
+static char str_pool[MAX_STR_OFFSETS * (CFGPACK_STR_MAX + 1)];
+static cfgpack_str_off_t str_offsets[MAX_STR_OFFSETS];
+
+/* Sanitized identifier per entry (lower case) and the prefix */
+static char idents[MAX_ENTRIES][8];
+static char prefix_lo[MAX_IDENT];
+static char prefix_up[MAX_IDENT];
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--prefix <name>] <input> <output.h>\n", prog);
+    fprintf(stderr, "       %s --hash <input>\n", prog);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Generates a C header with index constants, static entry "
+                    "and default\n");
+    fprintf(stderr, "tables and inline typed accessors for a schema.\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Input format:\n");
+    fprintf(stderr, "  .json files  - Parsed as JSON schema\n");
+    fprintf(stderr, "  .img files   - Precompiled schema image\n");
+    fprintf(stderr, "  Other files  - Parsed as .map schema\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --prefix     Identifier prefix (default: schema "
+                    "name)\n");
+    fprintf(stderr, "  --hash       Print the schema hash and exit\n");
+}
+
+static int has_suffix(const char *str, const char *suffix) {
+    size_t str_len = strlen(str);
+    size_t suf_len = strlen(suffix);
+    if (suf_len > str_len) {
+        return 0;
+    }
+    return strcmp(str + str_len - suf_len, suffix) == 0;
+}
+
+/* Copy @p src into @p dst as a C identifier fragment (non-alnum -> '_'). */
+static void make_ident(char *dst, size_t cap, const char *src, int upper) {
+    size_t n = 0;
+
+    for (; *src && n + 1 < cap; ++src) {
+        unsigned char c = (unsigned char)*src;
+        if (!isalnum(c)) {
+            c = '_';
+        }
+        dst[n++] = (char)(upper ? toupper(c) : tolower(c));
+    }
+    dst[n] = '\0';
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Schema loading
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static int load_image(const char *path,
+                      cfgpack_schema_t *schema,
+                      cfgpack_schema_measure_t *m) {
+    cfgpack_parse_error_t perr;
+    FILE *f = fopen(path, "rb");
+    size_t len;
+
+    if (!f) {
+        fprintf(stderr, "Cannot open input file: %s\n", path);
+        return 2;
+    }
+    len = fread(image.bytes, 1, sizeof(image.bytes), f);
+    fclose(f);
+
+    cfgpack_parse_opts_t opts = {
+        .out_schema = schema,
+        .entries = NULL,
+        .max_entries = MAX_ENTRIES,
+        .values = values,
+        .str_pool = str_pool,
+        .str_pool_cap = sizeof(str_pool),
+        .str_offsets = str_offsets,
+        .str_offsets_count = MAX_STR_OFFSETS,
+        .err = &perr,
+    };
+    if (cfgpack_schema_measure_image(image.bytes, len, m, &perr) !=
+            CFGPACK_OK ||
+        cfgpack_schema_attach_image(image.bytes, len, &opts) != CFGPACK_OK) {
+        fprintf(stderr, "Attach failed: %s\n", perr.message);
+        return 3;
+    }
+    return 0;
+}
+
+static int load_schema(const char *path,
+                       cfgpack_schema_t *schema,
+                       cfgpack_schema_measure_t *m) {
+    cfgpack_parse_error_t perr;
+    int is_json = has_suffix(path, ".json");
+    cfgpack_err_t rc;
+
+    if (has_suffix(path, ".img")) {
+        return load_image(path, schema, m);
+    }
+
+    if (is_json) {
+        rc = cfgpack_schema_measure_json_file(path, m, scratch,
+                                              sizeof(scratch), &perr);
+    } else {
+        rc = cfgpack_schema_measure_file(path, m, scratch, sizeof(scratch),
+                                         &perr);
+    }
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "Measure failed: %s\n", perr.message);
+        return 3;
+    }
+    if (m->entry_count > MAX_ENTRIES ||
+        m->str_count + m->fstr_count > MAX_STR_OFFSETS) {
+        fprintf(stderr, "Schema too large: %zu entries, %zu strings\n",
+                m->entry_count, m->str_count + m->fstr_count);
+        return 3;
+    }
+
+    cfgpack_parse_opts_t opts = {
+        .out_schema = schema,
+        .entries = entries,
+        .max_entries = m->entry_count,
+        .values = values,
+        .str_pool = str_pool,
+        .str_pool_cap = m->str_pool_size,
+        .str_offsets = str_offsets,
+        .str_offsets_count = m->str_count + m->fstr_count,
+        .err = &perr,
+    };
+    if (is_json) {
+        rc = cfgpack_schema_parse_json_file(path, &opts, scratch,
+                                            sizeof(scratch));
+    } else {
+        rc = cfgpack_parse_schema_file(path, &opts, scratch, sizeof(scratch));
+    }
+    if (rc != CFGPACK_OK) {
+        fprintf(stderr, "Parse failed: %s\n", perr.message);
+        return 3;
+    }
+    return 0;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────────
+ * Header emission
+ * ───────────────────────────────────────────────────────────────────────────── */
+
+static const char *type_name(cfgpack_type_t t) {
+    static const char *const names[] = {"U8",  "U16", "U32", "U64",
+                                        "I8",  "I16", "I32", "I64",
+                                        "F32", "F64", "STR", "FSTR"};
+    return names[t];
+}
+
+static const char *c_type(cfgpack_type_t t) {
+    static const char *const types[] = {
+        "uint8_t", "uint16_t", "uint32_t", "uint64_t", "int8_t", "int16_t",
+        "int32_t", "int64_t",  "float",    "double",   NULL,     NULL};
+    return types[t];
+}
+
+/* Union member holding a numeric type's value */
+static const char *member(cfgpack_type_t t) {
+    if (t <= CFGPACK_TYPE_U64) {
+        return "u64";
+    }
+    if (t <= CFGPACK_TYPE_I64) {
+        return "i64";
+    }
+    return (t == CFGPACK_TYPE_F32) ? "f32" : "f64";
+}
+
+static void emit_c_string(FILE *f, const char *s, size_t len) {
+    fputc('"', f);
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\' || c == '?') {
+            fprintf(f, "\\%c", c);
+        } else if (c < 0x20 || c >= 0x7F) {
+            fprintf(f, "\\%03o", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static void emit_float(FILE *f, double d, int is_f32) {
+    if (isnan(d)) {
+        fprintf(f, "NAN");
+    } else if (isinf(d)) {
+        fprintf(f, d < 0 ? "-INFINITY" : "INFINITY");
+    } else {
+        fprintf(f, "%a%s", d, is_f32 ? "f" : "");
+    }
+}
+
+static void emit_default(FILE *f,
+                         const cfgpack_entry_t *e,
+                         const cfgpack_value_t *v) {
+    const char *id = idents[e - entries];
+
+    fprintf(f, "    {.type = CFGPACK_TYPE_%s", type_name(e->type));
+    if (!e->has_default) {
+        fprintf(f, "},\n");
+        return;
+    }
+    switch (e->type) {
+    case CFGPACK_TYPE_U8:
+    case CFGPACK_TYPE_U16:
+    case CFGPACK_TYPE_U32:
+    case CFGPACK_TYPE_U64:
+        fprintf(f, ", .v.u64 = UINT64_C(%" PRIu64 ")},\n", v->v.u64);
+        break;
+    case CFGPACK_TYPE_I8:
+    case CFGPACK_TYPE_I16:
+    case CFGPACK_TYPE_I32:
+    case CFGPACK_TYPE_I64:
+        if (v->v.i64 == INT64_MIN) {
+            fprintf(f, ", .v.i64 = INT64_MIN},\n");
+        } else {
+            fprintf(f, ", .v.i64 = INT64_C(%" PRId64 ")},\n", v->v.i64);
+        }
+        break;
+    case CFGPACK_TYPE_F32:
+        fprintf(f, ", .v.f32 = ");
+        emit_float(f, v->v.f32, 1);
+        fprintf(f, "},\n");
+        break;
+    case CFGPACK_TYPE_F64:
+        fprintf(f, ", .v.f64 = ");
+        emit_float(f, v->v.f64, 0);
+        fprintf(f, "},\n");
+        break;
+    case CFGPACK_TYPE_STR:
+        fprintf(f, ", .v.str = {%s_POOL_", prefix_up);
+        for (const char *p = id; *p; ++p) {
+            fputc(toupper((unsigned char)*p), f);
+        }
+        fprintf(f, ", %u}},\n", v->v.str.len);
+        break;
+    case CFGPACK_TYPE_FSTR:
+        fprintf(f, ", .v.fstr = {%s_POOL_", prefix_up);
+        for (const char *p = id; *p; ++p) {
+            fputc(toupper((unsigned char)*p), f);
+        }
+        fprintf(f, ", %u, 0}},\n", v->v.fstr.len);
+        break;
+    }
+}
+
+static void emit_accessors(FILE *f, size_t i, const char *up) {
+    const cfgpack_entry_t *e = &entries[i];
+    const char *lo = idents[i];
+    const char *p = prefix_lo;
+    const char *P = prefix_up;
+
+    fprintf(f, "/* %s: %s, index %u */\n\n", e->name, type_name(e->type),
+            e->index);
+
+    fprintf(f,
+            "static inline int %s_has_%s(const cfgpack_ctx_t *ctx) {\n"
+            "    return (cfgpack_presence_get(ctx, %s_POS_%s));\n"
+            "}\n\n",
+            p, lo, P, up);
+
+    if (e->type == CFGPACK_TYPE_STR || e->type == CFGPACK_TYPE_FSTR) {
+        int is_str = e->type == CFGPACK_TYPE_STR;
+        const char *fld = is_str ? "str" : "fstr";
+        const char *len_t = is_str ? "uint16_t" : "uint8_t";
+
+        int get_pad = (int)(strlen("static inline const char *_get_(") +
+                            strlen(p) + strlen(lo));
+        int set_pad = (int)(strlen("static inline cfgpack_err_t _set_(") +
+                            strlen(p) + strlen(lo));
+        char limit[24];
+
+        if (e->str_max) {
+            snprintf(limit, sizeof(limit), "%u", e->str_max);
+        } else {
+            snprintf(limit, sizeof(limit), "%s",
+                     is_str ? "CFGPACK_STR_MAX" : "CFGPACK_FSTR_MAX");
+        }
+
+        fprintf(f,
+                "static inline const char *%s_get_%s(const cfgpack_ctx_t "
+                "*ctx,\n"
+                "%*s%s *len) {\n"
+                "    if (len) {\n"
+                "        *len = ctx->values[%s_POS_%s].v.%s.len;\n"
+                "    }\n"
+                "    return (ctx->str_pool + %s_POOL_%s);\n"
+                "}\n\n",
+                p, lo, get_pad, "", len_t, P, up, fld, P, up);
+        fprintf(f,
+                "static inline cfgpack_err_t %s_set_%s(cfgpack_ctx_t *ctx,\n"
+                "%*sconst char *str) {\n"
+                "    size_t len = strlen(str);\n"
+                "    if (len > %s) {\n"
+                "        return (CFGPACK_ERR_STR_TOO_LONG);\n"
+                "    }\n"
+                "    memcpy(ctx->str_pool + %s_POOL_%s, str, len);\n"
+                "    ctx->str_pool[%s_POOL_%s + len] = '\\0';\n"
+                "    ctx->values[%s_POS_%s].type = CFGPACK_TYPE_%s;\n"
+                "    ctx->values[%s_POS_%s].v.%s.offset = %s_POOL_%s;\n"
+                "    ctx->values[%s_POS_%s].v.%s.len = (%s)len;\n"
+                "    cfgpack_presence_set(ctx, %s_POS_%s);\n"
+                "    cfgpack_dirty_set(ctx, %s_POS_%s);\n"
+                "    return (CFGPACK_OK);\n"
+                "}\n\n",
+                p, lo, set_pad, "", limit, P, up,
+                P, up, P, up, type_name(e->type), P, up, fld, P, up, P, up,
+                fld, len_t, P, up, P, up);
+        return;
+    }
+
+    fprintf(f,
+            "static inline %s %s_get_%s(const cfgpack_ctx_t *ctx) {\n"
+            "    return ((%s)ctx->values[%s_POS_%s].v.%s);\n"
+            "}\n\n",
+            c_type(e->type), p, lo, c_type(e->type), P, up,
+            member(e->type));
+    fprintf(f,
+            "static inline void %s_set_%s(cfgpack_ctx_t *ctx, %s val) {\n"
+            "    ctx->values[%s_POS_%s].type = CFGPACK_TYPE_%s;\n"
+            "    ctx->values[%s_POS_%s].v.%s = val;\n"
+            "    cfgpack_presence_set(ctx, %s_POS_%s);\n"
+            "    cfgpack_dirty_set(ctx, %s_POS_%s);\n"
+            "}\n\n",
+            p, lo, c_type(e->type), P, up, type_name(e->type), P, up,
+            member(e->type), P, up, P, up);
+}
+
+static int emit_header(FILE *f,
+                       const char *input_path,
+                       const cfgpack_schema_t *schema,
+                       const cfgpack_schema_measure_t *m) {
+    const char *p = prefix_lo;
+    const char *P = prefix_up;
+    size_t n_str = m->str_count + m->fstr_count;
+    char up[8];
+
+    fprintf(f,
+            "/* Generated by cfgpack-schema-gen from %s. Do not edit. */\n\n",
+            input_path);
+    fprintf(f, "#ifndef %s_SCHEMA_H\n#define %s_SCHEMA_H\n\n", P, P);
+    fprintf(f, "#include \"cfgpack/cfgpack.h\"\n\n");
+    fprintf(f, "#include <math.h>\n#include <stdint.h>\n#include <string.h>"
+               "\n\n");
+
+    fprintf(f, "#define %s_SCHEMA_NAME ", P);
+    emit_c_string(f, schema->map_name, strlen(schema->map_name));
+    fprintf(f, "\n#define %s_SCHEMA_VERSION %uu\n", P, schema->version);
+    fprintf(f, "#define %s_SCHEMA_HASH 0x%08" PRIx32 "u\n", P,
+            cfgpack_schema_hash(schema));
+    fprintf(f, "#define %s_ENTRY_COUNT %zuu\n", P, schema->entry_count);
+    fprintf(f, "#define %s_STR_COUNT %zuu /* str + fstr slots */\n", P, n_str);
+    fprintf(f, "#define %s_STR_POOL_SIZE %zuu\n\n", P, m->str_pool_size);
+
+    fprintf(f, "#ifdef %s_SCHEMA_EXPECTED_HASH\n", P);
+    fprintf(f, "  #if defined(__STDC_VERSION__) && __STDC_VERSION__ >= "
+               "201112L\n");
+    fprintf(f,
+            "_Static_assert(%s_SCHEMA_EXPECTED_HASH == %s_SCHEMA_HASH,\n"
+            "               \"%s schema header out of date\");\n",
+            P, P, p);
+    fprintf(f, "  #else\n");
+    fprintf(f,
+            "typedef char %s_schema_hash_check[(%s_SCHEMA_EXPECTED_HASH == "
+            "%s_SCHEMA_HASH) ? 1 : -1];\n",
+            p, P, P);
+    fprintf(f, "  #endif\n#endif\n\n");
+
+    /* Index, position and string constants */
+    fprintf(f, "/* Wire indices (cfgpack_get() / cfgpack_set() keys) */\n");
+    fprintf(f, "enum {\n");
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        make_ident(up, sizeof(up), idents[i], 1);
+        fprintf(f, "    %s_IDX_%s = %u,\n", P, up, entries[i].index);
+    }
+    fprintf(f, "};\n\n");
+
+    fprintf(f, "/* Offsets into the entry and value arrays */\n");
+    fprintf(f, "enum {\n");
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        make_ident(up, sizeof(up), idents[i], 1);
+        fprintf(f, "    %s_POS_%s = %zu,\n", P, up, i);
+    }
+    fprintf(f, "};\n\n");
+
+    if (n_str > 0) {
+        fprintf(f, "/* String pool offsets (as computed by cfgpack_init()) "
+                   "*/\n");
+        fprintf(f, "enum {\n");
+        for (size_t i = 0; i < schema->entry_count; ++i) {
+            if (entries[i].str_slot == CFGPACK_STR_SLOT_NONE) {
+                continue;
+            }
+            make_ident(up, sizeof(up), idents[i], 1);
+            fprintf(f, "    %s_POOL_%s = %u,\n", P, up,
+                    str_offsets[entries[i].str_slot]);
+        }
+        fprintf(f, "};\n\n");
+    }
+
+    /* Tables */
+    fprintf(f, "static const cfgpack_entry_t %s_entries[%s_ENTRY_COUNT] = {\n",
+            p, P);
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        const cfgpack_entry_t *e = &entries[i];
+        fprintf(f, "    {%u, \"%s\", CFGPACK_TYPE_%s, %u, ", e->index, e->name,
+                type_name(e->type), e->has_default);
+        if (e->str_slot == CFGPACK_STR_SLOT_NONE) {
+            fprintf(f, "CFGPACK_STR_SLOT_NONE, 0},\n");
+        } else {
+            fprintf(f, "%u, %u},\n", e->str_slot, e->str_max);
+        }
+    }
+    fprintf(f, "};\n\n");
+
+    fprintf(f,
+            "static const cfgpack_value_t %s_defaults[%s_ENTRY_COUNT] = {\n",
+            p, P);
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        emit_default(f, &entries[i], &values[i]);
+    }
+    fprintf(f, "};\n\n");
+
+    /* Init */
+    fprintf(f,
+            "/**\n"
+            " * @brief Set up @p ctx for the compiled-in schema (no parsing).\n"
+            " *\n"
+            " * @p schema must outlive @p ctx.  Buffers must hold "
+            "%s_ENTRY_COUNT values,\n"
+            " * %s_STR_POOL_SIZE pool bytes and %s_STR_COUNT offsets.\n"
+            " */\n",
+            P, P, P);
+    {
+        /* Align continuation lines under the first parameter */
+        int pad = (int)(strlen("static inline cfgpack_err_t _init(") +
+                        strlen(p));
+        fprintf(f,
+                "static inline cfgpack_err_t %s_init(cfgpack_ctx_t *ctx,\n"
+                "%*scfgpack_schema_t *schema,\n"
+                "%*scfgpack_value_t *values,\n"
+                "%*schar *str_pool,\n"
+                "%*scfgpack_str_off_t *str_offsets) {\n",
+                p, pad, "", pad, "", pad, "", pad, "");
+    }
+    fprintf(f, "    memcpy(schema->map_name, %s_SCHEMA_NAME, "
+               "sizeof(%s_SCHEMA_NAME));\n",
+            P, P);
+    fprintf(f, "    schema->version = %s_SCHEMA_VERSION;\n", P);
+    fprintf(f, "    /* Entries are never written, so they stay in flash */\n");
+    fprintf(f, "    schema->entries = (cfgpack_entry_t *)(uintptr_t)%s_entries;"
+               "\n",
+            p);
+    fprintf(f, "    schema->entry_count = %s_ENTRY_COUNT;\n", P);
+    fprintf(f, "    memcpy(values, %s_defaults, sizeof(%s_defaults));\n", p, p);
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        const cfgpack_entry_t *e = &entries[i];
+        const cfgpack_value_t *v = &values[i];
+        size_t len;
+
+        if (!e->has_default || e->str_slot == CFGPACK_STR_SLOT_NONE) {
+            continue;
+        }
+        make_ident(up, sizeof(up), idents[i], 1);
+        len = (e->type == CFGPACK_TYPE_STR) ? v->v.str.len : v->v.fstr.len;
+        fprintf(f, "    memcpy(str_pool + %s_POOL_%s, ", P, up);
+        emit_c_string(f, str_pool + v->v.str.offset, len);
+        fprintf(f, ", %zu);\n", len + 1);
+    }
+    fprintf(f,
+            "    return (cfgpack_init(ctx, schema, values, %s_ENTRY_COUNT, "
+            "str_pool,\n"
+            "                         %s_STR_POOL_SIZE, str_offsets, "
+            "%s_STR_COUNT));\n"
+            "}\n\n",
+            P, P, P);
+
+    fprintf(f, "/* Typed accessors: index ctx->values directly.  Getters "
+               "return the stored\n"
+               " * value whether or not it is present; check "
+               "%s_has_<name>() first when\n"
+               " * the entry has no default. */\n\n",
+            p);
+    for (size_t i = 0; i < schema->entry_count; ++i) {
+        make_ident(up, sizeof(up), idents[i], 1);
+        emit_accessors(f, i, up);
+    }
+
+    fprintf(f, "#endif /* %s_SCHEMA_H */\n", P);
+    return ferror(f) ? 2 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    cfgpack_schema_measure_t m;
+    cfgpack_schema_t schema;
+    const char *prefix = NULL;
+    int hash_only = 0;
+    FILE *fout;
+    int rc;
+
+    if (argc == 3 && strcmp(argv[1], "--hash") == 0) {
+        hash_only = 1;
+    } else if (argc == 5 && strcmp(argv[1], "--prefix") == 0) {
+        prefix = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+    if (!hash_only && argc != 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    rc = load_schema(argv[hash_only ? 2 : 1], &schema, &m);
+    if (rc != 0) {
+        return rc;
+    }
+    if (schema.entries != entries) {
+        /* Attached image: emitters read the file-scope arrays */
+        memcpy(entries, schema.entries,
+               schema.entry_count * sizeof(cfgpack_entry_t));
+    }
+    if (hash_only) {
+        printf("0x%08" PRIx32 "u\n", cfgpack_schema_hash(&schema));
+        return 0;
+    }
+
+    make_ident(prefix_lo, sizeof(prefix_lo), prefix ? prefix : schema.map_name,
+               0);
+    make_ident(prefix_up, sizeof(prefix_up), prefix_lo, 1);
+    if (!isalpha((unsigned char)prefix_lo[0]) && prefix_lo[0] != '_') {
+        fprintf(stderr, "Prefix \"%s\" is not a C identifier; use --prefix\n",
+                prefix_lo);
+        return 1;
+    }
+    for (size_t i = 0; i < schema.entry_count; ++i) {
+        make_ident(idents[i], sizeof(idents[i]), entries[i].name, 0);
+        for (size_t j = 0; j < i; ++j) {
+            if (strcmp(idents[i], idents[j]) == 0) {
+                fprintf(stderr, "Entries \"%s\" and \"%s\" map to the same "
+                                "identifier\n",
+                        entries[j].name, entries[i].name);
+                return 3;
+            }
+        }
+    }
+
+    fout = fopen(argv[2], "w");
+    if (!fout) {
+        fprintf(stderr, "Cannot open output file: %s\n", argv[2]);
+        return 2;
+    }
+    rc = emit_header(fout, argv[1], &schema, &m);
+    if (fclose(fout) != 0 || rc != 0) {
+        fprintf(stderr, "Error writing output file\n");
+        return 2;
+    }
+
+    printf("Schema: \"%s\" v%u (%zu entries)\n", schema.map_name,
+           schema.version, schema.entry_count);
+    printf("Header: %s (prefix %s_, hash 0x%08" PRIx32 ")\n", argv[2],
+           prefix_lo, cfgpack_schema_hash(&schema));
+    return 0;
+}
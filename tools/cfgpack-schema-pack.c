@@ -3,16 +3,36 @@
  * @brief CLI tool for converting .map or JSON schemas to MessagePack binary.
  *
  * Usage:
- *   cfgpack-schema-pack <input> <output>
+ *   cfgpack-schema-pack [--image] [-j N] [--cache FILE] <input> <output>
+ *   cfgpack-schema-pack [--image] [-j N] [--cache FILE] --manifest FILE
+ *   cfgpack-schema-pack [--image] [-j N] [--cache FILE] --out-dir DIR
+ *                       <input>...
+ *   cfgpack-schema-pack --family <output> <input>...
  *
  * The input file format is auto-detected:
  *   - Files ending in ".json" are parsed as JSON schemas.
  *   - All other files are parsed as .map schemas.
  *
  * The output file contains raw MessagePack binary data suitable for
- * on-device parsing with cfgpack_schema_parse_msgpack().
+ * on-device parsing with cfgpack_schema_parse_msgpack().  With --image it
+ * is instead a precompiled schema image (cfgpack_schema_write_image()) for
+ * zero-parse loading with cfgpack_schema_attach_image(); the image uses
+ * this host's struct layout, so the target ABI must match it.
  *
- * Exit codes:
+ * Many schemas can be packed in one run: a --manifest lists one
+ * "<input> <output>" pair per line, and --out-dir writes each input to
+ * DIR/<input basename>.msgpack (or .img with --image).  Jobs run on -j
+ * worker threads (one per CPU by default).  With --cache, an output is
+ * left alone when its input and mode match the last run and the output
+ * file still holds what that run wrote.
+ *
+ * --family packs every input into one schema family image
+ * (cfgpack_schema_write_family()) for a product line whose variants share
+ * most entries; each variant is named after its input's basename without
+ * the extension and loaded with cfgpack_schema_attach_family().  Like
+ * --image, the layout is this host's.
+ *
+ * Exit codes (the highest over all inputs):
  *   0 - Success
  *   1 - Usage error
  *   2 - File I/O error
@@ -20,9 +40,10 @@
  */
 
 #include "cfgpack/cfgpack.h"
-#include "cfgpack/io_file.h"
 #include "cfgpack/msgpack.h"
 
+#include "batch.h"
+
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -32,25 +53,59 @@
 #define MAX_OUTPUT_SIZE (64 * 1024) /* 64 KB max output */
 #define MAX_ENTRIES 256
 #define MAX_STR_OFFSETS 256
+#define MAX_PATH_LEN 4096
 
-static char scratch[MAX_INPUT_SIZE];
-static uint8_t output_buf[MAX_OUTPUT_SIZE];
+/** Per-worker buffers, reused for every schema the worker packs. */
+typedef struct {
+    char input[MAX_INPUT_SIZE];
+    uint8_t output_buf[MAX_OUTPUT_SIZE];
+    uint8_t existing[MAX_OUTPUT_SIZE];
+    cfgpack_entry_t entries[MAX_ENTRIES];
+    cfgpack_value_t values[MAX_ENTRIES];
+    char str_pool[MAX_STR_OFFSETS * (CFGPACK_STR_MAX + 1)];
+    cfgpack_str_off_t str_offsets[MAX_STR_OFFSETS];
+} workspace_t;
 
-static cfgpack_entry_t entries[MAX_ENTRIES];
-static cfgpack_value_t values[MAX_ENTRIES];
-static char str_pool[MAX_STR_OFFSETS * (CFGPACK_STR_MAX + 1)];
-static uint16_t str_offsets[MAX_STR_OFFSETS];
+/** Options shared by every schema of a run. */
+typedef struct {
+    int as_image;
+    int use_cache;
+} pack_opts_t;
 
 static void print_usage(const char *prog) {
-    fprintf(stderr, "Usage: %s <input> <output>\n", prog);
+    fprintf(stderr,
+            "Usage: %s [--image] [-j N] [--cache FILE] <input> <output>\n"
+            "       %s [--image] [-j N] [--cache FILE] --manifest FILE\n"
+            "       %s [--image] [-j N] [--cache FILE] --out-dir DIR"
+            " <input>...\n"
+            "       %s --family <output> <input>...\n",
+            prog, prog, prog, prog);
     fprintf(stderr, "\n");
-    fprintf(stderr, "Converts a .map or JSON schema to MessagePack binary.\n");
+    fprintf(stderr, "Converts .map or JSON schemas to MessagePack binary.\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Input format:\n");
     fprintf(stderr, "  .json files  - Parsed as JSON schema\n");
     fprintf(stderr, "  Other files  - Parsed as .map schema\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Output: raw msgpack binary for on-device parsing.\n");
+    fprintf(stderr, "  --image      Write a precompiled schema image "
+                    "instead (native\n");
+    fprintf(stderr, "               struct layout, attached without "
+                    "parsing).\n");
+    fprintf(stderr, "  --family O   Write all inputs to one family image "
+                    "O, one variant\n");
+    fprintf(stderr, "               per input named after its "
+                    "basename.\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Batch options:\n");
+    fprintf(stderr, "  --manifest F Pack each \"<input> <output>\" line "
+                    "of F\n");
+    fprintf(stderr, "  --out-dir D  Write each input to D/<name>.msgpack "
+                    "(or .img)\n");
+    fprintf(stderr, "  -j N         Worker threads (default: one per "
+                    "CPU)\n");
+    fprintf(stderr, "  --cache F    Skip outputs left up to date by the "
+                    "run recorded in F\n");
 }
 
 static int has_suffix(const char *str, const char *suffix) {
@@ -62,109 +117,441 @@ static int has_suffix(const char *str, const char *suffix) {
     return strcmp(str + str_len - suf_len, suffix) == 0;
 }
 
-int main(int argc, char *argv[]) {
-    FILE *fout = NULL;
-    cfgpack_schema_t schema;
+/* Hash of the file at @p path, or 0 if it cannot be read in full. */
+static uint64_t hash_existing(workspace_t *ws, const char *path) {
+    size_t len = 0;
+    FILE *f;
+
+    f = fopen(path, "rb");
+    if (!f) {
+        return (0);
+    }
+    len = fread(ws->existing, 1, sizeof(ws->existing), f);
+    if (ferror(f) || fgetc(f) != EOF) {
+        fclose(f);
+        return (0);
+    }
+    fclose(f);
+    return (batch_hash(BATCH_HASH_INIT, ws->existing, len));
+}
+
+/* Phases 1-3: measure, parse and init the schema read into ws->input. */
+static int load_schema(workspace_t *ws,
+                       const char *input_path,
+                       size_t in_len,
+                       cfgpack_schema_t *schema,
+                       cfgpack_ctx_t *ctx,
+                       FILE *err) {
     cfgpack_schema_measure_t m;
     cfgpack_parse_error_t perr;
-    cfgpack_ctx_t ctx;
     cfgpack_err_t rc;
     int is_json;
-    size_t out_len = 0;
-
-    if (argc != 3) {
-        print_usage(argv[0]);
-        return 1;
-    }
-
-    const char *input_path = argv[1];
-    const char *output_path = argv[2];
 
+    memset(&perr, 0, sizeof(perr));
     is_json = has_suffix(input_path, ".json");
 
     /* Phase 1: measure */
     if (is_json) {
-        rc = cfgpack_schema_measure_json_file(input_path, &m, scratch,
-                                              sizeof(scratch), &perr);
+        rc = cfgpack_schema_measure_json(ws->input, in_len, &m, &perr);
     } else {
-        rc = cfgpack_schema_measure_file(input_path, &m, scratch,
-                                         sizeof(scratch), &perr);
+        rc = cfgpack_schema_measure(ws->input, in_len, &m, &perr);
     }
     if (rc != CFGPACK_OK) {
-        fprintf(stderr, "Measure failed: %s\n", perr.message);
+        fprintf(err, "Measure failed: %s\n", perr.message);
         return 3;
     }
 
     if (m.entry_count > MAX_ENTRIES) {
-        fprintf(stderr, "Too many entries: %zu (max %d)\n", m.entry_count,
+        fprintf(err, "Too many entries: %zu (max %d)\n", m.entry_count,
                 MAX_ENTRIES);
         return 3;
     }
     if (m.str_count + m.fstr_count > MAX_STR_OFFSETS) {
-        fprintf(stderr, "Too many string entries: %zu (max %d)\n",
+        fprintf(err, "Too many string entries: %zu (max %d)\n",
                 m.str_count + m.fstr_count, MAX_STR_OFFSETS);
         return 3;
     }
 
     /* Phase 2: parse */
     cfgpack_parse_opts_t opts = {
-        .out_schema = &schema,
-        .entries = entries,
+        .out_schema = schema,
+        .entries = ws->entries,
         .max_entries = m.entry_count,
-        .values = values,
-        .str_pool = str_pool,
+        .values = ws->values,
+        .str_pool = ws->str_pool,
         .str_pool_cap = m.str_pool_size,
-        .str_offsets = str_offsets,
+        .str_offsets = ws->str_offsets,
         .str_offsets_count = m.str_count + m.fstr_count,
         .err = &perr,
     };
 
     if (is_json) {
-        rc = cfgpack_schema_parse_json_file(input_path, &opts, scratch,
-                                            sizeof(scratch));
+        rc = cfgpack_schema_parse_json(ws->input, in_len, &opts);
     } else {
-        rc = cfgpack_parse_schema_file(input_path, &opts, scratch,
-                                       sizeof(scratch));
+        rc = cfgpack_parse_schema(ws->input, in_len, &opts);
     }
     if (rc != CFGPACK_OK) {
-        fprintf(stderr, "Parse failed: %s\n", perr.message);
+        fprintf(err, "Parse failed: %s\n", perr.message);
         return 3;
     }
 
     /* Phase 3: init context */
-    rc = cfgpack_init(&ctx, &schema, values, schema.entry_count, str_pool,
-                      m.str_pool_size, str_offsets, m.str_count + m.fstr_count);
+    rc = cfgpack_init(ctx, schema, ws->values, schema->entry_count,
+                      ws->str_pool, m.str_pool_size, ws->str_offsets,
+                      m.str_count + m.fstr_count);
     if (rc != CFGPACK_OK) {
-        fprintf(stderr, "Init failed (error %d)\n", rc);
+        fprintf(err, "Init failed (error %d)\n", rc);
         return 3;
     }
 
-    /* Phase 4: write msgpack */
-    rc = cfgpack_schema_write_msgpack(&ctx, output_buf, sizeof(output_buf),
-                                      &out_len, &perr);
+    return 0;
+}
+
+/* batch_fn: measure, parse and encode one schema, then write it out. */
+static int pack_job(void *arg,
+                    const batch_job_t *job,
+                    void *user,
+                    FILE *out,
+                    FILE *err) {
+    const pack_opts_t *po = user;
+    workspace_t *ws = arg;
+    const char *input_path = job->in;
+    const char *output_path = job->out;
+    FILE *fout = NULL;
+    cfgpack_schema_t schema;
+    cfgpack_parse_error_t perr;
+    cfgpack_ctx_t ctx;
+    cfgpack_err_t rc;
+    uint64_t key = BATCH_HASH_INIT;
+    uint64_t cached_key;
+    uint64_t cached_out;
+    uint8_t mode;
+    size_t in_len = 0;
+    size_t out_len = 0;
+    int status;
+
+    memset(&perr, 0, sizeof(perr));
+    if (batch_read_file(input_path, (uint8_t *)ws->input, sizeof(ws->input),
+                        &in_len, err) != 0) {
+        return 2;
+    }
+
+    /* The output depends on the mode and the input bytes alone. */
+    mode = (uint8_t)po->as_image;
+    key = batch_hash(batch_hash(key, &mode, 1), ws->input, in_len);
+    if (po->use_cache && batch_cache_get(output_path, &cached_key,
+                                         &cached_out) &&
+        cached_key == key && hash_existing(ws, output_path) == cached_out) {
+        fprintf(out, "Up to date: %s\n", output_path);
+        return 0;
+    }
+
+    status = load_schema(ws, input_path, in_len, &schema, &ctx, err);
+    if (status != 0) {
+        return status;
+    }
+
+    /* Phase 4: write msgpack (or the precompiled image) */
+    if (po->as_image) {
+        rc = cfgpack_schema_write_image(&ctx, ws->output_buf,
+                                        sizeof(ws->output_buf), &out_len,
+                                        &perr);
+    } else {
+        rc = cfgpack_schema_write_msgpack(&ctx, ws->output_buf,
+                                          sizeof(ws->output_buf), &out_len,
+                                          &perr);
+    }
     if (rc != CFGPACK_OK) {
-        fprintf(stderr, "Encode failed: %s\n", perr.message);
+        fprintf(err, "Encode failed: %s\n", perr.message);
         return 3;
     }
 
     /* Phase 5: write output file */
     fout = fopen(output_path, "wb");
     if (!fout) {
-        fprintf(stderr, "Cannot open output file: %s\n", output_path);
+        fprintf(err, "Cannot open output file: %s\n", output_path);
         return 2;
     }
 
-    if (fwrite(output_buf, 1, out_len, fout) != out_len) {
-        fprintf(stderr, "Error writing output file\n");
+    if (fwrite(ws->output_buf, 1, out_len, fout) != out_len) {
+        fprintf(err, "Error writing output file\n");
         fclose(fout);
         return 2;
     }
-    fclose(fout);
+    if (fclose(fout) != 0) {
+        fprintf(err, "Error writing output file\n");
+        return 2;
+    }
+    if (po->use_cache) {
+        batch_cache_put(output_path, key,
+                        batch_hash(BATCH_HASH_INIT, ws->output_buf, out_len));
+    }
 
     /* Print stats */
-    printf("Schema: \"%s\" v%u (%zu entries)\n", schema.map_name,
-           schema.version, schema.entry_count);
-    printf("Output: %zu bytes -> %s\n", out_len, output_path);
+    fprintf(out, "Schema: \"%s\" v%u (%zu entries)\n", schema.map_name,
+            schema.version, schema.entry_count);
+    fprintf(out, "Output: %zu bytes -> %s\n", out_len, output_path);
 
     return 0;
 }
+
+/* Basename of @p input; returns the length without the extension. */
+static size_t input_stem(const char *input, const char **base) {
+    const char *dot;
+
+    *base = strrchr(input, '/');
+    *base = *base ? *base + 1 : input;
+    dot = strrchr(*base, '.');
+    return (dot && dot != *base) ? (size_t)(dot - *base) : strlen(*base);
+}
+
+/* DIR/<basename of input without extension><ext> */
+static int out_dir_path(char *buf,
+                        size_t cap,
+                        const char *dir,
+                        const char *input,
+                        const char *ext) {
+    const char *base;
+    size_t stem = input_stem(input, &base);
+    int n;
+
+    n = snprintf(buf, cap, "%s/%.*s%s", dir, (int)stem, base, ext);
+    return (n > 0 && (size_t)n < cap) ? 0 : -1;
+}
+
+/** One variant of a --family run. */
+typedef struct {
+    workspace_t ws;
+    cfgpack_schema_t schema;
+    cfgpack_ctx_t ctx;
+    char name[CFGPACK_SCHEMA_FAMILY_NAME];
+} family_input_t;
+
+/* Parse every input, then write them all as one family image. */
+static int pack_family(const char *output_path,
+                       const char *const *inputs,
+                       size_t count) {
+    const cfgpack_ctx_t *ctxs[CFGPACK_SCHEMA_FAMILY_MAX];
+    const char *names[CFGPACK_SCHEMA_FAMILY_MAX];
+    family_input_t *fin;
+    cfgpack_parse_error_t perr;
+    cfgpack_err_t rc;
+    uint8_t *image = NULL;
+    uint8_t probe = 0;
+    size_t out_len = 0;
+    FILE *fout;
+    int status = 0;
+
+    if (count > CFGPACK_SCHEMA_FAMILY_MAX) {
+        fprintf(stderr, "Too many variants: %zu (max %d)\n", count,
+                CFGPACK_SCHEMA_FAMILY_MAX);
+        return 1;
+    }
+    fin = calloc(count, sizeof(*fin));
+    if (!fin) {
+        fprintf(stderr, "Out of memory\n");
+        return 2;
+    }
+
+    for (size_t k = 0; k < count && status == 0; k++) {
+        const char *base;
+        size_t stem = input_stem(inputs[k], &base);
+        size_t in_len = 0;
+
+        if (stem >= sizeof(fin[k].name)) {
+            fprintf(stderr, "%s: variant name too long\n", inputs[k]);
+            status = 3;
+            break;
+        }
+        memcpy(fin[k].name, base, stem);
+        if (batch_read_file(inputs[k], (uint8_t *)fin[k].ws.input,
+                            sizeof(fin[k].ws.input), &in_len, stderr) != 0) {
+            status = 2;
+            break;
+        }
+        status = load_schema(&fin[k].ws, inputs[k], in_len, &fin[k].schema,
+                             &fin[k].ctx, stderr);
+        ctxs[k] = &fin[k].ctx;
+        names[k] = fin[k].name;
+    }
+
+    /* Size the image first, then write it into a buffer of that size */
+    memset(&perr, 0, sizeof(perr));
+    if (status == 0) {
+        rc = cfgpack_schema_write_family(ctxs, names, count, &probe, 0,
+                                         &out_len, &perr);
+        if (rc == CFGPACK_ERR_ENCODE && out_len > 0) {
+            image = malloc(out_len);
+            rc = image ? cfgpack_schema_write_family(ctxs, names, count,
+                                                     image, out_len,
+                                                     &out_len, &perr)
+                       : CFGPACK_ERR_BOUNDS;
+        }
+        if (rc != CFGPACK_OK) {
+            fprintf(stderr, "Encode failed: %s\n",
+                    rc == CFGPACK_ERR_BOUNDS ? "out of memory"
+                                             : perr.message);
+            status = 3;
+        }
+    }
+
+    if (status == 0) {
+        fout = fopen(output_path, "wb");
+        if (!fout) {
+            fprintf(stderr, "Cannot open output file: %s\n", output_path);
+            status = 2;
+        } else if (fwrite(image, 1, out_len, fout) != out_len) {
+            fprintf(stderr, "Error writing output file\n");
+            fclose(fout);
+            status = 2;
+        } else if (fclose(fout) != 0) {
+            fprintf(stderr, "Error writing output file\n");
+            status = 2;
+        }
+    }
+
+    if (status == 0) {
+        for (size_t k = 0; k < count; k++) {
+            fprintf(stdout, "Variant: %s = \"%s\" v%u (%zu entries)\n",
+                    fin[k].name, fin[k].schema.map_name,
+                    fin[k].schema.version, fin[k].schema.entry_count);
+        }
+        fprintf(stdout, "Output: %zu bytes -> %s\n", out_len, output_path);
+    }
+
+    free(image);
+    free(fin);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    pack_opts_t po = {0, 0};
+    batch_list_t list = {NULL, 0, 0};
+    const char *positional[2] = {NULL, NULL};
+    const char *manifest = NULL;
+    const char *out_dir = NULL;
+    const char *cache_path = NULL;
+    const char *family = NULL;
+    char path[MAX_PATH_LEN];
+    unsigned threads = 0;
+    size_t n_pos = 0;
+    int rc = 0;
+    int i;
+
+    for (i = 1; i < argc && rc == 0; i++) {
+        if (strcmp(argv[i], "--image") == 0) {
+            po.as_image = 1;
+        } else if (strcmp(argv[i], "-j") == 0 ||
+                   strcmp(argv[i], "--manifest") == 0 ||
+                   strcmp(argv[i], "--out-dir") == 0 ||
+                   strcmp(argv[i], "--family") == 0 ||
+                   strcmp(argv[i], "--cache") == 0) {
+            const char *opt = argv[i];
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires an argument\n", opt);
+                rc = 1;
+                break;
+            }
+            i++;
+            if (strcmp(opt, "-j") == 0) {
+                threads = (unsigned)strtoul(argv[i], NULL, 10);
+            } else if (strcmp(opt, "--manifest") == 0) {
+                manifest = argv[i];
+            } else if (strcmp(opt, "--out-dir") == 0) {
+                out_dir = argv[i];
+            } else if (strcmp(opt, "--family") == 0) {
+                family = argv[i];
+            } else {
+                cache_path = argv[i];
+            }
+        } else if (strcmp(argv[i], "--help") == 0 ||
+                   strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            rc = 1;
+        } else if (out_dir || family || n_pos >= 2) {
+            /* With --out-dir or --family every positional argument is an
+             * input. */
+            break;
+        } else {
+            positional[n_pos++] = argv[i];
+        }
+    }
+
+    /* A family image is one output from every input, packed in one go */
+    if (rc == 0 && family) {
+        const char **inputs;
+        size_t count = 0;
+
+        if (po.as_image || manifest || out_dir || cache_path ||
+            n_pos + (size_t)(argc - i) == 0) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        inputs = malloc((n_pos + (size_t)(argc - i)) * sizeof(*inputs));
+        if (!inputs) {
+            fprintf(stderr, "Out of memory\n");
+            return 2;
+        }
+        for (size_t k = 0; k < n_pos; k++) {
+            inputs[count++] = positional[k];
+        }
+        for (; i < argc; i++) {
+            inputs[count++] = argv[i];
+        }
+        rc = pack_family(family, inputs, count);
+        free(inputs);
+        return rc;
+    }
+
+    /* Build the job list */
+    if (rc == 0 && out_dir) {
+        const char *ext = po.as_image ? ".img" : ".msgpack";
+        for (size_t k = 0; k < n_pos && rc == 0; k++) {
+            if (out_dir_path(path, sizeof(path), out_dir, positional[k], ext) !=
+                    0 ||
+                batch_add(&list, positional[k], path) != 0) {
+                rc = 2;
+            }
+        }
+        for (; i < argc && rc == 0; i++) {
+            if (out_dir_path(path, sizeof(path), out_dir, argv[i], ext) != 0 ||
+                batch_add(&list, argv[i], path) != 0) {
+                rc = 2;
+            }
+        }
+        if (rc == 2) {
+            fprintf(stderr, "Cannot form output path in %s\n", out_dir);
+        }
+    } else if (rc == 0 && (i < argc || (manifest && n_pos) ||
+                           (!manifest && n_pos != 2))) {
+        rc = 1; /* stray inputs, or not exactly one <input> <output> pair */
+    } else if (rc == 0 && n_pos == 2) {
+        rc = batch_add(&list, positional[0], positional[1]) ? 2 : 0;
+    }
+    if (rc == 0 && manifest) {
+        rc = batch_read_manifest(&list, manifest, 1);
+    }
+    if (rc == 0 && list.count == 0) {
+        rc = 1;
+    }
+    if (rc == 1) {
+        print_usage(argv[0]);
+    }
+
+    if (rc == 0 && cache_path) {
+        rc = batch_cache_load(cache_path);
+        po.use_cache = (rc == 0);
+    }
+    if (rc == 0) {
+        rc = batch_run(&list, threads, sizeof(workspace_t), pack_job, &po);
+        if (batch_cache_save() != 0 && rc == 0) {
+            rc = 2;
+        }
+    }
+
+    batch_free(&list);
+    return rc;
+}
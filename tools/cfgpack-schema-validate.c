@@ -3,7 +3,9 @@
  * @brief CLI tool for validating cfgpack schema files.
  *
  * Usage:
- *   cfgpack-schema-validate [--lz4|--heatshrink] [--format map|json|msgpack] <input>
+ *   cfgpack-schema-validate [--lz4|--heatshrink] [--format map|json|msgpack]
+ *                           [-j N] [--manifest FILE] [--cache FILE]
+ *                           <input>...
  *
  * The input file format is auto-detected by extension:
  *   - Files ending in ".json" are parsed as JSON schemas.
@@ -15,7 +17,13 @@
  * When --lz4 or --heatshrink is specified, the file is decompressed first.
  * Compressed schemas are always MessagePack binary underneath.
  *
- * Exit codes:
+ * Any number of inputs may be given, on the command line and/or one per
+ * line in a --manifest file.  They are validated on -j worker threads (one
+ * per CPU by default) and reported in input order, each line prefixed with
+ * the file name when there is more than one input.  With --cache, files whose
+ * content and options match the last successful run are skipped.
+ *
+ * Exit codes (the highest over all inputs):
  *   0 - Valid schema
  *   1 - Usage error
  *   2 - File I/O error
@@ -26,6 +34,7 @@
 #include "cfgpack/schema.h"
 #include "cfgpack/value.h"
 
+#include "batch.h"
 #include "heatshrink_decoder.h"
 #include "lz4.h"
 
@@ -43,13 +52,23 @@ enum { FMT_MAP = 0, FMT_JSON = 1, FMT_MSGPACK = 2 };
 
 enum { COMPRESS_NONE = 0, COMPRESS_LZ4 = 1, COMPRESS_HEATSHRINK = 2 };
 
-static uint8_t input_buf[MAX_INPUT_SIZE];
-static uint8_t scratch_buf[MAX_SCRATCH_SIZE];
-
-static cfgpack_entry_t entries[MAX_ENTRIES];
-static cfgpack_value_t values[MAX_ENTRIES];
-static char str_pool[MAX_STR_OFFSETS * (CFGPACK_STR_MAX + 1)];
-static uint16_t str_offsets[MAX_STR_OFFSETS];
+/** Per-worker buffers, reused for every file the worker validates. */
+typedef struct {
+    uint8_t input_buf[MAX_INPUT_SIZE];
+    uint8_t scratch_buf[MAX_SCRATCH_SIZE];
+    cfgpack_entry_t entries[MAX_ENTRIES];
+    cfgpack_value_t values[MAX_ENTRIES];
+    char str_pool[MAX_STR_OFFSETS * (CFGPACK_STR_MAX + 1)];
+    cfgpack_str_off_t str_offsets[MAX_STR_OFFSETS];
+    heatshrink_decoder hs_decoder;
+} workspace_t;
+
+/** Options shared by every file of a run. */
+typedef struct {
+    int compression;
+    int format; /* -1 = by extension */
+    int use_cache;
+} validate_opts_t;
 
 /* ─────────────────────────────────────────────────────────────────────────────
  * Helpers
@@ -58,15 +77,20 @@ static uint16_t str_offsets[MAX_STR_OFFSETS];
 static void print_usage(const char *prog) {
     fprintf(stderr,
             "Usage: %s [--lz4|--heatshrink] [--format map|json|msgpack]"
-            " <input>\n",
+            " [-j N]\n"
+            "       [--manifest FILE] [--cache FILE] <input>...\n",
             prog);
     fprintf(stderr, "\n");
-    fprintf(stderr, "Validates a cfgpack schema file.\n");
+    fprintf(stderr, "Validates cfgpack schema files.\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  --lz4          Decompress input with LZ4\n");
     fprintf(stderr, "  --heatshrink   Decompress input with heatshrink\n");
     fprintf(stderr, "  --format FMT   Force format: map, json, or msgpack\n");
+    fprintf(stderr, "  -j N           Worker threads (default: one per CPU)\n");
+    fprintf(stderr, "  --manifest F   Also validate each path listed in F\n");
+    fprintf(stderr, "  --cache F      Skip files unchanged since the last "
+                    "run recorded in F\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Format auto-detection (by extension):\n");
     fprintf(stderr, "  .json          JSON schema\n");
@@ -83,33 +107,6 @@ static int has_suffix(const char *str, const char *suffix) {
     return (strcmp(str + str_len - suf_len, suffix) == 0);
 }
 
-static size_t read_file(const char *path, uint8_t *buf, size_t cap) {
-    size_t n;
-    FILE *f;
-
-    f = fopen(path, "rb");
-    if (!f) {
-        fprintf(stderr, "Cannot open file: %s\n", path);
-        return (0);
-    }
-
-    n = fread(buf, 1, cap, f);
-    if (n == 0 && ferror(f)) {
-        fprintf(stderr, "Error reading file: %s\n", path);
-        fclose(f);
-        return (0);
-    }
-    if (!feof(f)) {
-        fprintf(stderr, "File too large (max %d bytes): %s\n", MAX_INPUT_SIZE,
-                path);
-        fclose(f);
-        return (0);
-    }
-
-    fclose(f);
-    return (n);
-}
-
 static int detect_format(const char *path) {
     if (has_suffix(path, ".json")) {
         return (FMT_JSON);
@@ -128,12 +125,13 @@ static cfgpack_err_t decompress_lz4(const uint8_t *in,
                                     size_t in_len,
                                     uint8_t *out,
                                     size_t out_cap,
-                                    size_t *out_len) {
+                                    size_t *out_len,
+                                    FILE *err) {
     uint32_t orig_size;
     int result;
 
     if (in_len < 4) {
-        fprintf(stderr, "LZ4 input too short (missing size header)\n");
+        fprintf(err, "LZ4 input too short (missing size header)\n");
         return (CFGPACK_ERR_DECODE);
     }
 
@@ -142,7 +140,7 @@ static cfgpack_err_t decompress_lz4(const uint8_t *in,
                 ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
 
     if ((size_t)orig_size > out_cap) {
-        fprintf(stderr, "Decompressed size %u exceeds buffer capacity\n",
+        fprintf(err, "Decompressed size %u exceeds buffer capacity\n",
                 orig_size);
         return (CFGPACK_ERR_BOUNDS);
     }
@@ -150,7 +148,7 @@ static cfgpack_err_t decompress_lz4(const uint8_t *in,
     result = LZ4_decompress_safe((const char *)(in + 4), (char *)out,
                                  (int)(in_len - 4), (int)orig_size);
     if (result < 0 || (size_t)result != (size_t)orig_size) {
-        fprintf(stderr, "LZ4 decompression failed\n");
+        fprintf(err, "LZ4 decompression failed\n");
         return (CFGPACK_ERR_DECODE);
     }
 
@@ -158,13 +156,13 @@ static cfgpack_err_t decompress_lz4(const uint8_t *in,
     return (CFGPACK_OK);
 }
 
-static heatshrink_decoder hs_decoder;
-
-static cfgpack_err_t decompress_heatshrink(const uint8_t *in,
+static cfgpack_err_t decompress_heatshrink(heatshrink_decoder *hs,
+                                           const uint8_t *in,
                                            size_t in_len,
                                            uint8_t *out,
                                            size_t out_cap,
-                                           size_t *out_len) {
+                                           size_t *out_len,
+                                           FILE *err) {
     size_t output_produced = 0;
     size_t input_consumed = 0;
     HSD_finish_res finish_res;
@@ -172,60 +170,60 @@ static cfgpack_err_t decompress_heatshrink(const uint8_t *in,
     HSD_sink_res sink_res;
     HSD_poll_res poll_res;
 
-    heatshrink_decoder_reset(&hs_decoder);
+    heatshrink_decoder_reset(hs);
 
     while (input_consumed < in_len) {
-        sink_res = heatshrink_decoder_sink(&hs_decoder,
+        sink_res = heatshrink_decoder_sink(hs,
                                            (uint8_t *)(in + input_consumed),
                                            in_len - input_consumed,
                                            &output_produced);
         if (sink_res < 0) {
-            fprintf(stderr, "Heatshrink sink failed\n");
+            fprintf(err, "Heatshrink sink failed\n");
             return (CFGPACK_ERR_DECODE);
         }
         input_consumed += output_produced;
 
         do {
-            poll_res = heatshrink_decoder_poll(&hs_decoder, out + total_output,
+            poll_res = heatshrink_decoder_poll(hs, out + total_output,
                                                out_cap - total_output,
                                                &output_produced);
             if (poll_res < 0) {
-                fprintf(stderr, "Heatshrink poll failed\n");
+                fprintf(err, "Heatshrink poll failed\n");
                 return (CFGPACK_ERR_DECODE);
             }
             total_output += output_produced;
 
             if (total_output > out_cap) {
-                fprintf(stderr, "Decompressed data exceeds buffer capacity\n");
+                fprintf(err, "Decompressed data exceeds buffer capacity\n");
                 return (CFGPACK_ERR_BOUNDS);
             }
         } while (poll_res == HSDR_POLL_MORE);
     }
 
-    finish_res = heatshrink_decoder_finish(&hs_decoder);
+    finish_res = heatshrink_decoder_finish(hs);
     if (finish_res < 0) {
-        fprintf(stderr, "Heatshrink finish failed\n");
+        fprintf(err, "Heatshrink finish failed\n");
         return (CFGPACK_ERR_DECODE);
     }
 
     while (finish_res == HSDR_FINISH_MORE) {
-        poll_res = heatshrink_decoder_poll(&hs_decoder, out + total_output,
+        poll_res = heatshrink_decoder_poll(hs, out + total_output,
                                            out_cap - total_output,
                                            &output_produced);
         if (poll_res < 0) {
-            fprintf(stderr, "Heatshrink poll failed\n");
+            fprintf(err, "Heatshrink poll failed\n");
             return (CFGPACK_ERR_DECODE);
         }
         total_output += output_produced;
 
         if (total_output > out_cap) {
-            fprintf(stderr, "Decompressed data exceeds buffer capacity\n");
+            fprintf(err, "Decompressed data exceeds buffer capacity\n");
             return (CFGPACK_ERR_BOUNDS);
         }
 
-        finish_res = heatshrink_decoder_finish(&hs_decoder);
+        finish_res = heatshrink_decoder_finish(hs);
         if (finish_res < 0) {
-            fprintf(stderr, "Heatshrink finish failed\n");
+            fprintf(err, "Heatshrink finish failed\n");
             return (CFGPACK_ERR_DECODE);
         }
     }
@@ -238,7 +236,7 @@ static cfgpack_err_t decompress_heatshrink(const uint8_t *in,
  * Validation
  * ───────────────────────────────────────────────────────────────────────────── */
 
-static void print_type_summary(const cfgpack_schema_t *schema) {
+static void print_type_summary(const cfgpack_schema_t *schema, FILE *out) {
     size_t counts[CFGPACK_TYPE_FSTR + 1] = {0};
     const char *names[] = {"u8",  "u16", "u32", "u64", "i8",  "i16",
                            "i32", "i64", "f32", "f64", "str", "fstr"};
@@ -249,17 +247,30 @@ static void print_type_summary(const cfgpack_schema_t *schema) {
         counts[schema->entries[i].type]++;
     }
 
-    printf("  Types:");
+    fprintf(out, "  Types:");
     for (i = 0; i <= CFGPACK_TYPE_FSTR; i++) {
         if (counts[i] > 0) {
-            printf("%s %zu %s", first ? "" : ",", counts[i], names[i]);
+            fprintf(out, "%s %zu %s", first ? "" : ",", counts[i], names[i]);
             first = 0;
         }
     }
-    printf("\n");
+    fprintf(out, "\n");
+}
+
+static void print_parse_error(const cfgpack_parse_error_t *perr, FILE *err) {
+    if (perr->line > 0) {
+        fprintf(err, "Invalid: line %zu: %s\n", perr->line, perr->message);
+    } else {
+        fprintf(err, "Invalid: %s\n", perr->message);
+    }
 }
 
-static int validate_schema(const uint8_t *data, size_t data_len, int format) {
+static int validate_schema(workspace_t *ws,
+                           const uint8_t *data,
+                           size_t data_len,
+                           int format,
+                           FILE *out,
+                           FILE *err) {
     cfgpack_schema_measure_t m;
     cfgpack_parse_error_t perr;
     cfgpack_parse_opts_t opts;
@@ -280,25 +291,21 @@ static int validate_schema(const uint8_t *data, size_t data_len, int format) {
     case FMT_MSGPACK:
         rc = cfgpack_schema_measure_msgpack(data, data_len, &m, &perr);
         break;
-    default: fprintf(stderr, "Internal error: unknown format\n"); return (3);
+    default: fprintf(err, "Internal error: unknown format\n"); return (3);
     }
 
     if (rc != CFGPACK_OK) {
-        if (perr.line > 0) {
-            fprintf(stderr, "Invalid: line %zu: %s\n", perr.line, perr.message);
-        } else {
-            fprintf(stderr, "Invalid: %s\n", perr.message);
-        }
+        print_parse_error(&perr, err);
         return (3);
     }
 
     if (m.entry_count > MAX_ENTRIES) {
-        fprintf(stderr, "Invalid: too many entries: %zu (max %d)\n",
+        fprintf(err, "Invalid: too many entries: %zu (max %d)\n",
                 m.entry_count, MAX_ENTRIES);
         return (3);
     }
     if (m.str_count + m.fstr_count > MAX_STR_OFFSETS) {
-        fprintf(stderr, "Invalid: too many string entries: %zu (max %d)\n",
+        fprintf(err, "Invalid: too many string entries: %zu (max %d)\n",
                 m.str_count + m.fstr_count, MAX_STR_OFFSETS);
         return (3);
     }
@@ -306,12 +313,12 @@ static int validate_schema(const uint8_t *data, size_t data_len, int format) {
     /* Phase 2: full parse (catches duplicates) */
     memset(&opts, 0, sizeof(opts));
     opts.out_schema = &schema;
-    opts.entries = entries;
+    opts.entries = ws->entries;
     opts.max_entries = m.entry_count;
-    opts.values = values;
-    opts.str_pool = str_pool;
+    opts.values = ws->values;
+    opts.str_pool = ws->str_pool;
     opts.str_pool_cap = m.str_pool_size;
-    opts.str_offsets = str_offsets;
+    opts.str_offsets = ws->str_offsets;
     opts.str_offsets_count = m.str_count + m.fstr_count;
     opts.err = &perr;
 
@@ -329,128 +336,184 @@ static int validate_schema(const uint8_t *data, size_t data_len, int format) {
     }
 
     if (rc != CFGPACK_OK) {
-        if (perr.line > 0) {
-            fprintf(stderr, "Invalid: line %zu: %s\n", perr.line, perr.message);
-        } else {
-            fprintf(stderr, "Invalid: %s\n", perr.message);
-        }
+        print_parse_error(&perr, err);
         return (3);
     }
 
     /* Phase 3: print success summary */
-    printf("Valid: \"%s\" v%u (%zu entries)\n", schema.map_name, schema.version,
-           schema.entry_count);
-    print_type_summary(&schema);
+    fprintf(out, "Valid: \"%s\" v%u (%zu entries)\n", schema.map_name,
+            schema.version, schema.entry_count);
+    print_type_summary(&schema, out);
 
     return (0);
 }
 
+/* batch_fn: read, hash, decompress and validate one input. */
+static int validate_job(void *arg,
+                        const batch_job_t *job,
+                        void *user,
+                        FILE *out,
+                        FILE *err) {
+    const validate_opts_t *vo = user;
+    workspace_t *ws = arg;
+    int format = vo->format;
+    const uint8_t *data;
+    size_t data_len;
+    size_t file_len;
+    uint64_t key = BATCH_HASH_INIT;
+    uint64_t cached_key;
+    uint64_t cached_out;
+    uint8_t mode[2];
+    int rc;
+
+    /* Read input file */
+    rc = batch_read_file(job->in, ws->input_buf, sizeof(ws->input_buf),
+                         &file_len, err);
+    if (rc != 0 || file_len == 0) {
+        if (rc == 0) {
+            fprintf(err, "Empty file: %s\n", job->in);
+        }
+        return (2);
+    }
+
+    /* The result depends on the options and the bytes alone. */
+    mode[0] = (uint8_t)vo->compression;
+    mode[1] = (uint8_t)(format + 1);
+    key = batch_hash(batch_hash(key, mode, sizeof(mode)), ws->input_buf,
+                     file_len);
+    if (vo->use_cache && batch_cache_get(job->in, &cached_key, &cached_out) &&
+        cached_key == key) {
+        fprintf(out, "Up to date\n");
+        return (0);
+    }
+
+    /* Decompress if needed */
+    data = ws->input_buf;
+    data_len = file_len;
+
+    if (vo->compression != COMPRESS_NONE) {
+        size_t decompressed_len = 0;
+        cfgpack_err_t drc;
+
+        if (vo->compression == COMPRESS_LZ4) {
+            drc = decompress_lz4(ws->input_buf, file_len, ws->scratch_buf,
+                                 sizeof(ws->scratch_buf), &decompressed_len,
+                                 err);
+        } else {
+            drc = decompress_heatshrink(&ws->hs_decoder, ws->input_buf,
+                                        file_len, ws->scratch_buf,
+                                        sizeof(ws->scratch_buf),
+                                        &decompressed_len, err);
+        }
+        if (drc != CFGPACK_OK) {
+            return (2);
+        }
+        data = ws->scratch_buf;
+        data_len = decompressed_len;
+        if (format < 0) {
+            format = FMT_MSGPACK;
+        }
+    }
+
+    /* Auto-detect format from extension if not already set */
+    if (format < 0) {
+        format = detect_format(job->in);
+    }
+
+    rc = validate_schema(ws, data, data_len, format, out, err);
+    if (rc == 0 && vo->use_cache) {
+        batch_cache_put(job->in, key, 0);
+    }
+    return (rc);
+}
+
 /* ─────────────────────────────────────────────────────────────────────────────
  * Main
  * ───────────────────────────────────────────────────────────────────────────── */
 
 int main(int argc, char *argv[]) {
-    const char *input_path = NULL;
+    validate_opts_t vo = {COMPRESS_NONE, -1, 0};
+    const char *cache_path = NULL;
     const char *fmt_str = NULL;
-    int compression = COMPRESS_NONE;
-    int format = -1;
-    const uint8_t *data;
-    size_t data_len;
-    size_t file_len;
-    cfgpack_err_t rc;
+    batch_list_t list = {NULL, 0, 0};
+    unsigned threads = 0;
+    int rc = 0;
     int i;
 
     /* Parse arguments */
-    for (i = 1; i < argc; i++) {
+    for (i = 1; i < argc && rc == 0; i++) {
         if (strcmp(argv[i], "--lz4") == 0) {
-            compression = COMPRESS_LZ4;
+            vo.compression = COMPRESS_LZ4;
         } else if (strcmp(argv[i], "--heatshrink") == 0) {
-            compression = COMPRESS_HEATSHRINK;
-        } else if (strcmp(argv[i], "--format") == 0) {
+            vo.compression = COMPRESS_HEATSHRINK;
+        } else if (strcmp(argv[i], "--format") == 0 ||
+                   strcmp(argv[i], "-j") == 0 ||
+                   strcmp(argv[i], "--manifest") == 0 ||
+                   strcmp(argv[i], "--cache") == 0) {
+            const char *opt = argv[i];
             if (i + 1 >= argc) {
-                fprintf(stderr, "Error: --format requires an argument\n");
-                return (1);
+                fprintf(stderr, "Error: %s requires an argument\n", opt);
+                rc = 1;
+                break;
+            }
+            i++;
+            if (strcmp(opt, "--format") == 0) {
+                fmt_str = argv[i];
+            } else if (strcmp(opt, "-j") == 0) {
+                threads = (unsigned)strtoul(argv[i], NULL, 10);
+            } else if (strcmp(opt, "--manifest") == 0) {
+                rc = batch_read_manifest(&list, argv[i], 0);
+            } else {
+                cache_path = argv[i];
             }
-            fmt_str = argv[++i];
         } else if (strcmp(argv[i], "--help") == 0 ||
                    strcmp(argv[i], "-h") == 0) {
             print_usage(argv[0]);
+            batch_free(&list);
             return (0);
         } else if (argv[i][0] == '-') {
             fprintf(stderr, "Unknown option: %s\n", argv[i]);
             print_usage(argv[0]);
-            return (1);
-        } else {
-            if (input_path) {
-                fprintf(stderr, "Error: multiple input files specified\n");
-                return (1);
-            }
-            input_path = argv[i];
+            rc = 1;
+        } else if (batch_add(&list, argv[i], NULL) != 0) {
+            fprintf(stderr, "Out of memory\n");
+            rc = 2;
         }
     }
 
-    if (!input_path) {
+    if (rc == 0 && list.count == 0) {
         print_usage(argv[0]);
-        return (1);
+        rc = 1;
     }
 
     /* Resolve format */
-    if (fmt_str) {
+    if (rc == 0 && fmt_str) {
         if (strcmp(fmt_str, "map") == 0) {
-            format = FMT_MAP;
+            vo.format = FMT_MAP;
         } else if (strcmp(fmt_str, "json") == 0) {
-            format = FMT_JSON;
+            vo.format = FMT_JSON;
         } else if (strcmp(fmt_str, "msgpack") == 0) {
-            format = FMT_MSGPACK;
+            vo.format = FMT_MSGPACK;
         } else {
             fprintf(stderr,
                     "Error: unknown format \"%s\""
                     " (expected: map, json, msgpack)\n",
                     fmt_str);
-            return (1);
+            rc = 1;
         }
     }
 
-    /* Read input file */
-    file_len = read_file(input_path, input_buf, sizeof(input_buf));
-    if (file_len == 0) {
-        return (2);
+    if (rc == 0 && cache_path) {
+        rc = batch_cache_load(cache_path);
+        vo.use_cache = (rc == 0);
     }
-
-    /* Decompress if needed */
-    data = input_buf;
-    data_len = file_len;
-
-    if (compression == COMPRESS_LZ4) {
-        size_t decompressed_len = 0;
-        rc = decompress_lz4(input_buf, file_len, scratch_buf,
-                            sizeof(scratch_buf), &decompressed_len);
-        if (rc != CFGPACK_OK) {
-            return (2);
+    if (rc == 0) {
+        rc = batch_run(&list, threads, sizeof(workspace_t), validate_job, &vo);
+        if (batch_cache_save() != 0 && rc == 0) {
+            rc = 2;
         }
-        data = scratch_buf;
-        data_len = decompressed_len;
-        if (format < 0) {
-            format = FMT_MSGPACK;
-        }
-    } else if (compression == COMPRESS_HEATSHRINK) {
-        size_t decompressed_len = 0;
-        rc = decompress_heatshrink(input_buf, file_len, scratch_buf,
-                                   sizeof(scratch_buf), &decompressed_len);
-        if (rc != CFGPACK_OK) {
-            return (2);
-        }
-        data = scratch_buf;
-        data_len = decompressed_len;
-        if (format < 0) {
-            format = FMT_MSGPACK;
-        }
-    }
-
-    /* Auto-detect format from extension if not already set */
-    if (format < 0) {
-        format = detect_format(input_path);
     }
 
-    return (validate_schema(data, data_len, format));
+    batch_free(&list);
+    return (rc);
 }